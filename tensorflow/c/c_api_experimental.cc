@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/c/c_api_experimental.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "absl/strings/substitute.h"
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -743,3 +746,151 @@ void TF_ImportGraphDefOptionsSetValidateColocationConstraints(
     TF_ImportGraphDefOptions* opts, unsigned char enable) {
   opts->opts.validate_colocation_constraints = enable;
 }
+
+TF_Tensor* TF_NewTensorFromAlignedBuffer(
+    TF_DataType dtype, const int64_t* dims, int num_dims, void* data,
+    size_t len, void (*deallocator)(void* data, size_t len, void* arg),
+    void* deallocator_arg, TF_Status* status) {
+  // Only the types that TF_NewTensor would copy need to be aligned.
+  const size_t alignment = std::max(1, EIGEN_MAX_ALIGN_BYTES);
+  if (dtype != TF_STRING && dtype != TF_RESOURCE &&
+      tensorflow::DataTypeCanUseMemcpy(
+          static_cast<tensorflow::DataType>(dtype)) &&
+      reinterpret_cast<intptr_t>(data) % alignment != 0) {
+    status->status = InvalidArgument("The data of the tensor must be aligned "
+                                     "to ",
+                                     alignment, " bytes");
+    return nullptr;
+  }
+  // Checked here rather than by TF_NewTensor, which would call `deallocator`
+  // and return nullptr without a status.
+  tensorflow::int64 num_elements = 1;
+  for (int i = 0; i < num_dims; ++i) {
+    if (dims[i] < 0) {
+      status->status =
+          InvalidArgument("Dimension ", i, " of the tensor is negative: ",
+                          dims[i]);
+      return nullptr;
+    }
+    num_elements *= dims[i];
+  }
+  const size_t elem_size = TF_DataTypeSize(dtype);
+  if (elem_size > 0 && len < elem_size * num_elements) {
+    status->status =
+        InvalidArgument("A tensor of ", num_elements, " elements of type ",
+                        tensorflow::DataTypeString(
+                            static_cast<tensorflow::DataType>(dtype)),
+                        " needs ", elem_size * num_elements,
+                        " bytes, but the buffer has ", len);
+    return nullptr;
+  }
+  status->status = Status::OK();
+  return TF_NewTensor(dtype, dims, num_dims, data, len, deallocator,
+                      deallocator_arg);
+}
+
+void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor* const* output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  using tensorflow::Tensor;
+  using tensorflow::strings::StrCat;
+
+  if (session->extend_before_run &&
+      !tensorflow::ExtendSessionGraphHelper(session, status)) {
+    return;
+  }
+  status->status = Status::OK();
+
+  for (int i = 0; i < noutputs; ++i) {
+    const TF_DataType dtype = TF_TensorType(output_values[i]);
+    if (dtype == TF_STRING || dtype == TF_RESOURCE || dtype == TF_VARIANT) {
+      status->status = InvalidArgument(
+          "Output ", i,
+          " cannot be written into a caller-owned buffer of type ",
+          tensorflow::DataTypeString(static_cast<tensorflow::DataType>(dtype)));
+      return;
+    }
+  }
+
+  std::vector<std::pair<tensorflow::string, Tensor>> input_pairs(ninputs);
+  for (int i = 0; i < ninputs; ++i) {
+    input_pairs[i].first =
+        StrCat(inputs[i].oper->node.name(), ":", inputs[i].index);
+    status->status =
+        tensorflow::TF_TensorToTensor(input_values[i], &input_pairs[i].second);
+    if (!status->status.ok()) return;
+  }
+  std::vector<tensorflow::string> output_names(noutputs);
+  for (int i = 0; i < noutputs; ++i) {
+    output_names[i] =
+        StrCat(outputs[i].oper->node.name(), ":", outputs[i].index);
+  }
+  std::vector<tensorflow::string> target_names(ntargets);
+  for (int i = 0; i < ntargets; ++i) {
+    target_names[i] = target_opers[i]->node.name();
+  }
+
+  tensorflow::RunOptions run_options_proto;
+  if (run_options != nullptr && !run_options_proto.ParseFromArray(
+                                    run_options->data, run_options->length)) {
+    status->status = InvalidArgument("Unparseable RunOptions proto");
+    return;
+  }
+  if (run_metadata != nullptr && run_metadata->data != nullptr) {
+    status->status =
+        InvalidArgument("Passing non-empty run_metadata is invalid.");
+    return;
+  }
+  // Lets the kernels producing the outputs write them into the caller's
+  // buffers directly; the others are copied below.
+  run_options_proto.mutable_experimental()->set_fetch_into_output_buffers(true);
+  std::vector<Tensor> fetched(noutputs);
+  for (int i = 0; i < noutputs; ++i) {
+    status->status =
+        tensorflow::TF_TensorToTensor(output_values[i], &fetched[i]);
+    if (!status->status.ok()) return;
+  }
+  tensorflow::RunMetadata run_metadata_proto;
+  status->status =
+      session->session->Run(run_options_proto, input_pairs, output_names,
+                            target_names, &fetched, &run_metadata_proto);
+  if (!status->status.ok()) return;
+  if (run_metadata != nullptr) {
+    status->status = MessageToBuffer(run_metadata_proto, run_metadata);
+    if (!status->status.ok()) return;
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    const Tensor& src = fetched[i];
+    TF_Tensor* dst = output_values[i];
+    tensorflow::TensorShape dst_shape;
+    for (int d = 0; d < TF_NumDims(dst); ++d) {
+      dst_shape.AddDim(TF_Dim(dst, d));
+    }
+    if (static_cast<TF_DataType>(src.dtype()) != TF_TensorType(dst) ||
+        src.shape() != dst_shape) {
+      status->status = InvalidArgument(
+          "Output ", i, " (", output_names[i], ") is a ",
+          tensorflow::DataTypeString(src.dtype()), " tensor of shape ",
+          src.shape().DebugString(), ", but the buffer is a ",
+          tensorflow::DataTypeString(
+              static_cast<tensorflow::DataType>(TF_TensorType(dst))),
+          " tensor of shape ", dst_shape.DebugString());
+      return;
+    }
+    const auto src_data = src.tensor_data();
+    if (src_data.size() != TF_TensorByteSize(dst)) {
+      status->status =
+          InvalidArgument("Output ", i, " (", output_names[i], ") has ",
+                          src_data.size(), " bytes, but the buffer has ",
+                          TF_TensorByteSize(dst));
+      return;
+    }
+    if (src_data.data() != TF_TensorData(dst) && !src_data.empty()) {
+      std::memcpy(TF_TensorData(dst), src_data.data(), src_data.size());
+    }
+  }
+}
@@ -304,6 +304,35 @@ TF_CAPI_EXPORT extern void
 TF_ImportGraphDefOptionsSetValidateColocationConstraints(
     TF_ImportGraphDefOptions* opts, unsigned char enable);
 
+// Like TF_NewTensor, but fails with TF_INVALID_ARGUMENT instead of copying
+// `data` if it is not aligned enough to be used by kernels directly, so that
+// the tensor is guaranteed to be fed to a session without a copy. Also fails
+// with TF_INVALID_ARGUMENT if `len` is too small for `dims`. On failure,
+// returns nullptr and does not call `deallocator`.
+TF_CAPI_EXPORT extern TF_Tensor* TF_NewTensorFromAlignedBuffer(
+    TF_DataType dtype, const int64_t* dims, int num_dims, void* data,
+    size_t len, void (*deallocator)(void* data, size_t len, void* arg),
+    void* deallocator_arg, TF_Status* status);
+
+// Like TF_SessionRun, but writes the value of `outputs[i]` into the buffer of
+// the caller-owned tensor `output_values[i]`, e.g. a tensor created with
+// TF_NewTensor on memory that the caller reuses across runs, instead of
+// returning a new tensor.
+//
+// Each `output_values[i]` must have the dtype and the shape of the fetched
+// value, and a dtype other than TF_STRING, TF_RESOURCE or TF_VARIANT. A
+// mismatch is reported as TF_INVALID_ARGUMENT, naming the output, rather than
+// handled by allocating a new tensor; the buffers of the other outputs may
+// have been written then. The kernel that produces an output on CPU writes it
+// into the buffer directly. Other values, e.g. fed tensors or values produced
+// on a GPU, are copied into the buffer once the run is done.
+TF_CAPI_EXPORT extern void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor* const* output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
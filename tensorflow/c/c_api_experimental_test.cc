@@ -234,5 +234,86 @@ TEST_F(ShapeInferenceTest, InfersShapesFromInputTensors) {
   TF_DeleteTensor(tensor_1X6);
 }
 
+void NoopDeallocator(void* data, size_t len, void* arg) {}
+
+TEST(CAPI_EXPERIMENTAL, SessionRunWithOutputBuffers) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  alignas(64) int32_t input = 3;
+  TF_Tensor* input_value = TF_NewTensorFromAlignedBuffer(
+      TF_INT32, nullptr, 0, &input, sizeof(input), &NoopDeallocator, nullptr,
+      s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  EXPECT_EQ(&input, TF_TensorData(input_value));
+
+  alignas(64) int32_t output = 0;
+  TF_Tensor* output_value = TF_NewTensor(TF_INT32, nullptr, 0, &output,
+                                         sizeof(output), &NoopDeallocator,
+                                         nullptr);
+  TF_Output inputs[] = {{feed, 0}};
+  TF_Output outputs[] = {{add, 0}};
+  for (int i = 0; i < 2; ++i) {
+    input = i;
+    TF_SessionRunWithOutputBuffers(session, nullptr, inputs, &input_value, 1,
+                                   outputs, &output_value, 1, nullptr, 0,
+                                   nullptr, s);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    EXPECT_EQ(i + 2, output);
+  }
+
+  // Mismatches are reported.
+  const int64_t dims[] = {2};
+  TF_Tensor* vector_value = TF_AllocateTensor(TF_INT32, dims, 1, 8);
+  TF_SessionRunWithOutputBuffers(session, nullptr, inputs, &input_value, 1,
+                                 outputs, &vector_value, 1, nullptr, 0,
+                                 nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s));
+  TF_DeleteTensor(vector_value);
+
+  TF_DeleteTensor(input_value);
+  TF_DeleteTensor(output_value);
+  TF_CloseSession(session, s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
+TEST(CAPI_EXPERIMENTAL, NewTensorFromAlignedBufferRejectsMisalignedData) {
+  TF_Status* s = TF_NewStatus();
+  alignas(64) float data[5];
+  const int64_t dims[] = {4};
+  TF_Tensor* t = TF_NewTensorFromAlignedBuffer(
+      TF_FLOAT, dims, 1, reinterpret_cast<char*>(data) + 1, 4 * sizeof(float),
+      &NoopDeallocator, nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s));
+  EXPECT_EQ(nullptr, t);
+  TF_DeleteStatus(s);
+}
+
+TEST(CAPI_EXPERIMENTAL, NewTensorFromAlignedBufferRejectsShortBuffer) {
+  TF_Status* s = TF_NewStatus();
+  alignas(64) float data[4];
+  const int64_t dims[] = {4};
+  TF_Tensor* t =
+      TF_NewTensorFromAlignedBuffer(TF_FLOAT, dims, 1, data, 3 * sizeof(float),
+                                    &NoopDeallocator, nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s));
+  EXPECT_EQ(nullptr, t);
+  TF_DeleteStatus(s);
+}
+
 }  // namespace
 }  // namespace tensorflow
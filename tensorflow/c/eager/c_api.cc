@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/c/eager/abstract_tensor_handle.h"
@@ -1633,7 +1634,16 @@ class CustomDeviceAPI : public tensorflow::CustomDevice {
                   string name)
       : context_(context), device_(device), info_(info), name_(name) {}
 
-  ~CustomDeviceAPI() override { device_.delete_device(info_); }
+  ~CustomDeviceAPI() override {
+    if (device_.delete_compiled != nullptr) {
+      for (const auto& compiled : compiled_functions_) {
+        if (compiled.second != nullptr) {
+          device_.delete_compiled(compiled.second, info_);
+        }
+      }
+    }
+    device_.delete_device(info_);
+  }
 
   const string& name() override { return name_; }
 
@@ -1674,10 +1684,19 @@ class CustomDeviceAPI : public tensorflow::CustomDevice {
   tensorflow::Status Execute(const tensorflow::EagerOperation* op,
                              tensorflow::TensorHandle** retvals,
                              int* num_retvals) override {
+    void* executable = nullptr;
+    if (device_.compile_function != nullptr && op->is_function()) {
+      TF_RETURN_IF_ERROR(CompiledFunction(op, &executable));
+    }
     std::vector<TFE_TensorHandle*> outputs(*num_retvals);
     TF_Status status;
-    device_.execute(tensorflow::wrap(op), num_retvals, outputs.data(), &status,
-                    info_);
+    if (executable != nullptr) {
+      device_.execute_compiled(executable, tensorflow::wrap(op), num_retvals,
+                               outputs.data(), &status, info_);
+    } else {
+      device_.execute(tensorflow::wrap(op), num_retvals, outputs.data(),
+                      &status, info_);
+    }
     if (status.status.ok()) {
       for (int i = 0; i < *num_retvals; ++i) {
         retvals[i] = tensorflow::TensorHandleFromInterface(
@@ -1690,10 +1709,54 @@ class CustomDeviceAPI : public tensorflow::CustomDevice {
   }
 
  private:
+  // Looks up the executable for the signature of the function call `op`,
+  // compiling it on first use. Sets `executable` to nullptr if the device
+  // declined to compile this signature.
+  tensorflow::Status CompiledFunction(const tensorflow::EagerOperation* op,
+                                      void** executable) {
+    tensorflow::AttrValueMap attrs;
+    op->Attrs().FillAttrValueMap(&attrs);
+    string signature =
+        tensorflow::Canonicalize(op->Name(), tensorflow::AttrSlice(&attrs));
+    for (tensorflow::TensorHandle* input : op->Inputs()) {
+      tensorflow::TensorShape shape;
+      TF_RETURN_IF_ERROR(input->Shape(&shape));
+      tensorflow::strings::StrAppend(&signature, ";",
+                                     tensorflow::DataTypeString(input->dtype),
+                                     shape.DebugString());
+    }
+    {
+      tensorflow::tf_shared_lock l(compiled_mu_);
+      auto it = compiled_functions_.find(signature);
+      if (it != compiled_functions_.end()) {
+        *executable = it->second;
+        return tensorflow::Status::OK();
+      }
+    }
+    TF_Status status;
+    void* compiled =
+        device_.compile_function(tensorflow::wrap(op), &status, info_);
+    if (!status.status.ok()) return status.status;
+    tensorflow::mutex_lock l(compiled_mu_);
+    auto inserted = compiled_functions_.emplace(signature, compiled);
+    if (!inserted.second && compiled != nullptr) {
+      // Another thread compiled the same signature first.
+      device_.delete_compiled(compiled, info_);
+    }
+    *executable = inserted.first->second;
+    return tensorflow::Status::OK();
+  }
+
   TFE_Context* context_;
   TFE_CustomDevice device_;
   void* info_;
   string name_;
+
+  tensorflow::mutex compiled_mu_;
+  // Executables by function call signature; nullptr if the device declined to
+  // compile the signature.
+  std::unordered_map<string, void*> compiled_functions_
+      TF_GUARDED_BY(compiled_mu_);
 };
 }  // namespace
 
@@ -439,7 +439,7 @@ TF_CAPI_EXPORT extern void TFE_OpSetAttrValueProto(const TFE_Op* op,
 // to have a non-string representation of devices (TF_Device) extracted from
 // tensors/ops/etc. and usable in APIs like OpSetDevice/ResetOp/etc.
 
-#define TFE_CUSTOM_DEVICE_VERSION 3
+#define TFE_CUSTOM_DEVICE_VERSION 4
 
 // Struct to be filled in
 typedef struct TFE_CustomDevice {
@@ -472,6 +472,25 @@ typedef struct TFE_CustomDevice {
 
   // Method to delete a device.
   void (*delete_device)(void* device_info);
+
+  // Optional methods to run a function called on the device as a single
+  // executable, for example one which fuses the operations of its body.
+  //
+  // When set, `compile_function` is called for a function call `op` placed on
+  // this device the first time it is seen with its attributes and the dtypes
+  // and shapes of its inputs. The body may be looked up with
+  // TFE_ContextGetFunctionDef(context, TFE_OpGetName(op), ...). It returns an
+  // opaque executable, or nullptr with an OK status to run calls with this
+  // signature through `execute` instead. The result is cached per signature,
+  // and every call with a compiled signature goes to `execute_compiled`, which
+  // takes the same arguments as `execute`. Executables are released with
+  // `delete_compiled` before the device is deleted.
+  void* (*compile_function)(const TFE_Op* op, TF_Status* s,
+                            void* device_info) = nullptr;
+  void (*execute_compiled)(void* executable, const TFE_Op* op,
+                           int* num_outputs, TFE_TensorHandle** outputs,
+                           TF_Status* s, void* device_info) = nullptr;
+  void (*delete_compiled)(void* executable, void* device_info) = nullptr;
 } TFE_CustomDevice;
 
 // Registers a custom device for use with eager execution.
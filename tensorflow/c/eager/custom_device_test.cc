@@ -23,7 +23,9 @@ limitations under the License.
 #include "tensorflow/c/eager/c_api_test_util.h"
 #include "tensorflow/c/eager/custom_device_testutil.h"
 #include "tensorflow/c/tf_status.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 
 TEST(CUSTOM_DEVICE, RegisterSimpleDevice) {
@@ -381,3 +383,147 @@ TEST(CUSTOM_DEVICE, InvalidRegistrationError) {
   ASSERT_TRUE(TF_GetCode(status.get()) == TF_ALREADY_EXISTS)
       << TF_Message(status.get());
 }
+
+namespace {
+
+// Counts the calls to the function compilation methods of a logging device.
+struct CompileCounts {
+  int compiled = 0;
+  int executed = 0;
+  int deleted = 0;
+};
+
+CompileCounts compile_counts;
+void (*logging_device_execute)(const TFE_Op*, int*, TFE_TensorHandle**,
+                               TF_Status*, void*);
+
+void* CountingCompileFunction(const TFE_Op* op, TF_Status* s,
+                              void* device_info) {
+  ++compile_counts.compiled;
+  // The executable only needs to be a distinct non-null pointer.
+  return new int(compile_counts.compiled);
+}
+
+void CountingExecuteCompiled(void* executable, const TFE_Op* op,
+                             int* num_outputs, TFE_TensorHandle** outputs,
+                             TF_Status* s, void* device_info) {
+  ++compile_counts.executed;
+  logging_device_execute(op, num_outputs, outputs, s, device_info);
+}
+
+void CountingDeleteCompiled(void* executable, void* device_info) {
+  ++compile_counts.deleted;
+  delete reinterpret_cast<int*>(executable);
+}
+
+tensorflow::string IdentityFunction() {
+  tensorflow::FunctionDef def;
+  CHECK(tensorflow::protobuf::TextFormat::ParseFromString(
+      "    signature {"
+      "      name: 'IdentityFunction'"
+      "      input_arg {"
+      "        name: 'a'"
+      "        type: DT_FLOAT"
+      "      }"
+      "      output_arg {"
+      "        name: 'm'"
+      "        type: DT_FLOAT"
+      "      }"
+      "    }"
+      "    node_def {"
+      "      name: 'identity'"
+      "      op: 'Identity'"
+      "      input: 'a'"
+      "      attr {"
+      "        key: 'T'"
+      "        value {"
+      "          type: DT_FLOAT"
+      "        }"
+      "      }"
+      "    }"
+      "    ret {"
+      "      key: 'm'"
+      "      value: 'identity:output'"
+      "    }",
+      &def));
+  return def.SerializeAsString();
+}
+
+}  // namespace
+
+TEST(CUSTOM_DEVICE, CompileFunctionsOncePerSignature) {
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+      TF_NewStatus(), TF_DeleteStatus);
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status.get()), TFE_DeleteContext);
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+  compile_counts = CompileCounts();
+
+  bool arrived = false;
+  bool executed = false;
+  const char* name = "/job:localhost/replica:0/task:0/device:CUSTOM:0";
+  TFE_CustomDevice* device;
+  void* device_info;
+  AllocateLoggingDevice(name, &arrived, &executed, &device, &device_info);
+  std::unique_ptr<TFE_CustomDevice> device_cleanup(device);
+  logging_device_execute = device->execute;
+  device->compile_function = &CountingCompileFunction;
+  device->execute_compiled = &CountingExecuteCompiled;
+  device->delete_compiled = &CountingDeleteCompiled;
+  TFE_RegisterCustomDevice(context.get(), *device, name, device_info,
+                           status.get());
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+
+  tensorflow::string function_def = IdentityFunction();
+  TFE_ContextAddFunctionDef(context.get(), function_def.data(),
+                            function_def.size(), status.get());
+  ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+
+  auto call = [&](TFE_TensorHandle* input, const char* op_name) {
+    std::unique_ptr<TFE_Op, decltype(&TFE_DeleteOp)> op(
+        TFE_NewOp(context.get(), op_name, status.get()), TFE_DeleteOp);
+    ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+    TFE_OpAddInput(op.get(), input, status.get());
+    ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+    if (tensorflow::string(op_name) == "Identity") {
+      TFE_OpSetAttrType(op.get(), "T", TF_FLOAT);
+    }
+    TFE_OpSetDevice(op.get(), name, status.get());
+    ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+    TFE_TensorHandle* retval;
+    int num_retvals = 1;
+    TFE_Execute(op.get(), &retval, &num_retvals, status.get());
+    ASSERT_TRUE(TF_GetCode(status.get()) == TF_OK) << TF_Message(status.get());
+    TFE_DeleteTensorHandle(retval);
+  };
+
+  std::unique_ptr<TFE_TensorHandle, decltype(&TFE_DeleteTensorHandle)> matrix(
+      TestMatrixTensorHandle(context.get()), TFE_DeleteTensorHandle);
+  std::unique_ptr<TFE_TensorHandle, decltype(&TFE_DeleteTensorHandle)> scalar(
+      TestScalarTensorHandle(context.get(), 1.0f), TFE_DeleteTensorHandle);
+
+  // Repeated calls with the same input shape reuse the executable.
+  call(matrix.get(), "IdentityFunction");
+  call(matrix.get(), "IdentityFunction");
+  EXPECT_EQ(1, compile_counts.compiled);
+  EXPECT_EQ(2, compile_counts.executed);
+
+  // A new input shape is a new signature.
+  call(scalar.get(), "IdentityFunction");
+  EXPECT_EQ(2, compile_counts.compiled);
+  EXPECT_EQ(3, compile_counts.executed);
+
+  // Primitive operations still go through `execute`.
+  executed = false;
+  call(matrix.get(), "Identity");
+  EXPECT_TRUE(executed);
+  EXPECT_EQ(2, compile_counts.compiled);
+  EXPECT_EQ(3, compile_counts.executed);
+
+  matrix.reset();
+  scalar.reset();
+  context.reset();
+  EXPECT_EQ(2, compile_counts.deleted);
+}
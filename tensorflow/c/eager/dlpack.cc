@@ -15,11 +15,16 @@ limitations under the License.
 
 #include "tensorflow/c/eager/dlpack.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "include/dlpack/dlpack.h"  // from @dlpack
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/c_api_experimental.h"
 #include "tensorflow/c/eager/tfe_tensorhandle_internal.h"
 #include "tensorflow/c/tf_status_internal.h"
+#include "tensorflow/c/tf_tensor.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
@@ -123,7 +128,11 @@ DLContext GetDlContext(TFE_TensorHandle* h, TF_Status* status) {
   if (device_type == "CPU") {
     ctx.device_type = DLDeviceType::kDLCPU;
   } else if (device_type == "GPU") {
+#if TENSORFLOW_USE_ROCM
+    ctx.device_type = DLDeviceType::kDLROCM;
+#else
     ctx.device_type = DLDeviceType::kDLGPU;
+#endif
   } else {
     status->status = tensorflow::errors::InvalidArgument(
         "Unsupported Device Type for dlpack");
@@ -136,9 +145,15 @@ DLContext GetDlContext(TFE_TensorHandle* h, TF_Status* status) {
 absl::optional<std::string> DeviceNameFromDlContext(const DLContext& ctx,
                                                     TF_Status* status) {
   switch (ctx.device_type) {
+    // Pinned host memory is read and written like any host memory.
     case DLDeviceType::kDLCPU:
+    case DLDeviceType::kDLCPUPinned:
       return "CPU:0";
+#if TENSORFLOW_USE_ROCM
+    case DLDeviceType::kDLROCM:
+#else
     case DLDeviceType::kDLGPU:
+#endif
       return absl::StrCat("GPU:", ctx.device_id);
     default:
       return absl::nullopt;
@@ -226,19 +241,52 @@ void DeallocatorWrapperFunc(void* data, size_t len, void* dlmt_vptr) {
 }
 
 // Checks whether the stride array matches the layout of compact, row-majored
-// data.
+// data.  The strides of dimensions of size 1 are never used, and neither are
+// any strides of empty tensors, so they may have any value.
 bool IsValidStrideCompactRowMajorData(int64_t* shape_arr, int64_t* stride_arr,
                                       int ndim) {
-  if (ndim >= 1 && stride_arr[ndim - 1] != 1) {
-    return false;
+  for (int i = 0; i < ndim; ++i) {
+    if (shape_arr[i] == 0) {
+      return true;
+    }
   }
-  for (int i = ndim - 2; i >= 0; --i) {
-    if (stride_arr[i] != shape_arr[i + 1] * stride_arr[i + 1]) {
+  int64_t expected_stride = 1;
+  for (int i = ndim - 1; i >= 0; --i) {
+    if (shape_arr[i] != 1 && stride_arr[i] != expected_stride) {
       return false;
     }
+    expected_stride *= shape_arr[i];
   }
   return true;
 }
+
+// Copies the elements of the host tensor "src", which starts at "src_data"
+// and may be strided, into the compact row-major buffer "dst".
+void CopyToCompactRowMajor(const DLTensor& src, const char* src_data,
+                           size_t element_size, int64_t num_elements,
+                           char* dst) {
+  if (num_elements == 0) {
+    return;
+  }
+  if (src.strides == nullptr) {
+    memcpy(dst, src_data, num_elements * element_size);
+    return;
+  }
+  std::vector<int64_t> index(src.ndim, 0);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    int64_t offset = 0;
+    for (int d = 0; d < src.ndim; ++d) {
+      offset += index[d] * src.strides[d];
+    }
+    memcpy(dst + i * element_size, src_data + offset * element_size,
+           element_size);
+    // Advances the row-major index.
+    for (int d = src.ndim - 1; d >= 0; --d) {
+      if (++index[d] < src.shape[d]) break;
+      index[d] = 0;
+    }
+  }
+}
 }  // namespace
 
 void TFE_CallDLManagedTensorDeleter(void* dlm_ptr) {
@@ -250,20 +298,36 @@ void TFE_CallDLManagedTensorDeleter(void* dlm_ptr) {
 
 void* TFE_HandleToDLPack(TFE_TensorHandle* h, TF_Status* status) {
   const Tensor* tensor = GetTensorFromHandle(h, status);
+  if (!status->status.ok()) {
+    return nullptr;
+  }
   TF_DataType data_type = static_cast<TF_DataType>(tensor->dtype());
+  DLDataType dl_dtype = GetDlDataType(data_type, status);
+  if (!status->status.ok()) {
+    return nullptr;
+  }
+  DLContext dl_ctx = GetDlContext(h, status);
+  if (!status->status.ok()) {
+    return nullptr;
+  }
+  // Waits for the pending work of the device on the tensor, as the consumer
+  // reads it on its own streams.
+  void* data = TFE_TensorHandleDevicePointer(h, status);
+  if (!status->status.ok()) {
+    return nullptr;
+  }
   TensorReference tensor_ref(*tensor);  // This will call buf_->Ref()
 
   auto* tf_dlm_tensor_ctx = new TfDlManagedTensorCtx(tensor_ref);
-  tf_dlm_tensor_ctx->reference = tensor_ref;
 
   DLManagedTensor* dlm_tensor = &tf_dlm_tensor_ctx->tensor;
   dlm_tensor->manager_ctx = tf_dlm_tensor_ctx;
   dlm_tensor->deleter = &DLManagedTensorDeleter;
-  dlm_tensor->dl_tensor.ctx = GetDlContext(h, status);
+  dlm_tensor->dl_tensor.ctx = dl_ctx;
   int ndim = tensor->dims();
   dlm_tensor->dl_tensor.ndim = ndim;
-  dlm_tensor->dl_tensor.data = TFE_TensorHandleDevicePointer(h, status);
-  dlm_tensor->dl_tensor.dtype = GetDlDataType(data_type, status);
+  dlm_tensor->dl_tensor.data = data;
+  dlm_tensor->dl_tensor.dtype = dl_dtype;
 
   std::vector<int64_t>* shape_arr = &tf_dlm_tensor_ctx->shape;
   std::vector<int64_t>* stride_arr = &tf_dlm_tensor_ctx->strides;
@@ -276,13 +340,13 @@ void* TFE_HandleToDLPack(TFE_TensorHandle* h, TF_Status* status) {
     (*stride_arr)[i] = (*shape_arr)[i + 1] * (*stride_arr)[i + 1];
   }
 
-  dlm_tensor->dl_tensor.shape = &(*shape_arr)[0];
+  dlm_tensor->dl_tensor.shape = shape_arr->data();
   // There are two ways to represent compact row-major data
   // 1) nullptr indicates tensor is compact and row-majored.
   // 2) fill in the strides array as the real case for compact row-major data.
   // Here we choose option 2, since some frameworks didn't handle the strides
   // argument properly.
-  dlm_tensor->dl_tensor.strides = &(*stride_arr)[0];
+  dlm_tensor->dl_tensor.strides = stride_arr->data();
   dlm_tensor->dl_tensor.byte_offset =
       0;  // TF doesn't handle the strides and byte_offsets here
   return static_cast<void*>(dlm_tensor);
@@ -305,27 +369,53 @@ TFE_TensorHandle* TFE_HandleFromDLPack(void* dlm, TF_Status* status,
     status->status = std::move(s);
     return nullptr;
   }
+  if (dl_tensor->dtype.lanes != 1) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Unsupported number of lanes from DLPack: ", dl_tensor->dtype.lanes);
+    return nullptr;
+  }
   int num_dims = dl_tensor->ndim;
   const int64_t* dims = dl_tensor->shape;
-  void* data = dl_tensor->data;
+  char* data = static_cast<char*>(dl_tensor->data) + dl_tensor->byte_offset;
 
-  size_t total_bytes = dl_tensor->dtype.bits / 8;
+  const size_t element_size = dl_tensor->dtype.bits / 8;
+  int64_t num_elements = 1;
   for (int i = 0; i < num_dims; i++) {
-    total_bytes *= dims[i];
+    num_elements *= dims[i];
   }
+  const size_t total_bytes = num_elements * element_size;
 
-  if (dl_tensor->strides != nullptr &&
-      !IsValidStrideCompactRowMajorData(dl_tensor->shape, dl_tensor->strides,
-                                        num_dims)) {
+  const bool is_compact =
+      dl_tensor->strides == nullptr ||
+      IsValidStrideCompactRowMajorData(dl_tensor->shape, dl_tensor->strides,
+                                       num_dims);
+  const bool on_host = dl_tensor->ctx.device_type == DLDeviceType::kDLCPU ||
+                       dl_tensor->ctx.device_type == DLDeviceType::kDLCPUPinned;
+  const bool is_aligned =
+      reinterpret_cast<intptr_t>(data) % std::max(1, EIGEN_MAX_ALIGN_BYTES) ==
+      0;
+  // TF kernels expect compact row-major data, aligned like TF's allocations on
+  // the host.  Other host tensors are copied; device memory is never copied.
+  if (is_compact && (is_aligned || !on_host)) {
+    return TFE_NewTensorHandleFromDeviceMemory(
+        ctx, device_name.value().c_str(), dtype, dims, num_dims, data,
+        total_bytes, &DeallocatorWrapperFunc, dlmt, status);
+  }
+  if (!on_host) {
     status->status = tensorflow::errors::InvalidArgument(
         "Invalid strides array from DLPack");
     return nullptr;
   }
-
-  TFE_TensorHandle* handle = TFE_NewTensorHandleFromDeviceMemory(
-      ctx, device_name.value().c_str(), dtype, dims, num_dims, data,
-      total_bytes, &DeallocatorWrapperFunc, dlmt, status);
-
+  TF_Tensor* tensor = TF_AllocateTensor(dtype, dims, num_dims, total_bytes);
+  CopyToCompactRowMajor(*dl_tensor, data, element_size, num_elements,
+                        static_cast<char*>(TF_TensorData(tensor)));
+  TFE_TensorHandle* handle = TFE_NewTensorHandle(tensor, status);
+  TF_DeleteTensor(tensor);
+  if (!status->status.ok()) {
+    return nullptr;
+  }
+  // The DLPack tensor is consumed, as on the zero-copy path.
+  TFE_CallDLManagedTensorDeleter(dlmt);
   return handle;
 }
 
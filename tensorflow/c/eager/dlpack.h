@@ -25,10 +25,21 @@ const char* const kDlTensorCapsuleName = "dltensor";
 
 // Converts eager tensor handle to DLPack (DLManagedTensor*), and return the
 // void* for further PyCapsule construction.
+//
+// The DLPack tensor shares the buffer of the handle.  The pending work of the
+// device on it is done before returning, so the consumer may read it on any
+// stream.
 TF_CAPI_EXPORT extern void* TFE_HandleToDLPack(TFE_TensorHandle* h,
                                                TF_Status* status);
 
 // Converts DLPack (DLManagedTensor*) to eager tensor handle.
+//
+// The handle shares the buffer of the DLPack tensor if its layout is compact
+// and row-major, which includes any strides of dimensions of size 1, and on
+// the host if it is aligned like TF's allocations.  Other host tensors are
+// copied, and other device tensors are rejected.  The producer must have
+// finished writing the tensor, as TF reads it on its own streams.  On success,
+// the DLPack tensor is consumed.
 TF_CAPI_EXPORT extern TFE_TensorHandle* TFE_HandleFromDLPack(void* dlm,
                                                              TF_Status* status,
                                                              TFE_Context* ctx);
@@ -0,0 +1,133 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/c/eager/dlpack.h"
+
+#include <utility>
+#include <vector>
+
+#include "include/dlpack/dlpack.h"  // from @dlpack
+#include "tensorflow/c/eager/c_api.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// A host DLPack tensor over a vector of floats, which counts its deletions.
+struct FloatDLTensor {
+  FloatDLTensor(std::vector<int64_t> shape, std::vector<int64_t> strides,
+                uint64_t byte_offset)
+      : shape(std::move(shape)), strides(std::move(strides)) {
+    for (int i = 0; i < kSize; ++i) data[i] = i;
+    DLTensor& dl_tensor = managed.dl_tensor;
+    dl_tensor.data = data;
+    dl_tensor.ctx = {kDLCPU, 0};
+    dl_tensor.ndim = this->shape.size();
+    dl_tensor.dtype = {kDLFloat, 32, 1};
+    dl_tensor.shape = this->shape.data();
+    dl_tensor.strides = this->strides.empty() ? nullptr : this->strides.data();
+    dl_tensor.byte_offset = byte_offset;
+    managed.manager_ctx = this;
+    managed.deleter = [](DLManagedTensor* self) {
+      ++static_cast<FloatDLTensor*>(self->manager_ctx)->num_deletes;
+    };
+  }
+
+  // Room for any offset and stride used by the tests, aligned like TF's
+  // allocations.
+  static constexpr int kSize = 64;
+  alignas(64) float data[kSize];
+  std::vector<int64_t> shape;
+  std::vector<int64_t> strides;
+  DLManagedTensor managed;
+  int num_deletes = 0;
+};
+
+class DLPackTest : public ::testing::Test {
+ protected:
+  DLPackTest() : status_(TF_NewStatus()) {
+    TFE_ContextOptions* opts = TFE_NewContextOptions();
+    ctx_ = TFE_NewContext(opts, status_);
+    TFE_DeleteContextOptions(opts);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  }
+
+  ~DLPackTest() override {
+    TFE_DeleteContext(ctx_);
+    TF_DeleteStatus(status_);
+  }
+
+  // Converts "tensor" and returns the values of the handle, and whether they
+  // share the buffer of "tensor".
+  std::vector<float> FromDLPack(FloatDLTensor* tensor, bool* shared) {
+    TFE_TensorHandle* h = TFE_HandleFromDLPack(&tensor->managed, status_, ctx_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TF_Tensor* t = TFE_TensorHandleResolve(h, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    const float* values = static_cast<const float*>(TF_TensorData(t));
+    *shared = values == reinterpret_cast<const float*>(
+                            reinterpret_cast<const char*>(tensor->data) +
+                            tensor->managed.dl_tensor.byte_offset);
+    std::vector<float> result(values,
+                              values + TF_TensorByteSize(t) / sizeof(float));
+    TF_DeleteTensor(t);
+    TFE_DeleteTensorHandle(h);
+    return result;
+  }
+
+  TF_Status* status_;
+  TFE_Context* ctx_;
+};
+
+TEST_F(DLPackTest, CompactTensorIsShared) {
+  // The stride of a dimension of size 1 is never used.
+  FloatDLTensor tensor({2, 1, 3}, {3, 42, 1}, 0);
+  bool shared = false;
+  EXPECT_EQ(FromDLPack(&tensor, &shared),
+            std::vector<float>({0, 1, 2, 3, 4, 5}));
+  EXPECT_TRUE(shared);
+  // The buffer is released with the handle.
+  EXPECT_EQ(tensor.num_deletes, 1);
+}
+
+TEST_F(DLPackTest, StridedTensorIsCopied) {
+  // Every other column of a 2x6 matrix, starting at column 1.
+  FloatDLTensor tensor({2, 3}, {6, 2}, sizeof(float));
+  bool shared = true;
+  EXPECT_EQ(FromDLPack(&tensor, &shared),
+            std::vector<float>({1, 3, 5, 7, 9, 11}));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(tensor.num_deletes, 1);
+}
+
+TEST_F(DLPackTest, MisalignedTensorIsCopied) {
+  FloatDLTensor tensor({4}, {}, sizeof(float));
+  bool shared = true;
+  EXPECT_EQ(FromDLPack(&tensor, &shared), std::vector<float>({1, 2, 3, 4}));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(tensor.num_deletes, 1);
+}
+
+TEST_F(DLPackTest, UnsupportedLanes) {
+  FloatDLTensor tensor({4}, {}, 0);
+  tensor.managed.dl_tensor.dtype.lanes = 4;
+  TFE_TensorHandle* h = TFE_HandleFromDLPack(&tensor.managed, status_, ctx_);
+  EXPECT_EQ(h, nullptr);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status_));
+  EXPECT_EQ(tensor.num_deletes, 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,14 +15,22 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <limits>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader_util.h"
 #include "tensorflow/cc/saved_model/reader.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
@@ -32,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
@@ -219,6 +228,460 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
                  nullptr /* outputs */, &run_metadata, session);
 }
 
+// The largest constant created by folding the graph frozen for serving.
+constexpr int64 kServingMaxConstantSize = 1LL << 30;
+// Graphs larger than this can't be serialized, so the graph isn't frozen if
+// the frozen graph would be larger.
+constexpr int64 kServingMaxGraphSize = std::numeric_limits<int32>::max();
+// The depth of nested function calls through which the resource variables
+// passed to a function call are found to be only read.
+constexpr int kServingMaxCallDepth = 16;
+
+bool IsVariable(const NodeDef& node) {
+  return node.op() == "VariableV2" || node.op() == "Variable" ||
+         node.op() == "VarHandleOp";
+}
+
+void AddTensorNames(const TensorInfo& tensor_info,
+                    std::vector<string>* tensor_names) {
+  if (tensor_info.has_coo_sparse()) {
+    const TensorInfo::CooSparse& coo_sparse = tensor_info.coo_sparse();
+    tensor_names->push_back(coo_sparse.values_tensor_name());
+    tensor_names->push_back(coo_sparse.indices_tensor_name());
+    tensor_names->push_back(coo_sparse.dense_shape_tensor_name());
+  } else if (tensor_info.has_composite_tensor()) {
+    for (const auto& component : tensor_info.composite_tensor().components()) {
+      tensor_names->push_back(component.name());
+    }
+  } else {
+    tensor_names->push_back(tensor_info.name());
+  }
+}
+
+// Strips the output index, or the control input marker, from `input`.
+string NodeNameOfInput(const string& input) {
+  const size_t start = input[0] == '^' ? 1 : 0;
+  return input.substr(start, input.find(':') - start);
+}
+
+// Sets `reachable` to the nodes of `graph_def` that the nodes `roots` depend
+// on.
+Status GetReachableNodes(const GraphDef& graph_def,
+                         const std::vector<string>& roots,
+                         std::unordered_set<string>* reachable) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  std::vector<string> to_visit;
+  for (const string& root : roots) {
+    to_visit.push_back(NodeNameOfInput(root));
+  }
+  while (!to_visit.empty()) {
+    const string name = to_visit.back();
+    to_visit.pop_back();
+    if (!reachable->insert(name).second) {
+      continue;
+    }
+    const auto node_it = nodes.find(name);
+    if (node_it == nodes.end()) {
+      return errors::InvalidArgument("Node ", name, " not found in the graph");
+    }
+    for (const string& input : node_it->second->input()) {
+      to_visit.push_back(NodeNameOfInput(input));
+    }
+  }
+  return Status::OK();
+}
+
+// Moves the nodes `reachable` of `graph_def`, in order, to `pruned`, and
+// clears `graph_def`.
+void PruneGraph(const std::unordered_set<string>& reachable,
+                GraphDef* graph_def, GraphDef* pruned) {
+  pruned->mutable_versions()->Swap(graph_def->mutable_versions());
+  pruned->mutable_library()->Swap(graph_def->mutable_library());
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (reachable.count(node.name())) {
+      pruned->add_node()->Swap(&node);
+    }
+  }
+  graph_def->Clear();
+}
+
+// The graph of a SavedModel frozen for serving a signature, with the nodes
+// restoring the variables that were kept.
+struct FrozenGraph {
+  GraphDef graph_def;
+  std::vector<std::pair<string, Tensor>> restore_inputs;
+  std::vector<string> restore_targets;
+};
+
+using FunctionMap = std::unordered_map<string, const FunctionDef*>;
+
+// Returns the function that `node` calls, or null if it isn't a call of a
+// function of `functions`.
+const FunctionDef* GetCalledFunction(const FunctionMap& functions,
+                                     const NodeDef& node) {
+  if (node.op() != "PartitionedCall" &&
+      node.op() != "StatefulPartitionedCall") {
+    return nullptr;
+  }
+  const auto f_it = node.attr().find("f");
+  if (f_it == node.attr().end()) {
+    return nullptr;
+  }
+  const auto function_it = functions.find(f_it->second.func().name());
+  return function_it == functions.end() ? nullptr : function_it->second;
+}
+
+// Returns true if the resource variable passed as the input `index` of the
+// function call `node` is only read by the function, with ReadVariableOp nodes
+// in it or in the functions it calls.
+bool IsReadOnlyCallInput(const FunctionMap& functions, const NodeDef& node,
+                         int index, int depth) {
+  const FunctionDef* function = GetCalledFunction(functions, node);
+  if (function == nullptr || depth > kServingMaxCallDepth ||
+      index >= function->signature().input_arg_size()) {
+    return false;
+  }
+  const string& arg = function->signature().input_arg(index).name();
+  for (const NodeDef& body_node : function->node_def()) {
+    int input_index = 0;
+    for (const string& input : body_node.input()) {
+      if (input[0] == '^') {
+        continue;
+      }
+      const int body_index = input_index++;
+      if (NodeNameOfInput(input) == arg && body_node.op() != "ReadVariableOp" &&
+          !IsReadOnlyCallInput(functions, body_node, body_index, depth + 1)) {
+        return false;
+      }
+    }
+  }
+  for (const auto& ret : function->ret()) {
+    if (NodeNameOfInput(ret.second) == arg) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The variables of a graph whose values are only read.
+struct ReadOnlyVariables {
+  std::unordered_set<string> variables;
+  // The function calls they are passed to, by TF2 models, with the indices and
+  // the types of their inputs that are read-only variables.
+  std::unordered_map<string, std::map<int, DataType>> call_inputs;
+};
+
+// Returns the variables of `graph_def` whose values are only read, by
+// ReadVariableOp nodes for resource variables and Identity nodes otherwise.
+// Resource variables may also be read in functions they are passed to.
+ReadOnlyVariables GetReadOnlyVariables(const GraphDef& graph_def) {
+  FunctionMap functions;
+  for (const FunctionDef& function : graph_def.library().function()) {
+    functions[function.signature().name()] = &function;
+  }
+  std::unordered_map<string, const NodeDef*> variables;
+  for (const NodeDef& node : graph_def.node()) {
+    if (IsVariable(node)) {
+      variables[node.name()] = &node;
+    }
+  }
+  std::unordered_set<string> updated_variables;
+  std::unordered_map<string, std::vector<std::pair<string, int>>>
+      variable_calls;
+  for (const NodeDef& node : graph_def.node()) {
+    int input_index = 0;
+    for (const string& input : node.input()) {
+      if (input[0] == '^') {
+        continue;
+      }
+      const int index = input_index++;
+      const auto variable_it = variables.find(NodeNameOfInput(input));
+      if (variable_it == variables.end()) {
+        continue;
+      }
+      const NodeDef& variable = *variable_it->second;
+      if (variable.op() != "VarHandleOp") {
+        if (node.op() != "Identity") {
+          updated_variables.insert(variable.name());
+        }
+      } else if (IsReadOnlyCallInput(functions, node, index, /*depth=*/0)) {
+        variable_calls[variable.name()].emplace_back(node.name(), index);
+      } else if (node.op() != "ReadVariableOp") {
+        updated_variables.insert(variable.name());
+      }
+    }
+  }
+  ReadOnlyVariables read_only;
+  for (const auto& variable : variables) {
+    if (updated_variables.count(variable.first)) {
+      continue;
+    }
+    read_only.variables.insert(variable.first);
+    const DataType dtype = variable.second->attr().at("dtype").type();
+    for (const auto& call : variable_calls[variable.first]) {
+      read_only.call_inputs[call.first][call.second] = dtype;
+    }
+  }
+  return read_only;
+}
+
+// Replaces the ReadVariableOp `node`, which reads a variable replaced by its
+// value, with an Identity.
+void ReplaceReadWithIdentity(NodeDef* node) {
+  const AttrValue dtype = node->attr().at("dtype");
+  node->set_op("Identity");
+  node->clear_attr();
+  (*node->mutable_attr())["T"] = dtype;
+}
+
+// Makes the function call `node` call a copy of its function, added to
+// `new_functions`, which takes the values of the read-only variables passed to
+// its inputs `frozen_inputs`, of the given types, instead of their handles.
+void SpecializeFunctionCall(const FunctionMap& functions,
+                            const std::map<int, DataType>& frozen_inputs,
+                            NodeDef* node, FunctionDefLibrary* new_functions) {
+  FunctionDef* function = new_functions->add_function();
+  *function = *GetCalledFunction(functions, *node);
+  const string name =
+      strings::StrCat(function->signature().name(), "_frozen_for_serving_",
+                      new_functions->function_size());
+  function->mutable_signature()->set_name(name);
+  std::unordered_map<string, DataType> frozen_args;
+  AttrValue::ListValue* tin = (*node->mutable_attr())["Tin"].mutable_list();
+  for (const auto& input : frozen_inputs) {
+    OpDef::ArgDef* arg =
+        function->mutable_signature()->mutable_input_arg(input.first);
+    arg->set_type(input.second);
+    frozen_args[arg->name()] = input.second;
+    function->mutable_arg_attr()->erase(input.first);
+    function->mutable_resource_arg_unique_id()->erase(input.first);
+    tin->set_type(input.first, input.second);
+  }
+  (*node->mutable_attr())["f"].mutable_func()->set_name(name);
+
+  for (NodeDef& body_node : *function->mutable_node_def()) {
+    std::map<int, DataType> frozen_body_inputs;
+    int input_index = 0;
+    for (const string& input : body_node.input()) {
+      if (input[0] == '^') {
+        continue;
+      }
+      const int body_index = input_index++;
+      const auto arg_it = frozen_args.find(NodeNameOfInput(input));
+      if (arg_it != frozen_args.end()) {
+        frozen_body_inputs[body_index] = arg_it->second;
+      }
+    }
+    if (frozen_body_inputs.empty()) {
+      continue;
+    }
+    if (body_node.op() == "ReadVariableOp") {
+      ReplaceReadWithIdentity(&body_node);
+    } else {
+      SpecializeFunctionCall(functions, frozen_body_inputs, &body_node,
+                             new_functions);
+    }
+  }
+}
+
+// Freezes the graph of `session` for serving `signature`: the graph is pruned
+// to the nodes the signature and the init op need, the variables the graph
+// only reads are replaced by constants with their values in `session`, and the
+// graph is constant folded. `source_graph` is cleared as soon as it's pruned.
+//
+// Returns a ResourceExhausted error if the frozen graph would be too large to
+// be serialized.
+Status FreezeGraphForServing(const RunOptions& run_options,
+                             const SignatureDef& signature,
+                             const string& init_op_name,
+                             const std::vector<AssetFileDef>& asset_file_defs,
+                             Session* session, GraphDef* source_graph,
+                             FrozenGraph* frozen) {
+  std::vector<string> feeds;
+  for (const auto& input : signature.inputs()) {
+    AddTensorNames(input.second, &feeds);
+  }
+  for (const auto& asset_file_def : asset_file_defs) {
+    feeds.push_back(asset_file_def.tensor_info().name());
+  }
+  std::vector<string> fetches;
+  for (const auto& output : signature.outputs()) {
+    AddTensorNames(output.second, &fetches);
+  }
+  if (!init_op_name.empty()) {
+    fetches.push_back(init_op_name);
+  }
+  std::vector<string> roots(fetches);
+  roots.insert(roots.end(), feeds.begin(), feeds.end());
+
+  GraphDef graph_def;
+  {
+    std::unordered_set<string> reachable;
+    TF_RETURN_IF_ERROR(GetReachableNodes(*source_graph, roots, &reachable));
+    PruneGraph(reachable, source_graph, &graph_def);
+  }
+
+  // Read the values of the variables, from nodes added to the session for
+  // resource variables.
+  const ReadOnlyVariables read_only_variables = GetReadOnlyVariables(graph_def);
+  std::vector<const NodeDef*> variables;
+  std::vector<string> value_names;
+  GraphDef read_nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    if (!IsVariable(node)) {
+      continue;
+    }
+    variables.push_back(&node);
+    if (node.op() == "VarHandleOp") {
+      NodeDef* read = read_nodes.add_node();
+      read->set_name(strings::StrCat(node.name(), "/ReadForServing"));
+      read->set_op("ReadVariableOp");
+      read->set_device(node.device());
+      read->add_input(node.name());
+      (*read->mutable_attr())["dtype"] = node.attr().at("dtype");
+      value_names.push_back(strings::StrCat(read->name(), ":0"));
+    } else {
+      value_names.push_back(strings::StrCat(node.name(), ":0"));
+    }
+  }
+  std::vector<Tensor> values;
+  if (!variables.empty()) {
+    if (read_nodes.node_size() > 0) {
+      TF_RETURN_IF_ERROR(session->Extend(read_nodes));
+    }
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(RunOnce(run_options, {}, value_names, {}, &values,
+                               &run_metadata, session));
+  }
+  std::unordered_map<string, Tensor*> read_only_values;
+  int64 frozen_size = graph_def.ByteSizeLong();
+  for (size_t i = 0; i < variables.size(); ++i) {
+    const NodeDef& variable = *variables[i];
+    if (read_only_variables.variables.count(variable.name())) {
+      read_only_values[variable.name()] = &values[i];
+      frozen_size += values[i].TotalBytes();
+      continue;
+    }
+    // The variables the graph may update are restored by assigning them their
+    // current values.
+    const string prefix =
+        strings::StrCat(variable.name(), "/RestoreForServing");
+    NodeDef* value = graph_def.add_node();
+    value->set_name(strings::StrCat(prefix, "/value"));
+    value->set_op("Placeholder");
+    value->set_device(variable.device());
+    (*value->mutable_attr())["dtype"] = variable.attr().at("dtype");
+    values[i].shape().AsProto(
+        (*value->mutable_attr())["shape"].mutable_shape());
+    NodeDef* assign = graph_def.add_node();
+    assign->set_name(prefix);
+    assign->set_device(variable.device());
+    assign->add_input(variable.name());
+    assign->add_input(value->name());
+    if (variable.op() == "VarHandleOp") {
+      assign->set_op("AssignVariableOp");
+      (*assign->mutable_attr())["dtype"] = variable.attr().at("dtype");
+    } else {
+      assign->set_op("Assign");
+      (*assign->mutable_attr())["T"] = variable.attr().at("dtype");
+    }
+    frozen->restore_inputs.emplace_back(strings::StrCat(value->name(), ":0"),
+                                        values[i]);
+    frozen->restore_targets.push_back(assign->name());
+  }
+  if (frozen_size > kServingMaxGraphSize) {
+    return errors::ResourceExhausted("The graph frozen for serving would have ",
+                                     frozen_size, " bytes");
+  }
+
+  // The values are released as they are copied to the constants.
+  FunctionMap functions;
+  for (const FunctionDef& function : graph_def.library().function()) {
+    functions[function.signature().name()] = &function;
+  }
+  FunctionDefLibrary new_functions;
+  for (NodeDef& node : *graph_def.mutable_node()) {
+    const auto value_it = read_only_values.find(node.name());
+    if (value_it != read_only_values.end()) {
+      const AttrValue dtype = node.attr().at("dtype");
+      node.set_op("Const");
+      node.clear_attr();
+      (*node.mutable_attr())["dtype"] = dtype;
+      value_it->second->AsProtoTensorContent(
+          (*node.mutable_attr())["value"].mutable_tensor());
+      *value_it->second = Tensor();
+    } else if (node.op() == "ReadVariableOp" &&
+               read_only_values.count(NodeNameOfInput(node.input(0)))) {
+      ReplaceReadWithIdentity(&node);
+    } else {
+      const auto call_it = read_only_variables.call_inputs.find(node.name());
+      if (call_it != read_only_variables.call_inputs.end()) {
+        SpecializeFunctionCall(functions, call_it->second, &node,
+                               &new_functions);
+      }
+    }
+  }
+  for (FunctionDef& function : *new_functions.mutable_function()) {
+    graph_def.mutable_library()->add_function()->Swap(&function);
+  }
+  LOG(INFO) << "Froze " << read_only_variables.variables.size() << " of "
+            << variables.size() << " variables for serving.";
+  read_only_values.clear();
+  values.clear();
+
+  grappler::GrapplerItem item;
+  item.id = "serving";
+  for (const string& feed : feeds) {
+    item.feed.emplace_back(feed, Tensor());
+  }
+  for (const auto& restore_input : frozen->restore_inputs) {
+    item.feed.emplace_back(restore_input.first, Tensor());
+  }
+  item.fetch = fetches;
+  item.fetch.insert(item.fetch.end(), frozen->restore_targets.begin(),
+                    frozen->restore_targets.end());
+  item.graph.Swap(&graph_def);
+  grappler::ConstantFolding constant_folding(
+      RewriterConfig::ON, /*cpu_device=*/nullptr,
+      /*disable_compressed_tensor_optimization=*/false,
+      kServingMaxConstantSize);
+  const Status folding_status =
+      constant_folding.Optimize(/*cluster=*/nullptr, item, &graph_def);
+  if (!folding_status.ok()) {
+    LOG(WARNING) << "Failed to fold the constants of the graph frozen for "
+                    "serving: "
+                 << folding_status;
+    graph_def.Swap(&item.graph);
+  }
+  item.graph.Clear();
+
+  // Drop the constants made unused by folding, and the variables they held.
+  roots.insert(roots.end(), frozen->restore_targets.begin(),
+               frozen->restore_targets.end());
+  std::unordered_set<string> reachable;
+  TF_RETURN_IF_ERROR(GetReachableNodes(graph_def, roots, &reachable));
+  PruneGraph(reachable, &graph_def, &frozen->graph_def);
+  if (frozen->graph_def.ByteSizeLong() > kServingMaxGraphSize) {
+    return errors::ResourceExhausted("The graph frozen for serving has ",
+                                     frozen->graph_def.ByteSizeLong(),
+                                     " bytes");
+  }
+  return Status::OK();
+}
+
+// Marks the RestoreV2 nodes of `graph_def`, so that they return read-only views
+// of the memory-mapped checkpoint instead of copies where possible.
+void MemoryMapRestoredTensors(GraphDef* graph_def) {
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (node.op() == "RestoreV2") {
+      (*node.mutable_attr())["_memory_mapped"].set_b(true);
+    }
+  }
+}
+
 }  // namespace
 
 SavedModelBundleInterface::~SavedModelBundleInterface() {}
@@ -237,9 +700,13 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
+                              bool memory_map_variables,
                               SavedModelBundle* const bundle) {
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
+  if (memory_map_variables) {
+    MemoryMapRestoredTensors(bundle->meta_graph_def.mutable_graph_def());
+  }
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
@@ -249,14 +716,17 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   return Status::OK();
 }
 
-Status LoadSavedModel(const SessionOptions& session_options,
-                      const RunOptions& run_options, const string& export_dir,
-                      const std::unordered_set<string>& tags,
-                      SavedModelBundle* const bundle) {
+Status LoadSavedModelAndCount(const SessionOptions& session_options,
+                              const RunOptions& run_options,
+                              const string& export_dir,
+                              const std::unordered_set<string>& tags,
+                              bool memory_map_variables,
+                              SavedModelBundle* const bundle) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status =
+      LoadSavedModelInternal(session_options, run_options, export_dir, tags,
+                             memory_map_variables, bundle);
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "SavedModel load for tags { " << absl::StrJoin(tags, " ")
               << " }; Status: " << status_str << ": " << status << ". Took "
@@ -273,6 +743,14 @@ Status LoadSavedModel(const SessionOptions& session_options,
   return status;
 }
 
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle) {
+  return LoadSavedModelAndCount(session_options, run_options, export_dir, tags,
+                                /*memory_map_variables=*/false, bundle);
+}
+
 namespace {
 // Session wrapper that prevents calls to Session::Create(), Session::Extend(),
 // and the deprecated partial-run methods.
@@ -411,10 +889,12 @@ Status RestoreSession(const RunOptions& run_options,
   return Status::OK();
 }
 
-Status LoadSavedModel(const SessionOptions& session_options,
-                      const RunOptions& run_options, const string& export_dir,
-                      const std::unordered_set<string>& tags,
-                      SavedModelBundleLite* const bundle) {
+Status LoadSavedModelLite(const SessionOptions& session_options,
+                          const RunOptions& run_options,
+                          const string& export_dir,
+                          const std::unordered_set<string>& tags,
+                          bool memory_map_variables,
+                          SavedModelBundleLite* const bundle) {
   SavedModelBundle legacy_bundle;
   SessionOptions rewritten_options(session_options);
   // We disallow calls to Session::Extend() on the returned session, so we can
@@ -428,14 +908,107 @@ Status LoadSavedModel(const SessionOptions& session_options,
       ->set_disable_output_partition_graphs(true);
   // TODO(mrry): Consider specializing the session creation to reduce peak
   // RAM consumption by using `Session::Create(GraphDef&&)`.
-  TF_RETURN_IF_ERROR(LoadSavedModel(rewritten_options, run_options, export_dir,
-                                    tags, &legacy_bundle));
+  TF_RETURN_IF_ERROR(LoadSavedModelAndCount(rewritten_options, run_options,
+                                            export_dir, tags,
+                                            memory_map_variables,
+                                            &legacy_bundle));
   *bundle = SavedModelBundleLite(
       absl::make_unique<LiteSessionWrapper>(std::move(legacy_bundle.session)),
       std::move(*legacy_bundle.meta_graph_def.mutable_signature_def()));
   return Status::OK();
 }
 
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundleLite* const bundle) {
+  return LoadSavedModelLite(session_options, run_options, export_dir, tags,
+                            /*memory_map_variables=*/false, bundle);
+}
+
+Status LoadSavedModelWithMappedVariables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    SavedModelBundleLite* const bundle) {
+  return LoadSavedModelLite(session_options, run_options, export_dir, tags,
+                            /*memory_map_variables=*/true, bundle);
+}
+
+Status LoadSavedModelForServing(const SessionOptions& session_options,
+                                const RunOptions& run_options,
+                                const string& export_dir,
+                                const std::unordered_set<string>& tags,
+                                const string& signature_key,
+                                SavedModelBundleLite* const bundle) {
+  SavedModelBundle legacy_bundle;
+  SessionOptions load_options(session_options);
+  // The values of the resource variables are read by nodes added to the graph.
+  load_options.config.mutable_experimental()->set_optimize_for_static_graph(
+      false);
+  TF_RETURN_IF_ERROR(LoadSavedModel(load_options, run_options, export_dir,
+                                    tags, &legacy_bundle));
+  MetaGraphDef& meta_graph = legacy_bundle.meta_graph_def;
+  const auto signature_it = meta_graph.signature_def().find(signature_key);
+  if (signature_it == meta_graph.signature_def().end()) {
+    return errors::NotFound("SavedModel at ", export_dir,
+                            " has no signature ", signature_key);
+  }
+  protobuf::Map<string, SignatureDef> signatures;
+  signatures[signature_key] = signature_it->second;
+  std::vector<AssetFileDef> asset_file_defs;
+  TF_RETURN_IF_ERROR(internal::GetAssetFileDefs(meta_graph, &asset_file_defs));
+  string init_op_name;
+  TF_RETURN_IF_ERROR(
+      internal::GetInitOp(export_dir, meta_graph, &init_op_name));
+
+  const uint64 freeze_start_microseconds = Env::Default()->NowMicros();
+  FrozenGraph frozen;
+  const Status freeze_status = FreezeGraphForServing(
+      run_options, signatures[signature_key], init_op_name, asset_file_defs,
+      legacy_bundle.session.get(), meta_graph.mutable_graph_def(), &frozen);
+  if (errors::IsResourceExhausted(freeze_status)) {
+    // Serve the graph as loaded, which its session already holds.
+    LOG(WARNING) << "Not freezing the SavedModel at " << export_dir
+                 << " for serving: " << freeze_status;
+    *bundle = SavedModelBundleLite(
+        absl::make_unique<LiteSessionWrapper>(
+            std::move(legacy_bundle.session)),
+        std::move(signatures));
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(freeze_status);
+  // Release the variables of the original session before creating the new
+  // one.
+  TF_RETURN_IF_ERROR(legacy_bundle.session->Close());
+  legacy_bundle.session.reset();
+
+  SessionOptions rewritten_options(session_options);
+  rewritten_options.config.mutable_experimental()
+      ->set_optimize_for_static_graph(true);
+  rewritten_options.config.mutable_experimental()
+      ->set_disable_output_partition_graphs(true);
+  Session* session_p = nullptr;
+  TF_RETURN_IF_ERROR(NewSession(rewritten_options, &session_p));
+  std::unique_ptr<Session> session(session_p);
+  TF_RETURN_IF_ERROR(session->Create(std::move(frozen.graph_def)));
+  if (!frozen.restore_targets.empty()) {
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(RunOnce(run_options, frozen.restore_inputs, {},
+                               frozen.restore_targets, nullptr /* outputs */,
+                               &run_metadata, session.get()));
+    frozen.restore_inputs.clear();
+  }
+  TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, meta_graph,
+                               asset_file_defs, session.get(), init_op_name));
+  load_latency_by_stage->GetCell(export_dir, "freeze_for_serving")
+      ->Add(GetLatencyMicroseconds(freeze_start_microseconds));
+
+  *bundle = SavedModelBundleLite(
+      absl::make_unique<LiteSessionWrapper>(std::move(session)),
+      std::move(signatures));
+  return Status::OK();
+}
+
 bool MaybeSavedModelDirectory(const string& export_dir) {
   const string saved_model_pb_path =
       io::JoinPath(export_dir, kSavedModelFilenamePb);
@@ -134,6 +134,42 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundleLite* const bundle);
 
+/// Loads a SavedModel like the overload above, but restores the variables as
+/// read-only views of a memory mapping of the checkpoint where possible, so
+/// that processes serving the same model share the pages of its variables and
+/// loading does not copy them.
+///
+/// A tensor is only mapped if it is stored in the host byte order and at an
+/// offset aligned for Eigen, i.e. if the checkpoint was written with
+/// `BundleWriter::Options::data_alignment` set accordingly; the other tensors
+/// are copied as usual. Only resource variables keep pointing into the
+/// mapping: updating one copies its value first, and ref variables always
+/// copy the restored value into their own buffer.
+Status LoadSavedModelWithMappedVariables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    SavedModelBundleLite* const bundle);
+
+/// Loads a SavedModel like the overload above, then freezes its graph for
+/// serving only the signature `signature_key`: the graph is pruned to the nodes
+/// needed by the signature and the init op, the variables it only reads are
+/// replaced by constants and folded, and the other variables are dropped. The
+/// variables that the pruned graph may update are kept, with their restored
+/// values. The bundle only has the signature `signature_key`.
+///
+/// Resource variables passed to functions, as in TF2 models, are frozen too if
+/// the functions only read them. If the frozen graph would not fit in a 2GB
+/// GraphDef, the bundle serves the graph as loaded instead.
+///
+/// This uses less RAM than LoadSavedModel() when the graph has nodes the
+/// signature doesn't need, e.g. for training, at the cost of a longer load.
+Status LoadSavedModelForServing(const SessionOptions& session_options,
+                                const RunOptions& run_options,
+                                const string& export_dir,
+                                const std::unordered_set<string>& tags,
+                                const string& signature_key,
+                                SavedModelBundleLite* const bundle);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
@@ -0,0 +1,143 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/multi_signature_runner.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+Status MultiSignatureRunner::AddTensors(
+    const string& signature_key,
+    const protobuf::Map<string, TensorInfo>& tensor_infos,
+    std::vector<string>* names, std::unordered_map<string, int>* name_indices,
+    std::vector<TensorIndex>* indices) {
+  for (const auto& tensor_info : tensor_infos) {
+    if (tensor_info.second.encoding_case() != TensorInfo::kName) {
+      return errors::Unimplemented("Tensor ", tensor_info.first,
+                                   " of signature ", signature_key,
+                                   " is not a dense tensor");
+    }
+    const string& name = tensor_info.second.name();
+    auto inserted = name_indices->emplace(name, names->size());
+    if (inserted.second) {
+      names->push_back(name);
+    }
+    indices->push_back({tensor_info.first, inserted.first->second});
+  }
+  return Status::OK();
+}
+
+Status MultiSignatureRunner::Create(
+    const SavedModelBundleInterface& bundle,
+    const std::vector<string>& signature_keys, const RunOptions& run_options,
+    std::unique_ptr<MultiSignatureRunner>* runner) {
+  if (signature_keys.empty()) {
+    return errors::InvalidArgument("No signature to run");
+  }
+  CallableOptions callable_options;
+  *callable_options.mutable_run_options() = run_options;
+  std::vector<string> feeds;
+  std::vector<string> fetches;
+  std::unordered_map<string, int> feed_indices_by_name;
+  std::unordered_map<string, int> fetch_indices_by_name;
+  std::vector<std::vector<TensorIndex>> feed_indices(signature_keys.size());
+  std::vector<std::vector<TensorIndex>> fetch_indices(signature_keys.size());
+  const auto& signatures = bundle.GetSignatures();
+  for (int i = 0; i < signature_keys.size(); ++i) {
+    const auto signature_it = signatures.find(signature_keys[i]);
+    if (signature_it == signatures.end()) {
+      return errors::NotFound("Could not find signature ", signature_keys[i]);
+    }
+    const SignatureDef& signature = signature_it->second;
+    TF_RETURN_IF_ERROR(AddTensors(signature_keys[i], signature.inputs(),
+                                  &feeds, &feed_indices_by_name,
+                                  &feed_indices[i]));
+    TF_RETURN_IF_ERROR(AddTensors(signature_keys[i], signature.outputs(),
+                                  &fetches, &fetch_indices_by_name,
+                                  &fetch_indices[i]));
+  }
+  for (const string& feed : feeds) {
+    callable_options.add_feed(feed);
+  }
+  for (const string& fetch : fetches) {
+    callable_options.add_fetch(fetch);
+  }
+
+  Session* session = bundle.GetSession();
+  Session::CallableHandle handle;
+  TF_RETURN_IF_ERROR(session->MakeCallable(callable_options, &handle));
+  runner->reset(new MultiSignatureRunner(
+      session, handle, signature_keys, std::move(feed_indices),
+      std::move(fetch_indices), feeds.size()));
+  return Status::OK();
+}
+
+MultiSignatureRunner::MultiSignatureRunner(
+    Session* session, Session::CallableHandle handle,
+    std::vector<string> signature_keys,
+    std::vector<std::vector<TensorIndex>> feed_indices,
+    std::vector<std::vector<TensorIndex>> fetch_indices, int num_feeds)
+    : session_(session),
+      handle_(handle),
+      signature_keys_(std::move(signature_keys)),
+      feed_indices_(std::move(feed_indices)),
+      fetch_indices_(std::move(fetch_indices)),
+      num_feeds_(num_feeds) {}
+
+MultiSignatureRunner::~MultiSignatureRunner() {
+  session_->ReleaseCallable(handle_).IgnoreError();
+}
+
+Status MultiSignatureRunner::Run(const std::vector<TensorMap>& inputs,
+                                 std::vector<TensorMap>* outputs) {
+  if (inputs.size() != feed_indices_.size()) {
+    return errors::InvalidArgument("Expected the inputs of ",
+                                   feed_indices_.size(), " signatures, got ",
+                                   inputs.size());
+  }
+  std::vector<Tensor> feed_tensors(num_feeds_);
+  std::vector<bool> fed(num_feeds_, false);
+  for (int i = 0; i < inputs.size(); ++i) {
+    for (const TensorIndex& feed : feed_indices_[i]) {
+      const auto input_it = inputs[i].find(feed.key);
+      if (input_it == inputs[i].end()) {
+        return errors::InvalidArgument("Missing input ", feed.key,
+                                       " of signature ", signature_keys_[i]);
+      }
+      if (!fed[feed.index]) {
+        feed_tensors[feed.index] = input_it->second;
+        fed[feed.index] = true;
+      }
+    }
+  }
+
+  std::vector<Tensor> fetch_tensors;
+  TF_RETURN_IF_ERROR(session_->RunCallable(handle_, feed_tensors,
+                                           &fetch_tensors,
+                                           /*run_metadata=*/nullptr));
+  outputs->clear();
+  outputs->resize(fetch_indices_.size());
+  for (int i = 0; i < fetch_indices_.size(); ++i) {
+    for (const TensorIndex& fetch : fetch_indices_[i]) {
+      (*outputs)[i].emplace(fetch.key, fetch_tensors[fetch.index]);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/// Runs several signatures of a loaded SavedModel in a single step.
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_MULTI_SIGNATURE_RUNNER_H_
+#define TENSORFLOW_CC_SAVED_MODEL_MULTI_SIGNATURE_RUNNER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+
+/// Runs several signatures of a SavedModel with a single callable of its
+/// session. The nodes the signatures share, e.g. an embedding lookup or an
+/// encoder, run once per step instead of once per signature, and Grappler
+/// dedupes the identical subgraphs that the signatures build separately since
+/// it optimizes the subgraph of all the signatures at once.
+///
+/// The inputs of the signatures that are the same tensor are fed once. Only
+/// the signatures with dense inputs and outputs are supported.
+class MultiSignatureRunner {
+ public:
+  /// Map from input or output key to tensor, for one signature.
+  using TensorMap = std::unordered_map<string, Tensor>;
+
+  /// Creates a runner for the signatures `signature_keys` of `bundle`, which
+  /// must outlive the runner. `run_options` apply to every step.
+  static Status Create(const SavedModelBundleInterface& bundle,
+                       const std::vector<string>& signature_keys,
+                       const RunOptions& run_options,
+                       std::unique_ptr<MultiSignatureRunner>* runner);
+
+  ~MultiSignatureRunner();
+
+  /// Runs the signatures in one step. `inputs` holds the inputs of each
+  /// signature, in the order of `signature_keys`, and `outputs` is set to
+  /// their outputs in the same order. An input shared by several signatures
+  /// must be fed the same value by each of them: the first is used.
+  Status Run(const std::vector<TensorMap>& inputs,
+             std::vector<TensorMap>* outputs);
+
+ private:
+  // Where a tensor of a signature is in the feeds or the fetches of the
+  // callable.
+  struct TensorIndex {
+    string key;
+    int index;
+  };
+
+  // Adds the tensors of `tensor_infos` to `names`, once each, and appends to
+  // `indices` where they are in `names`.
+  static Status AddTensors(
+      const string& signature_key,
+      const protobuf::Map<string, TensorInfo>& tensor_infos,
+      std::vector<string>* names, std::unordered_map<string, int>* name_indices,
+      std::vector<TensorIndex>* indices);
+
+  MultiSignatureRunner(Session* session, Session::CallableHandle handle,
+                       std::vector<string> signature_keys,
+                       std::vector<std::vector<TensorIndex>> feed_indices,
+                       std::vector<std::vector<TensorIndex>> fetch_indices,
+                       int num_feeds);
+
+  Session* const session_;  // Not owned.
+  const Session::CallableHandle handle_;
+  const std::vector<string> signature_keys_;
+  const std::vector<std::vector<TensorIndex>> feed_indices_;
+  const std::vector<std::vector<TensorIndex>> fetch_indices_;
+  const int num_feeds_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MultiSignatureRunner);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_MULTI_SIGNATURE_RUNNER_H_
@@ -0,0 +1,119 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/multi_signature_runner.h"
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestDataSharded[] =
+    "cc/saved_model/testdata/half_plus_two/00000123";
+
+// Returns serialized Examples holding each of `xs` as feature "x".
+Tensor MakeSerializedExamples(const std::vector<float>& xs) {
+  std::vector<tstring> serialized_examples;
+  for (float x : xs) {
+    tensorflow::Example example;
+    auto* feature_map = example.mutable_features()->mutable_feature();
+    (*feature_map)["x"].mutable_float_list()->add_value(x);
+    serialized_examples.push_back(example.SerializeAsString());
+  }
+  return test::AsTensor<tstring>(
+      serialized_examples,
+      TensorShape({static_cast<int64>(serialized_examples.size())}));
+}
+
+class MultiSignatureRunnerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string export_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+    TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir,
+                                {kSavedModelTagServe}, &bundle_));
+  }
+
+  SavedModelBundleLite bundle_;
+};
+
+TEST_F(MultiSignatureRunnerTest, SharedInput) {
+  // Both signatures parse the same examples.
+  std::unique_ptr<MultiSignatureRunner> runner;
+  TF_ASSERT_OK(MultiSignatureRunner::Create(
+      bundle_, {"regress_x_to_y", "regress_x_to_y2"}, RunOptions(), &runner));
+
+  const Tensor examples = MakeSerializedExamples({0, 1, 2, 3});
+  std::vector<MultiSignatureRunner::TensorMap> outputs;
+  TF_ASSERT_OK(runner->Run(
+      {{{kRegressInputs, examples}}, {{kRegressInputs, examples}}}, &outputs));
+
+  ASSERT_EQ(outputs.size(), 2);
+  test::ExpectTensorEqual<float>(
+      outputs[0].at(kRegressOutputs),
+      test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
+  test::ExpectTensorEqual<float>(
+      outputs[1].at(kRegressOutputs),
+      test::AsTensor<float>({3, 3.5, 4, 4.5}, TensorShape({4, 1})));
+}
+
+TEST_F(MultiSignatureRunnerTest, SeparateInputs) {
+  std::unique_ptr<MultiSignatureRunner> runner;
+  TF_ASSERT_OK(MultiSignatureRunner::Create(
+      bundle_, {"regress_x_to_y", "serving_default"}, RunOptions(), &runner));
+
+  std::vector<MultiSignatureRunner::TensorMap> outputs;
+  TF_ASSERT_OK(runner->Run(
+      {{{kRegressInputs, MakeSerializedExamples({0, 1})}},
+       {{"x", test::AsTensor<float>({2, 3}, TensorShape({2, 1}))}}},
+      &outputs));
+
+  ASSERT_EQ(outputs.size(), 2);
+  test::ExpectTensorEqual<float>(
+      outputs[0].at(kRegressOutputs),
+      test::AsTensor<float>({2, 2.5}, TensorShape({2, 1})));
+  test::ExpectTensorEqual<float>(
+      outputs[1].at("y"), test::AsTensor<float>({3, 3.5}, TensorShape({2, 1})));
+}
+
+TEST_F(MultiSignatureRunnerTest, MissingSignature) {
+  std::unique_ptr<MultiSignatureRunner> runner;
+  const Status status = MultiSignatureRunner::Create(
+      bundle_, {"regress_x_to_y", "missing_signature"}, RunOptions(), &runner);
+  EXPECT_TRUE(errors::IsNotFound(status)) << status;
+}
+
+TEST_F(MultiSignatureRunnerTest, MissingInput) {
+  std::unique_ptr<MultiSignatureRunner> runner;
+  TF_ASSERT_OK(MultiSignatureRunner::Create(
+      bundle_, {"regress_x_to_y", "regress_x_to_y2"}, RunOptions(), &runner));
+
+  std::vector<MultiSignatureRunner::TensorMap> outputs;
+  const Status status = runner->Run(
+      {{{kRegressInputs, MakeSerializedExamples({0})}}, {}}, &outputs);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
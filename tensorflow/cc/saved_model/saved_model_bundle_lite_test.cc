@@ -39,6 +39,8 @@ constexpr char kTestDataSharded[] =
     "cc/saved_model/testdata/half_plus_two/00000123";
 constexpr char kTestDataInitOpV2[] =
     "cc/saved_model/testdata/half_plus_two_v2/00000123";
+constexpr char kTestDataV2ObjectGraph[] =
+    "cc/saved_model/testdata/VarsAndArithmeticObjectGraph";
 
 class LoaderTest : public ::testing::Test {
  protected:
@@ -263,5 +265,85 @@ TEST_F(LoaderTest, SavedModelInitOpV2Format) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, MappedVariables) {
+  SavedModelBundleLite bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModelWithMappedVariables(session_options, run_options,
+                                                 export_dir,
+                                                 {kSavedModelTagServe}, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
+TEST_F(LoaderTest, FreezeForServing) {
+  SavedModelBundleLite bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModelForServing(session_options, run_options,
+                                        export_dir, {kSavedModelTagServe},
+                                        "regress_x_to_y", &bundle));
+  // The asset is set by the init op, in a variable that is kept.
+  CheckSavedModelBundle(export_dir, bundle);
+  EXPECT_EQ(bundle.GetSignatures().size(), 1);
+
+  // The frozen variables keep their values.
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.GetSession()->Run({}, {"a:0", "b:0"}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  test::ExpectTensorEqual<float>(outputs[0], test::AsScalar<float>(0.5));
+  test::ExpectTensorEqual<float>(outputs[1], test::AsScalar<float>(2));
+
+  // The nodes of the other signatures are pruned.
+  EXPECT_FALSE(bundle.GetSession()->Run({}, {"c:0"}, {}, &outputs).ok());
+}
+
+TEST_F(LoaderTest, FreezeForServingResourceVariablesInFunctions) {
+  SavedModelBundleLite bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  // The signature calls a function, which reads the variables x = 1, y = 2
+  // and z = 3 in a nested function call computing (a + x) * (b + y) / z + 5.
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataV2ObjectGraph);
+  TF_ASSERT_OK(LoadSavedModelForServing(session_options, run_options,
+                                        export_dir, {kSavedModelTagServe},
+                                        "serving_default", &bundle));
+  const SignatureDef& signature =
+      bundle.GetSignatures().at("serving_default");
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.GetSession()->Run(
+      {{signature.inputs().at("a").name(), test::AsScalar<float>(1)},
+       {signature.inputs().at("b").name(), test::AsScalar<float>(2)}},
+      {signature.outputs().at("output_0").name()}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorNear<float>(outputs[0],
+                                test::AsScalar<float>(2.0f * 4 / 3 + 5),
+                                1e-6);
+
+  // The variables were replaced by constants.
+  TF_ASSERT_OK(bundle.GetSession()->Run({}, {"variable_x:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(outputs[0], test::AsScalar<float>(1));
+}
+
+TEST_F(LoaderTest, FreezeForServingMissingSignature) {
+  SavedModelBundleLite bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const Status status = LoadSavedModelForServing(
+      session_options, run_options, export_dir, {kSavedModelTagServe},
+      "missing_signature", &bundle);
+  EXPECT_TRUE(errors::IsNotFound(status)) << status;
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -215,6 +215,21 @@ Status Main(const MainFlags& flags) {
     return errors::InvalidArgument("Must specify --config");
   }
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, &config));
+  if (flags.batch_size > 0) {
+    for (tf2xla::Feed& feed : *config.mutable_feed()) {
+      if (feed.shape().dim_size() == 0) {
+        return errors::InvalidArgument(
+            "--batch_size requires every feed to have a batch dimension, but ",
+            feed.id().node_name(), " is a scalar");
+      }
+      feed.mutable_shape()->mutable_dim(0)->set_size(flags.batch_size);
+    }
+    for (tf2xla::Fetch& fetch : *config.mutable_fetch()) {
+      if (fetch.shape().dim_size() > 0) {
+        fetch.mutable_shape()->mutable_dim(0)->set_size(flags.batch_size);
+      }
+    }
+  }
   TF_RETURN_IF_ERROR(ValidateConfig(config));
   if (flags.dump_fetch_nodes) {
     std::set<string> nodes;
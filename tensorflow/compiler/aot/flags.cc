@@ -80,6 +80,10 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
       {"experimental_quantize", &flags->experimental_quantize,
        "If set, quantization passes will run and dump the result before HLO "
        "code generation."},
+      {"batch_size", &flags->batch_size,
+       "If positive, overrides the major dimension of every feed, and of every "
+       "fetch that has a shape in the config, with this batch size.  Used to "
+       "compile the variants of a tf_library_batched."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
@@ -43,6 +43,7 @@ struct MainFlags {
   string out_session_module;
   string mlir_components;
   bool experimental_quantize = false;
+  int64 batch_size = 0;
 
   // C++ codegen options
   bool gen_name_to_index = false;
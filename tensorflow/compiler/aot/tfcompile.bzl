@@ -419,6 +419,122 @@ def tf_library(
             tags = tags,
         )
 
+def tf_library_batched(
+        name,
+        batch_sizes,
+        cpp_class,
+        tfcompile_flags = None,
+        visibility = None,
+        testonly = None,
+        tags = [],
+        **kwargs):
+    """Runs tfcompile to compile a TensorFlow graph for several batch sizes.
+
+    Given an invocation of tf_library_batched(name="foo", cpp_class="ns::Foo",
+    batch_sizes=[1, 8, 64], ...), generates the following build targets:
+      foo_batch1, foo_batch8, foo_batch64: tf_library targets compiled with
+                     the major dimension of every feed set to the batch size,
+                     with classes ns::FooBatch1, ns::FooBatch8, ns::FooBatch64.
+      foo:           A cc_library whose header foo.h defines ns::Foo, a
+                     tensorflow::XlaBatchedCpuFunction that runs each batch of
+                     up to 64 rows with the smallest variant it fits in.
+
+    Args:
+      name: The name of the build rule.
+      batch_sizes: The batch sizes to compile the graph for.
+      cpp_class: The name of the generated dispatcher class, with the same
+        syntax as for tf_library. The variants are named after it.
+      tfcompile_flags: Extra flags to pass to tfcompile for every variant.
+      visibility: Bazel build visibility.
+      testonly: Bazel testonly attribute.
+      tags: tags to apply to subsidiary build rules.
+      **kwargs: Other arguments of tf_library, passed to every variant.
+    """
+    if not batch_sizes:
+        fail("batch_sizes must not be empty")
+    if type(tfcompile_flags) == type(""):
+        flags = [tfcompile_flags]
+    else:
+        flags = list(tfcompile_flags or [])
+
+    cpp_class_split = cpp_class.split("::")
+    namespaces = cpp_class_split[:-1]
+    class_name = cpp_class_split[-1]
+    includes = []
+    variants = []
+    for batch_size in batch_sizes:
+        variant_name = "%s_batch%d" % (name, batch_size)
+        tf_library(
+            name = variant_name,
+            cpp_class = "%sBatch%d" % (cpp_class, batch_size),
+            tfcompile_flags = flags + ["--batch_size=%d" % batch_size],
+            gen_test = False,
+            gen_benchmark = False,
+            visibility = visibility,
+            testonly = testonly,
+            tags = tags,
+            **kwargs
+        )
+        includes.append("#include \"%s/%s.h\"" % (
+            native.package_name(),
+            variant_name,
+        ))
+        variants.append("{%d, &%sBatch%d::StaticData()}" % (
+            batch_size,
+            class_name,
+            batch_size,
+        ))
+
+    header_file = name + ".h"
+    guard = ("TFCOMPILE_GENERATED_" + native.package_name() + "_" +
+             name + "_H_").replace("/", "_").upper()
+    header = "\n".join(
+        [
+            "// Generated by tf_library_batched. DO NOT EDIT!",
+            "#ifndef " + guard,
+            "#define " + guard,
+            "",
+        ] + includes + [
+            "#include \"tensorflow/compiler/tf2xla/xla_batched_cpu_function.h\"",
+            "",
+        ] + ["namespace %s {" % ns for ns in namespaces] + [
+            "",
+            "class %s final : public tensorflow::XlaBatchedCpuFunction {" %
+            class_name,
+            " public:",
+            "  %s()" % class_name,
+            "      : XlaBatchedCpuFunction({" + ", ".join(variants) + "}) {}",
+            "};",
+            "",
+        ] + ["}  // namespace %s" % ns for ns in reversed(namespaces)] + [
+            "",
+            "#endif  // " + guard,
+            "",
+        ],
+    )
+    native.genrule(
+        name = "gen_" + name,
+        outs = [header_file],
+        cmd = "cat > $@ <<'EOF'\n" + header + "EOF\n",
+        visibility = visibility,
+        testonly = testonly,
+        tags = tags,
+    )
+
+    native.cc_library(
+        name = name,
+        hdrs = [header_file],
+        visibility = visibility,
+        testonly = testonly,
+        deps = [
+            ":%s_batch%d" % (name, batch_size)
+            for batch_size in batch_sizes
+        ] + [
+            "//tensorflow/compiler/tf2xla:xla_batched_cpu_function",
+        ],
+        tags = tags,
+    )
+
 def target_llvm_triple():
     """Returns the target LLVM triple to be used for compiling the target."""
 
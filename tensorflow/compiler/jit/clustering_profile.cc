@@ -0,0 +1,124 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/clustering_profile.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace {
+// Cost of dispatching one TF op (executor bookkeeping plus kernel launch).
+// An XLA cluster pays this once rather than once per op, so clustering saves
+// up to this much per node.
+constexpr double kPerOpOverheadUsecs = 4.0;
+
+// Fraction of the remaining, non-overhead time of each node that fusion is
+// expected to save by keeping intermediate values out of memory.
+constexpr double kFusionSavingFraction = 0.2;
+
+// Fixed cost of launching a compiled cluster: the XlaCompile cache lookup,
+// XlaRun dispatch and executable launch.
+constexpr double kClusterLaunchOverheadUsecs = 30.0;
+
+// Cost of passing one tensor into or out of a compiled cluster.  Clusters
+// that cut across a hot path pay this, and any host/device copy it causes,
+// on every edge they split.
+constexpr double kPerBoundaryTensorUsecs = 2.0;
+
+bool ParseProfile(const string& contents, StepStats* step_stats) {
+  RunMetadata run_metadata;
+  if (run_metadata.ParseFromString(contents) &&
+      run_metadata.step_stats().dev_stats_size() > 0) {
+    step_stats->Swap(run_metadata.mutable_step_stats());
+    return true;
+  }
+  if (step_stats->ParseFromString(contents) &&
+      step_stats->dev_stats_size() > 0) {
+    return true;
+  }
+  run_metadata.Clear();
+  if (protobuf::TextFormat::ParseFromString(contents, &run_metadata) &&
+      run_metadata.step_stats().dev_stats_size() > 0) {
+    step_stats->Swap(run_metadata.mutable_step_stats());
+    return true;
+  }
+  step_stats->Clear();
+  return protobuf::TextFormat::ParseFromString(contents, step_stats);
+}
+}  // namespace
+
+xla::StatusOr<std::unique_ptr<ClusteringProfile>> ClusteringProfile::Load(
+    Env* env, const string& path) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, path, &contents));
+  StepStats step_stats;
+  if (!ParseProfile(contents, &step_stats)) {
+    return errors::InvalidArgument(
+        "Could not parse ", path,
+        " as a RunMetadata or StepStats proto for clustering.");
+  }
+  return FromStepStats(step_stats);
+}
+
+std::unique_ptr<ClusteringProfile> ClusteringProfile::FromStepStats(
+    const StepStats& step_stats) {
+  auto profile = absl::make_unique<ClusteringProfile>();
+  for (const DeviceStepStats& dev_stats : step_stats.dev_stats()) {
+    // A node may run several times per step, e.g. inside a loop.
+    absl::flat_hash_map<string, double> device_time_usecs;
+    for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+      // GPU tracers label kernels "<node name>:<op type>"; node names never
+      // contain ':'.
+      absl::string_view name = node_stats.node_name();
+      name = name.substr(0, name.find(':'));
+      device_time_usecs[string(name)] += std::max<int64>(
+          node_stats.all_end_rel_micros(),
+          node_stats.op_end_rel_micros() - node_stats.op_start_rel_micros());
+    }
+    for (const auto& entry : device_time_usecs) {
+      double& time_usecs = profile->node_time_usecs_[entry.first];
+      time_usecs = std::max(time_usecs, entry.second);
+    }
+  }
+  return profile;
+}
+
+absl::optional<double> ClusteringProfile::GetNodeTimeUsecs(
+    absl::string_view node_name) const {
+  auto it = node_time_usecs_.find(node_name);
+  if (it == node_time_usecs_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+double EstimateClusteringGainUsecs(absl::Span<const double> node_times_usecs,
+                                   int num_boundary_tensors) {
+  double gain_usecs = 0;
+  for (double time_usecs : node_times_usecs) {
+    double overhead_usecs = std::min(time_usecs, kPerOpOverheadUsecs);
+    gain_usecs += overhead_usecs +
+                  kFusionSavingFraction * (time_usecs - overhead_usecs);
+  }
+  return gain_usecs - kClusterLaunchOverheadUsecs -
+         kPerBoundaryTensorUsecs * num_boundary_tensors;
+}
+
+}  // namespace tensorflow
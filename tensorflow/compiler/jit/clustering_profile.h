@@ -0,0 +1,68 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Contains the execution profile used by MarkForCompilationPass to decide
+// whether an auto-clustering candidate is worth compiling.
+
+#ifndef TENSORFLOW_COMPILER_JIT_CLUSTERING_PROFILE_H_
+#define TENSORFLOW_COMPILER_JIT_CLUSTERING_PROFILE_H_
+
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+// Per-node execution times from an earlier run of a graph, typically one
+// collected with auto-clustering disabled and `RunOptions::FULL_TRACE`.
+class ClusteringProfile {
+ public:
+  // Loads a profile from `path`, which holds a RunMetadata or a StepStats
+  // proto in binary or text format.
+  static xla::StatusOr<std::unique_ptr<ClusteringProfile>> Load(
+      Env* env, const string& path);
+
+  // Builds a profile from `step_stats`.  Times recorded for the same node on
+  // several devices (e.g. an executor and the GPU stream it launched on) are
+  // not added up; the largest per-device total is used instead.
+  static std::unique_ptr<ClusteringProfile> FromStepStats(
+      const StepStats& step_stats);
+
+  // Returns the time, in microseconds, spent per step executing the node
+  // named `node_name`, or nullopt if the node was not profiled.
+  absl::optional<double> GetNodeTimeUsecs(absl::string_view node_name) const;
+
+  int num_nodes() const { return node_time_usecs_.size(); }
+
+ private:
+  absl::flat_hash_map<string, double> node_time_usecs_;
+};
+
+// Returns the expected time, in microseconds, saved per step by running the
+// nodes whose profiled times are `node_times_usecs` as one XLA cluster, with
+// `num_boundary_tensors` tensors flowing into or out of the cluster.  A
+// negative value means the cluster is expected to make the step slower.
+double EstimateClusteringGainUsecs(absl::Span<const double> node_times_usecs,
+                                   int num_boundary_tensors);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_CLUSTERING_PROFILE_H_
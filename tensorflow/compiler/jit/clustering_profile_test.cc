@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/clustering_profile.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace {
+
+void AddNodeStats(DeviceStepStats* dev_stats, const string& node_name,
+                  int64 all_end_rel_micros) {
+  NodeExecStats* node_stats = dev_stats->add_node_stats();
+  node_stats->set_node_name(node_name);
+  node_stats->set_all_end_rel_micros(all_end_rel_micros);
+}
+
+TEST(ClusteringProfileTest, FromStepStats) {
+  StepStats step_stats;
+  DeviceStepStats* executor = step_stats.add_dev_stats();
+  executor->set_device("/job:localhost/replica:0/task:0/device:GPU:0");
+  AddNodeStats(executor, "a", 3);
+  AddNodeStats(executor, "b", 2);
+  AddNodeStats(executor, "b", 2);
+  DeviceStepStats* stream = step_stats.add_dev_stats();
+  stream->set_device("/device:GPU:0/stream:all");
+  AddNodeStats(stream, "a:MatMul", 40);
+
+  std::unique_ptr<ClusteringProfile> profile =
+      ClusteringProfile::FromStepStats(step_stats);
+  EXPECT_EQ(profile->num_nodes(), 2);
+  EXPECT_EQ(profile->GetNodeTimeUsecs("a"), 40.0);
+  EXPECT_EQ(profile->GetNodeTimeUsecs("b"), 4.0);
+  EXPECT_FALSE(profile->GetNodeTimeUsecs("c").has_value());
+}
+
+TEST(ClusteringProfileTest, LoadRunMetadata) {
+  RunMetadata run_metadata;
+  AddNodeStats(run_metadata.mutable_step_stats()->add_dev_stats(), "a", 7);
+  string path =
+      io::JoinPath(testing::TmpDir(), "clustering_profile_run_metadata.pb");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), path, run_metadata));
+
+  auto profile_or = ClusteringProfile::Load(Env::Default(), path);
+  TF_ASSERT_OK(profile_or.status());
+  EXPECT_EQ(profile_or.ValueOrDie()->GetNodeTimeUsecs("a"), 7.0);
+}
+
+TEST(ClusteringProfileTest, LoadTextStepStats) {
+  string path =
+      io::JoinPath(testing::TmpDir(), "clustering_profile_step_stats.pbtxt");
+  TF_ASSERT_OK(WriteStringToFile(
+      Env::Default(), path,
+      "dev_stats { node_stats { node_name: 'a' all_end_rel_micros: 5 } }"));
+
+  auto profile_or = ClusteringProfile::Load(Env::Default(), path);
+  TF_ASSERT_OK(profile_or.status());
+  EXPECT_EQ(profile_or.ValueOrDie()->GetNodeTimeUsecs("a"), 5.0);
+}
+
+TEST(ClusteringProfileTest, LoadInvalid) {
+  string path = io::JoinPath(testing::TmpDir(), "clustering_profile_bad.txt");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "not a profile {"));
+  EXPECT_FALSE(ClusteringProfile::Load(Env::Default(), path).ok());
+}
+
+TEST(ClusteringProfileTest, EstimateClusteringGain) {
+  // A few cheap ops do not pay for the cluster launch.
+  EXPECT_LT(EstimateClusteringGainUsecs({1, 1, 2}, 2), 0);
+  // Many overhead-bound ops do.
+  EXPECT_GT(EstimateClusteringGainUsecs(std::vector<double>(20, 5), 2), 0);
+  // A cluster cut across many tensors pays for each of them.
+  EXPECT_LT(EstimateClusteringGainUsecs({100, 100}, 50), 0);
+  EXPECT_GT(EstimateClusteringGainUsecs({100, 100}, 2), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -120,6 +120,12 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
            &mark_for_compilation_flags->tf_xla_clustering_fuel,
            "Places an artificial limit on the number of ops marked as "
            "eligible for clustering."),
+      Flag("tf_xla_clustering_profile",
+           &mark_for_compilation_flags->tf_xla_clustering_profile,
+           "Path to a RunMetadata or StepStats proto (binary or text) from a "
+           "run of the graph without auto-clustering.  If set, clusters whose "
+           "expected gain according to these per-op execution times is "
+           "negative are not compiled."),
       Flag("tf_xla_disable_deadness_safety_checks_for_debugging",
            &mark_for_compilation_flags
                 ->tf_xla_disable_deadness_safety_checks_for_debugging,
@@ -163,6 +169,11 @@ void AllocateAndParseFlags() {
 
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
+  ops_flags->tf_xla_enable_shape_bucketing = false;
+  ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_async_compilation_threads = 2;
+  ops_flags->tf_xla_async_compilation_max_pending = 8;
+  ops_flags->tf_xla_share_compilation_across_devices = true;
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -175,6 +186,19 @@ void AllocateAndParseFlags() {
     return true;
   };
 
+  auto setter_for_shape_buckets = [](string sequence) {
+    ops_flags->tf_xla_shape_buckets.clear();
+    for (absl::string_view bucket :
+         absl::StrSplit(sequence, ',', absl::SkipEmpty())) {
+      int64 size;
+      if (!absl::SimpleAtoi(bucket, &size) || size <= 0) {
+        return false;
+      }
+      ops_flags->tf_xla_shape_buckets.push_back(size);
+    }
+    return true;
+  };
+
   flag_list = new std::vector<Flag>(
       {Flag("tf_xla_enable_lazy_compilation",
             &build_ops_flags->tf_xla_enable_lazy_compilation, ""),
@@ -207,6 +231,28 @@ void AllocateAndParseFlags() {
 
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
+       Flag("tf_xla_enable_shape_bucketing",
+            &ops_flags->tf_xla_enable_shape_bucketing,
+            "If true then pad the parameters of clusters compiled by XlaLaunch "
+            "up to shape buckets to avoid recompiling them for every shape."),
+       Flag("tf_xla_shape_buckets", setter_for_shape_buckets, "",
+            "Comma-separated sizes that dynamic dimensions are padded up to. "
+            "If empty, the buckets are learned from the observed shapes."),
+       Flag("tf_xla_async_compilation",
+            &ops_flags->tf_xla_async_compilation,
+            "If true then compile lazily compiled clusters in the background "
+            "and run them in the TF executor until compilation finishes."),
+       Flag("tf_xla_async_compilation_threads",
+            &ops_flags->tf_xla_async_compilation_threads,
+            "Number of threads used for background XLA compilation."),
+       Flag("tf_xla_async_compilation_max_pending",
+            &ops_flags->tf_xla_async_compilation_max_pending,
+            "Maximum number of background XLA compilations queued or running "
+            "at once."),
+       Flag("tf_xla_share_compilation_across_devices",
+            &ops_flags->tf_xla_share_compilation_across_devices,
+            "If true then reuse a cluster compiled for one device on all "
+            "equivalent devices, e.g. GPUs of the same model."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
@@ -68,6 +68,12 @@ struct MarkForCompilationPassFlags {
   // eligible for clustering.
   int64 tf_xla_clustering_fuel;
 
+  // If non-empty, a RunMetadata or StepStats proto collected from an earlier
+  // run of the graph.  Auto-clustering then uses the per-op execution times
+  // it records to reject clusters that are not expected to pay for their
+  // launch overhead.
+  string tf_xla_clustering_profile;
+
   // If tf_xla_disable_deadness_safety_checks_for_debugging is set to true then
   // we do not do deadness related safety checks.  This is unsound in general,
   // but can be used as a debugging aid.
@@ -97,6 +103,34 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If true, the dimensions of the parameters of XLA clusters compiled by
+  // XlaLaunch that vary between executions are padded up to shape buckets, so
+  // that a cluster is compiled once per bucket rather than once per shape.
+  bool tf_xla_enable_shape_bucketing;
+
+  // The sizes dynamic dimensions are padded up to.  If empty, the buckets are
+  // learned from the observed sizes of each dimension.
+  std::vector<int64> tf_xla_shape_buckets;
+
+  // If true, clusters compiled lazily by _XlaCompile are compiled on a
+  // background thread pool, and run in the TF executor until the compiled
+  // executable is ready.  Defaults to false.
+  bool tf_xla_async_compilation;
+
+  // The number of threads running background compilations.
+  int32 tf_xla_async_compilation_threads;
+
+  // The maximum number of background compilations queued or running at once
+  // across the process.  Cache misses beyond this run in the TF executor
+  // without starting a compilation.  This bounds the memory held by pending
+  // compilations.
+  int32 tf_xla_async_compilation_max_pending;
+
+  // If true, a cluster compiled for one device is reused by every device that
+  // XLA considers equivalent (e.g. the other GPUs of the same model), instead
+  // of being compiled again for each of them.  Defaults to true.
+  bool tf_xla_share_compilation_across_devices;
 };
 
 // Flags for the build_xla_ops pass.
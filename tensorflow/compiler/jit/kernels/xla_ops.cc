@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
 #include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/jit/xla_platform_info.h"
@@ -169,7 +170,8 @@ static Status CompileToLocalExecutable(
     absl::Span<const int> constants, bool lazy, bool may_alias_resource_update,
     xla::LocalClient** client,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable,
+    std::vector<int64>* dynamic_dimension_sizes = nullptr) {
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
@@ -209,10 +211,35 @@ static Status CompileToLocalExecutable(
       XlaComputationLaunchContext::BuildXlaCompilerArguments(constants, inputs,
                                                              variable_infos);
   TF_RETURN_IF_ERROR(args.status());
+  const XlaCompilationCache::CompileMode compile_mode =
+      lazy ? XlaCompilationCache::CompileMode::kLazy
+           : XlaCompilationCache::CompileMode::kStrict;
+
+  // Pad the parameters up to shape buckets, so that the cluster is compiled
+  // once per bucket rather than once per shape. If the padded cluster fails
+  // to compile, e.g. because an op needs a static shape, stop bucketing it.
+  if (dynamic_dimension_sizes && !platform_info.is_on_xla_device() &&
+      GetXlaOpsCommonFlags().tf_xla_enable_shape_bucketing) {
+    ShapeBucketer::BucketedArguments bucketed =
+        cache->shape_bucketer()->Bucket(function.name(), *args);
+    if (!bucketed.padded_dims.empty()) {
+      Status s = cache->Compile(options, function, bucketed.args,
+                                compile_options, compile_mode,
+                                compilation_result, executable);
+      if (s.ok()) {
+        for (const ShapeBucketer::PaddedDimension& padded_dim :
+             bucketed.padded_dims) {
+          dynamic_dimension_sizes->push_back(padded_dim.size);
+        }
+        return Status::OK();
+      }
+      VLOG(1) << "Disabling shape bucketing for " << function.name()
+              << ", which failed to compile with padded shapes: " << s;
+      cache->shape_bucketer()->Disable(function.name());
+    }
+  }
   return cache->Compile(options, function, *args, compile_options,
-                        lazy ? XlaCompilationCache::CompileMode::kLazy
-                             : XlaCompilationCache::CompileMode::kStrict,
-                        compilation_result, executable);
+                        compile_mode, compilation_result, executable);
 }
 
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
@@ -223,6 +250,7 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::LocalClient* client;
   const XlaCompiler::CompilationResult* compilation_result;
   xla::LocalExecutable* executable;
+  std::vector<int64> dynamic_dimension_sizes;
 
   std::vector<VariableInfo> variable_infos;
   {
@@ -234,7 +262,7 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
         ctx, function_, /*has_ref_vars=*/has_ref_vars_, platform_info_, inputs,
         variable_infos, constants_, /*lazy=*/false,
         /*may_alias_resource_update=*/true, &client, &compilation_result,
-        &executable);
+        &executable, &dynamic_dimension_sizes);
     OP_REQUIRES_OK(ctx, s);
   }
 
@@ -264,7 +292,8 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs =
       launch_context.PopulateInputs(ctx, compilation_result, resource_var_ptrs,
                                     /*missing_ctx_input_prefix=*/0,
-                                    input_output_alias);
+                                    input_output_alias,
+                                    dynamic_dimension_sizes);
   OP_REQUIRES_OK(ctx, execution_inputs.status());
 
   // Execute the computation.
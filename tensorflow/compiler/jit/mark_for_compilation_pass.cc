@@ -25,6 +25,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/compiler/jit/clustering_profile.h"
 #include "tensorflow/compiler/jit/compilability_check_util.h"
 #include "tensorflow/compiler/jit/deadness_analysis.h"
 #include "tensorflow/compiler/jit/defs.h"
@@ -52,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/graph/control_flow.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
 
@@ -106,6 +108,10 @@ class MarkForCompilationPassImpl {
     std::atomic<int64>* fuel;
 
     bool dump_graphs;
+
+    // If not null, per-node execution times used to reject clusters that are
+    // not expected to be faster than running their nodes individually.
+    const ClusteringProfile* clustering_profile;
   };
 
   MarkForCompilationPassImpl(DebugOptions debug_options, Graph* graph,
@@ -313,6 +319,13 @@ class MarkForCompilationPassImpl {
   void DumpPostClusteringGraphs();
   void VLogClusteringSummary();
 
+  // Estimates, using `debug_options_.clustering_profile`, whether compiling
+  // each cluster with a compilation candidate is expected to be faster than
+  // running its nodes individually.  The result is keyed by the cluster's
+  // cycles graph node id.  Clusters without profiled nodes are assumed to
+  // be profitable.
+  absl::flat_hash_map<int, bool> FindProfitableClusters();
+
   Cluster* MakeNewCluster(int cycles_graph_node_id, int effective_cluster_size,
                           bool has_functional_control_flow,
                           const DeviceSet& device_set,
@@ -851,6 +864,11 @@ Status MarkForCompilationPassImpl::CreateClusters() {
   // Names for each cluster.
   std::unordered_map<int, string> cluster_names;
 
+  absl::flat_hash_map<int, bool> profitable_clusters;
+  if (debug_options_.clustering_profile) {
+    profitable_clusters = FindProfitableClusters();
+  }
+
   if (debug_options_.dump_graphs) {
     DumpGraphToFile("before_mark_for_compilation", *graph_, flib_def_);
   }
@@ -860,7 +878,8 @@ Status MarkForCompilationPassImpl::CreateClusters() {
   // * are explicitly marked for compilation (_XlaCompile=true), or
   // * have more than debug_options_.xla_min_cluster_size elements (applicable
   //   only if compilation is enabled, otherwise there will be no such
-  //   candidates).
+  //   candidates) and, given a clustering profile, have a non-negative
+  //   expected gain.
   for (Node* n : compilation_candidates_) {
     Cluster* cluster = GetClusterForNode(n);
     TF_ASSIGN_OR_RETURN(bool should_compile_cluster,
@@ -874,7 +893,11 @@ Status MarkForCompilationPassImpl::CreateClusters() {
     // to (recursively) verify this fact, but that's probably not worth the
     // trouble.
 
-    if (cluster->effective_cluster_size() >= debug_options_.min_cluster_size ||
+    bool is_profitable =
+        !debug_options_.clustering_profile ||
+        profitable_clusters[cluster->cycles_graph_node_id()];
+    if ((cluster->effective_cluster_size() >= debug_options_.min_cluster_size &&
+         is_profitable) ||
         cluster->has_functional_control_flow() ||
         cluster->is_xla_compile_attr_true()) {
       string& name = cluster_names[cluster->cycles_graph_node_id()];
@@ -892,6 +915,63 @@ Status MarkForCompilationPassImpl::CreateClusters() {
   return Status::OK();
 }
 
+absl::flat_hash_map<int, bool>
+MarkForCompilationPassImpl::FindProfitableClusters() {
+  absl::flat_hash_map<int, std::vector<double>> node_times_usecs;
+  absl::flat_hash_map<int, int> num_boundary_tensors;
+  auto cluster_id = [&](Node* n) {
+    Cluster* cluster = GetClusterForNode(n);
+    return cluster ? cluster->cycles_graph_node_id() : -1;
+  };
+
+  for (Node* n : compilation_candidates_) {
+    int id = cluster_id(n);
+    std::vector<double>& times = node_times_usecs[id];
+    if (absl::optional<double> time_usecs =
+            debug_options_.clustering_profile->GetNodeTimeUsecs(n->name())) {
+      times.push_back(*time_usecs);
+    }
+
+    // Every data edge that crosses the cluster boundary becomes an argument
+    // or a result of the compiled cluster.
+    for (const Edge* e : n->in_edges()) {
+      if (!e->IsControlEdge() && cluster_id(e->src()) != id) {
+        ++num_boundary_tensors[id];
+      }
+    }
+    for (const Edge* e : n->out_edges()) {
+      if (!e->IsControlEdge() && cluster_id(e->dst()) != id) {
+        ++num_boundary_tensors[id];
+      }
+    }
+  }
+
+  absl::flat_hash_map<int, bool> result;
+  int num_rejected = 0;
+  for (const auto& entry : node_times_usecs) {
+    int id = entry.first;
+    if (entry.second.empty()) {
+      VLOG(2) << "No profile for cluster " << id << "; keeping it.";
+      result[id] = true;
+      continue;
+    }
+    double gain_usecs =
+        EstimateClusteringGainUsecs(entry.second, num_boundary_tensors[id]);
+    result[id] = gain_usecs >= 0;
+    if (gain_usecs < 0) {
+      ++num_rejected;
+    }
+    VLOG(1) << (gain_usecs >= 0 ? "Accepting" : "Rejecting") << " cluster "
+            << GetClusterForCyclesGraphNode(id)->DebugString(*graph_)
+            << " with " << entry.second.size() << " profiled nodes and "
+            << num_boundary_tensors[id]
+            << " boundary tensors; expected gain: " << gain_usecs << "us";
+  }
+  VLOG(1) << "Profile-guided clustering rejected " << num_rejected << " of "
+          << result.size() << " clusters.";
+  return result;
+}
+
 Status MarkForCompilationPassImpl::DumpDebugInfo() {
   TF_RET_CHECK(initialized_ && edges_contracted_ && clusters_created_);
 
@@ -1496,6 +1576,15 @@ void MarkForCompilationPassImpl::VLogClusteringSummary() {
     }
   }
 
+  if (!auto_clustering_info.cluster_boundary_op_histogram().empty()) {
+    VLOG(2) << " Unclustered nodes between clusters:";
+    for (const XlaAutoClusteringSummary::OpAndCount& op_count :
+         auto_clustering_info.cluster_boundary_op_histogram()) {
+      VLOG(2) << "  " << op_count.op() << ": " << op_count.count()
+              << " instances";
+    }
+  }
+
   struct EdgeInfo {
     absl::string_view node_name;
     absl::optional<absl::string_view> cluster_name;
@@ -1706,6 +1795,26 @@ std::atomic<int64>* GetPointerToFuel(int64 initial_value) {
 
   return fuel;
 }
+
+// Returns the profile loaded from `path`, or nullptr if `path` is empty.
+// Profiles are cached for the lifetime of the process.
+xla::StatusOr<const ClusteringProfile*> GetClusteringProfile(
+    const string& path) {
+  if (path.empty()) {
+    return nullptr;
+  }
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* profiles =
+      new absl::flat_hash_map<string, std::unique_ptr<ClusteringProfile>>;
+  mutex_lock l(mu);
+  std::unique_ptr<ClusteringProfile>& profile = (*profiles)[path];
+  if (!profile) {
+    TF_ASSIGN_OR_RETURN(profile, ClusteringProfile::Load(Env::Default(), path));
+    VLOG(1) << "Loaded clustering profile for " << profile->num_nodes()
+            << " nodes from " << path;
+  }
+  return profile.get();
+}
 }  // anonymous namespace
 
 bool IsCompilable(FunctionLibraryRuntime* flr, const NodeDef& ndef,
@@ -1756,6 +1865,8 @@ Status MarkForCompilationPass::Run(
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
+  TF_ASSIGN_OR_RETURN(debug_options.clustering_profile,
+                      GetClusteringProfile(flags->tf_xla_clustering_profile));
 
   return MarkForCompilation(options, debug_options);
 }
@@ -1774,6 +1885,8 @@ Status MarkForCompilationPass::RunForTest(
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
+  TF_ASSIGN_OR_RETURN(debug_options.clustering_profile,
+                      GetClusteringProfile(flags->tf_xla_clustering_profile));
 
   return MarkForCompilation(options, debug_options);
 }
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/mark_for_compilation_pass_test_helper.h"
 #include "tensorflow/compiler/jit/node_matchers.h"
 #include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
@@ -34,9 +35,12 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_def_builder_util.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/test.h"
 
 using ::tensorflow::testing::FindNodeByName;
@@ -115,6 +119,48 @@ TEST(XlaCompilationTest, Chains) {
   EXPECT_TRUE(clusters.find("D") == clusters.cend());
 }
 
+TEST(XlaCompilationTest, ProfileGuidedClustering) {
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    Node* a =
+        ops::SourceOp("UncompilableNullary", builder.opts().WithName("A"));
+    Node* b = ops::UnaryOp("Relu", a, builder.opts().WithName("B"));
+    Node* c = ops::UnaryOp("Relu", b, builder.opts().WithName("C"));
+    Node* d =
+        ops::UnaryOp("UncompilableUnary", c, builder.opts().WithName("D"));
+    Node* e = ops::UnaryOp("Relu", d, builder.opts().WithName("E"));
+    ops::UnaryOp("Relu", e, builder.opts().WithName("F"));
+    TF_EXPECT_OK(GraphDefBuilderToGraph(builder, graph.get()));
+  }
+
+  // B and C are too cheap to pay for a cluster launch, E and F are not.
+  StepStats step_stats;
+  DeviceStepStats* dev_stats = step_stats.add_dev_stats();
+  for (const auto& name_and_time :
+       std::vector<std::pair<string, int64>>{
+           {"B", 1}, {"C", 1}, {"E", 500}, {"F", 500}}) {
+    NodeExecStats* node_stats = dev_stats->add_node_stats();
+    node_stats->set_node_name(name_and_time.first);
+    node_stats->set_all_end_rel_micros(name_and_time.second);
+  }
+  string profile_path =
+      io::JoinPath(testing::TmpDir(), "profile_guided_clustering.pb");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), profile_path, step_stats));
+
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  flags->tf_xla_clustering_profile = profile_path;
+  auto reset_profile = gtl::MakeCleanup(
+      [flags]() { flags->tf_xla_clustering_profile.clear(); });
+
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+  auto clusters = GetClusters(*graph);
+  EXPECT_EQ(2, clusters.size());
+  EXPECT_EQ(clusters["E"], clusters["F"]);
+  EXPECT_TRUE(clusters.find("B") == clusters.cend());
+  EXPECT_TRUE(clusters.find("C") == clusters.cend());
+}
+
 TEST(XlaCompilationTest, UncompilableCycles) {
   std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
   {
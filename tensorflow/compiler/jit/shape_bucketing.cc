@@ -0,0 +1,173 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <limits>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Padding a parameter copies it in one contiguous run per index of the
+// dimensions major to its last padded dimension. Parameters that would take
+// more runs than this are not padded.
+constexpr int64 kMaxPaddingCopies = 4096;
+
+int64 RoundUpToPowerOfTwo(int64 size) {
+  int64 bucket = 1;
+  while (bucket < size) {
+    bucket *= 2;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+constexpr int64 ShapeBucketer::kMinObservationsToLearn;
+constexpr int ShapeBucketer::kNumLearnedBoundaries;
+constexpr int ShapeBucketer::kMaxHistogramSizes;
+
+ShapeBucketer::ShapeBucketer(std::vector<int64> boundaries)
+    : boundaries_([&] {
+        absl::c_sort(boundaries);
+        return boundaries;
+      }()) {}
+
+int64 ShapeBucketer::BucketFor(const DimensionStats& stats, int64 size) const {
+  const std::vector<int64>& boundaries =
+      boundaries_.empty() ? stats.learned_boundaries : boundaries_;
+  auto it = absl::c_lower_bound(boundaries, size);
+  return it != boundaries.end() ? *it : RoundUpToPowerOfTwo(size);
+}
+
+ShapeBucketer::BucketedArguments ShapeBucketer::Bucket(
+    const string& cluster, absl::Span<const XlaCompiler::Argument> args) {
+  BucketedArguments result;
+  result.args.assign(args.begin(), args.end());
+
+  mutex_lock lock(mu_);
+  ClusterStats& cluster_stats = clusters_[cluster];
+  if (cluster_stats.disabled) {
+    return result;
+  }
+  for (int arg_num = 0; arg_num < args.size(); ++arg_num) {
+    const XlaCompiler::Argument& arg = args[arg_num];
+    if (arg.kind != XlaCompiler::Argument::kParameter ||
+        !absl::holds_alternative<TensorShape>(arg.shape) ||
+        !arg.dynamic_dim_to_arg_num_map.empty()) {
+      continue;
+    }
+    const TensorShape& shape = absl::get<TensorShape>(arg.shape);
+    TensorShape padded_shape = shape;
+    std::vector<int> dynamic_dims;
+    for (int dim = 0; dim < shape.dims(); ++dim) {
+      const int64 size = shape.dim_size(dim);
+      DimensionStats& stats = cluster_stats.dims[{arg_num, dim}];
+      auto it = stats.histogram.find(size);
+      if (it != stats.histogram.end()) {
+        ++it->second;
+        ++stats.num_observations;
+      } else if (stats.histogram.size() < kMaxHistogramSizes) {
+        stats.histogram.emplace(size, 1);
+        ++stats.num_observations;
+      }
+      if (boundaries_.empty() && stats.learned_boundaries.empty() &&
+          stats.num_observations >= kMinObservationsToLearn &&
+          stats.histogram.size() > 1) {
+        // Place a boundary at the largest size of each quantile, so that each
+        // bucket holds about the same share of the observed shapes.
+        int64 seen = 0;
+        int quantile = 1;
+        for (const auto& size_and_count : stats.histogram) {
+          seen += size_and_count.second;
+          if (seen * kNumLearnedBoundaries >=
+              quantile * stats.num_observations) {
+            stats.learned_boundaries.push_back(size_and_count.first);
+            while (seen * kNumLearnedBoundaries >=
+                   quantile * stats.num_observations) {
+              ++quantile;
+            }
+          }
+        }
+        VLOG(1) << "Learned shape buckets for dimension " << dim
+                << " of argument " << arg_num << " of " << cluster << ": "
+                << absl::StrJoin(stats.learned_boundaries, ",");
+      }
+      // Dimensions that have only been seen with one size are left static.
+      if (stats.histogram.size() > 1) {
+        padded_shape.set_dim(dim, BucketFor(stats, size));
+        dynamic_dims.push_back(dim);
+      }
+    }
+    if (dynamic_dims.empty()) {
+      continue;
+    }
+    int64 num_copies = 1;
+    for (int dim = 0; dim < dynamic_dims.back(); ++dim) {
+      num_copies *= shape.dim_size(dim);
+    }
+    if (num_copies > kMaxPaddingCopies ||
+        padded_shape.dim_size(dynamic_dims.back()) >
+            std::numeric_limits<int32>::max()) {
+      continue;
+    }
+    XlaCompiler::Argument& padded_arg = result.args[arg_num];
+    padded_arg.shape = padded_shape;
+    for (int dim : dynamic_dims) {
+      padded_arg.dynamic_dim_to_arg_num_map[dim] =
+          args.size() + result.padded_dims.size();
+      result.padded_dims.push_back({arg_num, dim, shape.dim_size(dim)});
+    }
+  }
+
+  for (const PaddedDimension& padded_dim : result.padded_dims) {
+    XlaCompiler::Argument size_arg;
+    size_arg.kind = XlaCompiler::Argument::kParameter;
+    size_arg.type = DT_INT32;
+    size_arg.shape = TensorShape({});
+    size_arg.name = absl::StrCat("arg", padded_dim.arg_num, "_dim",
+                                 padded_dim.dim, "_size");
+    size_arg.is_pad_arg = true;
+    result.args.push_back(std::move(size_arg));
+  }
+  return result;
+}
+
+void ShapeBucketer::Disable(const string& cluster) {
+  mutex_lock lock(mu_);
+  clusters_[cluster].disabled = true;
+}
+
+std::map<int64, int64> ShapeBucketer::Histogram(const string& cluster,
+                                                int arg_num, int dim) const {
+  mutex_lock lock(mu_);
+  auto cluster_it = clusters_.find(cluster);
+  if (cluster_it == clusters_.end()) {
+    return {};
+  }
+  auto dim_it = cluster_it->second.dims.find({arg_num, dim});
+  if (dim_it == cluster_it->second.dims.end()) {
+    return {};
+  }
+  return dim_it->second.histogram;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,115 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Pads the dimensions of the parameters of XLA clusters that are observed to
+// vary up to bucket boundaries, so that a cluster is compiled once per bucket
+// rather than once per shape. The actual sizes of the padded dimensions are
+// passed to the computation as extra int32 parameters, which XlaCompiler
+// attaches to the padded parameters with SetDimensionSize. XLA's dynamic
+// padder then keeps the padding from affecting the results.
+//
+// A dimension is bucketed from the second distinct size observed for it on.
+// The boundaries are `boundaries` if it is not empty. Otherwise they are
+// learned from the histogram of the sizes observed for each dimension: powers
+// of two until kMinObservationsToLearn sizes have been recorded, then the
+// sizes at evenly spaced quantiles of the histogram. Sizes above the largest
+// boundary are rounded up to a power of two. The histogram of a dimension holds
+// at most kMaxHistogramSizes distinct sizes; further sizes are still bucketed
+// but not recorded.
+class ShapeBucketer {
+ public:
+  // The number of observations of a dimension after which its boundaries are
+  // learned, and the number of boundaries learned.
+  static constexpr int64 kMinObservationsToLearn = 100;
+  static constexpr int kNumLearnedBoundaries = 8;
+  // The number of distinct sizes recorded per dimension.
+  static constexpr int kMaxHistogramSizes = 256;
+
+  explicit ShapeBucketer(std::vector<int64> boundaries = {});
+
+  // A dimension of a parameter padded up to its bucket.
+  struct PaddedDimension {
+    int arg_num;
+    int dim;
+    // The actual size of the dimension.
+    int64 size;
+  };
+
+  struct BucketedArguments {
+    // The arguments to compile the cluster with: the original arguments with
+    // their bucketed dimensions padded, followed by an int32 scalar parameter
+    // for each entry of `padded_dims`, in order.
+    std::vector<XlaCompiler::Argument> args;
+    std::vector<PaddedDimension> padded_dims;
+  };
+
+  // Records the shapes of the parameters `args` of `cluster`, and returns the
+  // arguments to compile and run it with. `padded_dims` is empty if no
+  // dimension is bucketed.
+  BucketedArguments Bucket(const string& cluster,
+                           absl::Span<const XlaCompiler::Argument> args);
+
+  // Stops bucketing `cluster`, e.g. because it needs static shapes to compile.
+  void Disable(const string& cluster);
+
+  // Returns how often each size was observed for dimension `dim` of argument
+  // `arg_num` of `cluster`.
+  std::map<int64, int64> Histogram(const string& cluster, int arg_num,
+                                   int dim) const;
+
+ private:
+  struct DimensionStats {
+    // The number of times each recorded size was observed.
+    std::map<int64, int64> histogram;
+    // The sum of the counts of `histogram`.
+    int64 num_observations = 0;
+    // The boundaries learned from the histogram, if any.
+    std::vector<int64> learned_boundaries;
+  };
+
+  struct ClusterStats {
+    bool disabled = false;
+    // Keyed by argument number and dimension.
+    std::map<std::pair<int, int>, DimensionStats> dims;
+  };
+
+  // Returns the bucket `size` is padded up to for a dimension with `stats`.
+  int64 BucketFor(const DimensionStats& stats, int64 size) const;
+
+  const std::vector<int64> boundaries_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<string, ClusterStats> clusters_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
@@ -0,0 +1,129 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<XlaCompiler::Argument> MatrixArgs(int64 rows, int64 cols) {
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({rows, cols});
+  return args;
+}
+
+TensorShape ShapeOf(const XlaCompiler::Argument& arg) {
+  return absl::get<TensorShape>(arg.shape);
+}
+
+TEST(ShapeBucketingTest, FirstShapeIsNotPadded) {
+  ShapeBucketer bucketer;
+  ShapeBucketer::BucketedArguments bucketed =
+      bucketer.Bucket("cluster", MatrixArgs(5, 7));
+  EXPECT_TRUE(bucketed.padded_dims.empty());
+  ASSERT_EQ(bucketed.args.size(), 1);
+  EXPECT_EQ(ShapeOf(bucketed.args[0]), TensorShape({5, 7}));
+}
+
+TEST(ShapeBucketingTest, VaryingDimensionIsPaddedToPowerOfTwo) {
+  ShapeBucketer bucketer;
+  bucketer.Bucket("cluster", MatrixArgs(5, 7));
+  ShapeBucketer::BucketedArguments bucketed =
+      bucketer.Bucket("cluster", MatrixArgs(6, 7));
+
+  ASSERT_EQ(bucketed.padded_dims.size(), 1);
+  EXPECT_EQ(bucketed.padded_dims[0].arg_num, 0);
+  EXPECT_EQ(bucketed.padded_dims[0].dim, 0);
+  EXPECT_EQ(bucketed.padded_dims[0].size, 6);
+
+  ASSERT_EQ(bucketed.args.size(), 2);
+  EXPECT_EQ(ShapeOf(bucketed.args[0]), TensorShape({8, 7}));
+  EXPECT_EQ(bucketed.args[0].dynamic_dim_to_arg_num_map,
+            (std::map<int32, int32>{{0, 1}}));
+  EXPECT_TRUE(bucketed.args[1].is_pad_arg);
+  EXPECT_EQ(bucketed.args[1].type, DT_INT32);
+  EXPECT_EQ(ShapeOf(bucketed.args[1]), TensorShape({}));
+
+  // Shapes in the same bucket compile to the same arguments.
+  ShapeBucketer::BucketedArguments same_bucket =
+      bucketer.Bucket("cluster", MatrixArgs(7, 7));
+  EXPECT_EQ(same_bucket.args, bucketed.args);
+  EXPECT_EQ(same_bucket.padded_dims[0].size, 7);
+}
+
+TEST(ShapeBucketingTest, UsesConfiguredBoundaries) {
+  ShapeBucketer bucketer({100, 10});
+  bucketer.Bucket("cluster", MatrixArgs(5, 7));
+  EXPECT_EQ(ShapeOf(bucketer.Bucket("cluster", MatrixArgs(6, 7)).args[0]),
+            TensorShape({10, 7}));
+  EXPECT_EQ(ShapeOf(bucketer.Bucket("cluster", MatrixArgs(11, 7)).args[0]),
+            TensorShape({100, 7}));
+  EXPECT_EQ(ShapeOf(bucketer.Bucket("cluster", MatrixArgs(101, 7)).args[0]),
+            TensorShape({128, 7}));
+}
+
+TEST(ShapeBucketingTest, LearnsBoundariesFromHistogram) {
+  ShapeBucketer bucketer;
+  for (int64 i = 0; i < ShapeBucketer::kMinObservationsToLearn; ++i) {
+    bucketer.Bucket("cluster", MatrixArgs(i % 2 == 0 ? 3 : 5, 7));
+  }
+  EXPECT_EQ(bucketer.Histogram("cluster", 0, 0),
+            (std::map<int64, int64>{{3, 50}, {5, 50}}));
+  EXPECT_EQ(bucketer.Histogram("cluster", 0, 1),
+            (std::map<int64, int64>{{7, 100}}));
+
+  // The learned boundaries are the observed sizes, rather than powers of two.
+  EXPECT_EQ(ShapeOf(bucketer.Bucket("cluster", MatrixArgs(3, 7)).args[0]),
+            TensorShape({3, 7}));
+  EXPECT_EQ(ShapeOf(bucketer.Bucket("cluster", MatrixArgs(4, 7)).args[0]),
+            TensorShape({5, 7}));
+}
+
+TEST(ShapeBucketingTest, HistogramIsBounded) {
+  ShapeBucketer bucketer({1 << 20});
+  for (int64 rows = 1; rows <= 2 * ShapeBucketer::kMaxHistogramSizes; ++rows) {
+    bucketer.Bucket("cluster", MatrixArgs(rows, 7));
+  }
+  std::map<int64, int64> histogram = bucketer.Histogram("cluster", 0, 0);
+  EXPECT_EQ(histogram.size(), ShapeBucketer::kMaxHistogramSizes);
+  EXPECT_EQ(histogram.rbegin()->first, ShapeBucketer::kMaxHistogramSizes);
+
+  // Sizes that are not recorded are still bucketed.
+  ShapeBucketer::BucketedArguments bucketed =
+      bucketer.Bucket("cluster", MatrixArgs(1000, 7));
+  EXPECT_EQ(ShapeOf(bucketed.args[0]), TensorShape({1 << 20, 7}));
+  EXPECT_EQ(bucketed.padded_dims[0].size, 1000);
+}
+
+TEST(ShapeBucketingTest, DisabledClusterIsNotPadded) {
+  ShapeBucketer bucketer;
+  bucketer.Bucket("cluster", MatrixArgs(5, 7));
+  bucketer.Disable("cluster");
+  ShapeBucketer::BucketedArguments bucketed =
+      bucketer.Bucket("cluster", MatrixArgs(6, 7));
+  EXPECT_TRUE(bucketed.padded_dims.empty());
+  EXPECT_EQ(ShapeOf(bucketed.args[0]), TensorShape({6, 7}));
+
+  // Other clusters are still bucketed.
+  bucketer.Bucket("other", MatrixArgs(5, 7));
+  EXPECT_EQ(bucketer.Bucket("other", MatrixArgs(6, 7)).padded_dims.size(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
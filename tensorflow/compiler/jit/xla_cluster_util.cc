@@ -342,6 +342,21 @@ void HistogramMapToRepeatedOpAndCount(
   });
 }
 
+// Returns true if `n` has a data input from, and a data output to, nodes in
+// XLA clusters.
+bool IsClusterBoundaryNode(const Node& n) {
+  auto is_clustered_data_edge = [](const Node* other, const Edge* e) {
+    return !e->IsControlEdge() && GetXlaClusterForNode(*other).has_value();
+  };
+  bool has_clustered_input = absl::c_any_of(n.in_edges(), [&](const Edge* e) {
+    return is_clustered_data_edge(e->src(), e);
+  });
+  return has_clustered_input &&
+         absl::c_any_of(n.out_edges(), [&](const Edge* e) {
+           return is_clustered_data_edge(e->dst(), e);
+         });
+}
+
 void ClusterInfoToProtobuf(XlaAutoClusteringSummary::Cluster* result,
                            absl::string_view name, const ClusterInfo& info) {
   result->set_name(std::string(name));
@@ -356,6 +371,7 @@ XlaAutoClusteringSummary GetXlaAutoClusteringSummary(const Graph& graph) {
   XlaAutoClusteringSummary result;
 
   absl::flat_hash_map<absl::string_view, int> unclustered_op_histogram;
+  absl::flat_hash_map<absl::string_view, int> cluster_boundary_op_histogram;
 
   for (Node* n : graph.nodes()) {
     absl::optional<absl::string_view> cluster_name = GetXlaClusterForNode(*n);
@@ -367,6 +383,9 @@ XlaAutoClusteringSummary GetXlaAutoClusteringSummary(const Graph& graph) {
     } else {
       result.set_unclustered_node_count(result.unclustered_node_count() + 1);
       unclustered_op_histogram[n->type_string()]++;
+      if (IsClusterBoundaryNode(*n)) {
+        cluster_boundary_op_histogram[n->type_string()]++;
+      }
     }
   }
 
@@ -383,6 +402,9 @@ XlaAutoClusteringSummary GetXlaAutoClusteringSummary(const Graph& graph) {
 
   HistogramMapToRepeatedOpAndCount(result.mutable_unclustered_op_histogram(),
                                    unclustered_op_histogram);
+  HistogramMapToRepeatedOpAndCount(
+      result.mutable_cluster_boundary_op_histogram(),
+      cluster_boundary_op_histogram);
 
   return result;
 }
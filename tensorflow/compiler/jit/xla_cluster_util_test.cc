@@ -223,6 +223,33 @@ void AddRegularFunctionFunctionDef(FunctionDefLibrary* fdef_lib) {
   *fdef_lib->add_function() = make_regular_float;
 }
 
+TEST(GetXlaAutoClusteringSummary, ClusterBoundaryOps) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+
+  Output a = ops::Const(root.WithOpName("a"), {1.0f, 0.0f});
+  Output b = ops::Neg(root.WithOpName("b"), a);
+  Output c = ops::Where(root.WithOpName("c"), b);
+  Output d = ops::Cast(root.WithOpName("d"), c, DT_FLOAT);
+  Output e = ops::Neg(root.WithOpName("e"), d);
+  Output f = ops::Where(root.WithOpName("f"), e);
+
+  FixupSourceAndSinkEdges(root.graph());
+  for (Node* n : root.graph()->nodes()) {
+    if (n->name() == "a" || n->name() == "b") {
+      n->AddAttr(kXlaClusterAttr, "cluster_0");
+    } else if (n->name() == "d" || n->name() == "e") {
+      n->AddAttr(kXlaClusterAttr, "cluster_1");
+    }
+  }
+
+  // "c" sits between two clusters; "f" only consumes from one.
+  XlaAutoClusteringSummary summary =
+      GetXlaAutoClusteringSummary(*root.graph());
+  ASSERT_EQ(summary.cluster_boundary_op_histogram_size(), 1);
+  EXPECT_EQ(summary.cluster_boundary_op_histogram(0).op(), "Where");
+  EXPECT_EQ(summary.cluster_boundary_op_histogram(0).count(), 1);
+}
+
 TEST(NodesRelatedToRefVariables, Basic) {
   Scope root = Scope::NewRootScope().ExitOnError();
 
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <algorithm>
+#include <atomic>
 #include <numeric>
 
 #include "absl/base/call_once.h"
@@ -55,9 +57,18 @@ constexpr int64 XlaCompilationCache::kDefaultCompilationThreshold;
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : client_(client),
+      device_type_(std::move(device_type)),
+      shape_bucketer_(GetXlaOpsCommonFlags().tf_xla_shape_buckets) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  {
+    mutex_lock lock(async_compilation_mu_);
+    while (num_async_compilations_ > 0) {
+      async_compilation_done_.wait(lock);
+    }
+  }
+
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -91,12 +102,17 @@ string XlaCompilationCache::Signature::HumanString() const {
   for (const auto& v : arg_values) {
     absl::StrAppend(&result, "; ", v.DebugString());
   }
+
+  for (const auto& d : dynamic_dims) {
+    absl::StrAppend(&result, "; dynamic ", d.first, ":", d.second);
+  }
   return result;
 }
 
 bool XlaCompilationCache::Signature::operator==(const Signature& other) const {
   if (name != other.name) return false;
   if (arg_shapes != other.arg_shapes) return false;
+  if (dynamic_dims != other.dynamic_dims) return false;
 
   if (arg_values.size() != other.arg_values.size()) return false;
   for (int i = 0, end = arg_values.size(); i < end; ++i) {
@@ -123,6 +139,10 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
     h = Hash64Combine(
         h, Hash64(arg.tensor_data().data(), arg.tensor_data().size()));
   }
+  for (const auto& dim : signature.dynamic_dims) {
+    h = Hash64Combine(h, std::hash<int>()(dim.first));
+    h = Hash64Combine(h, std::hash<int>()(dim.second));
+  }
   return h;
 }
 
@@ -133,7 +153,8 @@ XlaCompilationCache::BuildSignature(
   Signature signature;
   signature.name = Canonicalize(function.name(), AttrSlice(&function.attr()));
 
-  for (const XlaCompiler::Argument& arg : args) {
+  for (int arg_num = 0, end = args.size(); arg_num < end; ++arg_num) {
+    const XlaCompiler::Argument& arg = args[arg_num];
     switch (arg.kind) {
       case XlaCompiler::Argument::kConstant:
         signature.arg_values.push_back(arg.constant_value);
@@ -142,6 +163,9 @@ XlaCompilationCache::BuildSignature(
       case XlaCompiler::Argument::kResource:
         signature.arg_shapes.emplace_back(arg.type,
                                           arg.DimensionSizesAsInlinedVector());
+        for (const auto& dim_and_arg_num : arg.dynamic_dim_to_arg_num_map) {
+          signature.dynamic_dims.emplace_back(arg_num, dim_and_arg_num.first);
+        }
         break;
       default:
         return errors::InvalidArgument(
@@ -194,7 +218,16 @@ Status XlaCompilationCache::Compile(
                         XlaCompiler::CompilationResult* result) {
     return compiler->CompileFunction(compile_options, function, args, result);
   };
+  auto make_async_compile_fn = [&]() -> CompileFn {
+    std::vector<XlaCompiler::Argument> owned_args(args.begin(), args.end());
+    return [compile_options, function, owned_args](
+               XlaCompiler* compiler, XlaCompiler::CompilationResult* result) {
+      return compiler->CompileFunction(compile_options, function, owned_args,
+                                       result);
+    };
+  };
   return CompileImpl(options, function, args, compile_fn,
+                     make_async_compile_fn,
                      /*compile_threshold=*/compile_threshold,
                      out_compilation_result, out_executable);
 }
@@ -299,6 +332,7 @@ Status XlaCompilationCache::CompileSingleOp(
         *options.flib_def, debug_info, options.shape_representation_fn, result);
   };
   return CompileImpl(options, name, args, compile_op,
+                     /*make_async_compile_fn=*/nullptr,
                      /*compile_threshold=*/absl::nullopt,
                      out_compilation_result, out_executable);
 }
@@ -315,13 +349,57 @@ void LogOnceXlaCompiledFirstCluster() {
                  "once for the lifetime of the process.";
   });
 }
+
+// Identifies the cache entries that the compilation caches of equivalent
+// devices share.  Besides the signature, the key holds every input of the
+// compilation that may differ between the caches.
+struct SharedEntryKey {
+  const xla::LocalClient* client;
+  string device_type;
+  // The lowest device ordinal equivalent to the compiling device.
+  int device_class;
+  const FunctionLibraryDefinition* flib_def;
+  int graph_def_version;
+  bool alias_passthrough_params;
+  XlaCompilationCache::Signature signature;
+
+  bool operator==(const SharedEntryKey& other) const {
+    return client == other.client && device_type == other.device_type &&
+           device_class == other.device_class && flib_def == other.flib_def &&
+           graph_def_version == other.graph_def_version &&
+           alias_passthrough_params == other.alias_passthrough_params &&
+           signature == other.signature;
+  }
+
+  struct Hash {
+    uint64 operator()(const SharedEntryKey& key) const {
+      uint64 h = XlaCompilationCache::Signature::Hash()(key.signature);
+      h = Hash64Combine(h, reinterpret_cast<uintptr_t>(key.client));
+      h = Hash64Combine(h, Hash64(key.device_type));
+      h = Hash64Combine(h, key.device_class);
+      h = Hash64Combine(h, reinterpret_cast<uintptr_t>(key.flib_def));
+      h = Hash64Combine(h, key.graph_def_version);
+      return Hash64Combine(h, key.alias_passthrough_params);
+    }
+  };
+};
+
+// The number of background compilations queued or running, across all
+// compilation caches.
+std::atomic<int64> num_pending_async_compilations(0);
+
+thread::ThreadPool* AsyncCompilationThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "xla_async_compilation",
+      std::max(1, GetXlaOpsCommonFlags().tf_xla_async_compilation_threads));
+  return pool;
+}
 }  // namespace
 
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
-    absl::Span<const XlaCompiler::Argument> args,
-    const std::function<Status(XlaCompiler* compiler,
-                               XlaCompiler::CompilationResult*)>& compile_fn,
+    absl::Span<const XlaCompiler::Argument> args, const CompileFn& compile_fn,
+    const std::function<CompileFn()>& make_async_compile_fn,
     absl::optional<int64> compile_threshold,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
@@ -344,13 +422,27 @@ Status XlaCompilationCache::CompileImpl(
 
   // The outer lock protects the existence of the cache entry. It does not
   // protect the contents of the cache entry.
-  Entry* entry;
+  Entry* entry = nullptr;
   {
     mutex_lock lock(compile_cache_mu_);
-    // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
+    auto it = cache_.find(signature);
+    if (it != cache_.end()) {
+      entry = it->second.get();
+    }
+  }
+  if (entry == nullptr) {
+    // Find or create a cache entry, possibly one shared with other devices.
+    std::shared_ptr<Entry> new_entry;
+    if (GetXlaOpsCommonFlags().tf_xla_share_compilation_across_devices) {
+      TF_ASSIGN_OR_RETURN(new_entry,
+                          FindOrCreateSharedEntry(options, signature));
+    } else {
+      new_entry = std::make_shared<Entry>();
+    }
+    mutex_lock lock(compile_cache_mu_);
+    std::shared_ptr<Entry>& e = cache_[signature];
     if (!e) {
-      e.reset(new Entry);
+      e = std::move(new_entry);
     }
     entry = e.get();
   }
@@ -436,6 +528,21 @@ Status XlaCompilationCache::CompileImpl(
       return Status::OK();
     }
 
+    // Lazily compiled clusters can fall back to the TF executor, so with async
+    // compilation they keep doing so until the background compilation is done.
+    if (compile_threshold.has_value() && make_async_compile_fn &&
+        GetXlaOpsCommonFlags().tf_xla_async_compilation) {
+      if (!entry->async_compilation_pending) {
+        StartAsyncCompilation(options, function.name(), entry,
+                              make_async_compile_fn());
+      }
+      VLOG(2) << "Compiling asynchronously for signature: "
+              << signature.HumanString();
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
+    }
+
     tensorflow::Env* env = tensorflow::Env::Default();
     const uint64 compile_start_us = env->NowMicros();
     // Do the actual JIT compilation without holding the lock (it can take
@@ -453,35 +560,7 @@ Status XlaCompilationCache::CompileImpl(
 
     const uint64 compile_end_us = env->NowMicros();
     const uint64 compile_time_us = compile_end_us - compile_start_us;
-    metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us ("
-              << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
-                                                               1.0e6)
-              << " / "
-              << tensorflow::strings::HumanReadableElapsedTime(
-                     it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    TF_RETURN_IF_ERROR(RecordCompilation(function.name(), compile_time_us));
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
@@ -489,4 +568,158 @@ Status XlaCompilationCache::CompileImpl(
   return Status::OK();
 }
 
+Status XlaCompilationCache::RecordCompilation(const string& function_name,
+                                              uint64 compile_time_us) {
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  mutex_lock lock(cluster_compile_stats_mu_);
+  auto it = cluster_compile_stats_.find(function_name);
+  it->second.compile_count++;
+  it->second.cumulative_compile_time_us += compile_time_us;
+  LogOnceXlaCompiledFirstCluster();
+  VLOG(1) << "compiled " << function_name << " " << it->second.compile_count
+          << " times, compile time: " << compile_time_us
+          << " us, cumulative: " << it->second.cumulative_compile_time_us
+          << " us ("
+          << tensorflow::strings::HumanReadableElapsedTime(compile_time_us /
+                                                           1.0e6)
+          << " / "
+          << tensorflow::strings::HumanReadableElapsedTime(
+                 it->second.cumulative_compile_time_us / 1.0e6)
+          << ")";
+
+  XlaJitCompilationActivity jit_compilation_activity;
+  jit_compilation_activity.set_cluster_name(function_name);
+  jit_compilation_activity.set_compile_count(it->second.compile_count);
+  jit_compilation_activity.set_compile_time_us(compile_time_us);
+  jit_compilation_activity.set_cumulative_compile_time_us(
+      it->second.cumulative_compile_time_us);
+
+  return BroadcastXlaActivity(std::move(jit_compilation_activity));
+}
+
+void XlaCompilationCache::StartAsyncCompilation(
+    const XlaCompiler::Options& options, const string& function_name,
+    Entry* entry, CompileFn compile_fn) {
+  const int64 max_pending =
+      GetXlaOpsCommonFlags().tf_xla_async_compilation_max_pending;
+  if (num_pending_async_compilations.fetch_add(1) >= max_pending) {
+    num_pending_async_compilations.fetch_sub(1);
+    VLOG(2) << "Not compiling " << function_name << " yet: " << max_pending
+            << " background compilations are already pending.";
+    return;
+  }
+  entry->async_compilation_pending = true;
+  {
+    mutex_lock lock(async_compilation_mu_);
+    ++num_async_compilations_;
+  }
+
+  // The caller's function library may be destroyed before the compilation
+  // runs, so compile against a copy of it.
+  auto flib_def =
+      std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  XlaCompiler::Options async_options = options;
+  async_options.flib_def = flib_def.get();
+
+  AsyncCompilationThreadPool()->Schedule([this, async_options, flib_def,
+                                          function_name, entry, compile_fn]() {
+    tensorflow::Env* env = tensorflow::Env::Default();
+    const uint64 compile_start_us = env->NowMicros();
+    XlaCompiler::CompilationResult compilation_result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status;
+    {
+      XlaCompiler compiler(async_options);
+      status = compile_fn(&compiler, &compilation_result);
+    }
+    if (status.ok()) {
+      status = BuildExecutable(async_options, compilation_result, &executable);
+    }
+    const uint64 compile_time_us = env->NowMicros() - compile_start_us;
+
+    {
+      mutex_lock lock(entry->mu);
+      entry->async_compilation_pending = false;
+      // A strict compilation of the same signature may have finished first.
+      if (!entry->compiled) {
+        entry->compiled = true;
+        entry->compilation_status = status;
+        entry->compilation_result = std::move(compilation_result);
+        entry->executable = std::move(executable);
+      }
+    }
+    if (status.ok()) {
+      Status record_status = RecordCompilation(function_name, compile_time_us);
+      if (!record_status.ok()) {
+        LOG(WARNING) << "Failed to record compilation of " << function_name
+                     << ": " << record_status;
+      }
+    } else {
+      VLOG(1) << "Background compilation of " << function_name
+              << " failed: " << status;
+    }
+
+    num_pending_async_compilations.fetch_sub(1);
+    mutex_lock lock(async_compilation_mu_);
+    if (--num_async_compilations_ == 0) {
+      async_compilation_done_.notify_all();
+    }
+  });
+}
+
+xla::StatusOr<std::shared_ptr<XlaCompilationCache::Entry>>
+XlaCompilationCache::FindOrCreateSharedEntry(
+    const XlaCompiler::Options& options, const Signature& signature) {
+  const int device_ordinal = options.device_ordinal != -1
+                                 ? options.device_ordinal
+                                 : client_->default_device_ordinal();
+  int device_class = device_ordinal;
+  for (int i = 0; i < device_ordinal; ++i) {
+    TF_ASSIGN_OR_RETURN(
+        bool equivalent,
+        client_->mutable_backend()->devices_equivalent(i, device_ordinal));
+    if (equivalent) {
+      device_class = i;
+      break;
+    }
+  }
+  SharedEntryKey key{client_,
+                     device_type_.type_string(),
+                     device_class,
+                     options.flib_def,
+                     options.graph_def_version,
+                     options.alias_passthrough_params,
+                     signature};
+
+  // Entries are owned by the caches using them; this only finds them.
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* entries =
+      new absl::flat_hash_map<SharedEntryKey, std::weak_ptr<Entry>,
+                              SharedEntryKey::Hash>;
+  static size_t sweep_threshold = 1024;
+  mutex_lock lock(mu);
+  std::weak_ptr<Entry>& weak_entry = (*entries)[key];
+  std::shared_ptr<Entry> entry = weak_entry.lock();
+  if (entry) {
+    VLOG(2) << "Sharing compilation of " << signature.HumanString()
+            << " with device " << device_class;
+    return entry;
+  }
+  entry = std::make_shared<Entry>();
+  weak_entry = entry;
+
+  // Forget the entries of destroyed caches once in a while.
+  if (entries->size() >= sweep_threshold) {
+    for (auto it = entries->begin(); it != entries->end();) {
+      if (it->second.expired()) {
+        entries->erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    sweep_threshold = std::max<size_t>(1024, 2 * entries->size());
+  }
+  return entry;
+}
+
 }  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -40,6 +41,11 @@ namespace tensorflow {
 // Since XLA computations must have static shapes, the cache generates a new
 // XLA computation for each new set of input shapes.
 //
+// Each device has its own cache, but the caches of devices that XLA considers
+// equivalent (e.g. the GPUs of one model in a host) share their entries, so a
+// cluster is compiled once for all of them.  Concurrent requests for the same
+// signature wait for a single compilation.
+//
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
 class XlaCompilationCache : public ResourceBase {
@@ -61,8 +67,10 @@ class XlaCompilationCache : public ResourceBase {
   // miss.  If `compile_mode` is `kLazy` then, based on some profitability
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
-  // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // and `out_executable`.  With --tf_xla_async_compilation, a lazy cache miss
+  // also returns nulls while the cluster is compiled in the background.  If
+  // `compile_mode` is `kStrict` then the compilation cache always attempts the
+  // compilation on a cache miss.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -91,6 +99,10 @@ class XlaCompilationCache : public ResourceBase {
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
+  // Pads the parameters of the clusters compiled by this cache up to shape
+  // buckets, if --tf_xla_enable_shape_bucketing is set.
+  ShapeBucketer* shape_bucketer() { return &shape_bucketer_; }
+
   string DebugString() const override;
 
   // Describes the types, shapes and any compile-time constant arguments
@@ -107,6 +119,10 @@ class XlaCompilationCache : public ResourceBase {
     // compilation, ordered by argument number. Tensors must be in host memory.
     absl::InlinedVector<Tensor, 4> arg_values;
 
+    // List of (argument number, dimension) pairs of the dimensions of
+    // parameters that are dynamic, i.e. padded up to the size in `arg_shapes`.
+    absl::InlinedVector<std::pair<int, int>, 4> dynamic_dims;
+
     bool operator==(const Signature& other) const;
 
     struct Hash {
@@ -123,12 +139,18 @@ class XlaCompilationCache : public ResourceBase {
       absl::Span<const XlaCompiler::Argument> args);
 
  private:
+  using CompileFn = std::function<Status(XlaCompiler* compiler,
+                                         XlaCompiler::CompilationResult*)>;
+
   // Common implementation of Compile and CompileSingleOp.
+  //
+  // `make_async_compile_fn`, if not null, returns a CompileFn equivalent to
+  // `compile_fn` that owns its inputs so it can run after this call returns.
+  // It is used for background compilation.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
-      absl::Span<const XlaCompiler::Argument> args,
-      const std::function<Status(XlaCompiler* compiler,
-                                 XlaCompiler::CompilationResult*)>& compile_fn,
+      absl::Span<const XlaCompiler::Argument> args, const CompileFn& compile_fn,
+      const std::function<CompileFn()>& make_async_compile_fn,
       absl::optional<int64> compile_threshold,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
@@ -141,6 +163,7 @@ class XlaCompilationCache : public ResourceBase {
 
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  ShapeBucketer shape_bucketer_;
 
   // The value associated with a cache entry.
   struct Entry {
@@ -149,6 +172,9 @@ class XlaCompilationCache : public ResourceBase {
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is a background compilation of this entry queued or running?
+    bool async_compilation_pending = false;
+
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
@@ -163,8 +189,14 @@ class XlaCompilationCache : public ResourceBase {
     std::unique_ptr<xla::LocalExecutable> executable TF_GUARDED_BY(mu);
   };
 
+  // Returns the entry for `signature` shared by all caches compiling with
+  // `options` for devices equivalent to `options.device_ordinal`, creating it
+  // if needed.
+  xla::StatusOr<std::shared_ptr<Entry>> FindOrCreateSharedEntry(
+      const XlaCompiler::Options& options, const Signature& signature);
+
   mutex compile_cache_mu_;
-  absl::flat_hash_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
+  absl::flat_hash_map<Signature, std::shared_ptr<Entry>, Signature::Hash> cache_
       TF_GUARDED_BY(compile_cache_mu_);
 
   struct ClusterCompileStats {
@@ -183,6 +215,24 @@ class XlaCompilationCache : public ResourceBase {
     bool is_megamorphic = false;
   };
 
+  // Starts compiling `entry` on the background compilation thread pool,
+  // unless --tf_xla_async_compilation_max_pending compilations are already
+  // pending.
+  void StartAsyncCompilation(const XlaCompiler::Options& options,
+                             const string& function_name, Entry* entry,
+                             CompileFn compile_fn)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(entry->mu);
+
+  // Updates the statistics of `function_name` after it has been compiled.
+  Status RecordCompilation(const string& function_name,
+                           uint64 compile_time_us);
+
+  // The number of background compilations started by this cache that have not
+  // finished.  The destructor waits for them, since they write to `cache_`.
+  mutex async_compilation_mu_;
+  condition_variable async_compilation_done_;
+  int64 num_async_compilations_ TF_GUARDED_BY(async_compilation_mu_) = 0;
+
   mutex cluster_compile_stats_mu_;
 
   // Maps cluster names to compilation statistics for said cluster.
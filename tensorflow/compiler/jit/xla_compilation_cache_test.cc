@@ -18,12 +18,21 @@ limitations under the License.
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
 
+// The flags are parsed once, on first use.
+static bool Initialized = [] {
+  setenv("TF_XLA_FLAGS", "--tf_xla_async_compilation=true", /*overwrite=*/1);
+  return true;
+}();
+
 TEST(XlaCompilationCacheTest, SignatureEquality) {
   NameAttrList fn;
   fn.set_name("afunction");
@@ -54,6 +63,90 @@ TEST(XlaCompilationCacheTest, SignatureEquality) {
   }
 }
 
+// Must run before TestDisabledXlaCompilation, which disables compilation for
+// the rest of the process.
+TEST(XlaCompilationCacheTest, SharedAcrossCaches) {
+  FunctionDefLibrary flib;
+  *flib.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), flib);
+
+  XlaCompiler::Options options;
+  options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  options.client = xla::ClientLibrary::LocalClientOrDie();
+  options.flib_def = &flib_def;
+
+  NameAttrList fn;
+  fn.set_name("XTimesTwo");
+  (*fn.mutable_attr())["T"].set_type(DT_FLOAT);
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({3});
+
+  // Two caches for the same device, as two devices of one model would have.
+  auto cache1 = new XlaCompilationCache(options.client, options.device_type);
+  core::ScopedUnref cache1_ref(cache1);
+  auto cache2 = new XlaCompilationCache(options.client, options.device_type);
+  core::ScopedUnref cache2_ref(cache2);
+
+  const XlaCompiler::CompilationResult* compilation_result1;
+  xla::LocalExecutable* executable1;
+  TF_ASSERT_OK(cache1->Compile(options, fn, args,
+                               XlaCompiler::CompileOptions{},
+                               XlaCompilationCache::CompileMode::kStrict,
+                               &compilation_result1, &executable1));
+  const XlaCompiler::CompilationResult* compilation_result2;
+  xla::LocalExecutable* executable2;
+  TF_ASSERT_OK(cache2->Compile(options, fn, args,
+                               XlaCompiler::CompileOptions{},
+                               XlaCompilationCache::CompileMode::kStrict,
+                               &compilation_result2, &executable2));
+  EXPECT_NE(executable1, nullptr);
+  EXPECT_EQ(executable1, executable2);
+  EXPECT_EQ(compilation_result1, compilation_result2);
+}
+
+TEST(XlaCompilationCacheTest, AsyncCompilation) {
+  FunctionDefLibrary flib;
+  *flib.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), flib);
+
+  XlaCompiler::Options options;
+  options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  options.client = xla::ClientLibrary::LocalClientOrDie();
+  options.flib_def = &flib_def;
+
+  NameAttrList fn;
+  fn.set_name("XTimesTwo");
+  (*fn.mutable_attr())["T"].set_type(DT_FLOAT);
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({2});
+
+  auto cache = new XlaCompilationCache(options.client, options.device_type);
+  core::ScopedUnref cache_ref(cache);
+
+  // The first lazy request starts a background compilation and falls back.
+  const XlaCompiler::CompilationResult* compilation_result;
+  xla::LocalExecutable* executable;
+  TF_ASSERT_OK(cache->Compile(options, fn, args, XlaCompiler::CompileOptions{},
+                              XlaCompilationCache::CompileMode::kLazy,
+                              &compilation_result, &executable));
+  EXPECT_EQ(compilation_result, nullptr);
+  EXPECT_EQ(executable, nullptr);
+
+  // Later requests pick up the compiled executable once it is ready.
+  while (executable == nullptr) {
+    Env::Default()->SleepForMicroseconds(1000);
+    TF_ASSERT_OK(cache->Compile(
+        options, fn, args, XlaCompiler::CompileOptions{},
+        XlaCompilationCache::CompileMode::kLazy, &compilation_result,
+        &executable));
+  }
+  EXPECT_NE(compilation_result, nullptr);
+}
+
 TEST(XlaCompilationCacheTest, TestDisabledXlaCompilation) {
   NameAttrList fn;
   fn.set_name("afunction");
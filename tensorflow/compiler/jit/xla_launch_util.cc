@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
+#include <cstring>
 #include <memory>
 
 #include "absl/algorithm/container.h"
@@ -24,6 +25,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -200,16 +203,100 @@ static void PopulateExecutionInputBuffer(xla::ExecutionInput& execution_input,
   }
 }
 
+// Returns a buffer of `device_shape` holding `t` padded with zeros at the end
+// of each dimension. `device_shape` must have a row-major layout.
+static xla::StatusOr<se::OwningDeviceMemory> PadInputBuffer(
+    se::Stream* stream, const Tensor& t, const xla::Shape& device_shape,
+    int device_ordinal, se::DeviceMemoryAllocator* allocator) {
+  TF_RET_CHECK(device_shape.IsArray() &&
+               device_shape.rank() == t.dims() &&
+               xla::LayoutUtil::IsMonotonicWithDim0Major(
+                   device_shape.layout()))
+      << "Can't pad " << t.shape().DebugString() << " to "
+      << xla::ShapeUtil::HumanStringWithLayout(device_shape);
+  const int64 size = xla::ShapeUtil::ByteSizeOf(device_shape);
+  TF_ASSIGN_OR_RETURN(se::OwningDeviceMemory padded,
+                      allocator->Allocate(device_ordinal, size));
+  se::DeviceMemoryBase dst = *padded;
+  if (stream) {
+    stream->ThenMemZero(&dst, size);
+  } else {
+    std::memset(dst.opaque(), 0, size);
+  }
+  if (t.NumElements() == 0) {
+    return std::move(padded);
+  }
+
+  // Copy one contiguous run per index of the dimensions major to the last
+  // padded one.
+  int last_padded_dim = t.dims() - 1;
+  while (t.dim_size(last_padded_dim) ==
+         device_shape.dimensions(last_padded_dim)) {
+    --last_padded_dim;
+  }
+  int64 run_bytes = DataTypeSize(t.dtype());
+  for (int dim = t.dims() - 1; dim >= last_padded_dim; --dim) {
+    run_bytes *= t.dim_size(dim);
+  }
+  const int64 dst_run_stride = run_bytes / t.dim_size(last_padded_dim) *
+                               device_shape.dimensions(last_padded_dim);
+  const char* src = static_cast<const char*>(DMAHelper::base(&t));
+  std::vector<int64> index(last_padded_dim, 0);
+  for (int64 src_offset = 0, end = t.TotalBytes(); src_offset < end;
+       src_offset += run_bytes) {
+    int64 dst_offset = 0;
+    for (int dim = 0; dim < last_padded_dim; ++dim) {
+      dst_offset = dst_offset * device_shape.dimensions(dim) + index[dim];
+    }
+    dst_offset *= dst_run_stride;
+    if (stream) {
+      se::DeviceMemoryBase dst_run(
+          static_cast<char*>(dst.opaque()) + dst_offset, run_bytes);
+      se::DeviceMemoryBase src_run(const_cast<char*>(src) + src_offset,
+                                   run_bytes);
+      stream->ThenMemcpy(&dst_run, src_run, run_bytes);
+    } else {
+      std::memcpy(static_cast<char*>(dst.opaque()) + dst_offset,
+                  src + src_offset, run_bytes);
+    }
+    for (int dim = last_padded_dim - 1; dim >= 0; --dim) {
+      if (++index[dim] < t.dim_size(dim)) {
+        break;
+      }
+      index[dim] = 0;
+    }
+  }
+  return std::move(padded);
+}
+
+// Returns a buffer holding the int32 `value`.
+static xla::StatusOr<se::OwningDeviceMemory> SizeInputBuffer(
+    se::Stream* stream, int64 value, int device_ordinal,
+    se::DeviceMemoryAllocator* allocator) {
+  TF_ASSIGN_OR_RETURN(se::OwningDeviceMemory buffer,
+                      allocator->Allocate(device_ordinal, sizeof(int32)));
+  se::DeviceMemoryBase mem = *buffer;
+  if (stream) {
+    stream->ThenMemset32(&mem, static_cast<uint32>(value), sizeof(int32));
+  } else {
+    *static_cast<int32*>(mem.opaque()) = value;
+  }
+  return std::move(buffer);
+}
+
 xla::StatusOr<std::vector<xla::ExecutionInput>>
 XlaComputationLaunchContext::PopulateInputs(
     OpKernelContext* ctx,
     const XlaCompiler::CompilationResult* compilation_result,
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
-    const xla::HloInputOutputAliasConfig& input_output_alias) {
+    const xla::HloInputOutputAliasConfig& input_output_alias,
+    absl::Span<const int64> dynamic_dimension_sizes) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
 
+  se::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
   xla::TransferManager* transfer_manager =
       client_->backend().transfer_manager();
   for (int i = 0, end = compilation_result->xla_input_shapes.size(); i < end;
@@ -220,6 +307,20 @@ XlaComputationLaunchContext::PopulateInputs(
     const xla::Shape& device_shape =
         transfer_manager->HostShapeToDeviceShape(shape);
 
+    // Arguments past the kernel's inputs hold the sizes of padded dimensions.
+    const int size_index =
+        arg_num - missing_ctx_input_prefix - ctx->num_inputs();
+    if (size_index >= 0) {
+      TF_RET_CHECK(size_index < dynamic_dimension_sizes.size());
+      TF_ASSIGN_OR_RETURN(
+          se::OwningDeviceMemory size_buffer,
+          SizeInputBuffer(stream, dynamic_dimension_sizes[size_index],
+                          device_ordinal_, xla_allocator_));
+      arguments.emplace_back(device_shape, shape);
+      *arguments.back().MutableBuffer({}) = std::move(size_buffer);
+      continue;
+    }
+
     bool is_resource_variable = resource_vars.count(arg_num);
     bool is_updated_resource_variable =
         is_resource_variable &&
@@ -251,7 +352,15 @@ XlaComputationLaunchContext::PopulateInputs(
 
     arguments.emplace_back(device_shape, shape);
     xla::ExecutionInput& execution_input = arguments.back();
-    if (xla::Shape::Equal().MinorToMajorOnlyInLayout()(shape, device_shape)) {
+    if (!dynamic_dimension_sizes.empty() && !use_multiple_streams_ &&
+        shape.IsArray() &&
+        t->NumElements() != xla::ShapeUtil::ElementsIn(shape)) {
+      TF_ASSIGN_OR_RETURN(se::OwningDeviceMemory padded,
+                          PadInputBuffer(stream, *t, device_shape,
+                                         device_ordinal_, xla_allocator_));
+      *execution_input.MutableBuffer({}) = std::move(padded);
+    } else if (xla::Shape::Equal().MinorToMajorOnlyInLayout()(shape,
+                                                              device_shape)) {
       se::DeviceMemoryBase dmem = XlaTensor::DeviceMemoryFromTensor(*t);
       PopulateExecutionInputBuffer(execution_input, xla::ShapeIndex{}, dmem,
                                    donate_buffer, device_ordinal_,
@@ -152,12 +152,18 @@ class XlaComputationLaunchContext {
   // missing and adjusts input indices accordingly.  All elements in kernel's
   // input_mapping must be greater than or equal to `missing_ctx_input_prefix`
   // (in other words, no inputs actually required by the kernel can be missing).
+  //
+  // If the computation was compiled with padded parameters (see
+  // ShapeBucketer), `dynamic_dimension_sizes` holds the values of the size
+  // parameters that follow the kernel's inputs, and inputs smaller than their
+  // parameters are copied into zero-padded buffers.
   xla::StatusOr<std::vector<xla::ExecutionInput>> PopulateInputs(
       OpKernelContext* ctx,
       const XlaCompiler::CompilationResult* compilation_result,
       const std::map<int, const Tensor*>& resource_vars,
       int missing_ctx_input_prefix,
-      const xla::HloInputOutputAliasConfig& input_output_alias);
+      const xla::HloInputOutputAliasConfig& input_output_alias,
+      absl::Span<const int64> dynamic_dimension_sizes = {});
 
   // Given the XLA output in `output`, populate all outputs of `ctx`.  Also
   // writes out the resource variable updates.
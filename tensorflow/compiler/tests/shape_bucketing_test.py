@@ -0,0 +1,64 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compiled functions with --tf_xla_enable_shape_bucketing.
+
+The flags are parsed once per process, so these tests live apart from the
+other tests of compiled functions.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.python.eager import def_function
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+class ShapeBucketingTest(test_util.TensorFlowTestCase):
+
+  def testPaddedInputsGiveExactResults(self):
+
+    @def_function.function(
+        experimental_compile=True,
+        input_signature=[tensor_spec.TensorSpec([None, 3], dtypes.float32)])
+    def f(x):
+      return (x * 2, math_ops.reduce_max(x, axis=0),
+              math_ops.reduce_sum(x, axis=1))
+
+    # The first call compiles the exact shape; the later ones are padded up to
+    # a power of two with zeros, which the results must not see.
+    for rows in [5, 6, 7, 8, 3]:
+      x = -1 - np.arange(rows * 3, dtype=np.float32).reshape([rows, 3])
+      doubled, row_max, col_sum = f(constant_op.constant(x))
+      self.assertAllEqual(x * 2, doubled)
+      self.assertAllEqual(np.max(x, axis=0), row_max)
+      self.assertAllEqual(np.sum(x, axis=1), col_sum)
+
+
+if __name__ == '__main__':
+  os.environ['TF_XLA_FLAGS'] = ('--tf_xla_enable_shape_bucketing=true ' +
+                                os.environ.get('TF_XLA_FLAGS', ''))
+  ops.enable_eager_execution()
+  test.main()
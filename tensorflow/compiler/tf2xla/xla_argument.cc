@@ -19,10 +19,12 @@ namespace tensorflow {
 
 bool XlaArgument::operator==(const XlaArgument& other) const {
   if (std::tie(kind, resource_kind, type, name, initialized, max_array_size,
-               tensor_array_gradients) !=
+               tensor_array_gradients, dynamic_dim_to_arg_num_map,
+               is_pad_arg) !=
       std::tie(other.kind, other.resource_kind, other.type, other.name,
                other.initialized, other.max_array_size,
-               other.tensor_array_gradients)) {
+               other.tensor_array_gradients, other.dynamic_dim_to_arg_num_map,
+               other.is_pad_arg)) {
     return false;
   }
   if (absl::holds_alternative<xla::Shape>(shape)) {
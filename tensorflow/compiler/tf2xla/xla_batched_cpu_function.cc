@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2xla/xla_batched_cpu_function.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace tensorflow {
+
+XlaBatchedCpuFunction::XlaBatchedCpuFunction(std::vector<Variant> variants)
+    : variants_(std::move(variants)) {
+  assert(!variants_.empty());
+  std::sort(variants_.begin(), variants_.end(),
+            [](const Variant& a, const Variant& b) {
+              return a.batch_size < b.batch_size;
+            });
+  functions_.resize(variants_.size());
+  set_batch_size(variants_.front().batch_size);
+}
+
+XlaBatchedCpuFunction::~XlaBatchedCpuFunction() = default;
+
+void XlaBatchedCpuFunction::set_thread_pool(
+    const Eigen::ThreadPoolDevice* pool) {
+  thread_pool_ = pool;
+  for (const auto& function : functions_) {
+    if (function != nullptr) {
+      function->set_thread_pool(pool);
+    }
+  }
+}
+
+bool XlaBatchedCpuFunction::set_batch_size(int64 batch_size) {
+  if (batch_size < 1 || batch_size > max_batch_size()) {
+    return false;
+  }
+  auto it = std::lower_bound(variants_.begin(), variants_.end(), batch_size,
+                             [](const Variant& variant, int64 batch_size) {
+                               return variant.batch_size < batch_size;
+                             });
+  selected_ = it - variants_.begin();
+  batch_size_ = batch_size;
+  if (functions_[selected_] == nullptr) {
+    functions_[selected_].reset(new XlaCompiledCpuFunction(*it->static_data));
+    if (thread_pool_ != nullptr) {
+      functions_[selected_]->set_thread_pool(thread_pool_);
+    }
+  }
+  return true;
+}
+
+void XlaBatchedCpuFunction::set_arg_rows(size_t index, const void* data) {
+  XlaCompiledCpuFunction& function = variant();
+  const size_t size = function.arg_size(index);
+  const size_t row_size = size / padded_batch_size();
+  char* arg = static_cast<char*>(function.arg_data(index));
+  std::memcpy(arg, data, batch_size_ * row_size);
+  std::memset(arg + batch_size_ * row_size, 0, size - batch_size_ * row_size);
+}
+
+}  // namespace tensorflow
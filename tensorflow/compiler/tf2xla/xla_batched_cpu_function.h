@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_TF2XLA_XLA_BATCHED_CPU_FUNCTION_H_
+#define TENSORFLOW_COMPILER_TF2XLA_XLA_BATCHED_CPU_FUNCTION_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Runs a function compiled for several batch sizes, e.g. by
+// tf_library_batched in tfcompile.bzl, on batches of any size up to the
+// largest one.
+//
+// The batch must be the major dimension of every argument and result of the
+// variants, so that each row is a contiguous run of bytes. Each run uses the
+// smallest variant the batch fits in: the rows passed to set_arg_rows are
+// copied into its argument buffers and the rows past the batch are zeroed.
+// The results keep the batch size of the variant; only their first
+// batch_size() rows belong to the batch.
+//
+// The variants are instantiated on first use, and share the thread pool set
+// with set_thread_pool.
+//
+// Like XlaCompiledCpuFunction, this class is thread-compatible.
+class XlaBatchedCpuFunction {
+ public:
+  struct Variant {
+    int64 batch_size;
+    const XlaCompiledCpuFunction::StaticData* static_data;
+  };
+
+  explicit XlaBatchedCpuFunction(std::vector<Variant> variants);
+  virtual ~XlaBatchedCpuFunction();
+
+  XlaBatchedCpuFunction(const XlaBatchedCpuFunction&) = delete;
+  XlaBatchedCpuFunction& operator=(const XlaBatchedCpuFunction&) = delete;
+
+  // Sets the intra-op thread pool used by all variants.
+  void set_thread_pool(const Eigen::ThreadPoolDevice* pool);
+
+  int64 max_batch_size() const { return variants_.back().batch_size; }
+
+  // Selects the variant that runs batches of `batch_size` rows. Returns false
+  // if `batch_size` is not in [1, max_batch_size()].
+  bool set_batch_size(int64 batch_size);
+  int64 batch_size() const { return batch_size_; }
+
+  // Returns the batch size of the selected variant.
+  int64 padded_batch_size() const {
+    return variants_[selected_].batch_size;
+  }
+
+  // Returns the selected variant. Its arguments and results may be accessed
+  // directly, e.g. to write the rows of an argument in place.
+  XlaCompiledCpuFunction& variant() { return *functions_[selected_]; }
+  const XlaCompiledCpuFunction& variant() const {
+    return *functions_[selected_];
+  }
+
+  // Copies the batch_size() rows of the positional argument at `index` from
+  // `data` into the selected variant, and zeroes its remaining rows.
+  void set_arg_rows(size_t index, const void* data);
+
+  // Runs the selected variant. Returns true on success and false on failure.
+  bool Run() { return variant().Run(); }
+
+  // Returns the buffer for the positional result at `index` of the last run.
+  void* result_data(size_t index) { return variant().result_data(index); }
+  const void* result_data(size_t index) const {
+    return variant().result_data(index);
+  }
+
+ private:
+  // Sorted by batch size.
+  std::vector<Variant> variants_;
+  // The instantiated variants, or null.
+  std::vector<std::unique_ptr<XlaCompiledCpuFunction>> functions_;
+  const Eigen::ThreadPoolDevice* thread_pool_ = nullptr;
+  int64 batch_size_ = 0;
+  size_t selected_ = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_TF2XLA_XLA_BATCHED_CPU_FUNCTION_H_
@@ -0,0 +1,109 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2xla/xla_batched_cpu_function.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
+#include "tensorflow/compiler/tf2xla/xla_jit_compiled_cpu_function.h"
+#include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64 kColumns = 2;
+
+GraphDef SumGraph() {
+  GraphDef graph_def;
+  AttrValue type;
+  SetAttrValue(DT_INT32, &type);
+  for (const char* name : {"x", "y"}) {
+    NodeDef* node = graph_def.add_node();
+    node->set_name(name);
+    node->set_op("Placeholder");
+    (*node->mutable_attr())["dtype"] = type;
+  }
+  NodeDef* sum = graph_def.add_node();
+  sum->set_name("sum");
+  sum->set_op("Add");
+  sum->add_input("x");
+  sum->add_input("y");
+  (*sum->mutable_attr())["T"] = type;
+  return graph_def;
+}
+
+// Compiles SumGraph for inputs of `batch_size` rows.
+std::unique_ptr<XlaJitCompiledCpuFunction> CompileSum(int64 batch_size) {
+  tf2xla::Config config;
+  for (const char* name : {"x", "y"}) {
+    tf2xla::Feed* feed = config.add_feed();
+    feed->mutable_id()->set_node_name(name);
+    feed->mutable_shape()->add_dim()->set_size(batch_size);
+    feed->mutable_shape()->add_dim()->set_size(kColumns);
+  }
+  config.add_fetch()->mutable_id()->set_node_name("sum");
+  auto jit = XlaJitCompiledCpuFunction::Compile(SumGraph(), config,
+                                                xla::ExecutableBuildOptions());
+  TF_CHECK_OK(jit.status());
+  return jit.ConsumeValueOrDie();
+}
+
+TEST(XlaBatchedCpuFunctionTest, RunsSmallestVariantThatFits) {
+  std::unique_ptr<XlaJitCompiledCpuFunction> batch4 = CompileSum(4);
+  std::unique_ptr<XlaJitCompiledCpuFunction> batch2 = CompileSum(2);
+  XlaBatchedCpuFunction function(
+      {{4, &batch4->StaticData()}, {2, &batch2->StaticData()}});
+  EXPECT_EQ(function.max_batch_size(), 4);
+
+  ASSERT_TRUE(function.set_batch_size(3));
+  EXPECT_EQ(function.padded_batch_size(), 4);
+  const int32 x[3 * kColumns] = {1, 2, 3, 4, 5, 6};
+  const int32 y[3 * kColumns] = {10, 20, 30, 40, 50, 60};
+  function.set_arg_rows(0, x);
+  function.set_arg_rows(1, y);
+  ASSERT_TRUE(function.Run());
+  const int32* sum = static_cast<const int32*>(function.result_data(0));
+  EXPECT_THAT(std::vector<int32>(sum, sum + 4 * kColumns),
+              ::testing::ElementsAre(11, 22, 33, 44, 55, 66, 0, 0));
+
+  ASSERT_TRUE(function.set_batch_size(1));
+  EXPECT_EQ(function.padded_batch_size(), 2);
+  function.set_arg_rows(0, x);
+  function.set_arg_rows(1, y);
+  ASSERT_TRUE(function.Run());
+  sum = static_cast<const int32*>(function.result_data(0));
+  EXPECT_EQ(sum[0], 11);
+  EXPECT_EQ(sum[1], 22);
+}
+
+TEST(XlaBatchedCpuFunctionTest, RejectsBatchesLargerThanVariants) {
+  std::unique_ptr<XlaJitCompiledCpuFunction> batch2 = CompileSum(2);
+  XlaBatchedCpuFunction function({{2, &batch2->StaticData()}});
+  EXPECT_FALSE(function.set_batch_size(3));
+  EXPECT_FALSE(function.set_batch_size(0));
+  EXPECT_TRUE(function.set_batch_size(2));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include <numeric>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "absl/types/variant.h"
 #include "tensorflow/compiler/jit/defs.h"
@@ -61,11 +62,14 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-// Checks that arguments `args` match types `types`.
+// Checks that arguments `args` match types `types`. Pad arguments, which hold
+// the sizes of dynamic dimensions, have no counterpart in `types`.
 Status CheckSignature(const DataTypeVector& types,
                       absl::Span<const XlaCompiler::Argument> args) {
-  if (args.size() != types.size()) {
-    return errors::Internal("Compilation arguments have ", args.size(),
+  const int num_args = absl::c_count_if(
+      args, [](const XlaCompiler::Argument& arg) { return !arg.is_pad_arg; });
+  if (num_args != types.size()) {
+    return errors::Internal("Compilation arguments have ", num_args,
                             " elements while function has ", types.size());
   }
   for (int i = 0, end = types.size(); i < end; ++i) {
@@ -678,7 +682,7 @@ Status XlaCompiler::CompileFunction(
   // Set shapes for _Arg nodes. They are useful for constant folding (e.g. an
   // Xla op requires a compile-time constant input, and that input is shape of
   // an _Arg node.
-  for (int i = 0, end = args.size(); i < end; i++) {
+  for (int i = 0, end = fbody->arg_nodes.size(); i < end; i++) {
     // Skip resource variables and tensor lists.
     DataType dtype;
     TF_RETURN_IF_ERROR(GetNodeAttr(fbody->arg_nodes[i]->def(), "T", &dtype));
@@ -73,6 +73,7 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_gpu_deterministic_reductions(false);
   opts.set_xla_cpu_enable_xprof_traceme(false);
   opts.set_xla_gpu_unsafe_fallback_to_driver_on_ptxas_not_found(false);
+  opts.set_xla_gpu_persistent_cache_max_size_mb(1024);
 
   return opts;
 }
@@ -436,6 +437,70 @@ static void AllocateFlags() {
       string_setter_for(&DebugOptions::set_xla_gpu_asm_extra_flags), "",
       "Pass extra parameters to the GPU assembler tool (i.e., ptxas for CUDA). "
       "If multiple parameters, separate them by comma."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_persistent_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_gpu_persistent_cache_dir),
+      flag_values->xla_gpu_persistent_cache_dir(),
+      "Directory of a cache of the PTX and the GPU binaries compiled by "
+      "XLA:GPU, shared by the processes that use it."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_persistent_cache_max_size_mb",
+      int32_setter_for(
+          &DebugOptions::set_xla_gpu_persistent_cache_max_size_mb),
+      flag_values->xla_gpu_persistent_cache_max_size_mb(),
+      "Maximum size of the directory set by xla_gpu_persistent_cache_dir, in "
+      "megabytes. The oldest entries are deleted when it grows beyond it."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_hlo_pass_threads",
+      int32_setter_for(&DebugOptions::set_xla_hlo_pass_threads),
+      flag_values->xla_hlo_pass_threads(),
+      "Number of threads to run the HLO passes which transform each "
+      "computation independently on, e.g. algsimp, cse and dce. The passes "
+      "run serially if it is 1 or less."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_compilation_parallelism",
+      int32_setter_for(&DebugOptions::set_xla_gpu_compilation_parallelism),
+      flag_values->xla_gpu_compilation_parallelism(),
+      "Number of LLVM modules XLA:GPU splits the module into, to compile them "
+      "in parallel and link the resulting GPU binaries. The module is "
+      "compiled as a whole if it is 1 or less."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_latency_hiding_scheduler",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_enable_latency_hiding_scheduler),
+      flag_values->xla_gpu_enable_latency_hiding_scheduler(),
+      "Run the all-reduces of XLA:GPU programs on a separate stream, and "
+      "order the launches so that compute independent of a pending "
+      "all-reduce overlaps with it."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cost_calibration_dir",
+      string_setter_for(&DebugOptions::set_xla_cost_calibration_dir),
+      flag_values->xla_cost_calibration_dir(),
+      "Directory of HLO execution times measured per device type. Cost "
+      "models prefer measured times to their estimates, and runs profiled "
+      "with --xla_hlo_profile add to the measurements."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Capture the thunks of GPU executables into CUDA graphs on their second "
+      "run with the same buffers, and replay the graphs afterwards."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_autotune_database_path",
+      string_setter_for(&DebugOptions::set_xla_gpu_autotune_database_path),
+      flag_values->xla_gpu_autotune_database_path(),
+      "An AutotuneDatabaseProto file of GEMM and convolution autotuning "
+      "results, keyed by GPU model, library versions and instruction. Results "
+      "in the file are reused and new ones are added to it. Files ending in "
+      ".pbtxt are text protos."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_critical_path_stream_assignment",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_critical_path_stream_assignment),
+      flag_values->xla_gpu_critical_path_stream_assignment(),
+      "Assign GPU streams along the estimated critical path, so that "
+      "independent branches run concurrently. Requires "
+      "--xla_gpu_disable_multi_streaming=false."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_fuel", setter_for_xla_fuel, /*default_value_for_display=*/"",
       "Sets compiler fuel, useful for bisecting bugs in passes.  Format "
@@ -765,11 +765,6 @@ StatusOr<Literal> LiteralBase::Broadcast(
 
   Literal result(result_shape);
 
-  // scratch_source_index is temporary storage space for the computed index into
-  // the input literal.  We put it here to avoid allocating an std::vector in
-  // every iteration of ShapeUtil::ForEachIndex.
-  std::vector<int64> scratch_source_index(shape().dimensions_size());
-
   char* dest_data = static_cast<char*>(result.untyped_data());
   const char* source_data = static_cast<const char*>(untyped_data());
   const int64 primitive_size =
@@ -780,19 +775,30 @@ StatusOr<Literal> LiteralBase::Broadcast(
     result.SetDynamicSize(dimensions[i], dynamic_size);
   }
 
-  ShapeUtil::ForEachIndex(
-      result_shape, [&](absl::Span<const int64> output_index) {
-        for (int64 i = 0, end = dimensions.size(); i < end; ++i) {
-          scratch_source_index[i] = output_index[dimensions[i]];
-        }
-        int64 dest_index = IndexUtil::MultidimensionalIndexToLinearIndex(
-            result_shape, output_index);
-        int64 source_index = IndexUtil::MultidimensionalIndexToLinearIndex(
-            shape(), scratch_source_index);
-        memcpy(dest_data + primitive_size * dest_index,
-               source_data + primitive_size * source_index, primitive_size);
-        return true;
-      });
+  // Walk the elements of the result in their physical order, tracking the
+  // linear index of the source element through the stride of each result
+  // dimension in the source (zero for the broadcast dimensions), rather than
+  // converting a multi-dimensional index per element.
+  const Shape& dest_shape = result.shape();
+  std::vector<int64> source_strides(dest_shape.rank(), 0);
+  for (int64 i = 0, end = dimensions.size(); i < end; ++i) {
+    source_strides[dimensions[i]] = IndexUtil::GetDimensionStride(shape(), i);
+  }
+  std::vector<int64> output_index(dest_shape.rank(), 0);
+  int64 source_index = 0;
+  const int64 num_elements = ShapeUtil::ElementsIn(dest_shape);
+  for (int64 dest_index = 0; dest_index < num_elements; ++dest_index) {
+    memcpy(dest_data + primitive_size * dest_index,
+           source_data + primitive_size * source_index, primitive_size);
+    for (int64 dim : LayoutUtil::MinorToMajor(dest_shape)) {
+      source_index += source_strides[dim];
+      if (++output_index[dim] < dest_shape.dimensions(dim)) {
+        break;
+      }
+      source_index -= source_strides[dim] * dest_shape.dimensions(dim);
+      output_index[dim] = 0;
+    }
+  }
 
   return std::move(result);
 }
@@ -5491,18 +5491,14 @@ Status AlgebraicSimplifierVisitor::HandleMap(HloInstruction* map) {
   return ReplaceWithNewInstruction(map, std::move(clone));
 }
 
-StatusOr<bool> AlgebraicSimplifier::Run(HloModule* module) {
-  XLA_VLOG_LINES(2,
-                 "AlgebraicSimplifier::Run(), before:\n" + module->ToString());
-  bool changed = false;
+StatusOr<bool> AlgebraicSimplifier::RunOnComputation(
+    HloComputation* computation) {
+  XLA_VLOG_LINES(2, "AlgebraicSimplifier::RunOnComputation(), before:\n" +
+                        computation->ToString());
   AlgebraicSimplifierVisitor visitor(options_, this);
-  for (auto* comp : module->MakeNonfusionComputations()) {
-    if (visitor.Run(comp, options_, this)) {
-      changed = true;
-    }
-  }
-  XLA_VLOG_LINES(2,
-                 "AlgebraicSimplifier::Run(), after:\n" + module->ToString());
+  bool changed = visitor.Run(computation, options_, this);
+  XLA_VLOG_LINES(2, "AlgebraicSimplifier::RunOnComputation(), after:\n" +
+                        computation->ToString());
   return changed;
 }
 
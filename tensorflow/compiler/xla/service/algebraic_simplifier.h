@@ -175,7 +175,7 @@ class AlgebraicSimplifierOptions {
 };
 
 // A pass which performs algebraic simplifications.
-class AlgebraicSimplifier : public HloModulePass {
+class AlgebraicSimplifier : public HloComputationPass {
  public:
   // If is_layout_sensitive is true, then the simplifier preserves layout during
   // transformation. Otherwise, layout is ignored.
@@ -186,7 +186,7 @@ class AlgebraicSimplifier : public HloModulePass {
 
   // Run algebraic simplification on the given computation. Returns whether the
   // computation was changed.
-  StatusOr<bool> Run(HloModule* module) override;
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override;
 
   // Create constant from literal with tiles and element size updated in the
   // constant's layout.
@@ -197,6 +197,11 @@ class AlgebraicSimplifier : public HloModulePass {
     return constant;
   }
 
+ protected:
+  std::vector<HloComputation*> ComputationsToRun(HloModule* module) override {
+    return module->MakeNonfusionComputations();
+  }
+
  private:
   AlgebraicSimplifierOptions options_;
 };
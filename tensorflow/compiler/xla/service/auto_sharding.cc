@@ -0,0 +1,462 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/auto_sharding.h"
+
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/array.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+namespace {
+
+// A candidate sharding of an instruction.
+struct Candidate {
+  // The dimension of the instruction split along each axis of the device mesh,
+  // or -1 if the instruction is replicated along the axis.
+  std::vector<int64> axis_to_dim;
+  HloSharding sharding;
+  // The number of distinct pieces the instruction is split into.
+  int64 num_shards;
+};
+
+// An instruction whose sharding is being planned.
+struct Node {
+  HloInstruction* instruction;
+  std::vector<Candidate> candidates;
+  // The time each candidate leaves the instruction to compute on a device.
+  std::vector<double> compute_times;
+  int64 bytes;
+  int64 chosen = 0;
+};
+
+// An operand of a planned dot or convolution.
+struct Edge {
+  int64 consumer;
+  // The planned node the operand inherits its sharding from, or -1 if its
+  // sharding is fixed to `fixed_sharding`.
+  int64 source;
+  HloSharding fixed_sharding;
+  int64 fixed_num_shards;
+  int64 bytes;
+  // The sharding the consumer needs the operand in, for each of its
+  // candidates.
+  std::vector<HloSharding> required;
+};
+
+// Returns the sharding that splits dimension `axis_to_dim[a]` of an array of
+// the given rank along axis `a` of `mesh_shape`, and replicates the array
+// along the axes where `axis_to_dim` is -1.
+HloSharding MeshSharding(int64 rank, absl::Span<const int64> axis_to_dim,
+                         absl::Span<const int64> mesh_shape) {
+  std::vector<int64> tile_dims(rank, 1);
+  int64 num_replicas = 1;
+  int64 num_devices = 1;
+  for (int64 axis = 0; axis < mesh_shape.size(); ++axis) {
+    num_devices *= mesh_shape[axis];
+    if (axis_to_dim[axis] >= 0) {
+      tile_dims[axis_to_dim[axis]] *= mesh_shape[axis];
+    } else {
+      num_replicas *= mesh_shape[axis];
+    }
+  }
+  if (num_replicas == num_devices) {
+    return HloSharding::Replicate();
+  }
+  const bool partially_replicated = num_replicas > 1;
+  if (partially_replicated) {
+    tile_dims.push_back(num_replicas);
+  }
+  Array<int64> tile_assignment(tile_dims);
+  std::vector<int64> mesh_index(mesh_shape.size());
+  std::vector<int64> tile_index(tile_dims.size());
+  for (int64 device = 0; device < num_devices; ++device) {
+    int64 remainder = device;
+    for (int64 axis = mesh_shape.size() - 1; axis >= 0; --axis) {
+      mesh_index[axis] = remainder % mesh_shape[axis];
+      remainder /= mesh_shape[axis];
+    }
+    // Axes splitting the same dimension (or replicating) nest in mesh order.
+    absl::c_fill(tile_index, 0);
+    for (int64 axis = 0; axis < mesh_shape.size(); ++axis) {
+      const int64 dim =
+          axis_to_dim[axis] >= 0 ? axis_to_dim[axis] : tile_dims.size() - 1;
+      tile_index[dim] = tile_index[dim] * mesh_shape[axis] + mesh_index[axis];
+    }
+    tile_assignment(tile_index) = device;
+  }
+  return partially_replicated ? HloSharding::PartialTile(tile_assignment)
+                              : HloSharding::Tile(tile_assignment);
+}
+
+// Returns the shardings of `shape` that split each axis of `mesh_shape` along
+// one of `shardable_dims` or replicate along it, replicated first. A
+// dimension may be split along several axes if its size allows.
+std::vector<Candidate> EnumerateCandidates(
+    const Shape& shape, absl::Span<const int64> shardable_dims,
+    absl::Span<const int64> mesh_shape) {
+  std::vector<Candidate> candidates;
+  std::vector<int64> axis_to_dim(mesh_shape.size(), -1);
+  std::vector<int64> dim_shards(shape.rank(), 1);
+  std::function<void(int64)> enumerate = [&](int64 axis) {
+    if (axis == mesh_shape.size()) {
+      candidates.push_back(
+          Candidate{axis_to_dim,
+                    MeshSharding(shape.rank(), axis_to_dim, mesh_shape),
+                    Product(dim_shards)});
+      return;
+    }
+    enumerate(axis + 1);
+    if (mesh_shape[axis] == 1) {
+      return;
+    }
+    for (int64 dim : shardable_dims) {
+      if (shape.dimensions(dim) % (dim_shards[dim] * mesh_shape[axis]) != 0) {
+        continue;
+      }
+      axis_to_dim[axis] = dim;
+      dim_shards[dim] *= mesh_shape[axis];
+      enumerate(axis + 1);
+      dim_shards[dim] /= mesh_shape[axis];
+      axis_to_dim[axis] = -1;
+    }
+  };
+  enumerate(0);
+  return candidates;
+}
+
+// Sets `shardable_dims` to the dimensions of `hlo` that may be split without
+// communication within `hlo` itself, and `operand_dims[i][d]` to the
+// dimension of operand i that dimension d of `hlo` is computed from, or -1 if
+// there is none. Returns false if `hlo` is not a kind of instruction that is
+// planned.
+bool GetDimensionMapping(const HloInstruction* hlo,
+                         std::vector<int64>* shardable_dims,
+                         std::vector<std::vector<int64>>* operand_dims) {
+  const int64 rank = hlo->shape().rank();
+  switch (hlo->opcode()) {
+    case HloOpcode::kParameter:
+      for (int64 dim = 0; dim < rank; ++dim) {
+        shardable_dims->push_back(dim);
+      }
+      return true;
+    case HloOpcode::kDot: {
+      // The dimensions of a dot are its batch dimensions followed by the free
+      // dimensions of the lhs and then those of the rhs.
+      const DotDimensionNumbers& dnums = hlo->dot_dimension_numbers();
+      std::vector<int64> lhs_dims(rank, -1);
+      std::vector<int64> rhs_dims(rank, -1);
+      int64 dim = 0;
+      for (int64 i = 0; i < dnums.lhs_batch_dimensions_size(); ++i, ++dim) {
+        lhs_dims[dim] = dnums.lhs_batch_dimensions(i);
+        rhs_dims[dim] = dnums.rhs_batch_dimensions(i);
+      }
+      for (int64 i = 0; i < hlo->operand(0)->shape().rank(); ++i) {
+        if (!absl::c_linear_search(dnums.lhs_batch_dimensions(), i) &&
+            !absl::c_linear_search(dnums.lhs_contracting_dimensions(), i)) {
+          lhs_dims[dim++] = i;
+        }
+      }
+      for (int64 i = 0; i < hlo->operand(1)->shape().rank(); ++i) {
+        if (!absl::c_linear_search(dnums.rhs_batch_dimensions(), i) &&
+            !absl::c_linear_search(dnums.rhs_contracting_dimensions(), i)) {
+          rhs_dims[dim++] = i;
+        }
+      }
+      if (dim != rank) {
+        return false;
+      }
+      for (dim = 0; dim < rank; ++dim) {
+        shardable_dims->push_back(dim);
+      }
+      operand_dims->push_back(std::move(lhs_dims));
+      operand_dims->push_back(std::move(rhs_dims));
+      return true;
+    }
+    case HloOpcode::kConvolution: {
+      // Splitting the spatial dimensions would need halo exchanges, and
+      // grouped convolutions mix the batch or feature dimensions, so only the
+      // batch and output feature dimensions of ungrouped ones are split.
+      const ConvolutionDimensionNumbers& dnums =
+          hlo->convolution_dimension_numbers();
+      std::vector<int64> lhs_dims(rank, -1);
+      std::vector<int64> rhs_dims(rank, -1);
+      if (hlo->batch_group_count() == 1) {
+        shardable_dims->push_back(dnums.output_batch_dimension());
+        lhs_dims[dnums.output_batch_dimension()] =
+            dnums.input_batch_dimension();
+        if (hlo->feature_group_count() == 1) {
+          shardable_dims->push_back(dnums.output_feature_dimension());
+          rhs_dims[dnums.output_feature_dimension()] =
+              dnums.kernel_output_feature_dimension();
+        }
+      }
+      operand_dims->push_back(std::move(lhs_dims));
+      operand_dims->push_back(std::move(rhs_dims));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Returns the number of distinct pieces `sharding` splits an array into.
+int64 NumShards(const HloSharding& sharding) {
+  if (sharding.IsTileMaximal()) {
+    return 1;
+  }
+  int64 num_shards = sharding.tile_assignment().num_elements();
+  if (sharding.ReplicateOnLastTileDim()) {
+    num_shards /= sharding.tile_assignment().dimensions().back();
+  }
+  return num_shards;
+}
+
+// Returns the number of bytes each device receives to reshard an array of
+// `bytes` bytes from `from`, split into `from_shards` pieces, to `to`.
+double ReshardBytes(int64 bytes, const HloSharding& from, int64 from_shards,
+                    const HloSharding& to) {
+  if (from == to || from.IsReplicated()) {
+    // Nothing to do, or each device slices out its piece locally.
+    return 0;
+  }
+  if (from.IsTileMaximal()) {
+    // Broadcast from the device holding the array.
+    return bytes;
+  }
+  // Gather the pieces held by the other devices, and keep the part `to` needs.
+  return bytes * (1.0 - 1.0 / from_shards);
+}
+
+}  // namespace
+
+StatusOr<bool> AutoSharding::Run(HloModule* module) {
+  const std::vector<int64>& mesh_shape = options_.device_mesh_shape;
+  if (Product(mesh_shape) <= 1) {
+    return false;
+  }
+  HloComputation* entry = module->entry_computation();
+  HloCostAnalysis cost_analysis(shape_size_);
+  TF_RETURN_IF_ERROR(entry->Accept(&cost_analysis));
+
+  std::vector<Node> nodes;
+  std::vector<std::vector<std::vector<int64>>> node_operand_dims;
+  absl::flat_hash_map<const HloInstruction*, int64> node_index;
+  for (HloInstruction* hlo : entry->MakeInstructionPostOrder()) {
+    if (hlo->has_sharding() || !hlo->shape().IsArray()) {
+      continue;
+    }
+    const int64 bytes = shape_size_(hlo->shape());
+    if (hlo->opcode() == HloOpcode::kParameter &&
+        bytes < options_.min_parameter_bytes) {
+      continue;
+    }
+    std::vector<int64> shardable_dims;
+    std::vector<std::vector<int64>> operand_dims;
+    if (!GetDimensionMapping(hlo, &shardable_dims, &operand_dims)) {
+      continue;
+    }
+    Node node;
+    node.instruction = hlo;
+    node.bytes = bytes;
+    node.candidates =
+        EnumerateCandidates(hlo->shape(), shardable_dims, mesh_shape);
+    for (const Candidate& candidate : node.candidates) {
+      node.compute_times.push_back(cost_analysis.flop_count(*hlo) /
+                                   static_cast<double>(candidate.num_shards) /
+                                   options_.flops_per_second);
+    }
+    node_index[hlo] = nodes.size();
+    nodes.push_back(std::move(node));
+    node_operand_dims.push_back(std::move(operand_dims));
+  }
+  if (nodes.empty()) {
+    return false;
+  }
+
+  // Returns the instruction `hlo` inherits its sharding from under sharding
+  // propagation, looking through elementwise unary ops.
+  auto sharding_source = [&](const HloInstruction* hlo) {
+    while (!node_index.contains(hlo) && !hlo->has_sharding() &&
+           hlo->IsElementwise() && hlo->operand_count() == 1 &&
+           ShapeUtil::SameDimensions(hlo->shape(), hlo->operand(0)->shape())) {
+      hlo = hlo->operand(0);
+    }
+    return hlo;
+  };
+
+  std::vector<Edge> edges;
+  std::vector<std::vector<int64>> consumer_edges(nodes.size());
+  std::vector<std::vector<int64>> source_edges(nodes.size());
+  for (int64 n = 0; n < nodes.size(); ++n) {
+    const HloInstruction* hlo = nodes[n].instruction;
+    for (int64 i = 0; i < node_operand_dims[n].size(); ++i) {
+      const HloInstruction* operand = hlo->operand(i);
+      const HloInstruction* source = sharding_source(operand);
+      auto it = node_index.find(source);
+      HloSharding fixed_sharding = source->has_sharding()
+                                       ? source->sharding()
+                                       : HloSharding::Replicate();
+      Edge edge{n,
+                it == node_index.end() ? -1 : it->second,
+                fixed_sharding,
+                NumShards(fixed_sharding),
+                shape_size_(operand->shape()),
+                {}};
+      for (const Candidate& candidate : nodes[n].candidates) {
+        std::vector<int64> axis_to_operand_dim(mesh_shape.size(), -1);
+        for (int64 axis = 0; axis < mesh_shape.size(); ++axis) {
+          if (candidate.axis_to_dim[axis] >= 0) {
+            axis_to_operand_dim[axis] =
+                node_operand_dims[n][i][candidate.axis_to_dim[axis]];
+          }
+        }
+        edge.required.push_back(MeshSharding(
+            operand->shape().rank(), axis_to_operand_dim, mesh_shape));
+      }
+      consumer_edges[n].push_back(edges.size());
+      if (edge.source >= 0) {
+        source_edges[edge.source].push_back(edges.size());
+      }
+      edges.push_back(std::move(edge));
+    }
+  }
+
+  auto edge_time = [&](const Edge& edge, int64 consumer_choice,
+                       int64 source_choice) {
+    const HloSharding& required = edge.required[consumer_choice];
+    if (edge.source < 0) {
+      return ReshardBytes(edge.bytes, edge.fixed_sharding,
+                          edge.fixed_num_shards, required) /
+             options_.bytes_per_second;
+    }
+    const Candidate& source = nodes[edge.source].candidates[source_choice];
+    return ReshardBytes(edge.bytes, source.sharding, source.num_shards,
+                        required) /
+           options_.bytes_per_second;
+  };
+  // Returns the cost of node n and of its edges if it took candidate c, with
+  // its neighbors keeping their current choices.
+  auto local_cost = [&](int64 n, int64 c) {
+    double cost = nodes[n].compute_times[c];
+    for (int64 e : consumer_edges[n]) {
+      const Edge& edge = edges[e];
+      cost += edge_time(edge, c,
+                        edge.source < 0 ? 0 : nodes[edge.source].chosen);
+    }
+    for (int64 e : source_edges[n]) {
+      cost += edge_time(edges[e], nodes[edges[e].consumer].chosen, c);
+    }
+    return cost;
+  };
+
+  // Iteratively move each node to its cheapest candidate given the choices of
+  // its neighbors, preferring candidates with more shards on ties so that
+  // parameters follow the shardings their consumers need.
+  for (int64 iteration = 0; iteration < options_.max_iterations; ++iteration) {
+    bool changed = false;
+    for (int64 n = 0; n < nodes.size(); ++n) {
+      Node& node = nodes[n];
+      int64 best = node.chosen;
+      double best_cost = local_cost(n, best);
+      for (int64 c = 0; c < node.candidates.size(); ++c) {
+        const double cost = local_cost(n, c);
+        if (cost < best_cost ||
+            (cost == best_cost && node.candidates[c].num_shards >
+                                      node.candidates[best].num_shards)) {
+          best = c;
+          best_cost = cost;
+        }
+      }
+      if (best != node.chosen) {
+        node.chosen = best;
+        changed = true;
+      }
+    }
+    if (!changed) {
+      break;
+    }
+  }
+
+  // Shard parameters further until they fit the memory budget, picking each
+  // time the move that costs the least time per byte saved.
+  auto per_device_bytes = [&](int64 n, int64 c) {
+    return CeilOfRatio(nodes[n].bytes, nodes[n].candidates[c].num_shards);
+  };
+  if (options_.memory_budget_per_device > 0) {
+    int64 total_bytes = 0;
+    for (int64 n = 0; n < nodes.size(); ++n) {
+      if (nodes[n].instruction->opcode() == HloOpcode::kParameter) {
+        total_bytes += per_device_bytes(n, nodes[n].chosen);
+      }
+    }
+    while (total_bytes > options_.memory_budget_per_device) {
+      int64 best_node = -1;
+      int64 best_candidate = -1;
+      double best_ratio = std::numeric_limits<double>::infinity();
+      for (int64 n = 0; n < nodes.size(); ++n) {
+        if (nodes[n].instruction->opcode() != HloOpcode::kParameter) {
+          continue;
+        }
+        const double current_cost = local_cost(n, nodes[n].chosen);
+        const int64 current_bytes = per_device_bytes(n, nodes[n].chosen);
+        for (int64 c = 0; c < nodes[n].candidates.size(); ++c) {
+          const int64 saved_bytes = current_bytes - per_device_bytes(n, c);
+          if (saved_bytes <= 0) {
+            continue;
+          }
+          const double ratio = (local_cost(n, c) - current_cost) / saved_bytes;
+          if (ratio < best_ratio) {
+            best_node = n;
+            best_candidate = c;
+            best_ratio = ratio;
+          }
+        }
+      }
+      if (best_node < 0) {
+        return ResourceExhausted(
+            "Entry parameters of %s need %d bytes per device when sharded as "
+            "much as possible, over the budget of %d bytes",
+            module->name(), total_bytes, options_.memory_budget_per_device);
+      }
+      total_bytes -= per_device_bytes(best_node, nodes[best_node].chosen) -
+                     per_device_bytes(best_node, best_candidate);
+      nodes[best_node].chosen = best_candidate;
+    }
+  }
+
+  for (const Node& node : nodes) {
+    const HloSharding& sharding = node.candidates[node.chosen].sharding;
+    VLOG(2) << "Auto-sharding " << node.instruction->name() << " as "
+            << sharding.ToString();
+    node.instruction->set_sharding(sharding);
+  }
+  return true;
+}
+
+}  // namespace xla
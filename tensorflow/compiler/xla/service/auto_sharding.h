@@ -0,0 +1,81 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_AUTO_SHARDING_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_AUTO_SHARDING_H_
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+struct AutoShardingOptions {
+  // The shape of the device mesh. Devices are numbered in row-major order of
+  // the mesh, so e.g. {2, 4} places devices 0-3 on the first row.
+  std::vector<int64> device_mesh_shape;
+
+  // The number of bytes of entry parameters each device may hold, or 0 for no
+  // limit.
+  int64 memory_budget_per_device = 0;
+
+  // Entry parameters smaller than this are not planned, and are left to
+  // sharding propagation.
+  int64 min_parameter_bytes = 1 << 20;
+
+  // The compute throughput of a device and the per-device bandwidth of
+  // collectives, used to weigh the compute saved by a sharding against the
+  // communication it needs.
+  double flops_per_second = 1e12;
+  double bytes_per_second = 1e10;
+
+  // The maximum number of rounds of the local search.
+  int64 max_iterations = 10;
+};
+
+// Chooses shardings for the dots, convolutions and large parameters of the
+// entry computation that have none, so that models can be partitioned by the
+// SPMD partitioner without hand annotation.
+//
+// Each of these instructions gets candidate shardings that split some of its
+// dimensions along the axes of the device mesh. A candidate is costed by the
+// flops it leaves on each device, from HloCostAnalysis, plus the size of the
+// collectives needed to bring the operands of dots and convolutions to the
+// shardings it requires. A local search then looks for the cheapest
+// assignment, after which the most cost-effective parameters are sharded
+// further until they fit the memory budget. The chosen shardings are set on
+// the instructions; run ShardingPropagation afterwards to shard the rest of
+// the module. Existing sharding annotations are kept and taken into account.
+class AutoSharding : public HloModulePass {
+ public:
+  AutoSharding(const HloCostAnalysis::ShapeSizeFunction& shape_size,
+               AutoShardingOptions options)
+      : shape_size_(shape_size), options_(std::move(options)) {}
+
+  absl::string_view name() const override { return "auto-sharding"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  HloCostAnalysis::ShapeSizeFunction shape_size_;
+  AutoShardingOptions options_;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_AUTO_SHARDING_H_
@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/auto_sharding.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace {
+
+class AutoShardingTest : public HloTestBase {
+ protected:
+  StatusOr<bool> RunAutoSharding(HloModule* module,
+                                 std::vector<int64> device_mesh_shape,
+                                 int64 memory_budget_per_device = 0) {
+    AutoShardingOptions options;
+    options.device_mesh_shape = std::move(device_mesh_shape);
+    options.memory_budget_per_device = memory_budget_per_device;
+    options.min_parameter_bytes = 0;
+    return AutoSharding(
+               [](const Shape& shape) {
+                 return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+               },
+               options)
+        .Run(module);
+  }
+};
+
+constexpr char kMatmul[] = R"(
+HloModule module
+ENTRY %matmul {
+  %param0 = f32[64,128]{1,0} parameter(0)
+  %param1 = f32[128,256]{1,0} parameter(1)
+  ROOT %dot = f32[64,256]{1,0} dot(%param0, %param1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+})";
+
+TEST_F(AutoShardingTest, ShardsDotAlongLhsRows) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kMatmul));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), {4}));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(FindInstruction(module.get(), "dot"),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "param0"),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "param1"),
+              op::Sharding("{replicated}"));
+}
+
+TEST_F(AutoShardingTest, SingleDeviceIsUnchanged) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kMatmul));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), {1}));
+  EXPECT_FALSE(changed);
+  EXPECT_FALSE(FindInstruction(module.get(), "dot")->has_sharding());
+}
+
+TEST_F(AutoShardingTest, ShardsParametersToFitMemoryBudget) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kMatmul));
+  // param0 and param1 take 8KB and 128KB per device when only the dot's rows
+  // are split.
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunAutoSharding(module.get(), {4}, /*memory_budget_per_device=*/100000));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(FindInstruction(module.get(), "param0"),
+              op::Sharding("{devices=[4,1]0,1,2,3}"));
+  EXPECT_FALSE(
+      FindInstruction(module.get(), "param1")->sharding().IsReplicated());
+}
+
+TEST_F(AutoShardingTest, FailsWhenMemoryBudgetCannotBeMet) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kMatmul));
+  EXPECT_FALSE(
+      RunAutoSharding(module.get(), {4}, /*memory_budget_per_device=*/1).ok());
+}
+
+TEST_F(AutoShardingTest, KeepsUserAnnotations) {
+  const char* const hlo_string = R"(
+HloModule module
+ENTRY %matmul {
+  %param0 = f32[64,128]{1,0} parameter(0), sharding={devices=[1,4]0,1,2,3}
+  %param1 = f32[128,256]{1,0} parameter(1)
+  ROOT %dot = f32[64,256]{1,0} dot(%param0, %param1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), {4}));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(FindInstruction(module.get(), "param0"),
+              op::Sharding("{devices=[1,4]0,1,2,3}"));
+  EXPECT_TRUE(FindInstruction(module.get(), "dot")->has_sharding());
+}
+
+TEST_F(AutoShardingTest, ShardsBatchDotOnTwoDimensionalMesh) {
+  const char* const hlo_string = R"(
+HloModule module
+ENTRY %batch_matmul {
+  %param0 = f32[8,64,128]{2,1,0} parameter(0)
+  %param1 = f32[8,128,32]{2,1,0} parameter(1)
+  ROOT %dot = f32[8,64,32]{2,1,0} dot(%param0, %param1),
+    lhs_batch_dims={0}, rhs_batch_dims={0},
+    lhs_contracting_dims={2}, rhs_contracting_dims={1}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunAutoSharding(module.get(), {2, 2}));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(FindInstruction(module.get(), "dot"),
+              op::Sharding("{devices=[4,1,1]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "param0"),
+              op::Sharding("{devices=[4,1,1]0,1,2,3}"));
+  EXPECT_THAT(FindInstruction(module.get(), "param1"),
+              op::Sharding("{devices=[4,1,1]0,1,2,3}"));
+}
+
+}  // namespace
+}  // namespace xla
@@ -1369,9 +1369,11 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
 
       TF_ASSIGN_OR_RETURN(
           HeapSimulator::Result<HloValue> result,
-          HeapSimulator::Run(
-              get_heap_algorithm(alignment), assignment->module(), schedule,
-              assignment->alias_analysis(), assignment->buffer_size_, options));
+          HeapSimulator::Run(get_heap_algorithm(alignment),
+                             assignment->module(), schedule,
+                             assignment->alias_analysis(),
+                             assignment->hlo_live_range(),
+                             assignment->buffer_size_, options));
       AssignBuffersFromHeapSimulator(result, assignment,
                                      single_colored_set.first);
     }
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <string>
@@ -44,6 +45,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -2707,5 +2709,48 @@ ENTRY entry_computation {
   EXPECT_EQ(dus9_alloc_slice.allocation(), dus5_alloc_slice.allocation());
   EXPECT_EQ(dus9_alloc_slice, dus5_alloc_slice);
 }
+
+void BM_SequentialBufferAssignment(int num_iters, int num_adds) {
+  // This benchmark assigns buffers to a sequentially scheduled chain of adds,
+  // each of which also reads a value from a few steps back so that many
+  // buffers are live at once. Whole-module heap simulation is run for it.
+  tensorflow::testing::StopTiming();
+  constexpr int kWindow = 16;
+  const Shape shape = ShapeUtil::MakeShape(F32, {1024});
+  auto size_fn = [](const BufferValue& buffer) {
+    return ShapeUtil::ByteSizeOf(buffer.shape(), sizeof(void*));
+  };
+  for (int i = 0; i < num_iters; ++i) {
+    auto module = absl::make_unique<HloModule>("BM_SequentialBufferAssignment",
+                                               HloModuleConfig());
+    auto builder = HloComputation::Builder("BM_SequentialBufferAssignment");
+    std::vector<HloInstruction*> values = {builder.AddInstruction(
+        HloInstruction::CreateParameter(0, shape, "param"))};
+    for (int j = 1; j <= num_adds; ++j) {
+      values.push_back(builder.AddInstruction(HloInstruction::CreateBinary(
+          shape, HloOpcode::kAdd, values[j - 1],
+          values[std::max(0, j - kWindow)])));
+    }
+    HloComputation* computation = module->AddEntryComputation(builder.Build());
+    HloSchedule schedule(module.get());
+    schedule.set_sequence(computation,
+                          computation->MakeInstructionPostOrder());
+    tensorflow::testing::StartTiming();
+    ASSERT_IS_OK(BufferAssigner::Run(
+                     module.get(),
+                     absl::make_unique<SequentialHloOrdering>(schedule),
+                     size_fn, [](LogicalBuffer::Color) { return 1; },
+                     /*allocate_buffers_for_constants=*/true)
+                     .status());
+    tensorflow::testing::StopTiming();
+  }
+}
+
+BENCHMARK(BM_SequentialBufferAssignment)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Arg(16384)
+    ->Arg(65536);
+
 }  // namespace
 }  // namespace xla
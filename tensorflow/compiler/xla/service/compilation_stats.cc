@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/compilation_stats.h"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_format.h"
@@ -35,7 +37,12 @@ class NoopStats : public CompilationStats {
 
   void EndPass(absl::string_view pass_name) override {}
 
+  void RecordInstructionCounts(absl::string_view pass_name, int64 before,
+                               int64 after) override {}
+
   void CompilationReport() override {}
+
+  CompilationStatsProto ToProto() override { return {}; }
 };
 
 class Stats : public CompilationStats {
@@ -46,8 +53,13 @@ class Stats : public CompilationStats {
 
   void EndPass(absl::string_view pass_name) override;
 
+  void RecordInstructionCounts(absl::string_view pass_name, int64 before,
+                               int64 after) override;
+
   void CompilationReport() override;
 
+  CompilationStatsProto ToProto() override;
+
  private:
   struct PassInfo {
     PassInfo(absl::string_view name, double duration)
@@ -56,6 +68,8 @@ class Stats : public CompilationStats {
     absl::string_view name;
     int num_runs = 1;
     double duration_ms;
+    int64 max_instructions = 0;
+    int64 instruction_delta = 0;
   };
 
   // Info about the passes that have been run so far.
@@ -65,6 +79,9 @@ class Stats : public CompilationStats {
   absl::string_view current_pass_;
   // The start time of the currently running pass.
   uint64 start_micros_;
+  // The instruction counts recorded for the currently running pass.
+  int64 instructions_before_ = 0;
+  int64 instructions_after_ = 0;
 };
 
 /* static */
@@ -82,6 +99,8 @@ void Stats::StartPass(absl::string_view pass_name) {
                         << current_pass_;
   pass_running_ = true;
   current_pass_ = pass_name;
+  instructions_before_ = 0;
+  instructions_after_ = 0;
   start_micros_ = tensorflow::Env::Default()->NowMicros();
 }
 
@@ -92,9 +111,19 @@ void Stats::EndPass(absl::string_view pass_name) {
   uint64 end_micros = tensorflow::Env::Default()->NowMicros();
   double duration_ms = (end_micros - start_micros_) / 1000.0;
   passes_.push_back(PassInfo(current_pass_, duration_ms));
+  passes_.back().max_instructions = instructions_before_;
+  passes_.back().instruction_delta = instructions_after_ - instructions_before_;
 }
 
-void Stats::CompilationReport() {
+void Stats::RecordInstructionCounts(absl::string_view pass_name, int64 before,
+                                    int64 after) {
+  CHECK(pass_running_);
+  CHECK_EQ(current_pass_, pass_name);
+  instructions_before_ = before;
+  instructions_after_ = after;
+}
+
+CompilationStatsProto Stats::ToProto() {
   CHECK(!pass_running_) << "EndPass never called for " << current_pass_;
   absl::flat_hash_map<absl::string_view, PassInfo> summary;
   double total_duration = 0;
@@ -106,8 +135,12 @@ void Stats::CompilationReport() {
     if (it == summary.end()) {
       summary.insert(std::make_pair(pass_name, pass_run));
     } else {
-      ++summary.at(pass_name).num_runs;
-      summary.at(pass_name).duration_ms += pass_run.duration_ms;
+      PassInfo& info = it->second;
+      ++info.num_runs;
+      info.duration_ms += pass_run.duration_ms;
+      info.max_instructions =
+          std::max(info.max_instructions, pass_run.max_instructions);
+      info.instruction_delta += pass_run.instruction_delta;
     }
   }
 
@@ -121,11 +154,30 @@ void Stats::CompilationReport() {
     return std::make_pair(b.duration_ms, a.name) <
            std::make_pair(a.duration_ms, b.name);
   });
-  LOG(INFO) << "Total runtime (ms) of HLO passes: " << total_duration;
-  LOG(INFO) << "Pass name, num runs, time (ms)";
-  for (auto& pass_info : sorted_summary) {
-    LOG(INFO) << pass_info.name << ", " << pass_info.num_runs << ", "
-              << pass_info.duration_ms;
+
+  CompilationStatsProto proto;
+  proto.set_total_duration_ms(total_duration);
+  for (const PassInfo& pass_info : sorted_summary) {
+    CompilationStatsProto::PassStats* pass = proto.add_passes();
+    pass->set_name(std::string(pass_info.name));
+    pass->set_num_runs(pass_info.num_runs);
+    pass->set_duration_ms(pass_info.duration_ms);
+    pass->set_max_instructions(pass_info.max_instructions);
+    pass->set_instruction_delta(pass_info.instruction_delta);
+  }
+  return proto;
+}
+
+void Stats::CompilationReport() {
+  CompilationStatsProto proto = ToProto();
+  LOG(INFO) << "Total runtime (ms) of HLO passes: "
+            << proto.total_duration_ms();
+  LOG(INFO) << "Pass name, num runs, time (ms), max instructions, "
+               "instruction delta";
+  for (const auto& pass : proto.passes()) {
+    LOG(INFO) << pass.name() << ", " << pass.num_runs() << ", "
+              << pass.duration_ms() << ", " << pass.max_instructions() << ", "
+              << pass.instruction_delta();
   }
 }
 
@@ -20,14 +20,16 @@ limitations under the License.
 #include <string>
 
 #include "absl/strings/str_format.h"
+#include "tensorflow/compiler/xla/service/compilation_stats.pb.h"
+#include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
 
 // This class is used to collect information about HLO passes and print some
 // statistics at the end of compilation. From HloPassPipeline, we call StartPass
-// before the execution of a pass, and EndPass after. Currently, we only collect
-// timing information and how many times each pass was run. In the future, we
-// can add more things, such as the size of the HLO graph after each pass.
+// before the execution of a pass, and EndPass after. We collect timing
+// information, how many times each pass was run, and the number of HLO
+// instructions before and after each run.
 class CompilationStats {
  public:
   virtual ~CompilationStats() = default;
@@ -40,7 +42,15 @@ class CompilationStats {
 
   virtual void EndPass(absl::string_view pass_name) = 0;
 
+  // Records the number of instructions of the HLO before and after the running
+  // pass. Must be called between StartPass and EndPass.
+  virtual void RecordInstructionCounts(absl::string_view pass_name,
+                                       int64 before, int64 after) = 0;
+
   virtual void CompilationReport() = 0;
+
+  // Returns the statistics of the passes that have been run so far.
+  virtual CompilationStatsProto ToProto() = 0;
 };
 
 }  // namespace xla
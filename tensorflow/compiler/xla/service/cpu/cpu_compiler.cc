@@ -29,6 +29,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/Function.h"
@@ -258,6 +259,19 @@ class CollectProfileCandidates : public DfsHloVisitorWithDefault {
   const std::unordered_map<const HloInstruction*, int64>& assigned_indices_;
 };
 
+// The matrix-matrix product of a GEMM epilogue fusion is written to the
+// output of the fusion before the epilogue reads the other operands, so none
+// of them may share the output buffer.
+absl::optional<bool> CanShareBufferHint(const HloInstruction* user,
+                                        const HloInstruction* operand,
+                                        const ShapeIndex& user_index) {
+  if (user->opcode() == HloOpcode::kFusion &&
+      GetGemmEpilogueFusionDot(*user) != nullptr) {
+    return false;
+  }
+  return absl::nullopt;
+}
+
 }  // namespace
 
 Status CpuCompiler::RunHloPassesThroughLayoutAssn(
@@ -419,7 +433,7 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   // before (and sometime after) copy insertion, to avoid dead code from
   // interfering with the rewrites.
   pipeline.AddPass<HloDCE>();
-  pipeline.AddPass<CopyInsertion>();
+  pipeline.AddPass<CopyInsertion>(&CanShareBufferHint);
   pipeline.AddPass<HloDCE>();
   return pipeline.Run(module).status();
 }
@@ -578,7 +592,9 @@ CpuCompiler::RunHloPassesAndBufferAssignement(
       BufferAssigner::Run(module.get(),
                           absl::make_unique<SequentialHloOrdering>(schedule),
                           BufferSizeBytesFunction(), memory_alignment,
-                          /*allocate_buffers_for_constants=*/true));
+                          /*allocate_buffers_for_constants=*/true,
+                          BufferAssigner::DefaultColorer(),
+                          /*must_not_live_out=*/{}, &CanShareBufferHint));
 
   return std::make_tuple(std::move(module), std::move(assignment));
 }
@@ -688,7 +704,9 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       BufferAssigner::Run(module.get(),
                           absl::make_unique<SequentialHloOrdering>(schedule),
                           BufferSizeBytesFunction(), memory_alignment,
-                          /*allocate_buffers_for_constants=*/true));
+                          /*allocate_buffers_for_constants=*/true,
+                          BufferAssigner::DefaultColorer(),
+                          /*must_not_live_out=*/{}, &CanShareBufferHint));
   DumpHloModuleIfEnabled(*module, *assignment, "after_optimizations");
 
   // Each computation is a single function.  Emit all embedded computations
@@ -882,7 +900,9 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
         BufferAssigner::Run(module,
                             absl::make_unique<SequentialHloOrdering>(schedule),
                             BufferSizeBytesFunction(), memory_alignment,
-                            /*allocate_buffers_for_constants=*/true));
+                            /*allocate_buffers_for_constants=*/true,
+                            BufferAssigner::DefaultColorer(),
+                            /*must_not_live_out=*/{}, &CanShareBufferHint));
     // BufferAssignment::ToString() includes a header, so no need for us to
     // print one ourselves.
     if (DumpingEnabledForHloModule(*module)) {
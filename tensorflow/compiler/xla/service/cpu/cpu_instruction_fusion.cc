@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
+#include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/fusion_node_indexing_evaluation.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
 
@@ -61,6 +65,55 @@ bool CanBeOutputFused(const HloInstruction* producer,
          HasExactlyOneUse(*producer) == 1;
 }
 
+// Returns whether `consumer` can be emitted as the epilogue of the
+// matrix-matrix product `dot`: the product is computed into the output of the
+// fusion and updated in place, so every instruction that reads it must be
+// elementwise and produce the shape of the product.
+bool IsElementwiseEpilogue(const HloInstruction& dot,
+                           const HloInstruction& consumer) {
+  if (!ShapeUtil::Equal(consumer.shape(), dot.shape())) {
+    return false;
+  }
+  if (consumer.opcode() != HloOpcode::kFusion) {
+    return consumer.IsElementwise();
+  }
+  if (!consumer.IsLoopFusion()) {
+    return false;
+  }
+  std::vector<const HloInstruction*> worklist = {
+      consumer.fused_parameter(consumer.operand_index(&dot))};
+  absl::flat_hash_set<const HloInstruction*> visited;
+  while (!worklist.empty()) {
+    const HloInstruction* instruction = worklist.back();
+    worklist.pop_back();
+    for (const HloInstruction* user : instruction->users()) {
+      if (!user->IsElementwise()) {
+        return false;
+      }
+      if (visited.insert(user).second) {
+        worklist.push_back(user);
+      }
+    }
+  }
+  return true;
+}
+
+bool CanBeGemmEpilogueFused(const HloInstruction* producer,
+                            const HloInstruction* consumer) {
+  if (producer->opcode() != HloOpcode::kDot ||
+      producer->shape().rank() != 2 ||
+      producer->dot_dimension_numbers().lhs_batch_dimensions_size() != 0 ||
+      ShapeUtil::ElementIsComplex(producer->shape()) ||
+      !HasExactlyOneUse(*producer)) {
+    return false;
+  }
+  if (options::GemmEpilogueFusionDisabled(
+          producer->GetModule()->config())) {
+    return false;
+  }
+  return IsElementwiseEpilogue(*producer, *consumer);
+}
+
 bool CanBeOutputFusedIntoSomeOperand(const HloInstruction* consumer) {
   return consumer->opcode() == HloOpcode::kAdd &&
          (CanBeOutputFused(consumer->operand(0), consumer) ||
@@ -81,6 +134,22 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     return true;
   }
 
+  if (CanBeGemmEpilogueFused(producer, consumer)) {
+    VLOG(2) << "Fusion OK: Can fuse the epilogue of a matrix product.";
+    return true;
+  }
+
+  if (const HloInstruction* dot = GetGemmEpilogueFusionDot(*consumer)) {
+    // The operands of the product are read by the GEMM, not elementally.
+    for (const HloInstruction* user :
+         consumer->fused_parameter(operand_index)->users()) {
+      if (user == dot) {
+        VLOG(2) << "Not fusing: producer is an operand of a matrix product.";
+        return false;
+      }
+    }
+  }
+
   if (CanBeOutputFusedIntoSomeOperand(producer)) {
     VLOG(2)
         << "Bailing because producer can be output-fused into some operand.";
@@ -181,7 +250,7 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
         LayoutUtil::Minor(producer->operand(0)->shape().layout(), 0));
   }
 
-  if (consumer->IsLoopFusion()) {
+  if (consumer->IsLoopFusion() || GetGemmEpilogueFusionDot(*consumer)) {
     VLOG(2) << "Fusing: consumer is a fusion node.";
     return true;
   }
@@ -197,7 +266,9 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
 
 HloInstruction::FusionKind CpuInstructionFusion::ChooseKind(
     const HloInstruction* producer, const HloInstruction* consumer) {
-  return CanBeOutputFused(producer, consumer)
+  return CanBeOutputFused(producer, consumer) ||
+                 CanBeGemmEpilogueFused(producer, consumer) ||
+                 consumer->IsOutputFusion()
              ? HloInstruction::FusionKind::kOutput
              : HloInstruction::FusionKind::kLoop;
 }
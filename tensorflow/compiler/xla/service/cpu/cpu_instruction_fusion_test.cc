@@ -699,6 +699,53 @@ TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x19) {
                                              /*k=*/50, /*n=*/19,
                                              /*add_extra_use_for_dot=*/false);
 
+  // Matrix-matrix products take the add as an epilogue.
+  RunFusionAndCheckOpcodesWereFused(
+      module.get(),
+      {HloOpcode::kDot, HloOpcode::kAdd, HloOpcode::kParameter,
+       HloOpcode::kParameter, HloOpcode::kParameter},
+      HloInstruction::FusionKind::kOutput);
+}
+
+TEST_F(OpcodeFusionTest, DotBiasAddActivationOutputFusion) {
+  string hlo_string = R"(
+HloModule module
+
+ENTRY main {
+  a = f32[64,32]{1,0} parameter(0)
+  b = f32[32,128]{1,0} parameter(1)
+  bias = f32[128]{0} parameter(2)
+  dot = f32[64,128]{1,0} dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  broadcast = f32[64,128]{1,0} broadcast(bias), dimensions={1}
+  add = f32[64,128]{1,0} add(dot, broadcast)
+  ROOT tanh = f32[64,128]{1,0} tanh(add)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  RunFusionAndCheckOpcodesWereFused(
+      module.get(),
+      {HloOpcode::kDot, HloOpcode::kBroadcast, HloOpcode::kAdd,
+       HloOpcode::kTanh, HloOpcode::kParameter, HloOpcode::kParameter,
+       HloOpcode::kParameter},
+      HloInstruction::FusionKind::kOutput);
+}
+
+TEST_F(InstructionFusionTest, DotOperationFusion_DontFuseTransposeEpilogue) {
+  string hlo_string = R"(
+HloModule module
+
+ENTRY main {
+  a = f32[64,32]{1,0} parameter(0)
+  b = f32[32,64]{1,0} parameter(1)
+  dot = f32[64,64]{1,0} dot(a, b), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT transpose = f32[64,64]{1,0} transpose(dot), dimensions={1,0}
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
   TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
                           CpuInstructionFusion().Run(module.get()));
   EXPECT_FALSE(fused_something);
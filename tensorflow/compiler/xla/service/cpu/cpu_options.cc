@@ -26,6 +26,11 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kXlaDisableTiledReduce = "xla_cpu_disable_tiled_reduce";
+const char* const kXlaDisableGemmEpilogueFusion =
+    "xla_cpu_disable_gemm_epilogue_fusion";
+const char* const kXlaDisableAsyncParallelTasks =
+    "xla_cpu_disable_async_parallel_tasks";
 
 }  // namespace
 
@@ -45,6 +50,24 @@ bool VectorizedReduceDisabled(const HloModuleConfig& config) {
   return extra_options_map.count(kXlaOptimizeForSizeCpuOption) > 0;
 }
 
+bool TiledReduceDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaDisableTiledReduce) > 0;
+}
+
+bool GemmEpilogueFusionDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaDisableGemmEpilogueFusion) > 0;
+}
+
+bool AsyncParallelTasksDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaDisableAsyncParallelTasks) > 0;
+}
+
 absl::optional<int64> LlvmIrGemvTilingFactor(const HloModuleConfig& config) {
   const auto& extra_options_map =
       config.debug_options().xla_backend_extra_options();
@@ -1245,5 +1245,53 @@ Status EmitDotOperation(const HloInstruction& dot,
                                   executable_run_options_value, b, mlir_context,
                                   hlo_module_config, target_machine_features);
 }
+
+bool CanEmitDotOperationRows(const HloInstruction& dot) {
+  const Shape& lhs_shape = dot.operand(0)->shape();
+  const Shape& rhs_shape = dot.operand(1)->shape();
+  const Shape& result_shape = dot.shape();
+  auto is_row_major_matrix = [](const Shape& shape) {
+    return shape.rank() == 2 && LayoutUtil::HasLayout(shape) &&
+           LayoutUtil::IsMonotonicWithDim0Major(shape.layout());
+  };
+  return !IsBatchDot(dot) && is_row_major_matrix(lhs_shape) &&
+         is_row_major_matrix(rhs_shape) && is_row_major_matrix(result_shape) &&
+         dot.dot_dimension_numbers().lhs_contracting_dimensions(0) == 1;
+}
+
+Status EmitDotOperationRows(
+    const HloInstruction& dot, const llvm_ir::IrArray& target_array,
+    const llvm_ir::IrArray& lhs_array, const llvm_ir::IrArray& rhs_array,
+    llvm::Value* row_start, int64 row_count,
+    llvm::Value* executable_run_options_value, llvm::IRBuilder<>* b,
+    mlir::MLIRContext* mlir_context, const HloModuleConfig& hlo_module_config,
+    const TargetMachineFeatures& target_machine_features) {
+  TF_RET_CHECK(CanEmitDotOperationRows(dot));
+  llvm::Module* module = b->GetInsertBlock()->getModule();
+
+  // The rows of row major matrices are contiguous, so the block of rows of the
+  // LHS and of the result are matrices of their own.
+  DotInfo dot_info(dot);
+  dot_info.lhs_shape.set_dimensions(0, row_count);
+  dot_info.result_shape.set_dimensions(0, row_count);
+  auto slice_rows = [&](const llvm_ir::IrArray& array, const Shape& shape) {
+    llvm::Type* element_type =
+        llvm_ir::PrimitiveTypeToIrType(shape.element_type(), module);
+    llvm::Value* first_element = b->CreateInBoundsGEP(
+        b->CreateBitCast(array.GetBasePointer(), element_type->getPointerTo()),
+        {b->CreateMul(row_start, b->getInt64(shape.dimensions(1)))});
+    return llvm_ir::IrArray(
+        b->CreateBitCast(first_element,
+                         llvm_ir::ShapeToIrType(shape, module)->getPointerTo()),
+        shape);
+  };
+  llvm_ir::IrArray target_rows =
+      slice_rows(target_array, dot_info.result_shape);
+  llvm_ir::IrArray lhs_rows = slice_rows(lhs_array, dot_info.lhs_shape);
+  return EmitNonBatchDotOperation(
+      std::move(dot_info), dot.name(), target_rows, lhs_rows, rhs_array,
+      /*addend_array=*/nullptr, executable_run_options_value, b, mlir_context,
+      hlo_module_config, target_machine_features);
+}
 }  // namespace cpu
 }  // namespace xla
@@ -67,6 +67,23 @@ Status EmitDotOperation(const HloInstruction& dot,
                         llvm::IRBuilder<>* b, mlir::MLIRContext* mlir_context,
                         const HloModuleConfig& hlo_module_config,
                         const TargetMachineFeatures& target_machine_features);
+
+// Returns true if EmitDotOperationRows can emit `dot`: a non-batch
+// matrix-matrix product of row major matrices whose LHS contracting dimension
+// is 1.
+bool CanEmitDotOperationRows(const HloInstruction& dot);
+
+// Emit LLVM IR computing the rows [`row_start`, `row_start` + `row_count`) of
+// the result of `dot` into the same rows of `target_array`, using the
+// implementation strategy for a product of that many rows.  `row_start` is an
+// i64 value.  Requires CanEmitDotOperationRows(`dot`).
+Status EmitDotOperationRows(
+    const HloInstruction& dot, const llvm_ir::IrArray& target_array,
+    const llvm_ir::IrArray& lhs_array, const llvm_ir::IrArray& rhs_array,
+    llvm::Value* row_start, int64 row_count,
+    llvm::Value* executable_run_options_value, llvm::IRBuilder<>* b,
+    mlir::MLIRContext* mlir_context, const HloModuleConfig& hlo_module_config,
+    const TargetMachineFeatures& target_machine_features);
 }  // namespace cpu
 }  // namespace xla
 
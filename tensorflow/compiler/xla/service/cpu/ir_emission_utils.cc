@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/window_util.h"
@@ -40,6 +41,21 @@ int64 GetMinimumAlignmentForArray(
       allocation_size_bytes);
 }
 
+const HloInstruction* GetGemmEpilogueFusionDot(const HloInstruction& fusion) {
+  if (!fusion.IsOutputFusion()) {
+    return nullptr;
+  }
+  // The other output fusions add a vector to a matrix-vector product.
+  for (const HloInstruction* instruction :
+       fusion.fused_instructions_computation()->instructions()) {
+    if (instruction->opcode() == HloOpcode::kDot &&
+        instruction->shape().rank() == 2) {
+      return instruction;
+    }
+  }
+  return nullptr;
+}
+
 bool PotentiallyImplementedAsEigenConvolution(
     const HloInstruction& convolution,
     const TargetMachineFeatures& target_machine_features) {
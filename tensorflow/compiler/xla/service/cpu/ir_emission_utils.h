@@ -27,6 +27,12 @@ bool PotentiallyImplementedAsEigenConvolution(
     const HloInstruction& convolution,
     const TargetMachineFeatures& target_machine_features);
 
+// Returns the dot of `fusion` if it is an output fusion of a matrix-matrix
+// product and an elementwise epilogue, and null otherwise.  Such fusions are
+// emitted by computing the product into the output of the fusion and applying
+// the epilogue to it in place.
+const HloInstruction* GetGemmEpilogueFusionDot(const HloInstruction& fusion);
+
 // Computes the minimum alignment guaranteed for a tensor of shape `shape` on
 // the target machine.
 int64 GetMinimumAlignmentForArray(
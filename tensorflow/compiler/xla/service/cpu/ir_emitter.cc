@@ -26,6 +26,7 @@ limitations under the License.
 #include <vector>
 
 // IWYU pragma: no_include "llvm/IR/Intrinsics.gen.inc"
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
@@ -56,6 +57,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/parallel_loop_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
+#include "tensorflow/compiler/xla/service/cpu/tiled_reduction_emitter.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -65,6 +67,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_support_library.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/loop_emitter.h"
@@ -189,6 +192,7 @@ StatusOr<llvm::Function*> IrEmitter::EmitComputation(
       computation->parent()->config().cpu_traceme_enabled());
 
   TF_RETURN_IF_ERROR(computation->AcceptOrdered(this, instruction_order));
+  CHECK(pending_parallel_tasks_.empty());
   llvm::Function* ir_function = compute_function_->function();
   InsertOrDie(&emitted_functions_, computation, ir_function);
   // Delete 'compute_function', finalizing 'ir_function' and restoring caller
@@ -224,6 +228,85 @@ void IrEmitter::InitializeIrFunction(const string& function_name) {
 
 IrEmitter::~IrEmitter() {}
 
+bool IrEmitter::GetBufferAccesses(
+    const HloInstruction& hlo, std::vector<BufferAllocation::Slice>* reads,
+    std::vector<BufferAllocation::Slice>* writes) const {
+  if (hlo.HasSideEffect()) {
+    return false;
+  }
+  auto add_slices = [&](const HloInstruction& instruction,
+                        std::vector<BufferAllocation::Slice>* slices) {
+    ShapeUtil::ForEachSubshape(
+        instruction.shape(), [&](const Shape& /*subshape*/,
+                                 const ShapeIndex& index) {
+          for (const BufferAllocation::Slice& slice :
+               assignment_.GetAllSlices(&instruction, index)) {
+            slices->push_back(slice);
+          }
+        });
+  };
+  add_slices(hlo, writes);
+  for (const HloInstruction* operand : hlo.operands()) {
+    add_slices(*operand, reads);
+  }
+  for (const HloComputation* callee : hlo.called_computations()) {
+    // Fused and thread local computations only access the operands and result
+    // of `hlo`, besides their stack.
+    if (hlo.opcode() == HloOpcode::kFusion ||
+        absl::c_binary_search(thread_local_computations_, callee)) {
+      continue;
+    }
+    if (hlo.opcode() != HloOpcode::kCall) {
+      return false;
+    }
+    // The parameters of the callee alias the operands of the call.
+    for (const HloInstruction* instruction : callee->instructions()) {
+      if (instruction->opcode() != HloOpcode::kParameter &&
+          !GetBufferAccesses(*instruction, reads, writes)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+namespace {
+
+bool AnySliceOverlaps(absl::Span<const BufferAllocation::Slice> a,
+                      absl::Span<const BufferAllocation::Slice> b) {
+  return absl::c_any_of(a, [&](const BufferAllocation::Slice& slice_a) {
+    return absl::c_any_of(b, [&](const BufferAllocation::Slice& slice_b) {
+      return slice_a.OverlapsWith(slice_b);
+    });
+  });
+}
+
+}  // namespace
+
+void IrEmitter::EmitJoinsForParallelTasksConflictingWith(
+    const HloInstruction* hlo) {
+  if (pending_parallel_tasks_.empty()) {
+    return;
+  }
+  std::vector<BufferAllocation::Slice> reads;
+  std::vector<BufferAllocation::Slice> writes;
+  const bool known =
+      hlo != nullptr && GetBufferAccesses(*hlo, &reads, &writes);
+  std::vector<PendingParallelTask> still_pending;
+  for (PendingParallelTask& task : pending_parallel_tasks_) {
+    if (known && !AnySliceOverlaps(task.writes, reads) &&
+        !AnySliceOverlaps(task.writes, writes) &&
+        !AnySliceOverlaps(task.reads, writes)) {
+      still_pending.push_back(std::move(task));
+      continue;
+    }
+    VLOG(3) << "Joining parallel task before "
+            << (hlo != nullptr ? hlo->name() : "the end of the computation");
+    EmitCallToParallelJoin(task.handle, &b_);
+  }
+  pending_parallel_tasks_ = std::move(still_pending);
+}
+
 Status IrEmitter::HandleBitcast(HloInstruction* bitcast) {
   VLOG(2) << "HandleBitcast: " << bitcast->ToString();
   emitted_value_[bitcast] =
@@ -1926,11 +2009,146 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   return true;
 }
 
+StatusOr<bool> IrEmitter::EmitTiledReduce(HloInstruction* reduce,
+                                          string* failure_reason) {
+  if (!reduce->shape().IsArray()) {
+    *failure_reason = "tiling of variadic reduce not implemented";
+    return false;
+  }
+
+  absl::optional<TiledReductionShape> tiled_shape =
+      GetTiledReductionShape(*reduce);
+  if (!tiled_shape) {
+    *failure_reason = "reduced dimensions are not contiguous in the layout";
+    return false;
+  }
+
+  ReductionGenerator reduction_generator =
+      MatchReductionGenerator(reduce->to_apply(), failure_reason);
+  if (!reduction_generator) {
+    return false;
+  }
+
+  const PrimitiveType element_type = reduce->shape().element_type();
+  const int64 element_size = ShapeUtil::ByteSizeOfPrimitiveType(element_type);
+  const int64 vectorization_factor =
+      target_machine_features_.vectorization_factor_in_bytes() / element_size;
+  if (vectorization_factor < 1 ||
+      target_machine_features_.vector_register_byte_size(
+          *compute_function_->function()) < element_size) {
+    *failure_reason = "vector registers are too small for the element type";
+    return false;
+  }
+
+  // The range of rows and columns of the [outer, inner] view of the output to
+  // compute. Parallel tasks compute the part of the output given by the
+  // dynamic loop bounds of its most-major dimensions; these must map to a
+  // contiguous range of either rows or columns.
+  const Shape& shape = reduce->shape();
+  std::vector<int64> major_to_minor_sizes;
+  for (int64 i = shape.rank() - 1; i >= 0; --i) {
+    major_to_minor_sizes.push_back(
+        shape.dimensions(LayoutUtil::Minor(shape.layout(), i)));
+  }
+  int64 num_outer_dims = 0;
+  for (int64 outer = 1; outer != tiled_shape->outer; ++num_outer_dims) {
+    outer *= major_to_minor_sizes[num_outer_dims];
+  }
+  auto product_of_sizes = [&](int64 begin, int64 end) {
+    int64 product = 1;
+    for (int64 i = begin; i < end; ++i) {
+      product *= major_to_minor_sizes[i];
+    }
+    return product;
+  };
+
+  const int64 num_partitioned_dims =
+      ShouldEmitParallelLoopFor(*reduce) ? num_dynamic_loop_bounds_ : 0;
+  if (num_partitioned_dims > shape.rank() ||
+      (num_partitioned_dims > num_outer_dims &&
+       (num_outer_dims > 0 ||
+        product_of_sizes(0, num_partitioned_dims - 1) != 1))) {
+    *failure_reason = "partition does not map to a range of rows or columns";
+    return false;
+  }
+
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
+  TiledReductionEmitter emitter(element_type, vectorization_factor,
+                                std::move(reduction_generator), &b_);
+  llvm::Value* input = GetEmittedValueFor(reduce->operand(0));
+  llvm::Value* output = GetEmittedValueFor(reduce);
+  llvm::Value* init_value = Load(GetEmittedValueFor(reduce->operand(1)));
+
+  if (num_partitioned_dims == 0) {
+    emitter.Emit(*tiled_shape, input, output, init_value, b_.getInt64(0),
+                 b_.getInt64(tiled_shape->outer), b_.getInt64(0),
+                 b_.getInt64(tiled_shape->inner));
+    return true;
+  }
+
+  DynamicLoopBounds dynamic_loop_bounds =
+      compute_function_->GetDynamicLoopBounds();
+  const int64 last = num_partitioned_dims - 1;
+  if (num_partitioned_dims > num_outer_dims) {
+    // The output has a single row, of which the task computes the columns
+    // spanned by the last partitioned dimension.
+    llvm::Value* stride =
+        b_.getInt64(product_of_sizes(num_partitioned_dims, shape.rank()));
+    emitter.Emit(*tiled_shape, input, output, init_value, b_.getInt64(0),
+                 b_.getInt64(1),
+                 NSWMul(dynamic_loop_bounds[last].first, stride),
+                 NSWMul(dynamic_loop_bounds[last].second, stride));
+    return true;
+  }
+
+  // Loop over the partitioned dimensions but the last, which spans a
+  // contiguous range of rows for each of their indices.
+  llvm::Value* stride =
+      b_.getInt64(product_of_sizes(num_partitioned_dims, num_outer_dims));
+  KernelSupportLibrary ksl(&b_);
+  std::function<void(int64, llvm::Value*)> emit_partitioned_dim =
+      [&](int64 dim, llvm::Value* linear_index) {
+        if (dim == last) {
+          llvm::Value* base = NSWMul(linear_index,
+                                     b_.getInt64(major_to_minor_sizes[last]));
+          emitter.Emit(
+              *tiled_shape, input, output, init_value,
+              NSWMul(NSWAdd(base, dynamic_loop_bounds[last].first), stride),
+              NSWMul(NSWAdd(base, dynamic_loop_bounds[last].second), stride),
+              b_.getInt64(0), b_.getInt64(tiled_shape->inner));
+          return;
+        }
+        ksl.For(absl::StrCat("reduce.partition.", dim),
+                dynamic_loop_bounds[dim].first,
+                dynamic_loop_bounds[dim].second, 1, [&](llvm::Value* index) {
+                  emit_partitioned_dim(
+                      dim + 1,
+                      NSWAdd(NSWMul(linear_index,
+                                    b_.getInt64(major_to_minor_sizes[dim])),
+                             index));
+                });
+      };
+  emit_partitioned_dim(0, b_.getInt64(0));
+  return true;
+}
+
 Status IrEmitter::HandleReduce(HloInstruction* reduce) {
   auto arg = reduce->mutable_operand(0);
   auto init_value = reduce->mutable_operand(1);
   absl::Span<const int64> dimensions(reduce->dimensions());
   HloComputation* function = reduce->to_apply();
+  if (!options::VectorizedReduceDisabled(hlo_module_config_) &&
+      !options::TiledReduceDisabled(hlo_module_config_)) {
+    string tiling_failure_reason;
+    TF_ASSIGN_OR_RETURN(bool tiling_successful,
+                        EmitTiledReduce(reduce, &tiling_failure_reason));
+    if (tiling_successful) {
+      VLOG(1) << "Successfully tiled reduction " << reduce->ToString();
+      return Status::OK();
+    }
+    VLOG(1) << "Could not tile reduction " << reduce->ToString() << ": "
+            << tiling_failure_reason;
+  }
   if (!options::VectorizedReduceDisabled(hlo_module_config_)) {
     string vectorization_failure_reason;
     TF_ASSIGN_OR_RETURN(
@@ -2214,6 +2432,9 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
     TF_RETURN_IF_ERROR(fusion->fused_expression_root()->Accept(&fused_emitter));
 
     return EmitTargetElementLoop(fusion, fused_emitter.GetRootGenerator());
+  } else if (const HloInstruction* dot = GetGemmEpilogueFusionDot(*fusion)) {
+    VLOG(3) << "HandleFusion kOutput with a matrix-matrix product";
+    return EmitGemmEpilogueFusion(fusion, dot);
   } else if (fusion->IsOutputFusion()) {
     VLOG(3) << "HandleFusion kOutput";
     int64 dot_op_index = root->operand(0)->opcode() == HloOpcode::kDot ? 0 : 1;
@@ -2248,6 +2469,121 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
   }
 }
 
+namespace {
+// Generates the elements of a dot by reading the array it was computed into,
+// so that the epilogue of a GEMM output fusion does not recompute them.
+class GemmEpilogueElementalIrEmitter : public CpuElementalIrEmitter {
+ public:
+  GemmEpilogueElementalIrEmitter(const HloModuleConfig& module_config,
+                                 IrEmitter* ir_emitter, llvm::Module* module,
+                                 const HloInstruction* dot,
+                                 const llvm_ir::IrArray& dot_array)
+      : CpuElementalIrEmitter(module_config, ir_emitter, module),
+        dot_(dot),
+        dot_array_(dot_array) {}
+
+  llvm_ir::ElementGenerator MakeElementGenerator(
+      const HloInstruction* hlo,
+      const HloToElementGeneratorMap& operand_to_generator) override {
+    if (hlo == dot_) {
+      return [this](const llvm_ir::IrArray::Index& index)
+                 -> StatusOr<llvm::Value*> {
+        return dot_array_.EmitReadArrayElement(index, b());
+      };
+    }
+    return CpuElementalIrEmitter::MakeElementGenerator(hlo,
+                                                       operand_to_generator);
+  }
+
+ private:
+  const HloInstruction* dot_;
+  const llvm_ir::IrArray& dot_array_;
+};
+}  // namespace
+
+Status IrEmitter::EmitGemmEpilogueFusion(HloInstruction* fusion,
+                                         const HloInstruction* dot) {
+  // The product is computed in blocks of rows of about this many bytes, which
+  // are still in L2 cache when the epilogue reads them back.
+  constexpr int64 kBlockBytes = 128 * 1024;
+
+  TF_RET_CHECK(dot->operand(0)->opcode() == HloOpcode::kParameter &&
+               dot->operand(1)->opcode() == HloOpcode::kParameter);
+  // The epilogue reads the operands after the product has overwritten the
+  // output, see CanShareBufferHint in cpu_compiler.cc.
+  for (const HloInstruction* operand : fusion->operands()) {
+    TF_RET_CHECK(assignment_.HaveDisjointSlices(fusion, operand));
+  }
+  TF_RETURN_IF_ERROR(EmitTargetAddressForOp(fusion));
+  llvm_ir::IrArray target_array = GetIrArrayFor(fusion);
+  llvm_ir::IrArray lhs_array =
+      GetIrArrayFor(fusion->operand(dot->operand(0)->parameter_number()));
+  llvm_ir::IrArray rhs_array =
+      GetIrArrayFor(fusion->operand(dot->operand(1)->parameter_number()));
+
+  GemmEpilogueElementalIrEmitter elemental_emitter(
+      hlo_module_config_, this, module_, dot, target_array);
+  FusedIrEmitter fused_emitter(GetGeneratorForOperandIrArrays(fusion),
+                               &elemental_emitter);
+  TF_RETURN_IF_ERROR(fusion->fused_expression_root()->Accept(&fused_emitter));
+  llvm_ir::ElementGenerator epilogue = fused_emitter.GetRootGenerator();
+
+  KernelSupportLibrary ksl(&b_);
+  const int64 rows = dot->shape().dimensions(0);
+  const int64 columns = dot->shape().dimensions(1);
+  auto emit_epilogue = [&](llvm::Value* row_start, int64 row_count) {
+    return ksl.ForWithStatus(
+        "gemm_epilogue.row", row_start,
+        NSWAdd(row_start, b_.getInt64(row_count)), 1, [&](llvm::Value* row) {
+          return ksl.ForWithStatus(
+              "gemm_epilogue.column", 0, columns, 1,
+              [&](llvm::Value* column) -> Status {
+                llvm_ir::IrArray::Index index({row, column}, fusion->shape(),
+                                              b_.getInt64Ty());
+                TF_ASSIGN_OR_RETURN(llvm::Value * value, epilogue(index));
+                target_array.EmitWriteArrayElement(index, value, &b_);
+                return Status::OK();
+              });
+        });
+  };
+
+  if (!CanEmitDotOperationRows(*dot)) {
+    TF_RETURN_IF_ERROR(EmitDotOperation(
+        *dot, target_array, lhs_array, rhs_array, /*addend_array=*/nullptr,
+        GetExecutableRunOptionsArgument(), &b_, mlir_context_,
+        hlo_module_config_, target_machine_features_));
+    return emit_epilogue(b_.getInt64(0), rows);
+  }
+
+  auto emit_block = [&](llvm::Value* row_start, int64 row_count) {
+    TF_RETURN_IF_ERROR(EmitDotOperationRows(
+        *dot, target_array, lhs_array, rhs_array, row_start, row_count,
+        GetExecutableRunOptionsArgument(), &b_, mlir_context_,
+        hlo_module_config_, target_machine_features_));
+    return emit_epilogue(row_start, row_count);
+  };
+  const int64 row_bytes =
+      columns * ShapeUtil::ByteSizeOfPrimitiveType(dot->shape().element_type());
+  const int64 block_rows =
+      std::min(rows, std::max<int64>(1, kBlockBytes / std::max<int64>(
+                                                          row_bytes, 1)));
+  const int64 num_blocks = rows / block_rows;
+  if (num_blocks == 1) {
+    TF_RETURN_IF_ERROR(emit_block(b_.getInt64(0), block_rows));
+  } else if (num_blocks > 1) {
+    TF_RETURN_IF_ERROR(ksl.ForWithStatus(
+        "gemm_epilogue.block", 0, num_blocks * block_rows, block_rows,
+        [&](llvm::Value* row_start) {
+          return emit_block(row_start, block_rows);
+        }));
+  }
+  if (rows % block_rows != 0) {
+    TF_RETURN_IF_ERROR(emit_block(b_.getInt64(num_blocks * block_rows),
+                                  rows % block_rows));
+  }
+  return Status::OK();
+}
+
 Status IrEmitter::HandleCall(HloInstruction* call) {
   HloComputation* computation = call->to_apply();
   llvm::Function* call_ir_function = FindOrDie(emitted_functions_, computation);
@@ -2265,9 +2601,22 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
         /*profile_counters_arg=*/GetProfileCountersArgument());
 
     HloInstruction* root = computation->root_instruction();
-    TF_RETURN_IF_ERROR(EmitCallToParallelForkJoin(
-        call_args, root->shape(), root->outer_dimension_partitions(), &b_,
-        call_ir_function, computation->name()));
+    PendingParallelTask task;
+    // Without profiling, the partitions are left running and only joined
+    // before the first instruction that depends on their buffers, so that
+    // independent instructions emitted after the call run concurrently.
+    if (!options::AsyncParallelTasksDisabled(hlo_module_config_) &&
+        instruction_to_profile_idx_.empty() &&
+        GetBufferAccesses(*call, &task.reads, &task.writes)) {
+      task.handle = EmitCallToParallelFork(
+          call_args, root->shape(), root->outer_dimension_partitions(), &b_,
+          call_ir_function, computation->name());
+      pending_parallel_tasks_.push_back(std::move(task));
+    } else {
+      TF_RETURN_IF_ERROR(EmitCallToParallelForkJoin(
+          call_args, root->shape(), root->outer_dimension_partitions(), &b_,
+          call_ir_function, computation->name()));
+    }
   } else {
     EmitGlobalCall(*computation, computation->name());
   }
@@ -2918,6 +3267,7 @@ Status IrEmitter::FinishVisit(HloInstruction* root) {
   // nothing to do since the result was already written directly into the output
   // buffer.
   VLOG(2) << "FinishVisit root: " << root->ToString();
+  EmitJoinsForParallelTasksConflictingWith(nullptr);
   if (root->opcode() == HloOpcode::kOutfeed) {
     VLOG(2) << "  outfeed with value: "
             << llvm_ir::DumpToString(*GetEmittedValueFor(root->operand(0)));
@@ -3092,6 +3442,7 @@ bool IsHloVeryCheap(const HloInstruction* hlo) {
 
 Status IrEmitter::Preprocess(HloInstruction* hlo) {
   VLOG(3) << "Visiting: " << hlo->ToString();
+  EmitJoinsForParallelTasksConflictingWith(hlo);
   // When profiling is enabled, trace the same HLOs that the profiler does.
   if (instruction_to_profile_idx_.count(hlo) ||
       (hlo_module_config_.cpu_traceme_enabled() && !IsHloVeryCheap(hlo))) {
@@ -197,6 +197,18 @@ class IrEmitter : public DfsHloVisitorWithDefault,
   // Private helper to initialize an IR function for the computation.
   void InitializeIrFunction(const string& function_name);
 
+  // Appends the buffer slices that `hlo` reads and writes to `reads` and
+  // `writes`. Returns false if these can't be determined from its operands and
+  // called computations, e.g. because it has side effects.
+  bool GetBufferAccesses(const HloInstruction& hlo,
+                         std::vector<BufferAllocation::Slice>* reads,
+                         std::vector<BufferAllocation::Slice>* writes) const;
+
+  // Emits joins for the pending parallel tasks that access a buffer written by
+  // `hlo`, or write a buffer accessed by `hlo`. Joins all of them if `hlo` is
+  // null or its buffer accesses are unknown.
+  void EmitJoinsForParallelTasksConflictingWith(const HloInstruction* hlo);
+
   // Emits the copying epilogue for the function,
   // where it copies the returned value to the reserved alloca.
   // This is only necessary for thread-local functions.
@@ -357,6 +369,19 @@ class IrEmitter : public DfsHloVisitorWithDefault,
                                       HloComputation* function,
                                       string* failure_reason);
 
+  // Tries to codegen a reduction operation with TiledReductionEmitter.  Returns
+  // true if successful, and false on failure.  On failure, sets
+  // "failure_reason" to a string describing why the reduction was not tiled.
+  StatusOr<bool> EmitTiledReduce(HloInstruction* reduce,
+                                 string* failure_reason);
+
+  // Emits an output fusion of the matrix-matrix product `dot` and an
+  // elementwise epilogue.  The product is computed into the output of the
+  // fusion in blocks of rows, and the epilogue is applied to each block in
+  // place while it is still in cache.
+  Status EmitGemmEpilogueFusion(HloInstruction* fusion,
+                                const HloInstruction* dot);
+
   // We'd like to keep one or two one cache-line's worth of data in registers
   // without generating IR with illegal (e.g. excessively large or
   // non-power-of-two) vector types.  We do this by introducing a layer of
@@ -472,6 +497,17 @@ class IrEmitter : public DfsHloVisitorWithDefault,
   absl::flat_hash_map<BufferAllocation::Index, int64>
       computation_parameter_allocations_;
 
+  // A parallel task of the computation being compiled that was forked but not
+  // joined yet, so that it may run concurrently with the instructions emitted
+  // after it.
+  struct PendingParallelTask {
+    // The handle returned by the fork.
+    llvm::Value* handle;
+    std::vector<BufferAllocation::Slice> reads;
+    std::vector<BufferAllocation::Slice> writes;
+  };
+  std::vector<PendingParallelTask> pending_parallel_tasks_;
+
   // Maps HLO instructions to their index into the profile counter array.
   const std::unordered_map<const HloInstruction*, int64>
       instruction_to_profile_idx_;
@@ -234,9 +234,11 @@ std::vector<llvm::Value*> GetArrayFunctionCallArguments(
   return arguments;
 }
 
-// Emits a call to a runtime fork/join function which dispatches parallel
-// calls to 'parallel_function' (and joins threads before returning).
-Status EmitCallToParallelForkJoin(
+// Emits a call to the runtime function 'symbol_name', which returns
+// 'return_type' and dispatches parallel calls to 'parallel_function' for the
+// partitions of 'shape'.
+static llvm::CallInst* EmitCallToParallelRuntime(
+    const char* symbol_name, llvm::Type* return_type,
     const std::vector<llvm::Value*>& arguments, const Shape& shape,
     const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
     llvm::Function* parallel_function, const string& name) {
@@ -258,14 +260,13 @@ Status EmitCallToParallelForkJoin(
       llvm::Type::getInt8PtrTy(module->getContext()));
 
   llvm::FunctionType* fork_join_type = llvm::FunctionType::get(
-      /*Result=*/llvm::Type::getVoidTy(module->getContext()),
+      /*Result=*/return_type,
       /*Params=*/compute_function_params,
       /*isVarArg=*/false);
 
   llvm::Function* fork_join_func = llvm::dyn_cast<llvm::Function>(
       module
-          ->getOrInsertFunction(runtime::kParallelForkJoinSymbolName,
-                                fork_join_type)
+          ->getOrInsertFunction(symbol_name, fork_join_type)
           .getCallee());
   fork_join_func->setCallingConv(llvm::CallingConv::C);
   fork_join_func->setDoesNotThrow();
@@ -332,10 +333,43 @@ Status EmitCallToParallelForkJoin(
   fork_join_arguments.push_back(
       b->CreateBitCast(parallel_function, b->getInt8PtrTy()));
   // Emit call to parallel fork/join.
-  b->CreateCall(fork_join_func, fork_join_arguments);
+  return b->CreateCall(fork_join_func, fork_join_arguments);
+}
 
+Status EmitCallToParallelForkJoin(
+    const std::vector<llvm::Value*>& arguments, const Shape& shape,
+    const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
+    llvm::Function* parallel_function, const string& name) {
+  EmitCallToParallelRuntime(runtime::kParallelForkJoinSymbolName,
+                            b->getVoidTy(), arguments, shape,
+                            dimension_partition_counts, b, parallel_function,
+                            name);
   return Status::OK();
 }
 
+llvm::Value* EmitCallToParallelFork(
+    const std::vector<llvm::Value*>& arguments, const Shape& shape,
+    const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
+    llvm::Function* parallel_function, const string& name) {
+  return EmitCallToParallelRuntime(runtime::kParallelForkSymbolName,
+                                   b->getInt8PtrTy(), arguments, shape,
+                                   dimension_partition_counts, b,
+                                   parallel_function, name);
+}
+
+void EmitCallToParallelJoin(llvm::Value* handle, llvm::IRBuilder<>* b) {
+  llvm::Module* module = b->GetInsertBlock()->getModule();
+  llvm::FunctionType* join_type = llvm::FunctionType::get(
+      /*Result=*/b->getVoidTy(),
+      /*Params=*/{b->getInt8PtrTy()},
+      /*isVarArg=*/false);
+  llvm::Function* join_func = llvm::dyn_cast<llvm::Function>(
+      module->getOrInsertFunction(runtime::kParallelJoinSymbolName, join_type)
+          .getCallee());
+  join_func->setCallingConv(llvm::CallingConv::C);
+  join_func->setDoesNotThrow();
+  b->CreateCall(join_func, {handle});
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -134,6 +134,18 @@ Status EmitCallToParallelForkJoin(
     const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
     llvm::Function* parallel_function, const string& name);
 
+// Emits a call to a runtime function which dispatches parallel calls to
+// 'parallel_function' like EmitCallToParallelForkJoin, but returns without
+// joining them. Returns the handle to pass to EmitCallToParallelJoin.
+llvm::Value* EmitCallToParallelFork(
+    const std::vector<llvm::Value*>& arguments, const Shape& shape,
+    const std::vector<int64>& dimension_partition_counts, llvm::IRBuilder<>* b,
+    llvm::Function* parallel_function, const string& name);
+
+// Emits a call to a runtime function which joins the threads dispatched by the
+// fork that returned 'handle'.
+void EmitCallToParallelJoin(llvm::Value* handle, llvm::IRBuilder<>* b);
+
 }  // namespace cpu
 }  // namespace xla
 
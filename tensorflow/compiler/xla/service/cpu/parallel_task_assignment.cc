@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
@@ -53,13 +54,24 @@ class DefaultCostModel : public ParallelCostModel {
  public:
   DefaultCostModel(const int64 max_parallelism,
                    const HloCostAnalysis::ShapeSizeFunction& shape_size,
-                   std::unique_ptr<HloCostAnalysis> cost_analysis)
+                   std::unique_ptr<CalibratedHloCostAnalysis> cost_analysis)
       : max_parallelism_(max_parallelism),
         shape_size_(shape_size),
         cost_analysis_(std::move(cost_analysis)) {}
   ~DefaultCostModel() override {}
 
   int64 GetParallelTaskCount(HloInstruction* instruction) override {
+    // Use the execution time measured for 'instruction' if there is one. The
+    // minimum per-thread cost is the 100000 cycles used below, at 2GHz.
+    if (cost_analysis_->is_measured(*instruction)) {
+      const double min_seconds_per_thread = 50e-6;
+      return std::min(
+          max_parallelism_,
+          std::max(int64{1},
+                   static_cast<int64>(
+                       cost_analysis_->optimal_seconds(*instruction) /
+                       min_seconds_per_thread)));
+    }
     // Parameters for parallel task count computation.
     int64 instruction_cost;
     int64 min_cost_per_thread;
@@ -103,17 +115,26 @@ class DefaultCostModel : public ParallelCostModel {
  private:
   const int64 max_parallelism_;
   const HloCostAnalysis::ShapeSizeFunction shape_size_;
-  const std::unique_ptr<HloCostAnalysis> cost_analysis_;
+  const std::unique_ptr<CalibratedHloCostAnalysis> cost_analysis_;
 };
 
+// The device type the execution times of HLOs run by the CPU backend are
+// recorded under, i.e. the name of the host StreamExecutor device.
+constexpr char kHostDeviceType[] = "Host";
+
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64 max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
     const TargetMachineFeatures* target_machine_features)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
-  // Run cost analysis on 'module'.
-  auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
+  // Run cost analysis on 'module', using the execution times measured on this
+  // host where available.
+  std::unique_ptr<HloCostCalibration> calibration =
+      HloCostCalibration::LoadForDevice(module->config().debug_options(),
+                                        kHostDeviceType);
+  auto cost_analysis = absl::make_unique<CalibratedHloCostAnalysis>(
+      shape_size, calibration.get());
   HloComputation* computation = module->entry_computation();
   Status status = computation->root_instruction()->Accept(cost_analysis.get());
   if (status.ok()) {
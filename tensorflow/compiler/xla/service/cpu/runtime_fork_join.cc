@@ -31,6 +31,52 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
+namespace {
+
+// Dispatches calls to 'function' for partitions [1, num_partitions) onto the
+// intra-op thread pool, each of which decrements 'bc' when done, and then calls
+// 'function' for the first partition inline.
+void DispatchPartitions(void* result_ptr, const void* run_options_ptr,
+                        const void** params, void** buffer_table,
+                        uint64* prof_counters, int32 num_partitions,
+                        int64* partitions, int32 num_partitioned_dims,
+                        void* function_ptr, tensorflow::BlockingCounter* bc) {
+  CHECK_EQ(params, nullptr);
+  CHECK_GT(num_partitions, 1);
+  CHECK_GT(num_partitioned_dims, 0);
+  CHECK_NE(function_ptr, nullptr);
+  CHECK_NE(partitions, nullptr);
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  CHECK_NE(run_options, nullptr);
+  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+
+  ComputeFunctionType function =
+      reinterpret_cast<ComputeFunctionType>(function_ptr);
+  // Compute partition stride in 'partitions' array.
+  const int64 stride = 2 * num_partitioned_dims;
+
+  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
+  for (int32 i = 1; i < num_partitions; ++i) {
+    const int64 offset = i * stride;
+    run_options->intra_op_thread_pool()->enqueueNoNotification(
+        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
+         partitions, offset, bc]() {
+          function(result_ptr, run_options_ptr, nullptr, buffer_table,
+                   &partitions[offset], prof_counters);
+          bc->DecrementCount();
+          VLOG(3) << "ParallelFork partition " << i << " done.";
+        });
+  }
+
+  // Call first compute function inline.
+  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
+           prof_counters);
+  VLOG(3) << "ParallelFork partition 0 done.";
+}
+
+}  // namespace
+
 // Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
 // Calls 'function_ptr' for first partition inline.
 // Uses blocking counter to synchronize threads after parallel calls complete.
@@ -66,39 +112,36 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   VLOG(2) << "ParallelForkJoin ENTRY"
           << " num_partitions: " << num_partitions
           << " num_partitioned_dims: " << num_partitioned_dims;
-  CHECK_EQ(params, nullptr);
-  CHECK_GT(num_partitions, 1);
-  CHECK_GT(num_partitioned_dims, 0);
-  CHECK_NE(function_ptr, nullptr);
-  CHECK_NE(partitions, nullptr);
-  const xla::ExecutableRunOptions* run_options =
-      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
-  CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
-
-  ComputeFunctionType function =
-      reinterpret_cast<ComputeFunctionType>(function_ptr);
-  // Compute partition stride in 'partitions' array.
-  const int64 stride = 2 * num_partitioned_dims;
-
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
   tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
-  }
-
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  DispatchPartitions(result_ptr, run_options_ptr, params, buffer_table,
+                     prof_counters, num_partitions, partitions,
+                     num_partitioned_dims, function_ptr, &bc);
   bc.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
+
+// Like __xla_cpu_runtime_ParallelForkJoin, but returns as soon as the first
+// partition is done. The returned handle must be passed to
+// __xla_cpu_runtime_ParallelJoin exactly once, which waits for the remaining
+// partitions.
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void* __xla_cpu_runtime_ParallelFork(
+    void* result_ptr, const void* run_options_ptr, const void** params,
+    void** buffer_table, uint64* prof_counters, int32 num_partitions,
+    int64* partitions, int32 num_partitioned_dims, void* function_ptr) {
+  VLOG(2) << "ParallelFork ENTRY"
+          << " num_partitions: " << num_partitions
+          << " num_partitioned_dims: " << num_partitioned_dims;
+  auto* bc = new tensorflow::BlockingCounter(num_partitions - 1);
+  DispatchPartitions(result_ptr, run_options_ptr, params, buffer_table,
+                     prof_counters, num_partitions, partitions,
+                     num_partitioned_dims, function_ptr, bc);
+  return bc;
+}
+
+TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelJoin(
+    void* handle) {
+  auto* bc = static_cast<tensorflow::BlockingCounter*>(handle);
+  bc->Wait();
+  delete bc;
+  VLOG(2) << "ParallelJoin EXIT";
+}
@@ -28,6 +28,19 @@ extern void __xla_cpu_runtime_ParallelForkJoin(
     tensorflow::int32 num_partitions, tensorflow::int64* partitions,
     tensorflow::int32 num_partitioned_dims, void* function_ptr);
 
+// Dispatches 'num_partitions' parallel calls to 'function_ptr' like
+// __xla_cpu_runtime_ParallelForkJoin, but returns without waiting for them.
+// Returns a handle to pass to __xla_cpu_runtime_ParallelJoin.
+extern void* __xla_cpu_runtime_ParallelFork(
+    void* result_ptr, const void* run_options_ptr, const void** params,
+    void** buffer_table, tensorflow::uint64* prof_counters,
+    tensorflow::int32 num_partitions, tensorflow::int64* partitions,
+    tensorflow::int32 num_partitioned_dims, void* function_ptr);
+
+// Waits for the calls dispatched by the __xla_cpu_runtime_ParallelFork that
+// returned 'handle', and releases it.
+extern void __xla_cpu_runtime_ParallelJoin(void* handle);
+
 }  // extern "C"
 
 #endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_FORK_JOIN_H_
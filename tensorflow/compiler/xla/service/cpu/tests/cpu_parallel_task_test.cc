@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuParallelTaskTest : public CpuCodegenTest {
+ protected:
+  void CompileAndVerifyParallelIr(const string& hlo_text,
+                                  const string& pattern) {
+    HloModuleConfig config = GetModuleConfigForTest();
+    config.set_intra_op_parallelism_threads(4);
+    TF_ASSERT_OK_AND_ASSIGN(auto module,
+                            ParseAndReturnVerifiedModule(hlo_text, config));
+    CompileAndVerifyIr(std::move(module), pattern,
+                       /*match_optimized_ir=*/false);
+  }
+
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    if (disable_async_) {
+      (*debug_options.mutable_xla_backend_extra_options())
+          ["xla_cpu_disable_async_parallel_tasks"] = "";
+    }
+    return debug_options;
+  }
+
+  bool disable_async_ = false;
+};
+
+const char* const kIndependentExps = R"(
+HloModule IndependentExps
+
+ENTRY main {
+  p0 = f32[1024,1024] parameter(0)
+  p1 = f32[1024,1024] parameter(1)
+  exp0 = f32[1024,1024] exponential(p0)
+  exp1 = f32[1024,1024] exponential(p1)
+  ROOT tuple = (f32[1024,1024], f32[1024,1024]) tuple(exp0, exp1)
+}
+)";
+
+TEST_F(CpuParallelTaskTest, IndependentTasksAreJoinedByTheirConsumer) {
+  CompileAndVerifyParallelIr(kIndependentExps, R"(
+CHECK: call i8* @__xla_cpu_runtime_ParallelFork
+CHECK-NOT: @__xla_cpu_runtime_ParallelJoin
+CHECK: call i8* @__xla_cpu_runtime_ParallelFork
+CHECK: call void @__xla_cpu_runtime_ParallelJoin
+CHECK: call void @__xla_cpu_runtime_ParallelJoin
+)");
+}
+
+TEST_F(CpuParallelTaskTest, AsyncTasksCanBeDisabled) {
+  disable_async_ = true;
+  CompileAndVerifyParallelIr(kIndependentExps, R"(
+CHECK-NOT: @__xla_cpu_runtime_ParallelFork(
+CHECK: call void @__xla_cpu_runtime_ParallelForkJoin
+CHECK: call void @__xla_cpu_runtime_ParallelForkJoin
+)");
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,275 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/tiled_reduction_emitter.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "llvm/IR/Constants.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_support_library.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// The number of vectors of partial results row reductions keep in registers,
+// so that consecutive loads don't wait on each other's reductions.
+constexpr int64 kRowAccumulators = 4;
+
+// The size in bytes of the blocks of the inner dimension that column
+// reductions accumulate at a time. A block of the output and a block of a row
+// of the input fit in L1 cache.
+constexpr int64 kColumnBlockBytes = 8 * 1024;
+
+}  // namespace
+
+absl::optional<TiledReductionShape> GetTiledReductionShape(
+    const HloInstruction& reduce) {
+  const Shape& operand_shape = reduce.operand(0)->shape();
+  const Shape& result_shape = reduce.shape();
+  if (!result_shape.IsArray() || !LayoutUtil::HasLayout(operand_shape) ||
+      !LayoutUtil::HasLayout(result_shape)) {
+    return absl::nullopt;
+  }
+  absl::flat_hash_set<int64> reduced_dims(reduce.dimensions().begin(),
+                                          reduce.dimensions().end());
+
+  // Walk the operand dimensions from major to minor, expecting the unreduced
+  // ones to be split into an outer and an inner run by the reduced ones.
+  TiledReductionShape shape{1, 1, 1};
+  bool seen_reduced = false;
+  std::vector<int64> expected_result_dims;
+  for (int64 i = operand_shape.rank() - 1; i >= 0; --i) {
+    const int64 dim = LayoutUtil::Minor(operand_shape.layout(), i);
+    const int64 size = operand_shape.dimensions(dim);
+    if (size == 1) {
+      continue;
+    }
+    if (reduced_dims.contains(dim)) {
+      if (shape.inner != 1) {
+        return absl::nullopt;
+      }
+      seen_reduced = true;
+      shape.reduced *= size;
+      continue;
+    }
+    (seen_reduced ? shape.inner : shape.outer) *= size;
+    expected_result_dims.push_back(
+        dim - absl::c_count_if(reduce.dimensions(),
+                               [&](int64 reduced) { return reduced < dim; }));
+  }
+
+  std::vector<int64> result_dims;
+  for (int64 i = result_shape.rank() - 1; i >= 0; --i) {
+    const int64 dim = LayoutUtil::Minor(result_shape.layout(), i);
+    if (result_shape.dimensions(dim) != 1) {
+      result_dims.push_back(dim);
+    }
+  }
+  if (result_dims != expected_result_dims) {
+    return absl::nullopt;
+  }
+  return shape;
+}
+
+TiledReductionEmitter::TiledReductionEmitter(
+    PrimitiveType element_type, int64 vector_size,
+    ReductionGenerator reduction_generator, llvm::IRBuilder<>* b)
+    : element_type_(element_type),
+      reduction_generator_(std::move(reduction_generator)),
+      b_(b),
+      vsl_(element_type, vector_size, b, "reduce") {}
+
+void TiledReductionEmitter::Emit(const TiledReductionShape& shape,
+                                 llvm::Value* input, llvm::Value* output,
+                                 llvm::Value* init_value,
+                                 llvm::Value* outer_start,
+                                 llvm::Value* outer_end,
+                                 llvm::Value* inner_start,
+                                 llvm::Value* inner_end) {
+  if (shape.reduced == 0) {
+    KernelSupportLibrary ksl(b_);
+    ksl.For("reduce.outer", outer_start, outer_end, 1, [&](llvm::Value* outer) {
+      llvm::Value* output_row = vsl_.ComputeOffsetPointer(
+          output, b_->CreateMul(outer, b_->getInt64(shape.inner)));
+      ksl.For("reduce.inner", inner_start, inner_end, 1,
+              [&](llvm::Value* inner) {
+                vsl_.StoreScalar(init_value, output_row, inner);
+              });
+    });
+    return;
+  }
+  if (shape.inner == 1) {
+    EmitRowReduction(shape, input, output, init_value, outer_start, outer_end);
+  } else {
+    EmitColumnReduction(shape, input, output, init_value, outer_start,
+                        outer_end, inner_start, inner_end);
+  }
+}
+
+void TiledReductionEmitter::EmitRowReduction(const TiledReductionShape& shape,
+                                             llvm::Value* input,
+                                             llvm::Value* output,
+                                             llvm::Value* init_value,
+                                             llvm::Value* outer_start,
+                                             llvm::Value* outer_end) {
+  KernelSupportLibrary ksl(b_);
+  const int64 vector_size = vsl_.vector_size();
+  const int64 tile_size = kRowAccumulators * vector_size;
+  const int64 tiled_end = shape.reduced / tile_size * tile_size;
+
+  ksl.For("reduce.row", outer_start, outer_end, 1, [&](llvm::Value* row) {
+    llvm::Value* row_start = vsl_.ComputeOffsetPointer(
+        input, b_->CreateMul(row, b_->getInt64(shape.reduced)));
+    ScalarVariable result(&vsl_, init_value);
+
+    if (tiled_end > 0) {
+      // The first tile initializes the accumulators, so that the initial value
+      // is only combined once.
+      std::vector<VectorVariable> accumulators;
+      accumulators.reserve(kRowAccumulators);
+      for (int64 i = 0; i < kRowAccumulators; ++i) {
+        accumulators.emplace_back(&vsl_,
+                                  vsl_.LoadVector(row_start, i * vector_size));
+      }
+      ksl.For("reduce.row.tile", tile_size, tiled_end, tile_size,
+              [&](llvm::Value* tile_start) {
+                for (int64 i = 0; i < kRowAccumulators; ++i) {
+                  llvm::Value* value = vsl_.LoadVector(
+                      row_start,
+                      b_->CreateAdd(tile_start, b_->getInt64(i * vector_size)));
+                  accumulators[i].Set(
+                      reduction_generator_(b_, accumulators[i].Get(), value));
+                }
+              });
+      llvm::Value* partial = accumulators[0].Get();
+      for (int64 i = 1; i < kRowAccumulators; ++i) {
+        partial = reduction_generator_(b_, partial, accumulators[i].Get());
+      }
+      result.Set(EmitHorizontalReduction(partial, result.Get()));
+    }
+
+    ksl.For("reduce.row.remainder", tiled_end, shape.reduced, 1,
+            [&](llvm::Value* i) {
+              result.Set(reduction_generator_(b_, result.Get(),
+                                              vsl_.LoadScalar(row_start, i)));
+            });
+    vsl_.StoreScalar(result.Get(), output, row);
+  });
+}
+
+void TiledReductionEmitter::EmitColumnReduction(
+    const TiledReductionShape& shape, llvm::Value* input, llvm::Value* output,
+    llvm::Value* init_value, llvm::Value* outer_start, llvm::Value* outer_end,
+    llvm::Value* inner_start, llvm::Value* inner_end) {
+  KernelSupportLibrary ksl(b_);
+  const int64 vector_size = vsl_.vector_size();
+  const int64 block_size = std::max(
+      vector_size,
+      kColumnBlockBytes / ShapeUtil::ByteSizeOfPrimitiveType(element_type_) /
+          vector_size * vector_size);
+
+  ksl.For("reduce.column", outer_start, outer_end, 1, [&](llvm::Value* outer) {
+    llvm::Value* input_plane = vsl_.ComputeOffsetPointer(
+        input, b_->CreateMul(outer, b_->getInt64(shape.reduced * shape.inner)));
+    llvm::Value* output_row = vsl_.ComputeOffsetPointer(
+        output, b_->CreateMul(outer, b_->getInt64(shape.inner)));
+
+    ksl.For("reduce.column.block", inner_start, inner_end, block_size,
+            [&](llvm::Value* block_start) {
+      llvm::Value* unclamped_end =
+          b_->CreateAdd(block_start, b_->getInt64(block_size));
+      llvm::Value* block_end =
+          b_->CreateSelect(b_->CreateICmpSLT(unclamped_end, inner_end),
+                           unclamped_end, inner_end);
+      llvm::Value* vectorized_end = b_->CreateAdd(
+          block_start,
+          b_->CreateMul(b_->CreateUDiv(b_->CreateSub(block_end, block_start),
+                                       b_->getInt64(vector_size)),
+                        b_->getInt64(vector_size)));
+
+      // Combines a row of the input block into the output block. The first
+      // row is combined with the initial value instead, so that the initial
+      // value is only combined once.
+      auto combine_row = [&](llvm::Value* input_row, bool is_first_row) {
+        ksl.For("reduce.column.vector", block_start, vectorized_end,
+                vector_size, [&](llvm::Value* column) {
+                  llvm::Value* partial =
+                      is_first_row ? vsl_.BroadcastScalar(init_value)
+                                   : vsl_.LoadVector(output_row, column);
+                  vsl_.StoreVector(
+                      reduction_generator_(b_, partial,
+                                           vsl_.LoadVector(input_row, column)),
+                      output_row, column);
+                });
+        ksl.For("reduce.column.remainder", vectorized_end, block_end, 1,
+                [&](llvm::Value* column) {
+                  llvm::Value* partial =
+                      is_first_row ? init_value
+                                   : vsl_.LoadScalar(output_row, column);
+                  vsl_.StoreScalar(
+                      reduction_generator_(b_, partial,
+                                           vsl_.LoadScalar(input_row, column)),
+                      output_row, column);
+                });
+      };
+
+      combine_row(input_plane, /*is_first_row=*/true);
+      ksl.For("reduce.column.row", 1, shape.reduced, 1, [&](llvm::Value* row) {
+        combine_row(
+            vsl_.ComputeOffsetPointer(
+                input_plane, b_->CreateMul(row, b_->getInt64(shape.inner))),
+            /*is_first_row=*/false);
+      });
+    });
+  });
+}
+
+llvm::Value* TiledReductionEmitter::EmitHorizontalReduction(
+    llvm::Value* vector, llvm::Value* accumulator) {
+  int64 width = vsl_.vector_size();
+  // Fold the vector in halves while its width is even, then combine the
+  // remaining lanes one by one.
+  while (width % 2 == 0) {
+    llvm::SmallVector<llvm::Constant*, 32> low_mask;
+    llvm::SmallVector<llvm::Constant*, 32> high_mask;
+    for (int64 i = 0; i < width / 2; ++i) {
+      low_mask.push_back(b_->getInt32(i));
+      high_mask.push_back(b_->getInt32(i + width / 2));
+    }
+    llvm::Value* undef = llvm::UndefValue::get(vector->getType());
+    vector = reduction_generator_(
+        b_,
+        b_->CreateShuffleVector(vector, undef,
+                                llvm::ConstantVector::get(low_mask)),
+        b_->CreateShuffleVector(vector, undef,
+                                llvm::ConstantVector::get(high_mask)));
+    width /= 2;
+  }
+  for (int64 i = 0; i < width; ++i) {
+    accumulator = reduction_generator_(
+        b_, accumulator, b_->CreateExtractElement(vector, b_->getInt64(i)));
+  }
+  return accumulator;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,99 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TILED_REDUCTION_EMITTER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TILED_REDUCTION_EMITTER_H_
+
+#include <functional>
+
+#include "absl/types/optional.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+#include "tensorflow/compiler/xla/service/cpu/vector_support_library.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace xla {
+namespace cpu {
+
+// A reduction viewed as reducing the middle dimension of a row-major
+// [outer, reduced, inner] array into a row-major [outer, inner] array.
+struct TiledReductionShape {
+  tensorflow::int64 outer;
+  tensorflow::int64 reduced;
+  tensorflow::int64 inner;
+};
+
+// Returns the TiledReductionShape view of `reduce`. Returns nullopt if the
+// reduced dimensions are not contiguous in the layout of the operand, or if
+// the unreduced dimensions are not in the same order in the layouts of the
+// operand and the result. Dimensions of size 1 are ignored.
+absl::optional<TiledReductionShape> GetTiledReductionShape(
+    const HloInstruction& reduce);
+
+// Emits LLVM IR for reductions in the TiledReductionShape form.
+//
+// Row reductions (inner == 1) stream over each row keeping several vectors of
+// partial results in registers, and only reduce across vector lanes at the end
+// of the row.
+//
+// Column reductions (inner > 1) stream over the input in blocks of the inner
+// dimension small enough to stay in L1 cache, combining each row of the block
+// into the output block one vector at a time. The input is thus read once and
+// contiguously, instead of once per output vector with a stride of a row.
+class TiledReductionEmitter {
+ public:
+  // Emits the combination of two scalars or two vectors of partial results.
+  using ReductionGenerator = std::function<llvm::Value*(
+      llvm::IRBuilder<>*, llvm::Value*, llvm::Value*)>;
+
+  TiledReductionEmitter(PrimitiveType element_type,
+                        tensorflow::int64 vector_size,
+                        ReductionGenerator reduction_generator,
+                        llvm::IRBuilder<>* b);
+
+  // Emits the reduction of `input` into rows [outer_start, outer_end) and
+  // columns [inner_start, inner_end) of `output`, starting from the scalar
+  // `init_value`. The bounds are i64 values.
+  void Emit(const TiledReductionShape& shape, llvm::Value* input,
+            llvm::Value* output, llvm::Value* init_value,
+            llvm::Value* outer_start, llvm::Value* outer_end,
+            llvm::Value* inner_start, llvm::Value* inner_end);
+
+ private:
+  void EmitRowReduction(const TiledReductionShape& shape, llvm::Value* input,
+                        llvm::Value* output, llvm::Value* init_value,
+                        llvm::Value* outer_start, llvm::Value* outer_end);
+  void EmitColumnReduction(const TiledReductionShape& shape,
+                           llvm::Value* input, llvm::Value* output,
+                           llvm::Value* init_value, llvm::Value* outer_start,
+                           llvm::Value* outer_end, llvm::Value* inner_start,
+                           llvm::Value* inner_end);
+
+  // Combines the lanes of `vector` into the scalar `accumulator`.
+  llvm::Value* EmitHorizontalReduction(llvm::Value* vector,
+                                       llvm::Value* accumulator);
+
+  PrimitiveType element_type_;
+  ReductionGenerator reduction_generator_;
+  llvm::IRBuilder<>* b_;
+  VectorSupportLibrary vsl_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TILED_REDUCTION_EMITTER_H_
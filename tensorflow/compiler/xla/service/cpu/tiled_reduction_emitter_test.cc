@@ -0,0 +1,91 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/tiled_reduction_emitter.h"
+
+#include "absl/strings/str_format.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class TiledReductionShapeTest : public HloTestBase {
+ protected:
+  absl::optional<TiledReductionShape> GetShape(absl::string_view input_shape,
+                                               absl::string_view output_shape,
+                                               absl::string_view dimensions) {
+    const std::string hlo_string = absl::StrFormat(R"(
+HloModule m
+
+add {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT add = f32[] add(a, b)
+}
+
+ENTRY e {
+  input = %s parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = %s reduce(input, zero), dimensions={%s}, to_apply=add
+})",
+                                                   input_shape, output_shape,
+                                                   dimensions);
+    auto module = ParseAndReturnVerifiedModule(hlo_string).ValueOrDie();
+    return GetTiledReductionShape(
+        *module->entry_computation()->root_instruction());
+  }
+};
+
+void ExpectShape(const absl::optional<TiledReductionShape>& shape,
+                 int64 outer, int64 reduced, int64 inner) {
+  ASSERT_TRUE(shape.has_value());
+  EXPECT_EQ(shape->outer, outer);
+  EXPECT_EQ(shape->reduced, reduced);
+  EXPECT_EQ(shape->inner, inner);
+}
+
+TEST_F(TiledReductionShapeTest, RowReduction) {
+  ExpectShape(GetShape("f32[8,16]{1,0}", "f32[8]{0}", "1"), 8, 16, 1);
+}
+
+TEST_F(TiledReductionShapeTest, ColumnReduction) {
+  ExpectShape(GetShape("f32[8,16]{1,0}", "f32[16]{0}", "0"), 1, 8, 16);
+  ExpectShape(GetShape("f32[4,8,16]{2,1,0}", "f32[4,16]{1,0}", "1"), 4, 8,
+              16);
+}
+
+TEST_F(TiledReductionShapeTest, FollowsLayout) {
+  ExpectShape(GetShape("f32[8,16]{0,1}", "f32[16]{0}", "0"), 16, 8, 1);
+}
+
+TEST_F(TiledReductionShapeTest, IgnoresDimensionsOfSizeOne) {
+  ExpectShape(GetShape("f32[8,16,1,4]{3,2,1,0}", "f32[8,1,4]{2,1,0}", "1"), 8,
+              16, 4);
+  ExpectShape(GetShape("f32[8,1,16]{2,1,0}", "f32[8]{0}", "1,2"), 8, 16, 1);
+}
+
+TEST_F(TiledReductionShapeTest, RejectsNonContiguousReducedDimensions) {
+  EXPECT_FALSE(GetShape("f32[4,8,16]{2,1,0}", "f32[8]{0}", "0,2"));
+}
+
+TEST_F(TiledReductionShapeTest, RejectsTransposingLayouts) {
+  EXPECT_FALSE(GetShape("f32[4,8,16]{2,1,0}", "f32[4,8]{0,1}", "2"));
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
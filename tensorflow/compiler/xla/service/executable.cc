@@ -19,6 +19,7 @@ limitations under the License.
 #include "absl/strings/str_format.h"
 #include "tensorflow/compiler/xla/debug_options_flags.h"
 #include "tensorflow/compiler/xla/service/dump.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
 #include "tensorflow/compiler/xla/service/hlo_graph_dumper.h"
 #include "tensorflow/compiler/xla/service/maybe_owning_device_memory.h"
 #include "tensorflow/compiler/xla/status.h"
@@ -277,6 +278,18 @@ Status ExecuteWrapperAfterExecution(
     stream->ThenDoHostCallback([profile, device_description]() {
       XLA_LOG_LINES(tensorflow::INFO, profile->ToString(*device_description));
     });
+
+    const std::string& calibration_dir =
+        executable->module_config().debug_options().xla_cost_calibration_dir();
+    if (!calibration_dir.empty() && executable->has_module()) {
+      std::shared_ptr<HloModule> module = executable->shared_module();
+      stream->ThenDoHostCallback(
+          [profile, device_description, module, calibration_dir]() {
+            HloCostCalibration::RecordProfile(
+                calibration_dir, device_description->name(), module, *profile,
+                device_description->clock_rate_ghz());
+          });
+    }
   }
 
   return return_status;
@@ -0,0 +1,200 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
+
+#include <map>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+std::string EntryKey(const AutotuneDevice& device, const std::string& hlo) {
+  return absl::StrCat(device.model(), "\n", device.cc().major(), ".",
+                      device.cc().minor(), "\n", device.driver_version(), "\n",
+                      device.cudnn_version().major(), ".",
+                      device.cudnn_version().minor(), ".",
+                      device.cudnn_version().patch(), "\n",
+                      device.blas_version(), "\n", hlo);
+}
+
+bool IsTextProto(const std::string& path) {
+  return absl::EndsWith(path, ".pbtxt");
+}
+
+}  // namespace
+
+/* static */ AutotuneDatabase* AutotuneDatabase::ForDebugOptions(
+    const DebugOptions& debug_options) {
+  const std::string& path = debug_options.xla_gpu_autotune_database_path();
+  if (path.empty()) {
+    return nullptr;
+  }
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto& databases TF_GUARDED_BY(mu) =
+      *new std::map<std::string, std::unique_ptr<AutotuneDatabase>>();
+  tensorflow::mutex_lock lock(mu);
+  std::unique_ptr<AutotuneDatabase>& database = databases[path];
+  if (database == nullptr) {
+    database = absl::make_unique<AutotuneDatabase>(path);
+    Status status = database->Load();
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring the autotuning results in " << path << ": "
+                   << status;
+    }
+  }
+  return database.get();
+}
+
+/* static */ AutotuneDevice AutotuneDatabase::DeviceOf(
+    se::StreamExecutor* stream_exec) {
+  AutotuneDevice device;
+  const se::DeviceDescription& description =
+      stream_exec->GetDeviceDescription();
+  device.set_model(description.name());
+  device.set_driver_version(description.driver_version());
+  int cc_major = 0, cc_minor = 0;
+  if (description.cuda_compute_capability(&cc_major, &cc_minor)) {
+    device.mutable_cc()->set_major(cc_major);
+    device.mutable_cc()->set_minor(cc_minor);
+  }
+  if (auto* dnn = stream_exec->AsDnn()) {
+    StatusOr<se::dnn::VersionInfo> version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      const auto& version = version_or.ValueOrDie();
+      device.mutable_cudnn_version()->set_major(version.major_version());
+      device.mutable_cudnn_version()->set_minor(version.minor_version());
+      device.mutable_cudnn_version()->set_patch(version.patch());
+    }
+  }
+  if (auto* blas = stream_exec->AsBlas()) {
+    std::string blas_version;
+    if (blas->GetVersion(&blas_version).ok()) {
+      device.set_blas_version(blas_version);
+    }
+  }
+  return device;
+}
+
+/* static */ std::string AutotuneDatabase::InstructionKey(
+    const HloInstruction& instr) {
+  auto options = HloPrintOptions::Canonical();
+  options.set_print_backend_config(true);
+  return instr.ToString(options);
+}
+
+absl::optional<tensorflow::AutotuneResult> AutotuneDatabase::Lookup(
+    const AutotuneDevice& device, const std::string& hlo) const {
+  tensorflow::mutex_lock lock(mu_);
+  auto it = entries_.find(EntryKey(device, hlo));
+  if (it == entries_.end()) {
+    return absl::nullopt;
+  }
+  return it->second.result();
+}
+
+void AutotuneDatabase::Insert(const AutotuneDevice& device,
+                              const std::string& hlo,
+                              const tensorflow::AutotuneResult& result) {
+  tensorflow::mutex_lock lock(mu_);
+  auto inserted = entries_.emplace(EntryKey(device, hlo),
+                                   AutotuneDatabaseProto::Entry());
+  if (!inserted.second) {
+    return;
+  }
+  AutotuneDatabaseProto::Entry& entry = inserted.first->second;
+  *entry.mutable_device() = device;
+  entry.set_hlo(hlo);
+  *entry.mutable_result() = result;
+  changed_ = true;
+}
+
+void AutotuneDatabase::AddProto(const AutotuneDatabaseProto& proto) {
+  for (const AutotuneDatabaseProto::Entry& entry : proto.entries()) {
+    entries_.emplace(EntryKey(entry.device(), entry.hlo()), entry);
+  }
+}
+
+Status AutotuneDatabase::ReadFile(AutotuneDatabaseProto* proto) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->FileExists(path_).ok()) {
+    return Status::OK();
+  }
+  return IsTextProto(path_) ? tensorflow::ReadTextProto(env, path_, proto)
+                            : tensorflow::ReadBinaryProto(env, path_, proto);
+}
+
+Status AutotuneDatabase::Load() {
+  AutotuneDatabaseProto proto;
+  TF_RETURN_IF_ERROR(ReadFile(&proto));
+  tensorflow::mutex_lock lock(mu_);
+  AddProto(proto);
+  VLOG(1) << "Loaded " << proto.entries_size() << " autotuning results from "
+          << path_;
+  return Status::OK();
+}
+
+Status AutotuneDatabase::SaveIfChanged() {
+  AutotuneDatabaseProto on_disk;
+  TF_RETURN_IF_ERROR(ReadFile(&on_disk));
+
+  tensorflow::mutex_lock lock(mu_);
+  if (!changed_) {
+    return Status::OK();
+  }
+  AddProto(on_disk);
+  AutotuneDatabaseProto proto;
+  for (const auto& key_and_entry : entries_) {
+    *proto.add_entries() = key_and_entry.second;
+  }
+
+  // Write to a temporary file first, so that processes reading the database
+  // concurrently never see a partially written one.
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::string temp_path = path_;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return InternalError("Could not create a temporary file next to %s",
+                         path_);
+  }
+  TF_RETURN_IF_ERROR(IsTextProto(path_)
+                         ? tensorflow::WriteTextProto(env, temp_path, proto)
+                         : tensorflow::WriteBinaryProto(env, temp_path, proto));
+  TF_RETURN_IF_ERROR(env->RenameFile(temp_path, path_));
+  changed_ = false;
+  VLOG(1) << "Saved " << proto.entries_size() << " autotuning results to "
+          << path_;
+  return Status::OK();
+}
+
+AutotuneDatabaseProto AutotuneDatabase::ToProto() const {
+  tensorflow::mutex_lock lock(mu_);
+  AutotuneDatabaseProto proto;
+  for (const auto& key_and_entry : entries_) {
+    *proto.add_entries() = key_and_entry.second;
+  }
+  return proto;
+}
+
+}  // namespace gpu
+}  // namespace xla
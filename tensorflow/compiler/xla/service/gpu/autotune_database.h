@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_DATABASE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_DATABASE_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/autotuning.pb.h"
+
+namespace xla {
+namespace gpu {
+
+// GEMM and convolution autotuning results persisted in a file, so that they
+// are reused across processes and can be shipped along with a model. Results
+// are keyed by the GPU model, the driver, cuDNN and cuBLAS versions, and the
+// canonical text of the instruction.
+//
+// Results that are already known are never replaced, which makes the choice
+// of algorithms deterministic across the processes sharing a file.
+//
+// Thread-safe.
+class AutotuneDatabase {
+ public:
+  explicit AutotuneDatabase(std::string path) : path_(std::move(path)) {}
+
+  // Returns the process-wide database persisted at
+  // --xla_gpu_autotune_database_path, loading it on first use. Returns null if
+  // the flag is not set.
+  static AutotuneDatabase* ForDebugOptions(const DebugOptions& debug_options);
+
+  // Returns the model and library versions of `stream_exec`.
+  static AutotuneDevice DeviceOf(se::StreamExecutor* stream_exec);
+
+  // Returns the key `instr` is looked up by.
+  static std::string InstructionKey(const HloInstruction& instr);
+
+  absl::optional<tensorflow::AutotuneResult> Lookup(
+      const AutotuneDevice& device, const std::string& hlo) const;
+
+  // Records `result` for `hlo` on `device`, unless a result is already known.
+  void Insert(const AutotuneDevice& device, const std::string& hlo,
+              const tensorflow::AutotuneResult& result);
+
+  // Adds the results in the file to the database. A missing file is treated
+  // as an empty one.
+  Status Load();
+
+  // Writes the database to its file if results were inserted since it was
+  // last loaded or saved. Results another process added to the file in the
+  // meantime are kept.
+  Status SaveIfChanged();
+
+  AutotuneDatabaseProto ToProto() const;
+
+ private:
+  void AddProto(const AutotuneDatabaseProto& proto)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status ReadFile(AutotuneDatabaseProto* proto) const;
+
+  const std::string path_;
+
+  mutable tensorflow::mutex mu_;
+  absl::flat_hash_map<std::string, AutotuneDatabaseProto::Entry> entries_
+      TF_GUARDED_BY(mu_);
+  bool changed_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_DATABASE_H_
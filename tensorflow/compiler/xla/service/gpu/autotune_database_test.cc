@@ -0,0 +1,101 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+AutotuneDevice MakeDevice(const std::string& model, int cudnn_major) {
+  AutotuneDevice device;
+  device.set_model(model);
+  device.mutable_cc()->set_major(7);
+  device.mutable_cudnn_version()->set_major(cudnn_major);
+  device.set_blas_version("10.1");
+  return device;
+}
+
+tensorflow::AutotuneResult ConvResult(int64 algorithm) {
+  tensorflow::AutotuneResult result;
+  result.mutable_conv()->set_algorithm(algorithm);
+  return result;
+}
+
+std::string TempPath(const std::string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+TEST(AutotuneDatabaseTest, LookupMatchesDeviceAndInstruction) {
+  AutotuneDatabase database(TempPath("lookup.pb"));
+  database.Insert(MakeDevice("V100", 7), "conv", ConvResult(3));
+
+  absl::optional<tensorflow::AutotuneResult> result =
+      database.Lookup(MakeDevice("V100", 7), "conv");
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->conv().algorithm(), 3);
+  EXPECT_FALSE(database.Lookup(MakeDevice("V100", 7), "other conv"));
+  EXPECT_FALSE(database.Lookup(MakeDevice("T4", 7), "conv"));
+  EXPECT_FALSE(database.Lookup(MakeDevice("V100", 8), "conv"));
+}
+
+TEST(AutotuneDatabaseTest, KnownResultsAreNotReplaced) {
+  AutotuneDatabase database(TempPath("replace.pb"));
+  database.Insert(MakeDevice("V100", 7), "conv", ConvResult(3));
+  database.Insert(MakeDevice("V100", 7), "conv", ConvResult(5));
+  EXPECT_EQ(database.Lookup(MakeDevice("V100", 7), "conv")->conv().algorithm(),
+            3);
+}
+
+TEST(AutotuneDatabaseTest, SavesAndLoads) {
+  for (const std::string& name : {"saved.pb", "saved.pbtxt"}) {
+    const std::string path = TempPath(name);
+    {
+      AutotuneDatabase database(path);
+      TF_ASSERT_OK(database.Load());
+      database.Insert(MakeDevice("V100", 7), "conv", ConvResult(3));
+      TF_ASSERT_OK(database.SaveIfChanged());
+    }
+    AutotuneDatabase loaded(path);
+    TF_ASSERT_OK(loaded.Load());
+    ASSERT_TRUE(loaded.Lookup(MakeDevice("V100", 7), "conv").has_value());
+    EXPECT_EQ(loaded.Lookup(MakeDevice("V100", 7), "conv")->conv().algorithm(),
+              3);
+  }
+}
+
+TEST(AutotuneDatabaseTest, SavingKeepsResultsOfOtherProcesses) {
+  const std::string path = TempPath("shared.pb");
+  AutotuneDatabase first(path);
+  AutotuneDatabase second(path);
+  first.Insert(MakeDevice("V100", 7), "conv0", ConvResult(1));
+  second.Insert(MakeDevice("V100", 7), "conv1", ConvResult(2));
+  TF_ASSERT_OK(first.SaveIfChanged());
+  TF_ASSERT_OK(second.SaveIfChanged());
+
+  AutotuneDatabase loaded(path);
+  TF_ASSERT_OK(loaded.Load());
+  EXPECT_EQ(loaded.ToProto().entries_size(), 2);
+  EXPECT_TRUE(loaded.Lookup(MakeDevice("V100", 7), "conv0").has_value());
+  EXPECT_TRUE(loaded.Lookup(MakeDevice("V100", 7), "conv1").has_value());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
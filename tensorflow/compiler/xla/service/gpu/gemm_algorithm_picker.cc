@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <limits>
 
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
@@ -265,6 +266,28 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
     // TODO(b/112111608): Implement auto tune for batched gemm.
     VLOG(2) << "Batch size is non-singular, using generic algorithm";
     result = absl::nullopt;
+  } else if (AutotuneDatabase* database = AutotuneDatabase::ForDebugOptions(
+                 instr->GetModule()->config().debug_options())) {
+    // Results persisted by an earlier process take precedence over
+    // autotuning. A result without a gemm key records that the generic
+    // algorithm is used.
+    AutotuneDevice device = AutotuneDatabase::DeviceOf(stream->parent());
+    std::string hlo = AutotuneDatabase::InstructionKey(*instr);
+    if (absl::optional<AutotuneResult> persisted =
+            database->Lookup(device, hlo)) {
+      VLOG(4) << "Using the persisted autotuning result";
+      if (persisted->has_gemm()) {
+        result = persisted->gemm().algorithm();
+      }
+    } else {
+      TF_ASSIGN_OR_RETURN(result,
+                          DoUncachedGemmAutotune(instr, stream, allocator));
+      AutotuneResult to_persist;
+      if (result) {
+        to_persist.mutable_gemm()->set_algorithm(*result);
+      }
+      database->Insert(device, hlo, to_persist);
+    }
   } else {
     TF_ASSIGN_OR_RETURN(result,
                         DoUncachedGemmAutotune(instr, stream, allocator));
@@ -326,6 +349,14 @@ StatusOr<bool> GemmAlgorithmPicker::Run(HloModule* module) {
         bool result, RunOnComputation(computation, stream_exec_, allocator_));
     changed |= result;
   }
+
+  if (AutotuneDatabase* database =
+          AutotuneDatabase::ForDebugOptions(module->config().debug_options())) {
+    Status status = database->SaveIfChanged();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to persist autotuning results: " << status;
+    }
+  }
   return changed;
 }
 
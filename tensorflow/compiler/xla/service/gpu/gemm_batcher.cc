@@ -0,0 +1,234 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gemm_batcher.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_creation_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Products with more output elements than this already occupy the device on
+// their own, and batching them would only add the cost of concatenating their
+// operands.
+constexpr int64 kMaxBatchedGemmOutputElements = 256 * 256;
+
+// Upper bound on the number of products merged into one GEMM.
+constexpr int64 kMaxBatchSize = 64;
+
+bool IsBatchable(const HloInstruction& hlo) {
+  return IsMatrixMultiplication(hlo) &&
+         hlo.dot_dimension_numbers().lhs_batch_dimensions_size() == 0 &&
+         hlo.shape().element_type() ==
+             hlo.operand(0)->shape().element_type() &&
+         ShapeUtil::ElementsIn(hlo.shape()) <= kMaxBatchedGemmOutputElements &&
+         hlo.control_predecessors().empty() &&
+         hlo.control_successors().empty();
+}
+
+// Products with the same key can be computed by one GEMM.
+std::string BatchingKey(const HloInstruction& dot) {
+  return absl::StrCat(
+      ShapeUtil::HumanStringWithLayout(dot.operand(0)->shape()), ";",
+      ShapeUtil::HumanStringWithLayout(dot.operand(1)->shape()), ";",
+      ShapeUtil::HumanStringWithLayout(dot.shape()), ";",
+      dot.dot_dimension_numbers().ShortDebugString(), ";",
+      dot.precision_config().ShortDebugString());
+}
+
+// Replaces each of `dots` by the slice `i` of size `size` along `dimension` of
+// `product`, reshaped to the shape of the dot.
+Status ReplaceWithSlices(absl::Span<HloInstruction* const> dots,
+                         HloInstruction* product, int64 dimension,
+                         int64 size) {
+  for (int64 i = 0; i < dots.size(); ++i) {
+    std::vector<int64> start_indices(product->shape().rank(), 0);
+    std::vector<int64> limit_indices(product->shape().dimensions().begin(),
+                                     product->shape().dimensions().end());
+    start_indices[dimension] = i * size;
+    limit_indices[dimension] = (i + 1) * size;
+    TF_ASSIGN_OR_RETURN(
+        HloInstruction * slice,
+        MakeSliceHlo(product, start_indices, limit_indices,
+                     std::vector<int64>(product->shape().rank(), 1)));
+    HloInstruction* replacement = slice;
+    if (!ShapeUtil::Compatible(slice->shape(), dots[i]->shape())) {
+      TF_ASSIGN_OR_RETURN(replacement,
+                          MakeReshapeHlo(dots[i]->shape(), slice));
+    }
+    TF_RETURN_IF_ERROR(
+        dots[i]->parent()->ReplaceInstruction(dots[i], replacement));
+  }
+  return Status::OK();
+}
+
+std::vector<HloInstruction*> OperandsOf(absl::Span<HloInstruction* const> dots,
+                                        int64 operand_index) {
+  std::vector<HloInstruction*> operands;
+  operands.reserve(dots.size());
+  for (HloInstruction* dot : dots) {
+    operands.push_back(dot->mutable_operand(operand_index));
+  }
+  return operands;
+}
+
+// Merges `dots`, which have the same batching key and are independent of each
+// other, into one product.
+StatusOr<bool> BatchDots(absl::Span<HloInstruction* const> dots) {
+  HloInstruction* first = dots.front();
+  const DotDimensionNumbers& dnums = first->dot_dimension_numbers();
+  const PrecisionConfig& precision_config = first->precision_config();
+  const bool shared_lhs = absl::c_all_of(dots, [&](HloInstruction* dot) {
+    return dot->operand(0) == first->operand(0);
+  });
+  const bool shared_rhs = absl::c_all_of(dots, [&](HloInstruction* dot) {
+    return dot->operand(1) == first->operand(1);
+  });
+  if (shared_lhs && shared_rhs) {
+    // Duplicates are left to CSE.
+    return false;
+  }
+  VLOG(2) << "Batching " << dots.size() << " products like "
+          << first->ToString();
+
+  // The output of a non-batch product holds the non-contracting dimension of
+  // the lhs followed by that of the rhs.
+  if (shared_lhs) {
+    const int64 rhs_free_dim = 1 - dnums.rhs_contracting_dimensions(0);
+    TF_ASSIGN_OR_RETURN(HloInstruction * rhs,
+                        MakeConcatHlo(OperandsOf(dots, 1), rhs_free_dim));
+    TF_ASSIGN_OR_RETURN(HloInstruction * product,
+                        MakeDotHlo(first->mutable_operand(0), rhs, dnums,
+                                   precision_config));
+    TF_RETURN_IF_ERROR(ReplaceWithSlices(dots, product, /*dimension=*/1,
+                                         first->shape().dimensions(1)));
+    return true;
+  }
+  if (shared_rhs) {
+    const int64 lhs_free_dim = 1 - dnums.lhs_contracting_dimensions(0);
+    TF_ASSIGN_OR_RETURN(HloInstruction * lhs,
+                        MakeConcatHlo(OperandsOf(dots, 0), lhs_free_dim));
+    TF_ASSIGN_OR_RETURN(HloInstruction * product,
+                        MakeDotHlo(lhs, first->mutable_operand(1), dnums,
+                                   precision_config));
+    TF_RETURN_IF_ERROR(ReplaceWithSlices(dots, product, /*dimension=*/0,
+                                         first->shape().dimensions(0)));
+    return true;
+  }
+
+  // Stack the operands along a new major batch dimension.
+  std::vector<HloInstruction*> batched_operands;
+  for (int64 operand_index : {0, 1}) {
+    std::vector<HloInstruction*> operands;
+    for (HloInstruction* operand : OperandsOf(dots, operand_index)) {
+      std::vector<int64> dims = {1};
+      dims.insert(dims.end(), operand->shape().dimensions().begin(),
+                  operand->shape().dimensions().end());
+      TF_ASSIGN_OR_RETURN(HloInstruction * reshape,
+                          MakeReshapeHlo(dims, operand));
+      operands.push_back(reshape);
+    }
+    TF_ASSIGN_OR_RETURN(HloInstruction * concat,
+                        MakeConcatHlo(operands, /*dimension=*/0));
+    batched_operands.push_back(concat);
+  }
+  DotDimensionNumbers batched_dnums;
+  batched_dnums.add_lhs_batch_dimensions(0);
+  batched_dnums.add_rhs_batch_dimensions(0);
+  batched_dnums.add_lhs_contracting_dimensions(
+      dnums.lhs_contracting_dimensions(0) + 1);
+  batched_dnums.add_rhs_contracting_dimensions(
+      dnums.rhs_contracting_dimensions(0) + 1);
+  TF_ASSIGN_OR_RETURN(HloInstruction * product,
+                      MakeDotHlo(batched_operands[0], batched_operands[1],
+                                 batched_dnums, precision_config));
+  TF_RETURN_IF_ERROR(
+      ReplaceWithSlices(dots, product, /*dimension=*/0, /*size=*/1));
+  return true;
+}
+
+}  // namespace
+
+StatusOr<bool> GemmBatcher::RunOnComputation(HloComputation* computation) {
+  // Group the candidates by key, in post order so that the batches are
+  // deterministic.
+  std::vector<std::vector<HloInstruction*>> groups;
+  absl::flat_hash_map<std::string, int64> group_indices;
+  for (HloInstruction* instruction : computation->MakeInstructionPostOrder()) {
+    if (!IsBatchable(*instruction)) {
+      continue;
+    }
+    auto it = group_indices.emplace(BatchingKey(*instruction), groups.size());
+    if (it.second) {
+      groups.emplace_back();
+    }
+    groups[it.first->second].push_back(instruction);
+  }
+
+  bool changed = false;
+  for (std::vector<HloInstruction*>& group : groups) {
+    while (group.size() > 1) {
+      // Merging a batch adds dependencies between the producers and consumers
+      // of its products, so reachability is recomputed for every batch.
+      std::unique_ptr<HloReachabilityMap> reachability =
+          HloReachabilityMap::Build(computation);
+      std::vector<HloInstruction*> batch;
+      std::vector<HloInstruction*> rest;
+      for (HloInstruction* dot : group) {
+        if (batch.size() < kMaxBatchSize &&
+            absl::c_none_of(batch, [&](const HloInstruction* member) {
+              return reachability->IsConnected(member, dot);
+            })) {
+          batch.push_back(dot);
+        } else {
+          rest.push_back(dot);
+        }
+      }
+      if (batch.size() > 1) {
+        TF_ASSIGN_OR_RETURN(bool batched, BatchDots(batch));
+        changed |= batched;
+      }
+      group = std::move(rest);
+    }
+  }
+  return changed;
+}
+
+StatusOr<bool> GemmBatcher::Run(HloModule* module) {
+  bool changed = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    TF_ASSIGN_OR_RETURN(bool computation_changed,
+                        RunOnComputation(computation));
+    changed |= computation_changed;
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,62 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GEMM_BATCHER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GEMM_BATCHER_H_
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// Merges small, independent matrix multiplications of the same shape into a
+// single GEMM, so that e.g. the per-head projections of an attention layer or
+// the towers of a multi-tower model run as one well-occupied cuBLAS call
+// instead of many small ones.
+//
+// Products that share their left-hand side become one product with the
+// right-hand sides concatenated along their non-contracting dimension, and
+// symmetrically for a shared right-hand side:
+//
+//   dot(x, w0), dot(x, w1)  =>  slice(dot(x, concatenate(w0, w1)))
+//
+// Other products become one batched product, which GemmRewriter turns into a
+// strided batched GEMM:
+//
+//   dot(a0, b0), dot(a1, b1)
+//     =>  slice(dot(concatenate(a0, a1), concatenate(b0, b1)), batch dim 0)
+//
+// The concatenates and slices are ordinary HLO and are fused into the
+// producers and consumers of the products by instruction fusion. Products
+// are only merged if none depends on another, so that merging does not create
+// cycles.
+//
+// This pass runs before layout assignment.
+class GemmBatcher : public HloModulePass {
+ public:
+  absl::string_view name() const override { return "gemm-batcher"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  StatusOr<bool> RunOnComputation(HloComputation* computation);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GEMM_BATCHER_H_
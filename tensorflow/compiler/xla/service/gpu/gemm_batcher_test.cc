@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gemm_batcher.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class GemmBatcherTest : public HloTestBase {};
+
+TEST_F(GemmBatcherTest, IndependentProductsAreBatched) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+  HloModule TestModule
+
+  ENTRY TestComputation {
+    a0 = f32[16,32] parameter(0)
+    b0 = f32[32,64] parameter(1)
+    a1 = f32[16,32] parameter(2)
+    b1 = f32[32,64] parameter(3)
+    dot0 = f32[16,64] dot(a0, b0),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    dot1 = f32[16,64] dot(a1, b1),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    ROOT tuple = (f32[16,64], f32[16,64]) tuple(dot0, dot1)
+  })")
+                    .ValueOrDie();
+
+  EXPECT_TRUE(GemmBatcher().Run(module.get()).ValueOrDie());
+  SCOPED_TRACE(module->ToString());
+
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Tuple(op::Reshape(op::Slice(op::Dot())),
+                              op::Reshape(op::Slice(op::Dot()))));
+  const HloInstruction* product = root->operand(0)->operand(0)->operand(0);
+  EXPECT_EQ(product, root->operand(1)->operand(0)->operand(0));
+  EXPECT_THAT(product,
+              AllOf(op::Shape("f32[2,16,64]"),
+                    op::Dot(op::Concatenate(op::Reshape(op::Parameter(0)),
+                                            op::Reshape(op::Parameter(2))),
+                            op::Concatenate(op::Reshape(op::Parameter(1)),
+                                            op::Reshape(op::Parameter(3))))));
+}
+
+TEST_F(GemmBatcherTest, ProductsWithSharedLhsAreConcatenated) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+  HloModule TestModule
+
+  ENTRY TestComputation {
+    x = f32[16,32] parameter(0)
+    w0 = f32[32,64] parameter(1)
+    w1 = f32[32,64] parameter(2)
+    w2 = f32[32,64] parameter(3)
+    dot0 = f32[16,64] dot(x, w0),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    dot1 = f32[16,64] dot(x, w1),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    dot2 = f32[16,64] dot(x, w2),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    ROOT tuple = (f32[16,64], f32[16,64], f32[16,64]) tuple(dot0, dot1, dot2)
+  })")
+                    .ValueOrDie();
+
+  EXPECT_TRUE(GemmBatcher().Run(module.get()).ValueOrDie());
+  SCOPED_TRACE(module->ToString());
+
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  auto product = AllOf(
+      op::Shape("f32[16,192]"),
+      op::Dot(op::Parameter(0),
+              op::Concatenate(op::Parameter(1), op::Parameter(2),
+                              op::Parameter(3))));
+  EXPECT_THAT(root, op::Tuple(op::Slice(product), op::Slice(product),
+                              op::Slice(product)));
+  EXPECT_EQ(root->operand(2)->slice_starts(1), 128);
+}
+
+TEST_F(GemmBatcherTest, DependentProductsAreNotBatched) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+  HloModule TestModule
+
+  ENTRY TestComputation {
+    a = f32[16,16] parameter(0)
+    b = f32[16,16] parameter(1)
+    c = f32[16,16] parameter(2)
+    dot0 = f32[16,16] dot(a, b),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    ROOT dot1 = f32[16,16] dot(dot0, c),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  })")
+                    .ValueOrDie();
+
+  EXPECT_FALSE(GemmBatcher().Run(module.get()).ValueOrDie());
+}
+
+TEST_F(GemmBatcherTest, LargeProductsAreNotBatched) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+  HloModule TestModule
+
+  ENTRY TestComputation {
+    a0 = f32[1024,32] parameter(0)
+    b0 = f32[32,1024] parameter(1)
+    a1 = f32[1024,32] parameter(2)
+    b1 = f32[32,1024] parameter(3)
+    dot0 = f32[1024,1024] dot(a0, b0),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    dot1 = f32[1024,1024] dot(a1, b1),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    ROOT tuple = (f32[1024,1024], f32[1024,1024]) tuple(dot0, dot1)
+  })")
+                    .ValueOrDie();
+
+  EXPECT_FALSE(GemmBatcher().Run(module.get()).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
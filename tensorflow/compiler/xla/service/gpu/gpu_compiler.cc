@@ -24,11 +24,14 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "mlir/IR/Module.h"  // from @llvm-project
 #include "mlir/InitAllDialects.h"  // from @llvm-project
 #include "tensorflow/compiler/xla/protobuf_util.h"
@@ -50,6 +53,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/alias_passthrough_params.h"
 #include "tensorflow/compiler/xla/service/gpu/cudnn_batchnorm_rewriter.h"
 #include "tensorflow/compiler/xla/service/gpu/fusion_merger.h"
+#include "tensorflow/compiler/xla/service/gpu/gemm_batcher.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_rewriter.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_conv_algorithm_picker.h"
@@ -80,6 +84,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/variadic_op_splitter.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
 #include "tensorflow/compiler/xla/service/hlo_cse.h"
 #include "tensorflow/compiler/xla/service/hlo_dataflow_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_dce.h"
@@ -115,6 +120,7 @@ limitations under the License.
 #include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/platform/subprocess.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/util/env_var.h"
@@ -240,6 +246,8 @@ Status GpuCompiler::OptimizeHloModule(
         },
         TransposeFolding::NeverFoldTranspose);
     pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/false);
+    // Merge independent small GEMMs once transposes are folded into them.
+    pipeline.AddPass<GemmBatcher>();
     pipeline.AddPass<HloDCE>();
 
     // Run WhileLoopTripCountAnnotator at the end of the simplification
@@ -484,6 +492,7 @@ static Status CompileModuleToLlvmIrImpl(
     absl::optional<CudaComputeCapability> cuda_compute_capability,
     const HloDataflowAnalysis::CanShareBuffer& can_share_buffer_function,
     int pointer_size, const HloProfileIndexMap* profile_index_map,
+    const HloCostCalibration* calibration,
     std::unique_ptr<llvm::Module>* llvm_module,
     std::unique_ptr<BufferAssignment>* buffer_assignment,
     std::unique_ptr<ThunkSchedule>* thunk_schedule,
@@ -494,10 +503,11 @@ static Status CompileModuleToLlvmIrImpl(
   (*llvm_module)->setDataLayout(data_layout);
 
   std::unique_ptr<StreamAssignment> stream_assignment =
-      AssignStreams(*hlo_module);
+      AssignStreams(*hlo_module, pointer_size, calibration);
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<GpuHloSchedule> hlo_schedule,
-      GpuHloSchedule::Build(*hlo_module, *stream_assignment, pointer_size));
+      GpuHloSchedule::Build(*hlo_module, *stream_assignment, pointer_size,
+                            calibration));
 
   auto buffer_size_bytes_function =
       [pointer_size](const BufferValue& buffer_value) -> int64 {
@@ -648,6 +658,11 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
     }
   }
 
+  std::unique_ptr<HloCostCalibration> calibration =
+      HloCostCalibration::LoadForDevice(
+          module->config().debug_options(),
+          stream_exec->GetDeviceDescription().name());
+
   std::unique_ptr<llvm::Module> llvm_module;
   std::unique_ptr<BufferAssignment> buffer_assignment;
   std::unique_ptr<ThunkSchedule> thunk_schedule;
@@ -656,8 +671,9 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
   TF_RETURN_IF_ERROR(CompileModuleToLlvmIrImpl(
       module.get(), &llvm_context, target_triple_, data_layout_,
       stream_exec->platform()->Name(), gpu_device_info, cuda_compute_capability,
-      GetCanShareBuffer(), pointer_size_, profile_index_map.get(), &llvm_module,
-      &buffer_assignment, &thunk_schedule, &constants));
+      GetCanShareBuffer(), pointer_size_, profile_index_map.get(),
+      calibration.get(), &llvm_module, &buffer_assignment, &thunk_schedule,
+      &constants));
 
   if (user_pre_optimization_hook_) {
     user_pre_optimization_hook_(*llvm_module);
@@ -691,8 +707,8 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
 
   using BackendCompileResult = std::pair<std::string, std::vector<uint8>>;
   TF_ASSIGN_OR_RETURN(BackendCompileResult backend_result,
-                      CompileTargetBinary(module.get(), llvm_module.get(),
-                                          gpu_version, stream_exec));
+                      CompileToTargetBinary(*module, std::move(llvm_module),
+                                            gpu_version, stream_exec));
 
   if (DumpingEnabledForHloModule(*module)) {
     DumpToFileInDirOrStdout(*module, "", "thunk_schedule",
@@ -711,6 +727,98 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
   return std::unique_ptr<Executable>(gpu_executable);
 }
 
+StatusOr<std::pair<std::string, std::vector<uint8>>>
+GpuCompiler::CompileToTargetBinary(const HloModule& module,
+                                   std::unique_ptr<llvm::Module> llvm_module,
+                                   GpuVersion gpu_version,
+                                   se::StreamExecutor* stream_exec) {
+  const int parallelism =
+      module.config().debug_options().xla_gpu_compilation_parallelism();
+  int num_functions = 0;
+  for (const llvm::Function& function : llvm_module->functions()) {
+    if (!function.isDeclaration()) {
+      ++num_functions;
+    }
+  }
+  if (parallelism <= 1 || num_functions <= 1 || !CanLinkModules()) {
+    return CompileTargetBinary(module.config(), llvm_module.get(), gpu_version,
+                               stream_exec, /*relocatable=*/false, &module);
+  }
+
+  // LLVM contexts can't be used by several threads, so each split module is
+  // compiled in a context of its own, into which it is read back from
+  // bitcode.
+  std::vector<std::string> bitcodes;
+  {
+    XLA_SCOPED_LOGGING_TIMER(
+        "GpuCompiler::CompileToTargetBinary - SplitModule");
+    llvm::SplitModule(
+        std::move(llvm_module), std::min(parallelism, num_functions),
+        [&](std::unique_ptr<llvm::Module> split_module) {
+          if (split_module->empty() && split_module->global_empty()) {
+            return;
+          }
+          std::string bitcode;
+          llvm::raw_string_ostream bitcode_stream(bitcode);
+          llvm::WriteBitcodeToFile(*split_module, bitcode_stream);
+          bitcode_stream.flush();
+          bitcodes.push_back(std::move(bitcode));
+        },
+        /*PreserveLocals=*/true);
+  }
+  VLOG(1) << "Compiling " << module.name() << " as " << bitcodes.size()
+          << " LLVM modules in parallel";
+
+  using BackendCompileResult = std::pair<std::string, std::vector<uint8>>;
+  std::vector<StatusOr<BackendCompileResult>> results(bitcodes.size());
+  {
+    tensorflow::thread::ThreadPool thread_pool(
+        tensorflow::Env::Default(), "xla_gpu_compilation", parallelism);
+    for (int i = 0; i < bitcodes.size(); ++i) {
+      thread_pool.Schedule([&, i]() {
+        llvm::LLVMContext llvm_context;
+        llvm::Expected<std::unique_ptr<llvm::Module>> split_module =
+            llvm::parseBitcodeFile(
+                llvm::MemoryBufferRef(bitcodes[i], module.name()),
+                llvm_context);
+        if (!split_module) {
+          results[i] = InternalError(
+              "Failed to read back split LLVM module: %s",
+              llvm::toString(split_module.takeError()));
+          return;
+        }
+        results[i] = CompileTargetBinary(module.config(), split_module->get(),
+                                         gpu_version, stream_exec,
+                                         /*relocatable=*/true,
+                                         /*debug_module=*/nullptr);
+      });
+    }
+    // The destructor of the thread pool waits for the compilations.
+  }
+
+  std::string text;
+  std::vector<std::vector<uint8>> binaries;
+  for (StatusOr<BackendCompileResult>& result : results) {
+    TF_RETURN_IF_ERROR(result.status());
+    BackendCompileResult& backend_result = result.ValueOrDie();
+    absl::StrAppend(&text, backend_result.first, "\n");
+    binaries.push_back(std::move(backend_result.second));
+  }
+  if (DumpingEnabledForHloModule(module)) {
+    DumpToFileInDirOrStdout(module, "", "ptx", text);
+  }
+  StatusOr<std::vector<uint8>> binary =
+      LinkModules(stream_exec, std::move(binaries));
+  if (!binary.ok()) {
+    return AppendStatus(
+        binary.status(),
+        "Linking the GPU binaries compiled in parallel failed; pass "
+        "--xla_gpu_compilation_parallelism=1 to compile the module as a "
+        "whole.");
+  }
+  return BackendCompileResult(std::move(text), std::move(binary).ValueOrDie());
+}
+
 StatusOr<std::vector<std::unique_ptr<AotCompilationResult>>>
 GpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
                                 const AotCompilationOptions& options) {
@@ -736,8 +844,8 @@ StatusOr<std::unique_ptr<llvm::Module>> CompileModuleToLlvmIr(
   TF_RETURN_IF_ERROR(CompileModuleToLlvmIrImpl(
       hlo_module, llvm_context, target_triple, data_layout, platform_name,
       gpu_device_info, cuda_compute_capability, DummyCanShareBufferFunction,
-      pointer_size, /*profile_index_map=*/nullptr, &llvm_module,
-      &buffer_assignment, &thunk_schedule, nullptr));
+      pointer_size, /*profile_index_map=*/nullptr, /*calibration=*/nullptr,
+      &llvm_module, &buffer_assignment, &thunk_schedule, nullptr));
   return llvm_module;
 }
 }  // namespace gpu
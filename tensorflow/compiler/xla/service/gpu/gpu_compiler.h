@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
@@ -75,10 +76,27 @@ class GpuCompiler : public LLVMCompiler {
 
   virtual GpuVersion GetGpuVersion(se::StreamExecutor* stream_exec) = 0;
 
+  // Compiles `llvm_module` to the text and binary of the target, configured by
+  // `module_config`. If `relocatable`, the binary is to be linked with others
+  // by LinkModules(). The optimized IR and the text are dumped and the post
+  // optimization hook runs only if `debug_module` is not null, i.e. when
+  // `llvm_module` is the whole module emitted for `debug_module`.
   virtual StatusOr<std::pair<std::string, std::vector<uint8>>>
-  CompileTargetBinary(const HloModule* hlo_module, llvm::Module* llvm_module,
-                      GpuVersion gpu_version,
-                      se::StreamExecutor* stream_exec) = 0;
+  CompileTargetBinary(const HloModuleConfig& module_config,
+                      llvm::Module* llvm_module, GpuVersion gpu_version,
+                      se::StreamExecutor* stream_exec, bool relocatable,
+                      const HloModule* debug_module) = 0;
+
+  // Returns whether LinkModules() is implemented, i.e. whether `llvm_module`
+  // may be split and compiled in parallel by CompileToTargetBinary().
+  virtual bool CanLinkModules() { return false; }
+
+  // Links the relocatable binaries compiled by CompileTargetBinary() into one.
+  virtual StatusOr<std::vector<uint8>> LinkModules(
+      se::StreamExecutor* stream_exec,
+      std::vector<std::vector<uint8>> modules) {
+    return Unimplemented("LinkModules is not implemented.");
+  }
 
   Status PrepareHloModuleForIrEmitting(HloModule* hlo_module);
 
@@ -109,6 +127,13 @@ class GpuCompiler : public LLVMCompiler {
   }
 
  private:
+  // Compiles `llvm_module` like CompileTargetBinary(). If
+  // --xla_gpu_compilation_parallelism is greater than 1, splits it into as
+  // many modules, compiles them in parallel, and links the results.
+  StatusOr<std::pair<std::string, std::vector<uint8>>> CompileToTargetBinary(
+      const HloModule& module, std::unique_ptr<llvm::Module> llvm_module,
+      GpuVersion gpu_version, se::StreamExecutor* stream_exec);
+
   se::Platform::Id platform_id_;
 
   // The triple that represents our target.
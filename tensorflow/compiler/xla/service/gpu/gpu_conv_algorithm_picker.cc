@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
@@ -303,6 +304,22 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
     autotune_cache_stats.cache_misses++;
   }
 
+  // Results persisted by an earlier process take precedence over autotuning.
+  AutotuneDatabase* database = AutotuneDatabase::ForDebugOptions(
+      instr->GetModule()->config().debug_options());
+  AutotuneDevice device;
+  if (database != nullptr) {
+    device = AutotuneDatabase::DeviceOf(stream_exec_);
+    if (absl::optional<AutotuneResult> persisted =
+            database->Lookup(device, std::get<1>(key))) {
+      VLOG(2) << "Using the persisted autotuning result for "
+              << instr->ToString();
+      tensorflow::mutex_lock lock(autotune_cache_lock);
+      CHECK(autotune_cache.insert({key, *persisted}).second);
+      return *persisted;
+    }
+  }
+
   // Make sure any previous activity on this executor is done. We don't want to
   // interfere with programs that are still running on the GPU.
   if (!stream_exec_->SynchronizeAllActivity()) {
@@ -335,6 +352,9 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
   }
 
   if (result_or.ok()) {
+    if (database != nullptr) {
+      database->Insert(device, std::get<1>(key), result_or.ValueOrDie());
+    }
     tensorflow::mutex_lock lock(autotune_cache_lock);
     CHECK(autotune_cache.insert({key, result_or.ValueOrDie()}).second);
   }
@@ -845,6 +865,14 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(HloModule* module) {
     autotune_cache_stats.LogStats();
   }
 
+  if (AutotuneDatabase* database =
+          AutotuneDatabase::ForDebugOptions(module->config().debug_options())) {
+    Status status = database->SaveIfChanged();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to persist autotuning results: " << status;
+    }
+  }
+
   return changed;
 }
 
@@ -19,6 +19,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_constants.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_debug_info_manager.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable_run_options.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -69,8 +71,12 @@ GpuExecutable::GpuExecutable(
       gpu_version_(gpu_version),
       thunk_schedule_(std::move(thunk_schedule)),
       assignment_(std::move(assignment)),
-      constants_(std::move(globals)) {
+      constants_(std::move(globals)),
+      graphs_(kMaxGraphsPerExecutable) {
   CHECK(has_module() && assignment_);
+  thunks_are_capturable_ = absl::c_all_of(
+      thunk_schedule_->TotalOrder(),
+      [](const Thunk* thunk) { return IsCapturableThunk(*thunk); });
   GpuDebugInfoManager::Get()->RegisterModule(module().name(), shared_module(),
                                              assignment_);
 }
@@ -152,9 +158,6 @@ Status GpuExecutable::ExecuteThunks(
     sub_streams.emplace_back();
     TF_ASSIGN_OR_RETURN(sub_streams.back(),
                         run_options->BorrowStream(executor->device_ordinal()));
-    // Require substreams to wait for the main stream, otherwise substreams may
-    // execute before the program is scheduled to start on the main stream.
-    sub_streams.back()->ThenWaitFor(main_stream);
   }
 
   HloExecutionProfiler profiler(do_profile, hlo_execution_profile, main_stream,
@@ -165,49 +168,24 @@ Status GpuExecutable::ExecuteThunks(
       [&] { return absl::StrCat(hlo_module_->name(), ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
-  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
-  std::vector<std::function<void()>> deferred_host_callbacks;
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
-    // Annotate execution of this op if tracing was enabled when we started
-    // running this module.  If tracing is enabled *while* we're running the
-    // module, we won't get any data, but that's probably an OK trade-off.
-    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
-
-    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
-    se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
-
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
-    }
+  std::shared_ptr<const GpuGraph> graph;
+  if (!do_profile && thunks_are_capturable_ &&
+      module().config().debug_options().xla_gpu_enable_cuda_graphs() &&
+      executor->platform_kind() == se::PlatformKind::kCuda) {
+    TF_ASSIGN_OR_RETURN(
+        graph, GetOrCaptureGraph(run_options, buffer_allocations, main_stream,
+                                 sub_streams, &profiler));
+  }
 
-    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
-            << " on stream " << stream_no;
-    const GpuExecutableRunOptions* gpu_options =
-        run_options->run_options().gpu_executable_run_options();
-    Thunk::ExecuteParams thunk_params{
-        &buffer_allocations,
-        stream,
-        run_options->run_options().run_id(),
-        &profiler,
-        run_options->run_options().device_assignment(),
-        &deferred_host_callbacks,
-        gpu_options && gpu_options->gpu_global_device_ids()
-            ? &*gpu_options->gpu_global_device_ids()
-            : nullptr,
-        gpu_options && gpu_options->nccl_unique_id_callback()
-            ? &gpu_options->nccl_unique_id_callback()
-            : nullptr};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
-    if (thunk_schedule_->Depended(thunk)) {
-      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk] = std::move(finish_event);
-    }
+  std::vector<std::function<void()>> deferred_host_callbacks;
+  if (graph != nullptr) {
+    TF_RETURN_IF_ERROR(graph->Launch(main_stream));
+  } else {
+    TF_RETURN_IF_ERROR(EnqueueThunks(run_options, buffer_allocations,
+                                     main_stream, sub_streams, &profiler,
+                                     &deferred_host_callbacks));
   }
 
-  main_stream->ThenWaitFor(&sub_streams);
   if (!deferred_host_callbacks.empty()) {
     auto fn = [deferred_host_callbacks{std::move(deferred_host_callbacks)}]() {
       for (auto& callback : deferred_host_callbacks) {
@@ -256,6 +234,121 @@ Status GpuExecutable::ExecuteThunks(
   return Status::OK();
 }
 
+Status GpuExecutable::EnqueueThunks(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+    absl::Span<const StreamPool::Ptr> sub_streams,
+    HloExecutionProfiler* profiler,
+    std::vector<std::function<void()>>* deferred_host_callbacks) {
+  // Require substreams to wait for the main stream, otherwise substreams may
+  // execute before the program is scheduled to start on the main stream.
+  for (const StreamPool::Ptr& sub_stream : sub_streams) {
+    sub_stream->ThenWaitFor(main_stream);
+  }
+
+  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
+  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+    // Annotate execution of this op if tracing was enabled when we started
+    // running this module.  If tracing is enabled *while* we're running the
+    // module, we won't get any data, but that's probably an OK trade-off.
+    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
+
+    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
+    se::Stream* stream =
+        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+
+    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
+      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
+    }
+
+    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation()
+            << " on stream " << stream_no;
+    const GpuExecutableRunOptions* gpu_options =
+        run_options->run_options().gpu_executable_run_options();
+    Thunk::ExecuteParams thunk_params{
+        &buffer_allocations,
+        stream,
+        run_options->run_options().run_id(),
+        profiler,
+        run_options->run_options().device_assignment(),
+        deferred_host_callbacks,
+        gpu_options && gpu_options->gpu_global_device_ids()
+            ? &*gpu_options->gpu_global_device_ids()
+            : nullptr,
+        gpu_options && gpu_options->nccl_unique_id_callback()
+            ? &gpu_options->nccl_unique_id_callback()
+            : nullptr};
+    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
+    if (thunk_schedule_->Depended(thunk)) {
+      auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
+      finish_event->Init();
+      stream->ThenRecordEvent(finish_event.get());
+      thunk_to_finish_event[thunk] = std::move(finish_event);
+    }
+  }
+
+  for (const StreamPool::Ptr& sub_stream : sub_streams) {
+    main_stream->ThenWaitFor(sub_stream.get());
+  }
+  return Status::OK();
+}
+
+StatusOr<std::shared_ptr<const GpuGraph>> GpuExecutable::GetOrCaptureGraph(
+    const ServiceExecutableRunOptions* run_options,
+    const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+    absl::Span<const StreamPool::Ptr> sub_streams,
+    HloExecutionProfiler* profiler) {
+  // Graphs bake in the buffer addresses, so every distinct set of addresses
+  // needs its own graph.
+  GraphSignature signature;
+  signature.first = main_stream->parent();
+  signature.second.reserve(assignment_->Allocations().size());
+  for (BufferAllocation::Index i = 0; i < assignment_->Allocations().size();
+       ++i) {
+    signature.second.push_back(buffer_allocations.GetDeviceAddress(i).opaque());
+  }
+
+  {
+    tensorflow::mutex_lock lock(graph_mutex_);
+    if (graph_capture_failed_) {
+      return nullptr;
+    }
+    std::shared_ptr<const GpuGraph> graph;
+    if (!graphs_.Lookup(signature, &graph)) {
+      // The first run with these buffers executes normally, which also
+      // performs the lazy initialization of libraries and modules that can't
+      // be captured.
+      return nullptr;
+    }
+    if (graph != nullptr) {
+      return graph;
+    }
+  }
+
+  std::vector<std::function<void()>> deferred_host_callbacks;
+  StatusOr<std::unique_ptr<GpuGraph>> captured =
+      GpuGraph::Capture(main_stream, [&] {
+        return EnqueueThunks(run_options, buffer_allocations, main_stream,
+                             sub_streams, profiler, &deferred_host_callbacks);
+      });
+  if (captured.ok() && !deferred_host_callbacks.empty()) {
+    captured = InternalError(
+        "%s deferred host callbacks while being captured", module().name());
+  }
+
+  tensorflow::mutex_lock lock(graph_mutex_);
+  if (!captured.ok()) {
+    LOG(WARNING) << "Failed to capture " << module().name()
+                 << " into a CUDA graph, launching its thunks instead: "
+                 << captured.status();
+    graph_capture_failed_ = true;
+    return nullptr;
+  }
+  VLOG(1) << "Captured " << module().name() << " into a CUDA graph";
+  return graphs_.Insert(
+      signature, std::shared_ptr<const GpuGraph>(captured.ConsumeValueOrDie()));
+}
+
 StatusOr<const GpuExecutable::BufferAllocToDeviceMemoryMap*>
 GpuExecutable::ResolveConstantGlobals(se::Stream* stream) {
   se::StreamExecutor* executor = stream->parent();
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
@@ -26,7 +29,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/executable.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph_cache.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
+#include "tensorflow/compiler/xla/service/gpu/hlo_execution_profiler.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk_schedule.h"
@@ -34,6 +40,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/shaped_buffer.h"
+#include "tensorflow/compiler/xla/service/stream_pool.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
@@ -109,6 +116,25 @@ class GpuExecutable : public Executable {
                        bool block_host_until_done,
                        HloExecutionProfile* hlo_execution_profile);
 
+  // Enqueues the thunks onto `main_stream` and the `sub_streams` it forks to
+  // and joins back. Host callbacks the thunks defer are added to
+  // `deferred_host_callbacks`.
+  Status EnqueueThunks(
+      const ServiceExecutableRunOptions* run_options,
+      const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+      absl::Span<const StreamPool::Ptr> sub_streams,
+      HloExecutionProfiler* profiler,
+      std::vector<std::function<void()>>* deferred_host_callbacks);
+
+  // Returns the graph to replay for a run with `buffer_allocations` on
+  // `main_stream`, capturing it if this is the second run with these buffers.
+  // Returns null if the run should enqueue the thunks normally.
+  StatusOr<std::shared_ptr<const GpuGraph>> GetOrCaptureGraph(
+      const ServiceExecutableRunOptions* run_options,
+      const BufferAllocations& buffer_allocations, se::Stream* main_stream,
+      absl::Span<const StreamPool::Ptr> sub_streams,
+      HloExecutionProfiler* profiler);
+
   // Returns the value set of the root instruction of the entry
   // computation. Uses dataflow analysis from buffer assignment.
   const InstructionValueSet& GetRootValueSet() const;
@@ -178,6 +204,21 @@ class GpuExecutable : public Executable {
 
   std::vector<ConstantInfo> constants_;
 
+  // Whether all thunks can be captured into a CUDA graph.
+  bool thunks_are_capturable_ = false;
+
+  // The CUDA graphs captured from the thunks, keyed by the executor and the
+  // device addresses of the buffer allocations they were captured with. Only
+  // the most recently used signatures are kept, so that runs whose buffers
+  // are not reused don't use up the cache.
+  static constexpr int kMaxGraphsPerExecutable = 16;
+  using GraphSignature =
+      std::pair<se::StreamExecutor*, std::vector<const void*>>;
+  tensorflow::mutex graph_mutex_;
+  GpuGraphCache<GraphSignature, const GpuGraph> graphs_
+      TF_GUARDED_BY(graph_mutex_);
+  bool graph_capture_failed_ TF_GUARDED_BY(graph_mutex_) = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
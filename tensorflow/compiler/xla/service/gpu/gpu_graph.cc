@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph.h"
+
+#include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/service/gpu/copy_thunk.h"
+#include "tensorflow/compiler/xla/service/gpu/sequential_thunk.h"
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+
+namespace xla {
+namespace gpu {
+
+using se::gpu::GpuDriver;
+
+bool IsCapturableThunk(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kKernel:
+    case Thunk::kGemm:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+      return true;
+    case Thunk::kCopy:
+      // Host to device copies read pageable host memory, which can't be
+      // captured.
+      return dynamic_cast<const DeviceToDeviceCopyThunk*>(&thunk) != nullptr;
+    case Thunk::kSequential:
+      return absl::c_all_of(
+          static_cast<const SequentialThunk&>(thunk).thunks(),
+          [](const std::unique_ptr<Thunk>& nested) {
+            return IsCapturableThunk(*nested);
+          });
+    default:
+      return false;
+  }
+}
+
+GpuGraph::~GpuGraph() {
+  GpuDriver::DestroyGraphExec(context_, graph_exec_);
+  GpuDriver::DestroyGraph(context_, graph_);
+}
+
+/* static */ StatusOr<std::unique_ptr<GpuGraph>> GpuGraph::Capture(
+    se::Stream* stream, const std::function<Status()>& enqueue) {
+  se::gpu::GpuContext* context =
+      se::gpu::AsGpuStream(stream)->parent()->gpu_context();
+  se::gpu::GpuStreamHandle stream_handle = se::gpu::AsGpuStreamValue(stream);
+  TF_RETURN_IF_ERROR(GpuDriver::StreamBeginCapture(context, stream_handle));
+
+  // The capture must be ended even if enqueueing failed, or the stream is
+  // left unusable.
+  Status enqueue_status = enqueue();
+  auto graph = absl::WrapUnique(new GpuGraph(context));
+  Status capture_status =
+      GpuDriver::StreamEndCapture(context, stream_handle, &graph->graph_);
+  TF_RETURN_IF_ERROR(enqueue_status);
+  TF_RETURN_IF_ERROR(capture_status);
+  TF_RETURN_IF_ERROR(
+      GpuDriver::GraphInstantiate(context, graph->graph_, &graph->graph_exec_));
+  return std::move(graph);
+}
+
+Status GpuGraph::Launch(se::Stream* stream) const {
+  return GpuDriver::GraphLaunch(context_, graph_exec_,
+                                se::gpu::AsGpuStreamValue(stream));
+}
+
+}  // namespace gpu
+}  // namespace xla
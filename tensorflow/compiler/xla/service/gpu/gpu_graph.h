@@ -0,0 +1,73 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_H_
+
+#include <functional>
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/gpu/thunk.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/stream_executor/gpu/gpu_types.h"
+
+namespace stream_executor {
+namespace gpu {
+class GpuContext;
+}  // namespace gpu
+}  // namespace stream_executor
+
+namespace xla {
+namespace gpu {
+
+// Returns whether the work `thunk` enqueues can be captured into a GPU graph:
+// it must only enqueue device work whose arguments are fixed by the buffer
+// addresses, and never synchronize with or copy from the host.
+bool IsCapturableThunk(const Thunk& thunk);
+
+// Work captured from a stream into a GPU graph, which can then be launched
+// with a single driver call instead of one per kernel or copy. The graph holds
+// the device addresses it was captured with, so it may only be launched while
+// those addresses still hold the same buffers.
+class GpuGraph {
+ public:
+  ~GpuGraph();
+
+  // Captures the work that `enqueue` issues onto `stream`, and onto the
+  // streams that wait for events recorded on `stream` while `enqueue` runs,
+  // instead of executing it.
+  static StatusOr<std::unique_ptr<GpuGraph>> Capture(
+      se::Stream* stream, const std::function<Status()>& enqueue);
+
+  // Enqueues the captured work onto `stream`.
+  Status Launch(se::Stream* stream) const;
+
+ private:
+  explicit GpuGraph(se::gpu::GpuContext* context) : context_(context) {}
+
+  se::gpu::GpuContext* context_;
+  se::gpu::GpuGraphHandle graph_ = nullptr;
+  se::gpu::GpuGraphExecHandle graph_exec_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuGraph);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_H_
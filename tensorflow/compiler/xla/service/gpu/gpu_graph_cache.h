@@ -0,0 +1,105 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace xla {
+namespace gpu {
+
+// A bounded cache from the signatures of executable runs, i.e. the buffer
+// addresses a run uses, to the graphs captured for them. A signature is
+// recorded on its first run and its graph is captured on its second. Once the
+// cache holds `capacity` signatures, the least recently used one is evicted,
+// whether its graph was captured or not, so that signatures which are not
+// reused make room for new ones.
+//
+// Graphs are handed out as shared pointers, so that a graph evicted while
+// another run launches it stays alive until that launch is enqueued.
+//
+// Not thread-safe.
+template <typename Signature, typename Graph>
+class GpuGraphCache {
+ public:
+  explicit GpuGraphCache(int capacity) : capacity_(capacity) {
+    CHECK_GT(capacity, 0);
+  }
+
+  // Looks up `signature` and marks it as the most recently used. Returns false
+  // and records the signature if it was not cached. Otherwise sets `graph` to
+  // its captured graph, or to null if its graph was not captured yet.
+  bool Lookup(const Signature& signature, std::shared_ptr<Graph>* graph) {
+    auto it = index_.find(signature);
+    if (it == index_.end()) {
+      Touch(signature, nullptr);
+      return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    *graph = it->second->second;
+    return true;
+  }
+
+  // Stores the captured `graph` of `signature` and marks it as the most
+  // recently used, unless another graph was already stored for it. Returns the
+  // stored graph.
+  std::shared_ptr<Graph> Insert(const Signature& signature,
+                                std::shared_ptr<Graph> graph) {
+    return Touch(signature, std::move(graph));
+  }
+
+  int size() const { return lru_.size(); }
+
+ private:
+  using Entry = std::pair<Signature, std::shared_ptr<Graph>>;
+
+  std::shared_ptr<Graph> Touch(const Signature& signature,
+                               std::shared_ptr<Graph> graph) {
+    auto it = index_.find(signature);
+    if (it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      if (it->second->second == nullptr) {
+        it->second->second = std::move(graph);
+      }
+      return it->second->second;
+    }
+    if (lru_.size() == capacity_) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    lru_.emplace_front(signature, std::move(graph));
+    index_.emplace(signature, lru_.begin());
+    return lru_.front().second;
+  }
+
+  const int capacity_;
+  // Most recently used first.
+  std::list<Entry> lru_;
+  absl::flat_hash_map<Signature, typename std::list<Entry>::iterator> index_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuGraphCache);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_CACHE_H_
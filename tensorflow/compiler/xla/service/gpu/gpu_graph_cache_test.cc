@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+using Signature = std::vector<const void*>;
+using Cache = GpuGraphCache<Signature, int>;
+
+Signature MakeSignature(int i) {
+  return {reinterpret_cast<const void*>(static_cast<intptr_t>(i + 1))};
+}
+
+TEST(GpuGraphCacheTest, CapturesOnSecondRun) {
+  Cache cache(/*capacity=*/4);
+  std::shared_ptr<int> graph;
+  EXPECT_FALSE(cache.Lookup(MakeSignature(0), &graph));
+  EXPECT_TRUE(cache.Lookup(MakeSignature(0), &graph));
+  EXPECT_EQ(graph, nullptr);
+  std::shared_ptr<int> captured = std::make_shared<int>(0);
+  EXPECT_EQ(cache.Insert(MakeSignature(0), captured), captured);
+  EXPECT_TRUE(cache.Lookup(MakeSignature(0), &graph));
+  EXPECT_EQ(graph, captured);
+  // A graph captured concurrently for the same signature is dropped.
+  EXPECT_EQ(cache.Insert(MakeSignature(0), std::make_shared<int>(1)),
+            captured);
+}
+
+TEST(GpuGraphCacheTest, EvictsPlaceholdersOfSignaturesNotReused) {
+  Cache cache(/*capacity=*/4);
+  std::shared_ptr<int> graph;
+  // More distinct signatures than the capacity, each seen once.
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(cache.Lookup(MakeSignature(i), &graph));
+  }
+  EXPECT_EQ(cache.size(), 4);
+  // A new signature is still recorded, and captured on its second run.
+  EXPECT_FALSE(cache.Lookup(MakeSignature(100), &graph));
+  EXPECT_TRUE(cache.Lookup(MakeSignature(100), &graph));
+  EXPECT_EQ(graph, nullptr);
+  EXPECT_FALSE(cache.Lookup(MakeSignature(0), &graph));
+}
+
+TEST(GpuGraphCacheTest, EvictsLeastRecentlyUsed) {
+  Cache cache(/*capacity=*/2);
+  std::shared_ptr<int> graph;
+  std::shared_ptr<int> graph_0 = std::make_shared<int>(0);
+  cache.Lookup(MakeSignature(0), &graph);
+  cache.Insert(MakeSignature(0), graph_0);
+  cache.Lookup(MakeSignature(1), &graph);
+  // Using signature 0 makes signature 1 the least recently used.
+  EXPECT_TRUE(cache.Lookup(MakeSignature(0), &graph));
+  cache.Lookup(MakeSignature(2), &graph);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_TRUE(cache.Lookup(MakeSignature(0), &graph));
+  EXPECT_EQ(graph, graph_0);
+  EXPECT_TRUE(cache.Lookup(MakeSignature(2), &graph));
+  EXPECT_FALSE(cache.Lookup(MakeSignature(1), &graph));
+}
+
+TEST(GpuGraphCacheTest, EvictedGraphStaysAliveWhileInUse) {
+  Cache cache(/*capacity=*/1);
+  std::shared_ptr<int> graph;
+  cache.Lookup(MakeSignature(0), &graph);
+  cache.Insert(MakeSignature(0), std::make_shared<int>(42));
+  EXPECT_TRUE(cache.Lookup(MakeSignature(0), &graph));
+  EXPECT_FALSE(cache.Lookup(MakeSignature(1), &graph));
+  EXPECT_EQ(*graph, 42);
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -13,17 +13,25 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <deque>
 #include <memory>
+#include <set>
 #include <unordered_map>
+#include <utility>
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 
 #include "absl/memory/memory.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -184,6 +192,124 @@ void BFSLaunchOrder(const HloComputation* computation,
   }
 }
 
+// Rough throughput of the interconnect of a GPU, used to estimate how much
+// compute it takes to hide a collective.
+constexpr double kCollectiveBytesPerSecond = 2e10;
+constexpr double kCollectiveLatencySeconds = 1e-5;
+
+// Computes a topological launch_order that issues the instructions running
+// collectives as early as their operands allow, and then launches compute
+// independent of the pending collectives before their consumers.
+//
+// The order is built by simulating a compute stream and a collective stream,
+// with the time of each instruction estimated from HloCostAnalysis, or taken
+// from `calibration` if it was measured. Ready
+// collectives are issued first, in post order. Otherwise the ready compute
+// instruction whose operands are available the soonest is issued, which
+// defers the consumers of a collective until it is estimated to be done.
+Status LatencyHidingLaunchOrder(const HloComputation* computation,
+                                int64 pointer_size,
+                                const HloCostCalibration* calibration,
+                                std::vector<HloInstruction*>* launch_order) {
+  CalibratedHloCostAnalysis cost_analysis(
+      [pointer_size](const Shape& shape) {
+        return ShapeUtil::ByteSizeOf(shape, pointer_size);
+      },
+      calibration);
+  TF_RETURN_IF_ERROR(computation->Accept(&cost_analysis));
+  auto estimated_time = [&](const HloInstruction* hlo) {
+    double seconds = EstimatedSeconds(cost_analysis, *hlo);
+    if (!cost_analysis.is_measured(*hlo) &&
+        hlo->opcode() == HloOpcode::kAllReduce) {
+      int64 bytes = 0;
+      ShapeUtil::ForEachSubshape(
+          hlo->shape(), [&](const Shape& subshape, const ShapeIndex&) {
+            if (subshape.IsArray()) {
+              bytes += ShapeUtil::ByteSizeOf(subshape);
+            }
+          });
+      seconds += kCollectiveLatencySeconds + bytes / kCollectiveBytesPerSecond;
+    }
+    return seconds;
+  };
+
+  const std::vector<HloInstruction*> post_order =
+      computation->MakeInstructionPostOrder();
+  absl::flat_hash_map<const HloInstruction*, int64> position;
+  for (int64 i = 0; i < post_order.size(); ++i) {
+    position[post_order[i]] = i;
+  }
+  // The instructions each instruction waits for, and those waiting for it.
+  std::vector<std::vector<int64>> predecessors(post_order.size());
+  std::vector<std::vector<int64>> successors(post_order.size());
+  for (int64 i = 0; i < post_order.size(); ++i) {
+    std::vector<int64>& preds = predecessors[i];
+    for (const HloInstruction* operand : post_order[i]->operands()) {
+      preds.push_back(position.at(operand));
+    }
+    for (const HloInstruction* pred : post_order[i]->control_predecessors()) {
+      preds.push_back(position.at(pred));
+    }
+    absl::c_sort(preds);
+    preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+    for (int64 pred : preds) {
+      successors[pred].push_back(i);
+    }
+  }
+
+  std::vector<int64> pending_count(post_order.size());
+  // The estimated time the operands of each ready instruction are available
+  // at, and the time each issued instruction finishes at.
+  std::vector<double> ready_time(post_order.size(), 0);
+  std::vector<double> finish_time(post_order.size(), 0);
+  // Ready compute instructions keyed by (ready time, position), and ready
+  // collectives keyed by position.
+  std::set<std::pair<double, int64>> ready_compute;
+  std::set<int64> ready_collectives;
+  auto make_ready = [&](int64 i) {
+    for (int64 pred : predecessors[i]) {
+      ready_time[i] = std::max(ready_time[i], finish_time[pred]);
+    }
+    if (RunsCollectives(*post_order[i])) {
+      ready_collectives.insert(i);
+    } else {
+      ready_compute.insert({ready_time[i], i});
+    }
+  };
+  for (int64 i = 0; i < post_order.size(); ++i) {
+    pending_count[i] = predecessors[i].size();
+    if (pending_count[i] == 0) {
+      make_ready(i);
+    }
+  }
+
+  double compute_clock = 0;
+  double collective_clock = 0;
+  while (!ready_compute.empty() || !ready_collectives.empty()) {
+    int64 i;
+    double* clock;
+    if (!ready_collectives.empty()) {
+      i = *ready_collectives.begin();
+      ready_collectives.erase(ready_collectives.begin());
+      clock = &collective_clock;
+    } else {
+      i = ready_compute.begin()->second;
+      ready_compute.erase(ready_compute.begin());
+      clock = &compute_clock;
+    }
+    *clock = std::max(*clock, ready_time[i]) + estimated_time(post_order[i]);
+    finish_time[i] = *clock;
+    launch_order->push_back(post_order[i]);
+    for (int64 successor : successors[i]) {
+      if (--pending_count[successor] == 0) {
+        make_ready(successor);
+      }
+    }
+  }
+  TF_RET_CHECK(launch_order->size() == post_order.size());
+  return Status::OK();
+}
+
 }  // end namespace
 
 GpuHloSchedule::GpuHloSchedule() {}
@@ -191,7 +317,7 @@ GpuHloSchedule::GpuHloSchedule() {}
 /* static */
 StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
     const HloModule& module, const StreamAssignment& stream_assignment,
-    int64 pointer_size) {
+    int64 pointer_size, const HloCostCalibration* calibration) {
   std::unique_ptr<GpuHloSchedule> schedule(new GpuHloSchedule);
 
   // Initialize thunk_launch_order_, the total order of thunk launches.
@@ -206,6 +332,12 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
               return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
             }));
     schedule->thunk_launch_order_ = sequence.instructions();
+  } else if (module.config()
+                 .debug_options()
+                 .xla_gpu_enable_latency_hiding_scheduler()) {
+    TF_RETURN_IF_ERROR(
+        LatencyHidingLaunchOrder(entry_computation, pointer_size, calibration,
+                                 &schedule->thunk_launch_order_));
   } else {
     // BFS tends to increase concurrency, but also increases memory usage.
     BFSLaunchOrder(entry_computation, &schedule->thunk_launch_order_);
@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_ordering.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -39,10 +40,11 @@ namespace gpu {
 class GpuHloSchedule {
  public:
   // Constructs an GpuHloSchedule for the given module, based on the given
-  // stream assignment.
+  // stream assignment. The execution times in `calibration`, if not null, are
+  // preferred to estimated ones.
   static StatusOr<std::unique_ptr<GpuHloSchedule>> Build(
       const HloModule& module, const StreamAssignment& stream_assignment,
-      int64 pointer_size);
+      int64 pointer_size, const HloCostCalibration* calibration = nullptr);
 
   // Returns the total order of thunk launches, represented in terms of HLO
   // instructions.
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <unordered_set>
 
+#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
@@ -401,5 +402,57 @@ TEST_F(GpuHloScheduleTest, LatticeMatMul) {
   }
 }
 
+constexpr char kAllReduceAndIndependentCompute[] = R"(
+HloModule module
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY entry {
+  p0 = f32[1024,1024] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  all-reduce = f32[1024,1024] all-reduce(p0), to_apply=add
+  negate = f32[1024,1024] negate(all-reduce)
+  dot1 = f32[2,2] dot(p1, p1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot2 = f32[2,2] dot(dot1, p1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT tuple = (f32[1024,1024], f32[2,2]) tuple(negate, dot2)
+})";
+
+// The latency hiding scheduler issues the all-reduce first and fills the time
+// it takes with the independent dots before launching its consumer.
+TEST_F(GpuHloScheduleTest, LatencyHidingOverlapsAllReduce) {
+  HloModuleConfig config;
+  auto debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module,
+      ParseAndReturnVerifiedModule(kAllReduceAndIndependentCompute, config));
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  const HloInstruction* all_reduce =
+      FindInstruction(module.get(), "all-reduce");
+  const HloInstruction* negate = FindInstruction(module.get(), "negate");
+  const HloInstruction* dot1 = FindInstruction(module.get(), "dot1");
+  const HloInstruction* dot2 = FindInstruction(module.get(), "dot2");
+
+  auto schedule = BuildGpuHloSchedule(*module, *streams);
+  const HloVec& order = schedule->ThunkLaunchOrder();
+  auto position = [&](const HloInstruction* hlo) {
+    return absl::c_find(order, hlo) - order.begin();
+  };
+  EXPECT_LT(position(all_reduce), position(dot1));
+  EXPECT_LT(position(dot2), position(negate));
+
+  auto ordering = schedule->ConsumeHloOrdering();
+  EXPECT_FALSE(ordering->ExecutesBefore(all_reduce, dot2));
+  EXPECT_FALSE(ordering->ExecutesBefore(dot2, all_reduce));
+  EXPECT_TRUE(ordering->ExecutesBefore(all_reduce, negate));
+}
+
 }  // namespace gpu
 }  // namespace xla
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_transfer_manager.h"
 
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -76,17 +77,19 @@ Status GpuTransferManager::EnqueueBuffersToInfeed(
   gpu::InfeedManager* infeed_manager = gpu::GetOrCreateInfeedManager();
   se::Stream* stream = infeed_manager->GetStream(executor);
 
-  // TODO(b/30467474): Since this stream is shared across different
-  // infeed requests, blocking on the stream might be
-  // heavy-handed. Figure out if finer-grained acknowledgement is
-  // possible.
-  Status block_status = stream->BlockHostUntilDone();
-  if (!block_status.ok()) {
-    return InternalError("Failed to complete data transfer on stream %p: %s",
-                         stream, block_status.error_message());
+  // The transfers were staged from pinned buffers, so there is no need to wait
+  // for them here: the infeed thunk makes its stream wait for this event.
+  auto ready = absl::make_unique<se::Event>(executor);
+  if (!ready->Init()) {
+    return InternalError("Failed to create infeed event");
+  }
+  stream->ThenRecordEvent(ready.get());
+  if (!stream->ok()) {
+    return InternalError("Failed to enqueue data transfer on stream %p",
+                         stream);
   }
 
-  infeed_manager->EnqueueDestination(std::move(buffers));
+  infeed_manager->EnqueueDestination({std::move(buffers), std::move(ready)});
 
   VLOG(2) << "Infeed data transferred";
 
@@ -110,8 +113,17 @@ StatusOr<InfeedBuffer> GpuTransferManager::TransferBufferToInfeedInternal(
     return InternalError("Failed to obtain a stream");
   }
 
+  // Copy the data to pinned memory so that the caller may reuse `source` as
+  // soon as this returns, while the transfer proceeds asynchronously.
+  TF_ASSIGN_OR_RETURN(void* staging_buffer,
+                      infeed_manager->AcquireStagingBuffer(executor, size));
+  std::memcpy(staging_buffer, source, size);
+
   InfeedBuffer buffer(executor, size);
-  stream->ThenMemcpy(buffer.device_memory(), source, size);
+  stream->ThenMemcpy(buffer.device_memory(), staging_buffer, size);
+  stream->ThenDoHostCallback([infeed_manager, staging_buffer, size] {
+    infeed_manager->ReleaseStagingBuffer(staging_buffer, size);
+  });
 
   VLOG(2) << "Queued infeed data on stream " << stream;
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/infeed_manager.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/util.h"
 
 namespace xla {
 namespace gpu {
@@ -37,6 +38,68 @@ se::Stream* InfeedManager::GetStream(se::StreamExecutor* executor) {
   return host_to_device_stream_.get();
 }
 
+StatusOr<void*> InfeedManager::AcquireStagingBuffer(
+    se::StreamExecutor* executor, int64 size) {
+  std::vector<void*> evicted;
+  {
+    tensorflow::mutex_lock l(staging_mu_);
+    // A single transfer larger than the limit proceeds once nothing else is
+    // in flight.
+    while (staging_bytes_in_flight_ > 0 &&
+           staging_bytes_in_flight_ + size > kMaxStagingBytesInFlight) {
+      staging_cv_.wait(l);
+    }
+    staging_bytes_in_flight_ += size;
+    auto same_size = free_staging_buffers_.find(size);
+    if (same_size != free_staging_buffers_.end() &&
+        !same_size->second.empty()) {
+      void* buffer = same_size->second.back();
+      same_size->second.pop_back();
+      free_staging_bytes_ -= size;
+      return buffer;
+    }
+    // Deallocate released buffers of other sizes until the new buffer fits in
+    // the limit, so that the pool does not keep pinned memory for every size
+    // it has seen.
+    for (auto it = free_staging_buffers_.begin();
+         it != free_staging_buffers_.end();) {
+      std::vector<void*>& free_buffers = it->second;
+      while (!free_buffers.empty() &&
+             staging_bytes_in_flight_ + free_staging_bytes_ >
+                 kMaxStagingBytesInFlight) {
+        evicted.push_back(free_buffers.back());
+        free_buffers.pop_back();
+        free_staging_bytes_ -= it->first;
+      }
+      if (free_buffers.empty()) {
+        free_staging_buffers_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (void* buffer : evicted) {
+    executor->HostMemoryDeallocate(buffer);
+  }
+  void* buffer = executor->HostMemoryAllocate(size);
+  if (buffer == nullptr) {
+    tensorflow::mutex_lock l(staging_mu_);
+    staging_bytes_in_flight_ -= size;
+    staging_cv_.notify_all();
+    return ResourceExhausted(
+        "Failed to allocate %d bytes of pinned host memory for infeed", size);
+  }
+  return buffer;
+}
+
+void InfeedManager::ReleaseStagingBuffer(void* buffer, int64 size) {
+  tensorflow::mutex_lock l(staging_mu_);
+  free_staging_buffers_[size].push_back(buffer);
+  free_staging_bytes_ += size;
+  staging_bytes_in_flight_ -= size;
+  staging_cv_.notify_all();
+}
+
 InfeedManager* GetOrCreateInfeedManager() {
   static InfeedManager* manager = new InfeedManager;
   return manager;
@@ -20,9 +20,14 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_INFEED_MANAGER_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_INFEED_MANAGER_H_
 
+#include <memory>
+#include <vector>
+
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/compiler/xla/service/gpu/xfeed_queue.h"
 #include "tensorflow/compiler/xla/shape_tree.h"
+#include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 
@@ -40,6 +45,12 @@ namespace gpu {
 // and it does not handle the case when it runs out of
 // memory. Potential solution is to pre-allocate a fixed amount of
 // memory and block when that memory is full.
+//
+// Infeed data is staged in pinned host buffers that are recycled once their
+// transfer completed, so that enqueueing does not wait for the device. At most
+// kMaxStagingBytesInFlight bytes are staged at a time, and the staging buffers
+// in flight and kept for reuse together stay within that limit, except for a
+// single larger transfer.
 
 // Defines an infeed buffer that is passed to the runtime by
 // the client. The client manages the memory of the buffer.
@@ -61,16 +72,54 @@ class InfeedBuffer {
   int64 length_;
 };
 
+// A tree of infeed buffers whose contents may still be in transit.
+struct InfeedBuffers {
+  ShapeTree<InfeedBuffer> buffers;
+
+  // Recorded on the infeed stream after the transfers into `buffers`. Streams
+  // that read `buffers` must wait for it.
+  std::unique_ptr<se::Event> ready;
+};
+
 // Client-side class used to enqueue infeed buffers.
-class InfeedManager : public XfeedQueue<ShapeTree<InfeedBuffer>> {
+class InfeedManager : public XfeedQueue<InfeedBuffers> {
  public:
+  static constexpr int64 kMaxStagingBytesInFlight = 64 << 20;
+
   // Returns a cached stream associated with an executor. Allocates a
   // new stream on the first invocation. On subsequent invocations, if
   // the cached executor is not the same as the requested executor,
   // returns null.
   se::Stream* GetStream(se::StreamExecutor* executor);
 
+  // Returns pinned host memory of `size` bytes to stage an infeed transfer
+  // from, reusing a released buffer of the same size if there is one, and
+  // otherwise deallocating released buffers of other sizes to make room for a
+  // new one. Blocks while other staged transfers would exceed
+  // kMaxStagingBytesInFlight.
+  StatusOr<void*> AcquireStagingBuffer(se::StreamExecutor* executor,
+                                       int64 size);
+
+  // Returns a buffer obtained from AcquireStagingBuffer once the transfer from
+  // it completed. Makes no StreamExecutor calls, so it may be called from a
+  // stream callback.
+  void ReleaseStagingBuffer(void* buffer, int64 size);
+
  private:
+  tensorflow::mutex staging_mu_;
+  tensorflow::condition_variable staging_cv_;
+
+  // Released staging buffers by size, kept since infeed shapes tend to
+  // repeat.
+  absl::flat_hash_map<int64, std::vector<void*>> free_staging_buffers_
+      ABSL_GUARDED_BY(staging_mu_);
+
+  // The total size of `free_staging_buffers_`.
+  int64 free_staging_bytes_ ABSL_GUARDED_BY(staging_mu_) = 0;
+
+  // Bytes acquired but not released yet.
+  int64 staging_bytes_in_flight_ ABSL_GUARDED_BY(staging_mu_) = 0;
+
   // Mutex for serializing the creation of host_to_device_stream_.
   tensorflow::mutex host_to_device_stream_mu_;
 
@@ -37,8 +37,12 @@ Status InfeedThunk::ExecuteOnStream(const ExecuteParams& params) {
 
   auto op_profiler =
       params.profiler->MakeScopedInstructionProfiler(profile_index());
-  ShapeTree<InfeedBuffer> infeed_buffers =
+  InfeedBuffers infeed =
       GetOrCreateInfeedManager()->BlockingGetNextDestination();
+  ShapeTree<InfeedBuffer>& infeed_buffers = infeed.buffers;
+  if (infeed.ready != nullptr) {
+    stream.ThenWaitFor(infeed.ready.get());
+  }
 
   // infeed_slices_'s shape should be a tuple of shape (buffers, token).
   const auto& infeed_shape = infeed_slices_.shape();
@@ -157,6 +157,13 @@ std::array<int64, 3> GetReductionTiling(
   return {1, 128, 1};
 }
 
+bool IsPackedRowReduction(const ReductionDimensions& reduction_dimensions) {
+  return reduction_dimensions.is_row_reduction &&
+         reduction_dimensions.dimensions[2] > 1 &&
+         reduction_dimensions.dimensions[2] < kWarpSize &&
+         reduction_dimensions.dimensions[1] >= kWarpSize;
+}
+
 const char* const kCudnnBatchNormForwardInferenceCallTarget =
     "__cudnn$batchNormalizationForwardInference";
 const char* const kCudnnBatchNormForwardTrainingCallTarget =
@@ -244,8 +251,9 @@ bool IsReductionFromOrToContiguousDimensions(const HloInstruction& reduce) {
   if (reduction_dimensions.is_row_reduction) {
     // For row reduction, the tile block is 1 x tile_size_x, and we are reducing
     // along tile_size_x which needs to be large enough to make the tiling
-    // implementation efficient.
-    return reduction_dimensions.dimensions[2] >= kWarpSize;
+    // implementation efficient, unless several rows can be packed into a warp.
+    return reduction_dimensions.dimensions[2] >= kWarpSize ||
+           IsPackedRowReduction(reduction_dimensions);
   }
 
   // For column reduction, the tile block is tile_size_y x tile_size_x, and we
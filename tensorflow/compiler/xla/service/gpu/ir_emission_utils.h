@@ -201,6 +201,12 @@ std::array<int64, 3> GetReductionTiling(
     int smallest_input_dtype_bits,
     absl::optional<CudaComputeCapability> cuda_compute_capability);
 
+// Returns whether `reduction_dimensions` describe a row reduction whose rows
+// are narrower than a warp but numerous enough to fill warps with several of
+// them. Such reductions are emitted with each row reduced by a segment of the
+// lanes of a warp, instead of one thread or one warp per row.
+bool IsPackedRowReduction(const ReductionDimensions& reduction_dimensions);
+
 // Emits call to "vprintf" with given format and arguments.
 llvm::Value* EmitPrintf(absl::string_view fmt,
                         absl::Span<llvm::Value* const> arguments,
@@ -835,6 +835,28 @@ Status IrEmitterUnnested::HandleCopy(HloInstruction* copy) {
   return IrEmitter::HandleCopy(copy);
 }
 
+// The copy of a copy-start runs on the stream assigned to it, which differs
+// from that of its users, and copy-done only forwards the destination of the
+// copy. The instructions launched in between overlap with the copy, and the
+// users of copy-done wait for it through their dependency on copy-start.
+Status IrEmitterUnnested::HandleCopyStart(HloInstruction* copy_start) {
+  const Shape& operand_shape = copy_start->operand(0)->shape();
+  TF_RET_CHECK(Shape::Equal().IgnoreMemorySpaceInLayout()(
+      operand_shape, ShapeUtil::GetTupleElementShape(copy_start->shape(), 0)));
+  // The destination is a value copy-start defines, so it never shares the
+  // buffer of the operand.
+  AddThunkToThunkSequence(absl::make_unique<DeviceToDeviceCopyThunk>(
+      GetThunkInfo(copy_start),
+      /*source_address=*/GetAllocationSlice(*copy_start->operand(0)),
+      /*destination_buffer=*/GetAllocationSlice(*copy_start, {0}),
+      /*mem_size=*/ByteSizeOf(operand_shape)));
+  return Status::OK();
+}
+
+Status IrEmitterUnnested::HandleCopyDone(HloInstruction* copy_done) {
+  return Status::OK();
+}
+
 Status IrEmitterUnnested::EmitExtraOutputsForReduce(
     const HloInstruction* unnested_hlo, const IrArray::Index& index,
     bool use_linear_index,
@@ -2748,8 +2770,8 @@ void IrEmitterUnnested::EmitFullWarpShuffleDownLoopForAllReduces(
 
 void IrEmitterUnnested::EmitFullWarpShuffleDownLoopForReduce(
     HloComputation* reducer, llvm::Type* element_type,
-    llvm::Value* partial_result_address) {
-  for (int distance = 16; distance >= 1; distance /= 2) {
+    llvm::Value* partial_result_address, int64 num_lanes) {
+  for (int distance = num_lanes / 2; distance >= 1; distance /= 2) {
     int bit_width = llvm_ir::GetSizeInBits(element_type);
     llvm::Value* result_from_other_lane = llvm_ir::EmitAllocaAtFunctionEntry(
         element_type, "result_from_other_lane", &b_);
@@ -2882,7 +2904,21 @@ void IrEmitterUnnested::EmitEpilogueForReduction(
       KernelSupportLibrary ksl(&b_);
       llvm::Type* element_type =
           partial_result_addresses[i]->getType()->getElementType();
-      if (reduction_info.IsRowReduction()) {
+      if (reduction_info.IsPackedRowReduction()) {
+        // The lanes that reduce a row are within one warp, so their partial
+        // results are combined without going through shared memory.
+        EmitFullWarpShuffleDownLoopForReduce(reducers[i], element_type,
+                                             current_output,
+                                             mapping_scheme.GetNumThreadsX());
+        llvm::Value* has_output = b_.CreateICmpULT(
+            thread_id_info.thread_id_y,
+            tiling_kernel_info.output_tile_bounds[kDimY]);
+        ksl.If(b_.CreateAnd(has_output, is_zero(thread_id_info.thread_id_x)),
+               [&] {
+                 TF_CHECK_OK(EmitAtomicOperationForNestedComputation(
+                     *reducers[i], output_address, current_output));
+               });
+      } else if (reduction_info.IsRowReduction()) {
         EmitFullWarpShuffleDownLoopForReduce(reducers[i], element_type,
                                              current_output);
         llvm::Value* warp_id =
@@ -3699,6 +3735,23 @@ ReductionCodegenInfo IrEmitterUnnested::ComputeReductionCodegenInfo(
       GetReductionTiling(reduction_dimensions, smallest_input_dtype_bits,
                          ir_emitter_context_->cuda_compute_capability());
 
+  if (IsPackedRowReduction(reduction_dimensions)) {
+    // Each row is reduced by the smallest power of two lanes that covers it,
+    // one element per lane, and the block packs as many rows as it has such
+    // segments of lanes.
+    constexpr int64 kPackedRowReductionBlockSize = 256;
+    const int64 num_threads_x =
+        tensorflow::NextPowerOfTwo64(reduction_dimensions.dimensions[2]);
+    const int64 num_threads_y = kPackedRowReductionBlockSize / num_threads_x;
+    KernelMappingScheme mapping_scheme(
+        reduction_dimensions.dimensions,
+        {reduction_tiling[0], num_threads_y, num_threads_x}, num_threads_y,
+        num_threads_x, kStridedIndexingX, /*vector_size=*/1);
+    return ReductionCodegenInfo(mapping_scheme, /*num_partial_results=*/1,
+                                /*is_row_reduction=*/true,
+                                /*is_packed_row_reduction=*/true);
+  }
+
   int64 num_threads_y = reduction_dimensions.is_row_reduction ? 1 : kWarpSize;
   int64 num_threads_x = [&] {
     if (reduction_dimensions.is_row_reduction) {
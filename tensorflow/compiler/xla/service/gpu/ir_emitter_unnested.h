@@ -143,6 +143,8 @@ class IrEmitterUnnested : public IrEmitter,
   // IrEmitter. It also mixes in some special handling for custom kernels
   // via the ThunkEmitter.
   Status HandleCopy(HloInstruction* copy) override;
+  Status HandleCopyStart(HloInstruction* copy_start) override;
+  Status HandleCopyDone(HloInstruction* copy_done) override;
   Status HandleConditional(HloInstruction* conditional) override;
   Status HandleConvolution(HloInstruction* convolution) override;
   Status HandleCustomCall(HloInstruction* custom_call) override;
@@ -538,10 +540,11 @@ class IrEmitterUnnested : public IrEmitter,
       absl::Span<llvm::AllocaInst* const> partial_result_addresses);
 
   // Emits shuffle-down reduction for the `partial_result_address` using the
-  // reduction computation `reducer` over types `element_type`.
+  // reduction computation `reducer` over types `element_type`. Reduces each
+  // aligned segment of `num_lanes` lanes, a power of two, into its first lane.
   void EmitFullWarpShuffleDownLoopForReduce(
       HloComputation* reducer, llvm::Type* element_type,
-      llvm::Value* partial_result_address);
+      llvm::Value* partial_result_address, int64 num_lanes = kWarpSize);
 
   std::unique_ptr<KernelThunk> BuildKernelThunkFromBufferSlices(
       absl::string_view name, Thunk::ThunkInfo thunk_info,
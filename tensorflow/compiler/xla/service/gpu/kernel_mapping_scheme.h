@@ -169,10 +169,13 @@ using AddressVector = absl::InlinedVector<llvm::AllocaInst*, 1>;
 class ReductionCodegenInfo {
  public:
   explicit ReductionCodegenInfo(KernelMappingScheme mapping_scheme,
-                                int num_partial_results, bool is_row_reduction)
+                                int num_partial_results, bool is_row_reduction,
+                                bool is_packed_row_reduction = false)
       : mapping_scheme_(mapping_scheme),
         num_partial_results_(num_partial_results),
-        is_row_reduction_(is_row_reduction) {
+        is_row_reduction_(is_row_reduction),
+        is_packed_row_reduction_(is_packed_row_reduction) {
+    CHECK(is_row_reduction || !is_packed_row_reduction);
     if (num_partial_results > 1) {
       CHECK_EQ(num_partial_results, (mapping_scheme.GetTileSizeX() /
                                      mapping_scheme.GetNumThreadsX()));
@@ -216,6 +219,11 @@ class ReductionCodegenInfo {
   int GetNumPartialResults() const { return num_partial_results_; }
   bool IsRowReduction() const { return is_row_reduction_; }
 
+  // Returns whether each row is reduced by the GetNumThreadsX() consecutive
+  // lanes of a warp that share a y coordinate, rather than by the whole
+  // block.
+  bool IsPackedRowReduction() const { return is_packed_row_reduction_; }
+
   // Gets a pointer to a mutable shared cache used by reduction.
   std::vector<llvm::GlobalVariable*>* GetMutableSharedCache() {
     return &shared_cache_;
@@ -234,6 +242,7 @@ class ReductionCodegenInfo {
   AddressVector reduction_input_addresses_;
   int num_partial_results_;
   bool is_row_reduction_;
+  bool is_packed_row_reduction_;
 };
 
 }  // end namespace gpu
@@ -20,6 +20,8 @@ limitations under the License.
 #include <fstream>
 
 #include "absl/base/call_once.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/xla/service/algebraic_simplifier.h"
 #include "tensorflow/compiler/xla/service/dump.h"
 #include "tensorflow/compiler/xla/service/gpu/cublas_gemm_pad_for_tensor_cores.h"
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_layout_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/llvm_gpu_backend/gpu_backend_lib.h"
+#include "tensorflow/compiler/xla/service/gpu/persistent_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_executor_util.h"
 #include "tensorflow/compiler/xla/service/gpu/target_constants.h"
 #include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
@@ -46,11 +49,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/cuda_libdevice_path.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/stream_executor/cuda/cuda_diagnostics.h"
 #include "tensorflow/stream_executor/gpu/asm_compiler.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
 
 namespace xla {
 namespace gpu {
@@ -272,6 +277,55 @@ bool MaybeLoadPtxFromFile(const HloModule* module, std::string* ptx) {
   return false;
 }
 
+absl::optional<PersistentCompilationCache> GetPersistentCache(
+    const HloModuleConfig& config) {
+  const string& directory =
+      config.debug_options().xla_gpu_persistent_cache_dir();
+  if (directory.empty()) {
+    return absl::nullopt;
+  }
+  return PersistentCompilationCache(
+      directory,
+      int64{config.debug_options().xla_gpu_persistent_cache_max_size_mb()}
+          << 20);
+}
+
+// Returns the key of the PTX compiled from `llvm_module` in the persistent
+// cache: the options affecting the compilation are all in the debug options.
+std::vector<std::string> PtxCacheKey(const llvm::Module& llvm_module,
+                                     std::pair<int, int> compute_capability,
+                                     const std::string& libdevice_dir,
+                                     const HloModuleConfig& config) {
+  DebugOptions debug_options = config.debug_options();
+  debug_options.clear_xla_gpu_persistent_cache_dir();
+  debug_options.clear_xla_gpu_persistent_cache_max_size_mb();
+  std::string serialized_debug_options;
+  tensorflow::SerializeToStringDeterministic(debug_options,
+                                             &serialized_debug_options);
+  return {"ptx", llvm_ir::DumpModuleToString(llvm_module),
+          absl::StrCat(compute_capability.first, ".",
+                       compute_capability.second),
+          libdevice_dir, serialized_debug_options};
+}
+
+// Returns the key of the cubin compiled from `ptx` by the ptxas of version
+// `ptxas_version` in the persistent cache. The driver version is part of it
+// too, so that updating CUDA doesn't reuse cubins of the previous toolkit.
+std::vector<std::string> CubinCacheKey(const string& ptx, int cc_major,
+                                       int cc_minor,
+                                       const se::GpuAsmOpts& options,
+                                       const std::string& ptxas_version,
+                                       const std::string& driver_version) {
+  return {"cubin",
+          ptx,
+          absl::StrCat(cc_major, ".", cc_minor),
+          absl::StrCat(options.disable_gpuasm_optimizations),
+          options.preferred_cuda_dir,
+          absl::StrJoin(options.extra_flags, " "),
+          ptxas_version,
+          driver_version};
+}
+
 }  // namespace
 
 NVPTXCompiler::NVPTXCompiler()
@@ -296,10 +350,12 @@ GpuVersion NVPTXCompiler::GetGpuVersion(se::StreamExecutor* stream_exec) {
 }
 
 StatusOr<std::pair<std::string, std::vector<uint8>>>
-NVPTXCompiler::CompileTargetBinary(const HloModule* module,
+NVPTXCompiler::CompileTargetBinary(const HloModuleConfig& module_config,
                                    llvm::Module* llvm_module,
                                    GpuVersion gpu_version,
-                                   se::StreamExecutor* stream_exec) {
+                                   se::StreamExecutor* stream_exec,
+                                   bool relocatable,
+                                   const HloModule* debug_module) {
   std::pair<int, int> compute_capability =
       absl::get<std::pair<int, int>>(gpu_version);
 
@@ -311,42 +367,76 @@ NVPTXCompiler::CompileTargetBinary(const HloModule* module,
     // time, we have a one-element cache, keyed on the module's config's
     // cuda_data_dir.
     if (cached_libdevice_dir_.empty()) {
-      cached_libdevice_dir_ = GetLibdeviceDir(module->config());
+      cached_libdevice_dir_ = GetLibdeviceDir(module_config);
     }
     libdevice_dir = cached_libdevice_dir_;
   }
   VLOG(2) << "Libdevice dir = " << libdevice_dir << "\n";
 
   string ptx;
-  if (!MaybeLoadPtxFromFile(module, &ptx)) {
-    XLA_SCOPED_LOGGING_TIMER(
-        "NVPTXCompiler::CompileTargetBinary - CompileToPtx");
-    TF_ASSIGN_OR_RETURN(
-        ptx, nvptx::CompileToPtx(llvm_module, gpu_version, module->config(),
-                                 libdevice_dir));
+  if (debug_module == nullptr || !MaybeLoadPtxFromFile(debug_module, &ptx)) {
+    const absl::optional<PersistentCompilationCache> persistent_cache =
+        GetPersistentCache(module_config);
+    std::vector<std::string> ptx_cache_key;
+    absl::optional<std::string> cached_ptx;
+    if (persistent_cache) {
+      ptx_cache_key = PtxCacheKey(*llvm_module, compute_capability,
+                                  libdevice_dir, module_config);
+      cached_ptx = persistent_cache->Lookup(ptx_cache_key);
+    }
+    if (cached_ptx) {
+      ptx = std::move(*cached_ptx);
+    } else {
+      XLA_SCOPED_LOGGING_TIMER(
+          "NVPTXCompiler::CompileTargetBinary - CompileToPtx");
+      TF_ASSIGN_OR_RETURN(
+          ptx, nvptx::CompileToPtx(llvm_module, gpu_version, module_config,
+                                   libdevice_dir));
+      if (persistent_cache) {
+        persistent_cache->Store(ptx_cache_key, ptx);
+      }
+    }
   }
 
-  llvm_ir::DumpIrIfEnabled(*module, *llvm_module, /*optimized=*/true);
+  if (debug_module != nullptr) {
+    llvm_ir::DumpIrIfEnabled(*debug_module, *llvm_module, /*optimized=*/true);
 
-  if (user_post_optimization_hook_) {
-    user_post_optimization_hook_(*llvm_module);
-  }
-  // Write PTX to IR dump directory, if IR dumping was requested.
-  if (DumpingEnabledForHloModule(*module)) {
-    DumpToFileInDirOrStdout(*module, "", "ptx", ptx);
+    if (user_post_optimization_hook_) {
+      user_post_optimization_hook_(*llvm_module);
+    }
+    // Write PTX to IR dump directory, if IR dumping was requested.
+    if (DumpingEnabledForHloModule(*debug_module)) {
+      DumpToFileInDirOrStdout(*debug_module, "", "ptx", ptx);
+    }
   }
 
   std::vector<uint8> cubin = CompileGpuAsmOrGetCachedResult(
       stream_exec, ptx, compute_capability.first, compute_capability.second,
-      module->config());
+      module_config, relocatable);
 
   return std::pair<std::string, std::vector<uint8>>(std::move(ptx),
                                                     std::move(cubin));
 }
 
+StatusOr<std::vector<uint8>> NVPTXCompiler::LinkModules(
+    se::StreamExecutor* stream_exec, std::vector<std::vector<uint8>> modules) {
+  XLA_SCOPED_LOGGING_TIMER("NVPTXCompiler::LinkModules");
+  for (const std::vector<uint8>& module : modules) {
+    // The driver compiles the PTX when ptxas isn't found, but it can't link
+    // the results.
+    if (module.empty()) {
+      return FailedPrecondition(
+          "Linking GPU binaries requires ptxas to compile the PTX.");
+    }
+  }
+  auto* gpu_executor =
+      static_cast<se::gpu::GpuExecutor*>(stream_exec->implementation());
+  return se::LinkGpuAsm(gpu_executor->gpu_context(), modules);
+}
+
 std::vector<uint8> NVPTXCompiler::CompileGpuAsmOrGetCachedResult(
     se::StreamExecutor* stream_exec, const string& ptx, int cc_major,
-    int cc_minor, const HloModuleConfig& hlo_module_config) {
+    int cc_minor, const HloModuleConfig& hlo_module_config, bool relocatable) {
   XLA_SCOPED_LOGGING_TIMER("NVPTXCompiler::CompileGpuAsmOrGetCachedResult");
   tensorflow::profiler::TraceMe activity(
       "PTX->CUBIN", tensorflow::profiler::TraceMeLevel::kInfo);
@@ -361,7 +451,7 @@ std::vector<uint8> NVPTXCompiler::CompileGpuAsmOrGetCachedResult(
     tensorflow::mutex_lock lock(mutex_);
     std::tie(iter, inserted) = compilation_cache_.emplace(
         std::piecewise_construct,
-        std::forward_as_tuple(ptx, cc_major, cc_minor),
+        std::forward_as_tuple(ptx, cc_major, cc_minor, relocatable),
         std::forward_as_tuple());
     cache_ptx = &iter->first.ptx;
     cache_value = &iter->second;
@@ -374,14 +464,46 @@ std::vector<uint8> NVPTXCompiler::CompileGpuAsmOrGetCachedResult(
     tensorflow::mutex_lock lock(cache_value->mutex_);
     if (inserted) {
       CHECK(!cache_value->compilation_done);
-      if (!ptx.empty()) {
-        StatusOr<std::vector<uint8>> maybe_cubin =
-            se::CompileGpuAsm(stream_exec->device_ordinal(), cache_ptx->c_str(),
-                              PtxOptsFromConfig(hlo_module_config));
+      se::GpuAsmOpts ptx_options = PtxOptsFromConfig(hlo_module_config);
+      if (relocatable) {
+        ptx_options.extra_flags.push_back("-c");
+      }
+      const absl::optional<PersistentCompilationCache> persistent_cache =
+          GetPersistentCache(hlo_module_config);
+      std::vector<std::string> cubin_cache_key;
+      absl::optional<std::string> cached_cubin;
+      if (persistent_cache && !ptx.empty()) {
+        // Without the version of ptxas, the persistent cache isn't used.
+        StatusOr<std::string> ptxas_version = se::GetPtxasVersion(ptx_options);
+        if (ptxas_version.ok()) {
+          cubin_cache_key = CubinCacheKey(
+              ptx, cc_major, cc_minor, ptx_options,
+              ptxas_version.ValueOrDie(),
+              stream_exec->GetDeviceDescription().driver_version());
+          cached_cubin = persistent_cache->Lookup(cubin_cache_key);
+        } else {
+          VLOG(1) << "Not using the compilation cache: "
+                  << ptxas_version.status();
+        }
+      }
+      if (cached_cubin) {
+        cache_value->cubin_data.assign(cached_cubin->begin(),
+                                       cached_cubin->end());
+      } else if (!ptx.empty()) {
+        StatusOr<std::vector<uint8>> maybe_cubin = se::CompileGpuAsm(
+            stream_exec->device_ordinal(), cache_ptx->c_str(), ptx_options);
         if (maybe_cubin.ok()) {
           cache_value->cubin_data = std::move(maybe_cubin).ValueOrDie();
           VLOG(2) << "Compiled PTX size:" << ptx.size()
                   << " CUBIN size: " << cache_value->cubin_data.size();
+          if (!cubin_cache_key.empty()) {
+            persistent_cache->Store(
+                cubin_cache_key,
+                absl::string_view(
+                    reinterpret_cast<const char*>(
+                        cache_value->cubin_data.data()),
+                    cache_value->cubin_data.size()));
+          }
         } else {
           if (maybe_cubin.status().code() ==
               tensorflow::error::Code::NOT_FOUND) {
@@ -0,0 +1,178 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/persistent_compilation_cache.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/version.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Entries being written end with this suffix, and are not part of the cache.
+constexpr char kTempFileSuffix[] = ".tmp";
+// Each entry ends with the masked CRC32C of its value.
+constexpr int kChecksumSize = sizeof(tensorflow::uint32);
+
+}  // namespace
+
+PersistentCompilationCache::PersistentCompilationCache(std::string directory,
+                                                       int64_t max_size_bytes)
+    : directory_(std::move(directory)), max_size_bytes_(max_size_bytes) {}
+
+std::string PersistentCompilationCache::EntryPath(
+    absl::Span<const std::string> key_parts) const {
+  // The parts are prefixed with their sizes, so different keys don't
+  // concatenate to the same string.
+  std::string key =
+      absl::StrCat(TF_VERSION_STRING, ";", tf_git_version(), ";");
+  for (const std::string& part : key_parts) {
+    absl::StrAppend(&key, part.size(), ":", part);
+  }
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      directory_,
+      absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64));
+}
+
+absl::optional<std::string> PersistentCompilationCache::Lookup(
+    absl::Span<const std::string> key_parts) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const std::string path = EntryPath(key_parts);
+  std::string value;
+  const tensorflow::Status status =
+      tensorflow::ReadFileToString(env, path, &value);
+  if (!status.ok()) {
+    if (!tensorflow::errors::IsNotFound(status)) {
+      LOG(WARNING) << "Failed to read compilation cache entry " << path << ": "
+                   << status;
+    }
+    return absl::nullopt;
+  }
+  if (value.size() < kChecksumSize ||
+      tensorflow::crc32c::Unmask(tensorflow::core::DecodeFixed32(
+          value.data() + value.size() - kChecksumSize)) !=
+          tensorflow::crc32c::Value(value.data(),
+                                    value.size() - kChecksumSize)) {
+    LOG(WARNING) << "Deleting corrupted compilation cache entry " << path;
+    env->DeleteFile(path).IgnoreError();
+    return absl::nullopt;
+  }
+  value.resize(value.size() - kChecksumSize);
+  VLOG(1) << "Compilation cache hit: " << path;
+  return std::move(value);
+}
+
+void PersistentCompilationCache::Store(
+    absl::Span<const std::string> key_parts,
+    absl::string_view value) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const std::string path = EntryPath(key_parts);
+  if (static_cast<int64_t>(value.size()) + kChecksumSize > max_size_bytes_) {
+    VLOG(1) << "Not storing compilation cache entry " << path << " of "
+            << value.size() << " bytes, which doesn't fit in the cache";
+    return;
+  }
+  std::string entry(value);
+  char checksum[kChecksumSize];
+  tensorflow::core::EncodeFixed32(
+      checksum,
+      tensorflow::crc32c::Mask(tensorflow::crc32c::Value(value.data(),
+                                                         value.size())));
+  entry.append(checksum, kChecksumSize);
+
+  std::string temp_path = path;
+  tensorflow::Status status = env->RecursivelyCreateDir(directory_);
+  if (status.ok() && !env->CreateUniqueFileName(&temp_path, kTempFileSuffix)) {
+    status = tensorflow::errors::Internal("Failed to create a unique name");
+  }
+  if (status.ok()) {
+    status = tensorflow::WriteStringToFile(env, temp_path, entry);
+  }
+  if (status.ok()) {
+    status = env->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write compilation cache entry " << path << ": "
+                 << status;
+    if (temp_path != path) {
+      env->DeleteFile(temp_path).IgnoreError();
+    }
+    return;
+  }
+  VLOG(1) << "Stored compilation cache entry: " << path;
+  EvictOldestEntries();
+}
+
+void PersistentCompilationCache::EvictOldestEntries() const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::vector<std::string> children;
+  if (!env->GetChildren(directory_, &children).ok()) {
+    return;
+  }
+  struct Entry {
+    std::string path;
+    tensorflow::FileStatistics stat;
+  };
+  std::vector<Entry> entries;
+  int64_t total_size = 0;
+  for (const std::string& child : children) {
+    if (absl::EndsWith(child, kTempFileSuffix)) {
+      continue;
+    }
+    Entry entry;
+    entry.path = tensorflow::io::JoinPath(directory_, child);
+    if (!env->Stat(entry.path, &entry.stat).ok() || entry.stat.is_directory) {
+      continue;
+    }
+    total_size += entry.stat.length;
+    entries.push_back(std::move(entry));
+  }
+  if (total_size <= max_size_bytes_) {
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return a.stat.mtime_nsec < b.stat.mtime_nsec;
+            });
+  for (const Entry& entry : entries) {
+    if (total_size <= max_size_bytes_) {
+      break;
+    }
+    // Another process may have deleted the entry already.
+    env->DeleteFile(entry.path).IgnoreError();
+    total_size -= entry.stat.length;
+    VLOG(1) << "Evicted compilation cache entry: " << entry.path;
+  }
+}
+
+}  // namespace gpu
+}  // namespace xla
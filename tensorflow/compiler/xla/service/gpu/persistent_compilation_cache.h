@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_PERSISTENT_COMPILATION_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+
+namespace xla {
+namespace gpu {
+
+// A cache of compilation results stored in a directory, which survives the
+// process and can be shared by processes compiling the same programs.
+//
+// An entry is a file named by a fingerprint of its key, which should hold
+// everything the value depends on. The key also includes the TensorFlow
+// version, so a new release doesn't reuse the entries of an older one. The
+// entries are written to a temporary file first and renamed, so concurrent
+// writers of an entry don't corrupt it and readers see complete entries only.
+// Each entry ends with a checksum of its value, and entries that don't match
+// their checksum, e.g. after a crash of the file system, are deleted.
+//
+// When the entries grow beyond `max_size_bytes`, the entries written first are
+// deleted, after storing a new one.
+//
+// The cache is best effort: errors reading or writing an entry are logged and
+// treated as cache misses.
+class PersistentCompilationCache {
+ public:
+  PersistentCompilationCache(std::string directory, int64_t max_size_bytes);
+
+  // Returns the value stored for the key made of `key_parts`, if any.
+  absl::optional<std::string> Lookup(
+      absl::Span<const std::string> key_parts) const;
+
+  // Stores `value` for the key made of `key_parts`, replacing any value
+  // stored for it.
+  void Store(absl::Span<const std::string> key_parts,
+             absl::string_view value) const;
+
+ private:
+  std::string EntryPath(absl::Span<const std::string> key_parts) const;
+
+  // Deletes the oldest entries until they fit in max_size_bytes_.
+  void EvictOldestEntries() const;
+
+  const std::string directory_;
+  const int64_t max_size_bytes_;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_PERSISTENT_COMPILATION_CACHE_H_
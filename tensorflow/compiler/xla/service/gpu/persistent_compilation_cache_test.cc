@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/persistent_compilation_cache.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+constexpr int64_t kMaxSizeBytes = 1 << 20;
+
+std::string CacheDir(const std::string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+// Returns the paths of the entries in `directory`.
+std::vector<std::string> EntryPaths(const std::string& directory) {
+  std::vector<std::string> children;
+  TF_CHECK_OK(tensorflow::Env::Default()->GetChildren(directory, &children));
+  for (std::string& child : children) {
+    child = tensorflow::io::JoinPath(directory, child);
+  }
+  return children;
+}
+
+TEST(PersistentCompilationCacheTest, StoreAndLookup) {
+  const PersistentCompilationCache cache(CacheDir("store_and_lookup"),
+                                         kMaxSizeBytes);
+  const std::vector<std::string> key = {"ptx", "module", "7.0"};
+  EXPECT_FALSE(cache.Lookup(key).has_value());
+
+  cache.Store(key, "compiled");
+  absl::optional<std::string> value = cache.Lookup(key);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(*value, "compiled");
+
+  cache.Store(key, "recompiled");
+  value = cache.Lookup(key);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(*value, "recompiled");
+}
+
+TEST(PersistentCompilationCacheTest, SharedDirectory) {
+  // The entries written through one cache are read through another, as by
+  // another process.
+  const std::string directory = CacheDir("shared_directory");
+  const std::vector<std::string> key = {"cubin", "ptx"};
+  PersistentCompilationCache(directory, kMaxSizeBytes)
+      .Store(key, std::string("\0\1\2", 3));
+
+  const absl::optional<std::string> value =
+      PersistentCompilationCache(directory, kMaxSizeBytes).Lookup(key);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(*value, std::string("\0\1\2", 3));
+
+  // Only the entry is left in the directory.
+  EXPECT_EQ(EntryPaths(directory).size(), 1);
+}
+
+TEST(PersistentCompilationCacheTest, KeyPartsAreDelimited) {
+  const PersistentCompilationCache cache(CacheDir("key_parts"), kMaxSizeBytes);
+  cache.Store({"ab", "c"}, "first");
+  cache.Store({"a", "bc"}, "second");
+
+  const absl::optional<std::string> value = cache.Lookup({"ab", "c"});
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(*value, "first");
+}
+
+TEST(PersistentCompilationCacheTest, CorruptedEntryIsDeleted) {
+  const std::string directory = CacheDir("corrupted_entry");
+  const PersistentCompilationCache cache(directory, kMaxSizeBytes);
+  const std::vector<std::string> key = {"cubin", "ptx"};
+  cache.Store(key, "compiled");
+
+  const std::vector<std::string> paths = EntryPaths(directory);
+  ASSERT_EQ(paths.size(), 1);
+  std::string entry;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(),
+                                            paths[0], &entry));
+  entry[0] ^= 1;
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                             paths[0], entry));
+
+  EXPECT_FALSE(cache.Lookup(key).has_value());
+  EXPECT_TRUE(EntryPaths(directory).empty());
+
+  // A truncated entry is corrupted too.
+  cache.Store(key, "compiled");
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                             paths[0], "co"));
+  EXPECT_FALSE(cache.Lookup(key).has_value());
+}
+
+TEST(PersistentCompilationCacheTest, OldestEntriesAreEvicted) {
+  const std::string directory = CacheDir("eviction");
+  // Room for two entries of 100 bytes and their checksums.
+  const PersistentCompilationCache cache(directory, /*max_size_bytes=*/250);
+  const std::string value(100, 'x');
+  cache.Store({"first"}, value);
+  // Make sure the entries have distinct modification times.
+  tensorflow::Env::Default()->SleepForMicroseconds(10 * 1000);
+  cache.Store({"second"}, value);
+  tensorflow::Env::Default()->SleepForMicroseconds(10 * 1000);
+  cache.Store({"third"}, value);
+
+  EXPECT_EQ(EntryPaths(directory).size(), 2);
+  EXPECT_FALSE(cache.Lookup({"first"}).has_value());
+  EXPECT_TRUE(cache.Lookup({"second"}).has_value());
+  EXPECT_TRUE(cache.Lookup({"third"}).has_value());
+
+  // A value larger than the cache is not stored.
+  cache.Store({"large"}, std::string(300, 'x'));
+  EXPECT_FALSE(cache.Lookup({"large"}).has_value());
+  EXPECT_TRUE(cache.Lookup({"third"}).has_value());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
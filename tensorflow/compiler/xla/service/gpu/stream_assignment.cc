@@ -15,12 +15,18 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
+#include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/random.h"
 
 namespace xla {
@@ -122,13 +128,201 @@ int ComputeStreamToAssign(
   return stream_assignment.StreamCount();
 }
 
+// Rough throughputs of a GPU.
+constexpr double kFlopsPerSecond = 1e13;
+constexpr double kMemoryBytesPerSecond = 5e11;
+
+// Instructions estimated to take less than this, about the cost of
+// synchronizing two streams, are not worth a stream of their own.
+constexpr double kMinSecondsForOwnStream = 1e-5;
+
+// Upper bound on the number of streams the critical path strategy opens.
+constexpr int kMaxCriticalPathStreams = 4;
+
+// Assigns streams along the critical path of a computation, see
+// AssignStreams.
+class CriticalPathStreams {
+ public:
+  // Returns null if the execution times of `computation` cannot be estimated.
+  static std::unique_ptr<CriticalPathStreams> Create(
+      const HloComputation& computation, int64 pointer_size,
+      const HloCostCalibration* calibration);
+
+  // Returns the stream to assign to `hlo`, or -1 if a stream is not needed.
+  // `stream_assignment` is the existing stream assignment for all
+  // instructions topologically before `hlo`.
+  int StreamToAssign(const HloInstruction& hlo,
+                     const StreamAssignment& stream_assignment,
+                     const HloReachabilityMap& reachability) const;
+
+  // Records that `hlo` was assigned `stream_num`.
+  void Assign(const HloInstruction* hlo, int stream_num);
+
+ private:
+  absl::flat_hash_map<const HloInstruction*, double> seconds_;
+  // The estimated time from the start of each instruction to the end of the
+  // computation, along the longest path.
+  absl::flat_hash_map<const HloInstruction*, double> bottom_level_;
+  // The instruction assigned last to each stream.
+  std::vector<const HloInstruction*> last_on_stream_;
+};
+
+/* static */ std::unique_ptr<CriticalPathStreams> CriticalPathStreams::Create(
+    const HloComputation& computation, int64 pointer_size,
+    const HloCostCalibration* calibration) {
+  CalibratedHloCostAnalysis cost_analysis(
+      [pointer_size](const Shape& shape) {
+        return ShapeUtil::ByteSizeOf(shape, pointer_size);
+      },
+      calibration);
+  Status status = computation.Accept(&cost_analysis);
+  if (!status.ok()) {
+    LOG(WARNING) << "Not assigning streams by critical path: " << status;
+    return nullptr;
+  }
+  auto streams = absl::make_unique<CriticalPathStreams>();
+  std::vector<HloInstruction*> post_order =
+      computation.MakeInstructionPostOrder();
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    const HloInstruction* hlo = *it;
+    double successors_level = 0;
+    for (const HloInstruction* user : hlo->users()) {
+      successors_level =
+          std::max(successors_level, streams->bottom_level_.at(user));
+    }
+    for (const HloInstruction* successor : hlo->control_successors()) {
+      successors_level =
+          std::max(successors_level, streams->bottom_level_.at(successor));
+    }
+    const double seconds = EstimatedSeconds(cost_analysis, *hlo);
+    streams->seconds_[hlo] = seconds;
+    streams->bottom_level_[hlo] = seconds + successors_level;
+  }
+  return streams;
+}
+
+int CriticalPathStreams::StreamToAssign(
+    const HloInstruction& hlo, const StreamAssignment& stream_assignment,
+    const HloReachabilityMap& reachability) const {
+  if (hlo.opcode() == HloOpcode::kParameter ||
+      hlo.opcode() == HloOpcode::kConstant) {
+    return kInvalidStreamNum;
+  }
+
+  // A stream is idle for `hlo` if everything on it runs before `hlo` anyway,
+  // so that placing `hlo` there does not serialize it with independent work.
+  auto is_idle = [&](int stream_num) {
+    return stream_num >= last_on_stream_.size() ||
+           last_on_stream_[stream_num] == nullptr ||
+           reachability.IsReachable(last_on_stream_[stream_num], &hlo);
+  };
+
+  // Continuing the stream of the operand on the critical path of `hlo` needs
+  // no synchronization with it.
+  int critical_stream_num = kInvalidStreamNum;
+  double critical_level = -1;
+  int operand_stream_num = kInvalidStreamNum;
+  double operand_level = -1;
+  for (const HloInstruction* operand : hlo.operands()) {
+    if (!stream_assignment.HasStreamAssigned(*operand)) {
+      continue;
+    }
+    const int stream_num = stream_assignment.StreamNumberForHlo(*operand);
+    const double level = bottom_level_.at(operand);
+    if (level > operand_level) {
+      operand_stream_num = stream_num;
+      operand_level = level;
+    }
+    if (level > critical_level && is_idle(stream_num)) {
+      critical_stream_num = stream_num;
+      critical_level = level;
+    }
+  }
+  if (IsStreamNumValid(critical_stream_num)) {
+    return critical_stream_num;
+  }
+  for (int stream_num = 0; stream_num < stream_assignment.StreamCount();
+       ++stream_num) {
+    if (is_idle(stream_num)) {
+      return stream_num;
+    }
+  }
+  // Every stream is busy with work independent of `hlo`.
+  if (seconds_.at(&hlo) >= kMinSecondsForOwnStream &&
+      stream_assignment.StreamCount() < kMaxCriticalPathStreams) {
+    return stream_assignment.StreamCount();
+  }
+  return IsStreamNumValid(operand_stream_num) ? operand_stream_num : 0;
+}
+
+void CriticalPathStreams::Assign(const HloInstruction* hlo, int stream_num) {
+  if (stream_num >= last_on_stream_.size()) {
+    last_on_stream_.resize(stream_num + 1, nullptr);
+  }
+  last_on_stream_[stream_num] = hlo;
+}
+
 }  // namespace
 
-std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
+double EstimatedSeconds(const CalibratedHloCostAnalysis& cost_analysis,
+                        const HloInstruction& hlo) {
+  if (cost_analysis.is_measured(hlo)) {
+    return cost_analysis.optimal_seconds(hlo);
+  }
+  double flops =
+      cost_analysis.flop_count(hlo) + cost_analysis.transcendental_count(hlo);
+  double bytes = cost_analysis.bytes_accessed(hlo);
+  if (IsCublasGemm(hlo)) {
+    // HloCostAnalysis knows nothing about custom calls.
+    bytes = ShapeUtil::ByteSizeOf(hlo.shape());
+    for (const HloInstruction* operand : hlo.operands()) {
+      bytes += ShapeUtil::ByteSizeOf(operand->shape());
+    }
+    flops = 0;
+    auto config = hlo.backend_config<GemmBackendConfig>();
+    if (config.ok()) {
+      int64 contracted_elements = 1;
+      for (int64 dim : config.ValueOrDie()
+                           .dot_dimension_numbers()
+                           .lhs_contracting_dimensions()) {
+        contracted_elements *= hlo.operand(0)->shape().dimensions(dim);
+      }
+      flops = 2.0 * ShapeUtil::ElementsIn(hlo.shape()) * contracted_elements;
+    }
+  }
+  return std::max(std::max(flops, 0.0) / kFlopsPerSecond,
+                  std::max(bytes, 0.0) / kMemoryBytesPerSecond);
+}
+
+bool RunsCollectives(const HloInstruction& hlo) {
+  if (hlo.opcode() == HloOpcode::kAllReduce) {
+    return true;
+  }
+  for (const HloComputation* computation : hlo.called_computations()) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      if (RunsCollectives(*instruction)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<StreamAssignment> AssignStreams(
+    const HloModule& module, int64 pointer_size,
+    const HloCostCalibration* calibration) {
   auto stream_assignment = absl::make_unique<StreamAssignment>();
   const HloComputation& computation = *module.entry_computation();
   std::unique_ptr<HloReachabilityMap> reachability =
       HloReachabilityMap::Build(&computation);
+  const DebugOptions& debug_options = module.config().debug_options();
+  std::unique_ptr<CriticalPathStreams> critical_path_streams;
+  if (debug_options.xla_gpu_critical_path_stream_assignment() &&
+      !debug_options.xla_gpu_disable_multi_streaming() &&
+      !debug_options.xla_gpu_use_random_streams()) {
+    critical_path_streams =
+        CriticalPathStreams::Create(computation, pointer_size, calibration);
+  }
   std::vector<const HloInstruction*> seen_gemms;
   // The execution of different RNG Hlo instructions in the same module updates
   // a common global variable. To avoid a race condition, we simply assign all
@@ -137,16 +331,41 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
   // TODO(b/111791052): If we remove such a common variable, we will need to
   // clean up the code here.
   int stream_num_for_rng = kInvalidStreamNum;
+
+  // With the latency hiding scheduler, collectives run on a stream of their
+  // own so that compute launched after them overlaps with them. They all share
+  // it, so that each replica runs them in the launch order.
+  const bool separate_collectives =
+      module.config().debug_options().xla_gpu_enable_latency_hiding_scheduler();
+  std::vector<const HloInstruction*> collectives;
+  std::vector<const HloInstruction*> copy_starts;
   for (const auto* hlo : computation.MakeInstructionPostOrder()) {
+    if (hlo->opcode() == HloOpcode::kCopyStart) {
+      copy_starts.push_back(hlo);
+      continue;
+    }
+    if (separate_collectives && RunsCollectives(*hlo)) {
+      collectives.push_back(hlo);
+      continue;
+    }
     // If we ever enable fusion of RNG instructions, we will need to extend this
     // code to look inside a fused instruction.
-    int stream_num = (hlo->opcode() == HloOpcode::kRng &&
-                      IsStreamNumValid(stream_num_for_rng))
-                         ? stream_num_for_rng
-                         : ComputeStreamToAssign(*hlo, *stream_assignment,
-                                                 *reachability, seen_gemms);
+    int stream_num;
+    if (hlo->opcode() == HloOpcode::kRng &&
+        IsStreamNumValid(stream_num_for_rng)) {
+      stream_num = stream_num_for_rng;
+    } else if (critical_path_streams != nullptr) {
+      stream_num = critical_path_streams->StreamToAssign(
+          *hlo, *stream_assignment, *reachability);
+    } else {
+      stream_num = ComputeStreamToAssign(*hlo, *stream_assignment,
+                                         *reachability, seen_gemms);
+    }
     if (IsStreamNumValid(stream_num)) {
       stream_assignment->AssignStreamToHlo(hlo, stream_num);
+      if (critical_path_streams != nullptr) {
+        critical_path_streams->Assign(hlo, stream_num);
+      }
       if (hlo->opcode() == HloOpcode::kRng &&
           !IsStreamNumValid(stream_num_for_rng)) {
         stream_num_for_rng = stream_num;
@@ -156,6 +375,18 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
       seen_gemms.push_back(hlo);
     }
   }
+  // Copy-starts run on a stream of their own, so that the instructions
+  // launched before the matching copy-dones overlap with the copies.
+  if (!copy_starts.empty()) {
+    const int copy_stream_num = stream_assignment->StreamCount();
+    for (const HloInstruction* hlo : copy_starts) {
+      stream_assignment->AssignStreamToHlo(hlo, copy_stream_num);
+    }
+  }
+  const int collective_stream_num = stream_assignment->StreamCount();
+  for (const HloInstruction* hlo : collectives) {
+    stream_assignment->AssignStreamToHlo(hlo, collective_stream_num);
+  }
   return stream_assignment;
 }
 
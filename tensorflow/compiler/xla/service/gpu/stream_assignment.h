@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_STREAM_ASSIGNMENT_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 
@@ -37,8 +38,32 @@ class StreamAssignment {
   absl::flat_hash_map<const HloInstruction*, int> hlo_to_stream_number_;
 };
 
-// Assigns GPU streams to instructions in `module`.
-std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module);
+// Returns whether `hlo` is an all-reduce, or calls computations containing
+// one.
+bool RunsCollectives(const HloInstruction& hlo);
+
+// Returns the estimated execution time of `hlo` on a GPU, in seconds. Times
+// measured in the calibration of `cost_analysis` are used as is; otherwise
+// the time is bound by the flops or the bytes accessed of `hlo`, whichever
+// takes longer.
+double EstimatedSeconds(const CalibratedHloCostAnalysis& cost_analysis,
+                        const HloInstruction& hlo);
+
+// Assigns GPU streams to instructions in `module`. Copy-starts share a stream
+// no other instruction uses, and so do the instructions of the entry
+// computation that run collectives with
+// xla_gpu_enable_latency_hiding_scheduler.
+//
+// With xla_gpu_critical_path_stream_assignment, the other instructions are
+// assigned streams along the critical path estimated from their execution
+// times, with `calibration` if not null: each instruction continues the
+// stream of its most critical operand if that stream is idle by then, and
+// otherwise takes an idle stream or opens a new one, so that independent
+// branches run concurrently with few cross-stream dependencies. Instructions
+// too cheap to amortize the synchronization stay with their operands.
+std::unique_ptr<StreamAssignment> AssignStreams(
+    const HloModule& module, int64 pointer_size = 8,
+    const HloCostCalibration* calibration = nullptr);
 
 }  // namespace gpu
 }  // namespace xla
@@ -139,5 +139,138 @@ TEST_F(StreamAssignmentTest, LatticeMatMul) {
             assignment->StreamNumberForHlo(*d31));
 }
 
+constexpr char kAllReduceAndIndependentCompute[] = R"(
+HloModule module
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY entry {
+  p0 = f32[1024,1024] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  all-reduce = f32[1024,1024] all-reduce(p0), to_apply=add
+  negate = f32[1024,1024] negate(all-reduce)
+  dot1 = f32[2,2] dot(p1, p1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot2 = f32[2,2] dot(dot1, p1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT tuple = (f32[1024,1024], f32[2,2]) tuple(negate, dot2)
+})";
+
+TEST_F(StreamAssignmentTest, AllReduceOnSeparateStream) {
+  HloModuleConfig config;
+  auto debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module,
+      ParseAndReturnVerifiedModule(kAllReduceAndIndependentCompute, config));
+
+  std::unique_ptr<StreamAssignment> assignment = AssignStreams(*module);
+  const int all_reduce_stream = assignment->StreamNumberForHlo(
+      *FindInstruction(module.get(), "all-reduce"));
+  for (const char* name : {"negate", "dot1", "dot2", "tuple"}) {
+    EXPECT_NE(all_reduce_stream, assignment->StreamNumberForHlo(
+                                     *FindInstruction(module.get(), name)))
+        << name;
+  }
+}
+
+constexpr char kTwoTowers[] = R"(
+HloModule module
+
+ENTRY entry {
+  a0 = f32[512,512] parameter(0)
+  a1 = f32[512,512] parameter(1)
+  b0 = f32[512,512] parameter(2)
+  b1 = f32[512,512] parameter(3)
+  a_dot1 = f32[512,512] dot(a0, a1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  a_negate = f32[512,512] negate(a_dot1)
+  a_dot2 = f32[512,512] dot(a_negate, a1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  b_dot1 = f32[512,512] dot(b0, b1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  b_negate = f32[512,512] negate(b_dot1)
+  b_dot2 = f32[512,512] dot(b_negate, b1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT add = f32[512,512] add(a_dot2, b_dot2)
+})";
+
+TEST_F(StreamAssignmentTest, CriticalPathPutsTowersOnSeparateStreams) {
+  HloModuleConfig config;
+  auto debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_gpu_disable_multi_streaming(false);
+  debug_options.set_xla_gpu_critical_path_stream_assignment(true);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kTwoTowers, config));
+
+  std::unique_ptr<StreamAssignment> assignment = AssignStreams(*module);
+  auto stream_of = [&](const char* name) {
+    return assignment->StreamNumberForHlo(
+        *FindInstruction(module.get(), name));
+  };
+  EXPECT_EQ(assignment->StreamCount(), 2);
+  // Each tower stays on one stream, so only the add synchronizes them.
+  EXPECT_EQ(stream_of("a_dot1"), stream_of("a_negate"));
+  EXPECT_EQ(stream_of("a_dot1"), stream_of("a_dot2"));
+  EXPECT_EQ(stream_of("b_dot1"), stream_of("b_negate"));
+  EXPECT_EQ(stream_of("b_dot1"), stream_of("b_dot2"));
+  EXPECT_NE(stream_of("a_dot1"), stream_of("b_dot1"));
+}
+
+TEST_F(StreamAssignmentTest, CriticalPathKeepsCheapBranchesTogether) {
+  const char* const hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  p0 = f32[2,2] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  negate0 = f32[2,2] negate(p0)
+  negate1 = f32[2,2] negate(p1)
+  ROOT add = f32[2,2] add(negate0, negate1)
+})";
+  HloModuleConfig config;
+  auto debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_gpu_disable_multi_streaming(false);
+  debug_options.set_xla_gpu_critical_path_stream_assignment(true);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string, config));
+
+  std::unique_ptr<StreamAssignment> assignment = AssignStreams(*module);
+  EXPECT_EQ(assignment->StreamCount(), 1);
+}
+
+TEST_F(StreamAssignmentTest, CopyStartOnSeparateStream) {
+  const char* const hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  p0 = f32[2,2] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  copy-start = (f32[2,2], f32[2,2], u32[]) copy-start(p0)
+  dot = f32[2,2] dot(p1, p1),
+    lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  copy-done = f32[2,2] copy-done(copy-start)
+  ROOT add = f32[2,2] add(copy-done, dot)
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+
+  std::unique_ptr<StreamAssignment> assignment = AssignStreams(*module);
+  const int copy_stream = assignment->StreamNumberForHlo(
+      *FindInstruction(module.get(), "copy-start"));
+  for (const char* name : {"dot", "copy-done", "add"}) {
+    EXPECT_NE(copy_stream, assignment->StreamNumberForHlo(
+                               *FindInstruction(module.get(), name)))
+        << name;
+  }
+}
+
 }  // namespace gpu
 }  // namespace xla
@@ -705,7 +705,7 @@ TEST_F(GpuKernelTilingTest, ColumnReductionSmallTileSizeX) {
   EXPECT_TRUE(RunAndCompareNoHloPasses(kHloString, ErrorSpec{1.0e-5, 1.0e-5}));
 }
 
-TEST_F(GpuKernelTilingTest, RowReductionWithSmallDimensionNotTiled) {
+TEST_F(GpuKernelTilingTest, RowReductionWithSmallDimensionPacked) {
   const char *const kHloString = R"(
     HloModule reduction
     reduction0 {
@@ -721,18 +721,22 @@ TEST_F(GpuKernelTilingTest, RowReductionWithSmallDimensionNotTiled) {
         to_apply=reduction0
     })";
 
-  // Check that the kernel is not tiled by looking for llvm.nvvm.shfl.sync.down.
+  // Check that the rows are packed into warps by looking for
+  // llvm.nvvm.shfl.sync.down, and that no shared memory is used to combine the
+  // lanes of a row.
   auto hlo_module =
       ParseAndReturnVerifiedModule(kHloString, ConfigWithoutLayoutAssignment())
           .ValueOrDie();
   auto expected_ir = is_built_with_rocm_ ? R"(
 ; CHECK-LABEL: define amdgpu_kernel void @reduce
-; CHECK-NOT: call i32 @llvm.amdgcn.ds.bpermute
+; CHECK: call i32 @llvm.amdgcn.ds.bpermute
+; CHECK-NOT: call void @llvm.amdgcn.s.barrier()
 ; CHECK: }
 )"
                                          : R"(
 ; CHECK-LABEL: define void @reduce
-; CHECK-NOT: call float @llvm.nvvm.shfl.sync.down.f32
+; CHECK: call float @llvm.nvvm.shfl.sync.down.f32
+; CHECK-NOT: call void @llvm.nvvm.barrier0
 ; CHECK: }
 )";
   CompileAndVerifyIr(std::move(hlo_module), expected_ir,
@@ -742,6 +746,27 @@ TEST_F(GpuKernelTilingTest, RowReductionWithSmallDimensionNotTiled) {
   EXPECT_TRUE(RunAndCompareNoHloPasses(kHloString, ErrorSpec{0.001}));
 }
 
+TEST_F(GpuKernelTilingTest, RowReductionWithOddSmallDimensionPacked) {
+  const char *const kHloString = R"(
+    HloModule reduction
+    reduction0 {
+      x0 = f32[] parameter(0)
+      y0 = f32[] parameter(1)
+      ROOT add0 = f32[] add(x0, y0)
+    }
+
+    ENTRY kernel_entry {
+      arg0 = f32[4,1000,6]{2,1,0}  parameter(0)
+      constant0 = f32[] constant(0)
+      ROOT reduce0 = f32[1000]{0} reduce(arg0, constant0), dimensions={0,2},
+        to_apply=reduction0
+    })";
+
+  // Check that the kernel runs correctly when rows are narrower than their
+  // segment of lanes and the batch dimension is reduced as well.
+  EXPECT_TRUE(RunAndCompareNoHloPasses(kHloString, ErrorSpec{0.001}));
+}
+
 TEST_F(GpuKernelTilingTest, RowReductionRequiring64BitIndex) {
   const char *const kHloString = R"(
   HloModule LargeReduction
@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <utility>
+
+#include "tensorflow/compiler/xla/service/gpu/tests/gpu_codegen_test.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+class GpuParallelCompilationTest : public GpuCodegenTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = GpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_compilation_parallelism(4);
+    return debug_options;
+  }
+};
+
+// The three roots share no operands and have different shapes, so they are
+// emitted as separate kernels, which are compiled as separate modules and
+// linked.
+TEST_F(GpuParallelCompilationTest, SplitModuleIsLinked) {
+  const char* hlo_text = R"(
+HloModule mod
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT add = f32[] add(x, y)
+}
+
+ENTRY main {
+  p0 = f32[1024,128] parameter(0)
+  p1 = f32[256,64] parameter(1)
+  p2 = f32[37] parameter(2)
+  exp = f32[1024,128] exponential(p0)
+  zero = f32[] constant(0)
+  reduce = f32[256] reduce(p1, zero), dimensions={1}, to_apply=add
+  negate = f32[37] negate(p2)
+  ROOT tuple = (f32[1024,128], f32[256], f32[37]) tuple(exp, reduce, negate)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_text));
+
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+
+  // Each of the split modules is lowered to PTX of its own.
+  CompileAndOptionallyVerifyPtx(std::move(module),
+                                R"(
+CHECK: .version
+CHECK: .version
+)");
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
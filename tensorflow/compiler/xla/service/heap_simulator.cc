@@ -98,16 +98,26 @@ StatusOr<HeapSimulator::Result<HloValue>> HeapSimulator::Run(
     std::unique_ptr<HeapAlgorithm<HloValue>> algorithm, const HloModule& module,
     const HloSchedule& schedule, const HloAliasAnalysis& alias_analysis,
     const BufferValue::SizeFunction& size_fn, const Options& options) {
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<HloLiveRange> hlo_live_range,
+      HloLiveRange::Run(schedule, alias_analysis, module.entry_computation()));
+  return Run(std::move(algorithm), module, schedule, alias_analysis,
+             *hlo_live_range, size_fn, options);
+}
+
+/*static*/
+StatusOr<HeapSimulator::Result<HloValue>> HeapSimulator::Run(
+    std::unique_ptr<HeapAlgorithm<HloValue>> algorithm, const HloModule& module,
+    const HloSchedule& schedule, const HloAliasAnalysis& alias_analysis,
+    const HloLiveRange& hlo_live_range,
+    const BufferValue::SizeFunction& size_fn, const Options& options) {
   HeapSimulator heap(std::move(algorithm), size_fn, options, &schedule);
   const HloComputation* entry_computation = module.entry_computation();
   const HloInstructionSequence& instruction_sequence =
       schedule.sequence(entry_computation);
-  TF_ASSIGN_OR_RETURN(
-      std::unique_ptr<HloLiveRange> hlo_live_range,
-      HloLiveRange::Run(schedule, alias_analysis, entry_computation));
   TF_RETURN_IF_ERROR(heap.RunComputation(*entry_computation,
                                          instruction_sequence, alias_analysis,
-                                         hlo_live_range.get()));
+                                         hlo_live_range));
   return heap.Finish();
 }
 
@@ -128,7 +138,7 @@ StatusOr<HeapSimulator::Result<HloValue>> HeapSimulator::Run(
                       HloLiveRange::Run(schedule, alias_analysis, &computation,
                                         /*module_scoped_analysis=*/false));
   TF_RETURN_IF_ERROR(heap.RunComputation(computation, instruction_sequence,
-                                         alias_analysis, hlo_live_range.get()));
+                                         alias_analysis, *hlo_live_range));
   return heap.Finish();
 }
 
@@ -146,7 +156,7 @@ StatusOr<HeapSimulator::Result<HloValue>> HeapSimulator::Run(
       std::unique_ptr<HloLiveRange> hlo_live_range,
       HloLiveRange::Run(*schedule, alias_analysis, &computation));
   TF_RETURN_IF_ERROR(heap.RunComputation(computation, instruction_sequence,
-                                         alias_analysis, hlo_live_range.get()));
+                                         alias_analysis, *hlo_live_range));
   return heap.Finish();
 }
 
@@ -155,11 +165,12 @@ StatusOr<HeapSimulator::Result<HloValue>> HeapSimulator::Run(
 Status HeapSimulator::RunComputation(
     const HloComputation& computation,
     const HloInstructionSequence& instruction_sequence,
-    const HloAliasAnalysis& alias_analysis, HloLiveRange* hlo_live_range) {
+    const HloAliasAnalysis& alias_analysis,
+    const HloLiveRange& hlo_live_range) {
   XLA_VLOG_LINES(1, computation.parent()->ToString());
   XLA_VLOG_LINES(2, computation.ToString());
 
-  VLOG(1) << hlo_live_range->ToString();
+  VLOG(1) << hlo_live_range.ToString();
 
   HloDataflowAnalysis& dataflow_analysis = alias_analysis.dataflow_analysis();
 
@@ -167,9 +178,9 @@ Status HeapSimulator::RunComputation(
   // remaining buffers (entry parameter, etc) after the program has finished
   // running, so we set the size of to program_end_time + 1.
   std::vector<std::vector<const HloValue*>> buffers_defined(
-      hlo_live_range->schedule_end_time() + 1);
+      hlo_live_range.schedule_end_time() + 1);
   std::vector<std::vector<const HloValue*>> buffers_freed(
-      hlo_live_range->schedule_end_time() + 1);
+      hlo_live_range.schedule_end_time() + 1);
 
   // values_to_assign tracks the HloValues that we need to assign a buffer to.
   // Note that we only need to assign a buffer to a value when both of the
@@ -186,7 +197,7 @@ Status HeapSimulator::RunComputation(
 
   for (const HloValue* value : dataflow_analysis.values()) {
     // Ignore buffers that are not tracked.
-    if (hlo_live_range->instruction_schedule().count(
+    if (hlo_live_range.instruction_schedule().count(
             value->defining_instruction()) == 0) {
       continue;
     }
@@ -196,7 +207,15 @@ Status HeapSimulator::RunComputation(
     values_to_assign.push_back(value);
   }
 
-  auto& buffer_live_ranges = hlo_live_range->buffer_live_ranges();
+  // The live ranges of the values to assign. Buffer sharing below extends the
+  // live range of the shared operand, so work on a copy rather than on
+  // `hlo_live_range`, which may be reused by the caller.
+  absl::flat_hash_map<const HloValue*, HloLiveRange::TimeBound>
+      buffer_live_ranges;
+  buffer_live_ranges.reserve(values_to_assign.size());
+  for (const HloValue* value : values_to_assign) {
+    buffer_live_ranges[value] = hlo_live_range.buffer_live_ranges().at(value);
+  }
 
   absl::c_sort(values_to_assign,
                [&](const HloValue* value1, const HloValue* value2) {
@@ -220,11 +239,11 @@ Status HeapSimulator::RunComputation(
   // map tracks the first value that got allocated in a buffer.
   absl::flat_hash_map<const HloBuffer*, const HloValue*> first_allocated_value;
 
-  VLOG(1) << "Program time" << hlo_live_range->schedule_end_time();
+  VLOG(1) << "Program time" << hlo_live_range.schedule_end_time();
 
   // Go through each step in the program and replay each buffer define and free
   // events.
-  for (int64 i = 0; i < hlo_live_range->schedule_end_time() + 1; ++i) {
+  for (int64 i = 0; i < hlo_live_range.schedule_end_time() + 1; ++i) {
     VLOG(1) << "Time step: " << i;
 
     for (const HloValue* value : buffers_defined[i]) {
@@ -620,162 +639,172 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::Free(const BufferType* buffer,
 
 using Chunk = HeapSimulator::Chunk;
 
+namespace {
+
+int64 Height(const BufferIntervalTreeNode* node) {
+  return node == nullptr ? 0 : node->height;
+}
+
+// Recomputes the height and subtree_end of `node` from its children.
+void UpdateNode(BufferIntervalTreeNode* node) {
+  node->height = 1 + std::max(Height(node->left), Height(node->right));
+  node->subtree_end = node->end;
+  if (node->left != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+}
+
+// Makes `child` the child of `parent` on the side given by `child_ptr`.
+void SetChild(BufferIntervalTreeNode* parent,
+              BufferIntervalTreeNode** child_ptr,
+              BufferIntervalTreeNode* child) {
+  *child_ptr = child;
+  if (child != nullptr) {
+    child->parent = parent;
+  }
+}
+
+}  // namespace
+
 void BufferIntervalTree::Add(int64 start, int64 end, const Chunk& chunk) {
   node_storage_.emplace_back(BufferIntervalTreeNode{
-      start, end, end, chunk,
+      start, end, end, /*height=*/1, chunk,
       /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr});
-  if (root_ == nullptr) {
-    root_ = &node_storage_.back();
-    // This is root.
-    return;
-  }
+  root_ = Add(root_, &node_storage_.back());
+  root_->parent = nullptr;
+}
 
-  BufferIntervalTreeNode* parent = root_;
-  while (true) {
-    parent->subtree_end = std::max(parent->subtree_end, end);
-    if (parent->start > start) {
-      if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
-      }
-      parent = parent->left;
-    } else {
-      if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
-      }
-      parent = parent->right;
-    }
+BufferIntervalTreeNode* BufferIntervalTree::Add(
+    BufferIntervalTreeNode* node, BufferIntervalTreeNode* new_node) {
+  if (node == nullptr) {
+    return new_node;
+  }
+  if (node->start > new_node->start) {
+    SetChild(node, &node->left, Add(node->left, new_node));
+  } else {
+    SetChild(node, &node->right, Add(node->right, new_node));
   }
+  return Rebalance(node);
 }
 
 bool BufferIntervalTree::Remove(int64 start, int64 end, const Chunk& chunk) {
-  BufferIntervalTreeNode* to_delete = root_;
-  while (to_delete != nullptr) {
-    if (to_delete->start == start && to_delete->end == end &&
-        to_delete->chunk.offset == chunk.offset) {
-      break;
+  bool removed = false;
+  root_ = Remove(root_, start, end, chunk, &removed);
+  if (root_ != nullptr) {
+    root_->parent = nullptr;
+  }
+  // Don't free the entry in node_storage_ until we free the entire tree.
+  return removed;
+}
+
+BufferIntervalTreeNode* BufferIntervalTree::Remove(BufferIntervalTreeNode* node,
+                                                   int64 start, int64 end,
+                                                   const Chunk& chunk,
+                                                   bool* removed) {
+  if (node == nullptr) {
+    return nullptr;
+  }
+  if (start < node->start) {
+    SetChild(node, &node->left,
+             Remove(node->left, start, end, chunk, removed));
+    return Rebalance(node);
+  }
+  if (start > node->start || node->end != end ||
+      node->chunk.offset != chunk.offset) {
+    // Rotations may move nodes with the same alloc time as `node` to either of
+    // its subtrees.
+    if (start == node->start) {
+      SetChild(node, &node->left,
+               Remove(node->left, start, end, chunk, removed));
     }
-    if (start < to_delete->start) {
-      to_delete = to_delete->left;
-    } else {
-      to_delete = to_delete->right;
+    if (!*removed) {
+      SetChild(node, &node->right,
+               Remove(node->right, start, end, chunk, removed));
     }
+    return Rebalance(node);
   }
-  if (to_delete == nullptr) {
-    // Nothing to delete.
-    return false;
-  }
-  // Found the node to be deleted, enter deletion sequence.
 
-  // Recursively traverse the parents of node and fix up the `subtree_end`
-  // invariant of a node. Recursive lambda need an explicit
-  // std::function declaration.
-  std::function<void(BufferIntervalTreeNode*)> fix_up =
-      [&](BufferIntervalTreeNode* node) {
-        if (node == nullptr) {
-          return;
-        }
-        node->subtree_end = node->end;
-        if (node->left) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->left->subtree_end);
-        }
-        if (node->right) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->right->subtree_end);
-        }
-        // Recursively go up.
-        fix_up(node->parent);
-      };
-
-  if (to_delete->right == nullptr) {
-    // to_delete has no right child, simply move up left child of to_delete if
-    // any.
-    //
-    // Turn:
-    //      parent
-    //       /
-    // to_delete
-    //  /      \
-    // left    nullptr
-    //
-    // Into:
-    //      parent
-    //      /
-    //    left
-    if (root_ == to_delete) {
-      // Deleting root is simply reseting root;
-      root_ = to_delete->left;
-      return true;
-    }
+  // Found the node to be deleted: replace it with its child if it has at most
+  // one, or else with the leftmost node of its right subtree.
+  *removed = true;
+  if (node->left == nullptr || node->right == nullptr) {
+    return node->left != nullptr ? node->left : node->right;
+  }
+  BufferIntervalTreeNode* min_node = nullptr;
+  BufferIntervalTreeNode* right = RemoveMin(node->right, &min_node);
+  SetChild(min_node, &min_node->left, node->left);
+  SetChild(min_node, &min_node->right, right);
+  return Rebalance(min_node);
+}
 
-    if (to_delete == to_delete->parent->left) {
-      // to_delete is left child of parent.
-      to_delete->parent->left = to_delete->left;
-    }
-    if (to_delete == to_delete->parent->right) {
-      // to_delete is right child of parent.
-      to_delete->parent->right = to_delete->left;
-    }
-    // Rewire parent to the node being moved up.
-    if (to_delete->left) {
-      to_delete->left->parent = to_delete->parent;
-    }
-    // Fix up starting from subroot.
-    fix_up(to_delete);
-  } else {
-    // 1. Find left-most node of the right subtree, promote it to the position
-    // of to_delete.
-    BufferIntervalTreeNode* to_promote = to_delete->right;
-    while (to_promote->left != nullptr) {
-      // Go to left-most subtree.
-      to_promote = to_promote->left;
-    }
+BufferIntervalTreeNode* BufferIntervalTree::RemoveMin(
+    BufferIntervalTreeNode* node, BufferIntervalTreeNode** min_node) {
+  if (node->left == nullptr) {
+    *min_node = node;
+    return node->right;
+  }
+  SetChild(node, &node->left, RemoveMin(node->left, min_node));
+  return Rebalance(node);
+}
 
-    // 2. Copy the content of `to_promote` to `to_delete`.
-    to_delete->start = to_promote->start;
-    to_delete->end = to_promote->end;
-    // This is incorrect but we will fix this up later in the `fix_up`
-    // procedure.
-    to_delete->subtree_end = to_promote->subtree_end;
-    to_delete->chunk = to_promote->chunk;
-    auto to_promote_parent = to_promote->parent;
-    // 3. Move the right child of `to_promote` up if there is any.
-    //
-    // Turn
-    //
-    // to_delete
-    //         \
-    //        to_promote_parent
-    //         /
-    //    to_promote
-    //          \
-    //          right
-    // into
-    //
-    // to_promote
-    //         \
-    //         to_promote_parent
-    //         /
-    //      right
-    if (to_promote_parent->left == to_promote) {
-      to_promote_parent->left = to_promote->right;
-    } else {
-      to_promote_parent->right = to_promote->right;
+/*static*/ BufferIntervalTreeNode* BufferIntervalTree::Rebalance(
+    BufferIntervalTreeNode* node) {
+  UpdateNode(node);
+  const int64 balance = Height(node->left) - Height(node->right);
+  if (balance > 1) {
+    if (Height(node->left->left) < Height(node->left->right)) {
+      SetChild(node, &node->left, RotateLeft(node->left));
     }
-    if (to_promote->right) {
-      // Set correct parent.
-      to_promote->right->parent = to_promote_parent;
+    return RotateRight(node);
+  }
+  if (balance < -1) {
+    if (Height(node->right->right) < Height(node->right->left)) {
+      SetChild(node, &node->right, RotateRight(node->right));
     }
-    // 4. Recursive fix up the `subtree_end` starting from
-    // `to_promote_parent`.
-    fix_up(to_promote_parent);
+    return RotateLeft(node);
   }
-  // Don't free the entry in node_storage_ until we free the entire tree.
-  return true;
+  return node;
+}
+
+// Turns:
+//
+//   node
+//   /  \
+//  a   right
+//      /   \
+//     b     c
+//
+// into:
+//
+//      right
+//      /   \
+//    node   c
+//    /  \
+//   a    b
+/*static*/ BufferIntervalTreeNode* BufferIntervalTree::RotateLeft(
+    BufferIntervalTreeNode* node) {
+  BufferIntervalTreeNode* right = node->right;
+  right->parent = node->parent;
+  SetChild(node, &node->right, right->left);
+  SetChild(right, &right->left, node);
+  UpdateNode(node);
+  UpdateNode(right);
+  return right;
+}
+
+// The mirror image of RotateLeft().
+/*static*/ BufferIntervalTreeNode* BufferIntervalTree::RotateRight(
+    BufferIntervalTreeNode* node) {
+  BufferIntervalTreeNode* left = node->left;
+  left->parent = node->parent;
+  SetChild(node, &node->left, left->right);
+  SetChild(left, &left->right, node);
+  UpdateNode(node);
+  UpdateNode(left);
+  return left;
 }
 
 std::vector<Chunk> BufferIntervalTree::ChunksOverlappingInTime(
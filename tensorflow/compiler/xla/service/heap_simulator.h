@@ -138,6 +138,18 @@ class HeapSimulator {
       const BufferValue::SizeFunction& size_fn,
       const Options& options = Options());
 
+  // Same as above, but reuses the given live ranges of the module, which must
+  // have been computed from the same schedule and alias analysis, instead of
+  // recomputing them. This saves rerunning HloLiveRange when simulating the
+  // heap several times over a large module, e.g. once per buffer color.
+  static StatusOr<Result<HloValue>> Run(
+      std::unique_ptr<HeapAlgorithm<HloValue>> algorithm,
+      const HloModule& module, const HloSchedule& schedule,
+      const HloAliasAnalysis& alias_analysis,
+      const HloLiveRange& hlo_live_range,
+      const BufferValue::SizeFunction& size_fn,
+      const Options& options = Options());
+
   // Same as above, but runs on a single computation. The 'instruction_sequence'
   // must contain a topologically-consistent total ordering of all instructions
   // in the computation. The result is invalid if instructions are not run in
@@ -176,7 +188,7 @@ class HeapSimulator {
   Status RunComputation(const HloComputation& computation,
                         const HloInstructionSequence& instruction_sequence,
                         const HloAliasAnalysis& alias_analysis,
-                        HloLiveRange* live_range);
+                        const HloLiveRange& hlo_live_range);
 
   bool IgnoreBuffer(const HloValue* buffer) const;
   void Alloc(const HloValue* buffer, const HloInstruction* instruction);
@@ -307,6 +319,8 @@ struct BufferIntervalTreeNode {
   int64 end;
   // Maximum free time of all nodes in the subtree where this node is the root.
   int64 subtree_end;
+  // Height of the subtree where this node is the root, 1 for a leaf.
+  int64 height;
   // Allocated chunk for the buffer.
   HeapSimulator::Chunk chunk;
   // Left child.
@@ -317,7 +331,10 @@ struct BufferIntervalTreeNode {
   BufferIntervalTreeNode* parent;
 };
 
-// An interval tree that can query buffers overlapping in time.
+// An interval tree that can query buffers overlapping in time. The tree is kept
+// balanced (as an AVL tree ordered by alloc time), so adding and removing a
+// buffer take O(log n) time and querying the k buffers overlapping an interval
+// takes O(k log n) time, whatever order the buffers are added in.
 class BufferIntervalTree {
  public:
   using Chunk = HeapSimulator::Chunk;
@@ -335,6 +352,28 @@ class BufferIntervalTree {
   BufferIntervalTreeNode* GetRoot() { return root_; }
 
  private:
+  // Returns the root of the subtree of `node` once `new_node` is added to it.
+  BufferIntervalTreeNode* Add(BufferIntervalTreeNode* node,
+                              BufferIntervalTreeNode* new_node);
+
+  // Returns the root of the subtree of `node` once the node with the given
+  // interval and chunk is removed from it, if found, in which case `removed` is
+  // set to true.
+  BufferIntervalTreeNode* Remove(BufferIntervalTreeNode* node, int64 start,
+                                 int64 end, const Chunk& chunk, bool* removed);
+
+  // Returns the root of the subtree of `node` once its leftmost node, stored
+  // to `min_node`, is removed from it.
+  BufferIntervalTreeNode* RemoveMin(BufferIntervalTreeNode* node,
+                                    BufferIntervalTreeNode** min_node);
+
+  // Updates the height and subtree_end of `node`, rotating the subtree it is
+  // the root of if its children's heights differ by more than 1. Returns the
+  // new root of the subtree.
+  static BufferIntervalTreeNode* Rebalance(BufferIntervalTreeNode* node);
+  static BufferIntervalTreeNode* RotateLeft(BufferIntervalTreeNode* node);
+  static BufferIntervalTreeNode* RotateRight(BufferIntervalTreeNode* node);
+
   BufferIntervalTreeNode* root_ = nullptr;
   std::list<BufferIntervalTreeNode> node_storage_;
 };
@@ -1476,17 +1476,25 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   //         [25, 45] (45) Chunk2({2, 3})
   //           /
   //       [22, 40] (40) Chunk3({3, 4})
+  //
+  // is rebalanced into:
+  //
+  //            [22, 40] (45) Chunk3({3, 4})
+  //             /                      \
+  //  [20, 36] (36) Chunk1({1, 2})   [25, 45] (45) Chunk2({2, 3})
   BufferIntervalTree tree;
   tree.Add(20, 36, chunk1);
   tree.Add(25, 45, chunk2);
   tree.Add(22, 40, chunk3);
+  EXPECT_EQ(tree.GetRoot()->subtree_end, 45);
+  EXPECT_EQ(tree.GetRoot()->chunk.offset, 3);
+  EXPECT_EQ(tree.GetRoot()->chunk.size, 4);
   EXPECT_TRUE(tree.Remove(25, 45, chunk2));
-  // Chunk 1 is till the root after removing chunk 2.
+  // Chunk 3 is still the root after removing chunk 2.
   EXPECT_EQ(tree.GetRoot()->subtree_end, 40);
-  EXPECT_EQ(tree.GetRoot()->chunk.offset, 1);
-  EXPECT_EQ(tree.GetRoot()->chunk.size, 2);
+  EXPECT_EQ(tree.GetRoot()->chunk.offset, 3);
+  EXPECT_EQ(tree.GetRoot()->chunk.size, 4);
   EXPECT_TRUE(tree.Remove(20, 36, chunk1));
-  // Chunk 3 becomes the root now.
   EXPECT_EQ(tree.GetRoot()->subtree_end, 40);
   EXPECT_EQ(tree.GetRoot()->chunk.offset, 3);
   EXPECT_EQ(tree.GetRoot()->chunk.size, 4);
@@ -1494,5 +1502,25 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   ASSERT_EQ(tree.GetRoot(), nullptr);
 }
 
+TEST_F(IntervalTreeTest, StaysBalanced) {
+  // Buffers allocated in order of increasing alloc time would otherwise
+  // degenerate the tree into a list.
+  constexpr int64 kNumBuffers = 1023;
+  BufferIntervalTree tree;
+  for (int64 i = 0; i < kNumBuffers; ++i) {
+    tree.Add(i, i + 10, HeapSimulator::Chunk({i, 1}));
+  }
+  EXPECT_EQ(tree.GetRoot()->height, 10);
+  EXPECT_EQ(tree.GetRoot()->subtree_end, kNumBuffers + 9);
+  EXPECT_EQ(tree.ChunksOverlappingInTime(500, 500).size(), 11);
+
+  for (int64 i = 0; i < kNumBuffers; i += 2) {
+    EXPECT_TRUE(tree.Remove(i, i + 10, HeapSimulator::Chunk({i, 1})));
+  }
+  EXPECT_LE(tree.GetRoot()->height, 9);
+  EXPECT_EQ(tree.GetRoot()->parent, nullptr);
+  EXPECT_EQ(tree.ChunksOverlappingInTime(500, 500).size(), 5);
+}
+
 }  // namespace
 }  // namespace xla
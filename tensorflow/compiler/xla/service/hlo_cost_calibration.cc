@@ -0,0 +1,324 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
+
+#include <deque>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace xla {
+
+namespace {
+
+std::string CalibrationPath(const std::string& directory,
+                            const std::string& device_type) {
+  std::string file_name = device_type;
+  for (char& c : file_name) {
+    if (!absl::ascii_isalnum(c) && c != '-' && c != '.') {
+      c = '_';
+    }
+  }
+  return tensorflow::io::JoinPath(directory, absl::StrCat(file_name, ".pb"));
+}
+
+// How often the recorded measurements are added to the calibration files.
+constexpr int64 kFlushIntervalMicros = 30 * 1000 * 1000;
+// The number of recorded profiles waiting to be flushed beyond which new ones
+// are dropped, in case the files are written slower than profiles are taken.
+constexpr int kMaxRecordedProfiles = 1024;
+
+// The execution times of a profiled run, waiting to be added to a calibration
+// file.
+struct RecordedProfile {
+  std::string directory;
+  std::string device_type;
+  // Keeps the instructions alive.
+  std::shared_ptr<const HloModule> module;
+  std::vector<std::pair<const HloInstruction*, double>> seconds;
+};
+
+// Queues the recorded profiles, and adds them to their calibration files from
+// a background thread, so that profiled runs don't wait for the files to be
+// read, merged and written.
+class MeasurementRecorder {
+ public:
+  static MeasurementRecorder* Get() {
+    static MeasurementRecorder* recorder = new MeasurementRecorder;
+    return recorder;
+  }
+
+  void Record(RecordedProfile profile) {
+    tensorflow::mutex_lock lock(mu_);
+    if (profiles_.size() >= kMaxRecordedProfiles) {
+      VLOG(1) << "Dropping the HLO profile of " << profile.module->name()
+              << ": too many profiles waiting to be recorded";
+      return;
+    }
+    profiles_.push_back(std::move(profile));
+    if (thread_ == nullptr) {
+      thread_.reset(tensorflow::Env::Default()->StartThread(
+          tensorflow::ThreadOptions(), "xla_cost_calibration",
+          [this]() { FlushPeriodically(); }));
+    }
+  }
+
+  Status Flush() {
+    tensorflow::mutex_lock flush_lock(flush_mu_);
+    std::deque<RecordedProfile> profiles;
+    {
+      tensorflow::mutex_lock lock(mu_);
+      profiles.swap(profiles_);
+    }
+    // Merge the profiles of each file first, to read and write it once.
+    std::map<std::pair<std::string, std::string>, HloCostCalibration>
+        calibrations;
+    for (const RecordedProfile& profile : profiles) {
+      HloCostCalibration& calibration =
+          calibrations
+              .emplace(std::piecewise_construct,
+                       std::forward_as_tuple(profile.directory,
+                                             profile.device_type),
+                       std::forward_as_tuple(profile.device_type))
+              .first->second;
+      for (const auto& hlo_and_seconds : profile.seconds) {
+        calibration.AddMeasurement(*hlo_and_seconds.first,
+                                   hlo_and_seconds.second);
+      }
+    }
+    profiles.clear();
+    Status status;
+    for (const auto& file_and_calibration : calibrations) {
+      const std::string& directory = file_and_calibration.first.first;
+      status.Update(file_and_calibration.second.MergeInto(directory));
+    }
+    return status;
+  }
+
+ private:
+  MeasurementRecorder() = default;
+
+  void FlushPeriodically() {
+    while (true) {
+      tensorflow::Env::Default()->SleepForMicroseconds(kFlushIntervalMicros);
+      Status status = Flush();
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to record HLO profiles: " << status;
+      }
+    }
+  }
+
+  tensorflow::mutex mu_;
+  std::deque<RecordedProfile> profiles_ TF_GUARDED_BY(mu_);
+  // Never joined, the recorder lives as long as the process.
+  std::unique_ptr<tensorflow::Thread> thread_ TF_GUARDED_BY(mu_);
+  // Serializes the flushes.
+  tensorflow::mutex flush_mu_;
+};
+
+}  // namespace
+
+/* static */ std::string HloCostCalibration::Signature(
+    const HloInstruction& hlo) {
+  return hlo.ToString(HloPrintOptions::Fingerprint());
+}
+
+void HloCostCalibration::AddMeasurement(const HloInstruction& hlo,
+                                        double seconds) {
+  Measurement& measurement = measurements_[Signature(hlo)];
+  measurement.total_seconds += seconds;
+  ++measurement.count;
+}
+
+void HloCostCalibration::AddProfile(const HloModule& module,
+                                    const HloExecutionProfile& profile,
+                                    double clock_rate_ghz) {
+  for (const HloInstruction* hlo : module.entry_computation()->instructions()) {
+    const uint64 cycles = profile.GetCyclesTakenBy(*hlo);
+    if (cycles > 0) {
+      AddMeasurement(*hlo, cycles / (clock_rate_ghz * 1e9));
+    }
+  }
+}
+
+absl::optional<double> HloCostCalibration::MeasuredSeconds(
+    const HloInstruction& hlo) const {
+  if (measurements_.empty()) {
+    return absl::nullopt;
+  }
+  auto it = measurements_.find(Signature(hlo));
+  if (it == measurements_.end()) {
+    return absl::nullopt;
+  }
+  return it->second.total_seconds / it->second.count;
+}
+
+HloCostCalibrationProto HloCostCalibration::ToProto() const {
+  HloCostCalibrationProto proto;
+  proto.set_device_type(device_type_);
+  for (const auto& signature_and_measurement : measurements_) {
+    HloCostCalibrationProto::Measurement* measurement =
+        proto.add_measurements();
+    measurement->set_signature(signature_and_measurement.first);
+    measurement->set_total_seconds(
+        signature_and_measurement.second.total_seconds);
+    measurement->set_count(signature_and_measurement.second.count);
+  }
+  return proto;
+}
+
+/* static */ HloCostCalibration HloCostCalibration::FromProto(
+    const HloCostCalibrationProto& proto) {
+  HloCostCalibration calibration(proto.device_type());
+  for (const HloCostCalibrationProto::Measurement& measurement :
+       proto.measurements()) {
+    if (measurement.count() <= 0) {
+      continue;
+    }
+    Measurement& entry = calibration.measurements_[measurement.signature()];
+    entry.total_seconds += measurement.total_seconds();
+    entry.count += measurement.count();
+  }
+  return calibration;
+}
+
+/* static */ StatusOr<HloCostCalibration> HloCostCalibration::Load(
+    const std::string& directory, const std::string& device_type) {
+  const std::string path = CalibrationPath(directory, device_type);
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->FileExists(path).ok()) {
+    return HloCostCalibration(device_type);
+  }
+  HloCostCalibrationProto proto;
+  TF_RETURN_IF_ERROR(tensorflow::ReadBinaryProto(env, path, &proto));
+  if (proto.device_type() != device_type) {
+    return InvalidArgument("%s holds a calibration for %s rather than %s",
+                           path, proto.device_type(), device_type);
+  }
+  return FromProto(proto);
+}
+
+Status HloCostCalibration::Save(const std::string& directory) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+  const std::string path = CalibrationPath(directory, device_type_);
+  std::string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return InternalError("Failed to create a temporary file name for %s",
+                         path);
+  }
+  Status status = tensorflow::WriteBinaryProto(env, temp_path, ToProto());
+  if (status.ok()) {
+    status = env->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+  return status;
+}
+
+void HloCostCalibration::Merge(const HloCostCalibration& other) {
+  for (const auto& signature_and_measurement : other.measurements_) {
+    Measurement& measurement = measurements_[signature_and_measurement.first];
+    measurement.total_seconds += signature_and_measurement.second.total_seconds;
+    measurement.count += signature_and_measurement.second.count;
+  }
+}
+
+Status HloCostCalibration::MergeInto(const std::string& directory) const {
+  static tensorflow::mutex* mu = new tensorflow::mutex;
+  tensorflow::mutex_lock lock(*mu);
+  TF_ASSIGN_OR_RETURN(HloCostCalibration calibration,
+                      Load(directory, device_type_));
+  calibration.Merge(*this);
+  return calibration.Save(directory);
+}
+
+/* static */ std::unique_ptr<HloCostCalibration>
+HloCostCalibration::LoadForDevice(const DebugOptions& debug_options,
+                                  const std::string& device_type) {
+  const std::string& directory = debug_options.xla_cost_calibration_dir();
+  if (directory.empty()) {
+    return nullptr;
+  }
+  StatusOr<HloCostCalibration> calibration = Load(directory, device_type);
+  if (!calibration.ok()) {
+    LOG(WARNING) << "Ignoring the cost calibration of " << device_type << ": "
+                 << calibration.status();
+    return nullptr;
+  }
+  if (calibration.ValueOrDie().empty()) {
+    return nullptr;
+  }
+  VLOG(1) << "Using the cost calibration of " << device_type << " in "
+          << directory;
+  return absl::make_unique<HloCostCalibration>(
+      calibration.ConsumeValueOrDie());
+}
+
+/* static */ void HloCostCalibration::RecordProfile(
+    const std::string& directory, const std::string& device_type,
+    std::shared_ptr<const HloModule> module, const HloExecutionProfile& profile,
+    double clock_rate_ghz) {
+  std::vector<std::pair<const HloInstruction*, double>> seconds;
+  for (const HloInstruction* hlo :
+       module->entry_computation()->instructions()) {
+    const uint64 cycles = profile.GetCyclesTakenBy(*hlo);
+    if (cycles > 0) {
+      seconds.emplace_back(hlo, cycles / (clock_rate_ghz * 1e9));
+    }
+  }
+  RecordMeasurements(directory, device_type, std::move(module),
+                     std::move(seconds));
+}
+
+/* static */ void HloCostCalibration::RecordMeasurements(
+    const std::string& directory, const std::string& device_type,
+    std::shared_ptr<const HloModule> module,
+    std::vector<std::pair<const HloInstruction*, double>> seconds) {
+  if (seconds.empty()) {
+    return;
+  }
+  MeasurementRecorder::Get()->Record(RecordedProfile{
+      directory, device_type, std::move(module), std::move(seconds)});
+}
+
+/* static */ Status HloCostCalibration::FlushRecordedMeasurements() {
+  return MeasurementRecorder::Get()->Flush();
+}
+
+Status CalibratedHloCostAnalysis::Postprocess(const HloInstruction* hlo) {
+  if (calibration_ != nullptr) {
+    if (absl::optional<double> seconds = calibration_->MeasuredSeconds(*hlo)) {
+      current_properties_[kOptimalSecondsKey] = *seconds;
+      current_should_compute_bottleneck_time_ = false;
+      measured_.insert(hlo);
+    }
+  }
+  return HloCostAnalysis::Postprocess(hlo);
+}
+
+}  // namespace xla
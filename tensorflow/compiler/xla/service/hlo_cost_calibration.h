@@ -0,0 +1,151 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HLO_COST_CALIBRATION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_HLO_COST_CALIBRATION_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.pb.h"
+#include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+
+namespace xla {
+
+// The execution times of HLO instructions measured by HLO profiling on one
+// type of device. Instructions are matched by their fingerprint, which covers
+// their opcode, attributes, shapes and layouts, and the bodies of the
+// computations they call, but not their names.
+//
+// Calibrations are persisted as <directory>/<device type>.pb, where the
+// directory is given by --xla_cost_calibration_dir. When the flag is set,
+// executables compiled with --xla_hlo_profile record the profile of each run,
+// and a background thread periodically adds the recorded profiles to the files
+// of their devices.
+class HloCostCalibration {
+ public:
+  explicit HloCostCalibration(std::string device_type)
+      : device_type_(std::move(device_type)) {}
+
+  const std::string& device_type() const { return device_type_; }
+  bool empty() const { return measurements_.empty(); }
+
+  // Returns the key instructions are matched by.
+  static std::string Signature(const HloInstruction& hlo);
+
+  // Records that `hlo` took `seconds` to execute.
+  void AddMeasurement(const HloInstruction& hlo, double seconds);
+
+  // Records the execution times in `profile` of the instructions of the entry
+  // computation of `module`, on a device clocked at `clock_rate_ghz`. The
+  // instructions of other computations may run several times per profile and
+  // are not recorded.
+  void AddProfile(const HloModule& module, const HloExecutionProfile& profile,
+                  double clock_rate_ghz);
+
+  // Returns the mean measured execution time of instructions with the
+  // signature of `hlo`, if any was recorded.
+  absl::optional<double> MeasuredSeconds(const HloInstruction& hlo) const;
+
+  HloCostCalibrationProto ToProto() const;
+  static HloCostCalibration FromProto(const HloCostCalibrationProto& proto);
+
+  // Loads the calibration for `device_type` from `directory`. Returns an empty
+  // calibration if there is none.
+  static StatusOr<HloCostCalibration> Load(const std::string& directory,
+                                           const std::string& device_type);
+
+  // Saves the calibration to its file in `directory`. The file is replaced
+  // atomically, so readers never see a partially written calibration.
+  Status Save(const std::string& directory) const;
+
+  // Adds the measurements of `other` to this calibration.
+  void Merge(const HloCostCalibration& other);
+
+  // Adds the measurements of this calibration to the one saved in
+  // `directory`. Concurrent calls from one process are serialized.
+  Status MergeInto(const std::string& directory) const;
+
+  // Loads the calibration for `device_type` from --xla_cost_calibration_dir
+  // in `debug_options`. Returns null if the flag is not set or nothing has
+  // been recorded; failures to read the calibration are logged and ignored.
+  static std::unique_ptr<HloCostCalibration> LoadForDevice(
+      const DebugOptions& debug_options, const std::string& device_type);
+
+  // Records the execution times in `profile` of the instructions of the
+  // entry computation of `module`, to be added to the calibration of
+  // `device_type` in `directory` by a background thread. This only copies the
+  // times, so that it can run after every profiled execution.
+  static void RecordProfile(const std::string& directory,
+                            const std::string& device_type,
+                            std::shared_ptr<const HloModule> module,
+                            const HloExecutionProfile& profile,
+                            double clock_rate_ghz);
+
+  // Records the execution times `seconds` of instructions of `module` like
+  // RecordProfile().
+  static void RecordMeasurements(
+      const std::string& directory, const std::string& device_type,
+      std::shared_ptr<const HloModule> module,
+      std::vector<std::pair<const HloInstruction*, double>> seconds);
+
+  // Adds the measurements recorded so far to the calibrations in their
+  // directories. The background thread calls this periodically.
+  static Status FlushRecordedMeasurements();
+
+ private:
+  struct Measurement {
+    double total_seconds = 0;
+    int64 count = 0;
+  };
+
+  std::string device_type_;
+  absl::flat_hash_map<std::string, Measurement> measurements_;
+};
+
+// An HloCostAnalysis whose time estimates are replaced by the times measured
+// in `calibration` for the instructions that have one. The flop, transcendental
+// and byte counts remain analytic.
+class CalibratedHloCostAnalysis : public HloCostAnalysis {
+ public:
+  CalibratedHloCostAnalysis(const ShapeSizeFunction& shape_size,
+                            const HloCostCalibration* calibration)
+      : HloCostAnalysis(shape_size), calibration_(calibration) {}
+
+  Status Postprocess(const HloInstruction* hlo) override;
+
+  // Returns whether the time of `hlo` was measured rather than estimated.
+  bool is_measured(const HloInstruction& hlo) const {
+    return measured_.contains(&hlo);
+  }
+
+ private:
+  const HloCostCalibration* calibration_;
+  absl::flat_hash_set<const HloInstruction*> measured_;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_HLO_COST_CALIBRATION_H_
@@ -0,0 +1,146 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/hlo_cost_calibration.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace {
+
+constexpr char kModule[] = R"(
+HloModule m
+
+ENTRY e {
+  p0 = f32[1024] parameter(0)
+  p1 = f32[1024] parameter(1)
+  p2 = f32[512] parameter(2)
+  add0 = f32[1024] add(p0, p1)
+  add1 = f32[1024] add(p1, p0)
+  add2 = f32[512] add(p2, p2)
+  ROOT t = (f32[1024], f32[1024], f32[512]) tuple(add0, add1, add2)
+})";
+
+int64 ShapeSize(const Shape& shape) {
+  return ShapeUtil::ByteSizeOf(shape, /*pointer_size=*/8);
+}
+
+using HloCostCalibrationTest = HloTestBase;
+
+TEST_F(HloCostCalibrationTest, MatchesInstructionsBySignature) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  const HloComputation* entry = module->entry_computation();
+  HloCostCalibration calibration("device");
+  calibration.AddMeasurement(*entry->GetInstructionWithName("add0"), 1.0);
+  calibration.AddMeasurement(*entry->GetInstructionWithName("add0"), 3.0);
+
+  EXPECT_EQ(calibration.MeasuredSeconds(*entry->GetInstructionWithName("add0")),
+            2.0);
+  // Instructions that only differ in their names and operands share the
+  // measurement, but not instructions of other shapes.
+  EXPECT_EQ(calibration.MeasuredSeconds(*entry->GetInstructionWithName("add1")),
+            2.0);
+  EXPECT_FALSE(
+      calibration.MeasuredSeconds(*entry->GetInstructionWithName("add2")));
+}
+
+TEST_F(HloCostCalibrationTest, MeasuredTimesOverrideEstimates) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  const HloComputation* entry = module->entry_computation();
+  HloCostCalibration calibration("device");
+  calibration.AddMeasurement(*entry->GetInstructionWithName("add0"), 0.5);
+
+  CalibratedHloCostAnalysis analysis(ShapeSize, &calibration);
+  analysis.set_flops_per_second(1e9);
+  analysis.set_bytes_per_second(1e9);
+  TF_ASSERT_OK(entry->Accept(&analysis));
+
+  const HloInstruction* add0 = entry->GetInstructionWithName("add0");
+  const HloInstruction* add2 = entry->GetInstructionWithName("add2");
+  EXPECT_TRUE(analysis.is_measured(*add0));
+  EXPECT_FLOAT_EQ(analysis.optimal_seconds(*add0), 0.5);
+  // The counts remain analytic.
+  EXPECT_EQ(analysis.flop_count(*add0), 1024);
+  EXPECT_FALSE(analysis.is_measured(*add2));
+  EXPECT_FLOAT_EQ(analysis.optimal_seconds(*add2), 3 * 512 * 4 / 1e9);
+}
+
+TEST_F(HloCostCalibrationTest, SavesAndLoadsPerDeviceType) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  const HloInstruction* add0 =
+      module->entry_computation()->GetInstructionWithName("add0");
+  const std::string directory =
+      tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), "calibration");
+  HloCostCalibration calibration("Some GPU");
+  calibration.AddMeasurement(*add0, 0.25);
+  TF_ASSERT_OK(calibration.Save(directory));
+
+  TF_ASSERT_OK_AND_ASSIGN(HloCostCalibration loaded,
+                          HloCostCalibration::Load(directory, "Some GPU"));
+  EXPECT_EQ(loaded.device_type(), "Some GPU");
+  EXPECT_EQ(loaded.MeasuredSeconds(*add0), 0.25);
+
+  TF_ASSERT_OK_AND_ASSIGN(HloCostCalibration other,
+                          HloCostCalibration::Load(directory, "Other GPU"));
+  EXPECT_TRUE(other.empty());
+}
+
+TEST_F(HloCostCalibrationTest, FlushMergesRecordedMeasurementsIntoFiles) {
+  TF_ASSERT_OK_AND_ASSIGN(auto parsed, ParseAndReturnVerifiedModule(kModule));
+  std::shared_ptr<const HloModule> module = std::move(parsed);
+  const HloInstruction* add0 =
+      module->entry_computation()->GetInstructionWithName("add0");
+  const HloInstruction* add2 =
+      module->entry_computation()->GetInstructionWithName("add2");
+  const std::string directory =
+      tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), "recorded");
+  HloCostCalibration saved("GPU");
+  saved.AddMeasurement(*add0, 1.0);
+  TF_ASSERT_OK(saved.Save(directory));
+
+  HloCostCalibration::RecordMeasurements(directory, "GPU", module,
+                                         {{add0, 2.0}, {add2, 0.5}});
+  HloCostCalibration::RecordMeasurements(directory, "GPU", module,
+                                         {{add0, 3.0}});
+  // Nothing is written until the recorded measurements are flushed.
+  TF_ASSERT_OK_AND_ASSIGN(HloCostCalibration before,
+                          HloCostCalibration::Load(directory, "GPU"));
+  EXPECT_FALSE(before.MeasuredSeconds(*add2));
+  TF_ASSERT_OK(HloCostCalibration::FlushRecordedMeasurements());
+
+  TF_ASSERT_OK_AND_ASSIGN(HloCostCalibration after,
+                          HloCostCalibration::Load(directory, "GPU"));
+  EXPECT_EQ(after.MeasuredSeconds(*add0), 2.0);
+  EXPECT_EQ(after.MeasuredSeconds(*add2), 0.5);
+  // The temporary files the saves go through are renamed into place.
+  std::vector<std::string> children;
+  TF_ASSERT_OK(tensorflow::Env::Default()->GetChildren(directory, &children));
+  for (const std::string& child : children) {
+    EXPECT_FALSE(absl::EndsWith(child, ".tmp")) << child;
+  }
+}
+
+}  // namespace
+}  // namespace xla
@@ -149,7 +149,20 @@ int64 CseHash(const HloInstruction* instruction) {
 
 }  // namespace
 
-StatusOr<bool> HloCSE::Run(HloModule* module) {
+std::vector<HloComputation*> HloCSE::ComputationsToRun(HloModule* module) {
+  if (!only_fusion_computations_) {
+    return module->MakeComputationPostOrder();
+  }
+  std::vector<HloComputation*> fusion_computations;
+  for (HloComputation* computation : module->MakeComputationPostOrder()) {
+    if (computation->IsFusionComputation()) {
+      fusion_computations.push_back(computation);
+    }
+  }
+  return fusion_computations;
+}
+
+StatusOr<bool> HloCSE::RunOnComputation(HloComputation* computation) {
   bool changed = false;
 
   const std::function<bool(const HloInstruction*, const HloInstruction*)>
@@ -163,44 +176,37 @@ StatusOr<bool> HloCSE::Run(HloModule* module) {
                           is_layout_sensitive_);
   };
 
-  for (auto* computation : module->computations()) {
-    if (only_fusion_computations_ && !computation->IsFusionComputation()) {
+  TF_ASSIGN_OR_RETURN(bool combined,
+                      CombineConstants(computation, is_layout_sensitive_));
+  changed |= combined;
+
+  // HLO instructions are grouped into equivalency classes by using the
+  // cse_equal predicate defined above. This set holds a representative
+  // instruction for each class.
+  absl::flat_hash_set<HloInstruction*, decltype(&CseHash), decltype(cse_equal)>
+      representatives(/*N=*/computation->instruction_count() + 1, &CseHash,
+                      cse_equal);
+  for (auto instruction : computation->MakeInstructionPostOrder()) {
+    // If the instruction has zero operands (constants, parameters, etc.) skip
+    // over it.
+    if (instruction->operand_count() == 0 &&
+        instruction->opcode() != HloOpcode::kPartitionId &&
+        instruction->opcode() != HloOpcode::kReplicaId) {
+      continue;
+    }
+    // Skip instructions which have side effects.
+    if (instruction->HasSideEffect()) {
       continue;
     }
 
-    TF_ASSIGN_OR_RETURN(bool combined,
-                        CombineConstants(computation, is_layout_sensitive_));
-    changed |= combined;
-
-    // HLO instructions are grouped into equivalency classes by using the
-    // cse_equal predicate defined above. This set holds a representative
-    // instruction for each class.
-    absl::flat_hash_set<HloInstruction*, decltype(&CseHash),
-                        decltype(cse_equal)>
-        representatives(/*N=*/computation->instruction_count() + 1, &CseHash,
-                        cse_equal);
-    for (auto instruction : computation->MakeInstructionPostOrder()) {
-      // If the instruction has zero operands (constants, parameters, etc.) skip
-      // over it.
-      if (instruction->operand_count() == 0 &&
-          instruction->opcode() != HloOpcode::kPartitionId &&
-          instruction->opcode() != HloOpcode::kReplicaId) {
-        continue;
-      }
-      // Skip instructions which have side effects.
-      if (instruction->HasSideEffect()) {
-        continue;
-      }
-
-      auto pair = representatives.insert(instruction);
-      if (!pair.second) {
-        HloInstruction* equivalent_instruction = *pair.first;
-        TF_RETURN_IF_ERROR(
-            instruction->ReplaceAllUsesWith(equivalent_instruction));
-        TF_RETURN_IF_ERROR(computation->RemoveInstruction(instruction));
-        changed = true;
-        continue;
-      }
+    auto pair = representatives.insert(instruction);
+    if (!pair.second) {
+      HloInstruction* equivalent_instruction = *pair.first;
+      TF_RETURN_IF_ERROR(
+          instruction->ReplaceAllUsesWith(equivalent_instruction));
+      TF_RETURN_IF_ERROR(computation->RemoveInstruction(instruction));
+      changed = true;
+      continue;
     }
   }
   return changed;
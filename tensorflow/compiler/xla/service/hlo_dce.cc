@@ -73,20 +73,9 @@ StatusOr<bool> HloDCE::RunOnComputation(
   return changed;
 }
 
-StatusOr<bool> HloDCE::Run(HloModule* module) {
+StatusOr<bool> HloDCE::RunOnModuleAfterComputations(HloModule* module) {
   bool changed = false;
 
-  VLOG(2) << "Before dce:";
-  XLA_VLOG_LINES(2, module->ToString());
-
-  // Run DCE on each computation.
-  for (auto* computation : module->MakeComputationPostOrder()) {
-    TF_ASSIGN_OR_RETURN(
-        bool changed_for_computation,
-        RunOnComputation(computation, remove_cross_partition_collective_ops_));
-    changed |= changed_for_computation;
-  }
-
   // Now DCE HloComputations.  First, collect the computations that are
   // referenced by some remaining instruction.
   absl::flat_hash_set<HloComputation*> live_computations;
@@ -33,7 +33,7 @@ namespace xla {
 //
 // This pass does not remove dead parameter instructions, as parameter
 // instructions cannot be deleted.
-class HloDCE : public HloModulePass {
+class HloDCE : public HloComputationPass {
  public:
   HloDCE() : remove_cross_partition_collective_ops_(false) {}
   explicit HloDCE(bool remove_cross_partition_collective_ops)
@@ -45,10 +45,15 @@ class HloDCE : public HloModulePass {
   // Run DCE on a computation.
   StatusOr<bool> RunOnComputation(HloComputation* computation,
                                   bool remove_cross_partition_collective_ops);
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override {
+    return RunOnComputation(computation,
+                            remove_cross_partition_collective_ops_);
+  }
 
-  // Run the pass on the given module. Returns whether the module was changed
-  // (instructions were removed).
-  StatusOr<bool> Run(HloModule* module) override;
+ protected:
+  // Removes the computations which are no longer called once the pass removed
+  // the dead instructions of each computation.
+  StatusOr<bool> RunOnModuleAfterComputations(HloModule* module) override;
 
  private:
   bool remove_cross_partition_collective_ops_;
@@ -2392,6 +2392,58 @@ static StatusOr<bool> GenerateReduceOutputElement(
   return true;
 }
 
+// Sums `arg` into `result`, starting from the scalar `init`, over the
+// dimensions of `arg` that are not listed in `result_to_arg_index`. Like the
+// fast add path of GenerateReduceOutputElement, accumulates in double precision
+// and in the physical order of `arg`, but walks the elements of `arg` only once
+// rather than visiting the reduced dimensions for every output element.
+template <typename NativeT>
+static void ReduceAddInPhysicalOrder(
+    const Literal& arg, const Literal& init,
+    absl::Span<const int64> result_to_arg_index, Literal* result) {
+  const Shape& arg_shape = arg.shape();
+  std::vector<double> sums(ShapeUtil::ElementsIn(result->shape()),
+                           static_cast<double>(init.Get<NativeT>({})));
+  // The stride in `sums` of each dimension of `arg`, zero for the reduced ones.
+  std::vector<int64> result_strides(arg_shape.rank(), 0);
+  for (int64 i = 0; i < result_to_arg_index.size(); ++i) {
+    result_strides[result_to_arg_index[i]] =
+        IndexUtil::GetDimensionStride(result->shape(), i);
+  }
+  std::vector<int64> arg_index(arg_shape.rank(), 0);
+  int64 result_index = 0;
+  for (const NativeT& element : arg.data<NativeT>()) {
+    sums[result_index] += static_cast<double>(element);
+    for (int64 dim : LayoutUtil::MinorToMajor(arg_shape)) {
+      result_index += result_strides[dim];
+      if (++arg_index[dim] < arg_shape.dimensions(dim)) {
+        break;
+      }
+      result_index -= result_strides[dim] * arg_shape.dimensions(dim);
+      arg_index[dim] = 0;
+    }
+  }
+  absl::Span<NativeT> result_data = result->data<NativeT>();
+  for (int64 i = 0; i < sums.size(); ++i) {
+    result_data[i] = static_cast<NativeT>(sums[i]);
+  }
+}
+
+// Returns true if a reduction of `input_args` with `function` may be computed
+// by ReduceAddInPhysicalOrder.
+static bool CanReduceAddInPhysicalOrder(
+    absl::Span<const Literal* const> init_values,
+    absl::Span<const Literal* const> input_args, HloComputation* function,
+    const Shape& output_shape) {
+  if (input_args.size() != 1 || !IsScalarAdd(function)) {
+    return false;
+  }
+  const Shape& arg_shape = input_args[0]->shape();
+  return ShapeUtil::ElementIsFloating(arg_shape) && !arg_shape.is_dynamic() &&
+         ShapeUtil::SameElementType(arg_shape, init_values[0]->shape()) &&
+         ShapeUtil::SameElementType(arg_shape, output_shape);
+}
+
 Status HloEvaluator::HandleReduce(HloInstruction* instr) {
   HloReduceInstruction* reduce = Cast<HloReduceInstruction>(instr);
   int64 num_args = reduce->inputs().size();
@@ -2461,13 +2513,38 @@ Status HloEvaluator::HandleReduce(HloInstruction* instr) {
     results[i] = Literal(is_tuple ? out_shape.tuple_shapes(i) : out_shape);
   }
 
-  TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexWithStatus(
-      output_shape, [&](absl::Span<const int64> output_index) {
-        return GenerateReduceOutputElement(
-            is_tuple, output_index, init_values, input_args,
-            absl::Span<Literal>(results), function, &embedded_evaluator,
-            arg_dim_steps, arg_dim_counts, result_to_arg_index);
-      }));
+  if (!is_tuple && CanReduceAddInPhysicalOrder(init_values, input_args,
+                                               function, output_shape)) {
+    switch (output_shape.element_type()) {
+      case F16:
+        ReduceAddInPhysicalOrder<Eigen::half>(*input_args[0], *init_values[0],
+                                              result_to_arg_index, &results[0]);
+        break;
+      case BF16:
+        ReduceAddInPhysicalOrder<bfloat16>(*input_args[0], *init_values[0],
+                                           result_to_arg_index, &results[0]);
+        break;
+      case F32:
+        ReduceAddInPhysicalOrder<float>(*input_args[0], *init_values[0],
+                                        result_to_arg_index, &results[0]);
+        break;
+      case F64:
+        ReduceAddInPhysicalOrder<double>(*input_args[0], *init_values[0],
+                                         result_to_arg_index, &results[0]);
+        break;
+      default:
+        return InternalError("Unexpected element type in reduce: %s",
+                             PrimitiveType_Name(output_shape.element_type()));
+    }
+  } else {
+    TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexWithStatus(
+        output_shape, [&](absl::Span<const int64> output_index) {
+          return GenerateReduceOutputElement(
+              is_tuple, output_index, init_values, input_args,
+              absl::Span<Literal>(results), function, &embedded_evaluator,
+              arg_dim_steps, arg_dim_counts, result_to_arg_index);
+        }));
+  }
 
   if (is_tuple) {
     Literal tuple_result(inferred_return_shape);
@@ -2525,6 +2602,13 @@ Status HloEvaluator::Postprocess(HloInstruction* hlo) {
   return Status::OK();
 }
 
+/*static*/ bool HloEvaluator::HaveSameLinearOrder(const Shape& a,
+                                                  const Shape& b) {
+  return a.IsArray() && b.IsArray() && !a.is_dynamic() && !b.is_dynamic() &&
+         ShapeUtil::SameDimensions(a, b) &&
+         Layout::Equal().MinorToMajorOnly()(a.layout(), b.layout());
+}
+
 namespace {
 template <typename T>
 std::unique_ptr<Array2D<T>> MatmulArray2DImpl(
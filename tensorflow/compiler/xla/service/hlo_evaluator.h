@@ -326,6 +326,12 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
   bool use_fast_path_ = false;
 
  private:
+  // Returns true if the arrays of shapes `a` and `b` have the same static
+  // dimensions and store their elements in the same order. Elementwise
+  // operations over such arrays may then walk their raw buffers in lockstep
+  // instead of computing a multi-dimensional index per element.
+  static bool HaveSameLinearOrder(const Shape& a, const Shape& b);
+
   template <typename ReturnT, typename NativeT>
   static StatusOr<Literal> ElementWiseUnaryOpImpl(
       HloInstruction* instruction,
@@ -336,6 +342,14 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    if (HaveSameLinearOrder(result.shape(), operand_literal.shape())) {
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      absl::Span<const NativeT> operand_data = operand_literal.data<NativeT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = unary_op(operand_data[i]);
+      }
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
@@ -4092,6 +4092,102 @@ ENTRY main {
   EXPECT_TRUE(LiteralTestUtil::Equal(arg, actual));
 }
 
+TEST_F(HloEvaluatorTest, SliceWithUnitStridesAndDifferentLayout) {
+  const string hlo_text = R"(
+HloModule SliceWithUnitStridesAndDifferentLayout
+
+ENTRY main {
+  arg = f32[3,4]{0,1} parameter(0)
+  ROOT slice = f32[2,3]{1,0} slice(arg), slice={[1:3], [1:4]}
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+
+  Literal arg = LiteralUtil::CreateR2WithLayout<float>(
+      {{1.0f, 2.0f, 3.0f, 4.0f},
+       {5.0f, 6.0f, 7.0f, 8.0f},
+       {9.0f, 10.0f, 11.0f, 12.0f}},
+      LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal actual, Evaluate({&arg}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{6.0f, 7.0f, 8.0f}, {10.0f, 11.0f, 12.0f}}),
+      actual));
+}
+
+TEST_F(HloEvaluatorTest, ElementwiseWithDifferentLayouts) {
+  const string hlo_text = R"(
+HloModule ElementwiseWithDifferentLayouts
+
+ENTRY main {
+  lhs = f32[2,3]{0,1} parameter(0)
+  rhs = f32[2,3]{1,0} parameter(1)
+  add = f32[2,3]{1,0} add(lhs, rhs)
+  negate = f32[2,3]{0,1} negate(lhs)
+  ROOT multiply = f32[2,3]{0,1} multiply(negate, add)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+
+  Literal lhs = LiteralUtil::CreateR2WithLayout<float>(
+      {{1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}},
+      LayoutUtil::MakeLayout({0, 1}));
+  Literal rhs = LiteralUtil::CreateR2<float>(
+      {{10.0f, 20.0f, 30.0f}, {40.0f, 50.0f, 60.0f}});
+  TF_ASSERT_OK_AND_ASSIGN(Literal actual, Evaluate({&lhs, &rhs}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>(
+          {{-11.0f, -44.0f, -99.0f}, {-176.0f, -275.0f, -396.0f}}),
+      actual));
+}
+
+TEST_F(HloEvaluatorTest, BroadcastWithDifferentLayout) {
+  const string hlo_text = R"(
+HloModule BroadcastWithDifferentLayout
+
+ENTRY main {
+  arg = f32[2,3]{0,1} parameter(0)
+  ROOT broadcast = f32[2,2,3]{1,0,2} broadcast(arg), dimensions={0,2}
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+
+  Literal arg = LiteralUtil::CreateR2WithLayout<float>(
+      {{1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}},
+      LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal actual, Evaluate({&arg}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR3<float>(
+          {{{1.0f, 2.0f, 3.0f}, {1.0f, 2.0f, 3.0f}},
+           {{4.0f, 5.0f, 6.0f}, {4.0f, 5.0f, 6.0f}}}),
+      actual));
+}
+
+TEST_P(HloEvaluatorBf16Test, ReduceAddWithDifferentLayout) {
+  const string hlo_text = R"(
+HloModule ReduceAddWithDifferentLayout
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  arg = f32[2,2,2]{0,1,2} parameter(0)
+  init = f32[] constant(1)
+  ROOT reduce = f32[2,2]{0,1} reduce(arg, init), dimensions={1}, to_apply=add
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+
+  Literal arg = LiteralUtil::CreateR3WithLayout<float>(
+      {{{1.0f, 2.0f}, {3.0f, 4.0f}}, {{5.0f, 6.0f}, {7.0f, 8.0f}}},
+      LayoutUtil::MakeLayout({0, 1, 2}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal actual, Evaluate({&arg}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{5.0f, 7.0f}, {13.0f, 15.0f}}), actual));
+}
+
 TEST_P(HloEvaluatorBf16Test, Bitcast) {
   // Regression test for b/114735354.
   const absl::string_view hlo_text_base = R"(
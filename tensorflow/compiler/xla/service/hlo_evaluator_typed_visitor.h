@@ -2398,6 +2398,19 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     const int64 rank = operand->shape().rank();
     const Literal& operand_literal = parent_->GetEvaluatedLiteralFor(operand);
+    Literal result(shape);
+
+    // Slices with unit strides are copied in runs along the minor dimension.
+    if (absl::c_all_of(slice->slice_strides(),
+                       [](int64 stride) { return stride == 1; })) {
+      TF_RETURN_IF_ERROR(result.CopySliceFrom(
+          operand_literal, slice->slice_starts(),
+          /*dest_base=*/std::vector<int64>(rank, 0),
+          AsInt64Slice(shape.dimensions())));
+      parent_->evaluated_[slice] = std::move(result);
+      return Status::OK();
+    }
+
     auto func = [&](absl::Span<const int64> out_index) {
       DimensionVector operand_index(rank);
       for (int64 i = 0; i < rank; ++i) {
@@ -2407,7 +2420,6 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
       return operand_literal.Get<ReturnT>(operand_index);
     };
 
-    Literal result(shape);
     TF_RETURN_IF_ERROR(result.Populate<ReturnT>(func));
     parent_->evaluated_[slice] = std::move(result);
     return Status::OK();
@@ -2931,14 +2943,28 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     const Literal& lhs_literal = parent_->GetEvaluatedLiteralFor(lhs);
     const Literal& rhs_literal = parent_->GetEvaluatedLiteralFor(rhs);
+    const std::function<ReturnT(ReturnT, ReturnT)> converted_binary_op =
+        ConvertBinaryFunction(binary_op);
 
     Literal result(shape);
 
+    if (HloEvaluator::HaveSameLinearOrder(result.shape(),
+                                          lhs_literal.shape()) &&
+        HloEvaluator::HaveSameLinearOrder(result.shape(),
+                                          rhs_literal.shape())) {
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = converted_binary_op(lhs_data[i], rhs_data[i]);
+      }
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
-          return ConvertBinaryFunction(binary_op)(
-              lhs_literal.Get<ReturnT>(multi_index),
-              rhs_literal.Get<ReturnT>(multi_index));
+          return converted_binary_op(lhs_literal.Get<ReturnT>(multi_index),
+                                     rhs_literal.Get<ReturnT>(multi_index));
         }));
     return std::move(result);
   }
@@ -2961,6 +2987,22 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (HloEvaluator::HaveSameLinearOrder(result.shape(),
+                                          lhs_literal.shape()) &&
+        HloEvaluator::HaveSameLinearOrder(result.shape(),
+                                          rhs_literal.shape()) &&
+        HloEvaluator::HaveSameLinearOrder(result.shape(),
+                                          ehs_literal.shape())) {
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+      absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+      absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+      }
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
@@ -64,6 +64,7 @@ void HloModule::ReplaceEntryComputation(HloComputation* entry_computation) {
 HloComputation* HloModule::AddComputationInternal(
     std::unique_ptr<HloComputation> computation, bool is_entry,
     bool uniquify_identifiers, bool preserve_entry_layouts) {
+  tensorflow::mutex_lock lock(mutex_);
   if (is_entry) {
     CHECK_EQ(nullptr, entry_computation_);
     entry_computation_ = computation.get();
@@ -89,7 +90,7 @@ HloComputation* HloModule::AddComputationInternal(
 
     // Pick unique IDs for each instruction.
     for (auto* instruction : computation->instructions()) {
-      instruction->SetUniqueId(NewUniqueInstructionId());
+      instruction->SetUniqueId(next_unique_id_++);
     }
     // Set unique id to this computation.
     CHECK_NE(computation->root_instruction()->unique_id(), -1)
@@ -130,7 +131,14 @@ HloComputation* HloModule::AddEntryComputationWithLayouts(
                                 /*preserve_entry_layouts=*/true);
 }
 
+void HloModule::UniquifyInstruction(HloInstruction* instruction) {
+  tensorflow::mutex_lock lock(mutex_);
+  instruction->UniquifyName(&instruction_name_uniquer_);
+  instruction->SetUniqueId(next_unique_id_++);
+}
+
 Status HloModule::RemoveEmbeddedComputation(HloComputation* to_remove) {
+  tensorflow::mutex_lock lock(mutex_);
   if (has_schedule() && !to_remove->IsFusionComputation()) {
     schedule_->remove_computation(to_remove);
   }
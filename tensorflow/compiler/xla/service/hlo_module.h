@@ -266,11 +266,17 @@ class HloModule {
 
   // Assign a new unique dense id for an instruction
   int NewUniqueInstructionId() {
+    tensorflow::mutex_lock lock(mutex_);
     int result = next_unique_id_;
     next_unique_id_++;
     return result;
   }
 
+  // Gives `instruction` a name and an id which are unique in the module. This
+  // may be called concurrently, by passes running on computations in
+  // parallel.
+  void UniquifyInstruction(HloInstruction* instruction);
+
   // input_output_alias_config indicates the list of aliased buffers that are
   // expected from the module.
   HloInputOutputAliasConfig& input_output_alias_config() {
@@ -386,6 +392,10 @@ class HloModule {
   NameUniquer instruction_name_uniquer_{/*separator=*/"."};
   int next_unique_id_ = 0;
 
+  // Serializes the additions and removals of computations, and the uniquing of
+  // identifiers, which passes running on computations in parallel may do.
+  mutable tensorflow::mutex mutex_;
+
   // Used to keep track of the next unique module id that should be assigned.
   static std::atomic<int> next_unique_module_id_;
   // A unique id to label modules with.
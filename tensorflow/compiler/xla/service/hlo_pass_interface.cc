@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+#include <algorithm>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+
+namespace xla {
+
+StatusOr<bool> HloComputationPass::Run(HloModule* module) {
+  bool changed = false;
+  if (thread_pool_ != nullptr && thread_pool_->NumThreads() > 1) {
+    TF_ASSIGN_OR_RETURN(changed, RunOnComputationsInParallel(module));
+  } else {
+    for (HloComputation* computation : ComputationsToRun(module)) {
+      TF_ASSIGN_OR_RETURN(bool computation_changed,
+                          RunOnComputation(computation));
+      changed |= computation_changed;
+    }
+  }
+  TF_ASSIGN_OR_RETURN(bool module_changed,
+                      RunOnModuleAfterComputations(module));
+  return changed || module_changed;
+}
+
+StatusOr<bool> HloComputationPass::RunOnComputationsInParallel(
+    HloModule* module) {
+  // The depth of a computation in the call graph is greater than the depths of
+  // the computations it calls, so the computations of the same depth don't
+  // depend on each other.
+  absl::flat_hash_map<const HloComputation*, int> depths;
+  for (const HloComputation* computation : module->MakeComputationPostOrder()) {
+    int depth = 0;
+    for (const HloInstruction* instruction : computation->instructions()) {
+      for (const HloComputation* callee : instruction->called_computations()) {
+        depth = std::max(depth, depths.at(callee) + 1);
+      }
+    }
+    depths[computation] = depth;
+  }
+  std::vector<std::vector<HloComputation*>> computations_by_depth;
+  for (HloComputation* computation : ComputationsToRun(module)) {
+    const int depth = depths.at(computation);
+    if (depth >= computations_by_depth.size()) {
+      computations_by_depth.resize(depth + 1);
+    }
+    computations_by_depth[depth].push_back(computation);
+  }
+
+  bool changed = false;
+  for (const std::vector<HloComputation*>& computations :
+       computations_by_depth) {
+    std::vector<StatusOr<bool>> results(computations.size(), false);
+    tensorflow::BlockingCounter counter(computations.size());
+    for (int i = 0; i < computations.size(); ++i) {
+      thread_pool_->Schedule([this, &computations, &results, &counter, i]() {
+        results[i] = RunOnComputation(computations[i]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    for (const StatusOr<bool>& result : results) {
+      TF_RETURN_IF_ERROR(result.status());
+      changed |= result.ValueOrDie();
+    }
+  }
+  return changed;
+}
+
+}  // namespace xla
@@ -16,12 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HLO_PASS_INTERFACE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HLO_PASS_INTERFACE_H_
 
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_module_group.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -68,6 +72,52 @@ class HloModulePass : public HloPassInterface {
   virtual void UpdateLayout(Shape* shape) {}
 };
 
+// Base class for module passes which transform each computation of the module
+// independently of the other computations, except the computations it calls,
+// which it may read. Running the pass on the module runs it on each
+// computation, then on the module, e.g. to remove the computations which are
+// no longer called.
+//
+// When given a thread pool, e.g. by the pass pipeline when
+// --xla_hlo_pass_threads is greater than 1, the pass runs on the computations
+// in parallel: the computations run after the computations they call,
+// concurrently with the ones they don't depend on. RunOnComputation() may add
+// instructions and computations to the module but must not remove
+// computations or iterate over the computations of the module, nor change the
+// computations it calls.
+class HloComputationPass : public HloModulePass {
+ public:
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // Runs the pass on `computation` only.
+  virtual StatusOr<bool> RunOnComputation(HloComputation* computation) = 0;
+
+  // Sets the thread pool Run() runs the pass on the computations with. The
+  // computations run serially if `thread_pool` is null, the default.
+  void set_thread_pool(tensorflow::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
+ protected:
+  // Returns the computations of `module` the pass runs on, in the order Run()
+  // runs the pass on them when it runs serially.
+  virtual std::vector<HloComputation*> ComputationsToRun(HloModule* module) {
+    return module->MakeComputationPostOrder();
+  }
+
+  // Runs the pass on `module` once it has run on its computations.
+  virtual StatusOr<bool> RunOnModuleAfterComputations(HloModule* module) {
+    return false;
+  }
+
+ private:
+  // Runs the pass on the computations of `module`, in parallel on
+  // thread_pool_.
+  StatusOr<bool> RunOnComputationsInParallel(HloModule* module);
+
+  tensorflow::thread::ThreadPool* thread_pool_ = nullptr;
+};
+
 // Base class for passes which are module-group scoped. These passes cannot run
 // on an HLO module.
 class HloModuleGroupPass : public HloPassInterface {
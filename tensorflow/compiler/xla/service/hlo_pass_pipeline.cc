@@ -19,18 +19,39 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/dump.h"
 #include "tensorflow/compiler/xla/service/hlo_graph_dumper.h"
+#include "tensorflow/compiler/xla/service/hlo_module_group.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace xla {
 
+namespace {
+
+int64 InstructionCount(const HloModule& module) {
+  return module.instruction_count();
+}
+
+int64 InstructionCount(const HloModuleGroup& module_group) {
+  int64 count = 0;
+  for (const HloModule* module : module_group.modules()) {
+    count += module->instruction_count();
+  }
+  return count;
+}
+
+}  // namespace
+
 template <typename HloT>
 Status HloPassPipeline::RunInvariantCheckers(
     HloT* hlo, absl::string_view after_pass_name) {
@@ -64,14 +85,41 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
     MaybeDumpHlo(*hlo,
                  /*after_pass_name=*/last_pass_name,
                  /*before_pass_name=*/pass_name);
+    int64 instructions_before = 0;
     if (!pass->IsPassPipeline()) {
       compilation_stats_->StartPass(pass_name);
+      instructions_before = InstructionCount(*hlo);
+    }
+    if (auto* computation_pass = dynamic_cast<HloComputationPass*>(pass)) {
+      computation_pass->set_thread_pool(thread_pool_.get());
+    }
+    // Nested pipelines are traced through their passes.
+    absl::optional<tensorflow::profiler::TraceMe> trace_me;
+    if (!pass->IsPassPipeline()) {
+      trace_me.emplace(
+          [&] {
+            return tensorflow::profiler::TraceMeEncode(
+                absl::StrCat("HloPass:", pass_name),
+                {{"instructions_before", instructions_before}});
+          },
+          tensorflow::profiler::TraceMeLevel::kInfo);
     }
     TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
     changed |= pass_changed;
     if (pass_changed) {
       VLOG(3) << "  Pass caused changes" << pass->name();
     }
+    if (!pass->IsPassPipeline()) {
+      int64 instructions_after = InstructionCount(*hlo);
+      trace_me->AppendMetadata([&] {
+        return tensorflow::profiler::TraceMeEncode(
+            {{"instructions_after", instructions_after},
+             {"changed", pass_changed}});
+      });
+      trace_me.reset();
+      compilation_stats_->RecordInstructionCounts(
+          pass_name, instructions_before, instructions_after);
+    }
     TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass_name));
     last_pass_name = string(pass_name);
     if (!pass->IsPassPipeline()) {
@@ -128,6 +176,14 @@ std::vector<HloPassInterface*> HloPassPipeline::GetEnabledPasses(
   return enabled_passes;
 }
 
+void HloPassPipeline::MaybeCreateThreadPool(const DebugOptions& debug_options) {
+  const int num_threads = debug_options.xla_hlo_pass_threads();
+  if (num_threads > 1 && thread_pool_ == nullptr) {
+    thread_pool_ = absl::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "xla_hlo_pass", num_threads);
+  }
+}
+
 void HloPassPipeline::MaybeDumpHlo(const HloModule& module,
                                    absl::string_view after_pass_name,
                                    absl::string_view before_pass_name) {
@@ -149,6 +205,7 @@ StatusOr<bool> HloPassPipeline::Run(HloModule* module) {
   VLOG(1) << "Running HLO pass pipeline on module " << module->name() << ": "
           << name();
 
+  MaybeCreateThreadPool(module->config().debug_options());
   return RunPassesInternal(module,
                            GetEnabledPasses(module->config().debug_options()));
 }
@@ -164,6 +221,7 @@ StatusOr<bool> HloPassPipeline::RunOnModuleGroup(HloModuleGroup* module_group) {
     return false;
   }
 
+  MaybeCreateThreadPool(module_group->module(0).config().debug_options());
   return RunPassesInternal(
       module_group,
       GetEnabledPasses(module_group->module(0).config().debug_options()));
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -102,6 +103,10 @@ class HloPassPipeline : public HloPassInterface {
   template <typename HloT>
   Status RunInvariantCheckers(HloT* hlo, absl::string_view after_pass_name);
 
+  // Creates the thread pool the passes which transform each computation
+  // independently run on, if --xla_hlo_pass_threads asks for one.
+  void MaybeCreateThreadPool(const DebugOptions& debug_options);
+
   // Helper which runs the given pass on the given HLO. HloT can be either
   // HloModule or HloModuleGroup.
   template <typename HloT>
@@ -128,6 +133,10 @@ class HloPassPipeline : public HloPassInterface {
   std::vector<std::unique_ptr<HloPassInterface>> invariant_checkers_;
   bool run_called_ = false;
 
+  // Thread pool the passes which transform each computation independently run
+  // on; null if they run serially.
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool_;
+
   CompilationStats* compilation_stats_;
   // Default stats instance for when one is not passed in the constructor.
   // Use via compilation_stats_, not directly.
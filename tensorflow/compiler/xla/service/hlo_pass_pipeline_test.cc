@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/compilation_stats.h"
+#include "tensorflow/compiler/xla/service/compilation_stats.pb.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -58,6 +62,34 @@ class FooToBarModulePass : public HloModulePass {
   }
 };
 
+// A computation pass which renames the 'foo' prefix of instruction names to
+// 'bar', and returns an error if a computation calls a computation it didn't
+// run on yet.
+class FooToBarComputationPass : public HloComputationPass {
+  absl::string_view name() const override { return "foo2bar-computation"; }
+
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override {
+    bool changed = false;
+    for (HloInstruction* instruction : computation->instructions()) {
+      for (HloComputation* callee : instruction->called_computations()) {
+        for (HloInstruction* callee_instruction : callee->instructions()) {
+          TF_RET_CHECK(!absl::StartsWith(callee_instruction->name(), "foo"))
+              << "Ran on " << computation->name() << " before "
+              << callee->name();
+        }
+      }
+    }
+    for (HloInstruction* instruction : computation->instructions()) {
+      if (absl::StartsWith(instruction->name(), "foo")) {
+        instruction->SetAndSanitizeName(
+            absl::StrCat("bar", instruction->name().substr(3)));
+        changed = true;
+      }
+    }
+    return changed;
+  }
+};
+
 // A module group pass which renames instructions named 'baz' to 'qux'.
 class BazToQuxModuleGroupPass : public HloModuleGroupPass {
   absl::string_view name() const override { return "baz2qux"; }
@@ -78,6 +110,19 @@ class BazToQuxModuleGroupPass : public HloModuleGroupPass {
   }
 };
 
+// A module pass which negates the root of the entry computation.
+class NegateRootModulePass : public HloModulePass {
+  absl::string_view name() const override { return "negate-root"; }
+
+  StatusOr<bool> Run(HloModule* module) override {
+    HloComputation* entry = module->entry_computation();
+    HloInstruction* root = entry->root_instruction();
+    entry->set_root_instruction(entry->AddInstruction(
+        HloInstruction::CreateUnary(root->shape(), HloOpcode::kNegate, root)));
+    return true;
+  }
+};
+
 // An invariant checker pass which returns an error if there exists an
 // instruction named 'bar'.
 class BarBlowerUpper : public HloModulePass {
@@ -138,6 +183,41 @@ ENTRY main {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(HloPassPipelineTest, CompilationStats) {
+  const string module_str = R"(
+HloModule CompilationStats
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT foo = f32[] multiply(a, b)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  std::unique_ptr<CompilationStats> stats = CompilationStats::MakeStats();
+  HloPassPipeline pipeline(TestName(), stats.get());
+  pipeline.AddPass<NegateRootModulePass>();
+  pipeline.AddPass<FooToBarModulePass>();
+  pipeline.AddPass<NegateRootModulePass>();
+  TF_ASSERT_OK(pipeline.Run(module.get()).status());
+
+  CompilationStatsProto proto = stats->ToProto();
+  ASSERT_EQ(proto.passes_size(), 2);
+  for (const auto& pass : proto.passes()) {
+    if (pass.name() == "negate-root") {
+      EXPECT_EQ(pass.num_runs(), 2);
+      EXPECT_EQ(pass.max_instructions(), 4);
+      EXPECT_EQ(pass.instruction_delta(), 2);
+    } else {
+      EXPECT_EQ(pass.name(), "foo2bar");
+      EXPECT_EQ(pass.num_runs(), 1);
+      EXPECT_EQ(pass.max_instructions(), 4);
+      EXPECT_EQ(pass.instruction_delta(), 0);
+    }
+  }
+}
+
 TEST_F(HloPassPipelineTest, MixedPipeline) {
   // Test a pipeline with both a module pass and a module group pass.
   const string module_0_str = R"(
@@ -255,5 +335,54 @@ ENTRY main {
       ::testing::HasSubstr("Module group pass cannot be run on a module"));
 }
 
+TEST_F(HloPassPipelineTest, ComputationPassInParallel) {
+  // Test an HLO computation pass running on the computations in parallel, after
+  // the computations they call.
+  const string module_str = R"(
+HloModule ComputationPassInParallel
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT foo.add = f32[] add(x, y)
+}
+
+mul {
+  x.1 = f32[] parameter(0)
+  y.1 = f32[] parameter(1)
+  ROOT foo.mul = f32[] multiply(x.1, y.1)
+}
+
+add_and_mul {
+  x.2 = f32[] parameter(0)
+  y.2 = f32[] parameter(1)
+  sum = f32[] call(x.2, y.2), to_apply=add
+  ROOT foo.add_and_mul = f32[] call(sum, y.2), to_apply=mul
+}
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  sum.1 = f32[] call(a, b), to_apply=add
+  ROOT foo.main = f32[] call(sum.1, b), to_apply=add_and_mul
+}
+)";
+  HloModuleConfig config = GetModuleConfigForTest();
+  DebugOptions debug_options = config.debug_options();
+  debug_options.set_xla_hlo_pass_threads(4);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str, config));
+  HloPassPipeline pipeline(TestName());
+  pipeline.AddPass<FooToBarComputationPass>();
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  for (HloComputation* computation : module->computations()) {
+    EXPECT_TRUE(
+        absl::StartsWith(computation->root_instruction()->name(), "bar"));
+  }
+}
+
 }  // namespace
 }  // namespace xla
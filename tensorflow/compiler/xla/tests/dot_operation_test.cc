@@ -1431,6 +1431,55 @@ ENTRY main {
   EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
 }
 
+XLA_TEST_F(DotOperationTextTest, DotAddWithTemporaryAddend) {
+  // The addend is a temporary with a single use, so a backend that computes
+  // the product into the output of the add must not let it share that buffer.
+  absl::string_view hlo_string =
+      R"(
+HloModule DotAddWithTemporaryAddend
+
+ENTRY main {
+  lhs_0 = f32[19,50] parameter(0)
+  rhs_0 = f32[50,19] parameter(1)
+  lhs_1 = f32[19,50] parameter(2)
+  rhs_1 = f32[50,19] parameter(3)
+
+  dot_0 = f32[19,19] dot(lhs_0, rhs_0), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot_1 = f32[19,19] dot(lhs_1, rhs_1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+
+  ROOT result = f32[19,19] add(dot_0, dot_1)
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
+}
+
+XLA_TEST_F(DotOperationTextTest, DotBiasAddActivationWithTemporaryAddend) {
+  // Large enough for the CPU backend to compute the product in several blocks
+  // of rows, with a remainder block.
+  absl::string_view hlo_string =
+      R"(
+HloModule DotBiasAddActivationWithTemporaryAddend
+
+ENTRY main {
+  lhs_0 = f32[300,64] parameter(0)
+  rhs_0 = f32[64,256] parameter(1)
+  lhs_1 = f32[300,32] parameter(2)
+  rhs_1 = f32[32,256] parameter(3)
+  bias = f32[256] parameter(4)
+
+  dot_0 = f32[300,256] dot(lhs_0, rhs_0), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot_1 = f32[300,256] dot(lhs_1, rhs_1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  broadcast = f32[300,256] broadcast(bias), dimensions={1}
+  add_0 = f32[300,256] add(dot_0, dot_1)
+  add_1 = f32[300,256] add(add_0, broadcast)
+  ROOT result = f32[300,256] tanh(add_1)
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
+}
+
 XLA_TEST_F(DotOperationTextTest, S32IotaDot) {
   absl::string_view hlo_string =
       R"(
@@ -1824,5 +1873,83 @@ void DOT_ReorderContracting(int num_iters) {
 
 BENCHMARK(DOT_ReorderContracting);
 
+// Step time of a model of independent towers of matrix multiplications, with
+// all thunks on one stream (arg 0) or with the streams assigned along the
+// critical path (arg 1).
+void BM_IndependentTowers(int num_iters, int critical_path_streams) {
+  tensorflow::testing::StopTiming();
+
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
+  auto executors = PlatformUtil::GetStreamExecutors(platform).ValueOrDie();
+  se::StreamExecutorMemoryAllocator allocator(platform, executors);
+
+  xla::LocalClientOptions client_options;
+  client_options.set_platform(platform);
+  auto client =
+      ClientLibrary::GetOrCreateLocalClient(client_options).ValueOrDie();
+
+  int device_ordinal = client->default_device_ordinal();
+
+  const int64 kNumTowers = 4;
+  const int64 kTowerDepth = 8;
+  // Large enough for the products not to be merged by GemmBatcher.
+  const int64 kSize = 512;
+
+  Shape shape = ShapeUtil::MakeShape(F32, {kSize, kSize});
+  XlaBuilder builder("IndependentTowers");
+  std::vector<XlaOp> outputs;
+  for (int64 tower = 0; tower < kNumTowers; ++tower) {
+    XlaOp x = Parameter(&builder, tower, shape, absl::StrCat("param", tower));
+    for (int64 layer = 0; layer < kTowerDepth; ++layer) {
+      x = Tanh(Dot(x, x));
+    }
+    outputs.push_back(x);
+  }
+  Tuple(&builder, outputs);
+  auto computation = builder.Build().ConsumeValueOrDie();
+
+  Array2D<float> input_arr(kSize, kSize);
+  input_arr.FillRandom(0.01f);
+  auto input_literal = LiteralUtil::CreateR2FromArray2D<float>(input_arr);
+  std::vector<ScopedShapedBuffer> buffers;
+  std::vector<const ShapedBuffer*> arguments;
+  std::vector<const Shape*> argument_shapes;
+  for (int64 tower = 0; tower < kNumTowers; ++tower) {
+    buffers.push_back(
+        client->LiteralToShapedBuffer(input_literal, device_ordinal)
+            .ConsumeValueOrDie());
+  }
+  for (const ScopedShapedBuffer& buffer : buffers) {
+    arguments.push_back(&buffer);
+    argument_shapes.push_back(&buffer.on_host_shape());
+  }
+
+  ExecutableBuildOptions build_options;
+  DebugOptions* debug_options = build_options.mutable_debug_options();
+  debug_options->set_xla_gpu_disable_multi_streaming(!critical_path_streams);
+  debug_options->set_xla_gpu_critical_path_stream_assignment(
+      critical_path_streams);
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto executables,
+      client->Compile(computation, argument_shapes, build_options));
+  auto executable = std::move(executables[0]);
+
+  ExecutableRunOptions options;
+  options.set_allocator(&allocator);
+
+  const int kWarmups = 2;
+  for (int i = 0; i < kWarmups; ++i) {
+    ASSERT_IS_OK(executable->Run(arguments, options));
+  }
+
+  tensorflow::testing::UseRealTime();
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < num_iters; ++i) {
+    ASSERT_IS_OK(executable->Run(arguments, options));
+  }
+}
+
+BENCHMARK(BM_IndependentTowers)->Arg(0)->Arg(1);
+
 }  // namespace
 }  // namespace xla
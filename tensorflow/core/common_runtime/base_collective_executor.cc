@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -281,7 +283,8 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
   // starve executor threads.
   col_impl->Ref();
   profiler::TraceMeProducer producer("BaseCollectiveExecutor::ExecuteAsync");
-  RunClosure([col_impl, col_ctx, done_safe, ctx,
+  const uint64 start_micros = Env::Default()->NowMicros();
+  RunClosure([col_impl, col_ctx, done_safe, ctx, start_micros,
               context_id = producer.GetContextId()]() {
     core::ScopedUnref unref(col_impl);
     profiler::TraceMeConsumer consumer(
@@ -293,8 +296,15 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
         },
         context_id);
     col_impl->Ref();
-    col_impl->Run([col_impl, col_ctx, done_safe](const Status& s) {
+    col_impl->Run([col_impl, col_ctx, done_safe,
+                   start_micros](const Status& s) {
       core::ScopedUnref unref(col_impl);
+      if (s.ok()) {
+        const CollectiveParams& cp = col_ctx->col_params;
+        metrics::RecordCollectiveOp(strings::StrCat(cp.group.group_key),
+                                    strings::StrCat(cp.instance.instance_key),
+                                    Env::Default()->NowMicros() - start_micros);
+      }
       done_safe(s);
     });
   });
@@ -37,6 +37,21 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr size_t BFCAllocator::kMaxThreadCacheChunkSize;
+constexpr int BFCAllocator::kNumThreadCacheBins;
+constexpr int BFCAllocator::kNumThreadCacheShards;
+
+namespace {
+
+// Sets `*value` to `v` if `v` is greater.
+void UpdateMax(std::atomic<int64>* value, int64 v) {
+  int64 current = value->load(std::memory_order_relaxed);
+  while (v > current &&
+         !value->compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
@@ -230,6 +245,13 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
   VLOG(1) << "AllocateRaw " << Name() << "  " << num_bytes;
+  if (thread_cache_shards_ != nullptr &&
+      allocation_attr.freed_by_func == nullptr) {
+    void* ptr = AllocateFromThreadCache(num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
   if (!allocation_attr.retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
@@ -398,6 +420,15 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Chunks held by the thread cache may be all that is missing.
+  if (FlushThreadCaches()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   if ((freed_before == 0) && (!timestamped_chunks_.empty())) {
     // We're unable to satisfy an allocation request without a specific
     // timestamp requirement.  Rather than fail, try merging any held-out
@@ -484,6 +515,7 @@ void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
                            {"bytes_allocated", stats_.bytes_in_use},
                            {"bytes_available", bytes_available},
                            {"fragmentation", GetFragmentation()},
+                           {"largest_free_block_bytes", LargestFreeChunk()},
                            {"peak_bytes_in_use", stats_.peak_bytes_in_use},
                            {"requested_bytes", req_bytes},
                            {"allocation_bytes", alloc_bytes},
@@ -534,14 +566,26 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         // Assign a unique id and increment the id counter, marking the
         // chunk as being in use.
         chunk->allocation_id = next_allocation_id_++;
+        // The chunk may have been freed under a timing counter. Its count
+        // only applies until it is reused, and must not follow it into the
+        // thread caches or to its next deallocation.
+        chunk->freed_at_count = 0;
 
         // Update stats.
         ++stats_.num_allocs;
         stats_.bytes_in_use += chunk->size;
-        stats_.peak_bytes_in_use =
-            std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+        bytes_in_use_snapshot_.store(stats_.bytes_in_use,
+                                     std::memory_order_relaxed);
+        stats_.peak_bytes_in_use = std::max(
+            stats_.peak_bytes_in_use,
+            stats_.bytes_in_use -
+                thread_cache_bytes_.load(std::memory_order_relaxed));
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        if (thread_cache_shards_ != nullptr && timing_counter_ == nullptr &&
+            rounded_bytes <= kMaxThreadCacheChunkSize) {
+          LendChunk(*chunk);
+        }
 
 #ifdef TENSORFLOW_MEM_DEBUG
         if (ShouldRecordOpName()) {
@@ -617,7 +661,9 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
-  DeallocateRawInternal(ptr);
+  if (thread_cache_shards_ == nullptr || !DeallocateToThreadCache(ptr)) {
+    DeallocateRawInternal(ptr);
+  }
   retry_helper_.NotifyDealloc();
 }
 
@@ -637,15 +683,7 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   int64 req_bytes = chunk->requested_size;
   int64 alloc_bytes = chunk->size;
 
-  MarkFree(h);
-
-  // Consider coalescing it.
-  if (timing_counter_) {
-    InsertFreeChunkIntoBin(h);
-    timestamped_chunks_.push_back(h);
-  } else {
-    InsertFreeChunkIntoBin(TryToCoalesce(h, false));
-  }
+  FreeChunk(h);
 
   // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
   // correct aggregation stats (bytes_in_use, fragmentation).
@@ -725,6 +763,18 @@ void BFCAllocator::RemoveFreeChunkFromBin(BFCAllocator::ChunkHandle h) {
   c->bin_num = kInvalidBinNum;
 }
 
+void BFCAllocator::FreeChunk(BFCAllocator::ChunkHandle h) {
+  MarkFree(h);
+
+  // Consider coalescing it.
+  if (timing_counter_) {
+    InsertFreeChunkIntoBin(h);
+    timestamped_chunks_.push_back(h);
+  } else {
+    InsertFreeChunkIntoBin(TryToCoalesce(h, false));
+  }
+}
+
 void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
   Chunk* c = ChunkFromHandle(h);
   CHECK(c->in_use() && (c->bin_num == kInvalidBinNum));
@@ -739,6 +789,7 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
 
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
+  bytes_in_use_snapshot_.store(stats_.bytes_in_use, std::memory_order_relaxed);
 
 #ifdef TENSORFLOW_MEM_DEBUG
   if (ShouldRecordOpName()) {
@@ -870,6 +921,15 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  if (lent_chunk_shards_ != nullptr) {
+    // The requested size of a lent chunk changes each time it is reused.
+    LentChunkShard* lent = LentChunkShardFor(ptr);
+    mutex_lock l(lent->mu);
+    auto it = lent->chunks.find(ptr);
+    if (it != lent->chunks.end()) {
+      return it->second.requested_size;
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -888,6 +948,14 @@ size_t BFCAllocator::AllocatedSize(const void* ptr) const {
 }
 
 int64 BFCAllocator::AllocationId(const void* ptr) const {
+  if (lent_chunk_shards_ != nullptr) {
+    LentChunkShard* lent = LentChunkShardFor(ptr);
+    mutex_lock l(lent->mu);
+    auto it = lent->chunks.find(ptr);
+    if (it != lent->chunks.end()) {
+      return it->second.allocation_id;
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -1070,6 +1138,8 @@ void BFCAllocator::MaybeWriteMemoryMap() {
 
 MemoryDump BFCAllocator::RecordMemoryMap() {
   mutex_lock l(lock_);
+  // Show the chunks held by the thread cache as free.
+  FlushThreadCaches();
   return RecordMemoryMapInternal();
 }
 
@@ -1141,14 +1211,180 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  if (thread_cache_shards_ == nullptr) {
+    return stats_;
+  }
+  AllocatorStats stats = stats_;
+  stats.num_allocs += thread_cache_num_allocs_.load();
+  stats.bytes_in_use -= thread_cache_bytes_.load();
+  stats.peak_bytes_in_use = std::max(stats.peak_bytes_in_use,
+                                     thread_cache_peak_bytes_in_use_.load());
+  stats.largest_alloc_size = std::max(stats.largest_alloc_size,
+                                      thread_cache_largest_alloc_size_.load());
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
   stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use - thread_cache_bytes_.load();
   stats_.largest_alloc_size = 0;
+  thread_cache_num_allocs_.store(0);
+  thread_cache_peak_bytes_in_use_.store(0);
+  thread_cache_largest_alloc_size_.store(0);
+}
+
+void BFCAllocator::SetThreadCacheLimit(size_t max_cached_bytes) {
+  CHECK(thread_cache_shards_ == nullptr)
+      << "The thread cache of " << Name() << " can only be enabled once";
+  if (max_cached_bytes == 0) {
+    return;
+  }
+  thread_cache_limit_ = max_cached_bytes;
+  lent_chunk_shards_.reset(new LentChunkShard[kNumThreadCacheShards]);
+  thread_cache_shards_.reset(new ThreadCacheShard[kNumThreadCacheShards]);
+}
+
+// static
+BFCAllocator::ThreadCacheShard* BFCAllocator::ThreadCacheShardForCurrentThread(
+    ThreadCacheShard* shards) {
+  // Threads are assigned shards round-robin, so that up to
+  // kNumThreadCacheShards threads never contend on a shard.
+  static std::atomic<int> next_thread_index{0};
+  static thread_local const int thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return &shards[thread_index % kNumThreadCacheShards];
+}
+
+void BFCAllocator::LendChunk(const Chunk& c) {
+  DCHECK_LT(BinNumForSize(c.size), kNumThreadCacheBins);
+  LentChunkShard* lent = LentChunkShardFor(c.ptr);
+  mutex_lock l(lent->mu);
+  lent->chunks[c.ptr] = {c.size, c.requested_size, c.allocation_id};
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t num_bytes) {
+  if (num_bytes == 0 || num_bytes > kMaxThreadCacheChunkSize ||
+      timing_counter_ != nullptr || profiler::TraceMe::Active()) {
+    return nullptr;
+  }
+  const size_t rounded_bytes = RoundedBytes(num_bytes);
+  // As in FindChunkPtr(), do not waste more than half of a chunk. The chunks
+  // that fit are in the bin of `rounded_bytes` or in the next one.
+  const BinNum first_bin = BinNumForSize(rounded_bytes);
+  const BinNum last_bin = std::min(first_bin + 1, kNumThreadCacheBins - 1);
+  CachedChunk chunk{nullptr, 0};
+  {
+    ThreadCacheShard* shard =
+        ThreadCacheShardForCurrentThread(thread_cache_shards_.get());
+    mutex_lock l(shard->mu);
+    for (BinNum b = first_bin; b <= last_bin && chunk.ptr == nullptr; ++b) {
+      std::vector<CachedChunk>& chunks = shard->bins[b];
+      // Prefer the most recently freed chunk, which is likely in cache.
+      for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) {
+        if (it->size >= rounded_bytes && it->size < 2 * rounded_bytes) {
+          chunk = *it;
+          chunks.erase(std::next(it).base());
+          shard->cached_bytes -= chunk.size;
+          break;
+        }
+      }
+    }
+  }
+  if (chunk.ptr == nullptr) {
+    return nullptr;
+  }
+  {
+    LentChunkShard* lent = LentChunkShardFor(chunk.ptr);
+    mutex_lock l(lent->mu);
+    lent->chunks[chunk.ptr] = {chunk.size, num_bytes, next_allocation_id_++};
+  }
+  const int64 cached_bytes =
+      thread_cache_bytes_.fetch_sub(chunk.size) - chunk.size;
+  thread_cache_num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  UpdateMax(&thread_cache_peak_bytes_in_use_,
+            bytes_in_use_snapshot_.load(std::memory_order_relaxed) -
+                cached_bytes);
+  UpdateMax(&thread_cache_largest_alloc_size_, chunk.size);
+  VLOG(4) << "Returning cached: " << chunk.ptr;
+  return chunk.ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  if (ptr == nullptr) {
+    return false;
+  }
+  size_t size;
+  {
+    LentChunkShard* lent = LentChunkShardFor(ptr);
+    mutex_lock l(lent->mu);
+    auto it = lent->chunks.find(ptr);
+    if (it == lent->chunks.end()) {
+      return false;
+    }
+    size = it->second.size;
+    lent->chunks.erase(it);
+  }
+  thread_cache_bytes_.fetch_add(size);
+
+  std::vector<CachedChunk> evicted;
+  {
+    ThreadCacheShard* shard =
+        ThreadCacheShardForCurrentThread(thread_cache_shards_.get());
+    mutex_lock l(shard->mu);
+    shard->bins[BinNumForSize(size)].push_back({ptr, size});
+    shard->cached_bytes += size;
+    if (shard->cached_bytes > thread_cache_limit_) {
+      // Evict the least recently freed chunks, largest first, down to half of
+      // the limit so that the lock is not taken on every deallocation.
+      for (BinNum b = kNumThreadCacheBins - 1;
+           b >= 0 && shard->cached_bytes > thread_cache_limit_ / 2; --b) {
+        std::vector<CachedChunk>& chunks = shard->bins[b];
+        auto end = chunks.begin();
+        while (end != chunks.end() &&
+               shard->cached_bytes > thread_cache_limit_ / 2) {
+          shard->cached_bytes -= end->size;
+          evicted.push_back(*end++);
+        }
+        chunks.erase(chunks.begin(), end);
+      }
+    }
+  }
+  if (!evicted.empty()) {
+    mutex_lock l(lock_);
+    ReturnCachedChunks(evicted);
+  }
+  return true;
+}
+
+void BFCAllocator::ReturnCachedChunks(const std::vector<CachedChunk>& chunks) {
+  for (const CachedChunk& c : chunks) {
+    BFCAllocator::ChunkHandle h = region_manager_.get_handle(c.ptr);
+    CHECK(h != kInvalidChunkHandle);
+    FreeChunk(h);
+    thread_cache_bytes_.fetch_sub(c.size);
+  }
+  if (VLOG_IS_ON(4)) {
+    LOG(INFO) << "F: " << RenderOccupancy();
+  }
+}
+
+bool BFCAllocator::FlushThreadCaches() {
+  if (thread_cache_shards_ == nullptr) {
+    return false;
+  }
+  std::vector<CachedChunk> chunks;
+  for (int i = 0; i < kNumThreadCacheShards; ++i) {
+    ThreadCacheShard* shard = &thread_cache_shards_[i];
+    mutex_lock l(shard->mu);
+    for (std::vector<CachedChunk>& bin : shard->bins) {
+      chunks.insert(chunks.end(), bin.begin(), bin.end());
+      bin.clear();
+    }
+    shard->cached_bytes = 0;
+  }
+  ReturnCachedChunks(chunks);
+  return !chunks.empty();
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -79,6 +81,19 @@ class BFCAllocator : public Allocator {
 
   void SetTimingCounter(SharedCounter* sc) { timing_counter_ = sc; }
 
+  // Enables a cache of recently freed small chunks, which serves
+  // allocations and deallocations of up to kMaxThreadCacheChunkSize bytes
+  // without taking the allocator lock. Freed chunks are cached in a shard
+  // selected by the calling thread, and each shard holds at most
+  // `max_cached_bytes`; the excess is returned to the bins. All cached chunks
+  // are returned to the bins before the allocator reports running out of
+  // memory. A value of 0 leaves the cache disabled.
+  //
+  // Must be called at most once, before the first allocation. The cache is
+  // bypassed when a timing counter is set or when the profiler is active.
+  void SetThreadCacheLimit(size_t max_cached_bytes);
+  static constexpr size_t kMaxThreadCacheChunkSize = 64 << 10;
+
   void SetSafeFrontier(uint64 count) override;
 
   bool ShouldRecordOpName() const { return true; }
@@ -98,6 +113,14 @@ class BFCAllocator : public Allocator {
 
   void DeallocateRawInternal(void* ptr);
 
+  // Returns a cached chunk that fits `num_bytes`, or nullptr if the shard of
+  // the calling thread has none.
+  void* AllocateFromThreadCache(size_t num_bytes) TF_LOCKS_EXCLUDED(lock_);
+
+  // Caches `ptr` if it was allocated by the thread cache. Returns false if
+  // `ptr` must be deallocated by DeallocateRawInternal().
+  bool DeallocateToThreadCache(void* ptr) TF_LOCKS_EXCLUDED(lock_);
+
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
   //
@@ -450,6 +473,9 @@ class BFCAllocator : public Allocator {
 
   void MarkFree(ChunkHandle h) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Marks 'h' free and inserts it, coalesced where allowed, into its bin.
+  void FreeChunk(ChunkHandle h) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   ChunkHandle TryToCoalesce(ChunkHandle h, bool ignore_freed_at)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -470,6 +496,73 @@ class BFCAllocator : public Allocator {
   std::array<BinDebugInfo, kNumBins> get_bin_debug_info()
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // The thread cache.
+  //
+  // A small chunk allocated while the cache is enabled is "lent" to the
+  // cache: it stays in use as far as the bins are concerned until it is
+  // flushed, and it is tracked in a LentChunkShard (selected by address)
+  // while the user holds it, and in a ThreadCacheShard (selected by the
+  // freeing thread) while it is free.
+  //
+  // A lent chunk is smaller than twice its rounded request, so it always
+  // falls in one of the first kNumThreadCacheBins bins.
+  static constexpr int kNumThreadCacheBins = 9;
+  static constexpr int kNumThreadCacheShards = 16;
+
+  struct CachedChunk {
+    void* ptr;
+    size_t size;
+  };
+  struct ThreadCacheShard {
+    mutex mu;
+    std::array<std::vector<CachedChunk>, kNumThreadCacheBins> bins
+        TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+  };
+  struct LentChunk {
+    size_t size;
+    size_t requested_size;
+    int64 allocation_id;
+  };
+  struct LentChunkShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, LentChunk> chunks TF_GUARDED_BY(mu);
+  };
+
+  static ThreadCacheShard* ThreadCacheShardForCurrentThread(
+      ThreadCacheShard* shards);
+  LentChunkShard* LentChunkShardFor(const void* ptr) const {
+    return &lent_chunk_shards_[(reinterpret_cast<uintptr_t>(ptr) >>
+                                kMinAllocationBits) %
+                               kNumThreadCacheShards];
+  }
+
+  // Registers the chunk `c`, just allocated from the bins, as lent.
+  void LendChunk(const Chunk& c) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns `chunks`, which must have been removed from the thread cache, to
+  // the bins.
+  void ReturnCachedChunks(const std::vector<CachedChunk>& chunks)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns every chunk of the thread cache to the bins. Returns true if any
+  // chunk was returned.
+  bool FlushThreadCaches() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  size_t thread_cache_limit_ = 0;
+  std::unique_ptr<ThreadCacheShard[]> thread_cache_shards_;
+  std::unique_ptr<LentChunkShard[]> lent_chunk_shards_;
+
+  // Stats of the allocations served by the thread cache, which GetStats()
+  // merges into stats_. Cached chunks are counted in stats_.bytes_in_use
+  // until they are flushed, so thread_cache_bytes_ is subtracted from it.
+  std::atomic<int64> thread_cache_bytes_{0};
+  std::atomic<int64> thread_cache_num_allocs_{0};
+  std::atomic<int64> thread_cache_peak_bytes_in_use_{0};
+  std::atomic<int64> thread_cache_largest_alloc_size_{0};
+  // Copy of stats_.bytes_in_use that can be read without lock_.
+  std::atomic<int64> bytes_in_use_snapshot_{0};
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -544,8 +637,8 @@ class BFCAllocator : public Allocator {
   ChunkHandle free_chunks_list_ TF_GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ TF_GUARDED_BY(lock_);
+  // newly-created chunk. Atomic, since the thread cache also assigns ids.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
@@ -0,0 +1,212 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/shared_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
+
+namespace tensorflow {
+namespace {
+
+class HostSubAllocator : public SubAllocator {
+ public:
+  HostSubAllocator() : SubAllocator({}, {}) {}
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+BFCAllocator* NewAllocator(size_t total_memory, size_t thread_cache_limit) {
+  BFCAllocator* a = new BFCAllocator(new HostSubAllocator, total_memory,
+                                     false /*allow_growth*/, "test_bfc");
+  a->SetThreadCacheLimit(thread_cache_limit);
+  return a;
+}
+
+TEST(BFCAllocatorThreadCacheTest, ReusesFreedChunks) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 20, 16 << 10));
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  a->DeallocateRaw(p1);
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 900);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(900, a->RequestedSize(p2));
+  EXPECT_EQ(1024, a->AllocatedSize(p2));
+  // Too small for the cached chunk.
+  void* p3 = a->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  a->DeallocateRaw(p2);
+  void* p4 = a->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_NE(p2, p4);
+  a->DeallocateRaw(p3);
+  a->DeallocateRaw(p4);
+}
+
+TEST(BFCAllocatorThreadCacheTest, StatsIgnoreCachedChunks) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 20, 16 << 10));
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  a->DeallocateRaw(p2);
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(1024, stats->bytes_in_use);
+  EXPECT_EQ(3072, stats->peak_bytes_in_use);
+
+  a->ClearStats();
+  p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  stats = a->GetStats();
+  EXPECT_EQ(1, stats->num_allocs);
+  EXPECT_EQ(3072, stats->bytes_in_use);
+  EXPECT_EQ(3072, stats->peak_bytes_in_use);
+  EXPECT_EQ(2048, stats->largest_alloc_size);
+
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(p2);
+  stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+}
+
+TEST(BFCAllocatorThreadCacheTest, EvictsAboveLimit) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 20, 4 << 10));
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 8; ++i) {
+    ptrs.push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 1024));
+  }
+  // The cache goes over its limit on the 5th and the 8th deallocation, and
+  // only keeps the last two chunks.
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+
+  std::vector<void*> reused;
+  for (int i = 0; i < 3; ++i) {
+    reused.push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 1024));
+  }
+  EXPECT_EQ(ptrs[7], reused[0]);
+  EXPECT_EQ(ptrs[6], reused[1]);
+  // The evicted chunks were coalesced in the bins.
+  EXPECT_EQ(ptrs[0], reused[2]);
+  for (void* p : reused) a->DeallocateRaw(p);
+
+  MemoryDump dump = a->RecordMemoryMap();
+  for (const auto& chunk : dump.chunk()) {
+    EXPECT_FALSE(chunk.in_use());
+  }
+}
+
+TEST(BFCAllocatorThreadCacheTest, FlushesWhenOutOfMemory) {
+  const size_t kTotal = 64 << 10;
+  std::unique_ptr<BFCAllocator> a(NewAllocator(kTotal, kTotal));
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 4 << 10);
+    ASSERT_NE(nullptr, p);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  // All the memory is cached in 4KiB chunks.
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, kTotal);
+  ASSERT_NE(nullptr, large);
+  EXPECT_EQ(ptrs[0], large);
+  a->DeallocateRaw(large);
+}
+
+// A chunk freed under a timing counter must not keep its count once it is
+// reused, or it would later be refused to allocations which may use it.
+TEST(BFCAllocatorThreadCacheTest, ReusedChunksForgetTheirFreedAtCount) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 20, 16 << 10));
+  SharedCounter counter;
+  a->SetTimingCounter(&counter);
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  for (int i = 0; i < 4; ++i) counter.next();
+  a->DeallocateRaw(p1);  // Freed at count 5.
+
+  std::function<uint64()> freed_by_5 = []() -> uint64 { return 5; };
+  AllocationAttributes attr(/*retry_on_failure=*/false,
+                            /*allocation_will_be_logged=*/false,
+                            &freed_by_5);
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1024, attr);
+  EXPECT_EQ(p1, p2);
+  a->SetTimingCounter(nullptr);
+  a->DeallocateRaw(p2);
+
+  std::function<uint64()> freed_by_1 = []() -> uint64 { return 1; };
+  attr.freed_by_func = &freed_by_1;
+  void* p3 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1024, attr);
+  EXPECT_EQ(p1, p3);
+  a->DeallocateRaw(p3);
+}
+
+TEST(BFCAllocatorThreadCacheTest, LargeAllocationsBypassTheCache) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 22, 1 << 20));
+  const size_t kLarge = BFCAllocator::kMaxThreadCacheChunkSize + 256;
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, kLarge);
+  a->DeallocateRaw(p1);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+  MemoryDump dump = a->RecordMemoryMap();
+  for (const auto& chunk : dump.chunk()) {
+    EXPECT_FALSE(chunk.in_use());
+  }
+}
+
+TEST(BFCAllocatorThreadCacheTest, ConcurrentAllocations) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 24, 64 << 10));
+  const int kNumThreads = 8;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, t]() {
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 1000; ++i) {
+          size_t bytes = 256 * (1 + (i + t) % 16);
+          void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, bytes);
+          CHECK(p != nullptr);
+          memset(p, t, bytes);
+          ptrs.push_back(p);
+          if (ptrs.size() > 8) {
+            a->DeallocateRaw(ptrs.front());
+            ptrs.erase(ptrs.begin());
+          }
+        }
+        for (void* p : ptrs) a->DeallocateRaw(p);
+      });
+    }
+  }
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(kNumThreads * 1000, stats->num_allocs);
+}
+
+void BM_AllocateDeallocate(int iters, int thread_cache_limit) {
+  std::unique_ptr<BFCAllocator> a(NewAllocator(1 << 24, thread_cache_limit));
+  std::vector<void*> ptrs(16);
+  for (int i = 0; i < iters; ++i) {
+    for (size_t j = 0; j < ptrs.size(); ++j) {
+      ptrs[j] = a->AllocateRaw(Allocator::kAllocatorAlignment, 256 << (j % 4));
+    }
+    for (void* p : ptrs) a->DeallocateRaw(p);
+  }
+}
+BENCHMARK(BM_AllocateDeallocate)->Arg(0)->Arg(64 << 10);
+
+}  // namespace
+}  // namespace tensorflow
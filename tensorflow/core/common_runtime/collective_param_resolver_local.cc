@@ -17,8 +17,10 @@ limitations under the License.
 #include <stddef.h>
 
 #include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -35,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -66,7 +69,12 @@ const char* GetCollectiveName(const CollectiveParams* cp, bool nccl) {
       return "HierarchicalTreeBroadcast";
 
     case REDUCTION_COLLECTIVE:
-      return nccl ? "NcclReduce" : "RingReduce";
+      // Only the ring implementation supports compression.
+      if (cp->encode_op) return "RingReduce";
+      if (nccl) return "NcclReduce";
+      return cp->instance.impl_details.communication_hint == "hierarchical"
+                 ? "HierarchicalRingReduce"
+                 : "RingReduce";
 
     case GATHER_COLLECTIVE:
       return "RingGather";
@@ -298,12 +306,90 @@ bool ParseRingOrder(const string& gpu_ring_order_str, TaskDeviceMap* tdm) {
   return true;
 }
 
+// Rings over at most this many devices of a task are ordered by an
+// exhaustive search, larger ones greedily.
+constexpr int kMaxExhaustiveRingDevices = 8;
+
+// Returns the quality of the link from `from` to the GPU with id `to_id`:
+// its InterconnectLink strength if there is one, otherwise 0 if both devices
+// are attached to the same NUMA node and -1 if the traffic has to cross
+// between NUMA nodes.
+int32 LinkScore(const DevRec& from, const DevRec& to, int to_id) {
+  int32 score = -1;
+  for (const InterconnectLink& il : from.locality->links().link()) {
+    if (il.device_id() == to_id) score = std::max(score, il.strength());
+  }
+  if (score >= 0) return score;
+  return from.locality->numa_node() == to.locality->numa_node() ? 0 : -1;
+}
+
+// Assigns local ranks in the ring order over the GPUs of `tdm` that
+// maximizes first the weakest and then the total link score around the ring,
+// closing link included.  Since subdivisions rotate the order within a task,
+// every subdivision then benefits from the same links.  Ties are broken
+// towards the order closest to the initial rank, so that every task computes
+// the same result.
+bool OrderTaskDevicesExhaustively(TaskDeviceMap* tdm) {
+  const int n = tdm->size();
+  if (n > kMaxExhaustiveRingDevices) return false;
+  std::vector<DevRec*> devs;
+  std::vector<int> ids;
+  for (auto& it : *tdm) devs.push_back(&it.second);
+  std::sort(devs.begin(), devs.end(), [](const DevRec* a, const DevRec* b) {
+    return a->original_rank < b->original_rank;
+  });
+  for (const DevRec* dr : devs) {
+    DeviceNameUtils::ParsedName parsed_name;
+    if (!DeviceNameUtils::ParseFullName(dr->device, &parsed_name) ||
+        parsed_name.type != "GPU") {
+      return false;
+    }
+    ids.push_back(parsed_name.id);
+  }
+  std::vector<std::vector<int32>> scores(n, std::vector<int32>(n, 0));
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      if (i != j) scores[i][j] = LinkScore(*devs[i], *devs[j], ids[j]);
+    }
+  }
+  // The device with the least initial rank stays first; permute the rest.
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i) order[i] = i;
+  std::vector<int> best_order;
+  int32 best_min = 0;
+  int64 best_sum = 0;
+  do {
+    int32 min_score = scores[order[n - 1]][order[0]];
+    int64 sum_score = min_score;
+    for (int i = 0; i + 1 < n; ++i) {
+      const int32 score = scores[order[i]][order[i + 1]];
+      min_score = std::min(min_score, score);
+      sum_score += score;
+    }
+    if (best_order.empty() || min_score > best_min ||
+        (min_score == best_min && sum_score > best_sum)) {
+      best_order = order;
+      best_min = min_score;
+      best_sum = sum_score;
+    }
+  } while (std::next_permutation(order.begin() + 1, order.end()));
+  for (int rank = 0; rank < n; ++rank) {
+    devs[best_order[rank]]->local_rank = rank;
+  }
+  VLOG(2) << "Assigned local ranks by exhaustive search, weakest link "
+          << best_min << " total " << best_sum;
+  return true;
+}
+
 void OrderTaskDeviceMap(const string& gpu_ring_order, TaskDeviceMap* tdm) {
   CHECK_GT(tdm->size(), 0);  // Should never be called with 0 devices
 
   // If a valid ring order has been passed in via ConfigProto, use that.
   if (ParseRingOrder(gpu_ring_order, tdm)) return;
 
+  // Small sets of GPUs can afford the best ring under the localities.
+  if (tdm->size() > 1 && OrderTaskDevicesExhaustively(tdm)) return;
+
   // Either no ring order was passed in, or the format was unexpected.
   // We now assign a ring order based on link strengths.  Note that this
   // algorithm is not optimal and may not always find the best ring order.
@@ -363,14 +449,20 @@ void OrderTaskDeviceMap(const string& gpu_ring_order, TaskDeviceMap* tdm) {
       next_device = DeviceNameUtils::ParsedNameToString(parsed_name);
     } else {
       // No good edges, alas. Pick the lowest initial rank among remaining
-      // devices.
+      // devices, preferring those on the same NUMA node.
       least_rank = -1;
+      bool least_same_numa = false;
       for (const auto& it : *tdm) {
         if (selected.find(it.second.device) != selected.end()) {
           continue;
         }
-        if (least_rank < 0 || it.second.original_rank < least_rank) {
+        const bool same_numa =
+            it.second.locality->numa_node() == dr->locality->numa_node();
+        if (least_rank < 0 || (same_numa && !least_same_numa) ||
+            (same_numa == least_same_numa &&
+             it.second.original_rank < least_rank)) {
           least_rank = it.second.original_rank;
+          least_same_numa = same_numa;
           next_device = it.second.device;
         }
       }
@@ -379,6 +471,59 @@ void OrderTaskDeviceMap(const string& gpu_ring_order, TaskDeviceMap* tdm) {
   }
 }
 
+// Parses TF_COLLECTIVE_TASK_TOPOLOGY, a comma separated list of
+// `<task name>=<domain>` hints that place tasks in topology domains such as
+// racks.  The hints must be the same in every task of the cluster, since each
+// of them computes the ring order independently.
+std::unordered_map<string, string> ParseTaskTopology() {
+  std::unordered_map<string, string> task_domains;
+  string hints;
+  Status s = ReadStringFromEnvVar("TF_COLLECTIVE_TASK_TOPOLOGY", "", &hints);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return task_domains;
+  }
+  for (const string& hint :
+       str_util::Split(hints, ',', str_util::SkipEmpty())) {
+    std::vector<string> parts = str_util::Split(hint, '=');
+    if (parts.size() != 2) {
+      LOG(ERROR) << "Ignoring malformed TF_COLLECTIVE_TASK_TOPOLOGY entry "
+                 << hint;
+      continue;
+    }
+    task_domains[parts[0]] = parts[1];
+  }
+  return task_domains;
+}
+
+// Returns the distinct tasks of `task_names` in order of first appearance,
+// except that the tasks of a topology domain follow each other, so that the
+// ring crosses between domains only once per domain.  Tasks without a hint
+// form a domain of their own.
+std::vector<string> OrderTasksByTopology(
+    const std::vector<string>& task_names) {
+  const std::unordered_map<string, string> task_domains = ParseTaskTopology();
+  std::vector<string> domains;
+  std::unordered_map<string, std::vector<string>> domain_tasks;
+  std::set<string> seen_tasks;
+  for (const string& task_name : task_names) {
+    if (!seen_tasks.insert(task_name).second) continue;
+    auto it = task_domains.find(task_name);
+    // Task names start with '/', which keeps them apart from domain names.
+    const string& domain = it == task_domains.end() ? task_name : it->second;
+    std::vector<string>& tasks = domain_tasks[domain];
+    if (tasks.empty()) domains.push_back(domain);
+    tasks.push_back(task_name);
+  }
+  std::vector<string> ordered_tasks;
+  for (const string& domain : domains) {
+    for (const string& task_name : domain_tasks[domain]) {
+      ordered_tasks.push_back(task_name);
+    }
+  }
+  return ordered_tasks;
+}
+
 // The first time a shared CollectiveParams is established for a
 // shared set of instances we compute a good rank order for all the
 // devices in the group, that is appropriate for a ring algorithm.
@@ -393,15 +538,12 @@ GlobalDeviceMap EstablishGlobalRank(
     TaskDeviceMap& tdm = iter.second;
     OrderTaskDeviceMap(cp->instance.gpu_ring_order, &tdm);
   }
-  // Connect the global rank order by the order in which tasks first appear.
-  std::set<string> ordered_tasks;
+  // Connect the global rank order by the order in which tasks first appear,
+  // keeping the tasks of each topology domain adjacent.
+  std::vector<string> ordered_tasks =
+      OrderTasksByTopology(cp->instance.task_names);
   int next_rank = 0;
-  for (int i = 0; i < cp->instance.task_names.size(); ++i) {
-    const string& task_name = cp->instance.task_names[i];
-    if (ordered_tasks.find(task_name) != ordered_tasks.end()) {
-      continue;
-    }
-    ordered_tasks.insert(task_name);
+  for (const string& task_name : ordered_tasks) {
     TaskDeviceMap* tdm = &gdm[task_name];
     for (auto& it : *tdm) {
       it.second.global_rank = it.second.local_rank + next_rank;
@@ -740,9 +882,12 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
   //
   // After enough testing, we may simplify this logic to use NCCL whenever
   // available.
+  //
+  // An explicit "hierarchical" hint takes precedence over `ConfigProto`.
   CollectiveImplementationInterface* col_impl;
+  const string& hint = cp->instance.impl_details.communication_hint;
   bool use_nccl =
-      (nccl_ || cp->instance.impl_details.communication_hint == "nccl") &&
+      ((nccl_ && hint != "hierarchical") || hint == "nccl") &&
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
@@ -14,7 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 
+#include <stdlib.h>
+
 #include <atomic>
+#include <map>
 
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/device.h"
@@ -175,6 +178,110 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRanking) {
                             });
 }
 
+TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRankingClosesRing) {
+  constexpr int kNumGpus = 4;
+  CollectiveParams cp;
+  std::vector<DeviceAttributes> attributes(kNumGpus);
+  cp.name = "PRLTest";
+  cp.group.device_type = DeviceType("GPU");
+  cp.group.num_tasks = 1;
+  cp.group.group_size = kNumGpus;
+  cp.instance.instance_key = 5;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DataType(DT_FLOAT);
+  // Links 0-1, 1-3, 3-2 and 2-0 form a ring of strength 2.  The stronger
+  // link 0-3 would lead a greedy walk into a ring that has no link between
+  // 1 and 2.
+  std::map<std::pair<int, int>, int> links = {
+      {{0, 1}, 2}, {{1, 3}, 2}, {{2, 3}, 2}, {{0, 2}, 2}, {{0, 3}, 3}};
+  for (int gpu_idx = 0; gpu_idx < kNumGpus; ++gpu_idx) {
+    cp.instance.task_names.push_back("/job:localhost/replica:0/task:0");
+    cp.instance.device_names.push_back(strings::StrCat(
+        "/job:localhost/replica:0/task:0/device:GPU:", gpu_idx));
+    DeviceLocality locality;
+    for (int link_idx = 0; link_idx < kNumGpus; ++link_idx) {
+      auto it = links.find(
+          {std::min(gpu_idx, link_idx), std::max(gpu_idx, link_idx)});
+      if (it == links.end()) continue;
+      InterconnectLink* ilink = locality.mutable_links()->add_link();
+      ilink->set_device_id(link_idx);
+      ilink->set_strength(it->second);
+    }
+    *attributes[gpu_idx].mutable_locality() = locality;
+  }
+  RunCompleteDefaultRanking(cp, attributes, {},
+                            {
+                                "/job:localhost/replica:0/task:0/device:GPU:0",
+                                "/job:localhost/replica:0/task:0/device:GPU:1",
+                                "/job:localhost/replica:0/task:0/device:GPU:3",
+                                "/job:localhost/replica:0/task:0/device:GPU:2",
+                            });
+}
+
+TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRankingNumaNodes) {
+  constexpr int kNumGpus = 4;
+  CollectiveParams cp;
+  std::vector<DeviceAttributes> attributes(kNumGpus);
+  cp.name = "PRLTest";
+  cp.group.device_type = DeviceType("GPU");
+  cp.group.num_tasks = 1;
+  cp.group.group_size = kNumGpus;
+  cp.instance.instance_key = 5;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DataType(DT_FLOAT);
+  // Without any links, the ring should cross between the NUMA nodes of
+  // GPUs 0,2 and 1,3 only twice.
+  for (int gpu_idx = 0; gpu_idx < kNumGpus; ++gpu_idx) {
+    cp.instance.task_names.push_back("/job:localhost/replica:0/task:0");
+    cp.instance.device_names.push_back(strings::StrCat(
+        "/job:localhost/replica:0/task:0/device:GPU:", gpu_idx));
+    attributes[gpu_idx].mutable_locality()->set_numa_node(gpu_idx % 2);
+  }
+  RunCompleteDefaultRanking(cp, attributes, {},
+                            {
+                                "/job:localhost/replica:0/task:0/device:GPU:0",
+                                "/job:localhost/replica:0/task:0/device:GPU:1",
+                                "/job:localhost/replica:0/task:0/device:GPU:3",
+                                "/job:localhost/replica:0/task:0/device:GPU:2",
+                            });
+}
+
+TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRankingTaskTopology) {
+  constexpr int kNumTasks = 4;
+  CollectiveParams cp;
+  std::vector<DeviceAttributes> attributes(kNumTasks);
+  cp.name = "PRLTest";
+  cp.group.device_type = DeviceType("CPU");
+  cp.group.num_tasks = kNumTasks;
+  cp.group.group_size = kNumTasks;
+  cp.instance.instance_key = 5;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DataType(DT_FLOAT);
+  for (int task_idx = 0; task_idx < kNumTasks; ++task_idx) {
+    const string task_name =
+        strings::StrCat("/job:worker/replica:0/task:", task_idx);
+    cp.instance.task_names.push_back(task_name);
+    cp.instance.device_names.push_back(
+        strings::StrCat(task_name, "/device:CPU:0"));
+  }
+  // Tasks 0 and 2 share a rack, 1 and 3 another one.
+  setenv("TF_COLLECTIVE_TASK_TOPOLOGY",
+         "/job:worker/replica:0/task:0=rack0,"
+         "/job:worker/replica:0/task:1=rack1,"
+         "/job:worker/replica:0/task:2=rack0,"
+         "/job:worker/replica:0/task:3=rack1",
+         1);
+  RunCompleteDefaultRanking(cp, attributes, {},
+                            {
+                                "/job:worker/replica:0/task:0/device:CPU:0",
+                                "/job:worker/replica:0/task:2/device:CPU:0",
+                                "/job:worker/replica:0/task:1/device:CPU:0",
+                                "/job:worker/replica:0/task:3/device:CPU:0",
+                            });
+  unsetenv("TF_COLLECTIVE_TASK_TOPOLOGY");
+  RunCompleteDefaultRanking(cp, attributes, {}, cp.instance.device_names);
+}
+
 TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
   CollectiveParams cps[NUM_DEVS];
   Status statuses[NUM_DEVS];
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/collective_util.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace collective_util {
@@ -108,5 +110,114 @@ Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
   return sub_ctx->sub_ctx_->status();
 }
 
+namespace {
+// A peer is reported as a straggler once its mean wait over at least
+// kStragglerMinSamples receives exceeds kStragglerFactor times the median.
+constexpr double kStragglerFactor = 2.0;
+constexpr int64 kStragglerMinSamples = 100;
+}  // namespace
+
+/*static*/
+PeerWaitStats* PeerWaitStats::Global() {
+  static PeerWaitStats* global = [] {
+    int64 report_interval_secs;
+    Status s = ReadInt64FromEnvVar("TF_COLLECTIVE_STRAGGLER_REPORT_SECS", 0,
+                                   &report_interval_secs);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      report_interval_secs = 0;
+    }
+    return new PeerWaitStats(report_interval_secs);
+  }();
+  return global;
+}
+
+void PeerWaitStats::RecordRecv(int32 group_key, const string& peer_device,
+                               uint64 wait_usecs) {
+  mutex_lock l(mu_);
+  PeerStats& stats = groups_[group_key][peer_device];
+  ++stats.count;
+  stats.total_wait_usecs += wait_usecs;
+}
+
+std::vector<string> PeerWaitStats::StragglersLocked(const PeerMap& peers,
+                                                    double factor,
+                                                    int64 min_samples) const {
+  std::vector<string> stragglers;
+  if (peers.size() < 2) return stragglers;
+  std::vector<double> means;
+  means.reserve(peers.size());
+  for (const auto& it : peers) {
+    means.push_back(static_cast<double>(it.second.total_wait_usecs) /
+                    it.second.count);
+  }
+  // Use the lower median so that with two peers the faster one is the
+  // reference.
+  auto median_it = means.begin() + (means.size() - 1) / 2;
+  std::nth_element(means.begin(), median_it, means.end());
+  const double median = *median_it;
+  for (const auto& it : peers) {
+    const double mean =
+        static_cast<double>(it.second.total_wait_usecs) / it.second.count;
+    if (it.second.count >= min_samples && mean > factor * median) {
+      stragglers.push_back(it.first);
+    }
+  }
+  return stragglers;
+}
+
+std::vector<string> PeerWaitStats::Stragglers(int32 group_key, double factor,
+                                              int64 min_samples) const {
+  mutex_lock l(mu_);
+  auto it = groups_.find(group_key);
+  if (it == groups_.end()) return {};
+  return StragglersLocked(it->second, factor, min_samples);
+}
+
+string PeerWaitStats::Report(double factor, int64 min_samples) const {
+  mutex_lock l(mu_);
+  string buf;
+  for (const auto& group : groups_) {
+    std::vector<string> stragglers =
+        StragglersLocked(group.second, factor, min_samples);
+    strings::StrAppend(&buf, "Group ", group.first, " mean recv wait:\n");
+    for (const auto& peer : group.second) {
+      strings::StrAppend(
+          &buf, "  ", peer.first, " ",
+          peer.second.total_wait_usecs / peer.second.count, "us over ",
+          peer.second.count, " recvs");
+      if (std::find(stragglers.begin(), stragglers.end(), peer.first) !=
+          stragglers.end()) {
+        strings::StrAppend(&buf, " STRAGGLER");
+      }
+      strings::StrAppend(&buf, "\n");
+    }
+  }
+  return buf;
+}
+
+void PeerWaitStats::MaybeLogReport(uint64 now_micros) {
+  if (report_interval_micros_ == 0) return;
+  {
+    mutex_lock l(mu_);
+    if (now_micros - last_report_micros_ < report_interval_micros_) return;
+    last_report_micros_ = now_micros;
+    bool has_stragglers = false;
+    for (const auto& group : groups_) {
+      if (!StragglersLocked(group.second, kStragglerFactor,
+                            kStragglerMinSamples)
+               .empty()) {
+        has_stragglers = true;
+        break;
+      }
+    }
+    if (!has_stragglers) return;
+  }
+  LOG(WARNING) << "Collective peers are consistently slow to provide data; "
+               << "this process waited on them more than " << kStragglerFactor
+               << "x the median of their group.\n"
+               << Report(kStragglerFactor, kStragglerMinSamples);
+}
+
 }  // namespace collective_util
 }  // namespace tensorflow
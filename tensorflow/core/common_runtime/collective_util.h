@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_UTIL_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_UTIL_H_
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -23,6 +25,8 @@ limitations under the License.
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace collective_util {
@@ -53,6 +57,54 @@ Status ComputeBinOp(OpKernelContext* op_ctx, OpKernelContext::Params* params,
                     Device* device, OpKernel* op, Tensor* output,
                     Tensor* input);
 
+// Accumulates, per collective group, the time this process waited on
+// RecvFromPeer for data from each peer device.  Every device of a ring waits
+// on its predecessor, so a peer whose mean wait stays well above that of the
+// other peers of the group is likely a straggler.
+class PeerWaitStats {
+ public:
+  // Returns the process-wide instance, which logs a straggler report at most
+  // every TF_COLLECTIVE_STRAGGLER_REPORT_SECS seconds.  The report is disabled
+  // when the variable is unset or 0.
+  static PeerWaitStats* Global();
+
+  explicit PeerWaitStats(int64 report_interval_secs)
+      : report_interval_micros_(report_interval_secs * 1000000) {}
+
+  void RecordRecv(int32 group_key, const string& peer_device,
+                  uint64 wait_usecs);
+
+  // Returns the peers of `group_key` with at least `min_samples` recorded
+  // waits whose mean wait exceeds `factor` times the median over all peers
+  // of the group.  A group with a single peer has no stragglers.
+  std::vector<string> Stragglers(int32 group_key, double factor,
+                                 int64 min_samples) const;
+
+  // Returns a summary of the mean wait per peer of every group, with the
+  // stragglers marked.
+  string Report(double factor, int64 min_samples) const;
+
+  // Logs the report if any group has a straggler and the report interval
+  // has elapsed since the last one.
+  void MaybeLogReport(uint64 now_micros);
+
+ private:
+  struct PeerStats {
+    int64 count = 0;
+    uint64 total_wait_usecs = 0;
+  };
+  typedef std::map<string, PeerStats> PeerMap;
+
+  std::vector<string> StragglersLocked(const PeerMap& peers, double factor,
+                                       int64 min_samples) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const uint64 report_interval_micros_;
+  mutable mutex mu_;
+  std::map<int32, PeerMap> groups_ TF_GUARDED_BY(mu_);
+  uint64 last_report_micros_ TF_GUARDED_BY(mu_) = 0;
+};
+
 }  // namespace collective_util
 }  // namespace tensorflow
 
@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_util.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace collective_util {
+namespace {
+
+TEST(PeerWaitStatsTest, NoStragglersWithSinglePeer) {
+  PeerWaitStats stats(0);
+  for (int i = 0; i < 10; ++i) {
+    stats.RecordRecv(1, "/job:worker/task:0/device:CPU:0", 1000);
+  }
+  EXPECT_TRUE(stats.Stragglers(1, 2.0, 1).empty());
+  EXPECT_TRUE(stats.Stragglers(2, 2.0, 1).empty());
+}
+
+TEST(PeerWaitStatsTest, ReportsConsistentlySlowPeer) {
+  PeerWaitStats stats(0);
+  for (int i = 0; i < 10; ++i) {
+    stats.RecordRecv(1, "/job:worker/task:0/device:CPU:0", 100);
+    stats.RecordRecv(1, "/job:worker/task:1/device:CPU:0", 110);
+    stats.RecordRecv(1, "/job:worker/task:2/device:CPU:0", 1000);
+    // A different group does not affect the median of group 1.
+    stats.RecordRecv(2, "/job:worker/task:3/device:CPU:0", 5000);
+  }
+  EXPECT_EQ(stats.Stragglers(1, 2.0, 10),
+            std::vector<string>({"/job:worker/task:2/device:CPU:0"}));
+  EXPECT_TRUE(stats.Stragglers(2, 2.0, 10).empty());
+  // Too few samples to call the peer consistently slow.
+  EXPECT_TRUE(stats.Stragglers(1, 2.0, 11).empty());
+
+  const string report = stats.Report(2.0, 10);
+  EXPECT_NE(report.find("/job:worker/task:2/device:CPU:0 1000us over 10 recvs "
+                        "STRAGGLER"),
+            string::npos);
+  EXPECT_NE(
+      report.find("/job:worker/task:0/device:CPU:0 100us over 10 recvs\n"),
+      string::npos);
+}
+
+TEST(PeerWaitStatsTest, SlowerOfTwoPeers) {
+  PeerWaitStats stats(0);
+  for (int i = 0; i < 5; ++i) {
+    stats.RecordRecv(1, "/job:worker/task:0/device:CPU:0", 100);
+    stats.RecordRecv(1, "/job:worker/task:1/device:CPU:0", 300);
+  }
+  EXPECT_EQ(stats.Stragglers(1, 2.0, 5),
+            std::vector<string>({"/job:worker/task:1/device:CPU:0"}));
+  EXPECT_TRUE(stats.Stragglers(1, 4.0, 5).empty());
+}
+
+}  // namespace
+}  // namespace collective_util
+}  // namespace tensorflow
@@ -21,6 +21,8 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/common_runtime/constant_folding.h"
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
@@ -46,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/framework/logging.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/run_handler.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
@@ -100,8 +104,9 @@ Status NewThreadPoolFromThreadPoolOptions(
     VLOG(1) << "Direct session inter op parallelism threads for pool "
             << pool_number << ": " << num_threads;
     *pool = new thread::ThreadPool(
-        options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
-        num_threads, !options.config.experimental().disable_thread_spinning(),
+        options.env, InterOpThreadOptions(options),
+        strings::StrCat("Compute", pool_number), num_threads,
+        !options.config.experimental().disable_thread_spinning(),
         /*allocator=*/nullptr);
     *owned = true;
     return Status::OK();
@@ -117,8 +122,9 @@ Status NewThreadPoolFromThreadPoolOptions(
   if (mvalue->second == nullptr) {
     mvalue->first = thread_pool_options.num_threads();
     mvalue->second = new thread::ThreadPool(
-        options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
-        num_threads, !options.config.experimental().disable_thread_spinning(),
+        options.env, InterOpThreadOptions(options),
+        strings::StrCat("Compute", pool_number), num_threads,
+        !options.config.experimental().disable_thread_spinning(),
         /*allocator=*/nullptr);
   } else {
     if (mvalue->first != thread_pool_options.num_threads()) {
@@ -134,6 +140,50 @@ Status NewThreadPoolFromThreadPoolOptions(
   return Status::OK();
 }
 
+// Records the serving metrics of a step of a session serving `model_name`.
+// `queue_time_usecs` is unset if the step did not wait for a run handler. The
+// device times are only known if the step collected GPU step stats.
+void RecordServingStepTimes(const string& model_name,
+                            const RunOptions& run_options,
+                            const absl::optional<uint64> queue_time_usecs,
+                            const uint64 run_time_usecs,
+                            const StepStats& step_stats) {
+  const string& signature_name = run_options.experimental().signature_name();
+  if (queue_time_usecs.has_value()) {
+    metrics::RecordServingStepTime(model_name, signature_name,
+                                   metrics::ServingPhase::kQueue,
+                                   *queue_time_usecs);
+  }
+  metrics::RecordServingStepTime(model_name, signature_name,
+                                 metrics::ServingPhase::kGraphExecution,
+                                 run_time_usecs);
+  uint64 compute_usecs = 0;
+  uint64 copy_usecs = 0;
+  for (const DeviceStepStats& dev_stats : step_stats.dev_stats()) {
+    uint64* usecs = nullptr;
+    if (absl::EndsWith(dev_stats.device(), "/stream:all")) {
+      usecs = &compute_usecs;
+    } else if (absl::EndsWith(dev_stats.device(), "/memcpy")) {
+      usecs = &copy_usecs;
+    } else {
+      continue;
+    }
+    for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+      *usecs += node_stats.all_end_rel_micros();
+    }
+  }
+  if (compute_usecs > 0) {
+    metrics::RecordServingStepTime(model_name, signature_name,
+                                   metrics::ServingPhase::kDeviceCompute,
+                                   compute_usecs);
+  }
+  if (copy_usecs > 0) {
+    metrics::RecordServingStepTime(model_name, signature_name,
+                                   metrics::ServingPhase::kHostDeviceCopy,
+                                   copy_usecs);
+  }
+}
+
 thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
   static thread::ThreadPool* const thread_pool =
       NewThreadPoolFromSessionOptions(options);
@@ -376,6 +426,28 @@ DirectSession::DirectSession(const SessionOptions& options,
 
 DirectSession::~DirectSession() {
   if (!closed_) Close().IgnoreError();
+  std::unique_ptr<thread::ThreadPool> async_step_pool;
+  std::unique_ptr<thread::ThreadPool> async_callback_pool;
+  {
+    // Wait for the RunCallableAsync() steps, which fail fast once the session
+    // is closed.
+    mutex_lock l(async_steps_mu_);
+    while (!pending_async_steps_.empty() || num_inflight_async_steps_ > 0) {
+      async_steps_cv_.wait(l);
+    }
+    async_step_pool = std::move(async_step_pool_);
+    async_callback_pool = std::move(async_callback_pool_);
+  }
+  async_step_pool.reset();
+  if (async_callback_pool != nullptr &&
+      async_callback_pool->CurrentThreadId() != -1) {
+    // The session is deleted by a `done` callback, so join the callback pool
+    // from another thread once the callback has returned.
+    thread::ThreadPool* pool = async_callback_pool.release();
+    options_.env->SchedClosure([pool]() { delete pool; });
+  }
+  // Joins the threads that are still calling the `done` callbacks.
+  async_callback_pool.reset();
   for (auto& it : partial_runs_) {
     it.second.reset(nullptr);
   }
@@ -504,15 +576,28 @@ Status DirectSession::RunInternal(
   profiler::TraceMeProducer activity(
       // To TraceMeConsumers in ExecutorState::Process/Finish.
       [&] {
+        const int64 request_id = run_options.experimental().request_id();
         if (options_.config.experimental().has_session_metadata()) {
           const auto& model_metadata =
               options_.config.experimental().session_metadata();
           string model_id = strings::StrCat(model_metadata.name(), ":",
                                             model_metadata.version());
+          if (request_id != 0) {
+            return profiler::TraceMeEncode("SessionRun",
+                                           {{"id", step_id},
+                                            {"_r", 1} /*root_event*/,
+                                            {"model_id", model_id},
+                                            {"request_id", request_id}});
+          }
           return profiler::TraceMeEncode("SessionRun",
                                          {{"id", step_id},
                                           {"_r", 1} /*root_event*/,
                                           {"model_id", model_id}});
+        } else if (request_id != 0) {
+          return profiler::TraceMeEncode("SessionRun",
+                                         {{"id", step_id},
+                                          {"_r", 1} /*root_event*/,
+                                          {"request_id", request_id}});
         } else {
           return profiler::TraceMeEncode(
               "SessionRun", {{"id", step_id}, {"_r", 1} /*root_event*/});
@@ -597,12 +682,15 @@ Status DirectSession::RunInternal(
                                  : operation_timeout_in_ms_;
 
   std::unique_ptr<RunHandler> handler;
+  absl::optional<uint64> queue_time_usecs;
   if (ShouldUseRunHandlerPool(run_options) &&
       run_options.experimental().use_run_handler_pool()) {
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
+    const uint64 queue_start_usecs = options_.env->NowMicros();
     handler = GetOrCreateRunHandlerPool(options_)->Get(
         step_id, call_timeout,
         run_options.experimental().run_handler_pool_options());
+    queue_time_usecs = options_.env->NowMicros() - queue_start_usecs;
     if (!handler) {
       return errors::DeadlineExceeded(
           "Could not obtain RunHandler for request after waiting for ",
@@ -649,6 +737,7 @@ Status DirectSession::RunInternal(
   args.sync_on_finish = sync_on_finish_;
   args.user_intra_op_threadpool = threadpool_options.intra_op_threadpool;
   args.run_all_kernels_inline = pool == nullptr;
+  args.use_step_arena = run_options.experimental().use_step_arena();
 
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
 
@@ -718,6 +807,7 @@ Status DirectSession::RunInternal(
 
     const auto& item = executors_and_keys->items[0];
     set_threadpool_args_for_item(item, &args);
+    args.memory_planner = item.memory_planner.get();
     run_status = item.executor->Run(args);
   } else {
     core::RefCountPtr<RefCountedIntraProcessRendezvous> rendezvous(
@@ -738,6 +828,7 @@ Status DirectSession::RunInternal(
 
     for (const auto& item : executors_and_keys->items) {
       set_threadpool_args_for_item(item, &args);
+      args.memory_planner = item.memory_planner.get();
       item.executor->RunAsync(args, barrier->Get());
     }
 
@@ -809,7 +900,22 @@ Status DirectSession::RunInternal(
       }
     }
   }
-  metrics::UpdateGraphExecTime(options_.env->NowMicros() - start_time_usecs);
+  const uint64 run_time_usecs = options_.env->NowMicros() - start_time_usecs;
+  metrics::UpdateGraphExecTime(run_time_usecs);
+  for (const auto& pool_and_owned : thread_pools_) {
+    metrics::UpdateThreadPoolUtilization(*pool_and_owned.first);
+  }
+  for (const Device* device : devices_) {
+    if (device->device_type() == DEVICE_CPU) {
+      metrics::UpdateThreadPoolUtilization(
+          *device->tensorflow_cpu_worker_threads()->workers);
+    }
+  }
+  if (options_.config.experimental().has_session_metadata()) {
+    RecordServingStepTimes(
+        options_.config.experimental().session_metadata().name(), run_options,
+        queue_time_usecs, run_time_usecs, run_metadata->step_stats());
+  }
 
   return Status::OK();
 }
@@ -881,6 +987,17 @@ Status DirectSession::Run(const RunOptions& run_options,
   } else if (!s.ok()) {
     return s;
   }
+  if (run_options.experimental().fetch_into_output_buffers() && outputs &&
+      outputs->size() == output_names.size()) {
+    std::vector<Tensor> retval_buffers(executors_and_keys->output_types.size());
+    for (int i = output_names.size() - 1; i >= 0; --i) {
+      // A name fetched twice gets the buffer of its first position.
+      const size_t index =
+          executors_and_keys->output_name_to_index[output_names[i]];
+      retval_buffers[index] = (*outputs)[i];
+    }
+    call_frame.SetRetvalBuffers(std::move(retval_buffers));
+  }
 
   const int64 step_id = step_id_counter_.fetch_add(1);
 
@@ -1417,6 +1534,18 @@ Status DirectSession::CreateExecutors(
     auto executor_type = options_.config.experimental().executor_type();
     TF_RETURN_IF_ERROR(
         NewExecutor(executor_type, params, *partition_graph, &item->executor));
+    if (options.callable_options.use_static_memory_plan() &&
+        device->device_type() == DEVICE_CPU) {
+      item->memory_planner.reset(
+          new StaticMemoryPlanner(partition_graph->num_node_ids()));
+    }
+    for (const Node* n : partition_graph->op_nodes()) {
+      if (n->op_def().is_stateful() && !n->IsArg() && !n->IsRetval() &&
+          !n->IsSend() && !n->IsRecv()) {
+        ek->has_stateful_ops = true;
+        break;
+      }
+    }
     if (!options_.config.experimental().disable_output_partition_graphs() ||
         options_.config.graph_options().build_cost_model() > 0) {
       item->graph = std::move(partition_graph);
@@ -2002,6 +2131,63 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   return Status::OK();
 }
 
+void DirectSession::RunCallableAsync(CallableHandle handle,
+                                     std::vector<Tensor> feed_tensors,
+                                     std::vector<Tensor>* fetch_tensors,
+                                     RunMetadata* run_metadata,
+                                     StatusCallback done) {
+  Status s = CheckNotClosed();
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  bool exclusive = false;
+  {
+    mutex_lock l(callables_lock_);
+    auto it = callables_.find(handle);
+    if (it != callables_.end()) {
+      exclusive = it->second.executors_and_keys->has_stateful_ops;
+    }
+  }
+  auto step = [this, handle, feed_tensors = std::move(feed_tensors),
+               fetch_tensors, run_metadata, done = std::move(done)]() {
+    Status s = RunCallable(handle, feed_tensors, fetch_tensors, run_metadata);
+    mutex_lock l(async_steps_mu_);
+    // `done` runs on its own pool, so that it may delete the session while
+    // the destructor waits for the steps that are still in flight.
+    async_callback_pool_->Schedule([done, s]() { done(s); });
+    --num_inflight_async_steps_;
+    exclusive_async_step_inflight_ = false;
+    StartAsyncStepsLocked();
+  };
+  mutex_lock l(async_steps_mu_);
+  pending_async_steps_.push_back({std::move(step), exclusive});
+  StartAsyncStepsLocked();
+}
+
+void DirectSession::StartAsyncStepsLocked() {
+  int max_inflight_steps =
+      options_.config.experimental().max_inflight_async_steps();
+  if (max_inflight_steps <= 0) max_inflight_steps = 2;
+  if (!pending_async_steps_.empty() && async_step_pool_ == nullptr) {
+    async_step_pool_.reset(new thread::ThreadPool(
+        options_.env, "direct_session_async_steps", max_inflight_steps));
+    async_callback_pool_.reset(new thread::ThreadPool(
+        options_.env, "direct_session_async_callbacks", max_inflight_steps));
+  }
+  while (!pending_async_steps_.empty() &&
+         num_inflight_async_steps_ < max_inflight_steps &&
+         !exclusive_async_step_inflight_) {
+    AsyncStep& step = pending_async_steps_.front();
+    if (step.exclusive && num_inflight_async_steps_ > 0) break;
+    ++num_inflight_async_steps_;
+    exclusive_async_step_inflight_ = step.exclusive;
+    async_step_pool_->Schedule(std::move(step.fn));
+    pending_async_steps_.pop_front();
+  }
+  async_steps_cv_.notify_all();
+}
+
 ::tensorflow::Status DirectSession::ReleaseCallable(CallableHandle handle) {
   mutex_lock l(callables_lock_);
   if (handle >= next_callable_handle_) {
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_DIRECT_SESSION_H_
 
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -41,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session.h"
@@ -131,6 +135,25 @@ class DirectSession : public Session {
       std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
       const thread::ThreadPoolOptions& threadpool_options) override;
 
+  // EXPERIMENTAL: Starts running the callable `handle` and returns
+  // immediately; `done` is called with the status of the step once
+  // `fetch_tensors` and `run_metadata` are filled in. Both must stay valid
+  // until then.
+  //
+  // Up to `ConfigProto.Experimental.max_inflight_async_steps` steps run
+  // concurrently, so that a step can start while the previous one is still
+  // draining; further steps are started in the order in which they were
+  // submitted. A step of a callable with stateful ops runs alone, after the
+  // steps submitted before it and before the ones submitted after it, so its
+  // effects on variables and other resources are ordered as if the steps
+  // were run one at a time.
+  //
+  // `done` may delete the session.
+  void RunCallableAsync(CallableHandle handle,
+                        std::vector<Tensor> feed_tensors,
+                        std::vector<Tensor>* fetch_tensors,
+                        RunMetadata* run_metadata, StatusCallback done);
+
   ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
 
   ::tensorflow::Status Finalize() override;
@@ -148,6 +171,9 @@ class DirectSession : public Session {
     Device* device = nullptr;                // not owned.
     FunctionLibraryRuntime* flib = nullptr;  // not owned.
     std::unique_ptr<Executor> executor;
+    // Non-null iff the callable uses a static memory plan on this CPU
+    // partition.
+    std::unique_ptr<StaticMemoryPlanner> memory_planner;
   };
 
   // An ExecutorsAndKeys is created for a given set of feeds/fetches.
@@ -175,6 +201,10 @@ class DirectSession : public Session {
 
     CallableOptions callable_options;
 
+    // True if a partition has a stateful op other than the ones that pass
+    // arguments, return values and tensors between partitions.
+    bool has_stateful_ops = false;
+
     int64 collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
   };
 
@@ -408,6 +438,28 @@ class DirectSession : public Session {
   mutex closed_lock_;
   bool closed_ TF_GUARDED_BY(closed_lock_) = false;
 
+  // Starts queued RunCallableAsync() steps while fewer than the maximum
+  // number of steps are in flight.
+  void StartAsyncStepsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(async_steps_mu_);
+
+  // State of the steps started with RunCallableAsync(). The steps run on
+  // `async_step_pool_` and their callbacks on `async_callback_pool_`, which
+  // are created by the first such step. An exclusive step runs while no other
+  // step is in flight.
+  struct AsyncStep {
+    std::function<void()> fn;
+    bool exclusive;
+  };
+  mutex async_steps_mu_;
+  condition_variable async_steps_cv_;
+  std::deque<AsyncStep> pending_async_steps_ TF_GUARDED_BY(async_steps_mu_);
+  int num_inflight_async_steps_ TF_GUARDED_BY(async_steps_mu_) = 0;
+  bool exclusive_async_step_inflight_ TF_GUARDED_BY(async_steps_mu_) = false;
+  std::unique_ptr<thread::ThreadPool> async_step_pool_
+      TF_GUARDED_BY(async_steps_mu_);
+  std::unique_ptr<thread::ThreadPool> async_callback_pool_
+      TF_GUARDED_BY(async_steps_mu_);
+
   // For generating unique names for this session instance.
   std::atomic<int64> edge_name_counter_ = {0};
   std::atomic<int64> handle_name_counter_ = {0};
@@ -39,10 +39,13 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/stacktrace.h"
@@ -89,6 +92,30 @@ std::unique_ptr<Session> CreateSession() {
   return std::unique_ptr<Session>(NewSession(DefaultSessionOptions()));
 }
 
+// Returns the number of samples recorded in the cell of the
+// /tensorflow/serving/step_time_usecs metric with the given labels.
+int64 NumServingStepTimeSamples(const string& model_name,
+                                const string& signature_name,
+                                const string& phase) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  auto it = metrics->point_set_map.find("/tensorflow/serving/step_time_usecs");
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const std::unique_ptr<monitoring::Point>& point : it->second->points) {
+    std::map<string, string> labels;
+    for (const monitoring::Point::Label& label : point->labels) {
+      labels[label.name] = label.value;
+    }
+    if (labels["model_name"] == model_name &&
+        labels["signature_name"] == signature_name &&
+        labels["phase"] == phase) {
+      return point->histogram_value.num();
+    }
+  }
+  return 0;
+}
+
 class DirectSessionMinusAXTest : public ::testing::Test {
  public:
   void Initialize(std::initializer_list<float> a_values) {
@@ -152,6 +179,28 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_FetchIntoOutputBuffers) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_fetch_into_output_buffers(true);
+  Tensor buffer(DT_FLOAT, TensorShape({2, 1}));
+  std::vector<Tensor> outputs = {buffer};
+  TF_ASSERT_OK(session->Run(run_options, {}, {y_ + ":0"}, {}, &outputs,
+                            /*run_metadata=*/nullptr));
+
+  ASSERT_EQ(1, outputs.size());
+  // The MatMul producing y writes its output into the provided buffer.
+  EXPECT_EQ(buffer.tensor_data().data(), outputs[0].tensor_data().data());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({5, -1}, {2, 1}),
+                                 outputs[0]);
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({5, -1}, {2, 1}),
+                                 buffer);
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -800,6 +849,160 @@ TEST_F(DirectSessionMinusAXTest, UseRunHandlerPool) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RecordsServingStepTimes) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->mutable_session_metadata()->set_name(
+      "serving_step_time_model");
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_use_run_handler_pool(true);
+  run_options.mutable_experimental()->set_signature_name("serving_default");
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run(run_options, {}, {y_ + ":0"}, {y_neg_}, &outputs,
+                            nullptr));
+  TF_ASSERT_OK(session->Run(run_options, {}, {y_ + ":0"}, {y_neg_}, &outputs,
+                            nullptr));
+
+  EXPECT_EQ(2, NumServingStepTimeSamples("serving_step_time_model",
+                                         "serving_default", "queue"));
+  EXPECT_EQ(2, NumServingStepTimeSamples("serving_step_time_model",
+                                         "serving_default", "graph_execution"));
+  // Without GPU step stats, the device phases are not recorded.
+  EXPECT_EQ(0, NumServingStepTimeSamples("serving_step_time_model",
+                                         "serving_default", "device_compute"));
+}
+
+TEST_F(DirectSessionMinusAXTest, UseStepArena) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_use_step_arena(true);
+
+  // The fetched tensors outlive the steps that allocated them.
+  std::vector<std::vector<Tensor>> all_outputs(10);
+  for (auto& outputs : all_outputs) {
+    TF_ASSERT_OK(session->Run(run_options, inputs, output_names, target_nodes,
+                              &outputs, nullptr));
+  }
+  for (const auto& outputs : all_outputs) {
+    ASSERT_EQ(1, outputs.size());
+    ASSERT_TRUE(outputs[0].IsInitialized());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, UseStaticMemoryPlan) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options =
+      MakeCallableOptions({}, {y_ + ":0"}, {y_neg_});
+  callable_options.set_use_static_memory_plan(true);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  // The first run records the plan, and the following ones use it. The
+  // fetched tensors outlive the steps that allocated them.
+  std::vector<std::vector<Tensor>> all_outputs(10);
+  for (auto& outputs : all_outputs) {
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+  }
+  for (const auto& outputs : all_outputs) {
+    ASSERT_EQ(1, outputs.size());
+    ASSERT_TRUE(outputs[0].IsInitialized());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  }
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunCallableAsync) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->set_max_inflight_async_steps(3);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(
+      MakeCallableOptions({x_ + ":0"}, {y_ + ":0"}, {}), &handle));
+
+  // y = A * [i, 1], so y[0] = 3 * i + 2.
+  const int kNumSteps = 10;
+  std::vector<std::vector<Tensor>> all_outputs(kNumSteps);
+  std::vector<Status> statuses(kNumSteps);
+  BlockingCounter counter(kNumSteps);
+  for (int i = 0; i < kNumSteps; ++i) {
+    direct_session->RunCallableAsync(
+        handle, {test::AsTensor<float>({1.0f * i, 1}, {2, 1})},
+        &all_outputs[i], nullptr, [&statuses, &counter, i](const Status& s) {
+          statuses[i] = s;
+          counter.DecrementCount();
+        });
+  }
+  counter.Wait();
+  for (int i = 0; i < kNumSteps; ++i) {
+    TF_ASSERT_OK(statuses[i]);
+    ASSERT_EQ(1, all_outputs[i].size());
+    EXPECT_FLOAT_EQ(3.0 * i + 2, all_outputs[i][0].matrix<float>()(0, 0));
+  }
+
+  Notification done;
+  Status s;
+  direct_session->RunCallableAsync(handle + 1, {}, nullptr, nullptr,
+                                   [&done, &s](const Status& status) {
+                                     s = status;
+                                     done.Notify();
+                                   });
+  done.WaitForNotification();
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST_F(DirectSessionMinusAXTest, DeleteSessionFromRunCallableAsyncCallback) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->set_max_inflight_async_steps(1);
+  DirectSession* session = static_cast<DirectSession*>(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(
+      MakeCallableOptions({x_ + ":0"}, {y_ + ":0"}, {}), &handle));
+
+  // The first callback deletes the session while the other steps are still
+  // queued behind it; they fail or complete, but do not deadlock.
+  const int kNumSteps = 3;
+  std::vector<std::vector<Tensor>> all_outputs(kNumSteps);
+  BlockingCounter counter(kNumSteps);
+  for (int i = 0; i < kNumSteps; ++i) {
+    session->RunCallableAsync(
+        handle, {test::AsTensor<float>({1.0f * i, 1}, {2, 1})},
+        &all_outputs[i], nullptr, [&session, &counter, i](const Status& s) {
+          if (i == 0) {
+            TF_EXPECT_OK(s);
+            delete session;
+          }
+          counter.DecrementCount();
+        });
+  }
+  counter.Wait();
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -839,6 +1042,58 @@ TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   EXPECT_EQ(20.0, outputs[0].flat<float>()(0));
 }
 
+TEST(DirectSessionTest, RunCallableAsyncOrdersStatefulSteps) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+  Node* var = test::graph::Var(&g, DT_FLOAT, TensorShape({}));
+  Node* init = test::graph::Assign(
+      &g, var, test::graph::Constant(&g, test::AsScalar<float>(0.0f)));
+  // A read-modify-write that loses updates if two steps run it concurrently.
+  Node* increment = test::graph::Assign(
+      &g, var,
+      test::graph::Add(&g, var,
+                       test::graph::Constant(&g, test::AsScalar<float>(1.0f))));
+  g.ToGraphDef(&def);
+
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->set_max_inflight_async_steps(4);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+  TF_ASSERT_OK(session->Run({}, {}, {init->name()}, nullptr));
+
+  Session::CallableHandle handle;
+  CallableOptions callable_options;
+  callable_options.add_fetch(increment->name() + ":0");
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  const int kNumSteps = 20;
+  std::vector<std::vector<Tensor>> all_outputs(kNumSteps);
+  std::vector<Status> statuses(kNumSteps);
+  BlockingCounter counter(kNumSteps);
+  for (int i = 0; i < kNumSteps; ++i) {
+    direct_session->RunCallableAsync(
+        handle, {}, &all_outputs[i], nullptr,
+        [&statuses, &counter, i](const Status& s) {
+          statuses[i] = s;
+          counter.DecrementCount();
+        });
+  }
+  counter.Wait();
+  for (int i = 0; i < kNumSteps; ++i) {
+    TF_ASSERT_OK(statuses[i]);
+    ASSERT_EQ(1, all_outputs[i].size());
+    EXPECT_EQ(i + 1, all_outputs[i][0].scalar<float>()());
+  }
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {var->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(kNumSteps, outputs[0].scalar<float>()());
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 TEST(DirectSessionTest, MultipleFeedTest) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -29,11 +29,27 @@ bool IsAsyncWaitForRemoteFunctionEnabled() {
                                  true, &enabled));
   return enabled;
 }
+
+int MaxParallelNodes() {
+  int64 max_parallel_nodes = 1;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_ASYNC_MAX_PARALLEL_NODES", 1,
+                                  &max_parallel_nodes));
+  return static_cast<int>(std::max<int64>(1, max_parallel_nodes));
+}
 }  // namespace
 
 EagerExecutor::EagerExecutor(bool async)
+    : EagerExecutor(async, MaxParallelNodes()) {}
+
+EagerExecutor::EagerExecutor(bool async, int max_parallel_nodes)
     : next_node_id_(0),
       ok_(true),
+      max_parallel_nodes_(std::max(1, max_parallel_nodes)),
+      parallel_pool_(async && max_parallel_nodes_ > 1
+                         ? new thread::ThreadPool(tensorflow::Env::Default(),
+                                                  "eager_parallel_executor",
+                                                  max_parallel_nodes_)
+                         : nullptr),
       thread_(async ? tensorflow::Env::Default()->StartThread(
                           tensorflow::ThreadOptions(), "eager_async_executor",
                           std::bind(&EagerExecutor::Run, this))
@@ -216,13 +232,14 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
   DVLOG(3) << "Node Done: [id " << item->id << "] " << item->node->DebugString()
            << " with status: " << status.ToString();
   DCHECK(item->state != NodeState::kDONE);
+  // Async nodes and nodes run in parallel are scheduled in unfinished_nodes_.
+  bool scheduled = item->state == NodeState::kSCHEDULED;
   item->state = NodeState::kDONE;
 
-  bool async = item->node->AsAsync() != nullptr;
   // If executing synchronously we don't need to notify if status is OK since
   // the node  was never added to the unfinished_nodes_ list and nobody should
   // ever be waiting for it.
-  if (status.ok() && !from_queue && !async) {
+  if (status.ok() && !from_queue && !scheduled) {
     return;
   }
 
@@ -236,11 +253,12 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       // Since this was from the async queue, pop it from the front of the queue
       DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
       node_queue_.pop();
-    } else if (async) {
+    } else if (scheduled) {
       // If it is an Async node then we will find the node in the unfinished
       // nodes list. However we only notify if we are at the front of the list
       // since we don't want to notify any waiters of earlier nodes.
-      need_notification = item->id == unfinished_nodes_.begin()->first;
+      need_notification = !unfinished_nodes_.empty() &&
+                          item->id == unfinished_nodes_.begin()->first;
       // Remove item if it exists in unfinished_nodes_.
       // With async execution, if two separate nodes failed and enter this
       // callback, then the second node might not find itself in
@@ -272,7 +290,10 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
         node_queue_.pop();
       }
       for (auto& it : unfinished_nodes_) {
-        items_to_destroy.push_front(std::move(it.second));
+        // Nodes running on parallel_pool_ still set their own outputs.
+        if (it.second->node->AsAsync() != nullptr) {
+          items_to_destroy.push_front(std::move(it.second));
+        }
       }
       unfinished_nodes_.clear();
     }
@@ -323,9 +344,10 @@ void EagerExecutor::Run() {
       gtl::MakeCleanup([this] { thread_exited_notification_.Notify(); });
   while (true) {
     core::RefCountPtr<NodeItem> curr_item;
+    bool in_parallel = false;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
-      while (node_queue_.empty() || !status_.ok()) {
+      while (node_queue_.empty() || !status_.ok() || !CanRunFrontLocked()) {
         if (state_ == ExecutorState::kShutDown) return;
         nodes_pending_.wait(l);
       }
@@ -338,6 +360,13 @@ void EagerExecutor::Run() {
       // and register a notification for its completion.
       curr_item.reset(node_queue_.front().get());
       curr_item->Ref();
+      in_parallel =
+          parallel_pool_ != nullptr && curr_item->node->CanRunInParallel();
+      if (in_parallel) ++num_parallel_nodes_;
+    }
+    if (in_parallel) {
+      RunItemInParallel(std::move(curr_item));
+      continue;
     }
     Status status = RunItem(std::move(curr_item), /*from_queue=*/true);
     if (!status.ok()) {
@@ -346,6 +375,40 @@ void EagerExecutor::Run() {
   }
 }
 
+bool EagerExecutor::CanRunFrontLocked() const {
+  if (parallel_pool_ == nullptr) return true;
+  if (node_queue_.front()->node->CanRunInParallel()) {
+    return num_parallel_nodes_ < max_parallel_nodes_;
+  }
+  // Other nodes keep the program order with respect to all nodes.
+  return num_parallel_nodes_ == 0;
+}
+
+void EagerExecutor::RunItemInParallel(core::RefCountPtr<NodeItem> item) {
+  DVLOG(3) << "Running Node in parallel: [id " << item->id << "] "
+           << item->node->DebugString();
+  auto parallel_done = [this]() {
+    tensorflow::mutex_lock l(node_queue_mutex_);
+    --num_parallel_nodes_;
+    nodes_pending_.notify_all();
+  };
+  item->state = NodeState::kSCHEDULED;
+  auto parallel_ref = item.get();
+  parallel_ref->Ref();
+  // This only fails if the executor is in an error state, in which case the
+  // node has been aborted.
+  if (!MoveToUnfinished(std::move(item), /*from_queue=*/true).ok()) {
+    parallel_ref->Unref();
+    parallel_done();
+    return;
+  }
+  parallel_pool_->Schedule([this, parallel_ref, parallel_done]() {
+    core::RefCountPtr<NodeItem> parallel_item(parallel_ref);
+    NodeDone(parallel_item, parallel_item->node->Run(), /*from_queue=*/false);
+    parallel_done();
+  });
+}
+
 Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
                               bool from_queue) {
   DVLOG(3) << "Running Node: [id " << item->id << "] "
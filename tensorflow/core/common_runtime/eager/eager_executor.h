@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/version.h"
 
@@ -75,6 +76,11 @@ class EagerNode {
 
   // Indicates whether a node failure should make the executor unusable.
   virtual bool Fatal() const { return true; }
+
+  // Indicates whether this node may run concurrently with the nodes added
+  // around it. Such a node must not depend on the program order of other nodes
+  // except through its input handles, which it waits for when it runs.
+  virtual bool CanRunInParallel() const { return false; }
 };
 
 class AsyncEagerNode : public EagerNode {
@@ -106,12 +112,19 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
 // TODO(agarwal): TFE_OpAddInput may currently block if it tries to access the
 // device of the input handle. Fix that.
 // TODO(agarwal): Implement support for control dependencies.
-// TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
+//
+// In async mode, nodes run one at a time in the order they were added, unless
+// `max_parallel_nodes` is greater than 1. Then up to that many consecutive
+// nodes whose CanRunInParallel() is true run concurrently on a thread pool,
+// and every other node waits for them to finish and runs alone, so that nodes
+// with side effects still see the program order.
 class EagerExecutor {
  public:
+  // `max_parallel_nodes` defaults to the TF_EAGER_ASYNC_MAX_PARALLEL_NODES
+  // environment variable, or 1.
   explicit EagerExecutor(bool async);
+  EagerExecutor(bool async, int max_parallel_nodes);
 
   ~EagerExecutor();
 
@@ -203,7 +216,13 @@ class EagerExecutor {
   // `status_` is not ok.
   void Run();
 
+  // Returns whether the node at the front of node_queue_ can start, given the
+  // nodes running on parallel_pool_.
+  bool CanRunFrontLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+
   Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
+  // Runs the node at the front of node_queue_ on parallel_pool_.
+  void RunItemInParallel(core::RefCountPtr<NodeItem> item);
   Status MoveToUnfinished(core::RefCountPtr<NodeItem> item, bool from_queue);
 
   // The impl of WaitForAllPendingNodes
@@ -249,6 +268,15 @@ class EagerExecutor {
   ExecutorState state_ TF_GUARDED_BY(node_queue_mutex_) =
       ExecutorState::kActive;
 
+  // Maximum number of nodes running on parallel_pool_ at a time.
+  const int max_parallel_nodes_;
+  int num_parallel_nodes_ TF_GUARDED_BY(node_queue_mutex_) = 0;
+
+  // Runs the nodes that can run in parallel. It is `nullptr` in sync mode or
+  // when max_parallel_nodes_ is 1. It is destroyed after `thread_` exits, and
+  // waits for the nodes still running.
+  const std::unique_ptr<thread::ThreadPool> parallel_pool_;
+
   // Thread object that calls the `Run` method in async mode.This thread runs
   // until state_ is set to kShuttingDown. It is `nullptr` in sync mode.
   const std::unique_ptr<Thread> thread_;
@@ -0,0 +1,125 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+
+#include <functional>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FnNode : public EagerNode {
+ public:
+  FnNode(bool parallel, std::function<Status()> fn)
+      : parallel_(parallel), fn_(std::move(fn)) {}
+
+  Status Run() override { return fn_(); }
+  void Abort(Status status) override {}
+  bool CanRunInParallel() const override { return parallel_; }
+  string DebugString() const override { return "[FnNode]"; }
+
+ private:
+  const bool parallel_;
+  const std::function<Status()> fn_;
+};
+
+TEST(EagerExecutorTest, RunsParallelNodesConcurrently) {
+  EagerExecutor executor(/*async=*/true, /*max_parallel_nodes=*/2);
+  Notification notification;
+  // The first node only succeeds if the second one runs while it waits.
+  TF_ASSERT_OK(executor.AddOrExecute(
+      absl::make_unique<FnNode>(/*parallel=*/true, [&notification]() {
+        if (!WaitForNotificationWithTimeout(&notification, 10 * 1000 * 1000)) {
+          return errors::DeadlineExceeded("Nodes did not run concurrently");
+        }
+        return Status::OK();
+      })));
+  TF_ASSERT_OK(executor.AddOrExecute(
+      absl::make_unique<FnNode>(/*parallel=*/true, [&notification]() {
+        notification.Notify();
+        return Status::OK();
+      })));
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST(EagerExecutorTest, OtherNodesWaitForParallelNodes) {
+  EagerExecutor executor(/*async=*/true, /*max_parallel_nodes=*/4);
+  mutex mu;
+  int num_done = 0;
+  std::vector<int> num_done_before_barrier;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      TF_ASSERT_OK(executor.AddOrExecute(
+          absl::make_unique<FnNode>(/*parallel=*/true, [&mu, &num_done]() {
+            Env::Default()->SleepForMicroseconds(1000);
+            mutex_lock l(mu);
+            ++num_done;
+            return Status::OK();
+          })));
+    }
+    TF_ASSERT_OK(executor.AddOrExecute(absl::make_unique<FnNode>(
+        /*parallel=*/false, [&mu, &num_done, &num_done_before_barrier]() {
+          mutex_lock l(mu);
+          num_done_before_barrier.push_back(num_done);
+          return Status::OK();
+        })));
+  }
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  EXPECT_EQ(num_done, 24);
+  EXPECT_EQ(num_done_before_barrier, std::vector<int>({8, 16, 24}));
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST(EagerExecutorTest, ParallelNodeErrorIsReported) {
+  EagerExecutor executor(/*async=*/true, /*max_parallel_nodes=*/4);
+  TF_ASSERT_OK(executor.AddOrExecute(absl::make_unique<FnNode>(
+      /*parallel=*/true, []() { return errors::Internal("Node failed"); })));
+  Status status = executor.WaitForAllPendingNodes();
+  EXPECT_EQ(status.code(), error::INTERNAL);
+  executor.ClearError();
+  TF_ASSERT_OK(executor.AddOrExecute(absl::make_unique<FnNode>(
+      /*parallel=*/true, []() { return Status::OK(); })));
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+TEST(EagerExecutorTest, RunsInProgramOrderByDefault) {
+  EagerExecutor executor(/*async=*/true, /*max_parallel_nodes=*/1);
+  std::vector<int> order;
+  for (int i = 0; i < 16; ++i) {
+    TF_ASSERT_OK(executor.AddOrExecute(
+        absl::make_unique<FnNode>(/*parallel=*/true, [&order, i]() {
+          order.push_back(i);
+          return Status::OK();
+        })));
+  }
+  TF_EXPECT_OK(executor.WaitForAllPendingNodes());
+  ASSERT_EQ(order.size(), 16);
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+  TF_EXPECT_OK(executor.ShutDown());
+}
+
+}  // namespace
+}  // namespace tensorflow
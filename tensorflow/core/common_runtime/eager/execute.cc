@@ -1108,7 +1108,8 @@ Status EagerKernelExecute(
     absl::Span<TensorHandle*> retvals) {
   profiler::TraceMe activity("EagerKernelExecute",
                              profiler::TraceMeLevel::kInfo);
-  std::vector<EagerKernelRet> outputs(1);
+  std::vector<EagerKernelRet> outputs;
+  outputs.reserve(retvals.size());
 
   ExecuteNodeArgs inputs(op_inputs.size());
   TF_RETURN_IF_ERROR(inputs.Init(ctx, op_inputs, kernel));
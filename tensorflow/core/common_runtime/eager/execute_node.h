@@ -220,6 +220,19 @@ class AsyncExecuteNode : public EagerNode {
     }
   }
 
+  // Stateless ops only depend on the nodes producing their inputs. Resource
+  // inputs are excluded since ops reading a resource may observe writes made
+  // by other nodes.
+  bool CanRunInParallel() const override {
+    if (remote_func_params_.has_value() || kernel_->IsStateful()) {
+      return false;
+    }
+    for (TensorHandle* h : inputs_) {
+      if (h->dtype == DT_RESOURCE) return false;
+    }
+    return true;
+  }
+
   std::string DebugString() const override {
     std::string out = "[AsyncExecuteNode]";
     strings::StrAppend(&out, " kernel: ", kernel_->name());
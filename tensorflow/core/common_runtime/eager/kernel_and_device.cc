@@ -109,6 +109,7 @@ Status KernelAndDeviceOp::Init(const Context& ctx, const NodeDef& ndef,
       ndef, flr_->GetFunctionLibraryDefinition(), &props));
   TF_RETURN_IF_ERROR(flr_->CreateKernel(props, &k));
   kernel_.reset(k);
+  is_stateful_ = props->op_def->is_stateful();
 
   input_alloc_attrs_.resize(kernel_->num_inputs());
   input_devices_.resize(kernel_->num_inputs(), device_);
@@ -307,8 +308,18 @@ Status KernelAndDeviceOp::Run(
 
   if (outputs != nullptr) {
     outputs->clear();
+    outputs->reserve(context.num_outputs());
     for (int i = 0; i < context.num_outputs(); ++i) {
-      outputs->push_back(Tensor(*context.mutable_output(i)));
+      // Take the outputs over from the context instead of copying them, which
+      // saves a reference count round trip per output.  Ref outputs belong to
+      // their variable and are copied.
+      const TensorValue value = context.release_output(i);
+      if (value.is_ref()) {
+        outputs->push_back(Tensor(*value.tensor));
+      } else {
+        std::unique_ptr<Tensor> output(value.tensor);
+        outputs->push_back(output ? std::move(*output) : Tensor());
+      }
     }
   }
   return Status::OK();
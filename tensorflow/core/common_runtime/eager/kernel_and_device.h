@@ -129,6 +129,10 @@ class KernelAndDevice : public core::RefCounted {
 
   virtual bool IsCrossProcess() { return false; }
 
+  // Returns whether running this may have side effects other than producing
+  // its outputs.
+  virtual bool IsStateful() const { return true; }
+
   // TODO(ashankar): Handle list-valued inputs.
   virtual Status Run(
       ScopedStepContainer* step_container, const EagerKernelArgs& inputs,
@@ -228,6 +232,8 @@ class KernelAndDeviceOp final : public KernelAndDevice {
 
   const OpKernel* kernel() const override { return kernel_.get(); }
 
+  bool IsStateful() const override { return is_stateful_; }
+
   Device* InputDevice(int i) const override;
   Device* OutputDevice(int idx) const override;
   Device* OutputResourceDevice(int idx) const override;
@@ -244,6 +250,7 @@ class KernelAndDeviceOp final : public KernelAndDevice {
 
  private:
   std::unique_ptr<OpKernel> kernel_;
+  bool is_stateful_ = true;
   gtl::InlinedVector<AllocatorAttributes, 4> input_alloc_attrs_;
   std::vector<Device*> input_devices_;
   gtl::InlinedVector<AllocatorAttributes, 1> output_alloc_attrs_;
@@ -29,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/attr_builder.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -69,6 +71,33 @@ class TestEnv {
   Device* cpu_device_;
 };
 
+TEST(KernelAndDeviceTest, RunReturnsOutputs) {
+  Tensor t = test::AsTensor<float>({1, 2, 3, 4}, TensorShape({2, 2}));
+  gtl::InlinedVector<TensorValue, 4> inputs;
+  inputs.push_back(TensorValue(&t));
+  NodeDef ndef(AttrBuilder("Unpack")
+                   .Set("T", DT_FLOAT)
+                   .Set("num", 2)
+                   .Set("axis", 0)
+                   .NumInputs(inputs.size())
+                   .BuildNodeDef());
+  TestEnv env;
+  KernelAndDeviceOp k(nullptr, false, env.function_library_runtime(), nullptr,
+                      nullptr, env.cpu_device());
+  TF_ASSERT_OK(k.Init({}, ndef, nullptr));
+  const EagerKernelArgs args(std::move(inputs));
+  std::vector<EagerKernelRet> outputs;
+  TF_ASSERT_OK(k.Run(nullptr, args, &outputs, nullptr, absl::nullopt));
+  ASSERT_EQ(outputs.size(), 2);
+  test::ExpectTensorEqual<float>(absl::get<Tensor>(outputs[0]),
+                                 test::AsTensor<float>({1, 2}));
+  test::ExpectTensorEqual<float>(absl::get<Tensor>(outputs[1]),
+                                 test::AsTensor<float>({3, 4}));
+  // The input is not affected by returning the outputs.
+  test::ExpectTensorEqual<float>(
+      t, test::AsTensor<float>({1, 2, 3, 4}, TensorShape({2, 2})));
+}
+
 void BM_CreateGraph(int iters) {
   for (int i = 0; i < iters; ++i) {
     Scope root = Scope::NewRootScope();
@@ -151,5 +180,31 @@ void BM_KernelAndDeviceRun(int iters) {
   }
 }
 BENCHMARK(BM_KernelAndDeviceRun);
+
+// Measures the per-output cost of returning the results of a kernel.
+void BM_KernelAndDeviceRunOutputs(int iters, int num_outputs) {
+  tensorflow::testing::StopTiming();
+  Tensor t(DT_FLOAT, TensorShape({num_outputs, 2}));
+  t.flat<float>().setZero();
+  gtl::InlinedVector<TensorValue, 4> inputs;
+  inputs.push_back(TensorValue(&t));
+  std::vector<EagerKernelRet> outputs;
+  NodeDef ndef(AttrBuilder("Unpack")
+                   .Set("T", DT_FLOAT)
+                   .Set("num", num_outputs)
+                   .Set("axis", 0)
+                   .NumInputs(inputs.size())
+                   .BuildNodeDef());
+  TestEnv env;
+  KernelAndDeviceOp k(nullptr, false, env.function_library_runtime(), nullptr,
+                      nullptr, env.cpu_device());
+  TF_CHECK_OK(k.Init({}, ndef, nullptr));
+  const EagerKernelArgs args(std::move(inputs));
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(k.Run(nullptr, args, &outputs, nullptr, absl::nullopt));
+  }
+}
+BENCHMARK(BM_KernelAndDeviceRunOutputs)->Arg(1)->Arg(16);
 }  // namespace
 }  // namespace tensorflow
@@ -54,8 +54,76 @@ int64 GetRemoteDeviceIncarnation(Device* device) {
   if (device == nullptr || device->IsLocal()) return 0;
   return device->attributes().incarnation();
 }
+
+// Sanitizers can't see uses of handles that were freed onto the free list, so
+// their builds allocate every handle from the system.
+#if !defined(ADDRESS_SANITIZER) && !defined(MEMORY_SANITIZER) && \
+    !defined(THREAD_SANITIZER)
+#define TF_TENSOR_HANDLE_FREE_LIST
+#endif
+
+#ifdef TF_TENSOR_HANDLE_FREE_LIST
+// Freed TensorHandle allocations kept by a thread for reuse.  The list is
+// bounded so that a thread releasing handles created elsewhere does not hoard
+// memory.
+class HandleFreeList {
+ public:
+  static constexpr int kMaxSize = 64;
+
+  ~HandleFreeList() {
+    destroyed_ = true;
+    for (int i = 0; i < size_; ++i) ::operator delete(blocks_[i]);
+  }
+
+  // Returns the free list of the calling thread, or nullptr while the thread
+  // is exiting.
+  static HandleFreeList* Get() {
+    if (destroyed_) return nullptr;
+    thread_local HandleFreeList list;
+    return &list;
+  }
+
+  void* Pop() { return size_ > 0 ? blocks_[--size_] : nullptr; }
+
+  bool Push(void* block) {
+    if (size_ == kMaxSize) return false;
+    blocks_[size_++] = block;
+    return true;
+  }
+
+ private:
+  static thread_local bool destroyed_;
+  void* blocks_[kMaxSize];
+  int size_ = 0;
+};
+
+thread_local bool HandleFreeList::destroyed_ = false;
+#endif  // TF_TENSOR_HANDLE_FREE_LIST
+
 }  // namespace
 
+void* TensorHandle::operator new(size_t size) {
+#ifdef TF_TENSOR_HANDLE_FREE_LIST
+  if (size == sizeof(TensorHandle)) {
+    HandleFreeList* list = HandleFreeList::Get();
+    void* block = list != nullptr ? list->Pop() : nullptr;
+    if (block != nullptr) return block;
+  }
+#endif  // TF_TENSOR_HANDLE_FREE_LIST
+  return ::operator new(size);
+}
+
+void TensorHandle::operator delete(void* ptr, size_t size) {
+  if (ptr == nullptr) return;
+#ifdef TF_TENSOR_HANDLE_FREE_LIST
+  if (size == sizeof(TensorHandle)) {
+    HandleFreeList* list = HandleFreeList::Get();
+    if (list != nullptr && list->Push(ptr)) return;
+  }
+#endif  // TF_TENSOR_HANDLE_FREE_LIST
+  ::operator delete(ptr);
+}
+
 TensorHandle::PackedTensorHandleData::PackedTensorHandleData(
     std::vector<TensorHandle*>&& handles, const TensorShape& shape)
     : handles_(std::move(handles)), shape_(shape) {
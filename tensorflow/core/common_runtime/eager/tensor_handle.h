@@ -118,6 +118,12 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
                                               EagerContext* ctx);
 #endif  // IS_MOBILE_PLATFORM
 
+  // Handles are allocated from a small per-thread free list, since eager
+  // execution creates and releases one for every op output. Sanitizer builds
+  // have no free list.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   void Release() override;
 
   tensorflow::DataType DataType() const override;
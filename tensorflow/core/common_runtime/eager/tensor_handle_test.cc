@@ -66,6 +66,35 @@ TEST(TensorHandle_ShapeTest, AsyncShape) {
   ctx->Unref();
 }
 
+TEST(TensorHandle_FreeListTest, ReusesReleasedHandles) {
+  Tensor t(DT_INT32, TensorShape({}));
+  t.scalar<int32>()() = 1;
+  TensorHandle* first = TensorHandle::CreateLocalHandle(t);
+  TensorHandle* first_address = first;
+  first->Unref();
+
+  t.scalar<int32>()() = 2;
+  TensorHandle* second = TensorHandle::CreateLocalHandle(t);
+  // Sanitizer builds have no free list, so they don't reuse the handle.
+#if !defined(ADDRESS_SANITIZER) && !defined(MEMORY_SANITIZER) && \
+    !defined(THREAD_SANITIZER)
+  EXPECT_EQ(second, first_address);
+#endif
+  const Tensor* second_tensor = nullptr;
+  TF_EXPECT_OK(second->Tensor(&second_tensor));
+  EXPECT_EQ(second_tensor->scalar<int32>()(), 2);
+
+  // More handles than the free list holds are released back to the system.
+  std::vector<TensorHandle*> handles;
+  for (int i = 0; i < 1000; ++i) {
+    handles.push_back(TensorHandle::CreateLocalHandle(t));
+  }
+  for (TensorHandle* handle : handles) {
+    handle->Unref();
+  }
+  second->Unref();
+}
+
 static Device* CreateDevice(const char* type, const char* name,
                             bool is_local = true) {
   class FakeDevice : public Device {
@@ -0,0 +1,330 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/elementwise_fusion_pass.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/dump_graph.h"
+
+namespace tensorflow {
+
+namespace {
+
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+// Returns the number of inputs of `op` if the _FusedElementwise kernel
+// supports it, and 0 otherwise. Must be kept in sync with
+// kernels/fused_elementwise_op.cc.
+int NumFusableInputs(const string& op) {
+  static const auto* const kOps = new absl::flat_hash_map<string, int>({
+      {"Abs", 1},
+      {"Exp", 1},
+      {"Log", 1},
+      {"Neg", 1},
+      {"Reciprocal", 1},
+      {"Relu", 1},
+      {"Relu6", 1},
+      {"Rsqrt", 1},
+      {"Sigmoid", 1},
+      {"Sqrt", 1},
+      {"Square", 1},
+      {"Tanh", 1},
+      {"Add", 2},
+      {"AddV2", 2},
+      {"Maximum", 2},
+      {"Minimum", 2},
+      {"Mul", 2},
+      {"RealDiv", 2},
+      {"SquaredDifference", 2},
+      {"Sub", 2},
+  });
+  auto it = kOps->find(op);
+  return it == kOps->end() ? 0 : it->second;
+}
+
+bool IsFusable(const Node* n, const std::vector<string>& device_types) {
+  if (!n->IsOp() || NumFusableInputs(n->type_string()) == 0) return false;
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(n->assigned_device_name(), &parsed) ||
+      std::find(device_types.begin(), device_types.end(), parsed.type) ==
+          device_types.end()) {
+    return false;
+  }
+  DataType dtype;
+  return TryGetNodeAttr(n->attrs(), "T", &dtype) &&
+         (dtype == DT_FLOAT || dtype == DT_DOUBLE);
+}
+
+bool IsScalar(ShapeHandle s) {
+  return InferenceContext::RankKnown(s) && InferenceContext::Rank(s) == 0;
+}
+
+// Returns true if `a` and `b` are known to be the same shape, either because
+// shape inference propagated the same handle to both, or because both are
+// fully defined and equal.
+bool ProvablySameShape(ShapeHandle a, ShapeHandle b) {
+  if (a.SameHandle(b)) return true;
+  if (!InferenceContext::RankKnown(a) || !InferenceContext::RankKnown(b) ||
+      InferenceContext::Rank(a) != InferenceContext::Rank(b)) {
+    return false;
+  }
+  for (int i = 0; i < InferenceContext::Rank(a); ++i) {
+    const int64 dim_a =
+        InferenceContext::Value(InferenceContext::DimKnownRank(a, i));
+    const int64 dim_b =
+        InferenceContext::Value(InferenceContext::DimKnownRank(b, i));
+    if (dim_a < 0 || dim_a != dim_b) return false;
+  }
+  return true;
+}
+
+struct Output {
+  Node* node;
+  int index;
+};
+
+// A chain of fusable nodes, each of which consumes the output of the
+// previous one.
+struct Chain {
+  std::vector<Node*> nodes;
+  // The input of the chain, and its shape.
+  Output input;
+  ShapeHandle shape;
+  // The other inputs of the binary ops of the chain.
+  std::vector<Output> args;
+  std::vector<bool> arg_is_lhs;
+};
+
+class ChainFinder {
+ public:
+  ChainFinder(Graph* graph, const std::vector<string>& device_types)
+      : refiner_(graph->versions(), graph->op_registry()),
+        device_types_(device_types) {
+    refiner_.set_require_shape_inference_fns(false);
+    std::vector<Node*> order;
+    GetReversePostOrder(*graph, &order);
+    for (Node* n : order) {
+      // Nodes whose shape cannot be inferred are not fused.
+      Status s = refiner_.AddNode(n);
+      if (!s.ok()) {
+        VLOG(2) << "Shape inference failed for " << n->name() << ": " << s;
+      }
+    }
+    order_ = std::move(order);
+  }
+
+  // Returns the maximal chains of the graph, in topological order.
+  std::vector<Chain> FindChains() {
+    std::vector<Chain> chains;
+    absl::flat_hash_set<const Node*> visited;
+    for (Node* n : order_) {
+      if (visited.contains(n) || !IsFusable(n, device_types_)) continue;
+      Chain chain;
+      if (!StartChain(n, &chain)) continue;
+      visited.insert(n);
+      Node* next;
+      while ((next = NextInChain(chain)) != nullptr &&
+             !visited.contains(next) && ExtendChain(next, &chain)) {
+        visited.insert(next);
+      }
+      if (chain.nodes.size() >= 2) chains.push_back(std::move(chain));
+    }
+    return chains;
+  }
+
+ private:
+  // Returns the shape of input `index` of `n`; `n` must have a context.
+  ShapeHandle InputShape(const Node* n, int index) {
+    return refiner_.GetContext(n)->input(index);
+  }
+
+  bool StartChain(Node* n, Chain* chain) {
+    if (refiner_.GetContext(n) == nullptr) return false;
+    std::vector<const Edge*> inputs;
+    if (!n->input_edges(&inputs).ok()) return false;
+    int input = 0;
+    if (inputs.size() == 2) {
+      ShapeHandle lhs = InputShape(n, 0);
+      ShapeHandle rhs = InputShape(n, 1);
+      if (IsScalar(lhs) && !IsScalar(rhs)) {
+        input = 1;
+      } else if (!IsScalar(rhs) && !ProvablySameShape(lhs, rhs)) {
+        return false;
+      }
+      chain->args.push_back(
+          {inputs[1 - input]->src(), inputs[1 - input]->src_output()});
+      chain->arg_is_lhs.push_back(input == 1);
+    }
+    chain->input = {inputs[input]->src(), inputs[input]->src_output()};
+    chain->shape = InputShape(n, input);
+    chain->nodes.push_back(n);
+    return true;
+  }
+
+  // Returns the only consumer of the output of the last node of `chain`, if
+  // it may join the chain.
+  Node* NextInChain(const Chain& chain) {
+    const Node* last = chain.nodes.back();
+    if (last->out_edges().size() != 1) return nullptr;
+    const Edge* e = *last->out_edges().begin();
+    if (e->IsControlEdge()) return nullptr;
+    Node* next = e->dst();
+    if (!IsFusable(next, device_types_) ||
+        next->assigned_device_name() != last->assigned_device_name() ||
+        next->input_type(0) != last->input_type(0)) {
+      return nullptr;
+    }
+    return next;
+  }
+
+  bool ExtendChain(Node* n, Chain* chain) {
+    if (refiner_.GetContext(n) == nullptr) return false;
+    std::vector<const Edge*> inputs;
+    if (!n->input_edges(&inputs).ok()) return false;
+    if (inputs.size() == 2) {
+      const int arg = inputs[0]->src() == chain->nodes.back() ? 1 : 0;
+      ShapeHandle arg_shape = InputShape(n, arg);
+      if (!IsScalar(arg_shape) &&
+          !ProvablySameShape(arg_shape, chain->shape)) {
+        return false;
+      }
+      chain->args.push_back({inputs[arg]->src(), inputs[arg]->src_output()});
+      chain->arg_is_lhs.push_back(arg == 0);
+    }
+    chain->nodes.push_back(n);
+    return true;
+  }
+
+  ShapeRefiner refiner_;
+  const std::vector<string> device_types_;
+  std::vector<Node*> order_;
+};
+
+// Replaces `chain` with a _FusedElementwise node. `fused_nodes` maps the last
+// node of each chain fused so far to its replacement, since the output of a
+// chain may be the input of another one.
+Status FuseChain(const Chain& chain, Graph* graph,
+                 absl::flat_hash_map<Node*, Node*>* fused_nodes) {
+  auto resolve = [fused_nodes](Node* n) {
+    auto it = fused_nodes->find(n);
+    return it == fused_nodes->end() ? n : it->second;
+  };
+  Node* last = chain.nodes.back();
+  std::vector<string> fused_ops;
+  absl::flat_hash_set<Node*> control_inputs;
+  for (const Node* n : chain.nodes) {
+    fused_ops.push_back(n->type_string());
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) control_inputs.insert(resolve(e->src()));
+    }
+  }
+  std::vector<NodeBuilder::NodeOut> args;
+  for (const Output& arg : chain.args) {
+    args.emplace_back(resolve(arg.node), arg.index);
+  }
+
+  NodeDebugInfo debug_info(*last);
+  Node* fused;
+  TF_RETURN_IF_ERROR(
+      NodeBuilder(graph->NewName(strings::StrCat(last->name(), "/Fused")),
+                  "_FusedElementwise", graph->op_registry(), &debug_info)
+          .Input(resolve(chain.input.node), chain.input.index)
+          .Input(args)
+          .Attr("T", last->input_type(0))
+          .Attr("fused_ops", fused_ops)
+          .Attr("arg_is_lhs", chain.arg_is_lhs)
+          .Device(last->requested_device())
+          .Finalize(graph, &fused));
+  fused->set_assigned_device_name(last->assigned_device_name());
+  for (Node* src : control_inputs) {
+    graph->AddControlEdge(src, fused);
+  }
+  std::vector<const Edge*> out_edges(last->out_edges().begin(),
+                                     last->out_edges().end());
+  for (const Edge* e : out_edges) {
+    graph->AddEdge(fused, e->src_output(), e->dst(), e->dst_input());
+  }
+  for (Node* n : chain.nodes) {
+    graph->RemoveNode(n);
+  }
+  (*fused_nodes)[last] = fused;
+  return Status::OK();
+}
+
+}  // namespace
+
+Status FuseElementwiseChains(Graph* graph,
+                             const std::vector<string>& device_types,
+                             int* num_fused) {
+  std::vector<Chain> chains = ChainFinder(graph, device_types).FindChains();
+  absl::flat_hash_map<Node*, Node*> fused_nodes;
+  for (const Chain& chain : chains) {
+    TF_RETURN_IF_ERROR(FuseChain(chain, graph, &fused_nodes));
+  }
+  *num_fused = chains.size();
+  return Status::OK();
+}
+
+Status ElementwiseFusionPass::Run(const GraphOptimizationPassOptions& options) {
+  if (options.session_options == nullptr ||
+      options.partition_graphs == nullptr) {
+    return Status::OK();
+  }
+  const ConfigProto::Experimental& experimental =
+      options.session_options->config.experimental();
+  std::vector<string> device_types;
+  if (experimental.enable_cpu_elementwise_fusion()) {
+    device_types.push_back(DEVICE_CPU);
+  }
+  if (experimental.enable_gpu_elementwise_fusion()) {
+    device_types.push_back(DEVICE_GPU);
+  }
+  if (device_types.empty()) return Status::OK();
+
+  for (auto& partition : *options.partition_graphs) {
+    Graph* graph = partition.second.get();
+    if (VLOG_IS_ON(3)) {
+      DumpGraphToFile("elementwise_fusion_before", *graph, nullptr, "/tmp");
+    }
+    int num_fused = 0;
+    TF_RETURN_IF_ERROR(FuseElementwiseChains(graph, device_types, &num_fused));
+    VLOG(1) << "Fused " << num_fused << " elementwise chains in "
+            << partition.first;
+    if (VLOG_IS_ON(3)) {
+      DumpGraphToFile("elementwise_fusion_after", *graph, nullptr, "/tmp");
+    }
+  }
+  return Status::OK();
+}
+
+// Runs after the MKL passes, which rewrite some of the same ops.
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_PARTITIONING, 10,
+                      ElementwiseFusionPass);
+
+}  // namespace tensorflow
@@ -0,0 +1,54 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ELEMENTWISE_FUSION_PASS_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_ELEMENTWISE_FUSION_PASS_H_
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+
+// Replaces the maximal chains of elementwise ops placed on CPU (or GPU) with
+// _FusedElementwise nodes, which evaluate the whole chain in a single pass
+// over memory. For example,
+//
+//   x --> Mul(x, 2) --> Add(., b) --> Relu
+//
+// becomes _FusedElementwise(x, 2, b, fused_ops = ["Mul", "Add", "Relu"]).
+//
+// A node only joins the chain of its input if it is the only consumer of that
+// input, and if its other input, if any, is a scalar or provably has the shape
+// of the input of the chain, so that the chain never broadcasts.
+//
+// The pass runs on the partition graphs, for the CPU chains if
+// `ConfigProto.Experimental.enable_cpu_elementwise_fusion` is set and for the
+// GPU chains if `enable_gpu_elementwise_fusion` is.
+class ElementwiseFusionPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+};
+
+// Fuses the elementwise chains of `graph` placed on the devices of
+// `device_types`. Returns the number of chains that were fused in
+// `num_fused`.
+Status FuseElementwiseChains(Graph* graph,
+                             const std::vector<string>& device_types,
+                             int* num_fused);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_ELEMENTWISE_FUSION_PASS_H_
@@ -0,0 +1,235 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/elementwise_fusion_pass.h"
+
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kCpu[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+constexpr char kGpu[] = "/job:localhost/replica:0/task:0/device:GPU:0";
+
+// Places the graph of `root` on `device`, and fuses its chains on the devices
+// of `device_types`.
+Status Fuse(const Scope& root, Graph* graph, int* num_fused,
+            const string& device = kCpu,
+            const std::vector<string>& device_types = {DEVICE_CPU}) {
+  TF_RETURN_IF_ERROR(root.ToGraph(graph));
+  for (Node* n : graph->op_nodes()) {
+    n->set_assigned_device_name(device);
+  }
+  return FuseElementwiseChains(graph, device_types, num_fused);
+}
+
+Node* FindFusedNode(const Graph& graph) {
+  Node* fused = nullptr;
+  for (Node* n : graph.op_nodes()) {
+    if (n->type_string() == "_FusedElementwise") {
+      EXPECT_EQ(nullptr, fused);
+      fused = n;
+    }
+  }
+  return fused;
+}
+
+TEST(ElementwiseFusionPassTest, FusesChain) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto mul = ops::Mul(root.WithOpName("mul"), x, 2.0f);
+  auto add = ops::Add(root.WithOpName("add"), mul, 1.0f);
+  auto relu = ops::Relu(root.WithOpName("relu"), add);
+  auto y = ops::Identity(root.WithOpName("y"), relu);
+
+  Graph graph(OpRegistry::Global());
+  int num_fused;
+  TF_ASSERT_OK(Fuse(root, &graph, &num_fused));
+  EXPECT_EQ(1, num_fused);
+
+  Node* fused = FindFusedNode(graph);
+  ASSERT_NE(nullptr, fused);
+  std::vector<string> fused_ops;
+  TF_ASSERT_OK(GetNodeAttr(fused->attrs(), "fused_ops", &fused_ops));
+  EXPECT_EQ(std::vector<string>({"Mul", "Add", "Relu"}), fused_ops);
+  std::vector<bool> arg_is_lhs;
+  TF_ASSERT_OK(GetNodeAttr(fused->attrs(), "arg_is_lhs", &arg_is_lhs));
+  EXPECT_EQ(std::vector<bool>({false, false}), arg_is_lhs);
+  EXPECT_EQ(kCpu, fused->assigned_device_name());
+
+  const Edge* input;
+  TF_ASSERT_OK(fused->input_edge(0, &input));
+  EXPECT_EQ("x", input->src()->name());
+  TF_ASSERT_OK(y.node()->input_edge(0, &input));
+  EXPECT_EQ(fused, input->src());
+  for (Node* n : graph.op_nodes()) {
+    EXPECT_NE("relu", n->name());
+  }
+}
+
+TEST(ElementwiseFusionPassTest, ChainValueOnTheRightHandSide) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto tanh = ops::Tanh(root.WithOpName("tanh"), x);
+  auto sub = ops::Sub(root.WithOpName("sub"), 1.0f, tanh);
+  // Swish: the argument of the Mul is the input of the chain.
+  auto sigmoid = ops::Sigmoid(root.WithOpName("sigmoid"), sub);
+  auto mul = ops::Mul(root.WithOpName("mul"), sigmoid, sub);
+  auto y = ops::Identity(root.WithOpName("y"), mul);
+
+  Graph graph(OpRegistry::Global());
+  int num_fused;
+  TF_ASSERT_OK(Fuse(root, &graph, &num_fused));
+  // `sub` has two consumers, so it ends the first chain.
+  EXPECT_EQ(2, num_fused);
+  int num_fused_nodes = 0;
+  for (Node* n : graph.op_nodes()) {
+    if (n->type_string() != "_FusedElementwise") continue;
+    ++num_fused_nodes;
+    std::vector<string> fused_ops;
+    TF_ASSERT_OK(GetNodeAttr(n->attrs(), "fused_ops", &fused_ops));
+    std::vector<bool> arg_is_lhs;
+    TF_ASSERT_OK(GetNodeAttr(n->attrs(), "arg_is_lhs", &arg_is_lhs));
+    if (fused_ops[0] == "Tanh") {
+      EXPECT_EQ(std::vector<string>({"Tanh", "Sub"}), fused_ops);
+      EXPECT_EQ(std::vector<bool>({true}), arg_is_lhs);
+    } else {
+      EXPECT_EQ(std::vector<string>({"Sigmoid", "Mul"}), fused_ops);
+      EXPECT_EQ(std::vector<bool>({false}), arg_is_lhs);
+      // Both inputs are the output of the first chain.
+      const Edge* x_edge;
+      const Edge* arg_edge;
+      TF_ASSERT_OK(n->input_edge(0, &x_edge));
+      TF_ASSERT_OK(n->input_edge(1, &arg_edge));
+      EXPECT_EQ("_FusedElementwise", x_edge->src()->type_string());
+      EXPECT_EQ(x_edge->src(), arg_edge->src());
+    }
+  }
+  EXPECT_EQ(2, num_fused_nodes);
+}
+
+TEST(ElementwiseFusionPassTest, DoesNotBroadcast) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto b = ops::Placeholder(root.WithOpName("b"), DT_FLOAT);
+  auto add = ops::Add(root.WithOpName("add"), x, b);
+  auto relu = ops::Relu(root.WithOpName("relu"), add);
+  auto c = ops::Const(root.WithOpName("c"), {1.0f, 2.0f, 3.0f});
+  auto mul = ops::Mul(root.WithOpName("mul"), relu, c);
+  ops::Identity(root.WithOpName("y"), mul);
+
+  Graph graph(OpRegistry::Global());
+  int num_fused;
+  TF_ASSERT_OK(Fuse(root, &graph, &num_fused));
+  // `x` and `b` may have different shapes, and so may `relu` and `c`.
+  EXPECT_EQ(0, num_fused);
+  EXPECT_EQ(nullptr, FindFusedNode(graph));
+}
+
+TEST(ElementwiseFusionPassTest, FusesKnownShapes) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_DOUBLE,
+                            ops::Placeholder::Shape({3}));
+  auto c = ops::Const(root.WithOpName("c"), {1.0, 2.0, 3.0});
+  auto mul = ops::Mul(root.WithOpName("mul"), c, x);
+  auto exp = ops::Exp(root.WithOpName("exp"), mul);
+  ops::Identity(root.WithOpName("y"), exp);
+
+  Graph graph(OpRegistry::Global());
+  int num_fused;
+  TF_ASSERT_OK(Fuse(root, &graph, &num_fused));
+  EXPECT_EQ(1, num_fused);
+  Node* fused = FindFusedNode(graph);
+  ASSERT_NE(nullptr, fused);
+  const Edge* input;
+  TF_ASSERT_OK(fused->input_edge(0, &input));
+  EXPECT_EQ("c", input->src()->name());
+}
+
+TEST(ElementwiseFusionPassTest, OnlyFusesCpuNodes) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto neg = ops::Neg(root.WithOpName("neg"), x);
+  ops::Exp(root.WithOpName("exp"), neg);
+
+  Graph graph(OpRegistry::Global());
+  int num_fused;
+  TF_ASSERT_OK(Fuse(root, &graph, &num_fused, kGpu));
+  EXPECT_EQ(0, num_fused);
+}
+
+TEST(ElementwiseFusionPassTest, FusesGpuNodesIfRequested) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto neg = ops::Neg(root.WithOpName("neg"), x);
+  auto exp = ops::Exp(root.WithOpName("exp"), neg);
+  ops::Identity(root.WithOpName("y"), exp);
+
+  Graph graph(OpRegistry::Global());
+  int num_fused;
+  TF_ASSERT_OK(Fuse(root, &graph, &num_fused, kGpu, {DEVICE_GPU}));
+  EXPECT_EQ(1, num_fused);
+  Node* fused = FindFusedNode(graph);
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ(kGpu, fused->assigned_device_name());
+  std::vector<string> fused_ops;
+  TF_ASSERT_OK(GetNodeAttr(fused->attrs(), "fused_ops", &fused_ops));
+  EXPECT_EQ(std::vector<string>({"Neg", "Exp"}), fused_ops);
+}
+
+TEST(ElementwiseFusionPassTest, RunsInSession) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto mul = ops::Mul(root.WithOpName("mul"), x, 2.0f);
+  auto sub = ops::Sub(root.WithOpName("sub"), 1.0f, mul);
+  auto relu = ops::Relu(root.WithOpName("relu"), sub);
+
+  SessionOptions session_options;
+  session_options.config.mutable_experimental()
+      ->set_enable_cpu_elementwise_fusion(true);
+  // Keep Grappler from rewriting the chain.
+  session_options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  ClientSession session(root, session_options);
+  RunOptions run_options;
+  run_options.set_output_partition_graphs(true);
+  RunMetadata run_metadata;
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run(run_options,
+                           {{x, test::AsTensor<float>({-1, 0, 0.25, 1})}},
+                           {relu}, {}, &outputs, &run_metadata));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({3, 1, 0.5, 0}),
+                                 outputs[0]);
+
+  bool found = false;
+  for (const GraphDef& partition : run_metadata.partition_graphs()) {
+    for (const NodeDef& node : partition.node()) {
+      found |= node.op() == "_FusedElementwise";
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -29,13 +29,17 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_queues.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/control_flow.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op_segment.h"
@@ -55,6 +59,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -68,6 +73,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
@@ -134,7 +140,14 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  ExecutorImpl(const LocalExecutorParams& p, bool work_stealing)
+      : immutable_state_(p), work_stealing_(work_stealing) {}
+
+  ~ExecutorImpl() override {
+    if (VLOG_IS_ON(1)) {
+      kernel_stats_.LogReclassifiedNodes(immutable_state_.graph_view());
+    }
+  }
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
@@ -161,9 +174,28 @@ class ExecutorImpl : public Executor {
         if (gview.node(i)) {
           is_expensive_[i] =
               gview.node(i)->kernel && gview.node(i)->kernel->IsExpensive();
-          cost_estimates_[i] = kInitialCostEstimateCycles;
+          // Kernels that declare themselves inexpensive start from a zero
+          // estimate, which sampled executions raise if they are not.
+          cost_estimates_[i] =
+              is_expensive_[i] ? kInitialCostEstimateCycles : 0;
         }
       }
+
+      int64 sample_interval;
+      Status s = ReadInt64FromEnvVar("TF_EXECUTOR_INEXPENSIVE_SAMPLE_INTERVAL",
+                                     kDefaultInexpensiveSampleInterval,
+                                     &sample_interval);
+      if (!s.ok()) {
+        LOG(ERROR) << s;
+        sample_interval = kDefaultInexpensiveSampleInterval;
+      }
+      sample_inexpensive_ = sample_interval > 0;
+      // Round the interval up to a power of two, so that sampling is a mask.
+      uint32 rounded_interval = 1;
+      while (rounded_interval < sample_interval && rounded_interval < 1 << 30) {
+        rounded_interval *= 2;
+      }
+      inexpensive_sample_mask_ = rounded_interval - 1;
     }
 
     // Returns true iff the given node is considered "expensive". The
@@ -175,15 +207,31 @@ class ExecutorImpl : public Executor {
               kOpIsExpensiveThresholdCycles);
     }
 
+    // Returns true if the current execution of an inexpensive node should be
+    // timed. Expensive nodes are always timed, while about one in
+    // TF_EXECUTOR_INEXPENSIVE_SAMPLE_INTERVAL (32 by default, 0 disables
+    // sampling) executions of inexpensive nodes are, so that the nodes that
+    // are expensive with the actual inputs (e.g. larger shapes) are dispatched
+    // to the thread pool.
+    bool SampleInexpensiveExecution() const {
+      if (!sample_inexpensive_) return false;
+      // A per-thread xorshift generator, so that the sampled nodes do not
+      // depend on the order in which a graph executes them.
+      static thread_local uint32 state = 0x9e3779b9;
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return (state & inexpensive_sample_mask_) == 0;
+    }
+
     // Updates the dynamic cost estimate, which is used to determine whether the
     // given node is expensive. The new cost estimate is a weighted average of
     // the old cost estimate and the latest cost.
     //
-    // NOTE: We currently only expect updates to the cost estimate when
-    // `is_expensive_[node.node_id]` is true (or at least, it *was* true, when
-    // we started to execute the kernel. As a result, we expect that a kernel
-    // can only ever transition from "expensive" to "inexpensive", but not vice
-    // versa.
+    // A node becomes inexpensive when its estimate falls below
+    // `kOpIsExpensiveThresholdCycles`, and expensive again when it exceeds
+    // `kOpBecomesExpensiveThresholdCycles`. The gap between the two thresholds
+    // keeps nodes close to the threshold from switching at every update.
     void UpdateCostEstimate(const NodeItem& node, uint64 elapsed_cycles) {
       // N.B. Updates to `cost_estimate` are atomic but unlocked.  Simultaneous
       // updates may result in one or more updates being ignored.  This does not
@@ -194,8 +242,34 @@ class ExecutorImpl : public Executor {
                                 kCostDecay +
                             (elapsed_cycles / kCostDecay);
       cost_estimate.store(new_estimate, std::memory_order_relaxed);
+      std::atomic<bool>& is_expensive = is_expensive_[node.node_id];
       if (new_estimate < kOpIsExpensiveThresholdCycles) {
-        is_expensive_[node.node_id].store(false, std::memory_order_relaxed);
+        if (is_expensive.load(std::memory_order_relaxed)) {
+          is_expensive.store(false, std::memory_order_relaxed);
+          metrics::RecordExecutorKernelReclassification(/*expensive=*/false);
+        }
+      } else if (new_estimate > kOpBecomesExpensiveThresholdCycles) {
+        if (!is_expensive.load(std::memory_order_relaxed)) {
+          is_expensive.store(true, std::memory_order_relaxed);
+          metrics::RecordExecutorKernelReclassification(/*expensive=*/true);
+        }
+      }
+    }
+
+    // Logs the nodes whose classification differs from the one declared by
+    // their kernel, with their cost estimates.
+    void LogReclassifiedNodes(const GraphView& gview) const {
+      for (int32 i = 0; i < gview.num_nodes(); ++i) {
+        const NodeItem* item = gview.node(i);
+        if (item == nullptr || item->kernel == nullptr) continue;
+        const bool is_expensive = IsExpensive(*item);
+        if (is_expensive == item->kernel->IsExpensive()) continue;
+        VLOG(1) << "Node " << item->kernel->name() << " ("
+                << item->kernel->type_string() << ") was scheduled as "
+                << (is_expensive ? "expensive" : "inexpensive")
+                << " with an estimated cost of "
+                << cost_estimates_[i].load(std::memory_order_relaxed)
+                << " cycles.";
       }
     }
 
@@ -205,15 +279,23 @@ class ExecutorImpl : public Executor {
     // Operations start out "expensive".
     static constexpr uint64 kInitialCostEstimateCycles = 100 * 1000 * 1000;
     static constexpr uint64 kOpIsExpensiveThresholdCycles = 5000;
+    static constexpr uint64 kOpBecomesExpensiveThresholdCycles = 20000;
     static constexpr uint64 kCostDecay = 10;
+    static constexpr int64 kDefaultInexpensiveSampleInterval = 32;
 
     std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
+    bool sample_inexpensive_ = true;
+    uint32 inexpensive_sample_mask_ = kDefaultInexpensiveSampleInterval - 1;
   };
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
 
+  // If true, ready nodes are scheduled on per-worker deques with work
+  // stealing, instead of being dispatched to `Args::runner` one at a time.
+  const bool work_stealing_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -225,8 +307,8 @@ class ExecutorImpl : public Executor {
 //
 // The template argument `class PropagatorStateType` must define the following
 // public members:
-// * A type `TaggedNode`, representing a node to be processed, with public
-//   members:
+// * A default-constructible type `TaggedNode`, representing a node to be
+//   processed, with public members:
 //   * `const NodeItem& get_node_item() const`
 //   * `bool get_is_dead() const`
 // * A type `TaggedNodeReadyQueue`, representing a queue of nodes to be
@@ -271,7 +353,7 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_, bool work_stealing);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -283,11 +365,37 @@ class ExecutorState {
       typename PropagatorStateType::TaggedNodeReadyQueue TaggedNodeReadyQueue;
   typedef typename PropagatorStateType::TaggedNodeSeq TaggedNodeSeq;
 
+  typedef WorkStealingQueues<TaggedNode> ReadyQueues;
+
   struct AsyncState;
 
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64 scheduled_nsec);
 
+  // Process a ready node, and any inexpensive nodes that become ready as a
+  // result, in the current thread. If `deque_id` is not `kNoDeque`, the nodes
+  // that become ready are pushed to that deque of `ready_queues_`, where other
+  // workers can steal them.
+  //
+  // Returns true if execution has completed, in which case `this` may have
+  // been deleted.
+  bool ProcessNodes(TaggedNode node, int64 scheduled_nsec, int deque_id);
+
+  // Body of a work-stealing worker: pops nodes from `queues` (stealing from
+  // other workers when the local deque is empty) until no work remains.
+  // Takes ownership of one reference on `queues`.
+  void RunWorker(ReadyQueues* queues);
+
+  // Starts up to `max_workers` new work-stealing workers, bounded by the
+  // number of idle worker slots.
+  void StartWorkers(int max_workers);
+
+  // Moves all the nodes in `inline_ready` to the deque `deque_id` of
+  // `ready_queues_`, and wakes idle workers to steal them.
+  void SpillToDeque(TaggedNodeReadyQueue* inline_ready, int deque_id);
+
+  static constexpr int kNoDeque = -1;
+
   Status ProcessSync(const NodeItem& item, OpKernelContext::Params* params,
                      EntryVector* outputs, NodeExecStatsInterface* stats);
   void ProcessAsync(const NodeItem& item, const OpKernelContext::Params& params,
@@ -363,6 +471,19 @@ class ExecutorState {
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
 
+  // Non-null iff the work-stealing scheduler is enabled for this step. Owns
+  // one reference.
+  ReadyQueues* ready_queues_ = nullptr;
+
+  // Non-null iff `Args::use_step_arena` is set and the device is a CPU.
+  // `EndStep()` is called when this ExecutorState is destroyed; the allocator
+  // deletes itself when the last tensor it allocated is freed.
+  StepArenaAllocator* step_arena_allocator_ = nullptr;
+
+  // Non-null iff `Args::memory_planner` is set, the device is a CPU and the
+  // planner accepted the step. Takes precedence over `step_arena_allocator_`.
+  StaticMemoryPlanStep* memory_plan_step_ = nullptr;
+
   PropagatorStateType propagator_;
 
   // Invoked when the execution finishes.
@@ -383,7 +504,7 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, bool work_stealing)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -413,6 +534,21 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (work_stealing && !run_all_kernels_inline_) {
+    ready_queues_ = new ReadyQueues(port::MaxParallelism());
+  }
+  if (args.use_step_arena || args.memory_planner != nullptr) {
+    Device* device = immutable_state_.params().device;
+    if (device->attributes().device_type() == DEVICE_CPU) {
+      Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+      if (args.memory_planner != nullptr) {
+        memory_plan_step_ = args.memory_planner->BeginStep(allocator);
+      }
+      if (args.use_step_arena && memory_plan_step_ == nullptr) {
+        step_arena_allocator_ = new StepArenaAllocator(allocator);
+      }
+    }
+  }
 }
 
 template <class PropagatorStateType>
@@ -420,6 +556,15 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
   if (device_context_) {
     device_context_->Unref();
   }
+  if (ready_queues_) {
+    ready_queues_->Unref();
+  }
+  if (step_arena_allocator_) {
+    step_arena_allocator_->EndStep();
+  }
+  if (memory_plan_step_) {
+    memory_plan_step_->EndStep();
+  }
   delete slice_reader_cache_;
 }
 
@@ -538,7 +683,7 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
     device->Compute(op_kernel, &ctx);
   } else {
     // In the common case, avoid creating any tracing objects.
-    if (is_expensive) {
+    if (is_expensive || kernel_stats_->SampleInexpensiveExecution()) {
       KernelTimer timer;
       device->Compute(op_kernel, &ctx);
       kernel_stats_->UpdateCostEstimate(item, timer.ElapsedCycles());
@@ -628,6 +773,13 @@ void ExecutorState<PropagatorStateType>::ProcessConstTensor(
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
                                                  int64 scheduled_nsec) {
+  ProcessNodes(tagged_node, scheduled_nsec, kNoDeque);
+}
+
+template <class PropagatorStateType>
+bool ExecutorState<PropagatorStateType>::ProcessNodes(TaggedNode tagged_node,
+                                                      int64 scheduled_nsec,
+                                                      int deque_id) {
   profiler::TraceMeConsumer activity(
       // From TraceMeProducer in DirectSession::RunInternal,
       // GraphMgr::ExecuteAsync, or FunctionLibraryRuntime::Run.
@@ -672,6 +824,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   params.resource_manager = device->resource_manager();
   params.step_container = step_container_;
   params.slice_reader_cache = slice_reader_cache_;
+  params.step_arena_allocator = step_arena_allocator_;
   params.inputs = &inputs;
   params.input_alloc_attrs = &input_alloc_attrs;
   params.runner = &runner_;
@@ -709,6 +862,11 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   while (!inline_ready.empty()) {
     tagged_node = inline_ready.front();
     inline_ready.pop_front();
+    if (deque_id != kNoDeque && !inline_ready.empty()) {
+      // Keep running the first ready successor in this thread, and make the
+      // others available to idle workers.
+      SpillToDeque(&inline_ready, deque_id);
+    }
     const NodeItem& item = tagged_node.get_node_item();
     const int id = item.node_id;
 
@@ -763,10 +921,17 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
       // Set up compute params.
       params.op_kernel = item.kernel;
+      if (memory_plan_step_ != nullptr) {
+        // Planned allocations that outlive the step fall back to the base
+        // allocator, so the plan may also serve outputs.
+        params.step_arena_allocator = memory_plan_step_->node_allocator(id);
+        params.step_output_allocator = params.step_arena_allocator;
+      }
       params.frame_iter = propagator_.GetFrameAndIter(tagged_node);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
+      params.output_retval_array = item.output_retval_index.get();
       params.outputs_required_array = item.outputs_required.get();
 
       if (item.kernel_is_async) {
@@ -812,6 +977,45 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
   // This thread of computation is done if completed = true.
   if (completed) ScheduleFinish();
+  return completed;
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunWorker(ReadyQueues* queues) {
+  // NOTE: `this` may be deleted by another worker whenever this worker does
+  // not hold a node, so only `queues` may be accessed outside
+  // `ProcessNodes()`.
+  core::ScopedUnref unref(queues);
+  const int deque_id = queues->NextDequeId();
+  do {
+    TaggedNode tagged_node;
+    while (queues->PopOrSteal(deque_id, &tagged_node)) {
+      const int64 scheduled_nsec =
+          stats_collector_ ? nodestats::NowInNsec() : 0;
+      if (ProcessNodes(tagged_node, scheduled_nsec, deque_id)) return;
+    }
+  } while (!queues->StopWorker());
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::StartWorkers(int max_workers) {
+  for (int i = 0; i < max_workers; ++i) {
+    if (!ready_queues_->TryStartWorker()) break;
+    ready_queues_->Ref();
+    runner_([this, queues = ready_queues_]() { RunWorker(queues); });
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::SpillToDeque(
+    TaggedNodeReadyQueue* inline_ready, int deque_id) {
+  int num_pushed = 0;
+  while (!inline_ready->empty()) {
+    ready_queues_->Push(deque_id, inline_ready->front());
+    inline_ready->pop_front();
+    ++num_pushed;
+  }
+  StartWorkers(num_pushed);
 }
 
 template <class PropagatorStateType>
@@ -1110,7 +1314,26 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     scheduled_nsec = nodestats::NowInNsec();
   }
 
-  if (run_all_kernels_inline_) {
+  if (ready_queues_ != nullptr) {
+    if (inline_ready == nullptr) {
+      // Hold an extra outstanding op while scheduling, because the workers
+      // may finish all the nodes in `*ready` (and delete `this`) before the
+      // last worker is started.
+      num_outstanding_ops_.fetch_add(1, std::memory_order_relaxed);
+      for (auto& tagged_node : *ready) {
+        ready_queues_->Push(ready_queues_->NextDequeId(), tagged_node);
+      }
+      StartWorkers(ready->size());
+      ready->clear();
+      if (num_outstanding_ops_.fetch_sub(1) == 1) ScheduleFinish();
+      return;
+    }
+    // The calling worker runs these nodes, and spills them to its deque for
+    // the other workers to steal.
+    for (auto& tagged_node : *ready) {
+      inline_ready->push_back(tagged_node);
+    }
+  } else if (run_all_kernels_inline_) {
     if (inline_ready == nullptr) {
       // Schedule all ready kernels from a single closure. This ensure that,
       // regardless of the `runner_` implementation, all kernels will run
@@ -1299,20 +1522,24 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        work_stealing_))
         ->RunAsync(std::move(done));
   } else {
     (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+                                              &kernel_stats_, work_stealing_))
         ->RunAsync(std::move(done));
   }
 }
 
 }  // namespace
 
-Status NewLocalExecutor(const LocalExecutorParams& params, const Graph& graph,
-                        Executor** executor) {
-  ExecutorImpl* impl = new ExecutorImpl(params);
+namespace {
+
+Status NewLocalExecutorImpl(const LocalExecutorParams& params,
+                            const Graph& graph, bool work_stealing,
+                            Executor** executor) {
+  ExecutorImpl* impl = new ExecutorImpl(params, work_stealing);
   const Status s = impl->Initialize(graph);
   if (s.ok()) {
     *executor = impl;
@@ -1322,6 +1549,14 @@ Status NewLocalExecutor(const LocalExecutorParams& params, const Graph& graph,
   return s;
 }
 
+}  // namespace
+
+Status NewLocalExecutor(const LocalExecutorParams& params, const Graph& graph,
+                        Executor** executor) {
+  return NewLocalExecutorImpl(params, graph, /*work_stealing=*/false,
+                              executor);
+}
+
 Status CreateNonCachedKernel(Device* device, FunctionLibraryRuntime* flib,
                              const std::shared_ptr<const NodeProperties>& props,
                              int graph_def_version, OpKernel** kernel) {
@@ -1339,20 +1574,29 @@ namespace {
 class DefaultExecutorRegistrar {
  public:
   DefaultExecutorRegistrar() {
-    Factory* factory = new Factory;
+    Factory* factory = new Factory(/*work_stealing=*/false);
     ExecutorFactory::Register("", factory);
     ExecutorFactory::Register("DEFAULT", factory);
+    ExecutorFactory::Register("WORK_STEALING",
+                              new Factory(/*work_stealing=*/true));
   }
 
  private:
   class Factory : public ExecutorFactory {
+   public:
+    explicit Factory(bool work_stealing) : work_stealing_(work_stealing) {}
+
     Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
                        std::unique_ptr<Executor>* out_executor) override {
       Executor* ret = nullptr;
-      TF_RETURN_IF_ERROR(NewLocalExecutor(params, std::move(graph), &ret));
+      TF_RETURN_IF_ERROR(
+          NewLocalExecutorImpl(params, graph, work_stealing_, &ret));
       out_executor->reset(ret);
       return Status::OK();
     }
+
+   private:
+    const bool work_stealing_;
   };
 };
 static DefaultExecutorRegistrar registrar;
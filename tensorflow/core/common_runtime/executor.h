@@ -31,6 +31,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class StaticMemoryPlanner;
 class StepStatsCollector;
 
 // Executor runs a graph computation.
@@ -107,6 +108,17 @@ class Executor {
     // If true, all kernels will be treated as "inexpensive", and hence executed
     // on the scheduling thread.
     bool run_all_kernels_inline = false;
+
+    // If true and the executor runs on a CPU device, kernel outputs and
+    // temporaries are bump-allocated from a step-scoped arena (see
+    // `StepArenaAllocator`) instead of the device allocator.
+    bool use_step_arena = false;
+
+    // If not null and the executor runs on a CPU device, kernel outputs and
+    // temporaries are served from a memory plan recorded on an earlier step
+    // (see `StaticMemoryPlanner`). The planner must be created for the graph
+    // of this executor. Not owned.
+    StaticMemoryPlanner* memory_planner = nullptr;
   };
   typedef std::function<void(const Status&)> DoneCallback;
   virtual void RunAsync(const Args& args, DoneCallback done) = 0;
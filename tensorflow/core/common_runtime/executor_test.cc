@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/array_ops.h"
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -41,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/profile_utils/cpu_utils.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -82,7 +86,13 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (executor_type_.empty()) {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    } else {
+      std::unique_ptr<Executor> executor;
+      TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &executor));
+      exec_ = executor.release();
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -101,6 +111,8 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  // If non-empty, the type passed to `NewExecutor()` by `Create()`.
+  string executor_type_;
 };
 
 // A float val -> Tensor<float>
@@ -255,6 +267,26 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  executor_type_ = "WORK_STEALING";
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -290,6 +322,24 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, ConcurrentAddAssignWorkStealing) {
+  executor_type_ = "WORK_STEALING";
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildConcurrentAddAssign(g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -430,10 +480,92 @@ TEST_F(ExecutorTest, NoInputTensors) {
   TF_ASSERT_OK(Run(rendez_));
 }
 
+// The number of cycles each ExecutorTestSpin kernel spins for.
+std::atomic<uint64> spin_cycles(0);
+
+REGISTER_OP("ExecutorTestSpin").Input("x: float").Output("y: float");
+
+// A kernel that declares itself inexpensive, but takes `spin_cycles`.
+class SpinOp : public OpKernel {
+ public:
+  explicit SpinOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const uint64 start = profile_utils::CpuUtils::GetCurrentClockCycle();
+    const uint64 cycles = spin_cycles.load();
+    while (profile_utils::CpuUtils::GetCurrentClockCycle() - start < cycles) {
+    }
+    ctx->set_output(0, ctx->input(0));
+  }
+
+  bool IsExpensive() override { return false; }
+};
+
+REGISTER_KERNEL_BUILDER(Name("ExecutorTestSpin").Device(DEVICE_CPU), SpinOp);
+
+TEST_F(ExecutorTest, InexpensiveKernelMovesToThreadPoolAndBack) {
+  if (profile_utils::CpuUtils::GetCurrentClockCycle() ==
+      profile_utils::CpuUtils::DUMMY_CYCLE_CLOCK) {
+    GTEST_SKIP() << "No cycle counter";
+  }
+  // Time every execution rather than a sample of them.
+  setenv("TF_EXECUTOR_INEXPENSIVE_SAMPLE_INTERVAL", "1", /*overwrite=*/1);
+  // Four nodes that become ready together. Inline nodes run on the thread
+  // that made them ready, while all but one expensive node are dispatched
+  // through the runner.
+  constexpr int kNumSpins = 4;
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  Node* in = test::graph::Constant(g.get(), V(1.0));
+  for (int i = 0; i < kNumSpins; ++i) {
+    Node* spin;
+    TF_ASSERT_OK(NodeBuilder(g->NewName("spin"), "ExecutorTestSpin")
+                     .Input(in)
+                     .Finalize(g.get(), &spin));
+  }
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_INEXPENSIVE_SAMPLE_INTERVAL");
+  std::atomic<int> num_dispatched(0);
+  runner_ = [this, &num_dispatched](std::function<void()> fn) {
+    ++num_dispatched;
+    thread_pool_->Schedule(fn);
+  };
+  // Runs the graph with kernels of `cycles`, and returns whether the spin
+  // nodes were dispatched to the thread pool. The root node always is.
+  auto run = [&](uint64 cycles) {
+    spin_cycles = cycles;
+    num_dispatched = 0;
+    TF_CHECK_OK(Run(rendez_));
+    return num_dispatched > 1;
+  };
+
+  EXPECT_FALSE(run(0));
+  // A node is only dispatched once its estimate exceeds 20000 cycles, so
+  // kernels of 12000 cycles stay inline.
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_FALSE(run(12000)) << i;
+  }
+  // A slow execution raises the estimate above 20000 cycles.
+  run(400000);
+  EXPECT_TRUE(run(400000));
+  // A node only returns inline once its estimate falls below 5000 cycles, so
+  // kernels of 12000 cycles stay on the thread pool.
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_TRUE(run(12000)) << i;
+  }
+  // Fast executions eventually lower the estimate below 5000 cycles.
+  bool dispatched = true;
+  for (int i = 0; i < 100 && dispatched; ++i) {
+    dispatched = run(0);
+  }
+  EXPECT_FALSE(dispatched);
+  EXPECT_FALSE(run(0));
+}
+
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+static void RunExecutorBenchmark(int iters, int width, int depth,
+                                 const char* executor_type) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -472,19 +604,34 @@ static void BM_executor(int iters, int width, int depth) {
 #endif  // PLATFORM_GOOGLE
   FixupSourceAndSinkEdges(g);
   testing::StartTiming();
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, /*options=*/nullptr, /*init=*/nullptr,
+                  /*rendez=*/nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "");
+}
+
+static void BM_executor_work_stealing(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "WORK_STEALING");
 }
 
 // Tall skinny graphs
 BENCHMARK(BM_executor)->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(16, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(32, 8192);
 
 // Short fat graphs
 BENCHMARK(BM_executor)->ArgPair(1024, 16);
 BENCHMARK(BM_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 16);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(8192, 32);
 
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 1024);
 
 static void BM_const_identity(int iters, int width, int outputs_per_const) {
 #ifdef PLATFORM_GOOGL
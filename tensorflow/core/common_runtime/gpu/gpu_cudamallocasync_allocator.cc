@@ -0,0 +1,224 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_id_utils.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/stream_executor.h"
+
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 11020
+#define TF_CUDA_MALLOC_ASYNC_SUPPORTED 1
+#else
+#define TF_CUDA_MALLOC_ASYNC_SUPPORTED 0
+#endif
+
+namespace tensorflow {
+
+GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
+    PlatformGpuId platform_gpu_id, size_t total_memory)
+    : name_(strings::StrCat("GPU_", platform_gpu_id.value(),
+                            "_cuda_malloc_async")) {
+  stream_exec_ =
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie();
+  stats_.bytes_limit = static_cast<int64>(total_memory);
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUdevice device;
+  CUmemoryPool pool = nullptr;
+  CUresult res = cuDeviceGet(&device, platform_gpu_id.value());
+  if (res == CUDA_SUCCESS) {
+    res = cuDeviceGetDefaultMemPool(&pool, device);
+  }
+  if (res != CUDA_SUCCESS) {
+    LOG(FATAL) << "Failed to get the default CUDA memory pool of GPU "
+               << platform_gpu_id.value() << ": " << res;
+  }
+  // By default the pool returns all unused memory to the driver whenever a
+  // stream, event or context is synchronized. Keeping what TensorFlow may
+  // use anyway avoids reallocating it from the driver on every step.
+  cuuint64_t release_threshold = total_memory;
+  res = cuMemPoolSetAttribute(pool, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD,
+                              &release_threshold);
+  if (res != CUDA_SUCCESS) {
+    LOG(FATAL) << "Failed to set the release threshold of the CUDA memory "
+                  "pool of GPU "
+               << platform_gpu_id.value() << ": " << res;
+  }
+  pool_ = pool;
+#else
+  LOG(FATAL) << "GpuCudaMallocAsyncAllocator requires TensorFlow to be built "
+                "with CUDA 11.2 or later.";
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+GpuCudaMallocAsyncAllocator::~GpuCudaMallocAsyncAllocator() {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  mutex_lock l(mu_);
+  if (!size_map_.empty()) {
+    LOG(WARNING) << Name() << " destroyed with " << size_map_.size()
+                 << " live allocations.";
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+bool GpuCudaMallocAsyncAllocator::IsSupported(PlatformGpuId platform_gpu_id) {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  CUdevice device;
+  int supported = 0;
+  if (cuDeviceGet(&device, platform_gpu_id.value()) != CUDA_SUCCESS ||
+      cuDeviceGetAttribute(&supported,
+                           CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED,
+                           device) != CUDA_SUCCESS) {
+    return false;
+  }
+  return supported != 0;
+#else
+  return false;
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void GpuCudaMallocAsyncAllocator::SetStream(se::Stream* stream) {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  cuda_stream_ = se::gpu::AsGpuStreamValue(stream);
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void* GpuCudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
+                                               size_t num_bytes) {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  if (num_bytes == 0) {
+    return nullptr;
+  }
+  // Pool allocations are aligned to at least 256 bytes, like those of
+  // GPUBFCAllocator.
+  DCHECK_LE(alignment, 256);
+
+  // Reserve the bytes before calling into the driver so that concurrent
+  // allocations cannot overshoot the limit together.
+  {
+    mutex_lock l(mu_);
+    if (stats_.bytes_in_use + static_cast<int64>(num_bytes) >
+        *stats_.bytes_limit) {
+      LOG(WARNING) << Name() << " ran out of memory trying to allocate "
+                   << strings::HumanReadableNumBytes(num_bytes) << " with "
+                   << strings::HumanReadableNumBytes(stats_.bytes_in_use)
+                   << " in use.";
+      return nullptr;
+    }
+    stats_.bytes_in_use += num_bytes;
+  }
+
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUdeviceptr ptr = 0;
+  CUresult res =
+      cuMemAllocFromPoolAsync(&ptr, num_bytes, static_cast<CUmemoryPool>(pool_),
+                              static_cast<CUstream>(cuda_stream_));
+  mutex_lock l(mu_);
+  if (res != CUDA_SUCCESS) {
+    stats_.bytes_in_use -= num_bytes;
+    LOG(ERROR) << "cuMemAllocFromPoolAsync failed to allocate " << num_bytes
+               << " bytes: " << res;
+    return nullptr;
+  }
+  void* rv = reinterpret_cast<void*>(ptr);
+  size_map_[rv] = num_bytes;
+  ++stats_.num_allocs;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64>(stats_.largest_alloc_size, num_bytes);
+  return rv;
+#else
+  return nullptr;
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+void GpuCudaMallocAsyncAllocator::DeallocateRaw(void* ptr) {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  if (ptr == nullptr) {
+    return;
+  }
+  se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+  CUresult res = cuMemFreeAsync(reinterpret_cast<CUdeviceptr>(ptr),
+                                static_cast<CUstream>(cuda_stream_));
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "cuMemFreeAsync failed to free " << ptr << ": " << res;
+  }
+  mutex_lock l(mu_);
+  auto it = size_map_.find(ptr);
+  DCHECK(it != size_map_.end()) << "Freeing unknown pointer " << ptr;
+  if (it != size_map_.end()) {
+    stats_.bytes_in_use -= it->second;
+    size_map_.erase(it);
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
+
+size_t GpuCudaMallocAsyncAllocator::RequestedSize(const void* ptr) const {
+  mutex_lock l(mu_);
+  auto it = size_map_.find(ptr);
+  CHECK(it != size_map_.end()) << "Asked for requested size of unknown pointer "
+                               << ptr;
+  return it->second;
+}
+
+size_t GpuCudaMallocAsyncAllocator::AllocatedSize(const void* ptr) const {
+  return RequestedSize(ptr);
+}
+
+absl::optional<AllocatorStats> GpuCudaMallocAsyncAllocator::GetStats() {
+  mutex_lock l(mu_);
+  AllocatorStats stats = stats_;
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+  // The memory the pool holds from the driver, whether in use or cached for
+  // reuse.
+  CUmemoryPool pool = static_cast<CUmemoryPool>(pool_);
+  cuuint64_t reserved = 0;
+  if (cuMemPoolGetAttribute(pool, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT,
+                            &reserved) == CUDA_SUCCESS) {
+    stats.bytes_reserved = reserved;
+  }
+  if (cuMemPoolGetAttribute(pool, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH,
+                            &reserved) == CUDA_SUCCESS) {
+    stats.peak_bytes_reserved = reserved;
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+  return stats;
+}
+
+void GpuCudaMallocAsyncAllocator::ClearStats() {
+  mutex_lock l(mu_);
+  stats_.num_allocs = 0;
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.largest_alloc_size = 0;
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+  cuuint64_t zero = 0;
+  cuMemPoolSetAttribute(static_cast<CUmemoryPool>(pool_),
+                        CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH, &zero);
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
+
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that hands out memory from the device's default CUDA memory
+// pool with stream-ordered allocation (cuMemAllocFromPoolAsync and
+// cuMemFreeAsync, available from CUDA 11.2).
+//
+// Unlike GPUBFCAllocator, the memory is managed by the driver: it is only
+// reserved as it is needed, freed memory is reused by later allocations on
+// the same stream without waiting for the device, and memory released by the
+// pool is available to other CUDA libraries in the process.
+//
+// Allocations and deallocations are ordered on the stream passed to
+// SetStream(), which must be the device's compute stream, so a buffer freed
+// by the host may be reused as soon as the kernels already enqueued on that
+// stream are done with it. That is the same contract GPUBFCAllocator relies
+// on.
+class GpuCudaMallocAsyncAllocator : public Allocator {
+ public:
+  // `total_memory` bounds the bytes in use at any time. The pool keeps up to
+  // that many bytes reserved between synchronizations instead of returning
+  // them to the driver.
+  explicit GpuCudaMallocAsyncAllocator(PlatformGpuId platform_gpu_id,
+                                       size_t total_memory);
+  ~GpuCudaMallocAsyncAllocator() override;
+  string Name() override { return name_; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override { return true; }
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Sets the stream that allocations and deallocations are ordered on. Until
+  // it is called, the legacy default stream is used.
+  void SetStream(se::Stream* stream);
+
+  // Returns true if the driver supports stream-ordered allocation on
+  // `platform_gpu_id`.
+  static bool IsSupported(PlatformGpuId platform_gpu_id);
+
+ private:
+  const string name_;
+  se::StreamExecutor* stream_exec_;  // Not owned.
+
+  // CUmemoryPool and CUstream, kept opaque so that this header does not
+  // depend on the CUDA headers.
+  void* pool_ = nullptr;
+  void* cuda_stream_ = nullptr;
+
+  mutable mutex mu_;
+  AllocatorStats stats_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<const void*, size_t> size_map_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuCudaMallocAsyncAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_CUDAMALLOCASYNC_ALLOCATOR_H_
@@ -35,6 +35,7 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
@@ -440,6 +441,14 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
                            stream_->host_to_device, stream_->device_to_host,
                            stream_->device_to_device);
 
+  // Order stream-ordered allocations on the stream kernels run on, so that
+  // freed memory is reused without waiting for the device.
+  auto* async_allocator =
+      dynamic_cast<GpuCudaMallocAsyncAllocator*>(gpu_allocator_);
+  if (async_allocator != nullptr) {
+    async_allocator->SetStream(stream_->compute);
+  }
+
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
 
@@ -103,14 +103,19 @@ EventMgr::~EventMgr() {
   StopPollingLoop();
 
   // Events are owned by this object.
-  for (auto& e : free_events_) {
-    delete e;
-  }
-  while (!used_events_.empty()) {
-    InUse* ue = &used_events_[0];
-    delete ue->event;
-    if (ue->func != nullptr) threadpool_.Schedule(ue->func);
-    used_events_.pop_front();
+  mutex_lock l(mu_);
+  for (auto& entry : stream_queues_) {
+    StreamQueue* queue = entry.second.get();
+    mutex_lock ql(queue->mu);
+    for (auto& e : queue->free_events) {
+      delete e;
+    }
+    while (!queue->used_events.empty()) {
+      InUse* ue = &queue->used_events[0];
+      delete ue->event;
+      if (ue->func != nullptr) threadpool_.Schedule(ue->func);
+      queue->used_events.pop_front();
+    }
   }
 }
 
@@ -136,6 +141,13 @@ void EventMgr::StopPollingLoop() {
   }
 }
 
+void EventMgr::WakePollLoop() {
+  // Taking mu_ orders this notification after the polling loop's check of
+  // num_pending_, so the wakeup cannot be lost.
+  mutex_lock l(mu_);
+  events_pending_.notify_all();
+}
+
 // A polling loop to detect completion of GPU events.
 //
 // While one or more events is outstanding, poll for completed events.  When no
@@ -143,45 +155,56 @@ void EventMgr::StopPollingLoop() {
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
   while (true) {
-    bool events_still_pending;
     {
       mutex_lock l(mu_);
       if (stop_polling_) {
         break;
       }
-      if (used_events_.empty()) {
+      if (num_pending_.load(std::memory_order_acquire) == 0) {
         events_pending_.wait(l);
+        continue;
       }
-      PollEvents(true, &to_free);
-      events_still_pending = !used_events_.empty();
     }
+    PollEvents(&to_free);
     FreeMemory(to_free);
     to_free.clear();
 
-    if (events_still_pending) {
+    if (num_pending_.load(std::memory_order_acquire) > 0) {
       Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
     }
   }
   polling_stopped_->Notify();
 }
 
-void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
-  VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
-          << " used_events_ " << used_events_.size();
+EventMgr::StreamQueue* EventMgr::GetStreamQueue(se::Stream* stream) {
+  {
+    tf_shared_lock l(mu_);
+    auto it = stream_queues_.find(stream);
+    if (it != stream_queues_.end()) return it->second.get();
+  }
+  mutex_lock l(mu_);
+  std::unique_ptr<StreamQueue>& queue = stream_queues_[stream];
+  if (queue == nullptr) queue.reset(new StreamQueue);
+  return queue.get();
+}
+
+bool EventMgr::QueueInUse(StreamQueue* queue, se::Stream* stream,
+                          InUse in_use) {
+  VLOG(2) << "QueueInUse  free_events " << queue->free_events.size()
+          << " used_events " << queue->used_events.size();
   // Events are created on demand, and repeatedly reused.  There is no
   // limit placed here on the number of allocated Events.
-  if (free_events_.empty()) {
-    free_events_.push_back(new se::Event(exec_));
-    free_events_.back()->Init();
+  if (queue->free_events.empty()) {
+    queue->free_events.push_back(new se::Event(exec_));
+    queue->free_events.back()->Init();
   }
-  se::Event* e = free_events_.back();
-  free_events_.pop_back();
+  se::Event* e = queue->free_events.back();
+  queue->free_events.pop_back();
   stream->ThenRecordEvent(e);
   in_use.event = e;
-  bool was_empty = used_events_.empty();
-  used_events_.push_back(in_use);
+  queue->used_events.push_back(in_use);
   // Maybe wake up the polling thread
-  if (was_empty) events_pending_.notify_all();
+  return num_pending_.fetch_add(1, std::memory_order_acq_rel) == 0;
 }
 
 // This function must be called periodically to check whether pending
@@ -192,53 +215,41 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
 // is used to cap pending kernels there should never be more than
 // that many.)
 //
-// NOTE: If all events are on the same stream, no later event will
-// complete before an earlier event, except possibly if the earlier
-// event transitions to an error state, so there's no advantage in
-// looking past the first kPending event.  However, if we're using
-// multiple streams there may be some gain in looking deeper.
-// As a compromise, PollEvent() calls that are triggered by the queueing
-// of a single event never look past the first kPending event.  Consequently
-// those calls do an expected constant amount of work, unaffected by the
-// length of the pending queue.  Calls coming from the dedicated
-// polling thread always sweep the full queue.
-void EventMgr::PollEvents(bool is_dedicated_poller,
-                          gtl::InlinedVector<InUse, 4>* to_free) {
-  VLOG(2) << "PollEvents  free_events_ " << free_events_.size()
-          << " used_events_ " << used_events_.size();
-  // Sweep the remaining events in order.  If this is the dedicated
-  // polling thread, check the entire set.  Otherwise, just sweep up to
-  // the first non-complete record that is still pending.
-  for (auto& iu : used_events_) {
-    if (iu.event == nullptr) continue;
+// NOTE: Since all events in a shard are on the same stream, no later
+// event will complete before an earlier event, except possibly if the
+// earlier event transitions to an error state, so there's no advantage in
+// looking past the first kPending event.  Each call therefore does an
+// expected constant amount of work, unaffected by the length of the
+// pending queue or by the number of other streams.
+void EventMgr::PollStream(StreamQueue* queue, ToFreeVector* to_free) {
+  int64 num_retired = 0;
+  while (!queue->used_events.empty()) {
+    InUse& iu = queue->used_events.front();
     se::Event::Status s = iu.event->PollForStatus();
-    switch (s) {
-      case se::Event::Status::kUnknown:
-      case se::Event::Status::kError:
-        // We don't expect to see these.  Someday maybe propagate
-        // a Status error, but for now fail hard.
-        LOG(FATAL) << "Unexpected Event status: " << static_cast<int>(s);
-        break;
-      case se::Event::Status::kPending:
-        if (!is_dedicated_poller) return;  // quit processing queue
-        break;
-      case se::Event::Status::kComplete:
-        // Make a copy of the InUse record so we can free it after releasing
-        // the lock
-        to_free->push_back(iu);
-        free_events_.push_back(iu.event);
-        // Mark this InUse record as completed.
-        iu.event = nullptr;
+    if (s == se::Event::Status::kPending) break;
+    if (s != se::Event::Status::kComplete) {
+      // We don't expect to see these.  Someday maybe propagate
+      // a Status error, but for now fail hard.
+      LOG(FATAL) << "Unexpected Event status: " << static_cast<int>(s);
     }
+    // Make a copy of the InUse record so we can free it after releasing
+    // the lock
+    to_free->push_back(iu);
+    queue->free_events.push_back(iu.event);
+    queue->used_events.pop_front();
+    ++num_retired;
   }
-  // Then clear any completed InUse records from the front of the queue.
-  while (!used_events_.empty()) {
-    InUse& iu = used_events_.front();
-    if (iu.event == nullptr) {
-      used_events_.pop_front();
-    } else {
-      break;
-    }
+  if (num_retired > 0) {
+    num_pending_.fetch_sub(num_retired, std::memory_order_acq_rel);
+  }
+}
+
+void EventMgr::PollEvents(ToFreeVector* to_free) {
+  tf_shared_lock l(mu_);
+  for (auto& entry : stream_queues_) {
+    StreamQueue* queue = entry.second.get();
+    mutex_lock ql(queue->mu);
+    PollStream(queue, to_free);
   }
 }
 
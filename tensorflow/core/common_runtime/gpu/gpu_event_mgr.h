@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_EVENT_MGR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_EVENT_MGR_H_
 
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -68,12 +71,15 @@ class EventMgr {
   // func must be brief and non-blocking since it executes in the one
   // thread used for all such callbacks and also buffer deletions.
   inline void ThenExecute(se::Stream* stream, std::function<void()> func) {
+    StreamQueue* queue = GetStreamQueue(stream);
     ToFreeVector to_free;
+    bool wake_poller;
     {
-      mutex_lock l(mu_);
-      QueueFunc(stream, std::move(func));
-      PollEvents(false, &to_free);
+      mutex_lock l(queue->mu);
+      wake_poller = QueueFunc(queue, stream, std::move(func));
+      PollStream(queue, &to_free);
     }
+    if (wake_poller) WakePollLoop();
     FreeMemory(to_free);
   }
 
@@ -91,6 +97,18 @@ class EventMgr {
     std::function<void()> func;
   };
 
+  // The pending events of a single stream.  Events recorded on one stream
+  // complete in the order they were enqueued, so a shard never needs to be
+  // polled past its first pending event.  Each shard has its own lock so
+  // that ThenExecute() calls on different streams do not contend.
+  struct StreamQueue {
+    mutex mu;
+    // A stack of unused events
+    std::vector<se::Event*> free_events TF_GUARDED_BY(mu);
+    // A FIFO queue of InUse events and associated callbacks.
+    std::deque<InUse> used_events TF_GUARDED_BY(mu);
+  };
+
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
 
   EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options);
@@ -102,24 +120,35 @@ class EventMgr {
     }
   }
 
+  // Returns the shard for "stream", creating it on first use.  Shards live
+  // as long as the EventMgr.
+  StreamQueue* GetStreamQueue(se::Stream* stream) TF_LOCKS_EXCLUDED(mu_);
+
   // Stream-enqueue an unused Event and save with it a collection of
   // Tensors and/or a BufRec to be deleted only after the Event
-  // records.
-  void QueueInUse(se::Stream* stream, InUse in_use)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
-
-  void QueueFunc(se::Stream* stream, std::function<void()> func)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    QueueInUse(stream, {nullptr, std::move(func)});
+  // records.  Returns true if no events were pending on any stream
+  // before this call, in which case the caller must call WakePollLoop()
+  // after releasing queue->mu.
+  bool QueueInUse(StreamQueue* queue, se::Stream* stream, InUse in_use)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(queue->mu);
+
+  bool QueueFunc(StreamQueue* queue, se::Stream* stream,
+                 std::function<void()> func)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(queue->mu) {
+    return QueueInUse(queue, stream, {nullptr, std::move(func)});
   }
 
-  // This function should be called at roughly the same tempo as
-  // QueueTensors() to check whether pending events have recorded,
-  // and then retire them.  It appends InUse elements that need cleanup
-  // to "*to_free".  The caller should call FreeMemory(to_free)
-  // when this returns.
-  void PollEvents(bool is_dedicated_poller, ToFreeVector* to_free)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Retires the completed events at the front of "queue", appending the
+  // InUse elements that need cleanup to "*to_free".  The caller should
+  // call FreeMemory(to_free) when this returns.
+  void PollStream(StreamQueue* queue, ToFreeVector* to_free)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(queue->mu);
+
+  // Calls PollStream() on every shard.
+  void PollEvents(ToFreeVector* to_free) TF_LOCKS_EXCLUDED(mu_);
+
+  // Wakes the polling loop if it is waiting for events to be queued.
+  void WakePollLoop() TF_LOCKS_EXCLUDED(mu_);
 
   // An internal polling loop that runs at a low frequency to clear
   // straggler Events.
@@ -129,11 +158,13 @@ class EventMgr {
   void StartPollingLoop();
   void StopPollingLoop();
 
-  // A stack of unused events
-  std::vector<se::Event*> free_events_ TF_GUARDED_BY(mu_);
+  // One shard per stream that has ever been passed to ThenExecute().
+  // Lock order: mu_ before StreamQueue::mu.
+  std::unordered_map<se::Stream*, std::unique_ptr<StreamQueue>> stream_queues_
+      TF_GUARDED_BY(mu_);
 
-  // A FIFO queue of InUse events and associated tensors.
-  std::deque<InUse> used_events_ TF_GUARDED_BY(mu_);
+  // The number of InUse records queued across all shards.
+  std::atomic<int64> num_pending_{0};
 
   bool stop_polling_ TF_GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
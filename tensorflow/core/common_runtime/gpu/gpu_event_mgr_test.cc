@@ -54,13 +54,28 @@ class TEST_EventMgrHelper {
   }
 
   size_t queue_size() {
-    mutex_lock l(em_->mu_);
-    return em_->used_events_.size();
+    tf_shared_lock l(em_->mu_);
+    size_t n = 0;
+    for (auto& entry : em_->stream_queues_) {
+      mutex_lock ql(entry.second->mu);
+      n += entry.second->used_events.size();
+    }
+    return n;
   }
 
   size_t free_size() {
-    mutex_lock l(em_->mu_);
-    return em_->free_events_.size();
+    tf_shared_lock l(em_->mu_);
+    size_t n = 0;
+    for (auto& entry : em_->stream_queues_) {
+      mutex_lock ql(entry.second->mu);
+      n += entry.second->free_events.size();
+    }
+    return n;
+  }
+
+  size_t num_stream_queues() {
+    tf_shared_lock l(em_->mu_);
+    return em_->stream_queues_.size();
   }
 
   void PollEvents() {
@@ -69,10 +84,7 @@ class TEST_EventMgrHelper {
       // should synchronously harvest all complete
       // events and execute the corresponding memory frees.
       EventMgr::ToFreeVector to_free;
-      {
-        mutex_lock l(em_->mu_);
-        em_->PollEvents(true, &to_free);
-      }
+      em_->PollEvents(&to_free);
       em_->FreeMemory(to_free);
     }
   }
@@ -138,6 +150,32 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// Tests that each stream gets its own shard and that polling retires the
+// events of every shard.
+TEST(EventMgr, StreamQueues) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  TEST_EventMgr em(stream_exec, GPUOptions());
+  TEST_EventMgrHelper th(&em);
+  std::unique_ptr<se::Stream> stream0(new se::Stream(stream_exec));
+  std::unique_ptr<se::Stream> stream1(new se::Stream(stream_exec));
+  stream0->Init();
+  stream1->Init();
+  std::atomic<int> counter(0);
+  for (int i = 0; i < 5; ++i) {
+    em.ThenExecute(stream0.get(), [&counter]() { counter.fetch_add(1); });
+    em.ThenExecute(stream1.get(), [&counter]() { counter.fetch_add(1); });
+  }
+  EXPECT_EQ(2, th.num_stream_queues());
+  TF_ASSERT_OK(stream0->BlockHostUntilDone());
+  TF_ASSERT_OK(stream1->BlockHostUntilDone());
+  th.PollEvents();
+  EXPECT_EQ(0, th.queue_size());
+  EXPECT_LE(2, th.free_size());
+  while (counter.load() < 10) {
+    Env::Default()->SleepForMicroseconds(1);
+  }
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
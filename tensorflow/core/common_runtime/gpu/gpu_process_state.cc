@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_cudamalloc_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_debug_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_host_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
@@ -93,7 +94,8 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
   AllocatorParts& allocator_parts = gpu_allocators_[tf_gpu_id.value()];
   if (allocator_parts.allocator == nullptr) {
     // Validate allocator types.
-    if (!allocator_type.empty() && allocator_type != "BFC") {
+    if (!allocator_type.empty() && allocator_type != "BFC" &&
+        allocator_type != "cuda_malloc_async") {
       LOG(ERROR) << "Invalid allocator type: " << allocator_type;
       return nullptr;
     }
@@ -105,21 +107,57 @@ Allocator* GPUProcessState::GetGPUAllocator(const GPUOptions& options,
     while (bus_id >= gpu_visitors_.size()) {
       gpu_visitors_.push_back({});
     }
-    GPUMemAllocator* sub_allocator = new GPUMemAllocator(
-        GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
-        platform_gpu_id,
-        (options.per_process_gpu_memory_fraction() > 1.0 ||
-         options.experimental().use_unified_memory()),
-        gpu_visitors_[bus_id], {});
-    GPUBFCAllocator* gpu_bfc_allocator =
-        new GPUBFCAllocator(sub_allocator, total_bytes, options,
-                            strings::StrCat("GPU_", tf_gpu_id.value(), "_bfc"));
-    Allocator* gpu_allocator = gpu_bfc_allocator;
+    if (allocator_type == "cuda_malloc_async") {
+      if (!GpuCudaMallocAsyncAllocator::IsSupported(platform_gpu_id)) {
+        LOG(ERROR) << "Allocator type cuda_malloc_async is not supported by "
+                      "this build or the driver of GPU "
+                   << platform_gpu_id.value();
+        return nullptr;
+      }
+      if (options.experimental().timestamped_allocator()) {
+        LOG(ERROR) << "Allocator type cuda_malloc_async does not support "
+                      "timestamped_allocator.";
+        return nullptr;
+      }
+    }
+
+    GPUMemAllocator* sub_allocator = nullptr;
+    GPUBFCAllocator* gpu_bfc_allocator = nullptr;
+    Allocator* gpu_allocator = nullptr;
+    if (allocator_type == "cuda_malloc_async") {
+      LOG(INFO) << "Using CUDA stream-ordered allocator for GPU.";
+      gpu_allocator =
+          new GpuCudaMallocAsyncAllocator(platform_gpu_id, total_bytes);
+    } else {
+      sub_allocator = new GPUMemAllocator(
+          GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+          platform_gpu_id,
+          (options.per_process_gpu_memory_fraction() > 1.0 ||
+           options.experimental().use_unified_memory()),
+          gpu_visitors_[bus_id], {});
+      gpu_bfc_allocator = new GPUBFCAllocator(
+          sub_allocator, total_bytes, options,
+          strings::StrCat("GPU_", tf_gpu_id.value(), "_bfc"));
+      gpu_allocator = gpu_bfc_allocator;
+    }
     SharedCounter* timing_counter = nullptr;
-    if (options.experimental().timestamped_allocator()) {
+    if (gpu_bfc_allocator != nullptr &&
+        options.experimental().timestamped_allocator()) {
       timing_counter = new SharedCounter;
       gpu_bfc_allocator->SetTimingCounter(timing_counter);
     }
+    if (gpu_bfc_allocator != nullptr) {
+      // Optionally serve small allocations from per-thread caches of freed
+      // chunks, see BFCAllocator::SetThreadCacheLimit(). The caches are
+      // bypassed while a timing counter is set.
+      int64 thread_cache_bytes = 0;
+      Status status = ReadInt64FromEnvVar("TF_GPU_BFC_THREAD_CACHE_BYTES", 0,
+                                          &thread_cache_bytes);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetGPUAllocator: " << status.error_message();
+      }
+      gpu_bfc_allocator->SetThreadCacheLimit(thread_cache_bytes);
+    }
 
     // If true, checks for memory overwrites by writing
     // distinctive patterns on both ends of allocated memory.
@@ -176,6 +214,11 @@ SharedCounter* GPUProcessState::GPUAllocatorCounter(TfGpuId tf_gpu_id) {
   }
 
   AllocatorParts& allocator_parts = gpu_allocators_[tf_gpu_id.value()];
+  if (allocator_parts.bfc_allocator == nullptr) {
+    LOG(ERROR) << "GPU allocator " << tf_gpu_id.value()
+               << " does not support timing counters";
+    return nullptr;
+  }
   if (allocator_parts.counter.get() == nullptr) {
     SharedCounter* timing_counter = new SharedCounter;
     allocator_parts.bfc_allocator->SetTimingCounter(timing_counter);
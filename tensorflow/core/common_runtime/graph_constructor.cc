@@ -23,6 +23,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/common_runtime/shape_refiner.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/node_properties.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/versions.h"
@@ -44,8 +46,11 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -208,6 +213,7 @@ class GraphConstructor {
   Status ValidateInputMapAndControlDependencies();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  Status PrepareNodes();
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -226,6 +232,7 @@ class GraphConstructor {
   Status IsNodeFullyMapped(const NodeDef& node_def, bool* is_node_mapped);
   Status ValidateColocationConstraints(const NodeDef& node_def);
   Status MakeNode(NodeDef&& node_def, Node** node);
+  Status MakePreparedNode(NodeDef&& node_def, int gdef_index, Node** node);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -266,6 +273,12 @@ class GraphConstructor {
   // already unique in the graph.
   string FindUniqueName(StringPiece original_name);
 
+  // Returns the i^th node in the graph, which has not been converted yet.
+  const NodeDef& get_unconverted_node_def(int i) const {
+    return prepared_nodes_.empty() ? get_node_def(i)
+                                   : prepared_nodes_[i].node_def;
+  }
+
   // Decrement pending count for users of `processed` and add the ones that now
   // have all of their pending inputs satisfied to `ready_`.
   void UpdatePendingCountAndReady(int processed, bool is_next_iteration);
@@ -347,6 +360,17 @@ class GraphConstructor {
   // (sorted) set so nodes are created in the order defined in the GraphDef.
   std::set<int> ready_;
 
+  // The nodes of a large graph, consumed and made ready to be added to g_ by
+  // PrepareNodes(), indexed like node_defs_. Empty if the nodes are prepared
+  // one by one in Convert() instead.
+  struct PreparedNode {
+    NodeDef node_def;
+    const OpRegistrationData* op_reg_data = nullptr;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+  };
+  std::vector<PreparedNode> prepared_nodes_;
+
   // Mapping between index within node_defs_ and the number of inputs that
   // still need to be converted.
   std::vector<int> pending_count_;
@@ -782,6 +806,21 @@ Status GraphConstructor::MakeNode(NodeDef&& node_def, Node** node) {
   return Status::OK();
 }
 
+Status GraphConstructor::MakePreparedNode(NodeDef&& node_def, int gdef_index,
+                                          Node** node) {
+  PreparedNode& prepared = prepared_nodes_[gdef_index];
+  *node = g_->AddNode(
+      std::make_shared<NodeProperties>(&prepared.op_reg_data->op_def,
+                                       std::move(node_def),
+                                       std::move(prepared.input_types),
+                                       std::move(prepared.output_types)),
+      *prepared.op_reg_data);
+  if (opts_.expect_device_spec) {
+    (*node)->set_assigned_device_name((*node)->def().device());
+  }
+  return Status::OK();
+}
+
 Status GraphConstructor::ValidateShape(Node* node) {
   if (!opts_.importing || !opts_.validate_shape) return Status::OK();
   TF_RETURN_IF_ERROR(refiner_->AddNode(node));
@@ -1070,7 +1109,7 @@ void GraphConstructor::DFS(int cur_node, std::vector<int>* cur_branch,
             std::find(cur_branch->begin(), cur_branch->end(), next_node);
         LOG(WARNING) << "Cycle detected:";
         while (iter != cur_branch->end()) {
-          LOG(WARNING) << SummarizeNodeDef(get_node_def(*iter));
+          LOG(WARNING) << SummarizeNodeDef(get_unconverted_node_def(*iter));
           ++iter;
         }
         LOG(WARNING) << "End of cycle";
@@ -1104,6 +1143,63 @@ void GraphConstructor::PrintCycles() {
   }
 }
 
+Status GraphConstructor::PrepareNodes() {
+  // Below this many nodes, starting the threads costs more than it saves.
+  constexpr int kMinNodesToPrepareInParallel = 4096;
+  const int num_nodes = node_def_count();
+  const int num_threads = port::MaxParallelism();
+  if (opts_.importing || num_nodes < kMinNodesToPrepareInParallel ||
+      num_threads < 2) {
+    return Status::OK();
+  }
+
+  // Look up each op once: graphs usually have few distinct op types, and the
+  // lookups take the op registry's lock.
+  prepared_nodes_.resize(num_nodes);
+  absl::flat_hash_map<string, const OpRegistrationData*> op_reg_data;
+  for (int i = 0; i < num_nodes; ++i) {
+    PreparedNode& prepared = prepared_nodes_[i];
+    prepared.node_def = consume_node_def(i);
+    auto it = op_reg_data.find(prepared.node_def.op());
+    if (it == op_reg_data.end()) {
+      const OpRegistrationData* data;
+      TF_RETURN_IF_ERROR(
+          g_->op_registry()->LookUp(prepared.node_def.op(), &data));
+      it = op_reg_data.emplace(prepared.node_def.op(), data).first;
+    }
+    prepared.op_reg_data = it->second;
+  }
+
+  // Adding default attributes, validating the nodes and inferring their types
+  // only reads the graph, so it is done in parallel.
+  std::vector<Status> statuses(num_nodes);
+  auto prepare = [&](int64 begin, int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      PreparedNode& prepared = prepared_nodes_[i];
+      const OpDef& op_def = prepared.op_reg_data->op_def;
+      if (opts_.add_default_attributes) {
+        AddDefaultsToNodeDef(op_def, &prepared.node_def);
+      }
+      if (opts_.validate_nodes) {
+        statuses[i] = ValidateNodeDef(prepared.node_def, op_def);
+        if (!statuses[i].ok()) continue;
+      }
+      statuses[i] = InOutTypesForNode(prepared.node_def, op_def,
+                                      &prepared.input_types,
+                                      &prepared.output_types);
+      if (!statuses[i].ok()) {
+        statuses[i] = AttachDef(statuses[i], prepared.node_def);
+      }
+    }
+  };
+  thread::ThreadPool pool(Env::Default(), "graph_constructor", num_threads);
+  pool.ParallelFor(num_nodes, /*cost_per_unit=*/10000, prepare);
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
 Status GraphConstructor::Convert() {
   // Import functions before adding nodes, since imported nodes may refer to
   // functions
@@ -1112,6 +1208,7 @@ Status GraphConstructor::Convert() {
     // avoid unnecessarily copying `*library()` here.
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library()));
   }
+  TF_RETURN_IF_ERROR(PrepareNodes());
 
   std::vector<InputInfo> inputs;
   int processed = 0;
@@ -1129,7 +1226,9 @@ Status GraphConstructor::Convert() {
     inputs.clear();
     bool has_data_back_edge = false;
 
-    NodeDef node_def = consume_node_def(o);
+    NodeDef node_def = prepared_nodes_.empty()
+                           ? consume_node_def(o)
+                           : std::move(prepared_nodes_[o].node_def);
 
     // input_already_exists[i] is true iff the i-th input of the node we're
     // importing refers to a preexisting node in g_ (i.e. input[i] existed prior
@@ -1230,7 +1329,7 @@ Status GraphConstructor::Convert() {
 
     if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
-    } else {
+    } else if (prepared_nodes_.empty()) {
       const OpDef* op_def;
       TF_RETURN_IF_ERROR(
           g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
@@ -1242,7 +1341,11 @@ Status GraphConstructor::Convert() {
       }
     }
 
-    TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    if (prepared_nodes_.empty()) {
+      TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    } else {
+      TF_RETURN_IF_ERROR(MakePreparedNode(std::move(node_def), o, &node));
+    }
 
     if (opts_.importing) {
       // Use interned original node name so StringPiece remains valid.
@@ -1286,7 +1389,8 @@ Status GraphConstructor::Convert() {
                  << " NODES IN A CYCLE";
     for (int64 i = 0; i < node_def_count(); i++) {
       if (pending_count_[i] != 0) {
-        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(get_node_def(i))
+        LOG(WARNING) << "PENDING: "
+                     << SummarizeNodeDef(get_unconverted_node_def(i))
                      << " WITH PENDING COUNT = " << pending_count_[i];
       }
     }
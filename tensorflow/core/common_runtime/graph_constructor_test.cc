@@ -923,6 +923,55 @@ TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
       {"Node 't2': Control dependencies must come after regular dependencies"});
 }
 
+// Returns a chain of `num_nodes` TestOneInputOneOutput nodes named n<i>, fed
+// by a TestParams node named n0, plus a TestDefaultAttr node named "default".
+GraphDef LargeChainGraphDef(int num_nodes) {
+  GraphDef gdef;
+  NodeDef* params = gdef.add_node();
+  params->set_name("n0");
+  params->set_op("TestParams");
+  for (int i = 1; i <= num_nodes; ++i) {
+    NodeDef* node = gdef.add_node();
+    node->set_name(strings::StrCat("n", i));
+    node->set_op("TestOneInputOneOutput");
+    node->add_input(strings::StrCat("n", i - 1));
+    AddNodeAttr("T", DT_FLOAT, node);
+  }
+  NodeDef* with_default = gdef.add_node();
+  with_default->set_name("default");
+  with_default->set_op("TestDefaultAttr");
+  return gdef;
+}
+
+TEST_F(GraphConstructorTest, LargeGraph) {
+  // Large enough for the nodes to be prepared in parallel.
+  const int kNumNodes = 5000;
+  GraphDef gdef = LargeChainGraphDef(kNumNodes);
+  TF_ASSERT_OK(ConvertGraphDefToGraph(GraphConstructorOptions(),
+                                      std::move(gdef), &graph_));
+  EXPECT_EQ(graph_.num_op_nodes(), kNumNodes + 2);
+  EXPECT_TRUE(HasEdge("n0", 0, "n1", 0));
+  EXPECT_TRUE(HasEdge("n4999", 0, "n5000", 0));
+  Node* last = FindNode("n5000");
+  ASSERT_NE(last, nullptr);
+  EXPECT_EQ(last->input_type(0), DT_FLOAT);
+  EXPECT_EQ(last->output_type(0), DT_FLOAT);
+  Node* with_default = FindNode("default");
+  ASSERT_NE(with_default, nullptr);
+  int value = 0;
+  TF_ASSERT_OK(GetNodeAttr(with_default->attrs(), "default_int", &value));
+  EXPECT_EQ(value, 31415);
+}
+
+TEST_F(GraphConstructorTest, LargeGraphWithInvalidNode) {
+  const int kNumNodes = 5000;
+  GraphDef gdef = LargeChainGraphDef(kNumNodes);
+  (*gdef.mutable_node(1234)->mutable_attr())["T"].set_type(DT_INT32);
+  Status s = ConvertGraphDefToGraph(GraphConstructorOptions(), gdef, &graph_);
+  EXPECT_FALSE(s.ok());
+  EXPECT_TRUE(str_util::StrContains(s.error_message(), "n1234")) << s;
+}
+
 TEST_F(GraphConstructorTest, ImportGraphDef) {
   GraphDef def;
   ImportGraphDefOptions opts;
@@ -109,6 +109,11 @@ struct NodeItem {
   // is true if and only if the ith output is consumed by another node.
   std::unique_ptr<bool[]> outputs_required;
 
+  // If non-null, contains an array of num_outputs ints, where the ith int is
+  // the index of the _Retval node that is the only consumer of the ith output,
+  // or -1. See OpKernelContext::Params::output_retval_array.
+  std::unique_ptr<int[]> output_retval_index;
+
   gtl::MutableArraySlice<EdgeInfo> mutable_output_edges() {
     return gtl::MutableArraySlice<EdgeInfo>(output_edge_base(),
                                             num_output_edges);
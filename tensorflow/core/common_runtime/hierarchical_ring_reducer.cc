@@ -0,0 +1,380 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// Key to be used for BufRendezvous by HierarchicalRingReducer.
+string HierarchicalReduceBufKey(const string& exec_key, int phase, int step,
+                                int src_rank) {
+  return strings::StrCat(exec_key, ":h", phase, ":", step, ":", src_rank);
+}
+
+int Mod(int a, int n) { return ((a % n) + n) % n; }
+
+}  // namespace
+
+HierarchicalRingReducer::HierarchicalRingReducer()
+    : col_ctx_(nullptr), col_params_(nullptr), chunk_elts_(0), total_elts_(0) {}
+
+Status HierarchicalRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
+  CHECK_EQ(col_params->instance.impl_details.collective_name,
+           "HierarchicalRingReduce");
+  // Precondition: device_names must be sorted so that all devices in
+  // the same task are adjacent.
+  const std::vector<string>& task_names = col_params->instance.task_names;
+  const int group_size = col_params->group.group_size;
+  if (static_cast<int>(task_names.size()) != group_size) {
+    return errors::Internal("Expected ", group_size, " task names, got ",
+                            task_names.size());
+  }
+  int num_tasks = 1;
+  int devices_per_task = 0;
+  for (int di = 0; di < group_size; ++di) {
+    if (di > 0 && task_names[di] != task_names[di - 1]) {
+      ++num_tasks;
+      // Devices of the first task set the expected count.
+      if (devices_per_task == 0) devices_per_task = di;
+    }
+  }
+  if (devices_per_task == 0) devices_per_task = group_size;
+  if (num_tasks * devices_per_task != group_size) {
+    return errors::InvalidArgument(
+        "HierarchicalRingReduce requires the same number of devices in every "
+        "task, got ",
+        group_size, " devices in ", num_tasks, " tasks");
+  }
+  for (int di = 0; di < group_size; ++di) {
+    if (task_names[di] !=
+        task_names[(di / devices_per_task) * devices_per_task]) {
+      return errors::InvalidArgument(
+          "HierarchicalRingReduce requires the same number of devices in "
+          "every task, but task ",
+          task_names[di], " has a different count");
+    }
+  }
+  col_params->group.num_tasks = num_tasks;
+  VLOG(2) << "HierarchicalRingReducer::InitializeCollectiveParams device="
+          << col_params->instance.device_names[col_params->default_rank]
+          << " num_tasks=" << num_tasks
+          << " devices_per_task=" << devices_per_task;
+  return Status::OK();
+}
+
+Status HierarchicalRingReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  CHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like `RingReducer`, this collective doesn't require non-overlapping
+  // collectives, so unblock any collective that is blocked on this instance.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  Status s = RunAllReduce();
+  if (!s.ok()) {
+    // Cancel the pending transfers of the other devices of the group.  This
+    // may repeat an abort started in SendRecv, which is harmless.
+    col_ctx_->col_exec->StartAbort(s);
+  }
+  if (ca_) ca_->ConsumeFinalValue(col_ctx_->output);
+  VLOG(2) << "device=" << col_ctx_->device_name << " return status " << s;
+  done(s);
+}
+
+Status HierarchicalRingReducer::RunAllReduce() {
+  const int group_size = col_params_->group.group_size;
+  const int num_tasks = col_params_->group.num_tasks;
+  const int devices_per_task = group_size / num_tasks;
+  const int rank = col_params_->default_rank;
+  const int task_rank = rank / devices_per_task;
+  const int local_rank = rank % devices_per_task;
+
+  // The devices of this task, and the devices at the same position in every
+  // task.
+  std::vector<int> local_ring;
+  for (int di = 0; di < devices_per_task; ++di) {
+    local_ring.push_back(task_rank * devices_per_task + di);
+  }
+  std::vector<int> cross_ring;
+  for (int ti = 0; ti < num_tasks; ++ti) {
+    cross_ring.push_back(ti * devices_per_task + local_rank);
+  }
+  VLOG(1) << "HierarchicalRingReducer::Run for device "
+          << col_ctx_->device_name << " default_rank " << rank << " task "
+          << task_rank << " local_rank " << local_rank;
+
+  TF_RETURN_IF_ERROR(CopyInputToOutput());
+
+  // Segment i of the local phases is made of chunks [i * T, (i + 1) * T),
+  // each of which is reduced by one cross-task ring.
+  const int L = devices_per_task;
+  const int T = num_tasks;
+  total_elts_ = col_ctx_->output->NumElements();
+  chunk_elts_ = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(col_ctx_->output->dtype()), total_elts_, L * T);
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, L * T,
+                                  col_ctx_->device->GetAllocator(attr)));
+  if (col_params_->final_op) {
+    TF_RETURN_IF_ERROR(InitGroupSizeTensor());
+  }
+
+  // The segment this device reduces in the cross-task phases.
+  const int own_segment = Mod(local_rank + 1, L);
+  const int own_chunk = Mod(task_rank + 1, T);
+
+  // Allocate all receive buffers up front so that one wait makes them valid.
+  std::vector<Tensor> local_tmp;
+  for (int step = 0; step < L - 1; ++step) {
+    local_tmp.push_back(TempSegment(Mod(local_rank - step - 1, L) * T, T));
+  }
+  std::vector<Tensor> cross_tmp;
+  for (int step = 0; step < T - 1; ++step) {
+    cross_tmp.push_back(
+        TempSegment(own_segment * T + Mod(task_rank - step - 1, T), 1));
+  }
+  TF_RETURN_IF_ERROR(WaitForQueuedEvents());
+
+  // Phase 1: reduce-scatter within the task.
+  {
+    profiler::TraceMe activity("LocalReduceScatter",
+                               profiler::TraceMeLevel::kInfo);
+    for (int step = 0; step < L - 1; ++step) {
+      Tensor send = Segment(Mod(local_rank - step, L) * T, T);
+      Tensor dst = Segment(Mod(local_rank - step - 1, L) * T, T);
+      TF_RETURN_IF_ERROR(SendRecv(kLocalReduceScatter, step, local_ring,
+                                  local_rank, send, &local_tmp[step]));
+      TF_RETURN_IF_ERROR(Merge(&dst, &local_tmp[step]));
+    }
+  }
+
+  // Phase 2: all-reduce of the own segment between the tasks.
+  {
+    profiler::TraceMe activity("CrossTaskAllReduce",
+                               profiler::TraceMeLevel::kInfo);
+    const int base = own_segment * T;
+    for (int step = 0; step < T - 1; ++step) {
+      Tensor send = Segment(base + Mod(task_rank - step, T), 1);
+      Tensor dst = Segment(base + Mod(task_rank - step - 1, T), 1);
+      TF_RETURN_IF_ERROR(SendRecv(kCrossTaskReduceScatter, step, cross_ring,
+                                  task_rank, send, &cross_tmp[step]));
+      TF_RETURN_IF_ERROR(Merge(&dst, &cross_tmp[step]));
+    }
+    if (col_params_->final_op) {
+      Tensor reduced = Segment(base + own_chunk, 1);
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->final_op.get(), &reduced, &group_size_tensor_));
+    }
+    for (int step = 0; step < T - 1; ++step) {
+      Tensor send = Segment(base + Mod(task_rank + 1 - step, T), 1);
+      Tensor dst = Segment(base + Mod(task_rank - step, T), 1);
+      TF_RETURN_IF_ERROR(SendRecv(kCrossTaskAllGather, step, cross_ring,
+                                  task_rank, send, &dst));
+    }
+  }
+
+  // Phase 3: all-gather within the task.
+  {
+    profiler::TraceMe activity("LocalAllGather",
+                               profiler::TraceMeLevel::kInfo);
+    for (int step = 0; step < L - 1; ++step) {
+      Tensor send = Segment(Mod(local_rank + 1 - step, L) * T, T);
+      Tensor dst = Segment(Mod(local_rank - step, L) * T, T);
+      TF_RETURN_IF_ERROR(
+          SendRecv(kLocalAllGather, step, local_ring, local_rank, send, &dst));
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalRingReducer::CopyInputToOutput() {
+  if ((col_ctx_->input == col_ctx_->output) ||
+      (DMAHelper::base(col_ctx_->input) == DMAHelper::base(col_ctx_->output))) {
+    return Status::OK();
+  }
+  Notification note;
+  Status status;
+  profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+  CollectiveRemoteAccessLocal::MemCpyAsync(
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+      col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+      col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+      col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+      [&note, &status](const Status& s) {
+        status.Update(s);
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
+Status HierarchicalRingReducer::InitGroupSizeTensor() {
+  Tensor group_size_val = ca_->Scalar(col_params_->group.group_size);
+  if (col_params_->group.device_type == "CPU") {
+    group_size_tensor_ = group_size_val;
+    return Status::OK();
+  }
+  group_size_tensor_ = ca_->Scalar(
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+      AllocationAttributes());
+  Notification note;
+  Status status;
+  col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+      &group_size_val, col_ctx_->device, &group_size_tensor_,
+      [&note, &status](const Status& s) {
+        status.Update(s);
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
+Status HierarchicalRingReducer::WaitForQueuedEvents() {
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      col_ctx_->device->tensorflow_gpu_device_info();
+  if (!gpu_info) return Status::OK();
+  profiler::TraceMe activity("WaitForQueuedEvents",
+                             profiler::TraceMeLevel::kInfo);
+  Notification note;
+  Status s = gpu_info->default_context->ThenExecute(
+      col_ctx_->device, gpu_info->stream, [&note]() { note.Notify(); });
+  if (!s.ok()) {
+    return errors::Internal(
+        "Failed to dispatch ThenExecute in HierarchicalRingReducer");
+  }
+  note.WaitForNotification();
+  return Status::OK();
+}
+
+Tensor HierarchicalRingReducer::Segment(int first_chunk, int num_chunks) const {
+  const int64 start = std::min(total_elts_, first_chunk * chunk_elts_);
+  const int64 end = std::min(total_elts_, start + num_chunks * chunk_elts_);
+  // Like CollectiveAdapter::ChunkAlias, take empty slices from the front of
+  // the tensor to avoid an illegal offset.
+  return (end > start) ? ca_->Value().Slice(start, end)
+                       : ca_->Value().Slice(0, 0);
+}
+
+Tensor HierarchicalRingReducer::TempSegment(int first_chunk,
+                                            int num_chunks) const {
+  const Tensor segment = Segment(first_chunk, num_chunks);
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  return Tensor(col_ctx_->device->GetAllocator(attr), segment.dtype(),
+                segment.shape());
+}
+
+Status HierarchicalRingReducer::SendRecv(Phase phase, int step,
+                                         const std::vector<int>& ring,
+                                         int ring_rank, const Tensor& send,
+                                         Tensor* recv) {
+  const int ring_size = static_cast<int>(ring.size());
+  const int dst_idx = ring[Mod(ring_rank + 1, ring_size)];
+  const int src_idx = ring[Mod(ring_rank - 1, ring_size)];
+  const int my_idx = ring[ring_rank];
+  VLOG(3) << "SendRecv device=" << col_ctx_->device_name << " phase=" << phase
+          << " step=" << step << " dst_idx=" << dst_idx
+          << " src_idx=" << src_idx;
+
+  mutex mu;
+  condition_variable cv;
+  Status status;
+  int pending = 2;
+  auto on_done = [&mu, &cv, &status, &pending](const Status& s) {
+    mutex_lock l(mu);
+    status.Update(s);
+    --pending;
+    cv.notify_all();
+  };
+  col_ctx_->col_exec->remote_access()->PostToPeer(
+      col_params_->instance.device_names[dst_idx],
+      col_params_->instance.task_names[dst_idx],
+      HierarchicalReduceBufKey(col_ctx_->exec_key, phase, step, my_idx),
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), &send,
+      col_ctx_->device_locality, on_done);
+  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+      col_params_->instance.device_names[src_idx],
+      col_params_->instance.task_names[src_idx],
+      col_params_->task.is_local[src_idx],
+      HierarchicalReduceBufKey(col_ctx_->exec_key, phase, step, src_idx),
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), recv, col_ctx_->device_locality,
+      0 /*dev_to_dev_stream_index*/, on_done);
+
+  Status abort_status;
+  {
+    mutex_lock l(mu);
+    while (pending > 0 && status.ok()) cv.wait(l);
+    if (pending > 0) abort_status = status;
+  }
+  if (!abort_status.ok()) {
+    // One transfer failed while the other may wait for a peer that will never
+    // show up.  Abort to cancel it, then wait for its callback since both
+    // reference this frame.
+    col_ctx_->col_exec->StartAbort(abort_status);
+  }
+  mutex_lock l(mu);
+  while (pending > 0) cv.wait(l);
+  return status;
+}
+
+Status HierarchicalRingReducer::Merge(Tensor* output, Tensor* input) {
+  return collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                       col_ctx_->device,
+                                       col_params_->merge_op.get(), output,
+                                       input);
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalRingReduce, HierarchicalRingReducer);
+}  // namespace
+
+}  // namespace tensorflow
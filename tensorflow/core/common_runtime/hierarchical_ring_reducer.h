@@ -0,0 +1,113 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Hierarchical ring-algorithm implementation of collective all-reduce.
+//
+// With T tasks of L devices each, the tensor is split into L segments of T
+// chunks.  The all-reduce runs in three phases:
+//   1. a ring reduce-scatter between the devices of each task, after which
+//      every device holds one segment reduced across its task;
+//   2. a ring all-reduce of that segment between the T devices that have the
+//      same position in their task;
+//   3. a ring all-gather between the devices of each task.
+// Every device sends 2(L-1)/L of the tensor over intra-task links but only
+// 2(T-1)/(LT) of it over inter-task links, against 2(LT-1)/(LT) over the
+// slowest link of a flat ring.
+//
+// Selected by setting the `communication_hint` of a reduction to
+// "hierarchical".  All tasks must contribute the same number of devices.
+class HierarchicalRingReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalRingReducer();
+  ~HierarchicalRingReducer() override = default;
+
+  // Checks that the devices are evenly divided between the tasks.  The rings
+  // are derived from the default ranks, which are sorted by task.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // No-op for hierarchical ring reducer.
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Begins execution of the hierarchical all-reduce.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Phases of the algorithm, used to tell apart their buffer keys.
+  enum Phase {
+    kLocalReduceScatter = 0,
+    kCrossTaskReduceScatter = 1,
+    kCrossTaskAllGather = 2,
+    kLocalAllGather = 3,
+  };
+
+  // Runs all three phases, blocking until they are complete.
+  Status RunAllReduce();
+
+  // Copies the input to the output, unless the reduction is in place.
+  Status CopyInputToOutput();
+
+  // Prepares group_size_tensor_ on the device for the final op.
+  Status InitGroupSizeTensor();
+
+  // Blocks until the work queued on the compute stream of a GPU device is
+  // done, so that freshly allocated buffers are valid.
+  Status WaitForQueuedEvents();
+
+  // Returns an alias of `num_chunks` consecutive chunks of the output,
+  // starting at `first_chunk`.
+  Tensor Segment(int first_chunk, int num_chunks) const;
+
+  // Returns a temporary buffer with room for `num_chunks` consecutive chunks
+  // starting at `first_chunk`.
+  Tensor TempSegment(int first_chunk, int num_chunks) const;
+
+  // Sends `send` to the successor of `ring_rank` in `ring` and concurrently
+  // receives the predecessor's data into `recv`.  Blocks until both are done.
+  // `ring` holds the default ranks of its members.
+  Status SendRecv(Phase phase, int step, const std::vector<int>& ring,
+                  int ring_rank, const Tensor& send, Tensor* recv);
+
+  // Reduces `input` into `output` with the merge op.
+  Status Merge(Tensor* output, Tensor* input);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  int64 chunk_elts_;
+  int64 total_elts_;
+  Tensor group_size_tensor_;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
@@ -0,0 +1,407 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <atomic>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/unbounded_work_queue.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+// Wraps CollectiveRemoteAccessLocal with the ability to return an
+// error status to the N'th action.
+class FailTestRMA : public CollectiveRemoteAccessLocal {
+ public:
+  FailTestRMA(const DeviceMgr* dev_mgr, DeviceResolverInterface* dev_resolver,
+              int64 step_id, int fail_after)
+      : CollectiveRemoteAccessLocal(dev_mgr, dev_resolver, step_id),
+        fail_after_(fail_after) {}
+
+  bool MaybeFail(const StatusCallback& done) {
+    bool fail_now = false;
+    {
+      mutex_lock l(mu_);
+      if (fail_after_ > 0) {
+        fail_now = (--fail_after_ == 0);
+      }
+    }
+    if (fail_now) {
+      done(errors::Internal("Deliberate failure"));
+      return true;
+    }
+    return false;
+  }
+
+  void RecvFromPeer(const string& peer_device, const string& peer_task,
+                    bool peer_is_local, const string& key, Device* to_device,
+                    DeviceContext* to_device_ctx,
+                    const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+                    const DeviceLocality& client_locality,
+                    int dev_to_dev_stream_index,
+                    const StatusCallback& done) override {
+    if (MaybeFail(done)) return;
+    CollectiveRemoteAccessLocal::RecvFromPeer(
+        peer_device, peer_task, peer_is_local, key, to_device, to_device_ctx,
+        to_alloc_attr, to_tensor, client_locality, dev_to_dev_stream_index,
+        done);
+  }
+
+  void PostToPeer(const string& peer_device, const string& peer_task,
+                  const string& key, Device* from_device,
+                  DeviceContext* from_device_ctx,
+                  const AllocatorAttributes& from_alloc_attr,
+                  const Tensor* from_tensor,
+                  const DeviceLocality& client_locality,
+                  const StatusCallback& done) override {
+    if (MaybeFail(done)) return;
+    CollectiveRemoteAccessLocal::PostToPeer(
+        peer_device, peer_task, key, from_device, from_device_ctx,
+        from_alloc_attr, from_tensor, client_locality, done);
+  }
+
+  mutex mu_;
+  int fail_after_ TF_GUARDED_BY(mu_);
+};
+
+std::unique_ptr<OpKernel> GetKernel(const NodeDef& node,
+                                    const DeviceType& device_type,
+                                    DeviceBase* device) {
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      device_type, device, device->GetAllocator(AllocatorAttributes()), node,
+      TF_GRAPH_DEF_VERSION, &status);
+  if (!status.ok()) {
+    LOG(FATAL) << status;
+  }
+  return k;
+}
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   const DeviceType& device_type,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op, "_node"), op);
+  TF_CHECK_OK(builder.Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  return GetKernel(node_def, device_type, device);
+}
+
+static int64 kStepId = 123;
+
+CollectiveParams SetUpCollectiveParams(const std::vector<int>& devs_per_task) {
+  CollectiveParams cp;
+  cp.group.group_key = 1;
+  cp.group.device_type = DeviceType("GPU");
+  cp.group.num_tasks = devs_per_task.size();
+  cp.instance.instance_key = 3;
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DataType(DT_FLOAT);
+  cp.instance.impl_details.collective_name = "HierarchicalRingReduce";
+  for (int ti = 0; ti < devs_per_task.size(); ++ti) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", ti);
+    for (int di = 0; di < devs_per_task[ti]; ++di) {
+      cp.instance.task_names.push_back(task_name);
+      cp.instance.device_names.push_back(
+          strings::StrCat(task_name, "/device:GPU:", di));
+    }
+  }
+  cp.group.group_size = cp.instance.device_names.size();
+  cp.instance.shape = TensorShape({cp.group.group_size});
+  cp.default_rank = 0;
+  return cp;
+}
+
+TEST(HierarchicalRingReducerParamsTest, UniformTasks) {
+  CollectiveParams cp = SetUpCollectiveParams({4, 4, 4});
+  HierarchicalRingReducer* reducer = new HierarchicalRingReducer;
+  core::ScopedUnref unref(reducer);
+  TF_EXPECT_OK(reducer->InitializeCollectiveParams(&cp));
+  EXPECT_EQ(3, cp.group.num_tasks);
+}
+
+TEST(HierarchicalRingReducerParamsTest, NonUniformTasks) {
+  HierarchicalRingReducer* reducer = new HierarchicalRingReducer;
+  core::ScopedUnref unref(reducer);
+  for (const auto& devs_per_task :
+       std::vector<std::vector<int>>{{2, 1, 3}, {2, 2, 3}, {3, 1}}) {
+    CollectiveParams cp = SetUpCollectiveParams(devs_per_task);
+    Status s = reducer->InitializeCollectiveParams(&cp);
+    EXPECT_EQ(error::INVALID_ARGUMENT, s.code()) << s;
+  }
+}
+
+class HierarchicalRingReducerTest : public ::testing::Test {
+ protected:
+  ~HierarchicalRingReducerTest() override {
+    stop_ = true;
+    for (auto i : instances_) delete i;
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(int num_workers, int num_devices, DataType dtype, int fail_after) {
+    std::vector<std::unique_ptr<Device>> local_devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    Bytes mem_limit(4 << 20);
+    DeviceLocality dev_locality;
+    for (int wi = 0; wi < num_workers; ++wi) {
+      for (int di = 0; di < num_devices; ++di) {
+        string dev_name =
+            strings::StrCat("/job:worker/replica:0/task:", wi, "/cpu:", di);
+        local_devices.push_back(absl::make_unique<ThreadPoolDevice>(
+            sess_opts, dev_name, mem_limit, dev_locality, cpu_allocator()));
+      }
+    }
+    dev_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(local_devices));
+    gpu_ring_order_ = absl::make_unique<string>();
+    dev_resolver_ = absl::make_unique<DeviceResolverLocal>(dev_mgr_.get());
+    work_queue_ = std::make_shared<UnboundedWorkQueue>(Env::Default(), "test");
+    rma_ = new FailTestRMA(dev_mgr_.get(), dev_resolver_.get(), kStepId,
+                           fail_after);
+    col_exec_ = new BaseCollectiveExecutor(&col_exec_mgr_, rma_, kStepId,
+                                           dev_mgr_.get(),
+                                           gpu_ring_order_.get(), work_queue_);
+    col_params_.name = "test_collective";
+    col_params_.group.group_key = 5;
+    col_params_.group.device_type = DEVICE_CPU;
+    col_params_.group.group_size = num_workers * num_devices;
+    col_params_.group.num_tasks = num_workers;
+    col_params_.instance.instance_key = 17;
+    col_params_.instance.type = REDUCTION_COLLECTIVE;
+    col_params_.instance.impl_details.collective_name =
+        "HierarchicalRingReduce";
+    col_params_.instance.data_type = dtype;
+    for (int wi = 0; wi < num_workers; ++wi) {
+      string task_name = strings::StrCat("/job:worker/replica:0/task:", wi);
+      col_params_.instance.num_devices_per_task[task_name] = num_devices;
+      for (int di = 0; di < num_devices; ++di) {
+        col_params_.instance.device_names.push_back(
+            strings::StrCat(task_name, "/cpu:", di));
+        col_params_.instance.task_names.push_back(task_name);
+        // Normally each device would set is_local to its own perspective but
+        // this test runs in a single process so is_local is always true.
+        col_params_.task.is_local.push_back(true);
+      }
+    }
+    for (int rank = 0; rank < col_params_.group.group_size; ++rank) {
+      instances_.push_back(new DeviceInstance(rank, this));
+    }
+  }
+
+  void Reduce(int fail_after) {
+    std::atomic<int> done(0);
+    for (auto di : instances_) {
+      SchedClosure([di, &done] {
+        di->DoReduce();
+        ++done;
+      });
+      if (fail_after > 0) {
+        // Stagger the op execution starts.
+        Env::Default()->SleepForMicroseconds(100);
+      }
+    }
+    while (done < static_cast<int>(instances_.size())) {
+      if (stop_) break;
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+  }
+
+  template <typename T>
+  void RunTest(DataType dtype, int num_workers, int num_devices,
+               int tensor_len, int fail_after) {
+    Init(num_workers, num_devices, dtype, fail_after);
+    std::vector<T> expected(tensor_len, 0);
+    for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+      Tensor* t = &instances_[di]->tensor_;
+      *t = Tensor(dtype, TensorShape({tensor_len}));
+      for (int i = 0; i < tensor_len; ++i) {
+        T value = static_cast<T>(di * 10 + i);
+        t->flat<T>()(i) = value;
+        expected[i] += value;
+      }
+    }
+    Reduce(fail_after);
+    if (fail_after > 0) {
+      // Confirm that every device terminated with the expected error status.
+      for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+        EXPECT_NE(
+            instances_[di]->status_.error_message().find("Deliberate failure"),
+            string::npos);
+      }
+      return;
+    }
+    // Confirm that every device computed the same correct reduction value.
+    const int group_size = num_workers * num_devices;
+    for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
+      TF_EXPECT_OK(instances_[di]->status_);
+      auto actual = instances_[di]->tensor_.template flat<T>();
+      for (int i = 0; i < tensor_len; ++i) {
+        EXPECT_EQ(expected[i] / static_cast<T>(group_size), actual(i))
+            << "Mismatch at device " << di << " index " << i;
+      }
+    }
+  }
+
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, HierarchicalRingReducerTest* parent)
+        : parent_(parent) {
+      col_params_.name = parent_->col_params_.name;
+      col_params_.group = parent_->col_params_.group;
+      col_params_.instance = parent_->col_params_.instance;
+      col_params_.task.is_local = parent_->col_params_.task.is_local;
+      col_params_.default_rank = rank;
+      dev_name_ = col_params_.instance.device_names[rank];
+      TF_CHECK_OK(parent_->dev_mgr_->LookupDevice(dev_name_, &device_))
+          << "Couldn't find device " << dev_name_;
+    }
+
+    void DoReduce() {
+      const DataType dtype = col_params_.instance.data_type;
+      col_params_.merge_op = GetBinOp("Add", dtype, DEVICE_CPU, device_);
+      col_params_.final_op = GetBinOp("Div", dtype, DEVICE_CPU, device_);
+
+      // Prepare an OpKernelContext.
+      OpKernelContext::Params op_params;
+      op_params.step_id = kStepId;
+      op_params.device = device_;
+      gtl::InlinedVector<TensorValue, 4> inputs;
+      inputs.push_back(TensorValue(&tensor_));
+      op_params.inputs = &inputs;
+      gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+          {AllocatorAttributes()});
+      op_params.input_alloc_attrs = &input_aa;
+      DeviceContext* dev_ctx = new DeviceContext;
+      op_params.op_device_context = dev_ctx;
+      int forward_from = 0;
+      op_params.forward_from_array = &forward_from;
+      AllocatorAttributes generic_alloc_attr;
+      op_params.output_attr_array = &generic_alloc_attr;
+      NodeDef node_def;
+      TF_CHECK_OK(NodeDefBuilder(strings::StrCat("collective_reduce_",
+                                                 col_params_.default_rank),
+                                 "CollectiveReduce")
+                      .Attr("T", dtype)
+                      .Attr("merge_op", "Add")
+                      .Attr("final_op", "Div")
+                      .Attr("group_size", col_params_.group.group_size)
+                      .Attr("group_key", col_params_.group.group_key)
+                      .Attr("instance_key", col_params_.instance.instance_key)
+                      .Attr("subdiv_offsets", std::vector<int>())
+                      .Attr("communication_hint", "hierarchical")
+                      .Input(FakeInput(dtype))
+                      .Finalize(&node_def));
+      std::unique_ptr<OpKernel> op = GetKernel(node_def, DEVICE_CPU, device_);
+      op_params.op_kernel = op.get();
+      OpKernelContext ctx(&op_params, 1);
+
+      // We never actually execute the kernel, so we need to do the output
+      // allocation it would do, ourselves.
+      Tensor* output_tensor_ptr = nullptr;
+      TF_CHECK_OK(ctx.forward_input_or_allocate_output({0}, 0, tensor_.shape(),
+                                                       &output_tensor_ptr));
+      CHECK_EQ(output_tensor_ptr, ctx.mutable_output(0));
+
+      string exec_key =
+          strings::StrCat(col_params_.instance.instance_key, ":0:0");
+      HierarchicalRingReducer* reducer = new HierarchicalRingReducer;
+      core::ScopedUnref unref(reducer);
+      auto col_ctx = std::make_shared<CollectiveContext>(
+          parent_->col_exec_, parent_->dev_mgr_.get(), &ctx, &op_params,
+          col_params_, exec_key, kStepId, &tensor_, &tensor_);
+      TF_CHECK_OK(reducer->InitializeCollectiveContext(col_ctx));
+
+      // Run the all-reduce.
+      reducer->Run([this](Status s) { status_ = s; });
+      if (status_.ok()) {
+        CHECK(tensor_.CopyFrom(*ctx.mutable_output(0), tensor_.shape()));
+      }
+
+      dev_ctx->Unref();
+    }
+
+    HierarchicalRingReducerTest* parent_;
+    string dev_name_;
+    Tensor tensor_;
+    Device* device_;
+    CollectiveParams col_params_;
+    Status status_;
+  };
+
+  bool stop_ = false;
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  CollectiveRemoteAccessLocal* rma_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  std::vector<DeviceInstance*> instances_;
+  CollectiveParams col_params_;
+  std::unique_ptr<tensorflow::DeviceMgr> dev_mgr_;
+  std::unique_ptr<string> gpu_ring_order_;
+};
+
+#define DEF_TEST(B, W, D, L, A)                                              \
+  TEST_F(HierarchicalRingReducerTest,                                        \
+         DaTy##B##_Wkr##W##_Dev##D##_Len##L##_Abrt##A) {                     \
+    DataType dtype = DT_##B;                                                 \
+    switch (dtype) {                                                         \
+      case DT_FLOAT: {                                                       \
+        RunTest<float>(dtype, W, D, L, A);                                   \
+      } break;                                                               \
+      case DT_INT64: {                                                       \
+        RunTest<int64>(dtype, W, D, L, A);                                   \
+      } break;                                                               \
+      default:                                                               \
+        LOG(FATAL) << "Unimplemented";                                       \
+    }                                                                        \
+  }
+
+// Group sizes are powers of two so that the float mean is exact.
+DEF_TEST(FLOAT, 1, 1, 7, 0)
+DEF_TEST(FLOAT, 1, 4, 1001, 0)
+DEF_TEST(FLOAT, 4, 1, 1001, 0)
+DEF_TEST(FLOAT, 2, 2, 1, 0)
+DEF_TEST(FLOAT, 2, 4, 3, 0)
+DEF_TEST(FLOAT, 2, 4, 4096, 0)
+DEF_TEST(FLOAT, 4, 4, 9409, 0)
+DEF_TEST(INT64, 2, 8, 4095, 0)
+// Failure tests
+DEF_TEST(FLOAT, 2, 4, 4096, 1)
+DEF_TEST(FLOAT, 2, 4, 4096, 9)
+
+}  // namespace
+}  // namespace tensorflow
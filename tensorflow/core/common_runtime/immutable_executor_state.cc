@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "absl/memory/memory.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -238,6 +242,35 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
       }
       item->outputs_required = std::move(outputs_required);
     }
+
+    // Outputs that only feed a _Retval may be allocated in a buffer provided
+    // by the caller of the step, if they are produced once per step in host
+    // memory.
+    if (frame_name.empty() && params_.device->device_type() == DEVICE_CPU &&
+        std::any_of(n->out_edges().begin(), n->out_edges().end(),
+                    [](const Edge* e) {
+                      return !e->IsControlEdge() && e->dst()->IsRetval();
+                    })) {
+      std::unique_ptr<int[]> output_retval_index(new int[n->num_outputs()]);
+      std::fill(&output_retval_index[0], &output_retval_index[n->num_outputs()],
+                -1);
+      std::vector<int> num_consumers(n->num_outputs(), 0);
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge()) continue;
+        const int output = e->src_output();
+        ++num_consumers[output];
+        if (e->dst()->IsRetval()) {
+          TF_RETURN_IF_ERROR(GetNodeAttr(e->dst()->attrs(), "index",
+                                         &output_retval_index[output]));
+        }
+      }
+      for (int i = 0; i < n->num_outputs(); ++i) {
+        if (num_consumers[i] != 1 || IsRefType(n->output_type(i))) {
+          output_retval_index[i] = -1;
+        }
+      }
+      item->output_retval_index = std::move(output_retval_index);
+    }
   }
 
   // Rewrite each `EdgeInfo::input_slot` member to refer directly to the input
@@ -128,13 +128,6 @@ Status InspectingPlacer::ComputeIOColocationGroups(const Node& node,
   const FunctionDef* fdef;
   NameAttrList func;
   TF_RETURN_IF_ERROR(GetFunctionDefAndAttrs(flib_def_, node, &fdef, &func));
-  std::unique_ptr<FunctionBody> fbody;
-
-  TF_RETURN_IF_ERROR(FunctionDefToBodyHelper(*fdef, AttrSlice(&func.attr()),
-                                             &flib_def_, &fbody));
-
-  TF_RETURN_IF_ERROR(
-      IsolatePlacerInspectionRequiredOps(flib_def_, fbody->graph));
   if (stack_.HasFunction(func.name())) {
     return errors::Unimplemented(
         "Recursive function calls are not supported. Node ",
@@ -145,6 +138,22 @@ Status InspectingPlacer::ComputeIOColocationGroups(const Node& node,
         stack_.FormatForError());
   }
 
+  // The groups only depend on the function body, so calls to the same
+  // function with the same attributes share them.
+  const string cache_key = Canonicalize(func.name(), AttrSlice(&func.attr()));
+  auto it = io_colocation_groups_cache_.find(cache_key);
+  if (it != io_colocation_groups_cache_.end()) {
+    *groups = it->second;
+    return Status::OK();
+  }
+
+  std::unique_ptr<FunctionBody> fbody;
+  TF_RETURN_IF_ERROR(FunctionDefToBodyHelper(*fdef, AttrSlice(&func.attr()),
+                                             &flib_def_, &fbody));
+
+  TF_RETURN_IF_ERROR(
+      IsolatePlacerInspectionRequiredOps(flib_def_, fbody->graph));
+
   ColocationGraph colocation_graph(
       fbody->graph, stack_.Push(&node, func.name()), &flib_def_, &device_set_,
       default_device_, allow_soft_placement_, log_device_placement_);
@@ -154,6 +163,7 @@ Status InspectingPlacer::ComputeIOColocationGroups(const Node& node,
   converter.AssignGroups(fbody->arg_nodes, &groups->input_groups);
   converter.AssignGroups(fbody->ret_nodes, &groups->output_groups);
   TF_RETURN_IF_ERROR(converter.FillGroups(&groups->group_devices));
+  io_colocation_groups_cache_.emplace(cache_key, *groups);
   return Status::OK();
 }
 
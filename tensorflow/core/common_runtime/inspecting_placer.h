@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_INSPECTING_PLACER_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_INSPECTING_PLACER_H_
 
+#include <unordered_map>
 #include <vector>
 
 #include "absl/strings/str_join.h"
@@ -87,6 +88,10 @@ class InspectingPlacer {
   const bool allow_soft_placement_;
   const bool log_device_placement_;
 
+  // Groups computed so far, keyed by the canonicalized function name and
+  // attributes of the call.
+  std::unordered_map<string, IOColocationGroups> io_colocation_groups_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(InspectingPlacer);
 };
 
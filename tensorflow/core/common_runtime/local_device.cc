@@ -84,8 +84,7 @@ struct LocalDevice::EigenThreadPoolInfo {
         intra_op_parallelism_threads = port::MaxParallelism(numa_node);
       }
     }
-    ThreadOptions thread_opts;
-    thread_opts.numa_node = numa_node;
+    ThreadOptions thread_opts = IntraOpThreadOptions(options, numa_node);
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
     eigen_worker_threads_.workers = new thread::ThreadPool(
         options.env, thread_opts, strings::StrCat("numa_", numa_node, "_Eigen"),
@@ -149,9 +148,15 @@ LocalDevice::LocalDevice(const SessionOptions& options,
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    // TODO(tucker): NUMA for these too?
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
-        options, port::kNUMANoAffinity, nullptr));
+    if (options.config.experimental().use_numa_affinity()) {
+      int numa_node = attributes.locality().numa_node();
+      owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
+          options, numa_node,
+          ProcessState::singleton()->GetCPUAllocator(numa_node)));
+    } else {
+      owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
+          options, port::kNUMANoAffinity, nullptr));
+    }
     tp_info = owned_tp_info_.get();
   }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
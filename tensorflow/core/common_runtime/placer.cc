@@ -106,6 +106,35 @@ bool IsGeneratorNode(const Node* node) {
          !IsRefType(node->output_type(0));
 }
 
+// Returns the device of the data inputs of `node`, if they are all assigned
+// to the same CPU device of `devices`, and that device is on another NUMA node
+// than the default CPU device `devices[0]`. Returns -1 otherwise.
+int NumaLocalInputDevice(const Node* node,
+                         const std::vector<Device*>& devices) {
+  const Node* input = nullptr;
+  for (const Edge* e : node->in_edges()) {
+    if (e->IsControlEdge()) continue;
+    if (!e->src()->has_assigned_device_name() ||
+        (input != nullptr && e->src()->assigned_device_name_index() !=
+                                 input->assigned_device_name_index())) {
+      return -1;
+    }
+    input = e->src();
+  }
+  if (input == nullptr || devices[0]->device_type() != DEVICE_CPU) return -1;
+  const int default_numa_node = devices[0]->attributes().locality().numa_node();
+  for (const Device* device : devices) {
+    if (device->name() == input->assigned_device_name()) {
+      return device->device_type() == DEVICE_CPU &&
+                     device->attributes().locality().numa_node() !=
+                         default_numa_node
+                 ? input->assigned_device_name_index()
+                 : -1;
+    }
+  }
+  return -1;
+}
+
 void LogDeviceAssignment(const Node* node, bool log_device_placement) {
   // Log placement if log_device_placement is set.
   if (log_device_placement) {
@@ -238,6 +267,14 @@ Status Placer::Run() {
       }
     }
 
+    // Heuristic C: If the CPU devices are on different NUMA nodes (see
+    // ConfigProto.Experimental.use_numa_affinity), place the node with its
+    // data inputs when they are all on the same device, rather than on the
+    // default device, to avoid reading them across NUMA nodes.
+    if (assigned_device == -1) {
+      assigned_device = NumaLocalInputDevice(node, *devices);
+    }
+
     // Provide the default, if necessary.
     if (assigned_device == -1) {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
@@ -93,10 +94,12 @@ class FakeDevice : public Device {
   Allocator* GetAllocator(AllocatorAttributes attr) override { return nullptr; }
 
   static std::unique_ptr<Device> MakeDevice(const string& name,
-                                            const string& device_type) {
+                                            const string& device_type,
+                                            int numa_node = 0) {
     DeviceAttributes device_attributes;
     device_attributes.set_name(name);
     device_attributes.set_device_type(device_type);
+    device_attributes.mutable_locality()->set_numa_node(numa_node);
     return std::unique_ptr<Device>(new FakeDevice(device_attributes));
   }
 
@@ -149,6 +152,8 @@ REGISTER_KERNEL_BUILDER(Name("TestAdd").Device("FakeGPU"), DummyOp);
 REGISTER_OP("TestRelu").Input("i: float").Output("o: float");
 REGISTER_KERNEL_BUILDER(Name("TestRelu").Device("FakeCPU"), DummyOp);
 REGISTER_KERNEL_BUILDER(Name("TestRelu").Device("FakeGPU"), DummyOp);
+// For the NUMA placement heuristic, which only applies to CPU devices.
+REGISTER_KERNEL_BUILDER(Name("TestRelu").Device(DEVICE_CPU), DummyOp);
 
 REGISTER_OP("ReluCPU").Input("i: float").Output("o: float");
 REGISTER_KERNEL_BUILDER(Name("ReluCPU").Device("FakeCPU"), DummyOp);
@@ -168,6 +173,7 @@ REGISTER_KERNEL_BUILDER(Name("AssignGPU").Device("FakeGPU"), DummyOp);
 
 REGISTER_OP("TestInput").Output("a: float").Output("b: float");
 REGISTER_KERNEL_BUILDER(Name("TestInput").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("TestInput").Device(DEVICE_CPU), DummyOp);
 
 // Op producing an output that can be placed on CPU or GPU.
 REGISTER_OP("TestCPUGPUOutput").Output("a: float");
@@ -789,6 +795,39 @@ TEST_F(PlacerTest, TestIgnoreGeneratorHeuristicIfWrongDevice) {
   EXPECT_COLOCATED(g, "var_cpu", "assign");
 }
 
+// Heuristic C keeps nodes on the NUMA node of their inputs when there is one
+// CPU device per NUMA node.
+TEST_F(PlacerTest, TestHeuristicNumaLocalInputs) {
+  for (const bool distinct_numa_nodes : {true, false}) {
+    Graph g(OpRegistry::Global());
+    {  // Scope for temporary variables used to construct g.
+      GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+      Node* input = ops::SourceOp(
+          "TestInput",
+          b.opts().WithName("in").WithDevice("/job:a/device:CPU:1"));
+      Node* relu = ops::UnaryOp("TestRelu", ops::NodeOut(input, 0),
+                                b.opts().WithName("relu"));
+      ops::UnaryOp("TestRelu", relu, b.opts().WithName("relu2"));
+      TF_EXPECT_OK(BuildGraph(b, &g));
+    }
+
+    DeviceSet devices;
+    std::unique_ptr<Device> cpu0(FakeDevice::MakeDevice(
+        "/job:a/replica:0/task:0/device:CPU:0", DEVICE_CPU, /*numa_node=*/0));
+    devices.AddDevice(cpu0.get());
+    std::unique_ptr<Device> cpu1(
+        FakeDevice::MakeDevice("/job:a/replica:0/task:0/device:CPU:1",
+                               DEVICE_CPU, distinct_numa_nodes ? 1 : 0));
+    devices.AddDevice(cpu1.get());
+    TF_EXPECT_OK(Place(&g, &devices));
+
+    const string expected_device = distinct_numa_nodes ? "CPU:1" : "CPU:0";
+    EXPECT_DEVICE_CONTAINS(g, "in", "CPU:1");
+    EXPECT_DEVICE_CONTAINS(g, "relu", expected_device);
+    EXPECT_DEVICE_CONTAINS(g, "relu2", expected_device);
+  }
+}
+
 TEST_F(PlacerTest, TestIgnoreGeneratorHeuristicIfWrongPartialDevice) {
   Graph g(OpRegistry::Global());
   {  // Scope for temporary variables used to construct g.
@@ -2151,6 +2190,37 @@ TEST_F(NestedPlacerTest, OutputOneResource) {
   EXPECT_DEVICE_TYPE(g, "r2", "FakeGPU");
 }
 
+TEST_F(NestedPlacerTest, CallsToSameFunctionFollowTheirOwnResources) {
+  // Both calls share the colocation groups computed for the function body,
+  // but their resource outputs follow their own resource inputs.
+  FunctionDef func = test::function::ResourceOutput();
+  GraphDef graph = GDef(
+      {
+          NDef("a", "_Arg", {}, {{"T", DT_FLOAT}}, kGPU),
+          NDef("b1", "_Arg", {}, {{"T", DT_RESOURCE}}, kCPU),
+          NDef("b2", "_Arg", {}, {{"T", DT_RESOURCE}}, kGPU),
+          NDef("y1", "PartitionedCall", {"a", "b1"},
+               {{"Tin", DataTypeSlice{DT_FLOAT, DT_RESOURCE}},
+                {"Tout", DataTypeSlice{DT_RESOURCE, DT_FLOAT}},
+                {"f", FDH::FunctionRef("ResourceOutput", {})}}),
+          NDef("y2", "PartitionedCall", {"a", "b2"},
+               {{"Tin", DataTypeSlice{DT_FLOAT, DT_RESOURCE}},
+                {"Tout", DataTypeSlice{DT_RESOURCE, DT_FLOAT}},
+                {"f", FDH::FunctionRef("ResourceOutput", {})}}),
+          NDef("r1", "Identity", {"y1:0"}, {{"T", DT_RESOURCE}}),
+          NDef("r2", "Identity", {"y2:0"}, {{"T", DT_RESOURCE}}),
+      },
+      // FunctionLib
+      {func});
+
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(BuildGraph(graph, &g));
+  TF_ASSERT_OK(CallOptPassesAndPlace(&g));
+
+  EXPECT_DEVICE_TYPE(g, "r1", "FakeCPU");
+  EXPECT_DEVICE_TYPE(g, "r2", "FakeGPU");
+}
+
 TEST_F(NestedPlacerTest, OutputOneResource_ExtraIdentities) {
   /*
    *                a:FLOAT
@@ -3100,5 +3170,46 @@ TEST_F(NestedPlacerTest, IndirectRecursion) {
       << s.ToString();
 }
 
+// Places `num_groups` groups of a ref variable, an assignment to it and a
+// node colocated with it through the "_class" attribute.
+static void BM_PlaceLargeGraph(int iters, int num_groups) {
+  testing::StopTiming();
+  std::vector<std::unique_ptr<Device>> devices;
+  devices.push_back(FakeDevice::MakeCPU(kFullCPU));
+  devices.push_back(FakeDevice::MakeGPU(kFullGPU));
+  DeviceSet device_set;
+  for (const auto& device : devices) {
+    device_set.AddDevice(device.get());
+  }
+
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  for (int i = 0; i < num_groups; ++i) {
+    const string var_name = strings::StrCat("var", i);
+    Node* var = ops::SourceOp("TestVariable", b.opts().WithName(var_name));
+    Node* value = ops::SourceOp(
+        "TestCPUGPUOutput", b.opts().WithName(strings::StrCat("value", i)));
+    Node* relu = ops::UnaryOp("TestRelu", value,
+                              b.opts()
+                                  .WithName(strings::StrCat("relu", i))
+                                  .WithAttr("_class", {"loc:@" + var_name}));
+    ops::BinaryOp("TestAssign", var, relu,
+                  b.opts().WithName(strings::StrCat("assign", i)));
+  }
+  GraphDef graph_def;
+  TF_CHECK_OK(b.ToGraphDef(&graph_def));
+
+  for (int i = 0; i < iters; ++i) {
+    Graph g(OpRegistry::Global());
+    TF_CHECK_OK(
+        ConvertGraphDefToGraph(GraphConstructorOptions(), graph_def, &g));
+    testing::StartTiming();
+    Placer placer(&g, "", &device_set);
+    TF_CHECK_OK(placer.Run());
+    testing::StopTiming();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_groups * 4);
+}
+BENCHMARK(BM_PlaceLargeGraph)->Arg(1000)->Arg(10000)->Arg(100000);
+
 }  // namespace
 }  // namespace tensorflow
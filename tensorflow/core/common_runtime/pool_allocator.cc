@@ -24,6 +24,7 @@ limitations under the License.
 #include <map>
 #include <utility>
 
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
@@ -256,10 +257,20 @@ void PoolAllocator::EvictOne() {
   }
 }
 
+namespace {
+// The bytes allocated in huge pages by all the BasicCPUAllocators.
+std::atomic<int64> huge_page_bytes{0};
+}  // namespace
+
 void* BasicCPUAllocator::Alloc(size_t alignment, size_t num_bytes) {
   void* ptr = nullptr;
   if (num_bytes > 0) {
-    if (numa_node_ == port::kNUMANoAffinity) {
+    if (UseHugePages(num_bytes)) {
+      ptr = port::HugePageMalloc(num_bytes, huge_page_size_);
+      if (ptr != nullptr) {
+        metrics::SetCPUHugePageBytes(huge_page_bytes += num_bytes);
+      }
+    } else if (numa_node_ == port::kNUMANoAffinity) {
       ptr = port::AlignedMalloc(num_bytes, static_cast<int>(alignment));
     } else {
       ptr =
@@ -273,7 +284,10 @@ void* BasicCPUAllocator::Alloc(size_t alignment, size_t num_bytes) {
 void BasicCPUAllocator::Free(void* ptr, size_t num_bytes) {
   if (num_bytes > 0) {
     VisitFree(ptr, numa_node_, num_bytes);
-    if (numa_node_ == port::kNUMANoAffinity) {
+    if (UseHugePages(num_bytes)) {
+      port::HugePageFree(ptr, num_bytes, huge_page_size_);
+      metrics::SetCPUHugePageBytes(huge_page_bytes -= num_bytes);
+    } else if (numa_node_ == port::kNUMANoAffinity) {
       port::AlignedFree(ptr);
     } else {
       port::NUMAFree(ptr, num_bytes);
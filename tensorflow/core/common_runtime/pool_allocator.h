@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -148,9 +149,17 @@ class Pow2Rounder : public RoundUpInterface {
 
 class BasicCPUAllocator : public SubAllocator {
  public:
+  // If huge_page_size is not 0, allocations of at least huge_page_min_bytes
+  // are backed by huge pages of that size (see port::HugePageMalloc), except
+  // on a specific NUMA node. The bytes allocated this way are exported by the
+  // /tensorflow/core/cpu_allocator/huge_page_bytes metric.
   BasicCPUAllocator(int numa_node, const std::vector<Visitor>& alloc_visitors,
-                    const std::vector<Visitor>& free_visitors)
-      : SubAllocator(alloc_visitors, free_visitors), numa_node_(numa_node) {}
+                    const std::vector<Visitor>& free_visitors,
+                    size_t huge_page_size = 0, size_t huge_page_min_bytes = 0)
+      : SubAllocator(alloc_visitors, free_visitors),
+        numa_node_(numa_node),
+        huge_page_size_(huge_page_size),
+        huge_page_min_bytes_(huge_page_min_bytes) {}
 
   ~BasicCPUAllocator() override {}
 
@@ -159,7 +168,14 @@ class BasicCPUAllocator : public SubAllocator {
   void Free(void* ptr, size_t num_bytes) override;
 
  private:
+  bool UseHugePages(size_t num_bytes) const {
+    return huge_page_size_ > 0 && num_bytes >= huge_page_min_bytes_ &&
+           numa_node_ == port::kNUMANoAffinity;
+  }
+
   int numa_node_;
+  const size_t huge_page_size_;
+  const size_t huge_page_min_bytes_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(BasicCPUAllocator);
 };
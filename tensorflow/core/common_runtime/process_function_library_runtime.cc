@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 
+#include <algorithm>
 #include <iterator>
 #include <utility>
 
@@ -47,7 +48,9 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/ptr_util.h"
@@ -654,13 +657,24 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
 
   {
     mutex_lock l(mu_);
-    const auto& it = table_.find(function_key);
-    if (it != table_.end()) {
-      *handle = it->second;
-      ++mdevice_data_[*handle]->instantiation_counter_;
-      return Status::OK();
+    while (true) {
+      const auto& it = table_.find(function_key);
+      if (it != table_.end()) {
+        *handle = it->second;
+        ++mdevice_data_[*handle]->instantiation_counter_;
+        return Status::OK();
+      }
+      // If another thread is instantiating this function, wait for its
+      // result. When it fails, this instantiation is attempted again.
+      if (pending_instantiations_.insert(function_key).second) break;
+      instantiation_done_.wait(l);
     }
   }
+  auto instantiation_done = gtl::MakeCleanup([this, &function_key] {
+    mutex_lock l(mu_);
+    pending_instantiations_.erase(function_key);
+    instantiation_done_.notify_all();
+  });
 
   VLOG(1) << "Instantiating MultiDevice function \"" << function_name
           << "\" on default device \"" << options.target << "\"";
@@ -1186,6 +1200,37 @@ void ProcessFunctionLibraryRuntime::RunMultiDevice(
   refcounted_done->Unref();
 }
 
+Status ProcessFunctionLibraryRuntime::InstantiateConcurrently(
+    const std::vector<InstantiateRequest>& requests,
+    std::vector<FunctionLibraryRuntime::Handle>* handles) {
+  handles->assign(requests.size(), kInvalidHandle);
+  std::vector<Status> statuses(requests.size());
+  auto instantiate = [this, &requests, handles, &statuses](int64 i) {
+    const InstantiateRequest& request = requests[i];
+    statuses[i] = Instantiate(request.function_name, AttrSlice(&request.attrs),
+                              request.options, &(*handles)[i]);
+    if (!statuses[i].ok()) (*handles)[i] = kInvalidHandle;
+  };
+  if (requests.size() <= 1) {
+    for (int64 i = 0, end = requests.size(); i < end; ++i) instantiate(i);
+  } else {
+    // Multi-device instantiation blocks on partitions that it schedules on
+    // default_thread_pool_, so the functions are instantiated on their own
+    // threads. The pool waits for them when it is destroyed.
+    thread::ThreadPool pool(
+        env_, "instantiate_functions",
+        std::min<int>(requests.size(), port::MaxParallelism()));
+    for (int64 i = 0, end = requests.size(); i < end; ++i) {
+      pool.Schedule([&instantiate, i]() { instantiate(i); });
+    }
+  }
+  StatusGroup group;
+  for (const Status& status : statuses) {
+    group.Update(status);
+  }
+  return group.as_summary_status();
+}
+
 Status ProcessFunctionLibraryRuntime::Instantiate(
     const string& function_name, AttrSlice attrs,
     const FunctionLibraryRuntime::InstantiateOptions& options,
@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_FUNCTION_LIBRARY_RUNTIME_H_
 
 #include <unordered_map>
+#include <unordered_set>
 
 // clang-format off
 // Required for IS_MOBILE_PLATFORM
@@ -166,6 +167,21 @@ class ProcessFunctionLibraryRuntime {
                      const FunctionLibraryRuntime::InstantiateOptions& options,
                      FunctionLibraryRuntime::Handle* handle);
 
+  // A function to instantiate with InstantiateConcurrently().
+  struct InstantiateRequest {
+    string function_name;
+    AttrValueMap attrs;
+    FunctionLibraryRuntime::InstantiateOptions options;
+  };
+
+  // Instantiates all the `requests` concurrently, e.g. to prepare the
+  // functions of a model when it is loaded. `handles[i]` is set to the handle
+  // of `requests[i]`, or to kInvalidHandle if it failed. Returns the errors of
+  // all the failed instantiations.
+  Status InstantiateConcurrently(
+      const std::vector<InstantiateRequest>& requests,
+      std::vector<FunctionLibraryRuntime::Handle>* handles);
+
   // Returns whether the function represented by the given handle needs to
   // execute cross process.
   Status IsCrossProcess(FunctionLibraryRuntime::Handle handle,
@@ -465,6 +481,12 @@ class ProcessFunctionLibraryRuntime {
   std::unordered_map<string, FunctionLibraryRuntime::Handle> table_
       TF_GUARDED_BY(mu_);
 
+  // Function keys of the multi-device functions being instantiated. Other
+  // callers instantiating the same key wait on `instantiation_done_` for the
+  // result instead of repeating the work.
+  std::unordered_set<string> pending_instantiations_ TF_GUARDED_BY(mu_);
+  condition_variable instantiation_done_;
+
   // Function data for instantiated remote functions.
   std::unordered_map<FunctionLibraryRuntime::Handle,
                      std::unique_ptr<FunctionData>>
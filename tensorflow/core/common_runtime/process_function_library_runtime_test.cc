@@ -1013,6 +1013,52 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_CreateKernelsEagerly) {
   EXPECT_TRUE(errors::IsInternal(status));
 }
 
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_InstantiateConcurrently) {
+  Init({test::function::XTimesTwo(), test::function::XTimesFour()});
+  std::vector<ProcessFunctionLibraryRuntime::InstantiateRequest> requests(8);
+  for (int i = 0; i < requests.size(); ++i) {
+    requests[i].function_name = i % 2 == 0 ? "XTimesTwo" : "XTimesFour";
+    requests[i].attrs["T"].set_type(DT_FLOAT);
+    requests[i].options = MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0"});
+  }
+  std::vector<FunctionLibraryRuntime::Handle> handles;
+  TF_ASSERT_OK(proc_flr_->InstantiateConcurrently(requests, &handles));
+  ASSERT_EQ(handles.size(), requests.size());
+  EXPECT_NE(handles[0], handles[1]);
+  // Concurrent instantiations of the same function share one handle.
+  for (int i = 2; i < handles.size(); ++i) {
+    EXPECT_EQ(handles[i], handles[i % 2]);
+  }
+
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(
+      Instantiate("XTimesTwo", {{"T", DT_FLOAT}}, requests[0].options, &handle));
+  EXPECT_EQ(handle, handles[0]);
+
+  auto x = test::AsTensor<float>({1, 2, 3, 4});
+  Tensor y;
+  TF_ASSERT_OK(RunInstantiated(handles[1], {}, {x}, {&y}));
+  test::ExpectTensorEqual<float>(y, test::AsTensor<float>({4, 8, 12, 16}));
+}
+
+TEST_F(ProcessFunctionLibraryRuntimeTest,
+       MultiDevice_InstantiateConcurrentlyReportsErrors) {
+  Init({test::function::XTimesTwo()});
+  std::vector<ProcessFunctionLibraryRuntime::InstantiateRequest> requests(2);
+  requests[0].function_name = "XTimesTwo";
+  requests[1].function_name = "Missing";
+  for (auto& request : requests) {
+    request.attrs["T"].set_type(DT_FLOAT);
+    request.options = MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0"});
+  }
+  std::vector<FunctionLibraryRuntime::Handle> handles;
+  Status status = proc_flr_->InstantiateConcurrently(requests, &handles);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  ASSERT_EQ(handles.size(), 2);
+  EXPECT_NE(handles[0], kInvalidHandle);
+  EXPECT_EQ(handles[1], kInvalidHandle);
+}
+
 TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_StateHandle) {
   auto T = DT_INT32;
   // The expected sequence of outputs from this function is [6, 4, 0, 1, ...].
@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 #include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/common_runtime/size_class_pool_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
@@ -61,6 +62,17 @@ ProcessState::MemDesc ProcessState::PtrType(const void* ptr) {
   return MemDesc();
 }
 
+void ProcessState::EnableCPUAllocatorPooling(size_t max_cached_bytes) {
+  mutex_lock lock(mu_);
+  if (max_cached_bytes == cpu_pool_max_cached_bytes_) return;
+  if (!cpu_allocators_.empty()) {
+    LOG(WARNING) << "EnableCPUAllocatorPooling has no effect after the first "
+                    "call to ProcessState::GetCPUAllocator";
+    return;
+  }
+  cpu_pool_max_cached_bytes_ = max_cached_bytes;
+}
+
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   if (!numa_enabled_ || numa_node == port::kNUMANoAffinity) numa_node = 0;
 
@@ -82,12 +94,35 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
     if (!status.ok()) {
       LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
     }
+    // Optionally back large allocations with huge pages of 2 MB or 1 GB,
+    // which the default CPU allocator cannot do since it frees without sizes.
+    int64 huge_page_bytes = 0;
+    status = ReadInt64FromEnvVar("TF_CPU_HUGE_PAGE_BYTES", 0, &huge_page_bytes);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+    }
+    if (huge_page_bytes != 0 && huge_page_bytes != (2LL << 20) &&
+        huge_page_bytes != (1LL << 30)) {
+      LOG(ERROR) << "GetCPUAllocator: TF_CPU_HUGE_PAGE_BYTES must be 2097152 "
+                 << "or 1073741824, not " << huge_page_bytes;
+      huge_page_bytes = 0;
+    }
+    int64 huge_page_min_bytes = 0;
+    status = ReadInt64FromEnvVar("TF_CPU_HUGE_PAGE_MIN_ALLOC_BYTES",
+                                 huge_page_bytes, &huge_page_min_bytes);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+    }
     Allocator* allocator = nullptr;
+    const bool use_pool_allocator =
+        !use_bfc_allocator && cpu_pool_max_cached_bytes_ > 0;
     SubAllocator* sub_allocator =
-        (numa_enabled_ || alloc_visitors_defined || use_bfc_allocator)
+        (numa_enabled_ || alloc_visitors_defined || use_bfc_allocator ||
+         use_pool_allocator || huge_page_bytes > 0)
             ? new BasicCPUAllocator(
                   numa_enabled_ ? numa_node : port::kNUMANoAffinity,
-                  cpu_alloc_visitors_, cpu_free_visitors_)
+                  cpu_alloc_visitors_, cpu_free_visitors_, huge_page_bytes,
+                  huge_page_min_bytes)
             : nullptr;
     if (use_bfc_allocator) {
       // TODO(reedwm): evaluate whether 64GB by default is the best choice.
@@ -100,11 +135,28 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
       DCHECK(sub_allocator);
-      allocator =
+      BFCAllocator* bfc_allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, true /*allow_growth*/,
                            "bfc_cpu_allocator_for_gpu" /*name*/);
+      // Optionally serve small allocations from per-thread caches of freed
+      // chunks, see BFCAllocator::SetThreadCacheLimit().
+      int64 thread_cache_bytes = 0;
+      status = ReadInt64FromEnvVar("TF_CPU_BFC_THREAD_CACHE_BYTES", 0,
+                                   &thread_cache_bytes);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      bfc_allocator->SetThreadCacheLimit(thread_cache_bytes);
+      allocator = bfc_allocator;
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
+    } else if (use_pool_allocator) {
+      DCHECK(sub_allocator);
+      allocator = new SizeClassPoolAllocator(
+          sub_allocator, cpu_pool_max_cached_bytes_, "cpu_size_class_pool");
+      VLOG(2) << "Using SizeClassPoolAllocator caching up to "
+              << cpu_pool_max_cached_bytes_
+              << " bytes for ProcessState CPU allocator";
     } else if (sub_allocator) {
       DCHECK(sub_allocator);
       allocator =
@@ -160,6 +212,7 @@ void ProcessState::TestOnlyReset() {
     if (a != default_cpu_allocator) delete a;
   }
   cpu_allocators_.clear();
+  cpu_pool_max_cached_bytes_ = 0;
   for (Allocator* a : cpu_al_) {
     delete a;
   }
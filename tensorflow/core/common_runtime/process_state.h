@@ -59,6 +59,12 @@ class ProcessState : public ProcessStateInterface {
   // Allocator accessor.
   void EnableNUMA() { numa_enabled_ = true; }
 
+  // If pooling CPU Allocators are desired, call this before calling any
+  // Allocator accessor. The CPU allocators then keep up to
+  // `max_cached_bytes` of freed buffers in pools of size classes, see
+  // SizeClassPoolAllocator.
+  void EnableCPUAllocatorPooling(size_t max_cached_bytes);
+
   // Returns what we know about the memory at ptr.
   // If we know nothing, it's called CPU 0 with no other attributes.
   MemDesc PtrType(const void* ptr);
@@ -96,6 +102,8 @@ class ProcessState : public ProcessStateInterface {
 
   mutex mu_;
 
+  size_t cpu_pool_max_cached_bytes_ TF_GUARDED_BY(mu_) = 0;
+
   // Indexed by numa_node.  If we want numa-specific allocators AND a
   // non-specific allocator, maybe should index by numa_node+1.
   std::vector<Allocator*> cpu_allocators_ TF_GUARDED_BY(mu_);
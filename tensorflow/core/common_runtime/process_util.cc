@@ -25,7 +25,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
@@ -78,7 +80,8 @@ static thread::ThreadPool* InitComputePool(const SessionOptions& options) {
     inter_op_parallelism_threads = DefaultNumInterOpThreads();
   }
   return new thread::ThreadPool(
-      Env::Default(), ThreadOptions(), "Compute", inter_op_parallelism_threads,
+      Env::Default(), InterOpThreadOptions(options), "Compute",
+      inter_op_parallelism_threads,
       !options.config.experimental().disable_thread_spinning(),
       /*allocator=*/nullptr);
 }
@@ -158,11 +161,57 @@ thread::ThreadPool* NewThreadPoolFromSessionOptions(
   const int32 num_threads = NumInterOpThreadsFromSessionOptions(options);
   VLOG(1) << "Direct session inter op parallelism threads: " << num_threads;
   return new thread::ThreadPool(
-      options.env, ThreadOptions(), "Compute", num_threads,
+      options.env, InterOpThreadOptions(options), "Compute", num_threads,
       !options.config.experimental().disable_thread_spinning(),
       /*allocator=*/nullptr);
 }
 
+Status ParseCPUList(const string& cpu_list, std::vector<int>* cpus) {
+  cpus->clear();
+  for (const string& range :
+       str_util::Split(cpu_list, ',', str_util::SkipEmpty())) {
+    const std::vector<string> bounds = str_util::Split(range, '-');
+    int32 first, last;
+    if (bounds.size() > 2 || !strings::safe_strto32(bounds[0], &first) ||
+        !strings::safe_strto32(bounds.back(), &last) || first < 0 ||
+        last < first) {
+      return errors::InvalidArgument("Invalid CPU range \"", range,
+                                     "\" in CPU list \"", cpu_list, "\"");
+    }
+    for (int32 cpu = first; cpu <= last; ++cpu) {
+      cpus->push_back(cpu);
+    }
+  }
+  return Status::OK();
+}
+
+namespace {
+
+ThreadOptions ThreadOptionsWithCPUList(const string& cpu_list) {
+  ThreadOptions thread_options;
+  Status s = ParseCPUList(cpu_list, &thread_options.cpu_list);
+  if (!s.ok()) {
+    LOG(ERROR) << "Thread pool threads are not pinned: " << s;
+    thread_options.cpu_list.clear();
+  }
+  return thread_options;
+}
+
+}  // namespace
+
+ThreadOptions InterOpThreadOptions(const SessionOptions& options) {
+  return ThreadOptionsWithCPUList(
+      options.config.experimental().inter_op_cpu_list());
+}
+
+ThreadOptions IntraOpThreadOptions(const SessionOptions& options,
+                                   int numa_node) {
+  ThreadOptions thread_options = ThreadOptionsWithCPUList(
+      options.config.experimental().intra_op_cpu_list());
+  thread_options.numa_node = numa_node;
+  return thread_options;
+}
+
 void SchedClosure(std::function<void()> closure) {
   if (!tracing::EventCollector::IsEnabled()) {
     return Env::Default()->SchedClosure(std::move(closure));
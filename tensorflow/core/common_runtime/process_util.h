@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_UTIL_H_
 
 #include <functional>
+#include <vector>
 
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/public/session_options.h"
@@ -48,6 +49,19 @@ int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options);
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options);
 
+// Parses a comma separated list of CPU ids and inclusive ranges of CPU ids,
+// e.g. "0-7,16-23", into `cpus`.
+Status ParseCPUList(const string& cpu_list, std::vector<int>* cpus);
+
+// Returns the options of the threads of the inter-op thread pools created for
+// a session with `options`.
+ThreadOptions InterOpThreadOptions(const SessionOptions& options);
+
+// Returns the options of the threads of the intra-op thread pool of a CPU
+// device on `numa_node` created for a session with `options`.
+ThreadOptions IntraOpThreadOptions(const SessionOptions& options,
+                                   int numa_node);
+
 // Schedule "closure" in the default thread queue.
 void SchedClosure(std::function<void()> closure);
 
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_util.h"
 
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -34,5 +35,25 @@ TEST(ProcessUtilTest, ThreadPool) {
   delete pool;
 }
 
+TEST(ProcessUtilTest, ParseCPUList) {
+  std::vector<int> cpus;
+  TF_EXPECT_OK(ParseCPUList("0-3, 8,10-11", &cpus));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), cpus);
+  TF_EXPECT_OK(ParseCPUList("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+  EXPECT_FALSE(ParseCPUList("3-1", &cpus).ok());
+  EXPECT_FALSE(ParseCPUList("1-2-3", &cpus).ok());
+  EXPECT_FALSE(ParseCPUList("a", &cpus).ok());
+}
+
+TEST(ProcessUtilTest, InterOpThreadOptions) {
+  SessionOptions opts;
+  opts.config.mutable_experimental()->set_inter_op_cpu_list("2-3");
+  EXPECT_EQ(std::vector<int>({2, 3}), InterOpThreadOptions(opts).cpu_list);
+  // Invalid lists leave the threads unpinned.
+  opts.config.mutable_experimental()->set_inter_op_cpu_list("x");
+  EXPECT_TRUE(InterOpThreadOptions(opts).cpu_list.empty());
+}
+
 }  // anonymous namespace
 }  // namespace tensorflow
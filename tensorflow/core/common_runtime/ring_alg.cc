@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -39,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 
 // Set true for greater intelligibility of debug mode log messages.
 #define READABLE_KEYS false
@@ -298,6 +300,8 @@ void RingAlg::Finish(bool ok) {
     s = status_;
   }
   rfv_.clear();  // Give up Refs on output tensor.
+  collective_util::PeerWaitStats::Global()->MaybeLogReport(
+      Env::Default()->NowMicros());
   done_(s);
 }
 
@@ -319,6 +323,7 @@ void RingAlg::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   rf->rank = col_params_->subdiv_rank[subdiv_idx];
   rf->second_pass = false;
   rf->action = RF_INIT;
+  rf->pass_start_micros = Env::Default()->NowMicros();
   // Recv from the device with preceding rank within the subdivision.
   int recv_from_rank = (rf->rank + (group_size_ - 1)) % group_size_;
   int send_to_rank = (rf->rank + 1) % group_size_;
@@ -351,6 +356,7 @@ void RingAlg::AdvanceToSecondPass(RingField* rf) {
   DCHECK(!rf->second_pass);
   rf->second_pass = true;
   rf->action = RF_INIT;
+  rf->pass_start_micros = Env::Default()->NowMicros();
   if (ca_->ChunkBytes(rf->sc_idx) > 0) {
     // In pass 1 the send/no-send boundary moves down 1 place.
     rf->do_recv =
@@ -363,6 +369,11 @@ void RingAlg::AdvanceToSecondPass(RingField* rf) {
   VLOG(3) << "IncrRingField new value " << rf->DebugString();
 }
 
+void RingAlg::RecordRingStep(const RingField& rf) {
+  metrics::RecordCollectiveRingStep(
+      name_, Env::Default()->NowMicros() - rf.pass_start_micros);
+}
+
 string RingAlg::RingField::DebugString() const {
   string rv = strings::StrCat("RingField rank=", rank, " chunk_idx=", chunk_idx,
                               " subdiv=", subdiv_idx, " sc_idx=", sc_idx,
@@ -384,11 +395,18 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
   int send_to_rank = (rf->rank + 1) % group_size_;
   int send_to_dev_idx = col_params_->instance.impl_details
                             .subdiv_permutations[rf->subdiv_idx][send_to_rank];
+  const string& send_to_device =
+      col_params_->instance.device_names[send_to_dev_idx];
+  const Tensor* src_tensor =
+      col_params_->encode_op ? &rf->wire_chunk : &rf->chunk;
+  metrics::RecordCollectivePeerSend(
+      strings::StrCat(col_params_->group.group_key), send_to_device,
+      src_tensor->TotalBytes());
   col_ctx_->col_exec->remote_access()->PostToPeer(
-      col_params_->instance.device_names[send_to_dev_idx],
+      send_to_device,
       col_params_->instance.task_names[send_to_dev_idx], send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
+      col_ctx_->op_ctx->output_alloc_attr(0), src_tensor,
       col_ctx_->device_locality, done);
 }
 
@@ -403,13 +421,42 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
+  if (col_params_->encode_op) dst_tensor = &rf->wire_chunk;
+  const string& peer_device =
+      col_params_->instance.device_names[rf->recv_dev_idx];
+  // Time the wait so that slow peers show up in the profile and metrics.
+  const uint64 start_micros = Env::Default()->NowMicros();
+  auto recv_done = [this, rf, dst_tensor, &peer_device, start_micros,
+                    done](const Status& s) {
+    if (s.ok()) {
+      const uint64 wait_usecs = Env::Default()->NowMicros() - start_micros;
+      const int32 group_key = col_params_->group.group_key;
+      const int32 instance_key = col_params_->instance.instance_key;
+      profiler::TraceMe::InstantActivity([&] {
+        return profiler::TraceMeEncode(
+            "RecvFromPeer", {{"name", name_},
+                             {"group_key", group_key},
+                             {"instance_key", instance_key},
+                             {"peer_device", peer_device},
+                             {"subdiv", rf->subdiv_idx},
+                             {"pass", rf->second_pass ? 1 : 0},
+                             {"bytes", dst_tensor->TotalBytes()},
+                             {"wait_us", wait_usecs}});
+      });
+      metrics::RecordCollectivePeerRecv(strings::StrCat(group_key),
+                                        peer_device, dst_tensor->TotalBytes(),
+                                        wait_usecs);
+      collective_util::PeerWaitStats::Global()->RecordRecv(
+          group_key, peer_device, wait_usecs);
+    }
+    done(s);
+  };
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
-      col_params_->instance.device_names[rf->recv_dev_idx],
-      col_params_->instance.task_names[rf->recv_dev_idx],
+      peer_device, col_params_->instance.task_names[rf->recv_dev_idx],
       col_params_->task.is_local[rf->recv_dev_idx], recv_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
       col_ctx_->op_ctx->output_alloc_attr(0), dst_tensor,
-      col_ctx_->device_locality, rf->subdiv_idx, done);
+      col_ctx_->device_locality, rf->subdiv_idx, recv_done);
 }
 
 string RingAlg::FieldState() {
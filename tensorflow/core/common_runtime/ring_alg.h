@@ -81,12 +81,17 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    Tensor wire_chunk;  // values as sent and received, if compressed
+    uint64 pass_start_micros = 0;  // when the current pass was initialized
     Status status;
     string DebugString() const;
   };
   virtual void InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
                              int field_idx);
   void AdvanceToSecondPass(RingField* rf);
+  // Records the time `rf` took for the pass it just completed, a single step
+  // of the ring for its chunk.
+  void RecordRingStep(const RingField& rf);
   void DispatchSend(RingField* rf, const StatusCallback& done);
   void DispatchRecv(RingField* rf, const StatusCallback& done);
 
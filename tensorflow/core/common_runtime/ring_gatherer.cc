@@ -237,6 +237,7 @@ bool RingGatherer::RunAsyncParts() {
             break;
         }
         if (rf->action == RF_DONE) {
+          RecordRingStep(*rf);
           // There's only one pass.
           ++field_done_count;
           break;  // from do while(!dispatched)
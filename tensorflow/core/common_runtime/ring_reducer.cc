@@ -164,7 +164,16 @@ void RingReducer::ContinueAfterInputCopy() {
 void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
                                 int field_idx) {
   RingAlg::InitRingField(rf, chunk_idx, subdiv_idx, field_idx);
-  if (rf->do_recv) {
+  if (col_params_->encode_op) {
+    // Values travel in their wire format and are decoded straight into the
+    // chunk, so one buffer per field replaces tmp_chunk.
+    if (rf->do_send || rf->do_recv) {
+      AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+      rf->wire_chunk = Tensor(col_ctx_->device->GetAllocator(attr),
+                              col_params_->encode_op->output_type(0),
+                              {rf->chunk.NumElements()});
+    }
+  } else if (rf->do_recv) {
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
   }
 }
@@ -209,6 +218,7 @@ bool RingReducer::RunAsyncParts() {
     }
   }
 
+  const bool compressed = (col_params_->encode_op != nullptr);
   int field_done_count = 0;
   int send_pending_count = 0;
   int recv_pending_count = 0;
@@ -254,15 +264,34 @@ bool RingReducer::RunAsyncParts() {
             --recv_pending_count;
             if (!rf->second_pass) {
               rf->action = RF_REDUCE;
-              Status s = collective_util::ComputeBinOp(
-                  col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
-                  col_params_->merge_op.get(), &rf->chunk, &rf->tmp_chunk);
+              Status s =
+                  compressed
+                      ? collective_util::ComputeBinOp(
+                            col_ctx_->op_ctx, col_ctx_->op_params,
+                            col_ctx_->device,
+                            col_params_->decode_merge_op.get(), &rf->chunk,
+                            &rf->wire_chunk)
+                      : collective_util::ComputeBinOp(
+                            col_ctx_->op_ctx, col_ctx_->op_params,
+                            col_ctx_->device, col_params_->merge_op.get(),
+                            &rf->chunk, &rf->tmp_chunk);
               if (!s.ok()) {
                 aborted = true;
                 StartAbort(s);
               }
             } else {
               rf->action = RF_SEND_READY;
+              if (compressed) {
+                // The wire_chunk is forwarded as received, if at all.
+                Status s = collective_util::ComputeBinOp(
+                    col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+                    col_params_->decode_op.get(), &rf->chunk,
+                    &rf->wire_chunk);
+                if (!s.ok()) {
+                  aborted = true;
+                  StartAbort(s);
+                }
+              }
             }
             break;
           case RF_REDUCE:
@@ -286,6 +315,14 @@ bool RingReducer::RunAsyncParts() {
             break;
           case RF_SEND_READY:
             if (rf->do_send) {
+              if (compressed && !(rf->second_pass && rf->do_recv)) {
+                Status s = EncodeChunk(rf);
+                if (!s.ok()) {
+                  aborted = true;
+                  StartAbort(s);
+                  break;
+                }
+              }
               rf->action = RF_SEND;
               auto send_complete = [this, rf, &ready_queue,
                                     &aborted](Status s) {
@@ -311,6 +348,7 @@ bool RingReducer::RunAsyncParts() {
             break;
         }
         if (rf->action == RF_DONE) {
+          RecordRingStep(*rf);
           if (rf->second_pass) {
             ++field_done_count;
             break;  // from do while(!dispatched)
@@ -349,6 +387,21 @@ bool RingReducer::RunAsyncParts() {
   return !aborted;
 }
 
+Status RingReducer::EncodeChunk(RingField* rf) {
+  TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->encode_op.get(), &rf->wire_chunk, &rf->chunk));
+  if (rf->second_pass) {
+    // This is the final value of the chunk, which the other devices only see
+    // in its wire format.  Round it the same way so that all devices end up
+    // with identical results.
+    TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->decode_op.get(), &rf->chunk, &rf->wire_chunk));
+  }
+  return Status::OK();
+}
+
 namespace {
 REGISTER_COLLECTIVE(RingReduce, RingReducer);
 }  // namespace
@@ -49,6 +49,9 @@ class RingReducer : public RingAlg {
   void ContinueAfterInputCopy();
   bool RunAsyncParts();
 
+  // Converts the chunk of `rf` into its wire_chunk before it is sent.
+  Status EncodeChunk(RingField* rf);
+
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
 
@@ -130,6 +130,24 @@ std::unique_ptr<OpKernel> GetDiv(DataType dtype, const DeviceType& device_type,
   return GetKernel(node_def, device_type, device);
 }
 
+std::unique_ptr<OpKernel> GetCodec(const string& op_name, DataType wire_dtype,
+                                   bool accumulate,
+                                   const DeviceType& device_type,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op_name, "_node"), op_name);
+  builder.Attr("T", DT_FLOAT).Attr("Twire", wire_dtype);
+  if (op_name == "_CollectiveEncode") {
+    builder.Input(FakeInput(wire_dtype)).Input(FakeInput(DT_FLOAT));
+  } else {
+    builder.Attr("accumulate", accumulate)
+        .Input(FakeInput(DT_FLOAT))
+        .Input(FakeInput(wire_dtype));
+  }
+  TF_CHECK_OK(builder.Finalize(&node_def));
+  return GetKernel(node_def, device_type, device);
+}
+
 static int64 kStepId = 123;
 
 class RingReducerTest : public ::testing::Test {
@@ -321,6 +339,7 @@ class RingReducerTest : public ::testing::Test {
       for (int i = 0; i < tensor_len; ++i) {
         expected[i] /= (num_workers * num_devices);
       }
+      Tensor first_actual;
       for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
         TF_EXPECT_OK(instances_[di]->status_);
         Tensor* inst = &instances_[di]->tensor_;
@@ -339,12 +358,25 @@ class RingReducerTest : public ::testing::Test {
                     .ok());
         }
 
+        if (di == 0) first_actual = actual;
         auto alias = actual.template unaligned_flat<T>();
         for (int i = 0; i < tensor_len; ++i) {
           switch (dtype) {
             case DT_FLOAT:
-              EXPECT_FLOAT_EQ(expected[i], alias(i))
-                  << "Mismatch at device " << di << " index " << i;
+              if (wire_dtype_ == DT_INVALID) {
+                EXPECT_FLOAT_EQ(expected[i], alias(i))
+                    << "Mismatch at device " << di << " index " << i;
+              } else {
+                // Partial sums are rounded to the wire format at every step,
+                // but all devices must still agree exactly.
+                const double rtol = wire_dtype_ == DT_HALF ? 4e-3 : 3e-2;
+                EXPECT_NEAR(expected[i], alias(i),
+                            rtol * std::abs(expected[i]))
+                    << "Mismatch at device " << di << " index " << i;
+                EXPECT_EQ(first_actual.template unaligned_flat<T>()(i),
+                          alias(i))
+                    << "Disagreement at device " << di << " index " << i;
+              }
               break;
             case DT_DOUBLE:
               EXPECT_DOUBLE_EQ(expected[i], alias(i))
@@ -468,6 +500,15 @@ class RingReducerTest : public ::testing::Test {
           GetAdd(col_params_.instance.data_type, device_type_, device_);
       col_params_.final_op =
           GetDiv(col_params_.instance.data_type, device_type_, device_);
+      if (parent_->wire_dtype_ != DT_INVALID) {
+        const DataType wire_dtype = parent_->wire_dtype_;
+        col_params_.encode_op = GetCodec("_CollectiveEncode", wire_dtype,
+                                         false, device_type_, device_);
+        col_params_.decode_op = GetCodec("_CollectiveDecode", wire_dtype,
+                                         false, device_type_, device_);
+        col_params_.decode_merge_op = GetCodec("_CollectiveDecode", wire_dtype,
+                                               true, device_type_, device_);
+      }
 
       // Prepare an OpKernelContext.
       OpKernelContext::Params op_params;
@@ -539,6 +580,8 @@ class RingReducerTest : public ::testing::Test {
 
   bool stop_ = false;
   DeviceType device_type_;
+  // Wire format of compressed reductions, DT_INVALID for none.
+  DataType wire_dtype_ = DT_INVALID;
   TestCollectiveExecutorMgr col_exec_mgr_;
   CollectiveExecutor* col_exec_;
   CollectiveRemoteAccessLocal* rma_;
@@ -677,6 +720,13 @@ TEST_F(RingReducerTest, AutomaticSubdivUpperBound) {
     }                                                                         \
   }
 
+#define DEF_COMPRESSION_TEST(C, T, W, D, S, L)                          \
+  TEST_F(RingReducerTest,                                              \
+         Compress##C##_DevTy##T##_Wkr##W##_Dev##D##_Sdiv##S##_Len##L) { \
+    wire_dtype_ = DT_##C;                                              \
+    RunTest<float>(DT_FLOAT, DEVICE_##T, W, D, S, L, 0);               \
+  }
+
 #if !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
 // Success tests
 DEF_TEST(FLOAT, CPU, 1, 2, 1, 1, 0)
@@ -697,6 +747,9 @@ DEF_TEST(INT32, CPU, 1, 2, 1, 1001, 0)
 DEF_TEST(INT32, CPU, 2, 8, 3, 4095, 0)
 DEF_TEST(INT64, CPU, 1, 2, 1, 1001, 0)
 DEF_TEST(INT64, CPU, 2, 8, 3, 4095, 0)
+DEF_COMPRESSION_TEST(HALF, CPU, 1, 2, 1, 1001)
+DEF_COMPRESSION_TEST(BFLOAT16, CPU, 2, 4, 1, 128)
+DEF_COMPRESSION_TEST(BFLOAT16, CPU, 2, 4, 2, 1001)
 
 // Failure tests
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 1)
@@ -723,6 +776,7 @@ DEF_TEST(DOUBLE, GPU, 1, 2, 1, 1001, 0)
 // INT32 values are never on the GPU.
 // DEF_TEST(INT32, GPU, 1, 2, 1, 1001, 0)
 DEF_TEST(INT64, GPU, 1, 2, 1, 1001, 0)
+DEF_COMPRESSION_TEST(HALF, GPU, 1, 2, 1, 1001)
 
 // Failure tests
 DEF_TEST(FLOAT, GPU, 1, 8, 1, 9408, 2)
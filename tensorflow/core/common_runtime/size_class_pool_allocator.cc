@@ -0,0 +1,255 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/size_class_pool_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr size_t SizeClassPoolAllocator::kMinPooledBytes;
+constexpr size_t SizeClassPoolAllocator::kMaxPooledBytes;
+constexpr int SizeClassPoolAllocator::kNumClasses;
+constexpr int SizeClassPoolAllocator::kNumThreadCacheShards;
+constexpr int SizeClassPoolAllocator::kUnpooled;
+
+// Every buffer is preceded by a header, in the kAllocatorAlignment bytes
+// before the pointer returned to the user.
+struct SizeClassPoolAllocator::Header {
+  // The memory obtained from the SubAllocator.
+  void* block;
+  size_t block_bytes;
+  size_t requested_bytes;
+  int size_class;
+};
+
+namespace {
+
+constexpr size_t kHeaderBytes = Allocator::kAllocatorAlignment;
+static_assert(kHeaderBytes >= sizeof(void*) + 3 * sizeof(size_t),
+              "The header does not fit before the buffer");
+
+void UpdateMax(std::atomic<int64>* max, int64 value) {
+  int64 current = max->load(std::memory_order_relaxed);
+  while (value > current &&
+         !max->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+SizeClassPoolAllocator::SizeClassPoolAllocator(SubAllocator* sub_allocator,
+                                               size_t max_cached_bytes,
+                                               string name)
+    : name_(std::move(name)),
+      max_cached_bytes_(max_cached_bytes),
+      // Half of the cache may be held by the threads, so that buffers freed
+      // by one thread and allocated by another are still reused.
+      thread_cache_limit_(max_cached_bytes / (2 * kNumThreadCacheShards)),
+      sub_allocator_(sub_allocator),
+      thread_caches_(new Pool[kNumThreadCacheShards]) {}
+
+SizeClassPoolAllocator::~SizeClassPoolAllocator() { Clear(); }
+
+// static
+int SizeClassPoolAllocator::ClassForSize(size_t num_bytes) {
+  if (num_bytes <= kMinPooledBytes) return 0;
+  if (num_bytes > kMaxPooledBytes) return kUnpooled;
+  // 2^e < num_bytes <= 2^(e+1), and the classes of that range are
+  // 2^e + k * 2^(e-2) for k in 1..4.
+  const int e = Log2Floor64(num_bytes - 1);
+  const size_t step = size_t{1} << (e - 2);
+  const size_t k = (num_bytes - (size_t{1} << e) + step - 1) / step;
+  return 1 + (e - Log2Floor64(kMinPooledBytes)) * 4 + (k - 1);
+}
+
+// static
+size_t SizeClassPoolAllocator::ClassSize(int size_class) {
+  if (size_class == 0) return kMinPooledBytes;
+  const int e = Log2Floor64(kMinPooledBytes) + (size_class - 1) / 4;
+  const size_t k = (size_class - 1) % 4 + 1;
+  return (size_t{1} << e) + k * (size_t{1} << (e - 2));
+}
+
+// static
+size_t SizeClassPoolAllocator::RoundedBytes(size_t num_bytes) {
+  const int size_class = ClassForSize(num_bytes);
+  return size_class == kUnpooled ? num_bytes : ClassSize(size_class);
+}
+
+// static
+SizeClassPoolAllocator::Header* SizeClassPoolAllocator::GetHeader(
+    const void* ptr) {
+  return reinterpret_cast<Header*>(
+      const_cast<char*>(static_cast<const char*>(ptr)) - kHeaderBytes);
+}
+
+SizeClassPoolAllocator::Pool*
+SizeClassPoolAllocator::ThreadCacheForCurrentThread() {
+  // As in BFCAllocator, threads are assigned caches round-robin, so that up
+  // to kNumThreadCacheShards threads never contend on a cache.
+  static std::atomic<int> next_thread_index{0};
+  static thread_local const int thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return &thread_caches_[thread_index % kNumThreadCacheShards];
+}
+
+void* SizeClassPoolAllocator::GetFromPool(Pool* pool, int size_class) {
+  mutex_lock l(pool->mu);
+  std::vector<void*>& free_list = pool->free_lists[size_class];
+  if (free_list.empty()) return nullptr;
+  void* ptr = free_list.back();
+  free_list.pop_back();
+  pool->cached_bytes -= ClassSize(size_class);
+  return ptr;
+}
+
+bool SizeClassPoolAllocator::PutInPool(Pool* pool, int size_class, void* ptr,
+                                       size_t limit) {
+  const size_t size = ClassSize(size_class);
+  mutex_lock l(pool->mu);
+  if (pool->cached_bytes + size > limit) return false;
+  pool->free_lists[size_class].push_back(ptr);
+  pool->cached_bytes += size;
+  return true;
+}
+
+void SizeClassPoolAllocator::FreeBuffer(void* ptr) {
+  const Header* header = GetHeader(ptr);
+  sub_allocator_->Free(header->block, header->block_bytes);
+}
+
+void SizeClassPoolAllocator::RecordAllocation(int64 num_bytes) {
+  num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  const int64 bytes_in_use =
+      bytes_in_use_.fetch_add(num_bytes, std::memory_order_relaxed) +
+      num_bytes;
+  UpdateMax(&peak_bytes_in_use_, bytes_in_use);
+  UpdateMax(&largest_alloc_size_, num_bytes);
+}
+
+void* SizeClassPoolAllocator::AllocateRaw(size_t alignment,
+                                          size_t num_bytes) {
+  const int size_class = alignment <= kAllocatorAlignment
+                             ? ClassForSize(num_bytes)
+                             : kUnpooled;
+  if (size_class != kUnpooled) {
+    void* ptr = GetFromPool(ThreadCacheForCurrentThread(), size_class);
+    if (ptr == nullptr) ptr = GetFromPool(&shared_pool_, size_class);
+    if (ptr != nullptr) {
+      cached_bytes_.fetch_sub(ClassSize(size_class), std::memory_order_relaxed);
+      get_from_pool_count_.fetch_add(1, std::memory_order_relaxed);
+      GetHeader(ptr)->requested_bytes = num_bytes;
+      RecordAllocation(ClassSize(size_class));
+      return ptr;
+    }
+  }
+
+  const size_t block_alignment = std::max(alignment, kAllocatorAlignment);
+  const size_t buffer_bytes =
+      size_class == kUnpooled ? num_bytes : ClassSize(size_class);
+  const size_t block_bytes = block_alignment + buffer_bytes;
+  void* block = sub_allocator_->Alloc(block_alignment, block_bytes);
+  if (block == nullptr && cached_bytes_.load() > 0) {
+    // The cached buffers may be what is missing.
+    Clear();
+    block = sub_allocator_->Alloc(block_alignment, block_bytes);
+  }
+  if (block == nullptr) return nullptr;
+  allocated_count_.fetch_add(1, std::memory_order_relaxed);
+
+  void* ptr = static_cast<char*>(block) + block_alignment;
+  Header* header = GetHeader(ptr);
+  header->block = block;
+  header->block_bytes = block_bytes;
+  header->requested_bytes = num_bytes;
+  header->size_class = size_class;
+  RecordAllocation(buffer_bytes);
+  return ptr;
+}
+
+void SizeClassPoolAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  const int size_class = GetHeader(ptr)->size_class;
+  const size_t size = size_class == kUnpooled
+                          ? GetHeader(ptr)->requested_bytes
+                          : ClassSize(size_class);
+  bytes_in_use_.fetch_sub(size, std::memory_order_relaxed);
+  if (size_class != kUnpooled) {
+    if (cached_bytes_.fetch_add(size, std::memory_order_relaxed) + size <=
+        max_cached_bytes_) {
+      if (PutInPool(ThreadCacheForCurrentThread(), size_class, ptr,
+                    thread_cache_limit_) ||
+          PutInPool(&shared_pool_, size_class, ptr, max_cached_bytes_)) {
+        return;
+      }
+    }
+    cached_bytes_.fetch_sub(size, std::memory_order_relaxed);
+  }
+  evicted_count_.fetch_add(1, std::memory_order_relaxed);
+  FreeBuffer(ptr);
+}
+
+size_t SizeClassPoolAllocator::RequestedSize(const void* ptr) const {
+  return GetHeader(ptr)->requested_bytes;
+}
+
+size_t SizeClassPoolAllocator::AllocatedSize(const void* ptr) const {
+  const Header* header = GetHeader(ptr);
+  return header->size_class == kUnpooled ? header->requested_bytes
+                                         : ClassSize(header->size_class);
+}
+
+void SizeClassPoolAllocator::Clear() {
+  auto clear = [this](Pool* pool) {
+    std::vector<void*> buffers;
+    {
+      mutex_lock l(pool->mu);
+      for (std::vector<void*>& free_list : pool->free_lists) {
+        buffers.insert(buffers.end(), free_list.begin(), free_list.end());
+        free_list.clear();
+      }
+      cached_bytes_.fetch_sub(pool->cached_bytes, std::memory_order_relaxed);
+      pool->cached_bytes = 0;
+    }
+    for (void* ptr : buffers) FreeBuffer(ptr);
+  };
+  for (int i = 0; i < kNumThreadCacheShards; ++i) {
+    clear(&thread_caches_[i]);
+  }
+  clear(&shared_pool_);
+}
+
+absl::optional<AllocatorStats> SizeClassPoolAllocator::GetStats() {
+  AllocatorStats stats;
+  stats.num_allocs = num_allocs_.load();
+  stats.bytes_in_use = bytes_in_use_.load();
+  stats.peak_bytes_in_use = peak_bytes_in_use_.load();
+  stats.largest_alloc_size = largest_alloc_size_.load();
+  stats.bytes_reserved = stats.bytes_in_use + cached_bytes_.load();
+  return stats;
+}
+
+void SizeClassPoolAllocator::ClearStats() {
+  num_allocs_.store(0);
+  peak_bytes_in_use_.store(bytes_in_use_.load());
+  largest_alloc_size_.store(0);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_POOL_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_POOL_ALLOCATOR_H_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that keeps freed buffers in pools of size classes, so that
+// the buffers of a step can be reused by the next steps of the same shapes
+// instead of being returned to the system allocator.
+//
+// Requests are rounded up to one of four size classes per power of two, so
+// that at most 25% of a buffer is wasted. Requests larger than
+// kMaxPooledBytes, or with an alignment larger than
+// Allocator::kAllocatorAlignment, are not pooled.
+//
+// Freed buffers go to a cache of the freeing thread first, then to a pool
+// shared by all threads, and are returned to the SubAllocator once
+// `max_cached_bytes` are cached in total.
+class SizeClassPoolAllocator : public Allocator {
+ public:
+  static constexpr size_t kMinPooledBytes = 256;
+  static constexpr size_t kMaxPooledBytes = 64 << 20;
+
+  // Takes ownership of `sub_allocator`.
+  SizeClassPoolAllocator(SubAllocator* sub_allocator, size_t max_cached_bytes,
+                         string name);
+  ~SizeClassPoolAllocator() override;
+
+  string Name() override { return name_; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  bool TracksAllocationSizes() const override { return true; }
+
+  size_t RequestedSize(const void* ptr) const override;
+
+  size_t AllocatedSize(const void* ptr) const override;
+
+  absl::optional<AllocatorStats> GetStats() override;
+
+  void ClearStats() override;
+
+  // Returns every cached buffer to the SubAllocator.
+  void Clear();
+
+  // Counters to monitor the effectiveness of the pool.
+
+  // Number of allocations served from a pool.
+  int64 get_from_pool_count() const { return get_from_pool_count_.load(); }
+  // Number of allocations served by the SubAllocator.
+  int64 allocated_count() const { return allocated_count_.load(); }
+  // Number of freed buffers returned to the SubAllocator.
+  int64 evicted_count() const { return evicted_count_.load(); }
+  // Number of bytes currently cached.
+  int64 cached_bytes() const { return cached_bytes_.load(); }
+
+  // Returns the size of the buffers of the class of `num_bytes`, or
+  // `num_bytes` if such buffers are not pooled.
+  static size_t RoundedBytes(size_t num_bytes);
+
+ private:
+  struct Header;
+
+  // kMinPooledBytes and the four size classes of each power of two up to
+  // kMaxPooledBytes.
+  static constexpr int kNumClasses = 1 + 4 * 18;
+  static constexpr int kNumThreadCacheShards = 16;
+  static constexpr int kUnpooled = -1;
+
+  static int ClassForSize(size_t num_bytes);
+  static size_t ClassSize(int size_class);
+  static Header* GetHeader(const void* ptr);
+
+  struct Pool {
+    mutex mu;
+    std::array<std::vector<void*>, kNumClasses> free_lists TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+  };
+
+  Pool* ThreadCacheForCurrentThread();
+
+  // Returns a cached buffer of `size_class` from `pool`, or nullptr.
+  void* GetFromPool(Pool* pool, int size_class);
+
+  // Caches `ptr` in `pool` if it holds less than `limit` bytes. Returns true
+  // if `ptr` was cached.
+  bool PutInPool(Pool* pool, int size_class, void* ptr, size_t limit);
+
+  // Returns the buffer of `ptr` to the SubAllocator.
+  void FreeBuffer(void* ptr);
+
+  void RecordAllocation(int64 num_bytes);
+
+  const string name_;
+  const size_t max_cached_bytes_;
+  const size_t thread_cache_limit_;
+  std::unique_ptr<SubAllocator> sub_allocator_;
+
+  std::unique_ptr<Pool[]> thread_caches_;
+  Pool shared_pool_;
+
+  std::atomic<int64> cached_bytes_{0};
+  std::atomic<int64> get_from_pool_count_{0};
+  std::atomic<int64> allocated_count_{0};
+  std::atomic<int64> evicted_count_{0};
+
+  // The stats are atomics rather than an AllocatorStats guarded by a mutex,
+  // so that the threads allocating from their caches never contend.
+  std::atomic<int64> num_allocs_{0};
+  std::atomic<int64> bytes_in_use_{0};
+  std::atomic<int64> peak_bytes_in_use_{0};
+  std::atomic<int64> largest_alloc_size_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SizeClassPoolAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_POOL_ALLOCATOR_H_
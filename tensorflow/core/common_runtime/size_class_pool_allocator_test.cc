@@ -0,0 +1,194 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/size_class_pool_allocator.h"
+
+#include <atomic>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Counts the blocks that are live in the underlying memory.
+class CountingSubAllocator : public SubAllocator {
+ public:
+  CountingSubAllocator(std::atomic<int>* num_allocs, std::atomic<int>* num_live)
+      : SubAllocator({}, {}), num_allocs_(num_allocs), num_live_(num_live) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    ++*num_allocs_;
+    ++*num_live_;
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    --*num_live_;
+    port::AlignedFree(ptr);
+  }
+
+ private:
+  std::atomic<int>* num_allocs_;
+  std::atomic<int>* num_live_;
+};
+
+class SizeClassPoolAllocatorTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<SizeClassPoolAllocator> MakeAllocator(
+      size_t max_cached_bytes) {
+    return absl::make_unique<SizeClassPoolAllocator>(
+        new CountingSubAllocator(&num_allocs_, &num_live_), max_cached_bytes,
+        "pool");
+  }
+
+  std::atomic<int> num_allocs_{0};
+  std::atomic<int> num_live_{0};
+};
+
+TEST_F(SizeClassPoolAllocatorTest, RoundedBytes) {
+  EXPECT_EQ(256, SizeClassPoolAllocator::RoundedBytes(1));
+  EXPECT_EQ(256, SizeClassPoolAllocator::RoundedBytes(256));
+  EXPECT_EQ(320, SizeClassPoolAllocator::RoundedBytes(257));
+  EXPECT_EQ(384, SizeClassPoolAllocator::RoundedBytes(321));
+  EXPECT_EQ(512, SizeClassPoolAllocator::RoundedBytes(500));
+  EXPECT_EQ(640, SizeClassPoolAllocator::RoundedBytes(513));
+  EXPECT_EQ(1280, SizeClassPoolAllocator::RoundedBytes(1025));
+  EXPECT_EQ(SizeClassPoolAllocator::kMaxPooledBytes,
+            SizeClassPoolAllocator::RoundedBytes(
+                SizeClassPoolAllocator::kMaxPooledBytes - 1));
+  EXPECT_EQ(SizeClassPoolAllocator::kMaxPooledBytes + 1,
+            SizeClassPoolAllocator::RoundedBytes(
+                SizeClassPoolAllocator::kMaxPooledBytes + 1));
+  // Never more than 25% larger than the request.
+  for (size_t n = 257; n < (1 << 20); n = n * 9 / 8) {
+    const size_t rounded = SizeClassPoolAllocator::RoundedBytes(n);
+    EXPECT_GE(rounded, n);
+    EXPECT_LE(rounded, n + n / 4);
+  }
+}
+
+TEST_F(SizeClassPoolAllocatorTest, ReusesBuffersOfTheSameClass) {
+  auto allocator = MakeAllocator(1 << 20);
+  void* p = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment);
+  EXPECT_EQ(1000, allocator->RequestedSize(p));
+  EXPECT_EQ(1024, allocator->AllocatedSize(p));
+  allocator->DeallocateRaw(p);
+  EXPECT_EQ(1024, allocator->cached_bytes());
+
+  // 900 bytes are in the class of 1000 bytes.
+  void* q = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 900);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(900, allocator->RequestedSize(q));
+  EXPECT_EQ(1, allocator->get_from_pool_count());
+  EXPECT_EQ(1, allocator->allocated_count());
+  EXPECT_EQ(0, allocator->cached_bytes());
+
+  // 2000 bytes are not.
+  void* r = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 2000);
+  EXPECT_NE(q, r);
+  EXPECT_EQ(2, allocator->allocated_count());
+  allocator->DeallocateRaw(q);
+  allocator->DeallocateRaw(r);
+  EXPECT_EQ(2, num_live_);
+  allocator->Clear();
+  EXPECT_EQ(0, allocator->cached_bytes());
+  EXPECT_EQ(0, num_live_);
+}
+
+TEST_F(SizeClassPoolAllocatorTest, EvictsBeyondTheLimit) {
+  auto allocator = MakeAllocator(4096);
+  std::vector<void*> buffers;
+  for (int i = 0; i < 8; ++i) {
+    buffers.push_back(allocator->AllocateRaw(16, 1024));
+  }
+  for (void* p : buffers) allocator->DeallocateRaw(p);
+  EXPECT_EQ(4096, allocator->cached_bytes());
+  EXPECT_EQ(4, allocator->evicted_count());
+  EXPECT_EQ(4, num_live_);
+  allocator.reset();
+  EXPECT_EQ(0, num_live_);
+}
+
+TEST_F(SizeClassPoolAllocatorTest, DoesNotPoolLargeOrOveralignedBuffers) {
+  auto allocator = MakeAllocator(1 << 30);
+  const size_t large = SizeClassPoolAllocator::kMaxPooledBytes + 1;
+  void* p = allocator->AllocateRaw(Allocator::kAllocatorAlignment, large);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(large, allocator->AllocatedSize(p));
+  allocator->DeallocateRaw(p);
+
+  void* q = allocator->AllocateRaw(4096, 100);
+  ASSERT_NE(nullptr, q);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(q) % 4096);
+  allocator->DeallocateRaw(q);
+
+  EXPECT_EQ(0, allocator->cached_bytes());
+  EXPECT_EQ(2, allocator->evicted_count());
+  EXPECT_EQ(0, num_live_);
+}
+
+TEST_F(SizeClassPoolAllocatorTest, Stats) {
+  auto allocator = MakeAllocator(1 << 20);
+  void* p = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  void* q = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  absl::optional<AllocatorStats> stats = allocator->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(1024 + 256, stats->bytes_in_use);
+  EXPECT_EQ(1024 + 256, stats->peak_bytes_in_use);
+  EXPECT_EQ(1024, stats->largest_alloc_size);
+
+  allocator->DeallocateRaw(p);
+  allocator->ClearStats();
+  stats = allocator->GetStats();
+  EXPECT_EQ(0, stats->num_allocs);
+  EXPECT_EQ(256, stats->bytes_in_use);
+  EXPECT_EQ(256, stats->peak_bytes_in_use);
+  EXPECT_EQ(1024 + 256, stats->bytes_reserved);
+  allocator->DeallocateRaw(q);
+}
+
+TEST_F(SizeClassPoolAllocatorTest, ConcurrentAllocations) {
+  auto allocator = MakeAllocator(1 << 20);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int t = 0; t < 8; ++t) {
+      threads.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), "test", [&allocator, t]() {
+            for (int i = 0; i < 1000; ++i) {
+              const size_t num_bytes = 64 * (1 + (i + t) % 50);
+              char* p = static_cast<char*>(allocator->AllocateRaw(
+                  Allocator::kAllocatorAlignment, num_bytes));
+              p[0] = p[num_bytes - 1] = t;
+              allocator->DeallocateRaw(p);
+            }
+          }));
+    }
+  }
+  EXPECT_EQ(8000, allocator->GetStats()->num_allocs);
+  EXPECT_EQ(0, allocator->GetStats()->bytes_in_use);
+  EXPECT_GT(allocator->get_from_pool_count(), 0);
+  allocator.reset();
+  EXPECT_EQ(0, num_live_);
+}
+
+}  // namespace
+}  // namespace tensorflow
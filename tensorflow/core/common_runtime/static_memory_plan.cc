@@ -0,0 +1,322 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t n, size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+bool LifetimesOverlap(const RecordedAllocation& a,
+                      const RecordedAllocation& b) {
+  return a.start < b.end && b.start < a.end;
+}
+
+}  // namespace
+
+StaticMemoryPlan::StaticMemoryPlan(
+    int num_nodes, const std::vector<RecordedAllocation>& allocations)
+    : entries_(allocations.size()), node_entries_(num_nodes) {
+  for (int i = 0; i < static_cast<int>(allocations.size()); ++i) {
+    const RecordedAllocation& a = allocations[i];
+    Entry& e = entries_[i];
+    e.alignment = std::max(a.alignment, Allocator::kAllocatorAlignment);
+    e.size =
+        RoundUp(std::max<size_t>(a.size, 1), Allocator::kAllocatorAlignment);
+    alignment_ = std::max(alignment_, e.alignment);
+    std::vector<int>& node_entries = node_entries_[a.node_id];
+    if (static_cast<int>(node_entries.size()) <= a.index) {
+      node_entries.resize(a.index + 1, -1);
+    }
+    node_entries[a.index] = i;
+  }
+
+  // Place the largest allocations first.
+  std::vector<int> order(allocations.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    if (entries_[a].size != entries_[b].size) {
+      return entries_[a].size > entries_[b].size;
+    }
+    return allocations[a].start < allocations[b].start;
+  });
+  // The entries placed so far, sorted by offset.
+  std::vector<int> placed;
+  placed.reserve(allocations.size());
+  for (int i : order) {
+    Entry& e = entries_[i];
+    size_t offset = 0;
+    for (int j : placed) {
+      if (!LifetimesOverlap(allocations[i], allocations[j])) continue;
+      const Entry& other = entries_[j];
+      if (offset + e.size <= other.offset) break;
+      offset =
+          std::max(offset, RoundUp(other.offset + other.size, e.alignment));
+    }
+    e.offset = offset;
+    total_bytes_ = std::max(total_bytes_, offset + e.size);
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), i,
+                                   [this](int a, int b) {
+                                     return entries_[a].offset <
+                                            entries_[b].offset;
+                                   }),
+                  i);
+  }
+
+  for (int i = 0; i < static_cast<int>(placed.size()); ++i) {
+    const int a = placed[i];
+    entries_by_offset_[entries_[a].offset].push_back(a);
+    for (int k = i + 1; k < static_cast<int>(placed.size()); ++k) {
+      const int b = placed[k];
+      if (entries_[b].offset >= entries_[a].offset + entries_[a].size) break;
+      entries_[a].overlaps.push_back(b);
+      entries_[b].overlaps.push_back(a);
+    }
+  }
+  VLOG(1) << "Planned " << entries_.size() << " allocations in "
+          << total_bytes_ << " bytes";
+}
+
+StaticMemoryPlan::~StaticMemoryPlan() {
+  if (spare_buffer_ != nullptr) {
+    spare_allocator_->DeallocateRaw(spare_buffer_);
+  }
+}
+
+void* StaticMemoryPlan::TakeBuffer(Allocator* allocator) {
+  {
+    mutex_lock l(mu_);
+    if (spare_buffer_ != nullptr && spare_allocator_ == allocator) {
+      void* buffer = spare_buffer_;
+      spare_buffer_ = nullptr;
+      return buffer;
+    }
+  }
+  return allocator->AllocateRaw(alignment_, total_bytes_);
+}
+
+void StaticMemoryPlan::ReturnBuffer(Allocator* allocator, void* buffer) {
+  {
+    mutex_lock l(mu_);
+    if (spare_buffer_ == nullptr) {
+      spare_buffer_ = buffer;
+      spare_allocator_ = allocator;
+      return;
+    }
+  }
+  allocator->DeallocateRaw(buffer);
+}
+
+class StaticMemoryPlanStep::NodeAllocator : public Allocator {
+ public:
+  void Init(StaticMemoryPlanStep* step, int node_id) {
+    step_ = step;
+    node_id_ = node_id;
+  }
+
+  std::string Name() override {
+    return strings::StrCat("static_plan_", step_->base_allocator_->Name());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    return step_->Allocate(node_id_, alignment, num_bytes, allocation_attr);
+  }
+  void DeallocateRaw(void* ptr) override { step_->Deallocate(ptr); }
+
+ private:
+  StaticMemoryPlanStep* step_ = nullptr;
+  int node_id_ = -1;
+};
+
+StaticMemoryPlanStep::StaticMemoryPlanStep(StaticMemoryPlanner* planner,
+                                           Allocator* base_allocator,
+                                           int num_nodes)
+    : planner_(planner),
+      base_allocator_(base_allocator),
+      num_nodes_(num_nodes),
+      node_allocators_(new NodeAllocator[num_nodes]),
+      next_index_(new std::atomic<int>[num_nodes]()) {
+  for (int i = 0; i < num_nodes; ++i) {
+    node_allocators_[i].Init(this, i);
+  }
+}
+
+StaticMemoryPlanStep::StaticMemoryPlanStep(
+    std::shared_ptr<StaticMemoryPlan> plan, Allocator* base_allocator,
+    int num_nodes)
+    : StaticMemoryPlanStep(nullptr, base_allocator, num_nodes) {
+  plan_ = std::move(plan);
+  if (plan_->num_entries() > 0) {
+    buffer_ = static_cast<char*>(plan_->TakeBuffer(base_allocator_));
+    live_.reset(new std::atomic<bool>[plan_->num_entries()]());
+  }
+}
+
+StaticMemoryPlanStep::~StaticMemoryPlanStep() {
+  DCHECK_EQ(refs_.load(), 0);
+  if (buffer_ != nullptr) {
+    plan_->ReturnBuffer(base_allocator_, buffer_);
+  }
+}
+
+Allocator* StaticMemoryPlanStep::node_allocator(int node_id) {
+  DCHECK_GE(node_id, 0);
+  DCHECK_LT(node_id, num_nodes_);
+  return &node_allocators_[node_id];
+}
+
+void StaticMemoryPlanStep::EndStep() {
+  if (is_recording()) {
+    std::vector<RecordedAllocation> allocations;
+    {
+      mutex_lock l(mu_);
+      DCHECK(!step_ended_);
+      step_ended_ = true;
+      // Allocations that are still live, e.g. fetched tensors, escape the
+      // step and cannot be planned.
+      for (const RecordedAllocation& a : records_) {
+        if (a.end >= 0) allocations.push_back(a);
+      }
+      records_.clear();
+      record_index_.clear();
+    }
+    planner_->SetPlan(
+        std::make_shared<StaticMemoryPlan>(num_nodes_, allocations));
+    planner_ = nullptr;
+  }
+  Unref();
+}
+
+void* StaticMemoryPlanStep::Allocate(
+    int node_id, size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const int index =
+      next_index_[node_id].fetch_add(1, std::memory_order_relaxed);
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  if (buffer_ != nullptr) {
+    const int e = plan_->Find(node_id, index);
+    if (e >= 0) {
+      const StaticMemoryPlan::Entry& entry = plan_->entry(e);
+      if (num_bytes <= entry.size && alignment <= entry.alignment &&
+          AcquireEntry(e)) {
+        return buffer_ + entry.offset;
+      }
+    }
+  }
+
+  void* ptr = base_allocator_->AllocateRaw(alignment, num_bytes,
+                                           allocation_attr);
+  if (ptr == nullptr) {
+    Unref();
+    return nullptr;
+  }
+  if (is_recording()) {
+    mutex_lock l(mu_);
+    if (!step_ended_) {
+      record_index_[ptr] = records_.size();
+      records_.push_back(
+          {node_id, index, num_bytes, alignment, clock_++, /*end=*/-1});
+    }
+  }
+  return ptr;
+}
+
+bool StaticMemoryPlanStep::AcquireEntry(int e) {
+  // Mark the entry before checking its neighbors, so that of two entries
+  // acquired concurrently, at least one sees the other.
+  live_[e].store(true);
+  for (int other : plan_->entry(e).overlaps) {
+    if (live_[other].load()) {
+      live_[e].store(false);
+      return false;
+    }
+  }
+  return true;
+}
+
+void StaticMemoryPlanStep::Deallocate(void* ptr) {
+  char* p = static_cast<char*>(ptr);
+  if (buffer_ != nullptr && p >= buffer_ &&
+      p < buffer_ + plan_->total_bytes()) {
+    // Entries that start at the same offset share memory, so at most one of
+    // them is live.
+    const std::vector<int>* entries = plan_->EntriesAt(p - buffer_);
+    DCHECK(entries != nullptr);
+    for (int e : *entries) {
+      if (live_[e].load()) {
+        live_[e].store(false, std::memory_order_release);
+        break;
+      }
+    }
+  } else {
+    if (is_recording()) {
+      mutex_lock l(mu_);
+      auto it = record_index_.find(ptr);
+      if (it != record_index_.end()) {
+        records_[it->second].end = clock_++;
+        record_index_.erase(it);
+      }
+    }
+    base_allocator_->DeallocateRaw(ptr);
+  }
+  Unref();
+}
+
+void StaticMemoryPlanStep::Unref() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+StaticMemoryPlanStep* StaticMemoryPlanner::BeginStep(
+    Allocator* base_allocator) {
+  std::shared_ptr<StaticMemoryPlan> plan;
+  {
+    mutex_lock l(mu_);
+    if (plan_ == nullptr) {
+      if (recording_) return nullptr;
+      recording_ = true;
+      return new StaticMemoryPlanStep(this, base_allocator, num_nodes_);
+    }
+    plan = plan_;
+  }
+  return new StaticMemoryPlanStep(std::move(plan), base_allocator, num_nodes_);
+}
+
+std::shared_ptr<const StaticMemoryPlan> StaticMemoryPlanner::plan() {
+  mutex_lock l(mu_);
+  return plan_;
+}
+
+void StaticMemoryPlanner::SetPlan(std::shared_ptr<StaticMemoryPlan> plan) {
+  mutex_lock l(mu_);
+  plan_ = std::move(plan);
+  recording_ = false;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,216 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class StaticMemoryPlanner;
+
+// A kernel allocation observed while recording a step.
+struct RecordedAllocation {
+  int node_id;
+  // The rank of this allocation among those made by `node_id` in the step.
+  int index;
+  size_t size;
+  size_t alignment;
+  // Logical times of the allocation and of the deallocation.
+  int64 start;
+  int64 end;
+};
+
+// Assigns offsets in a single buffer to the allocations recorded during one
+// step, so that allocations with overlapping lifetimes never share memory.
+// The offsets are assigned greedily, largest allocation first, at the lowest
+// offset that does not conflict with the allocations already placed (as in
+// TF Lite's ArenaPlanner).
+//
+// The plan also caches the buffer of one completed step, so that steps that
+// do not overlap reuse the same memory.
+class StaticMemoryPlan {
+ public:
+  struct Entry {
+    size_t offset;
+    size_t size;
+    size_t alignment;
+    // The entries whose memory intersects this one. Their recorded lifetimes
+    // are disjoint from this entry's.
+    std::vector<int> overlaps;
+  };
+
+  // `allocations` must only contain allocations that were freed before the
+  // end of the recorded step.
+  StaticMemoryPlan(int num_nodes,
+                   const std::vector<RecordedAllocation>& allocations);
+  ~StaticMemoryPlan();
+
+  size_t total_bytes() const { return total_bytes_; }
+  int num_entries() const { return entries_.size(); }
+  const Entry& entry(int i) const { return entries_[i]; }
+
+  // Returns the entry planned for the `index`-th allocation of `node_id`, or
+  // -1 if there is none.
+  int Find(int node_id, int index) const {
+    const std::vector<int>& node_entries = node_entries_[node_id];
+    if (index >= static_cast<int>(node_entries.size())) return -1;
+    return node_entries[index];
+  }
+
+  // Returns the entries that start at `offset`, or nullptr if none.
+  const std::vector<int>* EntriesAt(size_t offset) const {
+    auto it = entries_by_offset_.find(offset);
+    return it == entries_by_offset_.end() ? nullptr : &it->second;
+  }
+
+  // Returns a buffer of `total_bytes()`, or nullptr on allocation failure.
+  void* TakeBuffer(Allocator* allocator) TF_LOCKS_EXCLUDED(mu_);
+  // Returns a buffer obtained from `TakeBuffer(allocator)`.
+  void ReturnBuffer(Allocator* allocator, void* buffer) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  std::vector<Entry> entries_;
+  // Indexed by node id, then by allocation rank. -1 if not planned.
+  std::vector<std::vector<int>> node_entries_;
+  absl::flat_hash_map<size_t, std::vector<int>> entries_by_offset_;
+  size_t total_bytes_ = 0;
+  size_t alignment_ = Allocator::kAllocatorAlignment;
+
+  mutex mu_;
+  void* spare_buffer_ TF_GUARDED_BY(mu_) = nullptr;
+  Allocator* spare_allocator_ TF_GUARDED_BY(mu_) = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryPlan);
+};
+
+// The kernel allocations of one step of an executor with a
+// StaticMemoryPlanner. Depending on the state of the planner, the step either
+// records the allocations made through `node_allocator()` and forwards them
+// to the base allocator, or serves them from the planned buffer.
+//
+// A planned allocation is only served if its size and alignment fit the plan
+// and no allocation that shares its memory is live; otherwise, e.g. if
+// kernels ran in a different order than in the recorded step, it falls back
+// to the base allocator. Planned memory is therefore never handed out twice.
+//
+// `EndStep()` must be called exactly once when the step is done. As for
+// StepArenaAllocator, the object deletes itself once every buffer it returned
+// has been deallocated, since tensors that escape the step (e.g. fetches)
+// keep a pointer to their allocator; the planned buffer is only reused after
+// then.
+class StaticMemoryPlanStep {
+ public:
+  // Returns the allocator that serves the allocations of node `node_id`.
+  Allocator* node_allocator(int node_id);
+
+  // Marks the end of the step. A recording step hands its allocations over
+  // to the planner.
+  void EndStep();
+
+  bool is_recording() const { return plan_ == nullptr; }
+
+ private:
+  friend class StaticMemoryPlanner;
+  class NodeAllocator;
+
+  // Recording step.
+  StaticMemoryPlanStep(StaticMemoryPlanner* planner,
+                       Allocator* base_allocator, int num_nodes);
+  // Planned step.
+  StaticMemoryPlanStep(std::shared_ptr<StaticMemoryPlan> plan,
+                       Allocator* base_allocator, int num_nodes);
+  ~StaticMemoryPlanStep();
+
+  void* Allocate(int node_id, size_t alignment, size_t num_bytes,
+                 const AllocationAttributes& allocation_attr);
+  void Deallocate(void* ptr);
+  // Marks entry `e` live. Returns false, and leaves the entry free, if an
+  // entry that shares its memory is live.
+  bool AcquireEntry(int e);
+  void Unref();
+
+  // Non-null iff recording, until `EndStep()`.
+  StaticMemoryPlanner* planner_;
+  // Null iff recording.
+  std::shared_ptr<StaticMemoryPlan> plan_;
+  Allocator* const base_allocator_;  // Not owned.
+  const int num_nodes_;
+  std::unique_ptr<NodeAllocator[]> node_allocators_;
+  std::unique_ptr<std::atomic<int>[]> next_index_;
+
+  // Planned step.
+  char* buffer_ = nullptr;
+  std::unique_ptr<std::atomic<bool>[]> live_;
+
+  // Recording step. The `end` of an allocation is -1 until it is freed.
+  mutex mu_;
+  std::vector<RecordedAllocation> records_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<void*, int> record_index_ TF_GUARDED_BY(mu_);
+  int64 clock_ TF_GUARDED_BY(mu_) = 0;
+  bool step_ended_ TF_GUARDED_BY(mu_) = false;
+
+  // One reference for the step, plus one per live allocation.
+  std::atomic<int64> refs_{1};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryPlanStep);
+};
+
+// Plans the memory of a graph that is executed repeatedly with the same
+// shapes, e.g. by a DirectSession callable: the first step records the
+// sizes and lifetimes of kernel allocations, and the following steps serve
+// each of them from a slice of a single pre-planned buffer, instead of
+// calling the device allocator.
+//
+// Thread-safe. Steps that start while the first step is recorded do not use
+// the planner.
+class StaticMemoryPlanner {
+ public:
+  // `num_nodes` is the number of node ids of the executed graph.
+  explicit StaticMemoryPlanner(int num_nodes) : num_nodes_(num_nodes) {}
+
+  // Returns a new step allocating from `base_allocator`, or nullptr if the
+  // step must use the device allocator.
+  StaticMemoryPlanStep* BeginStep(Allocator* base_allocator)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the plan, or nullptr if no step has been recorded yet.
+  std::shared_ptr<const StaticMemoryPlan> plan() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  friend class StaticMemoryPlanStep;
+  void SetPlan(std::shared_ptr<StaticMemoryPlan> plan) TF_LOCKS_EXCLUDED(mu_);
+
+  const int num_nodes_;
+  mutex mu_;
+  bool recording_ TF_GUARDED_BY(mu_) = false;
+  std::shared_ptr<StaticMemoryPlan> plan_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryPlanner);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
@@ -0,0 +1,180 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Counts the buffers that are live in the base allocator.
+class CountingAllocator : public Allocator {
+ public:
+  std::string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations_;
+    ++num_live_;
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void DeallocateRaw(void* ptr) override {
+    --num_live_;
+    port::AlignedFree(ptr);
+  }
+
+  int num_allocations() const { return num_allocations_; }
+  int num_live() const { return num_live_; }
+
+ private:
+  std::atomic<int> num_allocations_{0};
+  std::atomic<int> num_live_{0};
+};
+
+TEST(StaticMemoryPlanTest, DisjointLifetimesShareMemory) {
+  // a: [0, 2), b: [1, 3), c: [2, 4).
+  StaticMemoryPlan plan(3, {{0, 0, 100, 64, 0, 2},
+                            {1, 0, 200, 64, 1, 3},
+                            {2, 0, 100, 64, 2, 4}});
+  ASSERT_EQ(3, plan.num_entries());
+  EXPECT_EQ(0, plan.Find(0, 0));
+  EXPECT_EQ(1, plan.Find(1, 0));
+  EXPECT_EQ(-1, plan.Find(1, 1));
+  // The largest allocation goes first.
+  EXPECT_EQ(0, plan.entry(1).offset);
+  EXPECT_EQ(256, plan.entry(1).size);
+  EXPECT_EQ(256, plan.entry(0).offset);
+  EXPECT_EQ(256, plan.entry(2).offset);
+  EXPECT_EQ(384, plan.total_bytes());
+  EXPECT_EQ(std::vector<int>({2}), plan.entry(0).overlaps);
+  EXPECT_TRUE(plan.entry(1).overlaps.empty());
+  ASSERT_NE(nullptr, plan.EntriesAt(256));
+  EXPECT_EQ(2, plan.EntriesAt(256)->size());
+  EXPECT_EQ(nullptr, plan.EntriesAt(64));
+}
+
+TEST(StaticMemoryPlanTest, AlignedOffsets) {
+  StaticMemoryPlan plan(2, {{0, 0, 64, 64, 0, 2}, {1, 0, 64, 256, 1, 3}});
+  EXPECT_EQ(0, plan.entry(0).offset);
+  EXPECT_EQ(256, plan.entry(1).offset);
+  EXPECT_EQ(320, plan.total_bytes());
+}
+
+// Runs a step in which node 0 allocates `a` and `b`, node 1 allocates `c`
+// after `a` is freed, and node 2 allocates an output that escapes the step.
+// Returns the escaped pointer.
+void* RunStep(StaticMemoryPlanStep* step, std::vector<void*>* ptrs) {
+  Allocator* n0 = step->node_allocator(0);
+  Allocator* n1 = step->node_allocator(1);
+  Allocator* n2 = step->node_allocator(2);
+  void* a = n0->AllocateRaw(64, 1000);
+  void* b = n0->AllocateRaw(64, 500);
+  n0->DeallocateRaw(a);
+  void* c = n1->AllocateRaw(64, 1000);
+  void* out = n2->AllocateRaw(64, 16);
+  n0->DeallocateRaw(b);
+  n1->DeallocateRaw(c);
+  *ptrs = {a, b, c};
+  return out;
+}
+
+TEST(StaticMemoryPlanTest, RecordsThenServesFromPlan) {
+  CountingAllocator base;
+  StaticMemoryPlanner planner(3);
+  EXPECT_EQ(nullptr, planner.plan());
+
+  StaticMemoryPlanStep* step = planner.BeginStep(&base);
+  ASSERT_NE(nullptr, step);
+  EXPECT_TRUE(step->is_recording());
+  // Only one step is recorded at a time.
+  EXPECT_EQ(nullptr, planner.BeginStep(&base));
+  std::vector<void*> ptrs;
+  void* out = RunStep(step, &ptrs);
+  EXPECT_EQ(4, base.num_allocations());
+  step->EndStep();
+  Allocator* escaped_allocator = step->node_allocator(2);
+  escaped_allocator->DeallocateRaw(out);
+  EXPECT_EQ(0, base.num_live());
+
+  std::shared_ptr<const StaticMemoryPlan> plan = planner.plan();
+  ASSERT_NE(nullptr, plan);
+  // `out` escaped the step; `a` and `c` share memory.
+  EXPECT_EQ(3, plan->num_entries());
+  EXPECT_EQ(1536, plan->total_bytes());
+
+  step = planner.BeginStep(&base);
+  ASSERT_NE(nullptr, step);
+  EXPECT_FALSE(step->is_recording());
+  out = RunStep(step, &ptrs);
+  // The buffer, and the escaped output.
+  EXPECT_EQ(6, base.num_allocations());
+  EXPECT_EQ(ptrs[0], ptrs[2]);
+  EXPECT_NE(ptrs[0], ptrs[1]);
+  step->EndStep();
+  // The escaped output does not pin the buffer.
+  EXPECT_EQ(2, base.num_live());
+  escaped_allocator = step->node_allocator(2);
+  escaped_allocator->DeallocateRaw(out);
+  // The buffer is kept by the plan for the next step.
+  EXPECT_EQ(1, base.num_live());
+
+  step = planner.BeginStep(&base);
+  std::vector<void*> next_ptrs;
+  out = RunStep(step, &next_ptrs);
+  EXPECT_EQ(ptrs, next_ptrs);
+  EXPECT_EQ(7, base.num_allocations());
+  step->node_allocator(2)->DeallocateRaw(out);
+  step->EndStep();
+}
+
+TEST(StaticMemoryPlanTest, ConflictsFallBack) {
+  CountingAllocator base;
+  StaticMemoryPlanner planner(2);
+  StaticMemoryPlanStep* step = planner.BeginStep(&base);
+  void* a = step->node_allocator(0)->AllocateRaw(64, 1000);
+  step->node_allocator(0)->DeallocateRaw(a);
+  void* b = step->node_allocator(1)->AllocateRaw(64, 1000);
+  step->node_allocator(1)->DeallocateRaw(b);
+  step->EndStep();
+  ASSERT_EQ(1024, planner.plan()->total_bytes());
+
+  // Node 1 runs before node 0 is done, unlike in the recorded step.
+  step = planner.BeginStep(&base);
+  b = step->node_allocator(1)->AllocateRaw(64, 1000);
+  a = step->node_allocator(0)->AllocateRaw(64, 1000);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(4, base.num_allocations());
+  memset(a, 1, 1000);
+  memset(b, 2, 1000);
+  EXPECT_EQ(2, static_cast<char*>(b)[999]);
+  step->node_allocator(0)->DeallocateRaw(a);
+  step->node_allocator(1)->DeallocateRaw(b);
+  step->EndStep();
+
+  // Larger than planned.
+  step = planner.BeginStep(&base);
+  a = step->node_allocator(0)->AllocateRaw(64, 2000);
+  EXPECT_EQ(5, base.num_allocations());
+  step->node_allocator(0)->DeallocateRaw(a);
+  step->EndStep();
+  // Only the cached buffer is left.
+  EXPECT_EQ(1, base.num_live());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+#include <new>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t n, size_t alignment) {
+  return (n + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+struct StepArenaAllocator::ChunkHeader {
+  // Number of live allocations in this chunk, plus one while it is the
+  // current chunk. A fallback buffer holds a single allocation.
+  std::atomic<int64> pending;
+};
+
+// The header occupies the first `kHeaderSize` bytes of every chunk, so that
+// allocations keep the default alignment.
+static constexpr size_t kHeaderSize = Allocator::kAllocatorAlignment;
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base_allocator,
+                                       size_t chunk_size)
+    : base_allocator_(base_allocator),
+      chunk_size_(chunk_size),
+      max_arena_allocation_(chunk_size / 4) {
+  static_assert(sizeof(ChunkHeader) <= kHeaderSize,
+                "ChunkHeader does not fit in kHeaderSize");
+  CHECK_GT(chunk_size, 2 * kHeaderSize);
+  CHECK_EQ(chunk_size & (chunk_size - 1), 0)
+      << "chunk_size must be a power of two: " << chunk_size;
+}
+
+StepArenaAllocator::~StepArenaAllocator() { DCHECK_EQ(refs_.load(), 0); }
+
+std::string StepArenaAllocator::Name() {
+  return strings::StrCat("step_arena_", base_allocator_->Name());
+}
+
+void StepArenaAllocator::EndStep() {
+  {
+    mutex_lock l(mu_);
+    DCHECK(!step_ended_);
+    step_ended_ = true;
+    RetireCurrentChunk();
+  }
+  Unref();
+}
+
+int64 StepArenaAllocator::num_live_chunks() {
+  mutex_lock l(mu_);
+  return refs_.load() - (step_ended_ ? 0 : 1);
+}
+
+void* StepArenaAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  alignment = std::max(alignment, Allocator::kAllocatorAlignment);
+  // Never return an empty range, so that a pointer cannot point at the end of
+  // its chunk, and be attributed to the next chunk by `DeallocateRaw()`.
+  const size_t bytes = RoundUp(std::max<size_t>(num_bytes, 1), alignment);
+  if (bytes > max_arena_allocation_ || alignment > kHeaderSize) {
+    return AllocateFallback(alignment, num_bytes, allocation_attr);
+  }
+
+  mutex_lock l(mu_);
+  DCHECK(!step_ended_) << "Allocation after the end of the step";
+  size_t offset = RoundUp(current_offset_, alignment);
+  if (current_ == nullptr || offset + bytes > chunk_size_) {
+    RetireCurrentChunk();
+    void* chunk = base_allocator_->AllocateRaw(chunk_size_, chunk_size_,
+                                               allocation_attr);
+    if (chunk == nullptr) return nullptr;
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    current_ = new (chunk) ChunkHeader;
+    current_->pending.store(1, std::memory_order_relaxed);
+    offset = kHeaderSize;
+  }
+  current_offset_ = offset + bytes;
+  current_->pending.fetch_add(1, std::memory_order_relaxed);
+  return reinterpret_cast<char*>(current_) + offset;
+}
+
+void* StepArenaAllocator::AllocateFallback(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const size_t header_size = std::max(alignment, kHeaderSize);
+  CHECK_LT(header_size, chunk_size_) << "Unsupported alignment " << alignment;
+  void* buffer = base_allocator_->AllocateRaw(
+      chunk_size_, header_size + num_bytes, allocation_attr);
+  if (buffer == nullptr) return nullptr;
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  ChunkHeader* header = new (buffer) ChunkHeader;
+  header->pending.store(1, std::memory_order_relaxed);
+  return static_cast<char*>(buffer) + header_size;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  ChunkHeader* header = reinterpret_cast<ChunkHeader*>(
+      reinterpret_cast<uintptr_t>(ptr) & ~(chunk_size_ - 1));
+  if (header->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    ReleaseChunk(header);
+  }
+}
+
+void StepArenaAllocator::RetireCurrentChunk() {
+  if (current_ == nullptr) return;
+  if (current_->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    ReleaseChunk(current_);
+  }
+  current_ = nullptr;
+  current_offset_ = 0;
+}
+
+void StepArenaAllocator::ReleaseChunk(ChunkHeader* header) {
+  header->~ChunkHeader();
+  base_allocator_->DeallocateRaw(header);
+  Unref();
+}
+
+void StepArenaAllocator::Unref() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+}  // namespace tensorflow
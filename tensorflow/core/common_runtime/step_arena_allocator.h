@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <string>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An Allocator that bump-allocates short-lived buffers for a single step out
+// of large chunks obtained from a base allocator.
+//
+// Unlike `core::Arena`, memory is returned to the base allocator chunk by
+// chunk: each chunk counts its live allocations, and is released once it is
+// no longer the current chunk and all of its allocations have been
+// deallocated. A tensor that escapes the step (e.g. a fetched output) is
+// therefore always safe; it only keeps its chunk alive. Requests that are too
+// large for a chunk fall back to the base allocator.
+//
+// A StepArenaAllocator is created at the beginning of a step and `EndStep()`
+// must be called exactly once when the step is done. The object deletes
+// itself when the step has ended and every buffer it returned has been
+// deallocated, because tensors keep a pointer to their allocator.
+//
+// Both chunks and fallback buffers are allocated on `chunk_size` boundaries
+// and start with a small header, so that `DeallocateRaw()` can find the
+// header of any pointer by masking its low bits.
+class StepArenaAllocator : public Allocator {
+ public:
+  static constexpr size_t kDefaultChunkSize = 1 << 20;
+
+  // `base_allocator` is not owned and must outlive every buffer allocated by
+  // this object. `chunk_size` must be a power of two.
+  explicit StepArenaAllocator(Allocator* base_allocator,
+                              size_t chunk_size = kDefaultChunkSize);
+
+  // Marks the end of the step. No further allocations may be made.
+  void EndStep() TF_LOCKS_EXCLUDED(mu_);
+
+  std::string Name() override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr)
+      TF_LOCKS_EXCLUDED(mu_) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Returns the number of chunks (including fallback buffers) that have not
+  // been returned to the base allocator. For testing.
+  int64 num_live_chunks() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  ~StepArenaAllocator() override;
+
+  struct ChunkHeader;
+
+  // Releases the reference that the allocator holds on `current_`.
+  void RetireCurrentChunk() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void* AllocateFallback(size_t alignment, size_t num_bytes,
+                         const AllocationAttributes& allocation_attr);
+  void ReleaseChunk(ChunkHeader* header);
+  void Unref();
+
+  Allocator* const base_allocator_;  // Not owned.
+  const size_t chunk_size_;
+  // Largest request served from a chunk.
+  const size_t max_arena_allocation_;
+
+  mutex mu_;
+  ChunkHeader* current_ TF_GUARDED_BY(mu_) = nullptr;
+  size_t current_offset_ TF_GUARDED_BY(mu_) = 0;
+  bool step_ended_ TF_GUARDED_BY(mu_) = false;
+
+  // One reference for the step, plus one per live chunk or fallback buffer.
+  std::atomic<int64> refs_{1};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,160 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Counts the buffers that are live in the base allocator.
+class CountingAllocator : public Allocator {
+ public:
+  std::string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations_;
+    ++num_live_;
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void DeallocateRaw(void* ptr) override {
+    --num_live_;
+    port::AlignedFree(ptr);
+  }
+
+  int num_allocations() const { return num_allocations_; }
+  int num_live() const { return num_live_; }
+
+ private:
+  std::atomic<int> num_allocations_{0};
+  std::atomic<int> num_live_{0};
+};
+
+constexpr size_t kChunkSize = 4096;
+
+TEST(StepArenaAllocatorTest, SmallAllocationsShareAChunk) {
+  CountingAllocator base;
+  StepArenaAllocator* arena = new StepArenaAllocator(&base, kChunkSize);
+  EXPECT_EQ("step_arena_counting", arena->Name());
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 8; ++i) {
+    void* p = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+    ASSERT_NE(nullptr, p);
+    EXPECT_EQ(0,
+              reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment);
+    ptrs.push_back(p);
+  }
+  EXPECT_EQ(1, base.num_allocations());
+  EXPECT_EQ(1, arena->num_live_chunks());
+  for (void* p : ptrs) arena->DeallocateRaw(p);
+  // The current chunk is kept until the end of the step.
+  EXPECT_EQ(1, base.num_live());
+
+  arena->EndStep();
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, FullChunksAreReleasedWhenDrained) {
+  CountingAllocator base;
+  StepArenaAllocator* arena = new StepArenaAllocator(&base, kChunkSize);
+
+  // Each allocation takes a quarter of a chunk, so that the chunk header
+  // pushes every fourth allocation to a new chunk.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 12; ++i) {
+    ptrs.push_back(arena->AllocateRaw(Allocator::kAllocatorAlignment,
+                                      kChunkSize / 4));
+  }
+  EXPECT_EQ(4, base.num_allocations());
+  for (int i = 0; i < 3; ++i) arena->DeallocateRaw(ptrs[i]);
+  EXPECT_EQ(3, base.num_live());
+  for (int i = 3; i < 12; ++i) arena->DeallocateRaw(ptrs[i]);
+  EXPECT_EQ(1, base.num_live());
+
+  arena->EndStep();
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, LargeAllocationsFallBack) {
+  CountingAllocator base;
+  StepArenaAllocator* arena = new StepArenaAllocator(&base, kChunkSize);
+
+  void* large = arena->AllocateRaw(Allocator::kAllocatorAlignment,
+                                   3 * kChunkSize);
+  ASSERT_NE(nullptr, large);
+  void* small = arena->AllocateRaw(Allocator::kAllocatorAlignment, 16);
+  ASSERT_NE(nullptr, small);
+  EXPECT_EQ(2, base.num_allocations());
+
+  // The whole buffer is usable.
+  memset(large, 0xab, 3 * kChunkSize);
+  arena->DeallocateRaw(large);
+  EXPECT_EQ(1, base.num_live());
+  arena->DeallocateRaw(small);
+  arena->EndStep();
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, AllocationsOutliveTheStep) {
+  CountingAllocator base;
+  StepArenaAllocator* arena = new StepArenaAllocator(&base, kChunkSize);
+
+  void* escaped = arena->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* large = arena->AllocateRaw(Allocator::kAllocatorAlignment, kChunkSize);
+  arena->EndStep();
+  EXPECT_EQ(2, base.num_live());
+
+  // `arena` deletes itself when the last buffer is returned.
+  arena->DeallocateRaw(escaped);
+  EXPECT_EQ(1, base.num_live());
+  arena->DeallocateRaw(large);
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, ZeroByteAllocationsAreDistinct) {
+  CountingAllocator base;
+  StepArenaAllocator* arena = new StepArenaAllocator(&base, kChunkSize);
+  void* a = arena->AllocateRaw(Allocator::kAllocatorAlignment, 0);
+  void* b = arena->AllocateRaw(Allocator::kAllocatorAlignment, 0);
+  EXPECT_NE(a, b);
+  arena->DeallocateRaw(a);
+  arena->DeallocateRaw(b);
+  arena->EndStep();
+  EXPECT_EQ(0, base.num_live());
+}
+
+TEST(StepArenaAllocatorTest, TensorsUseTheArena) {
+  CountingAllocator base;
+  StepArenaAllocator* arena = new StepArenaAllocator(&base, kChunkSize);
+  {
+    Tensor t1(arena, DT_FLOAT, TensorShape({4, 4}));
+    Tensor t2(arena, DT_INT32, TensorShape({8}));
+    t1.flat<float>().setZero();
+    t2.flat<int32>().setConstant(7);
+    EXPECT_EQ(1, base.num_allocations());
+    arena->EndStep();
+    EXPECT_EQ(7, t2.flat<int32>()(3));
+  }
+  EXPECT_EQ(0, base.num_live());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
+#include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -68,5 +70,25 @@ TEST(ThreadPoolDeviceTest, CopyTensor) {
   device_context->Unref();
 }
 
+TEST(ThreadPoolDeviceTest, OneDevicePerNumaNode) {
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory(DEVICE_CPU)->CreateDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+  ASSERT_EQ(port::NUMANumNodes(), static_cast<int>(devices.size()));
+  for (int i = 0; i < devices.size(); ++i) {
+    EXPECT_EQ(i, devices[i]->attributes().locality().numa_node());
+    EXPECT_NE(nullptr, devices[i]->tensorflow_cpu_worker_threads());
+  }
+
+  // `device_count` still sets the number of devices.
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  devices.clear();
+  TF_ASSERT_OK(DeviceFactory::GetFactory(DEVICE_CPU)->CreateDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+  EXPECT_EQ(2, devices.size());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,185 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUES_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUES_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// WorkStealingQueues is a set of per-worker double-ended queues of items,
+// for use by the work-stealing ExecutorState scheduler.
+//
+// Each worker owns a deque, identified by an integer in
+// [0, num_deques()). A worker pushes newly ready items to the back of its own
+// deque and pops from the back (LIFO), so that the successors of a node are
+// likely to run while their inputs are still hot in cache. An idle worker
+// steals items from the front (FIFO) of the other deques.
+//
+// The class also tracks the number of active workers, bounded by
+// `num_deques()`, so that callers can start a new worker only when there is
+// spare capacity:
+//
+//    WorkStealingQueues<Item> queues(num_workers);
+//    queues.Push(id, item);
+//    if (queues.TryStartWorker()) runner([&]() {
+//      const int id = queues.NextDequeId();
+//      do {
+//        Item item;
+//        while (queues.PopOrSteal(id, &item)) Run(item);
+//      } while (!queues.StopWorker());
+//    });
+//
+// Every item pushed is guaranteed to be picked up by some worker as long as
+// pushers call `TryStartWorker()` after `Push()`, and workers only exit when
+// `StopWorker()` returns true.
+//
+// The object is reference counted so that workers that race with the end of a
+// step can safely observe that no work remains.
+template <typename T>
+class WorkStealingQueues : public core::RefCounted {
+ public:
+  explicit WorkStealingQueues(int num_deques)
+      : num_deques_(num_deques), deques_(new Deque[num_deques]) {
+    DCHECK_GT(num_deques, 0);
+  }
+
+  int num_deques() const { return num_deques_; }
+
+  // Returns a deque id for a new worker, or for an item pushed from outside
+  // of a worker. Ids are handed out round-robin.
+  int NextDequeId() {
+    return static_cast<int>(next_deque_id_.fetch_add(
+                                1, std::memory_order_relaxed) %
+                            num_deques_);
+  }
+
+  // Pushes `item` to the back of the deque `id`.
+  void Push(int id, const T& item) {
+    DCHECK_GE(id, 0);
+    DCHECK_LT(id, num_deques_);
+    // Increment before the item becomes visible, so that `num_items_` never
+    // undercounts the items available to `PopOrSteal()`.
+    num_items_.fetch_add(1);
+    Deque& deque = deques_[id];
+    mutex_lock l(deque.mu);
+    deque.items.push_back(item);
+    deque.size.store(deque.items.size() - deque.head,
+                     std::memory_order_relaxed);
+  }
+
+  // Pops an item from the back of deque `id` or, if that deque is empty,
+  // steals an item from the front of another deque. Returns false if no item
+  // was found.
+  bool PopOrSteal(int id, T* item) {
+    if (num_items_.load() == 0) return false;
+    if (PopBack(id, item)) return true;
+    for (int i = 1; i < num_deques_; ++i) {
+      if (StealFront((id + i) % num_deques_, item)) return true;
+    }
+    return false;
+  }
+
+  // Returns the total number of items in all deques.
+  int64 num_items() const { return num_items_.load(); }
+
+  // Reserves a worker slot. Returns false if `num_deques()` workers are
+  // already active.
+  bool TryStartWorker() {
+    int active = active_workers_.load(std::memory_order_relaxed);
+    while (active < num_deques_) {
+      if (active_workers_.compare_exchange_weak(active, active + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Releases a worker slot. Returns true if the worker may exit, or false if
+  // items were pushed concurrently and the worker has been restarted and must
+  // keep popping.
+  bool StopWorker() {
+    active_workers_.fetch_sub(1);
+    if (num_items_.load() == 0) return true;
+    return !TryStartWorker();
+  }
+
+  int num_active_workers() const { return active_workers_.load(); }
+
+ private:
+  struct Deque {
+    mutex mu;
+    // Items in [head, items.size()) are queued. Stolen items advance `head`,
+    // and the vector is reset when it becomes empty, so that no allocation
+    // happens for a deque that is never used.
+    std::vector<T> items TF_GUARDED_BY(mu);
+    size_t head TF_GUARDED_BY(mu) = 0;
+    // Lock-free hint of `items.size() - head`, used to skip empty deques.
+    std::atomic<size_t> size{0};
+  };
+
+  bool PopBack(int id, T* item) {
+    Deque& deque = deques_[id];
+    if (deque.size.load(std::memory_order_relaxed) == 0) return false;
+    mutex_lock l(deque.mu);
+    if (deque.head == deque.items.size()) return false;
+    *item = deque.items.back();
+    deque.items.pop_back();
+    MaybeReset(&deque);
+    num_items_.fetch_sub(1);
+    return true;
+  }
+
+  bool StealFront(int id, T* item) {
+    Deque& deque = deques_[id];
+    if (deque.size.load(std::memory_order_relaxed) == 0) return false;
+    mutex_lock l(deque.mu);
+    if (deque.head == deque.items.size()) return false;
+    *item = deque.items[deque.head++];
+    MaybeReset(&deque);
+    num_items_.fetch_sub(1);
+    return true;
+  }
+
+  static void MaybeReset(Deque* deque) TF_EXCLUSIVE_LOCKS_REQUIRED(deque->mu) {
+    if (deque->head == deque->items.size()) {
+      deque->items.clear();
+      deque->head = 0;
+    }
+    deque->size.store(deque->items.size() - deque->head,
+                      std::memory_order_relaxed);
+  }
+
+  const int num_deques_;
+  std::unique_ptr<Deque[]> deques_;
+  std::atomic<int64> num_items_{0};
+  std::atomic<int> active_workers_{0};
+  std::atomic<uint64> next_deque_id_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueues);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUES_H_
@@ -0,0 +1,134 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_queues.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueuesTest, OwnerPopsLifo) {
+  core::RefCountPtr<WorkStealingQueues<int>> queues(
+      new WorkStealingQueues<int>(2));
+  queues->Push(0, 1);
+  queues->Push(0, 2);
+  queues->Push(0, 3);
+  EXPECT_EQ(3, queues->num_items());
+
+  int item = 0;
+  ASSERT_TRUE(queues->PopOrSteal(0, &item));
+  EXPECT_EQ(3, item);
+  ASSERT_TRUE(queues->PopOrSteal(0, &item));
+  EXPECT_EQ(2, item);
+  ASSERT_TRUE(queues->PopOrSteal(0, &item));
+  EXPECT_EQ(1, item);
+  EXPECT_FALSE(queues->PopOrSteal(0, &item));
+  EXPECT_EQ(0, queues->num_items());
+}
+
+TEST(WorkStealingQueuesTest, ThiefStealsFifo) {
+  core::RefCountPtr<WorkStealingQueues<int>> queues(
+      new WorkStealingQueues<int>(3));
+  queues->Push(1, 1);
+  queues->Push(1, 2);
+  queues->Push(1, 3);
+
+  int item = 0;
+  ASSERT_TRUE(queues->PopOrSteal(0, &item));
+  EXPECT_EQ(1, item);
+  ASSERT_TRUE(queues->PopOrSteal(2, &item));
+  EXPECT_EQ(2, item);
+  // The owner still pops from the back.
+  ASSERT_TRUE(queues->PopOrSteal(1, &item));
+  EXPECT_EQ(3, item);
+  EXPECT_FALSE(queues->PopOrSteal(0, &item));
+}
+
+TEST(WorkStealingQueuesTest, WorkerSlots) {
+  core::RefCountPtr<WorkStealingQueues<int>> queues(
+      new WorkStealingQueues<int>(2));
+  EXPECT_TRUE(queues->TryStartWorker());
+  EXPECT_TRUE(queues->TryStartWorker());
+  EXPECT_FALSE(queues->TryStartWorker());
+  EXPECT_EQ(2, queues->num_active_workers());
+
+  // No work left: the worker exits and frees its slot.
+  EXPECT_TRUE(queues->StopWorker());
+  EXPECT_EQ(1, queues->num_active_workers());
+
+  // Work was pushed concurrently: the worker must keep going.
+  queues->Push(0, 7);
+  EXPECT_FALSE(queues->StopWorker());
+  EXPECT_EQ(1, queues->num_active_workers());
+  int item = 0;
+  ASSERT_TRUE(queues->PopOrSteal(1, &item));
+  EXPECT_EQ(7, item);
+  EXPECT_TRUE(queues->StopWorker());
+  EXPECT_EQ(0, queues->num_active_workers());
+}
+
+TEST(WorkStealingQueuesTest, ConcurrentWorkersRunEveryItem) {
+  const int kNumWorkers = 4;
+  const int kNumRoots = 8;
+  const int kFanOut = 4;
+  const int kDepth = 4;
+  core::RefCountPtr<WorkStealingQueues<int>> queues(
+      new WorkStealingQueues<int>(kNumWorkers));
+  std::atomic<int> num_run(0);
+
+  thread::ThreadPool pool(Env::Default(), "test", kNumWorkers);
+  std::function<void()> worker;
+  // Each item spawns `kFanOut` children on the local deque until `kDepth`.
+  worker = [&]() {
+    const int id = queues->NextDequeId();
+    do {
+      int depth = 0;
+      while (queues->PopOrSteal(id, &depth)) {
+        num_run.fetch_add(1);
+        if (depth + 1 < kDepth) {
+          for (int i = 0; i < kFanOut; ++i) {
+            queues->Push(id, depth + 1);
+            if (queues->TryStartWorker()) pool.Schedule(worker);
+          }
+        }
+      }
+    } while (!queues->StopWorker());
+  };
+  for (int i = 0; i < kNumRoots; ++i) {
+    queues->Push(queues->NextDequeId(), 0);
+    if (queues->TryStartWorker()) pool.Schedule(worker);
+  }
+
+  int expected = 0;
+  int level = kNumRoots;
+  for (int d = 0; d < kDepth; ++d) {
+    expected += level;
+    level *= kFanOut;
+  }
+  while (num_run.load() < expected) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  EXPECT_EQ(expected, num_run.load());
+  EXPECT_EQ(0, queues->num_items());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,13 +16,73 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/io/block_gzip_inputstream.h"
+#include "tensorflow/core/lib/io/block_gzip_outputbuffer.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 namespace data {
 
+namespace {
+
+// Uncompresses the snappy-compressed `compressed_data` of `total_size`
+// uncompressed bytes into `iov`.
+Status SnappyUncompressToIOVec(const std::string& compressed_data,
+                               int64 total_size,
+                               std::vector<struct iovec>& iov) {
+  size_t uncompressed_size;
+  if (!port::Snappy_GetUncompressedLength(
+          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
+    return errors::Internal(
+        "Could not get snappy uncompressed length. Compressed data size: ",
+        compressed_data.size());
+  }
+  if (uncompressed_size != static_cast<size_t>(total_size)) {
+    return errors::Internal(
+        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
+        " whereas the tensor metadata suggests ", total_size);
+  }
+  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
+                                      compressed_data.size(), iov.data(),
+                                      iov.size())) {
+    return errors::Internal("Failed to perform snappy decompression.");
+  }
+  return Status::OK();
+}
+
+// Uncompresses the gzip-compressed `compressed_data` of `total_size`
+// uncompressed bytes into `iov`.
+Status GzipUncompressToIOVec(const std::string& compressed_data,
+                             int64 total_size,
+                             std::vector<struct iovec>& iov) {
+  std::string uncompressed;
+  TF_RETURN_IF_ERROR(io::BlockGzipInputStream::DecompressBlock(
+      compressed_data, &uncompressed));
+  if (uncompressed.size() != static_cast<size_t>(total_size)) {
+    return errors::Internal("Uncompressed size mismatch. Gzip data has ",
+                            uncompressed.size(),
+                            " bytes whereas the tensor metadata suggests ",
+                            total_size);
+  }
+  const char* position = uncompressed.data();
+  for (const struct iovec& v : iov) {
+    memcpy(v.iov_base, position, v.iov_len);
+    position += v.iov_len;
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out) {
+  return CompressElement(element, CompressedElement::SNAPPY, out);
+}
+
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement::Compression compression,
+                       CompressedElement* out) {
   // Step 1: Determine the total uncompressed size. This requires serializing
   // non-memcopyable tensors, which we save to use again later.
   std::vector<TensorProto> non_memcpy_components;
@@ -40,11 +100,20 @@ Status CompressElement(const std::vector<Tensor>& element,
   }
 
   // Step 2: Write the tensor data to a buffer, and compress that buffer.
-  // We use tstring for access to resize_uninitialized.
+  // Uncompressed elements are written to the output directly. Otherwise we use
+  // tstring for access to resize_uninitialized.
+  out->set_compression(compression);
   tstring uncompressed;
-  uncompressed.resize_uninitialized(total_size);
-  // Position in `uncompressed` to write the next component.
-  char* position = uncompressed.mdata();
+  char* start;
+  if (compression == CompressedElement::UNCOMPRESSED) {
+    out->mutable_data()->resize(total_size);
+    start = &(*out->mutable_data())[0];
+  } else {
+    uncompressed.resize_uninitialized(total_size);
+    start = uncompressed.mdata();
+  }
+  // Position in the buffer to write the next component.
+  char* position = start;
   int non_memcpy_component_index = 0;
   for (auto& component : element) {
     CompressedComponentMetadata* metadata =
@@ -62,10 +131,18 @@ Status CompressElement(const std::vector<Tensor>& element,
     }
     position += metadata->tensor_size_bytes();
   }
-  DCHECK_EQ(position, uncompressed.mdata() + total_size);
+  DCHECK_EQ(position, start + total_size);
 
-  if (!port::Snappy_Compress(uncompressed.mdata(), total_size,
-                             out->mutable_data())) {
+  if (compression == CompressedElement::UNCOMPRESSED) {
+    VLOG(3) << "Wrote uncompressed element of " << total_size << " bytes";
+    return Status::OK();
+  }
+  if (compression == CompressedElement::GZIP) {
+    TF_RETURN_IF_ERROR(io::BlockGzipOutputBuffer::CompressBlock(
+        uncompressed, io::ZlibCompressionOptions::GZIP(),
+        out->mutable_data()));
+  } else if (!port::Snappy_Compress(uncompressed.mdata(), total_size,
+                                    out->mutable_data())) {
     return errors::Internal("Failed to compress using snappy.");
   }
   VLOG(3) << "Compressed element from " << total_size << " bytes to "
@@ -111,22 +188,26 @@ Status UncompressElement(const CompressedElement& compressed,
 
   // Step 2: Uncompress into the iovec.
   const std::string& compressed_data = compressed.data();
-  size_t uncompressed_size;
-  if (!port::Snappy_GetUncompressedLength(
-          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
-    return errors::Internal(
-        "Could not get snappy uncompressed length. Compressed data size: ",
-        compressed_data.size());
-  }
-  if (uncompressed_size != static_cast<size_t>(total_size)) {
-    return errors::Internal(
-        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
-        " whereas the tensor metadata suggests ", total_size);
-  }
-  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
-                                      compressed_data.size(), iov.data(),
-                                      num_components)) {
-    return errors::Internal("Failed to perform snappy decompression.");
+  if (compressed.compression() == CompressedElement::UNCOMPRESSED) {
+    if (compressed_data.size() != static_cast<size_t>(total_size)) {
+      return errors::Internal(
+          "Uncompressed element size mismatch. The data has ",
+          compressed_data.size(),
+          " bytes whereas the tensor metadata suggests ", total_size);
+    }
+    const char* position = compressed_data.data();
+    for (int i = 0; i < num_components; ++i) {
+      memcpy(iov[i].iov_base, position, iov[i].iov_len);
+      position += iov[i].iov_len;
+    }
+  } else if (compressed.compression() == CompressedElement::GZIP) {
+    TF_RETURN_IF_ERROR(GzipUncompressToIOVec(compressed_data, total_size, iov));
+  } else if (compressed.compression() != CompressedElement::SNAPPY) {
+    return errors::InvalidArgument("Unknown element compression: ",
+                                   compressed.compression());
+  } else {
+    TF_RETURN_IF_ERROR(
+        SnappyUncompressToIOVec(compressed_data, total_size, iov));
   }
 
   // Step 3: Deserialize tensor proto strings to tensors.
@@ -29,7 +29,15 @@ namespace data {
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out);
 
-// Uncompresses a `CompressedElement` into a vector of tensor components.
+// Like `CompressElement` above, but encodes the tensor bytes with
+// `compression`. With `CompressedElement::UNCOMPRESSED`, the tensor bytes are
+// copied into `out` once, without an intermediate buffer.
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement::Compression compression,
+                       CompressedElement* out);
+
+// Uncompresses a `CompressedElement` into a vector of tensor components. The
+// encoding is read from `compressed.compression()`.
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out);
 
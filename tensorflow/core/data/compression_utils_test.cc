@@ -35,6 +35,29 @@ TEST_P(ParameterizedCompressionUtilsTest, RoundTrip) {
       ExpectEqual(element, round_trip_element, /*compare_order=*/true));
 }
 
+TEST_P(ParameterizedCompressionUtilsTest, UncompressedRoundTrip) {
+  std::vector<Tensor> element = GetParam();
+  CompressedElement compressed;
+  TF_ASSERT_OK(
+      CompressElement(element, CompressedElement::UNCOMPRESSED, &compressed));
+  EXPECT_EQ(compressed.compression(), CompressedElement::UNCOMPRESSED);
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
+TEST_P(ParameterizedCompressionUtilsTest, GzipRoundTrip) {
+  std::vector<Tensor> element = GetParam();
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, CompressedElement::GZIP, &compressed));
+  EXPECT_EQ(compressed.compression(), CompressedElement::GZIP);
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
 std::vector<std::vector<Tensor>> TestCases() {
   return {
       CreateTensors<int64>(TensorShape{1}, {{1}}),             // int64
@@ -29,6 +29,10 @@ namespace data {
 namespace {
 constexpr const char kParallelEpochs[] = "parallel_epochs";
 constexpr const char kOneEpoch[] = "one_epoch";
+// Deadline of requests for elements of tasks read in coordinated rounds, which
+// may wait for other consumers. It is longer than the workers' default round
+// timeout, so that requests normally return before it.
+constexpr int64 kRoundElementTimeoutMs = 60 * 1000;
 }  // namespace
 
 Status ParseProcessingMode(const std::string& s, ProcessingMode& mode) {
@@ -56,13 +60,15 @@ std::string ProcessingModeToString(ProcessingMode mode) {
 
 Status DataServiceDispatcherClient::WorkerHeartbeat(
     const std::string& worker_address, const std::vector<int64>& current_tasks,
-    std::vector<TaskDef>& new_tasks, std::vector<int64>& tasks_to_delete) {
+    const WorkerLoad& load, std::vector<TaskDef>& new_tasks,
+    std::vector<int64>& tasks_to_delete) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   WorkerHeartbeatRequest req;
   req.set_worker_address(worker_address);
   for (int64 task : current_tasks) {
     req.add_current_tasks(task);
   }
+  *req.mutable_load() = load;
   WorkerHeartbeatResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->WorkerHeartbeat(&client_ctx, req, &resp);
@@ -147,13 +153,15 @@ Status DataServiceDispatcherClient::CreateJob(int64 dataset_id,
 
 Status DataServiceDispatcherClient::GetOrCreateJob(
     int64 dataset_id, ProcessingMode processing_mode,
-    const std::string& job_name, int job_name_index, int64& job_client_id) {
+    const std::string& job_name, int job_name_index, int64 num_consumers,
+    int64& job_client_id) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   GetOrCreateJobRequest req;
   req.set_dataset_id(dataset_id);
   req.set_processing_mode(ProcessingModeDef(processing_mode));
   req.set_job_name(job_name);
   req.set_job_name_index(job_name_index);
+  req.set_num_consumers(num_consumers);
   GetOrCreateJobResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->GetOrCreateJob(&client_ctx, req, &resp);
@@ -235,9 +243,49 @@ Status DataServiceDispatcherClient::EnsureInitialized() {
 Status DataServiceWorkerClient::GetElement(int64 task_id,
                                            CompressedElement& element,
                                            bool& end_of_sequence) {
+  GetElementRequest req;
+  req.set_task_id(task_id);
+  return GetElement(req, element, end_of_sequence);
+}
+
+Status DataServiceWorkerClient::GetRoundElement(int64 task_id,
+                                                int64 consumer_index,
+                                                int64 round_index,
+                                                CompressedElement& element,
+                                                bool& end_of_sequence,
+                                                bool& skipped) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   GetElementRequest req;
   req.set_task_id(task_id);
+  req.set_consumer_index(consumer_index);
+  req.set_round_index(round_index);
+  GetElementResponse resp;
+  grpc::ClientContext ctx;
+  ctx.set_deadline(std::chrono::system_clock::now() +
+                   std::chrono::milliseconds(kRoundElementTimeoutMs));
+  grpc::Status s = stub_->GetElement(&ctx, req, &resp);
+  if (s.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED) {
+    // Requests for a round are idempotent, so report the timeout as
+    // retriable.
+    return errors::Unavailable("Timed out getting round ", round_index,
+                               " of task ", task_id, ": ",
+                               s.error_message());
+  }
+  if (!s.ok()) {
+    return grpc_util::WrapError("Failed to get element", s);
+  }
+  end_of_sequence = resp.end_of_sequence();
+  skipped = resp.skipped();
+  if (!end_of_sequence && !skipped) {
+    element = std::move(*resp.mutable_compressed_element());
+  }
+  return Status::OK();
+}
+
+Status DataServiceWorkerClient::GetElement(const GetElementRequest& req,
+                                           CompressedElement& element,
+                                           bool& end_of_sequence) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
   GetElementResponse resp;
   grpc::ClientContext ctx;
   grpc::Status s = stub_->GetElement(&ctx, req, &resp);
@@ -251,6 +299,49 @@ Status DataServiceWorkerClient::GetElement(int64 task_id,
   return Status::OK();
 }
 
+Status DataServiceWorkerClient::GetElements(
+    int64 task_id, int64 max_elements, int64 max_bytes,
+    std::vector<CompressedElement>& elements, bool& end_of_sequence) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  if (get_elements_unimplemented_) {
+    return GetElementsOneByOne(task_id, elements, end_of_sequence);
+  }
+  GetElementsRequest req;
+  req.set_task_id(task_id);
+  req.set_max_elements(max_elements);
+  req.set_max_bytes(max_bytes);
+  GetElementsResponse resp;
+  grpc::ClientContext ctx;
+  grpc::Status s = stub_->GetElements(&ctx, req, &resp);
+  if (s.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+    // The worker predates GetElements.
+    VLOG(1) << "Worker " << address_ << " does not implement GetElements, "
+            << "falling back to GetElement";
+    get_elements_unimplemented_ = true;
+    return GetElementsOneByOne(task_id, elements, end_of_sequence);
+  }
+  if (!s.ok()) {
+    return grpc_util::WrapError("Failed to get elements", s);
+  }
+  end_of_sequence = resp.end_of_sequence();
+  elements.reserve(elements.size() + resp.compressed_elements_size());
+  for (CompressedElement& element : *resp.mutable_compressed_elements()) {
+    elements.push_back(std::move(element));
+  }
+  return Status::OK();
+}
+
+Status DataServiceWorkerClient::GetElementsOneByOne(
+    int64 task_id, std::vector<CompressedElement>& elements,
+    bool& end_of_sequence) {
+  CompressedElement element;
+  TF_RETURN_IF_ERROR(GetElement(task_id, element, end_of_sequence));
+  if (!end_of_sequence) {
+    elements.push_back(std::move(element));
+  }
+  return Status::OK();
+}
+
 Status DataServiceWorkerClient::EnsureInitialized() {
   mutex_lock l(mu_);
   if (stub_) {
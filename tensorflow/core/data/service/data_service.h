@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_DATA_SERVICE_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_DATA_SERVICE_H_
 
+#include <atomic>
+
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -77,9 +79,11 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // registered with the dispatcher, this will register the worker. The
   // dispatcher will report which new tasks the worker should run, and which
   // tasks it should delete. This is stored into `new_tasks` and
-  // `tasks_to_delete`.
+  // `tasks_to_delete`. `load` is the worker's load since its previous
+  // heartbeat.
   Status WorkerHeartbeat(const std::string& worker_address,
                          const std::vector<int64>& current_tasks,
+                         const WorkerLoad& load,
                          std::vector<TaskDef>& new_tasks,
                          std::vector<int64>& tasks_to_delete);
 
@@ -103,9 +107,12 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // Gets the job id for the job represented by the tuple
   // (job_name, job_name_index), and stores the id in `job_client_id`. If the
   // job doesn't exist yet, it will be created.
+  //
+  // If `num_consumers` is positive, the job is read by that many consumers in
+  // coordinated rounds. All clients of a named job must agree on it.
   Status GetOrCreateJob(int64 dataset_id, ProcessingMode processing_mode,
                         const std::string& job_name, int job_name_index,
-                        int64& job_client_id);
+                        int64 num_consumers, int64& job_client_id);
 
   // Releases a job client id, indicating that the id will no longer be used to
   // read from the job.
@@ -144,10 +151,38 @@ class DataServiceWorkerClient : public DataServiceClientBase {
   Status GetElement(int64 task_id, CompressedElement& element,
                     bool& end_of_sequence);
 
+  // Like `GetElement`, but for tasks read in coordinated rounds: fetches the
+  // element of round `round_index` for the consumer `consumer_index`. This
+  // blocks until the task moves on to round `round_index`. `skipped` is set if
+  // the task moved on from the round before the consumer read it, in which
+  // case `element` is left unchanged. Requests may be retried, and return the
+  // same element again.
+  Status GetRoundElement(int64 task_id, int64 consumer_index,
+                         int64 round_index, CompressedElement& element,
+                         bool& end_of_sequence, bool& skipped);
+
+  // Fetches up to `max_elements` next elements for the specified task_id,
+  // stopping early once the elements add up to `max_bytes` (if positive). The
+  // elements are appended to `elements`. `end_of_sequence` is `true` if the
+  // task has no elements after the returned ones. Workers which do not
+  // implement the GetElements RPC return one element at a time.
+  Status GetElements(int64 task_id, int64 max_elements, int64 max_bytes,
+                     std::vector<CompressedElement>& elements,
+                     bool& end_of_sequence);
+
  protected:
   Status EnsureInitialized() override;
 
  private:
+  Status GetElement(const GetElementRequest& req, CompressedElement& element,
+                    bool& end_of_sequence);
+  // Implements `GetElements` with a single GetElement RPC.
+  Status GetElementsOneByOne(int64 task_id,
+                             std::vector<CompressedElement>& elements,
+                             bool& end_of_sequence);
+
+  // Set once the worker rejected a GetElements RPC as unimplemented.
+  std::atomic<bool> get_elements_unimplemented_{false};
   mutex mu_;
   // Initialization is guarded by `mu_`, but using the stub does not require
   // holding `mu_`
@@ -17,8 +17,11 @@ limitations under the License.
 
 #include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
+#include "grpcpp/server_builder.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/data/service/credentials_factory.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/grpc_util.h"
@@ -29,7 +32,9 @@ limitations under the License.
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -37,8 +42,113 @@ namespace data {
 
 namespace {
 constexpr const char kProtocol[] = "grpc+local";
+
+// Reads round `round_index` of `task_id` for `consumer_index` and stores its
+// value in `value`, or -1 if the consumer skipped the round.
+Status GetRoundValue(DataServiceWorkerClient& worker, int64 task_id,
+                     int64 consumer_index, int64 round_index, int64& value) {
+  CompressedElement compressed;
+  bool end_of_sequence = false;
+  bool skipped = false;
+  TF_RETURN_IF_ERROR(worker.GetRoundElement(task_id, consumer_index,
+                                            round_index, compressed,
+                                            end_of_sequence, skipped));
+  if (end_of_sequence) {
+    return errors::OutOfRange("Unexpected end of sequence");
+  }
+  if (skipped) {
+    value = -1;
+    return Status::OK();
+  }
+  std::vector<Tensor> element;
+  TF_RETURN_IF_ERROR(UncompressElement(compressed, &element));
+  value = element[0].scalar<int64>()();
+  return Status::OK();
+}
+
+// Starts a job reading the map test dataset, which produces 0, 1, 4, ..., 81,
+// and stores the id of its only task in `task_id`.
+Status StartMapJob(TestCluster& cluster, int64& task_id) {
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  test_util::GraphDefTestCase test_case;
+  TF_RETURN_IF_ERROR(test_util::map_test_case(&test_case));
+  int64 dataset_id;
+  TF_RETURN_IF_ERROR(
+      dispatcher.RegisterDataset(test_case.graph_def, dataset_id));
+  int64 job_client_id;
+  TF_RETURN_IF_ERROR(dispatcher.GetOrCreateJob(
+      dataset_id, ProcessingMode::PARALLEL_EPOCHS, "job", /*job_name_index=*/0,
+      /*num_consumers=*/0, job_client_id));
+  std::vector<TaskInfo> tasks;
+  bool job_finished = false;
+  while (tasks.empty()) {
+    TF_RETURN_IF_ERROR(dispatcher.GetTasks(job_client_id, tasks, job_finished));
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+  }
+  task_id = tasks[0].task_id();
+  return Status::OK();
 }
 
+// Fetches up to `max_elements` elements of `task_id` with GetElements, and
+// stores their values in `values`.
+Status GetValues(DataServiceWorkerClient& worker, int64 task_id,
+                 int64 max_elements, int64 max_bytes,
+                 std::vector<int64>& values, bool& end_of_sequence) {
+  std::vector<CompressedElement> elements;
+  TF_RETURN_IF_ERROR(worker.GetElements(task_id, max_elements, max_bytes,
+                                        elements, end_of_sequence));
+  values.clear();
+  for (const CompressedElement& compressed : elements) {
+    std::vector<Tensor> element;
+    TF_RETURN_IF_ERROR(UncompressElement(compressed, &element));
+    values.push_back(element[0].scalar<int64>()());
+  }
+  return Status::OK();
+}
+
+// A worker which predates the GetElements RPC. It serves the values
+// 0, 1, ..., `num_elements` - 1 through GetElement.
+class GetElementOnlyWorker : public WorkerService::Service {
+ public:
+  explicit GetElementOnlyWorker(int64 num_elements)
+      : num_elements_(num_elements) {}
+
+  ::grpc::Status GetElement(::grpc::ServerContext* context,
+                            const GetElementRequest* request,
+                            GetElementResponse* response) override {
+    mutex_lock l(mu_);
+    if (next_ == num_elements_) {
+      response->set_end_of_sequence(true);
+      return ::grpc::Status::OK;
+    }
+    Status s = CompressElement({Tensor(next_++)},
+                               response->mutable_compressed_element());
+    if (!s.ok()) return ::grpc::Status(::grpc::StatusCode::INTERNAL, "");
+    return ::grpc::Status::OK;
+  }
+
+  ::grpc::Status GetElements(::grpc::ServerContext* context,
+                             const GetElementsRequest* request,
+                             GetElementsResponse* response) override {
+    mutex_lock l(mu_);
+    ++num_get_elements_calls_;
+    return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+  }
+
+  int64 num_get_elements_calls() {
+    mutex_lock l(mu_);
+    return num_get_elements_calls_;
+  }
+
+ private:
+  const int64 num_elements_;
+  mutex mu_;
+  int64 next_ TF_GUARDED_BY(mu_) = 0;
+  int64 num_get_elements_calls_ TF_GUARDED_BY(mu_) = 0;
+};
+}  // namespace
+
 TEST(DataService, ParseParallelEpochsProcessingMode) {
   ProcessingMode mode;
   TF_ASSERT_OK(ParseProcessingMode("parallel_epochs", mode));
@@ -73,5 +183,149 @@ TEST(DataService, GetWorkers) {
   EXPECT_EQ(1, workers.size());
 }
 
+TEST(DataService, CoordinatedReadRetriesAndSkipsStragglers) {
+  TestCluster cluster(1, /*worker_round_timeout_ms=*/100);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  int64 dataset_id;
+  TF_ASSERT_OK(dispatcher.RegisterDataset(test_case.graph_def, dataset_id));
+  int64 job_client_id;
+  TF_ASSERT_OK(dispatcher.GetOrCreateJob(
+      dataset_id, ProcessingMode::PARALLEL_EPOCHS, "job", /*job_name_index=*/0,
+      /*num_consumers=*/2, job_client_id));
+  std::vector<TaskInfo> tasks;
+  bool job_finished = false;
+  while (tasks.empty()) {
+    TF_ASSERT_OK(dispatcher.GetTasks(job_client_id, tasks, job_finished));
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+  }
+  const int64 task_id = tasks[0].task_id();
+  DataServiceWorkerClient worker(cluster.WorkerAddress(0), kProtocol);
+
+  // The dataset produces 0, 1, 4, 9, ..., two elements per round.
+  int64 value;
+  TF_ASSERT_OK(GetRoundValue(worker, task_id, /*consumer_index=*/0,
+                             /*round_index=*/0, value));
+  EXPECT_EQ(0, value);
+  // Retrying a round returns the same element.
+  TF_ASSERT_OK(GetRoundValue(worker, task_id, /*consumer_index=*/0,
+                             /*round_index=*/0, value));
+  EXPECT_EQ(0, value);
+  // Consumer 1 never reads round 0, so round 1 starts once round 0 times out.
+  TF_ASSERT_OK(GetRoundValue(worker, task_id, /*consumer_index=*/0,
+                             /*round_index=*/1, value));
+  EXPECT_EQ(4, value);
+  TF_ASSERT_OK(GetRoundValue(worker, task_id, /*consumer_index=*/1,
+                             /*round_index=*/0, value));
+  EXPECT_EQ(-1, value);
+  TF_ASSERT_OK(GetRoundValue(worker, task_id, /*consumer_index=*/1,
+                             /*round_index=*/1, value));
+  EXPECT_EQ(9, value);
+  // Round 0 is still kept for consumer 0, which read it.
+  TF_ASSERT_OK(GetRoundValue(worker, task_id, /*consumer_index=*/0,
+                             /*round_index=*/0, value));
+  EXPECT_EQ(0, value);
+}
+
+TEST(DataService, GetElementsReturnsAtMostMaxElements) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  int64 task_id;
+  TF_ASSERT_OK(StartMapJob(cluster, task_id));
+  DataServiceWorkerClient worker(cluster.WorkerAddress(0), kProtocol);
+
+  std::vector<int64> values;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/4,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({0, 1, 4, 9}));
+  EXPECT_FALSE(end_of_sequence);
+  // Values less than 1 are treated as 1.
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/0,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({16}));
+  EXPECT_FALSE(end_of_sequence);
+}
+
+TEST(DataService, GetElementsStopsAtMaxBytes) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  int64 task_id;
+  TF_ASSERT_OK(StartMapJob(cluster, task_id));
+  DataServiceWorkerClient worker(cluster.WorkerAddress(0), kProtocol);
+
+  // A single element already exceeds one byte, but at least one element is
+  // always returned.
+  std::vector<int64> values;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/8,
+                         /*max_bytes=*/1, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({0}));
+  EXPECT_FALSE(end_of_sequence);
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/8,
+                         /*max_bytes=*/1, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({1}));
+  EXPECT_FALSE(end_of_sequence);
+}
+
+TEST(DataService, GetElementsReachesEndOfSequence) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  int64 task_id;
+  TF_ASSERT_OK(StartMapJob(cluster, task_id));
+  DataServiceWorkerClient worker(cluster.WorkerAddress(0), kProtocol);
+
+  std::vector<int64> values;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/7,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_EQ(values.size(), 7);
+  EXPECT_FALSE(end_of_sequence);
+  // The end of the sequence is reported together with the last elements.
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/16,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({49, 64, 81}));
+  EXPECT_TRUE(end_of_sequence);
+  TF_ASSERT_OK(GetValues(worker, task_id, /*max_elements=*/16,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_TRUE(values.empty());
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST(DataService, GetElementsFallsBackToGetElement) {
+  GetElementOnlyWorker service(/*num_elements=*/2);
+  std::shared_ptr<::grpc::ServerCredentials> credentials;
+  TF_ASSERT_OK(
+      CredentialsFactory::CreateServerCredentials(kProtocol, &credentials));
+  int port = 0;
+  ::grpc::ServerBuilder builder;
+  builder.AddListeningPort("localhost:0", credentials, &port);
+  builder.RegisterService(&service);
+  std::unique_ptr<::grpc::Server> server = builder.BuildAndStart();
+  ASSERT_NE(server, nullptr);
+  DataServiceWorkerClient worker(absl::StrCat("localhost:", port), kProtocol);
+
+  std::vector<int64> values;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(GetValues(worker, /*task_id=*/0, /*max_elements=*/8,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({0}));
+  EXPECT_FALSE(end_of_sequence);
+  TF_ASSERT_OK(GetValues(worker, /*task_id=*/0, /*max_elements=*/8,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_EQ(values, std::vector<int64>({1}));
+  EXPECT_FALSE(end_of_sequence);
+  TF_ASSERT_OK(GetValues(worker, /*task_id=*/0, /*max_elements=*/8,
+                         /*max_bytes=*/0, values, end_of_sequence));
+  EXPECT_TRUE(values.empty());
+  EXPECT_TRUE(end_of_sequence);
+  // The client remembers that the worker lacks GetElements.
+  EXPECT_EQ(service.num_get_elements_calls(), 1);
+  server->Shutdown();
+}
+
 }  // namespace data
 }  // namespace tensorflow
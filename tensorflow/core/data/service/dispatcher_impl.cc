@@ -35,9 +35,11 @@ limitations under the License.
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/journal.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
+#include "tensorflow/core/data/service/worker_load.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/protobuf/data/experimental/service_config.pb.h"
@@ -58,6 +60,20 @@ using NamedJobKey = DispatcherState::NamedJobKey;
 using Job = DispatcherState::Job;
 using Task = DispatcherState::Task;
 
+// Signals for cluster autoscalers, derived from the load reported by workers.
+auto* tf_data_service_reporting_workers = monitoring::Gauge<int64, 0>::New(
+    "/tensorflow/data/service/dispatcher/reporting_workers",
+    "The number of tf.data service workers which have reported their load.");
+auto* tf_data_service_saturated_workers = monitoring::Gauge<int64, 0>::New(
+    "/tensorflow/data/service/dispatcher/saturated_workers",
+    "The number of tf.data service workers which are busy all the time while "
+    "clients are waiting for them.");
+auto* tf_data_service_desired_workers = monitoring::Gauge<int64, 0>::New(
+    "/tensorflow/data/service/dispatcher/desired_workers",
+    "The number of tf.data service workers needed for the current load. More "
+    "than `reporting_workers` means that more workers are needed, fewer means "
+    "that there are too many.");
+
 std::string JournalDir(const std::string& work_dir) {
   return io::JoinPath(work_dir, kJournalDir);
 }
@@ -154,6 +170,7 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
           << request->worker_address();
   mutex_lock l(mu_);
   const std::string& worker_address = request->worker_address();
+  RecordWorkerLoad(worker_address, request->load());
   std::vector<std::shared_ptr<const Task>> correct_tasks;
   Status s = state_.TasksForWorker(worker_address, correct_tasks);
   if (!s.ok()) {
@@ -194,6 +211,9 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
     task_def->set_dataset_id(task->dataset_id);
     task_def->set_job_id(task->job_id);
     task_def->set_task_id(task->task_id);
+    std::shared_ptr<const Job> job;
+    TF_RETURN_IF_ERROR(state_.JobFromId(task->job_id, job));
+    task_def->set_num_consumers(job->num_consumers);
   }
   for (int64 current_task : current_tasks) {
     if (!correct_tasks_set.contains(current_task)) {
@@ -301,7 +321,8 @@ Status DataServiceDispatcherImpl::CreateJob(const CreateJobRequest* request,
   {
     mutex_lock l(mu_);
     TF_RETURN_IF_ERROR(CreateJob(request->dataset_id(), processing_mode,
-                                 absl::optional<NamedJobKey>(), job));
+                                 absl::optional<NamedJobKey>(),
+                                 /*num_consumers=*/0, job));
     int64 job_client_id;
     TF_RETURN_IF_ERROR(AcquireJobClientId(job, job_client_id));
     response->set_job_client_id(job_client_id);
@@ -330,7 +351,8 @@ Status DataServiceDispatcherImpl::GetOrCreateJob(
     Status s = state_.NamedJobByKey(key, job);
     if (s.ok()) {
       TF_RETURN_IF_ERROR(ValidateMatchingJob(job, requested_processing_mode,
-                                             request->dataset_id()));
+                                             request->dataset_id(),
+                                             request->num_consumers()));
       int64 job_client_id;
       TF_RETURN_IF_ERROR(AcquireJobClientId(job, job_client_id));
       response->set_job_client_id(job_client_id);
@@ -340,8 +362,9 @@ Status DataServiceDispatcherImpl::GetOrCreateJob(
     } else if (!errors::IsNotFound(s)) {
       return s;
     }
-    TF_RETURN_IF_ERROR(
-        CreateJob(request->dataset_id(), requested_processing_mode, key, job));
+    TF_RETURN_IF_ERROR(CreateJob(request->dataset_id(),
+                                 requested_processing_mode, key,
+                                 request->num_consumers(), job));
     int64 job_client_id;
     TF_RETURN_IF_ERROR(AcquireJobClientId(job, job_client_id));
     response->set_job_client_id(job_client_id);
@@ -373,7 +396,7 @@ Status DataServiceDispatcherImpl::ReleaseJobClient(
 // Validates that the job matches the given processing_mode and dataset_id.
 Status DataServiceDispatcherImpl::ValidateMatchingJob(
     std::shared_ptr<const Job> job, ProcessingMode processing_mode,
-    int64 dataset_id) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    int64 dataset_id, int64 num_consumers) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   DCHECK(job->named_job_key.has_value());
   std::string job_name = job->named_job_key->name;
   if (job->processing_mode != processing_mode) {
@@ -396,13 +419,19 @@ Status DataServiceDispatcherImpl::ValidateMatchingJob(
         "under the same job_name, or that your dataset is being constructed "
         "non-deterministically.");
   }
+  if (job->num_consumers != num_consumers) {
+    return errors::FailedPrecondition(
+        "Tried to create a job with name ", job_name, " for ", num_consumers,
+        " consumers, but there is already an existing job with that name for ",
+        job->num_consumers, " consumers.");
+  }
   return Status::OK();
 }
 
 Status DataServiceDispatcherImpl::CreateJob(
     int64 dataset_id, ProcessingMode processing_mode,
-    absl::optional<NamedJobKey> named_job_key, std::shared_ptr<const Job>& job)
-    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    absl::optional<NamedJobKey> named_job_key, int64 num_consumers,
+    std::shared_ptr<const Job>& job) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   switch (processing_mode) {
     case ProcessingMode::PARALLEL_EPOCHS:
       break;
@@ -426,6 +455,7 @@ Status DataServiceDispatcherImpl::CreateJob(
     key->set_name(named_job_key->name);
     key->set_index(named_job_key->index);
   }
+  create_job->set_num_consumers(num_consumers);
   TF_RETURN_IF_ERROR(Apply(update));
   TF_RETURN_IF_ERROR(state_.JobFromId(job_id, job));
   return Status::OK();
@@ -545,6 +575,9 @@ Status DataServiceDispatcherImpl::AssignTask(std::shared_ptr<const Task> task)
           io::JoinPath(DatasetsDir(config_.work_dir()), dataset_key);
       task_def->set_path(path);
     }
+    std::shared_ptr<const Job> job;
+    TF_RETURN_IF_ERROR(state_.JobFromId(task->job_id, job));
+    task_def->set_num_consumers(job->num_consumers);
   }
   task_def->set_task_id(task->task_id);
   ProcessTaskResponse resp;
@@ -634,6 +667,10 @@ void DataServiceDispatcherImpl::JobGcThread() {
     if (!s.ok()) {
       LOG(WARNING) << "Error garbage collecting old jobs: " << s;
     }
+    // Forget workers which stopped sending heartbeats, even if no other
+    // worker reports its load anymore.
+    worker_loads_.RemoveExpired(env_->NowMicros());
+    UpdateWorkerScalingMetrics();
     next_check_micros =
         env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
   }
@@ -664,5 +701,25 @@ Status DataServiceDispatcherImpl::GcOldJobs() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   return Status::OK();
 }
 
+void DataServiceDispatcherImpl::RecordWorkerLoad(
+    const std::string& worker_address, const WorkerLoad& load)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  VLOG(3) << "Worker " << worker_address << " reported load "
+          << load.ShortDebugString();
+  const int64 now_micros = env_->NowMicros();
+  worker_loads_.Record(worker_address, load, now_micros);
+  worker_loads_.RemoveExpired(now_micros);
+  UpdateWorkerScalingMetrics();
+}
+
+void DataServiceDispatcherImpl::UpdateWorkerScalingMetrics()
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  tf_data_service_reporting_workers->GetCell()->Set(worker_loads_.NumWorkers());
+  tf_data_service_saturated_workers->GetCell()->Set(
+      worker_loads_.NumSaturatedWorkers());
+  tf_data_service_desired_workers->GetCell()->Set(
+      worker_loads_.DesiredNumWorkers());
+}
+
 }  // namespace data
 }  // namespace tensorflow
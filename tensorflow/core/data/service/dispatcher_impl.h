@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/dispatcher_state.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
+#include "tensorflow/core/data/service/worker_load.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/data/experimental/service_config.pb.h"
@@ -92,6 +93,7 @@ class DataServiceDispatcherImpl {
   // dispatcher state with the new job, but does not assign tasks to workers.
   Status CreateJob(int64 dataset_id, ProcessingMode processing_mode,
                    absl::optional<DispatcherState::NamedJobKey> named_job_key,
+                   int64 num_consumers,
                    std::shared_ptr<const DispatcherState::Job>& job)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Creates tasks for the specified worker, one task for every unfinished job.
@@ -121,10 +123,12 @@ class DataServiceDispatcherImpl {
   // Assigns a task to the worker indicated by its `worker_address` field.
   Status AssignTask(std::shared_ptr<const DispatcherState::Task> task)
       LOCKS_EXCLUDED(mu_);
-  // Validates that an existing job matches the given processing_mode and
-  // dataset_id, returning an error status describing any difference.
+  // Validates that an existing job matches the given processing_mode,
+  // dataset_id and num_consumers, returning an error status describing any
+  // difference.
   Status ValidateMatchingJob(std::shared_ptr<const DispatcherState::Job> job,
-                             ProcessingMode processing_mode, int64 dataset_id)
+                             ProcessingMode processing_mode, int64 dataset_id,
+                             int64 num_consumers)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Checks that the dispatcher has started, returning UNAVAILABLE if it hasn't.
   Status CheckStarted() LOCKS_EXCLUDED(mu_);
@@ -138,6 +142,12 @@ class DataServiceDispatcherImpl {
   void JobGcThread();
   // Scans for old jobs and marks them as finished.
   Status GcOldJobs() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Records the load reported in a worker heartbeat and updates the worker
+  // scaling metrics.
+  void RecordWorkerLoad(const std::string& worker_address,
+                        const WorkerLoad& load) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Sets the worker scaling metrics from `worker_loads_`.
+  void UpdateWorkerScalingMetrics() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   const experimental::DispatcherConfig& config_;
   Env* env_;
@@ -155,6 +165,9 @@ class DataServiceDispatcherImpl {
   absl::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
   DispatcherState state_ TF_GUARDED_BY(mu_);
+  // The latest load reported by each worker. This is not journaled, since
+  // workers report their load again in their next heartbeat.
+  WorkerLoadTracker worker_loads_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the job gc thread.
   condition_variable job_gc_thread_cv_;
   std::unique_ptr<Thread> job_gc_thread_;
@@ -38,7 +38,9 @@ Status AddressFromTarget(absl::string_view target, std::string* address) {
 }
 }  // namespace
 
-TestCluster::TestCluster(int num_workers) : num_workers_(num_workers) {}
+TestCluster::TestCluster(int num_workers, int64 worker_round_timeout_ms)
+    : num_workers_(num_workers),
+      worker_round_timeout_ms_(worker_round_timeout_ms) {}
 
 Status TestCluster::Initialize() {
   if (initialized_) {
@@ -67,6 +69,7 @@ Status TestCluster::AddWorker() {
   config.set_protocol(kProtocol);
   config.set_dispatcher_address(dispatcher_address_);
   config.set_worker_address("localhost:%port%");
+  config.set_round_timeout_ms(worker_round_timeout_ms_);
   TF_RETURN_IF_ERROR(NewWorkerServer(config, worker));
   TF_RETURN_IF_ERROR(worker->Start());
   worker_addresses_.push_back(absl::StrCat("localhost:", worker->BoundPort()));
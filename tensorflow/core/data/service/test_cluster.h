@@ -24,8 +24,9 @@ namespace data {
 // Helper class for unit testing a tf.data service cluster.
 class TestCluster {
  public:
-  // Creates a new test cluster with a dispatcher and `num_workers` workers.
-  explicit TestCluster(int num_workers);
+  // Creates a new test cluster with a dispatcher and `num_workers` workers. If
+  // positive, `worker_round_timeout_ms` sets the workers' `round_timeout_ms`.
+  explicit TestCluster(int num_workers, int64 worker_round_timeout_ms = 0);
 
   // Initializes the test cluster. This must be called before interacting with
   // the cluster. Initialize should be called only once.
@@ -42,6 +43,7 @@ class TestCluster {
  private:
   bool initialized_ = false;
   int num_workers_;
+  int64 worker_round_timeout_ms_;
   std::unique_ptr<DispatchGrpcDataServer> dispatcher_;
   std::string dispatcher_address_;
   std::vector<std::unique_ptr<WorkerGrpcDataServer>> workers_;
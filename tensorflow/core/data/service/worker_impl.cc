@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/worker_impl.h"
 
+#include <algorithm>
+
 #include "grpcpp/create_channel.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/errors.h"
@@ -39,6 +42,7 @@ namespace tensorflow {
 namespace data {
 
 const constexpr uint64 kRetryIntervalMicros = 5ull * 1000 * 1000;
+const constexpr int64 kDefaultRoundTimeoutMs = 30 * 1000;
 
 namespace {
 auto* tf_data_service_created =
@@ -58,6 +62,7 @@ DataServiceWorkerImpl::~DataServiceWorkerImpl() {
   cancelled_ = true;
   task_completion_cv_.notify_one();
   heartbeat_cv_.notify_one();
+  round_cv_.notify_all();
 }
 
 Status DataServiceWorkerImpl::Start(const std::string& worker_address) {
@@ -144,10 +149,108 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
   return Status::OK();
 }
 
+namespace {
+// Moves the `CompressedElement` produced by a task's dataset into `element`.
+Status ExtractCompressedElement(std::vector<Tensor>& outputs,
+                                CompressedElement& element) {
+  if (outputs.size() != 1) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but the "
+        "dataset produced ",
+        outputs.size(), " outputs");
+  }
+  if (outputs[0].dtype() != DT_VARIANT) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with type ",
+        DataTypeString(outputs[0].dtype()));
+  }
+  if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with shape ",
+        outputs[0].shape());
+  }
+  Variant& variant = outputs[0].scalar<Variant>()();
+  CompressedElement* compressed = variant.get<CompressedElement>();
+  if (compressed == nullptr) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a CompressedElement variant tensor, but "
+        "it produced ",
+        variant.TypeName());
+  }
+  compressed->Swap(&element);
+  return Status::OK();
+}
+}  // namespace
+
 Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
                                          GetElementResponse* response) {
   VLOG(3) << "Received GetElement request for task " << request->task_id();
   bool end_of_sequence = false;
+  bool skipped = false;
+  bool read_in_rounds = false;
+  {
+    mutex_lock l(mu_);
+    auto it = tasks_.find(request->task_id());
+    read_in_rounds = registered_ && it != tasks_.end() &&
+                     it->second->task_def.num_consumers() > 0;
+  }
+  if (read_in_rounds) {
+    TF_RETURN_IF_ERROR(GetRoundElement(*request,
+                                       *response->mutable_compressed_element(),
+                                       end_of_sequence, skipped));
+  } else {
+    TF_RETURN_IF_ERROR(
+        GetElementInternal(request->task_id(),
+                           *response->mutable_compressed_element(),
+                           end_of_sequence));
+  }
+  if (end_of_sequence || skipped) {
+    response->clear_compressed_element();
+  }
+  response->set_end_of_sequence(end_of_sequence);
+  response->set_skipped(skipped);
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetElements(const GetElementsRequest* request,
+                                          GetElementsResponse* response) {
+  VLOG(3) << "Received GetElements request for task " << request->task_id()
+          << " with max_elements=" << request->max_elements();
+  const int64 max_elements = std::max<int64>(request->max_elements(), 1);
+  int64 num_bytes = 0;
+  bool end_of_sequence = false;
+  while (response->compressed_elements_size() < max_elements) {
+    CompressedElement element;
+    Status s = GetElementInternal(request->task_id(), element, end_of_sequence);
+    if (!s.ok()) {
+      // Return the elements which were already produced rather than losing
+      // them. The client's next request surfaces the error if it persists.
+      if (response->compressed_elements_size() > 0) {
+        break;
+      }
+      return s;
+    }
+    if (end_of_sequence) {
+      break;
+    }
+    num_bytes += element.ByteSizeLong();
+    response->add_compressed_elements()->Swap(&element);
+    if (request->max_bytes() > 0 && num_bytes >= request->max_bytes()) {
+      break;
+    }
+  }
+  response->set_end_of_sequence(end_of_sequence);
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetElementInternal(int64 task_id,
+                                                 CompressedElement& element,
+                                                 bool& end_of_sequence) {
+  end_of_sequence = false;
+  ++num_pending_requests_;
+  auto cleanup = gtl::MakeCleanup([this] { --num_pending_requests_; });
   std::vector<tensorflow::Tensor> outputs;
   {
     mutex_lock l(mu_);
@@ -158,54 +261,161 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
       return errors::Unavailable(
           "Worker has not yet registered with dispatcher.");
     }
-    auto it = tasks_.find(request->task_id());
+    auto it = tasks_.find(task_id);
     if (it == tasks_.end()) {
-      response->set_end_of_sequence(true);
+      end_of_sequence = true;
       return Status::OK();
     }
     auto& task = it->second;
+    if (task->task_def.num_consumers() > 0) {
+      return errors::FailedPrecondition(
+          "Task ", task_id,
+          " is read in coordinated rounds, so its elements can only be read "
+          "one round at a time.");
+    }
     TF_RETURN_IF_ERROR(EnsureTaskInitialized(*task));
-    TF_RETURN_IF_ERROR(task->iterator->GetNext(&outputs, &end_of_sequence));
+    const int64 start_micros = Env::Default()->NowMicros();
+    Status s = task->iterator->GetNext(&outputs, &end_of_sequence);
+    busy_micros_ += Env::Default()->NowMicros() - start_micros;
+    TF_RETURN_IF_ERROR(s);
     if (end_of_sequence) {
-      VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
-      tasks_.erase(request->task_id());
-      pending_completed_tasks_.insert(request->task_id());
+      VLOG(3) << "Reached end_of_sequence for task " << task_id;
+      tasks_.erase(task_id);
+      pending_completed_tasks_.insert(task_id);
       task_completion_cv_.notify_one();
+    } else {
+      ++num_elements_produced_;
     }
   }
 
   if (!end_of_sequence) {
-    VLOG(3) << "Producing an element for task " << request->task_id();
-    if (outputs.size() != 1) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but the "
-          "dataset produced ",
-          outputs.size(), " outputs");
+    VLOG(3) << "Producing an element for task " << task_id;
+    TF_RETURN_IF_ERROR(ExtractCompressedElement(outputs, element));
+  }
+
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::GetRoundElement(const GetElementRequest& request,
+                                              CompressedElement& element,
+                                              bool& end_of_sequence,
+                                              bool& skipped) {
+  const int64 task_id = request.task_id();
+  const int64 consumer_index = request.consumer_index();
+  const int64 round_index = request.round_index();
+  const int64 round_timeout_micros =
+      (config_.round_timeout_ms() > 0 ? config_.round_timeout_ms()
+                                      : kDefaultRoundTimeoutMs) *
+      1000;
+  end_of_sequence = false;
+  skipped = false;
+  ++num_pending_requests_;
+  auto cleanup = gtl::MakeCleanup([this] { --num_pending_requests_; });
+  mutex_lock l(mu_);
+  while (true) {
+    if (cancelled_) {
+      return errors::Cancelled("Worker is shutting down");
     }
-    if (outputs[0].dtype() != DT_VARIANT) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with type ",
-          DataTypeString(outputs[0].dtype()));
+    // The task may be deleted while we wait, so look it up on every iteration.
+    auto it = tasks_.find(task_id);
+    if (it == tasks_.end()) {
+      end_of_sequence = true;
+      return Status::OK();
     }
-    if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with shape ",
-          outputs[0].shape());
+    Task& task = *it->second;
+    const int64 num_consumers = task.task_def.num_consumers();
+    if (consumer_index < 0 || consumer_index >= num_consumers) {
+      return errors::InvalidArgument("Consumer index ", consumer_index,
+                                     " is out of range for task ", task_id,
+                                     ", which has ", num_consumers,
+                                     " consumers.");
     }
-    Variant& variant = outputs[0].scalar<Variant>()();
-    CompressedElement* compressed = variant.get<CompressedElement>();
-    if (compressed == nullptr) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a CompressedElement variant tensor, but "
-          "it produced ",
-          variant.TypeName());
+    // A round cut short by the end of the sequence is dropped for all
+    // consumers, so that they all read the same number of rounds.
+    if (task.round_end_of_sequence) {
+      end_of_sequence = true;
+      return Status::OK();
+    }
+    if (task.round == round_index) {
+      if (!task.round_fetched[consumer_index]) {
+        task.round_fetched[consumer_index] = true;
+        ++task.num_round_fetched;
+        if (task.num_round_fetched == num_consumers) {
+          round_cv_.notify_all();
+        }
+      }
+      // Copy the element rather than moving it out, so that a retried request
+      // gets the same element.
+      element = task.round_elements[consumer_index];
+      return Status::OK();
     }
-    compressed->Swap(response->mutable_compressed_element());
+    if (task.round > round_index) {
+      if (task.previous_round == round_index &&
+          task.previous_round_fetched[consumer_index]) {
+        // A retry of a request whose response was lost.
+        element = task.previous_round_elements[consumer_index];
+        return Status::OK();
+      }
+      VLOG(1) << "Consumer " << consumer_index << " requested round "
+              << round_index << " of task " << task_id
+              << " after the task moved on to round " << task.round
+              << ", so it skips the round.";
+      skipped = true;
+      return Status::OK();
+    }
+    if (task.round >= 0 && task.num_round_fetched < num_consumers) {
+      // Some consumers haven't read the current round yet. Wait for them until
+      // the round times out, then move on without them so that a slow or
+      // failed consumer doesn't stall all the others.
+      const int64 now_micros = Env::Default()->NowMicros();
+      const int64 deadline_micros =
+          task.round_start_micros + round_timeout_micros;
+      if (now_micros < deadline_micros) {
+        round_cv_.wait_for(
+            l, std::chrono::microseconds(deadline_micros - now_micros));
+        continue;
+      }
+      VLOG(1) << "Round " << task.round << " of task " << task_id
+              << " timed out with " << num_consumers - task.num_round_fetched
+              << " consumers yet to read it.";
+    }
+    TF_RETURN_IF_ERROR(PrepareRound(task, round_index));
+    round_cv_.notify_all();
   }
-  response->set_end_of_sequence(end_of_sequence);
+}
 
+Status DataServiceWorkerImpl::PrepareRound(Task& task, int64 round_index)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64 task_id = task.task_def.task_id();
+  const int64 num_consumers = task.task_def.num_consumers();
+  VLOG(3) << "Preparing round " << round_index << " of task " << task_id;
+  TF_RETURN_IF_ERROR(EnsureTaskInitialized(task));
+  std::vector<CompressedElement> elements(num_consumers);
+  for (int64 i = 0; i < num_consumers; ++i) {
+    std::vector<Tensor> outputs;
+    bool end_of_sequence = false;
+    const int64 start_micros = Env::Default()->NowMicros();
+    Status s = task.iterator->GetNext(&outputs, &end_of_sequence);
+    busy_micros_ += Env::Default()->NowMicros() - start_micros;
+    TF_RETURN_IF_ERROR(s);
+    if (end_of_sequence) {
+      VLOG(3) << "Reached end_of_sequence for task " << task_id;
+      task.round_end_of_sequence = true;
+      pending_completed_tasks_.insert(task_id);
+      task_completion_cv_.notify_one();
+      return Status::OK();
+    }
+    ++num_elements_produced_;
+    TF_RETURN_IF_ERROR(ExtractCompressedElement(outputs, elements[i]));
+  }
+  task.previous_round = task.round;
+  task.previous_round_elements = std::move(task.round_elements);
+  task.previous_round_fetched = std::move(task.round_fetched);
+  task.round = round_index;
+  task.round_start_micros = Env::Default()->NowMicros();
+  task.round_elements = std::move(elements);
+  task.round_fetched.assign(num_consumers, false);
+  task.num_round_fetched = 0;
   return Status::OK();
 }
 
@@ -300,16 +510,18 @@ void DataServiceWorkerImpl::HeartbeatThread() LOCKS_EXCLUDED(mu_) {
 
 Status DataServiceWorkerImpl::Heartbeat() LOCKS_EXCLUDED(mu_) {
   std::vector<int64> current_tasks;
+  WorkerLoad load;
   {
     mutex_lock l(mu_);
     for (const auto& task : tasks_) {
       current_tasks.push_back(task.first);
     }
+    load = TakeLoad();
   }
   std::vector<TaskDef> new_tasks;
   std::vector<int64> tasks_to_delete;
   TF_RETURN_IF_ERROR(dispatcher_->WorkerHeartbeat(
-      worker_address_, current_tasks, new_tasks, tasks_to_delete));
+      worker_address_, current_tasks, load, new_tasks, tasks_to_delete));
   mutex_lock l(mu_);
   for (const auto& task : new_tasks) {
     Status s = ProcessTaskInternal(task);
@@ -323,8 +535,26 @@ Status DataServiceWorkerImpl::Heartbeat() LOCKS_EXCLUDED(mu_) {
             << " at the request of the dispatcher";
     tasks_.erase(task_id);
   }
+  // Wake up requests waiting for rounds of deleted tasks.
+  round_cv_.notify_all();
   return Status::OK();
 }
 
+WorkerLoad DataServiceWorkerImpl::TakeLoad() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  WorkerLoad load;
+  const int64 now_micros = Env::Default()->NowMicros();
+  const int64 elapsed_micros = now_micros - load_period_start_micros_;
+  if (load_period_start_micros_ > 0 && elapsed_micros > 0) {
+    load.set_busy_fraction(static_cast<double>(busy_micros_) / elapsed_micros);
+    load.set_elements_per_second(num_elements_produced_ * 1e6 /
+                                 elapsed_micros);
+  }
+  load.set_num_pending_requests(num_pending_requests_.load());
+  load_period_start_micros_ = now_micros;
+  busy_micros_ = 0;
+  num_elements_produced_ = 0;
+  return load;
+}
+
 }  // namespace data
 }  // namespace tensorflow
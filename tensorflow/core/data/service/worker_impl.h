@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 
+#include <atomic>
+
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_service.h"
@@ -50,6 +52,8 @@ class DataServiceWorkerImpl {
   /// Client-facing API.
   Status GetElement(const GetElementRequest* request,
                     GetElementResponse* response);
+  Status GetElements(const GetElementsRequest* request,
+                     GetElementsResponse* response);
   Status GetWorkerTasks(const GetWorkerTasksRequest* request,
                         GetWorkerTasksResponse* response);
 
@@ -64,6 +68,21 @@ class DataServiceWorkerImpl {
     // standalone::Dataset so that we don't need to store the dataset here.
     std::unique_ptr<standalone::Dataset> dataset;
     std::unique_ptr<standalone::Iterator> iterator;
+
+    // State of tasks read in coordinated rounds, guarded by the worker's
+    // `mu_`. `round_elements` holds one element for every consumer of the
+    // current round, which is -1 before the first round. The elements of the
+    // previous round are kept as well, so that consumers can retry requests
+    // whose responses were lost.
+    int64 round = -1;
+    int64 round_start_micros = 0;
+    std::vector<CompressedElement> round_elements;
+    std::vector<bool> round_fetched;
+    int64 num_round_fetched = 0;
+    int64 previous_round = -1;
+    std::vector<CompressedElement> previous_round_elements;
+    std::vector<bool> previous_round_fetched;
+    bool round_end_of_sequence = false;
   };
 
   // Sends task status to the dispatcher and checks for dispatcher commands.
@@ -71,12 +90,28 @@ class DataServiceWorkerImpl {
   // Creates an iterator to process a task.
   Status ProcessTaskInternal(const TaskDef& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
   Status EnsureTaskInitialized(Task& task);
+  // Produces the next element of task `task_id` into `element`, or sets
+  // `end_of_sequence` if the task has no more elements.
+  Status GetElementInternal(int64 task_id, CompressedElement& element,
+                            bool& end_of_sequence) LOCKS_EXCLUDED(mu_);
+  // Serves `request` for a task read in coordinated rounds. This waits until
+  // all consumers have read the task's current round, or until the round
+  // times out, before producing the requested round. Sets `skipped` if the
+  // task moved on from the requested round before the consumer read it.
+  Status GetRoundElement(const GetElementRequest& request,
+                         CompressedElement& element, bool& end_of_sequence,
+                         bool& skipped) LOCKS_EXCLUDED(mu_);
+  // Produces the elements of round `round_index` of `task`.
+  Status PrepareRound(Task& task, int64 round_index)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // A thread for notifying the dispatcher when tasks complete.
   void TaskCompletionThread() LOCKS_EXCLUDED(mu_);
   // A thread for doing periodic heartbeats to the dispatcher.
   void HeartbeatThread() LOCKS_EXCLUDED(mu_);
   // Performs a heartbeat to the dispatcher.
   Status Heartbeat() LOCKS_EXCLUDED(mu_);
+  // Returns the load since the previous call, and starts a new load period.
+  WorkerLoad TakeLoad() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   const experimental::WorkerConfig config_;
   // The worker's own address.
@@ -91,6 +126,17 @@ class DataServiceWorkerImpl {
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
   // Whether the worker has registered with the dispatcher yet.
   bool registered_ TF_GUARDED_BY(mu_) = false;
+  // Load since the previous heartbeat, reported to the dispatcher in the next
+  // heartbeat.
+  int64 load_period_start_micros_ TF_GUARDED_BY(mu_) = 0;
+  int64 busy_micros_ TF_GUARDED_BY(mu_) = 0;
+  int64 num_elements_produced_ TF_GUARDED_BY(mu_) = 0;
+  // The number of element requests waiting for or being served. This is not
+  // guarded by `mu_` because requests wait for `mu_` while producing elements.
+  std::atomic<int64> num_pending_requests_{0};
+  // Notified when a task read in coordinated rounds moves on to a new round,
+  // or when all of its consumers have read the current round.
+  condition_variable round_cv_ TF_GUARDED_BY(mu_);
   // A thread for notifying the dispatcher when tasks complete.
   std::unique_ptr<Thread> task_completion_thread_;
   condition_variable task_completion_cv_ TF_GUARDED_BY(mu_);
@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/worker_load.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr double WorkerLoadTracker::kSaturatedBusyFraction;
+/* static */ constexpr double WorkerLoadTracker::kTargetBusyFraction;
+/* static */ constexpr int64 WorkerLoadTracker::kDefaultExpirationMicros;
+
+void WorkerLoadTracker::Record(const std::string& worker_address,
+                               const WorkerLoad& load, int64 now_micros) {
+  loads_[worker_address] = {load, now_micros};
+}
+
+void WorkerLoadTracker::RemoveExpired(int64 now_micros) {
+  for (auto it = loads_.begin(); it != loads_.end();) {
+    if (now_micros - it->second.report_micros > expiration_micros_) {
+      loads_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int64 WorkerLoadTracker::NumSaturatedWorkers() const {
+  int64 num_saturated = 0;
+  for (const auto& it : loads_) {
+    if (IsSaturated(it.second.load)) {
+      ++num_saturated;
+    }
+  }
+  return num_saturated;
+}
+
+int64 WorkerLoadTracker::DesiredNumWorkers() const {
+  if (loads_.empty()) {
+    return 0;
+  }
+  double total_busy_fraction = 0;
+  for (const auto& it : loads_) {
+    total_busy_fraction += std::min(it.second.load.busy_fraction(), 1.0);
+  }
+  int64 desired = static_cast<int64>(
+      std::ceil(total_busy_fraction / kTargetBusyFraction));
+  desired = std::max<int64>(desired, 1);
+  if (NumSaturatedWorkers() > 0) {
+    desired = std::max<int64>(desired, NumWorkers() + 1);
+  }
+  return desired;
+}
+
+/* static */ bool WorkerLoadTracker::IsSaturated(const WorkerLoad& load) {
+  return load.busy_fraction() >= kSaturatedBusyFraction &&
+         load.num_pending_requests() > 0;
+}
+
+}  // namespace data
+}  // namespace tensorflow
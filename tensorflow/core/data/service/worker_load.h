@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_LOAD_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_WORKER_LOAD_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// Keeps the latest load reported by each worker, and derives from it how many
+// workers the service needs. This is a signal for cluster autoscalers; the
+// dispatcher doesn't add or remove workers itself. Workers which stop
+// reporting, e.g. because they were shut down, are forgotten after
+// `expiration_micros`.
+//
+// Not thread-safe.
+class WorkerLoadTracker {
+ public:
+  // Workers reporting at least this busy fraction while requests are waiting
+  // for them are considered saturated.
+  static constexpr double kSaturatedBusyFraction = 0.95;
+  // The busy fraction that `DesiredNumWorkers` aims for on every worker,
+  // leaving headroom for bursts.
+  static constexpr double kTargetBusyFraction = 0.75;
+  // How long the load of a worker is kept without a new report, well above
+  // the heartbeat interval of workers.
+  static constexpr int64 kDefaultExpirationMicros = 5 * 60 * 1000 * 1000;
+
+  explicit WorkerLoadTracker(
+      int64 expiration_micros = kDefaultExpirationMicros)
+      : expiration_micros_(expiration_micros) {}
+
+  // Records the latest load of the worker at `worker_address`, reported at
+  // `now_micros`.
+  void Record(const std::string& worker_address, const WorkerLoad& load,
+              int64 now_micros);
+
+  // Forgets the workers which have not reported their load for the expiration
+  // time as of `now_micros`.
+  void RemoveExpired(int64 now_micros);
+
+  // Returns the number of workers which have reported load.
+  int64 NumWorkers() const { return loads_.size(); }
+
+  // Returns the number of workers that are saturated.
+  int64 NumSaturatedWorkers() const;
+
+  // Returns the number of workers needed to bring every worker to
+  // `kTargetBusyFraction`. If any worker is saturated, the true demand can't be
+  // observed, so at least one more worker than today is requested.
+  int64 DesiredNumWorkers() const;
+
+ private:
+  struct ReportedLoad {
+    WorkerLoad load;
+    int64 report_micros;
+  };
+
+  static bool IsSaturated(const WorkerLoad& load);
+
+  const int64 expiration_micros_;
+  absl::flat_hash_map<std::string, ReportedLoad> loads_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_WORKER_LOAD_H_
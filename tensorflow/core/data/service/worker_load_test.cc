@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/worker_load.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+WorkerLoad Load(double busy_fraction, int64 num_pending_requests) {
+  WorkerLoad load;
+  load.set_busy_fraction(busy_fraction);
+  load.set_num_pending_requests(num_pending_requests);
+  return load;
+}
+}  // namespace
+
+TEST(WorkerLoadTracker, NoWorkers) {
+  WorkerLoadTracker tracker;
+  EXPECT_EQ(tracker.NumWorkers(), 0);
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 0);
+}
+
+TEST(WorkerLoadTracker, ScalesDownIdleWorkers) {
+  WorkerLoadTracker tracker;
+  for (int i = 0; i < 4; ++i) {
+    tracker.Record(absl::StrCat("worker", i), Load(0.3, 0), /*now_micros=*/0);
+  }
+  EXPECT_EQ(tracker.NumWorkers(), 4);
+  EXPECT_EQ(tracker.NumSaturatedWorkers(), 0);
+  // 4 * 0.3 / 0.75 = 1.6.
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 2);
+}
+
+TEST(WorkerLoadTracker, KeepsAtLeastOneWorker) {
+  WorkerLoadTracker tracker;
+  tracker.Record("worker0", Load(0, 0), /*now_micros=*/0);
+  tracker.Record("worker1", Load(0, 0), /*now_micros=*/0);
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 1);
+}
+
+TEST(WorkerLoadTracker, ScalesUpSaturatedWorkers) {
+  WorkerLoadTracker tracker;
+  tracker.Record("worker0", Load(1.0, 3), /*now_micros=*/0);
+  tracker.Record("worker1", Load(0.2, 0), /*now_micros=*/0);
+  EXPECT_EQ(tracker.NumSaturatedWorkers(), 1);
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 3);
+}
+
+TEST(WorkerLoadTracker, BusyWithoutWaitingRequestsIsNotSaturated) {
+  WorkerLoadTracker tracker;
+  tracker.Record("worker0", Load(1.0, 0), /*now_micros=*/0);
+  EXPECT_EQ(tracker.NumSaturatedWorkers(), 0);
+  // 1.0 / 0.75 rounds up to 2.
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 2);
+}
+
+TEST(WorkerLoadTracker, KeepsLatestLoad) {
+  WorkerLoadTracker tracker;
+  tracker.Record("worker0", Load(1.0, 3), /*now_micros=*/0);
+  tracker.Record("worker0", Load(0.5, 0), /*now_micros=*/0);
+  EXPECT_EQ(tracker.NumWorkers(), 1);
+  EXPECT_EQ(tracker.NumSaturatedWorkers(), 0);
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 1);
+}
+
+TEST(WorkerLoadTracker, ForgetsWorkersWhichStopReporting) {
+  WorkerLoadTracker tracker(/*expiration_micros=*/1000);
+  tracker.Record("worker0", Load(1.0, 3), /*now_micros=*/0);
+  tracker.Record("worker1", Load(0.5, 0), /*now_micros=*/500);
+  tracker.RemoveExpired(/*now_micros=*/1000);
+  EXPECT_EQ(tracker.NumWorkers(), 2);
+
+  tracker.RemoveExpired(/*now_micros=*/1200);
+  EXPECT_EQ(tracker.NumWorkers(), 1);
+  EXPECT_EQ(tracker.NumSaturatedWorkers(), 0);
+  // Reporting again keeps a worker.
+  tracker.Record("worker1", Load(0.5, 0), /*now_micros=*/1300);
+  tracker.RemoveExpired(/*now_micros=*/2000);
+  EXPECT_EQ(tracker.NumWorkers(), 1);
+  tracker.RemoveExpired(/*now_micros=*/2400);
+  EXPECT_EQ(tracker.NumWorkers(), 0);
+  EXPECT_EQ(tracker.DesiredNumWorkers(), 0);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,409 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// End-to-end benchmarks of representative tf.data input pipelines, executed
+// with the standalone API under fixed thread budgets.
+//
+// For each pipeline and budget, the benchmark reports the elements produced
+// per second, the process CPU time per element and the peak memory allocated
+// by the CPU allocator. The results are printed and, if TEST_REPORT_FILE_PREFIX
+// is set, written as BenchmarkEntries (in JSON if TEST_REPORT_FILE_FORMAT is
+// "json") so that they can be compared across versions.
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/reporter.h"
+
+namespace tensorflow {
+namespace data {
+namespace standalone {
+namespace {
+
+using test::function::NDef;
+using FDH = FunctionDefHelper;
+
+constexpr int kNumFiles = 64;
+constexpr int kRecordsPerFile = 256;
+constexpr int kFeatureSize = 16;
+constexpr int64 kBatchSize = 32;
+constexpr int64 kShuffleBufferSize = 10000;
+constexpr int kNumWarmupElements = 100;
+constexpr int kNumElements = 2000;
+// The values of `inter_op_parallelism_threads`, which bound the threads of
+// the pipelines, and of their `num_parallel_calls`.
+constexpr int kThreadBudgets[] = {1, 4, 16};
+
+// Writes `kNumFiles` TFRecord files of serialized tf.Examples with a float
+// feature "x" of `kFeatureSize` values, and returns their names.
+std::vector<tstring> WriteExampleFiles() {
+  Example example;
+  auto* values = (*example.mutable_features()->mutable_feature())["x"]
+                     .mutable_float_list();
+  for (int i = 0; i < kFeatureSize; ++i) values->add_value(i);
+  const string record = example.SerializeAsString();
+
+  std::vector<tstring> filenames;
+  for (int i = 0; i < kNumFiles; ++i) {
+    const string filename =
+        io::JoinPath(testing::TmpDir(),
+                     absl::StrCat("standalone_benchmark_", i, ".tfrecord"));
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(filename, &file));
+    io::RecordWriter writer(file.get());
+    for (int j = 0; j < kRecordsPerFile; ++j) {
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+    filenames.push_back(filename);
+  }
+  return filenames;
+}
+
+// filename: string -> y: TFRecordDataset of the file.
+FunctionDef ReadTFRecords() {
+  return FDH::Create(
+      // Name
+      "ReadTFRecords",
+      // Args
+      {"filename: string"},
+      // Return values
+      {"y: variant"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"compression_type"},
+        "Const",
+        {},
+        {{"dtype", DT_STRING}, {"value", test::AsScalar<tstring>("")}}},
+       {{"buffer_size"},
+        "Const",
+        {},
+        {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(256 << 10)}}},
+       {{"dataset"},
+        "TFRecordDataset",
+        {"filename", "compression_type:output:0", "buffer_size:output:0"},
+        {}}},
+      {{"y", "dataset:handle:0"}});
+}
+
+NodeDef Int64Const(const string& name, int64 value) {
+  return NDef(name, "Const", {},
+              {{"dtype", DT_INT64}, {"value", test::AsScalar<int64>(value)}});
+}
+
+// Builds the nodes of the graphs of the benchmarked pipelines. Each Add*
+// method appends a dataset reading from the previous one.
+class PipelineBuilder {
+ public:
+  explicit PipelineBuilder(const std::vector<tstring>& filenames)
+      : filenames_(filenames) {}
+
+  // Reads the files sequentially, forever.
+  PipelineBuilder& AddTFRecords() {
+    nodes_.push_back(NDef("filenames", "Const", {},
+                          {{"dtype", DT_STRING},
+                           {"value", test::AsTensor<tstring>(filenames_)}}));
+    nodes_.push_back(NDef("compression_type", "Const", {},
+                          {{"dtype", DT_STRING},
+                           {"value", test::AsScalar<tstring>("")}}));
+    nodes_.push_back(Int64Const("buffer_size", 256 << 10));
+    nodes_.push_back(NDef("tfrecord", "TFRecordDataset",
+                          {"filenames", "compression_type", "buffer_size"}));
+    last_ = "tfrecord";
+    SetOutput(DT_STRING, PartialTensorShape({}));
+    return AddRepeat();
+  }
+
+  // Reads the files `cycle_length` at a time, forever.
+  PipelineBuilder& AddInterleavedTFRecords(int64 cycle_length,
+                                           int64 num_parallel_calls) {
+    nodes_.push_back(NDef("filenames", "Const", {},
+                          {{"dtype", DT_STRING},
+                           {"value", test::AsTensor<tstring>(filenames_)}}));
+    nodes_.push_back(NDef(
+        "tensor_slice", "TensorSliceDataset", {"filenames"},
+        {{"Toutput_types", DataTypeVector{DT_STRING}},
+         {"output_shapes",
+          std::vector<PartialTensorShape>{PartialTensorShape({})}}}));
+    last_ = "tensor_slice";
+    SetOutput(DT_STRING, PartialTensorShape({}));
+    AddRepeat();
+    const string input = last_;
+    const string prefix = NextName("interleave");
+    nodes_.push_back(Int64Const(prefix + "/cycle_length", cycle_length));
+    nodes_.push_back(Int64Const(prefix + "/block_length", 1));
+    nodes_.push_back(Int64Const(prefix + "/buffer_output_elements",
+                                model::kAutotune));
+    nodes_.push_back(Int64Const(prefix + "/prefetch_input_elements",
+                                model::kAutotune));
+    nodes_.push_back(
+        Int64Const(prefix + "/num_parallel_calls", num_parallel_calls));
+    nodes_.push_back(NDef(
+        prefix, "ParallelInterleaveDatasetV4",
+        {input, prefix + "/cycle_length", prefix + "/block_length",
+         prefix + "/buffer_output_elements",
+         prefix + "/prefetch_input_elements", prefix + "/num_parallel_calls"},
+        {{"f", FDH::FunctionRef("ReadTFRecords")},
+         {"Targuments", DataTypeVector{}},
+         {"output_types", DataTypeVector{output_type_}},
+         {"output_shapes", std::vector<PartialTensorShape>{output_shape_}}}));
+    last_ = prefix;
+    return *this;
+  }
+
+  // Parses the records as tf.Examples with a float feature "x".
+  PipelineBuilder& AddParseExample(int64 num_parallel_calls) {
+    const string prefix = NextName("parse");
+    nodes_.push_back(
+        Int64Const(prefix + "/num_parallel_calls", num_parallel_calls));
+    nodes_.push_back(
+        NDef(prefix + "/dense_defaults", "Const", {},
+             {{"dtype", DT_FLOAT},
+              {"value", Tensor(DT_FLOAT, TensorShape({0}))}}));
+    SetOutput(DT_FLOAT, PartialTensorShape({kFeatureSize}));
+    nodes_.push_back(NDef(
+        prefix, "ParseExampleDataset",
+        {last_, prefix + "/num_parallel_calls", prefix + "/dense_defaults"},
+        {{"sparse_keys", std::vector<string>{}},
+         {"dense_keys", std::vector<string>{"x"}},
+         {"sparse_types", DataTypeVector{}},
+         {"Tdense", DataTypeVector{DT_FLOAT}},
+         {"dense_shapes",
+          std::vector<TensorShape>{TensorShape({kFeatureSize})}},
+         {"output_types", DataTypeVector{output_type_}},
+         {"output_shapes", std::vector<PartialTensorShape>{output_shape_}}}));
+    last_ = prefix;
+    return *this;
+  }
+
+  // Doubles the elements.
+  PipelineBuilder& AddParallelMap(int64 num_parallel_calls) {
+    const string prefix = NextName("map");
+    nodes_.push_back(
+        Int64Const(prefix + "/num_parallel_calls", num_parallel_calls));
+    nodes_.push_back(NDef(
+        prefix, "ParallelMapDatasetV2",
+        {last_, prefix + "/num_parallel_calls"},
+        {{"f", FDH::FunctionRef("XTimesTwo", {{"T", output_type_}})},
+         {"Targuments", DataTypeVector{}},
+         {"output_types", DataTypeVector{output_type_}},
+         {"output_shapes", std::vector<PartialTensorShape>{output_shape_}}}));
+    last_ = prefix;
+    return *this;
+  }
+
+  PipelineBuilder& AddShuffle(int64 buffer_size) {
+    const string prefix = NextName("shuffle");
+    nodes_.push_back(Int64Const(prefix + "/buffer_size", buffer_size));
+    nodes_.push_back(Int64Const(prefix + "/seed", 1));
+    nodes_.push_back(Int64Const(prefix + "/seed2", 2));
+    AddDataset(prefix, "ShuffleDataset",
+               {prefix + "/buffer_size", prefix + "/seed", prefix + "/seed2"});
+    return *this;
+  }
+
+  PipelineBuilder& AddBatch(int64 batch_size) {
+    const string prefix = NextName("batch");
+    nodes_.push_back(Int64Const(prefix + "/batch_size", batch_size));
+    nodes_.push_back(
+        NDef(prefix + "/drop_remainder", "Const", {},
+             {{"dtype", DT_BOOL}, {"value", test::AsScalar<bool>(true)}}));
+    PartialTensorShape batched_shape({batch_size});
+    batched_shape.AppendShape(output_shape_);
+    SetOutput(output_type_, batched_shape);
+    AddDataset(prefix, "BatchDatasetV2",
+               {prefix + "/batch_size", prefix + "/drop_remainder"});
+    return *this;
+  }
+
+  PipelineBuilder& AddPrefetch(int64 buffer_size) {
+    const string prefix = NextName("prefetch");
+    nodes_.push_back(Int64Const(prefix + "/buffer_size", buffer_size));
+    AddDataset(prefix, "PrefetchDataset", {prefix + "/buffer_size"});
+    return *this;
+  }
+
+  GraphDef Build() {
+    nodes_.push_back(
+        NDef("retval", "_Retval", {last_}, {{"T", DT_VARIANT}, {"index", 0}}));
+    return test::function::GDef(
+        nodes_, {test::function::XTimesTwo(), ReadTFRecords()});
+  }
+
+ private:
+  PipelineBuilder& AddRepeat() {
+    const string prefix = NextName("repeat");
+    nodes_.push_back(Int64Const(prefix + "/count", -1));
+    AddDataset(prefix, "RepeatDataset", {prefix + "/count"});
+    return *this;
+  }
+
+  // Adds a dataset transforming the last one, with the given other inputs and
+  // the current output types and shapes.
+  void AddDataset(const string& name, const string& op,
+                  std::vector<string> inputs) {
+    inputs.insert(inputs.begin(), last_);
+    nodes_.push_back(NDef(
+        name, op, inputs,
+        {{"output_types", DataTypeVector{output_type_}},
+         {"output_shapes", std::vector<PartialTensorShape>{output_shape_}}}));
+    last_ = name;
+  }
+
+  void SetOutput(DataType type, const PartialTensorShape& shape) {
+    output_type_ = type;
+    output_shape_ = shape;
+  }
+
+  string NextName(const string& prefix) {
+    return absl::StrCat(prefix, "_", nodes_.size());
+  }
+
+  const std::vector<tstring>& filenames_;
+  std::vector<NodeDef> nodes_;
+  string last_;
+  DataType output_type_ = DT_INVALID;
+  PartialTensorShape output_shape_;
+};
+
+struct Pipeline {
+  string name;
+  GraphDef (*build)(const std::vector<tstring>& filenames, int threads);
+};
+
+const Pipeline kPipelines[] = {
+    {"TFRecordParseMapBatchPrefetch",
+     [](const std::vector<tstring>& filenames, int threads) {
+       return PipelineBuilder(filenames)
+           .AddTFRecords()
+           .AddParseExample(threads)
+           .AddParallelMap(threads)
+           .AddBatch(kBatchSize)
+           .AddPrefetch(/*buffer_size=*/2)
+           .Build();
+     }},
+    {"InterleaveManyFiles",
+     [](const std::vector<tstring>& filenames, int threads) {
+       return PipelineBuilder(filenames)
+           .AddInterleavedTFRecords(/*cycle_length=*/16, threads)
+           .AddParseExample(threads)
+           .AddBatch(kBatchSize)
+           .AddPrefetch(/*buffer_size=*/2)
+           .Build();
+     }},
+    {"ShuffleLargeBuffer",
+     [](const std::vector<tstring>& filenames, int threads) {
+       return PipelineBuilder(filenames)
+           .AddTFRecords()
+           .AddParseExample(threads)
+           .AddShuffle(kShuffleBufferSize)
+           .AddBatch(kBatchSize)
+           .Build();
+     }},
+};
+
+void GetNextElements(Iterator* iterator, int num_elements) {
+  for (int i = 0; i < num_elements; ++i) {
+    std::vector<Tensor> outputs;
+    bool end_of_input = false;
+    TF_CHECK_OK(iterator->GetNext(&outputs, &end_of_input));
+    CHECK(!end_of_input);
+  }
+}
+
+void RunPipelineBenchmark(const Pipeline& pipeline, int threads,
+                          const std::vector<tstring>& filenames) {
+  const string name = absl::StrCat("BM_", pipeline.name, "/", threads);
+  Dataset::Params params;
+  params.session_options.config.set_inter_op_parallelism_threads(threads);
+  std::unique_ptr<Dataset> dataset;
+  TF_CHECK_OK(Dataset::FromGraph(params, pipeline.build(filenames, threads),
+                                 &dataset));
+  std::unique_ptr<Iterator> iterator;
+  TF_CHECK_OK(dataset->MakeIterator(&iterator));
+  // Fills the buffers of the pipeline before measuring.
+  GetNextElements(iterator.get(), kNumWarmupElements);
+
+  Allocator* allocator = cpu_allocator();
+  allocator->ClearStats();
+  const std::clock_t start_cpu = std::clock();
+  const uint64 start_micros = Env::Default()->NowMicros();
+  GetNextElements(iterator.get(), kNumElements);
+  const double wall_seconds =
+      (Env::Default()->NowMicros() - start_micros) * 1e-6;
+  const double cpu_seconds =
+      static_cast<double>(std::clock() - start_cpu) / CLOCKS_PER_SEC;
+  absl::optional<AllocatorStats> stats = allocator->GetStats();
+  const int64 peak_bytes = stats ? stats->peak_bytes_in_use : 0;
+
+  const double elements_per_second = kNumElements / wall_seconds;
+  const double cpu_micros_per_element = cpu_seconds * 1e6 / kNumElements;
+  LOG(INFO) << name << ": " << elements_per_second << " elements/s, "
+            << cpu_micros_per_element << " CPU us/element, " << peak_bytes
+            << " peak bytes";
+
+  TestReporter reporter(name);
+  TF_CHECK_OK(reporter.Initialize());
+  TF_CHECK_OK(reporter.Benchmark(kNumElements, cpu_seconds, wall_seconds,
+                                 elements_per_second));
+  TF_CHECK_OK(reporter.SetProperty("inter_op_parallelism_threads", threads));
+  TF_CHECK_OK(reporter.AddMetric("elements_per_second", elements_per_second));
+  TF_CHECK_OK(
+      reporter.AddMetric("cpu_micros_per_element", cpu_micros_per_element));
+  TF_CHECK_OK(reporter.AddMetric("peak_memory_bytes", peak_bytes));
+  TF_CHECK_OK(reporter.Close());
+}
+
+void RunPipelineBenchmarks() {
+  EnableCPUAllocatorStats();
+  const std::vector<tstring> filenames = WriteExampleFiles();
+  for (const Pipeline& pipeline : kPipelines) {
+    for (int threads : kThreadBudgets) {
+      RunPipelineBenchmark(pipeline, threads, filenames);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace standalone
+}  // namespace data
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::data::standalone::RunPipelineBenchmarks();
+  return 0;
+}
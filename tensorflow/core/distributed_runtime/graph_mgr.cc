@@ -422,7 +422,13 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
   const uint64 start_time_usecs = Env::Default()->NowMicros();
   profiler::TraceMeProducer activity(
       // To TraceMeConsumers in ExecutorState::Process/Finish or RunGraphDone.
-      [step_id] {
+      [step_id, &opts] {
+        if (opts.request_id() != 0) {
+          return profiler::TraceMeEncode("RunGraph",
+                                         {{"id", step_id},
+                                          {"_r", 1} /*root_event*/,
+                                          {"request_id", opts.request_id()}});
+        }
         return profiler::TraceMeEncode(
             "RunGraph", {{"id", step_id}, {"_r", 1} /*root_event*/});
       },
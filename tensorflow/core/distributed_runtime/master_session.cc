@@ -48,10 +48,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -61,6 +63,92 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Client graphs built for different (feeds, fetches, targets) signatures
+// often partition into identical subgraphs on the workers that the
+// differences do not touch.  PartitionRegistry tracks the subgraphs that the
+// ReffedClientGraphs of a session have registered, so that such a subgraph
+// is registered once and deregistered when its last user goes away.  Each
+// ReffedClientGraph holds a reference, as it may outlive its MasterSession.
+class MasterSession::PartitionRegistry : public core::RefCounted {
+ public:
+  // If a partition with `key` is registered, returns true and its graph
+  // handle in `*graph_handle`, and adds a user.
+  bool Acquire(const string& key, string* graph_handle) {
+    mutex_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    ++it->second.num_users;
+    *graph_handle = it->second.graph_handle;
+    return true;
+  }
+
+  // Records a newly registered partition with a single user.  Returns false
+  // if a partition with `key` has been added concurrently, in which case
+  // the caller keeps `graph_handle` to itself.
+  bool Add(const string& key, const string& graph_handle) {
+    mutex_lock l(mu_);
+    return entries_.insert({key, Entry{graph_handle, 1}}).second;
+  }
+
+  // Removes a user of the partition with `key`.  Returns true if it was the
+  // last one, and the partition should be deregistered.
+  bool Release(const string& key) {
+    mutex_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return true;
+    if (--it->second.num_users > 0) return false;
+    entries_.erase(it);
+    return true;
+  }
+
+ private:
+  struct Entry {
+    string graph_handle;
+    int num_users;
+  };
+
+  mutex mu_;
+  std::unordered_map<string, Entry> entries_ TF_GUARDED_BY(mu_);
+};
+
+namespace {
+// Returns the PartitionRegistry key of the partition registered on `worker`
+// by `req`.  The names of the nodes added by graph partitioning, in
+// `generated_names`, are unique within the session and do not change the
+// meaning of the partition, so they are canonicalized before fingerprinting.
+// Send and recv nodes are paired through their `tensor_name` attributes,
+// which remain part of the key.
+string PartitionRegistryKey(const string& worker,
+                            const RegisterGraphRequest& req,
+                            const std::unordered_set<string>& generated_names) {
+  RegisterGraphRequest canonical = req;
+  std::unordered_map<string, string> renames;
+  for (NodeDef& node : *canonical.mutable_graph_def()->mutable_node()) {
+    if (generated_names.count(node.name()) > 0) {
+      string name = strings::StrCat("_generated_", renames.size());
+      renames.emplace(node.name(), name);
+      node.set_name(name);
+    }
+  }
+  for (NodeDef& node : *canonical.mutable_graph_def()->mutable_node()) {
+    for (string& input : *node.mutable_input()) {
+      const TensorId id = ParseTensorName(input);
+      auto it = renames.find(string(id.node()));
+      if (it == renames.end()) continue;
+      if (id.index() == Graph::kControlSlot) {
+        input = strings::StrCat("^", it->second);
+      } else {
+        input = strings::StrCat(it->second, ":", id.index());
+      }
+    }
+  }
+  string serialized;
+  SerializeToStringDeterministic(canonical, &serialized);
+  const Fprint128 fp = Fingerprint128(serialized);
+  return strings::StrCat(worker, ";", fp.high64, ";", fp.low64);
+}
+}  // namespace
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -73,6 +161,7 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
                     const SessionOptions& session_opts,
                     const StatsPublisherFactory& stats_publisher_factory,
                     bool is_partial, WorkerCacheInterface* worker_cache,
+                    PartitionRegistry* partition_registry,
                     bool should_deregister)
       : session_handle_(handle),
         bg_opts_(bopts),
@@ -81,9 +170,11 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         is_partial_(is_partial),
         callable_opts_(bopts.callable_options),
         worker_cache_(worker_cache),
+        partition_registry_(partition_registry),
         should_deregister_(should_deregister),
         collective_graph_key_(
             client_graph_before_register_->collective_graph_key) {
+    partition_registry_->Ref();
     VLOG(1) << "Created ReffedClientGraph for node with "
             << client_graph_before_register_->graph.num_node_ids();
 
@@ -104,9 +195,13 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
       DeregisterPartitions();
     } else {
       for (Part& part : partitions_) {
+        if (!part.registry_key.empty()) {
+          partition_registry_->Release(part.registry_key);
+        }
         worker_cache_->ReleaseWorker(part.name, part.worker);
       }
     }
+    partition_registry_->Unref();
   }
 
   const CallableOptions& callable_options() { return callable_opts_; }
@@ -235,6 +330,7 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   const bool is_partial_;
   const CallableOptions callable_opts_;
   WorkerCacheInterface* const worker_cache_;  // Not owned.
+  PartitionRegistry* const partition_registry_;  // Holds a ref.
 
   struct NodeDetails {
     explicit NodeDetails(string type_string, string detail_text)
@@ -267,6 +363,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     // this partition on the worker.
     string graph_handle;
 
+    // If not empty, the graph is shared through the session's
+    // PartitionRegistry under this key.
+    string registry_key;
+
     Part() : feed_key(3), key_fetch(3) {}
   };
 
@@ -312,7 +412,8 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
       std::unordered_map<string, GraphDef>* out_partitions);
   Status DoRegisterPartitions(
       const PartitionOptions& popts,
-      std::unordered_map<string, GraphDef> graph_partitions);
+      std::unordered_map<string, GraphDef> graph_partitions,
+      const std::unordered_set<string>& generated_names);
 
   // Prepares a number of calls to workers. One call per partition.
   // This is a generic method that handles Run, PartialRun, and RunCallable.
@@ -346,6 +447,15 @@ Status MasterSession::ReffedClientGraph::RegisterPartitions(
       mu_.unlock();
       std::unordered_map<string, GraphDef> graph_defs;
       popts.flib_def = client_graph->flib_def.get();
+      // Remember the names of the nodes added by partitioning, which
+      // PartitionRegistryKey() canonicalizes.
+      std::unordered_set<string> generated_names;
+      popts.new_name = [&generated_names,
+                        new_name = popts.new_name](const string& prefix) {
+        string name = new_name(prefix);
+        generated_names.insert(name);
+        return name;
+      };
       Status s = DoBuildPartitions(popts, client_graph.get(), &graph_defs);
       if (s.ok()) {
         // NOTE(mrry): The pointers in `graph_defs_for_publishing` do not remain
@@ -358,7 +468,8 @@ Status MasterSession::ReffedClientGraph::RegisterPartitions(
           graph_defs_for_publishing.push_back(&name_def.second);
         }
         stats_publisher_->PublishGraphProto(graph_defs_for_publishing);
-        s = DoRegisterPartitions(popts, std::move(graph_defs));
+        s = DoRegisterPartitions(popts, std::move(graph_defs),
+                                 generated_names);
       }
       mu_.lock();
       init_result_ = s;
@@ -439,7 +550,8 @@ Status MasterSession::ReffedClientGraph::DoBuildPartitions(
 
 Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     const PartitionOptions& popts,
-    std::unordered_map<string, GraphDef> graph_partitions) {
+    std::unordered_map<string, GraphDef> graph_partitions,
+    const std::unordered_set<string>& generated_names) {
   partitions_.reserve(graph_partitions.size());
   Status s;
   for (auto& name_def : graph_partitions) {
@@ -464,12 +576,14 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     RegisterGraphRequest req;
     RegisterGraphResponse resp;
     Status status;
+    bool reused = false;
   };
   const int num = partitions_.size();
   gtl::InlinedVector<Call, 4> calls(num);
   BlockingCounter done(num);
+  int num_reused = 0;
   for (int i = 0; i < num; ++i) {
-    const Part& part = partitions_[i];
+    Part& part = partitions_[i];
     Call* c = &calls[i];
     c->req.set_session_handle(session_handle_);
     c->req.set_create_worker_session_called(!should_deregister_);
@@ -481,6 +595,17 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     *c->req.mutable_debug_options() =
         callable_opts_.run_options().debug_options();
     c->req.set_collective_graph_key(collective_graph_key_);
+    part.registry_key =
+        PartitionRegistryKey(part.name, c->req, generated_names);
+    string graph_handle;
+    if (partition_registry_->Acquire(part.registry_key, &graph_handle)) {
+      // An identical partition is already registered on this worker.
+      c->resp.set_graph_handle(graph_handle);
+      c->reused = true;
+      ++num_reused;
+      done.DecrementCount();
+      continue;
+    }
     VLOG(2) << "Register " << c->req.graph_def().DebugString();
     auto cb = [c, &done](const Status& s) {
       c->status = s;
@@ -489,10 +614,18 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     part.worker->RegisterGraphAsync(&c->req, &c->resp, cb);
   }
   done.Wait();
+  VLOG(1) << "Reused " << num_reused << " of " << num
+          << " registered partitions";
   for (int i = 0; i < num; ++i) {
     Call* c = &calls[i];
+    Part& part = partitions_[i];
     s.Update(c->status);
-    partitions_[i].graph_handle = c->resp.graph_handle();
+    part.graph_handle = c->resp.graph_handle();
+    if (c->reused) continue;
+    if (!c->status.ok() ||
+        !partition_registry_->Add(part.registry_key, part.graph_handle)) {
+      part.registry_key.clear();
+    }
   }
   return s;
 }
@@ -662,6 +795,7 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
   if (pss->collect_partition_graphs) {
     exec_opts.set_record_partition_graphs(true);
   }
+  exec_opts.set_request_id(pss->request_id);
   if (pss->collect_costs || pss->collect_timeline) {
     pss->step_stats.resize(partitions_.size());
   }
@@ -1098,6 +1232,12 @@ void MasterSession::ReffedClientGraph::DeregisterPartitions() {
     DeregisterGraphResponse resp;
   };
   for (Part& part : partitions_) {
+    if (!part.registry_key.empty() &&
+        !partition_registry_->Release(part.registry_key)) {
+      // Other client graphs still use the partition.
+      worker_cache_->ReleaseWorker(part.name, part.worker);
+      continue;
+    }
     // The graph handle may be empty if we failed during partition registration.
     if (!part.graph_handle.empty()) {
       Call* c = new Call;
@@ -1240,6 +1380,7 @@ MasterSession::MasterSession(
       filtered_worker_list_(std::move(filtered_worker_list)),
       stats_publisher_factory_(std::move(stats_publisher_factory)),
       graph_version_(0),
+      partition_registry_(new PartitionRegistry),
       run_graphs_(5),
       partial_run_graphs_(5) {
   UpdateLastAccessTime();
@@ -1254,6 +1395,7 @@ MasterSession::MasterSession(
 MasterSession::~MasterSession() {
   for (const auto& iter : run_graphs_) iter.second->Unref();
   for (const auto& iter : partial_run_graphs_) iter.second->Unref();
+  partition_registry_->Unref();
 }
 
 void MasterSession::UpdateLastAccessTime() {
@@ -1542,7 +1684,7 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
       auto entry = new ReffedClientGraph(
           handle_, opts, std::move(client_graph), session_opts_,
           stats_publisher_factory_, is_partial, worker_cache,
-          !should_delete_worker_sessions_);
+          partition_registry_, !should_delete_worker_sessions_);
       iter = m->insert({hash, entry}).first;
       VLOG(1) << "Preparing to execute new graph";
     }
@@ -1743,6 +1885,7 @@ Status MasterSession::DoPartialRun(CallOptions* opts,
     pss.collect_rpcs = req.options().trace_level() == RunOptions::FULL_TRACE;
     pss.report_tensor_allocations_upon_oom =
         req.options().report_tensor_allocations_upon_oom();
+    pss.request_id = req.options().experimental().request_id();
 
     // Build the cost model every 'build_cost_model_every' steps after skipping
     // an
@@ -1880,6 +2023,7 @@ void MasterSession::FillPerStepState(MasterSession::ReffedClientGraph* rcg,
   out_pss->collect_rpcs = run_options.trace_level() == RunOptions::FULL_TRACE;
   out_pss->report_tensor_allocations_upon_oom =
       run_options.report_tensor_allocations_upon_oom();
+  out_pss->request_id = run_options.experimental().request_id();
   // Build the cost model every 'build_cost_model_every' steps after skipping an
   // initial 'build_cost_model_after' steps.
   const int64 build_cost_model_after =
@@ -2011,6 +2155,7 @@ Status MasterSession::MakeCallable(const MakeCallableRequest& req,
     callable = new ReffedClientGraph(handle_, opts, std::move(client_graph),
                                      session_opts_, stats_publisher_factory_,
                                      false /* is_partial */, get_worker_cache(),
+                                     partition_registry_,
                                      !should_delete_worker_sessions_);
   }
 
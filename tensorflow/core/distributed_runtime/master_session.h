@@ -152,6 +152,9 @@ class MasterSession : public core::RefCounted {
   // scope and lose their state.
   class ReffedClientGraph;
   typedef std::unordered_map<uint64, ReffedClientGraph*> RCGMap;
+  // Partitions registered on workers, shared among ReffedClientGraphs.
+  class PartitionRegistry;
+  PartitionRegistry* partition_registry_;
   RCGMap run_graphs_ TF_GUARDED_BY(mu_);
   RCGMap partial_run_graphs_ TF_GUARDED_BY(mu_);
   int64 next_callable_handle_ TF_GUARDED_BY(mu_) = 0;
@@ -163,6 +166,7 @@ class MasterSession : public core::RefCounted {
     bool collect_rpcs = false;
     bool collect_partition_graphs = false;
     bool report_tensor_allocations_upon_oom = false;
+    int64 request_id = 0;
     Microseconds start_micros = Microseconds(0);
     Microseconds end_micros = Microseconds(0);
     std::vector<StepStats> step_stats;  // per partition
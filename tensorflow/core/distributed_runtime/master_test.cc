@@ -422,4 +422,41 @@ TEST_F(MasterTest, EigenProblem) {
   TF_EXPECT_OK(CloseSession(handle));
 }
 
+// Runs steps with different fetches, whose client graphs share some of their
+// partitions, interleaved over several rounds.
+TEST_F(MasterTest, SharedPartitions) {
+  Graph graph(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({}));
+  test::FillValues<float>(&a_tensor, {3});
+  Node* a_node = test::graph::Constant(&graph, a_tensor);
+  Node* b_node = test::graph::Add(&graph, a_node, a_node);
+  Node* c_node = test::graph::Add(&graph, b_node, a_node);
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  for (NodeDef& node : *def.mutable_node()) {
+    node.set_device(node.name() == a_node->name()
+                        ? "/job:localhost/replica:0/task:0/cpu:0"
+                        : "/job:localhost/replica:0/task:1/cpu:0");
+  }
+
+  string handle;
+  int64 initial_version;
+  TF_ASSERT_OK(CreateSession(def, &handle, &initial_version));
+  Tensor a(DT_FLOAT, TensorShape({}));
+  Tensor b(DT_FLOAT, TensorShape({}));
+  Tensor c(DT_FLOAT, TensorShape({}));
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(RunStep(handle, {}, {{a_node->name() + ":0", &a}}));
+    test::ExpectTensorEqual<float>(a, test::AsScalar<float>(3));
+    TF_ASSERT_OK(RunStep(handle, {}, {{b_node->name() + ":0", &b}}));
+    test::ExpectTensorEqual<float>(b, test::AsScalar<float>(6));
+    TF_ASSERT_OK(RunStep(handle, {},
+                         {{b_node->name() + ":0", &b},
+                          {c_node->name() + ":0", &c}}));
+    test::ExpectTensorEqual<float>(b, test::AsScalar<float>(6));
+    test::ExpectTensorEqual<float>(c, test::AsScalar<float>(9));
+  }
+  TF_EXPECT_OK(CloseSession(handle));
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,686 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <rdma/rdma_cma.h>
+#include <rdma/rdma_verbs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/distributed_runtime/rdma/rdma.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#endif  // GOOGLE_CUDA
+
+namespace tensorflow {
+
+namespace {
+
+// Zero-length receives kept posted on each accepted connection for the
+// release notifications of the readers.
+constexpr int kNumPostedRecvs = 1024;
+constexpr int kMaxWorkRequests = 4096;
+constexpr int kCompletionQueueSize = 65536;
+constexpr int kListenBacklog = 64;
+// How long the event loop waits for events before checking for Stop() and
+// for expired tensors.
+constexpr int kPollTimeoutMs = 100;
+
+constexpr int kAccessFlags =
+    IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE;
+
+struct MemoryRegionDeleter {
+  void operator()(ibv_mr* mr) {
+    if (ibv_dereg_mr(mr)) {
+      LOG(ERROR) << "Failed to deregister RDMA memory region";
+    }
+  }
+};
+
+struct EndpointDeleter {
+  void operator()(rdma_cm_id* id) { rdma_destroy_ep(id); }
+};
+
+using MemoryRegionPtr = std::unique_ptr<ibv_mr, MemoryRegionDeleter>;
+using EndpointPtr = std::unique_ptr<rdma_cm_id, EndpointDeleter>;
+
+bool EndsBefore(const void* addr, const MemoryRegionPtr& mr) {
+  return addr < static_cast<const char*>(mr->addr) + mr->length;
+}
+
+Status SetNonBlocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    return errors::Unavailable("Cannot make fd ", fd,
+                               " non-blocking: ", std::strerror(errno));
+  }
+  return Status::OK();
+}
+
+class RdmaMemoryManager : public RemoteMemoryManager {
+ public:
+  RdmaMemoryManager(const string& host, const string& port,
+                    int64 exposed_tensor_timeout_micros)
+      : host_(host),
+        port_(port),
+        exposed_tensor_timeout_micros_(exposed_tensor_timeout_micros) {}
+
+  ~RdmaMemoryManager() override;
+
+  Status Init() override;
+  void Run() override;
+  void Stop() override { stopped_ = true; }
+
+  void TransportOptionsFromTensor(
+      int64 step_id, ::google::protobuf::Any* mutable_transport_options,
+      const Tensor& tensor, Device* device, DeviceContext* device_context,
+      bool on_host, StatusCallback done) override;
+
+  void CleanupStep(int64 step_id) override;
+
+  void TensorFromTransportOptions(
+      Tensor* tensor, const ::google::protobuf::Any& transport_options,
+      Device* device, DeviceContext* device_context,
+      const AllocatorAttributes& alloc_attrs, StatusCallback done) override;
+
+ private:
+  // A tensor exposed to a reader, kept until the reader releases it, its step
+  // is cleaned up or it expires.
+  struct ExposedTensor {
+    Tensor tensor;
+    // Set if the buffer wasn't allocated in a registered region.
+    MemoryRegionPtr owned_mr;
+    int64 step_id;
+    uint64 expiration_micros;
+  };
+
+  // An outstanding RDMA read, passed as the work request id.
+  struct ReadRequest {
+    rdma_cm_id* id;
+    uint32 tensor_key;
+    MemoryRegionPtr owned_mr;
+    StatusCallback done;
+  };
+
+  void InsertMemoryRegion(void* addr, size_t length);
+  void EvictMemoryRegion(void* addr, size_t length);
+  // Returns the registered region containing [addr, addr + length), or
+  // nullptr.
+  ibv_mr* FindMemoryRegion(const void* addr, size_t length);
+  // Like FindMemoryRegion() but registers the buffer if it isn't in a
+  // registered region, in which case '*owned_mr' takes the registration.
+  Status GetMemoryRegion(void* addr, size_t length, ibv_mr** mr,
+                         MemoryRegionPtr* owned_mr);
+
+  void ExposeTensor(int64 step_id, const Tensor& tensor,
+                    ::google::protobuf::Any* mutable_transport_options,
+                    StatusCallback done);
+  void ReleaseTensor(uint32 tensor_key);
+  void ReleaseExpiredTensors();
+
+  Status CreateQueuePair(rdma_cm_id* id);
+  // Returns a connection to the manager listening on 'host':'port'.
+  Status GetEndpoint(const string& host, const string& port, rdma_cm_id** id);
+
+  void AcceptConnections();
+  void PollCompletions();
+  void HandleCompletion(const ibv_wc& wc);
+
+  const string host_;
+  const string port_;
+  const int64 exposed_tensor_timeout_micros_;
+  std::atomic<bool> stopped_{false};
+
+  EndpointPtr listening_;
+  ibv_pd* pd_ = nullptr;
+  ibv_comp_channel* channel_ = nullptr;
+  // Shared by the queue pairs of all the connections.
+  ibv_cq* cq_ = nullptr;
+
+  mutex mrs_mu_;
+  // Sorted by end address.
+  std::vector<MemoryRegionPtr> mrs_ TF_GUARDED_BY(mrs_mu_);
+
+  mutex endpoints_mu_;
+  std::map<std::pair<string, string>, EndpointPtr> endpoints_
+      TF_GUARDED_BY(endpoints_mu_);
+  std::vector<EndpointPtr> accepted_ TF_GUARDED_BY(endpoints_mu_);
+
+  mutex tensors_mu_;
+  uint32 next_tensor_key_ TF_GUARDED_BY(tensors_mu_) = 0;
+  std::map<uint32, ExposedTensor> exposed_tensors_ TF_GUARDED_BY(tensors_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaMemoryManager);
+};
+
+RdmaMemoryManager::~RdmaMemoryManager() {
+  // The queue pairs go before the completion queue they use, and the memory
+  // regions before their protection domain.
+  {
+    mutex_lock l(endpoints_mu_);
+    endpoints_.clear();
+    accepted_.clear();
+  }
+  if (cq_ != nullptr) ibv_destroy_cq(cq_);
+  if (channel_ != nullptr) ibv_destroy_comp_channel(channel_);
+  {
+    mutex_lock l(tensors_mu_);
+    exposed_tensors_.clear();
+  }
+  {
+    mutex_lock l(mrs_mu_);
+    mrs_.clear();
+  }
+  listening_.reset();
+  if (pd_ != nullptr) ibv_dealloc_pd(pd_);
+}
+
+Status RdmaMemoryManager::Init() {
+  rdma_addrinfo hints = {};
+  hints.ai_port_space = RDMA_PS_TCP;
+  hints.ai_flags = RAI_PASSIVE;
+  rdma_addrinfo* addrinfo;
+  if (rdma_getaddrinfo(const_cast<char*>(host_.c_str()),
+                       const_cast<char*>(port_.c_str()), &hints, &addrinfo)) {
+    return errors::Unavailable("Cannot resolve RDMA address ", host_, ":",
+                               port_, ": ", std::strerror(errno));
+  }
+  rdma_cm_id* id;
+  const int ret = rdma_create_ep(&id, addrinfo, nullptr, nullptr);
+  rdma_freeaddrinfo(addrinfo);
+  if (ret) {
+    return errors::Unavailable("Cannot bind to RDMA address ", host_, ":",
+                               port_, ": ", std::strerror(errno));
+  }
+  listening_.reset(id);
+  if (listening_->verbs == nullptr) {
+    return errors::Unavailable(host_, " is not the address of an RDMA device");
+  }
+  if (rdma_listen(listening_.get(), kListenBacklog)) {
+    return errors::Unavailable("Cannot listen on RDMA address ", host_, ":",
+                               port_, ": ", std::strerror(errno));
+  }
+  TF_RETURN_IF_ERROR(SetNonBlocking(listening_->channel->fd));
+
+  pd_ = ibv_alloc_pd(listening_->verbs);
+  if (pd_ == nullptr) {
+    return errors::Unavailable("Cannot allocate RDMA protection domain");
+  }
+  channel_ = ibv_create_comp_channel(listening_->verbs);
+  if (channel_ == nullptr) {
+    return errors::Unavailable("Cannot create RDMA completion channel");
+  }
+  TF_RETURN_IF_ERROR(SetNonBlocking(channel_->fd));
+  cq_ = ibv_create_cq(listening_->verbs, kCompletionQueueSize, nullptr,
+                      channel_, 0);
+  if (cq_ == nullptr || ibv_req_notify_cq(cq_, 0)) {
+    return errors::Unavailable("Cannot create RDMA completion queue");
+  }
+
+  // Registers the memory of the allocators used for tensors that cross
+  // workers, so that they are sent and received in place.
+  SubAllocator::Visitor alloc_visitor = [this](void* ptr, int index,
+                                               size_t num_bytes) {
+    InsertMemoryRegion(ptr, num_bytes);
+  };
+  SubAllocator::Visitor free_visitor = [this](void* ptr, int index,
+                                              size_t num_bytes) {
+    EvictMemoryRegion(ptr, num_bytes);
+  };
+  ProcessState::singleton()->AddCPUAllocVisitor(alloc_visitor);
+  ProcessState::singleton()->AddCPUFreeVisitor(free_visitor);
+#if GOOGLE_CUDA
+  for (int numa_node = 0; numa_node < port::NUMANumNodes(); ++numa_node) {
+    GPUProcessState::singleton()->AddGpuHostAllocVisitor(numa_node,
+                                                         alloc_visitor);
+    GPUProcessState::singleton()->AddGpuHostFreeVisitor(numa_node,
+                                                        free_visitor);
+    // Registering GPU memory only succeeds with GPUDirect RDMA; otherwise GPU
+    // tensors are staged through the registered GPU host memory.
+    GPUProcessState::singleton()->AddGPUAllocVisitor(numa_node, alloc_visitor);
+  }
+#endif  // GOOGLE_CUDA
+  LOG(INFO) << "RDMA transport listening on " << host_ << ":" << port_;
+  return Status::OK();
+}
+
+void RdmaMemoryManager::Run() {
+  pollfd fds[2];
+  fds[0].fd = listening_->channel->fd;
+  fds[0].events = POLLIN;
+  fds[1].fd = channel_->fd;
+  fds[1].events = POLLIN;
+  while (!stopped_) {
+    const int ret = poll(fds, 2, kPollTimeoutMs);
+    if (ret < 0 && errno != EINTR) {
+      LOG(ERROR) << "RDMA event loop failed: " << std::strerror(errno);
+      return;
+    }
+    if (ret > 0) {
+      if (fds[0].revents & POLLIN) AcceptConnections();
+      if (fds[1].revents & POLLIN) PollCompletions();
+    }
+    ReleaseExpiredTensors();
+  }
+}
+
+void RdmaMemoryManager::AcceptConnections() {
+  while (true) {
+    rdma_cm_id* id;
+    if (rdma_get_request(listening_.get(), &id)) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        LOG(ERROR) << "Failed to get RDMA connection request: "
+                   << std::strerror(errno);
+      }
+      return;
+    }
+    EndpointPtr endpoint(id);
+    Status s = CreateQueuePair(id);
+    for (int i = 0; s.ok() && i < kNumPostedRecvs; ++i) {
+      if (rdma_post_recvv(id, id, nullptr, 0)) {
+        s = errors::Unavailable("Cannot post RDMA receive: ",
+                                std::strerror(errno));
+      }
+    }
+    if (s.ok() && rdma_accept(id, nullptr)) {
+      s = errors::Unavailable("Cannot accept RDMA connection: ",
+                              std::strerror(errno));
+    }
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      continue;
+    }
+    VLOG(2) << "Accepted RDMA connection";
+    mutex_lock l(endpoints_mu_);
+    accepted_.push_back(std::move(endpoint));
+  }
+}
+
+void RdmaMemoryManager::PollCompletions() {
+  ibv_cq* cq;
+  void* context;
+  if (ibv_get_cq_event(channel_, &cq, &context)) return;
+  ibv_ack_cq_events(cq, 1);
+  if (ibv_req_notify_cq(cq, 0)) {
+    LOG(ERROR) << "Failed to request RDMA completion notifications";
+  }
+  ibv_wc wcs[32];
+  int n;
+  while ((n = ibv_poll_cq(cq, 32, wcs)) > 0) {
+    for (int i = 0; i < n; ++i) HandleCompletion(wcs[i]);
+  }
+}
+
+void RdmaMemoryManager::HandleCompletion(const ibv_wc& wc) {
+  switch (wc.opcode) {
+    case IBV_WC_RDMA_READ: {
+      std::unique_ptr<ReadRequest> request(
+          reinterpret_cast<ReadRequest*>(wc.wr_id));
+      if (wc.status != IBV_WC_SUCCESS) {
+        request->done(errors::Unavailable("RDMA read failed: ",
+                                          ibv_wc_status_str(wc.status)));
+        return;
+      }
+      // Tells the sender that its buffer can be released.
+      ibv_send_wr wr = {};
+      wr.opcode = IBV_WR_SEND_WITH_IMM;
+      wr.send_flags = IBV_SEND_SIGNALED;
+      wr.imm_data = htonl(request->tensor_key);
+      ibv_send_wr* bad_wr;
+      if (ibv_post_send(request->id->qp, &wr, &bad_wr)) {
+        LOG(WARNING) << "Failed to release remote tensor "
+                     << request->tensor_key << ": " << std::strerror(errno);
+      }
+      request->done(Status::OK());
+      return;
+    }
+    case IBV_WC_RECV: {
+      rdma_cm_id* id = reinterpret_cast<rdma_cm_id*>(wc.wr_id);
+      if (wc.status != IBV_WC_SUCCESS) {
+        // Receives are flushed when the connection goes away.
+        VLOG(2) << "RDMA receive failed: " << ibv_wc_status_str(wc.status);
+        return;
+      }
+      ReleaseTensor(ntohl(wc.imm_data));
+      if (rdma_post_recvv(id, id, nullptr, 0)) {
+        LOG(ERROR) << "Cannot post RDMA receive: " << std::strerror(errno);
+      }
+      return;
+    }
+    default:
+      if (wc.status != IBV_WC_SUCCESS) {
+        LOG(WARNING) << "RDMA work request failed: "
+                     << ibv_wc_status_str(wc.status);
+      }
+      return;
+  }
+}
+
+Status RdmaMemoryManager::CreateQueuePair(rdma_cm_id* id) {
+  ibv_qp_init_attr attr = {};
+  attr.qp_type = IBV_QPT_RC;
+  attr.send_cq = cq_;
+  attr.recv_cq = cq_;
+  attr.cap.max_send_wr = kMaxWorkRequests;
+  attr.cap.max_recv_wr = kMaxWorkRequests;
+  attr.cap.max_send_sge = 1;
+  attr.cap.max_recv_sge = 1;
+  attr.sq_sig_all = 1;
+  if (rdma_create_qp(id, pd_, &attr)) {
+    return errors::Unavailable("Cannot create RDMA queue pair: ",
+                               std::strerror(errno));
+  }
+  return Status::OK();
+}
+
+Status RdmaMemoryManager::GetEndpoint(const string& host, const string& port,
+                                      rdma_cm_id** id) {
+  mutex_lock l(endpoints_mu_);
+  auto it = endpoints_.find({host, port});
+  if (it != endpoints_.end()) {
+    *id = it->second.get();
+    return Status::OK();
+  }
+
+  rdma_addrinfo hints = {};
+  hints.ai_port_space = RDMA_PS_TCP;
+  rdma_addrinfo* addrinfo;
+  if (rdma_getaddrinfo(const_cast<char*>(host.c_str()),
+                       const_cast<char*>(port.c_str()), &hints, &addrinfo)) {
+    return errors::Unavailable("Cannot resolve RDMA address ", host, ":", port,
+                               ": ", std::strerror(errno));
+  }
+  rdma_cm_id* new_id;
+  const int ret = rdma_create_ep(&new_id, addrinfo, nullptr, nullptr);
+  rdma_freeaddrinfo(addrinfo);
+  if (ret) {
+    return errors::Unavailable("Cannot create RDMA endpoint to ", host, ":",
+                               port, ": ", std::strerror(errno));
+  }
+  EndpointPtr endpoint(new_id);
+  if (new_id->verbs != listening_->verbs) {
+    return errors::Unimplemented("RDMA route to ", host, ":", port,
+                                 " uses a different device than ", host_);
+  }
+  TF_RETURN_IF_ERROR(CreateQueuePair(new_id));
+  if (rdma_connect(new_id, nullptr)) {
+    return errors::Unavailable("Cannot connect to RDMA address ", host, ":",
+                               port, ": ", std::strerror(errno));
+  }
+  VLOG(2) << "Connected to RDMA address " << host << ":" << port;
+  *id = new_id;
+  endpoints_.emplace(std::make_pair(host, port), std::move(endpoint));
+  return Status::OK();
+}
+
+void RdmaMemoryManager::InsertMemoryRegion(void* addr, size_t length) {
+  if (length == 0) return;
+  ibv_mr* mr = ibv_reg_mr(pd_, addr, length, kAccessFlags);
+  if (mr == nullptr) {
+    // Expected for GPU memory without GPUDirect RDMA.
+    VLOG(1) << "Cannot register memory region at " << addr << " of " << length
+            << " bytes: " << std::strerror(errno);
+    return;
+  }
+  mutex_lock l(mrs_mu_);
+  auto it = std::upper_bound(mrs_.begin(), mrs_.end(), addr, &EndsBefore);
+  mrs_.insert(it, MemoryRegionPtr(mr));
+}
+
+void RdmaMemoryManager::EvictMemoryRegion(void* addr, size_t length) {
+  if (length == 0) return;
+  mutex_lock l(mrs_mu_);
+  auto it = std::upper_bound(mrs_.begin(), mrs_.end(), addr, &EndsBefore);
+  if (it != mrs_.end() && (*it)->addr == addr) {
+    mrs_.erase(it);
+  }
+}
+
+ibv_mr* RdmaMemoryManager::FindMemoryRegion(const void* addr, size_t length) {
+  mutex_lock l(mrs_mu_);
+  auto it = std::upper_bound(mrs_.begin(), mrs_.end(), addr, &EndsBefore);
+  if (it == mrs_.end() || addr < (*it)->addr ||
+      static_cast<const char*>(addr) + length >
+          static_cast<const char*>((*it)->addr) + (*it)->length) {
+    return nullptr;
+  }
+  return it->get();
+}
+
+Status RdmaMemoryManager::GetMemoryRegion(void* addr, size_t length,
+                                          ibv_mr** mr,
+                                          MemoryRegionPtr* owned_mr) {
+  *mr = FindMemoryRegion(addr, length);
+  if (*mr != nullptr) return Status::OK();
+  // The buffer was allocated before the allocator visitors were registered,
+  // or by an allocator without visitors.
+  VLOG(1) << "Registering a memory region of " << length
+          << " bytes for a single transfer";
+  *mr = ibv_reg_mr(pd_, addr, length, kAccessFlags);
+  if (*mr == nullptr) {
+    return errors::Unavailable("Cannot register memory region of ", length,
+                               " bytes: ", std::strerror(errno));
+  }
+  owned_mr->reset(*mr);
+  return Status::OK();
+}
+
+void RdmaMemoryManager::TransportOptionsFromTensor(
+    int64 step_id, ::google::protobuf::Any* mutable_transport_options,
+    const Tensor& tensor, Device* device, DeviceContext* device_context,
+    bool on_host, StatusCallback done) {
+  const bool in_registered_region =
+      FindMemoryRegion(DMAHelper::base(&tensor), tensor.TotalBytes()) !=
+      nullptr;
+  if (on_host || in_registered_region) {
+    ExposeTensor(step_id, tensor, mutable_transport_options, std::move(done));
+    return;
+  }
+
+  // Without GPUDirect RDMA, the tensor is copied to GPU host memory first.
+  AllocatorAttributes host_attrs;
+  host_attrs.set_gpu_compatible(true);
+  host_attrs.set_on_host(true);
+  Allocator* allocator = device->GetAllocator(host_attrs);
+  Tensor* host_copy = new Tensor(allocator, tensor.dtype(), tensor.shape());
+  device_context->CopyDeviceTensorToCPU(
+      &tensor, "", device, host_copy,
+      [this, step_id, mutable_transport_options, host_copy,
+       done = std::move(done)](const Status& s) {
+        if (s.ok()) {
+          ExposeTensor(step_id, *host_copy, mutable_transport_options,
+                       std::move(done));
+        } else {
+          done(s);
+        }
+        delete host_copy;
+      });
+}
+
+void RdmaMemoryManager::ExposeTensor(
+    int64 step_id, const Tensor& tensor,
+    ::google::protobuf::Any* mutable_transport_options, StatusCallback done) {
+  void* addr = DMAHelper::base(&tensor);
+  const size_t length = tensor.TotalBytes();
+  ibv_mr* mr;
+  MemoryRegionPtr owned_mr;
+  Status s = GetMemoryRegion(addr, length, &mr, &owned_mr);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  RemoteMemoryRegion region;
+  region.set_host(host_);
+  region.set_port(port_);
+  region.set_addr(reinterpret_cast<uint64>(addr));
+  region.set_length(length);
+  region.set_rkey(mr->rkey);
+  region.set_dtype(tensor.dtype());
+  tensor.shape().AsProto(region.mutable_shape());
+  {
+    mutex_lock l(tensors_mu_);
+    const uint32 tensor_key = next_tensor_key_++;
+    region.set_tensor_key(tensor_key);
+    exposed_tensors_.emplace(
+        tensor_key,
+        ExposedTensor{tensor, std::move(owned_mr), step_id,
+                      Env::Default()->NowMicros() +
+                          exposed_tensor_timeout_micros_});
+  }
+  mutable_transport_options->PackFrom(region);
+  done(Status::OK());
+}
+
+void RdmaMemoryManager::ReleaseTensor(uint32 tensor_key) {
+  mutex_lock l(tensors_mu_);
+  if (exposed_tensors_.erase(tensor_key) == 0) {
+    // Already released by CleanupStep() or ReleaseExpiredTensors().
+    VLOG(1) << "Release of unknown tensor " << tensor_key;
+  }
+}
+
+void RdmaMemoryManager::CleanupStep(int64 step_id) {
+  mutex_lock l(tensors_mu_);
+  for (auto it = exposed_tensors_.begin(); it != exposed_tensors_.end();) {
+    if (it->second.step_id == step_id) {
+      VLOG(1) << "Releasing tensor " << it->first << " of step " << step_id
+              << ", which was never read";
+      it = exposed_tensors_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void RdmaMemoryManager::ReleaseExpiredTensors() {
+  const uint64 now_micros = Env::Default()->NowMicros();
+  mutex_lock l(tensors_mu_);
+  for (auto it = exposed_tensors_.begin(); it != exposed_tensors_.end();) {
+    if (it->second.expiration_micros <= now_micros) {
+      LOG(WARNING) << "Releasing tensor " << it->first << " of step "
+                   << it->second.step_id << ", which was not read in "
+                   << exposed_tensor_timeout_micros_ << " us";
+      it = exposed_tensors_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void RdmaMemoryManager::TensorFromTransportOptions(
+    Tensor* tensor, const ::google::protobuf::Any& transport_options,
+    Device* device, DeviceContext* device_context,
+    const AllocatorAttributes& alloc_attrs, StatusCallback done) {
+  RemoteMemoryRegion region;
+  if (!transport_options.UnpackTo(&region)) {
+    done(errors::InvalidArgument("No RDMA transport options found"));
+    return;
+  }
+  rdma_cm_id* id;
+  Status s = GetEndpoint(region.host(), region.port(), &id);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  *tensor = Tensor(device->GetAllocator(alloc_attrs), region.dtype(),
+                   TensorShape(region.shape()));
+  if (tensor->TotalBytes() != region.length()) {
+    done(errors::Internal("Remote tensor of ", region.length(),
+                          " bytes received as ", tensor->DebugString()));
+    return;
+  }
+  const bool on_host =
+      device->tensorflow_gpu_device_info() == nullptr || alloc_attrs.on_host();
+  Tensor* target = tensor;
+  Tensor* staging = nullptr;
+  if (!on_host &&
+      FindMemoryRegion(DMAHelper::base(tensor), tensor->TotalBytes()) ==
+          nullptr) {
+    // Without GPUDirect RDMA, the tensor is read to GPU host memory first.
+    AllocatorAttributes host_attrs;
+    host_attrs.set_gpu_compatible(true);
+    host_attrs.set_on_host(true);
+    staging = new Tensor(device->GetAllocator(host_attrs), tensor->dtype(),
+                         tensor->shape());
+    target = staging;
+  }
+
+  void* addr = DMAHelper::base(target);
+  ibv_mr* mr;
+  MemoryRegionPtr owned_mr;
+  s = GetMemoryRegion(addr, region.length(), &mr, &owned_mr);
+  if (!s.ok()) {
+    delete staging;
+    done(s);
+    return;
+  }
+
+  StatusCallback read_done = std::move(done);
+  if (staging != nullptr) {
+    read_done = [tensor, staging, device, device_context,
+                 done = std::move(read_done)](const Status& s) {
+      if (!s.ok()) {
+        delete staging;
+        done(s);
+        return;
+      }
+      device_context->CopyCPUTensorToDevice(
+          staging, device, tensor, [staging, done](const Status& s) {
+            delete staging;
+            done(s);
+          });
+    };
+  }
+  auto* request = new ReadRequest{id, region.tensor_key(), std::move(owned_mr),
+                                  std::move(read_done)};
+  if (rdma_post_read(id, request, addr, region.length(), mr, IBV_SEND_SIGNALED,
+                     region.addr(), region.rkey())) {
+    s = errors::Unavailable("Cannot post RDMA read: ", std::strerror(errno));
+    StatusCallback failed = std::move(request->done);
+    delete request;
+    failed(s);
+  }
+}
+
+}  // namespace
+
+RemoteMemoryManager* CreateRemoteMemoryManager(
+    const string& host, const string& port,
+    int64 exposed_tensor_timeout_micros) {
+  return new RdmaMemoryManager(host, port, exposed_tensor_timeout_micros);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,78 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_MEMORY_MANAGER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_MEMORY_MANAGER_H_
+
+#include "google/protobuf/any.pb.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Moves tensor contents between workers with one-sided RDMA, while the
+// RecvTensor RPC only carries the description of the remote buffer.
+//
+// The memory of the CPU allocator, of the GPU host allocators and, when
+// GPUDirect RDMA is available, of the GPU allocators is registered with the
+// RDMA device as it is allocated, so that tensors are read from and written
+// to their own buffers without any copy.
+class RemoteMemoryManager {
+ public:
+  virtual ~RemoteMemoryManager() {}
+
+  // Starts listening for RDMA connections and registers the allocator
+  // visitors. Must be called before the devices and their allocators are
+  // created; memory allocated earlier is registered on demand instead.
+  virtual Status Init() = 0;
+
+  // Runs the event loops. Blocks until Stop() is called.
+  virtual void Run() = 0;
+  virtual void Stop() = 0;
+
+  // Called on the sender side. Exposes 'tensor' for RDMA and describes it in
+  // 'mutable_transport_options'. The tensor is kept alive until the receiver
+  // has read it, until step 'step_id' is cleaned up or until it expires,
+  // whichever comes first. 'on_host' tells whether a tensor of 'device' is in
+  // host memory.
+  virtual void TransportOptionsFromTensor(
+      int64 step_id, ::google::protobuf::Any* mutable_transport_options,
+      const Tensor& tensor, Device* device, DeviceContext* device_context,
+      bool on_host, StatusCallback done) = 0;
+
+  // Releases the tensors exposed for step 'step_id' that haven't been read,
+  // e.g. because the RecvTensor call was cancelled or the step aborted.
+  virtual void CleanupStep(int64 step_id) = 0;
+
+  // Called on the receiver side. Allocates 'tensor' on 'device' with
+  // 'alloc_attrs' and reads the remote tensor described by 'transport_options'
+  // into it.
+  virtual void TensorFromTransportOptions(
+      Tensor* tensor, const ::google::protobuf::Any& transport_options,
+      Device* device, DeviceContext* device_context,
+      const AllocatorAttributes& alloc_attrs, StatusCallback done) = 0;
+};
+
+// Creates a manager listening on 'host':'port'. Exposed tensors that are
+// neither read nor cleaned up, e.g. because the reader died, are released
+// after 'exposed_tensor_timeout_micros'.
+RemoteMemoryManager* CreateRemoteMemoryManager(
+    const string& host, const string& port,
+    int64 exposed_tensor_timeout_micros = 10 * 60 * 1000 * 1000LL);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_MEMORY_MANAGER_H_
@@ -0,0 +1,148 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+
+#include <cstdlib>
+#include <memory>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// Waits for up to 10 seconds for the last reference to 'tensor' other than
+// its own to be dropped.
+bool WaitForRefCountIsOne(const Tensor& tensor) {
+  for (int i = 0; i < 1000; ++i) {
+    if (tensor.RefCountIsOne()) return true;
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+  }
+  return false;
+}
+
+class RdmaMemoryManagerTest : public ::testing::Test {
+ protected:
+  // Starts a manager on the RDMA device of TF_RDMA_TEST_HOST, which reads
+  // from itself over a loopback connection. Returns false if there is no
+  // such device.
+  bool StartManager(int64 exposed_tensor_timeout_micros) {
+    const char* host = std::getenv("TF_RDMA_TEST_HOST");
+    manager_.reset(CreateRemoteMemoryManager(
+        host != nullptr ? host : "127.0.0.1",
+        strings::StrCat(testing::PickUnusedPortOrDie()),
+        exposed_tensor_timeout_micros));
+    Status s = manager_->Init();
+    if (!s.ok()) {
+      LOG(WARNING) << "No RDMA device: " << s;
+      return false;
+    }
+    device_ = DeviceFactory::NewDevice("CPU", SessionOptions(),
+                                       "/job:localhost/replica:0/task:0");
+    thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "rdma_memory_manager", [this]() { manager_->Run(); }));
+    return true;
+  }
+
+  ~RdmaMemoryManagerTest() override {
+    if (thread_ != nullptr) {
+      manager_->Stop();
+      thread_.reset();
+    }
+  }
+
+  Status Expose(int64 step_id, const Tensor& tensor,
+                ::google::protobuf::Any* transport_options) {
+    Notification n;
+    Status status;
+    manager_->TransportOptionsFromTensor(
+        step_id, transport_options, tensor, device_.get(),
+        /*device_context=*/nullptr, /*on_host=*/true,
+        [&n, &status](const Status& s) {
+          status = s;
+          n.Notify();
+        });
+    n.WaitForNotification();
+    return status;
+  }
+
+  std::unique_ptr<RemoteMemoryManager> manager_;
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<Thread> thread_;
+};
+
+TEST_F(RdmaMemoryManagerTest, ReadAndRelease) {
+  if (!StartManager(/*exposed_tensor_timeout_micros=*/60 * 1000 * 1000)) {
+    GTEST_SKIP() << "No RDMA device";
+  }
+  Tensor sent = test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3});
+  ::google::protobuf::Any transport_options;
+  TF_ASSERT_OK(Expose(/*step_id=*/1, sent, &transport_options));
+  EXPECT_FALSE(sent.RefCountIsOne());
+
+  Tensor received;
+  Notification n;
+  Status status;
+  manager_->TensorFromTransportOptions(
+      &received, transport_options, device_.get(),
+      /*device_context=*/nullptr, AllocatorAttributes(),
+      [&n, &status](const Status& s) {
+        status = s;
+        n.Notify();
+      });
+  n.WaitForNotification();
+  TF_ASSERT_OK(status);
+  test::ExpectTensorEqual<float>(sent, received);
+  // The reader releases the tensor after reading it.
+  EXPECT_TRUE(WaitForRefCountIsOne(sent));
+}
+
+TEST_F(RdmaMemoryManagerTest, CleanupStepReleasesUnreadTensors) {
+  if (!StartManager(/*exposed_tensor_timeout_micros=*/60 * 1000 * 1000)) {
+    GTEST_SKIP() << "No RDMA device";
+  }
+  Tensor step_1 = test::AsTensor<float>({1, 2, 3});
+  Tensor step_2 = test::AsTensor<float>({4, 5, 6});
+  ::google::protobuf::Any transport_options_1;
+  ::google::protobuf::Any transport_options_2;
+  TF_ASSERT_OK(Expose(/*step_id=*/1, step_1, &transport_options_1));
+  TF_ASSERT_OK(Expose(/*step_id=*/2, step_2, &transport_options_2));
+
+  manager_->CleanupStep(1);
+  EXPECT_TRUE(step_1.RefCountIsOne());
+  EXPECT_FALSE(step_2.RefCountIsOne());
+  manager_->CleanupStep(2);
+  EXPECT_TRUE(step_2.RefCountIsOne());
+}
+
+TEST_F(RdmaMemoryManagerTest, UnreadTensorsExpire) {
+  if (!StartManager(/*exposed_tensor_timeout_micros=*/1000)) {
+    GTEST_SKIP() << "No RDMA device";
+  }
+  Tensor sent = test::AsTensor<float>({1, 2, 3});
+  ::google::protobuf::Any transport_options;
+  TF_ASSERT_OK(Expose(/*step_id=*/1, sent, &transport_options));
+  EXPECT_TRUE(WaitForRefCountIsOne(sent));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,249 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_rendezvous_mgr.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/request_id.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/notification.h"
+
+namespace tensorflow {
+
+namespace {
+
+class RdmaRemoteRendezvous : public BaseRemoteRendezvous {
+ public:
+  RdmaRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                       RemoteMemoryManager* remote_memory_manager)
+      : BaseRemoteRendezvous(env, step_id),
+        remote_memory_manager_(remote_memory_manager) {}
+
+ protected:
+  void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                           const Rendezvous::Args& args,
+                           DoneCallback done) override;
+
+ private:
+  ~RdmaRemoteRendezvous() override {}
+
+  RemoteMemoryManager* const remote_memory_manager_;  // Not owned.
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaRemoteRendezvous);
+};
+
+// Used only to retrieve tensors from remote processes. The RecvTensor RPC
+// returns either the tensor content, or its location for an RDMA read.
+class RdmaRecvTensorCall : public BaseRecvTensorCall {
+ public:
+  RdmaRecvTensorCall(WorkerInterface* wi, int64 step_id, StringPiece key,
+                     const string& src_worker, Device* dst_device,
+                     const Rendezvous::Args& recv_args,
+                     RemoteMemoryManager* remote_memory_manager)
+      : wi_(wi),
+        src_worker_(src_worker),
+        dst_device_(dst_device),
+        recv_args_(recv_args),
+        remote_memory_manager_(remote_memory_manager) {
+    req_.set_step_id(step_id);
+    req_.set_rendezvous_key(key.data(), key.size());
+    req_.set_request_id(GetUniqueRequestId());
+    req_.set_dma_ok(true);
+  }
+
+  ~RdmaRecvTensorCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in RdmaRecvTensorCall destructor.";
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    // The metadata and any inline content are parsed into host memory; the
+    // content read with RDMA lands in the memory of the destination device.
+    AllocatorAttributes host_attrs;
+    host_attrs.set_on_host(true);
+    resp_.InitAlloc(dst_device_, host_attrs);
+    auto abort_checked = std::make_shared<Notification>();
+    auto cb = [this, abort_checked,
+               recv_done = std::move(recv_done)](const Status& s) {
+      abort_checked->WaitForNotification();
+      if (!s.ok()) {
+        SetStatus(s);
+        recv_done();
+        return;
+      }
+      ReceiveTensor([this, recv_done](const Status& s) {
+        SetStatus(s);
+        recv_done();
+      });
+    };
+    wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
+
+    // Like RpcRecvTensorCall, checks for an abort after sending the RPC, which
+    // may have missed the cancellation.
+    if (!status().ok()) {
+      opts_.StartCancel();
+    }
+    abort_checked->Notify();
+  }
+
+  void StartAbort(const Status& s) override {
+    SetStatus(s);
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  void ReleaseWorker(WorkerCacheInterface* worker_cache) {
+    DCHECK_NE(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "RdmaRecvTensorCall::ReleaseWorker() called twice.";
+    worker_cache->ReleaseWorker(src_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+  const Tensor& tensor() const { return tensor_; }
+  bool is_dead() const { return resp_.metadata().is_dead(); }
+  const Rendezvous::Args& recv_args() const { return recv_args_; }
+
+ private:
+  void SetStatus(const Status& s) {
+    mutex_lock l(mu_);
+    status_.Update(s);
+  }
+
+  // Sets 'tensor_' from the response.
+  void ReceiveTensor(StatusCallback done) {
+    if (resp_.metadata().has_transport_options()) {
+      remote_memory_manager_->TensorFromTransportOptions(
+          &tensor_, resp_.metadata().transport_options(), dst_device_,
+          recv_args_.device_context, recv_args_.alloc_attrs, std::move(done));
+      return;
+    }
+    // The sender sent the content inline, e.g. because it isn't memcpy-able.
+    const Tensor& received = resp_.tensor();
+    const bool on_host = dst_device_->tensorflow_gpu_device_info() == nullptr ||
+                         recv_args_.alloc_attrs.on_host();
+    if (on_host || received.TotalBytes() == 0 ||
+        !DataTypeCanUseMemcpy(received.dtype())) {
+      tensor_ = received;
+      done(Status::OK());
+      return;
+    }
+    tensor_ = Tensor(dst_device_->GetAllocator(recv_args_.alloc_attrs),
+                     received.dtype(), received.shape());
+    recv_args_.device_context->CopyCPUTensorToDevice(&received, dst_device_,
+                                                     &tensor_, std::move(done));
+  }
+
+  WorkerInterface* wi_;  // Not owned.
+  const string src_worker_;
+  Device* const dst_device_;
+  const Rendezvous::Args recv_args_;
+  RemoteMemoryManager* const remote_memory_manager_;  // Not owned.
+  CallOptions opts_;
+  RecvTensorRequest req_;
+  TensorResponse resp_;
+  Tensor tensor_;
+
+  mutable mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaRecvTensorCall);
+};
+
+void RdmaRemoteRendezvous::RecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
+  CHECK(is_initialized());
+
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    done(errors::Internal(parsed.src_device,
+                          " is invalid remote source device."),
+         Args(), recv_args, Tensor{}, false);
+    return;
+  }
+  WorkerSession* sess = session();
+  std::shared_ptr<WorkerCacheInterface> worker_cache =
+      sess->GetSharedWorkerCache();
+  WorkerInterface* rwi = worker_cache->GetOrCreateWorker(src_worker);
+  if (rwi == nullptr) {
+    done(errors::Internal("No worker known as ", src_worker), Args(),
+         recv_args, Tensor{}, false);
+    return;
+  }
+  Device* dst_device;
+  Status s = sess->device_mgr()->LookupDevice(parsed.dst_device, &dst_device);
+  if (!s.ok()) {
+    worker_cache->ReleaseWorker(src_worker, rwi);
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+
+  auto* call =
+      new RdmaRecvTensorCall(rwi, step_id_, parsed.FullKey(), src_worker,
+                             dst_device, recv_args, remote_memory_manager_);
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call, recv_args);
+  if (!call->status().ok()) {
+    DeregisterCall(call);
+    call->ReleaseWorker(worker_cache.get());
+    done(call->status(), Args(), Args(), Tensor(), false);
+    delete call;
+    return;
+  }
+
+  Ref();
+  call->Start([this, call, worker_cache, done = std::move(done)]() {
+    // Removes "call" from active_. Prevent StartAbort().
+    DeregisterCall(call);
+    Status s = call->status();
+    call->ReleaseWorker(worker_cache.get());
+    done(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+    delete call;
+    Unref();
+  });
+}
+
+}  // namespace
+
+RdmaRendezvousMgr::RdmaRendezvousMgr(const WorkerEnv* env,
+                                     RemoteMemoryManager* remote_memory_manager)
+    : BaseRendezvousMgr(env), remote_memory_manager_(remote_memory_manager) {}
+
+void RdmaRendezvousMgr::Cleanup(int64 step_id) {
+  BaseRendezvousMgr::Cleanup(step_id);
+  remote_memory_manager_->CleanupStep(step_id);
+}
+
+BaseRemoteRendezvous* RdmaRendezvousMgr::Create(int64 step_id,
+                                                const WorkerEnv* worker_env) {
+  return new RdmaRemoteRendezvous(worker_env, step_id, remote_memory_manager_);
+}
+
+}  // namespace tensorflow
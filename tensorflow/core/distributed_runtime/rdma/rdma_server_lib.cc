@@ -0,0 +1,148 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_server_lib.h"
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/rdma/rdma_worker.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns the host and port of this task in the cluster. The RDMA transport
+// listens on the same port number as gRPC, in the RDMA port space.
+Status GetTaskAddress(const ServerDef& server_def, string* host,
+                      string* port) {
+  for (const auto& job : server_def.cluster().job()) {
+    if (job.name() != server_def.job_name()) continue;
+    auto iter = job.tasks().find(server_def.task_index());
+    if (iter == job.tasks().end()) break;
+    const string& address = iter->second;
+    const size_t colon_index = address.find_last_of(':');
+    if (colon_index == string::npos || colon_index == 0) {
+      return errors::InvalidArgument("Could not parse host and port from \"",
+                                     address, "\".");
+    }
+    *host = address.substr(0, colon_index);
+    *port = server_def.port() != 0 ? std::to_string(server_def.port())
+                                   : address.substr(colon_index + 1);
+    return Status::OK();
+  }
+  return errors::InvalidArgument("Task ", server_def.task_index(),
+                                 " was not defined in job \"",
+                                 server_def.job_name(), "\"");
+}
+
+}  // namespace
+
+RdmaServer::RdmaServer(const ServerDef& server_def, Env* env)
+    : GrpcServer(server_def, env) {}
+
+RdmaServer::~RdmaServer() {
+  if (remote_memory_manager_ != nullptr) remote_memory_manager_->Stop();
+  mutex_lock l(mu_);
+  remote_memory_manager_thread_.reset();
+}
+
+Status RdmaServer::Init() {
+  string host;
+  string port;
+  TF_RETURN_IF_ERROR(GetTaskAddress(server_def(), &host, &port));
+  remote_memory_manager_ = CreateRemoteMemoryManager(host, port);
+  // Registers the allocator visitors before GrpcServer::Init() creates the
+  // devices.
+  TF_RETURN_IF_ERROR(remote_memory_manager_->Init());
+
+  RemoteMemoryManager* remote_memory_manager = remote_memory_manager_;
+  GrpcServerOptions opts;
+  opts.rendezvous_mgr_func = [remote_memory_manager](const WorkerEnv* env) {
+    return new RdmaRendezvousMgr(env, remote_memory_manager);
+  };
+  opts.worker_func = [remote_memory_manager](WorkerEnv* env,
+                                             const ConfigProto& config) {
+    return std::unique_ptr<GrpcWorker>(
+        new RdmaWorker(env, config, remote_memory_manager));
+  };
+  return GrpcServer::Init(opts);
+}
+
+Status RdmaServer::Start() {
+  {
+    mutex_lock l(mu_);
+    if (remote_memory_manager_thread_ == nullptr) {
+      remote_memory_manager_thread_.reset(Env::Default()->StartThread(
+          ThreadOptions(), "TF_rdma_transport",
+          [this] { remote_memory_manager_->Run(); }));
+    }
+  }
+  return GrpcServer::Start();
+}
+
+Status RdmaServer::Stop() {
+  TF_RETURN_IF_ERROR(GrpcServer::Stop());
+  remote_memory_manager_->Stop();
+  return Status::OK();
+}
+
+Status RdmaServer::Join() {
+  {
+    mutex_lock l(mu_);
+    remote_memory_manager_thread_.reset();
+  }
+  return GrpcServer::Join();
+}
+
+/* static */
+Status RdmaServer::Create(const ServerDef& server_def, Env* env,
+                          std::unique_ptr<ServerInterface>* out_server) {
+  std::unique_ptr<RdmaServer> ret(
+      new RdmaServer(server_def, env == nullptr ? Env::Default() : env));
+  Status s = ret->Init();
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return s;
+  }
+  *out_server = std::move(ret);
+  return Status::OK();
+}
+
+namespace {
+
+class RdmaServerFactory : public ServerFactory {
+ public:
+  bool AcceptsOptions(const ServerDef& server_def) override {
+    return server_def.protocol() == "grpc+rdma";
+  }
+
+  Status NewServer(const ServerDef& server_def, const Options& options,
+                   std::unique_ptr<ServerInterface>* out_server) override {
+    return RdmaServer::Create(server_def, Env::Default(), out_server);
+  }
+};
+
+// Registers a `ServerFactory` for `RdmaServer` instances.
+class RdmaServerRegistrar {
+ public:
+  RdmaServerRegistrar() {
+    ServerFactory::Register("RDMA_SERVER", new RdmaServerFactory());
+  }
+};
+static RdmaServerRegistrar registrar;
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,56 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_SERVER_LIB_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_SERVER_LIB_H_
+
+#include <memory>
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_server_lib.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+// A GrpcServer whose workers exchange tensors with RDMA (protocol
+// "grpc+rdma"). gRPC is only used for the control messages.
+class RdmaServer : public GrpcServer {
+ protected:
+  RdmaServer(const ServerDef& server_def, Env* env);
+
+ public:
+  static Status Create(const ServerDef& server_def, Env* env,
+                       std::unique_ptr<ServerInterface>* out_server);
+
+  ~RdmaServer() override;
+
+  Status Start() override;
+  Status Stop() override;
+  Status Join() override;
+
+ protected:
+  Status Init();
+
+ private:
+  // Never deleted, as the allocator visitors it registers can't be removed.
+  RemoteMemoryManager* remote_memory_manager_ = nullptr;
+
+  mutex mu_;
+  std::unique_ptr<Thread> remote_memory_manager_thread_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_SERVER_LIB_H_
@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_worker.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+RdmaWorker::RdmaWorker(WorkerEnv* env, const ConfigProto& config,
+                       RemoteMemoryManager* remote_memory_manager)
+    : GrpcWorker(env, config), remote_memory_manager_(remote_memory_manager) {}
+
+void RdmaWorker::GrpcRecvTensorAsync(CallOptions* opts,
+                                     const RecvTensorRequest* request,
+                                     ::grpc::ByteBuffer* response,
+                                     StatusCallback done) {
+  if (!request->dma_ok()) {
+    GrpcWorker::GrpcRecvTensorAsync(opts, request, response, std::move(done));
+    return;
+  }
+
+  const int64 step_id = request->step_id();
+  Status s = recent_request_ids_.TrackUnique(
+      request->request_id(), "RecvTensor (RdmaWorker)", *request);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  const string& key = request->rendezvous_key();
+  TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
+  Rendezvous::ParsedKey parsed;
+  s = Rendezvous::ParseKey(key, &parsed);
+  Device* src_dev = nullptr;
+  if (s.ok()) {
+    s = PrepareRecvTensor(parsed, &src_dev);
+  }
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  opts->SetCancelCallback(
+      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
+  env_->rendezvous_mgr->RecvLocalAsync(
+      step_id, parsed,
+      [this, step_id, opts, response, done, src_dev](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
+        opts->ClearCancelCallback();
+        if (!status.ok()) {
+          done(status);
+          return;
+        }
+        // Dead and empty tensors have no content to read, and the content
+        // of the others can't be copied as raw bytes.
+        if (is_dead || val.TotalBytes() == 0 ||
+            !DataTypeCanUseMemcpy(val.dtype())) {
+          grpc::EncodeTensorToByteBuffer(is_dead, val, /*require_ack=*/false,
+                                         response);
+          done(Status::OK());
+          return;
+        }
+        const bool on_host = src_dev->tensorflow_gpu_device_info() == nullptr ||
+                             send_args.alloc_attrs.on_host();
+        auto* proto = new RecvTensorResponse;
+        proto->set_send_start_micros(env_->env->NowMicros());
+        remote_memory_manager_->TransportOptionsFromTensor(
+            step_id, proto->mutable_transport_options(), val, src_dev,
+            send_args.device_context, on_host,
+            [proto, response, done](const Status& s) {
+              if (s.ok()) {
+                grpc::EncodeRecvTensorResponseToByteBuffer(*proto, response);
+              }
+              delete proto;
+              done(s);
+            });
+      });
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,41 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_WORKER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_WORKER_H_
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+namespace tensorflow {
+
+// A GrpcWorker that answers RecvTensor requests allowing DMA with the
+// location of the tensor for an RDMA read, instead of the tensor content.
+class RdmaWorker : public GrpcWorker {
+ public:
+  RdmaWorker(WorkerEnv* env, const ConfigProto& config,
+             RemoteMemoryManager* remote_memory_manager);
+
+  void GrpcRecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                           ::grpc::ByteBuffer* response,
+                           StatusCallback done) override;
+
+ private:
+  RemoteMemoryManager* const remote_memory_manager_;  // Not owned.
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_WORKER_H_
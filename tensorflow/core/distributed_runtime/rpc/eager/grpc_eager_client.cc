@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
+#include <deque>
+#include <memory>
+#include <vector>
+
 #include "grpcpp/generic/generic_stub.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
@@ -63,6 +67,158 @@ bool EnableStreaming() {
   return result;
 }
 
+// Setting "TF_EAGER_CLIENT_STREAMING_ENQUEUE_WINDOW" to a positive value N
+// bounds the number of enqueue requests in flight on the stream of a context
+// to N.  The requests issued meanwhile are coalesced into one request, which
+// is sent as soon as an earlier one completes, so that consecutive remote ops
+// share a message and its per-RPC overhead.  An error in a coalesced request
+// is reported to all the requests it was made of.  Defaults to 0, which sends
+// every request as soon as it is issued.
+int64 StreamingEnqueueWindow() {
+  int64 result;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_CLIENT_STREAMING_ENQUEUE_WINDOW",
+                                  0, &result));
+  return result;
+}
+
+// Upper bound on the number of queue items in a coalesced enqueue request.
+constexpr int kMaxCoalescedQueueItems = 256;
+
+// The enqueue request stream of one remote context.
+class EnqueueStream {
+ public:
+  EnqueueStream(::grpc::GenericStub* stub, ::grpc::CompletionQueue* cq,
+                int64 window)
+      : dispatcher_(stub, cq,
+                    "/tensorflow.eager.EagerService/StreamingEnqueue"),
+        window_(window) {}
+
+  // Sends `request`, or queues it to be coalesced with the following ones if
+  // the window is full.
+  static void Send(std::shared_ptr<EnqueueStream> stream,
+                   const EnqueueRequest& request, EnqueueResponse* response,
+                   StatusCallback done) {
+    if (stream->window_ <= 0) {
+      stream->dispatcher_.SendNextRequest(request, response, std::move(done));
+      return;
+    }
+    {
+      mutex_lock l(stream->mu_);
+      stream->pending_.push_back({request, response, std::move(done)});
+      if (stream->draining_) return;
+      stream->draining_ = true;
+    }
+    Drain(std::move(stream));
+  }
+
+  void CancelCall() { dispatcher_.CancelCall(); }
+
+ private:
+  struct PendingRequest {
+    EnqueueRequest request;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+
+  // Sends the pending requests while the window allows, coalescing them if
+  // there is more than one.  Only one thread drains at a time, which keeps
+  // the requests in order.
+  static void Drain(std::shared_ptr<EnqueueStream> stream) {
+    mutex_lock l(stream->mu_);
+    while (!stream->pending_.empty() &&
+           stream->num_in_flight_ < stream->window_) {
+      std::vector<PendingRequest> batch;
+      int num_items = 0;
+      while (!stream->pending_.empty() &&
+             (batch.empty() ||
+              num_items + stream->pending_.front().request.queue_size() <=
+                  kMaxCoalescedQueueItems)) {
+        num_items += stream->pending_.front().request.queue_size();
+        batch.push_back(std::move(stream->pending_.front()));
+        stream->pending_.pop_front();
+      }
+      ++stream->num_in_flight_;
+      // `done` may run before SendNextRequest returns, so mu_ is released.
+      stream->mu_.unlock();
+      SendBatch(stream, std::move(batch));
+      stream->mu_.lock();
+    }
+    stream->draining_ = false;
+  }
+
+  static void SendBatch(std::shared_ptr<EnqueueStream> stream,
+                        std::vector<PendingRequest> batch) {
+    auto on_done = [stream]() {
+      bool drain = false;
+      {
+        mutex_lock l(stream->mu_);
+        --stream->num_in_flight_;
+        if (!stream->draining_ && !stream->pending_.empty()) {
+          stream->draining_ = true;
+          drain = true;
+        }
+      }
+      if (drain) Drain(stream);
+    };
+    if (batch.size() == 1) {
+      PendingRequest* single = new PendingRequest(std::move(batch[0]));
+      stream->dispatcher_.SendNextRequest(
+          single->request, single->response,
+          [single, on_done](const Status& s) {
+            single->done(s);
+            delete single;
+            on_done();
+          });
+      return;
+    }
+    VLOG(3) << "Coalescing " << batch.size() << " enqueue requests";
+    EnqueueRequest request;
+    request.set_context_id(batch[0].request.context_id());
+    std::vector<int> num_items;
+    for (PendingRequest& p : batch) {
+      num_items.push_back(p.request.queue_size());
+      for (QueueItem& item : *p.request.mutable_queue()) {
+        request.add_queue()->Swap(&item);
+      }
+    }
+    auto response = std::make_shared<EnqueueResponse>();
+    auto shared_batch =
+        std::make_shared<std::vector<PendingRequest>>(std::move(batch));
+    stream->dispatcher_.SendNextRequest(
+        request, response.get(),
+        [shared_batch, num_items, response, on_done](const Status& s) {
+          // Hand every request the responses for its queue items.
+          int next = 0;
+          for (size_t j = 0; j < shared_batch->size(); ++j) {
+            PendingRequest& p = (*shared_batch)[j];
+            Status status = s;
+            if (status.ok() &&
+                next + num_items[j] > response->queue_response_size()) {
+              status = errors::Internal(
+                  "Missing queue responses in coalesced enqueue response");
+            }
+            if (status.ok()) {
+              for (int i = 0; i < num_items[j]; ++i) {
+                p.response->add_queue_response()->Swap(
+                    response->mutable_queue_response(next + i));
+              }
+            }
+            next += num_items[j];
+            p.done(status);
+          }
+          on_done();
+        });
+  }
+
+  StreamingRPCDispatcher<EnqueueResponse> dispatcher_;
+  const int64 window_;
+
+  mutex mu_;
+  std::deque<PendingRequest> pending_ TF_GUARDED_BY(mu_);
+  int64 num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  bool draining_ TF_GUARDED_BY(mu_) = false;
+};
+
 // Ref-counted thread to handle callbacks for completed requests a GRPC
 // completion queue. The thread might be shared by multiple eager clients, and
 // each one of them should hold a reference count to ensure that the thread
@@ -169,10 +325,10 @@ class GrpcEagerClient : public EagerClient {
             << request->DebugString();
 
     mutex_lock l(mu_);
-    const auto& it = enqueue_dispatchers_.find(request->context_id());
-    if (it != enqueue_dispatchers_.end()) {
-      it->second.CancelCall();
-      enqueue_dispatchers_.erase(it);
+    const auto& it = enqueue_streams_.find(request->context_id());
+    if (it != enqueue_streams_.end()) {
+      it->second->CancelCall();
+      enqueue_streams_.erase(it);
     } else if (EnableStreaming()) {
       LOG(ERROR) << "Remote EagerContext with id " << request->context_id()
                  << " does not seem to exist.";
@@ -185,19 +341,20 @@ class GrpcEagerClient : public EagerClient {
                              StatusCallback done) override {
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
     if (EnableStreaming()) {
-      mutex_lock l(mu_);
-      auto it = enqueue_dispatchers_.find(request->context_id());
-      if (it == enqueue_dispatchers_.end()) {
-        auto it_and_bool = enqueue_dispatchers_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(request->context_id()),
-            std::forward_as_tuple(
-                &stub_, cq_,
-                "/tensorflow.eager.EagerService/StreamingEnqueue"));
-        it = it_and_bool.first;
+      std::shared_ptr<EnqueueStream> stream;
+      {
+        mutex_lock l(mu_);
+        std::shared_ptr<EnqueueStream>& it =
+            enqueue_streams_[request->context_id()];
+        if (it == nullptr) {
+          it = std::make_shared<EnqueueStream>(&stub_, cq_,
+                                               StreamingEnqueueWindow());
+        }
+        stream = it;
       }
       // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
-      it->second.SendNextRequest(*request, response, std::move(done_wrapped));
+      EnqueueStream::Send(std::move(stream), *request, response,
+                          std::move(done_wrapped));
     } else {
       Notification n;
       Status status;
@@ -220,8 +377,8 @@ class GrpcEagerClient : public EagerClient {
 
   mutable mutex mu_;
 
-  std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
-      enqueue_dispatchers_ TF_GUARDED_BY(mu_);
+  std::unordered_map<uint64, std::shared_ptr<EnqueueStream>> enqueue_streams_
+      TF_GUARDED_BY(mu_);
 
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
@@ -15,13 +15,24 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server_builder.h"
 #include "tensorflow/c/tf_status.h"
+#include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
 
 namespace tensorflow {
 namespace eager {
@@ -54,5 +65,258 @@ TEST(GrpcEagerClientCache, TestGetClientThreadSafety) {
   counter.Wait();
 }
 
+// An EagerService whose StreamingEnqueue answers each queue item with a
+// QueueResponse whose only shape has the item's operation id as its only
+// dimension.  The reply to the first request is held back until
+// ReleaseFirstRequest() is called, so that the client's window fills up.
+class FakeEagerService : public grpc::EagerService::Service {
+ public:
+  enum class Mode {
+    kAnswerAll,
+    // Fail the stream on any request with more than one queue item.
+    kFailCoalesced,
+    // Leave out the last queue response of a request with more than one item.
+    kDropLastResponseOfCoalesced,
+  };
+
+  explicit FakeEagerService(Mode mode) : mode_(mode) {}
+
+  ::grpc::Status StreamingEnqueue(
+      ::grpc::ServerContext* context,
+      ::grpc::ServerReaderWriter<EnqueueResponse, EnqueueRequest>* stream)
+      override {
+    EnqueueRequest request;
+    while (stream->Read(&request)) {
+      bool first;
+      {
+        mutex_lock l(mu_);
+        first = queue_sizes_.empty();
+        queue_sizes_.push_back(request.queue_size());
+        for (const QueueItem& item : request.queue()) {
+          operation_ids_.push_back(item.operation().id());
+        }
+      }
+      if (first) first_request_released_.WaitForNotification();
+
+      int num_responses = request.queue_size();
+      if (num_responses > 1) {
+        if (mode_ == Mode::kFailCoalesced) {
+          return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT,
+                                "Coalesced request rejected");
+        }
+        if (mode_ == Mode::kDropLastResponseOfCoalesced) --num_responses;
+      }
+      EnqueueResponse response;
+      for (int i = 0; i < num_responses; ++i) {
+        response.add_queue_response()->add_shape()->add_dim()->set_size(
+            request.queue(i).operation().id());
+      }
+      if (!stream->Write(response)) break;
+    }
+    return ::grpc::Status::OK;
+  }
+
+  void ReleaseFirstRequest() { first_request_released_.Notify(); }
+
+  // The number of queue items of each request received, in order.
+  std::vector<int> queue_sizes() const {
+    mutex_lock l(mu_);
+    return queue_sizes_;
+  }
+
+  // The operation ids of all the queue items received, in order.
+  std::vector<int64> operation_ids() const {
+    mutex_lock l(mu_);
+    return operation_ids_;
+  }
+
+ private:
+  const Mode mode_;
+  Notification first_request_released_;
+
+  mutable mutex mu_;
+  std::vector<int> queue_sizes_ TF_GUARDED_BY(mu_);
+  std::vector<int64> operation_ids_ TF_GUARDED_BY(mu_);
+};
+
+class GrpcEagerClientStreamingEnqueueTest : public ::testing::Test {
+ protected:
+  static constexpr uint64 kContextId = 17;
+
+  // A StreamingEnqueue call on the client.
+  struct Call {
+    EnqueueRequest request;
+    EnqueueResponse response;
+    Notification done;
+    Status status;
+  };
+
+  // Serves a FakeEagerService over a local port, and connects a client to it
+  // that keeps at most `window` enqueue requests in flight.
+  void StartServer(FakeEagerService::Mode mode, int window) {
+    setenv("TF_EAGER_CLIENT_STREAMING_ENQUEUE_WINDOW",
+           strings::StrCat(window).c_str(), /*overwrite=*/1);
+    service_ = absl::make_unique<FakeEagerService>(mode);
+    const string address =
+        strings::StrCat("localhost:", testing::PickUnusedPortOrDie());
+    ::grpc::ServerBuilder builder;
+    builder.AddListeningPort(address, ::grpc::InsecureServerCredentials());
+    builder.RegisterService(service_.get());
+    server_ = builder.BuildAndStart();
+
+    GrpcChannelSpec spec;
+    TF_ASSERT_OK(spec.AddHostPortsJob("worker", {address}));
+    ChannelCreationFunction channel_func =
+        ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
+    client_cache_.reset(NewGrpcEagerClientCache(
+        std::shared_ptr<GrpcChannelCache>(
+            NewGrpcChannelCache(spec, channel_func))));
+    TF_ASSERT_OK(
+        client_cache_->GetClient("/job:worker/replica:0/task:0", &client_));
+  }
+
+  void TearDown() override {
+    if (client_ != nullptr) {
+      // Closing the context ends its enqueue stream, so that the server can
+      // shut down.
+      CloseContextRequest request;
+      request.set_context_id(kContextId);
+      CloseContextResponse response;
+      Notification closed;
+      client_->CloseContextAsync(&request, &response,
+                                 [&closed](const Status& s) {
+                                   closed.Notify();
+                                 });
+      closed.WaitForNotification();
+      client_.reset();
+    }
+    client_cache_.reset();
+    if (server_ != nullptr) server_->Shutdown();
+  }
+
+  // Enqueues `num_items` operations with consecutive ids from `first_id`.
+  void Enqueue(int64 first_id, int num_items, Call* call) {
+    call->request.set_context_id(kContextId);
+    for (int i = 0; i < num_items; ++i) {
+      call->request.add_queue()->mutable_operation()->set_id(first_id + i);
+    }
+    client_->StreamingEnqueueAsync(/*call_opts=*/nullptr, &call->request,
+                                   &call->response, [call](const Status& s) {
+                                     call->status = s;
+                                     call->done.Notify();
+                                   });
+  }
+
+  // The operation ids that the queue responses of `call` answer, in order.
+  static std::vector<int64> AnsweredIds(const Call& call) {
+    std::vector<int64> ids;
+    for (const QueueResponse& r : call.response.queue_response()) {
+      ids.push_back(r.shape(0).dim(0).size());
+    }
+    return ids;
+  }
+
+  static std::vector<int64> Range(int64 first_id, int num_items) {
+    std::vector<int64> ids;
+    for (int i = 0; i < num_items; ++i) ids.push_back(first_id + i);
+    return ids;
+  }
+
+  std::unique_ptr<FakeEagerService> service_;
+  std::unique_ptr<::grpc::Server> server_;
+  std::unique_ptr<EagerClientCache> client_cache_;
+  core::RefCountPtr<EagerClient> client_;
+};
+
+TEST_F(GrpcEagerClientStreamingEnqueueTest, CoalescesInOrderWhenWindowIsFull) {
+  StartServer(FakeEagerService::Mode::kAnswerAll, /*window=*/1);
+  Call calls[5];
+  for (int i = 0; i < 5; ++i) Enqueue(i, 1, &calls[i]);
+  service_->ReleaseFirstRequest();
+
+  for (int i = 0; i < 5; ++i) {
+    calls[i].done.WaitForNotification();
+    TF_EXPECT_OK(calls[i].status);
+    EXPECT_EQ(AnsweredIds(calls[i]), Range(i, 1));
+  }
+  EXPECT_EQ(service_->queue_sizes(), std::vector<int>({1, 4}));
+  EXPECT_EQ(service_->operation_ids(), Range(0, 5));
+}
+
+TEST_F(GrpcEagerClientStreamingEnqueueTest, SplitsResponsesByNumItems) {
+  StartServer(FakeEagerService::Mode::kAnswerAll, /*window=*/1);
+  Call calls[4];
+  Enqueue(0, 1, &calls[0]);
+  Enqueue(1, 3, &calls[1]);
+  Enqueue(4, 1, &calls[2]);
+  Enqueue(5, 2, &calls[3]);
+  service_->ReleaseFirstRequest();
+
+  for (Call& call : calls) {
+    call.done.WaitForNotification();
+    TF_EXPECT_OK(call.status);
+  }
+  EXPECT_EQ(AnsweredIds(calls[0]), Range(0, 1));
+  EXPECT_EQ(AnsweredIds(calls[1]), Range(1, 3));
+  EXPECT_EQ(AnsweredIds(calls[2]), Range(4, 1));
+  EXPECT_EQ(AnsweredIds(calls[3]), Range(5, 2));
+  EXPECT_EQ(service_->queue_sizes(), std::vector<int>({1, 6}));
+}
+
+TEST_F(GrpcEagerClientStreamingEnqueueTest, ErrorFailsEveryCoalescedRequest) {
+  StartServer(FakeEagerService::Mode::kFailCoalesced, /*window=*/1);
+  Call calls[4];
+  for (int i = 0; i < 4; ++i) Enqueue(i, 1, &calls[i]);
+  service_->ReleaseFirstRequest();
+
+  calls[0].done.WaitForNotification();
+  TF_EXPECT_OK(calls[0].status);
+  for (int i = 1; i < 4; ++i) {
+    calls[i].done.WaitForNotification();
+    EXPECT_EQ(error::INVALID_ARGUMENT, calls[i].status.code());
+  }
+  EXPECT_EQ(service_->queue_sizes(), std::vector<int>({1, 3}));
+}
+
+TEST_F(GrpcEagerClientStreamingEnqueueTest, CoalescesAtMost256Items) {
+  StartServer(FakeEagerService::Mode::kAnswerAll, /*window=*/1);
+  Call calls[5];
+  Enqueue(0, 1, &calls[0]);
+  Enqueue(1, 100, &calls[1]);
+  Enqueue(101, 100, &calls[2]);
+  Enqueue(201, 100, &calls[3]);
+  // A request above the cap is sent on its own rather than split.
+  Enqueue(301, 300, &calls[4]);
+  service_->ReleaseFirstRequest();
+
+  for (Call& call : calls) {
+    call.done.WaitForNotification();
+    TF_EXPECT_OK(call.status);
+  }
+  EXPECT_EQ(AnsweredIds(calls[3]), Range(201, 100));
+  EXPECT_EQ(AnsweredIds(calls[4]), Range(301, 300));
+  EXPECT_EQ(service_->queue_sizes(), std::vector<int>({1, 200, 100, 300}));
+  EXPECT_EQ(service_->operation_ids(), Range(0, 601));
+}
+
+TEST_F(GrpcEagerClientStreamingEnqueueTest, MissingQueueResponses) {
+  StartServer(FakeEagerService::Mode::kDropLastResponseOfCoalesced,
+              /*window=*/1);
+  Call calls[3];
+  Enqueue(0, 1, &calls[0]);
+  Enqueue(1, 2, &calls[1]);
+  Enqueue(3, 1, &calls[2]);
+  service_->ReleaseFirstRequest();
+
+  for (Call& call : calls) call.done.WaitForNotification();
+  TF_EXPECT_OK(calls[0].status);
+  // The coalesced request is answered for its first two items only, which
+  // are all that calls[1] needs.
+  TF_EXPECT_OK(calls[1].status);
+  EXPECT_EQ(AnsweredIds(calls[1]), Range(1, 2));
+  EXPECT_EQ(error::INTERNAL, calls[2].status.code());
+  EXPECT_EQ(service_->queue_sizes(), std::vector<int>({1, 3}));
+}
+
 }  // namespace eager
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "grpcpp/generic/generic_stub.h"
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -39,12 +42,115 @@ limitations under the License.
 
 namespace tensorflow {
 
+class GrpcRemoteWorker;
+
+namespace {
+// Helper function for configuring max GRPC retries. Defaults to 0 (no
+// retries).
+int64 MaxRetries() {
+  int64 max_retries = -1;
+  TF_CHECK_OK(ReadInt64FromEnvVar("GRPC_MAX_RETRIES", 0, &max_retries));
+  return max_retries;
+}
+
+// A RecvTensor call waiting in a GrpcRecvTensorBatcher.
+struct BatchedRecvTensorCall {
+  // Not owned, and only alive until `done` is called, which a cancelled call
+  // does right away.  Only use them after claiming the call.
+  GrpcRemoteWorker* worker;
+  CallOptions* call_opts;
+  const RecvTensorRequest* request;
+  TensorResponse* response;
+  StatusCallback done;
+
+  mutex mu;
+  // Set once the call is completed, cancelled, or handed back to `worker`.
+  bool claimed TF_GUARDED_BY(mu) = false;
+
+  // Returns true if the caller is the first to claim the call, and is
+  // responsible for calling `done`.
+  bool Claim() {
+    mutex_lock l(mu);
+    if (claimed) return false;
+    claimed = true;
+    return true;
+  }
+};
+}  // namespace
+
+class GrpcRecvTensorBatcher
+    : public std::enable_shared_from_this<GrpcRecvTensorBatcher> {
+ public:
+  GrpcRecvTensorBatcher(SharedGrpcChannelPtr channel,
+                        ::grpc::CompletionQueue* completion_queue,
+                        thread::ThreadPool* callback_threadpool,
+                        const string& target, int64 window_micros,
+                        int64 max_batch_size, int64 max_tensor_bytes)
+      : channel_(std::move(channel)),
+        stub_(channel_),
+        cq_(completion_queue),
+        callback_threadpool_(callback_threadpool),
+        target_(target),
+        batchrecvtensor_(
+            GrpcWorkerMethodName(GrpcWorkerMethod::kBatchRecvTensor)),
+        markrecvfinished_(
+            GrpcWorkerMethodName(GrpcWorkerMethod::kMarkRecvFinished)),
+        max_retries_(MaxRetries()),
+        window_micros_(window_micros),
+        max_batch_size_(max_batch_size),
+        max_tensor_bytes_(max_tensor_bytes) {}
+
+  // Queues `call` to be sent together with other calls of its step.
+  // Returns false if the target does not serve BatchRecvTensor, in which
+  // case the caller issues the call itself.
+  bool Enqueue(std::shared_ptr<BatchedRecvTensorCall> call);
+
+ private:
+  typedef std::vector<std::shared_ptr<BatchedRecvTensorCall>> Calls;
+
+  struct Batch {
+    BatchRecvTensorRequest request;
+    Calls calls;
+  };
+
+  // Sends the batch collected for `step_id`, if it is still `batch`.
+  void FlushAfterWindow(int64 step_id, std::shared_ptr<Batch> batch);
+
+  void IssueBatch(std::shared_ptr<Batch> batch);
+
+  void BatchDone(const Batch& batch, const BatchRecvTensorResponse& response,
+                 const Status& s);
+
+  SharedGrpcChannelPtr channel_;
+  ::grpc::GenericStub stub_;
+  ::grpc::CompletionQueue* cq_;
+  thread::ThreadPool* callback_threadpool_;
+  const string target_;
+  const ::grpc::string batchrecvtensor_;
+  const ::grpc::string markrecvfinished_;
+  const int64 max_retries_;
+
+  const int64 window_micros_;
+  const int64 max_batch_size_;
+  const int64 max_tensor_bytes_;
+
+  mutex mu_;
+  // Set once the target turned out not to serve BatchRecvTensor.
+  bool unsupported_ TF_GUARDED_BY(mu_) = false;
+  // The batches being collected, by step id.
+  std::unordered_map<int64, std::shared_ptr<Batch>> batches_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcRecvTensorBatcher);
+};
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
-  explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
-                            ::grpc::CompletionQueue* completion_queue,
-                            thread::ThreadPool* callback_threadpool,
-                            WorkerCacheLogger* logger, const string& target)
+  explicit GrpcRemoteWorker(
+      SharedGrpcChannelPtr channel, ::grpc::CompletionQueue* completion_queue,
+      thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger,
+      const string& target,
+      std::shared_ptr<GrpcRecvTensorBatcher> recv_tensor_batcher)
       : channel_(std::move(channel)),
         stub_(channel_),
         cq_(completion_queue),
@@ -66,7 +172,10 @@ class GrpcRemoteWorker : public WorkerInterface {
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
         logger_(logger),
-        target_(target) {}
+        target_(target),
+        recv_tensor_chunk_bytes_(RecvTensorChunkBytes()),
+        recv_tensor_chunk_window_(RecvTensorChunkWindow()),
+        recv_tensor_batcher_(std::move(recv_tensor_batcher)) {}
 
   ~GrpcRemoteWorker() override {}
 
@@ -251,7 +360,41 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    if (recv_tensor_batcher_ && request->request_id() != 0) {
+      auto call = std::make_shared<BatchedRecvTensorCall>();
+      call->worker = this;
+      call->call_opts = call_opts;
+      call->request = request;
+      call->response = response;
+      call->done = callback;
+      if (recv_tensor_batcher_->Enqueue(std::move(call))) return;
+    }
+    IssueRecvTensor(call_opts, request, response, std::move(callback));
+  }
+
+  // Issues a RecvTensor RPC for `request`, bypassing any batching.
+  void IssueRecvTensor(CallOptions* call_opts, const RecvTensorRequest* request,
+                       TensorResponse* response, StatusCallback callback) {
+    if (recv_tensor_chunk_bytes_ > 0 && response->on_host()) {
+      // Ask for large tensors in chunks.  If the sender splits its response,
+      // only the first chunk arrives here and the remaining ones are fetched
+      // straight into the tensor before `callback` runs.
+      RecvTensorRequest chunked_request(*request);
+      chunked_request.set_max_chunk_bytes(recv_tensor_chunk_bytes_);
+      auto first_chunk_done = [this, call_opts, request, response,
+                               callback](const Status& s) {
+        if (s.ok() && response->metadata().partial()) {
+          FetchRemainingChunks(call_opts, *request, response, callback);
+        } else {
+          callback(s);
+        }
+      };
+      IssueRequest(&chunked_request, response, recvtensor_,
+                   std::move(first_chunk_done), call_opts);
+      return;
+    }
+    IssueRequest(request, response, recvtensor_, std::move(callback),
+                 call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -285,6 +428,141 @@ class GrpcRemoteWorker : public WorkerInterface {
                                  /*fail_fast=*/true, &target_);
   }
 
+  // State of a RecvTensor call whose response is split into chunks.
+  struct RecvTensorChunks {
+    RecvTensorRequest request;
+    char* data;  // Not owned.  The content of the received tensor.
+    int64 total_bytes;
+    CallOptions* call_opts;  // Not owned.
+    StatusCallback done;
+
+    mutex mu;
+    int64 next_offset TF_GUARDED_BY(mu);
+    int num_pending TF_GUARDED_BY(mu) = 0;
+    Status status TF_GUARDED_BY(mu);
+    // Options of the chunk requests in flight, used to cancel them.
+    std::unordered_set<CallOptions*> active TF_GUARDED_BY(mu);
+  };
+
+  // Number of times a chunk request that failed with UNAVAILABLE is reissued.
+  // Chunks are served from the sender's response cache, so unlike a whole
+  // RecvTensor call they can always be retried.
+  static constexpr int kMaxRecvTensorChunkRetries = 3;
+
+  // Receives the content of the tensor in `response` that follows its first
+  // chunk, keeping at most `recv_tensor_chunk_window_` requests in flight.
+  void FetchRemainingChunks(CallOptions* call_opts,
+                            const RecvTensorRequest& request,
+                            TensorResponse* response, StatusCallback done) {
+    auto state = std::make_shared<RecvTensorChunks>();
+    state->request = request;
+    state->request.set_max_chunk_bytes(recv_tensor_chunk_bytes_);
+    const Tensor& tensor = response->tensor();
+    state->data = const_cast<char*>(tensor.tensor_data().data());
+    state->total_bytes = tensor.TotalBytes();
+    state->call_opts = call_opts;
+    state->done = std::move(done);
+    std::vector<std::pair<int64, CallOptions*>> chunks;
+    {
+      mutex_lock l(state->mu);
+      state->next_offset =
+          std::min(recv_tensor_chunk_bytes_, state->total_bytes);
+      TakeRecvTensorChunks(state.get(), &chunks);
+    }
+    if (chunks.empty()) {
+      state->done(Status::OK());
+      return;
+    }
+    if (call_opts) {
+      call_opts->SetCancelCallback([state]() {
+        mutex_lock l(state->mu);
+        state->status.Update(errors::Cancelled("RecvTensor cancelled"));
+        for (CallOptions* opts : state->active) opts->StartCancel();
+      });
+    }
+    for (const auto& chunk : chunks) {
+      IssueRecvTensorChunk(state, chunk.first, chunk.second, 0);
+    }
+  }
+
+  // Reserves the next chunks to request, as long as the window allows.
+  void TakeRecvTensorChunks(RecvTensorChunks* state,
+                            std::vector<std::pair<int64, CallOptions*>>* chunks)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(state->mu) {
+    while (state->status.ok() &&
+           state->num_pending < recv_tensor_chunk_window_ &&
+           state->next_offset < state->total_bytes) {
+      CallOptions* opts = new CallOptions;
+      state->active.insert(opts);
+      chunks->emplace_back(state->next_offset, opts);
+      state->next_offset += recv_tensor_chunk_bytes_;
+      ++state->num_pending;
+    }
+  }
+
+  void IssueRecvTensorChunk(std::shared_ptr<RecvTensorChunks> state,
+                            int64 offset, CallOptions* opts, int num_retries) {
+    RecvTensorRequest request(state->request);
+    request.set_chunk_offset(offset);
+    RecvTensorResponse* response = new RecvTensorResponse;
+    auto done = [this, state, offset, opts, num_retries, response](Status s) {
+      const int64 num_bytes =
+          std::min(recv_tensor_chunk_bytes_, state->total_bytes - offset);
+      if (s.ok()) {
+        if (!response->partial() ||
+            static_cast<int64>(response->tensor_chunk().size()) != num_bytes) {
+          s = errors::Internal("Unexpected RecvTensor chunk at offset ",
+                               offset, " for ",
+                               state->request.rendezvous_key());
+        } else {
+          memcpy(state->data + offset, response->tensor_chunk().data(),
+                 num_bytes);
+        }
+      }
+      delete response;
+
+      bool retry = false;
+      bool finished = false;
+      std::vector<std::pair<int64, CallOptions*>> chunks;
+      {
+        mutex_lock l(state->mu);
+        retry = errors::IsUnavailable(s) &&
+                num_retries < kMaxRecvTensorChunkRetries && state->status.ok();
+        if (!retry) {
+          state->active.erase(opts);
+          --state->num_pending;
+          state->status.Update(s);
+          if (!s.ok()) {
+            for (CallOptions* other : state->active) other->StartCancel();
+          }
+          TakeRecvTensorChunks(state.get(), &chunks);
+          finished = (state->num_pending == 0);
+        }
+      }
+      if (retry) {
+        VLOG(1) << "Retrying RecvTensor chunk at offset " << offset << ": "
+                << s;
+        IssueRecvTensorChunk(state, offset, opts, num_retries + 1);
+        return;
+      }
+      delete opts;
+      if (finished) {
+        if (state->call_opts) state->call_opts->ClearCancelCallback();
+        Status status;
+        {
+          mutex_lock l(state->mu);
+          status = state->status;
+        }
+        state->done(status);
+        return;
+      }
+      for (const auto& chunk : chunks) {
+        IssueRecvTensorChunk(state, chunk.first, chunk.second, 0);
+      }
+    };
+    IssueRequest(&request, response, recvtensor_, std::move(done), opts);
+  }
+
   void IssueMarkRecvFinishedRequest(int64 request_id) {
     VLOG(2) << "Send MarkRecvFinishedRequest for request " << request_id;
     MarkRecvFinishedRequest request;
@@ -298,12 +576,22 @@ class GrpcRemoteWorker : public WorkerInterface {
   // Helper function for initializing the RpcMethod objects below.
   const char* Method(GrpcWorkerMethod id) { return GrpcWorkerMethodName(id); }
 
-  // Helper function for configuring max GRPC retries. Defaults to 0 (no
-  // retries).
-  const int64 MaxRetries() {
-    int64 max_retries = -1;
-    TF_CHECK_OK(ReadInt64FromEnvVar("GRPC_MAX_RETRIES", 0, &max_retries));
-    return max_retries;
+  // Helper function for configuring the chunk size of RecvTensor responses.
+  // Defaults to 0 (tensors are received in a single response).
+  static int64 RecvTensorChunkBytes() {
+    int64 chunk_bytes = 0;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("GRPC_RECV_TENSOR_CHUNK_BYTES", 0, &chunk_bytes));
+    return chunk_bytes;
+  }
+
+  // Helper function for configuring how many chunk requests of one
+  // RecvTensor call may be in flight at once. Defaults to 4.
+  static int64 RecvTensorChunkWindow() {
+    int64 window = 0;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("GRPC_RECV_TENSOR_CHUNK_WINDOW", 4, &window));
+    return std::max<int64>(window, 1);
   }
 
   SharedGrpcChannelPtr channel_;
@@ -332,16 +620,182 @@ class GrpcRemoteWorker : public WorkerInterface {
   WorkerCacheLogger* logger_;
   const string target_;
 
+  // Support for chunked RecvTensor responses.
+  const int64 recv_tensor_chunk_bytes_;
+  const int64 recv_tensor_chunk_window_;
+
+  // Support for batched RecvTensor calls.
+  std::shared_ptr<GrpcRecvTensorBatcher> recv_tensor_batcher_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcRemoteWorker);
 };
 
-WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
-                                     ::grpc::CompletionQueue* completion_queue,
-                                     thread::ThreadPool* callback_threadpool,
-                                     WorkerCacheLogger* logger,
-                                     const string& target) {
+bool GrpcRecvTensorBatcher::Enqueue(
+    std::shared_ptr<BatchedRecvTensorCall> call) {
+  const int64 step_id = call->request->step_id();
+  std::shared_ptr<Batch> batch;
+  bool new_batch = false;
+  {
+    mutex_lock l(mu_);
+    if (unsupported_) return false;
+    std::shared_ptr<Batch>& pending = batches_[step_id];
+    if (pending == nullptr) {
+      pending = std::make_shared<Batch>();
+      new_batch = true;
+    }
+    batch = pending;
+    *batch->request.add_request() = *call->request;
+    batch->calls.push_back(call);
+    if (call->call_opts) {
+      // A cancelled call completes right away.  The tensor it asked for is
+      // still delivered to the batch, and left to the sender's step cleanup.
+      // The callback is set before `mu_` is released, so that the batch
+      // cannot complete the call before.
+      thread::ThreadPool* pool = callback_threadpool_;
+      call->call_opts->SetCancelCallback([call, pool]() {
+        if (!call->Claim()) return;
+        pool->Schedule([call]() {
+          call->call_opts->ClearCancelCallback();
+          call->done(errors::Cancelled("RecvTensor cancelled"));
+        });
+      });
+    }
+    if (static_cast<int64>(batch->calls.size()) < max_batch_size_) {
+      batch.reset();
+    } else {
+      batches_.erase(step_id);
+    }
+  }
+  if (batch) {
+    IssueBatch(std::move(batch));
+  } else if (new_batch) {
+    std::shared_ptr<GrpcRecvTensorBatcher> self = shared_from_this();
+    Env::Default()->SchedClosureAfter(window_micros_, [self, step_id]() {
+      std::shared_ptr<Batch> batch;
+      {
+        mutex_lock l(self->mu_);
+        auto it = self->batches_.find(step_id);
+        if (it == self->batches_.end()) return;
+        batch = std::move(it->second);
+        self->batches_.erase(it);
+      }
+      self->IssueBatch(std::move(batch));
+    });
+  }
+  return true;
+}
+
+void GrpcRecvTensorBatcher::IssueBatch(std::shared_ptr<Batch> batch) {
+  VLOG(2) << "Issue BatchRecvTensor with " << batch->calls.size()
+          << " calls to " << target_;
+  batch->request.set_max_delay_micros(window_micros_);
+  batch->request.set_max_tensor_bytes(max_tensor_bytes_);
+  BatchRecvTensorResponse* response = new BatchRecvTensorResponse;
+  std::shared_ptr<GrpcRecvTensorBatcher> self = shared_from_this();
+  auto done = [self, batch, response](const Status& s) {
+    self->BatchDone(*batch, *response, s);
+    delete response;
+  };
+  new RPCState<protobuf::Message>(&stub_, cq_, batchrecvtensor_,
+                                  batch->request, response, std::move(done),
+                                  /*call_opts=*/nullptr, callback_threadpool_,
+                                  max_retries_, /*fail_fast=*/true, &target_);
+}
+
+void GrpcRecvTensorBatcher::BatchDone(const Batch& batch,
+                                      const BatchRecvTensorResponse& response,
+                                      const Status& s) {
+  const Calls& calls = batch.calls;
+  if (!s.ok()) {
+    VLOG(1) << "BatchRecvTensor to " << target_ << " failed: " << s;
+    if (errors::IsUnimplemented(s)) {
+      mutex_lock l(mu_);
+      if (!unsupported_) {
+        LOG(WARNING) << "Disabling RecvTensor batching for " << target_
+                     << ": " << s;
+      }
+      unsupported_ = true;
+    }
+  }
+  const bool ok =
+      s.ok() && response.result_size() == static_cast<int>(calls.size());
+
+  // Ack all returned tensors at once, before any `done` may delete the
+  // workers.  The request ids are taken from the batch's copy of the
+  // requests, since a cancelled call's own request may already be gone.
+  MarkRecvFinishedRequest ack;
+  for (int i = 0; ok && i < calls.size(); ++i) {
+    const BatchRecvTensorResponse::Result& result = response.result(i);
+    if (result.ready() && result.response().require_ack()) {
+      const int64 request_id = batch.request.request(i).request_id();
+      if (ack.request_id() == 0) {
+        ack.set_request_id(request_id);
+      } else {
+        ack.add_additional_request_id(request_id);
+      }
+    }
+  }
+  if (ack.request_id() != 0) {
+    MarkRecvFinishedResponse* ack_response = new MarkRecvFinishedResponse;
+    // The RPC uses `stub_` and `target_`, so it keeps the batcher alive.
+    std::shared_ptr<GrpcRecvTensorBatcher> self = shared_from_this();
+    new RPCState<protobuf::Message>(
+        &stub_, cq_, markrecvfinished_, ack, ack_response,
+        [self, ack_response](const Status&) { delete ack_response; },
+        /*call_opts=*/nullptr, callback_threadpool_, max_retries_,
+        /*fail_fast=*/true, &target_);
+  }
+
+  for (int i = 0; i < calls.size(); ++i) {
+    BatchedRecvTensorCall* call = calls[i].get();
+    if (!call->Claim()) continue;
+    if (call->call_opts) call->call_opts->ClearCancelCallback();
+    if (!ok || !response.result(i).ready()) {
+      // The call is still pending at the sender, or its tensor is large, or
+      // the batch failed: issue it on its own.  The sender serves it from
+      // its response cache if it already started it.
+      call->worker->IssueRecvTensor(call->call_opts, call->request,
+                                    call->response, std::move(call->done));
+      continue;
+    }
+    const BatchRecvTensorResponse::Result& result = response.result(i);
+    if (result.status_code() != error::OK) {
+      call->done(Status(result.status_code(), result.status_error_message()));
+      continue;
+    }
+    // Already acked above.
+    RecvTensorResponse recv_response(result.response());
+    recv_response.set_require_ack(false);
+    call->done(call->response->InitFrom(&recv_response));
+  }
+}
+
+std::shared_ptr<GrpcRecvTensorBatcher> NewGrpcRecvTensorBatcher(
+    SharedGrpcChannelPtr channel, ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, const string& target) {
+  int64 window_micros = 0;
+  int64 max_batch_size = 0;
+  int64 max_tensor_bytes = 0;
+  TF_CHECK_OK(ReadInt64FromEnvVar("GRPC_RECV_TENSOR_BATCH_WINDOW_MICROS", 0,
+                                  &window_micros));
+  TF_CHECK_OK(ReadInt64FromEnvVar("GRPC_RECV_TENSOR_BATCH_SIZE", 64,
+                                  &max_batch_size));
+  TF_CHECK_OK(ReadInt64FromEnvVar("GRPC_RECV_TENSOR_BATCH_MAX_TENSOR_BYTES",
+                                  4096, &max_tensor_bytes));
+  if (window_micros <= 0 || max_batch_size <= 1) return nullptr;
+  return std::make_shared<GrpcRecvTensorBatcher>(
+      std::move(channel), completion_queue, callback_threadpool, target,
+      window_micros, max_batch_size, max_tensor_bytes);
+}
+
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel, ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger,
+    const string& target,
+    std::shared_ptr<GrpcRecvTensorBatcher> recv_tensor_batcher) {
   return new GrpcRemoteWorker(std::move(channel), completion_queue,
-                              callback_threadpool, logger, target);
+                              callback_threadpool, logger, target,
+                              std::move(recv_tensor_batcher));
 }
 
 }  // namespace tensorflow
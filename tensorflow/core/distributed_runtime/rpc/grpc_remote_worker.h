@@ -23,14 +23,26 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
+class GrpcRecvTensorBatcher;
 class WorkerCacheLogger;
 class WorkerInterface;
 
-WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
-                                     ::grpc::CompletionQueue* completion_queue,
-                                     thread::ThreadPool* callback_threadpool,
-                                     WorkerCacheLogger* logger,
-                                     const string& target);
+// Returns an object that coalesces the small RecvTensor calls that the
+// remote workers for `target` issue for the same step within a short time
+// window into BatchRecvTensor RPCs, or nullptr if batching is disabled.
+// Batching is configured through the GRPC_RECV_TENSOR_BATCH_* environment
+// variables, and is off by default.
+std::shared_ptr<GrpcRecvTensorBatcher> NewGrpcRecvTensorBatcher(
+    SharedGrpcChannelPtr channel, ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, const string& target);
+
+// If `recv_tensor_batcher` is not null, it should be shared by all remote
+// workers for `target`.
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel, ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger,
+    const string& target,
+    std::shared_ptr<GrpcRecvTensorBatcher> recv_tensor_batcher = nullptr);
 
 }  // namespace tensorflow
 
@@ -254,5 +254,53 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
 }
 
+// The chunk is encoded as the last field of the RecvTensorResponse, so that
+// it can be appended to the encoding of all other fields as a grpc::Slice
+// that shares the backing store of "val".
+void EncodeTensorChunkToByteBuffer(const Tensor& val, int64 offset,
+                                   int64 max_chunk_bytes, bool require_ack,
+                                   ::grpc::ByteBuffer* result) {
+  DCHECK(DataTypeCanUseMemcpy(val.dtype()));
+  StringPiece tdata = val.tensor_data();
+  DCHECK_LE(offset, tdata.size());
+  const size_t chunk_bytes =
+      std::min<int64>(max_chunk_bytes, tdata.size() - offset);
+
+  RecvTensorResponse response;
+  response.mutable_tensor()->set_dtype(val.dtype());
+  val.shape().AsProto(response.mutable_tensor()->mutable_tensor_shape());
+  response.set_require_ack(require_ack);
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  response.set_partial(true);
+  string header;  // All of RecvTensorResponse except the tensor_chunk field
+  response.AppendToString(&header);
+
+  size_t encoder_size =
+      header.size() +
+      VarLengthEncodingSize(RecvTensorResponse::kTensorChunkFieldNumber,
+                            chunk_bytes) -
+      chunk_bytes;
+  gtl::InlinedVector<char, 128> space(encoder_size);
+  io::ProtoEncodeHelper e(space.data(), space.size());
+  e.WriteRawBytes(header);
+  e.WriteVarlengthBeginning(RecvTensorResponse::kTensorChunkFieldNumber,
+                            chunk_bytes);
+
+  ::grpc::Slice slices[2];
+  slices[0] = ::grpc::Slice(e.data(), e.size());
+  int num_slices = 1;
+  if (chunk_bytes > 0) {
+    const TensorBuffer* buf = DMAHelper::buffer(&val);
+    buf->Ref();
+    slices[1] = ::grpc::Slice(
+        const_cast<char*>(tdata.data()) + offset, chunk_bytes,
+        [](void* backing) { static_cast<TensorBuffer*>(backing)->Unref(); },
+        const_cast<TensorBuffer*>(buf));
+    num_slices += 1;
+  }
+  ::grpc::ByteBuffer tmp(&slices[0], num_slices);
+  result->Swap(&tmp);
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
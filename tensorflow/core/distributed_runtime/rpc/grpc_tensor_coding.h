@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 class Tensor;
@@ -49,6 +50,16 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// Encode the part of "val"'s content that starts at "offset" and is at most
+// "max_chunk_bytes" long into a byte buffer in a format that is parseable as
+// a RecvTensorResponse protocol buffer with "partial" set.  "val" must be of
+// a type that can be copied with memcpy.
+//
+// Discards original contents of *result.
+void EncodeTensorChunkToByteBuffer(const Tensor& val, int64 offset,
+                                   int64 max_chunk_bytes, bool require_ack,
+                                   ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -100,4 +100,36 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, TensorChunks) {
+  const int64 kMaxChunkBytes = 1000;
+  Tensor t(DT_FLOAT, TensorShape({3, 333}));
+  test::FillFn<float>(&t, [](int i) { return static_cast<float>(i); });
+  StringPiece tdata = t.tensor_data();
+
+  string content;
+  for (int64 offset = 0; offset < tdata.size(); offset += kMaxChunkBytes) {
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorChunkToByteBuffer(t, offset, kMaxChunkBytes, true, &buf);
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+
+    RecvTensorResponse response;
+    EXPECT_TRUE(response.ParseFromString(tmp));
+    EXPECT_TRUE(response.partial());
+    EXPECT_TRUE(response.require_ack());
+    EXPECT_FALSE(response.is_dead());
+    EXPECT_EQ(DT_FLOAT, response.tensor().dtype());
+    EXPECT_EQ(t.shape(), TensorShape(response.tensor().tensor_shape()));
+    EXPECT_TRUE(response.tensor().tensor_content().empty());
+    EXPECT_EQ(std::min<int64>(kMaxChunkBytes, tdata.size() - offset),
+              response.tensor_chunk().size());
+    content.append(response.tensor_chunk());
+  }
+  EXPECT_EQ(string(tdata), content);
+}
+
 }  // namespace tensorflow
@@ -61,7 +61,8 @@ class GrpcWorkerCache : public WorkerCachePartial {
       size_t index = AssignWorkerToThread(target);
       return NewGrpcRemoteWorker(
           channel, worker_env_->GetCompletionQueue(index),
-          worker_env_->GetThreadPool(), &logger_, target);
+          worker_env_->GetThreadPool(), &logger_, target,
+          GetRecvTensorBatcher(target, channel, index));
     }
   }
 
@@ -104,6 +105,24 @@ class GrpcWorkerCache : public WorkerCachePartial {
     return it->second;
   }
 
+  // Returns the RecvTensor batcher shared by the remote workers for `target`,
+  // or nullptr if batching is disabled.
+  std::shared_ptr<GrpcRecvTensorBatcher> GetRecvTensorBatcher(
+      const string& target, const SharedGrpcChannelPtr& channel,
+      size_t index) {
+    mutex_lock lock(batchers_mu_);
+    auto it = recv_tensor_batchers_.find(target);
+    if (it == recv_tensor_batchers_.end()) {
+      it = recv_tensor_batchers_
+               .emplace(target, NewGrpcRecvTensorBatcher(
+                                    channel,
+                                    worker_env_->GetCompletionQueue(index),
+                                    worker_env_->GetThreadPool(), target))
+               .first;
+    }
+    return it->second;
+  }
+
   const string local_target_;
   WorkerInterface* const local_worker_;  // Not owned.
   std::shared_ptr<GrpcChannelCache> channel_cache_;
@@ -114,6 +133,10 @@ class GrpcWorkerCache : public WorkerCachePartial {
   std::unordered_map<std::string, size_t> target_assignments_
       TF_GUARDED_BY(assignment_mu_);
   size_t next_round_robin_assignment_ TF_GUARDED_BY(assignment_mu_);
+
+  mutex batchers_mu_;
+  std::unordered_map<string, std::shared_ptr<GrpcRecvTensorBatcher>>
+      recv_tensor_batchers_ TF_GUARDED_BY(batchers_mu_);
 };
 
 }  // namespace
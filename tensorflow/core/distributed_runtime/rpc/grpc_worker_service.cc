@@ -147,6 +147,7 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
+    SETUP_FOR_REQUEST(BatchRecvTensor, 100, true);
 
     // TODO(ncteisen): Determine a better policy for enqueuing the
     // appropriate number of each request type.
@@ -234,6 +235,9 @@ class GrpcWorkerServiceThread {
       WorkerCall<MarkRecvFinishedRequest, MarkRecvFinishedResponse>* call) {
     VLOG(1) << "Clean cache entry for request " << call->request.request_id();
     worker_->RemoveCacheEntryForId(call->request.request_id());
+    for (int64 request_id : call->request.additional_request_id()) {
+      worker_->RemoveCacheEntryForId(request_id);
+    }
     call->SendResponse(::grpc::Status::OK);
     ENQUEUE_REQUEST(MarkRecvFinished, false);
   }
@@ -283,6 +287,25 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void BatchRecvTensorHandler(
+      WorkerCall<BatchRecvTensorRequest, BatchRecvTensorResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->BatchRecvTensorAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(1) << "Bad response from BatchRecvTensor:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    ENQUEUE_REQUEST(BatchRecvTensor, true);
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -447,13 +470,34 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
-    if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+  // Large tensors are returned in chunks if the receiver asks for it.  All
+  // chunks are served from the response cache entry of the first request,
+  // so a cache is required, and a chunk can be retried on its own.
+  const int64 max_chunk_bytes = cache_enabled ? request->max_chunk_bytes() : 0;
+  const int64 chunk_offset = request->chunk_offset();
+  auto do_response = [response, done, cache_enabled, max_chunk_bytes,
+                      chunk_offset](const Tensor& tensor, bool is_dead,
+                                    const Status& status) {
+    Status s = status;
+    if (s.ok()) {
+      const bool chunkable =
+          max_chunk_bytes > 0 && !is_dead &&
+          DataTypeCanUseMemcpy(tensor.dtype()) &&
+          (chunk_offset > 0 || tensor.TotalBytes() > max_chunk_bytes);
+      if (chunkable && chunk_offset < tensor.TotalBytes()) {
+        grpc::EncodeTensorChunkToByteBuffer(tensor, chunk_offset,
+                                            max_chunk_bytes, cache_enabled,
+                                            response);
+      } else if (chunk_offset > 0) {
+        s = errors::InvalidArgument("Invalid chunk offset ", chunk_offset,
+                                    " for tensor of ", tensor.TotalBytes(),
+                                    " bytes");
+      } else {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
     }
-    done(status);
+    done(s);
   };
 
   // If response cache is enabled and the response cache already contains the
@@ -476,18 +520,23 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
     }
   };
 
-  auto fail = [&rendezvous_done](const Status& status) {
-    rendezvous_done(Tensor(), false, status);
-  };
+  RecvLocalTensorAsync(opts, *request, rendezvous_done);
+}
+
+void GrpcWorker::RecvLocalTensorAsync(
+    CallOptions* opts, const RecvTensorRequest& request,
+    const GrpcResponseCache::FinishResponseCB& done) {
+  auto fail = [&done](const Status& status) { done(Tensor(), false, status); };
 
+  const int64 step_id = request.step_id();
   Status s = recent_request_ids_.TrackUnique(
-      request_id, "RecvTensor (GrpcWorker)", *request);
+      request.request_id(), "RecvTensor (GrpcWorker)", request);
   if (!s.ok()) {
     fail(s);
     return;
   }
 
-  const string& key = request->rendezvous_key();
+  const string& key = request.rendezvous_key();
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
   Rendezvous::ParsedKey parsed;
   s = Rendezvous::ParseKey(key, &parsed);
@@ -506,15 +555,18 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // and aborting the step eliminates the opportunity for client side retries.
   // Repeated client failures will eventually cause the step to be aborted by
   // the client.
-  opts->SetCancelCallback(
-      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
+  if (opts) {
+    opts->SetCancelCallback([step_id]() {
+      LOG(WARNING) << "RecvTensor cancelled for " << step_id;
+    });
+  }
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, rendezvous_done, src_dev, request](
-          const Status& status, const Rendezvous::Args& send_args,
-          const Rendezvous::Args& recv_args, const Tensor& val,
-          const bool is_dead) {
-        opts->ClearCancelCallback();
+      [opts, done, src_dev, key](const Status& status,
+                                 const Rendezvous::Args& send_args,
+                                 const Rendezvous::Args& recv_args,
+                                 const Tensor& val, const bool is_dead) {
+        if (opts) opts->ClearCancelCallback();
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
           // the following three odd edge cases: 1) a zero-size
@@ -537,24 +589,135 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on an accelerator device. Uses the device_context to
               // fill the copy on host.
-              StatusCallback copy_ready = [rendezvous_done, copy,
+              StatusCallback copy_ready = [done, copy,
                                            is_dead](const Status& s) {
                 // The value is now ready to be returned on the wire.
-                rendezvous_done(*copy, is_dead, s);
+                done(*copy, is_dead, s);
                 delete copy;
               };
 
-              CopyDeviceToHost(&val, alloc, alloc, request->rendezvous_key(),
-                               src_dev, copy, send_dev_context, copy_ready);
+              CopyDeviceToHost(&val, alloc, alloc, key, src_dev, copy,
+                               send_dev_context, copy_ready);
               return;
             }
           }
         }
 
-        rendezvous_done(val, is_dead, status);
+        done(val, is_dead, status);
       });
 }
 
+void GrpcWorker::BatchRecvTensorAsync(CallOptions* opts,
+                                      const BatchRecvTensorRequest* request,
+                                      BatchRecvTensorResponse* response,
+                                      StatusCallback done) {
+  if (response_cache_ == nullptr) {
+    done(errors::Unimplemented(
+        "BatchRecvTensor requires the gRPC response cache"));
+    return;
+  }
+  for (const RecvTensorRequest& req : request->request()) {
+    if (req.request_id() == 0) {
+      done(errors::InvalidArgument(
+          "BatchRecvTensor requires a request_id for every call"));
+      return;
+    }
+  }
+  if (request->request_size() == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  // The results are filled in as the tensors become available.  Once the
+  // response is sent the remaining ones only complete their cache entries.
+  struct State {
+    mutex mu;
+    int num_pending TF_GUARDED_BY(mu);
+    bool replied TF_GUARDED_BY(mu) = false;
+    bool timer_started TF_GUARDED_BY(mu) = false;
+    BatchRecvTensorResponse* response;
+    StatusCallback done;
+  };
+  auto state = std::make_shared<State>();
+  state->num_pending = request->request_size();
+  state->response = response;
+  state->done = std::move(done);
+  for (int i = 0; i < request->request_size(); ++i) {
+    response->add_result();
+  }
+
+  const int64 max_delay_micros = request->max_delay_micros();
+  const int64 max_tensor_bytes = request->max_tensor_bytes();
+  Env* env = env_->env;
+  for (int i = 0; i < request->request_size(); ++i) {
+    const RecvTensorRequest& req = request->request(i);
+    auto result_ready = [state, i, max_delay_micros, max_tensor_bytes, env](
+                            const Tensor& tensor, bool is_dead,
+                            const Status& status) {
+      bool reply = false;
+      bool start_timer = false;
+      {
+        mutex_lock l(state->mu);
+        if (state->replied) return;
+        BatchRecvTensorResponse::Result* result =
+            state->response->mutable_result(i);
+        if (!status.ok()) {
+          result->set_ready(true);
+          result->set_status_code(status.code());
+          result->set_status_error_message(status.error_message());
+        } else if (is_dead || tensor.TotalBytes() <= max_tensor_bytes) {
+          result->set_ready(true);
+          RecvTensorResponse* resp = result->mutable_response();
+          resp->set_is_dead(is_dead);
+          resp->set_require_ack(true);
+          resp->set_send_start_micros(env->NowMicros());
+          if (is_dead) {
+            // The value of a dead tensor is uninitialized.
+            resp->mutable_tensor()->set_dtype(tensor.dtype());
+            tensor.shape().AsProto(
+                resp->mutable_tensor()->mutable_tensor_shape());
+          } else {
+            tensor.AsProtoTensorContent(resp->mutable_tensor());
+          }
+        }
+        if (--state->num_pending == 0) {
+          state->replied = true;
+          reply = true;
+        } else if (!state->timer_started) {
+          state->timer_started = true;
+          start_timer = true;
+        }
+      }
+      if (reply) {
+        state->done(Status::OK());
+      } else if (start_timer) {
+        env->SchedClosureAfter(max_delay_micros, [state]() {
+          {
+            mutex_lock l(state->mu);
+            if (state->replied) return;
+            state->replied = true;
+          }
+          state->done(Status::OK());
+        });
+      }
+    };
+    // As for RecvTensor, a call that is already in the response cache is
+    // served from there, which makes a retried batch safe.
+    const int64 request_id = req.request_id();
+    if (response_cache_->QueueRequest(request_id, req.step_id(),
+                                      result_ready)) {
+      continue;
+    }
+    RecvLocalTensorAsync(
+        nullptr, req,
+        [this, request_id](const Tensor& tensor, bool is_dead,
+                           const Status& status) {
+          response_cache_->OnRequestFinished(request_id, tensor, is_dead,
+                                             status);
+        });
+  }
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
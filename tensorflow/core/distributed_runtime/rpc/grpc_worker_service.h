@@ -46,6 +46,13 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  // Serves several RecvTensor calls of one step with a single response, see
+  // BatchRecvTensorRequest.  Requires the response cache.
+  void BatchRecvTensorAsync(CallOptions* opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done);
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -63,6 +70,11 @@ class GrpcWorker : public Worker {
   void RemoveCacheEntryForId(int64 request_id);
 
  private:
+  // Receives the tensor named by `request` from the local rendezvous, copied
+  // to host memory, and passes it to `done`.  `opts` may be null.
+  void RecvLocalTensorAsync(CallOptions* opts, const RecvTensorRequest& request,
+                            const GrpcResponseCache::FinishResponseCB& done);
+
   std::unique_ptr<GrpcResponseCache> response_cache_;
   const int32 recv_buf_max_chunk_;
 };
@@ -0,0 +1,377 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+#include <cstdlib>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "grpcpp/create_channel.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server_builder.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
+#include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kWorkerName[] = "/job:worker/replica:0/task:0";
+
+class GrpcWorkerTest : public ::testing::Test {
+ protected:
+  GrpcWorkerTest()
+      : compute_pool_(Env::Default(), "grpc_worker_test", /*num_threads=*/2) {
+    std::vector<std::unique_ptr<Device>> devices;
+    devices.push_back(
+        DeviceFactory::NewDevice("CPU", SessionOptions(), kWorkerName));
+    device_ = devices[0].get();
+    device_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(devices));
+    env_.env = Env::Default();
+    env_.device_mgr = device_mgr_.get();
+    env_.compute_pool = &compute_pool_;
+    rendezvous_mgr_ = absl::make_unique<RpcRendezvousMgr>(&env_);
+    env_.rendezvous_mgr = rendezvous_mgr_.get();
+    worker_session_ = absl::make_unique<WorkerSession>(
+        "grpc_worker_test", kWorkerName,
+        std::unique_ptr<WorkerCacheInterface>(new TestWorkerCache),
+        std::unique_ptr<DeviceMgr>(), std::unique_ptr<GraphMgr>(),
+        /*remote_device_mgr=*/nullptr);
+  }
+
+  std::unique_ptr<GrpcWorker> NewWorker(bool cache_rpc_response) {
+    ConfigProto config;
+    config.mutable_rpc_options()->set_cache_rpc_response(cache_rpc_response);
+    return NewGrpcWorker(&env_, config);
+  }
+
+  string Key(const string& name) {
+    return Rendezvous::CreateKey(device_->name(),
+                                 device_->attributes().incarnation(),
+                                 device_->name(), name, FrameAndIter(0, 0));
+  }
+
+  RecvTensorRequest MakeRequest(int64 step_id, int64 request_id,
+                                const string& name) {
+    RecvTensorRequest request;
+    request.set_step_id(step_id);
+    request.set_request_id(request_id);
+    request.set_rendezvous_key(Key(name));
+    return request;
+  }
+
+  // Produces the tensor `name` of step `step_id` on the worker.
+  void Send(int64 step_id, const string& name, const Tensor& tensor) {
+    RemoteRendezvous* rendez = rendezvous_mgr_->Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_ASSERT_OK(rendez->Initialize(worker_session_.get()));
+    Rendezvous::ParsedKey parsed;
+    TF_ASSERT_OK(Rendezvous::ParseKey(Key(name), &parsed));
+    TF_ASSERT_OK(rendez->Send(parsed, Rendezvous::Args(), tensor,
+                              /*is_dead=*/false));
+  }
+
+  Status BatchRecvTensor(GrpcWorker* worker,
+                         const BatchRecvTensorRequest& request,
+                         BatchRecvTensorResponse* response) {
+    CallOptions opts;
+    Notification n;
+    Status status;
+    worker->BatchRecvTensorAsync(&opts, &request, response,
+                                 [&n, &status](const Status& s) {
+                                   status = s;
+                                   n.Notify();
+                                 });
+    n.WaitForNotification();
+    return status;
+  }
+
+  thread::ThreadPool compute_pool_;
+  Device* device_;  // Owned by device_mgr_.
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<RpcRendezvousMgr> rendezvous_mgr_;
+  WorkerEnv env_;
+  std::unique_ptr<WorkerSession> worker_session_;
+};
+
+void ExpectReadyTensor(const BatchRecvTensorResponse::Result& result,
+                       const Tensor& expected) {
+  ASSERT_TRUE(result.ready());
+  EXPECT_EQ(result.status_code(), error::OK);
+  EXPECT_TRUE(result.response().require_ack());
+  Tensor tensor;
+  ASSERT_TRUE(tensor.FromProto(result.response().tensor()));
+  test::ExpectTensorEqual<float>(tensor, expected);
+}
+
+TEST_F(GrpcWorkerTest, BatchRecvTensorRequiresResponseCache) {
+  std::unique_ptr<GrpcWorker> worker = NewWorker(false);
+  BatchRecvTensorRequest request;
+  *request.add_request() = MakeRequest(1, 1, "a");
+  BatchRecvTensorResponse response;
+  EXPECT_TRUE(errors::IsUnimplemented(
+      BatchRecvTensor(worker.get(), request, &response)));
+}
+
+TEST_F(GrpcWorkerTest, BatchRecvTensorReturnsReadyTensors) {
+  std::unique_ptr<GrpcWorker> worker = NewWorker(true);
+  const Tensor a = test::AsTensor<float>({1, 2});
+  const Tensor b = test::AsTensor<float>({3});
+  Send(1, "a", a);
+  Send(1, "b", b);
+
+  BatchRecvTensorRequest request;
+  *request.add_request() = MakeRequest(1, 1, "a");
+  *request.add_request() = MakeRequest(1, 2, "b");
+  request.set_max_delay_micros(60 * 1000 * 1000);
+  request.set_max_tensor_bytes(1024);
+  BatchRecvTensorResponse response;
+  TF_ASSERT_OK(BatchRecvTensor(worker.get(), request, &response));
+  ASSERT_EQ(response.result_size(), 2);
+  ExpectReadyTensor(response.result(0), a);
+  ExpectReadyTensor(response.result(1), b);
+}
+
+TEST_F(GrpcWorkerTest, BatchRecvTensorRepliesAfterDelay) {
+  std::unique_ptr<GrpcWorker> worker = NewWorker(true);
+  const Tensor a = test::AsTensor<float>({1, 2});
+  const Tensor b = test::AsTensor<float>({3});
+  Send(1, "a", a);
+
+  // "b" is not produced, so the reply is sent once the delay has passed
+  // since "a" became available.
+  BatchRecvTensorRequest request;
+  *request.add_request() = MakeRequest(1, 1, "a");
+  *request.add_request() = MakeRequest(1, 2, "b");
+  request.set_max_delay_micros(1000);
+  request.set_max_tensor_bytes(1024);
+  BatchRecvTensorResponse response;
+  TF_ASSERT_OK(BatchRecvTensor(worker.get(), request, &response));
+  ASSERT_EQ(response.result_size(), 2);
+  ExpectReadyTensor(response.result(0), a);
+  EXPECT_FALSE(response.result(1).ready());
+
+  // "b" stays in the response cache, which serves a later call with the same
+  // request_id.
+  Send(1, "b", b);
+  BatchRecvTensorRequest retry;
+  *retry.add_request() = MakeRequest(1, 2, "b");
+  retry.set_max_delay_micros(1000);
+  retry.set_max_tensor_bytes(1024);
+  BatchRecvTensorResponse retry_response;
+  TF_ASSERT_OK(BatchRecvTensor(worker.get(), retry, &retry_response));
+  ASSERT_EQ(retry_response.result_size(), 1);
+  ExpectReadyTensor(retry_response.result(0), b);
+}
+
+TEST_F(GrpcWorkerTest, BatchRecvTensorLeavesLargeTensorsInCache) {
+  std::unique_ptr<GrpcWorker> worker = NewWorker(true);
+  const Tensor a = test::AsTensor<float>({1, 2, 3, 4, 5, 6, 7, 8});
+  Send(1, "a", a);
+
+  BatchRecvTensorRequest request;
+  *request.add_request() = MakeRequest(1, 1, "a");
+  request.set_max_delay_micros(1000);
+  request.set_max_tensor_bytes(a.TotalBytes() - 1);
+  BatchRecvTensorResponse response;
+  TF_ASSERT_OK(BatchRecvTensor(worker.get(), request, &response));
+  ASSERT_EQ(response.result_size(), 1);
+  EXPECT_FALSE(response.result(0).ready());
+
+  request.set_max_tensor_bytes(a.TotalBytes());
+  response.Clear();
+  TF_ASSERT_OK(BatchRecvTensor(worker.get(), request, &response));
+  ASSERT_EQ(response.result_size(), 1);
+  ExpectReadyTensor(response.result(0), a);
+}
+
+TEST_F(GrpcWorkerTest, BatchRecvTensorReturnsErrorsPerCall) {
+  std::unique_ptr<GrpcWorker> worker = NewWorker(true);
+  const Tensor a = test::AsTensor<float>({1, 2});
+  Send(1, "a", a);
+
+  BatchRecvTensorRequest request;
+  *request.add_request() = MakeRequest(1, 1, "a");
+  RecvTensorRequest* unknown_device = request.add_request();
+  unknown_device->set_step_id(1);
+  unknown_device->set_request_id(2);
+  unknown_device->set_rendezvous_key(Rendezvous::CreateKey(
+      strings::StrCat(kWorkerName, "/device:CPU:7"), 1, device_->name(), "b",
+      FrameAndIter(0, 0)));
+  request.set_max_delay_micros(60 * 1000 * 1000);
+  request.set_max_tensor_bytes(1024);
+  BatchRecvTensorResponse response;
+  TF_ASSERT_OK(BatchRecvTensor(worker.get(), request, &response));
+  ASSERT_EQ(response.result_size(), 2);
+  ExpectReadyTensor(response.result(0), a);
+  EXPECT_TRUE(response.result(1).ready());
+  EXPECT_NE(response.result(1).status_code(), error::OK);
+}
+
+// Serves a GrpcWorker over a local port, and receives from it through a
+// GrpcRemoteWorker that batches its RecvTensor calls.
+class GrpcRecvTensorBatcherTest : public GrpcWorkerTest {
+ protected:
+  void StartServer(bool cache_rpc_response) {
+    worker_ = NewWorker(cache_rpc_response);
+    const string address =
+        strings::StrCat("localhost:", testing::PickUnusedPortOrDie());
+    ::grpc::ServerBuilder builder;
+    builder.AddListeningPort(address, ::grpc::InsecureServerCredentials());
+    service_ = NewGrpcWorkerService(worker_.get(), &builder);
+    server_ = builder.BuildAndStart();
+    serving_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "grpc_worker_service",
+        [this]() { service_->HandleRPCsLoop(); }));
+
+    setenv("GRPC_RECV_TENSOR_BATCH_WINDOW_MICROS", "10000", /*overwrite=*/1);
+    SharedGrpcChannelPtr channel =
+        ::grpc::CreateChannel(address, ::grpc::InsecureChannelCredentials());
+    grpc_worker_env_ = absl::make_unique<GrpcWorkerEnv>(
+        /*num_completion_queues=*/1, /*num_threads=*/2);
+    std::shared_ptr<GrpcRecvTensorBatcher> batcher = NewGrpcRecvTensorBatcher(
+        channel, grpc_worker_env_->GetCompletionQueue(0),
+        grpc_worker_env_->GetThreadPool(), address);
+    ASSERT_NE(batcher, nullptr);
+    remote_worker_.reset(NewGrpcRemoteWorker(
+        channel, grpc_worker_env_->GetCompletionQueue(0),
+        grpc_worker_env_->GetThreadPool(), &logger_, address, batcher));
+  }
+
+  void TearDown() override {
+    remote_worker_.reset();
+    grpc_worker_env_.reset();
+    if (server_ != nullptr) {
+      server_->Shutdown();
+      service_->Shutdown();
+      serving_thread_.reset();
+    }
+  }
+
+  // A RecvTensor call on the remote worker.
+  struct Call {
+    RecvTensorRequest request;
+    TensorResponse response;
+    CallOptions opts;
+    Notification done;
+    Status status;
+  };
+
+  void StartRecv(int64 step_id, int64 request_id, const string& name,
+                 Call* call) {
+    call->request = MakeRequest(step_id, request_id, name);
+    call->response.InitAlloc(device_, AllocatorAttributes());
+    remote_worker_->RecvTensorAsync(&call->opts, &call->request,
+                                    &call->response, [call](const Status& s) {
+                                      call->status = s;
+                                      call->done.Notify();
+                                    });
+  }
+
+  std::unique_ptr<GrpcWorker> worker_;
+  std::unique_ptr<AsyncServiceInterface> service_;
+  std::unique_ptr<::grpc::Server> server_;
+  std::unique_ptr<Thread> serving_thread_;
+  std::unique_ptr<GrpcWorkerEnv> grpc_worker_env_;
+  WorkerCacheLogger logger_;
+  std::unique_ptr<WorkerInterface> remote_worker_;
+};
+
+TEST_F(GrpcRecvTensorBatcherTest, BatchesCalls) {
+  StartServer(/*cache_rpc_response=*/true);
+  const Tensor a = test::AsTensor<float>({1, 2});
+  const Tensor b = test::AsTensor<float>({3});
+  Call call_a;
+  Call call_b;
+  StartRecv(1, 1, "a", &call_a);
+  StartRecv(1, 2, "b", &call_b);
+  Send(1, "a", a);
+  Send(1, "b", b);
+
+  call_a.done.WaitForNotification();
+  call_b.done.WaitForNotification();
+  TF_ASSERT_OK(call_a.status);
+  TF_ASSERT_OK(call_b.status);
+  test::ExpectTensorEqual<float>(call_a.response.tensor(), a);
+  test::ExpectTensorEqual<float>(call_b.response.tensor(), b);
+}
+
+TEST_F(GrpcRecvTensorBatcherTest, CallCancelledBeforeBatchReply) {
+  StartServer(/*cache_rpc_response=*/true);
+  const Tensor a = test::AsTensor<float>({1, 2});
+  const Tensor b = test::AsTensor<float>({3});
+  auto call_a = absl::make_unique<Call>();
+  Call call_b;
+  StartRecv(1, 1, "a", call_a.get());
+  StartRecv(1, 2, "b", &call_b);
+
+  // Nothing is produced yet, so the batch cannot have been answered.
+  call_a->opts.StartCancel();
+  call_a->done.WaitForNotification();
+  EXPECT_TRUE(errors::IsCancelled(call_a->status));
+  // Like the rendezvous, which frees or reuses the request once the call is
+  // done.
+  call_a.reset();
+
+  Send(1, "a", a);
+  Send(1, "b", b);
+  call_b.done.WaitForNotification();
+  TF_ASSERT_OK(call_b.status);
+  test::ExpectTensorEqual<float>(call_b.response.tensor(), b);
+}
+
+TEST_F(GrpcRecvTensorBatcherTest, FallsBackWithoutResponseCache) {
+  StartServer(/*cache_rpc_response=*/false);
+  const Tensor a = test::AsTensor<float>({1, 2});
+  const Tensor b = test::AsTensor<float>({3});
+  Send(1, "a", a);
+  Send(1, "b", b);
+
+  // The first call is batched, answered UNIMPLEMENTED and reissued on its
+  // own.  The second one is not batched any more.
+  Call call_a;
+  StartRecv(1, 1, "a", &call_a);
+  call_a.done.WaitForNotification();
+  TF_ASSERT_OK(call_a.status);
+  test::ExpectTensorEqual<float>(call_a.response.tensor(), a);
+
+  Call call_b;
+  StartRecv(1, 2, "b", &call_b);
+  call_b.done.WaitForNotification();
+  TF_ASSERT_OK(call_b.status);
+  test::ExpectTensorEqual<float>(call_b.response.tensor(), b);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -267,6 +267,24 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_require_ack(v != 0);
         break;
       }
+      case RecvTensorResponse::kPartialFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_partial(v != 0);
+        break;
+      }
+      case RecvTensorResponse::kTensorChunkFieldNumber: {
+        // The first chunk of a partial response is read straight into the
+        // tensor allocated for the content-less tensor submessage.
+        if (wt != WIRETYPE_LENGTH_DELIMITED || !meta_.partial()) return false;
+        int num_bytes;
+        if (!ReadVarintSizeAsInt(&input, &num_bytes)) return false;
+        StringPiece buf = tensor_.tensor_data();
+        if (static_cast<size_t>(num_bytes) > buf.size()) return false;
+        if (!input.ReadRaw(const_cast<char*>(buf.data()), num_bytes))
+          return false;
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -287,6 +305,13 @@ bool TensorResponse::ParseSlow(Source* source) {
     return false;
   }
   tensor_ = std::move(parsed);
+  if (meta_.partial()) {
+    StringPiece buf = tensor_.tensor_data();
+    if (meta_.tensor_chunk().size() > buf.size()) return false;
+    memcpy(const_cast<char*>(buf.data()), meta_.tensor_chunk().data(),
+           meta_.tensor_chunk().size());
+    meta_.clear_tensor_chunk();
+  }
 
   // Reduce memory usage for big tensors.
   {
@@ -91,6 +91,9 @@ class TensorResponse {
   // Return pointer to the device hosting the tensor.
   DeviceBase* device() const { return device_; }
 
+  // Return true if the tensor is allocated in host memory.
+  bool on_host() const { return on_host_; }
+
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
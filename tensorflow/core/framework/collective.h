@@ -144,6 +144,12 @@ struct CollectiveParams {
   std::vector<int> subdiv_rank;
   std::unique_ptr<OpKernel> merge_op;  // reduction only
   std::unique_ptr<OpKernel> final_op;  // reduction only
+  // Set for reductions that compress the values they transmit.  encode_op
+  // converts a chunk to its wire format, decode_op converts it back and
+  // decode_merge_op converts it back and merges it, in a single pass.
+  std::unique_ptr<OpKernel> encode_op;        // reduction only
+  std::unique_ptr<OpKernel> decode_op;        // reduction only
+  std::unique_ptr<OpKernel> decode_merge_op;  // reduction only
   string ToString() const;
 };
 
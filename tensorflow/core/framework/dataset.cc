@@ -461,6 +461,12 @@ Status DatasetBase::InputDatasets(
                                type_string());
 }
 
+Status DatasetBase::Get(IteratorContext* ctx, int64 index,
+                        std::vector<Tensor>* out_tensors) const {
+  return errors::Unimplemented("Random access is not supported by ",
+                               type_string());
+}
+
 Status DatasetBase::DatasetGraphDefBuilder::AddInputDataset(
     SerializationContext* ctx, const DatasetBase* dataset, Node** output) {
   Status status = dataset->AsGraphDefInternal(ctx, this, output);
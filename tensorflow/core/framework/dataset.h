@@ -876,6 +876,17 @@ class DatasetBase : public core::RefCounted {
   // state. Otherwise, the method returns `Status::OK()`.
   virtual Status CheckExternalState() const = 0;
 
+  // Indicates whether the dataset supports random access through `Get`.
+  virtual bool SupportsRandomAccess() const { return false; }
+
+  // Stores the `index`th element of the dataset in `*out_tensors`, where
+  // `index` is in `[0, Cardinality())`. Random access lets a transformation
+  // read the elements of its input in any order without iterating over it
+  // (e.g. to shuffle the input globally). Datasets that implement it must
+  // also override `SupportsRandomAccess` and have a known cardinality.
+  virtual Status Get(IteratorContext* ctx, int64 index,
+                     std::vector<Tensor>* out_tensors) const;
+
  protected:
   friend Status AsGraphDef(
       OpKernelContext* ctx, const DatasetBase* dataset,
@@ -1025,6 +1036,22 @@ class DatasetBaseIterator : public IteratorBase {
     }
   }
 
+  // When modeling is enabled, this method records the fact that this iterator
+  // has started producing an element for an internal buffer.
+  void RecordInFlightStart(IteratorContext* ctx) {
+    if (collect_resource_usage(ctx)) {
+      node_->record_in_flight_event(1);
+    }
+  }
+
+  // When modeling is enabled, this method records the fact that this iterator
+  // has finished producing an element for an internal buffer.
+  void RecordInFlightEnd(IteratorContext* ctx) {
+    if (collect_resource_usage(ctx)) {
+      node_->record_in_flight_event(-1);
+    }
+  }
+
   // When modeling is enabled, this method records the fact that this iterator
   // has produced an element and its size in bytes.
   void RecordElement(IteratorContext* ctx, std::vector<Tensor>* out_tensors) {
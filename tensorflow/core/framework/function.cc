@@ -1172,6 +1172,23 @@ Status FunctionCallFrame::SetRetval(int index, const Tensor& val) {
   return Status::OK();
 }
 
+bool FunctionCallFrame::GetRetvalBuffer(int index, DataType dtype,
+                                        const TensorShape& shape,
+                                        Tensor* buffer) {
+  if (index < 0 || static_cast<size_t>(index) >= retval_buffers_.size()) {
+    return false;
+  }
+  Tensor& retval_buffer = retval_buffers_[index];
+  if (!retval_buffer.IsInitialized() || retval_buffer.dtype() != dtype ||
+      retval_buffer.shape() != shape || !retval_buffer.IsAligned()) {
+    return false;
+  }
+  // Each buffer is handed out once.
+  *buffer = std::move(retval_buffer);
+  retval_buffer = Tensor();
+  return true;
+}
+
 FunctionLibraryDefinition::FunctionDefAndOpRegistration::
     FunctionDefAndOpRegistration(const FunctionDef& fdef_in)
     : fdef(fdef_in),
@@ -289,6 +289,16 @@ class CallFrameInterface {
   virtual bool CanConsumeArg(int index) const { return false; }
 
   virtual Status SetRetval(int index, const Tensor& val) = 0;
+
+  // Returns true and sets `*buffer` to a caller-provided tensor if the caller
+  // asked for the retval `index` to be produced in that tensor, and it has
+  // type `dtype` and shape `shape`. A kernel whose output is only consumed by
+  // the retval may then allocate its output there, instead of having it
+  // copied by the caller afterwards.
+  virtual bool GetRetvalBuffer(int index, DataType dtype,
+                               const TensorShape& shape, Tensor* buffer) {
+    return false;
+  }
 };
 
 // Represents a function call frame. I.e., the data structure used to
@@ -310,12 +320,20 @@ class FunctionCallFrame : public CallFrameInterface {
   // false it will fail if any of the retvals do not have a value.
   Status ConsumeRetvals(std::vector<Tensor>* rets, bool allow_dead_tensors);
 
+  // Offers `buffers[i]`, if initialized, as the buffer of the ith retval. See
+  // GetRetvalBuffer().
+  void SetRetvalBuffers(std::vector<Tensor> buffers) {
+    retval_buffers_ = std::move(buffers);
+  }
+
   size_t num_args() const override { return arg_types_.size(); }
   size_t num_retvals() const override { return ret_types_.size(); }
 
   // Callee methods.
   Status GetArg(int index, const Tensor** val) override;
   Status SetRetval(int index, const Tensor& val) override;
+  bool GetRetvalBuffer(int index, DataType dtype, const TensorShape& shape,
+                       Tensor* buffer) override;
 
  private:
   DataTypeVector arg_types_;
@@ -326,6 +344,7 @@ class FunctionCallFrame : public CallFrameInterface {
     Tensor val;
   };
   gtl::InlinedVector<Retval, 4> rets_;
+  std::vector<Tensor> retval_buffers_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FunctionCallFrame);
 };
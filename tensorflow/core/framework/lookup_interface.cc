@@ -79,6 +79,18 @@ Status LookupInterface::CheckKeyTensorForRemove(const Tensor& keys) {
   return CheckKeyShape(keys.shape());
 }
 
+Status LookupInterface::ExportDelta(OpKernelContext* ctx) {
+  return errors::Unimplemented("This table does not track its changes: ",
+                               DebugString());
+}
+
+Status LookupInterface::ImportDelta(OpKernelContext* ctx, const Tensor& keys,
+                                    const Tensor& values,
+                                    const Tensor& removed_keys) {
+  return errors::Unimplemented("This table does not track its changes: ",
+                               DebugString());
+}
+
 Status LookupInterface::CheckFindArguments(const Tensor& key,
                                            const Tensor& default_value) {
   TF_RETURN_IF_ERROR(CheckKeyAndValueTypes(key, default_value));
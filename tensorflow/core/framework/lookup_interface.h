@@ -91,6 +91,21 @@ class LookupInterface : public ResourceBase {
   virtual Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                               const Tensor& values) = 0;
 
+  // Exports the entries inserted or updated since the last export or import
+  // to tensors named keys and values, and the keys removed since then to a
+  // tensor named removed_keys.  Applying them with ImportDelta to a table
+  // holding the contents of that last export or import reproduces the current
+  // contents.
+
+  // Returns the following statuses:
+  // - OK: when the export finishes successfully.
+  // - Unimplemented: if the table does not track its changes.
+  virtual Status ExportDelta(OpKernelContext* ctx);
+
+  // Imports changes exported by ExportDelta on top of the current contents.
+  virtual Status ImportDelta(OpKernelContext* ctx, const Tensor& keys,
+                             const Tensor& values, const Tensor& removed_keys);
+
   // Returns the data type of the key.
   virtual DataType key_dtype() const = 0;
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -80,6 +81,19 @@ auto* tf_data_bytes_fetched_counter = monitoring::Counter<0>::New(
 auto* tf_data_elements_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/elements", "tf.data elements", "name");
 
+auto* tf_data_processing_time_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/processing_time",
+    "The number of microseconds spent by a tf.data Dataset on producing "
+    "elements.",
+    "name");
+
+auto* tf_data_buffer_utilization_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/data/buffer_utilization",
+     "The fraction of the buffer of a tf.data Dataset that is filled.", "name"},
+    // Buckets of 10% of the buffer up to a full buffer.
+    {monitoring::Buckets::Explicit(
+        {0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 1.})});
+
 auto* tf_data_experiment_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/experiment",
     "The number of times tf.data experiment is applied to input pipelines.",
@@ -158,6 +172,110 @@ auto* bfc_allocator_delay =
                                 "The total time spent running each graph "
                                 "optimization pass in microseconds.");
 
+auto* run_handler_requests = monitoring::Counter<1>::New(
+    "/tensorflow/core/run_handler/requests",
+    "The number of requests that ran on the run handler thread pool.",
+    "priority_class");
+
+auto* run_handler_request_time_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/run_handler/request_time_usecs",
+    "The total time requests held a run handler in microseconds.",
+    "priority_class");
+
+auto* run_handler_missed_deadlines = monitoring::Counter<1>::New(
+    "/tensorflow/core/run_handler/missed_deadlines",
+    "The number of run handler requests that finished after their deadline.",
+    "priority_class");
+
+auto* run_handler_starved_tasks = monitoring::Counter<1>::New(
+    "/tensorflow/core/run_handler/starved_tasks",
+    "The number of tasks the run handler thread pool ran ahead of higher "
+    "priority work because their request was starving.",
+    "priority_class");
+
+auto* executor_kernel_reclassifications = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor/kernel_reclassifications",
+    "The number of times executors changed the scheduling of a kernel after "
+    "timing its executions.",
+    "scheduling");
+
+auto* thread_pool_tasks = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/core/thread_pool/tasks",
+    "The number of closures run by the threads of each thread pool since it "
+    "was created.",
+    "pool");
+
+auto* thread_pool_busy_usecs = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/core/thread_pool/busy_usecs",
+    "The time the threads of each thread pool spent running closures since "
+    "it was created, in microseconds.",
+    "pool");
+
+auto* thread_pool_threads = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/core/thread_pool/threads",
+    "The number of threads of each thread pool.", "pool");
+
+auto* cpu_huge_page_bytes = monitoring::Gauge<int64, 0>::New(
+    "/tensorflow/core/cpu_allocator/huge_page_bytes",
+    "The number of bytes the CPU allocators currently hold in huge pages.");
+
+auto* collective_ops = monitoring::Counter<2>::New(
+    "/tensorflow/core/collective/ops",
+    "The number of collective instances executed by this process.",
+    "group_key", "instance_key");
+
+auto* collective_op_time_usecs = monitoring::Counter<2>::New(
+    "/tensorflow/core/collective/op_time_usecs",
+    "The total time spent executing collective instances in microseconds.",
+    "group_key", "instance_key");
+
+auto* collective_ring_step_time_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/collective/ring_step_time_usecs_histogram",
+     "The time a ring collective spent on a single step of one tensor chunk, "
+     "from issuing its receive to completing its send, in microseconds.",
+     "collective_name"},
+    // Power of 2 with bucket count 24 (> 16 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* collective_peer_recv_wait_usecs = monitoring::Counter<2>::New(
+    "/tensorflow/core/collective/peer_recv_wait_usecs",
+    "The total time collectives spent waiting on RecvFromPeer for data from "
+    "each peer device in microseconds.",
+    "group_key", "peer_device");
+
+auto* collective_peer_recv_bytes = monitoring::Counter<2>::New(
+    "/tensorflow/core/collective/peer_recv_bytes",
+    "The number of bytes collectives received from each peer device.",
+    "group_key", "peer_device");
+
+auto* collective_peer_send_bytes = monitoring::Counter<2>::New(
+    "/tensorflow/core/collective/peer_send_bytes",
+    "The number of bytes collectives sent to each peer device.",
+    "group_key", "peer_device");
+
+auto* serving_step_time_usecs_histogram = monitoring::Sampler<3>::New(
+    {"/tensorflow/serving/step_time_usecs",
+     "The time a serving step spent in each phase in microseconds.",
+     "model_name", "signature_name", "phase"},
+    // Power of 2 with bucket count 24 (> 16 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+const char* ServingPhaseLabel(ServingPhase phase) {
+  switch (phase) {
+    case ServingPhase::kQueue:
+      return "queue";
+    case ServingPhase::kGraphExecution:
+      return "graph_execution";
+    case ServingPhase::kDeviceCompute:
+      return "device_compute";
+    case ServingPhase::kHostDeviceCopy:
+      return "host_device_copy";
+    case ServingPhase::kBatchWait:
+      return "batch_wait";
+  }
+  return "unknown";
+}
+
 }  // namespace
 
 void RecordTFDataAutotune(const string& name) {
@@ -180,6 +298,14 @@ monitoring::CounterCell* GetTFDataElementsCounter(const string& name) {
   return tf_data_elements_counter->GetCell(name);
 }
 
+monitoring::CounterCell* GetTFDataProcessingTimeCounter(const string& name) {
+  return tf_data_processing_time_counter->GetCell(name);
+}
+
+monitoring::SamplerCell* GetTFDataBufferUtilizationSampler(const string& name) {
+  return tf_data_buffer_utilization_histogram->GetCell(name);
+}
+
 void RecordTFDataBytesFetched(int64 num_bytes) {
   tf_data_bytes_fetched_counter->GetCell()->IncrementBy(num_bytes);
 }
@@ -305,5 +431,75 @@ void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
 
+void RecordRunHandlerRequest(const string& priority_class,
+                             const uint64 latency_usecs, bool missed_deadline) {
+  run_handler_requests->GetCell(priority_class)->IncrementBy(1);
+  run_handler_request_time_usecs->GetCell(priority_class)
+      ->IncrementBy(latency_usecs);
+  if (missed_deadline) {
+    run_handler_missed_deadlines->GetCell(priority_class)->IncrementBy(1);
+  }
+}
+
+void RecordRunHandlerStarvedTask(const string& priority_class) {
+  run_handler_starved_tasks->GetCell(priority_class)->IncrementBy(1);
+}
+
+void RecordExecutorKernelReclassification(bool expensive) {
+  static auto* inline_cell =
+      executor_kernel_reclassifications->GetCell("inline");
+  static auto* thread_pool_cell =
+      executor_kernel_reclassifications->GetCell("thread_pool");
+  (expensive ? thread_pool_cell : inline_cell)->IncrementBy(1);
+}
+
+void RecordCollectiveOp(const string& group_key, const string& instance_key,
+                        const uint64 running_time_usecs) {
+  collective_ops->GetCell(group_key, instance_key)->IncrementBy(1);
+  collective_op_time_usecs->GetCell(group_key, instance_key)
+      ->IncrementBy(running_time_usecs);
+}
+
+void RecordCollectiveRingStep(const string& collective_name,
+                              const uint64 step_time_usecs) {
+  collective_ring_step_time_usecs_histogram->GetCell(collective_name)
+      ->Add(step_time_usecs);
+}
+
+void RecordCollectivePeerRecv(const string& group_key,
+                              const string& peer_device, const int64 num_bytes,
+                              const uint64 wait_usecs) {
+  collective_peer_recv_bytes->GetCell(group_key, peer_device)
+      ->IncrementBy(num_bytes);
+  collective_peer_recv_wait_usecs->GetCell(group_key, peer_device)
+      ->IncrementBy(wait_usecs);
+}
+
+void RecordCollectivePeerSend(const string& group_key,
+                              const string& peer_device,
+                              const int64 num_bytes) {
+  collective_peer_send_bytes->GetCell(group_key, peer_device)
+      ->IncrementBy(num_bytes);
+}
+
+void UpdateThreadPoolUtilization(const thread::ThreadPool& pool) {
+  const thread::ThreadPool::Stats stats = pool.GetStats();
+  thread_pool_tasks->GetCell(pool.name())->Set(stats.num_tasks);
+  thread_pool_busy_usecs->GetCell(pool.name())->Set(stats.busy_micros);
+  thread_pool_threads->GetCell(pool.name())->Set(pool.NumThreads());
+}
+
+void SetCPUHugePageBytes(const int64 bytes) {
+  cpu_huge_page_bytes->GetCell()->Set(bytes);
+}
+
+void RecordServingStepTime(const string& model_name,
+                           const string& signature_name, ServingPhase phase,
+                           const uint64 time_usecs) {
+  serving_step_time_usecs_histogram
+      ->GetCell(model_name, signature_name, ServingPhaseLabel(phase))
+      ->Add(time_usecs);
+}
+
 }  // namespace metrics
 }  // namespace tensorflow
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
 
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -53,6 +55,19 @@ monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name);
 // The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
 monitoring::CounterCell* GetTFDataElementsCounter(const string& name);
 
+// Returns a counter that can be used to record the number of microseconds
+// spent by the threads of a tf.data.Dataset on producing elements, excluding
+// the time spent waiting for their inputs or for buffer space.
+//
+// The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
+monitoring::CounterCell* GetTFDataProcessingTimeCounter(const string& name);
+
+// Returns a sampler that can be used to record the fraction of the buffer of
+// an asynchronous tf.data.Dataset that is filled with elements.
+//
+// The `name` argument identifies the Dataset type (e.g. "Prefetch").
+monitoring::SamplerCell* GetTFDataBufferUtilizationSampler(const string& name);
+
 // Records the number of bytes fetched from tf.data.Dataset iterator.
 void RecordTFDataBytesFetched(int64 num_bytes);
 
@@ -129,6 +144,81 @@ void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 // Increment the number of jobs that failed during import to mlir.
 void IncrementMLIRImportFailureCount();
 
+// Records that a request of the given RunHandlerPoolOptions priority class
+// released its run handler, `latency_usecs` after getting it.
+void RecordRunHandlerRequest(const string& priority_class,
+                             const uint64 latency_usecs, bool missed_deadline);
+
+// Records that the run handler thread pool ran a task of a request of the
+// given priority class ahead of higher priority work, because the request
+// was starving.
+void RecordRunHandlerStarvedTask(const string& priority_class);
+
+// Records that an executor started to schedule a kernel as expensive, i.e. on
+// its thread pool, or as inexpensive, i.e. inline, after its sampled execution
+// times changed its cost estimate.
+void RecordExecutorKernelReclassification(bool expensive);
+
+// Records that a collective instance of the given group completed
+// `running_time_usecs` after it started executing.
+void RecordCollectiveOp(const string& group_key, const string& instance_key,
+                        const uint64 running_time_usecs);
+
+// Records the duration of one step of a ring collective, i.e. one pass of a
+// tensor chunk through receive, reduction and send.
+//
+// The `collective_name` argument identifies the implementation (e.g.
+// "RingReduce").
+void RecordCollectiveRingStep(const string& collective_name,
+                              const uint64 step_time_usecs);
+
+// Records that a collective of the given group received `num_bytes` from
+// `peer_device`, `wait_usecs` after it issued the RecvFromPeer.
+void RecordCollectivePeerRecv(const string& group_key,
+                              const string& peer_device, const int64 num_bytes,
+                              const uint64 wait_usecs);
+
+// Records that a collective of the given group sent `num_bytes` to
+// `peer_device`.
+void RecordCollectivePeerSend(const string& group_key,
+                              const string& peer_device,
+                              const int64 num_bytes);
+
+// Updates the utilization of `pool`, labeled with its name. The busy time
+// divided by the number of threads and the wall time gives the fraction of
+// the time the threads of the pool were running closures rather than spinning
+// or parked.
+void UpdateThreadPoolUtilization(const thread::ThreadPool& pool);
+
+// Sets the number of bytes the CPU allocators currently hold in huge pages.
+void SetCPUHugePageBytes(const int64 bytes);
+
+// The phases of a serving step whose time is recorded by
+// RecordServingStepTime. Their labels in the metric are stable:
+enum class ServingPhase {
+  // "queue": waiting for a run handler to run the step.
+  kQueue,
+  // "graph_execution": executing the graph, from the start to the end of the
+  // step.
+  kGraphExecution,
+  // "device_compute": running kernels on accelerators.
+  kDeviceCompute,
+  // "host_device_copy": copying tensors between the host and accelerators.
+  kHostDeviceCopy,
+  // "batch_wait": waiting in a batching queue for the batch to be processed.
+  kBatchWait,
+};
+
+// Records that a serving step of the model and signature spent
+// `time_usecs` microseconds in `phase`.
+//
+// The `model_name` argument is the name in the SessionMetadata of the session
+// and the `signature_name` argument the one in the RunOptions of the step, or
+// empty if it is not known (e.g. to the batching ops).
+void RecordServingStepTime(const string& model_name,
+                           const string& signature_name, ServingPhase phase,
+                           const uint64 time_usecs);
+
 }  // namespace metrics
 }  // namespace tensorflow
 
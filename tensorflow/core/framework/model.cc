@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "absl/time/clock.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/mem.h"
 
 namespace tensorflow {
 namespace data {
@@ -28,6 +29,13 @@ namespace {
 // Wrapper for the square function to reduce verbosity.
 inline double Square(double x) { return x * x; }
 
+// Returns true if `parameter` only sizes a buffer. Such parameters are only
+// incremented by the search algorithms for a significant improvement in output
+// time, since every increment costs memory.
+inline bool IsBufferParameter(const Parameter& parameter) {
+  return parameter.name == kBufferSize || parameter.name == kBufferedBlocks;
+}
+
 // The first input of InterleaveMany corresponds to the input dataset whose
 // elements are used to create the (derived) input datasets whose elements are
 // interleaved as output.
@@ -226,6 +234,10 @@ class AsyncInterleaveMany : public Node {
     if (parameter) {
       parallelism = std::min(parallelism, (*parameter)->value);
     }
+    // Buffering more blocks per input lets the workers run further ahead of
+    // the consumer, which the buffer model sees as a larger buffer.
+    const double buffered_blocks_ratio = BufferedBlocksRatio();
+    const double buffer_size = parallelism * buffered_blocks_ratio;
     double output_time_for_inputs =
         OutputTimeForInputs(*output_times) -
         (*output_times)[inputs_.front()->long_name()];
@@ -236,7 +248,7 @@ class AsyncInterleaveMany : public Node {
       double producer_time_der = 0.0L;
       double consumer_time_der = 0.0L;
       double buffer_size_der = 0.0L;
-      wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
+      wait_time = ComputeWaitTime(producer_time, consumer_time, buffer_size,
                                   &producer_time_der, &consumer_time_der,
                                   &buffer_size_der);
       double inputs_time_der_sum =
@@ -265,10 +277,11 @@ class AsyncInterleaveMany : public Node {
       // Add derivative w.r.t. own parallelism parameter.
       if (parameter && (*parameter)->state->tunable) {
         (*gradients)[long_name()] =
-            buffer_size_der - producer_time_der * producer_time / parallelism;
+            buffer_size_der * buffered_blocks_ratio -
+            producer_time_der * producer_time / parallelism;
       }
     } else {
-      wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
+      wait_time = ComputeWaitTime(producer_time, consumer_time, buffer_size,
                                   /*producer_time_derivative=*/nullptr,
                                   /*consumer_time_derivative=*/nullptr,
                                   /*buffer_size_derivative=*/nullptr);
@@ -944,6 +957,28 @@ void Node::FlushMetrics() {
   metrics_.record_bytes_consumed(bytes_consumed_);
   metrics_.record_bytes_produced(bytes_produced_);
   metrics_.record_num_elements(num_elements_);
+  metrics_.record_processing_time(processing_time_);
+}
+
+void Node::RecordBufferUtilization() {
+  if (!record_metrics_) {
+    return;
+  }
+  double buffer_limit = 0;
+  {
+    tf_shared_lock l(mu_);
+    auto* parameter = gtl::FindOrNull(parameters_, kBufferSize);
+    if (!parameter) {
+      parameter = gtl::FindOrNull(parameters_, kParallelism);
+    }
+    if (parameter) {
+      buffer_limit = (*parameter)->value;
+    }
+  }
+  if (buffer_limit > 0) {
+    metrics_.record_buffer_utilization(
+        std::min(1.0, static_cast<double>(buffered_elements_) / buffer_limit));
+  }
 }
 
 double Node::OutputTime(absl::flat_hash_map<string, double>* input_times,
@@ -1050,6 +1085,14 @@ double Node::AverageBufferedElementSize() const {
          static_cast<double>(buffered_elements_);
 }
 
+double Node::BufferedBlocksRatio() const {
+  auto* parameter = gtl::FindOrNull(parameters_, kBufferedBlocks);
+  if (!parameter || (*parameter)->min <= 0) {
+    return 1.0;
+  }
+  return (*parameter)->value / (*parameter)->min;
+}
+
 double Node::OutputTimeForInputs(
     const absl::flat_hash_map<string, double>& output_times) const {
   double sum = 0;
@@ -1157,7 +1200,14 @@ void Node::CollectTunableParametersHelper(
   }
   for (auto& pair : parameters_) {
     if (pair.second->state->tunable) {
-      parameters->insert(std::make_pair(long_name(), pair.second));
+      // The gradients of the output time are keyed by node, so only the
+      // primary parameter of a node is keyed by the node name. Secondary
+      // parameters are tuned only by the algorithms that search the parameter
+      // space, and stay at their minimum under gradient descent.
+      string key = pair.first == kBufferedBlocks
+                       ? strings::StrCat(long_name(), ":", pair.first)
+                       : long_name();
+      parameters->insert(std::make_pair(std::move(key), pair.second));
     }
   }
 }
@@ -1171,6 +1221,8 @@ void Node::DebugStringHelper(absl::flat_hash_map<string, string>* debug_strings)
                      "\n");
   strings::StrAppend(&result, "  buffered_elements=", buffered_elements_.load(),
                      "\n");
+  strings::StrAppend(&result,
+                     "  elements_in_flight=", elements_in_flight_.load(), "\n");
   strings::StrAppend(&result, "  bytes_consumed=", bytes_consumed_.load(),
                      "\n");
   strings::StrAppend(&result, "  bytes_produced=", bytes_produced_.load(),
@@ -1201,6 +1253,7 @@ std::shared_ptr<Node> Node::SnapshotHelper(
     cloned_current->autotune_.store(autotune_);
     cloned_current->buffered_bytes_.store(buffered_bytes_);
     cloned_current->buffered_elements_.store(buffered_elements_);
+    cloned_current->elements_in_flight_.store(elements_in_flight_);
     cloned_current->bytes_consumed_.store(bytes_consumed_);
     cloned_current->bytes_produced_.store(bytes_produced_);
     cloned_current->num_elements_.store(num_elements_);
@@ -1231,6 +1284,17 @@ void Node::TotalBufferedBytesHelper(
   }
   if (parameter) {
     result = buffered_bytes_;
+    // The elements in flight are expected to be as large as the buffered
+    // elements or, if nothing is buffered, as the elements produced so far.
+    const int64 elements_in_flight = std::max<int64>(elements_in_flight_, 0);
+    if (elements_in_flight > 0) {
+      double element_size = AverageBufferedElementSize();
+      if (element_size == 0 && num_elements_ > 0) {
+        element_size = static_cast<double>(bytes_produced_) /
+                       static_cast<double>(num_elements_);
+      }
+      result += elements_in_flight * element_size;
+    }
   }
   for (auto& input : inputs_) {
     result += total_bytes->at(input->long_name());
@@ -1252,7 +1316,8 @@ void Node::TotalMaximumBufferedBytesHelper(
     parameter = gtl::FindOrNull(parameters_, kParallelism);
   }
   if (parameter) {
-    result = (*parameter)->value * AverageBufferedElementSize();
+    result = (*parameter)->value * BufferedBlocksRatio() *
+             AverageBufferedElementSize();
   }
   for (auto& input : inputs_) {
     result += total_bytes->at(input->long_name());
@@ -1293,6 +1358,10 @@ void Model::FlushMetrics() {
     auto node = queue.front();
     queue.pop_front();
     node->FlushMetrics();
+    // The utilization of the buffers is sampled every time the model flushes
+    // the metrics. This happens after the optimization, which updates the
+    // parameter values read by `RecordBufferUtilization()`.
+    node->RecordBufferUtilization();
     for (auto input : node->inputs()) {
       queue.push_back(input);
     }
@@ -1308,6 +1377,9 @@ void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
     case AutotuneAlgorithm::GRADIENT_DESCENT:
       OptimizeGradientDescent(cpu_budget, ram_budget, model_input_time);
       break;
+    case AutotuneAlgorithm::MEMORY_BOUNDED:
+      OptimizeMemoryBounded(cpu_budget, ram_budget, model_input_time);
+      break;
   }
 }
 
@@ -1441,7 +1513,7 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
   // We add the number of model's buffered bytes because it is excluded from the
   // memory budget, but it is included in the maximum number of buffered bytes.
   ram_budget += TotalBufferedBytes(snapshot);
-  // Buffer size parameter will only be incremented if the output latency
+  // Buffer parameters will only be incremented if the output latency
   // improvement is greater than this constant.
   constexpr double kBufferSizeMinDelta = 1.0L;
 
@@ -1473,7 +1545,7 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
           OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
       double delta = output_time - new_output_time;
       if (delta > best_delta &&
-          (delta > kBufferSizeMinDelta || pair.second->name != kBufferSize)) {
+          (delta > kBufferSizeMinDelta || !IsBufferParameter(*pair.second))) {
         best_delta = delta;
         best_parameter = pair.second.get();
       }
@@ -1499,6 +1571,90 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
   }
 }
 
+void Model::OptimizeMemoryBounded(int64 cpu_budget, int64 ram_budget,
+                                  double model_input_time) {
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock lock(mu_);
+    snapshot = output_->Snapshot();
+  }
+  VLOG(2) << "Starting optimization of tunable parameters with MemoryBounded";
+  const double processing_time = TotalProcessingTime(snapshot);
+  auto parameters = CollectTunableParameters(snapshot);
+  auto essential_parameters = CollectEssentialParallelism(snapshot, parameters);
+
+  // Unlike the other algorithms, the budget includes the memory currently
+  // buffered by the model. The memory available on the host excludes it, so it
+  // is added back to the share of the available memory.
+  constexpr double kAvailableRamShare = 0.5L;
+  const double buffered_bytes = TotalBufferedBytes(snapshot);
+  const double memory_budget =
+      std::min(static_cast<double>(ram_budget),
+               buffered_bytes + kAvailableRamShare * port::AvailableRam());
+  // Buffer parameters will only be incremented if the output latency
+  // improvement is greater than this constant.
+  constexpr double kBufferSizeMinDelta = 1.0L;
+
+  for (auto& pair : parameters) {
+    pair.second->value = pair.second->min;
+  }
+  while (true) {
+    const double output_time =
+        OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
+    int64 model_parallelism = 0;
+    for (auto& pair : essential_parameters) {
+      model_parallelism += std::round(pair.second->value);
+    }
+    if (output_time < processing_time / cpu_budget ||
+        model_parallelism >= cpu_budget) {
+      break;
+    }
+    const double memory = TotalMaximumBufferedBytes(snapshot);
+    double best_score = 0.0L;
+    Parameter* best_parameter = nullptr;
+    for (auto& pair : parameters) {
+      if (pair.second->value == pair.second->max) {
+        continue;
+      }
+      pair.second->value++;
+      const double new_memory = TotalMaximumBufferedBytes(snapshot);
+      double delta = -1.0L;
+      if (new_memory <= memory_budget) {
+        delta = output_time -
+                OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
+      }
+      pair.second->value--;
+      if (delta <= 0 ||
+          (IsBufferParameter(*pair.second) && delta <= kBufferSizeMinDelta)) {
+        continue;
+      }
+      // Increments that do not buffer more memory are scored as if they
+      // buffered one byte.
+      const double score = delta / std::max(new_memory - memory, 1.0);
+      if (score > best_score) {
+        best_score = score;
+        best_parameter = pair.second.get();
+      }
+    }
+    if (!best_parameter) {
+      break;
+    }
+    best_parameter->value++;
+  }
+  VLOG(2) << "Number of tunable parameters: " << parameters.size()
+          << ", projected buffered bytes: "
+          << TotalMaximumBufferedBytes(snapshot)
+          << ", memory budget: " << memory_budget;
+  for (auto& pair : parameters) {
+    auto& parameter = pair.second;
+    VLOG(2) << "Setting tunable parameter " << pair.first << " to "
+            << parameter->value;
+    mutex_lock l(*parameter->state->mu);
+    parameter->state->value = parameter->value;
+    parameter->state->cond_var->notify_all();
+  }
+}
+
 double Model::OutputTime(std::shared_ptr<Node> node, double model_input_time,
                          absl::flat_hash_map<string, double>* gradients) {
   // To store the input time for each node.
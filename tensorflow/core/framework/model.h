@@ -41,6 +41,10 @@ namespace model {
 constexpr int64 kAutotune = -1;
 constexpr char kParallelism[] = "parallelism";
 constexpr char kBufferSize[] = "buffer_size";
+// A secondary parameter of interleave nodes: the number of blocks of results
+// buffered per input. The buffer of the node is scaled by the ratio of the
+// parameter value to its minimum.
+constexpr char kBufferedBlocks[] = "buffered_blocks";
 
 // A key used to identify the input time of the model.
 constexpr char kModelInputTimeKey[] = "model_input_time";
@@ -48,6 +52,7 @@ constexpr char kModelInputTimeKey[] = "model_input_time";
 enum class AutotuneAlgorithm {
   HILL_CLIMB = 0,
   GRADIENT_DESCENT = 1,
+  MEMORY_BOUNDED = 2,
 };
 
 enum class TraversalOrder {
@@ -149,6 +154,7 @@ class Node {
         autotune_(true),
         buffered_bytes_(0),
         buffered_elements_(0),
+        elements_in_flight_(0),
         bytes_consumed_(0),
         bytes_produced_(0),
         num_elements_(0),
@@ -209,6 +215,12 @@ class Node {
     return buffered_elements_;
   }
 
+  // Returns the number of elements that this node is producing for its buffer,
+  // such as the in-flight calls of a parallel map.
+  int64 elements_in_flight() const TF_LOCKS_EXCLUDED(mu_) {
+    return elements_in_flight_;
+  }
+
   // Returns the number of bytes consumed by the node.
   int64 bytes_consumed() const TF_LOCKS_EXCLUDED(mu_) {
     return bytes_consumed_;
@@ -268,6 +280,12 @@ class Node {
     buffered_elements_ += elements_delta;
   }
 
+  // Records the change in the number of elements that this node is producing
+  // for its buffer.
+  void record_in_flight_event(int64 elements_delta) {
+    elements_in_flight_ += elements_delta;
+  }
+
   // Records that the node produced an element.
   void record_element() TF_LOCKS_EXCLUDED(mu_) {
     num_elements_++;
@@ -334,6 +352,11 @@ class Node {
   // Flushes the metrics recorded by this node.
   void FlushMetrics() TF_LOCKS_EXCLUDED(mu_);
 
+  // Records a sample of the fraction of the buffer of this node that is
+  // filled, if the node has a buffer size or parallelism parameter. Must not
+  // be called concurrently with the optimization of the model.
+  void RecordBufferUtilization() TF_LOCKS_EXCLUDED(mu_);
+
   // Returns the per-element output time for this node and if `gradients` is not
   // `nullptr`, collects the output time gradient w.r.t. tunable parameters of
   // the subtree rooted in this node.
@@ -352,7 +375,8 @@ class Node {
   double SelfProcessingTime() const TF_LOCKS_EXCLUDED(mu_);
 
   // Returns the total number of bytes buffered in all nodes in the subtree for
-  // which autotuning is enabled.
+  // which autotuning is enabled. This includes an estimate of the size of the
+  // elements in flight.
   double TotalBufferedBytes() const TF_LOCKS_EXCLUDED(mu_);
 
   // Collects the total buffer limit of all nodes in the subtree for which
@@ -375,9 +399,14 @@ class Node {
         : bytes_consumed_counter_(metrics::GetTFDataBytesConsumedCounter(name)),
           bytes_produced_counter_(metrics::GetTFDataBytesProducedCounter(name)),
           num_elements_counter_(metrics::GetTFDataElementsCounter(name)),
+          processing_time_counter_(
+              metrics::GetTFDataProcessingTimeCounter(name)),
+          buffer_utilization_sampler_(
+              metrics::GetTFDataBufferUtilizationSampler(name)),
           recorded_bytes_consumed_(0),
           recorded_bytes_produced_(0),
-          recorded_num_elements_(0) {}
+          recorded_num_elements_(0),
+          recorded_processing_time_(0) {}
 
     // Expects the total number of bytes consumed and records the delta since
     // last invocation.
@@ -403,13 +432,30 @@ class Node {
       num_elements_counter_->IncrementBy(delta);
     }
 
+    // Expects the total processing time in nanoseconds and records the delta
+    // since last invocation in microseconds.
+    void record_processing_time(int64 total_nanos) {
+      int64 recorded = recorded_processing_time_.exchange(total_nanos);
+      processing_time_counter_->IncrementBy(
+          total_nanos / EnvTime::kMicrosToNanos -
+          recorded / EnvTime::kMicrosToNanos);
+    }
+
+    // Records a sample of the fraction of the buffer that is filled.
+    void record_buffer_utilization(double utilization) {
+      buffer_utilization_sampler_->Add(utilization);
+    }
+
    private:
     monitoring::CounterCell* const bytes_consumed_counter_;
     monitoring::CounterCell* const bytes_produced_counter_;
     monitoring::CounterCell* const num_elements_counter_;
+    monitoring::CounterCell* const processing_time_counter_;
+    monitoring::SamplerCell* const buffer_utilization_sampler_;
     std::atomic<int64> recorded_bytes_consumed_;
     std::atomic<int64> recorded_bytes_produced_;
     std::atomic<int64> recorded_num_elements_;
+    std::atomic<int64> recorded_processing_time_;
   };
 
   // Returns the number of inputs.
@@ -431,6 +477,10 @@ class Node {
   // Returns the average size of an element buffered in this node.
   double AverageBufferedElementSize() const TF_SHARED_LOCKS_REQUIRED(mu_);
 
+  // Returns the factor by which the `kBufferedBlocks` parameter of this node
+  // scales its buffer, or 1 if the node has no such parameter.
+  double BufferedBlocksRatio() const TF_SHARED_LOCKS_REQUIRED(mu_);
+
   // Returns the sum of per-element output time for the tunable inputs of this
   // node.
   double OutputTimeForInputs(
@@ -534,6 +584,7 @@ class Node {
   std::atomic<bool> autotune_;
   std::atomic<int64> buffered_bytes_;
   std::atomic<int64> buffered_elements_;
+  std::atomic<int64> elements_in_flight_;
   std::atomic<int64> bytes_consumed_;
   std::atomic<int64> bytes_produced_;
   std::atomic<int64> num_elements_;
@@ -658,6 +709,23 @@ class Model {
   void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
                                double model_input_time);
 
+  // This optimization algorithm is a hill climb that treats `ram_budget` as a
+  // hard limit on the memory used by the buffers of the whole model, including
+  // the elements in flight. The budget is further reduced to a share of the
+  // memory available on the host, so that the buffers shrink when the host
+  // comes under memory pressure.
+  //
+  // All tunable parameters start at their minimum value. The algorithm then
+  // repeatedly increments the parameter that decreases the output time the
+  // most per byte of additional buffered memory, among the increments that
+  // keep the model within the budget. This is repeated until no such increment
+  // decreases the output time, the essential transformations' parallelism
+  // reaches the CPU budget or the projected output time is less than or equal
+  // to the processing time needed to produce an element divided by the CPU
+  // budget.
+  void OptimizeMemoryBounded(int64 cpu_budget, int64 ram_budget,
+                             double model_input_time);
+
   // Collects the output time and if `gradients` is not `nullptr`, the output
   // time gradient w.r.t. tunable parameters of the subtree rooted in the given
   // node.
@@ -14,9 +14,14 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/framework/model.h"
+
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -105,6 +110,75 @@ INSTANTIATE_TEST_SUITE_P(Test, AsyncInterleaveManyTest,
                                             ::testing::Values(0, 50, 100,
                                                               200)));
 
+TEST(AsyncInterleaveManyBufferedBlocksTest, Model) {
+  const int64 parallelism = 2;
+  auto buffered_blocks_state =
+      std::make_shared<SharedState>(kAutotune, nullptr, nullptr);
+  std::shared_ptr<Node> async_interleave_many =
+      model::MakeAsyncInterleaveManyNode(
+          {0, "async_interleave_many", nullptr},
+          {model::MakeParameter(
+               kParallelism,
+               std::make_shared<SharedState>(parallelism, nullptr, nullptr), 1,
+               parallelism),
+           model::MakeParameter(kBufferedBlocks, buffered_blocks_state,
+                                /*min=*/2, /*max=*/8)});
+  std::shared_ptr<Node> meta_source =
+      model::MakeSourceNode({1, "meta_source", async_interleave_many});
+  async_interleave_many->add_input(meta_source);
+  auto cleanup_meta = gtl::MakeCleanup([async_interleave_many, meta_source]() {
+    async_interleave_many->remove_input(meta_source);
+  });
+  std::shared_ptr<Node> source1 =
+      model::MakeSourceNode({2, "source1", async_interleave_many});
+  async_interleave_many->add_input(source1);
+  auto cleanup1 = gtl::MakeCleanup([async_interleave_many, source1]() {
+    async_interleave_many->remove_input(source1);
+  });
+  std::shared_ptr<Node> source2 =
+      model::MakeSourceNode({3, "source2", async_interleave_many});
+  async_interleave_many->add_input(source2);
+  auto cleanup2 = gtl::MakeCleanup([async_interleave_many, source2]() {
+    async_interleave_many->remove_input(source2);
+  });
+
+  // Only the buffered blocks are tunable, and they are keyed apart from the
+  // node so that they do not collide with a primary parameter.
+  absl::flat_hash_map<string, std::shared_ptr<Parameter>> parameters;
+  async_interleave_many->CollectTunableParameters(&parameters);
+  ASSERT_EQ(parameters.size(), 1);
+  const string key =
+      strings::StrCat(async_interleave_many->long_name(), ":", kBufferedBlocks);
+  ASSERT_TRUE(parameters.contains(key));
+  EXPECT_EQ(parameters[key]->value, 2);
+
+  async_interleave_many->record_buffer_event(110, 10);
+  EXPECT_EQ(async_interleave_many->TotalMaximumBufferedBytes(),
+            110 * parallelism / 10);
+  parameters[key]->value = 4;
+  EXPECT_EQ(async_interleave_many->TotalMaximumBufferedBytes(),
+            2 * 110 * parallelism / 10);
+
+  // When the producers are about as fast as the consumer, buffering more
+  // blocks absorbs the variance of the producers.
+  async_interleave_many->record_element();
+  async_interleave_many->add_processing_time(100);
+  source1->record_element();
+  source1->add_processing_time(200);
+  source2->record_element();
+  source2->add_processing_time(200);
+  absl::flat_hash_map<string, double> input_times;
+  input_times[kModelInputTimeKey] = 200;
+  double previous_output_time = std::numeric_limits<double>::max();
+  for (int blocks = 2; blocks <= 8; ++blocks) {
+    parameters[key]->value = blocks;
+    const double output_time =
+        async_interleave_many->OutputTime(&input_times, nullptr);
+    EXPECT_LT(output_time, previous_output_time);
+    previous_output_time = output_time;
+  }
+}
+
 class AsyncKnownRatioTest
     : public ::testing::TestWithParam<std::tuple<int64, double, int64>> {};
 
@@ -791,6 +865,156 @@ TEST(SnapshotTest, Model) {
   }
 }
 
+TEST(InFlightElementsTest, Model) {
+  std::shared_ptr<Node> async_known_many = model::MakeAsyncKnownRatioNode(
+      {0, "async_known_many", nullptr}, /*ratio=*/1,
+      {model::MakeParameter(
+          "parallelism", std::make_shared<SharedState>(4, nullptr, nullptr), 1,
+          4)});
+  EXPECT_EQ(async_known_many->TotalBufferedBytes(), 0);
+  async_known_many->record_in_flight_event(3);
+  EXPECT_EQ(async_known_many->elements_in_flight(), 3);
+  // Nothing has been produced, so the size of the elements is unknown.
+  EXPECT_EQ(async_known_many->TotalBufferedBytes(), 0);
+
+  // The elements in flight are as large as the buffered elements.
+  async_known_many->record_buffer_event(100, 2);
+  EXPECT_EQ(async_known_many->TotalBufferedBytes(), 100 + 3 * 50);
+
+  // Or, if nothing is buffered, as the elements produced so far.
+  async_known_many->record_buffer_event(-100, -2);
+  for (int i = 0; i < 4; ++i) {
+    async_known_many->record_element();
+  }
+  async_known_many->record_bytes_produced(400);
+  EXPECT_EQ(async_known_many->TotalBufferedBytes(), 3 * 100);
+  // The maximum is bounded by the buffers, which hold the elements in flight.
+  EXPECT_EQ(async_known_many->TotalMaximumBufferedBytes(), 0);
+
+  async_known_many->record_in_flight_event(-3);
+  EXPECT_EQ(async_known_many->TotalBufferedBytes(), 0);
+}
+
+TEST(MetricsTest, Model) {
+  // The metrics are global, so the node has a name used by no other test.
+  const string name = "metrics_test_prefetch";
+  std::shared_ptr<Node> prefetch = model::MakeAsyncKnownRatioNode(
+      {0, name, nullptr}, /*ratio=*/1,
+      {model::MakeParameter(
+          kBufferSize, std::make_shared<SharedState>(4, nullptr, nullptr),
+          /*min=*/1, /*max=*/8)});
+  monitoring::CounterCell* processing_time =
+      metrics::GetTFDataProcessingTimeCounter(name);
+  monitoring::SamplerCell* buffer_utilization =
+      metrics::GetTFDataBufferUtilizationSampler(name);
+
+  prefetch->add_processing_time(3500);
+  prefetch->FlushMetrics();
+  EXPECT_EQ(processing_time->value(), 3);
+  // Only whole microseconds are recorded, but the remainder is not lost.
+  prefetch->add_processing_time(600);
+  prefetch->FlushMetrics();
+  EXPECT_EQ(processing_time->value(), 4);
+
+  prefetch->record_buffer_event(/*bytes_delta=*/100, /*elements_delta=*/2);
+  prefetch->RecordBufferUtilization();
+  prefetch->record_buffer_event(/*bytes_delta=*/200, /*elements_delta=*/6);
+  prefetch->RecordBufferUtilization();
+  HistogramProto histogram = buffer_utilization->value();
+  EXPECT_EQ(histogram.num(), 2);
+  // The buffer holds 2 and then 8 elements of 4, which is capped to full.
+  EXPECT_DOUBLE_EQ(histogram.sum(), 0.5 + 1.0);
+}
+
+class MemoryBoundedOptimizationTest : public ::testing::TestWithParam<int64> {
+};
+
+TEST_P(MemoryBoundedOptimizationTest, Model) {
+  const int64 ram_budget = GetParam();
+  constexpr int64 kElementBytes = 1000;
+  constexpr int64 kMaxParallelism = 16;
+  auto mu = std::make_shared<mutex>();
+  auto cond_var = std::make_shared<condition_variable>();
+  auto state = std::make_shared<SharedState>(kAutotune, mu, cond_var);
+
+  Model model;
+  std::shared_ptr<Node> map;
+  model.AddNode(
+      [&state](Node::Args args) {
+        return model::MakeAsyncKnownRatioNode(
+            std::move(args), /*ratio=*/1,
+            {model::MakeParameter(kParallelism, state, /*min=*/1,
+                                  /*max=*/kMaxParallelism)});
+      },
+      "map", /*parent=*/nullptr, &map);
+  std::shared_ptr<Node> source;
+  model.AddNode([](Node::Args args) { return MakeSourceNode(std::move(args)); },
+                "source", map, &source);
+  for (int i = 0; i < 100; ++i) {
+    map->record_element();
+    source->record_element();
+  }
+  map->add_processing_time(100 * 1000000);
+  source->add_processing_time(100 * 1000);
+  map->record_buffer_event(kElementBytes, 1);
+
+  model.Optimize(AutotuneAlgorithm::MEMORY_BOUNDED, /*cpu_budget=*/64,
+                 ram_budget, /*model_input_time=*/0);
+  mutex_lock l(*mu);
+  EXPECT_GE(state->value, 1);
+  EXPECT_LE(state->value * kElementBytes, std::max(ram_budget, kElementBytes));
+  if (ram_budget >= kMaxParallelism * kElementBytes) {
+    EXPECT_EQ(state->value, kMaxParallelism);
+  } else if (ram_budget >= kElementBytes) {
+    EXPECT_EQ(state->value, ram_budget / kElementBytes);
+  }
+  map->remove_input(source);
+}
+
+INSTANTIATE_TEST_SUITE_P(Test, MemoryBoundedOptimizationTest,
+                         ::testing::Values(0, 1000, 4500, 8000, 1000000));
+
+TEST(BufferedBlocksOptimizationTest, SmallImprovementsDoNotBufferMore) {
+  auto mu = std::make_shared<mutex>();
+  auto cond_var = std::make_shared<condition_variable>();
+  auto state = std::make_shared<SharedState>(kAutotune, mu, cond_var);
+
+  Model model;
+  std::shared_ptr<Node> interleave;
+  model.AddNode(
+      [&state](Node::Args args) {
+        return model::MakeAsyncInterleaveManyNode(
+            std::move(args),
+            {model::MakeParameter(kBufferedBlocks, state, /*min=*/2,
+                                  /*max=*/8)});
+      },
+      "interleave", /*parent=*/nullptr, &interleave);
+  std::vector<std::shared_ptr<Node>> sources(3);
+  for (int i = 0; i < sources.size(); ++i) {
+    model.AddNode(
+        [](Node::Args args) { return MakeSourceNode(std::move(args)); },
+        strings::StrCat("source", i), interleave, &sources[i]);
+  }
+  interleave->record_element();
+  interleave->add_processing_time(100);
+  for (int i = 1; i < sources.size(); ++i) {
+    sources[i]->record_element();
+    sources[i]->add_processing_time(100);
+  }
+
+  // The inputs are much faster than the consumer, so buffering more blocks
+  // only shortens the output time by a fraction of a nanosecond.
+  model.Optimize(AutotuneAlgorithm::MEMORY_BOUNDED, /*cpu_budget=*/64,
+                 /*ram_budget=*/1 << 30, /*model_input_time=*/1000);
+  {
+    mutex_lock l(*mu);
+    EXPECT_EQ(state->value, 2);
+  }
+  for (const auto& source : sources) {
+    interleave->remove_input(source);
+  }
+}
+
 class ComputeWaitTimeTest
     : public ::testing::TestWithParam<std::tuple<double, double, double>> {};
 
@@ -361,10 +361,17 @@ OpKernelContext::~OpKernelContext() {
 }
 
 Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
+  return get_allocator(attr, /*step_allocator=*/nullptr);
+}
+
+Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr,
+                                          Allocator* step_allocator) {
   Allocator* allocator = nullptr;
   if (TF_PREDICT_FALSE(attr.scope_id > 0)) {
     allocator = params_->device->GetScopedAllocator(attr, step_id());
     CHECK(allocator);
+  } else if (step_allocator != nullptr && attr.value == 0) {
+    allocator = step_allocator;
   } else {
     allocator = params_->device->GetAllocator(attr);
   }
@@ -704,9 +711,8 @@ Status OpKernelContext::allocate_output(StringPiece name,
 }
 
 Status OpKernelContext::allocate_tensor(
-    DataType type, const TensorShape& shape, Tensor* out_tensor,
-    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(
       a, type, shape,
       AllocationAttributes(
@@ -761,10 +767,23 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
           " more than once.  Try turning off the ScopedAllocator optimizer.");
     }
   }
+  if (params_->output_retval_array != nullptr &&
+      params_->output_retval_array[index] >= 0 &&
+      params_->call_frame != nullptr && attr.scope_id <= 0) {
+    Tensor buffer;
+    if (params_->call_frame->GetRetvalBuffer(
+            params_->output_retval_array[index], type, shape, &buffer)) {
+      outputs_[index] = TensorValue(new Tensor(std::move(buffer)));
+      *output = outputs_[index].tensor;
+      return Status::OK();
+    }
+  }
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "output", type, &shape);
   auto output_tensor = MakeUnique<Tensor>();
-  Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
+  Status s =
+      allocate_tensor(get_allocator(attr, params_->step_output_allocator), type,
+                      shape, output_tensor.get(), AllocationAttributes());
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor.release());
     *output = outputs_[index].tensor;
@@ -794,10 +813,9 @@ Status OpKernelContext::allocate_temp(
   }
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "temp", type, &shape);
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  Allocator* a = get_allocator(allocator_attr, params_->step_arena_allocator);
+  Status s = allocate_tensor(a, type, shape, out_temp, allocation_attr);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
-    Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
       int64 alloc_size = a->AllocatedSize(out_temp->tensor_data().data());
       record_temp_memory_allocation(alloc_size, *out_temp);
@@ -824,8 +842,10 @@ Status OpKernelContext::allocate_persistent(DataType type,
   }
   ScopedMemoryDebugAnnotation op_annotation(op_kernel().name_view().data(),
                                             step_id(), "persist", type, &shape);
+  Allocator* a = get_allocator(attr);
   Tensor persistent;
-  Status s = allocate_tensor(type, shape, &persistent, attr);
+  Status s = allocate_tensor(a, type, shape, &persistent,
+                             AllocationAttributes());
   if (s.ok()) {
     *out_persistent = PersistentTensor(persistent);
     Tensor* t = out_persistent->AccessTensor(this);
@@ -835,7 +855,6 @@ Status OpKernelContext::allocate_persistent(DataType type,
     }
 
     if (track_allocations()) {
-      Allocator* a = get_allocator(attr);
       if (a->TracksAllocationSizes()) {
         // Zero-byte Tensors don't use allocators: check and skip tracking.
         AllocationDescription alloc_desc;
@@ -691,12 +691,28 @@ class OpKernelContext {
     // TensorSliceReaderCache support.
     checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache = nullptr;
 
+    // If not null, serves the temporaries with default allocator attributes
+    // of this kernel, instead of the device allocator. Not owned.
+    Allocator* step_arena_allocator = nullptr;
+
+    // If not null, serves the outputs with default allocator attributes of
+    // this kernel, instead of the device allocator. Outputs may outlive the
+    // step, so this must not be a StepArenaAllocator, whose chunks they would
+    // keep alive. Not owned.
+    Allocator* step_output_allocator = nullptr;
+
     // Support for forwarding reservations (used by ScopedAllocator).
     static constexpr int kNeverForward = -2;
     static constexpr int kNoReservation = -1;
     // Values in [0,...) represent reservations for the indexed output.
     const int* forward_from_array = nullptr;
 
+    // If non-null, an array of num_outputs ints: the index of the retval of
+    // `call_frame` whose only input is the ith output, or -1. Such outputs
+    // are allocated in the buffer offered by CallFrameInterface::
+    // GetRetvalBuffer(), if any.
+    const int* output_retval_array = nullptr;
+
     // For tracking actively running deferred ops.
     std::function<void()> inc_num_deferred_ops_function;
     std::function<void()> dec_num_deferred_ops_function;
@@ -1264,6 +1280,10 @@ class OpKernelContext {
  private:
   bool record_memory_consumption_ = false;
 
+  // Like `get_allocator()`, but returns `step_allocator` (if not null) for
+  // default allocator attributes.
+  Allocator* get_allocator(AllocatorAttributes attr, Allocator* step_allocator);
+
   // Internal common method used when allocating tensor memory
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor,
@@ -1274,6 +1294,13 @@ class OpKernelContext {
 
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
+                         const AllocationAttributes& allocation_attr) {
+    return allocate_tensor(get_allocator(allocator_attr), type, shape,
+                           out_tensor, allocation_attr);
+  }
+
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
                          const AllocationAttributes& allocation_attr);
 
   // Helpers for `set_output()`.
@@ -476,6 +476,63 @@ TEST_F(OpKernelTest, ScopedAllocationTest) {
   EXPECT_EQ(sa_device->num_allocations(true), 1);
 }
 
+// Forwards to cpu_allocator() and counts the allocations.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  int num_allocations() const { return num_allocations_; }
+
+ private:
+  int num_allocations_ = 0;
+};
+
+// Outputs may outlive the step, so they must not be allocated from the step
+// arena, unless they are explicitly given a step output allocator.
+TEST_F(OpKernelTest, StepArenaAllocatorOnlyServesTemporaries) {
+  Env* env = Env::Default();
+  OpKernelContext::Params params;
+  DummyDevice device(env);
+  params.device = &device;
+  Status status;
+  std::unique_ptr<OpKernel> op(CreateOpKernel(
+      DEVICE_CPU, params.device, cpu_allocator(),
+      CreateNodeDef("Test4", {DT_FLOAT}), TF_GRAPH_DEF_VERSION, &status));
+  TF_ASSERT_OK(status);
+  params.op_kernel = op.get();
+  std::vector<AllocatorAttributes> output_alloc_attrs(1);
+  params.output_attr_array = output_alloc_attrs.data();
+  CountingAllocator step_arena_allocator;
+  params.step_arena_allocator = &step_arena_allocator;
+
+  {
+    OpKernelContext ctx(&params);
+    Tensor temp;
+    TF_ASSERT_OK(ctx.allocate_temp(DT_FLOAT, TensorShape({8}), &temp));
+    EXPECT_EQ(1, step_arena_allocator.num_allocations());
+    Tensor* output = nullptr;
+    TF_ASSERT_OK(ctx.allocate_output(0, TensorShape({8}), &output));
+    EXPECT_EQ(1, step_arena_allocator.num_allocations());
+    EXPECT_EQ(cpu_allocator(), ctx.get_allocator(AllocatorAttributes()));
+  }
+
+  CountingAllocator step_output_allocator;
+  params.step_output_allocator = &step_output_allocator;
+  {
+    OpKernelContext ctx(&params);
+    Tensor* output = nullptr;
+    TF_ASSERT_OK(ctx.allocate_output(0, TensorShape({8}), &output));
+    EXPECT_EQ(1, step_output_allocator.num_allocations());
+    EXPECT_EQ(1, step_arena_allocator.num_allocations());
+  }
+}
+
 class OpKernelBuilderTest : public ::testing::Test {
  protected:
   // Each attr is described by a "name|type|value".
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <mutex>  // NOLINT(build/c++11): only using std::call_once.
+
 #include "tensorflow/core/framework/resource_mgr.h"
 
 namespace tensorflow {
@@ -57,6 +59,10 @@ namespace tensorflow {
 // mutex as desired. To access the variable in dense mode grab the mutex either
 // directly or via `MaybeLockVariableInputMutexesInOrder` on all variables being
 // modified and then call `PrepareToUpdateVariable` on them in any order.
+//
+// Sparse writes may also be done under a shared mutex while holding the row
+// stripe mutexes of the rows they modify in exclusive mode. Concurrent writes
+// to disjoint stripes then proceed in parallel, without tearing rows.
 class Var : public ResourceBase {
  public:
   explicit Var(DataType dtype) : tensor_(dtype) {}
@@ -67,6 +73,20 @@ class Var : public ResourceBase {
   mutex* mu() { return &mu_; }
   Tensor* tensor() { return &tensor_; }
 
+  // Rows are assigned to kNumRowStripes stripes by index. When locking
+  // several stripes, they must be acquired in order of increasing stripe.
+  static constexpr int kNumRowStripes = 1024;
+  static int RowStripe(int64 row) {
+    return static_cast<uint64>(row) % kNumRowStripes;
+  }
+  // The mutexes are only allocated for variables updated this way.
+  mutex* row_stripe_mu(int stripe) {
+    std::call_once(row_stripe_mus_once_, [this] {
+      row_stripe_mus_.reset(new mutex[kNumRowStripes]);
+    });
+    return &row_stripe_mus_[stripe];
+  }
+
   std::string DebugString() const override {
     return strings::StrCat(DataTypeString(tensor_.dtype()), "/",
                            tensor_.shape().DebugString());
@@ -90,6 +110,8 @@ class Var : public ResourceBase {
  private:
   mutex mu_;
   Tensor tensor_;
+  std::once_flag row_stripe_mus_once_;
+  std::unique_ptr<mutex[]> row_stripe_mus_;
 
   ~Var() override {}
   TF_DISALLOW_COPY_AND_ASSIGN(Var);
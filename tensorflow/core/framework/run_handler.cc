@@ -19,10 +19,12 @@ limitations under the License.
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <list>
 #include <memory>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -44,6 +46,20 @@ static constexpr int32 kMaxConcurrentHandlers = 128;
 typedef typename internal::RunHandlerEnvironment::Task Task;
 typedef Eigen::RunQueue<Task, 1024> Queue;
 
+typedef RunOptions::Experimental::RunHandlerPoolOptions RunHandlerPoolOptions;
+
+// Requests of a higher rank are scheduled first.
+int PriorityClassRank(RunHandlerPoolOptions::PriorityClass priority_class) {
+  switch (priority_class) {
+    case RunHandlerPoolOptions::LATENCY_CRITICAL:
+      return 2;
+    case RunHandlerPoolOptions::BACKFILL:
+      return 0;
+    default:
+      return 1;
+  }
+}
+
 }  // namespace
 
 namespace internal {
@@ -131,6 +147,10 @@ ThreadWorkSource::ThreadWorkSource()
       blocking_inflight_(0),
       non_blocking_inflight_(0),
       traceme_id_(0),
+      priority_class_(RunHandlerPoolOptions::DEFAULT),
+      deadline_us_(0),
+      pending_tasks_(0),
+      waiting_since_us_(0),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -160,11 +180,18 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking) {
     mu = &blocking_queue_op_mu_;
   }
 
+  if (pending_tasks_.fetch_add(1, std::memory_order_relaxed) == 0) {
+    waiting_since_us_.store(EnvTime::NowMicros(), std::memory_order_relaxed);
+  }
   {
     mutex_lock l(*mu);
     // For a given queue, only one thread can call PushFront.
     t = task_queue->PushFront(std::move(t));
   }
+  if (t.f) {
+    // The queue is full, the caller runs the task inline.
+    pending_tasks_.fetch_sub(1, std::memory_order_relaxed);
+  }
 
   Waiter* w = nullptr;
   static const bool use_sub_thread_pool =
@@ -216,8 +243,17 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking) {
   return t;
 }
 
+void ThreadWorkSource::OnTaskPopped() {
+  pending_tasks_.fetch_sub(1, std::memory_order_relaxed);
+  waiting_since_us_.store(EnvTime::NowMicros(), std::memory_order_relaxed);
+}
+
 Task ThreadWorkSource::PopBlockingTask() {
-  return blocking_work_queue_.PopBack();
+  Task t = blocking_work_queue_.PopBack();
+  if (t.f) {
+    OnTaskPopped();
+  }
+  return t;
 }
 
 Task ThreadWorkSource::PopNonBlockingTask(int start_index,
@@ -228,6 +264,7 @@ Task ThreadWorkSource::PopNonBlockingTask(int start_index,
     t = non_blocking_work_queues_[(start_index + j) % sharding_factor]
             ->queue.PopBack();
     if (t.f) {
+      OnTaskPopped();
       return t;
     }
     if (!search_from_all_queue) {
@@ -260,6 +297,29 @@ int64 ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64 value) { traceme_id_ = value; }
 
+void ThreadWorkSource::SetSchedulingOptions(
+    RunHandlerPoolOptions::PriorityClass priority_class, uint64 deadline_us) {
+  priority_class_.store(priority_class, std::memory_order_relaxed);
+  deadline_us_.store(deadline_us, std::memory_order_relaxed);
+}
+
+RunHandlerPoolOptions::PriorityClass ThreadWorkSource::GetPriorityClass()
+    const {
+  return priority_class_.load(std::memory_order_relaxed);
+}
+
+uint64 ThreadWorkSource::GetDeadlineUs() const {
+  return deadline_us_.load(std::memory_order_relaxed);
+}
+
+bool ThreadWorkSource::IsStarving(uint64 now_us, uint64 threshold_us) const {
+  if (pending_tasks_.load(std::memory_order_relaxed) <= 0) {
+    return false;
+  }
+  return now_us > waiting_since_us_.load(std::memory_order_relaxed) +
+                      threshold_us;
+}
+
 void ThreadWorkSource::SetWaiter(uint64 version, Waiter* waiter, mutex* mutex) {
   {
     tf_shared_lock lock(run_handler_waiter_mu_);
@@ -334,7 +394,10 @@ RunHandlerThreadPool::RunHandlerThreadPool(
           std::vector<double>({0, 0.4}))),
       sub_thread_pool_end_request_percentage_(ParamFromEnvWithDefault(
           "TF_RUN_HANDLER_SUB_THREAD_POOL_END_REQUEST_PERCENTAGE",
-          std::vector<double>({0.4, 1}))) {
+          std::vector<double>({0.4, 1}))),
+      starvation_threshold_us_(static_cast<uint64>(std::max(
+          0.0, 1000 * ParamFromEnvWithDefault(
+                          "TF_RUN_HANDLER_STARVATION_THRESHOLD_MS", 0.0)))) {
   thread_data_.resize(num_threads_);
   VLOG(1) << "Creating RunHandlerThreadPool " << name << " with  "
           << num_blocking_threads_ << " blocking threads and "
@@ -476,7 +539,8 @@ RunHandlerThreadPool::ThreadData::ThreadData()
       current_thread_work_sources(
           new Eigen::MaxSizeVector<ThreadWorkSource*>(static_cast<int32>(
               ParamFromEnvWithDefault("TF_RUN_HANDLER_MAX_CONCURRENT_HANDLERS",
-                                      kMaxConcurrentHandlers)))) {}
+                                      kMaxConcurrentHandlers)))),
+      iterations_since_starvation_check(0) {}
 
 Task RunHandlerThreadPool::FindTask(
     int searching_range_start, int searching_range_end, int thread_id,
@@ -516,6 +580,38 @@ Task RunHandlerThreadPool::FindTask(
   return t;
 }
 
+Task RunHandlerThreadPool::FindStarvedTask(
+    int thread_id, int max_blocking_inflight, bool may_steal_blocking_work,
+    const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
+    bool* task_from_blocking_queue, ThreadWorkSource** tws) {
+  Task t;
+  if (starvation_threshold_us_ == 0) {
+    return t;
+  }
+  const uint64 now = EnvTime::NowMicros();
+  for (int i = static_cast<int>(thread_work_sources.size()) - 1; i >= 0;
+       --i) {
+    *tws = thread_work_sources[i];
+    if (!(*tws)->IsStarving(now, starvation_threshold_us_)) {
+      continue;
+    }
+    if (may_steal_blocking_work &&
+        (*tws)->GetInflightTaskCount(true) < max_blocking_inflight) {
+      t = (*tws)->PopBlockingTask();
+      if (t.f) {
+        *task_from_blocking_queue = true;
+        return t;
+      }
+    }
+    t = (*tws)->PopNonBlockingTask(thread_id, true);
+    if (t.f) {
+      *task_from_blocking_queue = false;
+      return t;
+    }
+  }
+  return t;
+}
+
 // Main worker thread loop.
 void RunHandlerThreadPool::WorkerLoop(int thread_id,
                                       bool may_steal_blocking_work) {
@@ -523,12 +619,15 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
   pt->pool = this;
   pt->thread_id = thread_id;
   static constexpr int32 kMaxBlockingInflight = 10;
+  // How often, in iterations, the thread looks for starved tasks before
+  // following the priority order.
+  static constexpr int kStarvationCheckPeriod = 16;
 
   while (!cancelled_) {
     Task t;
     ThreadWorkSource* tws = nullptr;
     bool task_from_blocking_queue = true;
-    int sub_thread_pool_id;
+    int sub_thread_pool_id = thread_data_[thread_id].sub_thread_pool_id;
     // Get the current thread work sources.
     {
       mutex_lock l(thread_data_[thread_id].mu);
@@ -542,8 +641,19 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
     }
     Eigen::MaxSizeVector<ThreadWorkSource*>* thread_work_sources =
         thread_data_[thread_id].current_thread_work_sources.get();
-    if (use_sub_thread_pool_) {
-      sub_thread_pool_id = thread_data_[thread_id].sub_thread_pool_id;
+    if (++thread_data_[thread_id].iterations_since_starvation_check >=
+        kStarvationCheckPeriod) {
+      thread_data_[thread_id].iterations_since_starvation_check = 0;
+      t = FindStarvedTask(thread_id, kMaxBlockingInflight,
+                          may_steal_blocking_work, *thread_work_sources,
+                          &task_from_blocking_queue, &tws);
+      if (t.f) {
+        metrics::RecordRunHandlerStarvedTask(
+            RunHandlerPoolOptions::PriorityClass_Name(
+                tws->GetPriorityClass()));
+      }
+    }
+    if (!t.f && use_sub_thread_pool_) {
       int active_requests = thread_work_sources->size();
       if (may_steal_blocking_work) {
         // Each thread will first look for tasks from requests that belongs to
@@ -578,7 +688,7 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
                      /*may_steal_blocking_work=*/false, *thread_work_sources,
                      &task_from_blocking_queue, &tws);
       }
-    } else {
+    } else if (!t.f) {
       // TODO(chaox): Refactor the following code to share the logic with
       // FindTask.
       for (int i = 0; i < thread_work_sources->size(); ++i) {
@@ -741,6 +851,14 @@ class RunHandler::Impl {
 
   int64 priority() { return options_.priority(); }
 
+  RunHandlerPoolOptions::PriorityClass priority_class() {
+    return options_.priority_class();
+  }
+
+  // The deadline in microseconds since unix epoch, or 0 if the request has
+  // none.
+  uint64 deadline_us() const { return deadline_us_; }
+
  private:
   class ThreadPoolInterfaceWrapper : public thread::ThreadPoolInterface {
    public:
@@ -757,6 +875,7 @@ class RunHandler::Impl {
 
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  uint64 deadline_us_;
   int64 step_id_;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   internal::ThreadWorkSource tws_;
@@ -862,12 +981,11 @@ class RunHandlerPool::Impl {
 
       num_active_requests = sorted_active_handlers_.size() + 1;
       thread_work_sources->resize(num_active_requests);
-      int priority = options.priority();
       auto it = sorted_active_handlers_.cbegin();
       bool new_handler_inserted = false;
       for (int i = 0; i < num_active_requests; ++i) {
         if (!new_handler_inserted && (it == sorted_active_handlers_.cend() ||
-                                      priority > (*it)->priority())) {
+                                      ScheduledBefore(handler_impl, *it))) {
           sorted_active_handlers_.insert(it, handler_impl);
           new_handler_inserted = true;
           // Point to the newly added handler.
@@ -883,13 +1001,18 @@ class RunHandlerPool::Impl {
   }
 
   void ReleaseHandler(RunHandler::Impl* handler) TF_LOCKS_EXCLUDED(mu_) {
+    uint64 now = tensorflow::EnvTime::NowMicros();
+    metrics::RecordRunHandlerRequest(
+        RunHandlerPoolOptions::PriorityClass_Name(handler->priority_class()),
+        now - handler->start_time_us(),
+        handler->deadline_us() != 0 && now > handler->deadline_us());
+
     mutex_lock l(mu_);
     DCHECK_GT(sorted_active_handlers_.size(), 0);
 
     CHECK_EQ(handler->tws()->TaskQueueSize(true), 0);   // Crash OK.
     CHECK_EQ(handler->tws()->TaskQueueSize(false), 0);  // Crash OK.
 
-    uint64 now = tensorflow::EnvTime::NowMicros();
     double elapsed = (now - handler->start_time_us()) / 1000.0;
     time_hist_.Add(elapsed);
 
@@ -923,7 +1046,35 @@ class RunHandlerPool::Impl {
     return ret;
   }
 
+  std::vector<int64> GetActiveHandlerStepIdsForTesting()
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    std::vector<int64> ret;
+    for (const auto& handler_impl : sorted_active_handlers_) {
+      ret.push_back(handler_impl->step_id());
+    }
+    return ret;
+  }
+
  private:
+  // Returns true if the new request `a` should be scheduled before the
+  // active request `b`: by priority class, then priority, then deadline.
+  // Ties are broken by arrival time, so `a` goes after `b`.
+  static bool ScheduledBefore(RunHandler::Impl* a, RunHandler::Impl* b) {
+    const int a_rank = PriorityClassRank(a->priority_class());
+    const int b_rank = PriorityClassRank(b->priority_class());
+    if (a_rank != b_rank) return a_rank > b_rank;
+    if (a->priority() != b->priority()) return a->priority() > b->priority();
+    // Requests without a deadline go after the ones with a deadline.
+    const uint64 a_deadline = a->deadline_us() == 0
+                                  ? std::numeric_limits<uint64>::max()
+                                  : a->deadline_us();
+    const uint64 b_deadline = b->deadline_us() == 0
+                                  ? std::numeric_limits<uint64>::max()
+                                  : b->deadline_us();
+    return a_deadline < b_deadline;
+  }
+
   void RecomputePoolStats(
       int num_active_requests, uint64 version,
       const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
@@ -1067,9 +1218,13 @@ void RunHandler::Impl::Reset(
     int64 step_id,
     const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = options.deadline_in_ms() > 0
+                     ? start_time_us_ + options.deadline_in_ms() * 1000
+                     : 0;
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.SetSchedulingOptions(options.priority_class(), deadline_us_);
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -1092,6 +1247,10 @@ std::vector<int64> RunHandlerPool::GetActiveHandlerPrioritiesForTesting()
   return impl_->GetActiveHandlerPrioritiesForTesting();
 }
 
+std::vector<int64> RunHandlerPool::GetActiveHandlerStepIdsForTesting() const {
+  return impl_->GetActiveHandlerStepIdsForTesting();
+}
+
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
 void RunHandler::ScheduleInterOpClosure(std::function<void()> fn) {
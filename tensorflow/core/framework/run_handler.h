@@ -72,6 +72,10 @@ class RunHandlerPool {
   // order of the active handler list.
   std::vector<int64> GetActiveHandlerPrioritiesForTesting() const;
 
+  // Get the step ids of the active handlers, in the order of the active
+  // handler list.
+  std::vector<int64> GetActiveHandlerStepIdsForTesting() const;
+
  private:
   class Impl;
   friend class RunHandler;
@@ -81,8 +85,9 @@ class RunHandlerPool {
 
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
-// handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// handler specific queue, from which the work is stolen in a priority order:
+// by priority class, then priority, then deadline, then time of the Get()
+// call (see RunOptions::Experimental::RunHandlerPoolOptions).
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -173,6 +178,23 @@ class ThreadWorkSource {
 
   void SetTracemeId(int64 value);
 
+  // Sets the priority class and the deadline of the request that owns this
+  // work source. `deadline_us` is in microseconds since the epoch, or 0 if the
+  // request has no deadline.
+  void SetSchedulingOptions(
+      RunOptions::Experimental::RunHandlerPoolOptions::PriorityClass
+          priority_class,
+      uint64 deadline_us);
+
+  RunOptions::Experimental::RunHandlerPoolOptions::PriorityClass
+  GetPriorityClass() const;
+
+  uint64 GetDeadlineUs() const;
+
+  // Returns true if this work source has had queued tasks for more than
+  // `threshold_us` at `now_us` without any of them being picked up.
+  bool IsStarving(uint64 now_us, uint64 threshold_us) const;
+
   void SetWaiter(uint64 version, Waiter* waiter, mutex* mutex);
 
   int64 GetInflightTaskCount(bool is_blocking);
@@ -186,6 +208,8 @@ class ThreadWorkSource {
   std::string ToString();
 
  private:
+  void OnTaskPopped();
+
   struct NonBlockingQueue {
     mutex queue_op_mu;
     char pad[128];
@@ -205,6 +229,14 @@ class ThreadWorkSource {
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64> traceme_id_;
 
+  std::atomic<RunOptions::Experimental::RunHandlerPoolOptions::PriorityClass>
+      priority_class_;
+  std::atomic<uint64> deadline_us_;
+  // The number of queued (not yet popped) tasks, and the last time the queues
+  // became non-empty or a task was popped from them.
+  std::atomic<int64> pending_tasks_;
+  std::atomic<uint64> waiting_since_us_;
+
   mutex run_handler_waiter_mu_;
   uint64 version_ TF_GUARDED_BY(run_handler_waiter_mu_);
   mutex* sub_thread_pool_waiter_mu_ TF_GUARDED_BY(run_handler_waiter_mu_);
@@ -263,6 +295,14 @@ class RunHandlerThreadPool {
       const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
       bool* task_from_blocking_queue, ThreadWorkSource** tws);
 
+  // Search, from the lowest priority request, for a task of a request that
+  // is starving (see ThreadWorkSource::IsStarving). Returns an empty task if
+  // starvation protection is disabled or no request is starving.
+  Task FindStarvedTask(
+      int thread_id, int max_blocking_inflight, bool may_steal_blocking_work,
+      const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
+      bool* task_from_blocking_queue, ThreadWorkSource** tws);
+
   void WaitForWork(bool is_blocking, int thread_id,
                    int32 max_blocking_inflight);
 
@@ -285,6 +325,10 @@ class RunHandlerThreadPool {
         current_thread_work_sources;
 
     int sub_thread_pool_id;
+
+    // Number of iterations of the worker loop since the last search for
+    // starved tasks.
+    int iterations_since_starvation_check;
   };
 
   const int num_threads_;
@@ -305,6 +349,12 @@ class RunHandlerThreadPool {
   // fashion.
   std::vector<double> sub_thread_pool_start_request_percentage_;
   std::vector<double> sub_thread_pool_end_request_percentage_;
+
+  // Requests whose queued tasks have waited for longer than this are run
+  // ahead of higher priority requests. Set from
+  // TF_RUN_HANDLER_STARVATION_THRESHOLD_MS; 0, the default, disables
+  // starvation protection.
+  const uint64 starvation_threshold_us_;
 };
 
 }  // namespace internal
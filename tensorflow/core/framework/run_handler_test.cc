@@ -113,6 +113,56 @@ TEST(RunHandlerUtilTest, PrioritySchedulingTest) {
   EXPECT_EQ(sorted_active_list[3], 1);
 }
 
+TEST(RunHandlerUtilTest, PriorityClassSchedulingTest) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  options.set_priority_class(
+      RunOptions::Experimental::RunHandlerPoolOptions::BACKFILL);
+  options.set_priority(10);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_priority_class(
+      RunOptions::Experimental::RunHandlerPoolOptions::DEFAULT);
+  options.set_priority(1);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.set_priority_class(
+      RunOptions::Experimental::RunHandlerPoolOptions::LATENCY_CRITICAL);
+  options.set_priority(0);
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+  options.set_priority_class(
+      RunOptions::Experimental::RunHandlerPoolOptions::DEFAULT);
+  options.set_priority(1);
+  auto handler4 = pool->Get(/*step_id=*/4, /*timeout_in_ms=*/0, options);
+
+  // The class takes precedence over the priority, and requests of the same
+  // class and priority are ordered by arrival.
+  EXPECT_EQ(pool->GetActiveHandlerStepIdsForTesting(),
+            std::vector<int64>({3, 2, 4, 1}));
+}
+
+TEST(RunHandlerUtilTest, DeadlineSchedulingTest) {
+  int num_threads = 2;
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  options.set_priority(1);
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(1000 * 1000);
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.set_deadline_in_ms(10);
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+  options.set_priority(2);
+  options.set_deadline_in_ms(0);
+  auto handler4 = pool->Get(/*step_id=*/4, /*timeout_in_ms=*/0, options);
+
+  // Earliest deadline first within a priority; no deadline goes last.
+  EXPECT_EQ(pool->GetActiveHandlerStepIdsForTesting(),
+            std::vector<int64>({4, 3, 2, 1}));
+}
+
 TEST(RunHandlerThreadPool, EnqueueTask) {
   Eigen::MaxSizeVector<mutex> waiters_mu(2);
   waiters_mu.resize(2);
@@ -426,6 +476,70 @@ TEST(RunHandlerThreadPool, FindTask) {
   }
 }
 
+TEST(RunHandlerThreadPool, FindStarvedTask) {
+  Eigen::MaxSizeVector<mutex> waiters_mu(2);
+  waiters_mu.resize(2);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(2);
+  waiters.resize(2);
+  setenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS", "50", true);
+  internal::RunHandlerThreadPool run_handler_thread_pool(
+      /*num_blocking_threads=*/1, /*num_non_blocking_threads=*/0,
+      Env::Default(), ThreadOptions(), "tf_run_handler_pool", &waiters_mu,
+      &waiters);
+  unsetenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS");
+
+  internal::ThreadWorkSource high;
+  internal::ThreadWorkSource low;
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(2);
+  thread_work_sources.resize(2);
+  thread_work_sources[0] = &high;
+  thread_work_sources[1] = &low;
+
+  int result = 0;
+  run_handler_thread_pool.AddWorkToQueue(&high, /*is_blocking=*/true,
+                                         [&result] { result = 1; });
+  run_handler_thread_pool.AddWorkToQueue(&low, /*is_blocking=*/true,
+                                         [&result] { result = 2; });
+  bool task_from_blocking_queue;
+  internal::ThreadWorkSource* tws;
+  EXPECT_FALSE(run_handler_thread_pool
+                   .FindStarvedTask(/*thread_id=*/0,
+                                    /*max_blocking_inflight=*/10,
+                                    /*may_steal_blocking_work=*/true,
+                                    thread_work_sources,
+                                    &task_from_blocking_queue, &tws)
+                   .f);
+
+  Env::Default()->SleepForMicroseconds(100 * 1000);
+  // Both requests are starving; the lowest priority one goes first.
+  internal::Task t = run_handler_thread_pool.FindStarvedTask(
+      /*thread_id=*/0, /*max_blocking_inflight=*/10,
+      /*may_steal_blocking_work=*/true, thread_work_sources,
+      &task_from_blocking_queue, &tws);
+  ASSERT_TRUE(t.f);
+  EXPECT_EQ(tws, &low);
+  EXPECT_TRUE(task_from_blocking_queue);
+  t.f->f();
+  EXPECT_EQ(result, 2);
+  EXPECT_FALSE(low.IsStarving(EnvTime::NowMicros(), 50 * 1000));
+
+  t = run_handler_thread_pool.FindStarvedTask(
+      /*thread_id=*/0, /*max_blocking_inflight=*/10,
+      /*may_steal_blocking_work=*/true, thread_work_sources,
+      &task_from_blocking_queue, &tws);
+  ASSERT_TRUE(t.f);
+  EXPECT_EQ(tws, &high);
+  t.f->f();
+  EXPECT_EQ(result, 1);
+  EXPECT_FALSE(run_handler_thread_pool
+                   .FindStarvedTask(/*thread_id=*/0,
+                                    /*max_blocking_inflight=*/10,
+                                    /*may_steal_blocking_work=*/true,
+                                    thread_work_sources,
+                                    &task_from_blocking_queue, &tws)
+                   .f);
+}
+
 TEST(RunHandlerThreadPool, RoundRobinExecution) {
   // Set up environment for 1 sub thread pool.
   setenv("TF_RUN_HANDLER_USE_SUB_THREAD_POOL", "true", true);
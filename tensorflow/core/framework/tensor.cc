@@ -29,6 +29,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor.h"
 
+#include "absl/memory/memory.h"
 #include "absl/strings/escaping.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/log_memory.h"
@@ -864,6 +865,49 @@ class SubBuffer : public TensorBuffer {
   TF_DISALLOW_COPY_AND_ASSIGN(SubBuffer);
 };
 
+// A buffer aliasing the tensor_content of a TensorProto, which it owns.
+class ProtoContentBuffer : public TensorBuffer {
+ public:
+  explicit ProtoContentBuffer(std::unique_ptr<string> content)
+      : TensorBuffer(&(*content)[0]), content_(std::move(content)) {}
+
+  size_t size() const override { return content_->size(); }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("ProtoContentBuffer");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  ~ProtoContentBuffer() override {}
+
+  const std::unique_ptr<string> content_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ProtoContentBuffer);
+};
+
+// Takes `*content` over and returns a buffer aliasing it, if it holds exactly
+// `n` elements of the simple type T and is aligned as tensors require.
+// Otherwise, leaves `*content` unchanged and returns nullptr.
+template <typename T>
+TensorBuffer* AliasTensorContent(string* content, int64 n) {
+  if (!is_simple_type<T>::value || content->size() != sizeof(T) * n) {
+    return nullptr;
+  }
+  // Moving the string keeps its heap allocation, if any, so this only fails to
+  // align contents that are short enough to be stored inline, or that were
+  // allocated with a smaller alignment.
+  auto owned = absl::make_unique<string>(std::move(*content));
+#if EIGEN_MAX_ALIGN_BYTES > 0
+  if (reinterpret_cast<intptr_t>(owned->data()) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    *content = std::move(*owned);
+    return nullptr;
+  }
+#endif
+  return new ProtoContentBuffer(std::move(owned));
+}
+
 Tensor Tensor::Slice(int64 start, int64 limit) const {
   CHECK_GE(dims(), 1);
   CHECK_LE(0, start);
@@ -949,6 +993,32 @@ bool Tensor::FromProto(Allocator* a, const TensorProto& proto) {
   return true;
 }
 
+bool Tensor::FromProto(TensorProto&& proto) {
+  if (proto.tensor_content().empty() ||
+      !TensorShape::IsValid(proto.tensor_shape()) ||
+      proto.dtype() == DT_INVALID) {
+    return FromProto(get_default_cpu_allocator(), proto);
+  }
+  TensorShape shape(proto.tensor_shape());
+  TensorBuffer* p = nullptr;
+  CASES_WITH_DEFAULT(proto.dtype(),
+                     p = AliasTensorContent<T>(proto.mutable_tensor_content(),
+                                               shape.num_elements()),
+                     {}, {});
+  if (p == nullptr) {
+    return FromProto(get_default_cpu_allocator(), proto);
+  }
+  shape_ = shape;
+  set_dtype(proto.dtype());
+  UnrefIfNonNull(buf_);
+  buf_ = p;
+  if (MemoryLoggingEnabled() && buf_->data() != nullptr) {
+    LogMemory::RecordTensorAllocation("Unknown (from Proto)",
+                                      LogMemory::UNKNOWN_STEP_ID, *this);
+  }
+  return true;
+}
+
 void Tensor::AsProtoField(TensorProto* proto) const {
   proto->Clear();
   shape_.AsProto(proto->mutable_tensor_shape());
@@ -361,6 +361,12 @@ class Tensor {
   bool FromProto(const TensorProto& other) TF_MUST_USE_RESULT;
   bool FromProto(Allocator* a, const TensorProto& other) TF_MUST_USE_RESULT;
 
+  /// \brief Like `FromProto(other)`, but avoids copying a POD
+  /// `other.tensor_content()`: when its bytes are suitably aligned, the tensor
+  /// takes the string over from `other` and aliases it. `other` is left in an
+  /// unspecified state.
+  bool FromProto(TensorProto&& other) TF_MUST_USE_RESULT;
+
   /// \brief Fills in `proto` with `*this` tensor's content.
   ///
   /// `AsProtoField()` fills in the repeated field for `proto.dtype()`, while
@@ -324,6 +324,45 @@ TEST(Tensor_Variant, Marshal) {
   EXPECT_FLOAT_EQ(out->scalar<float>()(), 42.0f);
 }
 
+TEST(Tensor_Float, FromProtoRvalue) {
+  Tensor t(DT_FLOAT, TensorShape({16, 64}));
+  t.flat<float>().setRandom();
+  TensorProto proto;
+  t.AsProtoTensorContent(&proto);
+  const char* content = proto.tensor_content().data();
+
+  Tensor t2;
+  ASSERT_TRUE(t2.FromProto(std::move(proto)));
+  test::ExpectTensorEqual<float>(t, t2);
+  EXPECT_TRUE(t2.IsAligned());
+  // The content is either aliased or, if misaligned, copied.
+  if (t2.tensor_data().data() == content) {
+    EXPECT_TRUE(proto.tensor_content().empty());
+  } else {
+    EXPECT_EQ(proto.tensor_content().size(), t.TotalBytes());
+  }
+}
+
+TEST(Tensor_Float, FromProtoRvalueWithWrongSize) {
+  Tensor t(DT_FLOAT, TensorShape({4}));
+  TensorProto proto;
+  t.AsProtoTensorContent(&proto);
+  proto.mutable_tensor_shape()->mutable_dim(0)->set_size(5);
+
+  Tensor t2;
+  EXPECT_FALSE(t2.FromProto(std::move(proto)));
+}
+
+TEST(Tensor_String, FromProtoRvalue) {
+  Tensor t = test::AsTensor<tstring>({"a", "bc"});
+  TensorProto proto;
+  t.AsProtoTensorContent(&proto);
+
+  Tensor t2;
+  ASSERT_TRUE(t2.FromProto(std::move(proto)));
+  test::ExpectTensorEqual<tstring>(t, t2);
+}
+
 TEST(Tensor_UInt16, Simple) {
   Tensor t(DT_UINT16, TensorShape({2, 2}));
   EXPECT_TRUE(t.shape().IsSameSize(TensorShape({2, 2})));
@@ -1567,6 +1606,22 @@ static void BM_FromProto(int iters, int size) {
 }
 BENCHMARK(BM_FromProto)->Range(1, 1 << 20);
 
+static void BM_FromProtoTensorContentRvalue(int iters, int size) {
+  testing::StopTiming();
+  Tensor a(cpu_allocator(), DT_FLOAT, TensorShape({size}));
+  std::fill_n(a.flat<float>().data(), size, 42.0f);
+  TensorProto p;
+  a.AsProtoTensorContent(&p);
+  while (--iters) {
+    TensorProto copy = p;
+    testing::StartTiming();
+    Tensor b;
+    ASSERT_TRUE(b.FromProto(std::move(copy)));
+    testing::StopTiming();
+  }
+}
+BENCHMARK(BM_FromProtoTensorContentRvalue)->Range(1, 1 << 20);
+
 static void BM_FromProtoCompressed(int iters, int size) {
   testing::StopTiming();
   TensorShape shape({size});
@@ -428,15 +428,20 @@ Node* Graph::AddNode(NodeDef node_def, Status* status) {
     return nullptr;
   }
 
-  Node::NodeClass node_class = op_reg_data->is_function_op
-                                   ? Node::NC_FUNCTION_OP
-                                   : Node::GetNodeClassForOp(node_def.op());
-
-  Node* node = AllocateNode(
+  return AddNode(
       std::make_shared<NodeProperties>(&op_reg_data->op_def,
                                        std::move(node_def), inputs, outputs),
-      nullptr, node_class);
-  return node;
+      *op_reg_data);
+}
+
+Node* Graph::AddNode(std::shared_ptr<NodeProperties> props,
+                     const OpRegistrationData& op_reg_data) {
+  DCHECK_EQ(props->op_def, &op_reg_data.op_def);
+  Node::NodeClass node_class =
+      op_reg_data.is_function_op
+          ? Node::NC_FUNCTION_OP
+          : Node::GetNodeClassForOp(props->node_def.op());
+  return AllocateNode(std::move(props), nullptr, node_class);
 }
 
 Node* Graph::CopyNode(const Node* node) {
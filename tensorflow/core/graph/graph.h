@@ -505,6 +505,13 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(NodeDef node_def, Status* status);
 
+  // Adds a new node with `props`, whose Op and input/output types were already
+  // looked up in `op_reg_data`, an entry of this graph's op registry. Lets
+  // callers such as the GraphDef importer do that work ahead of time, e.g. in
+  // parallel.
+  Node* AddNode(std::shared_ptr<NodeProperties> props,
+                const OpRegistrationData& op_reg_data);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
@@ -2337,6 +2337,12 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
                                         bool aggressive_shape_inference,
                                         bool include_input_tensor_values,
                                         bool include_output_tensor_values) {
+  inferred_statically_ = true;
+  assume_valid_feeds_ = assume_valid_feeds;
+  aggressive_shape_inference_ = aggressive_shape_inference;
+  include_input_tensor_values_ = include_input_tensor_values;
+  include_output_tensor_values_ = include_output_tensor_values;
+
   FunctionLibraryDefinition function_library(OpRegistry::Global(),
                                              item_.graph.library());
   absl::flat_hash_map<string, absl::flat_hash_set<int>> fed_ports;
@@ -2572,6 +2578,200 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   return Status::OK();
 }
 
+Status GraphProperties::UpdateStatically(
+    const absl::flat_hash_set<string>& changed_nodes) {
+  if (!inferred_statically_) {
+    return errors::FailedPrecondition(
+        "UpdateStatically() requires a previous call to InferStatically().");
+  }
+  const auto infer_from_scratch = [this]() {
+    VLOG(2) << "Inferring the properties of the whole graph again.";
+    Clear();
+    return InferStatically(assume_valid_feeds_, aggressive_shape_inference_,
+                           include_input_tensor_values_,
+                           include_output_tensor_values_);
+  };
+
+  // Find the nodes whose properties might have changed: the transitive fanout
+  // of the changed nodes that are still in the graph.
+  GraphView graph_view(&item_.graph);
+  absl::flat_hash_set<const NodeDef*> cone;
+  std::vector<const NodeDef*> stack;
+  for (const string& node_name : changed_nodes) {
+    const NodeDef* node = graph_view.GetNode(node_name);
+    if (node == nullptr) {
+      input_properties_.erase(node_name);
+      output_properties_.erase(node_name);
+      incompatible_shape_nodes_.erase(node_name);
+    } else if (cone.insert(node).second) {
+      stack.push_back(node);
+    }
+  }
+  while (!stack.empty()) {
+    const NodeDef* node = stack.back();
+    stack.pop_back();
+    // The shapes of queue elements flow from enqueue to dequeue nodes through
+    // the queue resource, not along the edges of the graph.
+    if (IsQueue(*node) || IsEnqueue(*node) || IsDequeue(*node)) {
+      return infer_from_scratch();
+    }
+    for (const GraphView::InputPort& fanout :
+         graph_view.GetFanouts(*node, false)) {
+      if (cone.insert(fanout.node).second) stack.push_back(fanout.node);
+    }
+  }
+  if (cone.empty()) return Status::OK();
+  if (2 * cone.size() > item_.graph.node_size()) return infer_from_scratch();
+
+  // Build a graph of the nodes in the cone, in which every output of a node
+  // outside of the cone is replaced by a node with the same properties: a
+  // constant if its value is known, or a placeholder otherwise.
+  GrapplerItem cone_item;
+  cone_item.id = item_.id;
+  *cone_item.graph.mutable_versions() = item_.graph.versions();
+  absl::flat_hash_map<string, string> boundary_nodes;
+  // The names of the boundary nodes, and the shapes they stand for.
+  std::vector<std::pair<string, TensorShapeProto>> boundary_shapes;
+  for (const NodeDef& node : item_.graph.node()) {
+    if (!cone.contains(&node)) continue;
+    NodeDef* cone_node = cone_item.graph.add_node();
+    *cone_node = node;
+    cone_node->clear_input();
+    for (const string& input : node.input()) {
+      const TensorId tensor = ParseTensorName(input);
+      const NodeDef* fanin = graph_view.GetNode(tensor.node());
+      if (fanin != nullptr && cone.contains(fanin)) {
+        cone_node->add_input(input);
+        continue;
+      }
+      // Control dependencies don't carry shapes.
+      if (tensor.index() < 0) continue;
+      const std::vector<OpInfo::TensorProperties>& fanin_properties =
+          GetOutputProperties(string(tensor.node()));
+      if (tensor.index() >= static_cast<int>(fanin_properties.size())) {
+        return infer_from_scratch();
+      }
+      const string tensor_name = tensor.ToString();
+      auto it = boundary_nodes.find(tensor_name);
+      if (it == boundary_nodes.end()) {
+        string boundary_name =
+            strings::StrCat("GraphProperties/boundary_", boundary_nodes.size());
+        while (graph_view.GetNode(boundary_name) != nullptr) {
+          boundary_name = strings::StrCat(boundary_name, "_");
+        }
+        const OpInfo::TensorProperties& properties =
+            fanin_properties[tensor.index()];
+        NodeDef* boundary_node = cone_item.graph.add_node();
+        boundary_node->set_name(boundary_name);
+        (*boundary_node->mutable_attr())["dtype"].set_type(properties.dtype());
+        if (properties.has_value()) {
+          boundary_node->set_op("Const");
+          *(*boundary_node->mutable_attr())["value"].mutable_tensor() =
+              properties.value();
+        } else {
+          boundary_node->set_op("Placeholder");
+          TensorShapeProto* shape =
+              (*boundary_node->mutable_attr())["shape"].mutable_shape();
+          *shape = properties.shape();
+          for (auto& dim : *shape->mutable_dim()) {
+            if (dim.size() < -1) dim.set_size(-1);
+          }
+        }
+        boundary_shapes.emplace_back(boundary_name, properties.shape());
+        it = boundary_nodes.emplace(tensor_name, boundary_name).first;
+      }
+      cone_node->add_input(it->second);
+    }
+  }
+  for (const auto& feed : item_.feed) {
+    const NodeDef* node =
+        graph_view.GetNode(ParseTensorName(feed.first).node());
+    if (node != nullptr && cone.contains(node)) cone_item.feed.push_back(feed);
+  }
+  if (item_.graph.library().function_size() > 0) {
+    *cone_item.graph.mutable_library() =
+        FunctionLibraryDefinition(OpRegistry::Global(), item_.graph.library())
+            .ReachableDefinitions(cone_item.graph)
+            .ToProto();
+  }
+
+  VLOG(2) << "Inferring the properties of " << cone.size() << " of "
+          << item_.graph.node_size() << " nodes again.";
+  GraphProperties cone_properties(cone_item);
+  TF_RETURN_IF_ERROR(cone_properties.InferStatically(
+      assume_valid_feeds_, aggressive_shape_inference_,
+      include_input_tensor_values_, include_output_tensor_values_));
+
+  // The symbolic dimensions of the cone are numbered independently of the rest
+  // of the graph. Translate the ones that come from the boundary back to the
+  // dimensions they stand for, and give the others unused numbers.
+  int64 next_symbolic_dim = -2;
+  for (const auto* properties_map : {&input_properties_, &output_properties_}) {
+    for (const auto& node_properties : *properties_map) {
+      for (const OpInfo::TensorProperties& properties :
+           node_properties.second) {
+        for (const auto& dim : properties.shape().dim()) {
+          next_symbolic_dim =
+              std::min<int64>(next_symbolic_dim, dim.size() - 1);
+        }
+      }
+    }
+  }
+  absl::flat_hash_map<int64, int64> symbolic_dims;
+  for (const auto& boundary : boundary_shapes) {
+    const std::vector<OpInfo::TensorProperties>& boundary_properties =
+        cone_properties.GetOutputProperties(boundary.first);
+    if (boundary_properties.size() != 1) continue;
+    const TensorShapeProto& cone_shape = boundary_properties[0].shape();
+    const TensorShapeProto& shape = boundary.second;
+    if (cone_shape.unknown_rank() || shape.unknown_rank() ||
+        cone_shape.dim_size() != shape.dim_size()) {
+      continue;
+    }
+    for (int i = 0; i < shape.dim_size(); ++i) {
+      if (cone_shape.dim(i).size() < -1 && shape.dim(i).size() < -1) {
+        symbolic_dims.emplace(cone_shape.dim(i).size(), shape.dim(i).size());
+      }
+    }
+  }
+  const auto translate =
+      [&](const std::vector<OpInfo::TensorProperties>& cone_node_properties) {
+        std::vector<OpInfo::TensorProperties> node_properties =
+            cone_node_properties;
+        for (OpInfo::TensorProperties& properties : node_properties) {
+          for (auto& dim : *properties.mutable_shape()->mutable_dim()) {
+            if (dim.size() >= -1) continue;
+            auto it = symbolic_dims.find(dim.size());
+            if (it == symbolic_dims.end()) {
+              it = symbolic_dims.emplace(dim.size(), next_symbolic_dim--).first;
+            }
+            dim.set_size(it->second);
+          }
+        }
+        return node_properties;
+      };
+
+  for (const NodeDef& node : item_.graph.node()) {
+    if (!cone.contains(&node)) continue;
+    const string& node_name = node.name();
+    input_properties_.erase(node_name);
+    output_properties_.erase(node_name);
+    incompatible_shape_nodes_.erase(node_name);
+    if (cone_properties.HasInputProperties(node_name)) {
+      input_properties_[node_name] =
+          translate(cone_properties.GetInputProperties(node_name));
+    }
+    if (cone_properties.HasOutputProperties(node_name)) {
+      output_properties_[node_name] =
+          translate(cone_properties.GetOutputProperties(node_name));
+    }
+    if (cone_properties.CheckShapeIncompatible(node_name)) {
+      incompatible_shape_nodes_.insert(node_name);
+    }
+  }
+  return Status::OK();
+}
+
 Status GraphProperties::InferDynamically(Cluster* cluster) {
   TF_RETURN_IF_ERROR(cluster->Initialize(item_));
 
@@ -2671,5 +2871,11 @@ void GraphProperties::ClearOutputProperties(const string& node_name) {
   output_properties_.erase(node_name);
 }
 
+void GraphProperties::Clear() {
+  input_properties_.clear();
+  output_properties_.clear();
+  incompatible_shape_nodes_.clear();
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
@@ -114,6 +115,16 @@ class GraphProperties {
                            /*aggressive_shape_inference=*/false,
                            /*include_tensor_values=*/true);
   }
+  // Updates the properties after the nodes in `changed_nodes` have been added
+  // to, modified in, or removed from the graph of the item (for example
+  // through a MutableGraphView), with the options of the last call to
+  // InferStatically(). Only the transitive fanout of the changed nodes is
+  // inferred again, starting from the properties already known for its
+  // inputs, so the properties object can be kept up to date across graph
+  // rewrites. Nodes whose inputs were rewired count as modified. Falls back to
+  // inferring the whole graph again when the fanout covers most of the graph
+  // or contains queue ops, whose shapes don't flow along edges.
+  Status UpdateStatically(const absl::flat_hash_set<string>& changed_nodes);
   // Infer the shape by running the graph on the specified cluster and recording
   // the shapes of the processed tensors.
   Status InferDynamically(Cluster* cluster);
@@ -199,8 +210,17 @@ class GraphProperties {
           resource_handles,
       int num_loops) const;
 
+  // Discards all the properties.
+  void Clear();
+
   // Data members
   const GrapplerItem& item_;
+  // The options of the last call to InferStatically(), if any.
+  bool inferred_statically_ = false;
+  bool assume_valid_feeds_ = false;
+  bool aggressive_shape_inference_ = false;
+  bool include_input_tensor_values_ = false;
+  bool include_output_tensor_values_ = false;
   absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>
       input_properties_;
   absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
 #include "tensorflow/core/grappler/inputs/utils.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -215,6 +216,59 @@ TEST_F(GraphPropertiesTest, ClearProperties) {
   }
 }
 
+TEST_F(GraphPropertiesTest, UpdateStatically) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 10}));
+  Output y = ops::Relu(s.WithOpName("y"), x);
+  Output perm = ops::Const(s.WithOpName("perm"), {1, 0}, {2});
+  Output t = ops::Transpose(s.WithOpName("t"), y, perm);
+  Output z = ops::Identity(s.WithOpName("z"), y);
+  Output w = ops::Square(s.WithOpName("w"), z);
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphProperties properties(item);
+  EXPECT_TRUE(errors::IsFailedPrecondition(properties.UpdateStatically({})));
+  TF_ASSERT_OK(properties.InferStatically(false));
+  EXPECT_EQ("float: [-1,10]",
+            PropToString(properties.GetOutputProperties("w")[0]));
+
+  // Make z the transpose of y.
+  MutableGraphView graph(&item.graph);
+  TF_ASSERT_OK(graph.UpdateRegularFaninByPort("z", 0, {"t", 0}));
+  TF_ASSERT_OK(properties.UpdateStatically({"z"}));
+
+  GraphProperties expected_properties(item);
+  TF_ASSERT_OK(expected_properties.InferStatically(false));
+  for (const NodeDef& node : item.graph.node()) {
+    const auto& props = properties.GetOutputProperties(node.name());
+    const auto& expected_props =
+        expected_properties.GetOutputProperties(node.name());
+    ASSERT_EQ(expected_props.size(), props.size()) << node.name();
+    for (int i = 0; i < props.size(); ++i) {
+      EXPECT_EQ(PropToString(expected_props[i]), PropToString(props[i]))
+          << node.name();
+    }
+  }
+  // The symbolic dimension of x is still the same in the updated nodes.
+  const int64 batch_dim =
+      properties.GetOutputProperties("x")[0].shape().dim(0).size();
+  EXPECT_LT(batch_dim, -1);
+  const auto& z_props = properties.GetOutputProperties("z");
+  EXPECT_EQ(10, z_props[0].shape().dim(0).size());
+  EXPECT_EQ(batch_dim, z_props[0].shape().dim(1).size());
+  const auto& w_props = properties.GetOutputProperties("w");
+  EXPECT_EQ(batch_dim, w_props[0].shape().dim(1).size());
+
+  // The properties of removed nodes are discarded.
+  TF_ASSERT_OK(graph.DeleteNodes({"w"}));
+  TF_ASSERT_OK(properties.UpdateStatically({"w"}));
+  EXPECT_FALSE(properties.HasInputProperties("w"));
+  EXPECT_FALSE(properties.HasOutputProperties("w"));
+  EXPECT_TRUE(properties.HasOutputProperties("z"));
+}
+
 TEST_F(GraphPropertiesTest, DynamicProperties) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false,
                                           cluster_->GetDeviceNames());
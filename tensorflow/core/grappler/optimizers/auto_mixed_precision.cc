@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -1942,6 +1943,14 @@ int GetNumGPUs(const Cluster& cluster,
   return num_gpus;
 }
 
+// Returns true if the CPU has native bfloat16 dot products. Without them,
+// MKL emulates bfloat16 with float32 arithmetic, and the conversions make the
+// graph slower.
+bool HasNativeBfloat16Support() {
+  return port::TestCPUFeature(port::CPUFeature::AVX512_BF16) ||
+         port::TestCPUFeature(port::CPUFeature::AMX_BF16);
+}
+
 }  // end namespace
 
 Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -1973,6 +1982,12 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
                  << " graph optimizer";
     return Status::OK();
   }
+  if (mode_ == AutoMixedPrecisionMode::MKL && !ShouldIgnorePerformance() &&
+      !HasNativeBfloat16Support()) {
+    LOG(WARNING) << "The CPU does not support bfloat16 natively, skipping "
+                 << name() << " graph optimizer";
+    return Status::OK();
+  }
 
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
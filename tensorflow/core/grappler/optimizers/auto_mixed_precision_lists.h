@@ -402,12 +402,20 @@ class AutoMixedPrecisionListsMkl : public AutoMixedPrecisionLists {
   }
 
   gtl::FlatSet<string> DenyList() override {
+    // bfloat16 has fewer bits of mantissa than float16, so ops that lose
+    // precision by accumulating, or near zero, are also kept in float32.
     auto list = gtl::FlatSet<string>{
+        "Cumprod",
+        "Cumsum",
         "Exp",
         "Expm1",
         "L2Loss",
+        "Log",
+        "Log1p",
+        "LogSoftmax",
         "Mean",
         "Pow",
+        "Prod",
         "SaveV2",
         "Softmax",
         "SoftmaxCrossEntropyWithLogits",
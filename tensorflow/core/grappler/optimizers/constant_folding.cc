@@ -188,11 +188,13 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
 
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
                                  DeviceBase* cpu_device,
-                                 bool disable_compressed_tensor_optimization)
+                                 bool disable_compressed_tensor_optimization,
+                                 int64 max_constant_size_in_bytes)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
       disable_compressed_tensor_optimization_(
-          disable_compressed_tensor_optimization) {
+          disable_compressed_tensor_optimization),
+      max_constant_size_in_bytes_(max_constant_size_in_bytes) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -1008,7 +1010,8 @@ bool ConstantFolding::IsFoldableUncached(
       if (output_shape.IsFullyDefined()) {
         const int64 num_bytes =
             output_shape.num_elements() * DataTypeSize(output_prop.dtype());
-        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize) {
+        if (num_bytes > input_size_bytes &&
+            num_bytes > max_constant_size_in_bytes_) {
           // Do not fold nodes if the in-memory size of output is too large.
           // Notice that this is not exactly the same check used in
           // CreateNodeDef() where the actual encoded size is checked.
@@ -1212,7 +1215,8 @@ bool IsValidConstShapeForMulConvPushDown(
 // static
 Status ConstantFolding::CreateNodeDef(const string& name,
                                       const TensorValue& tensor, NodeDef* node,
-                                      size_t original_size) {
+                                      size_t original_size,
+                                      int64 max_constant_size) {
   node->set_name(name);
   node->set_op("Const");
 
@@ -1291,10 +1295,10 @@ Status ConstantFolding::CreateNodeDef(const string& name,
   }
   node->mutable_attr()->insert({"value", attr_tensor});
 
-  if (encoded_size > original_size && encoded_size >= kMaxConstantSize) {
+  if (encoded_size > original_size && encoded_size >= max_constant_size) {
     return errors::InvalidArgument(
         strings::StrCat("Can't fold ", name, ", its size would be too large (",
-                        encoded_size, " >= ", kMaxConstantSize, " bytes)"));
+                        encoded_size, " >= ", max_constant_size, " bytes)"));
   }
   return Status::OK();
 }
@@ -1358,7 +1362,7 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     }
     if (output_tensors[i].tensor) {
       Status s = CreateNodeDef(node_name, output_tensors[i], &outputs->at(i),
-                               total_inputs_size);
+                               total_inputs_size, max_constant_size_in_bytes_);
       if (!s.ok()) {
         *result_too_large = true;
         return s;
@@ -41,14 +41,18 @@ class ConstantFolding : public GraphOptimizer {
   // The size limit will only be considered if the newly created node is greater
   // than original_size (optional).
   static Status CreateNodeDef(const string& name, const TensorValue& tensor,
-                              NodeDef* node, size_t original_size = 0);
+                              NodeDef* node, size_t original_size = 0,
+                              int64 max_constant_size = kMaxConstantSize);
   static string AddControlDependency(const string& input_name, GraphDef* graph,
                                      NodeMap* node_map);
 
   explicit ConstantFolding(DeviceBase* cpu_device,
                            bool disable_compressed_tensor_optimization = false);
+  // max_constant_size_in_bytes: The size of the largest constant created by
+  //   folding nodes whose outputs are larger than their inputs.
   ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device,
-                  bool disable_compressed_tensor_optimization = false);
+                  bool disable_compressed_tensor_optimization = false,
+                  int64 max_constant_size_in_bytes = kMaxConstantSize);
 
   ~ConstantFolding() override {}
 
@@ -340,6 +344,7 @@ class ConstantFolding : public GraphOptimizer {
   bool graph_modified_;
   bool graph_contains_assign_or_inplace_op_;
   bool disable_compressed_tensor_optimization_;
+  int64 max_constant_size_in_bytes_;
 };
 
 }  // end namespace grappler
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
 
+#include <algorithm>
+
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -56,6 +58,8 @@ constexpr char kParallelMapOp[] = "ParallelMapDataset";
 constexpr char kParallelMapV2Op[] = "ParallelMapDatasetV2";
 constexpr char kChooseFastestOp[] = "ChooseFastestBranchDataset";
 constexpr char kPrefetchOp[] = "PrefetchDataset";
+constexpr char kMapDefunOp[] = "MapDefun";
+constexpr char kJitCompileAttr[] = "jit_compile";
 
 // Returns a FunctionDef containing a MapDefun op that wraps the original
 // function.
@@ -306,6 +310,15 @@ Status AddNewMapNode(const NodeDef& old_map_node, const NodeDef& old_batch_node,
   if (old_map_node.attr().contains("deterministic")) {
     graph_utils::CopyAttribute("deterministic", old_map_node, &map_node);
   }
+  // Only compile the vectorized function if it was fully vectorized, since
+  // XLA cannot compile the per-element loop of a `MapDefun` node.
+  if (old_map_node.attr().contains(kJitCompileAttr) &&
+      std::none_of(vectorized_func.node_def().begin(),
+                   vectorized_func.node_def().end(), [](const NodeDef& node) {
+                     return node.op() == kMapDefunOp;
+                   })) {
+    graph_utils::CopyAttribute(kJitCompileAttr, old_map_node, &map_node);
+  }
   *new_map_node = graph->AddNode(std::move(map_node));
   return Status::OK();
 }
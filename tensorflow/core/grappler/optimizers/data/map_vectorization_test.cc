@@ -586,6 +586,26 @@ TEST(MapVectorizationTest, VectorizeWithUndefinedOutputTypes) {
       input_node->name());
 }
 
+TEST(MapVectorizationTest, VectorizeKeepsJitCompile) {
+  // Tests that a fully vectorized map is still compiled with XLA.
+  GrapplerItem item;
+  MutableGraphView graph(&item.graph);
+  auto range_node = AddRangeNode(&graph);
+  auto map_fn = AddMapFn(&graph);
+  auto map_node =
+      AddMapNode(&graph, range_node->name(), map_fn->signature().name());
+  (*map_node->mutable_attr())["jit_compile"].set_b(true);
+  auto batch_node = AddBatchNode(&graph, map_node->name());
+  GraphDef output;
+  TF_ASSERT_OK(OptimizeWithMapVectorization(item, &output, false));
+  CheckVectorizedWithoutChooseFastest(
+      output, /*expected_vectorized_branch=*/{batch_node->op(), kMapOp},
+      range_node->name());
+  const NodeDef& vectorized_map_node =
+      output.node(graph_utils::FindGraphNodeWithOp(kMapOp, output));
+  EXPECT_TRUE(vectorized_map_node.attr().at("jit_compile").b());
+}
+
 // TODO(rachelim): Add test that has a polymorphic function.
 
 }  // namespace
@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr int kSerializedInput = 0;
+constexpr int kFirstKeysInput = 2;
+constexpr int kFirstDenseDefaultsInput = 5;
+
+// Sets `*is_scalar` to whether the `_output_shapes` of the node producing
+// input `index` of `node` (e.g. the function argument it is read from) show
+// that the input is a scalar.
+Status IsKnownScalarInput(const Node& node, int index, bool* is_scalar) {
+  *is_scalar = false;
+  const Edge* edge;
+  TF_RETURN_IF_ERROR(node.input_edge(index, &edge));
+  std::vector<PartialTensorShape> output_shapes;
+  if (!GetNodeAttr(edge->src()->attrs(), "_output_shapes", &output_shapes)
+           .ok() ||
+      edge->src_output() >= static_cast<int>(output_shapes.size())) {
+    return Status::OK();
+  }
+  const PartialTensorShape& shape = output_shapes[edge->src_output()];
+  *is_scalar = shape.dims() == 0;
+  return Status::OK();
+}
+
+// A ParseExampleV2 node that parses a scalar `serialized` input is vectorized
+// into a ParseExampleV2 node that parses the whole batch of serialized
+// examples at once. This lets `map(parse_single_example).batch(n)` parse a
+// minibatch of examples with a single kernel invocation, writing dense
+// features directly into the batched output tensors.
+//
+// Ragged features are not supported, because the row splits of a scalar parse
+// do not stack into the row splits of a batched parse.
+class ParseExampleV2Vectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    std::vector<DataType> ragged_value_types;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node.attrs(), "ragged_value_types", &ragged_value_types));
+    if (!ragged_value_types.empty()) {
+      return errors::Unimplemented(
+          "Cannot vectorize ParseExampleV2 with ragged features.");
+    }
+
+    // A batch of serialized examples is parsed into outputs with different
+    // shapes, which do not stack, so only scalar inputs are vectorized.
+    bool is_scalar;
+    TF_RETURN_IF_ERROR(IsKnownScalarInput(node, kSerializedInput, &is_scalar));
+    if (!is_scalar) {
+      return errors::Unimplemented(
+          "Cannot vectorize ParseExampleV2 unless `serialized` is known to be "
+          "a scalar.");
+    }
+
+    NodeBuilder::NodeOut serialized;
+    TF_RETURN_IF_ERROR(inputs.stacked(kSerializedInput, &serialized));
+
+    // The keys and the dense defaults are shared by all the examples of the
+    // batch, so they have to be loop invariant.
+    std::vector<NodeBuilder::NodeOut> keys(3);
+    for (int i = 0; i < 3; ++i) {
+      TF_RETURN_IF_ERROR(inputs.unstacked(kFirstKeysInput + i, &keys[i]));
+    }
+
+    std::vector<NodeBuilder::NodeOut> dense_defaults;
+    dense_defaults.resize(inputs.size() - kFirstDenseDefaultsInput);
+    for (size_t i = kFirstDenseDefaultsInput; i < inputs.size(); ++i) {
+      TF_RETURN_IF_ERROR(
+          inputs.unstacked(i, &dense_defaults[i - kFirstDenseDefaultsInput]));
+    }
+
+    Status scope_status;
+    Scope parent = NewInternalScope(outer_scope, &scope_status, nullptr);
+    Scope s = parent.NewSubScope("vectorize/parse_example_v2");
+
+    // The names of the examples are only used in error messages, and there is
+    // one per example, so they are dropped rather than stacked.
+    Node* names = ops::Const(s, std::initializer_list<string>({})).node();
+    TF_RETURN_IF_ERROR(scope_status);
+
+    Node* new_node;
+    auto node_builder =
+        NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                    "ParseExampleV2")
+            .Input(serialized)
+            .Input(names)
+            .Input(keys[0])
+            .Input(keys[1])
+            .Input(keys[2])
+            .Input(dense_defaults);
+
+    for (const auto& attr :
+         {"num_sparse", "sparse_types", "ragged_value_types",
+          "ragged_split_types", "dense_shapes"}) {
+      const AttrValue* val;
+      TF_RETURN_IF_ERROR(node.attrs().Find(attr, &val));
+      node_builder = node_builder.Attr(attr, *val);
+    }
+
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings
+    for (int i = 0; i < node.num_outputs(); ++i) {
+      outputs->emplace_back(new_node, i, true);
+    }
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("ParseExampleV2", ParseExampleV2Vectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -120,6 +120,16 @@ string GetRetval(const FunctionDef& function_def, int index) {
       function_def.signature().output_arg(index).name());
 }
 
+// Records the shape of an argument of `function_def` as its
+// `_output_shapes`, as function tracing does.
+void SetArgOutputShape(FunctionDef* function_def, int index,
+                       const PartialTensorShape& shape) {
+  AttrValue output_shapes;
+  shape.AsProto(output_shapes.mutable_list()->add_shape());
+  (*(*function_def->mutable_arg_attr())[index].mutable_attr())
+      ["_output_shapes"] = output_shapes;
+}
+
 ///==================================//
 // Tests for vectorization framework //
 ///==================================//
@@ -1332,6 +1342,132 @@ TEST(VectorizerTest, VectorizeParseSingleExampleWithStackedDefaults) {
       function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
 }
 
+TEST(VectorizerTest, VectorizeParseExampleV2) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: string"},
+      /*out_def=*/
+      {"si0: int64", "sv0: int64", "ss0: int64", "dv0: int64", "dv1: string"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const("Names", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("SparseKeys",
+                                gtl::ArraySlice<tstring>({"spar_int"})),
+       FunctionDefHelper::Const(
+           "DenseKeys", gtl::ArraySlice<tstring>({"dense_int", "dense_str"})),
+       FunctionDefHelper::Const("RaggedKeys", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("DenseIntDefault", static_cast<int64>(0)),
+       FunctionDefHelper::Const("DenseStrDefault", tstring("")),
+       {{"Parse"},
+        "ParseExampleV2",
+        {"arg0", "Names:output:0", "SparseKeys:output:0", "DenseKeys:output:0",
+         "RaggedKeys:output:0", "DenseIntDefault:output:0",
+         "DenseStrDefault:output:0"},
+        {
+            {"Tdense", DataTypeVector({DT_INT64, DT_STRING})},
+            {"dense_shapes", gtl::ArraySlice<TensorShape>({}, {})},
+            {"num_sparse", 1},
+            {"sparse_types", DataTypeVector({DT_INT64})},
+            {"ragged_value_types", DataTypeVector({})},
+            {"ragged_split_types", DataTypeVector({})},
+        }}},
+      /*ret_def=*/
+      {
+          {"si0", "Parse:sparse_indices:0"},
+          {"sv0", "Parse:sparse_values:0"},
+          {"ss0", "Parse:sparse_shapes:0"},
+          {"dv0", "Parse:dense_values:0"},
+          {"dv1", "Parse:dense_values:1"},
+      });
+  SetArgOutputShape(&inner, 0, PartialTensorShape({}));
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_TRUE(
+      !function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  EXPECT_TRUE(function_utils::ContainsFunctionNodeWithOp("ParseExampleV2",
+                                                         *vectorized));
+}
+
+// ParseExampleV2 of a vector of serialized examples adds a dimension to the
+// dense values, and its sparse indices and shapes do not stack.
+TEST(VectorizerTest, VectorizeParseExampleV2WithNonScalarInput) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: string"},
+      /*out_def=*/{"dv0: int64"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const("Names", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("SparseKeys", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("DenseKeys",
+                                gtl::ArraySlice<tstring>({"dense_int"})),
+       FunctionDefHelper::Const("RaggedKeys", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("DenseIntDefault", static_cast<int64>(0)),
+       {{"Parse"},
+        "ParseExampleV2",
+        {"arg0", "Names:output:0", "SparseKeys:output:0", "DenseKeys:output:0",
+         "RaggedKeys:output:0", "DenseIntDefault:output:0"},
+        {
+            {"Tdense", DataTypeVector({DT_INT64})},
+            {"dense_shapes", gtl::ArraySlice<TensorShape>({TensorShape({})})},
+            {"num_sparse", 0},
+            {"sparse_types", DataTypeVector({})},
+            {"ragged_value_types", DataTypeVector({})},
+            {"ragged_split_types", DataTypeVector({})},
+        }}},
+      /*ret_def=*/{{"dv0", "Parse:dense_values:0"}});
+
+  for (const PartialTensorShape& shape :
+       {PartialTensorShape({2}), PartialTensorShape()}) {
+    FunctionDef inner_with_shape = inner;
+    SetArgOutputShape(&inner_with_shape, 0, shape);
+    FunctionDefLibrary lib;
+    FunctionDef* vectorized;
+    TF_ASSERT_OK(WrapAndVectorize(inner_with_shape, &lib, &vectorized));
+    EXPECT_TRUE(
+        function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+  }
+}
+
+TEST(VectorizerTest, VectorizeParseExampleV2WithRaggedFeatures) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: string"},
+      /*out_def=*/{"rv0: int64", "rs0: int64"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {FunctionDefHelper::Const("Names", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("SparseKeys", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("DenseKeys", gtl::ArraySlice<tstring>({})),
+       FunctionDefHelper::Const("RaggedKeys",
+                                gtl::ArraySlice<tstring>({"ragged_int"})),
+       {{"Parse"},
+        "ParseExampleV2",
+        {"arg0", "Names:output:0", "SparseKeys:output:0", "DenseKeys:output:0",
+         "RaggedKeys:output:0"},
+        {
+            {"Tdense", DataTypeVector({})},
+            {"dense_shapes", gtl::ArraySlice<TensorShape>({})},
+            {"num_sparse", 0},
+            {"sparse_types", DataTypeVector({})},
+            {"ragged_value_types", DataTypeVector({DT_INT64})},
+            {"ragged_split_types", DataTypeVector({DT_INT64})},
+        }}},
+      /*ret_def=*/
+      {
+          {"rv0", "Parse:ragged_values:0"},
+          {"rs0", "Parse:ragged_row_splits:0"},
+      });
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized));
+  EXPECT_TRUE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *vectorized));
+}
+
 TEST(VectorizerTest, VectorizeTranspose) {
   FunctionDef inner = FunctionDefHelper::Create(
       /*function_name=*/"inner_function",
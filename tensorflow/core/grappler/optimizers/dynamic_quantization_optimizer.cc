@@ -0,0 +1,173 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/dynamic_quantization_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/tpu.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kDynamicQuantizedMatMul[] = "_DynamicQuantizedMatMul";
+
+// Quantizes the [k, n] `weights` (or [n, k] if `transpose`) to [n, k] int8
+// values, with one symmetric scale per output channel.
+void QuantizeWeights(const Tensor& weights, bool transpose, Tensor* quantized,
+                     Tensor* scales) {
+  auto matrix = weights.matrix<float>();
+  const int64 k = weights.dim_size(transpose ? 1 : 0);
+  const int64 n = weights.dim_size(transpose ? 0 : 1);
+  auto value = [&](int64 j, int64 p) {
+    return transpose ? matrix(j, p) : matrix(p, j);
+  };
+
+  *quantized = Tensor(DT_QINT8, TensorShape({n, k}));
+  *scales = Tensor(DT_FLOAT, TensorShape({n}));
+  auto quantized_matrix = quantized->matrix<qint8>();
+  auto scales_vec = scales->vec<float>();
+  for (int64 j = 0; j < n; ++j) {
+    float max_abs = 0;
+    for (int64 p = 0; p < k; ++p) {
+      max_abs = std::max(max_abs, std::abs(value(j, p)));
+    }
+    const float scale = max_abs > 0 ? max_abs / 127 : 1;
+    scales_vec(j) = scale;
+    for (int64 p = 0; p < k; ++p) {
+      const float q = std::round(value(j, p) / scale);
+      quantized_matrix(j, p) =
+          static_cast<int8>(std::min(127.0f, std::max(-127.0f, q)));
+    }
+  }
+}
+
+// Adds a Const node holding `value`, with the device and control inputs of
+// `like`, so that it lives in the same frame.
+NodeDef* AddConstNode(const string& name, const Tensor& value,
+                      const NodeDef& like, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(like.device());
+  for (const string& input : like.input()) {
+    if (IsControlInput(input)) {
+      node->add_input(input);
+    }
+  }
+  (*node->mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent(
+      (*node->mutable_attr())["value"].mutable_tensor());
+  return node;
+}
+
+}  // namespace
+
+Status DynamicQuantizationOptimizer::Optimize(Cluster* cluster,
+                                              const GrapplerItem& item,
+                                              GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  // Skip all TPU graphs.
+  if (IsTPUGraphDef(*optimized_graph)) {
+    return Status::OK();
+  }
+
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  NodeMap node_map(optimized_graph);
+
+  std::vector<NodeDef*> matmuls;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    if (node.op() == "MatMul" && NodeIsOnCpu(&node) &&
+        GetDataTypeFromAttr(node, "T") == DT_FLOAT &&
+        nodes_to_preserve.count(node.name()) == 0) {
+      matmuls.push_back(&node);
+    }
+  }
+
+  std::set<string> nodes_to_delete;
+  for (NodeDef* matmul : matmuls) {
+    if (matmul->input_size() < 2 || IsControlInput(matmul->input(1))) {
+      continue;
+    }
+    const string weights_name = NodeName(matmul->input(1));
+    const NodeDef* weights_node = node_map.GetNode(weights_name);
+    if (weights_node == nullptr || !IsConstant(*weights_node) ||
+        weights_node->device() != matmul->device()) {
+      continue;
+    }
+    Tensor weights;
+    if (!weights.FromProto(weights_node->attr().at("value").tensor()) ||
+        weights.dtype() != DT_FLOAT || weights.dims() != 2 ||
+        weights.NumElements() < min_weights_size_) {
+      continue;
+    }
+    const string quantized_name =
+        strings::StrCat(matmul->name(), "/quantized_weights");
+    const string scales_name =
+        strings::StrCat(matmul->name(), "/weight_scales");
+    if (node_map.NodeExists(quantized_name) ||
+        node_map.NodeExists(scales_name)) {
+      continue;
+    }
+
+    const bool transpose_b = matmul->attr().at("transpose_b").b();
+    Tensor quantized;
+    Tensor scales;
+    QuantizeWeights(weights, transpose_b, &quantized, &scales);
+    VLOG(2) << "Quantizing the weights of " << matmul->name() << " ("
+            << weights.shape().DebugString() << ")";
+
+    NodeDef* quantized_node =
+        AddConstNode(quantized_name, quantized, *weights_node, optimized_graph);
+    NodeDef* scales_node =
+        AddConstNode(scales_name, scales, *weights_node, optimized_graph);
+    node_map.AddNode(quantized_name, quantized_node);
+    node_map.AddNode(scales_name, scales_node);
+
+    // Rewrite the MatMul in place, so that its consumers are unchanged.
+    matmul->set_op(kDynamicQuantizedMatMul);
+    matmul->mutable_attr()->erase("T");
+    matmul->mutable_attr()->erase("transpose_b");
+    matmul->set_input(1, quantized_name);
+    matmul->mutable_input()->Add(string(scales_name));
+    // Keep the control inputs after the regular ones.
+    std::stable_partition(
+        matmul->mutable_input()->begin(), matmul->mutable_input()->end(),
+        [](const string& input) { return !IsControlInput(input); });
+    node_map.RemoveOutput(weights_name, matmul->name());
+    node_map.AddOutput(quantized_name, matmul->name());
+    node_map.AddOutput(scales_name, matmul->name());
+
+    if (node_map.GetOutputs(weights_name).empty() &&
+        nodes_to_preserve.count(weights_name) == 0) {
+      nodes_to_delete.insert(weights_name);
+    }
+  }
+
+  EraseNodesFromGraph(nodes_to_delete, optimized_graph);
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
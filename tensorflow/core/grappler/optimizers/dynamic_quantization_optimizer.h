@@ -0,0 +1,61 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DYNAMIC_QUANTIZATION_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DYNAMIC_QUANTIZATION_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Rewrites float MatMuls on CPU whose weights are constants into
+// _DynamicQuantizedMatMul ops ("dynamic range quantization").
+//
+// The weights are quantized once, when the graph is optimized, to int8 with
+// one scale per output channel. The other input is quantized to int8 on the
+// fly, with one scale per row, and the product is computed with an int8 GEMM
+// and rescaled to float. This trades some accuracy for throughput, so the
+// optimizer is off by default.
+class DynamicQuantizationOptimizer : public GraphOptimizer {
+ public:
+  DynamicQuantizationOptimizer() {}
+  // min_weights_size: MatMuls with fewer weights are left alone, since the
+  //   cost of quantizing their input outweighs the faster GEMM.
+  explicit DynamicQuantizationOptimizer(RewriterConfig::Toggle opt_level,
+                                        int64 min_weights_size = 4096)
+      : min_weights_size_(min_weights_size) {}
+
+  ~DynamicQuantizationOptimizer() override {}
+
+  string name() const override { return "dynamic_quantization"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  int64 min_weights_size_ = 4096;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DYNAMIC_QUANTIZATION_OPTIMIZER_H_
@@ -0,0 +1,137 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/dynamic_quantization_optimizer.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class DynamicQuantizationOptimizerTest : public GrapplerTest {
+ protected:
+  // Builds x * weights for a [8, 128] x and [128, 64] weights on `device`.
+  GrapplerItem MakeItem(const string& device, bool transpose_b) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto x = ops::Placeholder(s.WithOpName("x").WithDevice(device), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 128}));
+    TensorShape weights_shape =
+        transpose_b ? TensorShape({64, 128}) : TensorShape({128, 64});
+    auto weights =
+        ops::Const(s.WithOpName("weights").WithDevice(device),
+                   GenerateTensorWithSetRandom<DT_FLOAT>(weights_shape));
+    auto matmul = ops::MatMul(s.WithOpName("matmul").WithDevice(device), x,
+                              weights, ops::MatMul::TransposeB(transpose_b));
+    auto output = ops::Identity(s.WithOpName("output"), matmul);
+
+    GrapplerItem item;
+    item.fetch = {"output"};
+    item.feed = {{"x", GenerateTensorWithSetRandom<DT_FLOAT>({8, 128})}};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(DynamicQuantizationOptimizerTest, QuantizesConstantWeights) {
+  for (bool transpose_b : {false, true}) {
+    GrapplerItem item = MakeItem("/device:CPU:0", transpose_b);
+
+    DynamicQuantizationOptimizer optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "weights");
+      if (node.name() == "matmul") {
+        ++found;
+        EXPECT_EQ(node.op(), "_DynamicQuantizedMatMul");
+        ASSERT_EQ(node.input_size(), 3);
+        EXPECT_EQ(node.input(0), "x");
+        EXPECT_EQ(node.input(1), "matmul/quantized_weights");
+        EXPECT_EQ(node.input(2), "matmul/weight_scales");
+        EXPECT_EQ(node.attr().count("transpose_b"), 0);
+      } else if (node.name() == "matmul/quantized_weights") {
+        ++found;
+        EXPECT_EQ(node.attr().at("dtype").type(), DT_QINT8);
+        EXPECT_EQ(node.device(), "/device:CPU:0");
+      } else if (node.name() == "matmul/weight_scales") {
+        ++found;
+        EXPECT_EQ(node.attr().at("dtype").type(), DT_FLOAT);
+      }
+    }
+    EXPECT_EQ(found, 3);
+
+    auto expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto actual = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(expected.size(), 1);
+    ASSERT_EQ(actual.size(), 1);
+    // Inputs are in [0, 1), so the products are a few dozen and 8 bit
+    // quantization of both operands costs a few hundredths.
+    test::ExpectClose(actual[0], expected[0], /*atol=*/0.1, /*rtol=*/0.05);
+  }
+}
+
+TEST_F(DynamicQuantizationOptimizerTest, SkipsNonCpuMatMul) {
+  GrapplerItem item = MakeItem("/device:GPU:0", false);
+
+  DynamicQuantizationOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  CompareGraphs(item.graph, output);
+}
+
+TEST_F(DynamicQuantizationOptimizerTest, SkipsSmallWeights) {
+  GrapplerItem item = MakeItem("/device:CPU:0", false);
+
+  DynamicQuantizationOptimizer optimizer(RewriterConfig::ON,
+                                         /*min_weights_size=*/128 * 64 + 1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  CompareGraphs(item.graph, output);
+}
+
+TEST_F(DynamicQuantizationOptimizerTest, KeepsSharedWeights) {
+  GrapplerItem item = MakeItem("/device:CPU:0", false);
+  NodeDef* other = item.graph.add_node();
+  other->set_name("other");
+  other->set_op("Identity");
+  other->add_input("weights");
+  (*other->mutable_attr())["T"].set_type(DT_FLOAT);
+
+  DynamicQuantizationOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  bool found_weights = false;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "weights") found_weights = true;
+    if (node.name() == "matmul") {
+      EXPECT_EQ(node.op(), "_DynamicQuantizedMatMul");
+    }
+  }
+  EXPECT_TRUE(found_weights);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
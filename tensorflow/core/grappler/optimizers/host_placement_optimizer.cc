@@ -0,0 +1,379 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/host_placement_optimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <queue>
+#include <set>
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/tpu.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace internal {
+
+namespace {
+// Arcs with less capacity left are considered saturated.
+constexpr double kEpsilon = 1e-9;
+}  // namespace
+
+MinCut::MinCut(int num_nodes)
+    : source_(num_nodes), sink_(num_nodes + 1), node_arcs_(num_nodes + 2) {}
+
+void MinCut::AddArc(int from, int to, double capacity) {
+  // The reverse arc of arc i is arc i ^ 1.
+  node_arcs_[from].push_back(arcs_.size());
+  arcs_.push_back({to, capacity});
+  node_arcs_[to].push_back(arcs_.size());
+  arcs_.push_back({from, 0});
+}
+
+void MinCut::AddTerminalCosts(int node, double sink_cost, double source_cost) {
+  // The arc from the source is cut if the node is with the sink, and the arc
+  // to the sink is cut if the node is with the source.
+  AddArc(source_, node, sink_cost);
+  AddArc(node, sink_, source_cost);
+}
+
+void MinCut::AddEdge(int from, int to, double cost) {
+  AddArc(from, to, cost);
+}
+
+bool MinCut::ComputeLevels() {
+  level_.assign(node_arcs_.size(), -1);
+  std::queue<int> to_visit;
+  level_[source_] = 0;
+  to_visit.push(source_);
+  while (!to_visit.empty()) {
+    const int node = to_visit.front();
+    to_visit.pop();
+    for (int arc_id : node_arcs_[node]) {
+      const Arc& arc = arcs_[arc_id];
+      if (arc.capacity > kEpsilon && level_[arc.to] < 0) {
+        level_[arc.to] = level_[node] + 1;
+        to_visit.push(arc.to);
+      }
+    }
+  }
+  return level_[sink_] >= 0;
+}
+
+double MinCut::Augment() {
+  // Looks for a path to the sink in the level graph iteratively, since paths
+  // can be as long as the graph.
+  std::vector<int> path;
+  int node = source_;
+  while (node != sink_) {
+    bool advanced = false;
+    for (int& i = next_arc_[node]; i < node_arcs_[node].size(); ++i) {
+      const int arc_id = node_arcs_[node][i];
+      const Arc& arc = arcs_[arc_id];
+      if (arc.capacity > kEpsilon && level_[arc.to] == level_[node] + 1) {
+        path.push_back(arc_id);
+        node = arc.to;
+        advanced = true;
+        break;
+      }
+    }
+    if (!advanced) {
+      if (path.empty()) {
+        return 0;
+      }
+      // Dead end: go back, and skip the arc that led here from now on.
+      node = arcs_[path.back() ^ 1].to;
+      path.pop_back();
+      ++next_arc_[node];
+    }
+  }
+  double flow = std::numeric_limits<double>::infinity();
+  for (int arc_id : path) {
+    flow = std::min(flow, arcs_[arc_id].capacity);
+  }
+  for (int arc_id : path) {
+    arcs_[arc_id].capacity -= flow;
+    arcs_[arc_id ^ 1].capacity += flow;
+  }
+  return flow;
+}
+
+double MinCut::Solve() {
+  double cost = 0;
+  while (ComputeLevels()) {
+    next_arc_.assign(node_arcs_.size(), 0);
+    for (double flow = Augment(); flow > 0; flow = Augment()) {
+      cost += flow;
+    }
+  }
+  // The last call to ComputeLevels() leaves the levels of the nodes that can
+  // be reached from the source, i.e. the nodes with the source.
+  return cost;
+}
+
+}  // end namespace internal
+
+namespace {
+
+// Copies between the host and a GPU are assumed to go over PCIe at 16 GBps
+// like in the memory optimizer, i.e. 16 bytes per nanosecond, after a fixed
+// latency.
+constexpr double kCopyBytesPerNs = 16;
+constexpr double kCopyLatencyNs = 10000;
+
+string GetDeviceType(const string& device) {
+  DeviceNameUtils::ParsedName parsed_name;
+  if (!DeviceNameUtils::ParseFullName(device, &parsed_name) ||
+      !parsed_name.has_type) {
+    return "";
+  }
+  return parsed_name.type;
+}
+
+// Returns true if `node` can be moved from its GPU to the host.
+bool CanRunOnHost(const NodeDef& node) {
+  if (IsCollective(node) || IsControlFlow(node) || IsNoOp(node) ||
+      IsSend(node) || IsRecv(node)) {
+    return false;
+  }
+  // Colocated nodes must move together.
+  if (node.attr().count(kColocationAttrName) > 0) {
+    return false;
+  }
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  // Resources and references stay on the device that owns them.
+  DataTypeVector input_types;
+  DataTypeVector output_types;
+  if (!InOutTypesForNode(node, *op_def, &input_types, &output_types).ok()) {
+    return false;
+  }
+  for (const DataTypeVector* types : {&input_types, &output_types}) {
+    for (DataType type : *types) {
+      if (IsRefType(type) || type == DT_RESOURCE || type == DT_VARIANT) {
+        return false;
+      }
+    }
+  }
+  return FindKernelDef(DeviceType(DEVICE_CPU), node, nullptr, nullptr).ok();
+}
+
+double CopyCost(const OpInfo::TensorProperties& tensor) {
+  return kCopyLatencyNs +
+         std::max<int64>(0, CalculateTensorSize(tensor)) / kCopyBytesPerNs;
+}
+
+}  // namespace
+
+Status HostPlacementOptimizer::LoadCostProfile() {
+  if (cost_profile_.empty() || cost_profile_loaded_) {
+    return Status::OK();
+  }
+  OpPerformanceList profile;
+  TF_RETURN_IF_ERROR(
+      ReadTextOrBinaryProto(Env::Default(), cost_profile_, &profile));
+  for (const OpPerformance& op_performance : profile.op_performance()) {
+    if (op_performance.node().empty() || op_performance.compute_cost() <= 0) {
+      continue;
+    }
+    measured_costs_[{op_performance.node(),
+                     op_performance.op().device().type()}] =
+        op_performance.compute_cost();
+  }
+  cost_profile_loaded_ = true;
+  return Status::OK();
+}
+
+Status HostPlacementOptimizer::Optimize(Cluster* cluster,
+                                        const GrapplerItem& item,
+                                        GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (cluster == nullptr) {
+    return errors::Aborted("Nothing to do.");
+  }
+  // Skip all TPU graphs.
+  if (IsTPUGraphDef(*optimized_graph)) {
+    return Status::OK();
+  }
+
+  std::map<string, std::vector<NodeDef*>> gpu_nodes;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    if (GetDeviceType(node.device()) == DEVICE_GPU) {
+      gpu_nodes[node.device()].push_back(&node);
+    }
+  }
+  if (gpu_nodes.empty()) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(LoadCostProfile());
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+  NodeMap node_map(optimized_graph);
+
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  gtl::FlatSet<string> device_names;
+  for (const auto& device : devices) {
+    device_names.insert(device.first);
+  }
+  const bool has_device_cpu =
+      device_names.find("/device:CPU:0") != device_names.end();
+  auto get_device_properties = [&devices](const string& name) {
+    auto it = devices.find(name);
+    return it != devices.end() ? it->second : GetDeviceInfo(name);
+  };
+
+  OpLevelCostEstimator estimator;
+  auto run_time = [&](const NodeDef& node, const string& device_type,
+                      const DeviceProperties& device) -> double {
+    auto it = measured_costs_.find({node.name(), device_type});
+    if (it != measured_costs_.end()) {
+      return it->second;
+    }
+    OpContext op_context;
+    op_context.name = node.name();
+    OpInfo& op_info = op_context.op_info;
+    op_info.set_op(node.op());
+    *op_info.mutable_attr() = node.attr();
+    for (const auto& input : properties.GetInputProperties(node.name())) {
+      *op_info.add_inputs() = input;
+    }
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_info.add_outputs() = output;
+    }
+    *op_info.mutable_device() = device;
+    return estimator.PredictCosts(op_context).execution_time.count();
+  };
+
+  for (const auto& gpu : gpu_nodes) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    const string host = internal::TryFindHostDevice(device_names,
+                                                    has_device_cpu, gpu.first);
+    if (host.empty()) {
+      continue;
+    }
+    const DeviceProperties gpu_device = get_device_properties(gpu.first);
+    const DeviceProperties host_device = get_device_properties(host);
+
+    const std::vector<NodeDef*>& nodes = gpu.second;
+    absl::flat_hash_map<const NodeDef*, int> node_ids;
+    for (int i = 0; i < nodes.size(); ++i) {
+      node_ids[nodes[i]] = i;
+    }
+    // The nodes with the source of the cut run on the host, and the nodes with
+    // the sink stay on the GPU.
+    std::vector<double> gpu_costs(nodes.size());
+    std::vector<double> host_costs(nodes.size());
+    for (int i = 0; i < nodes.size(); ++i) {
+      const NodeDef& node = *nodes[i];
+      gpu_costs[i] = run_time(node, DEVICE_GPU, gpu_device);
+      host_costs[i] = CanRunOnHost(node)
+                          ? run_time(node, DEVICE_CPU, host_device)
+                          : std::numeric_limits<double>::infinity();
+    }
+
+    internal::MinCut cut(nodes.size());
+    // A tensor is copied at most once to the host, whatever the number of its
+    // consumers there.
+    std::set<std::pair<const NodeDef*, int>> copied_to_host;
+    for (int i = 0; i < nodes.size(); ++i) {
+      const NodeDef& node = *nodes[i];
+      const auto& inputs = properties.GetInputProperties(node.name());
+      for (int j = 0; j < node.input_size(); ++j) {
+        const TensorId input = ParseTensorName(node.input(j));
+        if (input.index() < 0 || j >= inputs.size()) {
+          continue;
+        }
+        const NodeDef* producer = node_map.GetNode(string(input.node()));
+        if (producer == nullptr) {
+          continue;
+        }
+        const double copy_cost = CopyCost(inputs[j]);
+        auto it = node_ids.find(producer);
+        if (it != node_ids.end()) {
+          // The tensor is copied if only one of the nodes moves to the host.
+          cut.AddEdge(it->second, i, copy_cost);
+          cut.AddEdge(i, it->second, copy_cost);
+        } else if (GetDeviceType(producer->device()) == DEVICE_CPU) {
+          gpu_costs[i] += copy_cost;
+        }
+      }
+      for (const NodeDef* consumer : node_map.GetOutputs(node.name())) {
+        if (GetDeviceType(consumer->device()) != DEVICE_CPU) {
+          continue;
+        }
+        const auto& consumer_inputs =
+            properties.GetInputProperties(consumer->name());
+        for (int j = 0; j < consumer->input_size(); ++j) {
+          const TensorId input = ParseTensorName(consumer->input(j));
+          if (input.node() != node.name() || input.index() < 0 ||
+              j >= consumer_inputs.size() ||
+              !copied_to_host.emplace(&node, input.index()).second) {
+            continue;
+          }
+          gpu_costs[i] += CopyCost(consumer_inputs[j]);
+        }
+      }
+    }
+
+    double current_cost = 0;
+    for (int i = 0; i < nodes.size(); ++i) {
+      cut.AddTerminalCosts(i, gpu_costs[i], host_costs[i]);
+      current_cost += gpu_costs[i];
+    }
+    const double cost = cut.Solve();
+    VLOG(1) << "Estimated cost of the ops on " << gpu.first << ": "
+            << current_cost << " ns, " << cost << " ns after moving ops to "
+            << host;
+    // Don't move ops for a negligible gain.
+    if (cost >= current_cost * (1 - 1e-3)) {
+      continue;
+    }
+    for (int i = 0; i < nodes.size(); ++i) {
+      if (cut.IsWithSource(i)) {
+        VLOG(2) << "Moving node " << nodes[i]->name() << " to device " << host;
+        nodes[i]->set_device(host);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,111 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_HOST_PLACEMENT_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_HOST_PLACEMENT_OPTIMIZER_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace internal {
+
+// Splits nodes between a source and a sink so that the sum of the costs of
+// the split is minimal, by computing a minimum cut with Dinic's algorithm.
+class MinCut {
+ public:
+  explicit MinCut(int num_nodes);
+
+  // The cost of placing `node` with the sink, and of placing it with the
+  // source. Either can be infinity.
+  void AddTerminalCosts(int node, double sink_cost, double source_cost);
+  // The cost of placing `from` with the source and `to` with the sink.
+  void AddEdge(int from, int to, double cost);
+
+  // Computes the cut, and returns its cost.
+  double Solve();
+  // Returns true if `node` is with the source in the cut computed by Solve().
+  bool IsWithSource(int node) const { return level_[node] >= 0; }
+
+ private:
+  struct Arc {
+    int to;
+    double capacity;
+  };
+
+  void AddArc(int from, int to, double capacity);
+  bool ComputeLevels();
+  double Augment();
+
+  const int source_;
+  const int sink_;
+  std::vector<Arc> arcs_;
+  std::vector<std::vector<int>> node_arcs_;
+  std::vector<int> level_;
+  std::vector<int> next_arc_;
+};
+
+}  // end namespace internal
+
+// Moves the ops placed on a GPU that are estimated to run faster on the host
+// once the copies between host and device are counted, e.g. chains of small
+// ops between string preprocessing on the host and a small model on the GPU.
+//
+// For each GPU, the ops placed on it are split between the GPU and its host
+// by a minimum cut that minimizes the sum of the run times of the ops and of
+// the copies between the devices. The run times come from a profile of
+// measured costs if one is given, and from OpLevelCostEstimator otherwise.
+// Ops that can't run on the host, or that must stay with their inputs, such as
+// ops on resources, are kept on the GPU.
+class HostPlacementOptimizer : public GraphOptimizer {
+ public:
+  HostPlacementOptimizer() {}
+  // cost_profile: Path of an OpPerformanceList with measured costs, or empty.
+  //   See RewriterConfig::host_placement_cost_profile.
+  explicit HostPlacementOptimizer(RewriterConfig::Toggle opt_level,
+                                  const string& cost_profile = "")
+      : cost_profile_(cost_profile) {}
+
+  ~HostPlacementOptimizer() override {}
+
+  string name() const override { return "host_placement_optimizer"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  Status LoadCostProfile();
+
+  string cost_profile_;
+  bool cost_profile_loaded_ = false;
+  // Measured run times in nanoseconds, by node name and device type.
+  absl::flat_hash_map<std::pair<string, string>, int64> measured_costs_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_HOST_PLACEMENT_OPTIMIZER_H_
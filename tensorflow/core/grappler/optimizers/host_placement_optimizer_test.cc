@@ -0,0 +1,171 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/host_placement_optimizer.h"
+
+#include <limits>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class HostPlacementOptimizerTest : public GrapplerTest {
+ protected:
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster() {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    cpu_device.set_frequency(1000);
+    cpu_device.set_num_cores(4);
+    cpu_device.set_bandwidth(32);
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.set_frequency(1000);
+    gpu_device.set_num_cores(24);
+    gpu_device.set_bandwidth(128);
+    std::unordered_map<string, DeviceProperties> devices;
+    devices["/device:CPU:0"] = cpu_device;
+    devices["/device:GPU:0"] = gpu_device;
+    return absl::make_unique<VirtualCluster>(devices);
+  }
+};
+
+TEST_F(HostPlacementOptimizerTest, MinCut) {
+  // Node 0 is cheaper on the sink, node 1 on the source, and moving them apart
+  // costs more than it saves.
+  internal::MinCut cut(3);
+  cut.AddTerminalCosts(0, /*sink_cost=*/1, /*source_cost=*/2);
+  cut.AddTerminalCosts(1, /*sink_cost=*/2, /*source_cost=*/1);
+  cut.AddEdge(0, 1, 5);
+  cut.AddEdge(1, 0, 5);
+  // Node 2 can't be with the source.
+  cut.AddTerminalCosts(2, /*sink_cost=*/10,
+                       /*source_cost=*/std::numeric_limits<double>::infinity());
+
+  EXPECT_DOUBLE_EQ(cut.Solve(), 13);
+  EXPECT_EQ(cut.IsWithSource(0), cut.IsWithSource(1));
+  EXPECT_FALSE(cut.IsWithSource(2));
+}
+
+TEST_F(HostPlacementOptimizerTest, MinCutSplit) {
+  internal::MinCut cut(2);
+  cut.AddTerminalCosts(0, /*sink_cost=*/1, /*source_cost=*/10);
+  cut.AddTerminalCosts(1, /*sink_cost=*/10, /*source_cost=*/1);
+  cut.AddEdge(0, 1, 1);
+  cut.AddEdge(1, 0, 1);
+
+  EXPECT_DOUBLE_EQ(cut.Solve(), 3);
+  EXPECT_FALSE(cut.IsWithSource(0));
+  EXPECT_TRUE(cut.IsWithSource(1));
+}
+
+TEST_F(HostPlacementOptimizerTest, MoveSmallOpsBetweenHostOps) {
+  // Small ops on the GPU between two ops on the host: the copies cost more
+  // than running the ops on the host.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a").WithDevice("/device:CPU:0"), 1.0f,
+                        {4});
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/device:GPU:0"), a);
+  Output c = ops::Neg(s.WithOpName("c").WithDevice("/device:GPU:0"), b);
+  Output d = ops::Identity(s.WithOpName("d").WithDevice("/device:CPU:0"), c);
+
+  GrapplerItem item;
+  item.fetch = {"d"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster();
+  HostPlacementOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    EXPECT_EQ(node.device(), "/device:CPU:0") << node.name();
+  }
+}
+
+TEST_F(HostPlacementOptimizerTest, KeepOpsWithMeasuredCosts) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a").WithDevice("/device:CPU:0"), 1.0f,
+                        {4});
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/device:GPU:0"), a);
+  Output c = ops::Identity(s.WithOpName("c").WithDevice("/device:CPU:0"), b);
+
+  GrapplerItem item;
+  item.fetch = {"c"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  // According to the profile, `b` is much slower on the host.
+  OpPerformanceList profile;
+  for (const auto& cost : {std::make_pair("GPU", 1000),
+                           std::make_pair("CPU", 1000000)}) {
+    OpPerformance* op_performance = profile.add_op_performance();
+    op_performance->set_node("b");
+    op_performance->mutable_op()->set_op("Sqrt");
+    op_performance->mutable_op()->mutable_device()->set_type(cost.first);
+    op_performance->set_compute_cost(cost.second);
+  }
+  const string profile_path =
+      io::JoinPath(testing::TmpDir(), "host_placement_profile.pb");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), profile_path, profile));
+
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster();
+  HostPlacementOptimizer optimizer(RewriterConfig::ON, profile_path);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "b") {
+      EXPECT_EQ(node.device(), "/device:GPU:0");
+    }
+  }
+}
+
+TEST_F(HostPlacementOptimizerTest, KeepResourceOps) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto var = ops::VarHandleOp(s.WithOpName("var").WithDevice("/device:GPU:0"),
+                              DT_FLOAT, {4});
+  Output read = ops::ReadVariableOp(
+      s.WithOpName("read").WithDevice("/device:GPU:0"), var, DT_FLOAT);
+  Output c = ops::Identity(s.WithOpName("c").WithDevice("/device:CPU:0"), read);
+
+  GrapplerItem item;
+  item.fetch = {"c"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster();
+  HostPlacementOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "var" || node.name() == "read") {
+      EXPECT_EQ(node.device(), "/device:GPU:0");
+    }
+  }
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
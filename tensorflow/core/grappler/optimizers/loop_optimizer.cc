@@ -30,7 +30,9 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/mutable_graph_view.h"
@@ -56,15 +58,61 @@ namespace {
 
 using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 
+// Hoisted values stay alive while the loop runs: the nodes expanding their
+// inputs into larger tensors than this, e.g. Fill or Tile, are left in place.
+constexpr int64 kMaxExpandedHoistedBytes = 16 << 20;
+
+// Returns the size of `tensor` in bytes, or -1 if its shape isn't known.
+int64 TensorBytes(const OpInfo::TensorProperties& tensor) {
+  const PartialTensorShape shape(tensor.shape());
+  if (!shape.IsFullyDefined()) {
+    return -1;
+  }
+  return shape.num_elements() * DataTypeSize(tensor.dtype());
+}
+
+// Returns false if the input types of `node` can't be determined.
+bool GetInputTypes(const NodeDef& node, DataTypeVector* input_types) {
+  const OpDef* op_def = nullptr;
+  DataTypeVector output_types;
+  return OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() &&
+         InOutTypesForNode(node, *op_def, input_types, &output_types).ok();
+}
+
+bool HasResourceOrRefInput(const DataTypeVector& input_types) {
+  return std::any_of(input_types.begin(), input_types.end(),
+                     [](DataType type) {
+                       return type == DT_RESOURCE || IsRefType(type);
+                     });
+}
+
+// Returns true if `node` may update a resource variable or a ref variable.
+bool MayUpdateVariables(const NodeDef& node) {
+  if (IsFreeOfSideEffect(node) || IsReadVariableOp(node)) {
+    return false;
+  }
+  DataTypeVector input_types;
+  if (!GetInputTypes(node, &input_types)) {
+    // Notably calls to the functions of the library.
+    return true;
+  }
+  return IsStatefulPartitionedCall(node) || HasResourceOrRefInput(input_types);
+}
+
 class LoopInvariantNodeMotionOptimizer {
  public:
-  explicit LoopInvariantNodeMotionOptimizer(GraphDef* optimized_graph)
-      : optimized_graph_(optimized_graph) {}
+  LoopInvariantNodeMotionOptimizer(const GrapplerItem& item,
+                                   GraphDef* optimized_graph)
+      : item_(item), optimized_graph_(optimized_graph) {}
   virtual ~LoopInvariantNodeMotionOptimizer() = default;
   Status Optimize();
 
  private:
-  Status FindInvariantNodes(NodeDef* node);
+  void FindPassThroughLoopVariables(const FrameView& frame_view);
+  bool CanHoist(const NodeDef& node, const int frame_id) const;
+  bool ExpandsToLargeTensor(const NodeDef& node) const;
+  bool IsLoopInput(const NodeDef& node) const;
+  Status FindInvariantNodes(NodeDef* node, const int frame_id);
   Status RevertInvariantNodes();
   Status MoveInvariantNodes(const int frame_id);
   Status HandleInvariantNode(NodeDef* node, const int num_outputs,
@@ -72,23 +120,170 @@ class LoopInvariantNodeMotionOptimizer {
   Status HandleConst(NodeDef* node, const int num_outputs, const int frame_id);
   Status HandleInvariantEnter(NodeDef* node, const int num_outputs);
 
+  const GrapplerItem& item_;
   GraphDef* optimized_graph_;  // Not owned.
   std::unique_ptr<NodeMap> node_map_;
+  // Null if the shapes couldn't be inferred.
+  std::unique_ptr<GraphProperties> properties_;
+  std::unordered_set<string> nodes_to_preserve_;
   std::map<NodeDef*, int> invariant_nodes_;
   std::set<int> empty_set_;
   std::vector<std::set<int>> frame_children_;
   std::vector<int> frame_parent_;
   std::map<int, const NodeDef*> loop_cond_;
+  // The loop inputs that are the same in every iteration: the constant Enter
+  // nodes, and the body inputs of the pass-through loop variables.
   std::map<int, std::vector<NodeDef*>> invariant_enters_;
+  // An Enter node of each frame, with the attributes of the frame.
+  std::map<int, const NodeDef*> frame_enter_;
+  // The Enter nodes of the loop variables that the body of their loop passes
+  // through unchanged, by body input.
+  std::unordered_map<const NodeDef*, const NodeDef*> pass_through_enters_;
+  // The frames that may update variables, or have a nested frame that may.
+  std::set<int> frames_updating_variables_;
   int new_enter_id_;
 };
 
+void LoopInvariantNodeMotionOptimizer::FindPassThroughLoopVariables(
+    const FrameView& frame_view) {
+  // A loop variable is passed through when its NextIteration node is fed from
+  // its Switch node by Identity nodes only, which is what lowering a While op
+  // produces for the loop variables that are returned unchanged by its body.
+  for (const NodeDef& node : optimized_graph_->node()) {
+    if (!IsNextIteration(node) || node.input_size() == 0) {
+      continue;
+    }
+    NodeDef* body_input = nullptr;
+    const NodeDef* switch_node = nullptr;
+    string input = node.input(0);
+    while (!IsControlInput(input)) {
+      int port;
+      NodeDef* producer = node_map_->GetNode(ParseNodeName(input, &port));
+      if (producer == nullptr) {
+        break;
+      }
+      if (IsSwitch(*producer)) {
+        if (port == 1) {
+          switch_node = producer;
+        }
+        break;
+      }
+      if (producer->op() != "Identity" || producer->input_size() == 0) {
+        break;
+      }
+      body_input = producer;
+      input = producer->input(0);
+    }
+    if (switch_node == nullptr || body_input == nullptr ||
+        switch_node->input_size() == 0) {
+      continue;
+    }
+    int merge_port;
+    const NodeDef* merge =
+        node_map_->GetNode(ParseNodeName(switch_node->input(0), &merge_port));
+    if (merge == nullptr || !IsMerge(*merge) || merge_port != 0 ||
+        merge->input_size() != 2) {
+      continue;
+    }
+    const NodeDef* enter = nullptr;
+    bool merges_next_iteration = false;
+    for (const string& merge_input : merge->input()) {
+      const NodeDef* producer = node_map_->GetNode(merge_input);
+      if (producer == &node) {
+        merges_next_iteration = true;
+      } else if (producer != nullptr && IsEnter(*producer)) {
+        enter = producer;
+      }
+    }
+    if (!merges_next_iteration || enter == nullptr) {
+      continue;
+    }
+    const std::vector<int>& frame_ids = frame_view.Frames(*body_input);
+    if (frame_ids.empty()) {
+      continue;
+    }
+    VLOG(2) << "Loop variable " << enter->name() << " is passed through by "
+            << body_input->name();
+    pass_through_enters_[body_input] = enter;
+    invariant_enters_[frame_ids.back()].push_back(body_input);
+  }
+}
+
+bool LoopInvariantNodeMotionOptimizer::CanHoist(const NodeDef& node,
+                                                const int frame_id) const {
+  if (IsControlFlow(node) || nodes_to_preserve_.count(node.name())) {
+    return false;
+  }
+  // TensorArray and stack ops update their resource in place: their inputs
+  // don't capture the state they depend on.
+  if (IsTensorArray(node) || IsStackOp(node) || IsStackPushOp(node) ||
+      IsStackPopOp(node) || IsStackCloseOp(node)) {
+    return false;
+  }
+  if (IsReadVariableOp(node)) {
+    // The value read is the same in every iteration only if the loop doesn't
+    // update any variable.
+    return frames_updating_variables_.count(frame_id) == 0 &&
+           !ExpandsToLargeTensor(node);
+  }
+  if (!IsFreeOfSideEffect(node)) {
+    return false;
+  }
+  // Only forwarding a resource handle is known not to depend on the state of
+  // the resource.
+  if (!IsIdentity(node) && !IsIdentityN(node)) {
+    DataTypeVector input_types;
+    if (!GetInputTypes(node, &input_types) ||
+        HasResourceOrRefInput(input_types)) {
+      return false;
+    }
+  }
+  return !ExpandsToLargeTensor(node);
+}
+
+bool LoopInvariantNodeMotionOptimizer::ExpandsToLargeTensor(
+    const NodeDef& node) const {
+  if (properties_ == nullptr ||
+      !properties_->HasOutputProperties(node.name())) {
+    return false;
+  }
+  int64 output_bytes = 0;
+  for (const auto& output : properties_->GetOutputProperties(node.name())) {
+    const int64 bytes = TensorBytes(output);
+    if (bytes < 0) {
+      return false;
+    }
+    output_bytes += bytes;
+  }
+  if (output_bytes <= kMaxExpandedHoistedBytes) {
+    return false;
+  }
+  int64 input_bytes = 0;
+  if (properties_->HasInputProperties(node.name())) {
+    for (const auto& input : properties_->GetInputProperties(node.name())) {
+      input_bytes += std::max<int64>(TensorBytes(input), 0);
+    }
+  }
+  return output_bytes > input_bytes;
+}
+
+bool LoopInvariantNodeMotionOptimizer::IsLoopInput(const NodeDef& node) const {
+  return IsEnter(node) || pass_through_enters_.count(&node) > 0;
+}
+
 Status LoopInvariantNodeMotionOptimizer::HandleInvariantEnter(
     NodeDef* node, const int num_outputs) {
+  // The body input of a pass-through loop variable is replaced by the input
+  // of its Enter node, like a constant Enter node is.
+  const NodeDef* enter = node;
+  auto pass_through_it = pass_through_enters_.find(node);
+  if (pass_through_it != pass_through_enters_.end()) {
+    enter = pass_through_it->second;
+  }
   auto consumers = node_map_->GetOutputs(node->name());
   std::vector<string> enter_control_inputs;
   string enter_input;
-  for (auto& input : node->input()) {
+  for (auto& input : enter->input()) {
     if (IsControlInput(input)) {
       enter_control_inputs.push_back(input);
     } else {
@@ -99,7 +294,11 @@ Status LoopInvariantNodeMotionOptimizer::HandleInvariantEnter(
     if (invariant_nodes_.count(consumer)) {
       for (int i = 0; i < consumer->input_size(); ++i) {
         if (NodeName(consumer->input(i)) == node->name()) {
-          consumer->set_input(i, enter_input);
+          if (IsControlInput(consumer->input(i))) {
+            consumer->set_input(i, AsControlDependency(NodeName(enter_input)));
+          } else {
+            consumer->set_input(i, enter_input);
+          }
           node_map_->AddOutput(NodeName(enter_input), consumer->name());
           node_map_->RemoveOutput(node->name(), consumer->name());
         }
@@ -187,14 +386,8 @@ Status LoopInvariantNodeMotionOptimizer::HandleConst(NodeDef* node,
 
 Status LoopInvariantNodeMotionOptimizer::HandleInvariantNode(
     NodeDef* node, const int num_outputs, const int frame_id) {
-  // have to remove control inputs to the invariant node from the same frame
-  // when moving this node out of this frame
-  for (int i = 0; i < node->input_size(); ++i) {
-    if (IsControlInput(node->input(i))) {
-      node->mutable_input()->SwapElements(i, node->input_size() - 1);
-      node->mutable_input()->RemoveLast();
-    }
-  }
+  // The control inputs of the invariant node are invariant too, and have been
+  // moved out of this frame with it.
   if (num_outputs == 0) {
     return Status::OK();
   }
@@ -208,9 +401,9 @@ Status LoopInvariantNodeMotionOptimizer::HandleInvariantNode(
                                        &output_types));
 
   auto consumers = node_map_->GetOutputs(node->name());
-  string fname = invariant_enters_[frame_id][0]->attr().at("frame_name").s();
-  int piterations =
-      invariant_enters_[frame_id][0]->attr().at("parallel_iterations").i();
+  const NodeDef* frame_enter = frame_enter_[frame_id];
+  string fname = frame_enter->attr().at("frame_name").s();
+  int piterations = frame_enter->attr().at("parallel_iterations").i();
   for (auto* consumer : consumers) {
     if (!invariant_nodes_.count(consumer)) {
       for (int i = 0; i < consumer->input_size(); ++i) {
@@ -260,7 +453,7 @@ Status LoopInvariantNodeMotionOptimizer::MoveInvariantNodes(
        ++iter) {
     auto* invariant_node = iter->first;
     const int num_outputs = iter->second;
-    if (IsEnter(*invariant_node)) {
+    if (IsLoopInput(*invariant_node)) {
       TF_RETURN_IF_ERROR(HandleInvariantEnter(invariant_node, num_outputs));
     } else if (IsConstant(*invariant_node)) {
       TF_RETURN_IF_ERROR(HandleConst(invariant_node, num_outputs, frame_id));
@@ -277,7 +470,7 @@ Status LoopInvariantNodeMotionOptimizer::RevertInvariantNodes() {
   for (auto iter = invariant_nodes_.begin(); iter != invariant_nodes_.end();) {
     bool erased = false;
     const auto* node = iter->first;
-    if (!IsConstant(*node) && !IsEnter(*node) && iter->second > 0) {
+    if (!IsConstant(*node) && !IsLoopInput(*node) && iter->second > 0) {
       auto& consumers = node_map_->GetOutputs(node->name());
       for (auto* consumer : consumers) {
         if (!invariant_nodes_.count(consumer)) {
@@ -304,7 +497,7 @@ Status LoopInvariantNodeMotionOptimizer::RevertInvariantNodes() {
       auto iter = invariant_nodes_.find(producer);
       if (iter != invariant_nodes_.end()) {
         if (IsControlInput(input) && !IsConstant(*producer) &&
-            !IsEnter(*producer)) {
+            !IsLoopInput(*producer)) {
           reverted_nodes.push_back(producer);
           invariant_nodes_.erase(iter);
         } else {
@@ -330,7 +523,7 @@ Status LoopInvariantNodeMotionOptimizer::RevertInvariantNodes() {
 }
 
 Status LoopInvariantNodeMotionOptimizer::FindInvariantNodes(
-    NodeDef* start_node) {
+    NodeDef* start_node, const int frame_id) {
   std::vector<NodeDef*> stack;
   stack.reserve(32);
   stack.push_back(start_node);
@@ -340,22 +533,22 @@ Status LoopInvariantNodeMotionOptimizer::FindInvariantNodes(
     auto consumers = node_map_->GetOutputs(node->name());
     invariant_nodes_.emplace(node, consumers.size());
     for (auto* consumer : consumers) {
-      if (invariant_nodes_.count(consumer) || ModifiesFrameInfo(*consumer)) {
+      if (invariant_nodes_.count(consumer) || !CanHoist(*consumer, frame_id)) {
         continue;
       }
+      // The control inputs must be invariant too: they may order the consumer
+      // after the updates of the state it reads.
       bool is_invariant = true;
       for (const auto& input : consumer->input()) {
-        if (!IsControlInput(input)) {
-          const string name = NodeName(input);
-          auto* producer = node_map_->GetNode(name);
-          if (!invariant_nodes_.count(producer)) {
-            if (IsConstant(*producer)) {
-              invariant_nodes_.insert(
-                  std::make_pair(producer, node_map_->GetOutputs(name).size()));
-            } else {
-              is_invariant = false;
-              break;
-            }
+        const string name = NodeName(input);
+        auto* producer = node_map_->GetNode(name);
+        if (!invariant_nodes_.count(producer)) {
+          if (IsConstant(*producer)) {
+            invariant_nodes_.insert(
+                std::make_pair(producer, node_map_->GetOutputs(name).size()));
+          } else {
+            is_invariant = false;
+            break;
           }
         }
       }
@@ -380,6 +573,7 @@ Status LoopInvariantNodeMotionOptimizer::FindInvariantNodes(
 
 Status LoopInvariantNodeMotionOptimizer::Optimize() {
   node_map_.reset(new NodeMap(optimized_graph_));
+  nodes_to_preserve_ = item_.NodesToPreserve();
   FrameView frame_view;
   // TODO(ezhulenev): Use GraphView when migrated from NodeMap.
   TF_RETURN_IF_ERROR(frame_view.InferFromGraph(*optimized_graph_));
@@ -411,12 +605,32 @@ Status LoopInvariantNodeMotionOptimizer::Optimize() {
         }
         loop_cond_[frame_ids.back()] = &node;
       }
-      if (IsEnter(node) && node.attr().at("is_constant").b()) {
-        invariant_enters_[frame_ids.back()].push_back(
-            const_cast<NodeDef*>(&node));
+      if (IsEnter(node)) {
+        frame_enter_.emplace(frame_ids.back(), &node);
+        if (node.attr().at("is_constant").b()) {
+          invariant_enters_[frame_ids.back()].push_back(
+              const_cast<NodeDef*>(&node));
+        }
+      }
+      if (MayUpdateVariables(node)) {
+        frames_updating_variables_.insert(frame_ids.begin(), frame_ids.end());
       }
     }
   }
+  FindPassThroughLoopVariables(frame_view);
+  if (invariant_enters_.empty()) {
+    return Status::OK();
+  }
+
+  // The shapes are only used to leave the nodes expanding their inputs in
+  // place, the nodes can be moved without them.
+  properties_.reset(new GraphProperties(item_));
+  const Status status =
+      properties_->InferStatically(/*assume_valid_feeds=*/false);
+  if (!status.ok()) {
+    VLOG(1) << "Failed to infer the shapes of the loops: " << status;
+    properties_.reset();
+  }
 
   for (size_t i = 0; i < frame_children_.size(); i++) {
     if (frame_children_[i].empty()) {
@@ -441,7 +655,7 @@ Status LoopInvariantNodeMotionOptimizer::Optimize() {
     }
     invariant_nodes_.clear();
     for (auto* enter : invariant_enters_[frame_id]) {
-      TF_RETURN_IF_ERROR(FindInvariantNodes(enter));
+      TF_RETURN_IF_ERROR(FindInvariantNodes(enter, frame_id));
     }
 
     // revert invariant nodes that have control outputs to variant nodes
@@ -725,7 +939,7 @@ LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
                              DeviceBase* cpu_device)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -739,7 +953,7 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   *optimized_graph = item.graph;
   // Set up helper data structures.
   if (options_.enable_loop_invariant_node_motion) {
-    LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
+    LoopInvariantNodeMotionOptimizer linm_optimizer(item, optimized_graph);
     TF_RETURN_IF_ERROR(linm_optimizer.Optimize());
   }
   if (options_.enable_stack_push_removal) {
@@ -59,6 +59,10 @@ class LoopOptimizer : public GraphOptimizer {
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
+      // Moving the loop invariant nodes out of their loops keeps their outputs
+      // alive while the loops run.
+      options.enable_loop_invariant_node_motion =
+          opt_level == RewriterConfig::AGGRESSIVE;
       return options;
     }
   };
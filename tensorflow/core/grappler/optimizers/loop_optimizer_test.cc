@@ -60,6 +60,38 @@ class LoopOptimizerTest : public GrapplerTest {
     AddNode(name, op, inputs, attributes, graph);
   }
 
+  // Returns the number of frames the node `node_name` of `graph` is in.
+  int NumFrames(const GraphDef& graph, const string& node_name) const {
+    Status status;
+    utils::GraphView view(&graph, &status);
+    TF_CHECK_OK(status);
+    FrameView frames;
+    TF_CHECK_OK(frames.InferFromGraphView(view));
+    const auto* node = view.GetNode(node_name);
+    CHECK(node != nullptr) << node_name;
+    return frames.Frames(*node->node()).size();
+  }
+
+  // Adds a loop counting with the loop variable "Counter" from "In".
+  void AddCounterLoop(GraphDef* graph) const {
+    AddSimpleNode("In", "Identity", {}, graph);
+    AddEnterNode("CounterEnter", "while/while_context", false, 1, {"In"},
+                 graph);
+    AddSimpleNode("CounterMerge", "Merge",
+                  {"CounterEnter", "CounterNextIteration"}, graph);
+    AddSimpleNode("Less/y", "Const", {"^Identity"}, graph);
+    AddSimpleNode("Less", "Less", {"CounterMerge", "Less/y"}, graph);
+    AddSimpleNode("LoopCond", "LoopCond", {"Less"}, graph);
+    AddSimpleNode("CounterSwitch", "Switch", {"CounterMerge", "LoopCond"},
+                  graph);
+    AddSimpleNode("Identity", "Identity", {"CounterSwitch:1"}, graph);
+    AddSimpleNode("One", "Const", {"^Identity"}, graph);
+    AddSimpleNode("Counter", "Add", {"Identity", "One"}, graph);
+    AddSimpleNode("CounterNextIteration", "NextIteration", {"Counter"}, graph);
+    AddSimpleNode("CounterExit", "Exit", {"CounterSwitch"}, graph);
+    AddSimpleNode("Out", "Identity", {"CounterExit"}, graph);
+  }
+
   void EnableOnlyLoopInvariantNodeMotion(LoopOptimizer* optimizer) {
     DisableAllStages(optimizer);
     optimizer->options_.enable_loop_invariant_node_motion = true;
@@ -613,6 +645,199 @@ TEST_F(LoopOptimizerTest, NestedLoopConst2) {
   }
 }
 
+TEST_F(LoopOptimizerTest, StatefulNode) {
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AddSimpleNode("Random", "RandomUniform", {"InvariantEnter"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"Random", "Counter"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Every iteration draws different numbers.
+  EXPECT_EQ(NumFrames(output, "Random"), 1);
+}
+
+TEST_F(LoopOptimizerTest, ReadVariable) {
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AttrValue dtype;
+  dtype.set_type(DT_FLOAT);
+  AddNode("Read", "ReadVariableOp", {"InvariantEnter"}, {{"dtype", dtype}},
+          &graph);
+  AddSimpleNode("InvariantNeg", "Neg", {"Read"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"InvariantNeg", "Counter"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(NumFrames(output, "Read"), 0);
+  EXPECT_EQ(NumFrames(output, "InvariantNeg"), 0);
+  EXPECT_EQ(NumFrames(output, "VariantAdd"), 1);
+}
+
+TEST_F(LoopOptimizerTest, ReadUpdatedVariable) {
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AttrValue dtype;
+  dtype.set_type(DT_FLOAT);
+  AddNode("Read", "ReadVariableOp", {"InvariantEnter"}, {{"dtype", dtype}},
+          &graph);
+  AddSimpleNode("InvariantNeg", "Neg", {"Read"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"InvariantNeg", "Counter"}, &graph);
+  AddNode("Update", "AssignAddVariableOp", {"InvariantEnter", "VariantAdd"},
+          {{"dtype", dtype}}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(NumFrames(output, "Read"), 1);
+  EXPECT_EQ(NumFrames(output, "InvariantNeg"), 1);
+}
+
+TEST_F(LoopOptimizerTest, TensorArray) {
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddEnterNode("HandleEnter", "while/while_context", true, 1, {"In"}, &graph);
+  AddEnterNode("IndexEnter", "while/while_context", true, 1, {"In"}, &graph);
+  AddEnterNode("FlowEnter", "while/while_context", true, 1, {"In"}, &graph);
+  AttrValue dtype;
+  dtype.set_type(DT_FLOAT);
+  AddNode("Read", "TensorArrayReadV3",
+          {"HandleEnter", "IndexEnter", "FlowEnter"}, {{"dtype", dtype}},
+          &graph);
+  AddSimpleNode("Neg", "Neg", {"Read"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"Neg", "Counter"}, &graph);
+  AddNode("Write", "TensorArrayWriteV3",
+          {"HandleEnter", "IndexEnter", "VariantAdd", "FlowEnter"},
+          {{"T", dtype}}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The TensorArray is updated in the loop without a change of the flow.
+  EXPECT_EQ(NumFrames(output, "Read"), 1);
+  EXPECT_EQ(NumFrames(output, "Neg"), 1);
+  EXPECT_EQ(NumFrames(output, "Write"), 1);
+}
+
+TEST_F(LoopOptimizerTest, VariantControlInput) {
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AddSimpleNode("Add", "Add",
+                {"InvariantEnter", "InvariantEnter", "^Counter"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"Add", "Counter"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(NumFrames(output, "Add"), 1);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhilePassThroughLoopVariable) {
+  // The loop variable "Weights" as lowered from a functional While op, whose
+  // body function returns it unchanged after inlining.
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddSimpleNode("Weights", "Identity", {}, &graph);
+  AddEnterNode("WeightsEnter", "while/while_context", false, 1, {"Weights"},
+               &graph);
+  AddSimpleNode("WeightsMerge", "Merge",
+                {"WeightsEnter", "WeightsNextIteration"}, &graph);
+  AddSimpleNode("WeightsSwitch", "Switch", {"WeightsMerge", "LoopCond"},
+                &graph);
+  AddSimpleNode("WeightsIdentity", "Identity", {"WeightsSwitch:1"}, &graph);
+  AddSimpleNode("body/weights", "Identity", {"WeightsIdentity"}, &graph);
+  AddSimpleNode("body/Neg", "Neg", {"body/weights"}, &graph);
+  AddSimpleNode("body/Mul", "Mul", {"body/Neg", "Counter"}, &graph);
+  AddSimpleNode("WeightsNextIteration", "NextIteration", {"body/weights"},
+                &graph);
+  AddSimpleNode("WeightsExit", "Exit", {"WeightsSwitch"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(NumFrames(output, "body/weights"), 0);
+  EXPECT_EQ(NumFrames(output, "body/Neg"), 0);
+  EXPECT_EQ(NumFrames(output, "body/Mul"), 1);
+  EXPECT_EQ(NumFrames(output, "WeightsIdentity"), 1);
+  EXPECT_EQ(NumFrames(output, "WeightsNextIteration"), 1);
+
+  NodeMap node_map(&output);
+  const NodeDef* weights = node_map.GetNode("body/weights");
+  ASSERT_NE(weights, nullptr);
+  ASSERT_EQ(weights->input_size(), 1);
+  EXPECT_EQ(weights->input(0), "Weights");
+  // The loop variable is still passed through, from the hoisted body input.
+  const NodeDef* next_iteration = node_map.GetNode("WeightsNextIteration");
+  ASSERT_NE(next_iteration, nullptr);
+  const NodeDef* enter = node_map.GetNode(next_iteration->input(0));
+  ASSERT_NE(enter, nullptr);
+  EXPECT_EQ(enter->op(), "Enter");
+  ASSERT_EQ(enter->input_size(), 1);
+  EXPECT_EQ(enter->input(0), "body/weights");
+}
+
+TEST_F(LoopOptimizerTest, EnabledWhenAggressive) {
+  GraphDef graph;
+  AddCounterLoop(&graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AddSimpleNode("InvariantAdd", "Add", {"InvariantEnter", "InvariantEnter"},
+                &graph);
+  AddSimpleNode("VariantAdd", "Add", {"InvariantAdd", "Counter"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  GraphDef output;
+  LoopOptimizer default_optimizer(RewriterConfig::ON, nullptr);
+  TF_EXPECT_OK(default_optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(NumFrames(output, "InvariantAdd"), 1);
+
+  LoopOptimizer aggressive_optimizer(RewriterConfig::AGGRESSIVE, nullptr);
+  TF_EXPECT_OK(aggressive_optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(NumFrames(output, "InvariantAdd"), 0);
+}
+
 void VerifyGraphsEqual(const GraphDef& original_graph,
                        const GraphDef& optimized_graph, const string& func) {
   EXPECT_EQ(original_graph.node_size(), optimized_graph.node_size()) << func;
@@ -440,6 +440,27 @@ void RecomputeSubgraph(
   }
 }
 
+// Recomputes `recomputed_subgraphs`. The nodes of `graph` must be sorted
+// topologically, and `node_map` must be built from `graph`.
+void RecomputeSubgraphs(
+    const std::vector<RecomputedSubGraph>& recomputed_subgraphs,
+    const NodeMap& node_map, GraphDef* graph) {
+  if (recomputed_subgraphs.empty()) {
+    return;
+  }
+  std::unordered_map<const NodeDef*, int> topological_numbering;
+  for (int node_number = 0; node_number < graph->node().size();
+       ++node_number) {
+    topological_numbering[graph->mutable_node(node_number)] =
+        graph->node().size() - node_number - 1;
+  }
+  // Duplicate the indicated sub-graphs and set up control dependencies
+  for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
+    RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
+                      node_map, topological_numbering, graph);
+  }
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
                                 GraphDef* graph, const GrapplerItem& item) {
@@ -497,19 +518,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
         },
         is_target);
   }
-  if (!recomputed_subgraphs.empty()) {
-    std::unordered_map<const NodeDef*, int> topological_numbering;
-    for (int node_number = 0; node_number < graph->node().size();
-         ++node_number) {
-      topological_numbering[graph->mutable_node(node_number)] =
-          graph->node().size() - node_number - 1;
-    }
-    // Duplicate the indicated sub-graphs and set up control dependencies
-    for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
-      RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
-                        node_map, topological_numbering, graph);
-    }
-  }
+  RecomputeSubgraphs(recomputed_subgraphs, node_map, graph);
 }
 
 bool SchedulingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
@@ -977,6 +986,44 @@ struct MemInfo {
   bool operator<(const MemInfo& other) const { return fitness < other.fitness; }
 };
 
+// Runs `item` on a VirtualCluster with the devices of `cluster`, and records
+// the time at which each op completes and, if `op_run_times` is not null, how
+// long each op runs.
+static bool SimulateExecution(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, Costs::NanoSeconds>* op_completion_times,
+    std::unordered_map<string, Costs::NanoSeconds>* op_run_times) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  if (!vcluster.Provision().ok()) {
+    return false;
+  }
+  if (!vcluster.Initialize(item).ok()) {
+    return false;
+  }
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return false;
+  }
+
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      Costs::NanoSeconds exec_time =
+          Costs::NanoSeconds(1) +
+          Costs::MicroSeconds(node_stats.all_start_micros() +
+                              node_stats.op_end_rel_micros());
+      op_completion_times->emplace(node_stats.node_name(), exec_time);
+      if (op_run_times != nullptr) {
+        op_run_times->emplace(
+            node_stats.node_name(),
+            Costs::MicroSeconds(node_stats.op_end_rel_micros() -
+                                node_stats.op_start_rel_micros()));
+      }
+    }
+  }
+  return true;
+}
+
 static bool IdentifySwappingCandidates(
     Cluster* cluster, GrapplerItem* item,
     std::unique_ptr<GraphMemory>* memory_ptr,
@@ -1012,29 +1059,9 @@ static bool IdentifySwappingCandidates(
     int64 required_savings = mem_usage.used_memory - prop.memory_size();
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
-    {
-      VirtualCluster vcluster(cluster->GetDevices());
-      if (!vcluster.Provision().ok()) {
-        return false;
-      }
-      if (!vcluster.Initialize(*item).ok()) {
-        return false;
-      }
-      RunMetadata metadata;
-      Status s = vcluster.Run(item->graph, item->feed, item->fetch, &metadata);
-      if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
-        return false;
-      }
-
-      for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
-        for (const auto& node_stats : dev_stats.node_stats()) {
-          Costs::NanoSeconds exec_time =
-              Costs::NanoSeconds(1) +
-              Costs::MicroSeconds(node_stats.all_start_micros() +
-                                  node_stats.op_end_rel_micros());
-          op_completion_times.emplace(node_stats.node_name(), exec_time);
-        }
-      }
+    if (!SimulateExecution(cluster, *item, &op_completion_times,
+                           /*op_run_times=*/nullptr)) {
+      return false;
     }
 
     Costs::Duration peak_time = -1;
@@ -1146,37 +1173,11 @@ static bool IdentifySwappingCandidates(
   return updated_graph;
 }
 
-bool SwappingPass(RewriterConfig::MemOptType optimization_level,
-                  Cluster* cluster, std::unique_ptr<GraphMemory>* memory,
-                  GrapplerItem* item, std::unordered_set<string>* skip_list) {
-  std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
-  if (optimization_level == RewriterConfig::DEFAULT_MEM_OPT ||
-      optimization_level == RewriterConfig::SWAPPING_HEURISTICS ||
-      optimization_level == RewriterConfig::HEURISTICS) {
-    // Use heuristics to figure out what needs to be swapped;
-    IdentifySwappingCandidates(cluster, item, memory, skip_list,
-                               &nodes_to_swap);
-  }
-  // Look for manual annotations in the graph.
-  for (auto& node : *item->graph.mutable_node()) {
-    if (node.attr().count("_swap_to_host") != 0) {
-      SwapInfo& swap_info = nodes_to_swap[&node];
-      const AttrValue& val = node.attr().at("_swap_to_host");
-      if (val.has_list()) {
-        for (int64 input_id : val.list().i()) {
-          swap_info.inputs_to_swap.push_back(input_id);
-        }
-      } else {
-        int64 input_id = val.i();
-        swap_info.inputs_to_swap.push_back(input_id);
-      }
-    }
-  }
-  if (nodes_to_swap.empty()) {
-    // Nothing to do.
-    return false;
-  }
-
+// Swaps the inputs of the nodes in `nodes_to_swap` to the host memory after
+// they are produced, and back to the device memory just before they are used.
+bool SwapTensors(Cluster* cluster, GrapplerItem* item,
+                 std::unordered_map<NodeDef*, SwapInfo>* nodes_to_swap,
+                 std::unordered_set<string>* skip_list) {
   // Estimate the size of the data to swap for each node.
   GraphProperties properties(*item);
   if (!properties
@@ -1186,7 +1187,7 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
            .ok()) {
     return false;
   }
-  for (auto& swap : nodes_to_swap) {
+  for (auto& swap : *nodes_to_swap) {
     const NodeDef* node = swap.first;
     const std::vector<OpInfo::TensorProperties>& props =
         properties.GetInputProperties(node->name());
@@ -1213,7 +1214,7 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
 
   bool updated_graph = false;
 
-  for (auto& swap : nodes_to_swap) {
+  for (auto& swap : *nodes_to_swap) {
     NodeDef* node = swap.first;
     const SwapInfo& swap_info = swap.second;
     if (skip_list->find(node->name()) != skip_list->end()) {
@@ -1270,6 +1271,296 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   return updated_graph;
 }
 
+bool SwappingPass(RewriterConfig::MemOptType optimization_level,
+                  Cluster* cluster, std::unique_ptr<GraphMemory>* memory,
+                  GrapplerItem* item, std::unordered_set<string>* skip_list) {
+  std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
+  if (optimization_level == RewriterConfig::DEFAULT_MEM_OPT ||
+      optimization_level == RewriterConfig::SWAPPING_HEURISTICS ||
+      optimization_level == RewriterConfig::HEURISTICS) {
+    // Use heuristics to figure out what needs to be swapped;
+    IdentifySwappingCandidates(cluster, item, memory, skip_list,
+                               &nodes_to_swap);
+  }
+  // Look for manual annotations in the graph.
+  for (auto& node : *item->graph.mutable_node()) {
+    if (node.attr().count("_swap_to_host") != 0) {
+      SwapInfo& swap_info = nodes_to_swap[&node];
+      const AttrValue& val = node.attr().at("_swap_to_host");
+      if (val.has_list()) {
+        for (int64 input_id : val.list().i()) {
+          swap_info.inputs_to_swap.push_back(input_id);
+        }
+      } else {
+        int64 input_id = val.i();
+        swap_info.inputs_to_swap.push_back(input_id);
+      }
+    }
+  }
+  if (nodes_to_swap.empty()) {
+    // Nothing to do.
+    return false;
+  }
+  return SwapTensors(cluster, item, &nodes_to_swap, skip_list);
+}
+
+// Returns true if `node` can be run again to recompute its outputs.
+bool IsRecomputable(const NodeDef& node,
+                    const std::unordered_set<string>& feeds) {
+  // Fed nodes would not take on the fed value when recomputed, and there is no
+  // point in recomputing nodes whose outputs are persistent.
+  if (feeds.count(node.name()) > 0 || IsPersistent(node) ||
+      IsPlaceholder(node)) {
+    return false;
+  }
+  if (ModifiesFrameInfo(node) || IsSwitch(node) || IsMerge(node)) {
+    return false;
+  }
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return false;
+  }
+  return !op_def->is_stateful();
+}
+
+// A way to remove a tensor from the point of peak memory usage: either
+// recompute it or swap it to the host for the uses after the peak.
+struct RematerializationCandidate {
+  MutableGraphView::OutputPort port;
+  std::vector<MutableGraphView::InputPort> uses_left;
+  bool recompute = false;
+  // The number of bytes removed from the peak memory usage.
+  int64 memory_saved = 0;
+  // The time spent recomputing the tensor, or transferring it back and forth.
+  Costs::NanoSeconds cost = 0;
+
+  double CostPerByte() const {
+    return static_cast<double>(cost.count()) / memory_saved;
+  }
+};
+
+// Simulates the execution of the graph, and recomputes or swaps the tensors
+// that are live at the point of peak memory usage of each device, cheapest
+// first, until the peak goes down to `memory_target_bytes`, or to the memory
+// size of the device if `memory_target_bytes` is 0.
+bool RematerializationPass(Cluster* cluster, int64 memory_target_bytes,
+                           std::unique_ptr<GraphMemory>* memory_ptr,
+                           GrapplerItem* item,
+                           std::unordered_set<string>* skip_list) {
+  // RecomputeSubgraphs needs the nodes to be sorted topologically. Sorting
+  // moves the nodes, so it needs to be done before we collect them.
+  if (!TopologicalSort(&item->graph).ok()) {
+    return false;
+  }
+  if ((*memory_ptr) == nullptr) {
+    memory_ptr->reset(new GraphMemory(*item));
+    Status s = (*memory_ptr)->InferStatically(cluster->GetDevices());
+    if (!s.ok()) {
+      memory_ptr->reset();
+      VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+      return false;
+    }
+  }
+  const GraphMemory& memory = **memory_ptr;
+
+  std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
+  std::unordered_map<string, Costs::NanoSeconds> op_run_times;
+  if (!SimulateExecution(cluster, *item, &op_completion_times,
+                         &op_run_times)) {
+    return false;
+  }
+  GraphProperties properties(*item);
+  if (!properties
+           .InferStatically(/*assume_valid_feeds=*/true,
+                            /*aggressive_shape_inference=*/false,
+                            /*include_tensor_values=*/false)
+           .ok()) {
+    return false;
+  }
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+
+  MutableGraphView graph(&item->graph);
+  std::unordered_map<const NodeDef*, RecomputedSubGraph> nodes_to_recompute;
+  std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    const int64 target_memory =
+        memory_target_bytes > 0 ? memory_target_bytes : prop.memory_size();
+    if (target_memory <= 0) {
+      VLOG(1) << "Memory target unknown for device " << name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= target_memory) {
+      continue;
+    }
+    int64 required_savings = mem_usage.used_memory - target_memory;
+
+    Costs::Duration peak_time = -1;
+    std::set<std::pair<string, int>> live_at_peak;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      peak_time = std::max(peak_time, live_tensor.allocation_time);
+      live_at_peak.emplace(live_tensor.node, live_tensor.output_id);
+    }
+    // The nodes that run at the peak need their inputs and outputs to be in
+    // memory at that point.
+    std::unordered_set<string> peak_nodes;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.allocation_time == peak_time) {
+        peak_nodes.insert(live_tensor.node);
+      }
+    }
+
+    std::vector<RematerializationCandidate> candidates;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.memory_used <= 1024) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      if (live_tensor.allocation_time >= peak_time ||
+          skip_list->find(live_tensor.node) != skip_list->end()) {
+        continue;
+      }
+      RematerializationCandidate candidate;
+      candidate.port =
+          graph.GetOutputPort(live_tensor.node, live_tensor.output_id);
+      if (candidate.port.node == nullptr) {
+        continue;
+      }
+      // Only the uses after the peak need the tensor to be rematerialized.
+      bool valid = true;
+      for (MutableGraphView::InputPort input :
+           graph.GetFanout(candidate.port)) {
+        auto it = op_completion_times.find(input.node->name());
+        if (it == op_completion_times.end() ||
+            peak_nodes.count(input.node->name()) > 0 ||
+            skip_list->find(input.node->name()) != skip_list->end()) {
+          valid = false;
+          break;
+        }
+        if (it->second > peak_time) {
+          candidate.uses_left.push_back(input);
+        }
+      }
+      if (!valid || candidate.uses_left.empty()) {
+        continue;
+      }
+
+      // Recomputing the tensor keeps its inputs alive until the recomputation,
+      // so the inputs that are not already live at the peak reduce the savings.
+      const NodeDef& producer = *candidate.port.node;
+      auto run_time = op_run_times.find(producer.name());
+      if (IsRecomputable(producer, feeds) && run_time != op_run_times.end()) {
+        int64 memory_saved = live_tensor.memory_used;
+        for (int i = 0; i < producer.input_size() && memory_saved > 0; ++i) {
+          const TensorId input = ParseTensorName(producer.input(i));
+          if (input.index() < 0) {
+            continue;
+          }
+          const NodeDef* input_node = graph.GetNode(input.node());
+          if (input_node == nullptr) {
+            memory_saved = 0;
+            break;
+          }
+          if (IsPersistent(*input_node) ||
+              live_at_peak.count({input_node->name(), input.index()}) > 0) {
+            continue;
+          }
+          const auto& outputs = properties.GetOutputProperties(
+              input_node->name());
+          if (input.index() >= static_cast<int>(outputs.size())) {
+            memory_saved = 0;
+            break;
+          }
+          memory_saved -= CalculateTensorSize(outputs[input.index()]);
+        }
+        if (memory_saved > 0) {
+          candidate.recompute = true;
+          candidate.memory_saved = memory_saved;
+          candidate.cost = run_time->second;
+        }
+      }
+
+      // Swapping is only possible from a GPU, and needs enough time for the
+      // tensor to be transferred.
+      bool swappable = prop.type() == "GPU" &&
+                       live_tensor.deallocation_time -
+                               live_tensor.allocation_time >
+                           Costs::Duration(1e6) &&
+                       IsSwappable(graph, candidate.port);
+      for (const auto& input : candidate.uses_left) {
+        swappable = swappable && IsSwappable(input);
+      }
+      if (swappable) {
+        // Let's assume we're going to swap over PCIe running at 16 GBps, in
+        // both directions.
+        const Costs::NanoSeconds swap_cost(2 * live_tensor.memory_used / 16);
+        const int64 memory_saved = live_tensor.memory_used;
+        if (!candidate.recompute ||
+            static_cast<double>(swap_cost.count()) / memory_saved <
+                candidate.CostPerByte()) {
+          candidate.recompute = false;
+          candidate.memory_saved = memory_saved;
+          candidate.cost = swap_cost;
+        }
+      }
+      if (candidate.memory_saved > 0) {
+        candidates.push_back(std::move(candidate));
+      }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const RematerializationCandidate& a,
+                 const RematerializationCandidate& b) {
+                return a.CostPerByte() < b.CostPerByte();
+              });
+    for (const RematerializationCandidate& candidate : candidates) {
+      if (required_savings <= 0) {
+        break;
+      }
+      const NodeDef* producer = candidate.port.node;
+      VLOG(1) << "Will " << (candidate.recompute ? "recompute" : "swap")
+              << " tensor " << producer->name() << ":"
+              << candidate.port.port_id << " saving "
+              << candidate.memory_saved << " bytes for "
+              << candidate.cost.count() << " ns";
+      if (candidate.recompute) {
+        RecomputedSubGraph& subgraph = nodes_to_recompute[producer];
+        subgraph.recomputed_source_nodes.insert(producer);
+        for (const auto& input : candidate.uses_left) {
+          subgraph.target_nodes.insert(input.node);
+        }
+      } else {
+        for (const auto& input : candidate.uses_left) {
+          nodes_to_swap[input.node].inputs_to_swap.push_back(input.port_id);
+        }
+      }
+      required_savings -= candidate.memory_saved;
+    }
+  }
+  if (nodes_to_recompute.empty() && nodes_to_swap.empty()) {
+    return false;
+  }
+
+  std::vector<RecomputedSubGraph> recomputed_subgraphs;
+  for (const auto& recompute : nodes_to_recompute) {
+    // A node is recomputed at most once, since the recomputed nodes are named
+    // after it.
+    skip_list->insert(recompute.first->name());
+    recomputed_subgraphs.push_back(recompute.second);
+  }
+  NodeMap node_map(&item->graph);
+  RecomputeSubgraphs(recomputed_subgraphs, node_map, &item->graph);
+  if (!nodes_to_swap.empty()) {
+    SwapTensors(cluster, item, &nodes_to_swap, skip_list);
+  }
+  return true;
+}
+
 bool CrossesTaskOrCpuGpuBoundary(const NodeDef& node1, const NodeDef& node2) {
   string task1;
   string device1;
@@ -1422,6 +1713,16 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
         }
       }
 
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+      if (optimization_level_ == RewriterConfig::AUTO_REMATERIALIZATION) {
+        if (RematerializationPass(cluster, memory_target_bytes_, &memory,
+                                  &optimized_item, &skip_list)) {
+          // Reset the inferred memory usage since the graph changed.
+          memory.reset();
+          updated_graph = true;
+        }
+      }
+
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
       if ((optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
            optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
@@ -393,6 +393,56 @@ TEST_F(MemoryOptimizerTest, UnswappableInputs) {
 #endif
 }
 
+TEST_F(MemoryOptimizerTest, AutoRematerialization) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/cpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  // `a` is live at the peak, but is only used after it.
+  Output a = ops::Sqrt(s.WithOpName("a").WithDevice("/cpu:0"), v);
+  Output shape = ops::Const(s.WithOpName("shape"), {128, 128, 16});
+  Output b = ops::RandomUniform(
+      s.WithOpName("b").WithDevice("/cpu:0").WithControlDependencies(a), shape,
+      DT_FLOAT);
+  Output c = ops::Exp(s.WithOpName("c").WithDevice("/cpu:0"), b);
+  Output axes = ops::Const(s.WithOpName("axes"), {0, 1, 2});
+  Output sum = ops::Sum(s.WithOpName("sum").WithDevice("/cpu:0"), c, axes);
+  Output d = ops::Add(s.WithOpName("d").WithDevice("/cpu:0"), a, sum);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"d"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::AUTO_REMATERIALIZATION,
+                            "gradients/",
+                            /*memory_target_bytes=*/1024 * 1024);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  int found = 0;
+  for (const auto& node : output.node()) {
+    if (node.name() == "d") {
+      EXPECT_EQ("Recomputed/a", node.input(0));
+      EXPECT_EQ("sum", node.input(1));
+      ++found;
+    } else if (node.name() == "Recomputed/a") {
+      EXPECT_EQ("Sqrt", node.op());
+      ASSERT_EQ(2, node.input_size());
+      EXPECT_EQ("v", node.input(0));
+      EXPECT_EQ("^RecomputeTrigger/a", node.input(1));
+      ++found;
+    } else if (node.name() == "RecomputeTrigger/a") {
+      EXPECT_EQ("NoOp", node.op());
+      ++found;
+    } else if (node.name() == "c") {
+      // `b` and `c` are needed at the peak, and are not rematerialized.
+      EXPECT_EQ("b", node.input(0));
+    }
+  }
+  EXPECT_EQ(3, found);
+}
+
 TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output a = ops::RandomNormal(s.WithOpName("a").WithDevice("/cpu:0"),
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -35,12 +36,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
 #include "tensorflow/core/grappler/optimizers/debug_stripper.h"
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/dynamic_quantization_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/host_placement_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
@@ -53,6 +57,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -64,6 +71,10 @@ namespace {
 
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
+// The default upper bound on the number of functions that are optimized
+// concurrently. Each of them holds a copy of its function body and of the
+// functions it calls, so this also bounds memory usage.
+constexpr int kMaxFunctionOptimizationThreads = 16;
 
 int64 NumEdges(const GraphDef& graph) {
   int64 num_edges = 0;
@@ -179,6 +190,15 @@ bool MetaOptimizer::IsSingleThreadedExecutor() const {
          "SINGLE_THREADED_EXECUTOR";
 }
 
+int MetaOptimizer::NumFunctionOptimizationThreads() const {
+  // Custom optimizers are not required to be thread-safe.
+  if (!cfg_.custom_optimizers().empty()) return 1;
+  if (cfg_.function_optimization_parallelism() > 0) {
+    return cfg_.function_optimization_parallelism();
+  }
+  return std::min(port::MaxParallelism(), kMaxFunctionOptimizationThreads);
+}
+
 std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
     const string& optimizer) const {
   MK_OPT("pruning", new ModelPruner());
@@ -211,6 +231,11 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("dynamic_quantization",
+         new DynamicQuantizationOptimizer(cfg_.dynamic_quantization()));
+  MK_OPT("host_placement",
+         new HostPlacementOptimizer(cfg_.host_placement_optimization(),
+                                    cfg_.host_placement_cost_profile()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -268,6 +293,11 @@ Status MetaOptimizer::InitializeOptimizers(
   if (cfg_.pin_to_host_optimization() == RewriterConfig::ON) {
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
   }
+  if (cfg_.host_placement_optimization() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<HostPlacementOptimizer>(
+        cfg_.host_placement_optimization(),
+        cfg_.host_placement_cost_profile()));
+  }
   if (cfg_.arithmetic_optimization() != RewriterConfig::OFF) {
     optimizers->push_back(
         MakeUnique<ArithmeticOptimizer>(cfg_.arithmetic_optimization()));
@@ -277,6 +307,10 @@ Status MetaOptimizer::InitializeOptimizers(
         /*optimization level*/ cfg_.layout_optimizer(),
         /*CPU layout conversion*/ cfg_.cpu_layout_conversion()));
   }
+  if (cfg_.dynamic_quantization() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<DynamicQuantizationOptimizer>(
+        cfg_.dynamic_quantization()));
+  }
   if (cfg_.remapping() != RewriterConfig::OFF) {
     optimizers->push_back(MakeUnique<Remapper>(cfg_.remapping()));
   }
@@ -294,11 +328,13 @@ Status MetaOptimizer::InitializeOptimizers(
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
       optimizers->push_back(
           // Use the default target node name prefix "gradients/"
-          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization()));
+          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization(), "gradients/",
+                                      cfg_.memory_optimizer_target_bytes()));
     } else {
       optimizers->push_back(MakeUnique<MemoryOptimizer>(
           cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
+          cfg_.memory_optimizer_target_node_name_scope(),
+          cfg_.memory_optimizer_target_bytes()));
     }
   }
   if (cfg_.auto_parallel().enable()) {
@@ -400,8 +436,9 @@ void MetaOptimizer::InitializeVerifiers(
   }
 }
 
-Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                                    GraphDef* optimized_graph) {
+Status MetaOptimizer::OptimizeGraph(
+    Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+    std::vector<GraphOptimizationResult>* optimization_results) const {
   int min_graph_nodes = cfg_.min_graph_nodes() == 0 ? kDefaultMinGraphNodes
                                                     : cfg_.min_graph_nodes();
   if (item.graph.node_size() < min_graph_nodes) {
@@ -533,7 +570,7 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  optimization_results->push_back(optimization_result);
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -550,8 +587,17 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
 
 Status MetaOptimizer::RunOptimizer(
     GraphOptimizer* optimizer, Cluster* cluster, GrapplerItem* optimized_item,
-    GraphDef* optimized_graph, GraphOptimizationResult* optimization_result) {
+    GraphDef* optimized_graph,
+    GraphOptimizationResult* optimization_result) const {
   const uint64 start_us = Env::Default()->NowMicros();
+  const int nodes_before = optimized_graph->node_size();
+  profiler::TraceMe trace_me(
+      [&] {
+        return profiler::TraceMeEncode(
+            absl::StrCat("GrapplerPass:", optimizer->name()),
+            {{"nodes_before", nodes_before}});
+      },
+      profiler::TraceMeLevel::kInfo);
 
   // If optimizer doesn't need a function library, we will replace it with a
   // stub before running optimization, and will put it back at the end.
@@ -600,6 +646,10 @@ Status MetaOptimizer::RunOptimizer(
         PrintSizesBeforeAfter(optimized_item->graph, *optimized_graph),
         ", time = ", duration_ms, "ms.");
     VLOG(1) << optimizer->name() << ": " << message;
+    trace_me.AppendMetadata([&] {
+      return profiler::TraceMeEncode(
+          {{"nodes_after", optimized_graph->node_size()}});
+    });
   }
 
   // Swap function library back into the main graph.
@@ -644,6 +694,24 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
           item.graph.library().function_size(),
       item.graph.library().function_size());
 
+  // Return the result of a previous optimization of the same item, if any.
+  const OptimizedGraphCacheOptions& cache_options =
+      cfg_.optimized_graph_cache();
+  string cache_key;
+  if (cache_options.enable()) {
+    cache_key = OptimizedGraphCache::Key(item, cluster, cfg_);
+    if (OptimizedGraphCache::Global()->Lookup(cache_key, cache_options,
+                                              optimized_graph)) {
+      VLOG(1) << "Found the optimized graph of grappler item " << item.id
+              << " in the cache.";
+      GraphOptimizationResult optimization_result(item.id);
+      optimization_result.results.push_back(
+          {"optimized_graph_cache", "cache hit", Status::OK()});
+      optimization_results_.push_back(std::move(optimization_result));
+      return Status::OK();
+    }
+  }
+
   // Save a few small fields from item before we move it.
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
@@ -723,15 +791,94 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
     find_xla_compiled_functions(function.node_def());
   }
 
+  // Optimizes the body of `func` into `optimized_func_graph`, and the
+  // GrapplerFunctionItem it was made of into `func_item`. Only reads `flib`, so
+  // that multiple functions can be optimized concurrently.
+  const auto optimize_function =
+      [&](const FunctionDef& func, bool is_tpu_graph,
+          GrapplerFunctionItem* func_item, GraphDef* optimized_func_graph,
+          std::vector<GraphOptimizationResult>* optimization_results)
+      -> Status {
+    const string& func_name = func.signature().name();
+
+    // Make a GrapplerItem from a FunctionDef.
+    TF_RETURN_IF_ERROR(
+        MakeGrapplerFunctionItem(func, flib, producer, func_item));
+
+    // If we need to compute the gradient of optimized function at runtime, we
+    // can't perform non-differentiable rewrites.
+    func_item->optimization_options().allow_non_differentiable_rewrites =
+        !differentiable_functions.contains(func_name);
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item->devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item->optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    // Optimize function body graph.
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      FunctionDefLibrary func_item_function_library;
+      func_item_function_library.Swap(func_item->graph.mutable_library());
+      *func_item->graph.mutable_library() =
+          GetFunctionDefLibraryStub(func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, *func_item,
+                                              optimized_func_graph);
+    }
+    GrapplerFunctionItem func_item_copy = *func_item;
+    return OptimizeGraph(cluster, std::move(func_item_copy),
+                         optimized_func_graph, optimization_results);
+  };
+
+  // The state of the optimization of one function.
+  struct FunctionOptimization {
+    const FunctionDef* func = nullptr;
+    GrapplerFunctionItem func_item;
+    GraphDef optimized_func_graph;
+    std::vector<GraphOptimizationResult> optimization_results;
+    Status status;
+  };
+
+  const int num_threads = NumFunctionOptimizationThreads();
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+  if (optimize_function_library && num_threads > 1) {
+    thread_pool = absl::make_unique<thread::ThreadPool>(
+        Env::Default(), "grappler_optimize_functions", num_threads);
+  }
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
+    const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
 
-    int function_idx = 0;
+    std::vector<const FunctionDef*> funcs;
     for (const FunctionDef& func : optimized_graph->library().function()) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
-
       const string& func_name = func.signature().name();
 
       // Skip functions that are not reachable from the optimized graph.
@@ -751,86 +898,71 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       if (IsTFDataFunction(func)) continue;
 
       VLOG(3) << "Optimize function: function=" << func_name << " ["
-              << function_idx++ << " of "
+              << funcs.size() << " of "
               << optimized_graph->library().function_size() << "]";
 
       // Function optimization might specialize nested function calls, so we
       // have to reset the flag and do at least one more pass over the library.
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
+    // Functions are optimized `num_threads` at a time, against the library as
+    // it was before the current window, and are merged back into the library
+    // in library order. This keeps the output independent of thread
+    // scheduling, and bounds the number of function bodies held in memory.
+    for (size_t start = 0; start < funcs.size(); start += num_threads) {
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
+      const int window_size =
+          std::min<int>(num_threads, funcs.size() - start);
+      std::vector<FunctionOptimization> window(window_size);
+      for (int i = 0; i < window_size; ++i) {
+        window[i].func = funcs[start + i];
+      }
+      const auto optimize = [&](FunctionOptimization* f) {
+        f->status = optimize_function(*f->func, is_tpu_graph, &f->func_item,
+                                      &f->optimized_func_graph,
+                                      &f->optimization_results);
+      };
+      if (thread_pool != nullptr && window_size > 1) {
+        BlockingCounter counter(window_size);
+        for (FunctionOptimization& f : window) {
+          thread_pool->Schedule([&optimize, &counter, &f]() {
+            optimize(&f);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
       } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+        for (FunctionOptimization& f : window) optimize(&f);
       }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      for (FunctionOptimization& f : window) {
+        TF_RETURN_IF_ERROR(f.status);
+        for (GraphOptimizationResult& result : f.optimization_results) {
+          optimization_results_.push_back(std::move(result));
+        }
+
+        // Function body optimization might have created new specialized
+        // functions for each instantiation context. Add them to the library.
+        for (const FunctionDef& func_def :
+             f.optimized_func_graph.library().function()) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
         }
-      }
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+        // Convert optimized graph back to FunctionDef.
+        FunctionDef optimized_func;
+        f.func_item.SwapFunctionBody(std::move(f.optimized_func_graph));
+        TF_RETURN_IF_ERROR(MakeFunctionDef(f.func_item, flib, &optimized_func));
 
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+        // Replace optimized function with a new FunctionDef.
+        TF_RETURN_IF_ERROR(
+            flib.ReplaceFunction(f.func->signature().name(), optimized_func));
+      }
     }
 
     // If optimized at least one function, update the graph library.
@@ -852,6 +984,22 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   const uint64 end_us = Env::Default()->NowMicros();
   metrics::UpdateGrapplerPassTime("*", end_us - start_us);
 
+  // Only cache graphs which all optimizers succeeded on, so that transient
+  // failures don't stick.
+  if (!cache_key.empty() &&
+      std::all_of(optimization_results_.begin(), optimization_results_.end(),
+                  [](const GraphOptimizationResult& graph_result) {
+                    return std::all_of(
+                        graph_result.results.begin(),
+                        graph_result.results.end(),
+                        [](const OptimizerResult& result) {
+                          return result.status.ok();
+                        });
+                  })) {
+    OptimizedGraphCache::Global()->Insert(cache_key, cache_options,
+                                          *optimized_graph);
+  }
+
   return Status::OK();
 }
 
@@ -891,6 +1039,8 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.host_placement_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.dynamic_quantization() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
          !rewrite_cfg.optimizers().empty() ||
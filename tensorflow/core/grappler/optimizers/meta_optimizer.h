@@ -83,15 +83,6 @@ class MetaOptimizer : public GraphOptimizer {
       std::vector<std::unique_ptr<GraphVerifier>>* post_optimization_verifiers)
       const;
 
-  // Run optimization pass over a single GrapplerItem. Meta optimizer might run
-  // multiple such passes: 1) for the main graph 2) for the function library
-  Status OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                       GraphDef* optimized_graph);
-
-  DeviceBase* const cpu_device_;  // may be NULL
-  ConfigProto config_proto_;
-  RewriterConfig& cfg_;
-
   struct OptimizerResult {
     string optimizer_name;
     string message;
@@ -104,9 +95,31 @@ class MetaOptimizer : public GraphOptimizer {
     std::vector<OptimizerResult> results;
   };
 
+  // Run optimization pass over a single GrapplerItem. Meta optimizer might run
+  // multiple such passes: 1) for the main graph 2) for the function library
+  Status OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
+                       GraphDef* optimized_graph) {
+    return OptimizeGraph(cluster, std::move(item), optimized_graph,
+                         &optimization_results_);
+  }
+  // Same as above, but appends the result of the pass to
+  // `optimization_results` instead of `optimization_results_`, so that
+  // multiple passes can run concurrently.
+  Status OptimizeGraph(
+      Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+      std::vector<GraphOptimizationResult>* optimization_results) const;
+
+  // Returns the number of functions of the function library to optimize
+  // concurrently.
+  int NumFunctionOptimizationThreads() const;
+
+  DeviceBase* const cpu_device_;  // may be NULL
+  ConfigProto config_proto_;
+  RewriterConfig& cfg_;
+
   Status RunOptimizer(GraphOptimizer* optimizer, Cluster* cluster,
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
-                      GraphOptimizationResult* optimization_result);
+                      GraphOptimizationResult* optimization_result) const;
 
   std::vector<GraphOptimizationResult> optimization_results_;
 };
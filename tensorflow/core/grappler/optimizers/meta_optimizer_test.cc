@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/function_testlib.h"
@@ -399,6 +400,93 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
   test::ExpectTensorEqual<int>(tensors_expected[1], tensors[1]);
 }
 
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryInParallel) {
+  using test::function::NDef;
+
+  // Define function library:
+  //
+  //   MyMul(x, y)     = x * y
+  //  *MySquare_i(x)   = MyMul(x, x)   for i in [0, 10)
+  //
+  //  * - marked as noinline
+  FunctionDef mul_func = FunctionDefHelper::Create(
+      "MyMul", {"x:T", "y:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"mul"}, "Mul", {"x", "y"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}});
+
+  // Tensorflow graph:
+  //
+  //   a = tf.Placeholder(tf.float);
+  //   square_i = MySquare_i(a);
+  constexpr int kNumFunctions = 10;
+  std::vector<FunctionDef> funcs = {mul_func};
+  std::vector<NodeDef> nodes = {
+      NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const string func_name = absl::StrCat("MySquare_", i);
+    FunctionDef square_func = FunctionDefHelper::Create(
+        func_name, {"x:T"}, {"z:T"}, {"T: {float, double}"},
+        {{{"my_mul"}, "MyMul", {"x", "x"}, {{"T", "$T"}}}},
+        /*ret_def=*/
+        {{"z", "my_mul:z:0"}});
+    (*square_func.mutable_attr())["_noinline"].set_b(true);
+    funcs.push_back(square_func);
+    nodes.push_back(NDef(absl::StrCat("square_", i), func_name, {"a"},
+                         {{"T", DT_FLOAT}}, kDevice));
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, funcs);
+
+  // The output must not depend on the number of threads.
+  const auto optimize = [&item](int parallelism, GraphDef* output) {
+    ConfigProto config_proto;
+    auto& rewriter_config =
+        *config_proto.mutable_graph_options()->mutable_rewrite_options();
+    rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+    rewriter_config.set_function_optimization(RewriterConfig::ON);
+    rewriter_config.add_optimizers("function");
+    rewriter_config.set_min_graph_nodes(-1);
+    rewriter_config.set_function_optimization_parallelism(parallelism);
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, output));
+  };
+  GraphDef sequential_output;
+  optimize(1, &sequential_output);
+  for (int parallelism : {3, kNumFunctions, 2 * kNumFunctions}) {
+    GraphDef parallel_output;
+    optimize(parallelism, &parallel_output);
+    CompareGraphs(sequential_output, parallel_output);
+    ASSERT_EQ(sequential_output.library().function_size(),
+              parallel_output.library().function_size());
+    for (int i = 0; i < sequential_output.library().function_size(); ++i) {
+      EXPECT_TRUE(
+          FunctionDefsEqual(sequential_output.library().function(i),
+                            parallel_output.library().function(i)))
+          << parallelism << " threads: "
+          << parallel_output.library().function(i).DebugString();
+    }
+  }
+
+  // Every function must have been specialized, with MyMul inlined into it.
+  FunctionLibraryDefinition optimized_flib(OpRegistry::Global(),
+                                           sequential_output.library());
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const FunctionDef* optimized_func = optimized_flib.Find(absl::Substitute(
+        "MySquare_$0_specialized_for_square_$0_at_tf_graph", i));
+    ASSERT_NE(optimized_func, nullptr);
+    int count = 0;
+    for (const NodeDef& node : optimized_func->node_def()) {
+      if (node.name() == "my_mul/mul" && ++count) {
+        EXPECT_EQ("Mul", node.op());
+      }
+    }
+    EXPECT_EQ(1, count);
+  }
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryPruneUnusedOutputs) {
   using test::function::NDef;
 
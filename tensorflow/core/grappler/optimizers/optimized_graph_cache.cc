@@ -0,0 +1,274 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace grappler {
+
+/* static */ constexpr char OptimizedGraphCache::kFileSuffix[];
+
+namespace {
+
+constexpr int64 kDefaultMaxMemoryBytes = 256LL << 20;     // 256 MiB
+constexpr int64 kDefaultMaxDirectoryBytes = 4LL << 30;  // 4 GiB
+constexpr size_t kChecksumSize = sizeof(uint32);
+
+// Appends `field` to `key`, prefixed with its size so that different
+// sequences of fields never produce the same key.
+void AppendField(StringPiece field, std::string* key) {
+  absl::StrAppend(key, field.size(), ":", field);
+}
+
+void AppendProto(const protobuf::MessageLite& proto, std::string* key) {
+  std::string serialized;
+  SerializeToStringDeterministic(proto, &serialized);
+  AppendField(serialized, key);
+}
+
+int64 MaxMemoryBytes(const OptimizedGraphCacheOptions& options) {
+  return options.max_memory_bytes() > 0 ? options.max_memory_bytes()
+                                        : kDefaultMaxMemoryBytes;
+}
+
+int64 MaxDirectoryBytes(const OptimizedGraphCacheOptions& options) {
+  return options.max_directory_bytes() > 0 ? options.max_directory_bytes()
+                                           : kDefaultMaxDirectoryBytes;
+}
+
+std::string CacheFilename(const std::string& directory,
+                          const std::string& key) {
+  return io::JoinPath(directory,
+                      absl::StrCat(key, OptimizedGraphCache::kFileSuffix));
+}
+
+}  // namespace
+
+/* static */ OptimizedGraphCache* OptimizedGraphCache::Global() {
+  static OptimizedGraphCache* cache = new OptimizedGraphCache(Env::Default());
+  return cache;
+}
+
+/* static */ std::string OptimizedGraphCache::Key(const GrapplerItem& item,
+                                                  const Cluster* cluster,
+                                                  const RewriterConfig& cfg) {
+  std::string key;
+  AppendField(TF_VERSION_STRING, &key);
+  AppendField(absl::StrCat(TF_GRAPH_DEF_VERSION), &key);
+  AppendProto(item.graph, &key);
+  for (const auto& feed : item.feed) {
+    AppendField(feed.first, &key);
+    AppendField(DataTypeString(feed.second.dtype()), &key);
+    AppendField(feed.second.shape().DebugString(), &key);
+  }
+  AppendField("fetch", &key);
+  for (const string& fetch : item.fetch) AppendField(fetch, &key);
+  AppendField("keep_ops", &key);
+  for (const string& keep_op : item.keep_ops) AppendField(keep_op, &key);
+  AppendField("init_ops", &key);
+  for (const string& init_op : item.init_ops) AppendField(init_op, &key);
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  AppendField(absl::StrCat(options.allow_non_differentiable_rewrites,
+                           options.allow_pruning_stateful_and_dataset_ops,
+                           options.optimize_function_library,
+                           options.is_eager_mode),
+              &key);
+
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  AppendField("devices", &key);
+  for (const string& device : devices) AppendField(device, &key);
+  if (cluster != nullptr) {
+    std::vector<string> names;
+    for (const auto& device : cluster->GetDevices()) {
+      names.push_back(device.first);
+    }
+    std::sort(names.begin(), names.end());
+    AppendField("cluster", &key);
+    for (const string& name : names) {
+      AppendField(name, &key);
+      AppendProto(cluster->GetDevices().at(name), &key);
+    }
+  }
+
+  // Where the graph is cached doesn't affect the optimized graph.
+  RewriterConfig cfg_without_cache = cfg;
+  cfg_without_cache.clear_optimized_graph_cache();
+  AppendProto(cfg_without_cache, &key);
+
+  const Fprint128 fingerprint = Fingerprint128(key);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+bool OptimizedGraphCache::Lookup(const std::string& key,
+                                 const OptimizedGraphCacheOptions& options,
+                                 GraphDef* graph) {
+  {
+    mutex_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+      *graph = *it->second.graph;
+      return true;
+    }
+  }
+  if (options.directory().empty() ||
+      !LookupFile(CacheFilename(options.directory(), key), graph)) {
+    return false;
+  }
+  InsertInMemory(key, options, std::make_shared<const GraphDef>(*graph));
+  return true;
+}
+
+void OptimizedGraphCache::Insert(const std::string& key,
+                                 const OptimizedGraphCacheOptions& options,
+                                 const GraphDef& graph) {
+  InsertInMemory(key, options, std::make_shared<const GraphDef>(graph));
+  if (options.directory().empty()) return;
+  Status s = WriteFile(CacheFilename(options.directory(), key), graph);
+  if (s.ok()) {
+    s = EvictFiles(options.directory(), MaxDirectoryBytes(options));
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to cache the optimized graph in "
+                 << options.directory() << ": " << s;
+  }
+}
+
+void OptimizedGraphCache::Clear() {
+  mutex_lock l(mu_);
+  lru_.clear();
+  entries_.clear();
+  memory_bytes_ = 0;
+}
+
+int64 OptimizedGraphCache::memory_bytes() const {
+  mutex_lock l(mu_);
+  return memory_bytes_;
+}
+
+void OptimizedGraphCache::InsertInMemory(
+    const std::string& key, const OptimizedGraphCacheOptions& options,
+    std::shared_ptr<const GraphDef> graph) {
+  const int64 size_bytes = graph->ByteSizeLong();
+  const int64 max_bytes = MaxMemoryBytes(options);
+  if (size_bytes > max_bytes) return;
+  mutex_lock l(mu_);
+  if (entries_.contains(key)) return;
+  lru_.push_front(key);
+  entries_[key] = Entry{std::move(graph), size_bytes, lru_.begin()};
+  memory_bytes_ += size_bytes;
+  while (memory_bytes_ > max_bytes) {
+    auto it = entries_.find(lru_.back());
+    memory_bytes_ -= it->second.size_bytes;
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+// A cache file holds the serialized graph, followed by the masked crc32c of
+// the serialized graph.
+bool OptimizedGraphCache::LookupFile(const std::string& filename,
+                                     GraphDef* graph) {
+  if (!env_->FileExists(filename).ok()) return false;
+  std::string contents;
+  Status s = ReadFileToString(env_, filename, &contents);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to read cached graph " << filename << ": " << s;
+    return false;
+  }
+  if (contents.size() >= kChecksumSize) {
+    const size_t size = contents.size() - kChecksumSize;
+    const uint32 checksum = core::DecodeFixed32(contents.data() + size);
+    if (crc32c::Unmask(checksum) == crc32c::Value(contents.data(), size) &&
+        graph->ParseFromArray(contents.data(), size)) {
+      return true;
+    }
+  }
+  // The file was not written by `WriteFile`, e.g. by a different version.
+  LOG(WARNING) << "Removing invalid cached graph " << filename;
+  env_->DeleteFile(filename).IgnoreError();
+  return false;
+}
+
+Status OptimizedGraphCache::WriteFile(const std::string& filename,
+                                      const GraphDef& graph) {
+  TF_RETURN_IF_ERROR(
+      env_->RecursivelyCreateDir(std::string(io::Dirname(filename))));
+  std::string contents;
+  if (!SerializeToStringDeterministic(graph, &contents)) {
+    return errors::Internal("Failed to serialize the optimized graph.");
+  }
+  char checksum[kChecksumSize];
+  core::EncodeFixed32(checksum,
+                      crc32c::Mask(crc32c::Value(contents.data(),
+                                                 contents.size())));
+  contents.append(checksum, kChecksumSize);
+  // Renaming the file into place keeps concurrent readers from seeing a
+  // partial file.
+  const std::string temp_filename =
+      absl::StrCat(filename, ".", random::New64(), ".tmp");
+  TF_RETURN_IF_ERROR(WriteStringToFile(env_, temp_filename, contents));
+  return env_->RenameFile(temp_filename, filename);
+}
+
+Status OptimizedGraphCache::EvictFiles(const std::string& directory,
+                                       int64 max_bytes) {
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(env_->GetChildren(directory, &children));
+  struct File {
+    std::string filename;
+    FileStatistics stats;
+  };
+  std::vector<File> files;
+  int64 total_bytes = 0;
+  for (const string& child : children) {
+    if (!absl::EndsWith(child, kFileSuffix)) continue;
+    File file{io::JoinPath(directory, child)};
+    // Another process may have removed the file in the meantime.
+    if (!env_->Stat(file.filename, &file.stats).ok()) continue;
+    total_bytes += file.stats.length;
+    files.push_back(std::move(file));
+  }
+  std::sort(files.begin(), files.end(), [](const File& a, const File& b) {
+    return a.stats.mtime_nsec < b.stats.mtime_nsec;
+  });
+  for (const File& file : files) {
+    if (total_bytes <= max_bytes) break;
+    VLOG(1) << "Evicting cached graph " << file.filename;
+    env_->DeleteFile(file.filename).IgnoreError();
+    total_bytes -= file.stats.length;
+  }
+  return Status::OK();
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A cache of the graphs optimized by the MetaOptimizer, keyed by a
+// fingerprint of everything the optimization depends on: the graph and its
+// function library, the fetch, feed and keep nodes, the optimization options,
+// the available devices, the RewriterConfig and the TensorFlow version.
+//
+// Graphs are cached in memory, in least recently used order, and optionally
+// in a directory shared with other processes (see
+// OptimizedGraphCacheOptions). Changing anything that is part of the key,
+// e.g. upgrading TensorFlow, makes the old entries unreachable; they are
+// eventually evicted by the size limits.
+class OptimizedGraphCache {
+ public:
+  // The suffix of the cache files in the cache directory.
+  static constexpr char kFileSuffix[] = ".optimized_graph";
+
+  explicit OptimizedGraphCache(Env* env) : env_(env) {}
+
+  // Returns the cache of the process.
+  static OptimizedGraphCache* Global();
+
+  // Returns the key of the result of optimizing `item` for `cluster` with
+  // `cfg`. `cluster` may be null.
+  static std::string Key(const GrapplerItem& item, const Cluster* cluster,
+                         const RewriterConfig& cfg);
+
+  // Returns true, and the cached graph in `*graph`, if there is a graph for
+  // `key` in memory or in `options.directory()`.
+  bool Lookup(const std::string& key, const OptimizedGraphCacheOptions& options,
+              GraphDef* graph);
+
+  // Caches `graph` for `key`, in memory and in `options.directory()`. Errors
+  // writing the cache file are logged and otherwise ignored.
+  void Insert(const std::string& key, const OptimizedGraphCacheOptions& options,
+              const GraphDef& graph);
+
+  // Removes all graphs cached in memory.
+  void Clear();
+
+  // Returns the total size of the graphs cached in memory.
+  int64 memory_bytes() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const GraphDef> graph;
+    int64 size_bytes;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  void InsertInMemory(const std::string& key,
+                      const OptimizedGraphCacheOptions& options,
+                      std::shared_ptr<const GraphDef> graph);
+  bool LookupFile(const std::string& filename, GraphDef* graph);
+  Status WriteFile(const std::string& filename, const GraphDef& graph);
+  // Removes the oldest cache files until they fit in `max_bytes`.
+  Status EvictFiles(const std::string& directory, int64 max_bytes);
+
+  Env* const env_;
+  mutable mutex mu_;
+  // The keys of the cached graphs, most recently used first.
+  std::list<std::string> lru_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, Entry> entries_ TF_GUARDED_BY(mu_);
+  int64 memory_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
@@ -0,0 +1,162 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+GraphDef MakeGraph(const string& node_name) {
+  GraphDef graph;
+  NodeDef* node = graph.add_node();
+  node->set_name(node_name);
+  node->set_op("NoOp");
+  return graph;
+}
+
+GrapplerItem MakeItem(const string& node_name) {
+  GrapplerItem item;
+  item.id = "item";
+  item.graph = MakeGraph(node_name);
+  item.fetch.push_back(node_name);
+  return item;
+}
+
+string TestDirectory(const string& name) {
+  const string directory = io::JoinPath(testing::TmpDir(), name);
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(directory, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return directory;
+}
+
+TEST(OptimizedGraphCacheTest, KeyDependsOnTheInputs) {
+  RewriterConfig cfg;
+  const GrapplerItem item = MakeItem("a");
+  const string key = OptimizedGraphCache::Key(item, nullptr, cfg);
+  EXPECT_EQ(key, OptimizedGraphCache::Key(MakeItem("a"), nullptr, cfg));
+  EXPECT_NE(key, OptimizedGraphCache::Key(MakeItem("b"), nullptr, cfg));
+
+  GrapplerItem other_fetch = MakeItem("a");
+  other_fetch.fetch.clear();
+  EXPECT_NE(key, OptimizedGraphCache::Key(other_fetch, nullptr, cfg));
+
+  GrapplerItem other_devices = MakeItem("a");
+  TF_ASSERT_OK(other_devices.AddDevice("/job:a/replica:0/task:0/device:CPU:0"));
+  EXPECT_NE(key, OptimizedGraphCache::Key(other_devices, nullptr, cfg));
+
+  RewriterConfig other_cfg;
+  other_cfg.set_constant_folding(RewriterConfig::OFF);
+  EXPECT_NE(key, OptimizedGraphCache::Key(item, nullptr, other_cfg));
+
+  // The cache options themselves are not part of the key.
+  RewriterConfig cache_cfg;
+  cache_cfg.mutable_optimized_graph_cache()->set_enable(true);
+  cache_cfg.mutable_optimized_graph_cache()->set_directory("/tmp/cache");
+  EXPECT_EQ(key, OptimizedGraphCache::Key(item, nullptr, cache_cfg));
+}
+
+TEST(OptimizedGraphCacheTest, InMemory) {
+  OptimizedGraphCache cache(Env::Default());
+  OptimizedGraphCacheOptions options;
+  options.set_enable(true);
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup("key", options, &graph));
+  cache.Insert("key", options, MakeGraph("optimized"));
+  ASSERT_TRUE(cache.Lookup("key", options, &graph));
+  EXPECT_EQ("optimized", graph.node(0).name());
+  EXPECT_GT(cache.memory_bytes(), 0);
+  cache.Clear();
+  EXPECT_FALSE(cache.Lookup("key", options, &graph));
+  EXPECT_EQ(0, cache.memory_bytes());
+}
+
+TEST(OptimizedGraphCacheTest, EvictsLeastRecentlyUsed) {
+  OptimizedGraphCache cache(Env::Default());
+  OptimizedGraphCacheOptions options;
+  options.set_enable(true);
+  const int64 graph_bytes = MakeGraph("graph0").ByteSizeLong();
+  options.set_max_memory_bytes(2 * graph_bytes);
+  cache.Insert("key0", options, MakeGraph("graph0"));
+  cache.Insert("key1", options, MakeGraph("graph1"));
+  GraphDef graph;
+  // Makes "key1" the least recently used.
+  EXPECT_TRUE(cache.Lookup("key0", options, &graph));
+  cache.Insert("key2", options, MakeGraph("graph2"));
+  EXPECT_TRUE(cache.Lookup("key0", options, &graph));
+  EXPECT_FALSE(cache.Lookup("key1", options, &graph));
+  EXPECT_TRUE(cache.Lookup("key2", options, &graph));
+  EXPECT_EQ(2 * graph_bytes, cache.memory_bytes());
+}
+
+TEST(OptimizedGraphCacheTest, SharesGraphsThroughTheDirectory) {
+  OptimizedGraphCacheOptions options;
+  options.set_enable(true);
+  options.set_directory(TestDirectory("shared"));
+  OptimizedGraphCache writer(Env::Default());
+  writer.Insert("key", options, MakeGraph("optimized"));
+
+  OptimizedGraphCache reader(Env::Default());
+  GraphDef graph;
+  ASSERT_TRUE(reader.Lookup("key", options, &graph));
+  EXPECT_EQ("optimized", graph.node(0).name());
+  EXPECT_FALSE(reader.Lookup("other_key", options, &graph));
+}
+
+TEST(OptimizedGraphCacheTest, RemovesInvalidFiles) {
+  OptimizedGraphCacheOptions options;
+  options.set_enable(true);
+  options.set_directory(TestDirectory("invalid"));
+  OptimizedGraphCache writer(Env::Default());
+  writer.Insert("key", options, MakeGraph("optimized"));
+
+  const string filename = io::JoinPath(
+      options.directory(), strings::StrCat("key",
+                                           OptimizedGraphCache::kFileSuffix));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  contents[0] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+
+  OptimizedGraphCache reader(Env::Default());
+  GraphDef graph;
+  EXPECT_FALSE(reader.Lookup("key", options, &graph));
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(filename)));
+}
+
+TEST(OptimizedGraphCacheTest, LimitsTheDirectorySize) {
+  OptimizedGraphCacheOptions options;
+  options.set_enable(true);
+  options.set_directory(TestDirectory("limited"));
+  options.set_max_directory_bytes(1);
+  OptimizedGraphCache cache(Env::Default());
+  cache.Insert("key0", options, MakeGraph("graph0"));
+  cache.Insert("key1", options, MakeGraph("graph1"));
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(options.directory(), &children));
+  EXPECT_TRUE(children.empty());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
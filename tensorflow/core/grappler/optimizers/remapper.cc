@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/remapper_fusion.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
@@ -62,6 +63,12 @@ namespace grappler {
 //
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
 // patterns are "ContractionWith...".
+//
+// Additional patterns can be registered with REGISTER_REMAPPER_FUSION_PATTERN
+// (see remapper_fusion.h), and are fused where OpLevelCostEstimator predicts
+// that fusing them saves time. The CPU forms of the contraction + BiasAdd +
+// <Activation> patterns above are also registered there, so that they are
+// fused where their intermediate results have other uses too.
 namespace {
 
 constexpr char kFusedConv2D[] = "_FusedConv2D";
@@ -252,7 +259,7 @@ bool IsCpuCompatibleDataType(const NodeDef* contraction,
 bool IsGpuCompatibleDataType(const NodeDef* contraction,
                              const string& type_attr = "T") {
   DataType dtype = GetDataTypeFromAttr(*contraction, type_attr);
-  if (IsConv2D(*contraction)) {
+  if (IsConv2D(*contraction) || IsMatMul(*contraction)) {
     return dtype == DT_FLOAT;
   } else {
     return false;
@@ -292,6 +299,11 @@ bool IsCpuCompatibleMatMul(const NodeDef* matmul) {
   return NodeIsOnCpu(matmul) && IsCpuCompatibleDataType(matmul);
 }
 
+bool IsGpuCompatibleMatMul(const NodeDef* matmul) {
+  DCHECK(IsMatMul(*matmul)) << "Expected MatMul op";
+  return NodeIsOnGpu(matmul) && IsGpuCompatibleDataType(matmul);
+}
+
 bool IsCpuCompatibleDepthwiseConv2dNative(const NodeDef* dw_conv2d) {
   DCHECK(IsDepthwiseConv2dNative(*dw_conv2d))
       << "Expected DepthwiseConv2dNative op";
@@ -317,15 +329,26 @@ bool IsCpuCompatible(const RemapperContext& ctx, const Pattern& matched) {
   }
 }
 
-// Checks if we can rewrite a pattern to the `_FusedConv2D` on GPU device.
+// Checks if we can rewrite a pattern to the `_Fused{Conv2D,MatMul}` on GPU
+// device.
 bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithBiasAddAndActivation& matched) {
+  const GraphDef* graph = ctx.graph_view.graph();
+  const NodeDef& contraction_node = graph->node(matched.contraction);
+
+  // _FusedMatMul runs the GEMM with cuBLAS and applies the bias and any of
+  // the activations its CPU kernel supports in one elementwise kernel.
+  if (IsMatMul(contraction_node)) {
+    const NodeDef& activation_node = graph->node(matched.activation);
+    return (IsRelu(activation_node) || IsRelu6(activation_node) ||
+            IsElu(activation_node)) &&
+           IsGpuCompatibleMatMul(&contraction_node);
+  }
+
 #if TENSORFLOW_USE_ROCM
   // ROCm does not support _FusedConv2D
   return false;
 #endif
-  const GraphDef* graph = ctx.graph_view.graph();
-  const NodeDef& contraction_node = graph->node(matched.contraction);
   if (!IsConv2D(contraction_node)) return false;
 
   const std::vector<OpInfo::TensorProperties>& input_props =
@@ -351,7 +374,9 @@ bool IsGpuCompatible(const RemapperContext& ctx,
 }
 bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithBiasAdd& matched) {
-  return false;
+  const NodeDef& contraction_node =
+      ctx.graph_view.graph()->node(matched.contraction);
+  return IsMatMul(contraction_node) && IsGpuCompatibleMatMul(&contraction_node);
 }
 bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithSqueezeAndBiasAdd& matched) {
@@ -1740,22 +1765,42 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   Status status;
   RemapperContext ctx(&mutable_item, &status);
   TF_RETURN_IF_ERROR(status);
+
+  // _Fused{...} kernels do not have registered gradient function, so we must
+  // not perform rewrite if the graph will be differentiated later.
+  bool allow_non_differentiable_rewrites =
+      item.optimization_options().allow_non_differentiable_rewrites;
+
+  // Fuse the patterns registered with REGISTER_REMAPPER_FUSION_PATTERN where
+  // the cost model estimates that it makes the graph faster. Unlike the
+  // patterns below, their matches are chosen globally, and may overlap.
+  const std::vector<FusionPattern>& fusion_patterns =
+      FusionPatternRegistry::GetRegisteredPatterns();
+  if (allow_non_differentiable_rewrites && !fusion_patterns.empty()) {
+    const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
+    TF_RETURN_IF_ERROR(ctx.graph_properties.InferStatically(
+        assume_valid_feeds,
+        /*aggressive_shape_inference=*/false,
+        /*include_input_tensor_values=*/true,
+        /*include_output_tensor_values=*/false));
+    ctx.inferred_graph_properties = true;
+    std::unordered_set<string> fused_nodes;
+    TF_RETURN_IF_ERROR(FuseWithCostModel(fusion_patterns,
+                                         ctx.nodes_to_preserve, &ctx.graph_view,
+                                         &ctx.graph_properties, &fused_nodes));
+  }
+
   // Processing graph in reverse-topological sorted order allows to remap
   // longer chains of dependent ops in one pass.
   TF_RETURN_IF_ERROR(
       ctx.graph_view.SortTopologically(/*ignore_cycles=*/false, {}));
 
-  const int num_nodes = item.graph.node_size();
+  const int num_nodes = ctx.graph_view.NumNodes();
   // Skip nodes that were invalidated by a remapper, e.g. do not process BiasAdd
   // and Activation nodes that were fused into a Conv2D node.
   std::vector<bool> invalidated_nodes(num_nodes);
   std::vector<bool> nodes_to_delete(num_nodes);
 
-  // _Fused{...} kernels do not have registered gradient function, so we must
-  // not perform rewrite if the graph will be differentiated later.
-  bool allow_non_differentiable_rewrites =
-      item.optimization_options().allow_non_differentiable_rewrites;
-
   for (int i = num_nodes - 1; i >= 0; --i) {
     // Check if node was invalidated by one of the previous remaps.
     if (invalidated_nodes[i] || nodes_to_delete[i]) {
@@ -0,0 +1,491 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/remapper_fusion.h"
+
+#include <algorithm>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+std::vector<FusionPattern>* GetPatterns() {
+  static std::vector<FusionPattern>* patterns = new std::vector<FusionPattern>;
+  return patterns;
+}
+
+bool IsOnDeviceType(const NodeDef& node, const string& device_type) {
+  if (device_type.empty()) return true;
+  if (device_type == DEVICE_CPU) return NodeIsOnCpu(&node);
+  if (device_type == DEVICE_GPU) return NodeIsOnGpu(&node);
+  return false;
+}
+
+double TensorBytes(const OpInfo::TensorProperties& tensor) {
+  // Like OpLevelCostEstimator, count unknown dimensions as 1.
+  double num_elements = 1;
+  if (!tensor.shape().unknown_rank()) {
+    for (const auto& dim : tensor.shape().dim()) {
+      num_elements *= std::max<int64>(1, dim.size());
+    }
+  }
+  return num_elements * DataTypeSize(BaseType(tensor.dtype()));
+}
+
+// Finds the matches of a pattern in the graph and estimates their benefit.
+class FusionMatcher {
+ public:
+  FusionMatcher(const utils::MutableGraphView& graph_view,
+                const GraphProperties& graph_properties,
+                const std::unordered_set<string>& nodes_to_preserve,
+                const std::unordered_set<string>& excluded_nodes,
+                const OpLevelCostEstimator& estimator)
+      : graph_view_(graph_view),
+        graph_properties_(graph_properties),
+        nodes_to_preserve_(nodes_to_preserve),
+        excluded_nodes_(excluded_nodes),
+        estimator_(estimator) {}
+
+  void FindMatches(const FusionPattern& pattern, int root,
+                   std::vector<FusionCandidate>* candidates) {
+    std::vector<int> chain = {root};
+    if (!CanFuse(pattern, chain, /*position=*/0, *graph_view_.GetNode(root))) {
+      return;
+    }
+    ExtendChain(pattern, &chain, candidates);
+  }
+
+ private:
+  struct NodeCost {
+    double compute_ns = 0;
+    double memory_ns = 0;
+  };
+
+  // Returns true if `node` can be the node at `position` in `chain`, whose
+  // first node is the root.
+  bool CanFuse(const FusionPattern& pattern, const std::vector<int>& chain,
+               int position, const utils::MutableNodeView& node) const {
+    const NodeDef& node_def = *node.node();
+    const NodeDef& root = *graph_view_.GetNode(chain[0])->node();
+    if (!absl::c_linear_search(pattern.ops[position], node_def.op())) {
+      return false;
+    }
+    // Control dependencies are not forwarded to the fused node.
+    if (node.NumControllingFanins() > 0 || node.NumControlledFanouts() > 0) {
+      return false;
+    }
+    if (excluded_nodes_.count(node_def.name()) > 0) return false;
+    if (node_def.device() != root.device() ||
+        !IsOnDeviceType(node_def, pattern.device_type)) {
+      return false;
+    }
+    const DataType type = GetDataTypeFromAttr(node_def, "T");
+    if (type != GetDataTypeFromAttr(root, "T")) return false;
+    if (!pattern.types.empty() && !absl::c_linear_search(pattern.types, type)) {
+      return false;
+    }
+    for (const auto& constraint : pattern.attrs) {
+      if (constraint.position != position) continue;
+      const AttrValue* value = node.GetAttr(constraint.name);
+      if (value == nullptr || value->s() != constraint.value) return false;
+    }
+    // The other inputs of the node must not come from the chain.
+    for (int i = 1; i < node.NumRegularFanins(); ++i) {
+      if (absl::c_linear_search(chain, node.GetRegularFanin(i).node_index())) {
+        return false;
+      }
+    }
+    if (!graph_properties_.HasInputProperties(node_def.name()) ||
+        !graph_properties_.HasOutputProperties(node_def.name())) {
+      return false;
+    }
+    return true;
+  }
+
+  void ExtendChain(const FusionPattern& pattern, std::vector<int>* chain,
+                   std::vector<FusionCandidate>* candidates) {
+    if (chain->size() == pattern.ops.size()) {
+      FusionCandidate candidate;
+      if (MakeCandidate(pattern, *chain, &candidate)) {
+        candidates->push_back(std::move(candidate));
+      }
+      return;
+    }
+    // Every consumer of the last node is an alternative.
+    const auto* last = graph_view_.GetNode(chain->back());
+    for (const auto& fanout : last->GetRegularFanout(0)) {
+      if (fanout.index() != 0) continue;
+      if (absl::c_linear_search(*chain, fanout.node_index())) continue;
+      if (!CanFuse(pattern, *chain, chain->size(), *fanout.node_view())) {
+        continue;
+      }
+      chain->push_back(fanout.node_index());
+      ExtendChain(pattern, chain, candidates);
+      chain->pop_back();
+    }
+  }
+
+  bool MakeCandidate(const FusionPattern& pattern,
+                     const std::vector<int>& chain,
+                     FusionCandidate* candidate) {
+    // The fused node replaces the last node, so it must provide all of its
+    // outputs that are used.
+    const auto& last_fanouts = graph_view_.GetNode(chain.back())
+                                   ->GetRegularFanouts();
+    for (int port = 1; port < last_fanouts.size(); ++port) {
+      if (!last_fanouts[port].empty()) return false;
+    }
+
+    candidate->pattern = &pattern;
+    candidate->nodes = chain;
+    candidate->num_kept = 0;
+    for (int i = 0; i + 1 < chain.size(); ++i) {
+      const auto* node = graph_view_.GetNode(chain[i]);
+      const auto& fanouts = node->GetRegularFanouts();
+      bool has_other_uses = nodes_to_preserve_.count(node->GetName()) > 0;
+      for (int port = 0; port < fanouts.size() && !has_other_uses; ++port) {
+        for (const auto& fanout : fanouts[port]) {
+          if (port != 0 || fanout.node_index() != chain[i + 1]) {
+            has_other_uses = true;
+            break;
+          }
+        }
+      }
+      if (has_other_uses) candidate->num_kept = i + 1;
+    }
+    candidate->benefit = EstimateBenefit(*candidate);
+    return true;
+  }
+
+  // Without the fusion, every node reads its inputs from memory and writes its
+  // outputs to memory. With the fusion, the fused node does all the
+  // computations of the chain, but only reads the inputs of the chain and
+  // writes its output, while the kept nodes still run as before.
+  double EstimateBenefit(const FusionCandidate& candidate) {
+    double removed_ns = 0;
+    double fused_compute_ns = 0;
+    double fused_bytes = 0;
+    for (int i = 0; i < candidate.nodes.size(); ++i) {
+      const int node_index = candidate.nodes[i];
+      const NodeCost cost = GetNodeCost(node_index);
+      fused_compute_ns += cost.compute_ns;
+      if (i >= candidate.num_kept) {
+        removed_ns += cost.compute_ns + cost.memory_ns;
+      }
+      const auto& inputs =
+          graph_properties_.GetInputProperties(GetName(node_index));
+      for (int j = i == 0 ? 0 : 1; j < inputs.size(); ++j) {
+        fused_bytes += TensorBytes(inputs[j]);
+      }
+    }
+    const string& last = GetName(candidate.nodes.back());
+    for (const auto& output : graph_properties_.GetOutputProperties(last)) {
+      fused_bytes += TensorBytes(output);
+    }
+    const DeviceProperties& device =
+        GetDevice(graph_view_.GetNode(candidate.nodes[0])->GetDevice());
+    const double gb_per_sec = estimator_.GetDeviceInfo(device).gb_per_sec;
+    return removed_ns - fused_compute_ns - fused_bytes / gb_per_sec;
+  }
+
+  const string& GetName(int node_index) const {
+    return graph_view_.GetNode(node_index)->GetName();
+  }
+
+  NodeCost GetNodeCost(int node_index) {
+    auto it = node_costs_.find(node_index);
+    if (it != node_costs_.end()) return it->second;
+
+    const NodeDef& node = *graph_view_.GetNode(node_index)->node();
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.device_name = node.device();
+    OpInfo& op_info = op_context.op_info;
+    op_info.set_op(node.op());
+    *op_info.mutable_attr() = node.attr();
+    for (const auto& input :
+         graph_properties_.GetInputProperties(node.name())) {
+      *op_info.add_inputs() = input;
+    }
+    for (const auto& output :
+         graph_properties_.GetOutputProperties(node.name())) {
+      *op_info.add_outputs() = output;
+    }
+    *op_info.mutable_device() = GetDevice(node.device());
+    const Costs costs = estimator_.PredictCosts(op_context);
+
+    NodeCost& cost = node_costs_[node_index];
+    cost.compute_ns = costs.compute_time.count();
+    cost.memory_ns = costs.memory_time.count();
+    return cost;
+  }
+
+  const DeviceProperties& GetDevice(const string& device_name) {
+    auto it = devices_.find(device_name);
+    if (it == devices_.end()) {
+      DeviceProperties device = GetDeviceInfo(device_name);
+      // Nodes that are not placed yet are estimated as if they run on CPU.
+      if (device.type() != DEVICE_CPU && device.type() != DEVICE_GPU) {
+        device = GetLocalCPUInfo();
+      }
+      it = devices_.emplace(device_name, std::move(device)).first;
+    }
+    return it->second;
+  }
+
+  const utils::MutableGraphView& graph_view_;
+  const GraphProperties& graph_properties_;
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const std::unordered_set<string>& excluded_nodes_;
+  const OpLevelCostEstimator& estimator_;
+  absl::flat_hash_map<int, NodeCost> node_costs_;
+  absl::flat_hash_map<string, DeviceProperties> devices_;
+};
+
+NodeDef MakeFusedNode(const utils::MutableGraphView& graph_view,
+                      const FusionCandidate& candidate) {
+  const NodeDef& first = *graph_view.GetNode(candidate.nodes[0])->node();
+  const NodeDef& last = *graph_view.GetNode(candidate.nodes.back())->node();
+
+  NodeDef fused;
+  fused.set_name(last.name());
+  fused.set_op(candidate.pattern->fused_op);
+  fused.set_device(first.device());
+  *fused.mutable_input() = first.input();
+  *fused.mutable_attr() = first.attr();
+
+  std::vector<string> fused_ops;
+  int num_args = 0;
+  for (int i = 1; i < candidate.nodes.size(); ++i) {
+    const NodeDef& node = *graph_view.GetNode(candidate.nodes[i])->node();
+    fused_ops.push_back(node.op());
+    for (int j = 1; j < node.input_size(); ++j) {
+      fused.add_input(node.input(j));
+      ++num_args;
+    }
+  }
+  SetAttrValue(fused_ops, &(*fused.mutable_attr())["fused_ops"]);
+  SetAttrValue(num_args, &(*fused.mutable_attr())["num_args"]);
+  return fused;
+}
+
+}  // namespace
+
+void FusionPatternRegistry::RegisterPatternOrDie(const FusionPattern& pattern) {
+  CHECK(!pattern.name.empty()) << "Fusion patterns must have a name.";
+  CHECK_GE(pattern.ops.size(), 2)
+      << "Fusion pattern " << pattern.name << " must have at least two ops.";
+  for (const auto& ops : pattern.ops) {
+    CHECK(!ops.empty()) << "Fusion pattern " << pattern.name
+                        << " has a node without ops.";
+  }
+  CHECK(!pattern.fused_op.empty())
+      << "Fusion pattern " << pattern.name << " has no fused op.";
+  for (const FusionPattern& registered : *GetPatterns()) {
+    CHECK_NE(registered.name, pattern.name)
+        << "Fusion pattern " << pattern.name << " is already registered.";
+  }
+  GetPatterns()->push_back(pattern);
+}
+
+const std::vector<FusionPattern>&
+FusionPatternRegistry::GetRegisteredPatterns() {
+  return *GetPatterns();
+}
+
+FusionPatternBuilder::FusionPatternBuilder(absl::string_view name) {
+  pattern_.name = string(name);
+}
+
+FusionPatternBuilder& FusionPatternBuilder::Op(
+    std::initializer_list<absl::string_view> ops) {
+  pattern_.ops.emplace_back(ops.begin(), ops.end());
+  return *this;
+}
+
+FusionPatternBuilder& FusionPatternBuilder::Attr(absl::string_view name,
+                                                 absl::string_view value) {
+  CHECK(!pattern_.ops.empty())
+      << "Fusion pattern " << pattern_.name << " has an attribute before ops.";
+  pattern_.attrs.push_back({static_cast<int>(pattern_.ops.size()) - 1,
+                            string(name), string(value)});
+  return *this;
+}
+
+FusionPatternBuilder& FusionPatternBuilder::FusedOp(
+    absl::string_view fused_op) {
+  pattern_.fused_op = string(fused_op);
+  return *this;
+}
+
+FusionPatternBuilder& FusionPatternBuilder::Device(
+    absl::string_view device_type) {
+  pattern_.device_type = string(device_type);
+  return *this;
+}
+
+FusionPatternBuilder& FusionPatternBuilder::TypeConstraint(
+    std::initializer_list<DataType> types) {
+  pattern_.types.assign(types.begin(), types.end());
+  return *this;
+}
+
+std::vector<FusionCandidate> FindFusionCandidates(
+    const std::vector<FusionPattern>& patterns,
+    const utils::MutableGraphView& graph_view,
+    const GraphProperties& graph_properties,
+    const std::unordered_set<string>& nodes_to_preserve,
+    const std::unordered_set<string>& excluded_nodes,
+    const OpLevelCostEstimator& estimator) {
+  FusionMatcher matcher(graph_view, graph_properties, nodes_to_preserve,
+                        excluded_nodes, estimator);
+  std::vector<FusionCandidate> candidates;
+  for (int i = 0; i < graph_view.NumNodes(); ++i) {
+    for (const FusionPattern& pattern : patterns) {
+      matcher.FindMatches(pattern, i, &candidates);
+    }
+  }
+  return candidates;
+}
+
+std::vector<FusionCandidate> SelectFusionCandidates(
+    std::vector<FusionCandidate> candidates) {
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const FusionCandidate& a, const FusionCandidate& b) {
+                     return a.benefit > b.benefit;
+                   });
+  std::vector<FusionCandidate> selected;
+  absl::flat_hash_set<int> fused_nodes;
+  for (FusionCandidate& candidate : candidates) {
+    if (candidate.benefit <= 0) break;
+    if (absl::c_any_of(candidate.nodes,
+                       [&](int node) { return fused_nodes.contains(node); })) {
+      continue;
+    }
+    fused_nodes.insert(candidate.nodes.begin(), candidate.nodes.end());
+    selected.push_back(std::move(candidate));
+  }
+  return selected;
+}
+
+Status FuseWithCostModel(const std::vector<FusionPattern>& patterns,
+                         const std::unordered_set<string>& nodes_to_preserve,
+                         utils::MutableGraphView* graph_view,
+                         GraphProperties* graph_properties,
+                         std::unordered_set<string>* fused_nodes) {
+  const OpLevelCostEstimator estimator;
+  // Fusing a chain can make another one profitable, e.g. when the nodes kept
+  // for the first one are left with a single use, so search again until there
+  // is nothing left to fuse. Fused nodes are never fused again, so this
+  // terminates.
+  while (true) {
+    const std::vector<FusionCandidate> fusions = SelectFusionCandidates(
+        FindFusionCandidates(patterns, *graph_view, *graph_properties,
+                             nodes_to_preserve, *fused_nodes, estimator));
+    if (fusions.empty()) return Status::OK();
+
+    absl::flat_hash_set<string> changed_nodes;
+    std::vector<string> nodes_to_delete;
+    std::vector<NodeDef> fused_defs;
+    for (const FusionCandidate& fusion : fusions) {
+      VLOG(2) << "Fuse " << fusion.nodes.size() << " nodes into "
+              << fusion.pattern->fused_op << " "
+              << graph_view->GetNode(fusion.nodes.back())->GetName()
+              << " (pattern " << fusion.pattern->name
+              << ", estimated benefit = " << fusion.benefit << "ns)";
+      fused_defs.push_back(MakeFusedNode(*graph_view, fusion));
+      for (int i = fusion.num_kept; i + 1 < fusion.nodes.size(); ++i) {
+        nodes_to_delete.push_back(
+            graph_view->GetNode(fusion.nodes[i])->GetName());
+      }
+    }
+
+    utils::Mutation* mutation = graph_view->GetMutationBuilder();
+    for (NodeDef& fused : fused_defs) {
+      changed_nodes.insert(fused.name());
+      fused_nodes->insert(fused.name());
+      Status status;
+      mutation->AddNode(std::move(fused), &status);
+      TF_RETURN_IF_ERROR(status);
+    }
+    TF_RETURN_IF_ERROR(mutation->Apply());
+
+    mutation = graph_view->GetMutationBuilder();
+    for (const string& name : nodes_to_delete) {
+      changed_nodes.insert(name);
+      mutation->RemoveNode(graph_view->GetNode(name));
+    }
+    TF_RETURN_IF_ERROR(mutation->Apply());
+
+    TF_RETURN_IF_ERROR(graph_properties->UpdateStatically(changed_nodes));
+  }
+}
+
+// Contractions followed by a bias and an activation, in the forms that the
+// CPU kernels of _FusedConv2D and _FusedMatMul support. Unlike the remapper's
+// own patterns, these are also fused where the output of the contraction or of
+// the BiasAdd has other uses, if the cost model estimates that computing it
+// again is cheaper than storing it.
+//
+// LeakyRelu is left to the remapper, which forwards its alpha to the fused
+// node. FusedBatchNorm is left to it too, since the fused node needs its
+// epsilon and must only fuse it in inference mode. Conv2D + BiasAdd alone is
+// not registered either, because fusing it here would keep the remapper from
+// fusing the longer chains it knows of, such as Conv2D + BiasAdd + LeakyRelu,
+// and neither is MatMul + BiasAdd with oneDNN, which fuses MatMul + BiasAdd +
+// Add and Tanh.
+REGISTER_REMAPPER_FUSION_PATTERN("Conv2DBiasAddActivation")
+    .Op("Conv2D")
+    .Attr("data_format", "NHWC")
+    .Op("BiasAdd")
+    .Attr("data_format", "NHWC")
+    .Op({"Relu", "Relu6", "Elu"})
+    .FusedOp("_FusedConv2D")
+    .Device("CPU")
+    .TypeConstraint({DT_FLOAT});
+
+REGISTER_REMAPPER_FUSION_PATTERN("MatMulBiasAddActivation")
+    .Op("MatMul")
+    .Op("BiasAdd")
+    .Attr("data_format", "NHWC")
+    .Op({"Relu", "Relu6", "Elu"})
+    .FusedOp("_FusedMatMul")
+    .Device("CPU")
+    .TypeConstraint({DT_FLOAT});
+
+#ifndef INTEL_MKL
+REGISTER_REMAPPER_FUSION_PATTERN("MatMulBiasAdd")
+    .Op("MatMul")
+    .Op("BiasAdd")
+    .Attr("data_format", "NHWC")
+    .FusedOp("_FusedMatMul")
+    .Device("CPU")
+    .TypeConstraint({DT_FLOAT});
+#endif  // !INTEL_MKL
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,171 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_FUSION_H_
+
+#include <initializer_list>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/utils/graph_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A chain of nodes that the remapper can replace with a single fused node:
+//
+//   ops[0] -> ops[1] -> ... -> ops[n - 1]
+//
+// where the output 0 of every node is the input 0 of the next one. The fused
+// op follows the convention of _FusedConv2D and _FusedMatMul: its inputs are
+// the regular inputs of the first node, followed by the other regular inputs
+// of the next nodes (the "args"), and its attributes are the attributes of the
+// first node, plus `fused_ops` (the ops of the next nodes) and `num_args`.
+struct FusionPattern {
+  string name;
+  // The ops that each node of the chain may have.
+  std::vector<std::vector<string>> ops;
+  string fused_op;
+  // If not empty, fuse only nodes placed on devices of this type, "CPU" or
+  // "GPU".
+  string device_type;
+  // If not empty, fuse only nodes whose "T" attribute is one of these types.
+  std::vector<DataType> types;
+
+  // Requires the node at `position` of the chain to have the string attribute
+  // `name` set to `value`.
+  struct AttrConstraint {
+    int position;
+    string name;
+    string value;
+  };
+  std::vector<AttrConstraint> attrs;
+};
+
+class FusionPatternRegistry {
+ public:
+  // Registers a pattern. This is meant to be called during program
+  // initialization, through REGISTER_REMAPPER_FUSION_PATTERN, and is not
+  // thread-safe.
+  static void RegisterPatternOrDie(const FusionPattern& pattern);
+
+  static const std::vector<FusionPattern>& GetRegisteredPatterns();
+};
+
+// Builds a FusionPattern declaratively, e.g.
+//
+//   REGISTER_REMAPPER_FUSION_PATTERN("Conv2DBiasAddRelu")
+//       .Op("Conv2D")
+//       .Attr("data_format", "NHWC")
+//       .Op("BiasAdd")
+//       .Op("Relu")
+//       .FusedOp("_FusedConv2D")
+//       .Device("CPU")
+//       .TypeConstraint({DT_FLOAT});
+class FusionPatternBuilder {
+ public:
+  explicit FusionPatternBuilder(absl::string_view name);
+
+  // Appends a node with one of the given ops to the chain.
+  FusionPatternBuilder& Op(std::initializer_list<absl::string_view> ops);
+  FusionPatternBuilder& Op(absl::string_view op) { return Op({op}); }
+  // Requires the last appended node to have the string attribute `name` set
+  // to `value`.
+  FusionPatternBuilder& Attr(absl::string_view name, absl::string_view value);
+
+  FusionPatternBuilder& FusedOp(absl::string_view fused_op);
+  FusionPatternBuilder& Device(absl::string_view device_type);
+  FusionPatternBuilder& TypeConstraint(std::initializer_list<DataType> types);
+
+  const FusionPattern& pattern() const { return pattern_; }
+
+ private:
+  FusionPattern pattern_;
+};
+
+namespace fusion_pattern_registration {
+
+class FusionPatternBuilderReceiver {
+ public:
+  // Registers the pattern built by `builder`.
+  FusionPatternBuilderReceiver(  // NOLINT(runtime/explicit)
+      const FusionPatternBuilder& builder) {
+    FusionPatternRegistry::RegisterPatternOrDie(builder.pattern());
+  }
+};
+
+}  // namespace fusion_pattern_registration
+
+#define REGISTER_REMAPPER_FUSION_PATTERN(name) \
+  REGISTER_REMAPPER_FUSION_PATTERN_UNIQ_HELPER(__COUNTER__, name)
+#define REGISTER_REMAPPER_FUSION_PATTERN_UNIQ_HELPER(ctr, name) \
+  REGISTER_REMAPPER_FUSION_PATTERN_UNIQ(ctr, name)
+#define REGISTER_REMAPPER_FUSION_PATTERN_UNIQ(ctr, name)             \
+  static ::tensorflow::grappler::fusion_pattern_registration::       \
+      FusionPatternBuilderReceiver register_fusion_pattern##ctr      \
+      TF_ATTRIBUTE_UNUSED = ::tensorflow::grappler::FusionPatternBuilder(name)
+
+// A match of a FusionPattern in a graph.
+struct FusionCandidate {
+  const FusionPattern* pattern = nullptr;
+  // The indices of the nodes of the chain, first to last.
+  std::vector<int> nodes;
+  // The number of nodes at the start of the chain that must be kept after the
+  // fusion, because their outputs have other uses. The fused node computes
+  // them again.
+  int num_kept = 0;
+  // The estimated time saved by the fusion, in nanoseconds. Negative if the
+  // fusion makes the graph slower.
+  double benefit = 0;
+};
+
+// Finds all the matches of `patterns` in `graph_view`, including the ones that
+// overlap, and estimates their benefit with `estimator`. Nodes in
+// `nodes_to_preserve` are only fused if their name and outputs are preserved,
+// and nodes in `excluded_nodes` are never fused.
+std::vector<FusionCandidate> FindFusionCandidates(
+    const std::vector<FusionPattern>& patterns,
+    const utils::MutableGraphView& graph_view,
+    const GraphProperties& graph_properties,
+    const std::unordered_set<string>& nodes_to_preserve,
+    const std::unordered_set<string>& excluded_nodes,
+    const OpLevelCostEstimator& estimator);
+
+// Returns the candidates with a positive benefit that don't share any node,
+// picking the candidates with the largest benefit first.
+std::vector<FusionCandidate> SelectFusionCandidates(
+    std::vector<FusionCandidate> candidates);
+
+// Fuses the matches of `patterns` in the graph of `graph_view` that are
+// estimated to make it faster, and updates `graph_properties` accordingly.
+// The names of the fused nodes are added to `fused_nodes`.
+Status FuseWithCostModel(const std::vector<FusionPattern>& patterns,
+                         const std::unordered_set<string>& nodes_to_preserve,
+                         utils::MutableGraphView* graph_view,
+                         GraphProperties* graph_properties,
+                         std::unordered_set<string>* fused_nodes);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_FUSION_H_
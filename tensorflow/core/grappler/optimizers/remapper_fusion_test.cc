@@ -0,0 +1,312 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/remapper_fusion.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/remapper.h"
+#include "tensorflow/core/grappler/utils/graph_view.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// The fused ops only need to be known to shape inference, the graphs that use
+// them are not run.
+REGISTER_OP("_TestFusedAdd")
+    .Input("x: T")
+    .Input("y: T")
+    .Input("args: num_args * T")
+    .Output("z: T")
+    .Attr("T: {float}")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(shape_inference::UnchangedShape);
+
+REGISTER_OP("_TestFusedAddRelu")
+    .Input("x: T")
+    .Input("y: T")
+    .Input("args: num_args * T")
+    .Output("z: T")
+    .Attr("T: {float}")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(shape_inference::UnchangedShape);
+
+REGISTER_REMAPPER_FUSION_PATTERN("TestAddRelu")
+    .Op({"Add", "AddV2"})
+    .Op("Relu")
+    .FusedOp("_TestFusedAdd")
+    .TypeConstraint({DT_FLOAT});
+
+REGISTER_REMAPPER_FUSION_PATTERN("TestAddReluTanh")
+    .Op({"Add", "AddV2"})
+    .Op("Relu")
+    .Op("Tanh")
+    .FusedOp("_TestFusedAddRelu")
+    .TypeConstraint({DT_FLOAT});
+
+class RemapperFusionTest : public GrapplerTest {};
+
+TEST_F(RemapperFusionTest, FuseAddRelu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({1000, 1000}));
+  auto y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                            ops::Placeholder::Shape({1000, 1000}));
+  auto add = ops::Add(s.WithOpName("add"), x, y);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), relu);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "add");
+    if (node.name() == "relu") {
+      EXPECT_EQ(node.op(), "_TestFusedAdd");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "y");
+      EXPECT_EQ(node.attr().at("num_args").i(), 0);
+      const auto& fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 1);
+      EXPECT_EQ(fused_ops[0], "Relu");
+      ++found;
+    }
+  }
+  EXPECT_EQ(found, 1);
+}
+
+TEST_F(RemapperFusionTest, PreferLongerOverlappingPattern) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({1000, 1000}));
+  auto y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                            ops::Placeholder::Shape({1000, 1000}));
+  auto add = ops::AddV2(s.WithOpName("add"), x, y);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), relu);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), tanh);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "add");
+    EXPECT_NE(node.name(), "relu");
+    if (node.name() == "tanh") {
+      EXPECT_EQ(node.op(), "_TestFusedAddRelu");
+      const auto& fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "Relu");
+      EXPECT_EQ(fused_ops[1], "Tanh");
+      ++found;
+    }
+  }
+  EXPECT_EQ(found, 1);
+}
+
+TEST_F(RemapperFusionTest, DoNotDuplicateSharedAdd) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({1000, 1000}));
+  auto y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                            ops::Placeholder::Shape({1000, 1000}));
+  auto add = ops::Add(s.WithOpName("add"), x, y);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+  auto neg = ops::Neg(s.WithOpName("neg"), add);
+  auto fetch1 = ops::Identity(s.WithOpName("fetch1"), relu);
+  auto fetch2 = ops::Identity(s.WithOpName("fetch2"), neg);
+
+  GrapplerItem item;
+  item.fetch = {"fetch1", "fetch2"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Fusing Add into Relu would compute the Add twice, and read its inputs
+  // twice, for the benefit of not reading its output once.
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ASSERT_EQ(output.node_size(), item.graph.node_size());
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "add") EXPECT_EQ(node.op(), "Add");
+    if (node.name() == "relu") EXPECT_EQ(node.op(), "Relu");
+  }
+}
+
+// Returns the candidates of the registered pattern `pattern_name` in the graph
+// of `item`.
+std::vector<FusionCandidate> FindRegisteredPatternCandidates(
+    const string& pattern_name, GrapplerItem* item) {
+  std::vector<FusionPattern> patterns;
+  for (const FusionPattern& pattern :
+       FusionPatternRegistry::GetRegisteredPatterns()) {
+    if (pattern.name == pattern_name) patterns.push_back(pattern);
+  }
+  EXPECT_EQ(patterns.size(), 1);
+
+  GraphProperties graph_properties(*item);
+  TF_CHECK_OK(graph_properties.InferStatically(
+      /*assume_valid_feeds=*/false));
+  Status status;
+  utils::MutableGraphView graph_view(&item->graph, &status);
+  TF_CHECK_OK(status);
+  const OpLevelCostEstimator estimator;
+  return FindFusionCandidates(patterns, graph_view, graph_properties,
+                              /*nodes_to_preserve=*/{},
+                              /*excluded_nodes=*/{}, estimator);
+}
+
+TEST_F(RemapperFusionTest, Conv2DBiasAddActivationConstraints) {
+  for (const string data_format : {"NHWC", "NCHW"}) {
+    for (const string device : {"/device:CPU:0", "/device:GPU:0"}) {
+      tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+      auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                    ops::Placeholder::Shape({8, 32, 32, 32}));
+      auto filter = ops::Placeholder(s.WithOpName("filter"), DT_FLOAT,
+                                     ops::Placeholder::Shape({1, 1, 32, 32}));
+      auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                                   ops::Placeholder::Shape({32}));
+      auto conv = ops::Conv2D(s.WithOpName("conv"), input, filter,
+                              {1, 1, 1, 1}, "SAME",
+                              ops::Conv2D::DataFormat(data_format));
+      auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias,
+                                   ops::BiasAdd::DataFormat(data_format));
+      auto relu = ops::Relu6(s.WithOpName("relu6"), bias_add);
+      auto fetch = ops::Identity(s.WithOpName("fetch"), relu);
+
+      GrapplerItem item;
+      item.fetch = {"fetch"};
+      TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+      for (int i = 0; i < item.graph.node_size(); ++i) {
+        item.graph.mutable_node(i)->set_device(device);
+      }
+
+      const std::vector<FusionCandidate> candidates =
+          FindRegisteredPatternCandidates("Conv2DBiasAddActivation", &item);
+      // The CPU kernel of _FusedConv2D only supports NHWC.
+      if (data_format == "NHWC" && device == "/device:CPU:0") {
+        ASSERT_EQ(candidates.size(), 1);
+        EXPECT_EQ(candidates[0].nodes.size(), 3);
+        EXPECT_EQ(candidates[0].num_kept, 0);
+        EXPECT_GT(candidates[0].benefit, 0);
+      } else {
+        EXPECT_TRUE(candidates.empty()) << data_format << " on " << device;
+      }
+    }
+  }
+}
+
+TEST_F(RemapperFusionTest, FuseMatMulBiasAddRelu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto lhs = ops::Placeholder(s.WithOpName("lhs"), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 32}));
+  auto rhs = ops::Placeholder(s.WithOpName("rhs"), DT_FLOAT,
+                              ops::Placeholder::Shape({32, 64}));
+  auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                               ops::Placeholder::Shape({64}));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), relu);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  // Both MatMul + BiasAdd and MatMul + BiasAdd + Relu match, and the longer
+  // chain saves more.
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "matmul");
+    EXPECT_NE(node.name(), "bias_add");
+    if (node.name() == "relu") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(2), "bias");
+      const auto& fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Relu");
+      ++found;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperFusionTest, SelectDisjointCandidates) {
+  FusionPattern pattern;
+  std::vector<FusionCandidate> candidates(3);
+  candidates[0].pattern = &pattern;
+  candidates[0].nodes = {0, 1};
+  candidates[0].benefit = 10;
+  candidates[1].pattern = &pattern;
+  candidates[1].nodes = {0, 1, 2};
+  candidates[1].benefit = 20;
+  candidates[2].pattern = &pattern;
+  candidates[2].nodes = {3, 4};
+  candidates[2].benefit = -5;
+
+  const std::vector<FusionCandidate> selected =
+      SelectFusionCandidates(candidates);
+  ASSERT_EQ(selected.size(), 1);
+  EXPECT_EQ(selected[0].nodes, std::vector<int>({0, 1, 2}));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -163,6 +163,12 @@ class BasicBatchScheduler : public BatchScheduler<TaskType> {
     // avoid latency spikes.
     int64 batch_timeout_micros = 0;
 
+    // If positive, the batch timeout and the batch size at which a batch is
+    // scheduled early are tuned to keep batches within this latency, with
+    // 'batch_timeout_micros' and 'max_batch_size' as upper bounds. See
+    // SharedBatchScheduler::QueueOptions::latency_target_micros.
+    int64 latency_target_micros = 0;
+
     // The name to use for the pool of batch threads.
     string thread_pool_name = {"batch_threads"};
 
@@ -286,6 +292,8 @@ Status BasicBatchScheduler<TaskType>::Create(
       options.max_batch_size;
   shared_scheduler_queue_options.batch_timeout_micros =
       options.batch_timeout_micros;
+  shared_scheduler_queue_options.latency_target_micros =
+      options.latency_target_micros;
   shared_scheduler_queue_options.max_enqueued_batches =
       options.max_enqueued_batches;
   shared_scheduler_queue_options.enable_large_batch_splitting =
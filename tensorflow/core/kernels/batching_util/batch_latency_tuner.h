@@ -0,0 +1,224 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_TUNER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_TUNER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Tunes the batch timeout of a batching queue, and the batch size at which it
+// stops waiting for more tasks, so that tasks complete within a latency target.
+//
+// The time to process a batch of b tasks is modeled as a + c * b, fitted to
+// recently processed batches, and the time for b tasks to arrive as
+// (b - 1) / r for the recent arrival rate r. The tuner picks the largest batch
+// size whose arrival and processing time fit in the latency budget, since
+// larger batches amortize the per-batch cost best, and lets the oldest task of
+// a batch wait for whatever remains of the budget.
+//
+// The budget is a fraction of the target. It shrinks whenever the observed
+// latency quantile exceeds the target and grows back slowly while it does not,
+// which absorbs delays the model does not capture, such as waiting for a batch
+// thread.
+//
+// Not thread-safe.
+class BatchLatencyTuner {
+ public:
+  struct Options {
+    // The latency, from enqueueing a task to the end of the processing of its
+    // batch, to stay below.
+    int64 latency_target_micros = 0;
+
+    // The quantile of task latencies that is held below the target.
+    double latency_quantile = 0.99;
+
+    // Upper bounds for the tuned values.
+    int64 max_batch_timeout_micros = std::numeric_limits<int64>::max();
+    int max_batch_size = 1000;
+
+    // The number of processed batches between two tuning rounds.
+    int batches_per_update = 16;
+  };
+
+  explicit BatchLatencyTuner(const Options& options)
+      : options_(options),
+        // Until batches have been processed, split the target evenly between
+        // waiting and processing.
+        batch_timeout_micros_(std::min(options.latency_target_micros / 2,
+                                       options.max_batch_timeout_micros)),
+        batch_size_limit_(options.max_batch_size) {
+    DCHECK_GT(options_.latency_target_micros, 0);
+    DCHECK_GT(options_.max_batch_size, 0);
+    latencies_micros_.reserve(kMaxLatencySamples);
+  }
+
+  // Records that a task of `size` units was enqueued at `now_micros`.
+  void RecordArrival(uint64 now_micros, int size) {
+    if (window_size_ == 0) {
+      window_start_micros_ = now_micros;
+    }
+    window_end_micros_ = now_micros;
+    window_size_ += size;
+  }
+
+  // Records that a batch of `batch_size` units took `processing_micros` to
+  // process, and completed `latency_micros` after its first task arrived.
+  void RecordBatch(int batch_size, int64 processing_micros,
+                   int64 latency_micros) {
+    // Exponentially weighted least squares for the processing cost model.
+    sum_weight_ = kCostDecay * sum_weight_ + 1;
+    sum_size_ = kCostDecay * sum_size_ + batch_size;
+    sum_size_squared_ = kCostDecay * sum_size_squared_ +
+                        static_cast<double>(batch_size) * batch_size;
+    sum_time_ = kCostDecay * sum_time_ + processing_micros;
+    sum_size_time_ = kCostDecay * sum_size_time_ +
+                     static_cast<double>(batch_size) * processing_micros;
+
+    if (latencies_micros_.size() < kMaxLatencySamples) {
+      latencies_micros_.push_back(latency_micros);
+    } else {
+      latencies_micros_[next_latency_sample_] = latency_micros;
+    }
+    next_latency_sample_ = (next_latency_sample_ + 1) % kMaxLatencySamples;
+
+    if (++batches_since_update_ >= options_.batches_per_update) {
+      batches_since_update_ = 0;
+      Update();
+    }
+  }
+
+  // The time the oldest task of the open batch may wait for more tasks.
+  int64 batch_timeout_micros() const { return batch_timeout_micros_; }
+
+  // The batch size at which the open batch is scheduled without waiting for
+  // the timeout.
+  int batch_size_limit() const { return batch_size_limit_; }
+
+  // The fraction of the latency target currently budgeted for a batch.
+  double headroom() const { return headroom_; }
+
+ private:
+  static constexpr size_t kMaxLatencySamples = 256;
+  static constexpr double kCostDecay = 0.95;
+  static constexpr double kArrivalRateDecay = 0.7;
+
+  void Update() {
+    // Adjust the budget to the observed latencies.
+    std::vector<int64> latencies = latencies_micros_;
+    const size_t index = std::min<size_t>(
+        latencies.size() - 1,
+        static_cast<size_t>(options_.latency_quantile * latencies.size()));
+    std::nth_element(latencies.begin(), latencies.begin() + index,
+                     latencies.end());
+    const int64 quantile_latency_micros = latencies[index];
+    if (quantile_latency_micros > options_.latency_target_micros) {
+      headroom_ = std::max(0.1, headroom_ * 0.8);
+    } else if (quantile_latency_micros < 0.8 * options_.latency_target_micros) {
+      headroom_ = std::min(1.0, headroom_ + 0.02);
+    }
+
+    // Refresh the arrival rate, in units per microsecond.
+    if (window_size_ > 0 && window_end_micros_ > window_start_micros_) {
+      const double rate = static_cast<double>(window_size_) /
+                          (window_end_micros_ - window_start_micros_);
+      arrival_rate_ = arrival_rate_ == 0
+                          ? rate
+                          : kArrivalRateDecay * arrival_rate_ +
+                                (1 - kArrivalRateDecay) * rate;
+    }
+    window_size_ = 0;
+
+    // Fit the processing cost a + c * b.  If every batch had the same size,
+    // assume the cost is proportional to the size, which errs toward smaller
+    // batches.
+    double per_batch_micros = 0;
+    double per_unit_micros = 0;
+    const double denominator =
+        sum_weight_ * sum_size_squared_ - sum_size_ * sum_size_;
+    if (denominator > 1e-6 * sum_weight_ * sum_size_squared_) {
+      per_unit_micros =
+          (sum_weight_ * sum_size_time_ - sum_size_ * sum_time_) / denominator;
+      per_batch_micros =
+          (sum_time_ - per_unit_micros * sum_size_) / sum_weight_;
+    }
+    if (per_unit_micros <= 0 || per_batch_micros < 0) {
+      per_batch_micros = 0;
+      per_unit_micros = sum_size_ > 0 ? sum_time_ / sum_size_ : 0;
+    }
+
+    // The largest b with (b - 1) / r + a + c * b <= budget.
+    const double budget_micros = headroom_ * options_.latency_target_micros;
+    double batch_size = 1;
+    if (arrival_rate_ > 0) {
+      const double inter_arrival_micros = 1 / arrival_rate_;
+      batch_size = (budget_micros - per_batch_micros + inter_arrival_micros) /
+                   (inter_arrival_micros + per_unit_micros);
+    }
+    batch_size_limit_ = static_cast<int>(
+        std::max(1.0, std::min<double>(options_.max_batch_size,
+                                       std::floor(batch_size))));
+
+    const double processing_micros =
+        per_batch_micros + per_unit_micros * batch_size_limit_;
+    batch_timeout_micros_ = std::min<int64>(
+        options_.max_batch_timeout_micros,
+        static_cast<int64>(std::max(0.0, budget_micros - processing_micros)));
+
+    VLOG(2) << "Batch latency tuner: p" << options_.latency_quantile * 100
+            << " latency " << quantile_latency_micros << "us, headroom "
+            << headroom_ << ", arrival rate " << arrival_rate_ * 1e6
+            << "/s, cost " << per_batch_micros << "us + " << per_unit_micros
+            << "us/unit -> batch size " << batch_size_limit_ << ", timeout "
+            << batch_timeout_micros_ << "us";
+  }
+
+  const Options options_;
+
+  int64 batch_timeout_micros_;
+  int batch_size_limit_;
+  double headroom_ = 0.8;
+
+  // Arrivals since the last tuning round.
+  uint64 window_start_micros_ = 0;
+  uint64 window_end_micros_ = 0;
+  int64 window_size_ = 0;
+  double arrival_rate_ = 0;
+
+  // Decayed sums of 1, b, b^2, t and b * t over processed batches.
+  double sum_weight_ = 0;
+  double sum_size_ = 0;
+  double sum_size_squared_ = 0;
+  double sum_time_ = 0;
+  double sum_size_time_ = 0;
+
+  // A ring buffer of recent batch latencies.
+  std::vector<int64> latencies_micros_;
+  size_t next_latency_sample_ = 0;
+  int batches_since_update_ = 0;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_TUNER_H_
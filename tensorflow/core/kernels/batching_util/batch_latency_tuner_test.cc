@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_tuner.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+BatchLatencyTuner::Options TunerOptions() {
+  BatchLatencyTuner::Options options;
+  options.latency_target_micros = 2000;
+  options.max_batch_size = 1000;
+  options.batches_per_update = 16;
+  return options;
+}
+
+// Simulates one tuning round: unit-size tasks arriving every
+// `inter_arrival_micros`, and batches of alternating sizes costing
+// 100us + 1us per task that complete `latency_micros` after they start.
+void RunRound(BatchLatencyTuner* tuner, uint64* now_micros,
+              int64 inter_arrival_micros, int64 latency_micros) {
+  for (int i = 0; i < 16; ++i) {
+    const int batch_size = i % 2 == 0 ? 10 : 50;
+    for (int j = 0; j < batch_size; ++j) {
+      tuner->RecordArrival(*now_micros, 1);
+      *now_micros += inter_arrival_micros;
+    }
+    tuner->RecordBatch(batch_size, 100 + batch_size, latency_micros);
+  }
+}
+
+TEST(BatchLatencyTunerTest, InitialValues) {
+  BatchLatencyTuner::Options options = TunerOptions();
+  BatchLatencyTuner tuner(options);
+  EXPECT_EQ(tuner.batch_timeout_micros(), 1000);
+  EXPECT_EQ(tuner.batch_size_limit(), 1000);
+
+  options.max_batch_timeout_micros = 300;
+  BatchLatencyTuner bounded_tuner(options);
+  EXPECT_EQ(bounded_tuner.batch_timeout_micros(), 300);
+}
+
+TEST(BatchLatencyTunerTest, HeavyLoadFormsLargeBatches) {
+  BatchLatencyTuner tuner(TunerOptions());
+  uint64 now_micros = 0;
+  RunRound(&tuner, &now_micros, 10, 1700);
+
+  // The budget is 0.8 * 2000us: (b - 1) * 10us + 100us + b * 1us <= 1600us.
+  EXPECT_EQ(tuner.batch_size_limit(), 137);
+  EXPECT_NEAR(tuner.batch_timeout_micros(), 1600 - 100 - 137, 1);
+}
+
+TEST(BatchLatencyTunerTest, LightLoadFormsSmallBatches) {
+  BatchLatencyTuner tuner(TunerOptions());
+  uint64 now_micros = 0;
+  RunRound(&tuner, &now_micros, 10000, 1700);
+
+  EXPECT_EQ(tuner.batch_size_limit(), 1);
+  EXPECT_NEAR(tuner.batch_timeout_micros(), 1600 - 100 - 1, 1);
+}
+
+TEST(BatchLatencyTunerTest, MissedTargetShrinksBudget) {
+  BatchLatencyTuner tuner(TunerOptions());
+  uint64 now_micros = 0;
+  RunRound(&tuner, &now_micros, 10, 1700);
+  const int batch_size_limit = tuner.batch_size_limit();
+  const int64 batch_timeout_micros = tuner.batch_timeout_micros();
+
+  // Every latency sample must be replaced for the quantile to move.
+  for (int i = 0; i < 16; ++i) {
+    RunRound(&tuner, &now_micros, 10, 3000);
+  }
+  EXPECT_LT(tuner.headroom(), 0.8);
+  EXPECT_LT(tuner.batch_size_limit(), batch_size_limit);
+  EXPECT_LT(tuner.batch_timeout_micros(), batch_timeout_micros);
+  EXPECT_GE(tuner.batch_size_limit(), 1);
+  EXPECT_GE(tuner.batch_timeout_micros(), 0);
+}
+
+TEST(BatchLatencyTunerTest, MetTargetGrowsBudget) {
+  BatchLatencyTuner tuner(TunerOptions());
+  uint64 now_micros = 0;
+  for (int i = 0; i < 20; ++i) {
+    RunRound(&tuner, &now_micros, 10, 500);
+  }
+  EXPECT_DOUBLE_EQ(tuner.headroom(), 1.0);
+  EXPECT_NEAR(tuner.batch_timeout_micros(),
+              2000 - 100 - tuner.batch_size_limit(), 1);
+}
+
+TEST(BatchLatencyTunerTest, RespectsUpperBounds) {
+  BatchLatencyTuner::Options options = TunerOptions();
+  options.max_batch_size = 20;
+  options.max_batch_timeout_micros = 50;
+  BatchLatencyTuner tuner(options);
+  uint64 now_micros = 0;
+  RunRound(&tuner, &now_micros, 1, 1700);
+
+  EXPECT_EQ(tuner.batch_size_limit(), 20);
+  EXPECT_EQ(tuner.batch_timeout_micros(), 50);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
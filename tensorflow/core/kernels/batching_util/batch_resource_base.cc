@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/ops_util.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
@@ -85,6 +86,43 @@ using ::tensorflow::concat_split_util::Concat;
 using ::tensorflow::concat_split_util::Split;
 using TensorMatrix = std::vector<std::vector<Tensor>>;
 
+namespace internal {
+
+Status SplitBatchedTensor(const Tensor& input, absl::Span<const int64> sizes,
+                          std::vector<Tensor>* outputs) {
+  std::vector<Tensor> slices;
+  slices.reserve(sizes.size());
+  int64 position = 0;
+  for (const int64 size : sizes) {
+    slices.push_back(input.Slice(position, position + size));
+    if (!slices.back().IsAligned()) {
+      return tensor::Split(input, sizes, outputs);
+    }
+    position += size;
+  }
+  *outputs = std::move(slices);
+  return Status::OK();
+}
+
+Status ConcatBatchedTensors(OpKernelContext* context,
+                            absl::Span<const Tensor> inputs, Tensor* output) {
+  if (inputs.size() == 1) {
+    *output = inputs[0];
+    return Status::OK();
+  }
+  return Concat(context, inputs, output);
+}
+
+void RecordBatchWaitTime(uint64 batch_wait_ns, const string& model_name) {
+  RecordBatchDelayMs(batch_wait_ns * 1e-6, model_name);
+  // The signature of the step is not known to the batching ops.
+  metrics::RecordServingStepTime(model_name, /*signature_name=*/"",
+                                 metrics::ServingPhase::kBatchWait,
+                                 batch_wait_ns / 1000);
+}
+
+}  // namespace internal
+
 Status BatchResourceBase::RegisterInput(
     int64 guid, OpKernelContext* context, const string& batcher_queue_name,
     AsyncOpKernel::DoneCallback done_callback) {
@@ -240,8 +278,8 @@ Status BatchResourceBase::ConcatInputTensors(
     }
 
     Tensor concatenated_tensor;
-    Status concat_status =
-        Concat(context, to_concatenate, &concatenated_tensor);
+    Status concat_status = internal::ConcatBatchedTensors(
+        context, to_concatenate, &concatenated_tensor);
     TF_RETURN_IF_ERROR(concat_status);
     concatenated_tensors->push_back(concatenated_tensor);
   }
@@ -401,8 +439,10 @@ Status BatchResourceBase::SplitOutputTensors(
           "the 0th dimension sizes of the input tensors");
     }
 
+    // The per-task outputs alias the batched output, which stays alive until
+    // the last of them is released.
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
+    const Status split_status = internal::SplitBatchedTensor(
         output_tensor, task_sizes_plus_optional_padding, &split_tensor);
     DCHECK(split_status.ok()) << split_status.ToString();
     if (!split_status.ok()) {
@@ -490,8 +530,8 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   uint64 current_time = EnvTime::NowNanos();
   const string& model_name = GetModelName(last_task_context);
   for (int i = 0; i < batch->num_tasks(); ++i) {
-    RecordBatchDelayMs((current_time - batch->task(i).start_time) * 1e-6,
-                       model_name);
+    internal::RecordBatchWaitTime(current_time - batch->task(i).start_time,
+                                  model_name);
   }
   // Releases the cleanup method here, because the callback of the function
   // library runtime will handle it now.
@@ -532,6 +572,13 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   OP_REQUIRES_OK_ASYNC(last_task_context, ValidateBatch(*batch),
                        last_task_callback);
 
+  const uint64 current_time = EnvTime::NowNanos();
+  const string& model_name = GetModelName(last_task_context);
+  for (int i = 0; i < batch->num_tasks(); ++i) {
+    internal::RecordBatchWaitTime(current_time - batch->task(i).start_time,
+                                  model_name);
+  }
+
   // All tasks should have the same number of input edges.
   const int num_input_edges = batch->task(0).inputs.size();
   std::vector<Tensor> concatenated_tensors;
@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_RESOURCE_BASE_H_
 
 #include <map>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -31,6 +33,25 @@ limitations under the License.
 
 namespace tensorflow {
 namespace serving {
+namespace internal {
+
+// Splits 'input' along the 0th dimension into tensors with 0th-dimension sizes
+// 'sizes'. The results are slices aliasing 'input' when they all satisfy the
+// alignment that kernels expect of their inputs, and copies otherwise.
+Status SplitBatchedTensor(const Tensor& input, absl::Span<const int64> sizes,
+                          std::vector<Tensor>* outputs);
+
+// Concatenates 'inputs' along the 0th dimension into 'output', which is
+// allocated using 'context'. A single input, such as a full-sized split of a
+// large input, is passed through without copying.
+Status ConcatBatchedTensors(OpKernelContext* context,
+                            absl::Span<const Tensor> inputs, Tensor* output);
+
+// Records that a task of a batch for 'model_name' waited 'batch_wait_ns'
+// nanoseconds in the batching queue before its batch was processed.
+void RecordBatchWaitTime(uint64 batch_wait_ns, const string& model_name);
+
+}  // namespace internal
 
 // Base class for resource that encapsulating the state and logic for batching
 // tensors.
@@ -0,0 +1,123 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Returns a [rows, cols] tensor holding 0, 1, 2, ...
+Tensor Iota(int64 rows, int64 cols) {
+  Tensor tensor(DT_FLOAT, TensorShape({rows, cols}));
+  auto flat = tensor.flat<float>();
+  for (int64 i = 0; i < flat.size(); ++i) {
+    flat(i) = i;
+  }
+  return tensor;
+}
+
+TEST(SplitBatchedTensorTest, AlignedSplitsAliasInput) {
+  // Rows of 128 bytes keep every slice aligned.
+  const Tensor input = Iota(4, 32);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(internal::SplitBatchedTensor(input, {1, 3}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  for (const Tensor& output : outputs) {
+    EXPECT_TRUE(output.SharesBufferWith(input));
+  }
+  test::ExpectTensorEqual<float>(outputs[0], input.Slice(0, 1));
+  test::ExpectTensorEqual<float>(outputs[1], input.Slice(1, 4));
+}
+
+TEST(SplitBatchedTensorTest, MisalignedSplitsAreCopied) {
+  // The second slice starts 4 bytes into the buffer.
+  const Tensor input = Iota(3, 1);
+  if (input.Slice(1, 3).IsAligned()) {
+    GTEST_SKIP() << "Slices are never misaligned in this build";
+  }
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(internal::SplitBatchedTensor(input, {1, 2}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  for (const Tensor& output : outputs) {
+    EXPECT_FALSE(output.SharesBufferWith(input));
+    EXPECT_TRUE(output.IsAligned());
+  }
+  test::ExpectTensorEqual<float>(outputs[0],
+                                 test::AsTensor<float>({0}, {1, 1}));
+  test::ExpectTensorEqual<float>(outputs[1],
+                                 test::AsTensor<float>({1, 2}, {2, 1}));
+}
+
+TEST(ConcatBatchedTensorsTest, SingleInputIsPassedThrough) {
+  const Tensor input = Iota(4, 3);
+  Tensor output;
+  // Passing a single input through allocates nothing, so needs no context.
+  TF_ASSERT_OK(internal::ConcatBatchedTensors(/*context=*/nullptr, {input},
+                                              &output));
+  EXPECT_TRUE(output.SharesBufferWith(input));
+  test::ExpectTensorEqual<float>(output, input);
+}
+
+// Returns the histogram recorded in the cell of the
+// /tensorflow/serving/step_time_usecs metric with the given labels, or an
+// empty one if there is no such cell.
+HistogramProto ServingStepTime(const string& model_name,
+                               const string& signature_name,
+                               const string& phase) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  auto it = metrics->point_set_map.find("/tensorflow/serving/step_time_usecs");
+  if (it == metrics->point_set_map.end()) return HistogramProto();
+  for (const std::unique_ptr<monitoring::Point>& point : it->second->points) {
+    std::map<string, string> labels;
+    for (const monitoring::Point::Label& label : point->labels) {
+      labels[label.name] = label.value;
+    }
+    if (labels["model_name"] == model_name &&
+        labels["signature_name"] == signature_name &&
+        labels["phase"] == phase) {
+      return point->histogram_value;
+    }
+  }
+  return HistogramProto();
+}
+
+TEST(RecordBatchWaitTimeTest, RecordsBatchWaitPhase) {
+  internal::RecordBatchWaitTime(/*batch_wait_ns=*/3000000, "batch_wait_model");
+  internal::RecordBatchWaitTime(/*batch_wait_ns=*/5000, "batch_wait_model");
+
+  // The batching ops don't know the signature, and record microseconds.
+  const HistogramProto histogram =
+      ServingStepTime("batch_wait_model", /*signature_name=*/"", "batch_wait");
+  EXPECT_EQ(2, histogram.num());
+  EXPECT_EQ(3005, histogram.sum());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
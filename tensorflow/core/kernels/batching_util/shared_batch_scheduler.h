@@ -18,14 +18,17 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "tensorflow/core/kernels/batching_util/batch_latency_tuner.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -119,6 +122,13 @@ class SharedBatchScheduler
     // The environment to use.
     // (Typically only overridden by test code.)
     Env* env = Env::Default();
+
+    // If true, batch threads share their time between queues in proportion to
+    // the queues' `fair_share_weight`s, instead of taking one batch from each
+    // queue in turn. Time is measured as the duration of the process-batch
+    // callback, so that a queue whose batches occupy a shared accelerator for
+    // longer (e.g. a larger model) gets proportionally fewer batches.
+    bool fair_share_by_processing_time = false;
   };
   // Ownership is shared between the caller of Create() and any queues created
   // via AddQueue().
@@ -194,6 +204,38 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If positive, the queue tunes its batch timeout and the size at which it
+    // schedules the open batch so that batches finish processing within this
+    // many microseconds of their first task being enqueued, based on the
+    // observed arrival rate and batch processing times. Larger batches are
+    // formed under heavy load and smaller ones under light load.
+    //
+    // `batch_timeout_micros` and the maximum batch size then become upper
+    // bounds for the tuned values; a `batch_timeout_micros` of 0 leaves the
+    // timeout bounded only by the latency target.
+    int64 latency_target_micros = 0;
+
+    // If set, tasks are only batched with tasks of similar length, so that
+    // little compute is spent on padding when a batch is padded to its longest
+    // task (e.g. a sequence model). A task of length l is placed in the bucket
+    // of the first entry of `length_bucket_boundaries` that is >= l, or in a
+    // final bucket if there is none. Each bucket forms batches independently,
+    // with the options above, and may hold up to `max_enqueued_batches`.
+    //
+    // `length_bucket_boundaries` must be strictly increasing.
+    std::function<int64(const TaskType& task)> task_length_func;
+    std::vector<int64> length_bucket_boundaries;
+
+    // If set, tasks for which this returns true are batched separately from
+    // other tasks, without waiting for their batch to fill, and batch threads
+    // process their batches ahead of those of any other queue.
+    std::function<bool(const TaskType& task)> is_high_priority_task_func;
+
+    // The share of batch processing time this queue receives relative to other
+    // queues, if the scheduler has `fair_share_by_processing_time` set. Must be
+    // positive.
+    double fair_share_weight = 1.0;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -209,6 +251,23 @@ class SharedBatchScheduler
   // no queues provide a batch to process, just sleeps briefly and exits.
   void ThreadLogic();
 
+  // Adds a queue for AddQueue(), after validating 'options'. Tasks of a high
+  // priority queue are scheduled ahead of those of other queues.
+  Status AddInternalQueue(
+      const QueueOptions& options,
+      std::function<void(std::unique_ptr<Batch<TaskType>>)>
+          process_batch_callback,
+      bool high_priority, std::unique_ptr<BatchScheduler<TaskType>>* queue);
+
+  // Returns a batch from the queue that has received the least processing
+  // time relative to its weight among those that have one to schedule, or
+  // nullptr. Sets '*queue_for_batch' to that queue. Drops closed, empty queues.
+  // Sets '*charged_virtual_time_micros' to the amount to pass to
+  // ProcessBatch().
+  std::unique_ptr<Batch<TaskType>> ScheduleFairShareBatch(
+      internal::Queue<TaskType>** queue_for_batch,
+      double* charged_virtual_time_micros) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const Options options_;
 
   mutex mu_;
@@ -227,6 +286,14 @@ class SharedBatchScheduler
   // available batch thread should grab work.
   typename QueueList::iterator next_queue_to_schedule_ TF_GUARDED_BY(mu_);
 
+  // The number of high priority queues in 'queues_'.
+  int num_high_priority_queues_ TF_GUARDED_BY(mu_) = 0;
+
+  // With 'options_.fair_share_by_processing_time', the virtual time of the
+  // most recently scheduled batch. Queues that were idle resume from it rather
+  // than from their own, older virtual time, so that idling earns no credit.
+  double fair_share_virtual_time_micros_ TF_GUARDED_BY(mu_) = 0;
+
   // Used by idle batch threads to wait for work to enter the system. Notified
   // whenever a batch becomes schedulable.
   condition_variable schedulable_batch_cv_;
@@ -272,7 +339,8 @@ class Queue {
       std::vector<std::unique_ptr<TaskType>>* output_tasks)>;
   Queue(const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
         Env* env, ProcessBatchCallback process_batch_callback,
-        SchedulableBatchCallback schedulable_batch_callback);
+        SchedulableBatchCallback schedulable_batch_callback,
+        bool high_priority = false);
 
   // Illegal to destruct unless the queue is empty.
   ~Queue();
@@ -316,7 +384,10 @@ class Queue {
   std::unique_ptr<Batch<TaskType>> ScheduleBatch();
 
   // Processes a batch that has been returned earlier by ScheduleBatch().
-  void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
+  // 'charged_virtual_time_micros' is what ChargeVirtualTime() returned for
+  // it, if it was called.
+  void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch,
+                    double charged_virtual_time_micros = 0);
 
   // Determines whether the queue is empty, i.e. has no tasks waiting or being
   // processed.
@@ -327,6 +398,21 @@ class Queue {
 
   bool closed() const TF_NO_THREAD_SAFETY_ANALYSIS { return closed_.load(); }
 
+  // Whether batch threads should take batches from this queue before those of
+  // other queues.
+  bool high_priority() const { return high_priority_; }
+
+  // The processing time of this queue's batches so far, divided by its
+  // fair share weight, plus any idle time skipped by SetVirtualTimeMicros().
+  double virtual_time_micros() const;
+  void SetVirtualTimeMicros(double virtual_time_micros);
+
+  // Advances the virtual time by the expected processing time of a batch that
+  // was just scheduled, so that other batch threads see it before the batch
+  // completes. Returns the amount, which ProcessBatch() corrects to the actual
+  // processing time.
+  double ChargeVirtualTime();
+
  private:
   // Same as IsEmpty(), but assumes the caller already holds a lock on 'mu_'.
   bool IsEmptyInternal() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -345,8 +431,14 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // The batch size and timeout at which the open batch becomes schedulable.
+  size_t batch_size_limit() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  int64 batch_timeout_micros() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
+  const bool high_priority_;
+
   // The environment to use.
   Env* env_;
 
@@ -375,6 +467,21 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
 
+  // See virtual_time_micros().
+  double virtual_time_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  // A moving average of the time taken to process a batch.
+  double estimated_batch_processing_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  // Tunes the batch size limit and timeout if 'options_.latency_target_micros'
+  // is positive; null otherwise.
+  std::unique_ptr<BatchLatencyTuner> latency_tuner_ TF_GUARDED_BY(mu_);
+
+  // The start times of closed batches that have not finished processing, by
+  // TraceMe context id. Only maintained if 'latency_tuner_' is non-null.
+  std::unordered_map<uint64, uint64> closed_batch_start_times_micros_
+      TF_GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled.
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
@@ -419,6 +526,44 @@ class QueueHandle : public BatchScheduler<TaskType> {
   TF_DISALLOW_COPY_AND_ASSIGN(QueueHandle);
 };
 
+// Implements the BatchScheduler API for a queue with length buckets or high
+// priority tasks, by routing each task to one of several queues.
+template <typename TaskType>
+class BucketedQueueHandle : public BatchScheduler<TaskType> {
+ public:
+  // 'length_queues' holds one queue per length bucket. 'high_priority_queue'
+  // is null unless the options have an 'is_high_priority_task_func'.
+  BucketedQueueHandle(
+      const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
+      std::vector<std::unique_ptr<BatchScheduler<TaskType>>> length_queues,
+      std::unique_ptr<BatchScheduler<TaskType>> high_priority_queue);
+  ~BucketedQueueHandle() override = default;
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override;
+  size_t NumEnqueuedTasks() const override;
+
+  // Returns the smallest capacity of the underlying queues, which any task
+  // can rely on regardless of which queue it is routed to.
+  size_t SchedulingCapacity() const override;
+
+  size_t max_task_size() const override {
+    return length_queues_[0]->max_task_size();
+  }
+
+ private:
+  // Returns the queue to which 'task' is routed.
+  BatchScheduler<TaskType>* SelectQueue(const TaskType& task) const;
+
+  const std::function<int64(const TaskType&)> task_length_func_;
+  const std::vector<int64> length_bucket_boundaries_;
+  const std::function<bool(const TaskType&)> is_high_priority_task_func_;
+
+  std::vector<std::unique_ptr<BatchScheduler<TaskType>>> length_queues_;
+  std::unique_ptr<BatchScheduler<TaskType>> high_priority_queue_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BucketedQueueHandle);
+};
+
 }  // namespace internal
 
 template <typename TaskType>
@@ -468,11 +613,20 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "batch_timeout_micros must be non-negative; was ",
         options.batch_timeout_micros);
   }
+  if (options.latency_target_micros < 0) {
+    return errors::InvalidArgument(
+        "latency_target_micros must be non-negative; was ",
+        options.latency_target_micros);
+  }
   if (options.max_enqueued_batches < 0) {
     return errors::InvalidArgument(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  if (options.fair_share_weight <= 0) {
+    return errors::InvalidArgument("fair_share_weight must be positive; was ",
+                                   options.fair_share_weight);
+  }
 
   if (options.enable_large_batch_splitting &&
       options.split_input_task_func == nullptr) {
@@ -492,6 +646,64 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         options.max_execution_batch_size);
   }
 
+  if (!options.length_bucket_boundaries.empty() &&
+      options.task_length_func == nullptr) {
+    return errors::InvalidArgument(
+        "task_length_func must be specified with length_bucket_boundaries");
+  }
+  for (int i = 1; i < options.length_bucket_boundaries.size(); ++i) {
+    if (options.length_bucket_boundaries[i] <=
+        options.length_bucket_boundaries[i - 1]) {
+      return errors::InvalidArgument(
+          "length_bucket_boundaries must be strictly increasing");
+    }
+  }
+
+  if (options.task_length_func == nullptr &&
+      options.is_high_priority_task_func == nullptr) {
+    return AddInternalQueue(options, process_batch_callback,
+                            /*high_priority=*/false, queue);
+  }
+
+  QueueOptions bucket_options = options;
+  bucket_options.task_length_func = nullptr;
+  bucket_options.length_bucket_boundaries.clear();
+  bucket_options.is_high_priority_task_func = nullptr;
+
+  const int num_length_buckets =
+      options.task_length_func == nullptr
+          ? 1
+          : options.length_bucket_boundaries.size() + 1;
+  std::vector<std::unique_ptr<BatchScheduler<TaskType>>> length_queues(
+      num_length_buckets);
+  for (auto& length_queue : length_queues) {
+    TF_RETURN_IF_ERROR(AddInternalQueue(bucket_options, process_batch_callback,
+                                        /*high_priority=*/false,
+                                        &length_queue));
+  }
+
+  std::unique_ptr<BatchScheduler<TaskType>> high_priority_queue;
+  if (options.is_high_priority_task_func != nullptr) {
+    QueueOptions high_priority_options = bucket_options;
+    high_priority_options.batch_timeout_micros = 0;
+    high_priority_options.latency_target_micros = 0;
+    TF_RETURN_IF_ERROR(AddInternalQueue(high_priority_options,
+                                        process_batch_callback,
+                                        /*high_priority=*/true,
+                                        &high_priority_queue));
+  }
+
+  queue->reset(new internal::BucketedQueueHandle<TaskType>(
+      options, std::move(length_queues), std::move(high_priority_queue)));
+  return Status::OK();
+}
+
+template <typename TaskType>
+Status SharedBatchScheduler<TaskType>::AddInternalQueue(
+    const QueueOptions& options,
+    std::function<void(std::unique_ptr<Batch<TaskType>>)>
+        process_batch_callback,
+    bool high_priority, std::unique_ptr<BatchScheduler<TaskType>>* queue) {
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
     schedulable_batch_cv_.notify_one();
@@ -499,13 +711,16 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
   auto internal_queue =
       std::unique_ptr<internal::Queue<TaskType>>(new internal::Queue<TaskType>(
           options, options_.env, process_batch_callback,
-          schedulable_batch_callback));
+          schedulable_batch_callback, high_priority));
   auto handle = std::unique_ptr<BatchScheduler<TaskType>>(
       new internal::QueueHandle<TaskType>(this->shared_from_this(),
                                           internal_queue.get()));
   {
     mutex_lock l(mu_);
     queues_.push_back(std::move(internal_queue));
+    if (high_priority) {
+      ++num_high_priority_queues_;
+    }
     if (next_queue_to_schedule_ == queues_.end()) {
       next_queue_to_schedule_ = queues_.begin();
     }
@@ -535,10 +750,29 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
   std::unique_ptr<Batch<TaskType>> batch_to_process;
   // The queue with which 'batch_to_process' is associated.
   internal::Queue<TaskType>* queue_for_batch = nullptr;
+  double charged_virtual_time_micros = 0;
   {
     mutex_lock l(mu_);
 
-    const int num_queues = queues_.size();
+    // High priority queues get the first chance to provide a batch.
+    if (num_high_priority_queues_ > 0) {
+      for (const auto& queue : queues_) {
+        if (!queue->high_priority()) continue;
+        batch_to_process = queue->ScheduleBatch();
+        if (batch_to_process != nullptr) {
+          queue_for_batch = queue.get();
+          break;
+        }
+      }
+    }
+
+    if (batch_to_process == nullptr && options_.fair_share_by_processing_time) {
+      batch_to_process = ScheduleFairShareBatch(&queue_for_batch,
+                                                &charged_virtual_time_micros);
+    }
+
+    const int num_queues =
+        options_.fair_share_by_processing_time ? 0 : queues_.size();
     for (int num_queues_tried = 0;
          batch_to_process == nullptr && num_queues_tried < num_queues;
          ++num_queues_tried) {
@@ -561,6 +795,9 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
           batch_to_process == nullptr) {
         // We've encountered a closed queue with no work to do. Drop it.
         DCHECK_NE(queue_for_batch, next_queue_to_schedule_->get());
+        if ((*next_queue_to_schedule_)->high_priority()) {
+          --num_high_priority_queues_;
+        }
         next_queue_to_schedule_ = queues_.erase(next_queue_to_schedule_);
       } else {
         ++next_queue_to_schedule_;
@@ -580,7 +817,57 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
     }
   }
 
-  queue_for_batch->ProcessBatch(std::move(batch_to_process));
+  queue_for_batch->ProcessBatch(std::move(batch_to_process),
+                                charged_virtual_time_micros);
+}
+
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>>
+SharedBatchScheduler<TaskType>::ScheduleFairShareBatch(
+    internal::Queue<TaskType>** queue_for_batch,
+    double* charged_virtual_time_micros) {
+  // Visit the queues in order of increasing virtual time. Ties go to the
+  // oldest queue.
+  using Candidate = std::pair<double, typename QueueList::iterator>;
+  std::vector<Candidate> candidates;
+  candidates.reserve(queues_.size());
+  for (auto it = queues_.begin(); it != queues_.end(); ++it) {
+    candidates.emplace_back((*it)->virtual_time_micros(), it);
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.first < b.first;
+                   });
+
+  for (const auto& candidate : candidates) {
+    const typename QueueList::iterator it = candidate.second;
+    // See ThreadLogic() for why closedness is checked first.
+    const bool queue_closed = (*it)->closed();
+    std::unique_ptr<Batch<TaskType>> batch = (*it)->ScheduleBatch();
+    if (batch != nullptr) {
+      if (candidate.first < fair_share_virtual_time_micros_) {
+        (*it)->SetVirtualTimeMicros(fair_share_virtual_time_micros_);
+      } else {
+        fair_share_virtual_time_micros_ = candidate.first;
+      }
+      *charged_virtual_time_micros = (*it)->ChargeVirtualTime();
+      *queue_for_batch = it->get();
+      return batch;
+    }
+    if (queue_closed && (*it)->IsEmpty()) {
+      if ((*it)->high_priority()) {
+        --num_high_priority_queues_;
+      }
+      if (next_queue_to_schedule_ == it) {
+        ++next_queue_to_schedule_;
+      }
+      queues_.erase(it);
+      if (next_queue_to_schedule_ == queues_.end()) {
+        next_queue_to_schedule_ = queues_.begin();
+      }
+    }
+  }
+  return nullptr;
 }
 
 namespace internal {
@@ -589,13 +876,24 @@ template <typename TaskType>
 Queue<TaskType>::Queue(
     const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
     Env* env, ProcessBatchCallback process_batch_callback,
-    SchedulableBatchCallback schedulable_batch_callback)
+    SchedulableBatchCallback schedulable_batch_callback, bool high_priority)
     : options_(options),
+      high_priority_(high_priority),
       env_(env),
       process_batch_callback_(process_batch_callback),
       schedulable_batch_callback_(schedulable_batch_callback) {
   // Create an initial, open batch.
   batches_.emplace_back(new Batch<TaskType>);
+
+  if (options_.latency_target_micros > 0) {
+    BatchLatencyTuner::Options tuner_options;
+    tuner_options.latency_target_micros = options_.latency_target_micros;
+    if (options_.batch_timeout_micros > 0) {
+      tuner_options.max_batch_timeout_micros = options_.batch_timeout_micros;
+    }
+    tuner_options.max_batch_size = max_execution_batch_size();
+    latency_tuner_.reset(new BatchLatencyTuner(tuner_options));
+  }
 }
 
 template <typename TaskType>
@@ -638,8 +936,12 @@ Status Queue<TaskType>::ScheduleWithoutSplit(std::unique_ptr<TaskType>* task) {
       }
       StartNewBatch();
     }
+    const uint64 now_micros = env_->NowMicros();
     if (batches_.back()->empty()) {
-      open_batch_start_time_micros_ = env_->NowMicros();
+      open_batch_start_time_micros_ = now_micros;
+    }
+    if (latency_tuner_ != nullptr) {
+      latency_tuner_->RecordArrival(now_micros, (*task)->size());
     }
     profiler::TraceMeProducer trace_me(
         [task] {
@@ -716,6 +1018,10 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
 
     std::vector<std::unique_ptr<TaskType>> output_tasks;
 
+    if (latency_tuner_ != nullptr) {
+      latency_tuner_->RecordArrival(env_->NowMicros(), input_task_size);
+    }
+
     if (input_task_size <= open_batch_remaining_slot) {
       // This is the fast path when input doesn't need to be split.
       output_tasks.push_back(std::move(*task));
@@ -805,7 +1111,8 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 }
 
 template <typename TaskType>
-void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
+void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch,
+                                   double charged_virtual_time_micros) {
   profiler::TraceMeConsumer trace_me(
       [&] {
         return profiler::TraceMeEncode(
@@ -815,10 +1122,31 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
       },
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
+  const uint64 traceme_context_id = batch->traceme_context_id();
+  const int batch_size = batch->size();
+  const uint64 start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
 
   {
     mutex_lock l(mu_);
+    const double processing_micros = env_->NowMicros() - start_time_micros;
+    virtual_time_micros_ += processing_micros / options_.fair_share_weight -
+                            charged_virtual_time_micros;
+    estimated_batch_processing_micros_ =
+        estimated_batch_processing_micros_ == 0
+            ? processing_micros
+            : 0.8 * estimated_batch_processing_micros_ +
+                  0.2 * processing_micros;
+    if (latency_tuner_ != nullptr) {
+      const uint64 end_time_micros = env_->NowMicros();
+      auto it = closed_batch_start_times_micros_.find(traceme_context_id);
+      if (it != closed_batch_start_times_micros_.end()) {
+        latency_tuner_->RecordBatch(batch_size,
+                                    end_time_micros - start_time_micros,
+                                    end_time_micros - it->second);
+        closed_batch_start_times_micros_.erase(it);
+      }
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -826,6 +1154,27 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
   }
 }
 
+template <typename TaskType>
+double Queue<TaskType>::virtual_time_micros() const {
+  mutex_lock l(mu_);
+  return virtual_time_micros_;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::SetVirtualTimeMicros(double virtual_time_micros) {
+  mutex_lock l(mu_);
+  virtual_time_micros_ = virtual_time_micros;
+}
+
+template <typename TaskType>
+double Queue<TaskType>::ChargeVirtualTime() {
+  mutex_lock l(mu_);
+  const double charge_micros =
+      estimated_batch_processing_micros_ / options_.fair_share_weight;
+  virtual_time_micros_ += charge_micros;
+  return charge_micros;
+}
+
 template <typename TaskType>
 bool Queue<TaskType>::IsEmpty() const {
   mutex_lock l(mu_);
@@ -856,6 +1205,10 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
+  if (latency_tuner_ != nullptr && !batches_.back()->empty()) {
+    closed_batch_start_times_micros_[batches_.back()->traceme_context_id()] =
+        open_batch_start_time_micros_;
+  }
   batches_.back()->Close();
   batches_.emplace_back(new Batch<TaskType>(++traceme_context_id_counter_));
 }
@@ -877,9 +1230,26 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  return closed_ || open_batch->size() >= batch_size_limit() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros();
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::batch_size_limit() const {
+  if (latency_tuner_ != nullptr) {
+    return std::min<size_t>(max_execution_batch_size(),
+                            latency_tuner_->batch_size_limit());
+  }
+  return max_execution_batch_size();
+}
+
+template <typename TaskType>
+int64 Queue<TaskType>::batch_timeout_micros() const {
+  if (latency_tuner_ != nullptr) {
+    return latency_tuner_->batch_timeout_micros();
+  }
+  return options_.batch_timeout_micros;
 }
 
 template <typename TaskType>
@@ -908,6 +1278,68 @@ size_t QueueHandle<TaskType>::SchedulingCapacity() const {
   return queue_->SchedulingCapacity();
 }
 
+template <typename TaskType>
+BucketedQueueHandle<TaskType>::BucketedQueueHandle(
+    const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
+    std::vector<std::unique_ptr<BatchScheduler<TaskType>>> length_queues,
+    std::unique_ptr<BatchScheduler<TaskType>> high_priority_queue)
+    : task_length_func_(options.task_length_func),
+      length_bucket_boundaries_(options.length_bucket_boundaries),
+      is_high_priority_task_func_(options.is_high_priority_task_func),
+      length_queues_(std::move(length_queues)),
+      high_priority_queue_(std::move(high_priority_queue)) {
+  DCHECK(!length_queues_.empty());
+  DCHECK_EQ(is_high_priority_task_func_ != nullptr,
+            high_priority_queue_ != nullptr);
+}
+
+template <typename TaskType>
+Status BucketedQueueHandle<TaskType>::Schedule(
+    std::unique_ptr<TaskType>* task) {
+  return SelectQueue(**task)->Schedule(task);
+}
+
+template <typename TaskType>
+size_t BucketedQueueHandle<TaskType>::NumEnqueuedTasks() const {
+  size_t num_enqueued_tasks = 0;
+  for (const auto& length_queue : length_queues_) {
+    num_enqueued_tasks += length_queue->NumEnqueuedTasks();
+  }
+  if (high_priority_queue_ != nullptr) {
+    num_enqueued_tasks += high_priority_queue_->NumEnqueuedTasks();
+  }
+  return num_enqueued_tasks;
+}
+
+template <typename TaskType>
+size_t BucketedQueueHandle<TaskType>::SchedulingCapacity() const {
+  size_t scheduling_capacity = length_queues_[0]->SchedulingCapacity();
+  for (const auto& length_queue : length_queues_) {
+    scheduling_capacity =
+        std::min(scheduling_capacity, length_queue->SchedulingCapacity());
+  }
+  if (high_priority_queue_ != nullptr) {
+    scheduling_capacity = std::min(scheduling_capacity,
+                                   high_priority_queue_->SchedulingCapacity());
+  }
+  return scheduling_capacity;
+}
+
+template <typename TaskType>
+BatchScheduler<TaskType>* BucketedQueueHandle<TaskType>::SelectQueue(
+    const TaskType& task) const {
+  if (high_priority_queue_ != nullptr && is_high_priority_task_func_(task)) {
+    return high_priority_queue_.get();
+  }
+  if (task_length_func_ == nullptr) {
+    return length_queues_[0].get();
+  }
+  const auto bucket = std::lower_bound(length_bucket_boundaries_.begin(),
+                                       length_bucket_boundaries_.end(),
+                                       task_length_func_(task));
+  return length_queues_[bucket - length_bucket_boundaries_.begin()].get();
+}
+
 }  // namespace internal
 
 }  // namespace serving
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -254,6 +256,248 @@ TEST(SharedBatchSchedulerTest, ObeysTimeout) {
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, LatencyTargetBoundsTimeout) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification batch_processed;
+    auto callback = [&batch_processed](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      EXPECT_EQ(batch->size(), 1);
+      batch_processed.Notify();
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 4;
+    queue_options.latency_target_micros = 20;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Until batches have been processed, half of the latency target is spent
+    // waiting for more tasks.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    env.AdvanceByMicroseconds(9);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(1);
+    batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, RejectsNegativeLatencyTarget) {
+  SharedBatchScheduler<FakeTask>::Options options;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.latency_target_micros = -1;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler
+                ->AddQueue(queue_options,
+                           [](std::unique_ptr<Batch<FakeTask>> batch) {},
+                           &queue)
+                .code());
+}
+
+TEST(SharedBatchSchedulerTest, LengthBuckets) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<int> batch_sizes;
+    auto callback = [&mu,
+                     &batch_sizes](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      // Each batch only holds tasks from one length bucket.
+      for (int i = 1; i < batch->num_tasks(); ++i) {
+        EXPECT_EQ(batch->task(i).size() <= 2, batch->task(0).size() <= 2);
+      }
+      mutex_lock l(mu);
+      batch_sizes.push_back(batch->size());
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 20;
+    queue_options.batch_timeout_micros = 10;
+    queue_options.task_length_func = [](const FakeTask& task) {
+      return static_cast<int64>(task.size());
+    };
+    queue_options.length_bucket_boundaries = {2};
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(5, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(5, queue.get()));
+    EXPECT_EQ(queue->NumEnqueuedTasks(), 4);
+    env.AdvanceByMicroseconds(10);
+    start_teardown.Notify();
+    queue.reset();
+
+    std::sort(batch_sizes.begin(), batch_sizes.end());
+    EXPECT_EQ(batch_sizes, std::vector<int>({3, 10}));
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, HighPriorityTasksDoNotWaitForTimeout) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification high_priority_batch_processed;
+    Notification low_priority_batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      if (batch->task(0).size() == 3) {
+        high_priority_batch_processed.Notify();
+      } else {
+        low_priority_batch_processed.Notify();
+      }
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 10;
+    queue_options.batch_timeout_micros = 10 * 1000;
+    queue_options.is_high_priority_task_func = [](const FakeTask& task) {
+      return task.size() == 3;
+    };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // The high priority task is processed while the clock stands still; the
+    // other task waits for its batch to time out.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(3, queue.get()));
+    high_priority_batch_processed.WaitForNotification();
+    EXPECT_FALSE(low_priority_batch_processed.HasBeenNotified());
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, RejectsInvalidLengthBuckets) {
+  SharedBatchScheduler<FakeTask>::Options options;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {};
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.length_bucket_boundaries = {4, 8};
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler->AddQueue(queue_options, callback, &queue).code());
+
+  queue_options.task_length_func = [](const FakeTask& task) {
+    return static_cast<int64>(task.size());
+  };
+  queue_options.length_bucket_boundaries = {8, 4};
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler->AddQueue(queue_options, callback, &queue).code());
+}
+
+TEST(SharedBatchSchedulerTest, FairShareByProcessingTime) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<char> processed_queues;
+    Notification all_tasks_scheduled;
+    // Every batch takes 100us to process.
+    auto make_callback = [&](char queue_name) {
+      return [&, queue_name](std::unique_ptr<Batch<FakeTask>> batch) {
+        all_tasks_scheduled.WaitForNotification();
+        env.AdvanceByMicroseconds(100);
+        mutex_lock l(mu);
+        processed_queues.push_back(queue_name);
+      };
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    options.fair_share_by_processing_time = true;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 1;
+    queue_options.max_enqueued_batches = 20;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue_a;
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, make_callback('a'), &queue_a));
+    queue_options.fair_share_weight = 3;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue_b;
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, make_callback('b'), &queue_b));
+
+    // The first task of 'a' occupies the batch thread while the others are
+    // enqueued. After that, 'b' gets three batches for each batch of 'a'.
+    TF_ASSERT_OK(ScheduleTask(1, queue_a.get()));
+    while (queue_a->NumEnqueuedTasks() > 0) {
+      Env::Default()->SleepForMicroseconds(100);
+    }
+    for (int i = 0; i < 12; ++i) {
+      TF_ASSERT_OK(ScheduleTask(1, queue_a.get()));
+      TF_ASSERT_OK(ScheduleTask(1, queue_b.get()));
+    }
+    all_tasks_scheduled.Notify();
+    start_teardown.Notify();
+    queue_a.reset();
+    queue_b.reset();
+
+    ASSERT_EQ(processed_queues.size(), 25);
+    EXPECT_EQ(string(processed_queues.begin(), processed_queues.begin() + 13),
+              "abbbabbbabbba");
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, RejectsNonPositiveFairShareWeight) {
+  SharedBatchScheduler<FakeTask>::Options options;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.fair_share_weight = 0;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler
+                ->AddQueue(queue_options,
+                           [](std::unique_ptr<Batch<FakeTask>> batch) {},
+                           &queue)
+                .code());
+}
+
 TEST(SharedBatchSchedulerTest, ObeysTimeoutWithRealClock) {
   Notification first_batch_processed, second_batch_processed;
   auto callback = [&first_batch_processed, &second_batch_processed](
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
 #include "tensorflow/core/kernels/boosted_trees/tree_helper.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -1277,16 +1278,24 @@ class BoostedTreesMakeStatsSummaryOp : public OpKernel {
     auto temp_stats_double = temp_stats_double_t.tensor<double, 4>();
     temp_stats_double.setZero();
 
-    // Partition by node, and then bucketize.
-    for (int feature_idx = 0; feature_idx < num_features_; ++feature_idx) {
-      const auto& features = bucketized_features_list[feature_idx].vec<int32>();
-      for (int i = 0; i < batch_size; ++i) {
-        const int32 node = node_ids(i);
-        const int32 bucket = features(i);
-        temp_stats_double(feature_idx, node, bucket, 0) += gradients(i, 0);
-        temp_stats_double(feature_idx, node, bucket, 1) += hessians(i, 0);
+    // Partition by node, and then bucketize.  Every feature accumulates into
+    // its own histogram, so the features are processed in parallel.
+    auto do_work = [&](int64 start, int64 end) {
+      for (int64 feature_idx = start; feature_idx < end; ++feature_idx) {
+        const auto& features =
+            bucketized_features_list[feature_idx].vec<int32>();
+        for (int i = 0; i < batch_size; ++i) {
+          const int32 node = node_ids(i);
+          const int32 bucket = features(i);
+          temp_stats_double(feature_idx, node, bucket, 0) += gradients(i, 0);
+          temp_stats_double(feature_idx, node, bucket, 1) += hessians(i, 0);
+        }
       }
-    }
+    };
+    thread::ThreadPool* const worker_threads =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    Shard(worker_threads->NumThreads(), worker_threads, num_features_,
+          /*cost_per_unit=*/10 * batch_size, do_work);
 
     // Copy temp tensor over to output tensor.
     Tensor* output_stats_summary_t = nullptr;
@@ -1354,22 +1363,30 @@ class BoostedTreesAggregateStatsOp : public OpKernel {
     auto temp_stats_double = temp_stats_double_t.tensor<double, 4>();
     temp_stats_double.setZero();
 
-    for (int i = 0; i < batch_size; ++i) {
-      const int32 node = node_ids(i);
-      for (int feature_dim = 0; feature_dim < feature_dims; ++feature_dim) {
-        const int32 feature_value = feature(i, feature_dim);
-        const int32 bucket =
-            (feature_value == -1) ? num_buckets_ : feature_value;
-        for (int stat_dim = 0; stat_dim < logits_dims; ++stat_dim) {
-          temp_stats_double(node, feature_dim, bucket, stat_dim) +=
-              gradients(i, stat_dim);
-        }
-        for (int stat_dim = logits_dims; stat_dim < stats_dims; ++stat_dim) {
-          temp_stats_double(node, feature_dim, bucket, stat_dim) +=
-              hessians(i, stat_dim - logits_dims);
+    // Every feature dimension accumulates into its own histograms, so the
+    // feature dimensions are processed in parallel.
+    auto do_work = [&](int64 start, int64 end) {
+      for (int64 feature_dim = start; feature_dim < end; ++feature_dim) {
+        for (int i = 0; i < batch_size; ++i) {
+          const int32 node = node_ids(i);
+          const int32 feature_value = feature(i, feature_dim);
+          const int32 bucket =
+              (feature_value == -1) ? num_buckets_ : feature_value;
+          for (int stat_dim = 0; stat_dim < logits_dims; ++stat_dim) {
+            temp_stats_double(node, feature_dim, bucket, stat_dim) +=
+                gradients(i, stat_dim);
+          }
+          for (int stat_dim = logits_dims; stat_dim < stats_dims; ++stat_dim) {
+            temp_stats_double(node, feature_dim, bucket, stat_dim) +=
+                hessians(i, stat_dim - logits_dims);
+          }
         }
       }
-    }
+    };
+    thread::ThreadPool* const worker_threads =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    Shard(worker_threads->NumThreads(), worker_threads, feature_dims,
+          /*cost_per_unit=*/10 * batch_size * stats_dims, do_work);
 
     // Copy temp tensor over to output tensor, downcasting to float.
     Tensor* output_stats_summary_t = nullptr;
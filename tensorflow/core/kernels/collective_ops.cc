@@ -47,6 +47,60 @@ static std::unique_ptr<OpKernel> BuildOpKernel(OpKernelConstruction* c,
   return k;
 }
 
+// Builds the kernels that convert chunks of a reduction to and from their
+// wire format, unless `compression` is "none".  Compression is lossy, so it is
+// only offered for float sums, i.e. gradient aggregation.
+static void BuildCodecOpKernels(OpKernelConstruction* c,
+                                const string& compression,
+                                const string& merge_op_name,
+                                CollectiveParams* col_params) {
+  if (compression == "none") return;
+  DataType wire_type = DT_INVALID;
+  if (compression == "float16") {
+    wire_type = DT_HALF;
+  } else if (compression == "bfloat16") {
+    wire_type = DT_BFLOAT16;
+  } else {
+    c->CtxFailure(errors::InvalidArgument("Unknown compression ", compression));
+    return;
+  }
+  OP_REQUIRES(c, col_params->instance.data_type == DT_FLOAT,
+              errors::InvalidArgument(
+                  "compression requires float values, got ",
+                  DataTypeString(col_params->instance.data_type)));
+  OP_REQUIRES(c, merge_op_name == "Add",
+              errors::InvalidArgument(
+                  "compression requires merge_op Add, got ", merge_op_name));
+  auto build = [c, wire_type](const string& op, bool accumulate) {
+    NodeDef sub_node;
+    sub_node.set_name(strings::StrCat(c->def().name(), "/", op,
+                                      accumulate ? "_merge" : ""));
+    sub_node.set_op(op);
+    sub_node.add_input(c->def().input(0));
+    sub_node.add_input(c->def().input(0));
+    sub_node.set_device(c->def().device());
+    SetAttrValue(DT_FLOAT, &(*sub_node.mutable_attr())["T"]);
+    SetAttrValue(wire_type, &(*sub_node.mutable_attr())["Twire"]);
+    if (op == "_CollectiveDecode") {
+      SetAttrValue(accumulate, &(*sub_node.mutable_attr())["accumulate"]);
+    }
+    Status status;
+    std::unique_ptr<OpKernel> k = CreateOpKernel(
+        c->device_type(), c->device(),
+        c->device()->GetAllocator(AllocatorAttributes()), sub_node,
+        c->graph_def_version(), &status);
+    if (!status.ok()) {
+      c->CtxFailureWithWarning(errors::Internal("Failed to build OpKernel for ",
+                                                op, " : ",
+                                                status.error_message()));
+    }
+    return k;
+  };
+  col_params->encode_op = build("_CollectiveEncode", false);
+  col_params->decode_op = build("_CollectiveDecode", false);
+  col_params->decode_merge_op = build("_CollectiveDecode", true);
+}
+
 class CollectiveOpKernel : public AsyncOpKernel {
  public:
   explicit CollectiveOpKernel(OpKernelConstruction* c) : AsyncOpKernel(c) {}
@@ -228,6 +282,9 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
                  &(*sub_node.mutable_attr())["T"]);
     col_params_.merge_op = BuildOpKernel(c, merge_op_name, &sub_node);
     col_params_.final_op = BuildOpKernel(c, final_op_name, &sub_node);
+    string compression;
+    OP_REQUIRES_OK(c, c->GetAttr("compression", &compression));
+    BuildCodecOpKernels(c, compression, merge_op_name, &col_params_);
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
@@ -465,6 +522,9 @@ class CollectiveReduceV2OpKernel : public AsyncOpKernel {
                  &(*sub_node.mutable_attr())["T"]);
     col_params_->merge_op = BuildOpKernel(c, merge_op_name, &sub_node);
     col_params_->final_op = BuildOpKernel(c, final_op_name, &sub_node);
+    string compression;
+    OP_REQUIRES_OK(c, c->GetAttr("compression", &compression));
+    BuildCodecOpKernels(c, compression, merge_op_name, col_params_.get());
 
     col_params_->name = strings::StrCat(c->def().name(), ": ReduceV2(",
                                         merge_op_name, ",", final_op_name, ")");
@@ -514,6 +574,9 @@ class CollectiveReduceV2OpKernel : public AsyncOpKernel {
         col_params_->instance.impl_details.subdiv_offsets;
     col_params->merge_op = std::move(col_params_->merge_op);
     col_params->final_op = std::move(col_params_->final_op);
+    col_params->encode_op = std::move(col_params_->encode_op);
+    col_params->decode_op = std::move(col_params_->decode_op);
+    col_params->decode_merge_op = std::move(col_params_->decode_merge_op);
     VLOG(1) << "CollectiveReduceV2 group_size " << col_params->group.group_size
             << " group_key " << col_params->group.group_key << " instance_key "
             << col_params->instance.instance_key;
@@ -0,0 +1,130 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/collective_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/collective_ops_codec.h"
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+// Both kernels write their result in place of input 0, which the collective
+// implementation guarantees by forwarding it.
+template <typename Device, typename T, typename Twire>
+class CollectiveEncodeOp : public OpKernel {
+ public:
+  explicit CollectiveEncodeOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& wire = context->input(0);
+    const Tensor& value = context->input(1);
+    OP_REQUIRES(context, wire.NumElements() == value.NumElements(),
+                errors::InvalidArgument(
+                    "wire and value must have the same number of elements: ",
+                    wire.shape().DebugString(), " vs. ",
+                    value.shape().DebugString()));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, wire.shape(), &output));
+    functor::CollectiveEncode<Device, T, Twire>()(
+        context->eigen_device<Device>(), value.flat<T>(),
+        output->flat<Twire>());
+  }
+};
+
+template <typename Device, typename T, typename Twire>
+class CollectiveDecodeOp : public OpKernel {
+ public:
+  explicit CollectiveDecodeOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("accumulate", &accumulate_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& value = context->input(0);
+    const Tensor& wire = context->input(1);
+    OP_REQUIRES(context, wire.NumElements() == value.NumElements(),
+                errors::InvalidArgument(
+                    "value and wire must have the same number of elements: ",
+                    value.shape().DebugString(), " vs. ",
+                    wire.shape().DebugString()));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, value.shape(), &output));
+    functor::CollectiveDecode<Device, T, Twire>()(
+        context->eigen_device<Device>(), accumulate_, value.flat<T>(),
+        wire.flat<Twire>(), output->flat<T>());
+  }
+
+ private:
+  bool accumulate_;
+};
+
+#define REGISTER_KERNELS(D, T, Twire)                              \
+  REGISTER_KERNEL_BUILDER(Name("_CollectiveEncode")                \
+                              .Device(DEVICE_##D)                  \
+                              .TypeConstraint<T>("T")              \
+                              .TypeConstraint<Twire>("Twire"),     \
+                          CollectiveEncodeOp<D##Device, T, Twire>) \
+  REGISTER_KERNEL_BUILDER(Name("_CollectiveDecode")                \
+                              .Device(DEVICE_##D)                  \
+                              .TypeConstraint<T>("T")              \
+                              .TypeConstraint<Twire>("Twire"),     \
+                          CollectiveDecodeOp<D##Device, T, Twire>)
+
+REGISTER_KERNELS(CPU, float, Eigen::half);
+REGISTER_KERNELS(CPU, float, bfloat16);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T, Twire)                                          \
+  template <>                                                               \
+  void CollectiveEncode<GPUDevice, T, Twire>::operator()(                   \
+      const GPUDevice& d, typename TTypes<T>::ConstFlat value,              \
+      typename TTypes<Twire>::Flat wire);                                   \
+  extern template struct CollectiveEncode<GPUDevice, T, Twire>;             \
+                                                                            \
+  template <>                                                               \
+  void CollectiveDecode<GPUDevice, T, Twire>::operator()(                   \
+      const GPUDevice& d, bool accumulate,                                  \
+      typename TTypes<T>::ConstFlat value,                                  \
+      typename TTypes<Twire>::ConstFlat wire,                               \
+      typename TTypes<T>::Flat output);                                     \
+  extern template struct CollectiveDecode<GPUDevice, T, Twire>;
+
+DECLARE_GPU_SPEC(float, Eigen::half);
+DECLARE_GPU_SPEC(float, bfloat16);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, float, Eigen::half);
+REGISTER_KERNELS(GPU, float, bfloat16);
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#undef REGISTER_KERNELS
+
+}  // namespace tensorflow
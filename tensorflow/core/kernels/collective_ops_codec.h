@@ -0,0 +1,56 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_COLLECTIVE_OPS_CODEC_H_
+#define TENSORFLOW_CORE_KERNELS_COLLECTIVE_OPS_CODEC_H_
+// Functor definitions for the wire codecs of compressed collective
+// reductions, must be compilable by nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Converts a chunk of values to its wire format.
+template <typename Device, typename T, typename Twire>
+struct CollectiveEncode {
+  void operator()(const Device& d, typename TTypes<T>::ConstFlat value,
+                  typename TTypes<Twire>::Flat wire) {
+    wire.device(d) = value.template cast<Twire>();
+  }
+};
+
+// Converts a chunk back from its wire format.  If `accumulate` is set the
+// decoded values are added to `value`, so that decoding and reduction take a
+// single pass over the chunk.
+template <typename Device, typename T, typename Twire>
+struct CollectiveDecode {
+  void operator()(const Device& d, bool accumulate,
+                  typename TTypes<T>::ConstFlat value,
+                  typename TTypes<Twire>::ConstFlat wire,
+                  typename TTypes<T>::Flat output) {
+    if (accumulate) {
+      output.device(d) = value + wire.template cast<T>();
+    } else {
+      output.device(d) = wire.template cast<T>();
+    }
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_COLLECTIVE_OPS_CODEC_H_
@@ -0,0 +1,448 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Curated benchmarks of the hottest TensorFlow CPU kernels at representative
+// production shapes, meant to track performance regressions across TensorFlow
+// versions. Unlike the per-kernel benchmarks next to each kernel's tests, the
+// set and names of the benchmarks in this file are kept stable, so that
+// results of different versions can be compared.
+//
+// Each benchmark writes its results through TestReporter. To get one JSON
+// file per benchmark in /tmp/baseline, set the environment variables
+//
+//   TEST_REPORT_FILE_PREFIX=/tmp/baseline/
+//   TEST_REPORT_FILE_FORMAT=json
+//
+// and run, e.g. with bazel run -c opt:
+//
+//   //tensorflow/core/kernels:core_kernels_benchmark_test -- --benchmarks=all
+//
+// Two such runs are compared with //tensorflow/tools/test:compare_benchmarks.
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+template <typename T>
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor tensor(DataTypeToEnum<T>::value, shape);
+  tensor.flat<T>().setRandom();
+  return tensor;
+}
+
+// MatMul of a [m, k] by a [k, n] matrix, e.g. a dense layer with batch size m.
+Graph* MatMul(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(
+      g, test::graph::Constant(g, RandomTensor<float>(TensorShape({m, k}))),
+      test::graph::Constant(g, RandomTensor<float>(TensorShape({k, n}))),
+      /*transpose_a=*/false, /*transpose_b=*/false);
+  return g;
+}
+
+#define BM_CoreMatMul(M, K, N)                                          \
+  void BM_Core_MatMul_##M##_##K##_##N(int iters) {                      \
+    testing::UseRealTime();                                             \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2); \
+    test::Benchmark("cpu", MatMul(M, K, N)).Run(iters);                 \
+  }                                                                     \
+  BENCHMARK(BM_Core_MatMul_##M##_##K##_##N);
+
+// Inference and training batches of dense layers.
+BM_CoreMatMul(1, 1024, 1024);
+BM_CoreMatMul(32, 1024, 1024);
+BM_CoreMatMul(128, 2048, 512);
+BM_CoreMatMul(512, 512, 512);
+BM_CoreMatMul(1024, 256, 1024);
+
+// NHWC Conv2D with 'SAME' padding and unit strides.
+Graph* Conv2D(int batch, int height, int width, int in_depth, int filter_size,
+              int out_depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Conv2D(
+      g,
+      test::graph::Constant(g, RandomTensor<float>(TensorShape(
+                                   {batch, height, width, in_depth}))),
+      test::graph::Constant(g, RandomTensor<float>(TensorShape(
+                                   {filter_size, filter_size, in_depth,
+                                    out_depth}))));
+  return g;
+}
+
+#define BM_CoreConv2D(N, H, W, C, FS, FC)                                    \
+  void BM_Core_Conv2D_##N##_##H##_##W##_##C##_##FS##_##FC(int iters) {       \
+    testing::UseRealTime();                                                  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N * H * W * C * FS * \
+                            FS * FC * 2);                                    \
+    test::Benchmark("cpu", Conv2D(N, H, W, C, FS, FC)).Run(iters);           \
+  }                                                                          \
+  BENCHMARK(BM_Core_Conv2D_##N##_##H##_##W##_##C##_##FS##_##FC);
+
+// ResNet-50 layers, at serving (1) and training (32) batch sizes.
+BM_CoreConv2D(1, 56, 56, 64, 3, 64);
+BM_CoreConv2D(1, 28, 28, 128, 3, 128);
+BM_CoreConv2D(1, 14, 14, 256, 3, 256);
+BM_CoreConv2D(1, 7, 7, 512, 3, 512);
+BM_CoreConv2D(32, 56, 56, 64, 3, 64);
+BM_CoreConv2D(32, 56, 56, 256, 1, 64);
+BM_CoreConv2D(32, 14, 14, 1024, 1, 256);
+
+// Embedding lookup of 'num_lookups' random rows of a [num_rows, dim] table.
+Graph* Gather(int num_rows, int dim, int num_lookups) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::mt19937 gen(301);
+  std::uniform_int_distribution<int32> dist(0, num_rows - 1);
+  Tensor indices(DT_INT32, TensorShape({num_lookups}));
+  auto indices_t = indices.flat<int32>();
+  for (int i = 0; i < num_lookups; ++i) indices_t(i) = dist(gen);
+  Tensor axis(DT_INT32, TensorShape({}));
+  axis.scalar<int32>()() = 0;
+
+  test::graph::Gather(
+      g,
+      test::graph::Constant(g,
+                            RandomTensor<float>(TensorShape({num_rows, dim}))),
+      test::graph::Constant(g, indices), test::graph::HostConstant(g, axis));
+  return g;
+}
+
+#define BM_CoreGather(R, D, L)                             \
+  void BM_Core_Gather_##R##_##D##_##L(int iters) {         \
+    const int64 items = static_cast<int64>(iters) * L * D; \
+    testing::UseRealTime();                                \
+    testing::ItemsProcessed(items);                        \
+    testing::BytesProcessed(items * sizeof(float));        \
+    test::Benchmark("cpu", Gather(R, D, L)).Run(iters);    \
+  }                                                        \
+  BENCHMARK(BM_Core_Gather_##R##_##D##_##L);
+
+BM_CoreGather(100000, 64, 4096);
+BM_CoreGather(100000, 256, 4096);
+BM_CoreGather(1000000, 32, 16384);
+
+// SegmentSum of a [num_rows, num_cols] matrix over sorted segments of
+// 'segment_size' rows.
+Graph* SegmentSum(int num_rows, int num_cols, int segment_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor segment_ids(DT_INT32, TensorShape({num_rows}));
+  auto segment_ids_t = segment_ids.flat<int32>();
+  for (int i = 0; i < num_rows; ++i) segment_ids_t(i) = i / segment_size;
+
+  Node* ret;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "SegmentSum")
+          .Input(test::graph::Constant(
+              g, RandomTensor<float>(TensorShape({num_rows, num_cols}))))
+          .Input(test::graph::Constant(g, segment_ids))
+          .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_CoreSegmentSum(R, C, S)                          \
+  void BM_Core_SegmentSum_##R##_##C##_##S(int iters) {      \
+    const int64 items = static_cast<int64>(iters) * R * C;  \
+    testing::UseRealTime();                                 \
+    testing::ItemsProcessed(items);                         \
+    testing::BytesProcessed(items * sizeof(float));         \
+    test::Benchmark("cpu", SegmentSum(R, C, S)).Run(iters); \
+  }                                                         \
+  BENCHMARK(BM_Core_SegmentSum_##R##_##C##_##S);
+
+BM_CoreSegmentSum(65536, 64, 8);
+BM_CoreSegmentSum(65536, 64, 128);
+BM_CoreSegmentSum(16384, 512, 16);
+
+// SparseTensorDenseMatMul of an [m, k] sparse matrix with 'nnz' random
+// non-zeros by a dense [k, n] matrix.
+Graph* SparseTensorDenseMatMul(int nnz, int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::mt19937 gen(301);
+  std::uniform_int_distribution<int64> row_dist(0, m - 1);
+  std::uniform_int_distribution<int64> col_dist(0, k - 1);
+  Tensor a_indices(DT_INT64, TensorShape({nnz, 2}));
+  auto a_indices_t = a_indices.matrix<int64>();
+  for (int i = 0; i < nnz; ++i) {
+    a_indices_t(i, 0) = row_dist(gen);
+    a_indices_t(i, 1) = col_dist(gen);
+  }
+  Tensor a_shape(DT_INT64, TensorShape({2}));
+  a_shape.vec<int64>()(0) = m;
+  a_shape.vec<int64>()(1) = k;
+
+  Node* ret;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "SparseTensorDenseMatMul")
+          .Input(test::graph::Constant(g, a_indices))
+          .Input(test::graph::Constant(
+              g, RandomTensor<float>(TensorShape({nnz}))))
+          .Input(test::graph::HostConstant(g, a_shape))
+          .Input(test::graph::Constant(
+              g, RandomTensor<float>(TensorShape({k, n}))))
+          .Attr("T", DT_FLOAT)
+          .Attr("adjoint_a", false)
+          .Attr("adjoint_b", false)
+          .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_CoreSparseTensorDenseMatMul(NNZ, M, K, N)                          \
+  void BM_Core_SparseTensorDenseMatMul_##NNZ##_##M##_##K##_##N(               \
+      int iters) {                                                            \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * NNZ * N);             \
+    test::Benchmark("cpu", SparseTensorDenseMatMul(NNZ, M, K, N)).Run(iters); \
+  }                                                                           \
+  BENCHMARK(BM_Core_SparseTensorDenseMatMul_##NNZ##_##M##_##K##_##N);
+
+// Sparse features (e.g. bag of words) times embedding or weight matrices.
+BM_CoreSparseTensorDenseMatMul(4096, 256, 100000, 64);
+BM_CoreSparseTensorDenseMatMul(65536, 4096, 4096, 64);
+BM_CoreSparseTensorDenseMatMul(16384, 512, 1000000, 32);
+
+// ParseExample of a batch of serialized Examples, each with 'num_dense' dense
+// float features and 'num_sparse' sparse int64 features of 'feature_size'
+// values.
+Graph* ParseExample(int batch_size, int num_dense, int num_sparse,
+                    int feature_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Example example;
+  auto* features = example.mutable_features()->mutable_feature();
+  for (int i = 0; i < num_dense; ++i) {
+    auto* values = (*features)[strings::Printf("dense_%d", i)]
+                       .mutable_float_list()
+                       ->mutable_value();
+    for (int j = 0; j < feature_size; ++j) values->Add(j * 0.5f);
+  }
+  for (int i = 0; i < num_sparse; ++i) {
+    auto* values = (*features)[strings::Printf("sparse_%d", i)]
+                       .mutable_int64_list()
+                       ->mutable_value();
+    for (int j = 0; j < feature_size; ++j) values->Add(j * 7919);
+  }
+  Tensor serialized(DT_STRING, TensorShape({batch_size}));
+  const string serialized_example = example.SerializeAsString();
+  for (int i = 0; i < batch_size; ++i) {
+    serialized.flat<tstring>()(i) = serialized_example;
+  }
+
+  std::vector<NodeBuilder::NodeOut> sparse_keys;
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<DataType> sparse_types;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int i = 0; i < num_dense; ++i) {
+    Tensor key(DT_STRING, TensorShape());
+    key.scalar<tstring>()() = strings::Printf("dense_%d", i);
+    dense_keys.emplace_back(test::graph::Constant(g, key));
+    dense_defaults.emplace_back(
+        test::graph::Constant(g, Tensor(DT_FLOAT, TensorShape({0}))));
+    dense_shapes.push_back(PartialTensorShape({feature_size}));
+  }
+  for (int i = 0; i < num_sparse; ++i) {
+    Tensor key(DT_STRING, TensorShape());
+    key.scalar<tstring>()() = strings::Printf("sparse_%d", i);
+    sparse_keys.emplace_back(test::graph::Constant(g, key));
+    sparse_types.push_back(DT_INT64);
+  }
+
+  Node* ret;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "ParseExample")
+          .Input(test::graph::Constant(g, serialized))
+          .Input(test::graph::Constant(g, Tensor(DT_STRING, TensorShape({0}))))
+          .Input(sparse_keys)
+          .Input(dense_keys)
+          .Input(dense_defaults)
+          .Attr("sparse_types", sparse_types)
+          .Attr("dense_shapes", dense_shapes)
+          .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_CoreParseExample(B, D, S, F)                                   \
+  void BM_Core_ParseExample_##B##_##D##_##S##_##F(int iters) {            \
+    testing::UseRealTime();                                               \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * (D + S) * F); \
+    test::Benchmark("cpu", ParseExample(B, D, S, F), nullptr, nullptr,    \
+                    nullptr, "SINGLE_THREADED_EXECUTOR")                  \
+        .Run(iters);                                                      \
+  }                                                                       \
+  BENCHMARK(BM_Core_ParseExample_##B##_##D##_##S##_##F);
+
+// Typical ranking and recommendation inputs.
+BM_CoreParseExample(128, 20, 20, 1);
+BM_CoreParseExample(128, 10, 10, 16);
+BM_CoreParseExample(1024, 40, 10, 1);
+
+// tf.data pipelines are set up by the init graph, which creates an iterator
+// over the dataset. Each run of the benchmark graph then fetches one element.
+constexpr char kIteratorName[] = "core_kernels_benchmark_iterator";
+
+Node* Iterator(Graph* g, const DataTypeVector& output_types,
+               const std::vector<PartialTensorShape>& output_shapes) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("iterator"), "IteratorV2")
+                  .Attr("shared_name", kIteratorName)
+                  .Attr("container", "")
+                  .Attr("output_types", output_types)
+                  .Attr("output_shapes", output_shapes)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+// Returns the init graph, which creates an iterator over 'dataset' in 'init'.
+Graph* MakeIterator(Graph* init, Node* dataset,
+                    const DataTypeVector& output_types,
+                    const std::vector<PartialTensorShape>& output_shapes) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(init->NewName("make_iterator"), "MakeIterator")
+                  .Input(dataset)
+                  .Input(Iterator(init, output_types, output_shapes))
+                  .Finalize(init, &ret));
+  return init;
+}
+
+// Returns the benchmark graph, which fetches the next element of the iterator.
+Graph* IteratorGetNext(const FunctionDefLibrary& library,
+                       const DataTypeVector& output_types,
+                       const std::vector<PartialTensorShape>& output_shapes) {
+  Graph* g = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(g->AddFunctionLibrary(library));
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("get_next"), "IteratorGetNext")
+                  .Input(Iterator(g, output_types, output_shapes))
+                  .Attr("output_types", output_types)
+                  .Attr("output_shapes", output_shapes)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+// An infinite dataset of int64 scalars.
+Node* RangeDataset(Graph* g) {
+  Tensor start(DT_INT64, TensorShape({}));
+  start.scalar<int64>()() = 0;
+  Tensor stop(DT_INT64, TensorShape({}));
+  stop.scalar<int64>()() = std::numeric_limits<int64>::max();
+  Tensor step(DT_INT64, TensorShape({}));
+  step.scalar<int64>()() = 1;
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("range"), "RangeDataset")
+                  .Input(test::graph::HostConstant(g, start))
+                  .Input(test::graph::HostConstant(g, stop))
+                  .Input(test::graph::HostConstant(g, step))
+                  .Attr("output_types", DataTypeVector({DT_INT64}))
+                  .Attr("output_shapes",
+                        std::vector<PartialTensorShape>({{}}))
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+// range.batch(batch_size, drop_remainder=True)
+void BM_Core_DataBatch(int iters, int batch_size) {
+  testing::StopTiming();
+  const DataTypeVector output_types({DT_INT64});
+  const std::vector<PartialTensorShape> output_shapes(
+      {PartialTensorShape({batch_size})});
+  Graph* init = new Graph(OpRegistry::Global());
+  Tensor batch_size_t(DT_INT64, TensorShape({}));
+  batch_size_t.scalar<int64>()() = batch_size;
+  Tensor drop_remainder(DT_BOOL, TensorShape({}));
+  drop_remainder.scalar<bool>()() = true;
+  Node* batch;
+  TF_CHECK_OK(NodeBuilder(init->NewName("batch"), "BatchDatasetV2")
+                  .Input(RangeDataset(init))
+                  .Input(test::graph::HostConstant(init, batch_size_t))
+                  .Input(test::graph::HostConstant(init, drop_remainder))
+                  .Attr("output_types", output_types)
+                  .Attr("output_shapes", output_shapes)
+                  .Finalize(init, &batch));
+
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch_size);
+  test::Benchmark(
+      "cpu", IteratorGetNext(FunctionDefLibrary(), output_types, output_shapes),
+      nullptr, MakeIterator(init, batch, output_types, output_shapes))
+      .Run(iters);
+}
+BENCHMARK(BM_Core_DataBatch)->Arg(32)->Arg(256)->Arg(4096);
+
+// range.map(lambda x: x * 2).batch(batch_size, drop_remainder=True), which
+// measures the per-element overhead of running the map function.
+void BM_Core_DataMapAndBatch(int iters, int batch_size) {
+  testing::StopTiming();
+  FunctionDefLibrary library;
+  *library.add_function() = test::function::XTimesTwo();
+  const DataTypeVector output_types({DT_INT64});
+  const std::vector<PartialTensorShape> output_shapes(
+      {PartialTensorShape({batch_size})});
+  Graph* init = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(init->AddFunctionLibrary(library));
+
+  NameAttrList map_fn;
+  map_fn.set_name("XTimesTwo");
+  (*map_fn.mutable_attr())["T"].set_type(DT_INT64);
+  Node* map;
+  TF_CHECK_OK(NodeBuilder(init->NewName("map"), "MapDataset")
+                  .Input(RangeDataset(init))
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Attr("f", map_fn)
+                  .Attr("Targuments", DataTypeVector())
+                  .Attr("output_types", output_types)
+                  .Attr("output_shapes",
+                        std::vector<PartialTensorShape>({{}}))
+                  .Finalize(init, &map));
+  Tensor batch_size_t(DT_INT64, TensorShape({}));
+  batch_size_t.scalar<int64>()() = batch_size;
+  Tensor drop_remainder(DT_BOOL, TensorShape({}));
+  drop_remainder.scalar<bool>()() = true;
+  Node* batch;
+  TF_CHECK_OK(NodeBuilder(init->NewName("batch"), "BatchDatasetV2")
+                  .Input(map)
+                  .Input(test::graph::HostConstant(init, batch_size_t))
+                  .Input(test::graph::HostConstant(init, drop_remainder))
+                  .Attr("output_types", output_types)
+                  .Attr("output_shapes", output_shapes)
+                  .Finalize(init, &batch));
+
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch_size);
+  test::Benchmark("cpu",
+                  IteratorGetNext(library, output_types, output_shapes),
+                  nullptr, MakeIterator(init, batch, output_types,
+                                        output_shapes))
+      .Run(iters);
+}
+BENCHMARK(BM_Core_DataMapAndBatch)->Arg(32)->Arg(256);
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #include <algorithm>
 #include <utility>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -44,6 +45,9 @@ namespace data {
 
 constexpr char kInputImplEmpty[] = "input_impl_empty";
 constexpr char kBatchDataset[] = "BatchDataset";
+// The minimum number of bytes of a component copied by one task when
+// `parallel_copy` is set.
+constexpr int64 kMinBytesPerShard = 64 << 10;
 
 class BatchDatasetOp::Dataset : public DatasetBase {
  public:
@@ -199,67 +203,7 @@ class BatchDatasetOp::Dataset : public DatasetBase {
       // respective slice locations. This would require a different GetNext()
       // overload that supports zero-copy, and might make sense in an
       // optimization pass.
-      const size_t num_tuple_components = batch_elements[0].size();
-      out_tensors->reserve(num_tuple_components);
-      const int64 num_batch_elements = batch_elements.size();
-      for (size_t component_index = 0; component_index < num_tuple_components;
-           ++component_index) {
-        const Tensor& first_element = batch_elements[0][component_index];
-        TensorShape batch_component_shape({num_batch_elements});
-        // NOTE(mrry): Copy the shape of the first element here, because
-        // `first_element.shape()` will become undefined after the 0th batch
-        // element is moved into the output batch.
-        TensorShape first_element_shape(first_element.shape());
-        batch_component_shape.AppendShape(first_element_shape);
-        out_tensors->emplace_back(ctx->allocator({}), first_element.dtype(),
-                                  batch_component_shape);
-        if (!out_tensors->back().IsInitialized()) {
-          return errors::ResourceExhausted(
-              "Failed to allocate memory for the batch of component ",
-              component_index);
-        }
-        Tensor& batch_component = out_tensors->back();
-        // Build the output tuple component by copying one slice
-        // from each input element in the batch.
-        auto copy_element_fn = [component_index, &batch_elements,
-                                &batch_component](int index) {
-          TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
-              std::move(batch_elements[index][component_index]),
-              &batch_component, index));
-          return Status::OK();
-        };
-        BlockingCounter counter(num_batch_elements);
-        Status status;
-        mutex status_mu;
-        for (size_t i = 0; i < num_batch_elements; ++i) {
-          if (batch_elements[i][component_index].shape() !=
-              first_element_shape) {
-            return errors::InvalidArgument(
-                "Cannot batch tensors with different shapes in "
-                "component ",
-                component_index, ". First element had shape ",
-                first_element_shape.DebugString(), " and element ", i,
-                " had shape ",
-                batch_elements[i][component_index].shape().DebugString(), ".");
-          }
-          if (TF_PREDICT_FALSE(dataset()->parallel_copy_)) {
-            (*ctx->runner())(
-                [i, &status, &status_mu, &counter, &copy_element_fn]() {
-                  Status s = copy_element_fn(i);
-                  {
-                    mutex_lock l(status_mu);
-                    status.Update(s);
-                  }
-                  counter.DecrementCount();
-                });
-          } else {
-            status.Update(copy_element_fn(i));
-            counter.DecrementCount();
-          }
-        }
-        counter.Wait();
-        TF_RETURN_IF_ERROR(status);
-      }
+      TF_RETURN_IF_ERROR(CopyBatch(ctx, &batch_elements, out_tensors));
       *end_of_sequence = false;
       return Status::OK();
     }
@@ -296,6 +240,107 @@ class BatchDatasetOp::Dataset : public DatasetBase {
       return dataset()->traceme_metadata_;
     }
 
+   private:
+    // A range of the elements of one component of a batch, copied by one
+    // task.
+    struct CopyShard {
+      size_t component_index;
+      int64 begin;
+      int64 end;
+    };
+
+    // Copies `batch_elements` into one tensor per tuple component. Each
+    // component is copied column by column, in ranges of elements, so that
+    // the per-element overhead of the copy is paid once per range. If
+    // `parallel_copy` is set, the ranges of all the components are copied
+    // concurrently on the runner of `ctx`.
+    Status CopyBatch(IteratorContext* ctx,
+                     std::vector<std::vector<Tensor>>* batch_elements,
+                     std::vector<Tensor>* out_tensors) {
+      const size_t num_tuple_components = (*batch_elements)[0].size();
+      const int64 num_batch_elements = batch_elements->size();
+      out_tensors->reserve(num_tuple_components);
+      // `columns[c][i]` is component `c` of the `i`th batch element.
+      std::vector<std::vector<Tensor*>> columns(num_tuple_components);
+      std::vector<CopyShard> shards;
+      for (size_t component_index = 0; component_index < num_tuple_components;
+           ++component_index) {
+        const Tensor& first_element = (*batch_elements)[0][component_index];
+        const TensorShape& first_element_shape = first_element.shape();
+        std::vector<Tensor*>& column = columns[component_index];
+        column.reserve(num_batch_elements);
+        for (int64 i = 0; i < num_batch_elements; ++i) {
+          Tensor* element = &(*batch_elements)[i][component_index];
+          if (element->shape() != first_element_shape) {
+            return errors::InvalidArgument(
+                "Cannot batch tensors with different shapes in "
+                "component ",
+                component_index, ". First element had shape ",
+                first_element_shape.DebugString(), " and element ", i,
+                " had shape ", element->shape().DebugString(), ".");
+          }
+          column.push_back(element);
+        }
+        TensorShape batch_component_shape({num_batch_elements});
+        batch_component_shape.AppendShape(first_element_shape);
+        out_tensors->emplace_back(ctx->allocator({}), first_element.dtype(),
+                                  batch_component_shape);
+        if (!out_tensors->back().IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate memory for the batch of component ",
+              component_index);
+        }
+
+        int64 num_shards = 1;
+        if (TF_PREDICT_FALSE(dataset()->parallel_copy_)) {
+          // Give each task at least `kMinBytesPerShard`, so that batches of
+          // small elements are not split into many tiny tasks.
+          const int64 bytes = first_element.TotalBytes() * num_batch_elements;
+          num_shards = std::max<int64>(
+              1, std::min<int64>({num_batch_elements, bytes / kMinBytesPerShard,
+                                  ctx->runner_threadpool_size()}));
+        }
+        for (int64 shard = 0; shard < num_shards; ++shard) {
+          shards.push_back({component_index,
+                            num_batch_elements * shard / num_shards,
+                            num_batch_elements * (shard + 1) / num_shards});
+        }
+      }
+
+      auto copy_shard_fn = [&columns, out_tensors](const CopyShard& shard) {
+        const std::vector<Tensor*>& column = columns[shard.component_index];
+        return batch_util::CopyElementsToSlices(
+            absl::MakeConstSpan(column.data() + shard.begin,
+                                shard.end - shard.begin),
+            &(*out_tensors)[shard.component_index], shard.begin);
+      };
+      Status status;
+      if (!dataset()->parallel_copy_ || shards.size() == 1) {
+        for (const CopyShard& shard : shards) {
+          status.Update(copy_shard_fn(shard));
+        }
+      } else {
+        BlockingCounter counter(shards.size() - 1);
+        mutex status_mu;
+        for (size_t i = 1; i < shards.size(); ++i) {
+          (*ctx->runner())([&shard = shards[i], &status, &status_mu, &counter,
+                            &copy_shard_fn]() {
+            Status s = copy_shard_fn(shard);
+            {
+              mutex_lock l(status_mu);
+              status.Update(s);
+            }
+            counter.DecrementCount();
+          });
+        }
+        // The calling thread copies the first shard itself.
+        Status s = copy_shard_fn(shards[0]);
+        counter.Wait();
+        status.Update(s);
+      }
+      return status;
+    }
+
    private:
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
@@ -11,6 +11,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/batch_dataset_op.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 
 namespace tensorflow {
@@ -105,7 +108,39 @@ BatchDatasetParams BatchDatasetParams7() {
                             /*node_name=*/kNodeName);
 }
 
-// Test Case 8: test BatchDatasetV2 with an invalid batch size
+// Test Case 8: test BatchDatasetV2 with `parallel_copy` = true and a tuple of
+// string and non-scalar components.
+BatchDatasetParams BatchDatasetParams8() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<tstring>(TensorShape{5},
+                                            {"a", "b", "c", "d", "e"}),
+                      CreateTensor<int64>(TensorShape{5, 2},
+                                          {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})},
+      /*node_name=*/"tensor_slice");
+  return BatchDatasetParams(std::move(tensor_slice_dataset_params),
+                            /*batch_size=*/2,
+                            /*drop_remainder=*/false,
+                            /*parallel_copy=*/true,
+                            /*output_dtypes=*/{DT_STRING, DT_INT64},
+                            /*output_shapes=*/
+                            {PartialTensorShape({-1}),
+                             PartialTensorShape({-1, 2})},
+                            /*node_name=*/kNodeName);
+}
+
+// Test Case 9: test BatchDatasetV2 with `parallel_copy` = true and batches
+// that are large enough to be copied by several tasks.
+BatchDatasetParams BatchDatasetParams9() {
+  return BatchDatasetParams(RangeDatasetParams(0, 50000, 1),
+                            /*batch_size=*/20000,
+                            /*drop_remainder=*/false,
+                            /*parallel_copy=*/true,
+                            /*output_dtypes=*/{DT_INT64},
+                            /*output_shapes=*/{PartialTensorShape({-1})},
+                            /*node_name=*/kNodeName);
+}
+
+// Test Case 10: test BatchDatasetV2 with an invalid batch size
 BatchDatasetParams InvalidBatchSizeBatchDatasetParams() {
   return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
                             /*batch_size=*/-1,
@@ -143,12 +178,34 @@ std::vector<GetNextTestCase<BatchDatasetParams>> GetNextTestCases() {
                                 {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}})},
 
           {/*dataset_params=*/BatchDatasetParams7(),
-           /*expected_outputs=*/{}}};
+           /*expected_outputs=*/{}},
+          {/*dataset_params=*/BatchDatasetParams8(),
+           /*expected_outputs=*/
+           {CreateTensor<tstring>(TensorShape({2}), {"a", "b"}),
+            CreateTensor<int64>(TensorShape({2, 2}), {0, 1, 2, 3}),
+            CreateTensor<tstring>(TensorShape({2}), {"c", "d"}),
+            CreateTensor<int64>(TensorShape({2, 2}), {4, 5, 6, 7}),
+            CreateTensor<tstring>(TensorShape({1}), {"e"}),
+            CreateTensor<int64>(TensorShape({1, 2}), {8, 9})}}};
 }
 
 ITERATOR_GET_NEXT_TEST_P(BatchDatasetOpTest, BatchDatasetParams,
                          GetNextTestCases())
 
+TEST_F(BatchDatasetOpTest, LargeBatchesWithParallelCopy) {
+  auto batch_dataset_params = BatchDatasetParams9();
+  TF_ASSERT_OK(Initialize(batch_dataset_params));
+  std::vector<Tensor> expected_outputs;
+  for (int64 begin = 0; begin < 50000; begin += 20000) {
+    const int64 end = std::min<int64>(begin + 20000, 50000);
+    std::vector<int64> values(end - begin);
+    std::iota(values.begin(), values.end(), begin);
+    expected_outputs.push_back(
+        CreateTensor<int64>(TensorShape({end - begin}), values));
+  }
+  TF_ASSERT_OK(CheckIteratorGetNext(expected_outputs, /*compare_order=*/true));
+}
+
 TEST_F(BatchDatasetOpTest, DatasetNodeName) {
   auto batch_dataset_params = BatchDatasetParams1();
   TF_ASSERT_OK(Initialize(batch_dataset_params));
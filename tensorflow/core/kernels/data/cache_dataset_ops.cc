@@ -724,8 +724,10 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       if (cache_->IsCompleted()) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheCompleted), ""));
+        std::vector<std::vector<Tensor>> elements;
+        TF_RETURN_IF_ERROR(cache_->GetAll(&elements));
         TF_RETURN_IF_ERROR(
-            WriteElementsToCheckpoint(writer, prefix(), cache_->data()));
+            WriteElementsToCheckpoint(writer, prefix(), elements));
       }
       return SaveInput(ctx, writer, iterator_);
     }
@@ -739,7 +741,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         std::vector<std::vector<Tensor>> temp_cache;
         TF_RETURN_IF_ERROR(
             ReadElementsFromCheckpoint(reader, prefix(), &temp_cache));
-        cache_->Complete(std::move(temp_cache));
+        TF_RETURN_IF_ERROR(cache_->Complete(std::move(temp_cache)));
       }
       TF_RETURN_IF_ERROR(InitializeIterator(ctx));
       return RestoreInput(ctx, reader, iterator_);
@@ -749,11 +751,13 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
     class MemoryWriterIterator : public DatasetIterator<MemoryDatasetBase> {
      public:
       explicit MemoryWriterIterator(const Params& params, MemoryCache* cache)
-          : DatasetIterator<MemoryDatasetBase>(params), cache_(cache) {}
+          : DatasetIterator<MemoryDatasetBase>(params),
+            cache_(cache),
+            temp_cache_(cache->NewElements()) {}
 
       ~MemoryWriterIterator() override {
         mutex_lock l(mu_);
-        if (!temp_cache_.empty() && !cache_->IsCompleted()) {
+        if (temp_cache_->size() > 0 && !cache_->IsCompleted()) {
           LOG(WARNING)
               << "The calling iterator did not fully read the dataset being "
                  "cached. In order to avoid unexpected truncation of the "
@@ -779,16 +783,16 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           if (!cache_->IsCompleted()) {
             VLOG(2) << "Finalizing the cache because EOF has been reached.";
-            cache_->Complete(std::move(temp_cache_));
+            TF_RETURN_IF_ERROR(CompleteCache());
           }
           return Status::OK();
         }
         RecordBufferEnqueue(ctx, *out_tensors);
-        temp_cache_.emplace_back(*out_tensors);
-        if (temp_cache_.size() == dataset()->input_->Cardinality()) {
+        TF_RETURN_IF_ERROR(temp_cache_->Append(*out_tensors));
+        if (temp_cache_->size() == dataset()->input_->Cardinality()) {
           VLOG(2) << "Finalizing the cache because its size matches the "
                      "expected input cardinality.";
-          cache_->Complete(std::move(temp_cache_));
+          TF_RETURN_IF_ERROR(CompleteCache());
         }
         return Status::OK();
       }
@@ -804,8 +808,10 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                           IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
         if (!cache_->IsCompleted()) {
+          std::vector<std::vector<Tensor>> elements;
+          TF_RETURN_IF_ERROR(temp_cache_->GetAll(&elements));
           TF_RETURN_IF_ERROR(
-              WriteElementsToCheckpoint(writer, prefix(), temp_cache_));
+              WriteElementsToCheckpoint(writer, prefix(), elements));
         }
         return SaveInput(ctx, writer, input_impl_);
       }
@@ -814,17 +820,31 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                              IteratorStateReader* reader) override {
         mutex_lock l(mu_);
         if (!reader->Contains(full_name(kCacheCompleted))) {
+          std::vector<std::vector<Tensor>> elements;
           TF_RETURN_IF_ERROR(
-              ReadElementsFromCheckpoint(reader, prefix(), &temp_cache_));
+              ReadElementsFromCheckpoint(reader, prefix(), &elements));
+          temp_cache_ = cache_->NewElements();
+          for (const std::vector<Tensor>& element : elements) {
+            TF_RETURN_IF_ERROR(temp_cache_->Append(element));
+          }
         }
         return RestoreInput(ctx, reader, input_impl_);
       }
 
      private:
+      // Hands the elements over to the cache.
+      Status CompleteCache() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        std::unique_ptr<CachedElements> elements = std::move(temp_cache_);
+        temp_cache_ = cache_->NewElements();
+        return cache_->Complete(std::move(elements));
+      }
+
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
-      std::vector<std::vector<Tensor>> temp_cache_ TF_GUARDED_BY(mu_);
+      // The elements written so far, of which the ones that exceed the memory
+      // budget of the cache are spilled.
+      std::unique_ptr<CachedElements> temp_cache_ TF_GUARDED_BY(mu_);
     };  // MemoryWriterIterator
 
     class MemoryReaderIterator : public DatasetIterator<MemoryDatasetBase> {
@@ -840,9 +860,13 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         // thus we record the memory allocated for the cache here. The caveat
         // is that this is incorrect if there are concurrent instances of this
         // iterator.
+        // Spilled elements are not accounted for, since they are not in
+        // memory.
         tf_shared_lock l(mu_);
-        for (size_t i = 0; i < cache_->size(); ++i) {
-          RecordBufferEnqueue(ctx, cache_->at(i));
+        std::vector<Tensor> element;
+        for (size_t i = 0; i < cache_->num_in_memory(); ++i) {
+          TF_RETURN_IF_ERROR(cache_->Get(i, &element));
+          RecordBufferEnqueue(ctx, element);
         }
         return Status::OK();
       }
@@ -852,7 +876,8 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         if (index_ < cache_->size()) {
-          const std::vector<Tensor>& cache_tensors = cache_->at(index_);
+          std::vector<Tensor> cache_tensors;
+          TF_RETURN_IF_ERROR(cache_->Get(index_, &cache_tensors));
           out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
                               cache_tensors.end());
           index_++;
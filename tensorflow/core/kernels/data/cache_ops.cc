@@ -14,14 +14,20 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_ops.h"
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -33,12 +39,194 @@ constexpr char kMemoryCache[] = "MemoryCache";
 
 string MemoryCacheManager::DebugString() const { return kMemoryCache; }
 
-void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
+CachedElements::CachedElements(int64 memory_budget_bytes, string spill_dir)
+    : memory_budget_bytes_(memory_budget_bytes),
+      spill_dir_(std::move(spill_dir)) {}
+
+CachedElements::~CachedElements() {
+  spill_file_.reset();
+  spill_region_.reset();
+  spill_reader_.reset();
+  if (!spill_filename_.empty()) {
+    Status s = Env::Default()->DeleteFile(spill_filename_);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete " << spill_filename_ << ": " << s;
+    }
+  }
+}
+
+Status CachedElements::Append(const std::vector<Tensor>& element) {
+  int64 element_bytes = 0;
+  for (const Tensor& t : element) {
+    element_bytes += t.TotalBytes();
+  }
+  // Once an element is spilled, the following ones are too, so that the
+  // elements in memory are always the first ones.
+  if (memory_budget_bytes_ <= 0 ||
+      (spilled_offsets_.empty() &&
+       memory_bytes_ + element_bytes <= memory_budget_bytes_)) {
+    in_memory_.push_back(element);
+    memory_bytes_ += element_bytes;
+    return Status::OK();
+  }
+  return Spill(element);
+}
+
+Status CachedElements::Spill(const std::vector<Tensor>& element) {
+  if (spill_file_ == nullptr) {
+    if (!spill_filename_.empty()) {
+      return errors::FailedPrecondition(
+          "Cannot append elements to a finalized cache");
+    }
+    string dir = spill_dir_;
+    if (dir.empty()) {
+      std::vector<string> dirs;
+      Env::Default()->GetLocalTempDirectories(&dirs);
+      if (dirs.empty()) {
+        return errors::Unavailable(
+            "No local directory to spill the cache to; set "
+            "TF_DATA_MEMORY_CACHE_SPILL_DIR");
+      }
+      dir = dirs[0];
+    }
+    TF_RETURN_IF_ERROR(Env::Default()->RecursivelyCreateDir(dir));
+    spill_filename_ =
+        io::JoinPath(dir, strings::StrCat("tf_data_cache_", random::New64(),
+                                          ".spill"));
+    TF_RETURN_IF_ERROR(
+        Env::Default()->NewWritableFile(spill_filename_, &spill_file_));
+    VLOG(1) << "Spilling the elements of the memory cache after "
+            << in_memory_.size() << " to " << spill_filename_;
+  }
+  spilled_offsets_.push_back(spill_bytes_);
+  string header;
+  core::PutFixed32(&header, element.size());
+  TF_RETURN_IF_ERROR(spill_file_->Append(header));
+  spill_bytes_ += header.size();
+  for (const Tensor& t : element) {
+    TensorProto proto;
+    t.AsProtoTensorContent(&proto);
+    const string serialized = proto.SerializeAsString();
+    string size;
+    core::PutFixed64(&size, serialized.size());
+    TF_RETURN_IF_ERROR(spill_file_->Append(size));
+    TF_RETURN_IF_ERROR(spill_file_->Append(serialized));
+    spill_bytes_ += size.size() + serialized.size();
+  }
+  return Status::OK();
+}
+
+Status CachedElements::Finalize() {
+  if (spill_file_ == nullptr) return Status::OK();
+  TF_RETURN_IF_ERROR(spill_file_->Close());
+  spill_file_.reset();
+  Status s = Env::Default()->NewReadOnlyMemoryRegionFromFile(spill_filename_,
+                                                             &spill_region_);
+  if (!s.ok()) {
+    VLOG(1) << "Could not map " << spill_filename_
+            << ", reading it instead: " << s;
+    TF_RETURN_IF_ERROR(
+        Env::Default()->NewRandomAccessFile(spill_filename_, &spill_reader_));
+  }
+  return Status::OK();
+}
+
+Status CachedElements::Get(size_t index, std::vector<Tensor>* element) const {
+  if (index < in_memory_.size()) {
+    *element = in_memory_[index];
+    return Status::OK();
+  }
+  if (index >= size()) {
+    return errors::OutOfRange("Index ", index, " is out of the ", size(),
+                              " cached elements");
+  }
+  return ReadSpilled(index - in_memory_.size(), element);
+}
+
+Status CachedElements::ReadSpilled(size_t index,
+                                   std::vector<Tensor>* element) const {
+  // Elements that are not finalized yet, e.g. checkpointed while the cache is
+  // written, are read through a new reader.
+  std::unique_ptr<RandomAccessFile> reader;
+  const RandomAccessFile* spill_reader = spill_reader_.get();
+  if (spill_region_ == nullptr && spill_reader == nullptr) {
+    TF_RETURN_IF_ERROR(spill_file_->Flush());
+    TF_RETURN_IF_ERROR(
+        Env::Default()->NewRandomAccessFile(spill_filename_, &reader));
+    spill_reader = reader.get();
+  }
+  const uint64 begin = spilled_offsets_[index];
+  const uint64 end = index + 1 < spilled_offsets_.size()
+                         ? spilled_offsets_[index + 1]
+                         : spill_bytes_;
+  const uint64 length = end - begin;
+  string buffer;
+  StringPiece data;
+  if (spill_region_ != nullptr) {
+    data = StringPiece(static_cast<const char*>(spill_region_->data()) + begin,
+                       length);
+  } else {
+    buffer.resize(length);
+    TF_RETURN_IF_ERROR(spill_reader->Read(begin, length, &data, &buffer[0]));
+    if (data.size() != length) {
+      return errors::DataLoss("Truncated spill file ", spill_filename_);
+    }
+  }
+
+  auto corrupted = [this]() {
+    return errors::DataLoss("Corrupted spill file ", spill_filename_);
+  };
+  if (data.size() < sizeof(uint32)) return corrupted();
+  const uint32 num_components = core::DecodeFixed32(data.data());
+  data.remove_prefix(sizeof(uint32));
+  element->clear();
+  element->reserve(num_components);
+  for (uint32 i = 0; i < num_components; ++i) {
+    if (data.size() < sizeof(uint64)) return corrupted();
+    const uint64 size = core::DecodeFixed64(data.data());
+    data.remove_prefix(sizeof(uint64));
+    if (data.size() < size) return corrupted();
+    TensorProto proto;
+    if (!proto.ParseFromArray(data.data(), size)) return corrupted();
+    data.remove_prefix(size);
+    element->emplace_back();
+    if (!element->back().FromProto(proto)) return corrupted();
+  }
+  return Status::OK();
+}
+
+Status CachedElements::GetAll(
+    std::vector<std::vector<Tensor>>* elements) const {
+  elements->clear();
+  elements->reserve(size());
+  for (size_t i = 0; i < size(); ++i) {
+    elements->emplace_back();
+    TF_RETURN_IF_ERROR(Get(i, &elements->back()));
+  }
+  return Status::OK();
+}
+
+std::unique_ptr<CachedElements> MemoryCache::NewElements() const {
+  return absl::make_unique<CachedElements>(memory_budget_bytes_, spill_dir_);
+}
+
+Status MemoryCache::Complete(std::unique_ptr<CachedElements> elements) {
+  TF_RETURN_IF_ERROR(elements->Finalize());
   mutex_lock l(mu_);
   if (!completed_) {
-    cache_ = std::move(cache);
+    cache_ = std::move(elements);
     completed_ = true;
   }
+  return Status::OK();
+}
+
+Status MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
+  std::unique_ptr<CachedElements> elements = NewElements();
+  for (const std::vector<Tensor>& element : cache) {
+    TF_RETURN_IF_ERROR(elements->Append(element));
+  }
+  cache.clear();
+  return Complete(std::move(elements));
 }
 
 bool MemoryCache::IsCompleted() {
@@ -49,23 +237,49 @@ bool MemoryCache::IsCompleted() {
 void MemoryCache::Reset() {
   mutex_lock l(mu_);
   completed_ = false;
-  cache_.clear();
+  cache_.reset();
 }
 
-const std::vector<Tensor>& MemoryCache::at(int64 index) {
+Status MemoryCache::Get(int64 index, std::vector<Tensor>* element) {
   tf_shared_lock l(mu_);
-  DCHECK(index < cache_.size());
-  return cache_[index];
+  if (cache_ == nullptr) {
+    return errors::FailedPrecondition("The cache is not completed");
+  }
+  return cache_->Get(index, element);
 }
 
 size_t MemoryCache::size() {
   tf_shared_lock l(mu_);
-  return cache_.size();
+  return cache_ == nullptr ? 0 : cache_->size();
+}
+
+size_t MemoryCache::num_in_memory() {
+  tf_shared_lock l(mu_);
+  return cache_ == nullptr ? 0 : cache_->num_in_memory();
 }
 
-const std::vector<std::vector<Tensor>>& MemoryCache::data() {
+Status MemoryCache::GetAll(std::vector<std::vector<Tensor>>* elements) {
   tf_shared_lock l(mu_);
-  return cache_;
+  if (cache_ == nullptr) {
+    elements->clear();
+    return Status::OK();
+  }
+  return cache_->GetAll(elements);
+}
+
+MemoryCacheManager::MemoryCacheManager() {
+  int64 memory_budget_mb = 0;
+  Status s = ReadInt64FromEnvVar("TF_DATA_MEMORY_CACHE_BUDGET_MB", 0,
+                                 &memory_budget_mb);
+  if (!s.ok()) {
+    LOG(ERROR) << "MemoryCacheManager: " << s.error_message();
+  }
+  string spill_dir;
+  s = ReadStringFromEnvVar("TF_DATA_MEMORY_CACHE_SPILL_DIR", "", &spill_dir);
+  if (!s.ok()) {
+    LOG(ERROR) << "MemoryCacheManager: " << s.error_message();
+  }
+  cache_ = std::make_shared<MemoryCache>(memory_budget_mb << 20, spill_dir);
 }
 
 AnonymousMemoryCacheHandleOp::AnonymousMemoryCacheHandleOp(
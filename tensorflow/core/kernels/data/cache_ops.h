@@ -16,23 +16,100 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/platform/file_system.h"
 
 namespace tensorflow {
 namespace data {
 
+// The elements of a memory cache. The first elements are kept in memory, up
+// to a budget, and the following ones are spilled to a local file, which is
+// memory-mapped once all elements have been appended.
+//
+// Each spilled element is stored as its number of components, followed by
+// the size and the serialized `TensorProto` of each component.
+//
+// `Append()` and `Finalize()` must be called by a single thread; `Get()` may
+// be called concurrently once the elements are finalized.
+class CachedElements {
+ public:
+  // A `memory_budget_bytes` of 0 means that all elements are kept in memory.
+  CachedElements(int64 memory_budget_bytes, string spill_dir);
+  ~CachedElements();
+
+  // Appends `element`, which is spilled if it does not fit in the budget.
+  Status Append(const std::vector<Tensor>& element);
+
+  // Marks the end of the elements, and maps the spilled elements for reading.
+  Status Finalize();
+
+  // Returns the number of elements.
+  size_t size() const {
+    return in_memory_.size() + spilled_offsets_.size();
+  }
+
+  // Returns the number of elements kept in memory, which are the first ones.
+  size_t num_in_memory() const { return in_memory_.size(); }
+
+  // Returns the element at `index`. Spilled elements must be finalized.
+  Status Get(size_t index, std::vector<Tensor>* element) const;
+
+  // Returns all the elements, e.g. to checkpoint them. Spilled elements are
+  // read back into memory.
+  Status GetAll(std::vector<std::vector<Tensor>>* elements) const;
+
+ private:
+  Status Spill(const std::vector<Tensor>& element);
+  Status ReadSpilled(size_t index, std::vector<Tensor>* element) const;
+
+  const int64 memory_budget_bytes_;
+  const string spill_dir_;
+  int64 memory_bytes_ = 0;
+  std::vector<std::vector<Tensor>> in_memory_;
+
+  // The spill file. `spill_file_` is only set while elements are appended,
+  // and `spill_region_` (or `spill_reader_` if the file cannot be mapped)
+  // once they are finalized.
+  string spill_filename_;
+  std::unique_ptr<WritableFile> spill_file_;
+  std::unique_ptr<ReadOnlyMemoryRegion> spill_region_;
+  std::unique_ptr<RandomAccessFile> spill_reader_;
+  uint64 spill_bytes_ = 0;
+  // The offset of each spilled element in the spill file.
+  std::vector<uint64> spilled_offsets_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CachedElements);
+};
+
 // A thread-safe data structure for caching dataset elements.
 //
 // The expected use is that a single `MemoryWriterIterator` populates the
 // cache with dataset elements. Once all elements are cached, the cache can
 // be used by one or more `MemoryReaderIterator`s.
+//
+// The elements that exceed the memory budget of the cache, if any, are
+// spilled to a local file (see `CachedElements`).
 class MemoryCache {
  public:
   MemoryCache() = default;
 
+  // A `memory_budget_bytes` of 0 means that the cache is unbounded.
+  MemoryCache(int64 memory_budget_bytes, string spill_dir)
+      : memory_budget_bytes_(memory_budget_bytes),
+        spill_dir_(std::move(spill_dir)) {}
+
+  // Returns an empty list of elements with the budget of the cache, to be
+  // populated and passed to `Complete()`.
+  std::unique_ptr<CachedElements> NewElements() const;
+
   // Marks the cache as completed.
-  void Complete(std::vector<std::vector<Tensor>>&& cache);
+  Status Complete(std::unique_ptr<CachedElements> elements);
+  Status Complete(std::vector<std::vector<Tensor>>&& cache);
 
   // Returns whether the cache is completed.
   bool IsCompleted();
@@ -41,26 +118,36 @@ class MemoryCache {
   void Reset();
 
   // Returns the element at the given index.
-  const std::vector<Tensor>& at(int64 index);
+  Status Get(int64 index, std::vector<Tensor>* element);
 
   // Returns the size of the cache.
   size_t size();
 
-  // Returns a reference to the cache's data. The returned reference will be
-  // invalidated by any call to Reset().
-  const std::vector<std::vector<Tensor>>& data();
+  // Returns the number of elements of the cache that are kept in memory.
+  size_t num_in_memory();
+
+  // Returns all the elements of the cache.
+  Status GetAll(std::vector<std::vector<Tensor>>* elements);
 
  private:
+  const int64 memory_budget_bytes_ = 0;
+  const string spill_dir_;
+
   mutex mu_;
   // Determines whether all elements of the dataset have been cached.
   bool completed_ TF_GUARDED_BY(mu_) = false;
-  std::vector<std::vector<Tensor>> cache_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<CachedElements> cache_ TF_GUARDED_BY(mu_);
 };
 
 // A resource wrapping a shared instance of a memory cache.
+//
+// The memory budget of the cache, in MB, is read from the
+// TF_DATA_MEMORY_CACHE_BUDGET_MB environment variable, and the elements that
+// exceed it are spilled to TF_DATA_MEMORY_CACHE_SPILL_DIR, or to a local
+// temporary directory. By default, the cache is unbounded.
 class MemoryCacheManager : public ResourceBase {
  public:
-  MemoryCacheManager() : cache_(std::make_shared<MemoryCache>()) {}
+  MemoryCacheManager();
 
   string DebugString() const override;
 
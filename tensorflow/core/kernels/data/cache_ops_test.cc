@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/cache_ops.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::vector<Tensor> MakeElement(int64 i) {
+  return {test::AsTensor<int64>({i, i + 1, i + 2, i + 3}),
+          test::AsTensor<tstring>({strings::StrCat("element_", i)})};
+}
+
+void ExpectElement(int64 i, const std::vector<Tensor>& element) {
+  std::vector<Tensor> expected = MakeElement(i);
+  ASSERT_EQ(expected.size(), element.size());
+  test::ExpectTensorEqual<int64>(expected[0], element[0]);
+  test::ExpectTensorEqual<tstring>(expected[1], element[1]);
+}
+
+int NumFiles(const string& dir) {
+  std::vector<string> children;
+  TF_CHECK_OK(Env::Default()->GetChildren(dir, &children));
+  return children.size();
+}
+
+TEST(CachedElementsTest, KeepsEverythingInMemoryWithoutBudget) {
+  CachedElements elements(/*memory_budget_bytes=*/0, /*spill_dir=*/"");
+  for (int64 i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(elements.Append(MakeElement(i)));
+  }
+  TF_ASSERT_OK(elements.Finalize());
+  EXPECT_EQ(10, elements.size());
+  EXPECT_EQ(10, elements.num_in_memory());
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(elements.Get(7, &element));
+  ExpectElement(7, element);
+  EXPECT_TRUE(errors::IsOutOfRange(elements.Get(10, &element)));
+}
+
+TEST(CachedElementsTest, SpillsBeyondTheBudget) {
+  const string dir = io::JoinPath(testing::TmpDir(), "spills_beyond_budget");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  const int64 element_bytes = MakeElement(0)[0].TotalBytes() +
+                              MakeElement(0)[1].TotalBytes();
+  {
+    CachedElements elements(/*memory_budget_bytes=*/3 * element_bytes, dir);
+    for (int64 i = 0; i < 10; ++i) {
+      TF_ASSERT_OK(elements.Append(MakeElement(i)));
+    }
+    EXPECT_EQ(10, elements.size());
+    EXPECT_EQ(3, elements.num_in_memory());
+    EXPECT_EQ(1, NumFiles(dir));
+
+    // The spilled elements can be read before finalization, e.g. to
+    // checkpoint them.
+    std::vector<std::vector<Tensor>> all;
+    TF_ASSERT_OK(elements.GetAll(&all));
+    ASSERT_EQ(10, all.size());
+    ExpectElement(9, all[9]);
+
+    TF_ASSERT_OK(elements.Finalize());
+    for (int64 i = 9; i >= 0; --i) {
+      std::vector<Tensor> element;
+      TF_ASSERT_OK(elements.Get(i, &element));
+      ExpectElement(i, element);
+    }
+  }
+  // The spill file is deleted with the elements.
+  EXPECT_EQ(0, NumFiles(dir));
+}
+
+TEST(MemoryCacheTest, CompleteAndReset) {
+  const string dir = io::JoinPath(testing::TmpDir(), "complete_and_reset");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  MemoryCache cache(/*memory_budget_bytes=*/1, dir);
+  std::unique_ptr<CachedElements> elements = cache.NewElements();
+  for (int64 i = 0; i < 5; ++i) {
+    TF_ASSERT_OK(elements->Append(MakeElement(i)));
+  }
+  EXPECT_FALSE(cache.IsCompleted());
+  TF_ASSERT_OK(cache.Complete(std::move(elements)));
+  EXPECT_TRUE(cache.IsCompleted());
+  EXPECT_EQ(5, cache.size());
+  EXPECT_EQ(0, cache.num_in_memory());
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(cache.Get(4, &element));
+  ExpectElement(4, element);
+
+  cache.Reset();
+  EXPECT_FALSE(cache.IsCompleted());
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(0, NumFiles(dir));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/time/clock.h"
+#include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -45,6 +46,7 @@ namespace data {
 namespace {
 
 const char kDataServiceDataset[] = "DataServiceDataset";
+const char kJitCompiledSuffix[] = "_jit_compiled";
 
 // Simplistic implementation of the `StepStatsCollectorInterface` that only
 // cares about collecting the CPU time needed to execute a captured function.
@@ -238,6 +240,59 @@ Status CreateFunctionLibraryDefinition(
   return (*result)->CopyFunctionDefFrom(func_name, *lib_def);
 }
 
+// Adds to `lib_def` a function with the signature of `func` whose single node
+// calls `func` with the `_XlaMustCompile` attribute, and returns the wrapper in
+// `jit_func`. When the XLA JIT is linked in, the function library runtime
+// creates an XLA launch kernel for that node, which compiles `func` once per
+// input signature; otherwise the node runs `func` as a regular function call.
+Status CreateJitCompiledFunction(const NameAttrList& func,
+                                 FunctionLibraryDefinition* lib_def,
+                                 NameAttrList* jit_func) {
+  const FunctionDef* fdef;
+  TF_RETURN_IF_ERROR(LookupFunction(*lib_def, func.name(), &fdef));
+  for (const auto& arg : fdef->signature().output_arg()) {
+    if (!arg.number_attr().empty() || !arg.type_list_attr().empty()) {
+      return errors::Unimplemented(
+          "JIT compilation of function ", func.name(),
+          " with a vector output ", arg.name(), " is not supported.");
+    }
+  }
+
+  // Keep the call node through function inlining, which would otherwise
+  // replace it with the body of `func`.
+  FunctionDef noinline_fdef = *fdef;
+  (*noinline_fdef.mutable_attr())[kNoInlineAttr].set_b(true);
+
+  FunctionDef jit_fdef;
+  OpDef* signature = jit_fdef.mutable_signature();
+  *signature = fdef->signature();
+  signature->set_name(strings::StrCat(func.name(), kJitCompiledSuffix));
+  signature->clear_control_output();
+  NodeDef* call = jit_fdef.add_node_def();
+  call->set_name("xla_call");
+  call->set_op(func.name());
+  // The wrapper has the attributes of `func` and forwards them to the call.
+  for (const auto& attr : signature->attr()) {
+    (*call->mutable_attr())[attr.name()].set_placeholder(attr.name());
+  }
+  (*call->mutable_attr())[kXlaMustCompileAttr].set_b(true);
+  for (const auto& arg : signature->input_arg()) {
+    call->add_input(arg.name());
+  }
+  for (const auto& arg : signature->output_arg()) {
+    (*jit_fdef.mutable_ret())[arg.name()] =
+        strings::StrCat(call->name(), ":", arg.name(), ":0");
+  }
+
+  TF_RETURN_IF_ERROR(lib_def->ReplaceFunction(func.name(), noinline_fdef));
+  if (!lib_def->Contains(signature->name())) {
+    TF_RETURN_IF_ERROR(lib_def->AddFunctionDef(jit_fdef));
+  }
+  *jit_func = func;
+  jit_func->set_name(signature->name());
+  return Status::OK();
+}
+
 Status IsFunctionStateful(const FunctionLibraryDefinition& library,
                           const FunctionDef& function_def) {
   if (!function_def.signature().is_stateful()) {
@@ -488,6 +543,15 @@ Status FunctionMetadata::Create(
       (*out_metadata)->func_.name(), &(*out_metadata)->lib_def_));
   TF_RETURN_IF_ERROR(CreateShortCircuitInfo(
       ctx, (*out_metadata)->func_, &(*out_metadata)->short_circuit_info_));
+  if ((*out_metadata)->jit_compile_) {
+    TF_RETURN_IF_ERROR(CreateJitCompiledFunction(
+        (*out_metadata)->func_, (*out_metadata)->lib_def_.get(),
+        &(*out_metadata)->instantiated_func_));
+    // The XLA launch kernel runs on the device of the function library
+    // runtime, so the function is not partitioned across devices.
+    (*out_metadata)->use_multi_device_function_ = false;
+    return Status::OK();
+  }
   const FunctionDef* fdef;
   TF_RETURN_IF_ERROR(LookupFunction(*(*out_metadata)->lib_def(),
                                     (*out_metadata)->func().name(), &fdef));
@@ -684,9 +748,9 @@ Status CapturedFunction::Instantiate(
   }
 
   FunctionLibraryRuntime::Handle f_handle;
+  const NameAttrList& func = metadata_->instantiated_func();
   TF_RETURN_IF_ERROR(ctx->function_handle_cache()->Instantiate(
-      metadata_->func().name(), AttrSlice(&metadata_->func().attr()), inst_opts,
-      &f_handle));
+      func.name(), AttrSlice(&func.attr()), inst_opts, &f_handle));
 
   DataTypeVector ret_types;
   TF_RETURN_IF_ERROR(lib->GetRetTypes(f_handle, &ret_types));
@@ -63,6 +63,7 @@ class FunctionMetadata {
   struct Params {
     bool use_inter_op_parallelism = true;
     bool use_default_device = true;
+    bool jit_compile = false;
   };
 
   // Creates a new instance of the `FunctionMetadata` class, fetching function
@@ -80,6 +81,12 @@ class FunctionMetadata {
   // Returns the named list of function arguments.
   const NameAttrList& func() const { return func_; }
 
+  // Returns the function to instantiate, which differs from `func()` when the
+  // function is compiled with XLA.
+  const NameAttrList& instantiated_func() const {
+    return jit_compile_ ? instantiated_func_ : func_;
+  }
+
   // Returns a borrowed pointer to the function library that contains the
   // transitive closure of definitions used by the function.
   const FunctionLibraryDefinition* lib_def() const { return lib_def_.get(); }
@@ -97,6 +104,9 @@ class FunctionMetadata {
   // function.
   bool use_inter_op_parallelism() const { return use_inter_op_parallelism_; }
 
+  // Indicates whether the function should be compiled with XLA.
+  bool jit_compile() const { return jit_compile_; }
+
   // Indicates whether the function should a multi-device function backend.
   bool use_multi_device_function() const { return use_multi_device_function_; }
 
@@ -104,13 +114,16 @@ class FunctionMetadata {
   FunctionMetadata(NameAttrList&& func, Params params)
       : func_(std::move(func)),
         use_default_device_(params.use_default_device),
-        use_inter_op_parallelism_(params.use_inter_op_parallelism) {}
+        use_inter_op_parallelism_(params.use_inter_op_parallelism),
+        jit_compile_(params.jit_compile) {}
 
   NameAttrList func_;
+  NameAttrList instantiated_func_;
   std::unique_ptr<FunctionLibraryDefinition> lib_def_ = nullptr;
   ShortCircuitInfo short_circuit_info_;
   bool use_default_device_ = true;
   bool use_inter_op_parallelism_ = true;
+  bool jit_compile_ = false;
   bool use_multi_device_function_ = true;
 };
 
@@ -175,6 +188,9 @@ class CapturedFunction {
     return metadata_->use_inter_op_parallelism();
   }
 
+  // Indicates whether the function should be compiled with XLA.
+  bool jit_compile() const { return metadata_->jit_compile(); }
+
  private:
   CapturedFunction(std::shared_ptr<const FunctionMetadata> metadata,
                    std::vector<Tensor> captured_inputs);
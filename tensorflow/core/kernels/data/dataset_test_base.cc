@@ -1031,7 +1031,8 @@ Status MapDatasetParams::GetAttributes(AttributeVector* attr_vector) const {
       {MapDatasetOp::kOutputShapes, output_shapes_},
       {MapDatasetOp::kOutputTypes, output_dtypes_},
       {MapDatasetOp::kUseInterOpParallelism, use_inter_op_parallelism_},
-      {MapDatasetOp::kPreserveCardinality, preserve_cardinality_}};
+      {MapDatasetOp::kPreserveCardinality, preserve_cardinality_},
+      {MapDatasetOp::kJitCompile, jit_compile_}};
   return Status::OK();
 }
 
@@ -247,7 +247,7 @@ class MapDatasetParams : public DatasetParams {
                    DataTypeVector type_arguments, DataTypeVector output_dtypes,
                    std::vector<PartialTensorShape> output_shapes,
                    bool use_inter_op_parallelism, bool preserve_cardinality,
-                   string node_name)
+                   string node_name, bool jit_compile = false)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         other_arguments_(std::move(other_arguments)),
@@ -255,7 +255,8 @@ class MapDatasetParams : public DatasetParams {
         func_lib_(std::move(func_lib)),
         type_arguments_(std::move(type_arguments)),
         use_inter_op_parallelism_(use_inter_op_parallelism),
-        preserve_cardinality_(preserve_cardinality) {
+        preserve_cardinality_(preserve_cardinality),
+        jit_compile_(jit_compile) {
     input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
     iterator_prefix_ =
         name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
@@ -279,6 +280,7 @@ class MapDatasetParams : public DatasetParams {
   DataTypeVector type_arguments_;
   bool use_inter_op_parallelism_;
   bool preserve_cardinality_;
+  bool jit_compile_;
 };
 
 // `TensorSliceDatasetParams` is a common dataset parameter type that are used
@@ -22,8 +22,20 @@ namespace tensorflow {
 namespace data {
 namespace experimental {
 
+/* static */ constexpr const char* const CompressElementOp::kCompression;
+
 CompressElementOp::CompressElementOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx) {}
+    : OpKernel(ctx) {
+  std::string compression;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kCompression, &compression));
+  if (compression == "none") {
+    compression_ = CompressedElement::UNCOMPRESSED;
+  } else if (compression == "gzip") {
+    compression_ = CompressedElement::GZIP;
+  } else {
+    compression_ = CompressedElement::SNAPPY;
+  }
+}
 
 void CompressElementOp::Compute(OpKernelContext* ctx) {
   std::vector<Tensor> components;
@@ -31,7 +43,7 @@ void CompressElementOp::Compute(OpKernelContext* ctx) {
     components.push_back(ctx->input(i));
   }
   CompressedElement compressed;
-  OP_REQUIRES_OK(ctx, CompressElement(components, &compressed));
+  OP_REQUIRES_OK(ctx, CompressElement(components, compression_, &compressed));
 
   Tensor* output;
   OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/experimental/data_service_dataset_op.h"
 
+#include <algorithm>
+#include <cmath>
 #include <map>
 #include <memory>
 #include <queue>
@@ -50,6 +52,8 @@ namespace data {
 /* static */ constexpr const char* const DataServiceDatasetOp::kAddress;
 /* static */ constexpr const char* const DataServiceDatasetOp::kProtocol;
 /* static */ constexpr const char* const DataServiceDatasetOp::kJobName;
+/* static */ constexpr const char* const DataServiceDatasetOp::kConsumerIndex;
+/* static */ constexpr const char* const DataServiceDatasetOp::kNumConsumers;
 /* static */ constexpr const char* const
     DataServiceDatasetOp::kMaxOutstandingRequests;
 /* static */ constexpr const char* const
@@ -65,6 +69,25 @@ const int64 kRetryTimeoutMicros = 1000LL * 1000 * 60 * 60;  // 60 minutes.
 // Default interval between task list refreshes.
 const int64 kDefaultTaskRefreshIntervalMs = 1000;  // 1 second.
 
+// The maximum number of elements fetched from a task by a single request.
+const int64 kMaxElementsPerRequest = 16;
+
+// Workers stop adding elements to a response once it reaches this size, so that
+// batching doesn't make individual responses arbitrarily large.
+const int64 kMaxBytesPerRequest = 64LL << 20;  // 64MB.
+
+// The weight of the latest observation in the moving averages used to size
+// requests.
+const double kLatencySmoothingFactor = 0.1;
+
+double UpdateMovingAverage(double average, double observation) {
+  if (average <= 0) {
+    return observation;
+  }
+  return (1 - kLatencySmoothingFactor) * average +
+         kLatencySmoothingFactor * observation;
+}
+
 }  // namespace
 
 // Dataset for reading data from the tf.data service non-deterministically.
@@ -77,6 +100,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
   Dataset(OpKernelContext* ctx, int64 dataset_id,
           ProcessingMode processing_mode, const std::string& address,
           const std::string& protocol, const std::string& job_name,
+          int64 consumer_index, int64 num_consumers,
           int64 max_outstanding_requests, int64 task_refresh_interval_ms,
           IterationCounter* iteration_counter, bool owns_resource,
           ResourceHandle iteration_counter_handle,
@@ -88,6 +112,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         address_(address),
         protocol_(protocol),
         job_name_(job_name),
+        consumer_index_(consumer_index),
+        num_consumers_(num_consumers),
         max_outstanding_requests_(max_outstanding_requests),
         task_refresh_interval_ms_(task_refresh_interval_ms),
         iteration_counter_(iteration_counter),
@@ -166,12 +192,20 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     b->BuildAttrValue(task_refresh_interval_ms_,
                       &task_refresh_interval_hint_ms);
 
+    AttrValue consumer_index;
+    b->BuildAttrValue(consumer_index_, &consumer_index);
+
+    AttrValue num_consumers;
+    b->BuildAttrValue(num_consumers_, &num_consumers);
+
     TF_RETURN_IF_ERROR(
         b->AddDataset(this,
                       {dataset_id, processing_mode, address, protocol, job_name,
                        max_outstanding_requests, iteration_counter_handle},
                       {std::make_pair(kTaskRefreshIntervalHintMs,
-                                      task_refresh_interval_hint_ms)},
+                                      task_refresh_interval_hint_ms),
+                       std::make_pair(kConsumerIndex, consumer_index),
+                       std::make_pair(kNumConsumers, num_consumers)},
                       output));
     return Status::OK();
   }
@@ -239,7 +273,9 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
             [&]() {
               return dispatcher_->GetOrCreateJob(
                   dataset()->dataset_id_, dataset()->processing_mode_,
-                  dataset()->job_name_, iterator_index_, job_client_id_);
+                  dataset()->job_name_, iterator_index_,
+                  std::max<int64>(dataset()->num_consumers_, 0),
+                  job_client_id_);
             },
             /*description=*/
             strings::StrCat("get or create job with dispatcher at ",
@@ -256,15 +292,18 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
                            bool* end_of_sequence) override {
       VLOG(3) << "Calling GetNext in data service dataset op";
       mutex_lock l(mu_);
-      if (!task_thread_manager_ && !cancelled_) {
-        task_thread_manager_ =
-            ctx->StartThread("task-thread-manager", [this, ctx]() {
-              TaskThreadManager(absl::make_unique<IteratorContext>(*ctx));
-            });
+      if (last_get_next_return_micros_ > 0) {
+        // The time the consumer spent on the previous element, which is how
+        // long it takes to consume an element when it doesn't have to wait.
+        avg_consumer_time_us_ = UpdateMovingAverage(
+            avg_consumer_time_us_,
+            std::max<int64>(
+                1, Env::Default()->NowMicros() - last_get_next_return_micros_));
       }
+      EnsureTaskThreadManagerStarted(ctx);
 
-      while (results_.empty() && !job_finished_ && !cancelled_ &&
-             status_.ok()) {
+      while (results_.empty() && !job_finished_ && !rounds_finished_ &&
+             !cancelled_ && status_.ok()) {
         get_next_cv_.wait(l);
       }
       if (cancelled_) {
@@ -282,6 +321,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       out_tensors->swap(results_.front());
       results_.pop();
       worker_thread_cv_.notify_one();
+      last_get_next_return_micros_ = Env::Default()->NowMicros();
 
       return Status::OK();
     }
@@ -401,6 +441,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
                                                 task_info.worker_address(),
                                                 std::move(worker)));
       }
+      // Wake up the round thread if it is waiting for tasks.
+      worker_thread_cv_.notify_all();
       if (dataset()->max_outstanding_requests_ == model::kAutotune) {
         // Adjust max_outstanding_requests to account for newly added tasks.
         max_outstanding_requests_ = tasks_.size();
@@ -409,6 +451,22 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
 
     void UpdateWorkerThreads(IteratorContext* ctx) LOCKS_EXCLUDED(mu_) {
       mutex_lock l(mu_);
+      if (ReadsInRounds()) {
+        // Rounds are read in order, so a single thread reads all of them.
+        if (num_running_worker_threads_ == 0 && !rounds_finished_) {
+          num_running_worker_threads_++;
+          auto done = [this]() {
+            mutex_lock l(mu_);
+            num_running_worker_threads_--;
+          };
+          worker_threads_.push_back(ctx->StartThread(
+              "tf-data-service-round_thread",
+              [this, done = std::move(done)]() {
+                RunRoundThread(std::move(done));
+              }));
+        }
+        return;
+      }
       while (num_running_worker_threads_ < max_outstanding_requests_) {
         num_running_worker_threads_++;
         outstanding_requests_++;
@@ -431,12 +489,14 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       });
       VLOG(1) << "Starting worker thread";
       std::shared_ptr<Task> task_to_process;
+      int64 num_elements = 0;
       while (true) {
         {
           mutex_lock l(mu_);
           if (task_to_process) {
             task_to_process->in_use = false;
             task_to_process = nullptr;
+            extra_reserved_elements_ -= num_elements - 1;
             worker_thread_cv_.notify_one();
           }
           outstanding_requests_--;
@@ -468,16 +528,27 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
             }
           }
           DCHECK(task_to_process != nullptr);
-          VLOG(3) << "Processing task " << task_to_process->task_id;
+          // `SpaceInBuffer()` held before this request was counted, so at
+          // least the request's own slot is free.
+          const int64 free_slots = MaxBufferedElements() - results_.size() -
+                                   outstanding_requests_ -
+                                   extra_reserved_elements_ + 1;
+          num_elements =
+              std::max<int64>(1, std::min(free_slots, ElementsPerRequest()));
+          extra_reserved_elements_ += num_elements - 1;
+          VLOG(3) << "Processing task " << task_to_process->task_id
+                  << " with up to " << num_elements << " elements";
         }
         int64 deadline_micros =
             Env::Default()->NowMicros() + kRetryTimeoutMicros;
-        Status s = GetElement(task_to_process.get(), deadline_micros);
+        Status s = GetElements(task_to_process.get(), num_elements,
+                               deadline_micros);
         if (!s.ok()) {
           mutex_lock l(mu_);
           VLOG(1) << "Failed to get element for task "
                   << task_to_process->task_id << ": " << s;
           task_to_process->in_use = false;
+          extra_reserved_elements_ -= num_elements - 1;
           status_ = s;
           get_next_cv_.notify_all();
           return;
@@ -485,21 +556,155 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
     }
 
-    // Gets an element from a task and adds the element to `results_`.
+    // Whether the job is read by several consumers in coordinated rounds, where
+    // every round gives each consumer one element from the same task.
+    bool ReadsInRounds() const { return dataset()->num_consumers_ > 0; }
+
+    // Starts the thread which keeps `tasks_` up to date.
+    void EnsureTaskThreadManagerStarted(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!task_thread_manager_ && !cancelled_) {
+        task_thread_manager_ =
+            ctx->StartThread("task-thread-manager", [this, ctx]() {
+              TaskThreadManager(absl::make_unique<IteratorContext>(*ctx));
+            });
+      }
+    }
+
+    // Reads the job in rounds, adding the elements to `results_` ahead of
+    // `GetNext`. Round `r` is served by the task at index `r % num_tasks` in
+    // the list of tasks sorted by task id, so that all consumers visit the
+    // tasks in the same order and each round produces exactly one element for
+    // every consumer. Tasks which have reached end_of_sequence are skipped,
+    // which all consumers agree on because a task ends at the same round for
+    // every consumer. Rounds which the task moved on from before this
+    // consumer read them are skipped as well.
+    void RunRoundThread(std::function<void()> done) {
+      auto cleanup = gtl::MakeCleanup([done = std::move(done)]() {
+        done();
+        VLOG(1) << "Round thread exiting";
+      });
+      VLOG(1) << "Starting round thread";
+      while (true) {
+        std::shared_ptr<Task> task;
+        int64 round;
+        {
+          mutex_lock l(mu_);
+          while (!cancelled_ && !job_finished_ &&
+                 (tasks_.empty() ||
+                  results_.size() >=
+                      std::max<int64>(1, MaxBufferedElements()))) {
+            worker_thread_cv_.wait(l);
+          }
+          if (cancelled_ || job_finished_) {
+            return;
+          }
+          if (finished_tasks_ == tasks_.size()) {
+            rounds_finished_ = true;
+            get_next_cv_.notify_all();
+            return;
+          }
+          std::vector<std::shared_ptr<Task>> sorted_tasks = tasks_;
+          std::sort(sorted_tasks.begin(), sorted_tasks.end(),
+                    [](const std::shared_ptr<Task>& a,
+                       const std::shared_ptr<Task>& b) {
+                      return a->task_id < b->task_id;
+                    });
+          round = round_++;
+          task = sorted_tasks[round % sorted_tasks.size()];
+          if (task->end_of_sequence) {
+            continue;
+          }
+        }
+        CompressedElement compressed;
+        bool task_end_of_sequence = false;
+        bool skipped = false;
+        int64 deadline_micros =
+            Env::Default()->NowMicros() + kRetryTimeoutMicros;
+        // Round requests are idempotent, so they are safe to retry.
+        Status s = grpc_util::Retry(
+            [&]() {
+              {
+                mutex_lock l(mu_);
+                if (cancelled_) {
+                  // Stop retrying. The round is dropped below.
+                  return Status::OK();
+                }
+              }
+              return task->worker->GetRoundElement(
+                  task->task_id, dataset()->consumer_index_, round, compressed,
+                  task_end_of_sequence, skipped);
+            },
+            /*description=*/
+            strings::StrCat("get round ", round, " from task ", task->task_id,
+                            " at ", task->address),
+            deadline_micros);
+        mutex_lock l(mu_);
+        if (cancelled_) {
+          return;
+        }
+        if (!s.ok()) {
+          VLOG(1) << "Failed to get round " << round << " for task "
+                  << task->task_id << ": " << s;
+          status_ = s;
+          get_next_cv_.notify_all();
+          return;
+        }
+        if (task_end_of_sequence) {
+          if (!task->end_of_sequence) {
+            task->end_of_sequence = true;
+            finished_tasks_++;
+          }
+          continue;
+        }
+        if (skipped) {
+          continue;
+        }
+        Tensor tensor(DT_VARIANT, TensorShape{});
+        tensor.scalar<Variant>()() = std::move(compressed);
+        results_.push({std::move(tensor)});
+        get_next_cv_.notify_one();
+      }
+    }
+
+    // Returns how many elements to request from a task at once: enough to keep
+    // the consumer busy for one round trip to the task, given that the other
+    // tasks are being read from in parallel.
+    int64 ElementsPerRequest() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (avg_request_latency_us_ <= 0 || avg_consumer_time_us_ <= 0) {
+        return 1;
+      }
+      const double elements_per_round_trip =
+          avg_request_latency_us_ /
+          (avg_consumer_time_us_ * std::max<size_t>(tasks_.size(), 1));
+      return std::min(
+          kMaxElementsPerRequest,
+          std::max<int64>(1, static_cast<int64>(
+                                 std::ceil(elements_per_round_trip))));
+    }
+
+    // Gets up to `num_elements` elements from a task in one request and adds
+    // them to `results_`.
     //
     // If the task reaches end_of_sequence or is cancelled (e.g. due to a
-    // worker dying), GetElement returns Status::OK() without adding to
-    // `results_`.
-    Status GetElement(Task* task, int64 deadline_micros)
+    // worker dying), GetElements returns Status::OK() after adding the
+    // elements produced before the end of the sequence, if any.
+    Status GetElements(Task* task, int64 num_elements, int64 deadline_micros)
         TF_LOCKS_EXCLUDED(mu_) {
-      VLOG(3) << "Getting an element for task id " << task->task_id;
+      VLOG(3) << "Getting " << num_elements << " elements for task id "
+              << task->task_id;
       tensorflow::profiler::TraceMe activity(
           "GetDataServiceElement", tensorflow::profiler::TraceMeLevel::kInfo);
-      CompressedElement compressed;
+      std::vector<CompressedElement> compressed;
       bool end_of_sequence;
+      int64 request_start_micros;
       for (int num_retries = 0;; ++num_retries) {
-        Status s = task->worker->GetElement(task->task_id, compressed,
-                                            end_of_sequence);
+        request_start_micros = Env::Default()->NowMicros();
+        Status s = num_elements == 1
+                       ? GetSingleElement(task, compressed, end_of_sequence)
+                       : task->worker->GetElements(
+                             task->task_id, num_elements, kMaxBytesPerRequest,
+                             compressed, end_of_sequence);
         if (s.ok()) {
           break;
         }
@@ -532,27 +737,62 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         Env::Default()->SleepForMicroseconds(backoff_until - now_micros);
       }
 
-      std::vector<Tensor> element;
-      if (!end_of_sequence) {
+      const int64 latency_us =
+          Env::Default()->NowMicros() - request_start_micros;
+      std::vector<std::vector<Tensor>> elements;
+      elements.reserve(compressed.size());
+      for (CompressedElement& element : compressed) {
         Tensor tensor(DT_VARIANT, TensorShape{});
-        tensor.scalar<Variant>()() = std::move(compressed);
-        element.push_back(tensor);
+        tensor.scalar<Variant>()() = std::move(element);
+        elements.push_back({std::move(tensor)});
       }
       mutex_lock l(mu_);
+      avg_request_latency_us_ =
+          UpdateMovingAverage(avg_request_latency_us_, latency_us);
+      for (std::vector<Tensor>& element : elements) {
+        results_.push(std::move(element));
+      }
+      if (!elements.empty()) {
+        get_next_cv_.notify_all();
+      }
       if (end_of_sequence) {
         task->end_of_sequence = true;
         finished_tasks_++;
         return Status::OK();
       }
-      results_.push(std::move(element));
-      get_next_cv_.notify_all();
-      VLOG(3) << "Got an element for task id " << task->task_id;
+      VLOG(3) << "Got " << elements.size() << " elements for task id "
+              << task->task_id;
       return Status::OK();
     }
 
+    // Fetches one element with the single-element RPC, which workers that
+    // predate `GetElements` also serve.
+    Status GetSingleElement(Task* task,
+                            std::vector<CompressedElement>& compressed,
+                            bool& end_of_sequence) TF_LOCKS_EXCLUDED(mu_) {
+      CompressedElement element;
+      TF_RETURN_IF_ERROR(
+          task->worker->GetElement(task->task_id, element, end_of_sequence));
+      if (!end_of_sequence) {
+        compressed.push_back(std::move(element));
+      }
+      return Status::OK();
+    }
+
+    // The number of elements which may be buffered or requested at the same
+    // time. When `max_outstanding_requests` is autotuned, every task gets a
+    // window of `ElementsPerRequest()` elements.
+    int64 MaxBufferedElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (dataset()->max_outstanding_requests_ == model::kAutotune) {
+        return max_outstanding_requests_ * ElementsPerRequest();
+      }
+      return max_outstanding_requests_;
+    }
+
     bool SpaceInBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-      return results_.size() + outstanding_requests_ <
-             max_outstanding_requests_;
+      return results_.size() + outstanding_requests_ +
+                 extra_reserved_elements_ <
+             MaxBufferedElements();
     }
 
     bool TaskAvailable() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -574,6 +814,17 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     // at the same time. This count includes both in-progress requests for
     // elements as well as completed requests which haven't yet been produced.
     int64 max_outstanding_requests_ TF_GUARDED_BY(mu_);
+    // Requests for more than one element reserve the additional elements here,
+    // so that they count against `max_outstanding_requests_` as well.
+    int64 extra_reserved_elements_ TF_GUARDED_BY(mu_) = 0;
+
+    // Moving average of the round trip time of element requests, in
+    // microseconds.
+    double avg_request_latency_us_ TF_GUARDED_BY(mu_) = 0;
+    // Moving average of the time the consumer spends between `GetNext` calls,
+    // in microseconds, and the time the last `GetNext` call returned.
+    double avg_consumer_time_us_ TF_GUARDED_BY(mu_) = 0;
+    int64 last_get_next_return_micros_ TF_GUARDED_BY(mu_) = 0;
 
     // The number of threads in `worker_threads_` which are still running.
     int64 num_running_worker_threads_ TF_GUARDED_BY(mu_) = 0;
@@ -581,6 +832,11 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     // The index of the next task in `tasks_` to read from.
     int64 next_task_index_ TF_GUARDED_BY(mu_) = 0;
 
+    // The next round to read when the job is read in rounds, and whether all
+    // tasks have reached end_of_sequence.
+    int64 round_ TF_GUARDED_BY(mu_) = 0;
+    bool rounds_finished_ TF_GUARDED_BY(mu_) = false;
+
     // The number tasks in the `tasks_` list that have reached end_of_sequence.
     int64 finished_tasks_ TF_GUARDED_BY(mu_) = 0;
 
@@ -607,6 +863,10 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
   const tstring address_;
   const tstring protocol_;
   const tstring job_name_;
+  // The index of this consumer and the number of consumers when the job is
+  // read in coordinated rounds, or -1 otherwise.
+  const int64 consumer_index_;
+  const int64 num_consumers_;
   const int64 max_outstanding_requests_;
   const int64 task_refresh_interval_ms_;
   IterationCounter* const iteration_counter_;  // Owned
@@ -624,6 +884,8 @@ DataServiceDatasetOp::DataServiceDatasetOp(OpKernelConstruction* ctx)
   if (task_refresh_interval_hint_ms_ == model::kAutotune) {
     task_refresh_interval_hint_ms_ = kDefaultTaskRefreshIntervalMs;
   }
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kConsumerIndex, &consumer_index_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kNumConsumers, &num_consumers_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
 }
@@ -653,6 +915,21 @@ void DataServiceDatasetOp::MakeDataset(OpKernelContext* ctx,
   tstring job_name;
   OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kJobName, &job_name));
 
+  if (num_consumers_ > 0) {
+    OP_REQUIRES(ctx, !job_name.empty(),
+                errors::InvalidArgument(
+                    "A job name must be provided when ", kNumConsumers,
+                    " is set, so that all consumers read the same job."));
+    OP_REQUIRES(ctx, consumer_index_ >= 0 && consumer_index_ < num_consumers_,
+                errors::InvalidArgument(kConsumerIndex, " must be in [0, ",
+                                        num_consumers_, "), but got ",
+                                        consumer_index_, "."));
+  } else {
+    OP_REQUIRES(ctx, consumer_index_ < 0,
+                errors::InvalidArgument(kConsumerIndex, " requires ",
+                                        kNumConsumers, " to be set."));
+  }
+
   int64 max_outstanding_requests;
   OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kMaxOutstandingRequests,
                                           &max_outstanding_requests));
@@ -694,7 +971,8 @@ void DataServiceDatasetOp::MakeDataset(OpKernelContext* ctx,
 
   *output =
       new Dataset(ctx, dataset_id, processing_mode, address, protocol, job_name,
-                  max_outstanding_requests, task_refresh_interval_hint_ms_,
+                  consumer_index_, num_consumers_, max_outstanding_requests,
+                  task_refresh_interval_hint_ms_,
                   iteration_counter, owns_resource, iteration_counter_handle,
                   output_types_, output_shapes_);
 }
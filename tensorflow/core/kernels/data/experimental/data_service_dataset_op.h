@@ -52,6 +52,8 @@ class DataServiceDatasetOp : public DatasetOpKernel {
   static constexpr const char* const kAddress = "address";
   static constexpr const char* const kProtocol = "protocol";
   static constexpr const char* const kJobName = "job_name";
+  static constexpr const char* const kConsumerIndex = "consumer_index";
+  static constexpr const char* const kNumConsumers = "num_consumers";
   static constexpr const char* const kMaxOutstandingRequests =
       "max_outstanding_requests";
   static constexpr const char* const kTaskRefreshIntervalHintMs =
@@ -69,6 +71,8 @@ class DataServiceDatasetOp : public DatasetOpKernel {
   class Dataset;
 
   int64 task_refresh_interval_hint_ms_;
+  int64 consumer_index_;
+  int64 num_consumers_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
 };
@@ -0,0 +1,284 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/global_shuffle_dataset_op.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Constants declared in global_shuffle_dataset_op.h and used both here and in
+// test cases.
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kDatasetType;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kInputDataset;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kSeed;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kSeed2;
+/* static */ constexpr const char* const
+    GlobalShuffleDatasetOp::kReshuffleEachIteration;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const GlobalShuffleDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kSeedKey[] = "seed";
+constexpr char kNextIndex[] = "next_index";
+
+// A pseudorandom permutation of `[0, size)`, computed one index at a time in
+// O(1) memory.
+//
+// The permutation is a balanced Feistel network over the smallest domain of
+// 2^(2k) indices that contains `[0, size)`. The indices it maps outside of
+// the range are mapped again ("cycle walking") until they fall in the range,
+// which takes fewer than four tries on average because the domain is less
+// than four times as large as the range.
+class RandomIndexPermutation {
+ public:
+  RandomIndexPermutation(uint64 seed, int64 size)
+      : size_(size),
+        half_bits_(std::max(1, (Log2Ceiling64(size) + 1) / 2)),
+        half_mask_((uint64{1} << half_bits_) - 1) {
+    for (uint64& key : keys_) {
+      key = Mix(seed);
+      seed = key;
+    }
+  }
+
+  // Returns the image of `index`, which must be in `[0, size)`.
+  int64 operator()(int64 index) const {
+    uint64 x = index;
+    do {
+      x = Encrypt(x);
+    } while (x >= static_cast<uint64>(size_));
+    return x;
+  }
+
+ private:
+  // Four rounds make the network a pseudorandom permutation.
+  static constexpr int kNumRounds = 4;
+
+  // The finalizer of SplitMix64.
+  static uint64 Mix(uint64 x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  uint64 Encrypt(uint64 x) const {
+    uint64 left = x >> half_bits_;
+    uint64 right = x & half_mask_;
+    for (uint64 key : keys_) {
+      const uint64 next_right = left ^ (Mix(right ^ key) & half_mask_);
+      left = right;
+      right = next_right;
+    }
+    return (left << half_bits_) | right;
+  }
+
+  int64 size_;
+  int half_bits_;
+  uint64 half_mask_;
+  uint64 keys_[kNumRounds];
+};
+
+}  // namespace
+
+class GlobalShuffleDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, std::pair<int64, int64> seeds,
+          bool reshuffle_each_iteration, const DatasetBase* input)
+      : DatasetBase(DatasetContext(ctx)),
+        seeds_(std::move(seeds)),
+        reshuffle_each_iteration_(reshuffle_each_iteration),
+        input_(input),
+        cardinality_(input->Cardinality()) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    uint64 seed = Hash64Combine(seeds_.first, seeds_.second);
+    if (reshuffle_each_iteration_) {
+      seed = Hash64Combine(seed, num_iterators_.fetch_add(1));
+    }
+    return absl::make_unique<Iterator>(
+        Iterator::Params{this,
+                         name_utils::IteratorPrefix(kDatasetType, prefix)},
+        seed);
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64 Cardinality() const override { return cardinality_; }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* seed = nullptr;
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.first, &seed));
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.second, &seed2));
+    AttrValue reshuffle_each_iteration;
+    b->BuildAttrValue(reshuffle_each_iteration_, &reshuffle_each_iteration);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {input_graph_node, seed, seed2},
+        {std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  // Reads the elements of the input dataset in the order of a random
+  // permutation of their indices. The state of the iterator is the seed of
+  // the permutation and the position in the permutation.
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    Iterator(const Params& params, uint64 seed)
+        : DatasetIterator<Dataset>(params),
+          seed_(seed),
+          permutation_(seed, dataset()->cardinality_) {}
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      int64 index;
+      {
+        mutex_lock l(mu_);
+        if (next_index_ >= dataset()->cardinality_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        index = permutation_(next_index_++);
+      }
+      *end_of_sequence = false;
+      return dataset()->input_->Get(ctx, index, out_tensors);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      // The seed is an uint64, and is stored bit for bit as an int64.
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kSeedKey),
+                                             static_cast<int64>(seed_)));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kNextIndex), next_index_));
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      int64 seed;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kSeedKey), &seed));
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kNextIndex), &next_index_));
+      seed_ = static_cast<uint64>(seed);
+      permutation_ = RandomIndexPermutation(seed_, dataset()->cardinality_);
+      return Status::OK();
+    }
+
+   private:
+    mutex mu_;
+    uint64 seed_ TF_GUARDED_BY(mu_);
+    RandomIndexPermutation permutation_ TF_GUARDED_BY(mu_);
+    int64 next_index_ TF_GUARDED_BY(mu_) = 0;
+  };
+
+  const std::pair<int64, int64> seeds_;
+  const bool reshuffle_each_iteration_;
+  const DatasetBase* const input_;
+  const int64 cardinality_;
+  // The number of iterators created so far, which makes the permutation of
+  // every iteration different if `reshuffle_each_iteration_` is set.
+  mutable std::atomic<int64> num_iterators_{0};
+};
+
+GlobalShuffleDatasetOp::GlobalShuffleDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReshuffleEachIteration,
+                                   &reshuffle_each_iteration_));
+}
+
+void GlobalShuffleDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                         DatasetBase* input,
+                                         DatasetBase** output) {
+  int64 seed;
+  int64 seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kSeed, &seed));
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kSeed2, &seed2));
+  OP_REQUIRES(ctx, input->SupportsRandomAccess(),
+              errors::InvalidArgument(
+                  "`global_shuffle` requires an input dataset that supports "
+                  "random access, but ",
+                  input->DebugString(), " does not."));
+  OP_REQUIRES(ctx, input->Cardinality() >= 0,
+              errors::InvalidArgument(
+                  "`global_shuffle` requires an input dataset with a known, "
+                  "finite cardinality, but the cardinality of ",
+                  input->DebugString(), " is ", input->Cardinality(), "."));
+
+  // The seeds are chosen here, rather than by each iterator, so that every
+  // iteration of a dataset without `reshuffle_each_iteration` produces the
+  // same order, and so that a serialized dataset keeps its seeds.
+  *output = new Dataset(ctx, MaybeOverrideSeeds({seed, seed2}),
+                        reshuffle_each_iteration_, input);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("GlobalShuffleDataset").Device(DEVICE_CPU),
+                        GlobalShuffleDatasetOp);
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,312 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/global_shuffle_dataset_op.h"
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "global_shuffle_dataset";
+constexpr int64 kRandomSeed = 42;
+constexpr int64 kRandomSeed2 = 7;
+
+class GlobalShuffleDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  GlobalShuffleDatasetParams(T input_dataset_params,
+                             bool reshuffle_each_iteration,
+                             DataTypeVector output_dtypes,
+                             std::vector<PartialTensorShape> output_shapes,
+                             string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        reshuffle_each_iteration_(reshuffle_each_iteration) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<int64>(TensorShape({}), {kRandomSeed}),
+            CreateTensor<int64>(TensorShape({}), {kRandomSeed2})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {GlobalShuffleDatasetOp::kInputDataset,
+                    GlobalShuffleDatasetOp::kSeed,
+                    GlobalShuffleDatasetOp::kSeed2};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{GlobalShuffleDatasetOp::kReshuffleEachIteration,
+                     reshuffle_each_iteration_},
+                    {GlobalShuffleDatasetOp::kOutputTypes, output_dtypes_},
+                    {GlobalShuffleDatasetOp::kOutputShapes, output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return GlobalShuffleDatasetOp::kDatasetType;
+  }
+
+ private:
+  bool reshuffle_each_iteration_;
+};
+
+class GlobalShuffleDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  // Creates a new iterator over `dataset_` and returns all of its elements.
+  Status Iterate(std::vector<Tensor>* outputs) {
+    std::unique_ptr<IteratorBase> iterator;
+    TF_RETURN_IF_ERROR(dataset_->MakeIterator(iterator_ctx_.get(),
+                                              /*parent=*/nullptr,
+                                              "Iterator", &iterator));
+    bool end_of_sequence = false;
+    while (!end_of_sequence) {
+      TF_RETURN_IF_ERROR(
+          iterator->GetNext(iterator_ctx_.get(), outputs, &end_of_sequence));
+    }
+    return Status::OK();
+  }
+};
+
+GlobalShuffleDatasetParams RangeShuffleParams() {
+  return GlobalShuffleDatasetParams(RangeDatasetParams(0, 10, 1),
+                                    /*reshuffle_each_iteration=*/false,
+                                    /*output_dtypes=*/{DT_INT64},
+                                    /*output_shapes=*/{PartialTensorShape({})},
+                                    /*node_name=*/kNodeName);
+}
+
+GlobalShuffleDatasetParams LargeRangeShuffleParams(
+    bool reshuffle_each_iteration) {
+  return GlobalShuffleDatasetParams(RangeDatasetParams(0, 1000, 1),
+                                    reshuffle_each_iteration,
+                                    /*output_dtypes=*/{DT_INT64},
+                                    /*output_shapes=*/{PartialTensorShape({})},
+                                    /*node_name=*/kNodeName);
+}
+
+GlobalShuffleDatasetParams TensorSliceShuffleParams() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64>(TensorShape({5, 2}),
+                                          {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}),
+                      CreateTensor<tstring>(TensorShape({5}),
+                                            {"a", "b", "c", "d", "e"})},
+      /*node_name=*/"tensor_slice");
+  return GlobalShuffleDatasetParams(
+      std::move(tensor_slice_dataset_params),
+      /*reshuffle_each_iteration=*/true,
+      /*output_dtypes=*/{DT_INT64, DT_STRING},
+      /*output_shapes=*/{PartialTensorShape({2}), PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+GlobalShuffleDatasetParams EmptyShuffleParams() {
+  return GlobalShuffleDatasetParams(RangeDatasetParams(0, 0, 1),
+                                    /*reshuffle_each_iteration=*/true,
+                                    /*output_dtypes=*/{DT_INT64},
+                                    /*output_shapes=*/{PartialTensorShape({})},
+                                    /*node_name=*/kNodeName);
+}
+
+GlobalShuffleDatasetParams NestedShuffleParams() {
+  return GlobalShuffleDatasetParams(RangeShuffleParams(),
+                                    /*reshuffle_each_iteration=*/true,
+                                    /*output_dtypes=*/{DT_INT64},
+                                    /*output_shapes=*/{PartialTensorShape({})},
+                                    /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> TensorSliceOutputs() {
+  return {CreateTensor<int64>(TensorShape({2}), {0, 1}),
+          CreateTensor<tstring>(TensorShape({}), {"a"}),
+          CreateTensor<int64>(TensorShape({2}), {2, 3}),
+          CreateTensor<tstring>(TensorShape({}), {"b"}),
+          CreateTensor<int64>(TensorShape({2}), {4, 5}),
+          CreateTensor<tstring>(TensorShape({}), {"c"}),
+          CreateTensor<int64>(TensorShape({2}), {6, 7}),
+          CreateTensor<tstring>(TensorShape({}), {"d"}),
+          CreateTensor<int64>(TensorShape({2}), {8, 9}),
+          CreateTensor<tstring>(TensorShape({}), {"e"})};
+}
+
+std::vector<GetNextTestCase<GlobalShuffleDatasetParams>> GetNextTestCases() {
+  return {{/*dataset_params=*/RangeShuffleParams(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(
+               TensorShape({}),
+               {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+           /*compare_order=*/false},
+          {/*dataset_params=*/EmptyShuffleParams(),
+           /*expected_outputs=*/{},
+           /*compare_order=*/false}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(GlobalShuffleDatasetOpTest,
+                         GlobalShuffleDatasetParams, GetNextTestCases())
+
+TEST_F(GlobalShuffleDatasetOpTest, TensorSliceInput) {
+  auto dataset_params = TensorSliceShuffleParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(Iterate(&outputs));
+  ASSERT_EQ(outputs.size(), 10);
+  // The components of each element stay together.
+  std::vector<Tensor> expected_outputs = TensorSliceOutputs();
+  for (int i = 0; i < outputs.size(); i += 2) {
+    const int64 first = outputs[i].vec<int64>()(0);
+    ASSERT_EQ(first % 2, 0);
+    TF_EXPECT_OK(ExpectEqual(outputs[i], expected_outputs[first]));
+    TF_EXPECT_OK(ExpectEqual(outputs[i + 1], expected_outputs[first + 1]));
+  }
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, ShufflesTheWholeDataset) {
+  auto dataset_params = LargeRangeShuffleParams(
+      /*reshuffle_each_iteration=*/false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(Iterate(&outputs));
+  ASSERT_EQ(outputs.size(), 1000);
+  // Elements from the end of the input appear early in the output, which a
+  // buffered shuffle with a small buffer would not produce.
+  int64 max_of_first_tenth = 0;
+  int64 num_in_place = 0;
+  for (int i = 0; i < outputs.size(); ++i) {
+    const int64 value = outputs[i].scalar<int64>()();
+    if (i < 100) max_of_first_tenth = std::max(max_of_first_tenth, value);
+    if (value == i) ++num_in_place;
+  }
+  EXPECT_GE(max_of_first_tenth, 900);
+  EXPECT_LT(num_in_place, 10);
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, SameOrderWithoutReshuffle) {
+  auto dataset_params = LargeRangeShuffleParams(
+      /*reshuffle_each_iteration=*/false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> first_outputs;
+  TF_ASSERT_OK(Iterate(&first_outputs));
+  std::vector<Tensor> second_outputs;
+  TF_ASSERT_OK(Iterate(&second_outputs));
+  TF_EXPECT_OK(ExpectEqual(first_outputs, second_outputs,
+                           /*compare_order=*/true));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, DifferentOrderWithReshuffle) {
+  auto dataset_params = LargeRangeShuffleParams(
+      /*reshuffle_each_iteration=*/true);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> first_outputs;
+  TF_ASSERT_OK(Iterate(&first_outputs));
+  std::vector<Tensor> second_outputs;
+  TF_ASSERT_OK(Iterate(&second_outputs));
+  EXPECT_FALSE(ExpectEqual(first_outputs, second_outputs,
+                           /*compare_order=*/true)
+                   .ok());
+  TF_EXPECT_OK(ExpectEqual(first_outputs, second_outputs,
+                           /*compare_order=*/false));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = RangeShuffleParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = RangeShuffleParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(GlobalShuffleDatasetOp::kDatasetType)));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = TensorSliceShuffleParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64, DT_STRING}));
+}
+
+TEST_F(GlobalShuffleDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = TensorSliceShuffleParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes(
+      {PartialTensorShape({2}), PartialTensorShape({})}));
+}
+
+std::vector<CardinalityTestCase<GlobalShuffleDatasetParams>>
+CardinalityTestCases() {
+  return {{/*dataset_params=*/RangeShuffleParams(),
+           /*expected_cardinality=*/10},
+          {/*dataset_params=*/TensorSliceShuffleParams(),
+           /*expected_cardinality=*/5},
+          {/*dataset_params=*/EmptyShuffleParams(),
+           /*expected_cardinality=*/0}};
+}
+
+DATASET_CARDINALITY_TEST_P(GlobalShuffleDatasetOpTest,
+                           GlobalShuffleDatasetParams, CardinalityTestCases())
+
+TEST_F(GlobalShuffleDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = RangeShuffleParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(
+      name_utils::IteratorPrefix(GlobalShuffleDatasetOp::kDatasetType,
+                                 dataset_params.iterator_prefix())));
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<GlobalShuffleDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/RangeShuffleParams(),
+           /*breakpoints=*/{0, 4, 11},
+           /*expected_outputs=*/
+           CreateTensors<int64>(
+               TensorShape({}),
+               {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+           /*compare_order=*/false},
+          {/*dataset_params=*/GlobalShuffleDatasetParams(
+               RangeDatasetParams(0, 10, 1),
+               /*reshuffle_each_iteration=*/true,
+               /*output_dtypes=*/{DT_INT64},
+               /*output_shapes=*/{PartialTensorShape({})},
+               /*node_name=*/kNodeName),
+           /*breakpoints=*/{0, 2, 6},
+           /*expected_outputs=*/
+           CreateTensors<int64>(
+               TensorShape({}),
+               {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+           /*compare_order=*/false}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(GlobalShuffleDatasetOpTest,
+                                 GlobalShuffleDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(GlobalShuffleDatasetOpTest, InputWithoutRandomAccess) {
+  auto dataset_params = NestedShuffleParams();
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -624,7 +624,24 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::WriteMetadataFile(
   tstring hash_directory =
       snapshot_util::HashDirectory(dataset()->path_, dataset()->hash_);
 
-  return snapshot_util::WriteMetadataFile(env, hash_directory, &metadata);
+  bool written;
+  TF_RETURN_IF_ERROR(snapshot_util::WriteMetadataFileUnlessFinalized(
+      env, hash_directory, &metadata, &written));
+  if (!written && finalized) {
+    // Another process has published its snapshot of the same dataset while
+    // this one was being written. Readers only ever read the published run, so
+    // the files of this run can be deleted.
+    LOG(INFO) << "Discarding snapshot run " << run_id_ << " in "
+              << hash_directory << " because another run has been finalized.";
+    int64 undeleted_files, undeleted_dirs;
+    Status s = env->DeleteRecursively(run_dir_, &undeleted_files,
+                                      &undeleted_dirs);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete snapshot run directory " << run_dir_
+                   << ": " << s;
+    }
+  }
+  return Status::OK();
 }
 
 Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::Initialize(
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include <algorithm>
+#include <numeric>
 #include <queue>
 
 #include "absl/memory/memory.h"
@@ -23,6 +25,8 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/io/block_gzip_inputstream.h"
+#include "tensorflow/core/lib/io/block_gzip_outputbuffer.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -44,6 +48,10 @@ namespace tensorflow {
 namespace data {
 namespace snapshot_util {
 
+/* static */ constexpr const int64 ColumnarWriter::kRowGroupSizeBytes;
+/* static */ constexpr const size_t ColumnarWriter::kHeaderSize;
+/* static */ constexpr const size_t ReadAheadFile::kDefaultBlockSizeBytes;
+/* static */ constexpr const int ReadAheadFile::kDefaultNumBlocks;
 /* static */ constexpr const int64
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64
@@ -92,6 +100,10 @@ Status Writer::Create(Env* env, const std::string& filename,
       *out_writer =
           absl::make_unique<TFRecordWriter>(filename, compression_type);
       break;
+    case 3:
+      *out_writer =
+          absl::make_unique<ColumnarWriter>(filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot writer version: ", version,
                                      " is not supported.");
@@ -305,6 +317,116 @@ Status CustomWriter::WriteRecord(const absl::Cord& data) {
 }
 #endif  // PLATFORM_GOOGLE
 
+ColumnarWriter::ColumnarWriter(const std::string& filename,
+                               const std::string& compression_type,
+                               const DataTypeVector& dtypes)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes),
+      chunks_(dtypes.size()) {}
+
+Status ColumnarWriter::Initialize(tensorflow::Env* env) {
+  if (compression_type_ != io::compression::kNone &&
+      compression_type_ != io::compression::kSnappy &&
+      compression_type_ != io::compression::kGzip) {
+    return errors::InvalidArgument(
+        "Columnar snapshots support no compression, snappy or gzip "
+        "compression, but got compression type ",
+        compression_type_);
+  }
+  return env->NewAppendableFile(filename_, &dest_);
+}
+
+Status ColumnarWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  if (tensors.size() != dtypes_.size()) {
+    return errors::InvalidArgument("Expected ", dtypes_.size(),
+                                   " tensors, but got ", tensors.size());
+  }
+  for (int i = 0; i < tensors.size(); ++i) {
+    TensorProto proto;
+    tensors[i].AsProtoTensorContent(&proto);
+    std::string& chunk = chunks_[i];
+    const size_t start = chunk.size();
+    const size_t proto_size = proto.ByteSizeLong();
+    chunk.resize(start + kHeaderSize + proto_size);
+    core::EncodeFixed64(&chunk[start], proto_size);
+    if (!proto.SerializeToArray(&chunk[start + kHeaderSize], proto_size)) {
+      return errors::Internal("Failed to serialize tensor proto.");
+    }
+    num_buffered_bytes_ += kHeaderSize + proto_size;
+  }
+  ++num_buffered_elements_;
+  if (num_buffered_bytes_ >= kRowGroupSizeBytes) {
+    return FlushRowGroup();
+  }
+  return Status::OK();
+}
+
+Status ColumnarWriter::FlushRowGroup() {
+  if (num_buffered_elements_ == 0) {
+    return Status::OK();
+  }
+  experimental::SnapshotRowGroup row_group;
+  row_group.set_num_elements(num_buffered_elements_);
+  for (std::string& chunk : chunks_) {
+    experimental::SnapshotRowGroup::Chunk* chunk_info =
+        row_group.add_chunks();
+    std::string compressed;
+    bool compressed_ok = false;
+    if (compression_type_ == io::compression::kSnappy) {
+      compressed_ok =
+          port::Snappy_Compress(chunk.data(), chunk.size(), &compressed);
+    } else if (compression_type_ == io::compression::kGzip) {
+      compressed_ok = io::BlockGzipOutputBuffer::CompressBlock(
+                          chunk, io::ZlibCompressionOptions::GZIP(),
+                          &compressed)
+                          .ok();
+    }
+    // Chunks which compression doesn't make smaller are stored uncompressed,
+    // so that reading them doesn't pay for decompression.
+    if (compressed_ok && compressed.size() < chunk.size()) {
+      chunk.swap(compressed);
+      chunk_info->set_compression(compression_type_);
+    }
+    chunk_info->set_size_bytes(chunk.size());
+  }
+  std::string header;
+  row_group.SerializeToString(&header);
+  char size[kHeaderSize];
+  core::EncodeFixed64(size, header.size());
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(size, kHeaderSize)));
+  TF_RETURN_IF_ERROR(dest_->Append(header));
+  for (std::string& chunk : chunks_) {
+    TF_RETURN_IF_ERROR(dest_->Append(chunk));
+    chunk.clear();
+  }
+  num_buffered_elements_ = 0;
+  num_buffered_bytes_ = 0;
+  return Status::OK();
+}
+
+Status ColumnarWriter::Sync() {
+  TF_RETURN_IF_ERROR(FlushRowGroup());
+  return dest_->Sync();
+}
+
+Status ColumnarWriter::Close() {
+  if (dest_ == nullptr) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(FlushRowGroup());
+  TF_RETURN_IF_ERROR(dest_->Close());
+  dest_ = nullptr;
+  return Status::OK();
+}
+
+ColumnarWriter::~ColumnarWriter() {
+  Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Could not finish writing file: " << s;
+  }
+}
+
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -322,6 +444,14 @@ Status Reader::Create(Env* env, const std::string& filename,
       *out_reader =
           absl::make_unique<TFRecordReader>(filename, compression_type, dtypes);
       break;
+    case 3: {
+      // Every chunk records its own compression.
+      std::vector<int> components(dtypes.size());
+      std::iota(components.begin(), components.end(), 0);
+      *out_reader =
+          absl::make_unique<ColumnarReader>(filename, dtypes, components);
+      break;
+    }
     default:
       return errors::InvalidArgument("Snapshot reader version: ", version,
                                      " is not supported.");
@@ -596,6 +726,191 @@ Status Reader::MakeNestedDataset(Env* env,
   return Status::OK();
 }
 
+ReadAheadBudget* ReadAheadBudget::Default() {
+  static ReadAheadBudget* budget = new ReadAheadBudget(256 << 20);
+  return budget;
+}
+
+bool ReadAheadBudget::TryReserve(int64 bytes) {
+  mutex_lock l(mu_);
+  if (used_bytes_ + bytes > max_bytes_) {
+    return false;
+  }
+  used_bytes_ += bytes;
+  return true;
+}
+
+void ReadAheadBudget::Release(int64 bytes) {
+  mutex_lock l(mu_);
+  used_bytes_ -= bytes;
+}
+
+ReadAheadFile::ReadAheadFile(Env* env, std::unique_ptr<RandomAccessFile> file,
+                             size_t block_size_bytes, int num_blocks,
+                             ReadAheadBudget* budget)
+    : file_(std::move(file)),
+      block_size_bytes_(block_size_bytes),
+      num_blocks_(num_blocks),
+      budget_(budget) {
+  thread_ = absl::WrapUnique(env->StartThread(
+      {}, "tf_data_snapshot_read_ahead", [this]() { ReadAheadLoop(); }));
+}
+
+ReadAheadFile::~ReadAheadFile() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cv_.notify_all();
+  }
+  // Joins the read-ahead thread.
+  thread_.reset();
+}
+
+Status ReadAheadFile::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+void ReadAheadFile::ReadAheadLoop() {
+  while (true) {
+    uint64 offset;
+    int64 generation;
+    int num_free_blocks;
+    {
+      mutex_lock l(mu_);
+      // Stop once the buffer is full, or the last read failed or reached the
+      // end of the file, until the reader consumes or restarts the buffer.
+      while (!cancelled_ &&
+             (blocks_.size() >= num_blocks_ ||
+              (!blocks_.empty() && !blocks_.back().status.ok()))) {
+        cv_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+      offset = next_offset_;
+      generation = generation_;
+      num_free_blocks = num_blocks_ - blocks_.size();
+    }
+    std::vector<Block> new_blocks;
+    new_blocks.reserve(num_free_blocks);
+    for (int i = 0; i < num_free_blocks; ++i) {
+      if (!budget_->TryReserve(block_size_bytes_)) {
+        break;
+      }
+      new_blocks.push_back(
+          Block{offset + i * block_size_bytes_,
+                std::unique_ptr<char[], BufferDeleter>(
+                    new char[block_size_bytes_],
+                    BufferDeleter{budget_, block_size_bytes_}),
+                StringPiece(), Status::OK()});
+    }
+    if (new_blocks.empty()) {
+      // Let the reader read from the file directly, and check the budget
+      // again later, since other files don't notify us when they free memory.
+      mutex_lock l(mu_);
+      out_of_budget_ = true;
+      cv_.notify_all();
+      cv_.wait_for(l, std::chrono::milliseconds(10));
+      continue;
+    }
+    // Read the blocks in one call, which file systems may serve concurrently.
+    // The blocks are read into their own buffers, which the reader copies
+    // from directly.
+    std::vector<RandomAccessFile::ReadRequest> requests(new_blocks.size());
+    for (int i = 0; i < new_blocks.size(); ++i) {
+      requests[i].offset = new_blocks[i].offset;
+      requests[i].n = block_size_bytes_;
+      requests[i].scratch = new_blocks[i].buffer.get();
+    }
+    file_->ReadMany(&requests);
+    mutex_lock l(mu_);
+    out_of_budget_ = false;
+    if (generation != generation_) {
+      continue;
+    }
+    for (int i = 0; i < new_blocks.size(); ++i) {
+      Block& block = new_blocks[i];
+      block.data = requests[i].result;
+      block.status = requests[i].status;
+      next_offset_ = block.offset + block.data.size();
+      const bool ok = block.status.ok();
+      blocks_.push_back(std::move(block));
+      if (!ok) {
+        break;
+      }
+    }
+    cv_.notify_all();
+  }
+}
+
+void ReadAheadFile::Restart(uint64 offset) const {
+  blocks_.clear();
+  next_offset_ = offset;
+  ++generation_;
+  cv_.notify_all();
+}
+
+Status ReadAheadFile::Read(uint64 offset, size_t n, StringPiece* result,
+                           char* scratch) const {
+  mutex_lock l(mu_);
+  size_t num_read = 0;
+  while (num_read < n) {
+    const uint64 position = offset + num_read;
+    // Drop the blocks which have been read completely.
+    while (!blocks_.empty() && blocks_.front().status.ok() &&
+           blocks_.front().offset + blocks_.front().data.size() <= position) {
+      blocks_.pop_front();
+      cv_.notify_all();
+    }
+    const bool sequential =
+        blocks_.empty()
+            ? position == next_offset_
+            : position >= blocks_.front().offset &&
+                  position <= blocks_.front().offset +
+                                  blocks_.front().data.size();
+    if (!sequential) {
+      Restart(position);
+    }
+    if (blocks_.empty()) {
+      if (!out_of_budget_) {
+        cv_.wait(l);
+        continue;
+      }
+      // Read the rest directly rather than wait for memory that other
+      // readers may hold.
+      StringPiece direct;
+      Status s =
+          file_->Read(position, n - num_read, &direct, scratch + num_read);
+      if (direct.data() != scratch + num_read) {
+        memmove(scratch + num_read, direct.data(), direct.size());
+      }
+      num_read += direct.size();
+      Restart(position + direct.size());
+      *result = StringPiece(scratch, num_read);
+      return s;
+    }
+    const Block& block = blocks_.front();
+    const size_t block_position = position - block.offset;
+    if (block_position == block.data.size()) {
+      // The read-ahead stopped at this block, e.g. at the end of the file.
+      *result = StringPiece(scratch, num_read);
+      Status s = block.status;
+      if (!errors::IsOutOfRange(s)) {
+        // Fetch the block again on the next read, since the error may be
+        // transient.
+        Restart(position);
+      }
+      return s;
+    }
+    const size_t num_bytes =
+        std::min(n - num_read, block.data.size() - block_position);
+    memcpy(scratch + num_read, block.data.data() + block_position, num_bytes);
+    num_read += num_bytes;
+  }
+  *result = StringPiece(scratch, num_read);
+  return Status::OK();
+}
+
 TFRecordReader::TFRecordReader(const std::string& filename,
                                const string& compression_type,
                                const DataTypeVector& dtypes)
@@ -605,7 +920,9 @@ TFRecordReader::TFRecordReader(const std::string& filename,
       dtypes_(dtypes) {}
 
 Status TFRecordReader::Initialize(Env* env) {
-  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file));
+  file_ = absl::make_unique<ReadAheadFile>(env, std::move(file));
 
   record_reader_ = absl::make_unique<io::RecordReader>(
       file_.get(), io::RecordReaderOptions::CreateRecordReaderOptions(
@@ -641,7 +958,9 @@ CustomReader::CustomReader(const std::string& filename,
       dtypes_(dtypes) {}
 
 Status CustomReader::Initialize(Env* env) {
-  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file));
+  file_ = absl::make_unique<ReadAheadFile>(env, std::move(file));
   input_stream_ = std::make_unique<io::RandomAccessInputStream>(file_.get());
 
 #if defined(IS_SLIM_BUILD)
@@ -842,6 +1161,173 @@ Status CustomReader::ReadRecord(absl::Cord* record) {
 }
 #endif
 
+Status ColumnarReader::Create(Env* env, const std::string& filename,
+                              const DataTypeVector& dtypes,
+                              const std::vector<int>& components,
+                              std::unique_ptr<Reader>* out_reader) {
+  auto reader = absl::make_unique<ColumnarReader>(filename, dtypes, components);
+  TF_RETURN_IF_ERROR(reader->Initialize(env));
+  *out_reader = std::move(reader);
+  return Status::OK();
+}
+
+ColumnarReader::ColumnarReader(const std::string& filename,
+                               const DataTypeVector& dtypes,
+                               const std::vector<int>& components)
+    : filename_(filename),
+      dtypes_(dtypes),
+      components_(components),
+      columns_(components.size()) {}
+
+Status ColumnarReader::Initialize(Env* env) {
+  for (int component : components_) {
+    if (component < 0 || component >= dtypes_.size()) {
+      return errors::InvalidArgument("Component ", component,
+                                     " is out of range for elements with ",
+                                     dtypes_.size(), " components.");
+    }
+  }
+  return env->NewRandomAccessFile(filename_, &file_);
+}
+
+Status ColumnarReader::ReadTensors(std::vector<Tensor>* read_tensors) {
+  profiler::TraceMe activity(
+      [&]() { return "ColumnarReader::ReadTensors"; },
+      profiler::TraceMeLevel::kInfo);
+  while (next_element_ >= num_elements_) {
+    TF_RETURN_IF_ERROR(ReadRowGroup());
+  }
+  read_tensors->reserve(columns_.size());
+  for (std::vector<Tensor>& column : columns_) {
+    read_tensors->push_back(std::move(column[next_element_]));
+  }
+  ++next_element_;
+  return Status::OK();
+}
+
+Status ColumnarReader::ReadBytes(uint64 offset, size_t n,
+                                 bool end_of_file_ok, std::string* data) {
+  data->resize(n);
+  StringPiece result;
+  Status s = file_->Read(offset, n, &result, &(*data)[0]);
+  if (errors::IsOutOfRange(s) && (!end_of_file_ok || !result.empty())) {
+    return errors::DataLoss("Snapshot file ", filename_,
+                            " is truncated at offset ", offset);
+  }
+  TF_RETURN_IF_ERROR(s);
+  if (result.data() != data->data()) {
+    memmove(&(*data)[0], result.data(), result.size());
+  }
+  return Status::OK();
+}
+
+Status ColumnarReader::ReadRowGroup() {
+  std::string size;
+  // Reaching the end of the file here means there are no more row groups.
+  TF_RETURN_IF_ERROR(ReadBytes(offset_, ColumnarWriter::kHeaderSize,
+                               /*end_of_file_ok=*/true, &size));
+  const uint64 header_size = core::DecodeFixed64(size.data());
+  std::string header;
+  TF_RETURN_IF_ERROR(ReadBytes(offset_ + ColumnarWriter::kHeaderSize,
+                               header_size, /*end_of_file_ok=*/false,
+                               &header));
+  experimental::SnapshotRowGroup row_group;
+  if (!row_group.ParseFromString(header)) {
+    return errors::DataLoss("Failed to parse row group at offset ", offset_,
+                            " of snapshot file ", filename_);
+  }
+  if (row_group.chunks_size() != dtypes_.size()) {
+    return errors::DataLoss("Expected ", dtypes_.size(),
+                            " chunks in the row group at offset ", offset_,
+                            " of snapshot file ", filename_, ", but found ",
+                            row_group.chunks_size());
+  }
+  std::vector<uint64> chunk_offsets(row_group.chunks_size());
+  uint64 chunk_offset = offset_ + ColumnarWriter::kHeaderSize + header_size;
+  for (int i = 0; i < row_group.chunks_size(); ++i) {
+    chunk_offsets[i] = chunk_offset;
+    chunk_offset += row_group.chunks(i).size_bytes();
+  }
+  for (int i = 0; i < components_.size(); ++i) {
+    const int component = components_[i];
+    const experimental::SnapshotRowGroup::Chunk& chunk_info =
+        row_group.chunks(component);
+    std::string chunk;
+    TF_RETURN_IF_ERROR(ReadBytes(chunk_offsets[component],
+                                 chunk_info.size_bytes(),
+                                 /*end_of_file_ok=*/false, &chunk));
+    columns_[i].clear();
+    TF_RETURN_IF_ERROR(ParseChunk(chunk_info.compression(), std::move(chunk),
+                                  component, row_group.num_elements(),
+                                  &columns_[i]));
+  }
+  offset_ = chunk_offset;
+  num_elements_ = row_group.num_elements();
+  next_element_ = 0;
+  return Status::OK();
+}
+
+Status ColumnarReader::ParseChunk(const std::string& compression,
+                                  std::string chunk, int component,
+                                  int64 num_elements,
+                                  std::vector<Tensor>* column) {
+  if (compression == io::compression::kSnappy) {
+    size_t uncompressed_size;
+    if (!port::Snappy_GetUncompressedLength(chunk.data(), chunk.size(),
+                                            &uncompressed_size)) {
+      return errors::DataLoss("Failed to get the uncompressed size of a "
+                              "chunk of snapshot file ",
+                              filename_);
+    }
+    std::string uncompressed(uncompressed_size, '\0');
+    if (!port::Snappy_Uncompress(chunk.data(), chunk.size(),
+                                 &uncompressed[0])) {
+      return errors::DataLoss("Failed to uncompress a chunk of snapshot file ",
+                              filename_);
+    }
+    chunk.swap(uncompressed);
+  } else if (compression == io::compression::kGzip) {
+    std::string uncompressed;
+    Status s = io::BlockGzipInputStream::DecompressBlock(chunk, &uncompressed);
+    if (!s.ok()) {
+      return errors::DataLoss("Failed to uncompress a chunk of snapshot file ",
+                              filename_, ": ", s.error_message());
+    }
+    chunk.swap(uncompressed);
+  } else if (compression != io::compression::kNone) {
+    return errors::Unimplemented("Unsupported chunk compression ",
+                                 compression, " in snapshot file ", filename_);
+  }
+  column->reserve(num_elements);
+  size_t position = 0;
+  for (int64 i = 0; i < num_elements; ++i) {
+    if (position + ColumnarWriter::kHeaderSize > chunk.size()) {
+      return errors::DataLoss("Chunk of component ", component,
+                              " in snapshot file ", filename_,
+                              " is truncated");
+    }
+    const uint64 proto_size = core::DecodeFixed64(chunk.data() + position);
+    position += ColumnarWriter::kHeaderSize;
+    if (position + proto_size > chunk.size()) {
+      return errors::DataLoss("Chunk of component ", component,
+                              " in snapshot file ", filename_,
+                              " is truncated");
+    }
+    TensorProto proto;
+    if (!proto.ParseFromArray(chunk.data() + position, proto_size)) {
+      return errors::DataLoss("Unable to parse tensor from stored proto.");
+    }
+    position += proto_size;
+    Tensor tensor;
+    if (!tensor.FromProto(proto) || tensor.dtype() != dtypes_[component]) {
+      return errors::DataLoss("Unable to parse tensor of component ",
+                              component, " from stored proto.");
+    }
+    column->push_back(std::move(tensor));
+  }
+  return Status::OK();
+}
+
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata) {
   string metadata_filename = io::JoinPath(dir, kMetadataFilename);
@@ -852,6 +1338,26 @@ Status WriteMetadataFile(Env* env, const string& dir,
   return env->RenameFile(tmp_filename, metadata_filename);
 }
 
+Status WriteMetadataFileUnlessFinalized(
+    Env* env, const string& dir,
+    const experimental::SnapshotMetadataRecord* metadata, bool* written) {
+  experimental::SnapshotMetadataRecord existing_metadata;
+  bool file_exists;
+  TF_RETURN_IF_ERROR(
+      ReadMetadataFile(env, dir, &existing_metadata, &file_exists));
+  if (file_exists && existing_metadata.finalized() &&
+      existing_metadata.run_id() != metadata->run_id()) {
+    *written = false;
+    return Status::OK();
+  }
+  // NOTE: Another process can still finalize its run between the check and the
+  // write, since file systems do not provide an atomic compare-and-swap. The
+  // write itself is atomic, so readers always see a consistent metadata file.
+  TF_RETURN_IF_ERROR(WriteMetadataFile(env, dir, metadata));
+  *written = true;
+  return Status::OK();
+}
+
 Status ReadMetadataFile(Env* env, const string& dir,
                         experimental::SnapshotMetadataRecord* metadata,
                         bool* file_exists) {
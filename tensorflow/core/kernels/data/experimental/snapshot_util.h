@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
 
+#include <deque>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
 
@@ -163,6 +166,141 @@ class CustomWriter : public Writer {
   int num_complex_ = 0;
 };
 
+// Writes snapshots in the columnar layout of file format version 3, so that
+// readers can read only some of the components of the elements.
+//
+// Elements are buffered into row groups of about `kRowGroupSizeBytes`. Each
+// row group is written as a header, a `SnapshotRowGroup` proto, followed by
+// one chunk for each component which holds that component of every element in
+// the row group. With snappy or gzip compression, every chunk is compressed
+// on its own and stored uncompressed when compression doesn't make it
+// smaller, e.g. for already-encoded images.
+class ColumnarWriter : public Writer {
+ public:
+  static constexpr const int64 kRowGroupSizeBytes = 16 << 20;  // 16 MiB
+  static constexpr const size_t kHeaderSize = sizeof(uint64);
+
+  ColumnarWriter(const std::string& filename,
+                 const std::string& compression_type,
+                 const DataTypeVector& dtypes);
+
+  Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  Status Sync() override;
+
+  Status Close() override;
+
+  ~ColumnarWriter() override;
+
+ protected:
+  Status Initialize(tensorflow::Env* env) override;
+
+ private:
+  // Writes the buffered elements as a row group.
+  Status FlushRowGroup();
+
+  std::unique_ptr<WritableFile> dest_;
+  const std::string filename_;
+  const std::string compression_type_;
+  const DataTypeVector dtypes_;
+  // The serialized components of the buffered elements, one string for each
+  // component.
+  std::vector<std::string> chunks_;
+  int64 num_buffered_elements_ = 0;
+  int64 num_buffered_bytes_ = 0;
+};
+
+// Bounds the memory that `ReadAheadFile`s buffer in total. A snapshot reader
+// may have many files open at once, e.g. one per interleaved shard.
+class ReadAheadBudget {
+ public:
+  explicit ReadAheadBudget(int64 max_bytes) : max_bytes_(max_bytes) {}
+
+  // The budget shared by all snapshot readers, of 256 MiB.
+  static ReadAheadBudget* Default();
+
+  // Reserves `bytes` if that keeps the total within the budget.
+  bool TryReserve(int64 bytes);
+  void Release(int64 bytes);
+
+ private:
+  const int64 max_bytes_;
+  mutex mu_;
+  int64 used_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// A `RandomAccessFile` which reads ahead of sequential reads on a background
+// thread. Snapshot files are read front to back, so fetching the next blocks
+// while the reader decompresses and parses the current one keeps the file
+// system busy, which matters for file systems with high per-request latency.
+//
+// At most `num_blocks` blocks of `block_size_bytes` are buffered, and only as
+// long as `budget` has room for them. When it doesn't, reads go to the file
+// directly. Reads which don't continue from the previous read restart the
+// read-ahead at their offset, and so do reads following a failed one.
+class ReadAheadFile : public RandomAccessFile {
+ public:
+  static constexpr const size_t kDefaultBlockSizeBytes = 8 << 20;  // 8 MiB
+  static constexpr const int kDefaultNumBlocks = 2;
+
+  ReadAheadFile(Env* env, std::unique_ptr<RandomAccessFile> file,
+                size_t block_size_bytes = kDefaultBlockSizeBytes,
+                int num_blocks = kDefaultNumBlocks,
+                ReadAheadBudget* budget = ReadAheadBudget::Default());
+
+  ~ReadAheadFile() override;
+
+  Status Name(StringPiece* result) const override;
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override;
+
+ private:
+  // Frees a block buffer and returns its size to the budget.
+  struct BufferDeleter {
+    ReadAheadBudget* budget;
+    size_t size;
+    void operator()(char* buffer) const {
+      delete[] buffer;
+      budget->Release(size);
+    }
+  };
+
+  struct Block {
+    uint64 offset;
+    // The buffer the block is read into, which `data` usually points to.
+    std::unique_ptr<char[], BufferDeleter> buffer;
+    StringPiece data;
+    // The status of reading the block. Only the last buffered block may have
+    // a non-OK status, after which the read-ahead stops.
+    Status status;
+  };
+
+  void ReadAheadLoop();
+
+  // Drops the buffered blocks and restarts the read-ahead at `offset`.
+  void Restart(uint64 offset) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::unique_ptr<RandomAccessFile> file_;
+  const size_t block_size_bytes_;
+  const int num_blocks_;
+  ReadAheadBudget* const budget_;
+
+  mutable mutex mu_;
+  mutable condition_variable cv_;
+  // Consecutive blocks starting at the offset of the last read.
+  mutable std::deque<Block> blocks_ TF_GUARDED_BY(mu_);
+  // The offset of the next block to read ahead.
+  mutable uint64 next_offset_ TF_GUARDED_BY(mu_) = 0;
+  // Incremented when the read-ahead restarts at a new offset, so that a block
+  // read for the old offset is discarded.
+  mutable int64 generation_ TF_GUARDED_BY(mu_) = 0;
+  // Whether the read-ahead is waiting for room in the budget.
+  bool out_of_budget_ TF_GUARDED_BY(mu_) = false;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+};
+
 // Interface class for reading snapshot files previous written with Writer.
 class Reader {
  public:
@@ -280,10 +418,74 @@ class CustomReader : public Reader {
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
 };
 
+// Reads snapshots previously written with `ColumnarWriter`.
+//
+// Reading can be restricted to a projection of the components, in which case
+// `ReadTensors` produces only those components, in the order of the
+// projection, and the chunks of the other components are never read.
+class ColumnarReader : public Reader {
+ public:
+  // Creates a reader for the components of the elements at the given
+  // indices into `dtypes`.
+  static Status Create(Env* env, const std::string& filename,
+                       const DataTypeVector& dtypes,
+                       const std::vector<int>& components,
+                       std::unique_ptr<Reader>* out_reader);
+
+  ColumnarReader(const std::string& filename, const DataTypeVector& dtypes,
+                 const std::vector<int>& components);
+
+  Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  ~ColumnarReader() override {}
+
+ protected:
+  Status Initialize(Env* env) override;
+
+ private:
+  // Reads the next row group into `columns_`.
+  Status ReadRowGroup();
+
+  // Reads exactly `n` bytes at `offset`. If the file ends before `offset + n`,
+  // returns OutOfRange when `end_of_file_ok` and nothing could be read, and
+  // DataLoss otherwise.
+  Status ReadBytes(uint64 offset, size_t n, bool end_of_file_ok,
+                   std::string* data);
+
+  // Parses the `num_elements` tensors of `component` in `chunk`, which has
+  // the given compression.
+  Status ParseChunk(const std::string& compression, std::string chunk,
+                    int component, int64 num_elements,
+                    std::vector<Tensor>* column);
+
+  const std::string filename_;
+  const DataTypeVector dtypes_;
+  const std::vector<int> components_;
+  std::unique_ptr<RandomAccessFile> file_;
+  // The offset of the next row group in the file.
+  uint64 offset_ = 0;
+  // The projected components of the current row group, one vector for each
+  // projected component.
+  std::vector<std::vector<Tensor>> columns_;
+  int64 num_elements_ = 0;
+  int64 next_element_ = 0;
+};
+
 // Writes snapshot metadata to the given directory.
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata);
 
+// Writes snapshot metadata to the given directory, unless the directory holds
+// the metadata of a finalized snapshot of a different run. Sets `*written`
+// to whether the metadata was written.
+//
+// Several processes may write snapshots of the same dataset at the same time.
+// The first run to be finalized is published to all readers, and stays
+// published so that readers can resume reading it from checkpoints.
+Status WriteMetadataFileUnlessFinalized(
+    Env* env, const string& dir,
+    const experimental::SnapshotMetadataRecord* metadata, bool* written);
+
 // Reads snapshot metadata from the given directory.
 Status ReadMetadataFile(Env* env, const string& dir,
                         experimental::SnapshotMetadataRecord* metadata,
@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 
 namespace tensorflow {
 namespace data {
@@ -89,6 +94,244 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kNone, 2);
   SnapshotRoundTrip(io::compression::kGzip, 2);
   SnapshotRoundTrip(io::compression::kSnappy, 2);
+
+  SnapshotRoundTrip(io::compression::kNone, 3);
+  SnapshotRoundTrip(io::compression::kSnappy, 3);
+  SnapshotRoundTrip(io::compression::kGzip, 3);
+}
+
+TEST(SnapshotUtilTest, ColumnarProjection) {
+  Env* env = Env::Default();
+  std::string filename;
+  EXPECT_TRUE(env->LocalTempFilename(&filename));
+  DataTypeVector dtypes = {DT_INT64, DT_STRING, DT_INT64};
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(env, filename, io::compression::kSnappy,
+                              /*version=*/3, dtypes, &writer));
+  for (int64 i = 0; i < 100; ++i) {
+    Tensor first(DT_INT64, TensorShape({}));
+    first.scalar<int64>()() = i;
+    Tensor second(DT_STRING, TensorShape({}));
+    second.scalar<tstring>()() = std::string(1000, 'a');
+    Tensor third(DT_INT64, TensorShape({2}));
+    third.vec<int64>()(0) = 2 * i;
+    third.vec<int64>()(1) = 3 * i;
+    TF_ASSERT_OK(writer->WriteTensors({first, second, third}));
+    if (i % 30 == 0) {
+      // Ends a row group.
+      TF_ASSERT_OK(writer->Sync());
+    }
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(ColumnarReader::Create(env, filename, dtypes,
+                                      /*components=*/{2, 0}, &reader));
+  for (int64 i = 0; i < 100; ++i) {
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+    ASSERT_EQ(read_tensors.size(), 2);
+    EXPECT_EQ(read_tensors[0].vec<int64>()(0), 2 * i);
+    EXPECT_EQ(read_tensors[0].vec<int64>()(1), 3 * i);
+    EXPECT_EQ(read_tensors[1].scalar<int64>()(), i);
+  }
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+
+  EXPECT_TRUE(errors::IsInvalidArgument(ColumnarReader::Create(
+      env, filename, dtypes, /*components=*/{3}, &reader)));
+  TF_ASSERT_OK(env->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, ColumnarTruncatedFile) {
+  Env* env = Env::Default();
+  std::string filename;
+  EXPECT_TRUE(env->LocalTempFilename(&filename));
+  DataTypeVector dtypes = {DT_INT64};
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(env, filename, io::compression::kNone,
+                              /*version=*/3, dtypes, &writer));
+  Tensor tensor(DT_INT64, TensorShape({}));
+  tensor.scalar<int64>()() = 1;
+  TF_ASSERT_OK(writer->WriteTensors({tensor}));
+  TF_ASSERT_OK(writer->Close());
+
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(env, filename, &contents));
+  contents.pop_back();
+  TF_ASSERT_OK(WriteStringToFile(env, filename, contents));
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(env, filename, io::compression::kNone,
+                              /*version=*/3, dtypes, &reader));
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsDataLoss(reader->ReadTensors(&read_tensors)));
+  TF_ASSERT_OK(env->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, WriteMetadataFileUnlessFinalized) {
+  Env* env = Env::Default();
+  string dir = io::JoinPath(testing::TmpDir(), "metadata_unless_finalized");
+  experimental::SnapshotMetadataRecord run1;
+  run1.set_run_id("1");
+  experimental::SnapshotMetadataRecord run2;
+  run2.set_run_id("2");
+
+  // Unfinalized runs overwrite each other.
+  bool written;
+  TF_ASSERT_OK(WriteMetadataFileUnlessFinalized(env, dir, &run1, &written));
+  EXPECT_TRUE(written);
+  TF_ASSERT_OK(WriteMetadataFileUnlessFinalized(env, dir, &run2, &written));
+  EXPECT_TRUE(written);
+
+  // The first finalized run stays published.
+  run1.set_finalized(true);
+  TF_ASSERT_OK(WriteMetadataFileUnlessFinalized(env, dir, &run1, &written));
+  EXPECT_TRUE(written);
+  run2.set_finalized(true);
+  TF_ASSERT_OK(WriteMetadataFileUnlessFinalized(env, dir, &run2, &written));
+  EXPECT_FALSE(written);
+
+  experimental::SnapshotMetadataRecord metadata;
+  bool file_exists;
+  TF_ASSERT_OK(ReadMetadataFile(env, dir, &metadata, &file_exists));
+  EXPECT_TRUE(file_exists);
+  EXPECT_EQ(metadata.run_id(), "1");
+  EXPECT_TRUE(metadata.finalized());
+
+  // The published run can still rewrite its own metadata.
+  TF_ASSERT_OK(WriteMetadataFileUnlessFinalized(env, dir, &run1, &written));
+  EXPECT_TRUE(written);
+
+  int64 undeleted_files, undeleted_dirs;
+  TF_ASSERT_OK(env->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs));
+}
+
+TEST(SnapshotUtilTest, ReadAheadFile) {
+  Env* env = Env::Default();
+  std::string filename;
+  EXPECT_TRUE(env->LocalTempFilename(&filename));
+  std::string contents;
+  for (int i = 0; i < 1000; ++i) {
+    contents.push_back(static_cast<char>('a' + i % 26));
+  }
+  TF_ASSERT_OK(WriteStringToFile(env, filename, contents));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(filename, &file));
+  ReadAheadFile read_ahead_file(env, std::move(file), /*block_size_bytes=*/64,
+                                /*num_blocks=*/2);
+  char scratch[1000];
+  StringPiece result;
+
+  // Sequential reads which span several blocks.
+  for (int offset = 0; offset < 900; offset += 100) {
+    TF_ASSERT_OK(read_ahead_file.Read(offset, 100, &result, scratch));
+    EXPECT_EQ(result, StringPiece(contents).substr(offset, 100));
+  }
+  // A read past the end of the file returns the remaining bytes.
+  Status s = read_ahead_file.Read(900, 200, &result, scratch);
+  EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+  EXPECT_EQ(result, StringPiece(contents).substr(900));
+
+  // Reads at other offsets restart the read-ahead.
+  TF_ASSERT_OK(read_ahead_file.Read(10, 20, &result, scratch));
+  EXPECT_EQ(result, StringPiece(contents).substr(10, 20));
+  TF_ASSERT_OK(read_ahead_file.Read(500, 300, &result, scratch));
+  EXPECT_EQ(result, StringPiece(contents).substr(500, 300));
+  s = read_ahead_file.Read(2000, 10, &result, scratch);
+  EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+  EXPECT_TRUE(result.empty());
+
+  TF_ASSERT_OK(env->DeleteFile(filename));
+}
+
+constexpr uint64 kNeverFail = ~0ull;
+
+// Serves `contents` from memory. The first read at `fail_offset` fails.
+class FlakyFile : public RandomAccessFile {
+ public:
+  FlakyFile(std::string contents, uint64 fail_offset)
+      : contents_(std::move(contents)), fail_offset_(fail_offset) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    {
+      mutex_lock l(mu_);
+      if (offset == fail_offset_ && !failed_) {
+        failed_ = true;
+        *result = StringPiece();
+        return errors::Unavailable("Injected failure");
+      }
+    }
+    if (offset >= contents_.size()) {
+      *result = StringPiece();
+      return errors::OutOfRange("End of file");
+    }
+    const size_t num_bytes = std::min<size_t>(n, contents_.size() - offset);
+    memcpy(scratch, contents_.data() + offset, num_bytes);
+    *result = StringPiece(scratch, num_bytes);
+    return num_bytes < n ? errors::OutOfRange("End of file") : Status::OK();
+  }
+
+ private:
+  const std::string contents_;
+  const uint64 fail_offset_;
+  mutable mutex mu_;
+  mutable bool failed_ TF_GUARDED_BY(mu_) = false;
+};
+
+std::string TestContents() {
+  std::string contents;
+  for (int i = 0; i < 1000; ++i) {
+    contents.push_back(static_cast<char>('a' + i % 26));
+  }
+  return contents;
+}
+
+TEST(SnapshotUtilTest, ReadAheadFileRefetchesFailedBlock) {
+  const std::string contents = TestContents();
+  ReadAheadFile read_ahead_file(
+      Env::Default(),
+      absl::make_unique<FlakyFile>(contents, /*fail_offset=*/128),
+      /*block_size_bytes=*/64, /*num_blocks=*/2);
+  char scratch[1000];
+  StringPiece result;
+
+  // The read stops at the failed block.
+  Status s = read_ahead_file.Read(0, 200, &result, scratch);
+  EXPECT_TRUE(errors::IsUnavailable(s)) << s;
+  EXPECT_EQ(result, StringPiece(contents).substr(0, 128));
+  // Retrying fetches the block again.
+  TF_ASSERT_OK(read_ahead_file.Read(128, 200, &result, scratch));
+  EXPECT_EQ(result, StringPiece(contents).substr(128, 200));
+}
+
+TEST(SnapshotUtilTest, ReadAheadFileOutOfBudget) {
+  const std::string contents = TestContents();
+  ReadAheadBudget budget(/*max_bytes=*/64);
+  // The other file holds the whole budget while it is not being read.
+  ReadAheadFile other_file(
+      Env::Default(),
+      absl::make_unique<FlakyFile>(contents, kNeverFail),
+      /*block_size_bytes=*/64, /*num_blocks=*/2, &budget);
+  ReadAheadFile read_ahead_file(
+      Env::Default(),
+      absl::make_unique<FlakyFile>(contents, kNeverFail),
+      /*block_size_bytes=*/64, /*num_blocks=*/2, &budget);
+  char scratch[1000];
+  StringPiece result;
+
+  // Reads go to the file directly, or use blocks when there is room for them.
+  for (int offset = 0; offset < 900; offset += 100) {
+    TF_ASSERT_OK(read_ahead_file.Read(offset, 100, &result, scratch));
+    EXPECT_EQ(result, StringPiece(contents).substr(offset, 100));
+  }
+  Status s = read_ahead_file.Read(900, 200, &result, scratch);
+  EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+  EXPECT_EQ(result, StringPiece(contents).substr(900));
+  TF_ASSERT_OK(other_file.Read(0, 100, &result, scratch));
+  EXPECT_EQ(result, StringPiece(contents).substr(0, 100));
 }
 
 void SnapshotReaderBenchmarkLoop(int iters, std::string compression_type,
@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <deque>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function_handle_cache.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -19,9 +21,13 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/resource.h"
+#include "tensorflow/core/platform/stringprintf.h"
 
 namespace tensorflow {
 namespace data {
@@ -106,10 +112,323 @@ class ToTFRecordOp : public AsyncOpKernel {
   BackgroundWorker background_worker_;
 };
 
+// The suffix of the file which marks a complete set of shards written by
+// `DatasetToShardedTFRecord`.
+constexpr char kCommitMarkerSuffix[] = ".COMMITTED";
+// The suffix of the files which hold shards while they are being written.
+constexpr char kTempSuffix[] = ".tmp";
+// The maximum number of bytes of records buffered across all shards.
+constexpr int64 kMaxBufferedBytes = 64 << 20;     // 64 MiB
+// The maximum number of bytes of records written to a shard as one batch.
+constexpr int64 kMaxBatchSizeBytes = 1 << 20;  // 1 MiB
+
+// Writes records to `num_shards` TFRecord files in parallel, one thread per
+// shard at a time, with at most `kMaxBufferedBytes` bytes of records in
+// memory.
+//
+// The shards are written to temporary files, which `Finish()` renames to
+// "<path_prefix>-<index>-of-<num_shards>" next to a record index for each
+// shard (see `io::RecordIndexFilename`). It then writes the commit marker
+// "<path_prefix>.COMMITTED", which lists the shards, so that readers can tell
+// a complete set of shards from the output of a failed or ongoing write.
+class ShardedTFRecordWriter {
+ public:
+  ShardedTFRecordWriter(Env* env, const std::string& path_prefix,
+                        const std::string& compression_type, int64 num_shards)
+      : env_(env),
+        path_prefix_(path_prefix),
+        compression_type_(compression_type),
+        batch_size_bytes_(std::max<int64>(
+            1, std::min(kMaxBatchSizeBytes,
+                        kMaxBufferedBytes / (2 * num_shards)))),
+        shards_(num_shards),
+        thread_pool_(absl::make_unique<thread::ThreadPool>(
+            env, "tf_data_to_sharded_tf_record",
+            std::max<int64>(
+                1, std::min<int64>(num_shards, port::MaxParallelism())))) {}
+
+  ~ShardedTFRecordWriter() {
+    // Waits for the batches being written.
+    thread_pool_.reset();
+    if (!finished_) {
+      // Removes the temporary files of an incomplete write.
+      for (Shard& shard : shards_) {
+        shard.writer.reset();
+        shard.file.reset();
+        if (!shard.temp_filename.empty()) {
+          env_->DeleteFile(shard.temp_filename).IgnoreError();
+        }
+      }
+    }
+  }
+
+  Status Initialize() {
+    for (int64 i = 0; i < shards_.size(); ++i) {
+      Shard& shard = shards_[i];
+      shard.filename = strings::Printf(
+          "%s-%05lld-of-%05lld", path_prefix_.c_str(),
+          static_cast<long long>(i), static_cast<long long>(shards_.size()));
+      shard.temp_filename = absl::StrCat(shard.filename, kTempSuffix);
+      TF_RETURN_IF_ERROR(
+          env_->NewWritableFile(shard.temp_filename, &shard.file));
+      shard.writer = absl::make_unique<io::RecordWriter>(
+          shard.file.get(), io::RecordWriterOptions::CreateRecordWriterOptions(
+                                compression_type_));
+    }
+    return Status::OK();
+  }
+
+  int64 num_shards() const { return shards_.size(); }
+
+  // Adds `record` to shard `shard_index`. Blocks while the buffers are full.
+  Status Write(int64 shard_index, const tstring& record) {
+    Shard& shard = shards_[shard_index];
+    shard.pending.records.push_back(record);
+    shard.pending.num_bytes += record.size();
+    if (shard.pending.num_bytes >= batch_size_bytes_) {
+      return StartBatch(&shard);
+    }
+    return Status::OK();
+  }
+
+  // Writes all buffered records, closes the shards and commits them.
+  Status Finish() {
+    for (Shard& shard : shards_) {
+      TF_RETURN_IF_ERROR(StartBatch(&shard));
+    }
+    {
+      mutex_lock l(mu_);
+      while (num_active_shards_ > 0) {
+        cv_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(status_);
+    }
+    std::string marker;
+    for (Shard& shard : shards_) {
+      shard.offsets.push_back(shard.writer->TellOffset());
+      TF_RETURN_IF_ERROR(shard.writer->Close());
+      shard.writer.reset();
+      TF_RETURN_IF_ERROR(shard.file->Close());
+      shard.file.reset();
+      TF_RETURN_IF_ERROR(
+          env_->RenameFile(shard.temp_filename, shard.filename));
+      shard.temp_filename.clear();
+      TF_RETURN_IF_ERROR(io::WriteRecordIndex(
+          env_, io::RecordIndexFilename(shard.filename), shard.offsets));
+      absl::StrAppend(&marker, shard.filename, "\n");
+    }
+    // The marker is renamed into place, so that it is either absent or
+    // complete.
+    const std::string marker_filename =
+        absl::StrCat(path_prefix_, kCommitMarkerSuffix);
+    const std::string temp_marker_filename =
+        absl::StrCat(marker_filename, kTempSuffix);
+    TF_RETURN_IF_ERROR(
+        WriteStringToFile(env_, temp_marker_filename, marker));
+    TF_RETURN_IF_ERROR(env_->RenameFile(temp_marker_filename, marker_filename));
+    finished_ = true;
+    return Status::OK();
+  }
+
+ private:
+  struct Batch {
+    std::vector<tstring> records;
+    int64 num_bytes = 0;
+  };
+
+  struct Shard {
+    std::string filename;
+    std::string temp_filename;
+    std::unique_ptr<WritableFile> file;
+    std::unique_ptr<io::RecordWriter> writer;
+    // The offsets of the records written so far. Only accessed by the thread
+    // which writes the shard.
+    std::vector<uint64> offsets;
+    // The batch filled by `Write()`.
+    Batch pending;
+    // The batches waiting to be written, guarded by `mu_`.
+    std::deque<Batch> batches;
+    // Whether a thread is writing the batches of this shard, guarded by
+    // `mu_`.
+    bool active = false;
+  };
+
+  // Queues the pending batch of `shard` to be written, waiting for buffer
+  // space if needed.
+  Status StartBatch(Shard* shard) {
+    if (shard->pending.records.empty()) {
+      return Status::OK();
+    }
+    mutex_lock l(mu_);
+    // Half of the buffer space is reserved for the pending batches.
+    while (status_.ok() && buffered_bytes_ > 0 &&
+           buffered_bytes_ + shard->pending.num_bytes > kMaxBufferedBytes / 2) {
+      cv_.wait(l);
+    }
+    TF_RETURN_IF_ERROR(status_);
+    buffered_bytes_ += shard->pending.num_bytes;
+    shard->batches.push_back(std::move(shard->pending));
+    shard->pending = Batch();
+    if (!shard->active) {
+      shard->active = true;
+      ++num_active_shards_;
+      thread_pool_->Schedule([this, shard]() { WriteBatches(shard); });
+    }
+    return Status::OK();
+  }
+
+  // Writes the batches of `shard` until there are none left.
+  void WriteBatches(Shard* shard) {
+    while (true) {
+      Batch batch;
+      {
+        mutex_lock l(mu_);
+        if (shard->batches.empty() || !status_.ok()) {
+          for (const Batch& dropped : shard->batches) {
+            buffered_bytes_ -= dropped.num_bytes;
+          }
+          shard->batches.clear();
+          shard->active = false;
+          --num_active_shards_;
+          cv_.notify_all();
+          return;
+        }
+        batch = std::move(shard->batches.front());
+        shard->batches.pop_front();
+      }
+      Status s;
+      for (const tstring& record : batch.records) {
+        shard->offsets.push_back(shard->writer->TellOffset());
+        s = shard->writer->WriteRecord(record);
+        if (!s.ok()) {
+          break;
+        }
+      }
+      mutex_lock l(mu_);
+      buffered_bytes_ -= batch.num_bytes;
+      status_.Update(s);
+      cv_.notify_all();
+    }
+  }
+
+  Env* const env_;
+  const std::string path_prefix_;
+  const std::string compression_type_;
+  const int64 batch_size_bytes_;
+  std::vector<Shard> shards_;
+  bool finished_ = false;
+
+  mutex mu_;
+  condition_variable cv_;
+  int64 buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+  int64 num_active_shards_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+};
+
+class ToShardedTFRecordOp : public AsyncOpKernel {
+ public:
+  explicit ToShardedTFRecordOp(OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx),
+        background_worker_(ctx->env(), "tf_data_to_sharded_tf_record") {}
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    // The call to `iterator->GetNext()` may block and depend on an inter-op
+    // thread pool thread, so we issue the call using a background thread.
+    background_worker_.Schedule([this, ctx, done = std::move(done)]() {
+      OP_REQUIRES_OK_ASYNC(ctx, DoCompute(ctx), done);
+      done();
+    });
+  }
+
+ private:
+  Status DoCompute(OpKernelContext* ctx) {
+    tensorflow::ResourceTagger tag(kTFDataResourceTag,
+                                   ctx->op_kernel().type_string());
+    tstring path_prefix;
+    TF_RETURN_IF_ERROR(
+        ParseScalarArgument<tstring>(ctx, "path_prefix", &path_prefix));
+    tstring compression_type;
+    TF_RETURN_IF_ERROR(ParseScalarArgument<tstring>(ctx, "compression_type",
+                                                    &compression_type));
+    int64 num_shards;
+    TF_RETURN_IF_ERROR(
+        ParseScalarArgument<int64>(ctx, "num_shards", &num_shards));
+    if (num_shards <= 0) {
+      return errors::InvalidArgument("num_shards must be positive, but got ",
+                                     num_shards);
+    }
+
+    DatasetBase* dataset;
+    TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(ctx->input(0), &dataset));
+    // Elements are either records, which are written to the shards in round
+    // robin order, or (key, record) pairs, which are written to the shard
+    // of their key.
+    const DataTypeVector& dtypes = dataset->output_dtypes();
+    const bool keyed = dtypes.size() == 2;
+    if (dtypes.back() != DT_STRING || dtypes.size() > 2 ||
+        (keyed && dtypes[0] != DT_INT64 && dtypes[0] != DT_STRING)) {
+      return errors::InvalidArgument(
+          "The dataset must produce string records, or pairs of int64 or "
+          "string keys and string records, but produces ",
+          DataTypeVectorString(dtypes));
+    }
+
+    ShardedTFRecordWriter writer(ctx->env(), path_prefix, compression_type,
+                                 num_shards);
+    TF_RETURN_IF_ERROR(writer.Initialize());
+
+    IteratorContext::Params params(ctx);
+    FunctionHandleCache function_handle_cache(params.flr);
+    params.function_handle_cache = &function_handle_cache;
+    ResourceMgr resource_mgr;
+    params.resource_mgr = &resource_mgr;
+    CancellationManager cancellation_manager(ctx->cancellation_manager());
+    params.cancellation_manager = &cancellation_manager;
+
+    IteratorContext iter_ctx(std::move(params));
+    std::unique_ptr<IteratorBase> iterator;
+    TF_RETURN_IF_ERROR(dataset->MakeIterator(&iter_ctx, /*parent=*/nullptr,
+                                             "ToShardedTFRecordOpIterator",
+                                             &iterator));
+
+    std::vector<Tensor> components;
+    components.reserve(dtypes.size());
+    int64 next_shard = 0;
+    bool end_of_sequence;
+    do {
+      TF_RETURN_IF_ERROR(
+          iterator->GetNext(&iter_ctx, &components, &end_of_sequence));
+      if (!end_of_sequence) {
+        int64 shard;
+        if (!keyed) {
+          shard = next_shard;
+          next_shard = (next_shard + 1) % num_shards;
+        } else if (dtypes[0] == DT_INT64) {
+          shard = components[0].scalar<int64>()() % num_shards;
+          if (shard < 0) shard += num_shards;
+        } else {
+          const tstring& key = components[0].scalar<tstring>()();
+          shard = Hash64(key.data(), key.size()) % num_shards;
+        }
+        TF_RETURN_IF_ERROR(
+            writer.Write(shard, components.back().scalar<tstring>()()));
+      }
+      components.clear();
+    } while (!end_of_sequence);
+    return writer.Finish();
+  }
+
+  BackgroundWorker background_worker_;
+};
+
 REGISTER_KERNEL_BUILDER(Name("DatasetToTFRecord").Device(DEVICE_CPU),
                         ToTFRecordOp);
 REGISTER_KERNEL_BUILDER(
     Name("ExperimentalDatasetToTFRecord").Device(DEVICE_CPU), ToTFRecordOp);
+REGISTER_KERNEL_BUILDER(Name("DatasetToShardedTFRecord").Device(DEVICE_CPU),
+                        ToShardedTFRecordOp);
 
 }  // namespace
 }  // namespace experimental
@@ -37,6 +37,7 @@ namespace data {
 /* static */ constexpr const char* const MapDatasetOp::kOutputShapes;
 /* static */ constexpr const char* const MapDatasetOp::kUseInterOpParallelism;
 /* static */ constexpr const char* const MapDatasetOp::kPreserveCardinality;
+/* static */ constexpr const char* const MapDatasetOp::kJitCompile;
 
 class MapDatasetOp::Dataset : public DatasetBase {
  public:
@@ -119,14 +120,18 @@ class MapDatasetOp::Dataset : public DatasetBase {
     AttrValue preserve_cardinality_attr;
     b->BuildAttrValue(preserve_cardinality_, &preserve_cardinality_attr);
 
+    // Attr: jit_compile
+    AttrValue jit_compile_attr;
+    b->BuildAttrValue(captured_func_->jit_compile(), &jit_compile_attr);
+
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {std::make_pair(0, input_graph_node)},  // Single tensor inputs.
         {std::make_pair(1, other_arguments)},         // Tensor list inputs.
         {std::make_pair(kFunc, f_attr),
          std::make_pair(kTarguments, other_arguments_types_attr),
          std::make_pair(kUseInterOpParallelism, use_inter_op_parallelism_attr),
-         std::make_pair(kPreserveCardinality,
-                        preserve_cardinality_attr)},  // Attrs
+         std::make_pair(kPreserveCardinality, preserve_cardinality_attr),
+         std::make_pair(kJitCompile, jit_compile_attr)},  // Attrs
         output));
     return Status::OK();
   }
@@ -216,6 +221,7 @@ MapDatasetOp::MapDatasetOp(OpKernelConstruction* ctx)
   FunctionMetadata::Params params;
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kUseInterOpParallelism,
                                    &params.use_inter_op_parallelism));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kJitCompile, &params.jit_compile));
   OP_REQUIRES_OK(ctx,
                  FunctionMetadata::Create(ctx, kFunc, params, &func_metadata_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
@@ -34,6 +34,7 @@ class MapDatasetOp : public UnaryDatasetOpKernel {
       "use_inter_op_parallelism";
   static constexpr const char* const kPreserveCardinality =
       "preserve_cardinality";
+  static constexpr const char* const kJitCompile = "jit_compile";
 
   explicit MapDatasetOp(OpKernelConstruction* ctx);
 
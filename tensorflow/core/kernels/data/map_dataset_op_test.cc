@@ -91,6 +91,25 @@ MapDatasetParams MapDatasetParams3() {
       /*node_name=*/kNodeName);
 }
 
+// In this test case, `XTimesFour()` is called through a wrapper that marks it
+// for XLA compilation. Without the XLA JIT linked in, the wrapper runs it as a
+// regular function call.
+MapDatasetParams MapDatasetParams4() {
+  return MapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*func=*/
+      FunctionDefHelper::FunctionRef("XTimesFour", {{"T", DT_INT64}}),
+      /*func_lib=*/{test::function::XTimesTwo(), test::function::XTimesFour()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName,
+      /*jit_compile=*/true);
+}
+
 std::vector<GetNextTestCase<MapDatasetParams>> GetNextTestCases() {
   return {{/*dataset_params=*/MapDatasetParams1(),
            /*expected_outputs=*/
@@ -99,6 +118,9 @@ std::vector<GetNextTestCase<MapDatasetParams>> GetNextTestCases() {
            /*expected_outputs=*/
            CreateTensors<int64>(TensorShape({2}), {{20, 14}, {8, 2}})},
           {/*dataset_params=*/MapDatasetParams3(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({}), {{0}, {12}, {24}, {36}})},
+          {/*dataset_params=*/MapDatasetParams4(),
            /*expected_outputs=*/
            CreateTensors<int64>(TensorShape({}), {{0}, {12}, {24}, {36}})}};
 }
@@ -115,6 +115,12 @@ constexpr double kDefaultCyclePrefetchFactor = 2.0L;
 // match the behavior of the original implementation.
 constexpr double kDefaultPerIteratorPrefetchFactor = 2.0L;
 
+// If the per-iterator prefetch is autotuned and the output is deterministic,
+// the number of blocks buffered per iterator is tuned between the default
+// factor and this value. Buffering more blocks lets the workers of the other
+// inputs run ahead while the consumer waits for a slow input.
+constexpr double kMaxPerIteratorPrefetchFactor = 16.0L;
+
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
@@ -171,6 +177,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         block_length_(block_length),
         buffer_output_elements_(
             ComputeBufferOutputElements(buffer_output_elements, block_length)),
+        autotune_buffer_output_elements_(buffer_output_elements ==
+                                         model::kAutotune),
         prefetch_input_elements_(ComputePrefetchInputElements(
             prefetch_input_elements, cycle_length)),
         num_parallel_calls_(num_parallel_calls),
@@ -257,8 +265,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
 
     if (op_version_ >= 4) {
       Node* buffer_output_elements_node;
-      TF_RETURN_IF_ERROR(
-          b->AddScalar(buffer_output_elements_, &buffer_output_elements_node));
+      TF_RETURN_IF_ERROR(b->AddScalar(autotune_buffer_output_elements_
+                                          ? model::kAutotune
+                                          : buffer_output_elements_,
+                                      &buffer_output_elements_node));
       inputs.emplace_back(input_index++, buffer_output_elements_node);
 
       Node* prefetch_input_elements_node;
@@ -306,6 +316,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           num_parallel_calls_(std::make_shared<model::SharedState>(
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
+          buffered_blocks_(
+              deterministic && params.dataset->autotune_buffer_output_elements_
+                  ? std::make_shared<model::SharedState>(
+                        model::kAutotune, mu_, num_parallel_calls_cond_var_)
+                  : nullptr),
           deterministic_(deterministic),
           current_elements_(params.dataset->cycle_length_) {}
 
@@ -336,6 +351,9 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       if (num_parallel_calls_->value == model::kAutotune) {
         num_parallel_calls_->value = dataset()->cycle_length_;
       }
+      if (buffered_blocks_ && buffered_blocks_->value == model::kAutotune) {
+        buffered_blocks_->value = kDefaultPerIteratorPrefetchFactor;
+      }
       // TODO(jsimsa): Register cancellation callback once the implementation is
       // refactored not to hold mu_ while calling `GetNext` on the input.
       ctx_ = std::make_unique<IteratorContext>(*ctx);
@@ -387,10 +405,17 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
    protected:
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
-      return model::MakeAsyncInterleaveManyNode(
-          std::move(args),
-          {model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/1,
-                                /*max=*/dataset()->cycle_length_)});
+      std::vector<std::shared_ptr<model::Parameter>> parameters = {
+          model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/1,
+                               /*max=*/dataset()->cycle_length_)};
+      if (buffered_blocks_) {
+        parameters.push_back(model::MakeParameter(
+            model::kBufferedBlocks, buffered_blocks_,
+            /*min=*/kDefaultPerIteratorPrefetchFactor,
+            /*max=*/kMaxPerIteratorPrefetchFactor));
+      }
+      return model::MakeAsyncInterleaveManyNode(std::move(args),
+                                                std::move(parameters));
     }
 
     // TODO(aaudibert): Refactor the implementations to avoid the need for
@@ -941,8 +966,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                {"element_id", result->id}});
         });
         bool end_of_input = false;
+        RecordInFlightStart(ctx_.get());
         result->status = iterator->GetNext(ctx_.get(), &result->return_values,
                                            &end_of_input);
+        RecordInFlightEnd(ctx_.get());
         if (end_of_input) {
           mutex_lock l(*mu_);
           element->iterator.reset();
@@ -954,7 +981,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         mutex_lock l(*mu_);
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
-        if (element->results.size() == dataset()->buffer_output_elements_) {
+        if (element->results.size() >= BufferOutputElements()) {
           break;
         }
       }
@@ -1052,7 +1079,19 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         return true;
       }
       return element->iterator &&
-             element->results.size() < dataset()->buffer_output_elements_;
+             element->results.size() < BufferOutputElements();
+    }
+
+    // Returns the number of results to buffer for each element. When
+    // `buffered_blocks_` is tuned up while an element's buffer is full, the
+    // element is processed further once the consumer takes its next result.
+    size_t BufferOutputElements() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!buffered_blocks_) {
+        return dataset()->buffer_output_elements_;
+      }
+      return static_cast<size_t>(buffered_blocks_->value) *
+                 dataset()->block_length_ +
+             1;
     }
 
     inline void IncrementCurrentWorkers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1460,6 +1499,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Identifies the maximum number of parallel calls.
     const std::shared_ptr<model::SharedState> num_parallel_calls_;
 
+    // Identifies the number of blocks of results buffered for each element, if
+    // it is autotuned. Only used when `deterministic` is true, where a slow
+    // element stalls the output while the other elements keep buffering.
+    const std::shared_ptr<model::SharedState> buffered_blocks_;
+
     // The number of current workers currently alive or scheduled to be started.
     // This includes current workers which are blocked waiting for work.
     int num_current_workers_ TF_GUARDED_BY(mu_) = 0;
@@ -1528,6 +1572,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   const int64 cycle_length_;
   const int64 block_length_;
   const int64 buffer_output_elements_;
+  const bool autotune_buffer_output_elements_;
   const int64 prefetch_input_elements_;
   const int64 num_parallel_calls_;
   const DeterminismPolicy deterministic_;
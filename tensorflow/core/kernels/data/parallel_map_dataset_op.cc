@@ -54,6 +54,7 @@ namespace data {
 /* static */ constexpr const char* const ParallelMapDatasetOp::kSloppy;
 /* static */ constexpr const char* const
     ParallelMapDatasetOp::kPreserveCardinality;
+/* static */ constexpr const char* const ParallelMapDatasetOp::kJitCompile;
 
 namespace {
 
@@ -181,6 +182,11 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       AttrValue deterministic_attr;
       b->BuildAttrValue(deterministic_.String(), &deterministic_attr);
       attrs.emplace_back(kDeterministic, deterministic_attr);
+
+      // Attr: jit_compile
+      AttrValue jit_compile_attr;
+      b->BuildAttrValue(captured_func_->jit_compile(), &jit_compile_attr);
+      attrs.emplace_back(kJitCompile, jit_compile_attr);
     }
 
     // Attr: preserve_cardinality
@@ -405,6 +411,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         TF_LOCKS_EXCLUDED(*mu_) {
       mutex_lock l(*mu_);
       num_calls_--;
+      RecordInFlightEnd(ctx.get());
       RecordBufferEnqueue(ctx.get(), result->return_values);
       result->notification.Notify();
       cond_var_->notify_all();
@@ -523,6 +530,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
                 std::make_shared<InvocationResult>(num_total_calls++));
             new_calls.push_back(invocation_results_.back());
             num_calls_++;
+            RecordInFlightStart(ctx.get());
           }
           cond_var_->notify_all();
         }
@@ -666,6 +674,9 @@ ParallelMapDatasetOp::ParallelMapDatasetOp(OpKernelConstruction* ctx)
   FunctionMetadata::Params params;
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kUseInterOpParallelism,
                                    &params.use_inter_op_parallelism));
+  if (op_version_ == 2) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kJitCompile, &params.jit_compile));
+  }
   OP_REQUIRES_OK(ctx,
                  FunctionMetadata::Create(ctx, kFunc, params, &func_metadata_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
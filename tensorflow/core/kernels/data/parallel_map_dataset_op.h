@@ -38,6 +38,7 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kSloppy = "sloppy";
   static constexpr const char* const kPreserveCardinality =
       "preserve_cardinality";
+  static constexpr const char* const kJitCompile = "jit_compile";
 
   explicit ParallelMapDatasetOp(OpKernelConstruction* ctx);
 
@@ -77,7 +77,8 @@ class ParallelMapDatasetParams : public DatasetParams {
         {ParallelMapDatasetOp::kUseInterOpParallelism,
          use_inter_op_parallelism_},
         {ParallelMapDatasetOp::kDeterministic, deterministic_},
-        {ParallelMapDatasetOp::kPreserveCardinality, preserve_cardinality_}};
+        {ParallelMapDatasetOp::kPreserveCardinality, preserve_cardinality_},
+        {ParallelMapDatasetOp::kJitCompile, false}};
     return Status::OK();
   }
 
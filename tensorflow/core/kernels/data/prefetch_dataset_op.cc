@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include <algorithm>
 #include <deque>
 
 #include "tensorflow/core/common_runtime/metrics.h"
@@ -48,6 +49,11 @@ namespace data {
 
 // Determines the fraction of slack time by which to delay prefetching of data.
 constexpr double kSleepFactor = 0.2;
+// Once the buffer is full, the prefetch thread is woken up only after the
+// consumers have made room for `1 / kRefillFraction` of the buffer, so that a
+// fast producer is woken up once per batch of elements rather than once per
+// element.
+constexpr int64 kRefillFraction = 4;
 constexpr char kBuffer[] = "buffer";
 constexpr char kStatus[] = "status";
 constexpr char kSizeSuffix[] = ".size";
@@ -163,14 +169,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
             auto_tuner_.RecordEmpty();
             buffer_size_->value = auto_tuner_.buffer_limit();
             RecordStop(ctx);
+            ++num_waiting_consumers_;
             cond_var_->wait(l);
+            --num_waiting_consumers_;
             RecordStart(ctx);
           }
         } else {
           while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_ &&
                  buffer_size_->value != 0) {
             RecordStop(ctx);
+            ++num_waiting_consumers_;
             cond_var_->wait(l);
+            --num_waiting_consumers_;
             RecordStart(ctx);
           }
         }
@@ -282,17 +292,21 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     }
 
     data::TraceMeMetadata GetTraceMeMetadata() const override {
-      int64 limit = -1;
+      int64 limit = -1, size = -1;
       // NOTE: We only set the parallelism value if the lock can be acquired
       // right away to avoid introducing tracing overhead.
       if (mu_->try_lock()) {
         limit = buffer_limit();
+        size = buffer_.size();
         mu_->unlock();
       }
       data::TraceMeMetadata result;
       result.push_back(std::make_pair(
           "buffer_limit",
           strings::Printf("%lld", static_cast<long long>(limit))));
+      result.push_back(std::make_pair(
+          "buffer_size",
+          strings::Printf("%lld", static_cast<long long>(size))));
       if (dataset()->slack_period_ > 0) {
         result.push_back(std::make_pair(
             "slack",
@@ -320,6 +334,12 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       return buffer_size_->value;
     }
 
+    // Returns the number of free slots in the buffer that wake up a waiting
+    // prefetch thread.
+    int64 RefillBatchSize() const TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      return std::max<int64>(1, buffer_limit() / kRefillFraction);
+    }
+
     void CancelThreads() TF_LOCKS_EXCLUDED(mu_) {
       mutex_lock l(*mu_);
       cancelled_ = true;
@@ -377,12 +397,19 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       buffer_.pop_front();
       *end_of_sequence = false;
 
-      // Wake the prefetch thread, in case it has been waiting for space
-      // in the buffer. Also wake up threads from other calls to GetNext.
+      // Wake the prefetch thread if it has been waiting for space in the
+      // buffer and there is now room for a batch of elements. Other calls to
+      // GetNext wait only for the buffer to become non-empty, so they do not
+      // need to be woken up here.
       //
-      // TODO(mrry): Consider using different condition variables for
-      // GetNext and Prefetch.
-      cond_var_->notify_all();
+      // NOTE: The consumers and the prefetch thread share the condition
+      // variable with `buffer_size_`, which notifies it when the buffer limit
+      // is autotuned, so both sides observe changes of the limit.
+      if (producer_waiting_ &&
+          static_cast<int64>(buffer_.size()) <=
+              buffer_limit() - RefillBatchSize()) {
+        cond_var_->notify_all();
+      }
       return s;
     }
 
@@ -411,7 +438,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           mutex_lock l(*mu_);
           while (!cancelled_ && buffer_.size() >= buffer_limit()) {
             RecordStop(ctx.get());
+            producer_waiting_ = true;
             cond_var_->wait(l);
+            producer_waiting_ = false;
             RecordStart(ctx.get());
           }
 
@@ -462,7 +491,11 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           buffer_element.created_us = EnvTime::NowMicros();
           buffer_element.id = num_produced;
           buffer_.push_back(std::move(buffer_element));
-          cond_var_->notify_all();
+          // Only consumers can be waiting at this point, and a single element
+          // satisfies only one of them.
+          if (num_waiting_consumers_ > 0) {
+            cond_var_->notify_one();
+          }
         }
         ++num_produced;
       }
@@ -522,6 +555,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     std::unique_ptr<Thread> prefetch_thread_ TF_GUARDED_BY(*mu_);
     bool cancelled_ TF_GUARDED_BY(*mu_) = false;
     bool prefetch_thread_finished_ TF_GUARDED_BY(*mu_) = false;
+    // Track the threads waiting on `cond_var_`, so that the prefetch thread
+    // and the consumers notify each other only when somebody is waiting.
+    int64 num_waiting_consumers_ TF_GUARDED_BY(*mu_) = 0;
+    bool producer_waiting_ TF_GUARDED_BY(*mu_) = false;
     const bool legacy_autotune_;
 
     std::atomic<int64> slack_us_;
@@ -152,6 +152,19 @@ PrefetchDatasetParams PrefetchDatasetParams5() {
       /*node_name=*/kNodeName);
 }
 
+// Test case 6: the input is much longer than the buffer, so that the prefetch
+// thread repeatedly fills the buffer and waits for it to drain.
+PrefetchDatasetParams PrefetchDatasetParams6() {
+  return PrefetchDatasetParams(
+      /*input_dataset_params=*/RangeDatasetParams(0, 100, 1),
+      /*buffer_size=*/8,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*slack_period=*/0,
+      /*legacy_autotune=*/false,
+      /*node_name=*/kNodeName);
+}
+
 PrefetchDatasetParams InvalidBufferSizePrefetchDatasetParams() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
       /*components=*/{CreateTensor<int64>(TensorShape{10, 1},
@@ -295,6 +308,17 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(PrefetchDatasetOpTest, PrefetchDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+TEST_F(PrefetchDatasetOpTest, RefillsFullBuffer) {
+  auto dataset_params = PrefetchDatasetParams6();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> expected_outputs;
+  for (int64 i = 0; i < 100; ++i) {
+    expected_outputs.push_back(CreateTensor<int64>(TensorShape({}), {i}));
+  }
+  TF_ASSERT_OK(CheckIteratorGetNext(expected_outputs,
+                                    /*compare_order=*/true));
+}
+
 TEST_F(PrefetchDatasetOpTest, InvalidBufferSize) {
   auto dataset_params = InvalidBufferSizePrefetchDatasetParams();
   EXPECT_EQ(Initialize(dataset_params).code(), error::INVALID_ARGUMENT);
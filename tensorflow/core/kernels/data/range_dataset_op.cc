@@ -39,6 +39,24 @@ constexpr char kHasSplitProvider[] = "has_split_provider";
 constexpr char kSlash[] = "/";
 constexpr char kSplitProvider[] = "split_provider";
 
+Status ConvertOutputTypes(const tensorflow::DataTypeVector& output_dtypes,
+                          std::vector<Tensor>* out_tensors, int64 value) {
+  out_tensors->reserve(1);
+  switch (output_dtypes[0]) {
+#define HANDLE_TYPE(type)                                \
+  case DataTypeToEnum<type>::value: {                    \
+    out_tensors->emplace_back(static_cast<type>(value)); \
+    break;                                               \
+  }
+    TF_CALL_NUMBER_TYPES(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      return errors::InvalidArgument("Unsupported data type: ",
+                                     DataTypeString(output_dtypes[0]));
+  }
+  return Status::OK();
+}
+
 // Class which produces the elements of `range(start, stop, step)`. Threadsafe.
 class RangeCounter {
  public:
@@ -165,6 +183,19 @@ class RangeDatasetOp::Dataset : public DatasetBase {
     }
   }
 
+  bool SupportsRandomAccess() const override { return true; }
+
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    if (index < 0 || index >= Cardinality()) {
+      return errors::OutOfRange("Index out of range [0, ", Cardinality(),
+                                "):", index);
+    }
+    out_tensors->clear();
+    return ConvertOutputTypes(output_dtypes(), out_tensors,
+                              start_ + index * step_);
+  }
+
   Status MakeSplitProvider(
       std::unique_ptr<SplitProvider>* split_provider) const override {
     *split_provider =
@@ -225,21 +256,7 @@ class RangeDatasetOp::Dataset : public DatasetBase {
           return Status::OK();
         }
       }
-      out_tensors->reserve(1);
-      switch (dataset()->output_dtypes()[0]) {
-#define HANDLE_TYPE(type)                                \
-  case DataTypeToEnum<type>::value: {                    \
-    out_tensors->emplace_back(static_cast<type>(value)); \
-    break;                                               \
-  }
-        TF_CALL_NUMBER_TYPES(HANDLE_TYPE);
-#undef HANDLE_TYPE
-        default:
-          return errors::InvalidArgument(
-              "Unsupported data type: ",
-              DataTypeString(dataset()->output_dtypes()[0]));
-      }
-      return Status::OK();
+      return ConvertOutputTypes(dataset()->output_dtypes(), out_tensors, value);
     }
 
    protected:
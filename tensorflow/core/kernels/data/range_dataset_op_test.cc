@@ -174,6 +174,21 @@ TEST_F(RangeDatasetOpTest, SplitProviderEmpty) {
       CreateTensors<int64>(TensorShape({}), {})));
 }
 
+TEST_F(RangeDatasetOpTest, RandomAccess) {
+  auto params = NegativeStepRangeDatasetParams();
+  TF_ASSERT_OK(Initialize(params));
+  EXPECT_TRUE(dataset_->SupportsRandomAccess());
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(dataset_->Get(iterator_ctx_.get(), 2, &out_tensors));
+  TF_EXPECT_OK(ExpectEqual(out_tensors,
+                           CreateTensors<int64>(TensorShape({}), {{4}}),
+                           /*compare_order=*/true));
+  EXPECT_EQ(dataset_->Get(iterator_ctx_.get(), 4, &out_tensors).code(),
+            tensorflow::error::OUT_OF_RANGE);
+  EXPECT_EQ(dataset_->Get(iterator_ctx_.get(), -1, &out_tensors).code(),
+            tensorflow::error::OUT_OF_RANGE);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
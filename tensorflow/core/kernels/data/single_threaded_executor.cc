@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/single_threaded_executor.h"
 
+#include <atomic>
+
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
@@ -58,6 +60,16 @@ class SingleThreadedExecutorImpl : public Executor {
                                      ordered_nodes.size());
     }
 
+    // Lowered conditionals (Switch and Merge nodes outside of any loop) are
+    // supported by propagating dead tensors in topological order.
+    has_control_flow_ = false;
+    for (const Node* n : ordered_nodes) {
+      if (n->IsSwitch() || n->IsMerge()) {
+        has_control_flow_ = true;
+        break;
+      }
+    }
+
     kernels_.reserve(ordered_nodes.size());
     std::vector<Node*> nodes_with_kernels;
     std::vector<Node*> nodes_with_const_tensor_kernels;
@@ -76,10 +88,11 @@ class SingleThreadedExecutorImpl : public Executor {
               DataTypeString(dt), " in outputs of node ", n->name());
         }
       }
-      if (n->IsControlFlow()) {
+      if (n->IsEnter() || n->IsExit() || n->IsNextIteration() ||
+          n->IsLoopCond()) {
         return errors::FailedPrecondition(
-            "Single-threaded executor does not support low level control flow, "
-            " but saw control flow node ",
+            "Single-threaded executor does not support low level loop control "
+            "flow, but saw control flow node ",
             n->name(),
             ".  Perhaps your graph contains old-style control flow primitives? "
             "Try using tf.compat.v1.enable_control_flow_v2().");
@@ -113,8 +126,22 @@ class SingleThreadedExecutorImpl : public Executor {
       OpKernel* kernel;
       TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
 
+      // A constant that depends on a dead control input is itself dead, so in
+      // a graph with control flow it is only evaluated ahead of time when it
+      // has no control inputs.
+      bool has_control_inputs = false;
+      if (has_control_flow_) {
+        for (const Edge* e : n->in_edges()) {
+          if (e->IsControlEdge() && !e->src()->IsSource()) {
+            has_control_inputs = true;
+            break;
+          }
+        }
+      }
+
       const Tensor* const_tensor;
-      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor())) {
+      if (n->num_outputs() == 1 && !has_control_inputs &&
+          (const_tensor = kernel->const_tensor())) {
         // Nodes that produce a single constant tensor are handled specially:
         // we evaluate the tensor once, and propagate it to its consumers as
         // a `const Tensor*`, to avoid refcount manipulation.
@@ -131,8 +158,11 @@ class SingleThreadedExecutorImpl : public Executor {
         nodes_with_kernels.push_back(n);
         KernelState& kernel_state = kernels_[kernel_index];
         kernel_state.kernel = kernel;
+        kernel_state.async_kernel = kernel->AsAsync();
         kernel_state.num_inputs = n->num_inputs();
         kernel_state.num_outputs = n->num_outputs();
+        kernel_state.is_merge = n->IsMerge();
+        kernel_state.is_control_trigger = n->IsControlTrigger();
         node_to_index_map[n] = kernel_index;
         if (kernel_index == 0) {
           kernel_state.input_start_index = 0;
@@ -142,6 +172,9 @@ class SingleThreadedExecutorImpl : public Executor {
               previous_kernel_state.input_start_index +
               previous_kernel_state.num_inputs;
         }
+        if (kernel_state.async_kernel != nullptr) {
+          has_async_kernels_ = true;
+        }
       }
     }
 
@@ -201,6 +234,9 @@ class SingleThreadedExecutorImpl : public Executor {
           kernel_state.output_locations[e->src_output()].push_back(
               kernels_[node_to_index_map[e->dst()]].input_start_index +
               e->dst_input());
+        } else if (has_control_flow_) {
+          kernel_state.control_output_kernels.push_back(
+              node_to_index_map[e->dst()]);
         }
       }
 
@@ -241,6 +277,45 @@ class SingleThreadedExecutorImpl : public Executor {
   }
 
   Status Run(const Args& args) override {
+    if (has_async_kernels_) {
+      // Waits for `RunAsync()`, which does not block on async kernels.
+      return Executor::Run(args);
+    }
+    RunState state(args, total_num_inputs_);
+    TF_RETURN_IF_ERROR(Start(args, &state));
+    for (size_t i = 0; i < kernels_.size(); ++i) {
+      if (!PrepareInputs(i, &state)) {
+        continue;
+      }
+      const KernelState& kernel_state = kernels_[i];
+      OpKernelContext ctx(&state.params, kernel_state.num_outputs);
+      params_.device->Compute(kernel_state.kernel, &ctx);
+      TF_RETURN_IF_ERROR(ProcessOutputs(i, &ctx, &state));
+    }
+    return Status::OK();
+  }
+
+  void RunAsync(const Args& args, DoneCallback done) override {
+    if (!has_async_kernels_) {
+      done(Run(args));
+      return;
+    }
+    RunState* state = new RunState(args, total_num_inputs_);
+    state->done = std::move(done);
+    Status s = Start(args, state);
+    if (!s.ok()) {
+      Finish(state, s);
+      return;
+    }
+    RunFrom(0, state);
+  }
+
+ private:
+  // The per-run state of the executor.
+  struct RunState {
+    RunState(const Args& args, size_t total_num_inputs)
+        : inputs(total_num_inputs), runner(args.runner) {}
+
     // The inputs to each kernel are stored contiguously in `inputs`.
     //
     // We use `kernels_[i].input_start_index` and `kernels_[i].num_inputs` to
@@ -271,18 +346,35 @@ class SingleThreadedExecutorImpl : public Executor {
     //   propagated to the inputs of kernels that depend on them.
     // * The elements corresponding to the inputs for kernel `i` are destroyed
     //   after kernel `i` executes.
-    // * In an error case (see below), we use the connectivity information in
-    //   `KernelState::output_locations` to determine which locations have been
-    //   initialized, and manually destroy them.
-    std::vector<Entry> inputs(total_num_inputs_);
+    // * In an error case, the remaining elements are destroyed with the
+    //   vector.
+    // * An element that is still uninitialized when its kernel runs holds a
+    //   dead tensor, i.e. an output of the untaken branch of a Switch.
+    std::vector<Entry> inputs;
+
+    // For graphs with control flow, `dead_control_inputs[i]` is true if
+    // `kernels_[i]` has a control input from a dead kernel.
+    std::vector<bool> dead_control_inputs;
 
     // TODO(mrry): Can we avoid copying into these vectors? Consider modifying
     // OpKernelContext to take the TensorValueVec as a pointer into `inputs`.
     TensorValueVec node_inputs;
     AllocatorAttributeVec input_alloc_attrs;
 
-    // Prepare the parameters that will be the same for all kernels.
+    // The parameters that are the same for all kernels.
     OpKernelContext::Params params;
+    Args::Runner runner;
+
+    // Only used by `RunAsync()`.
+    DoneCallback done;
+    Status status;
+    std::atomic<int> async_phase{0};
+  };
+
+  // Prepares `state` to run the kernels, and forwards the arguments and
+  // constant tensors to their consumers.
+  Status Start(const Args& args, RunState* state) const {
+    OpKernelContext::Params& params = state->params;
     params.step_id = args.step_id;
     Device* device = params_.device;
     params.device = device;
@@ -296,16 +388,16 @@ class SingleThreadedExecutorImpl : public Executor {
     params.resource_manager = device->resource_manager();
     params.step_container = args.step_container;
     params.slice_reader_cache = nullptr;  // TODO(mrry): Too severe?
-    params.inputs = &node_inputs;
-    params.input_alloc_attrs = &input_alloc_attrs;
+    params.inputs = &state->node_inputs;
+    params.input_alloc_attrs = &state->input_alloc_attrs;
 
-    Args::Runner runner_copy = args.runner;
-    params.runner = &runner_copy;
+    params.runner = &state->runner;
     params.run_all_kernels_inline = args.run_all_kernels_inline;
     params.stats_collector = args.stats_collector;
     params.executor_type = &kSingleThreadedExecutor;
 
-    // NOTE(mrry): We are assuming that the graph is loopless and condless.
+    // NOTE(mrry): We are assuming that the graph is loopless, so every node
+    // runs at most once in the root frame.
     params.frame_iter = FrameAndIter(0, 0);
     params.is_input_dead = false;
 
@@ -314,6 +406,10 @@ class SingleThreadedExecutorImpl : public Executor {
     // TODO(mrry): Consider implementing forwarding.
     params.forward_from_array = nullptr;
 
+    if (has_control_flow_) {
+      state->dead_control_inputs.resize(kernels_.size());
+    }
+
     const size_t received_args =
         args.call_frame ? args.call_frame->num_args() : 0;
     if (arg_output_locations_.size() > received_args) {
@@ -322,6 +418,8 @@ class SingleThreadedExecutorImpl : public Executor {
                                      received_args, ".");
     }
 
+    std::vector<Entry>& inputs = state->inputs;
+
     // ArgOp is a relatively expensive OpKernel due to the Tensor
     // allocations that it performs. Therefore we specialize its implementation
     // and forward arguments directly to the inputs of kernels that consume
@@ -374,91 +472,189 @@ class SingleThreadedExecutorImpl : public Executor {
         input.const_tensor = &kernel_state.const_tensor;
       }
     }
+    return Status::OK();
+  }
 
-    // Execute the kernels one-at-a-time in topological order.
-    for (size_t i = 0; i < kernels_.size(); ++i) {
-      const KernelState& kernel_state = kernels_[i];
-
-      // Prepare the per-kernel parameters.
-      const size_t input_start_index = kernel_state.input_start_index;
-      const size_t num_inputs = kernel_state.num_inputs;
-      const size_t num_outputs = kernel_state.num_outputs;
-
-      node_inputs.clear();
-      node_inputs.resize(num_inputs);
-      input_alloc_attrs.clear();
-      input_alloc_attrs.resize(num_inputs);
+  // Prepares the inputs of `kernels_[i]`. Returns false if the kernel is dead
+  // and must not run, in which case its outputs are dead too.
+  bool PrepareInputs(size_t i, RunState* state) const {
+    const KernelState& kernel_state = kernels_[i];
+    const size_t input_start_index = kernel_state.input_start_index;
+    const size_t num_inputs = kernel_state.num_inputs;
+    std::vector<Entry>& inputs = state->inputs;
+
+    if (has_control_flow_) {
+      // A Merge is dead if all of its data inputs are; any other kernel is dead
+      // if one of its inputs is, except for ControlTrigger, which never is.
+      size_t num_dead_inputs = 0;
       for (size_t j = 0; j < num_inputs; ++j) {
-        Entry& input = inputs[input_start_index + j];
-        switch (input.state) {
-          case Entry::State::HAS_CONST_TENSOR:
-            // NOTE(mrry): This `const_cast` is necessary because `TensorValue`
-            // stores a non-const `Tensor*`, and relies on the `OpKernelContext`
-            // accessors making dynamic checks that prevent using an immutable
-            // tensor as a mutable tensor.
-            node_inputs[j].tensor = const_cast<Tensor*>(input.const_tensor);
-            break;
-          case Entry::State::HAS_VALUE:
-            node_inputs[j].tensor = input.val.get();
-            break;
-          default:
-            DCHECK(false) << "Input did not have a valid value.";
+        if (inputs[input_start_index + j].state == Entry::State::NO_VALUE) {
+          ++num_dead_inputs;
         }
-        input_alloc_attrs[j] = input_alloc_attrs_[input_start_index + j];
       }
-      params.op_kernel = kernel_state.kernel;
-      params.output_attr_array = kernel_state.output_alloc_attrs.data();
-      OpKernelContext ctx(&params, num_outputs);
-
-      // Actually execute the kernel.
-      device->Compute(kernel_state.kernel, &ctx);
-      TF_RETURN_IF_ERROR(ctx.status());
+      bool is_dead;
+      if (kernel_state.is_merge) {
+        is_dead = num_dead_inputs == num_inputs;
+      } else {
+        is_dead = num_dead_inputs > 0 || state->dead_control_inputs[i];
+      }
+      if (is_dead && !kernel_state.is_control_trigger) {
+        for (size_t j = 0; j < num_inputs; ++j) {
+          inputs[input_start_index + j].ClearVal();
+        }
+        for (size_t k : kernel_state.control_output_kernels) {
+          state->dead_control_inputs[k] = true;
+        }
+        return false;
+      }
+    }
 
-      // Free the inputs to the current kernel.
-      for (size_t j = 0; j < num_inputs; ++j) {
-        inputs[input_start_index + j].ClearVal();
+    TensorValueVec& node_inputs = state->node_inputs;
+    AllocatorAttributeVec& input_alloc_attrs = state->input_alloc_attrs;
+    node_inputs.clear();
+    node_inputs.resize(num_inputs);
+    input_alloc_attrs.clear();
+    input_alloc_attrs.resize(num_inputs);
+    for (size_t j = 0; j < num_inputs; ++j) {
+      Entry& input = inputs[input_start_index + j];
+      switch (input.state) {
+        case Entry::State::HAS_CONST_TENSOR:
+          // NOTE(mrry): This `const_cast` is necessary because `TensorValue`
+          // stores a non-const `Tensor*`, and relies on the `OpKernelContext`
+          // accessors making dynamic checks that prevent using an immutable
+          // tensor as a mutable tensor.
+          node_inputs[j].tensor = const_cast<Tensor*>(input.const_tensor);
+          break;
+        case Entry::State::HAS_VALUE:
+          node_inputs[j].tensor = input.val.get();
+          break;
+        case Entry::State::NO_VALUE:
+          // A dead input of a Merge, which the kernel sees as missing.
+          DCHECK(has_control_flow_) << "Input did not have a valid value.";
+          break;
+        default:
+          DCHECK(false) << "Input did not have a valid value.";
       }
+      input_alloc_attrs[j] = input_alloc_attrs_[input_start_index + j];
+    }
+    state->params.op_kernel = kernel_state.kernel;
+    state->params.output_attr_array = kernel_state.output_alloc_attrs.data();
+    return true;
+  }
 
-      // Forward the outputs of the kernel to the inputs of subsequent kernels.
-      for (size_t j = 0; j < num_outputs; ++j) {
-        TensorValue val = ctx.release_output(j);
-        const size_t num_destinations = kernel_state.output_locations[j].size();
-        if (num_destinations > 0) {
-          // TODO(mrry): Consider flattening the `output_locations` vector
-          // to improve the cache-friendliness of this loop.
-          for (size_t k = 0; k < num_destinations - 1; ++k) {
-            // TODO(mrry): Validate that the types match the expected values or
-            // ensure that the necessary validation has already happened.
-            Entry& input = inputs[kernel_state.output_locations[j][k]];
-            input.state = Entry::State::HAS_VALUE;
-            input.val.Init(*val.tensor);
-          }
-          // Move `arg` to the last consumer to avoid the cost of copying it.
-          Entry& input =
-              inputs[kernel_state.output_locations[j][num_destinations - 1]];
+  // Frees the inputs of `kernels_[i]` after it ran, and forwards its outputs
+  // to the inputs of subsequent kernels.
+  Status ProcessOutputs(size_t i, OpKernelContext* ctx,
+                        RunState* state) const {
+    TF_RETURN_IF_ERROR(ctx->status());
+    const KernelState& kernel_state = kernels_[i];
+    std::vector<Entry>& inputs = state->inputs;
+
+    // Free the inputs to the current kernel.
+    for (size_t j = 0; j < kernel_state.num_inputs; ++j) {
+      inputs[kernel_state.input_start_index + j].ClearVal();
+    }
+
+    // Forward the outputs of the kernel to the inputs of subsequent kernels.
+    for (size_t j = 0; j < kernel_state.num_outputs; ++j) {
+      TensorValue val = ctx->release_output(j);
+      const size_t num_destinations = kernel_state.output_locations[j].size();
+      // A missing output, e.g. of the untaken branch of a Switch, is dead.
+      if (val.tensor != nullptr && num_destinations > 0) {
+        // TODO(mrry): Consider flattening the `output_locations` vector
+        // to improve the cache-friendliness of this loop.
+        for (size_t k = 0; k < num_destinations - 1; ++k) {
+          // TODO(mrry): Validate that the types match the expected values or
+          // ensure that the necessary validation has already happened.
+          Entry& input = inputs[kernel_state.output_locations[j][k]];
           input.state = Entry::State::HAS_VALUE;
-          input.val.Init(std::move(*val.tensor));
+          input.val.Init(*val.tensor);
         }
-        delete val.tensor;
+        // Move `arg` to the last consumer to avoid the cost of copying it.
+        Entry& input =
+            inputs[kernel_state.output_locations[j][num_destinations - 1]];
+        input.state = Entry::State::HAS_VALUE;
+        input.val.Init(std::move(*val.tensor));
       }
+      delete val.tensor;
     }
     return Status::OK();
   }
 
-  void RunAsync(const Args& args, DoneCallback done) override {
-    done(Run(args));
+  // Runs `kernels_[i]` onwards for `RunAsync()`. Synchronous kernels run in
+  // place, and an async kernel resumes the loop from its done callback rather
+  // than blocking the thread until it completes.
+  void RunFrom(size_t i, RunState* state) const {
+    for (; i < kernels_.size(); ++i) {
+      if (!PrepareInputs(i, state)) {
+        continue;
+      }
+      const KernelState& kernel_state = kernels_[i];
+      if (kernel_state.async_kernel == nullptr) {
+        OpKernelContext ctx(&state->params, kernel_state.num_outputs);
+        params_.device->Compute(kernel_state.kernel, &ctx);
+        Status s = ProcessOutputs(i, &ctx, state);
+        if (!s.ok()) {
+          Finish(state, s);
+          return;
+        }
+        continue;
+      }
+
+      // Whichever of this call and the done callback finishes second resumes
+      // the loop, so that kernels completing inline do not recurse.
+      state->async_phase = 0;
+      auto* ctx = new OpKernelContext(&state->params, kernel_state.num_outputs);
+      params_.device->ComputeAsync(
+          kernel_state.async_kernel, ctx, [this, i, ctx, state]() {
+            state->status = ProcessOutputs(i, ctx, state);
+            delete ctx;
+            if (state->async_phase.fetch_add(1) == 1) {
+              Resume(i + 1, state);
+            }
+          });
+      if (state->async_phase.fetch_add(1) == 0) {
+        return;
+      }
+      if (!state->status.ok()) {
+        Finish(state, state->status);
+        return;
+      }
+    }
+    Finish(state, Status::OK());
+  }
+
+  void Resume(size_t i, RunState* state) const {
+    if (!state->status.ok()) {
+      Finish(state, state->status);
+      return;
+    }
+    RunFrom(i, state);
+  }
+
+  static void Finish(RunState* state, const Status& s) {
+    DoneCallback done = std::move(state->done);
+    delete state;
+    done(s);
   }
 
- private:
   const LocalExecutorParams params_;
 
   // All following members are read-only after Initialize().
 
   // The sum of the number of inputs for each node in the graph. This determines
-  // the length of the flat `inputs` vector. See comment at the beginning of
-  // `RunAsync()` for details.
+  // the length of the flat `inputs` vector. See comment on `RunState::inputs`
+  // for details.
   size_t total_num_inputs_;
 
+  // True if the graph contains Switch or Merge nodes, whose dead outputs must
+  // be propagated.
+  bool has_control_flow_ = false;
+
+  // True if the graph contains async kernels, which are run without blocking
+  // by `RunAsync()`.
+  bool has_async_kernels_ = false;
+
   // Represents cached graph structure state for each kernel.
   struct KernelState {
     // The kernel object. Not owned.
@@ -467,6 +663,9 @@ class SingleThreadedExecutorImpl : public Executor {
     // `params_.delete_kernel()`.
     OpKernel* kernel;
 
+    // `kernel` if it is an `AsyncOpKernel`, and nullptr otherwise.
+    AsyncOpKernel* async_kernel;
+
     // These fields determine the range of elements in `inputs` that corresponds
     // to the inputs of `kernel`.
     size_t input_start_index;
@@ -474,15 +673,22 @@ class SingleThreadedExecutorImpl : public Executor {
 
     size_t num_outputs;
 
+    bool is_merge;
+    bool is_control_trigger;
+
     // For the `j`th output of `kernel`, `output_locations[j]` contains the
     // locations in the flat `inputs` vector to which that output must be
-    // copied. See comment at the beginning of `Run()` for details.
+    // copied. See comment on `RunState::inputs` for details.
     std::vector<std::vector<size_t>>
         output_locations;  // Length = `num_outputs`.
 
     // Memory space information for each output of `kernel`.
     std::vector<AllocatorAttributes>
         output_alloc_attrs;  // Length = `num_outputs`.
+
+    // For graphs with control flow, the indices of the kernels that have a
+    // control input from `kernel`.
+    std::vector<size_t> control_output_kernels;
   };
   std::vector<KernelState> kernels_;
 
@@ -510,7 +716,7 @@ class SingleThreadedExecutorImpl : public Executor {
 
     // For the single output of `kernel`, `output_locations` contains the
     // locations in the flat `inputs` vector to which that output must be
-    // copied. See comment at the beginning of `Run()` for details.
+    // copied. See comment on `RunState::inputs` for details.
     std::vector<size_t> output_locations;  // Length = `num_outputs`.
 
     // Memory space information for the single output of `kernel`.
@@ -519,8 +725,8 @@ class SingleThreadedExecutorImpl : public Executor {
   std::vector<ConstTensorKernelState> const_tensor_kernels_;
 
   // Memory space information for each input. This information is stored in the
-  // same order as the flat `inputs` vector. See comment at the beginning of
-  // `RunAsync()` for details.
+  // same order as the flat `inputs` vector. See comment on `RunState::inputs`
+  // for details.
   std::vector<AllocatorAttributes>
       input_alloc_attrs_;  // Length = `total_num_inputs_`.
 };
@@ -24,9 +24,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
@@ -273,6 +275,82 @@ TEST_F(ExecutorTest, ControlDependenciesFromSpecialNodes) {
   EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
 }
 
+// Builds the lowered form of `pred ? x + x : x + 10`.
+std::unique_ptr<Graph> BuildCond() {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto switch_x = test::graph::Switch(g.get(), x, pred);
+  auto else_x = test::graph::Identity(g.get(), switch_x, 0);
+  auto then_x = test::graph::Identity(g.get(), switch_x, 1);
+  // The constant is only live on the else branch.
+  auto ten = test::graph::Constant(g.get(), V(10.0));
+  g->AddControlEdge(else_x, ten);
+  auto else_out = test::graph::Add(g.get(), else_x, ten);
+  auto then_out = test::graph::Add(g.get(), then_x, then_x);
+  auto merge = test::graph::Merge(g.get(), else_out, then_out);
+  test::graph::Retval(g.get(), 0, merge);
+  FixupSourceAndSinkEdges(g.get());
+  return g;
+}
+
+TEST_F(ExecutorTest, LoweredCond) {
+  Create(BuildCond());
+  for (bool pred : {true, false}) {
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(3.0), VB(pred)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(pred ? 6.0 : 13.0, V(retvals[0]));
+  }
+}
+
+REGISTER_OP("SingleThreadedExecutorTestAsyncIdentity")
+    .Input("input: float")
+    .Output("output: float");
+
+// Forwards its input from another thread.
+class AsyncIdentityOp : public AsyncOpKernel {
+ public:
+  explicit AsyncIdentityOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {}
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    Env::Default()->SchedClosure([ctx, done]() {
+      ctx->set_output(0, ctx->input(0));
+      done();
+    });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("SingleThreadedExecutorTestAsyncIdentity").Device(DEVICE_CPU),
+    AsyncIdentityOp);
+
+TEST_F(ExecutorTest, AsyncKernels) {
+  // v_i = async_identity(v_{i-1}) + a, with v_0 = a.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  Node* v = in;
+  for (int i = 0; i < 10; ++i) {
+    Node* async_identity;
+    TF_ASSERT_OK(
+        NodeBuilder(g->NewName("n"), "SingleThreadedExecutorTestAsyncIdentity")
+            .Input(v)
+            .Finalize(g.get(), &async_identity));
+    v = test::graph::Add(g.get(), async_identity, in);
+  }
+  test::graph::Retval(g.get(), 0, v);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(11.0, V(retvals[0]));
+}
+
 static void BM_executor(int iters, int width, int depth) {
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
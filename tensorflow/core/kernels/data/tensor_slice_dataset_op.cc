@@ -77,6 +77,26 @@ class TensorSliceDatasetOp::Dataset : public DatasetBase {
 
   int64 Cardinality() const override { return tensors_[0].dim_size(0); }
 
+  bool SupportsRandomAccess() const override { return true; }
+
+  Status Get(IteratorContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    if (index < 0 || index >= Cardinality()) {
+      return errors::OutOfRange("Index out of range [0, ", Cardinality(),
+                                "):", index);
+    }
+    out_tensors->clear();
+    out_tensors->reserve(tensors_.size());
+    for (size_t i = 0; i < tensors_.size(); ++i) {
+      out_tensors->emplace_back(ctx->allocator({}), tensors_[i].dtype(),
+                                shapes_[i]);
+      TF_RETURN_IF_ERROR(
+          batch_util::CopySliceToElement(tensors_[i], &out_tensors->back(),
+                                         index));
+    }
+    return Status::OK();
+  }
+
   Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
     return Status::OK();
   }
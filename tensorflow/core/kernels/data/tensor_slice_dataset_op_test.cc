@@ -343,6 +343,24 @@ TEST_F(TensorSliceDatasetOpTest, SplitProviderEmpty) {
       CreateTensors<int64>(TensorShape({}), {})));
 }
 
+TEST_F(TensorSliceDatasetOpTest, RandomAccess) {
+  auto params = TensorSliceDatasetParams(
+      {CreateTensor<int64>(TensorShape({3}), {6, 2, 3}),
+       CreateTensor<tstring>(TensorShape({3, 1}), {"a", "b", "c"})},
+      kNodeName);
+  TF_ASSERT_OK(Initialize(params));
+  EXPECT_TRUE(dataset_->SupportsRandomAccess());
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(dataset_->Get(iterator_ctx_.get(), 1, &out_tensors));
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors,
+      {CreateTensor<int64>(TensorShape({}), {2}),
+       CreateTensor<tstring>(TensorShape({1}), {"b"})},
+      /*compare_order=*/true));
+  EXPECT_EQ(dataset_->Get(iterator_ctx_.get(), 3, &out_tensors).code(),
+            tensorflow::error::OUT_OF_RANGE);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
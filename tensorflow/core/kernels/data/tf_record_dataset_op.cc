@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -159,6 +160,38 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     }
 
    protected:
+    Status SkipInternal(IteratorContext* ctx, int num_to_skip,
+                        bool* end_of_sequence, int* num_skipped) override {
+      *num_skipped = 0;
+      mutex_lock l(mu_);
+      do {
+        // We are currently processing a file, so try to skip the remaining
+        // records in it.
+        if (reader_) {
+          int num_skipped_in_file = 0;
+          Status s = SkipRecordsLocked(ctx->env(), num_to_skip - *num_skipped,
+                                       &num_skipped_in_file);
+          *num_skipped += num_skipped_in_file;
+          if (s.ok()) {
+            *end_of_sequence = false;
+            return Status::OK();
+          }
+          ResetStreamsLocked();
+          ++current_file_index_;
+          if (!errors::IsOutOfRange(s)) {
+            return s;
+          }
+        }
+
+        if (current_file_index_ == dataset()->filenames_.size()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+      } while (true);
+    }
+
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
       return model::MakeSourceNode(std::move(args));
@@ -215,6 +248,62 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
       file_.reset();
+      index_.clear();
+      index_loaded_ = false;
+    }
+
+    // Skips up to `num_to_skip` records of the current file. Returns an
+    // `OutOfRange` error if the end of the file is reached first.
+    //
+    // If the file has a record index, the reader seeks past the skipped
+    // records without reading them. Otherwise it reads their headers only.
+    Status SkipRecordsLocked(Env* env, int num_to_skip, int* num_skipped)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!index_loaded_) {
+        LoadIndexLocked(env);
+        index_loaded_ = true;
+      }
+      const uint64 offset = reader_->TellOffset();
+      auto it = std::lower_bound(index_.begin(), index_.end(), offset);
+      if (it == index_.end() || *it != offset) {
+        return reader_->SkipRecords(num_to_skip, num_skipped);
+      }
+      const int64 position = it - index_.begin();
+      const int64 num_records = index_.size() - 1;
+      *num_skipped = std::min<int64>(num_to_skip, num_records - position);
+      TF_RETURN_IF_ERROR(reader_->SeekOffset(index_[position + *num_skipped]));
+      if (*num_skipped < num_to_skip) {
+        return errors::OutOfRange("eof");
+      }
+      return Status::OK();
+    }
+
+    // Reads the record index of the current file into `index_`, or leaves
+    // `index_` empty if the file has no valid index.
+    void LoadIndexLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const string& filename = dataset()->filenames_[current_file_index_];
+      const string index_filename = io::RecordIndexFilename(filename);
+      if (!env->FileExists(index_filename).ok()) {
+        return;
+      }
+      Status s = io::ReadRecordIndex(env, index_filename, &index_);
+      if (s.ok() && dataset()->options_.compression_type ==
+                        io::RecordReaderOptions::NONE) {
+        // A stale index would silently drop or corrupt records, so check that
+        // it covers the whole file.
+        uint64 file_size;
+        s = env->GetFileSize(filename, &file_size);
+        if (s.ok() && file_size != index_.back()) {
+          s = errors::FailedPrecondition(
+              "the index ends at offset ", index_.back(),
+              " but the file has ", file_size, " bytes");
+        }
+      }
+      if (!s.ok()) {
+        LOG(WARNING) << "Ignoring the record index " << index_filename
+                     << ": " << s;
+        index_.clear();
+      }
     }
 
     mutex mu_;
@@ -224,6 +313,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    // The record index of the current file, loaded on the first skip in the
+    // file. It is empty if the file has no index.
+    std::vector<uint64> index_ TF_GUARDED_BY(mu_);
+    bool index_loaded_ TF_GUARDED_BY(mu_) = false;
   };
 
   const std::vector<string> filenames_;
@@ -12,6 +12,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/tf_record_dataset_op.h"
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/record_index.h"
 
 namespace tensorflow {
 namespace data {
@@ -225,6 +226,100 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(TFRecordDatasetOpTest, TFRecordDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+// Uncompressed files, with a record index next to each file if `with_index`.
+TFRecordDatasetParams SkipDatasetParams(const string& prefix,
+                                        bool with_index) {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/", prefix, "_1"),
+      absl::StrCat(testing::TmpDir(), "/", prefix, "_2")};
+  std::vector<std::vector<string>> contents = {{"1", "22", "333"},
+                                               {"a", "bb", "ccc"}};
+  TF_CHECK_OK(
+      CreateTestFiles(filenames, contents, CompressionType::UNCOMPRESSED));
+  if (with_index) {
+    for (const tstring& filename : filenames) {
+      std::unique_ptr<RandomAccessFile> file;
+      TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
+      std::vector<uint64> offsets;
+      TF_CHECK_OK(
+          io::BuildRecordIndex(file.get(), io::RecordReaderOptions(), &offsets));
+      TF_CHECK_OK(io::WriteRecordIndex(
+          Env::Default(), io::RecordIndexFilename(filename), offsets));
+    }
+  }
+  return TFRecordDatasetParams(filenames,
+                               /*compression_type=*/
+                               CompressionType::UNCOMPRESSED,
+                               /*buffer_size=*/10,
+                               /*node_name=*/kNodeName);
+}
+
+class TFRecordDatasetSkipTest : public TFRecordDatasetOpTest,
+                                public ::testing::WithParamInterface<bool> {};
+
+TEST_P(TFRecordDatasetSkipTest, SkipAcrossFiles) {
+  const bool with_index = GetParam();
+  auto dataset_params = SkipDatasetParams(
+      with_index ? "tf_record_skip_index" : "tf_record_skip", with_index);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  int num_skipped = 0;
+  std::vector<Tensor> out_tensors;
+
+  TF_ASSERT_OK(
+      iterator_->Skip(iterator_ctx_.get(), 1, &end_of_sequence, &num_skipped));
+  EXPECT_FALSE(end_of_sequence);
+  EXPECT_EQ(num_skipped, 1);
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  TF_EXPECT_OK(ExpectEqual(out_tensors,
+                           CreateTensors<tstring>(TensorShape({}), {{"22"}}),
+                           /*compare_order=*/true));
+
+  // Skips "333" and "a", in two files.
+  TF_ASSERT_OK(
+      iterator_->Skip(iterator_ctx_.get(), 2, &end_of_sequence, &num_skipped));
+  EXPECT_FALSE(end_of_sequence);
+  EXPECT_EQ(num_skipped, 2);
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  TF_EXPECT_OK(ExpectEqual(out_tensors,
+                           CreateTensors<tstring>(TensorShape({}), {{"bb"}}),
+                           /*compare_order=*/true));
+
+  TF_ASSERT_OK(
+      iterator_->Skip(iterator_ctx_.get(), 5, &end_of_sequence, &num_skipped));
+  EXPECT_TRUE(end_of_sequence);
+  EXPECT_EQ(num_skipped, 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(TFRecordDatasetOpTest, TFRecordDatasetSkipTest,
+                         ::testing::Bool());
+
+TEST_F(TFRecordDatasetOpTest, SkipIgnoresStaleIndex) {
+  auto dataset_params =
+      SkipDatasetParams("tf_record_skip_stale_index", /*with_index=*/false);
+  // The index of a file with a single record.
+  TF_ASSERT_OK(io::WriteRecordIndex(
+      Env::Default(),
+      io::RecordIndexFilename(absl::StrCat(
+          testing::TmpDir(), "/tf_record_skip_stale_index_1")),
+      {0, 13}));
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  int num_skipped = 0;
+  TF_ASSERT_OK(
+      iterator_->Skip(iterator_ctx_.get(), 2, &end_of_sequence, &num_skipped));
+  EXPECT_EQ(num_skipped, 2);
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  TF_EXPECT_OK(ExpectEqual(out_tensors,
+                           CreateTensors<tstring>(TensorShape({}), {{"333"}}),
+                           /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
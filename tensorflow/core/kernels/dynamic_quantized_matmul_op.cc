@@ -0,0 +1,213 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements a float matmul against int8 weights that quantizes its float
+// input on the fly ("dynamic range quantization"). See docs in
+// ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+
+#include "ruy/context.h"  // from @ruy
+#include "ruy/matrix.h"  // from @ruy
+#include "ruy/mul_params.h"  // from @ruy
+#include "ruy/ruy.h"  // from @ruy
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// Output blocks narrower than this are not worth a separate GEMM.
+constexpr int64 kMinColsPerBlock = 64;
+
+// Quantizes `size` floats, `stride` apart, symmetrically to [-127, 127] and
+// returns the scale that dequantizes them.
+float QuantizeRow(const float* values, int64 size, int64 stride,
+                  int8* quantized) {
+  float max_abs = 0;
+  for (int64 i = 0; i < size; ++i) {
+    max_abs = std::max(max_abs, std::abs(values[i * stride]));
+  }
+  if (max_abs == 0) {
+    std::fill(quantized, quantized + size, 0);
+    return 1;
+  }
+  const float scale = max_abs / 127;
+  const float inverse_scale = 127 / max_abs;
+  for (int64 i = 0; i < size; ++i) {
+    const float value = std::round(values[i * stride] * inverse_scale);
+    quantized[i] =
+        static_cast<int8>(std::min(127.0f, std::max(-127.0f, value)));
+  }
+  return scale;
+}
+
+// Computes the int32 product of rows [row_begin, row_end) of the row-major
+// [m, k] matrix `lhs` and columns [col_begin, col_end) of the column-major
+// [k, n] matrix `rhs` into the row-major [m, n] matrix `result`.
+void RuyMultiply(const int8* lhs, const int8* rhs, int32* result, int64 n,
+                 int64 k, int64 row_begin, int64 row_end, int64 col_begin,
+                 int64 col_end) {
+  // Kernels run concurrently, so each thread uses its own single-threaded
+  // context; the parallelism comes from the TensorFlow worker threads.
+  thread_local ruy::Context context;
+
+  ruy::Matrix<int8> ruy_lhs;
+  ruy::MakeSimpleLayout(row_end - row_begin, k, ruy::Order::kRowMajor,
+                        ruy_lhs.mutable_layout());
+  ruy_lhs.set_data(lhs + row_begin * k);
+
+  ruy::Matrix<int8> ruy_rhs;
+  ruy::MakeSimpleLayout(k, col_end - col_begin, ruy::Order::kColMajor,
+                        ruy_rhs.mutable_layout());
+  ruy_rhs.set_data(rhs + col_begin * k);
+
+  ruy::Matrix<int32> ruy_result;
+  ruy::MakeSimpleLayout(row_end - row_begin, col_end - col_begin,
+                        ruy::Order::kRowMajor, ruy_result.mutable_layout());
+  ruy_result.mutable_layout()->set_stride(n);
+  ruy_result.set_data(result + row_begin * n + col_begin);
+
+  ruy::MulParams<int32, int32> mul_params;
+  ruy::Mul(ruy_lhs, ruy_rhs, mul_params, &context, &ruy_result);
+}
+
+}  // namespace
+
+class DynamicQuantizedMatMulOp : public OpKernel {
+ public:
+  explicit DynamicQuantizedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    const Tensor& b_scales = context->input(2);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix. Instead it has "
+                                        "shape ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix. Instead it has "
+                                        "shape ",
+                                        b.shape().DebugString()));
+    const int64 m = a.dim_size(transpose_a_ ? 1 : 0);
+    const int64 k = a.dim_size(transpose_a_ ? 0 : 1);
+    const int64 n = b.dim_size(0);
+    OP_REQUIRES(context, b.dim_size(1) == k,
+                errors::InvalidArgument("Matrix size-incompatible: In[0]: ",
+                                        a.shape().DebugString(), ", In[1]: ",
+                                        b.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(b_scales.shape()) &&
+                    b_scales.dim_size(0) == n,
+                errors::InvalidArgument("b_scales must be a vector of size ",
+                                        n, ", got shape ",
+                                        b_scales.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({m, n}), &output));
+    if (output->NumElements() == 0) {
+      return;
+    }
+    if (k == 0) {
+      output->flat<float>().setZero();
+      return;
+    }
+
+    Tensor quantized_a;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_INT8, TensorShape({m, k}), &quantized_a));
+    Tensor a_scales;
+    OP_REQUIRES_OK(context, context->allocate_temp(DT_FLOAT, TensorShape({m}),
+                                                   &a_scales));
+    Tensor product;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_INT32, TensorShape({m, n}), &product));
+
+    const float* a_data = a.flat<float>().data();
+    int8* quantized_a_data = quantized_a.flat<int8>().data();
+    float* a_scales_data = a_scales.flat<float>().data();
+    const int8* b_data = reinterpret_cast<const int8*>(b.flat<qint8>().data());
+    const float* b_scales_data = b_scales.flat<float>().data();
+    int32* product_data = product.flat<int32>().data();
+    float* output_data = output->flat<float>().data();
+
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *(context->device()->tensorflow_cpu_worker_threads());
+
+    // Quantize each row of `a` with its own scale, so that one outlier in a
+    // batch does not cost the other examples their precision.
+    const bool transpose_a = transpose_a_;
+    Shard(worker_threads.num_threads, worker_threads.workers, m, 4 * k,
+          [&](int64 begin, int64 end) {
+            for (int64 i = begin; i < end; ++i) {
+              a_scales_data[i] =
+                  transpose_a
+                      ? QuantizeRow(a_data + i, k, m, quantized_a_data + i * k)
+                      : QuantizeRow(a_data + i * k, k, 1,
+                                    quantized_a_data + i * k);
+            }
+          });
+
+    // Split the output into one block per thread, by rows first since that
+    // keeps the weights of a block contiguous, and by columns when there are
+    // fewer rows than threads.
+    const int64 row_blocks = std::min<int64>(m, worker_threads.num_threads);
+    const int64 col_blocks = std::max<int64>(
+        1, std::min<int64>(
+               (worker_threads.num_threads + row_blocks - 1) / row_blocks,
+               n / kMinColsPerBlock));
+    const int64 block_cost = ((m + row_blocks - 1) / row_blocks) *
+                             ((n + col_blocks - 1) / col_blocks) * k;
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          row_blocks * col_blocks, block_cost, [&](int64 begin, int64 end) {
+            for (int64 block = begin; block < end; ++block) {
+              const int64 row_block = block / col_blocks;
+              const int64 col_block = block % col_blocks;
+              const int64 row_begin = m * row_block / row_blocks;
+              const int64 row_end = m * (row_block + 1) / row_blocks;
+              const int64 col_begin = n * col_block / col_blocks;
+              const int64 col_end = n * (col_block + 1) / col_blocks;
+              RuyMultiply(quantized_a_data, b_data, product_data, n, k,
+                          row_begin, row_end, col_begin, col_end);
+              for (int64 i = row_begin; i < row_end; ++i) {
+                for (int64 j = col_begin; j < col_end; ++j) {
+                  output_data[i * n + j] = product_data[i * n + j] *
+                                           a_scales_data[i] * b_scales_data[j];
+                }
+              }
+            }
+          });
+  }
+
+ private:
+  bool transpose_a_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_DynamicQuantizedMatMul").Device(DEVICE_CPU),
+    DynamicQuantizedMatMulOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class DynamicQuantizedMatMulTest : public OpsTestBase {
+ protected:
+  void MakeOp(bool transpose_a) {
+    TF_ASSERT_OK(
+        NodeDefBuilder("dynamic_quantized_matmul", "_DynamicQuantizedMatMul")
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_QINT8))
+            .Input(FakeInput(DT_FLOAT))
+            .Attr("transpose_a", transpose_a)
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Adds the weights of output channels with dequantized values
+  // | 1  0 |, | 0  2 | and | -1  1 |.
+  void AddWeights() {
+    AddInputFromArray<qint8>(TensorShape({3, 2}),
+                             {127, 0, 0, 127, -127, 127});
+    AddInputFromArray<float>(TensorShape({3}),
+                             {1.0f / 127, 2.0f / 127, 1.0f / 127});
+  }
+};
+
+TEST_F(DynamicQuantizedMatMulTest, Small) {
+  MakeOp(/*transpose_a=*/false);
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, -3, 4});
+  AddWeights();
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Each row of `a` is quantized with its own scale, so the rows are off by
+  // at most half a step of 2/127 and 4/127 respectively.
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {1, 4, 1, -3, 8, 7});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.02);
+}
+
+TEST_F(DynamicQuantizedMatMulTest, TransposeA) {
+  MakeOp(/*transpose_a=*/true);
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, -3, 2, 4});
+  AddWeights();
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {1, 4, 1, -3, 8, 7});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.02);
+}
+
+TEST_F(DynamicQuantizedMatMulTest, ZeroRow) {
+  MakeOp(/*transpose_a=*/false);
+  AddInputFromArray<float>(TensorShape({2, 2}), {0, 0, -3, 4});
+  AddWeights();
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {0, 0, 0, -3, 8, 7});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.02);
+}
+
+TEST_F(DynamicQuantizedMatMulTest, Large) {
+  // Large enough to be split into blocks of rows and columns.
+  const int m = 37;
+  const int k = 128;
+  const int n = 300;
+  MakeOp(/*transpose_a=*/false);
+
+  std::vector<float> a(m * k);
+  for (int i = 0; i < a.size(); ++i) {
+    a[i] = std::sin(i * 0.37f);
+  }
+  std::vector<float> weights(n * k);
+  std::vector<qint8> quantized_weights(n * k);
+  std::vector<float> weight_scales(n);
+  for (int j = 0; j < n; ++j) {
+    weight_scales[j] = 1.0f / 127;
+    for (int p = 0; p < k; ++p) {
+      const int value = (j * 31 + p * 17) % 255 - 127;
+      quantized_weights[j * k + p] = value;
+      weights[j * k + p] = value * weight_scales[j];
+    }
+  }
+  AddInputFromArray<float>(TensorShape({m, k}), a);
+  AddInputFromArray<qint8>(TensorShape({n, k}), quantized_weights);
+  AddInputFromArray<float>(TensorShape({n}), weight_scales);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({m, n}));
+  auto expected_matrix = expected.matrix<float>();
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float sum = 0;
+      for (int p = 0; p < k; ++p) {
+        sum += a[i * k + p] * weights[j * k + p];
+      }
+      expected_matrix(i, j) = sum;
+    }
+  }
+  // Each of the k products is off by at most half a step of 1/127.
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), k * 0.5f / 127);
+}
+
+TEST_F(DynamicQuantizedMatMulTest, IncompatibleShapes) {
+  MakeOp(/*transpose_a=*/false);
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddWeights();
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace tensorflow
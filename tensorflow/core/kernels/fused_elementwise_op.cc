@@ -0,0 +1,394 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the _FusedElementwise op, created by the elementwise fusion pass
+// (see common_runtime/elementwise_fusion_pass.cc) for chains of cwise ops.
+
+#define EIGEN_USE_THREADS
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#define EIGEN_USE_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include "tensorflow/core/kernels/fused_elementwise_op.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The chain is evaluated one block at a time, so that the block stays in
+// cache across the fused ops.
+constexpr int64 kBlockSize = 1024;
+// A rough estimate of the cost of one op on one element, in cycles.
+constexpr int64 kCostPerOp = 4;
+
+template <typename T>
+using Block = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+template <typename T>
+using ConstBlock = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+template <typename T>
+using UnaryFn = void (*)(Block<T>* x);
+
+// Applies `f(lhs, rhs)` to `x` and a block of an argument that is either a
+// scalar or has the shape of `x`.
+template <typename T, typename F>
+void ApplyBinary(Block<T>* x, const T* arg, bool arg_is_scalar,
+                 bool arg_is_lhs, F f) {
+  const int64 n = x->size();
+  if (arg_is_scalar) {
+    const auto y = Eigen::Array<T, Eigen::Dynamic, 1>::Constant(n, *arg);
+    if (arg_is_lhs) {
+      *x = f(y, *x);
+    } else {
+      *x = f(*x, y);
+    }
+  } else {
+    const ConstBlock<T> y(arg, n);
+    if (arg_is_lhs) {
+      *x = f(y, *x);
+    } else {
+      *x = f(*x, y);
+    }
+  }
+}
+
+template <typename T>
+using BinaryFn = void (*)(Block<T>* x, const T* arg, bool arg_is_scalar,
+                          bool arg_is_lhs);
+
+#define BINARY_FN(expr)                                                   \
+  [](Block<T>* x, const T* arg, bool arg_is_scalar, bool arg_is_lhs) {    \
+    ApplyBinary<T>(x, arg, arg_is_scalar, arg_is_lhs,                     \
+                   [](const auto& a, const auto& b) { return (expr); }); \
+  }
+
+// The ops below must be kept in sync with the elementwise fusion pass.
+template <typename T>
+UnaryFn<T> GetUnaryFn(const string& op) {
+  if (op == "Abs") return [](Block<T>* x) { *x = x->abs(); };
+  if (op == "Exp") return [](Block<T>* x) { *x = x->exp(); };
+  if (op == "Log") return [](Block<T>* x) { *x = x->log(); };
+  if (op == "Neg") return [](Block<T>* x) { *x = -*x; };
+  if (op == "Reciprocal") return [](Block<T>* x) { *x = x->inverse(); };
+  if (op == "Relu") return [](Block<T>* x) { *x = x->max(T(0)); };
+  if (op == "Relu6") {
+    return [](Block<T>* x) { *x = x->max(T(0)).min(T(6)); };
+  }
+  if (op == "Rsqrt") return [](Block<T>* x) { *x = x->rsqrt(); };
+  if (op == "Sigmoid") {
+    return [](Block<T>* x) {
+      *x = x->unaryExpr(Eigen::internal::scalar_logistic_op<T>());
+    };
+  }
+  if (op == "Sqrt") return [](Block<T>* x) { *x = x->sqrt(); };
+  if (op == "Square") return [](Block<T>* x) { *x = x->square(); };
+  if (op == "Tanh") return [](Block<T>* x) { *x = x->tanh(); };
+  return nullptr;
+}
+
+template <typename T>
+BinaryFn<T> GetBinaryFn(const string& op) {
+  if (op == "Add" || op == "AddV2") return BINARY_FN(a + b);
+  if (op == "Maximum") return BINARY_FN(a.max(b));
+  if (op == "Minimum") return BINARY_FN(a.min(b));
+  if (op == "Mul") return BINARY_FN(a * b);
+  if (op == "RealDiv") return BINARY_FN(a / b);
+  if (op == "SquaredDifference") return BINARY_FN((a - b).square());
+  if (op == "Sub") return BINARY_FN(a - b);
+  return nullptr;
+}
+
+#undef BINARY_FN
+
+Status ValidateArgs(const Tensor& x, const OpInputList& args) {
+  for (int i = 0; i < args.size(); ++i) {
+    if (!TensorShapeUtils::IsScalar(args[i].shape()) &&
+        args[i].shape() != x.shape()) {
+      return errors::InvalidArgument(
+          "args[", i, "] must be a scalar or have the shape of x: ",
+          args[i].shape().DebugString(), " vs. ", x.shape().DebugString());
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    std::vector<bool> arg_is_lhs;
+    OP_REQUIRES_OK(context, context->GetAttr("arg_is_lhs", &arg_is_lhs));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES(context, static_cast<int>(arg_is_lhs.size()) == num_args,
+                errors::InvalidArgument("Expected ", num_args,
+                                        " values for arg_is_lhs, got ",
+                                        arg_is_lhs.size()));
+
+    int arg = 0;
+    for (const string& op : fused_ops) {
+      Stage stage;
+      stage.unary = GetUnaryFn<T>(op);
+      if (stage.unary == nullptr) {
+        stage.binary = GetBinaryFn<T>(op);
+        OP_REQUIRES(context, stage.binary != nullptr,
+                    errors::Unimplemented("Unsupported fused op: ", op));
+        OP_REQUIRES(context, arg < num_args,
+                    errors::InvalidArgument("Too few args for fused ops: ",
+                                            absl::StrJoin(fused_ops, ",")));
+        stage.arg = arg;
+        stage.arg_is_lhs = arg_is_lhs[arg];
+        ++arg;
+      }
+      stages_.push_back(stage);
+    }
+    OP_REQUIRES(context, arg == num_args,
+                errors::InvalidArgument("Too many args for fused ops: ",
+                                        absl::StrJoin(fused_ops, ",")));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OpInputList args;
+    OP_REQUIRES_OK(context, context->input_list("args", &args));
+    OP_REQUIRES_OK(context, ValidateArgs(x, args));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    const int64 n = x.NumElements();
+    if (n == 0) return;
+
+    const T* x_data = x.flat<T>().data();
+    T* y_data = y->flat<T>().data();
+    auto eval_blocks = [&](int64 begin_block, int64 end_block) {
+      const int64 begin = begin_block * kBlockSize;
+      const int64 end = std::min(n, end_block * kBlockSize);
+      for (int64 start = begin; start < end; start += kBlockSize) {
+        const int64 size = std::min(kBlockSize, end - start);
+        Block<T> block(y_data + start, size);
+        if (x_data != y_data) {
+          block = ConstBlock<T>(x_data + start, size);
+        }
+        for (const Stage& stage : stages_) {
+          if (stage.unary != nullptr) {
+            stage.unary(&block);
+          } else {
+            const Tensor& arg = args[stage.arg];
+            const bool arg_is_scalar = arg.NumElements() == 1;
+            const T* arg_data = arg.flat<T>().data();
+            stage.binary(&block, arg_is_scalar ? arg_data : arg_data + start,
+                         arg_is_scalar, stage.arg_is_lhs);
+          }
+        }
+      }
+    };
+
+    const int64 num_blocks = (n + kBlockSize - 1) / kBlockSize;
+    const int64 cost_per_block = kBlockSize * kCostPerOp * stages_.size();
+    context->device()
+        ->tensorflow_cpu_worker_threads()
+        ->workers->ParallelFor(num_blocks, cost_per_block, eval_blocks);
+  }
+
+ private:
+  // One op of the chain; either `unary` or `binary` is set.
+  struct Stage {
+    UnaryFn<T> unary = nullptr;
+    BinaryFn<T> binary = nullptr;
+    // The index of the other input of a binary op in `args`.
+    int arg = -1;
+    bool arg_is_lhs = false;
+  };
+  std::vector<Stage> stages_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedElementwiseOp);
+};
+
+#define REGISTER_CPU(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+
+#undef REGISTER_CPU
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// Must be kept in sync with GetUnaryFn and GetBinaryFn.
+bool GetOpCode(const string& op, functor::FusedElementwiseOpCode* code) {
+  using OpCode = functor::FusedElementwiseOpCode;
+  static const auto* const kOpCodes = new std::map<string, OpCode>({
+      {"Abs", OpCode::kAbs},
+      {"Exp", OpCode::kExp},
+      {"Log", OpCode::kLog},
+      {"Neg", OpCode::kNeg},
+      {"Reciprocal", OpCode::kReciprocal},
+      {"Relu", OpCode::kRelu},
+      {"Relu6", OpCode::kRelu6},
+      {"Rsqrt", OpCode::kRsqrt},
+      {"Sigmoid", OpCode::kSigmoid},
+      {"Sqrt", OpCode::kSqrt},
+      {"Square", OpCode::kSquare},
+      {"Tanh", OpCode::kTanh},
+      {"Add", OpCode::kAdd},
+      {"AddV2", OpCode::kAdd},
+      {"Maximum", OpCode::kMaximum},
+      {"Minimum", OpCode::kMinimum},
+      {"Mul", OpCode::kMul},
+      {"RealDiv", OpCode::kRealDiv},
+      {"SquaredDifference", OpCode::kSquaredDifference},
+      {"Sub", OpCode::kSub},
+  });
+  auto it = kOpCodes->find(op);
+  if (it == kOpCodes->end()) return false;
+  *code = it->second;
+  return true;
+}
+
+}  // namespace
+
+// Evaluates the chain with one kernel launch per kMaxStages ops. The program
+// depends only on the attrs, so it is built once and reused for every input
+// shape.
+template <typename T>
+class FusedElementwiseGpuOp : public OpKernel {
+ public:
+  explicit FusedElementwiseGpuOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    std::vector<bool> arg_is_lhs;
+    OP_REQUIRES_OK(context, context->GetAttr("arg_is_lhs", &arg_is_lhs));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES(context, static_cast<int>(arg_is_lhs.size()) == num_args,
+                errors::InvalidArgument("Expected ", num_args,
+                                        " values for arg_is_lhs, got ",
+                                        arg_is_lhs.size()));
+
+    int arg = 0;
+    for (const string& op : fused_ops) {
+      Stage stage;
+      OP_REQUIRES(context, GetOpCode(op, &stage.op),
+                  errors::Unimplemented("Unsupported fused op: ", op));
+      if (functor::IsBinary(stage.op)) {
+        OP_REQUIRES(context, arg < num_args,
+                    errors::InvalidArgument("Too few args for fused ops: ",
+                                            absl::StrJoin(fused_ops, ",")));
+        stage.arg = arg;
+        stage.arg_is_lhs = arg_is_lhs[arg];
+        ++arg;
+      }
+      stages_.push_back(stage);
+    }
+    OP_REQUIRES(context, arg == num_args,
+                errors::InvalidArgument("Too many args for fused ops: ",
+                                        absl::StrJoin(fused_ops, ",")));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OpInputList args;
+    OP_REQUIRES_OK(context, context->input_list("args", &args));
+    OP_REQUIRES_OK(context, ValidateArgs(x, args));
+    OP_REQUIRES(context, x.NumElements() <= std::numeric_limits<int32>::max(),
+                errors::InvalidArgument("x has too many elements: ",
+                                        x.shape().DebugString()));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    const int n = x.NumElements();
+    if (n == 0) return;
+
+    using Program = functor::FusedElementwiseProgram<T>;
+    const T* input = x.flat<T>().data();
+    T* output = y->flat<T>().data();
+    for (size_t begin = 0; begin < stages_.size();
+         begin += Program::kMaxStages) {
+      Program program;
+      const size_t end = std::min(stages_.size(), begin + Program::kMaxStages);
+      for (size_t i = begin; i < end; ++i) {
+        const Stage& stage = stages_[i];
+        const int s = program.num_stages++;
+        program.ops[s] = stage.op;
+        program.args[s] = nullptr;
+        program.arg_is_scalar[s] = false;
+        program.arg_is_lhs[s] = stage.arg_is_lhs;
+        if (stage.arg >= 0) {
+          program.args[s] = args[stage.arg].flat<T>().data();
+          program.arg_is_scalar[s] = args[stage.arg].NumElements() == 1;
+        }
+      }
+      functor::FusedElementwiseFunctor<GPUDevice, T>()(
+          context->eigen_device<GPUDevice>(), program, input, n, output);
+      // Later segments continue from the output of this one.
+      input = output;
+    }
+  }
+
+ private:
+  struct Stage {
+    functor::FusedElementwiseOpCode op;
+    // The index of the other input of a binary op in `args`.
+    int arg = -1;
+    bool arg_is_lhs = false;
+  };
+  std::vector<Stage> stages_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedElementwiseGpuOp);
+};
+
+#define REGISTER_GPU(T)                                                  \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_FusedElementwise").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedElementwiseGpuOp<T>);
+
+TF_CALL_float(REGISTER_GPU);
+TF_CALL_double(REGISTER_GPU);
+
+#undef REGISTER_GPU
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
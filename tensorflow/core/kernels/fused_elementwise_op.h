@@ -0,0 +1,78 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_ELEMENTWISE_OP_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_ELEMENTWISE_OP_H_
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// The ops of a _FusedElementwise chain, as evaluated on GPU. The unary ops
+// come first.
+enum class FusedElementwiseOpCode : int8 {
+  kAbs,
+  kExp,
+  kLog,
+  kNeg,
+  kReciprocal,
+  kRelu,
+  kRelu6,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh,
+  kAdd,
+  kMaximum,
+  kMinimum,
+  kMul,
+  kRealDiv,
+  kSquaredDifference,
+  kSub,
+};
+
+inline bool IsBinary(FusedElementwiseOpCode op) {
+  return op >= FusedElementwiseOpCode::kAdd;
+}
+
+// A segment of a chain, passed by value to the GPU kernel. The kernel is
+// compiled once per type and interprets the program for each element, so a
+// single kernel evaluates every chain, whatever the shape of its input.
+template <typename T>
+struct FusedElementwiseProgram {
+  static constexpr int kMaxStages = 16;
+
+  int num_stages = 0;
+  FusedElementwiseOpCode ops[kMaxStages];
+  // The other input of each binary op, which is a scalar or has as many
+  // elements as the input of the chain.
+  const T* args[kMaxStages];
+  bool arg_is_scalar[kMaxStages];
+  bool arg_is_lhs[kMaxStages];
+};
+
+// Computes y = program(x) for the `n` elements of `x`; `y` may alias `x`.
+template <typename Device, typename T>
+struct FusedElementwiseFunctor {
+  void operator()(const Device& d, const FusedElementwiseProgram<T>& program,
+                  const T* x, int n, T* y);
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_ELEMENTWISE_OP_H_
@@ -0,0 +1,138 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/fused_elementwise_op.h"
+#include "tensorflow/core/util/gpu_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+using functor::FusedElementwiseOpCode;
+
+template <typename T>
+__device__ EIGEN_ALWAYS_INLINE T ApplyUnary(FusedElementwiseOpCode op, T x) {
+  using Eigen::numext::maxi;
+  using Eigen::numext::mini;
+  switch (op) {
+    case FusedElementwiseOpCode::kAbs:
+      return Eigen::numext::abs(x);
+    case FusedElementwiseOpCode::kExp:
+      return Eigen::numext::exp(x);
+    case FusedElementwiseOpCode::kLog:
+      return Eigen::numext::log(x);
+    case FusedElementwiseOpCode::kNeg:
+      return -x;
+    case FusedElementwiseOpCode::kReciprocal:
+      return T(1) / x;
+    case FusedElementwiseOpCode::kRelu:
+      return maxi(x, T(0));
+    case FusedElementwiseOpCode::kRelu6:
+      return mini(maxi(x, T(0)), T(6));
+    case FusedElementwiseOpCode::kRsqrt:
+      return T(1) / Eigen::numext::sqrt(x);
+    case FusedElementwiseOpCode::kSigmoid:
+      return T(1) / (T(1) + Eigen::numext::exp(-x));
+    case FusedElementwiseOpCode::kSqrt:
+      return Eigen::numext::sqrt(x);
+    case FusedElementwiseOpCode::kSquare:
+      return x * x;
+    case FusedElementwiseOpCode::kTanh:
+      return Eigen::numext::tanh(x);
+    default:
+      return x;
+  }
+}
+
+template <typename T>
+__device__ EIGEN_ALWAYS_INLINE T ApplyBinary(FusedElementwiseOpCode op, T a,
+                                             T b) {
+  switch (op) {
+    case FusedElementwiseOpCode::kAdd:
+      return a + b;
+    case FusedElementwiseOpCode::kMaximum:
+      return Eigen::numext::maxi(a, b);
+    case FusedElementwiseOpCode::kMinimum:
+      return Eigen::numext::mini(a, b);
+    case FusedElementwiseOpCode::kMul:
+      return a * b;
+    case FusedElementwiseOpCode::kRealDiv:
+      return a / b;
+    case FusedElementwiseOpCode::kSquaredDifference:
+      return (a - b) * (a - b);
+    case FusedElementwiseOpCode::kSub:
+      return a - b;
+    default:
+      return a;
+  }
+}
+
+// `x` and `y` may alias, so neither is __restrict__.
+template <typename T>
+__global__ void FusedElementwiseKernel(
+    const functor::FusedElementwiseProgram<T> program, const T* x, int n,
+    T* y) {
+  GPU_1D_KERNEL_LOOP(i, n) {
+    T value = x[i];
+    for (int s = 0; s < program.num_stages; ++s) {
+      const FusedElementwiseOpCode op = program.ops[s];
+      if (!functor::IsBinary(op)) {
+        value = ApplyUnary(op, value);
+        continue;
+      }
+      const T arg = program.arg_is_scalar[s] ? ldg(program.args[s])
+                                             : ldg(program.args[s] + i);
+      value = program.arg_is_lhs[s] ? ApplyBinary(op, arg, value)
+                                    : ApplyBinary(op, value, arg);
+    }
+    y[i] = value;
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename T>
+struct FusedElementwiseFunctor<GPUDevice, T> {
+  void operator()(const GPUDevice& d, const FusedElementwiseProgram<T>& program,
+                  const T* x, int n, T* y) {
+    GpuLaunchConfig config = GetGpuLaunchConfig(n, d);
+    TF_CHECK_OK(GpuLaunchKernel(FusedElementwiseKernel<T>, config.block_count,
+                                config.thread_per_block, 0, d.stream(),
+                                program, x, n, y));
+  }
+};
+
+#define DEFINE_GPU_SPEC(T) \
+  template struct FusedElementwiseFunctor<GPUDevice, T>;
+
+TF_CALL_float(DEFINE_GPU_SPEC);
+TF_CALL_double(DEFINE_GPU_SPEC);
+
+#undef DEFINE_GPU_SPEC
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
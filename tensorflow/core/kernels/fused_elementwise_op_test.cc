@@ -0,0 +1,107 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status Init(DataType dtype, const std::vector<string>& fused_ops,
+              const std::vector<bool>& arg_is_lhs) {
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("fused", "_FusedElementwise")
+            .Input(FakeInput(dtype))
+            .Input(FakeInput(arg_is_lhs.size(), dtype))
+            .Attr("fused_ops", fused_ops)
+            .Attr("arg_is_lhs", arg_is_lhs)
+            .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, UnaryChain) {
+  TF_ASSERT_OK(Init(DT_FLOAT, {"Neg", "Relu", "Square"}, {}));
+  AddInputFromArray<float>(TensorShape({2, 2}), {-3, -1, 0, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {9, 1, 0, 0});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, BinaryChain) {
+  // (2 - x) / y, then max with 1.
+  TF_ASSERT_OK(Init(DT_DOUBLE, {"Sub", "RealDiv", "Maximum"},
+                    {true, false, false}));
+  AddInputFromArray<double>(TensorShape({4}), {0, 1, 2, -6});
+  AddInputFromArray<double>(TensorShape({}), {2});
+  AddInputFromArray<double>(TensorShape({4}), {1, 0.5, 4, 2});
+  AddInputFromArray<double>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_DOUBLE, TensorShape({4}));
+  test::FillValues<double>(&expected, {2, 2, 1, 4});
+  test::ExpectTensorEqual<double>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, LargeInput) {
+  // Spans several blocks, with a partial last block.
+  TF_ASSERT_OK(Init(DT_FLOAT, {"Mul", "Add", "Sigmoid"}, {false, true}));
+  const int n = 5000;
+  std::vector<float> x(n), b(n), y(n);
+  for (int i = 0; i < n; ++i) {
+    x[i] = (i % 17) - 8;
+    b[i] = (i % 5) * 0.1f;
+    y[i] = 1 / (1 + std::exp(-(b[i] + x[i] * 0.5f)));
+  }
+  AddInputFromArray<float>(TensorShape({n}), x);
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  AddInputFromArray<float>(TensorShape({n}), b);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({n}));
+  test::FillValues<float>(&expected, y);
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsBroadcasting) {
+  TF_ASSERT_OK(Init(DT_FLOAT, {"Add", "Relu"}, {false}));
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsUnsupportedOps) {
+  Status s = Init(DT_FLOAT, {"Relu", "Erf"}, {});
+  EXPECT_TRUE(errors::IsUnimplemented(s)) << s;
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsMismatchedArgs) {
+  Status s = Init(DT_FLOAT, {"Relu", "Add"}, {});
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+}  // namespace tensorflow
@@ -60,24 +60,30 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   auto work = [&](int64 start, int64 end) {
     SliceIndex batch_idx = static_cast<SliceIndex>(start / indices_size);
     SliceIndex indices_idx = static_cast<SliceIndex>(start % indices_size);
-    SliceIndex batch_idx_end = static_cast<SliceIndex>(end / indices_size);
-    SliceIndex indices_idx_end = static_cast<SliceIndex>(end % indices_size);
-
-    while ((batch_idx < batch_idx_end) ||
-           (batch_idx == batch_idx_end && indices_idx < indices_idx_end)) {
-      SliceIndex i_next = indices_idx + 1;
-      SliceIndex b_next = batch_idx + 1;
-      if ((batch_idx == batch_idx_end && i_next < indices_idx_end) ||
-          (i_next < indices_size)) {
-        port::prefetch<port::PREFETCH_HINT_T0>(
-            &params(batch_idx, indices(i_next), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(batch_idx, i_next, 0));
-        b_next = batch_idx;
-      } else if (b_next <= batch_idx_end) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(b_next, indices(0), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(b_next, 0, 0));
-        i_next = 0;
+
+    // The rows are prefetched kPrefetchDistance indices ahead of the copies,
+    // so that the latency of the random accesses into params overlaps with
+    // the copies of the preceding rows.
+    constexpr int kPrefetchDistance = 4;
+    int64 ahead = start;
+    SliceIndex ahead_batch_idx = batch_idx;
+    SliceIndex ahead_indices_idx = indices_idx;
+    auto prefetch_ahead = [&]() {
+      if (ahead >= end) return;
+      port::prefetch<port::PREFETCH_HINT_T0>(
+          &params(ahead_batch_idx, indices(ahead_indices_idx), 0));
+      if (++ahead_indices_idx == indices_size) {
+        ahead_indices_idx = 0;
+        ++ahead_batch_idx;
       }
+      ++ahead;
+    };
+    for (int i = 0; i < kPrefetchDistance; ++i) {
+      prefetch_ahead();
+    }
+
+    for (int64 pos = start; pos < end; ++pos) {
+      prefetch_ahead();
       const Index index = internal::SubtleMustCopy(indices(indices_idx));
       if (!FastBoundsCheck(index, limit)) {
         mutex_lock l(mu);
@@ -100,8 +106,10 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
         out.template chip<0>(batch_idx).template chip<0>(indices_idx) =
             params.template chip<0>(batch_idx).template chip<0>(index);
       }
-      indices_idx = i_next;
-      batch_idx = b_next;
+      if (++indices_idx == indices_size) {
+        indices_idx = 0;
+        ++batch_idx;
+      }
     }
   };
 
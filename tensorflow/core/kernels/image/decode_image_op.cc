@@ -15,6 +15,7 @@ limitations under the License.
 
 // See docs in ../ops/image_ops.cc
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 
@@ -121,6 +122,7 @@ class DecodeImageV2Op : public OpKernel {
       } else if (dct_method == "INTEGER_ACCURATE") {
         flags_.dct_method = JDCT_ISLOW;
       }
+      OP_REQUIRES_OK(context, context->GetAttr("target_size", &target_size_));
     } else {
       flags_ = jpeg::UncompressFlags();
       flags_.dct_method = JDCT_IFAST;
@@ -218,6 +220,54 @@ class DecodeImageV2Op : public OpKernel {
     }
   }
 
+  // Lets libjpeg scale the image down in the DCT domain by the largest ratio
+  // at which both sides of the decoded region, the whole image or the crop
+  // window, still have at least `target_size_` pixels.  The crop window is
+  // given at full resolution and is mapped to the smallest window of the
+  // scaled image covering it.  Invalid data or crop windows are left
+  // unscaled for jpeg::Uncompress to report.
+  void ScaleToTargetSize(StringPiece input, jpeg::UncompressFlags* flags) {
+    int width;
+    int height;
+    if (!jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                            nullptr)) {
+      return;
+    }
+    int64 region_width = width;
+    int64 region_height = height;
+    if (flags->crop) {
+      if (flags->crop_x < 0 || flags->crop_y < 0 || flags->crop_width <= 0 ||
+          flags->crop_height <= 0 ||
+          int64{flags->crop_x} + flags->crop_width > width ||
+          int64{flags->crop_y} + flags->crop_height > height) {
+        return;
+      }
+      region_width = flags->crop_width;
+      region_height = flags->crop_height;
+    }
+    int ratio = 8;
+    while (ratio > 1 && std::min(region_width, region_height) / ratio <
+                            target_size_) {
+      ratio /= 2;
+    }
+    flags->ratio = ratio;
+    if (flags->crop && ratio > 1) {
+      // libjpeg rounds the scaled dimensions up.
+      const int scaled_width = (width + ratio - 1) / ratio;
+      const int scaled_height = (height + ratio - 1) / ratio;
+      const int x_end = std::min<int64>(
+          scaled_width, (int64{flags->crop_x} + flags->crop_width + ratio - 1) /
+                            ratio);
+      const int y_end = std::min<int64>(
+          scaled_height,
+          (int64{flags->crop_y} + flags->crop_height + ratio - 1) / ratio);
+      flags->crop_x /= ratio;
+      flags->crop_y /= ratio;
+      flags->crop_width = x_end - flags->crop_x;
+      flags->crop_height = y_end - flags->crop_y;
+    }
+  }
+
   void DecodeJpegV2(OpKernelContext* context, StringPiece input) {
     OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
                 errors::InvalidArgument("JPEG does not support 4 channels"));
@@ -244,6 +294,10 @@ class DecodeImageV2Op : public OpKernel {
       flags.crop_width = crop_window_vec(3);
     }
 
+    if (target_size_ > 0) {
+      ScaleToTargetSize(input, &flags);
+    }
+
     // Output tensor and the image buffer size.
     Tensor* output = nullptr;
     int buffer_size = 0;
@@ -599,6 +653,7 @@ class DecodeImageV2Op : public OpKernel {
   DataType data_type_ = DataType::DT_UINT8;
   bool expand_animations_ = true;
   jpeg::UncompressFlags flags_;
+  int target_size_ = 0;
   string op_type_;
 };
 
@@ -364,18 +364,10 @@ class TensorListResize : public OpKernel {
     output_list.element_shape = input_list->element_shape;
     output_list.element_dtype = input_list->element_dtype;
     output_list.max_num_elements = input_list->max_num_elements;
-    if (size > input_list->tensors().size()) {
-      output_list.tensors().insert(output_list.tensors().begin(),
-                                   input_list->tensors().begin(),
-                                   input_list->tensors().end());
-      // Add DT_INVALID tensors to the end of the list if the requested size
-      // is larger than the list length.
-      output_list.tensors().resize(size, Tensor(DT_INVALID));
-    } else {
-      output_list.tensors().insert(output_list.tensors().begin(),
-                                   input_list->tensors().begin(),
-                                   input_list->tensors().begin() + size);
-    }
+    // Shares the chunks of the input list. Adds DT_INVALID tensors to the end
+    // of the list if the requested size is larger than the list length.
+    output_list.tensors() = input_list->tensors();
+    output_list.tensors().resize(size, Tensor(DT_INVALID));
     result->scalar<Variant>()() = std::move(output_list);
   }
 };
@@ -16,10 +16,17 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <array>
+#include <set>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
@@ -30,11 +37,173 @@ limitations under the License.
 namespace tensorflow {
 namespace lookup {
 
-// Lookup table that wraps an unordered_map, where the key and value data type
-// is specified. Each individual value must be a scalar. If vector values are
-// required, use MutableHashTableOfTensors.
+namespace {
+
+// Hash functor for the keys of ShardedHashMap.  absl::Hash mixes the bits of
+// integral keys, which the open-addressing probe sequence relies on.
+template <typename K>
+struct ShardedKeyHash {
+  size_t operator()(const K& key) const { return absl::Hash<K>()(key); }
+};
+
+template <>
+struct ShardedKeyHash<tstring> {
+  size_t operator()(const tstring& key) const { return Hash64(key); }
+};
+
+// Hash map split into independently locked shards, each an open-addressing
+// absl::flat_hash_map with the keys and values stored inline.  Operations on
+// different shards proceed concurrently.  The batched operations group the
+// keys by shard first, so that every shard lock is taken at most once per
+// batch and the keys of a shard are probed back to back.
+template <class K, class V>
+class ShardedHashMap {
+ public:
+  typedef absl::flat_hash_map<K, V, ShardedKeyHash<K>> Map;
+
+  size_t size() const {
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  // Calls `fn(map, i, key)` for every i in [0, n), where `key` is
+  // `key_fn(i)` and `map` is the shard that holds it, under a shared lock.
+  template <typename KeyFn, typename Fn>
+  void ReadBatch(int64 n, KeyFn key_fn, Fn fn) const {
+    std::vector<int64> order;
+    std::array<int64, kNumShards + 1> starts;
+    GroupByShard(n, key_fn, &order, &starts);
+    for (int s = 0; s < kNumShards; ++s) {
+      if (starts[s] == starts[s + 1]) continue;
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64 j = starts[s]; j < starts[s + 1]; ++j) {
+        const int64 i = order[j];
+        fn(shard.map, i, key_fn(i));
+      }
+    }
+  }
+
+  // Like ReadBatch, but with mutable shards under an exclusive lock.  If
+  // `clear` is set the map is emptied first, and the batch is applied while
+  // holding every shard lock so that readers never see a partial table.
+  template <typename KeyFn, typename Fn>
+  void UpdateBatch(bool clear, int64 n, KeyFn key_fn, Fn fn) {
+    if (clear) {
+      LockAll();
+      for (Shard& shard : shards_) shard.map.clear();
+      for (int64 i = 0; i < n; ++i) {
+        auto key = key_fn(i);
+        fn(&shards_[ShardIndex(key)].map, i, std::move(key));
+      }
+      UnlockAll();
+      return;
+    }
+    std::vector<int64> order;
+    std::array<int64, kNumShards + 1> starts;
+    GroupByShard(n, key_fn, &order, &starts);
+    for (int s = 0; s < kNumShards; ++s) {
+      if (starts[s] == starts[s + 1]) continue;
+      Shard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64 j = starts[s]; j < starts[s + 1]; ++j) {
+        const int64 i = order[j];
+        fn(&shard.map, i, key_fn(i));
+      }
+    }
+  }
+
+  // Calls `fn(size)` with the total number of entries and then `fn(key,
+  // value)` for every entry, all under shared locks on every shard.
+  template <typename SizeFn, typename Fn>
+  Status ForEach(SizeFn size_fn, Fn fn) const {
+    LockAllShared();
+    size_t size = 0;
+    for (const Shard& shard : shards_) size += shard.map.size();
+    Status s = size_fn(size);
+    if (s.ok()) {
+      for (const Shard& shard : shards_) {
+        for (const auto& it : shard.map) fn(it.first, it.second);
+      }
+    }
+    UnlockAllShared();
+    return s;
+  }
+
+  // Returns the bytes held by the slots and control bytes of every shard.
+  int64 MemoryUsed() const {
+    int64 ret = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      ret += shard.map.capacity() * (sizeof(typename Map::value_type) + 1);
+    }
+    return ret;
+  }
+
+ private:
+  static constexpr int kNumShards = 16;
+
+  struct Shard {
+    mutable mutex mu;
+    Map map;
+  };
+
+  static int ShardIndex(const K& key) {
+    // Take the top bits of a multiplicative rehash so that the shard is
+    // independent of the bits that the shard maps use for probing.
+    return static_cast<int>(
+        (static_cast<uint64>(ShardedKeyHash<K>()(key)) *
+         0x9E3779B97F4A7C15ULL) >>
+        60);
+  }
+
+  // Counting sort of [0, n) by the shard of `key_fn(i)`: the indices of
+  // shard s are (*order)[(*starts)[s]] up to (*order)[(*starts)[s + 1]].
+  template <typename KeyFn>
+  static void GroupByShard(int64 n, KeyFn key_fn, std::vector<int64>* order,
+                           std::array<int64, kNumShards + 1>* starts) {
+    static_assert(kNumShards == 16, "ShardIndex keeps the top 4 bits");
+    std::vector<uint8> shard_of(n);
+    starts->fill(0);
+    for (int64 i = 0; i < n; ++i) {
+      shard_of[i] = ShardIndex(key_fn(i));
+      ++(*starts)[shard_of[i] + 1];
+    }
+    for (int s = 0; s < kNumShards; ++s) (*starts)[s + 1] += (*starts)[s];
+    std::array<int64, kNumShards> next;
+    std::copy(starts->begin(), starts->end() - 1, next.begin());
+    order->resize(n);
+    for (int64 i = 0; i < n; ++i) (*order)[next[shard_of[i]]++] = i;
+  }
+
+  void LockAll() TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (Shard& shard : shards_) shard.mu.lock();
+  }
+  void UnlockAll() TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (Shard& shard : shards_) shard.mu.unlock();
+  }
+  void LockAllShared() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (const Shard& shard : shards_) shard.mu.lock_shared();
+  }
+  void UnlockAllShared() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (const Shard& shard : shards_) shard.mu.unlock_shared();
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace
+
+// Lookup table that wraps a sharded hash map, where the key and value data
+// type is specified. Each individual value must be a scalar. If vector values
+// are required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
+// Finds and Inserts of keys in different shards do not contend.
 //
 // Sample use case:
 //
@@ -49,10 +218,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -60,11 +226,15 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
-    }
+    table_.ReadBatch(
+        key_values.size(),
+        [&key_values](int64 i) -> decltype(auto) {
+          return SubtleMustCopyIfIntegral(key_values(i));
+        },
+        [&value_values, &default_val](const Map& map, int64 i, const K& key) {
+          auto it = map.find(key);
+          value_values(i) = it == map.end() ? default_val : it->second;
+        });
 
     return Status::OK();
   }
@@ -73,14 +243,14 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          SubtleMustCopyIfIntegral(value_values(i)));
-    }
+    table_.UpdateBatch(
+        clear, key_values.size(),
+        [&key_values](int64 i) -> decltype(auto) {
+          return SubtleMustCopyIfIntegral(key_values(i));
+        },
+        [&value_values](Map* map, int64 i, K key) {
+          (*map)[std::move(key)] = SubtleMustCopyIfIntegral(value_values(i));
+        });
     return Status::OK();
   }
 
@@ -92,10 +262,12 @@ class MutableHashTableOfScalars final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.UpdateBatch(
+        false, key_values.size(),
+        [&key_values](int64 i) -> decltype(auto) {
+          return SubtleMustCopyIfIntegral(key_values(i));
+        },
+        [](Map* map, int64 i, const K& key) { map->erase(key); });
     return Status::OK();
   }
 
@@ -105,24 +277,24 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
-    return Status::OK();
+    K* keys_data = nullptr;
+    V* values_data = nullptr;
+    return table_.ForEach(
+        [ctx, &keys_data, &values_data](int64 size) {
+          Tensor* keys;
+          Tensor* values;
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), &keys));
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("values", TensorShape({size}), &values));
+          keys_data = keys->flat<K>().data();
+          values_data = values->flat<V>().data();
+          return Status::OK();
+        },
+        [&keys_data, &values_data](const K& key, const V& value) {
+          *keys_data++ = key;
+          *values_data++ = value;
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -134,25 +306,15 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + table_.MemoryUsed();
   }
 
  private:
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ TF_GUARDED_BY(mu_);
+  typedef typename ShardedHashMap<K, V>::Map Map;
+  ShardedHashMap<K, V> table_;
 };
 
-// Lookup table that wraps an unordered_map. Behaves identical to
+// Lookup table that wraps a sharded hash map. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
@@ -166,10 +328,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -178,20 +337,24 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec =
-          gtl::FindOrNull(table_, SubtleMustCopyIfIntegral(key_values(i)));
-      if (value_vec != nullptr) {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = value_vec->at(j);
-        }
-      } else {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = default_flat(j);
-        }
-      }
-    }
+    table_.ReadBatch(
+        key_values.size(),
+        [&key_values](int64 i) -> decltype(auto) {
+          return SubtleMustCopyIfIntegral(key_values(i));
+        },
+        [&value_values, &default_flat, value_dim](const Map& map, int64 i,
+                                                  const K& key) {
+          auto it = map.find(key);
+          if (it != map.end()) {
+            for (int64 j = 0; j < value_dim; j++) {
+              value_values(i, j) = it->second.at(j);
+            }
+          } else {
+            for (int64 j = 0; j < value_dim; j++) {
+              value_values(i, j) = default_flat(j);
+            }
+          }
+        });
 
     return Status::OK();
   }
@@ -201,19 +364,19 @@ class MutableHashTableOfTensors final : public LookupInterface {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray value_vec;
-      for (int64 j = 0; j < value_dim; j++) {
-        V value = value_values(i, j);
-        value_vec.push_back(value);
-      }
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          value_vec);
-    }
+    table_.UpdateBatch(
+        clear, key_values.size(),
+        [&key_values](int64 i) -> decltype(auto) {
+          return SubtleMustCopyIfIntegral(key_values(i));
+        },
+        [&value_values, value_dim](Map* map, int64 i, K key) {
+          ValueArray& value_vec = (*map)[std::move(key)];
+          value_vec.clear();
+          for (int64 j = 0; j < value_dim; j++) {
+            V value = value_values(i, j);
+            value_vec.push_back(value);
+          }
+        });
     return Status::OK();
   }
 
@@ -225,10 +388,12 @@ class MutableHashTableOfTensors final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.UpdateBatch(
+        false, key_values.size(),
+        [&key_values](int64 i) -> decltype(auto) {
+          return SubtleMustCopyIfIntegral(key_values(i));
+        },
+        [](Map* map, int64 i, const K& key) { map->erase(key); });
     return Status::OK();
   }
 
@@ -238,29 +403,29 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
     int64 value_dim = value_shape_.dim_size(0);
 
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
-      }
-    }
-    return Status::OK();
+    K* keys_data = nullptr;
+    V* values_data = nullptr;
+    return table_.ForEach(
+        [ctx, &keys_data, &values_data, value_dim](int64 size) {
+          Tensor* keys;
+          Tensor* values;
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), &keys));
+          TF_RETURN_IF_ERROR(ctx->allocate_output(
+              "values", TensorShape({size, value_dim}), &values));
+          keys_data = keys->flat<K>().data();
+          values_data = values->flat<V>().data();
+          return Status::OK();
+        },
+        [&keys_data, &values_data, value_dim](const K& key,
+                                              const ValueArray& value) {
+          *keys_data++ = key;
+          for (int64 j = 0; j < value_dim; j++) {
+            *values_data++ = value[j];
+          }
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -272,24 +437,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfTensors) + ret;
+    return sizeof(MutableHashTableOfTensors) + table_.MemoryUsed();
   }
 
  private:
-  TensorShape value_shape_;
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ TF_GUARDED_BY(mu_);
+  typedef typename ShardedHashMap<K, ValueArray>::Map Map;
+  TensorShape value_shape_;
+  ShardedHashMap<K, ValueArray> table_;
 };
 
 namespace {
@@ -776,6 +931,327 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// Lookup table with a bounded number of entries, for vocabularies that keep
+// growing over the course of training.  Each value must be a scalar or a
+// vector.
+//
+// A key that is not in the table is admitted once it has been inserted
+// `min_frequency` times; until then Find returns the default value for it.
+// When admitting a key would exceed `capacity` entries, the entry chosen by
+// the `eviction_policy` is removed first:
+// - "lru": the entry least recently found or inserted;
+// - "lfu": the entry found or inserted the fewest times, least recently used
+//   first among those;
+// - "timestamp": the entry least recently inserted.
+//
+// Besides the full ExportValues/ImportValues, the table tracks the entries
+// inserted and the keys removed since the last export or import, so that
+// incremental checkpoints can save only those with ExportDelta and restore
+// them on top of the previous checkpoint with ImportDelta.
+template <class K, class V>
+class MutableBoundedHashTable final : public LookupInterface {
+ public:
+  MutableBoundedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(value_shape_) ||
+                    TensorShapeUtils::IsVector(value_shape_),
+                errors::InvalidArgument(
+                    "Value must be a scalar or a vector, got shape ",
+                    value_shape_.DebugString()));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "capacity", &capacity_));
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "min_frequency", &min_frequency_));
+    string eviction_policy;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "eviction_policy",
+                                    &eviction_policy));
+    if (eviction_policy == "lfu") {
+      policy_ = EvictionPolicy::kLfu;
+    } else if (eviction_policy == "timestamp") {
+      policy_ = EvictionPolicy::kTimestamp;
+    } else {
+      policy_ = EvictionPolicy::kLru;
+    }
+  }
+
+  size_t size() const override {
+    tf_shared_lock l(mu_);
+    return table_.size();
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto default_flat = default_value.flat<V>();
+    const auto key_values = key.flat<K>();
+    const int64 value_dim = value_shape_.num_elements();
+    auto value_values = value->shaped<V, 2>({key_values.size(), value_dim});
+
+    // Lookups update the recency and frequency that eviction is based on.
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      auto it = table_.find(SubtleMustCopyIfIntegral(key_values(i)));
+      if (it != table_.end()) {
+        Touch(it->first, &it->second, /*update=*/false);
+        for (int64 j = 0; j < value_dim; j++) {
+          value_values(i, j) = it->second.value[j];
+        }
+      } else {
+        for (int64 j = 0; j < value_dim; j++) {
+          value_values(i, j) = default_flat(j);
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.shaped<V, 2>(
+        {key_values.size(), value_shape_.num_elements()});
+
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const K key = SubtleMustCopyIfIntegral(key_values(i));
+      auto it = table_.find(key);
+      if (it == table_.end()) {
+        if (!Admit(key)) continue;
+        it = table_.emplace(key, Entry()).first;
+      }
+      Entry* entry = &it->second;
+      SetValue(value_values, i, entry);
+      entry->dirty = true;
+      // A key removed since the last export is still part of it.
+      if (removed_.erase(key) > 0) entry->exported = true;
+      Touch(key, entry, /*update=*/true);
+      if (static_cast<int64>(table_.size()) > capacity_) EvictOne(&key);
+    }
+    return Status::OK();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      auto it = table_.find(SubtleMustCopyIfIntegral(key_values(i)));
+      if (it != table_.end()) Erase(it);
+    }
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    mutex_lock l(mu_);
+    table_.clear();
+    ranks_.clear();
+    candidates_.clear();
+    removed_.clear();
+    return DoImport(keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    mutex_lock l(mu_);
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(AllocateExport(ctx, table_.size(), &keys, &values));
+    K* keys_data = keys->flat<K>().data();
+    V* values_data = values->flat<V>().data();
+    for (auto& it : table_) {
+      *keys_data++ = it.first;
+      values_data = std::copy(it.second.value.begin(), it.second.value.end(),
+                              values_data);
+      it.second.dirty = false;
+      it.second.exported = true;
+    }
+    removed_.clear();
+    return Status::OK();
+  }
+
+  Status ExportDelta(OpKernelContext* ctx) override {
+    mutex_lock l(mu_);
+    int64 num_dirty = 0;
+    for (const auto& it : table_) {
+      if (it.second.dirty) ++num_dirty;
+    }
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(AllocateExport(ctx, num_dirty, &keys, &values));
+    Tensor* removed_keys;
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "removed_keys", TensorShape({static_cast<int64>(removed_.size())}),
+        &removed_keys));
+    K* keys_data = keys->flat<K>().data();
+    V* values_data = values->flat<V>().data();
+    for (auto& it : table_) {
+      if (!it.second.dirty) continue;
+      *keys_data++ = it.first;
+      values_data = std::copy(it.second.value.begin(), it.second.value.end(),
+                              values_data);
+      it.second.dirty = false;
+      it.second.exported = true;
+    }
+    std::copy(removed_.begin(), removed_.end(),
+              removed_keys->flat<K>().data());
+    removed_.clear();
+    return Status::OK();
+  }
+
+  Status ImportDelta(OpKernelContext* ctx, const Tensor& keys,
+                     const Tensor& values,
+                     const Tensor& removed_keys) override {
+    const auto removed_values = removed_keys.flat<K>();
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < removed_values.size(); ++i) {
+      auto it = table_.find(SubtleMustCopyIfIntegral(removed_values(i)));
+      if (it != table_.end()) Erase(it);
+    }
+    removed_.clear();
+    return DoImport(keys, values);
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64 MemoryUsed() const override {
+    tf_shared_lock l(mu_);
+    // Every entry also has a node in ranks_.
+    return sizeof(MutableBoundedHashTable) +
+           table_.capacity() * (sizeof(typename Map::value_type) + 1) +
+           table_.size() * sizeof(typename RankSet::value_type) +
+           candidates_.capacity() *
+               (sizeof(typename CandidateMap::value_type) + 1);
+  }
+
+ private:
+  enum class EvictionPolicy { kLru, kLfu, kTimestamp };
+
+  typedef gtl::InlinedVector<V, 4> ValueArray;
+  // Entries are evicted in increasing order of (frequency, tick), where the
+  // frequency is only tracked by the "lfu" policy.
+  typedef std::pair<int64, uint64> Rank;
+
+  struct Entry {
+    ValueArray value;
+    Rank rank = {0, 0};
+    // Whether the entry changed since the last export or import.
+    bool dirty = false;
+    // Whether the entry is part of the last export or import, which the
+    // delta has to report its removal to.
+    bool exported = false;
+  };
+
+  typedef absl::flat_hash_map<K, Entry, ShardedKeyHash<K>> Map;
+  typedef absl::flat_hash_map<K, int64, ShardedKeyHash<K>> CandidateMap;
+  typedef std::set<std::pair<Rank, K>> RankSet;
+
+  // Counts an insert of `key`, which is not in the table, and returns whether
+  // the key is now frequent enough to be admitted.
+  bool Admit(const K& key) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (min_frequency_ <= 1) return true;
+    auto it = candidates_.find(key);
+    if (it == candidates_.end()) {
+      // Bound the memory of the filter as well: once it tracks as many keys
+      // as the table holds, counting starts over.
+      if (static_cast<int64>(candidates_.size()) >= capacity_) {
+        candidates_.clear();
+      }
+      candidates_.emplace(key, 1);
+      return false;
+    }
+    if (++it->second < min_frequency_) return false;
+    candidates_.erase(it);
+    return true;
+  }
+
+  void SetValue(typename TTypes<V, 2>::ConstTensor value_values, int64 i,
+                Entry* entry) {
+    const int64 value_dim = value_shape_.num_elements();
+    entry->value.clear();
+    for (int64 j = 0; j < value_dim; j++) {
+      entry->value.push_back(SubtleMustCopyIfIntegral(value_values(i, j)));
+    }
+  }
+
+  // Records a use of the entry of `key`, or an update of its value.
+  void Touch(const K& key, Entry* entry, bool update)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (policy_ == EvictionPolicy::kTimestamp && !update) return;
+    Rank rank = entry->rank;
+    ranks_.erase({rank, key});
+    if (policy_ == EvictionPolicy::kLfu) ++rank.first;
+    rank.second = ++tick_;
+    entry->rank = rank;
+    ranks_.insert({rank, key});
+  }
+
+  void Erase(typename Map::iterator it) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    ranks_.erase({it->second.rank, it->first});
+    if (it->second.exported) removed_.insert(it->first);
+    table_.erase(it);
+  }
+
+  // Evicts the entry ranked lowest, other than the one of `keep` if given,
+  // so that a key just admitted under "lfu" is not its own victim.
+  void EvictOne(const K* keep = nullptr) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto victim = ranks_.begin();
+    if (keep != nullptr && victim != ranks_.end() && victim->second == *keep) {
+      ++victim;
+    }
+    DCHECK(victim != ranks_.end());
+    Erase(table_.find(victim->second));
+  }
+
+  Status AllocateExport(OpKernelContext* ctx, int64 size, Tensor** keys,
+                        Tensor** values) {
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), keys));
+    TensorShape values_shape({size});
+    values_shape.AppendShape(value_shape_);
+    return ctx->allocate_output("values", values_shape, values);
+  }
+
+  // Inserts previously exported entries, bypassing the frequency filter.
+  Status DoImport(const Tensor& keys, const Tensor& values)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.shaped<V, 2>(
+        {key_values.size(), value_shape_.num_elements()});
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const K key = SubtleMustCopyIfIntegral(key_values(i));
+      Entry* entry = &table_[key];
+      SetValue(value_values, i, entry);
+      entry->dirty = false;
+      entry->exported = true;
+      Touch(key, entry, /*update=*/true);
+      candidates_.erase(key);
+    }
+    while (static_cast<int64>(table_.size()) > capacity_) EvictOne();
+    // Evictions of entries that were just imported need not be reported.
+    removed_.clear();
+    return Status::OK();
+  }
+
+  TensorShape value_shape_;
+  int64 capacity_;
+  int64 min_frequency_;
+  EvictionPolicy policy_;
+
+  mutable mutex mu_;
+  Map table_ TF_GUARDED_BY(mu_);
+  RankSet ranks_ TF_GUARDED_BY(mu_);
+  CandidateMap candidates_ TF_GUARDED_BY(mu_);
+  // Keys of the last export or import removed since then.
+  absl::flat_hash_set<K, ShardedKeyHash<K>> removed_ TF_GUARDED_BY(mu_);
+  uint64 tick_ TF_GUARDED_BY(mu_) = 0;
+};
+
 }  // namespace lookup
 
 // Base class for kernels that take a LookupTable handle as the 0th input.
@@ -974,6 +1450,59 @@ REGISTER_KERNEL_BUILDER(Name("LookupTableImport").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("LookupTableImportV2").Device(DEVICE_CPU),
                         LookupTableImportOp);
 
+// Export the entries changed since the last export or import.
+class LookupTableExportDeltaOp : public LookupTableOpKernel {
+ public:
+  using LookupTableOpKernel::LookupTableOpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::LookupInterface* table;
+    OP_REQUIRES_OK(ctx, GetTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    OP_REQUIRES_OK(ctx, table->ExportDelta(ctx));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("LookupTableExportDelta").Device(DEVICE_CPU),
+                        LookupTableExportDeltaOp);
+
+// Apply exported changes on top of the table.
+class LookupTableImportDeltaOp : public LookupTableOpKernel {
+ public:
+  using LookupTableOpKernel::LookupTableOpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::LookupInterface* table;
+    OP_REQUIRES_OK(ctx, GetTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    DataTypeVector expected_inputs = {expected_input_0_, table->key_dtype(),
+                                      table->value_dtype(),
+                                      table->key_dtype()};
+    OP_REQUIRES_OK(ctx, ctx->MatchSignature(expected_inputs, {}));
+
+    const Tensor& keys = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    const Tensor& removed_keys = ctx->input(3);
+    OP_REQUIRES_OK(ctx, table->CheckKeyAndValueTensorsForImport(keys, values));
+    OP_REQUIRES_OK(ctx, table->CheckKeyTensorForRemove(removed_keys));
+
+    int memory_used_before = 0;
+    if (ctx->track_allocations()) {
+      memory_used_before = table->MemoryUsed();
+    }
+    OP_REQUIRES_OK(ctx, table->ImportDelta(ctx, keys, values, removed_keys));
+    if (ctx->track_allocations()) {
+      ctx->record_persistent_memory_allocation(table->MemoryUsed() -
+                                               memory_used_before);
+    }
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("LookupTableImportDelta").Device(DEVICE_CPU),
+                        LookupTableImportDeltaOp);
+
 // Register the HashTable op with the currently supported key and value types.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                           \
   REGISTER_KERNEL_BUILDER(                                                \
@@ -1076,6 +1605,30 @@ REGISTER_KERNEL(tstring, int64);
 
 #undef REGISTER_KERNEL
 
+// Register the MutableBoundedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("MutableBoundedHashTable")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::MutableBoundedHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64, double);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(int64, int32);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableDenseHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                            \
   REGISTER_KERNEL_BUILDER(                                                 \
@@ -56,6 +56,40 @@ struct MatMulFunctor {
       const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair);
 };
 
+// The activation applied by FusedMatMulEpilogue.
+enum class FusedMatMulActivation { kNone, kRelu, kRelu6, kElu };
+
+template <typename Device, typename T>
+struct FusedMatMulEpilogue {
+  // Computes on device "d": out = activation(out + bias), where `bias` is
+  // broadcast across the rows of `out`.  Runs as a single pass over `out`.
+  void operator()(const Device& d, FusedMatMulActivation activation,
+                  typename TTypes<T>::ConstVec bias,
+                  typename MatMulTypes<T>::out_type out) {
+    Eigen::DSizes<Eigen::DenseIndex, 2> bias_shape(1, bias.dimension(0));
+    Eigen::DSizes<Eigen::DenseIndex, 2> broadcast(out.dimension(0), 1);
+    auto biased = out + bias.reshape(bias_shape).broadcast(broadcast);
+    switch (activation) {
+      case FusedMatMulActivation::kNone:
+        out.device(d) = biased;
+        break;
+      case FusedMatMulActivation::kRelu:
+        out.device(d) = biased.cwiseMax(static_cast<T>(0));
+        break;
+      case FusedMatMulActivation::kRelu6:
+        out.device(d) =
+            biased.cwiseMax(static_cast<T>(0)).cwiseMin(static_cast<T>(6));
+        break;
+      case FusedMatMulActivation::kElu:
+        out.device(d) = (biased < static_cast<T>(0))
+                            .select(biased.exp() -
+                                        biased.constant(static_cast<T>(1)),
+                                    biased);
+        break;
+    }
+  }
+};
+
 }  // end namespace functor
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -20,7 +20,9 @@ limitations under the License.
 //
 // Activation: Relu, Relu6, Elu, etc...
 //
-// Currently supported only on CPU device.
+// On GPU only MatMul + BiasAdd + <Activation> is supported: the product is
+// computed by cuBLAS, and the bias and activation by a single elementwise
+// kernel.
 
 #ifndef TENSORFLOW_CORE_KERNELS_MATMUL_OP_FUSED_H_
 #define TENSORFLOW_CORE_KERNELS_MATMUL_OP_FUSED_H_
@@ -38,12 +40,19 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/kernels/fused_eigen_output_kernels.h"
+#include "tensorflow/core/kernels/matmul_op.h"
+#include "tensorflow/core/util/matmul_autotune.h"
 #include "tensorflow/core/util/tensor_format.h"
 
 #if defined(TENSORFLOW_USE_CUSTOM_CONTRACTION_KERNEL)
 #include "tensorflow/core/kernels/eigen_contraction_kernel.h"
 #endif
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/kernels/gpu_utils.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -102,6 +111,154 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
   }
 };
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+namespace functor {
+extern template struct FusedMatMulEpilogue<GPUDevice, float>;
+}  // namespace functor
+
+// A dummy type to group fused matmul autotune results together.  The GEMM of
+// a fused matmul runs with beta = 0 like a plain MatMul, but it is tuned
+// separately so that the two ops do not depend on each other's cache.
+struct FusedMatmulAutoTuneGroup {
+  static string name() { return "FusedMatmul"; }
+};
+typedef AutoTuneSingleton<FusedMatmulAutoTuneGroup, MatmulParameters,
+                          se::blas::AlgorithmConfig>
+    AutoTuneFusedMatmul;
+
+template <typename T>
+struct LaunchFusedMatMulOp<GPUDevice, T> {
+  void operator()(
+      OpKernelContext* context, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      FusedComputationType fusion, const FusedComputationArgs& fusion_args,
+      Tensor* output) {
+    using se::blas::AlgorithmConfig;
+    using se::blas::kNoAlgorithm;
+    using se::blas::ProfileResult;
+    using se::blas::Transpose;
+
+    functor::FusedMatMulActivation activation;
+    switch (fusion) {
+      case FusedComputationType::kBiasAdd:
+        activation = functor::FusedMatMulActivation::kNone;
+        break;
+      case FusedComputationType::kBiasAddWithRelu:
+        activation = functor::FusedMatMulActivation::kRelu;
+        break;
+      case FusedComputationType::kBiasAddWithRelu6:
+        activation = functor::FusedMatMulActivation::kRelu6;
+        break;
+      case FusedComputationType::kBiasAddWithElu:
+        activation = functor::FusedMatMulActivation::kElu;
+        break;
+      default:
+        OP_REQUIRES_OK(context,
+                       errors::Internal("Fusion type is not supported"));
+        return;
+    }
+
+    Transpose trans[] = {Transpose::kNoTranspose, Transpose::kTranspose};
+    const uint64 m = a.dim_size(1 - dim_pair[0].first);
+    const uint64 k = a.dim_size(dim_pair[0].first);
+    const uint64 n = b.dim_size(1 - dim_pair[0].second);
+    bool transpose_a = dim_pair[0].first == 0;
+    bool transpose_b = dim_pair[0].second == 1;
+    auto blas_transpose_a = trans[transpose_a];
+    auto blas_transpose_b = trans[transpose_b];
+
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context,
+                bias.dims() == 1 && bias.dim_size(0) == static_cast<int64>(n),
+                errors::InvalidArgument("bias must be a vector of size ", n,
+                                        ", got shape ",
+                                        bias.shape().DebugString()));
+
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES(context, stream, errors::Internal("No GPU stream available."));
+
+    auto a_ptr = AsDeviceMemory(a.template flat<T>().data(),
+                                a.template flat<T>().size());
+    auto b_ptr = AsDeviceMemory(b.template flat<T>().data(),
+                                b.template flat<T>().size());
+    auto c_ptr = AsDeviceMemory(output->template flat<T>().data(),
+                                output->template flat<T>().size());
+    auto alpha = static_cast<T>(1.0);
+    auto beta = static_cast<T>(0.0);
+
+    // Cublas does C = A x B where A, B and C are column major.  The output is
+    // row major, so compute C' = B' x A' (' stands for transpose).
+    MatmulParameters matmul_parameters = {
+        transpose_a, transpose_b, m, n, k, a.dtype(),
+        stream->parent()->device_ordinal(),
+    };
+    // Only float is registered, so the GEMM always computes in F32.
+    AlgorithmConfig algorithm_config(kNoAlgorithm);
+    if (MatmulAutotuneEnable() &&
+        !AutoTuneFusedMatmul::GetInstance()->Find(matmul_parameters,
+                                                  &algorithm_config)) {
+      std::vector<se::blas::AlgorithmType> algorithms;
+      stream->parent()->GetBlasGemmAlgorithms(&algorithms);
+      ProfileResult best_result;
+      for (auto profile_algorithm : algorithms) {
+        ProfileResult profile_result;
+        bool cublas_launch_status =
+            stream
+                ->ThenBlasGemmWithAlgorithm(
+                    blas_transpose_b, blas_transpose_a, n, m, k, alpha, b_ptr,
+                    transpose_b ? k : n, a_ptr, transpose_a ? m : k, beta,
+                    &c_ptr, n, se::blas::ComputationType::kF32,
+                    profile_algorithm, &profile_result)
+                .ok();
+        if (cublas_launch_status && profile_result.is_valid() &&
+            profile_result.elapsed_time_in_ms() <
+                best_result.elapsed_time_in_ms()) {
+          best_result = profile_result;
+        }
+      }
+      // Each parameter set is tuned once.  If no algorithm produced a valid
+      // result, kNoAlgorithm is cached and the default GEMM is used.
+      if (best_result.is_valid()) {
+        algorithm_config.set_algorithm(best_result.algorithm());
+      }
+      AutoTuneFusedMatmul::GetInstance()->Insert(matmul_parameters,
+                                                 algorithm_config);
+    }
+
+    bool blas_launch_status;
+    if (algorithm_config.algorithm() != kNoAlgorithm) {
+      blas_launch_status =
+          stream
+              ->ThenBlasGemmWithAlgorithm(
+                  blas_transpose_b, blas_transpose_a, n, m, k, alpha, b_ptr,
+                  transpose_b ? k : n, a_ptr, transpose_a ? m : k, beta,
+                  &c_ptr, n, se::blas::ComputationType::kF32,
+                  algorithm_config.algorithm(), nullptr)
+              .ok();
+    } else {
+      blas_launch_status =
+          stream
+              ->ThenBlasGemm(blas_transpose_b, blas_transpose_a, n, m, k, 1.0f,
+                             b_ptr, transpose_b ? k : n, a_ptr,
+                             transpose_a ? m : k, 0.0f, &c_ptr, n)
+              .ok();
+    }
+    OP_REQUIRES(context, blas_launch_status,
+                errors::Internal("Blas GEMM launch failed : a.shape=(",
+                                 a.dim_size(0), ", ", a.dim_size(1),
+                                 "), b.shape=(", b.dim_size(0), ", ",
+                                 b.dim_size(1), "), m=", m, ", n=", n,
+                                 ", k=", k));
+
+    functor::FusedMatMulEpilogue<GPUDevice, T>()(
+        context->eigen_device<GPUDevice>(), activation,
+        bias.template vec<T>(), output->template matrix<T>());
+  }
+};
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 template <typename Device, typename T>
 class FusedMatMulOp : public OpKernel {
  public:
@@ -118,6 +275,14 @@ class FusedMatMulOp : public OpKernel {
                   {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
                   {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
     }
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+    if (std::is_same<Device, GPUDevice>::value) {
+      patterns = {{FCT::kBiasAdd, {"BiasAdd"}},
+                  {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
+                  {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
+                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
+    }
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
                                 context, "MatMul", patterns,
@@ -193,5 +358,17 @@ TF_CALL_float(REGISTER_FUSED_CPU_MATMUL);
 
 #undef REGISTER_FUSED_CPU_MATMUL
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// Registration of the GPU implementations.
+#define REGISTER_FUSED_GPU_MATMUL(T)                                  \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedMatMul").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<GPUDevice, T>);
+
+TF_CALL_float(REGISTER_FUSED_GPU_MATMUL);
+
+#undef REGISTER_FUSED_GPU_MATMUL
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 }  // namespace tensorflow
 #endif  // TENSORFLOW_CORE_KERNELS_MATMUL_OP_FUSED_H_
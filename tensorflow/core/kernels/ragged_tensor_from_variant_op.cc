@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -22,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_encode_decode.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -112,11 +114,15 @@ Status RaggedComponentsFromVariant(const Tensor& encoded_variant,
 
 template <typename VALUE_TYPE, typename SPLIT_TYPE>
 Status NestedStackRaggedTensors(
+    OpKernelContext* context,
     const std::vector<RaggedTensor>& ragged_components,
     const std::vector<int>& nested_dim_sizes, const int input_ragged_rank,
     const int output_ragged_rank, RaggedTensor* output_ragged) {
   output_ragged->nested_splits.reserve(output_ragged_rank);
   const int dims = nested_dim_sizes.size();
+  const int num_components = ragged_components.size();
+  auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  const int64 num_shard_units = std::max(num_components, 1);
 
   // Populate first `dims - 1` splits.
   for (int i = 0; i < dims - 1; i++) {
@@ -145,34 +151,47 @@ Status NestedStackRaggedTensors(
     dims_splits_vec(i + 1) = dims_splits_vec(i) + split_val;
   }
 
-  // Populate last `input_ragged_rank` splits.
+  // Populate last `input_ragged_rank` splits. The splits of each component
+  // are shifted by the last split values of the components before it, so
+  // compute where each component goes first, then copy them in parallel.
+  std::vector<int64> split_offsets(num_components + 1);
+  std::vector<SPLIT_TYPE> split_shifts(num_components + 1);
   for (int i = 0; i < input_ragged_rank; i++) {
-    int split_index = dims + i;
-    int split_size = 1;
-    for (int j = 0; j < ragged_components.size(); j++) {
+    split_offsets[0] = 0;
+    split_shifts[0] = 0;
+    for (int j = 0; j < num_components; j++) {
+      split_offsets[j + 1] = split_offsets[j];
+      split_shifts[j + 1] = split_shifts[j];
+      // Corner case: empty row. e.g [ [[x], [x]], [] ]
       if (!ragged_components[j].nested_splits.empty()) {
-        split_size += ragged_components[j].nested_splits[i].NumElements() - 1;
+        auto component_splits_vec =
+            ragged_components[j].nested_splits[i].vec<SPLIT_TYPE>();
+        const int64 component_splits_size = component_splits_vec.size();
+        split_offsets[j + 1] += component_splits_size - 1;
+        split_shifts[j + 1] += component_splits_vec(component_splits_size - 1);
       }
     }
+    int split_index = dims + i;
+    int split_size = split_offsets[num_components] + 1;
     output_ragged->nested_splits.push_back(
         Tensor(DataTypeToEnum<SPLIT_TYPE>::value, TensorShape({split_size})));
     auto splits_vec =
         output_ragged->nested_splits[split_index].vec<SPLIT_TYPE>();
     splits_vec(0) = 0;
-    SPLIT_TYPE last_split_value = 0;
-    int index = 1;
-    for (int j = 0; j < ragged_components.size(); j++) {
-      if (ragged_components[j].nested_splits.empty()) {
-        // Corner case: empty row. e.g [ [[x], [x]], [] ]
-        continue;
+    auto copy_splits = [&](int64 begin, int64 end) {
+      for (int64 j = begin; j < end; j++) {
+        if (ragged_components[j].nested_splits.empty()) continue;
+        auto component_splits_vec =
+            ragged_components[j].nested_splits[i].vec<SPLIT_TYPE>();
+        SPLIT_TYPE* out = splits_vec.data() + split_offsets[j];
+        for (int k = 1; k < component_splits_vec.size(); k++) {
+          out[k] = component_splits_vec(k) + split_shifts[j];
+        }
       }
-      auto component_splits_vec =
-          ragged_components[j].nested_splits[i].vec<SPLIT_TYPE>();
-      for (int k = 1; k < component_splits_vec.size(); k++, index++) {
-        splits_vec(index) = component_splits_vec(k) + last_split_value;
-      }
-      last_split_value = splits_vec(index - 1);
-    }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, num_components,
+          /*cost_per_unit=*/std::max<int64>(1, split_size / num_shard_units),
+          copy_splits);
   }
 
   // If the variant tensor input is empty, then we have no way to determine
@@ -190,38 +209,58 @@ Status NestedStackRaggedTensors(
     component_values_shape = ragged_components[0].values.shape();
   }
 
-  // Populate values.
-  int values_size = component_values_shape.dim_size(0);
-  for (int i = 1; i < ragged_components.size(); i++) {
-    if (ragged_components[i].values.dims() != component_values_shape.dims()) {
+  // Populate values. Each component's values are contiguous, so they are
+  // copied as a whole, in parallel, to their offset in the output.
+  std::vector<int64> value_offsets(num_components + 1, 0);
+  for (int i = 0; i < num_components; i++) {
+    const TensorShape& values_shape = ragged_components[i].values.shape();
+    if (values_shape.dims() != component_values_shape.dims()) {
       return errors::InvalidArgument(
           "Rank of values must match for all "
           "components; values shape at index 0: ",
           component_values_shape.DebugString(), ", values shape at index ", i,
-          ": ", ragged_components[i].values.shape().DebugString());
+          ": ", values_shape.DebugString());
     }
-    values_size += ragged_components[i].values.shape().dim_size(0);
+    for (int d = 1; d < values_shape.dims(); d++) {
+      if (values_shape.dim_size(d) != component_values_shape.dim_size(d)) {
+        return errors::InvalidArgument(
+            "Inner dimensions of values must match for all "
+            "components; values shape at index 0: ",
+            component_values_shape.DebugString(), ", values shape at index ",
+            i, ": ", values_shape.DebugString());
+      }
+    }
+    value_offsets[i + 1] = value_offsets[i] + values_shape.num_elements();
+  }
+  int64 num_inner_elements = 1;
+  for (int d = 1; d < component_values_shape.dims(); d++) {
+    num_inner_elements *= component_values_shape.dim_size(d);
+  }
+  if (num_inner_elements > 0) {
+    component_values_shape.set_dim(
+        0, value_offsets[num_components] / num_inner_elements);
+  } else {
+    int64 values_size = 0;
+    for (const RaggedTensor& component : ragged_components) {
+      values_size += component.values.dim_size(0);
+    }
+    component_values_shape.set_dim(0, values_size);
   }
-  component_values_shape.set_dim(0, values_size);
   output_ragged->values =
       Tensor(DataTypeToEnum<VALUE_TYPE>::value, component_values_shape);
-  auto output_values_flat =
-      output_ragged->values.flat_outer_dims<VALUE_TYPE, 2>();
-  int values_index = 0;
-  for (int i = 0; i < ragged_components.size(); i++) {
-    auto component_values_flat =
-        ragged_components[i].values.flat_outer_dims<VALUE_TYPE, 2>();
-    int num_inner_elements = ragged_components[i].values.NumElements();
-    if (ragged_components[i].values.dim_size(0) > 0) {
-      num_inner_elements /= ragged_components[i].values.dim_size(0);
+  VALUE_TYPE* output_values = output_ragged->values.flat<VALUE_TYPE>().data();
+  auto copy_values = [&](int64 begin, int64 end) {
+    for (int64 i = begin; i < end; i++) {
+      const Tensor& component_values = ragged_components[i].values;
+      std::copy_n(component_values.flat<VALUE_TYPE>().data(),
+                  component_values.NumElements(),
+                  output_values + value_offsets[i]);
     }
-    for (int j = 0; j < ragged_components[i].values.dim_size(0);
-         j++, values_index++) {
-      for (int k = 0; k < num_inner_elements; k++) {
-        output_values_flat(values_index, k) = component_values_flat(j, k);
-      }
-    }
-  }
+  };
+  Shard(worker_threads->num_threads, worker_threads->workers, num_components,
+        /*cost_per_unit=*/
+        std::max<int64>(1, value_offsets[num_components] / num_shard_units),
+        copy_values);
   return Status::OK();
 }
 }  // namespace
@@ -284,8 +323,8 @@ class RaggedTensorFromVariantOp : public OpKernel {
     RaggedTensor output_ragged;
     OP_REQUIRES_OK(
         context, NestedStackRaggedTensors<VALUE_TYPE, SPLIT_TYPE>(
-                     decoded_components, encoded_dim_sizes, input_ragged_rank_,
-                     output_ragged_rank_, &output_ragged));
+                     context, decoded_components, encoded_dim_sizes,
+                     input_ragged_rank_, output_ragged_rank_, &output_ragged));
 
     // Set output.
     ReturnRaggedTensor(context, output_ragged);
@@ -387,6 +387,49 @@ TEST_F(RaggedTensorFromVariantKernelTest, NDValues1DIn2DOut) {
   test::ExpectTensorEqual<int>(*GetOutput(2), expected_values);
 }
 
+TEST_F(RaggedTensorFromVariantKernelTest, ManyComponents1DIn2DOut) {
+  // ragged_component_i = [[x], [x, ..., x]], with 1 + (i % 3) values.
+  const int num_components = 200;
+  std::vector<Variant> variant_components;
+  std::vector<int64> batched_splits_1 = {0};
+  std::vector<int64> batched_splits_2 = {0};
+  std::vector<int> batched_values;
+  for (int i = 0; i < num_components; i++) {
+    const int num_values = 1 + i % 3;
+    std::vector<int> component_values;
+    for (int j = 0; j < num_values; j++) {
+      component_values.push_back(i * 10 + j);
+    }
+    variant_components.push_back(CreateVariantFromRagged<int, int64>(
+        {{0, 1, num_values}}, TensorShape({num_values}), component_values));
+    batched_splits_1.push_back(batched_splits_1.back() + 2);
+    const int64 last_split = batched_splits_2.back();
+    batched_splits_2.push_back(last_split + 1);
+    batched_splits_2.push_back(last_split + num_values);
+    batched_values.insert(batched_values.end(), component_values.begin(),
+                          component_values.end());
+  }
+
+  Tensor expected_splits_1(DT_INT64, TensorShape({num_components + 1}));
+  Tensor expected_splits_2(DT_INT64, TensorShape({2 * num_components + 1}));
+  Tensor expected_values(
+      DT_INT32, TensorShape({static_cast<int64>(batched_values.size())}));
+  test::FillValues<int64>(&expected_splits_1, batched_splits_1);
+  test::FillValues<int64>(&expected_splits_2, batched_splits_2);
+  test::FillValues<int>(&expected_values, batched_values);
+
+  int input_ragged_rank = 1;
+  int output_ragged_rank = 2;
+  BuildDecodeRaggedTensorGraph<int, int64>(
+      input_ragged_rank, output_ragged_rank, TensorShape({num_components}),
+      variant_components);
+
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<int64>(*GetOutput(0), expected_splits_1);
+  test::ExpectTensorEqual<int64>(*GetOutput(1), expected_splits_2);
+  test::ExpectTensorEqual<int>(*GetOutput(2), expected_values);
+}
+
 TEST_F(RaggedTensorFromVariantKernelTest, NonEmpty1DIn3DOutInt32Splits) {
   // ragged_component_1 = [[x]]
   // ragged_component_2 = [[x], [x]]
@@ -641,6 +684,27 @@ TEST_F(RaggedTensorFromVariantKernelTest, RaggedValuesRankMismatch) {
                                "Rank of values must match for all components"));
 }
 
+TEST_F(RaggedTensorFromVariantKernelTest, RaggedValuesInnerDimsMismatch) {
+  const std::vector<int64> component_split_1_1 = {0, 1};
+  const std::vector<int64> component_split_2_1 = {0, 1, 2};
+  const std::vector<int> component_values_1 = {0, 1, 2};
+  const std::vector<int> component_values_2 = {0, 1, 2, 3};
+
+  Tensor variant_component_1 = CreateVariantFromRagged<int, int64>(
+      {component_split_1_1}, TensorShape({1, 3}), component_values_1);
+  Tensor variant_component_2 = CreateVariantFromRagged<int, int64>(
+      {component_split_2_1}, TensorShape({2, 2}), component_values_2);
+  int input_ragged_rank = 1;
+  int output_ragged_rank = 2;
+  BuildDecodeRaggedTensorGraph<int, int64>(
+      input_ragged_rank, output_ragged_rank, TensorShape({2}),
+      {variant_component_1, variant_component_2});
+  EXPECT_TRUE(
+      absl::StartsWith(RunOpKernel().error_message(),
+                       "Inner dimensions of values must match for all "
+                       "components"));
+}
+
 TEST_F(RaggedTensorFromVariantKernelTest, ShapeFnTest) {
   ShapeInferenceTestOp op("RaggedTensorFromVariant");
 
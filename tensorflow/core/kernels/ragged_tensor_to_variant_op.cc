@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -22,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_encode_decode.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -43,8 +45,39 @@ Status RaggedToVariant(const RaggedTensor& ragged, Tensor* encoded_list) {
   return Status::OK();
 }
 
+// Sets the values of each of `ragged_components` to rows
+// [row_offsets[i], row_offsets[i + 1]) of `batched_values`, copying them in
+// parallel.
+template <typename VALUE_TYPE>
+void UnbatchRaggedValues(OpKernelContext* context, const Tensor& batched_values,
+                         const std::vector<int64>& row_offsets,
+                         int num_inner_elems,
+                         std::vector<RaggedTensor>* ragged_components) {
+  const int num_components = ragged_components->size();
+  const VALUE_TYPE* batched_data = batched_values.flat<VALUE_TYPE>().data();
+  auto copy_values = [&](int64 begin, int64 end) {
+    TensorShape values_shape = batched_values.shape();
+    for (int64 i = begin; i < end; i++) {
+      const int64 num_values = row_offsets[i + 1] - row_offsets[i];
+      values_shape.set_dim(0, num_values);
+      Tensor& values = (*ragged_components)[i].values;
+      values = Tensor(DataTypeToEnum<VALUE_TYPE>::value, values_shape);
+      std::copy_n(batched_data + row_offsets[i] * num_inner_elems,
+                  num_values * num_inner_elems,
+                  values.flat<VALUE_TYPE>().data());
+    }
+  };
+  const int64 cost_per_component =
+      (row_offsets[num_components] - row_offsets[0]) * num_inner_elems /
+      std::max(num_components, 1);
+  auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, num_components,
+        std::max<int64>(1, cost_per_component), copy_values);
+}
+
 template <typename VALUE_TYPE, typename SPLIT_TYPE>
-Status UnbatchRaggedZerothDim(const RaggedTensor& batched_ragged,
+Status UnbatchRaggedZerothDim(OpKernelContext* context,
+                              const RaggedTensor& batched_ragged,
                               std::vector<RaggedTensor>* ragged_components) {
   // Set up the component Ragged Tensors.
   int ragged_rank = batched_ragged.nested_splits.size();
@@ -56,29 +89,20 @@ Status UnbatchRaggedZerothDim(const RaggedTensor& batched_ragged,
   for (RaggedTensor ragged_component : *ragged_components) {
     ragged_component.nested_splits.reserve(num_splits);
   }
-  const auto& batched_flat = batched_ragged.values.flat<VALUE_TYPE>();
   int num_inner_elems = batched_ragged.values.NumElements();
   if (batched_ragged.values.dim_size(0) > 1) {
     num_inner_elems /= batched_ragged.values.dim_size(0);
   }
-  TensorShape values_shape = batched_ragged.values.shape();
+  std::vector<int64> row_offsets(num_components + 1);
 
   // Corner case: ragged_rank == 1, e.g. [[1, 2, 3], [4, 5]]
   if (num_splits == 0) {
-    for (int i = 0; i < num_components; i++) {
-      int start = batched_splits_top_vec(i);
-      int limit = batched_splits_top_vec(i + 1);
-      int num_values = limit - start;
-      values_shape.set_dim(0, num_values);
-      (*ragged_components)[i].values =
-          Tensor(DataTypeToEnum<VALUE_TYPE>::value, values_shape);
-      auto ragged_component_values_flat =
-          (*ragged_components)[i].values.flat<VALUE_TYPE>();
-      for (int j = 0; j < num_values * num_inner_elems; j++) {
-        ragged_component_values_flat(j) =
-            batched_flat(j + start * num_inner_elems);
-      }
+    for (int i = 0; i <= num_components; i++) {
+      row_offsets[i] = batched_splits_top_vec(i);
     }
+    UnbatchRaggedValues<VALUE_TYPE>(context, batched_ragged.values,
+                                    row_offsets, num_inner_elems,
+                                    ragged_components);
     return Status::OK();
   }
 
@@ -121,19 +145,12 @@ Status UnbatchRaggedZerothDim(const RaggedTensor& batched_ragged,
   }
 
   // Unbatch values.
-  int value_index = 0;
+  row_offsets[0] = 0;
   for (int i = 0; i < num_components; i++) {
-    int num_values = ragged_component_values_size[i];
-    values_shape.set_dim(0, num_values);
-    (*ragged_components)[i].values =
-        Tensor(DataTypeToEnum<VALUE_TYPE>::value, values_shape);
-    auto ragged_component_values_flat =
-        (*ragged_components)[i].values.flat<VALUE_TYPE>();
-    for (int j = 0; j < num_values * num_inner_elems; j++, value_index++) {
-      ragged_component_values_flat(j) = batched_flat(value_index);
-    }
+    row_offsets[i + 1] = row_offsets[i] + ragged_component_values_size[i];
   }
-
+  UnbatchRaggedValues<VALUE_TYPE>(context, batched_ragged.values, row_offsets,
+                                  num_inner_elems, ragged_components);
   return Status::OK();
 }
 }  // namespace
@@ -176,7 +193,8 @@ class RaggedTensorToVariantOp : public OpKernel {
     // Unbatch the Ragged Tensor and encode the components.
     std::vector<RaggedTensor> ragged_components;
     OP_REQUIRES_OK(context, UnbatchRaggedZerothDim<VALUE_TYPE, SPLIT_TYPE>(
-                                batched_ragged_input, &ragged_components));
+                                context, batched_ragged_input,
+                                &ragged_components));
     std::vector<Tensor> encoded_components(ragged_components.size());
     for (int i = 0; i < ragged_components.size(); i++) {
       OP_REQUIRES_OK(context, RaggedToVariant(ragged_components[i],
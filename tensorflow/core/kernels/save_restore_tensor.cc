@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -234,38 +235,22 @@ void RestoreTensor(OpKernelContext* context,
 
 namespace {
 
-// Tensors larger than this threshold will be restored from a thread-pool.
-const int64 kLargeShapeThreshold = 16 << 20;  // 16M
+// Tensors are restored by up to this many threads besides the op thread.
+const int kNumRestoreThreads = 8;
 
-// A restore operation for a single tensor.  Small tensors may be restored
-// directly from the op thread to improve read locality.  Large tensors can be
-// restored from a thread pool: this requires creating a separate BundleReader
-// for each restore.
+// Every restore thread reads at least about this many bytes, counting a
+// fixed cost for each tensor so that many small tensors, each needing its own
+// read, are spread over the threads too.
+const int64 kMinRestoreBytesPerThread = 4 << 20;  // 4MB
+const int64 kRestoreOpCostBytes = 64 << 10;       // 64KB
+
+// A restore operation for a single tensor.  The tensors are split into runs of
+// consecutive names, which are restored by different threads for
+// parallelism, each with its own BundleReader.  Consecutive names keep the
+// reads of every thread local.
 struct RestoreOp {
   RestoreOp& operator=(const RestoreOp&) = delete;
 
-  bool should_run_in_pool(BundleReader* reader) const {
-    TensorShape restored_full_shape;
-
-    // Ignore status here; we'll catch the error later.
-    if (!reader->LookupTensorShape(tensor_name, &restored_full_shape).ok()) {
-      return false;
-    }
-
-    return restored_full_shape.num_elements() > kLargeShapeThreshold;
-  }
-
-  // Run this restore operation using a new BundleReader.
-  void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
-    if (!reader.status().ok()) {
-      status = reader.status();
-      return;
-    }
-
-    status = run(&reader);
-  }
-
   Status run(BundleReader* reader) {
     TensorShape restored_full_shape;
     TF_RETURN_IF_ERROR(
@@ -275,10 +260,22 @@ struct RestoreOp {
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
     if (shape_and_slice.empty()) {
-      // Lookup the full tensor.
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(idx, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+      // Lookup the full tensor, pointing into the data file if possible.
+      bool mapped = false;
+      if (memory_mapped) {
+        Tensor mapped_tensor;
+        TF_RETURN_IF_ERROR(
+            reader->LookupMapped(tensor_name, &mapped_tensor, &mapped));
+        if (mapped) {
+          context->set_output(idx, std::move(mapped_tensor));
+          restored_tensor = context->mutable_output(idx);
+        }
+      }
+      if (!mapped) {
+        TF_RETURN_IF_ERROR(context->allocate_output(idx, restored_full_shape,
+                                                    &restored_tensor));
+        TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+      }
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
@@ -327,16 +324,24 @@ struct RestoreOp {
   string tensor_name;
   string shape_and_slice;
   string reader_prefix;
-
-  ::tensorflow::Status status;
+  bool memory_mapped;
 };
 
+// Restores `ops[begin, end)` in order with `reader`.
+Status RunRestoreOps(const std::vector<std::unique_ptr<RestoreOp> >& ops,
+                     size_t begin, size_t end, BundleReader* reader) {
+  for (size_t i = begin; i < end; ++i) {
+    TF_RETURN_IF_ERROR(ops[i]->run(reader));
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes) {
+                        gtl::ArraySlice<DataType> dtypes, bool memory_mapped) {
   const string& prefix_string = prefix.scalar<tstring>()();
 
   const auto& tensor_names_flat = tensor_names.flat<tstring>();
@@ -350,12 +355,12 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
               return tensor_names_flat(a) < tensor_names_flat(b);
             });
 
-  std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
-  std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
-
   BundleReader default_reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(default_reader.status());
 
+  // The cost of restoring each tensor, in the order of sorted_name_idx.
+  std::vector<int64> costs;
+  costs.reserve(sorted_name_idx.size());
   std::vector<string> mismatched_errors;
   for (const size_t i : sorted_name_idx) {
     TensorShape restored_full_shape;
@@ -363,6 +368,9 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     const string& tensor_name = tensor_names_flat(i);
     TF_RETURN_IF_ERROR(default_reader.LookupDtypeAndShape(
         tensor_name, &original_dtype, &restored_full_shape));
+    costs.push_back(restored_full_shape.num_elements() *
+                        std::max(DataTypeSize(original_dtype), 1) +
+                    kRestoreOpCostBytes);
     if (dtypes[i] != original_dtype) {
       string error_msg = strings::StrCat(
           "tensor_name = ", tensor_name, "; expected dtype ",
@@ -376,39 +384,65 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  std::vector<std::unique_ptr<RestoreOp> > restore_ops;
+  restore_ops.reserve(sorted_name_idx.size());
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    auto op =
-        new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
-    if (op->should_run_in_pool(&default_reader)) {
-      pool_restore_ops.emplace_back(op);
-    } else {
-      direct_restore_ops.emplace_back(op);
-    }
+    restore_ops.emplace_back(new RestoreOp{context, i, tensor_name,
+                                           shape_and_slice, prefix_string,
+                                           memory_mapped});
   }
 
+  // Split the tensors into runs of about the same cost.  The run of worker w
+  // holds the tensors starting in [w, w + 1) * total_cost / num_workers, so a
+  // large tensor gets a run of its own.
+  const int64 total_cost = std::accumulate(costs.begin(), costs.end(), int64{0});
+  const int num_workers = static_cast<int>(std::min<int64>(
+      1 + kNumRestoreThreads,
+      std::max<int64>(1, total_cost / kMinRestoreBytesPerThread)));
+  std::vector<size_t> run_starts(num_workers + 1, restore_ops.size());
+  run_starts[0] = 0;
   {
-    // Schedule any threaded operations first, skipping thread pool creation if
-    // we don't have any expensive operations.
-    std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
-      reader_pool.reset(
-          new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
-      for (auto& op : pool_restore_ops) {
-        reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
+    int64 cost_before = 0;
+    int worker = 0;
+    for (size_t i = 0; i < restore_ops.size(); ++i) {
+      while (worker + 1 < num_workers &&
+             cost_before >= total_cost * (worker + 1) / num_workers) {
+        run_starts[++worker] = i;
       }
+      cost_before += costs[i];
     }
+  }
 
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
-      TF_RETURN_IF_ERROR(op->run(&default_reader));
+  std::vector<Status> run_status(num_workers);
+  {
+    // Worker 0 reads from the op thread, the others from a thread pool, which
+    // is only created if there is more than one run.
+    std::unique_ptr<thread::ThreadPool> reader_pool;
+    if (num_workers > 1) {
+      reader_pool.reset(new thread::ThreadPool(
+          Env::Default(), "restore_tensors", num_workers - 1));
+      for (int w = 1; w < num_workers; ++w) {
+        if (run_starts[w] == run_starts[w + 1]) continue;
+        reader_pool->Schedule([&restore_ops, &run_starts, &run_status,
+                               &prefix_string, w]() {
+          BundleReader reader(Env::Default(), prefix_string);
+          run_status[w] = reader.status();
+          if (run_status[w].ok()) {
+            run_status[w] = RunRestoreOps(restore_ops, run_starts[w],
+                                          run_starts[w + 1], &reader);
+          }
+        });
+      }
     }
+    run_status[0] = RunRestoreOps(restore_ops, run_starts[0], run_starts[1],
+                                  &default_reader);
   }
 
-  // Check status of pool ops; this must come after the pool shuts down.
-  for (auto& op : pool_restore_ops) {
-    TF_RETURN_IF_ERROR(op->status);
+  // Check status of the runs; this must come after the pool shuts down.
+  for (const Status& status : run_status) {
+    TF_RETURN_IF_ERROR(status);
   }
 
   for (auto i : sorted_name_idx) {
@@ -63,10 +63,15 @@ void RestoreTensor(OpKernelContext* context,
 //   * "prefix" has 1 element, DT_STRING.
 //   * "tensor_names" and "shape_and_slices" shaped {N}, both DT_STRING.
 //   * "dtypes" has N elements, the datatypes of the to-restore tensors.
+//
+// If "memory_mapped" is true, full tensors whose bytes are suitably aligned in
+// the data files are returned as read-only views of a memory mapping of the
+// files instead of being copied (see "BundleReader::LookupMapped()").
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes);
+                        gtl::ArraySlice<DataType> dtypes,
+                        bool memory_mapped = false);
 
 }  // namespace tensorflow
 
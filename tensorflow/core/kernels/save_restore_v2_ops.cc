@@ -165,6 +165,12 @@ class RestoreV2 : public OpKernel {
  public:
   explicit RestoreV2(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
+    // Set on the nodes of graphs that only read the restored values, e.g. by
+    // the SavedModel loader (see LoadSavedModel's memory-mapping option).
+    if (context->HasAttr("_memory_mapped")) {
+      OP_REQUIRES_OK(context,
+                     context->GetAttr("_memory_mapped", &memory_mapped_));
+    }
   }
 
   void Compute(OpKernelContext* context) override {
@@ -201,13 +207,16 @@ class RestoreV2 : public OpKernel {
       return;
     }
     // If found, invokes the V2 reader.
-    OP_REQUIRES_OK(context, RestoreTensorsV2(context, prefix, tensor_names,
-                                             shape_and_slices, dtypes_));
+    OP_REQUIRES_OK(context,
+                   RestoreTensorsV2(context, prefix, tensor_names,
+                                    shape_and_slices, dtypes_, memory_mapped_));
   }
 
  private:
   // Expected dtypes of the to-restore tensors.
   std::vector<DataType> dtypes_;
+  // Whether to return views of the memory-mapped checkpoint where possible.
+  bool memory_mapped_ = false;
 };
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
@@ -23,8 +23,10 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -38,7 +40,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -77,6 +81,16 @@ extern bool UnsortedSegmentReductionDoValidation(OpKernel* op_kernel,
                                                  const Tensor& data,
                                                  const Tensor& segment_ids,
                                                  const Tensor& num_segments);
+
+// Segment reductions over fewer elements than this run on a single thread.
+constexpr int64 kMinParallelSegmentReductionSize = 1 << 15;
+
+// Splits the segments whose rows start at `offsets[0, n)`, with `offsets[n]`
+// the total number of rows, into at most `max_blocks` ranges of consecutive
+// segments holding about the same number of rows each.  Returns the first
+// segment of every range followed by n.
+extern std::vector<int64> SplitSegmentsByRows(
+    const std::vector<int64>& offsets, int64 max_blocks);
 }  // namespace internal
 
 // This operator handles reducing segments along the first dimension.
@@ -312,6 +326,13 @@ class SegmentSumGPUOp : public AsyncOpKernel {
 namespace functor {
 
 // The ReductionFunctor implementation for CPU.
+//
+// Large inputs are reduced in parallel: the rows are grouped by segment with
+// a stable counting sort and the segments are split among the threads into
+// ranges with the same number of rows, so that every output row is still
+// reduced by a single thread in the order of the input.  When one segment
+// holds more than a thread's share of the rows, the columns are split as
+// well, so that a skewed distribution does not leave the other threads idle.
 template <typename T, typename Index, typename InitialValueF,
           typename ReductionF>
 struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
@@ -325,9 +346,39 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     }
     const int64 N = segment_ids.dimension(0);
     const int64 num_segments = output.dimension(0);
+    const int64 inner_dim = data.dimension(1);
     ReductionF reduction;
+    auto reduce_row = [&](int64 i, int64 j, int64 col_begin, int64 col_end) {
+      reduction(typename TTypes<T>::UnalignedConstVec(&data(i, col_begin),
+                                                      col_end - col_begin),
+                typename TTypes<T>::UnalignedVec(&output(j, col_begin),
+                                                 col_end - col_begin));
+    };
+
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads.num_threads <= 1 ||
+        data.size() < internal::kMinParallelSegmentReductionSize) {
+      for (int64 i = 0; i < N; ++i) {
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (j < 0) {
+          continue;
+        }
+        OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
+                    errors::InvalidArgument(
+                        "segment_ids", SliceDebugString(segment_ids_shape, i),
+                        " = ", j, " is out of range [0, ", num_segments, ")"));
+        reduce_row(i, j, 0, inner_dim);
+      }
+      return;
+    }
+
+    // The rows of segment j are rows[offsets[j], offsets[j + 1]).
+    std::vector<Index> ids(N);
+    std::vector<int64> offsets(num_segments + 1, 0);
     for (int64 i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
+      ids[i] = j;
       if (j < 0) {
         continue;
       }
@@ -335,43 +386,82 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
                       " = ", j, " is out of range [0, ", num_segments, ")"));
-      reduction(data.template chip<0>(i), output.template chip<0>(j));
+      ++offsets[j + 1];
+    }
+    int64 max_segment_rows = 0;
+    for (int64 j = 0; j < num_segments; ++j) {
+      max_segment_rows = std::max(max_segment_rows, offsets[j + 1]);
+      offsets[j + 1] += offsets[j];
+    }
+    const int64 num_rows = offsets[num_segments];
+    std::vector<int64> rows(num_rows);
+    {
+      std::vector<int64> next(offsets.begin(), offsets.end() - 1);
+      for (int64 i = 0; i < N; ++i) {
+        if (ids[i] >= 0) rows[next[ids[i]]++] = i;
+      }
+    }
+
+    const int64 num_threads = worker_threads.num_threads;
+    const std::vector<int64> row_blocks =
+        internal::SplitSegmentsByRows(offsets, 4 * num_threads);
+    const int64 num_row_blocks = row_blocks.size() - 1;
+    int64 num_col_blocks = 1;
+    if (max_segment_rows * num_threads > num_rows) {
+      // Keep every column block several packets wide.
+      const int64 kMinColumnsPerBlock = 64;
+      num_col_blocks = std::max<int64>(
+          1, std::min(num_threads, inner_dim / kMinColumnsPerBlock));
     }
+    auto work = [&](int64 begin, int64 end) {
+      for (int64 b = begin; b < end; ++b) {
+        const int64 row_block = b / num_col_blocks;
+        const int64 col_block = b % num_col_blocks;
+        const int64 col_begin = inner_dim * col_block / num_col_blocks;
+        const int64 col_end = inner_dim * (col_block + 1) / num_col_blocks;
+        for (int64 j = row_blocks[row_block]; j < row_blocks[row_block + 1];
+             ++j) {
+          for (int64 k = offsets[j]; k < offsets[j + 1]; ++k) {
+            reduce_row(rows[k], j, col_begin, col_end);
+          }
+        }
+      }
+    };
+    const int64 num_blocks = num_row_blocks * num_col_blocks;
+    Shard(num_threads, worker_threads.workers, num_blocks,
+          std::max<int64>(1, num_rows * inner_dim / num_blocks), work);
   }
 };
 
-template <typename T>
-using MatrixChip = Eigen::TensorChippingOp<0l, typename TTypes<T, 2>::Matrix>;
-
-template <typename T>
-using constMatrixChip =
-    Eigen::TensorChippingOp<0l, const typename TTypes<T, 2>::ConstMatrix>;
-
 // reduction functors
 template <typename T>
 struct SumOp {
-  void operator()(const constMatrixChip<T> data, MatrixChip<T> output) {
+  void operator()(typename TTypes<T>::UnalignedConstVec data,
+                  typename TTypes<T>::UnalignedVec output) {
     output += data;
   }
 };
 
 template <typename T>
 struct MaxOp {
-  void operator()(const constMatrixChip<T> data, MatrixChip<T> output) {
+  void operator()(typename TTypes<T>::UnalignedConstVec data,
+                  typename TTypes<T>::UnalignedVec output) {
     output = data.cwiseMax(output);
   }
 };
 
 template <typename T>
 struct MinOp {
-  void operator()(const constMatrixChip<T> data, MatrixChip<T> output) {
+  void operator()(typename TTypes<T>::UnalignedConstVec data,
+                  typename TTypes<T>::UnalignedVec output) {
     output = data.cwiseMin(output);
   }
 };
 
 template <typename T>
 struct ProdOp {
-  void operator()(const constMatrixChip<T> data, MatrixChip<T> output) {
+  void operator()(typename TTypes<T>::UnalignedConstVec data,
+                  typename TTypes<T>::UnalignedVec output) {
     output *= data;
   }
 };
@@ -419,6 +509,68 @@ class UnsortedSegmentReductionOp : public OpKernel {
   DeviceReductionFunctor reduction_functor_;
 };
 
+// Sums the rows of `data` that have the same index, e.g. to deduplicate the
+// gradient of a gather from an embedding.  Equivalent to a Unique of
+// `indices` followed by an UnsortedSegmentSum over its positions, in a single
+// kernel: the unique indices are output in the order they first appear.
+template <typename T, typename Index>
+class UniqueSegmentSumOp : public OpKernel {
+ public:
+  explicit UniqueSegmentSumOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& data = context->input(0);
+    const Tensor& indices = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector, got ",
+                                        indices.shape().DebugString()));
+    OP_REQUIRES(
+        context, TensorShapeUtils::StartsWith(data.shape(), indices.shape()),
+        errors::InvalidArgument("data.shape = ", data.shape().DebugString(),
+                                " does not start with indices.shape = ",
+                                indices.shape().DebugString()));
+    const auto indices_vec = indices.vec<Index>();
+    const int64 N = indices_vec.dimension(0);
+
+    // positions(i) is the position of indices(i) among the unique indices.
+    Tensor positions;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<Index>::v(),
+                                                   TensorShape({N}),
+                                                   &positions));
+    auto positions_vec = positions.vec<Index>();
+    absl::flat_hash_map<Index, Index> uniq;
+    uniq.reserve(2 * N);
+    std::vector<Index> unique_indices;
+    for (int64 i = 0; i < N; ++i) {
+      const Index index = internal::SubtleMustCopy(indices_vec(i));
+      auto it = uniq.emplace(index, static_cast<Index>(uniq.size())).first;
+      if (it->second == static_cast<Index>(unique_indices.size())) {
+        unique_indices.push_back(index);
+      }
+      positions_vec(i) = it->second;
+    }
+    const int64 num_unique = unique_indices.size();
+
+    Tensor* unique_indices_t = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, TensorShape({num_unique}),
+                                            &unique_indices_t));
+    std::copy(unique_indices.begin(), unique_indices.end(),
+              unique_indices_t->vec<Index>().data());
+
+    TensorShape output_shape = data.shape();
+    output_shape.set_dim(0, num_unique);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    functor::UnsortedSegmentFunctor<CPUDevice, T, Index, functor::Zero<T>,
+                                    functor::SumOp<T>>()(
+        context, indices.shape(),
+        typename TTypes<Index>::ConstFlat(positions_vec.data(), N),
+        data.flat_outer_dims<T>(), output->flat_outer_dims<T>());
+  }
+};
+
 // ____________________________________________________________________________
 // Sparse segment reduction ops.
 
@@ -514,12 +666,13 @@ class SparseSegmentReductionOpBase : public OpKernel {
     }
     auto temp_flat = temp.flat_outer_dims<float>();
 
-    int64 start = 0, end = 1;
-    // Index from which the output is not initialized.
-    SegmentId uninitialized_index = 0;
-    SegmentId out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    while (true) {
+    // Find the run of indices of every segment first, so that the segments
+    // can be reduced in parallel.  Segment k is segments[k] and reduces the
+    // indices [offsets[k], offsets[k + 1]).
+    std::vector<SegmentId> segments;
+    std::vector<int64> offsets = {0};
+    SegmentId out_index = internal::SubtleMustCopy(segment_vec(0));
+    for (int64 end = 1; end <= num_indices; ++end) {
       // We initialize next_index to 0 to avoid "warning: 'next_index' may be
       // used uninitialized in this function" in the Mac build (since the
       // compiler isn't smart enough to realize the code is safe).
@@ -527,7 +680,6 @@ class SparseSegmentReductionOpBase : public OpKernel {
       if (end < num_indices) {
         next_index = internal::SubtleMustCopy(segment_vec(end));
         if (out_index == next_index) {
-          ++end;
           continue;
         }
         // We have a new segment here.  Verify that the segment ids are growing.
@@ -540,42 +692,71 @@ class SparseSegmentReductionOpBase : public OpKernel {
           errors::InvalidArgument(
               "Segment id ", out_index, " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
-
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(default_value_);
-      }
-
-      auto out = output_flat.template chip<0>(out_index);
-      auto temp = temp_flat.template chip<0>(out_index);
-      const int bad_offset = Reduce<T, Index>(input_flat, indices_vec, start,
-                                              end - start, out, temp);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset,
-                      "] == ", indices_vec(start + bad_offset),
-                      " out of range [0, ", input_flat.dimension(0), ")"));
-
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
+      segments.push_back(out_index);
+      offsets.push_back(end);
       out_index = next_index;
-      if (end > num_indices) break;
     }
 
-    // Fill the gap at the end with the default value.
-    if (uninitialized_index < output_rows) {
-      Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-          output_rows - uninitialized_index, num_col);
+    // Sets the output rows [begin, end) to the default value.
+    auto fill_gap = [&](int64 begin, int64 end) {
+      if (end <= begin) return;
+      Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(end - begin,
+                                                          num_col);
       Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-          gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice(&output_flat(begin, 0), gap_slice_shape);
       gap_slice.setConstant(default_value_);
+    };
+    // Reduces the segments [begin, end) and returns the position of the
+    // first out of range index, or -1.
+    auto reduce_segments = [&](int64 begin, int64 end) -> int64 {
+      for (int64 k = begin; k < end; ++k) {
+        // If there is a gap between two indices, we need to set that gap to
+        // the default value.
+        fill_gap(k == 0 ? 0 : segments[k - 1] + 1, segments[k]);
+        auto out = output_flat.template chip<0>(segments[k]);
+        auto temp = temp_flat.template chip<0>(segments[k]);
+        const int64 bad_offset =
+            Reduce<T, Index>(input_flat, indices_vec, offsets[k],
+                             offsets[k + 1] - offsets[k], out, temp);
+        if (bad_offset >= 0) return offsets[k] + bad_offset;
+      }
+      return -1;
+    };
+
+    int64 bad_index = -1;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads.num_threads <= 1 ||
+        num_indices * num_col < internal::kMinParallelSegmentReductionSize) {
+      bad_index = reduce_segments(0, segments.size());
+    } else {
+      // Split the segments into blocks with the same number of indices, so
+      // that skewed segment sizes still spread over the threads.
+      const std::vector<int64> blocks = internal::SplitSegmentsByRows(
+          offsets, 4 * worker_threads.num_threads);
+      const int64 num_blocks = blocks.size() - 1;
+      mutex mu;
+      auto work = [&](int64 begin, int64 end) {
+        for (int64 b = begin; b < end; ++b) {
+          const int64 bad = reduce_segments(blocks[b], blocks[b + 1]);
+          if (bad >= 0) {
+            // Report the same index as a sequential reduction would.
+            mutex_lock l(mu);
+            if (bad_index < 0 || bad < bad_index) bad_index = bad;
+            return;
+          }
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            std::max<int64>(1, num_indices * num_col / num_blocks), work);
     }
+    OP_REQUIRES(context, bad_index < 0,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_index, "] == ", indices_vec(bad_index),
+                    " out of range [0, ", input_flat.dimension(0), ")"));
+
+    // Fill the gap at the end with the default value.
+    fill_gap(segments.back() + 1, output_rows);
   }
 
  private:
@@ -66,6 +66,26 @@ bool UnsortedSegmentReductionDoValidation(OpKernel* op_kernel,
   return context->status().ok();
 }
 
+std::vector<int64> SplitSegmentsByRows(const std::vector<int64>& offsets,
+                                       int64 max_blocks) {
+  const int64 num_segments = offsets.size() - 1;
+  const int64 num_rows = offsets[num_segments] - offsets[0];
+  std::vector<int64> blocks = {0};
+  for (int64 b = 1; b < max_blocks; ++b) {
+    // The first segment starting at or after the b-th share of the rows.
+    const int64 target = offsets[0] + num_rows * b / max_blocks;
+    const int64 segment =
+        std::lower_bound(offsets.begin() + blocks.back(), offsets.end() - 1,
+                         target) -
+        offsets.begin();
+    if (segment > blocks.back() && segment < num_segments) {
+      blocks.push_back(segment);
+    }
+  }
+  blocks.push_back(num_segments);
+  return blocks;
+}
+
 }  // namespace internal
 
 #define REGISTER_CPU_KERNEL_SEGMENT(name, functor, type, index_type, \
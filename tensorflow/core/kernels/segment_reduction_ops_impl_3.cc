@@ -69,6 +69,16 @@ REGISTER_COMPLEX_CPU_UNSORTED_KERNELS_ALL(complex128);
 #undef REGISTER_COMPLEX_CPU_UNSORTED_KERNELS_ALL
 #undef REGISTER_REAL_CPU_UNSORTED_KERNELS_ALL
 
+#define REGISTER_CPU_UNIQUE_SEGMENT_SUM_KERNEL(type)              \
+  REGISTER_KERNEL_BUILDER(Name("UniqueSegmentSum")                \
+                              .Device(DEVICE_CPU)                 \
+                              .TypeConstraint<type>("T")          \
+                              .TypeConstraint<int32>("Tindices"), \
+                          UniqueSegmentSumOp<type, int32>)
+
+TF_CALL_NUMBER_TYPES(REGISTER_CPU_UNIQUE_SEGMENT_SUM_KERNEL);
+#undef REGISTER_CPU_UNIQUE_SEGMENT_SUM_KERNEL
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #define REGISTER_GPU_KERNEL_UNSORTEDSEGMENT(                                 \
     name, type, index_type, initial_value_functor, reduction_kernel_functor) \
@@ -19,6 +19,9 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -245,6 +248,8 @@ template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
 struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
   // Vectorize certain operations above this size.
   static constexpr std::size_t kNumVectorize = 32;
+  // Products with fewer multiply-adds than this run on a single thread.
+  static constexpr std::size_t kMinParallelSize = 1 << 16;
 
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
@@ -258,9 +263,9 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
 
     out.setZero();
 
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
+    if (d.numThreads() > 1 && nnz * rhs_right >= kMinParallelSize) {
+      return ParallelCompute(d, out, a_indices, a_values, b);
+    }
 
     if (rhs_right < kNumVectorize) {
       // Disable vectorization if the RHS of output is too small
@@ -314,6 +319,91 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     }
     return Status::OK();
   }
+
+ private:
+  // Groups the entries of A by output row with a stable counting sort, which
+  // turns the COO indices into CSR row offsets, and lets every thread
+  // accumulate a contiguous range of output rows.  Each output row is owned
+  // by a single thread and sums its entries in the order of a_indices, so the
+  // result is the same as that of the single threaded loops above.
+  static Status ParallelCompute(const CPUDevice& d,
+                                typename TTypes<T>::Matrix out,
+                                typename TTypes<Tindices>::ConstMatrix a_indices,
+                                typename TTypes<T>::ConstVec a_values,
+                                typename TTypes<T>::ConstMatrix b) {
+    const std::size_t nnz = a_values.size();
+    const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+    const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
+    const int lhs_index_a = ADJ_A ? 1 : 0;
+    const int rhs_index_a = ADJ_A ? 0 : 1;
+    const int64 num_rows = out.dimension(0);
+
+    // The entries of output row m are entries[row_offsets[m],
+    // row_offsets[m + 1]), stored as (k, position in a_values) pairs.
+    std::vector<int64> row_offsets(num_rows + 1, 0);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+      const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+      if (!FastBoundsCheck(k, lhs_right)) {
+        return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+      }
+      if (!FastBoundsCheck(m, num_rows)) {
+        return MOutOfBoundsError(m, i, lhs_index_a, num_rows);
+      }
+      ++row_offsets[m + 1];
+    }
+    for (int64 m = 0; m < num_rows; ++m) {
+      row_offsets[m + 1] += row_offsets[m];
+    }
+    std::vector<std::pair<Tindices, int64>> entries(nnz);
+    {
+      std::vector<int64> next(row_offsets.begin(), row_offsets.end() - 1);
+      for (std::size_t i = 0; i < nnz; ++i) {
+        const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+        entries[next[m]++] = {k, static_cast<int64>(i)};
+      }
+    }
+
+    // Transpose and conjugate B once, so that the rows of B used by an entry
+    // are contiguous.
+    Eigen::Tensor<T, 2, Eigen::RowMajor> conj_b_t;
+    const T* b_data = b.data();
+    if (ADJ_B) {
+      Eigen::array<int, 2> shuffle(1, 0);
+      conj_b_t.resize(b.dimension(1), b.dimension(0));
+      conj_b_t.device(d) = b.shuffle(shuffle).conjugate();
+      b_data = conj_b_t.data();
+    }
+
+    auto work = [&](Eigen::Index begin, Eigen::Index end) {
+      for (Eigen::Index m = begin; m < end; ++m) {
+        T* out_row = &out(m, 0);
+        for (int64 e = row_offsets[m]; e < row_offsets[m + 1]; ++e) {
+          const T* b_row = b_data + entries[e].first * rhs_right;
+          const int64 i = entries[e].second;
+          const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+          if (rhs_right < kNumVectorize) {
+            for (std::size_t n = 0; n < rhs_right; ++n) {
+              out_row[n] += a_value * b_row[n];
+            }
+          } else {
+            typename TTypes<T>::UnalignedVec(out_row, rhs_right) +=
+                typename TTypes<T>::UnalignedConstVec(b_row, rhs_right) *
+                a_value;
+          }
+        }
+      }
+    };
+    const double entries_per_row = static_cast<double>(nnz) / num_rows;
+    const Eigen::TensorOpCost cost(
+        entries_per_row * rhs_right * sizeof(T) /* bytes_loaded */,
+        rhs_right * sizeof(T) /* bytes_stored */,
+        entries_per_row * rhs_right *
+            Eigen::TensorOpCost::MulCost<T>() /* compute_cycles */);
+    d.parallelFor(num_rows, cost, work);
+    return Status::OK();
+  }
 };
 
 }  // namespace functor
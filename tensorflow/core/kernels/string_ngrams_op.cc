@@ -19,6 +19,7 @@ limitations under the License.
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace text {
@@ -96,37 +97,49 @@ class StringNGramsOp : public tensorflow::OpKernel {
             0, TensorShape({ngrams_splits_data[num_batch_items]}), &ngrams));
     auto ngrams_data = ngrams->flat<tstring>().data();
 
-    for (int i = 0; i < num_batch_items; ++i) {
-      auto data_start = &input_data[splits_vec(i)];
-      int output_start_idx = ngrams_splits_data[i];
-      for (int ngram_width : ngram_widths_) {
-        auto output_start = &ngrams_data[output_start_idx];
-        int length = splits_vec(i + 1) - splits_vec(i);
-        int num_ngrams = get_num_ngrams(length, ngram_width);
-        CreateNgrams(data_start, output_start, num_ngrams, ngram_width);
-        output_start_idx += num_ngrams;
-      }
-      // If we're preserving short sequences, check to see if no sequence was
-      // generated by comparing the current output start idx to the original
-      // one (ngram_splits_data). If no ngrams were generated, then they will
-      // be equal (since we increment output_start_idx by num_ngrams every
-      // time we create a set of ngrams.)
-      if (preserve_short_ && output_start_idx == ngrams_splits_data[i]) {
-        int data_length = splits_vec(i + 1) - splits_vec(i);
-        // One legitimate reason to not have any ngrams when preserve_short_
-        // is true is if the sequence itself is empty. In that case, move on.
-        if (data_length == 0) {
-          continue;
+    // The batch items write disjoint ranges of the output, so they are
+    // processed in parallel.  A rough number of cycles to build the ngrams of
+    // one batch item.
+    const int64 cost_per_item =
+        50 * ngram_widths_.size() *
+        std::max<int64>(1, data->NumElements() / std::max(1, num_batch_items));
+    auto work = [&](int64 start, int64 end) {
+      for (int64 i = start; i < end; ++i) {
+        auto data_start = &input_data[splits_vec(i)];
+        int output_start_idx = ngrams_splits_data[i];
+        for (int ngram_width : ngram_widths_) {
+          auto output_start = &ngrams_data[output_start_idx];
+          int length = splits_vec(i + 1) - splits_vec(i);
+          int num_ngrams = get_num_ngrams(length, ngram_width);
+          CreateNgrams(data_start, output_start, num_ngrams, ngram_width);
+          output_start_idx += num_ngrams;
+        }
+        // If we're preserving short sequences, check to see if no sequence was
+        // generated by comparing the current output start idx to the original
+        // one (ngram_splits_data). If no ngrams were generated, then they will
+        // be equal (since we increment output_start_idx by num_ngrams every
+        // time we create a set of ngrams.)
+        if (preserve_short_ && output_start_idx == ngrams_splits_data[i]) {
+          int data_length = splits_vec(i + 1) - splits_vec(i);
+          // One legitimate reason to not have any ngrams when preserve_short_
+          // is true is if the sequence itself is empty. In that case, move on.
+          if (data_length == 0) {
+            continue;
+          }
+          // We don't have to worry about dynamic padding sizes here: if padding
+          // was dynamic, every sequence would have had sufficient padding to
+          // generate at least one ngram.
+          int ngram_width = data_length + 2 * pad_width_;
+          auto output_start = &ngrams_data[output_start_idx];
+          int num_ngrams = 1;
+          CreateNgrams(data_start, output_start, num_ngrams, ngram_width);
         }
-        // We don't have to worry about dynamic padding sizes here: if padding
-        // was dynamic, every sequence would have had sufficient padding to
-        // generate at least one ngram.
-        int ngram_width = data_length + 2 * pad_width_;
-        auto output_start = &ngrams_data[output_start_idx];
-        int num_ngrams = 1;
-        CreateNgrams(data_start, output_start, num_ngrams, ngram_width);
       }
-    }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_batch_items,
+          cost_per_item, work);
   }
 
   void CreateNgrams(const tstring* data, tstring* output, int num_ngrams,
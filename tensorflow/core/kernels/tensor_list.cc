@@ -21,6 +21,55 @@ limitations under the License.
 
 namespace tensorflow {
 
+void ChunkedTensorVector::push_back(Tensor t) {
+  if (size_ == chunks_.size() * kChunkSize) {
+    chunks_.push_back(new Chunk);
+    chunks_.back()->values.reserve(kChunkSize);
+  }
+  Chunk* chunk = MutableChunk(size_ / kChunkSize);
+  chunk->values.push_back(std::move(t));
+  ++size_;
+}
+
+void ChunkedTensorVector::resize(size_t n, const Tensor& value) {
+  if (n < size_) {
+    // Shared chunks are left as they are; the other vectors may use them.
+    const size_t num_chunks = (n + kChunkSize - 1) / kChunkSize;
+    for (size_t c = num_chunks; c < chunks_.size(); ++c) {
+      chunks_[c]->Unref();
+    }
+    chunks_.resize(num_chunks);
+    size_ = n;
+    if (num_chunks > 0 && chunks_.back()->RefCountIsOne()) {
+      chunks_.back()->values.resize(ChunkSize(num_chunks - 1));
+    }
+    return;
+  }
+  reserve(n);
+  while (size_ < n) push_back(value);
+}
+
+void ChunkedTensorVector::clear() {
+  for (Chunk* chunk : chunks_) chunk->Unref();
+  chunks_.clear();
+  size_ = 0;
+}
+
+ChunkedTensorVector::Chunk* ChunkedTensorVector::MutableChunk(size_t c) {
+  Chunk* chunk = chunks_[c];
+  const size_t size = ChunkSize(c);
+  if (!chunk->RefCountIsOne()) {
+    Chunk* copy = new Chunk;
+    copy->values.reserve(kChunkSize);
+    copy->values.assign(chunk->values.begin(), chunk->values.begin() + size);
+    chunk->Unref();
+    chunks_[c] = chunk = copy;
+  } else if (chunk->values.size() > size) {
+    chunk->values.resize(size);
+  }
+  return chunk;
+}
+
 TensorList::~TensorList() {
   if (tensors_) tensors_->Unref();
 }
@@ -15,7 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_TENSOR_LIST_H_
 #define TENSORFLOW_CORE_KERNELS_TENSOR_LIST_H_
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant.h"
@@ -24,6 +27,141 @@ limitations under the License.
 
 namespace tensorflow {
 
+// A vector of tensors stored in reference-counted chunks of kChunkSize
+// elements. Copies share the chunks, and a chunk is only copied when it is
+// modified while shared. Copying a vector of n tensors and updating one of
+// them thus costs O(n / kChunkSize + kChunkSize) rather than O(n), which keeps
+// lists that are repeatedly copied and grown, e.g. by TensorListPushBack
+// while a while loop keeps an alias of the list for backprop, linear overall.
+//
+// Provides the subset of the std::vector interface used by the list kernels.
+// Not thread-safe, like std::vector; distinct copies may be used concurrently.
+class ChunkedTensorVector {
+ public:
+  static constexpr size_t kChunkSize = 64;
+
+  using value_type = Tensor;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Tensor;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Tensor*;
+    using reference = const Tensor&;
+
+    const_iterator(const ChunkedTensorVector* v, size_t i) : v_(v), i_(i) {}
+
+    reference operator*() const { return (*v_)[i_]; }
+    pointer operator->() const { return &(*v_)[i_]; }
+    const_iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+    const_iterator operator++(int) { return const_iterator(v_, i_++); }
+    const_iterator operator+(difference_type n) const {
+      return const_iterator(v_, i_ + n);
+    }
+    bool operator==(const const_iterator& other) const {
+      return v_ == other.v_ && i_ == other.i_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    const ChunkedTensorVector* v_;
+    size_t i_;
+  };
+
+  ChunkedTensorVector() {}
+  ~ChunkedTensorVector() { clear(); }
+
+  ChunkedTensorVector(const ChunkedTensorVector& other)
+      : chunks_(other.chunks_), size_(other.size_) {
+    for (Chunk* chunk : chunks_) chunk->Ref();
+  }
+
+  ChunkedTensorVector(ChunkedTensorVector&& other)
+      : chunks_(std::move(other.chunks_)), size_(other.size_) {
+    other.chunks_.clear();
+    other.size_ = 0;
+  }
+
+  ChunkedTensorVector& operator=(const ChunkedTensorVector& other) {
+    ChunkedTensorVector copy(other);
+    std::swap(chunks_, copy.chunks_);
+    std::swap(size_, copy.size_);
+    return *this;
+  }
+
+  ChunkedTensorVector& operator=(ChunkedTensorVector&& other) {
+    std::swap(chunks_, other.chunks_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const Tensor& operator[](size_t i) const {
+    return chunks_[i / kChunkSize]->values[i % kChunkSize];
+  }
+  // Copies the chunk holding element `i` if it is shared.
+  Tensor& operator[](size_t i) {
+    return MutableChunk(i / kChunkSize)->values[i % kChunkSize];
+  }
+  const Tensor& at(size_t i) const {
+    DCHECK_LT(i, size_);
+    return (*this)[i];
+  }
+  const Tensor& back() const { return (*this)[size_ - 1]; }
+  Tensor& back() { return (*this)[size_ - 1]; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  void push_back(Tensor t);
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    push_back(Tensor(std::forward<Args>(args)...));
+  }
+  void pop_back() { resize(size_ - 1); }
+
+  void resize(size_t n) { resize(n, Tensor()); }
+  void resize(size_t n, const Tensor& value);
+  void reserve(size_t n) {
+    chunks_.reserve((n + kChunkSize - 1) / kChunkSize);
+  }
+  void clear();
+
+  // Appends the elements in [first, last); `pos` must be end().
+  template <typename InputIt>
+  void insert(const_iterator pos, InputIt first, InputIt last) {
+    DCHECK(pos == end());
+    for (; first != last; ++first) push_back(*first);
+  }
+
+ private:
+  // A chunk may hold more values than the vectors sharing it use, if some of
+  // them were shrunk. Its values are never modified while it is shared.
+  struct Chunk : public core::RefCounted {
+    std::vector<Tensor> values;
+  };
+
+  // The number of elements of chunk `c` in use.
+  size_t ChunkSize(size_t c) const {
+    return std::min(kChunkSize, size_ - c * kChunkSize);
+  }
+
+  // Returns chunk `c`, copying it first if it is shared, with exactly the
+  // elements in use.
+  Chunk* MutableChunk(size_t c);
+
+  std::vector<Chunk*> chunks_;
+  size_t size_ = 0;
+};
+
 // Variant compatible type for a list of tensors. This is mutable but instances
 // should never be mutated after stored in a variant tensor.
 //
@@ -123,16 +261,17 @@ class TensorList {
   int max_num_elements = -1;
 
   // Access to the underlying tensor container.
-  std::vector<Tensor>& tensors() { return tensors_->values_; }
-  const std::vector<Tensor>& tensors() const { return tensors_->values_; }
+  ChunkedTensorVector& tensors() { return tensors_->values_; }
+  const ChunkedTensorVector& tensors() const { return tensors_->values_; }
 
   // Get a new TensorList containing a copy of the underlying tensor container.
+  // The copy shares the chunks of the container until either list modifies
+  // them (see ChunkedTensorVector).
   TensorList Copy() const {
     TensorList out;
     out.element_shape = element_shape;
     out.element_dtype = element_dtype;
     out.max_num_elements = max_num_elements;
-    // This performs a copy of the std::vector.
     out.tensors_->values_ = tensors_->values_;
     return out;
   }
@@ -144,7 +283,7 @@ class TensorList {
  private:
   class Tensors : public core::RefCounted {
    public:
-    std::vector<Tensor> values_;
+    ChunkedTensorVector values_;
   };
   Tensors* tensors_;
 };
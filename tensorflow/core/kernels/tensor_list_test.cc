@@ -0,0 +1,131 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/tensor_list.h"
+
+#include <iterator>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kSize = 3 * ChunkedTensorVector::kChunkSize + 5;
+
+ChunkedTensorVector MakeVector(int size) {
+  ChunkedTensorVector v;
+  for (int i = 0; i < size; ++i) {
+    v.push_back(Tensor(i));
+  }
+  return v;
+}
+
+void ExpectValues(const ChunkedTensorVector& v, int size) {
+  ASSERT_EQ(v.size(), size);
+  for (int i = 0; i < size; ++i) {
+    EXPECT_EQ(v[i].scalar<int32>()(), i) << i;
+  }
+}
+
+TEST(ChunkedTensorVectorTest, PushBackAndIterate) {
+  ChunkedTensorVector v = MakeVector(kSize);
+  ExpectValues(v, kSize);
+  EXPECT_EQ(v.back().scalar<int32>()(), kSize - 1);
+  EXPECT_EQ(std::distance(v.begin(), v.end()), kSize);
+  int i = 0;
+  for (const Tensor& t : v) {
+    EXPECT_EQ(t.scalar<int32>()(), i++);
+  }
+
+  ChunkedTensorVector empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.begin(), empty.end());
+}
+
+TEST(ChunkedTensorVectorTest, CopiesAreIndependent) {
+  ChunkedTensorVector a = MakeVector(kSize);
+  ChunkedTensorVector b = a;
+  b[1] = Tensor(-1);
+  b.push_back(Tensor(kSize));
+  a.pop_back();
+  a.push_back(Tensor(-2));
+
+  EXPECT_EQ(a.size(), kSize);
+  EXPECT_EQ(a[1].scalar<int32>()(), 1);
+  EXPECT_EQ(a.back().scalar<int32>()(), -2);
+  EXPECT_EQ(b.size(), kSize + 1);
+  EXPECT_EQ(b[1].scalar<int32>()(), -1);
+  EXPECT_EQ(b[kSize - 1].scalar<int32>()(), kSize - 1);
+  EXPECT_EQ(b.back().scalar<int32>()(), kSize);
+}
+
+TEST(ChunkedTensorVectorTest, ResizeSharedVector) {
+  ChunkedTensorVector a = MakeVector(kSize);
+  ChunkedTensorVector b = a;
+  // Shrink into the middle of a shared chunk, then grow again.
+  b.resize(ChunkedTensorVector::kChunkSize + 3);
+  b.resize(kSize + 2, Tensor(-1));
+  ExpectValues(a, kSize);
+  ASSERT_EQ(b.size(), kSize + 2);
+  for (int i = 0; i < kSize + 2; ++i) {
+    const int expected = i < ChunkedTensorVector::kChunkSize + 3 ? i : -1;
+    EXPECT_EQ(b[i].scalar<int32>()(), expected) << i;
+  }
+
+  // The other vector then owns the chunk, and may reuse it.
+  b.clear();
+  a.resize(ChunkedTensorVector::kChunkSize + 3);
+  a.push_back(Tensor(-3));
+  EXPECT_EQ(a.back().scalar<int32>()(), -3);
+}
+
+TEST(ChunkedTensorVectorTest, Insert) {
+  ChunkedTensorVector a = MakeVector(kSize);
+  ChunkedTensorVector b;
+  b.insert(b.end(), a.begin(), a.begin() + 10);
+  ExpectValues(b, 10);
+  std::copy(a.begin() + 10, a.end(), std::back_inserter(b));
+  ExpectValues(b, kSize);
+}
+
+TEST(TensorListTest, CopyDoesNotModifyOriginal) {
+  TensorList a;
+  a.element_dtype = DT_INT32;
+  a.tensors() = MakeVector(kSize);
+  TensorList b = a.Copy();
+  b.tensors().push_back(Tensor(kSize));
+  b.tensors()[0] = Tensor(-1);
+  ExpectValues(a.tensors(), kSize);
+  EXPECT_EQ(b.tensors().size(), kSize + 1);
+  EXPECT_EQ(b.tensors()[0].scalar<int32>()(), -1);
+}
+
+void BM_CopyAndPushBack(int iters, int size) {
+  TensorList list;
+  for (int i = 0; i < size; ++i) {
+    list.tensors().push_back(Tensor(i));
+  }
+  for (int i = 0; i < iters; ++i) {
+    TensorList copy = list.Copy();
+    copy.tensors().push_back(Tensor(i));
+  }
+}
+BENCHMARK(BM_CopyAndPushBack)->Arg(100)->Arg(10000);
+
+}  // namespace
+}  // namespace tensorflow
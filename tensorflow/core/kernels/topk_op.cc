@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/topk_op.h"
 
 #include <algorithm>
+#include <memory>
 #include <numeric>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -136,18 +137,18 @@ struct TopKFunctor<CPUDevice, T> {
       return Status::OK();
     }
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64 num_col_blocks =
+        NumColumnBlocks(worker_threads.num_threads, k, num_rows, num_cols);
+    if (num_col_blocks > 1) {
+      return ComputeInColumnBlocks(context, sorted, k, input, num_rows,
+                                   num_cols, num_col_blocks, values, indices);
+    }
+
     auto SortIndices = [&](int start_batch, int limit_batch) {
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32 a, const int32 b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
+        const StableGreater stable_comp{input_data};
         const auto comp = [input_data](const int32 a, const int32 b) {
           return input_data[b] < input_data[a];
         };
@@ -180,7 +181,7 @@ struct TopKFunctor<CPUDevice, T> {
           }
         } else {
           // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
+          gtl::TopN<int32, StableGreater> filter(k, stable_comp);
           filter.reserve(num_cols);
           for (int32 c = 0; c < num_cols; ++c) {
             filter.push(c);
@@ -221,12 +222,109 @@ struct TopKFunctor<CPUDevice, T> {
     const int64 final_cost = (total_cost >= static_cast<double>(kint64max))
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return Status::OK();
   }
+
+ private:
+  // Orders column indices by decreasing value, breaking ties by increasing
+  // index.  This is a total order, so the top k of a row does not depend on
+  // the order in which its columns are visited.
+  struct StableGreater {
+    const T* input_data;
+    bool operator()(const int32 a, const int32 b) const {
+      if (input_data[b] < input_data[a]) {
+        return true;
+      } else if (input_data[b] > input_data[a]) {
+        return false;
+      } else {
+        return a < b;
+      }
+    }
+  };
+
+  // Returns the number of blocks to split the columns of every row into.
+  // Rows are already processed in parallel, so the columns are only split
+  // when there are fewer rows than threads, e.g. for a single row holding
+  // the scores of millions of candidates.  Every block keeps many more
+  // columns than the k candidates it contributes to the final selection.
+  static int64 NumColumnBlocks(int num_threads, int k, int64 num_rows,
+                               int64 num_cols) {
+    const int64 kMinColumnsPerBlock = 1 << 14;
+    if (k >= num_cols || num_rows >= num_threads) return 1;
+    const int64 max_blocks =
+        num_cols / std::max<int64>(kMinColumnsPerBlock, 8 * int64{k});
+    return std::max<int64>(1, std::min<int64>(num_threads / num_rows,
+                                              max_blocks));
+  }
+
+  // Selects the top k of each block of columns in parallel, then the top k
+  // of the candidates of every row.  The global top k is always among the
+  // candidates, so the result is the same as that of a single selection.
+  static Status ComputeInColumnBlocks(
+      OpKernelContext* context, bool sorted, int k,
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,
+      const int64 num_cols, const int64 num_col_blocks,
+      typename TTypes<T, 2>::Tensor values,
+      typename TTypes<int, 2>::Tensor indices) {
+    std::vector<int32> candidates(num_rows * num_col_blocks * k);
+    auto SelectInBlocks = [&](int64 start, int64 limit) {
+      for (int64 i = start; i < limit; ++i) {
+        const int64 b = i / num_col_blocks;
+        const int64 block = i % num_col_blocks;
+        const int32 begin = num_cols * block / num_col_blocks;
+        const int32 end = num_cols * (block + 1) / num_col_blocks;
+        gtl::TopN<int32, StableGreater> filter(k, StableGreater{&input(b, 0)});
+        filter.reserve(end - begin);
+        for (int32 c = begin; c < end; ++c) {
+          filter.push(c);
+        }
+        std::copy(filter.unsorted_begin(), filter.unsorted_end(),
+                  candidates.begin() + i * k);
+      }
+    };
+    auto MergeBlocks = [&](int64 start, int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        gtl::TopN<int32, StableGreater> filter(k, StableGreater{&input(b, 0)});
+        filter.reserve(num_col_blocks * k);
+        for (int64 i = b * num_col_blocks * k; i < (b + 1) * num_col_blocks * k;
+             ++i) {
+          filter.push(candidates[i]);
+        }
+        int32 i = 0;
+        if (sorted) {
+          std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
+          for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
+               ++top_k_it, ++i) {
+            indices(b, i) = *top_k_it;
+          }
+        } else {
+          for (auto top_k_it = filter.unsorted_begin();
+               top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
+            indices(b, i) = *top_k_it;
+          }
+        }
+        std::transform(&indices(b, 0), &indices(b, k), &values(b, 0),
+                       [b, &input](const int32 loc) { return input(b, loc); });
+      }
+    };
+
+    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                            Eigen::TensorOpCost::AddCost<T>();
+    const double log_k = Eigen::numext::log2(static_cast<float>(k + 1));
+    const int64 block_cost = static_cast<int64>(
+        4 * cmp_cost * (num_cols / num_col_blocks) * log_k);
+    const int64 merge_cost =
+        static_cast<int64>(4 * cmp_cost * num_col_blocks * k * log_k);
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_col_blocks, block_cost, SelectInBlocks);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          merge_cost, MergeBlocks);
+    return Status::OK();
+  }
 };
 
 }  // namespace functor
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/kernels/dense_update_functor.h"
 #include "tensorflow/core/kernels/variable_ops.h"
@@ -83,11 +84,14 @@ struct VariableInputLockHolder {
   VariableInputLockHolder(VariableInputLockHolder&& other)
       : vars_(std::move(other.vars_)),
         locks_(std::move(other.locks_)),
-        shared_locks_(std::move(other.shared_locks_)) {}
+        shared_locks_(std::move(other.shared_locks_)),
+        row_locks_(std::move(other.row_locks_)) {}
 
   ~VariableInputLockHolder() {
     // Release the locks before unreffing the Vars, because each lock
-    // is potentially borrowed from a Var in vars_.
+    // is potentially borrowed from a Var in vars_. The row stripe locks are
+    // acquired last, so they are released first.
+    row_locks_.reset();
     locks_.reset();
     for (Var* var : vars_) {
       var->Unref();
@@ -100,6 +104,12 @@ struct VariableInputLockHolder {
   // because a `std::vector<mutex_lock>` is not movable on all platforms.
   std::unique_ptr<std::vector<mutex_lock>> locks_;
   std::unique_ptr<std::vector<tf_shared_lock>> shared_locks_;
+  std::unique_ptr<std::vector<mutex_lock>> row_locks_;
+
+  template <typename Device, typename T, typename Tindex>
+  friend VariableInputLockHolder MaybeLockVariableRowsInOrder(
+      OpKernelContext* ctx, bool do_lock, const std::vector<int>& input_ids,
+      const Tensor& indices);
 };
 
 // Returns a borrowed pointer to the mutex for the variable `input` in `ctx`.
@@ -188,6 +198,69 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
                                  std::move(shared_locks));
 }
 
+// Returns true if the TF_SPARSE_APPLY_ROW_LOCKING environment variable is set,
+// to make MaybeLockVariableRowsInOrder lock row stripes.
+bool SparseApplyRowLockingEnabled();
+
+// Acquires the locks for a sparse update of the rows `indices` of the
+// variables `input_ids`, as MaybeLockVariableInputMutexesInOrder does with
+// sparse set to true.
+//
+// If row locking is enabled, do_lock is true and all the variables are
+// resource variables on CPU, locks the variable mutexes in shared mode instead
+// and the stripes of the rows of the first variable that `indices` refer to in
+// exclusive mode. The other variables are assumed to be slots of the first
+// one, updated at the same rows. Sparse updates of disjoint stripes then run
+// concurrently, while each updated row, and the matching rows of its slots,
+// are still modified by one update at a time. Dense accesses still exclude
+// sparse updates, and sparse updates happen in place since the variables are
+// in copy-on-read mode.
+template <typename Device, typename T, typename Tindex>
+VariableInputLockHolder MaybeLockVariableRowsInOrder(
+    OpKernelContext* ctx, bool do_lock, const std::vector<int>& input_ids,
+    const Tensor& indices) {
+  const bool sparse = true;
+  bool lock_rows = do_lock && !input_ids.empty() &&
+                   std::is_same<Device, Eigen::ThreadPoolDevice>::value &&
+                   TensorShapeUtils::IsVector(indices.shape()) &&
+                   SparseApplyRowLockingEnabled();
+  for (int input : input_ids) {
+    lock_rows &= ctx->input_dtype(input) == DT_RESOURCE;
+  }
+  if (!lock_rows) {
+    return MaybeLockVariableInputMutexesInOrder<Device, T>(ctx, do_lock, sparse,
+                                                           input_ids);
+  }
+
+  // Resource variables are locked in shared mode when do_lock is false.
+  VariableInputLockHolder holder =
+      MaybeLockVariableInputMutexesInOrder<Device, T>(
+          ctx, /*do_lock=*/false, sparse, input_ids);
+  core::RefCountPtr<Var> var;
+  if (!LookupResource(ctx, HandleFromInput(ctx, input_ids[0]), &var).ok()) {
+    // GetInputTensorFromVariable reports the error.
+    return holder;
+  }
+  std::vector<bool> touched(Var::kNumRowStripes, false);
+  int num_touched = 0;
+  const auto indices_vec = indices.vec<Tindex>();
+  for (int64 i = 0; i < indices_vec.size(); ++i) {
+    const int stripe = Var::RowStripe(indices_vec(i));
+    if (!touched[stripe]) {
+      touched[stripe] = true;
+      ++num_touched;
+    }
+  }
+  holder.row_locks_ = absl::make_unique<std::vector<mutex_lock>>();
+  holder.row_locks_->reserve(num_touched);
+  for (int stripe = 0; stripe < Var::kNumRowStripes; ++stripe) {
+    if (touched[stripe]) {
+      holder.row_locks_->emplace_back(*var->row_stripe_mu(stripe));
+    }
+  }
+  return holder;
+}
+
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output);
 
@@ -1085,8 +1085,8 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0}, ctx->input(5));
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -1552,8 +1552,8 @@ class SparseApplyAdagradOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1}, ctx->input(4));
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -1715,8 +1715,8 @@ class SparseApplyAdagradV2Op : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1}, ctx->input(5));
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -1886,8 +1886,8 @@ class SparseApplyProximalAdagradOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1}, ctx->input(6));
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -2161,8 +2161,8 @@ class SparseApplyAdagradDAOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1, 2}, ctx->input(4));
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -2573,8 +2573,8 @@ class SparseApplyFtrlOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+    auto locks = MaybeLockVariableRowsInOrder<Device, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1, 2}, ctx->input(4));
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -2993,8 +2993,8 @@ class SparseApplyMomentumOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1}, ctx->input(4));
 
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
@@ -3220,8 +3220,8 @@ class SparseApplyKerasMomentumOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = MaybeLockVariableRowsInOrder<Device, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1}, ctx->input(4));
 
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
@@ -4030,8 +4030,8 @@ class SparseApplyRMSPropOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1, 2}, ctx->input(8));
 
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
@@ -4160,8 +4160,8 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1, 2, 3});
+    auto locks = MaybeLockVariableRowsInOrder<CPUDevice, T, Tindex>(
+        ctx, use_exclusive_lock_, {0, 1, 2, 3}, ctx->input(9));
 
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -370,6 +371,40 @@ TEST(ThreadPool, Parallelism) {
   }
 }
 
+TEST(ThreadPool, Stats) {
+  ThreadPool pool(Env::Default(), "test", 4);
+  EXPECT_EQ("test", pool.name());
+  for (int i = 0; i < 8; ++i) {
+    pool.Schedule([]() { Env::Default()->SleepForMicroseconds(1000); });
+  }
+  // The stats of a closure are updated after it returns.
+  while (pool.GetStats().num_tasks < 8) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  const ThreadPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(8, stats.num_tasks);
+  EXPECT_GE(stats.busy_micros, 8 * 1000);
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(ThreadPool, CPUList) {
+  // The CPU the test runs on is one the process may be pinned to.
+  const int cpu = port::GetCurrentCPU();
+  ASSERT_NE(port::kUnknownCPU, cpu);
+  ThreadOptions thread_options;
+  thread_options.cpu_list = {cpu};
+  ThreadPool pool(Env::Default(), thread_options, "test", 3);
+  absl::BlockingCounter counter(10);
+  for (int i = 0; i < 10; ++i) {
+    pool.Schedule([cpu, &counter]() {
+      EXPECT_EQ(cpu, port::GetCurrentCPU());
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+#endif
+
 static void BM_Sequential(int iters) {
   ThreadPool pool(Env::Default(), "test", kNumThreads);
   // Decrement count sequentially until 0.
@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/crc32c.h"
 
 #include <stdint.h>
+#include <string.h>
+
 #include "tensorflow/core/lib/core/coding.h"
 
 namespace tensorflow {
@@ -26,6 +28,8 @@ namespace crc32c {
 
 extern bool CanAccelerate();
 extern uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size);
+extern uint32_t AcceleratedExtendAndCopy(uint32_t crc, const char *buf,
+                                         size_t size, char *dst);
 
 static const uint32 table0_[256] = {
     0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
@@ -263,6 +267,15 @@ uint32 Extend(uint32 crc, const char *buf, size_t size) {
   return l ^ 0xffffffffu;
 }
 
+uint32 ExtendAndCopy(uint32 crc, const char *buf, size_t size, char *dst) {
+  static bool can_accelerate = CanAccelerate();
+  if (can_accelerate) {
+    return AcceleratedExtendAndCopy(crc, buf, size, dst);
+  }
+  memcpy(dst, buf, size);
+  return Extend(crc, dst, size);
+}
+
 #if defined(PLATFORM_GOOGLE)
 uint32 Extend(uint32 crc, const absl::Cord &cord) {
   for (absl::string_view fragment : cord.Chunks()) {
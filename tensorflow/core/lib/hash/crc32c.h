@@ -35,6 +35,12 @@ extern uint32 Extend(uint32 init_crc, const char* data, size_t n);
 // Return the crc32c of data[0,n-1]
 inline uint32 Value(const char* data, size_t n) { return Extend(0, data, n); }
 
+// Copies data[0,n-1] to dst[0,n-1], which must not overlap it, and returns
+// Extend(init_crc, data, n). With hardware crc32c instructions both are done
+// in a single pass over the data.
+extern uint32 ExtendAndCopy(uint32 init_crc, const char* data, size_t n,
+                            char* dst);
+
 #if defined(PLATFORM_GOOGLE)
 extern uint32 Extend(uint32 init_crc, const absl::Cord& cord);
 inline uint32 Value(const absl::Cord& cord) { return Extend(0, cord); }
@@ -15,21 +15,30 @@ limitations under the License.
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
-// SSE4.2 accelerated CRC32c.
+// Hardware accelerated CRC32c, with the SSE4.2 crc32 instruction on x86-64
+// and the CRC32 extension on AArch64. On x86-64 the instruction is enabled
+// per function and checked for at runtime, so the build does not need
+// -msse4.2.
 
-// See if the SSE4.2 crc32c instruction is available.
+// See if the crc32c instructions are available.
 #undef USE_SSE_CRC32C
-#ifdef __SSE4_2__
-#if defined(__x86_64__) && defined(__GNUC__) && \
-    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
+#undef USE_ARM_CRC32C
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
 #define USE_SSE_CRC32C 1
 #elif defined(__x86_64__) && defined(__clang__)
 #if __has_builtin(__builtin_cpu_supports)
 #define USE_SSE_CRC32C 1
 #endif
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define USE_SSE_CRC32C 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && \
+    defined(__ORDER_LITTLE_ENDIAN__) &&                       \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define USE_ARM_CRC32C 1
 #endif
-#endif /* __SSE4_2__ */
 
 // This version of Apple clang has a bug:
 // https://llvm.org/bugs/show_bug.cgi?id=25510
@@ -39,60 +48,240 @@ limitations under the License.
 
 #ifdef USE_SSE_CRC32C
 #include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32C_TARGET
+#else
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#endif
+
+#ifdef USE_ARM_CRC32C
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#define CRC32C_TARGET
 #endif
 
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   // Should not be called.
   return 0;
 }
+uint32_t AcceleratedExtendAndCopy(uint32_t crc, const char *buf, size_t size,
+                                  char *dst) {
+  // Should not be called.
+  return 0;
+}
 
 #else
 
-// SSE4.2 optimized crc32c computation.
-bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+namespace {
 
-uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
+#ifdef USE_SSE_CRC32C
+CRC32C_TARGET inline uint32_t Crc8(uint32_t crc, uint8_t value) {
+  return _mm_crc32_u8(crc, value);
+}
+CRC32C_TARGET inline uint32_t Crc64(uint32_t crc, uint64_t value) {
+  return static_cast<uint32_t>(_mm_crc32_u64(crc, value));
+}
+#else
+inline uint32_t Crc8(uint32_t crc, uint8_t value) {
+  return __crc32cb(crc, value);
+}
+inline uint32_t Crc64(uint32_t crc, uint64_t value) {
+  return __crc32cd(crc, value);
+}
+#endif
+
+// The crc32c instruction has a latency of several cycles but a throughput of
+// one per cycle, so long buffers are processed as three interleaved streams
+// whose crcs are then combined. The crc of the concatenation of A and B is
+// the crc of A shifted by the length of B, xor the crc of B started from 0;
+// the shift is the multiplication by x^(8 * length(B)) modulo the
+// polynomial, which is linear and so applied with four table lookups.
+constexpr size_t kLongStream = 8192;
+constexpr size_t kShortStream = 256;
+
+// Returns the product of the 32x32 matrix over GF(2) and the vector.
+uint32_t Gf2MatrixTimes(const uint32_t *matrix, uint32_t vector) {
+  uint32_t sum = 0;
+  for (; vector != 0; vector >>= 1, ++matrix) {
+    if (vector & 1) sum ^= *matrix;
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(uint32_t *square, const uint32_t *matrix) {
+  for (int n = 0; n < 32; ++n) {
+    square[n] = Gf2MatrixTimes(matrix, matrix[n]);
+  }
+}
+
+class CrcShift {
+ public:
+  // Builds the tables to shift a crc by `length` zero bytes.
+  explicit CrcShift(size_t length) {
+    uint32_t even[32];  // Operator for an even power of two zero bits.
+    uint32_t odd[32];   // Operator for an odd power of two zero bits.
+    // The operator for one zero bit.
+    odd[0] = 0x82f63b78u;
+    for (int n = 1; n < 32; ++n) odd[n] = 1u << (n - 1);
+    Gf2MatrixSquare(even, odd);  // Two zero bits.
+    Gf2MatrixSquare(odd, even);  // Four zero bits.
+    // Square up to the operator for `length` zero bytes, which must be a
+    // power of two.
+    const uint32_t *op = nullptr;
+    do {
+      Gf2MatrixSquare(even, odd);
+      op = even;
+      length >>= 1;
+      if (length == 0) break;
+      Gf2MatrixSquare(odd, even);
+      op = odd;
+      length >>= 1;
+    } while (length != 0);
+    for (uint32_t n = 0; n < 256; ++n) {
+      table_[0][n] = Gf2MatrixTimes(op, n);
+      table_[1][n] = Gf2MatrixTimes(op, n << 8);
+      table_[2][n] = Gf2MatrixTimes(op, n << 16);
+      table_[3][n] = Gf2MatrixTimes(op, n << 24);
+    }
+  }
+
+  uint32_t Shift(uint32_t crc) const {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+           table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+  }
+
+ private:
+  uint32_t table_[4][256];
+};
+
+const CrcShift &LongShift() {
+  static const CrcShift *shift = new CrcShift(kLongStream);
+  return *shift;
+}
+
+const CrcShift &ShortShift() {
+  static const CrcShift *shift = new CrcShift(kShortStream);
+  return *shift;
+}
+
+inline uint64_t Load64(const uint8_t *p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Extends crc (not inverted) with the data at *p in groups of three streams
+// of stream_size bytes, as long as *size allows, and advances the pointers.
+template <bool kCopy>
+CRC32C_TARGET inline uint32_t ExtendStreams(uint32_t crc, size_t stream_size,
+                                            const CrcShift &shift,
+                                            const uint8_t **p, size_t *size,
+                                            char **dst) {
+  while (*size >= 3 * stream_size) {
+    const uint8_t *p0 = *p;
+    const uint8_t *p1 = p0 + stream_size;
+    const uint8_t *p2 = p1 + stream_size;
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    for (size_t i = 0; i < stream_size; i += 8) {
+      const uint64_t v0 = Load64(p0 + i);
+      const uint64_t v1 = Load64(p1 + i);
+      const uint64_t v2 = Load64(p2 + i);
+      if (kCopy) {
+        memcpy(*dst + i, &v0, 8);
+        memcpy(*dst + stream_size + i, &v1, 8);
+        memcpy(*dst + 2 * stream_size + i, &v2, 8);
+      }
+      crc = Crc64(crc, v0);
+      crc1 = Crc64(crc1, v1);
+      crc2 = Crc64(crc2, v2);
+    }
+    crc = shift.Shift(crc) ^ crc1;
+    crc = shift.Shift(crc) ^ crc2;
+    *p += 3 * stream_size;
+    *size -= 3 * stream_size;
+    if (kCopy) *dst += 3 * stream_size;
+  }
+  return crc;
+}
+
+template <bool kCopy>
+CRC32C_TARGET uint32_t ExtendImpl(uint32_t crc, const char *buf, size_t size,
+                                  char *dst) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
-  const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
 
-  // Advance p until aligned to 8-bytes..
-  // Point x at first 7-byte aligned byte in string.  This might be
-  // just past the end of the string.
-  const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
-  const uint8_t *x = reinterpret_cast<const uint8_t *>(((pval + 7) >> 3) << 3);
-  if (x <= e) {
-    // Process bytes until finished or p is 8-byte aligned
-    while (p != x) {
-      l = _mm_crc32_u8(l, *p);
-      p++;
-    }
+  // Process bytes until finished or p is 8-byte aligned.
+  while (size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    if (kCopy) *dst++ = static_cast<char>(*p);
+    l = Crc8(l, *p++);
+    --size;
   }
 
-  // Process bytes 16 at a time
-  uint64_t l64 = l;
-  while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
-    p += 16;
+  l = ExtendStreams<kCopy>(l, kLongStream, LongShift(), &p, &size, &dst);
+  l = ExtendStreams<kCopy>(l, kShortStream, ShortShift(), &p, &size, &dst);
+
+  // Process bytes 8 at a time.
+  while (size >= 8) {
+    const uint64_t v = Load64(p);
+    if (kCopy) {
+      memcpy(dst, &v, 8);
+      dst += 8;
+    }
+    l = Crc64(l, v);
+    p += 8;
+    size -= 8;
   }
 
   // Process remaining bytes one at a time.
-  l = l64;
-  while (p < e) {
-    l = _mm_crc32_u8(l, *p);
-    p++;
+  while (size > 0) {
+    if (kCopy) *dst++ = static_cast<char>(*p);
+    l = Crc8(l, *p++);
+    --size;
   }
 
   return l ^ 0xffffffffu;
 }
 
+}  // namespace
+
+bool CanAccelerate() {
+#if defined(USE_ARM_CRC32C)
+#if defined(__linux__)
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+  // The build targets CPUs with the CRC32 extension.
+  return true;
+#endif
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 20)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
+  return ExtendImpl<false>(crc, buf, size, nullptr);
+}
+
+uint32_t AcceleratedExtendAndCopy(uint32_t crc, const char *buf, size_t size,
+                                  char *dst) {
+  return ExtendImpl<true>(crc, buf, size, dst);
+}
+
 #endif
 
 }  // namespace crc32c
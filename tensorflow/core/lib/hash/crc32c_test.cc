@@ -62,6 +62,42 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+// Bit at a time reference implementation.
+uint32 ReferenceExtend(uint32 crc, const char* data, size_t n) {
+  crc = ~crc;
+  for (size_t i = 0; i < n; ++i) {
+    crc ^= static_cast<uint8>(data[i]);
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+TEST(CRC, LongInputs) {
+  // Covers the interleaved streams of the accelerated code.
+  std::string input(100000, 0);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = i * 7 + (i >> 9);
+  for (size_t n : {255, 768, 769, 24575, 24576, 24577, 99990}) {
+    for (size_t offset : {0, 1, 7}) {
+      EXPECT_EQ(ReferenceExtend(123, input.data() + offset, n),
+                Extend(123, input.data() + offset, n))
+          << n << " " << offset;
+    }
+  }
+}
+
+TEST(CRC, ExtendAndCopy) {
+  std::string input(30000, 0);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = i * 13;
+  for (size_t n : {0, 5, 1000, 29990}) {
+    std::string output(n + 3, 0);
+    EXPECT_EQ(Extend(7, input.data() + 1, n),
+              ExtendAndCopy(7, input.data() + 1, n, &output[3]));
+    EXPECT_EQ(input.substr(1, n), output.substr(3));
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
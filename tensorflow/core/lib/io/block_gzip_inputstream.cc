@@ -0,0 +1,234 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_gzip_inputstream.h"
+
+#include <zlib.h>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/block_gzip_outputbuffer.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+constexpr size_t kHeaderSize = BlockGzipOutputBuffer::kHeaderSize;
+constexpr size_t kTrailerSize = BlockGzipOutputBuffer::kTrailerSize;
+
+// Checks the gzip header written by `BlockGzipOutputBuffer`, and returns the
+// size of the whole block in `block_size`.
+Status ParseHeader(StringPiece header, uint32* block_size) {
+  if (header.size() < kHeaderSize || header[0] != '\x1f' ||
+      header[1] != '\x8b' || header[2] != 8 || header[3] != 4 ||
+      header[10] != 8 || header[11] != 0 || header[12] != 'T' ||
+      header[13] != 'F' || header[14] != 4 || header[15] != 0) {
+    return errors::DataLoss("Not a block of a block gzip file.");
+  }
+  *block_size = core::DecodeFixed32(header.data() + 16);
+  if (*block_size < kHeaderSize + kTrailerSize) {
+    return errors::DataLoss("Invalid block size ", *block_size,
+                            " in block gzip file.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+BlockGzipInputStream::BlockGzipInputStream(
+    InputStreamInterface* input_stream,
+    const ZlibCompressionOptions& zlib_options, bool owns_input_stream)
+    : owns_input_stream_(owns_input_stream),
+      input_stream_(input_stream),
+      max_blocks_in_flight_(2 * std::max(zlib_options.num_threads, 1)),
+      thread_pool_(absl::make_unique<thread::ThreadPool>(
+          Env::Default(), "block_gzip_decompression",
+          std::max(zlib_options.num_threads, 1))) {}
+
+BlockGzipInputStream::~BlockGzipInputStream() {
+  // Waits for the blocks being decompressed.
+  thread_pool_.reset();
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+/* static */ bool BlockGzipInputStream::IsBlockGzipFile(
+    RandomAccessFile* file) {
+  char scratch[kHeaderSize];
+  StringPiece header;
+  Status s = file->Read(0, kHeaderSize, &header, scratch);
+  uint32 block_size;
+  return (s.ok() || errors::IsOutOfRange(s)) &&
+         ParseHeader(header, &block_size).ok();
+}
+
+/* static */ Status BlockGzipInputStream::DecompressBlock(
+    StringPiece block, std::string* output) {
+  uint32 block_size;
+  TF_RETURN_IF_ERROR(ParseHeader(block, &block_size));
+  if (block_size != block.size()) {
+    return errors::DataLoss("Block gzip block has ", block.size(),
+                            " bytes, expected ", block_size, ".");
+  }
+  const char* trailer = block.data() + block.size() - kTrailerSize;
+  const uint32 expected_crc = core::DecodeFixed32(trailer);
+  const uint32 size = core::DecodeFixed32(trailer + 4);
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  int status = inflateInit2(&stream, -MAX_WBITS);
+  if (status != Z_OK) {
+    return errors::Internal("inflateInit2 failed with status ", status);
+  }
+  output->resize(size);
+  stream.next_in = reinterpret_cast<Bytef*>(
+      const_cast<char*>(block.data() + kHeaderSize));
+  stream.avail_in = block.size() - kHeaderSize - kTrailerSize;
+  // One spare byte of output detects data longer than the trailer says.
+  std::string spare(1, '\0');
+  stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  stream.avail_out = size;
+  status = inflate(&stream, Z_FINISH);
+  if (status == Z_BUF_ERROR && stream.avail_out == 0) {
+    stream.next_out = reinterpret_cast<Bytef*>(&spare[0]);
+    stream.avail_out = spare.size();
+    status = inflate(&stream, Z_FINISH);
+  }
+  const uLong total_out = stream.total_out;
+  inflateEnd(&stream);
+  if (status != Z_STREAM_END || total_out != size) {
+    return errors::DataLoss("Failed to decompress block gzip block: inflate ",
+                            "returned ", status, " after ", total_out,
+                            " of ", size, " bytes.");
+  }
+  const uint32 crc =
+      crc32(crc32(0L, Z_NULL, 0),
+            reinterpret_cast<const Bytef*>(output->data()), output->size());
+  if (crc != expected_crc) {
+    return errors::DataLoss("Checksum mismatch in block gzip block.");
+  }
+  return Status::OK();
+}
+
+Status BlockGzipInputStream::StartBlocks() {
+  while (!end_of_input_) {
+    {
+      mutex_lock l(mu_);
+      if (blocks_.size() >= max_blocks_in_flight_) {
+        return Status::OK();
+      }
+    }
+    tstring header;
+    Status s = input_stream_->ReadNBytes(kHeaderSize, &header);
+    if (errors::IsOutOfRange(s)) {
+      end_of_input_ = true;
+      if (header.empty()) {
+        return Status::OK();
+      }
+      return errors::DataLoss("Truncated block gzip file.");
+    }
+    TF_RETURN_IF_ERROR(s);
+    uint32 block_size;
+    TF_RETURN_IF_ERROR(ParseHeader(header, &block_size));
+    tstring rest;
+    s = input_stream_->ReadNBytes(block_size - kHeaderSize, &rest);
+    if (errors::IsOutOfRange(s)) {
+      end_of_input_ = true;
+      return errors::DataLoss("Truncated block gzip file.");
+    }
+    TF_RETURN_IF_ERROR(s);
+
+    auto block = std::make_shared<Block>();
+    block->compressed.reserve(block_size);
+    block->compressed.append(header.data(), header.size());
+    block->compressed.append(rest.data(), rest.size());
+    {
+      mutex_lock l(mu_);
+      blocks_.push_back(block);
+    }
+    // The destructor joins the pool first, so the closure may refer to `this`.
+    thread_pool_->Schedule([this, block]() {
+      std::string data;
+      Status s = DecompressBlock(block->compressed, &data);
+      mutex_lock l(mu_);
+      block->data.swap(data);
+      block->status = s;
+      block->done = true;
+      block->compressed.clear();
+      cv_.notify_all();
+    });
+  }
+  return Status::OK();
+}
+
+Status BlockGzipInputStream::NextBlock() {
+  TF_RETURN_IF_ERROR(StartBlocks());
+  std::shared_ptr<Block> block;
+  {
+    mutex_lock l(mu_);
+    if (blocks_.empty()) {
+      return errors::OutOfRange("EOF reached");
+    }
+    while (!blocks_.front()->done) {
+      cv_.wait(l);
+    }
+    block = blocks_.front();
+    blocks_.pop_front();
+  }
+  TF_RETURN_IF_ERROR(block->status);
+  current_block_.swap(block->data);
+  current_block_pos_ = 0;
+  // Keeps the pool busy while the caller reads this block.
+  return StartBlocks();
+}
+
+Status BlockGzipInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  result->clear();
+  while (bytes_to_read > 0) {
+    if (current_block_pos_ == current_block_.size()) {
+      TF_RETURN_IF_ERROR(NextBlock());
+      continue;
+    }
+    const size_t num_bytes = std::min<size_t>(
+        bytes_to_read, current_block_.size() - current_block_pos_);
+    result->append(current_block_.data() + current_block_pos_, num_bytes);
+    current_block_pos_ += num_bytes;
+    bytes_read_ += num_bytes;
+    bytes_to_read -= num_bytes;
+  }
+  return Status::OK();
+}
+
+int64 BlockGzipInputStream::Tell() const { return bytes_read_; }
+
+Status BlockGzipInputStream::Reset() {
+  {
+    mutex_lock l(mu_);
+    // Blocks still being decompressed only hold on to their own state.
+    blocks_.clear();
+  }
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+  current_block_.clear();
+  current_block_pos_ = 0;
+  end_of_input_ = false;
+  bytes_read_ = 0;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
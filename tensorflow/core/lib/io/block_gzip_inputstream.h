@@ -0,0 +1,115 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a gzip file written by `BlockGzipOutputBuffer`, decompressing up to
+// `zlib_options.num_threads` blocks in parallel. Other gzip files must be
+// read with `ZlibInputStream`; see `IsBlockGzipFile`.
+//
+// A given instance of a BlockGzipInputStream is NOT safe for concurrent use
+// by multiple threads.
+class BlockGzipInputStream : public InputStreamInterface {
+ public:
+  // Creates a BlockGzipInputStream for `input_stream`, which must be
+  // positioned at the start of a block.
+  //
+  // Takes ownership of `input_stream` iff `owns_input_stream` is true.
+  BlockGzipInputStream(InputStreamInterface* input_stream,
+                       const ZlibCompressionOptions& zlib_options,
+                       bool owns_input_stream);
+
+  ~BlockGzipInputStream() override;
+
+  // Reads bytes_to_read bytes into *result, overwriting *result.
+  //
+  // Return Status codes:
+  // OK:           If successful.
+  // OUT_OF_RANGE: If there are not enough bytes to read before
+  //               the end of the stream.
+  // DATA_LOSS:    If a block is not in the format of `BlockGzipOutputBuffer`,
+  //               or fails to decompress.
+  // others:       If reading from stream failed.
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+  // Returns true if `file` starts with a block written by
+  // `BlockGzipOutputBuffer`.
+  static bool IsBlockGzipFile(RandomAccessFile* file);
+
+  // Decompresses one gzip member `block` written by `BlockGzipOutputBuffer`,
+  // and checks its size and checksum.
+  static Status DecompressBlock(StringPiece block, std::string* output);
+
+ private:
+  struct Block {
+    std::string compressed;
+    std::string data;
+    Status status;
+    bool done = false;
+  };
+
+  // Reads blocks from `input_stream_` and starts decompressing them, until
+  // `max_blocks_in_flight_` blocks are in flight or the stream ends.
+  Status StartBlocks();
+
+  // Waits for the front block of `blocks_`, and makes it the current block.
+  Status NextBlock();
+
+  const bool owns_input_stream_;
+  InputStreamInterface* input_stream_;
+  const size_t max_blocks_in_flight_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  // The decompressed data of the current block, and the position of the next
+  // byte to return from it.
+  std::string current_block_;
+  size_t current_block_pos_ = 0;
+  // True once the end of `input_stream_` was reached.
+  bool end_of_input_ = false;
+  int64 bytes_read_ = 0;
+
+  mutex mu_;
+  condition_variable cv_;
+  // The blocks being decompressed or waiting to be read, in file order.
+  std::deque<std::shared_ptr<Block>> blocks_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockGzipInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_INPUTSTREAM_H_
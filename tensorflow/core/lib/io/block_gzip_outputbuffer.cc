@@ -0,0 +1,201 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_gzip_outputbuffer.h"
+
+#include <zlib.h>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+
+/* static */ constexpr size_t BlockGzipOutputBuffer::kHeaderSize;
+/* static */ constexpr size_t BlockGzipOutputBuffer::kTrailerSize;
+
+BlockGzipOutputBuffer::BlockGzipOutputBuffer(
+    WritableFile* file, const ZlibCompressionOptions& zlib_options)
+    : file_(file),
+      zlib_options_(zlib_options),
+      max_blocks_in_flight_(2 * std::max(zlib_options.num_threads, 1)),
+      thread_pool_(absl::make_unique<thread::ThreadPool>(
+          Env::Default(), "block_gzip_compression",
+          std::max(zlib_options.num_threads, 1))) {}
+
+BlockGzipOutputBuffer::~BlockGzipOutputBuffer() {
+  if (!closed_) {
+    LOG(WARNING)
+        << "BlockGzipOutputBuffer::Close() not called. Possible data loss";
+  }
+  // Waits for the blocks being compressed.
+  thread_pool_.reset();
+}
+
+/* static */ bool BlockGzipOutputBuffer::UseBlockGzip(
+    const ZlibCompressionOptions& zlib_options) {
+  return zlib_options.num_threads > 1 && zlib_options.window_bits > MAX_WBITS;
+}
+
+Status BlockGzipOutputBuffer::CompressBlock(
+    StringPiece data, const ZlibCompressionOptions& zlib_options,
+    std::string* output) {
+  if (data.size() > kuint32max) {
+    return errors::InvalidArgument("Block of ", data.size(),
+                                   " bytes does not fit in a gzip member.");
+  }
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Raw deflate, since the gzip header and trailer are written here.
+  int status =
+      deflateInit2(&stream, zlib_options.compression_level, Z_DEFLATED,
+                   -MAX_WBITS, zlib_options.mem_level,
+                   zlib_options.compression_strategy);
+  if (status != Z_OK) {
+    return errors::Internal("deflateInit2 failed with status ", status);
+  }
+  const uLong bound = deflateBound(&stream, data.size());
+  output->resize(kHeaderSize + bound + kTrailerSize);
+  char* header = &(*output)[0];
+  // ID1, ID2, CM = deflate, FLG = FEXTRA.
+  header[0] = '\x1f';
+  header[1] = '\x8b';
+  header[2] = 8;
+  header[3] = 4;
+  // MTIME = 0, XFL = 0, OS = unknown.
+  memset(header + 4, 0, 5);
+  header[9] = '\xff';
+  // XLEN, then the subfield "TF" with 4 bytes of data.
+  header[10] = 8;
+  header[11] = 0;
+  header[12] = 'T';
+  header[13] = 'F';
+  header[14] = 4;
+  header[15] = 0;
+
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(header + kHeaderSize);
+  stream.avail_out = bound;
+  status = deflate(&stream, Z_FINISH);
+  const size_t compressed_size = stream.total_out;
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    return errors::Internal("deflate failed with status ", status);
+  }
+
+  const size_t member_size = kHeaderSize + compressed_size + kTrailerSize;
+  if (member_size > kuint32max) {
+    return errors::InvalidArgument("Compressed block of ", member_size,
+                                   " bytes does not fit in a gzip member.");
+  }
+  core::EncodeFixed32(header + 16, member_size);
+  char* trailer = header + kHeaderSize + compressed_size;
+  core::EncodeFixed32(
+      trailer, crc32(crc32(0L, Z_NULL, 0),
+                     reinterpret_cast<const Bytef*>(data.data()), data.size()));
+  core::EncodeFixed32(trailer + 4, static_cast<uint32>(data.size()));
+  output->resize(member_size);
+  return Status::OK();
+}
+
+Status BlockGzipOutputBuffer::Append(StringPiece data) {
+  while (!data.empty()) {
+    const size_t num_bytes = std::min<size_t>(
+        data.size(), zlib_options_.block_size - current_block_.size());
+    current_block_.append(data.data(), num_bytes);
+    data.remove_prefix(num_bytes);
+    if (current_block_.size() >= zlib_options_.block_size) {
+      StartBlock();
+      TF_RETURN_IF_ERROR(WriteCompressedBlocks(/*wait=*/false));
+    }
+  }
+  return Status::OK();
+}
+
+void BlockGzipOutputBuffer::StartBlock() {
+  if (current_block_.empty()) {
+    return;
+  }
+  auto block = std::make_shared<Block>();
+  block->data.swap(current_block_);
+  {
+    mutex_lock l(mu_);
+    blocks_.push_back(block);
+  }
+  // The destructor joins the pool first, so the closure may refer to `this`.
+  thread_pool_->Schedule([this, block, options = zlib_options_]() {
+    Status s = CompressBlock(block->data, options, &block->compressed);
+    mutex_lock l(mu_);
+    block->status = s;
+    block->done = true;
+    block->data.clear();
+    cv_.notify_all();
+  });
+}
+
+Status BlockGzipOutputBuffer::WriteCompressedBlocks(bool wait) {
+  while (true) {
+    std::shared_ptr<Block> block;
+    {
+      mutex_lock l(mu_);
+      if (blocks_.empty()) {
+        return Status::OK();
+      }
+      // Bound the memory used by blocks waiting to be written.
+      while (!blocks_.front()->done &&
+             (wait || blocks_.size() > max_blocks_in_flight_)) {
+        cv_.wait(l);
+      }
+      if (!blocks_.front()->done) {
+        return Status::OK();
+      }
+      block = blocks_.front();
+      blocks_.pop_front();
+    }
+    TF_RETURN_IF_ERROR(block->status);
+    TF_RETURN_IF_ERROR(file_->Append(block->compressed));
+  }
+}
+
+Status BlockGzipOutputBuffer::Flush() {
+  StartBlock();
+  TF_RETURN_IF_ERROR(WriteCompressedBlocks(/*wait=*/true));
+  return file_->Flush();
+}
+
+Status BlockGzipOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status BlockGzipOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status BlockGzipOutputBuffer::Close() {
+  if (closed_) {
+    return Status::OK();
+  }
+  StartBlock();
+  TF_RETURN_IF_ERROR(WriteCompressedBlocks(/*wait=*/true));
+  closed_ = true;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
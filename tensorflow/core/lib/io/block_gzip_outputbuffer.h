@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_OUTPUTBUFFER_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Writes a gzip file as a series of independently compressed gzip members
+// ("blocks"), so that the blocks can be compressed in parallel, and read back
+// in parallel by `BlockGzipInputStream`.
+//
+// Every member has a gzip extra field with the subfield "TF", whose 4 bytes
+// hold the size of the whole member in the file, little endian. Readers can
+// thus find the members without decompressing them, e.g. to split a file.
+// Gzip readers which support files of several members, such as
+// `ZlibInputStream` and the gzip tools, read the output as one stream.
+//
+// A BlockGzipOutputBuffer is NOT safe for concurrent use by multiple threads.
+class BlockGzipOutputBuffer : public WritableFile {
+ public:
+  // The size of the gzip header of a block, including the extra field.
+  static constexpr size_t kHeaderSize = 20;
+  // The size of the gzip trailer of a block.
+  static constexpr size_t kTrailerSize = 8;
+
+  // Creates a BlockGzipOutputBuffer which buffers `zlib_options.block_size`
+  // bytes per block, and compresses up to `zlib_options.num_threads` blocks at
+  // the same time. Only the compression level, memory level and strategy of
+  // `zlib_options` affect compression. Does not take ownership of `file`.
+  BlockGzipOutputBuffer(WritableFile* file,
+                        const ZlibCompressionOptions& zlib_options);
+
+  ~BlockGzipOutputBuffer() override;
+
+  // Adds `data` to the current block, and starts compressing the block once
+  // it is full.
+  Status Append(StringPiece data) override;
+
+  // Compresses the current block and writes all blocks to file. Ends the
+  // current block even if it isn't full.
+  Status Flush() override;
+
+  Status Name(StringPiece* result) const override;
+
+  Status Sync() override;
+
+  // Writes all blocks to the file. This must be called before the destructor
+  // to avoid any data loss. Does not close the underlying file.
+  Status Close() override;
+
+  // Returns true if `zlib_options` ask for gzip encoding with more than one
+  // thread, i.e. if files should be written with a BlockGzipOutputBuffer.
+  static bool UseBlockGzip(const ZlibCompressionOptions& zlib_options);
+
+  // Compresses `data` into one gzip member in the format described above.
+  static Status CompressBlock(StringPiece data,
+                              const ZlibCompressionOptions& zlib_options,
+                              std::string* output);
+
+ private:
+  struct Block {
+    std::string data;
+    std::string compressed;
+    Status status;
+    bool done = false;
+  };
+
+  // Starts compressing the current block.
+  void StartBlock();
+
+  // Writes out the compressed blocks at the front of `blocks_`. If `wait` is
+  // set, waits for all blocks to be compressed.
+  Status WriteCompressedBlocks(bool wait);
+
+  WritableFile* const file_;  // Not owned
+  const ZlibCompressionOptions zlib_options_;
+  const size_t max_blocks_in_flight_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  std::string current_block_;
+  bool closed_ = false;
+
+  mutex mu_;
+  condition_variable cv_;
+  // The blocks being compressed or waiting to be written, in file order.
+  std::deque<std::shared_ptr<Block>> blocks_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockGzipOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_BLOCK_GZIP_OUTPUTBUFFER_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 
 namespace tensorflow {
@@ -87,6 +88,17 @@ Status BufferedInputStream::ReadLineHelper(StringType* result,
 }
 
 Status BufferedInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  return ReadNBytesHelper(bytes_to_read, result, nullptr);
+}
+
+Status BufferedInputStream::ReadNBytesWithCrc32c(int64 bytes_to_read,
+                                                 tstring* result,
+                                                 uint32* crc) {
+  return ReadNBytesHelper(bytes_to_read, result, crc);
+}
+
+Status BufferedInputStream::ReadNBytesHelper(int64 bytes_to_read,
+                                             tstring* result, uint32* crc) {
   if (bytes_to_read < 0) {
     return errors::InvalidArgument("Can't read a negative number of bytes: ",
                                    bytes_to_read);
@@ -111,7 +123,14 @@ Status BufferedInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
     }
     const int64 bytes_to_copy =
         std::min<int64>(limit_ - pos_, bytes_to_read - result->size());
-    result->insert(result->size(), buf_, pos_, bytes_to_copy);
+    if (crc != nullptr) {
+      const size_t size = result->size();
+      result->resize_uninitialized(size + bytes_to_copy);
+      *crc = crc32c::ExtendAndCopy(*crc, buf_.data() + pos_, bytes_to_copy,
+                                   result->mdata() + size);
+    } else {
+      result->insert(result->size(), buf_, pos_, bytes_to_copy);
+    }
     pos_ += bytes_to_copy;
   }
   // Filling the buffer might lead to a situation when we go past the end of
@@ -43,6 +43,9 @@ class BufferedInputStream : public InputStreamInterface {
 
   tensorflow::Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
 
+  tensorflow::Status ReadNBytesWithCrc32c(int64 bytes_to_read, tstring* result,
+                                          uint32* crc) override;
+
   tensorflow::Status SkipNBytes(int64 bytes_to_skip) override;
 
   int64 Tell() const override;
@@ -89,6 +92,9 @@ class BufferedInputStream : public InputStreamInterface {
   tensorflow::Status FillBuffer();
   template <typename StringType>
   tensorflow::Status ReadLineHelper(StringType* result, bool include_eol);
+  // Implements ReadNBytes, and ReadNBytesWithCrc32c if crc is not null.
+  tensorflow::Status ReadNBytesHelper(int64 bytes_to_read, tstring* result,
+                                      uint32* crc);
 
   InputStreamInterface* input_stream_;  // not owned.
   size_t size_;                         // buffer size.
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
@@ -227,6 +228,33 @@ TEST(BufferedInputStream, ReadNBytes) {
   }
 }
 
+TEST(BufferedInputStream, ReadNBytesWithCrc32c) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    std::unique_ptr<RandomAccessInputStream> input_stream(
+        new RandomAccessInputStream(file.get()));
+    tstring read;
+    uint32 crc = 0;
+    BufferedInputStream in(input_stream.get(), buf_size);
+    TF_ASSERT_OK(in.ReadNBytesWithCrc32c(3, &read, &crc));
+    EXPECT_EQ(read, "012");
+    EXPECT_EQ(crc32c::Value("012", 3), crc);
+    TF_ASSERT_OK(in.ReadNBytesWithCrc32c(4, &read, &crc));
+    EXPECT_EQ(read, "3456");
+    EXPECT_EQ(crc32c::Value("0123456", 7), crc);
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytesWithCrc32c(5, &read, &crc)));
+    EXPECT_EQ(read, "789");
+    EXPECT_EQ(crc32c::Value("0123456789", 10), crc);
+    EXPECT_EQ(10, in.Tell());
+  }
+}
+
 TEST(BufferedInputStream, OutOfRangeCache) {
   for (auto buf_size : BufferSizes()) {
     if (buf_size < 11) {
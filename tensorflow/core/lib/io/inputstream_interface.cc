@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 
 namespace tensorflow {
 namespace io {
@@ -38,5 +39,13 @@ Status InputStreamInterface::SkipNBytes(int64 bytes_to_skip) {
   return Status::OK();
 }
 
+Status InputStreamInterface::ReadNBytesWithCrc32c(int64 bytes_to_read,
+                                                  tstring* result,
+                                                  uint32* crc) {
+  Status s = ReadNBytes(bytes_to_read, result);
+  *crc = crc32c::Extend(*crc, result->data(), result->size());
+  return s;
+}
+
 }  // namespace io
 }  // namespace tensorflow
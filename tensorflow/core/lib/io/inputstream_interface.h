@@ -37,6 +37,13 @@ class InputStreamInterface {
   //  * OUT_OF_RANGE - not enough bytes remaining before end of file.
   virtual Status ReadNBytes(int64 bytes_to_read, tstring* result) = 0;
 
+  // Reads the next bytes_to_read from the file like ReadNBytes, and extends
+  // *crc with the crc32c of the bytes stored in *result. Streams that copy
+  // from a buffer compute the crc while copying, rather than in a second pass
+  // over the data.
+  virtual Status ReadNBytesWithCrc32c(int64 bytes_to_read, tstring* result,
+                                      uint32* crc);
+
 #if defined(PLATFORM_GOOGLE)
   // Reads the next bytes_to_read from the file. Typical return codes:
   //  * OK - in case of success.
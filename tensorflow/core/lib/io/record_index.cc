@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// "TFRIDX01" in little-endian order.
+constexpr uint64 kMagic = 0x3130584449524654ULL;
+constexpr size_t kHeaderSize = 2 * sizeof(uint64);
+constexpr size_t kFooterSize = sizeof(uint32);
+
+}  // namespace
+
+string RecordIndexFilename(StringPiece filename) {
+  return strings::StrCat(filename, kRecordIndexSuffix);
+}
+
+Status WriteRecordIndex(Env* env, const string& index_filename,
+                        const std::vector<uint64>& offsets) {
+  if (offsets.empty()) {
+    return errors::InvalidArgument(
+        "A record index needs the offset of the end of the records.");
+  }
+  string contents;
+  contents.reserve(kHeaderSize + offsets.size() * sizeof(uint64) +
+                   kFooterSize);
+  core::PutFixed64(&contents, kMagic);
+  core::PutFixed64(&contents, offsets.size() - 1);
+  for (uint64 offset : offsets) {
+    core::PutFixed64(&contents, offset);
+  }
+  const uint32 crc = crc32c::Value(contents.data(), contents.size());
+  core::PutFixed32(&contents, crc32c::Mask(crc));
+  return WriteStringToFile(env, index_filename, contents);
+}
+
+Status ReadRecordIndex(Env* env, const string& index_filename,
+                       std::vector<uint64>* offsets) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, index_filename, &contents));
+  if (contents.size() < kHeaderSize + sizeof(uint64) + kFooterSize ||
+      core::DecodeFixed64(contents.data()) != kMagic) {
+    return errors::DataLoss(index_filename, " is not a record index.");
+  }
+  const uint64 num_records = core::DecodeFixed64(contents.data() + 8);
+  const size_t num_offsets =
+      (contents.size() - kHeaderSize - kFooterSize) / sizeof(uint64);
+  if (num_offsets != num_records + 1 ||
+      kHeaderSize + num_offsets * sizeof(uint64) + kFooterSize !=
+          contents.size()) {
+    return errors::DataLoss("The record index ", index_filename,
+                            " is truncated.");
+  }
+  const size_t crc_offset = contents.size() - kFooterSize;
+  if (crc32c::Unmask(core::DecodeFixed32(contents.data() + crc_offset)) !=
+      crc32c::Value(contents.data(), crc_offset)) {
+    return errors::DataLoss("The record index ", index_filename,
+                            " is corrupted.");
+  }
+  offsets->clear();
+  offsets->reserve(num_offsets);
+  for (size_t pos = kHeaderSize; pos < crc_offset; pos += sizeof(uint64)) {
+    const uint64 offset = core::DecodeFixed64(contents.data() + pos);
+    if (!offsets->empty() && offset < offsets->back()) {
+      return errors::DataLoss("The offsets of the record index ",
+                              index_filename, " are not sorted.");
+    }
+    offsets->push_back(offset);
+  }
+  return Status::OK();
+}
+
+Status BuildRecordIndex(RandomAccessFile* file,
+                        const RecordReaderOptions& options,
+                        std::vector<uint64>* offsets) {
+  RecordReader reader(file, options);
+  offsets->clear();
+  uint64 offset = 0;
+  while (true) {
+    offsets->push_back(offset);
+    int num_skipped;
+    Status s = reader.SkipRecords(&offset, 1, &num_skipped);
+    if (errors::IsOutOfRange(s) && num_skipped == 0) {
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(s);
+  }
+}
+
+}  // namespace io
+}  // namespace tensorflow
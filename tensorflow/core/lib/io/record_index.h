@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Env;
+class RandomAccessFile;
+
+namespace io {
+
+// A record index lists the offsets of the records of a TFRecord file, so that
+// readers can seek to any record without reading the records before it.
+//
+// The index of a file with N records is a vector of N + 1 offsets: the
+// offset of each record, as accepted by `RecordReader::ReadRecord()`,
+// followed by the offset of the end of the last record. For compressed files,
+// the offsets are in the uncompressed stream of records.
+//
+// An index is stored next to its TFRecord file, in a file with the
+// `kRecordIndexSuffix` suffix, in the following format:
+//  uint64    magic number
+//  uint64    N
+//  uint64    offsets[N + 1]
+//  uint32    masked crc of all of the above
+constexpr char kRecordIndexSuffix[] = ".tfrecord_index";
+
+// Returns the name of the index file of the TFRecord file `filename`.
+string RecordIndexFilename(StringPiece filename);
+
+// Writes `offsets` to the index file `index_filename`.
+Status WriteRecordIndex(Env* env, const string& index_filename,
+                        const std::vector<uint64>& offsets);
+
+// Reads the index file `index_filename` into `*offsets`. Returns a
+// `DataLoss` error if the file is not a valid index.
+Status ReadRecordIndex(Env* env, const string& index_filename,
+                       std::vector<uint64>* offsets);
+
+// Builds the index of the records of `file` by reading their headers.
+Status BuildRecordIndex(RandomAccessFile* file,
+                        const RecordReaderOptions& options,
+                        std::vector<uint64>* offsets);
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
@@ -0,0 +1,164 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// Writes `num_records` records of different sizes to `fname`, and returns
+// their offsets as reported by the writer.
+std::vector<uint64> WriteRecords(const string& fname, int num_records,
+                                 const RecordWriterOptions& options) {
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  RecordWriter writer(file.get(), options);
+  std::vector<uint64> offsets;
+  for (int i = 0; i < num_records; ++i) {
+    offsets.push_back(writer.TellOffset());
+    TF_CHECK_OK(writer.WriteRecord(strings::StrCat(string(i * 7, 'x'), i)));
+  }
+  offsets.push_back(writer.TellOffset());
+  TF_CHECK_OK(writer.Close());
+  TF_CHECK_OK(file->Close());
+  return offsets;
+}
+
+TEST(RecordIndexTest, RecordIndexFilename) {
+  EXPECT_EQ("/a/b.tfrecord.tfrecord_index",
+            RecordIndexFilename("/a/b.tfrecord"));
+}
+
+TEST(RecordIndexTest, WriterOffsetsLocateRecords) {
+  const string fname = testing::TmpDir() + "/record_index_writer_offsets";
+  const std::vector<uint64> offsets =
+      WriteRecords(fname, 10, RecordWriterOptions());
+  ASSERT_EQ(11, offsets.size());
+  uint64 file_size;
+  TF_ASSERT_OK(Env::Default()->GetFileSize(fname, &file_size));
+  EXPECT_EQ(file_size, offsets.back());
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  RecordReader reader(file.get());
+  // Read the records backwards, seeking to each one.
+  for (int i = 9; i >= 0; --i) {
+    uint64 offset = offsets[i];
+    tstring record;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(strings::StrCat(string(i * 7, 'x'), i), record);
+    EXPECT_EQ(offsets[i + 1], offset);
+  }
+}
+
+TEST(RecordIndexTest, BuildMatchesWriterOffsets) {
+  for (const string compression_type : {"", "ZLIB", "GZIP"}) {
+    const string fname = strings::StrCat(
+        testing::TmpDir(), "/record_index_build_", compression_type);
+    const std::vector<uint64> offsets = WriteRecords(
+        fname, 100,
+        RecordWriterOptions::CreateRecordWriterOptions(compression_type));
+
+    std::unique_ptr<RandomAccessFile> file;
+    TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+    std::vector<uint64> built;
+    TF_ASSERT_OK(BuildRecordIndex(
+        file.get(),
+        RecordReaderOptions::CreateRecordReaderOptions(compression_type),
+        &built));
+    EXPECT_EQ(offsets, built) << compression_type;
+  }
+}
+
+TEST(RecordIndexTest, BuildEmptyFile) {
+  const string fname = testing::TmpDir() + "/record_index_empty";
+  EXPECT_EQ(std::vector<uint64>({0}),
+            WriteRecords(fname, 0, RecordWriterOptions()));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  std::vector<uint64> built;
+  TF_ASSERT_OK(BuildRecordIndex(file.get(), RecordReaderOptions(), &built));
+  EXPECT_EQ(std::vector<uint64>({0}), built);
+}
+
+TEST(RecordIndexTest, BuildTruncatedFile) {
+  const string fname = testing::TmpDir() + "/record_index_truncated";
+  const std::vector<uint64> offsets =
+      WriteRecords(fname, 3, RecordWriterOptions());
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), fname, &contents));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname,
+                                 contents.substr(0, offsets[2] + 20)));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  std::vector<uint64> built;
+  EXPECT_EQ(error::DATA_LOSS,
+            BuildRecordIndex(file.get(), RecordReaderOptions(), &built).code());
+}
+
+TEST(RecordIndexTest, WriteAndRead) {
+  const string fname = testing::TmpDir() + "/record_index_roundtrip";
+  const std::vector<uint64> offsets = {0, 17, 40, 40, 1ULL << 40};
+  TF_ASSERT_OK(WriteRecordIndex(Env::Default(), fname, offsets));
+  std::vector<uint64> read;
+  TF_ASSERT_OK(ReadRecordIndex(Env::Default(), fname, &read));
+  EXPECT_EQ(offsets, read);
+
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            WriteRecordIndex(Env::Default(), fname, {}).code());
+}
+
+TEST(RecordIndexTest, ReadInvalidIndex) {
+  Env* env = Env::Default();
+  const string fname = testing::TmpDir() + "/record_index_invalid";
+  std::vector<uint64> offsets;
+  TF_ASSERT_OK(WriteRecordIndex(env, fname, {0, 10, 20}));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, fname, &contents));
+
+  // Not an index.
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "not an index at all"));
+  EXPECT_EQ(error::DATA_LOSS, ReadRecordIndex(env, fname, &offsets).code());
+
+  // Truncated.
+  TF_ASSERT_OK(
+      WriteStringToFile(env, fname, contents.substr(0, contents.size() - 8)));
+  EXPECT_EQ(error::DATA_LOSS, ReadRecordIndex(env, fname, &offsets).code());
+
+  // Corrupted.
+  string corrupted = contents;
+  corrupted[20] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(env, fname, corrupted));
+  EXPECT_EQ(error::DATA_LOSS, ReadRecordIndex(env, fname, &offsets).code());
+
+  // Missing.
+  EXPECT_EQ(error::NOT_FOUND,
+            ReadRecordIndex(env, fname + ".missing", &offsets).code());
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
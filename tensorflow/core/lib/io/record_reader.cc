@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/block_gzip_inputstream.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
@@ -68,7 +69,13 @@ RecordReader::RecordReader(RandomAccessFile* file,
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (options.compression_type == RecordReaderOptions::ZLIB_COMPRESSION) {
+  if (options.compression_type == RecordReaderOptions::ZLIB_COMPRESSION &&
+      options.zlib_options.num_threads > 1 &&
+      BlockGzipInputStream::IsBlockGzipFile(file)) {
+    input_stream_.reset(new BlockGzipInputStream(
+        input_stream_.release(), options.zlib_options, true));
+  } else if (options.compression_type ==
+             RecordReaderOptions::ZLIB_COMPRESSION) {
     input_stream_.reset(new ZlibInputStream(
         input_stream_.release(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options, true));
@@ -95,10 +102,15 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n, tstring* result) {
     return errors::DataLoss("record size too large");
   }
 
-  const size_t expected = n + sizeof(uint32);
-  TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(expected, result));
+  // The crc is computed while the data is copied out of the input buffer.
+  uint32 crc = 0;
+  TF_RETURN_IF_ERROR(input_stream_->ReadNBytesWithCrc32c(n, result, &crc));
+  tstring footer;
+  if (result->size() == n) {
+    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(sizeof(uint32), &footer));
+  }
 
-  if (result->size() != expected) {
+  if (result->size() != n || footer.size() != sizeof(uint32)) {
     if (result->empty()) {
       return errors::OutOfRange("eof");
     } else {
@@ -106,11 +118,10 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n, tstring* result) {
     }
   }
 
-  const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
-  if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
+  const uint32 masked_crc = core::DecodeFixed32(footer.data());
+  if (crc32c::Unmask(masked_crc) != crc) {
     return errors::DataLoss("corrupted record at ", offset);
   }
-  result->resize(n);
   return Status::OK();
 }
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/block_gzip_outputbuffer.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
 
@@ -65,7 +66,10 @@ RecordWriter::RecordWriter(WritableFile* dest,
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (IsZlibCompressed(options)) {
+  if (IsZlibCompressed(options) &&
+      BlockGzipOutputBuffer::UseBlockGzip(options.zlib_options)) {
+    dest_ = new BlockGzipOutputBuffer(dest, options.zlib_options);
+  } else if (IsZlibCompressed(options)) {
     ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
         dest, options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options);
@@ -112,7 +116,9 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   PopulateFooter(footer, data.data(), data.size());
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  offset_ += kHeaderSize + data.size() + kFooterSize;
+  return Status::OK();
 }
 
 #if defined(PLATFORM_GOOGLE)
@@ -132,7 +138,9 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
   PopulateFooter(footer, data);
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  offset_ += kHeaderSize + data.size() + kFooterSize;
+  return Status::OK();
 }
 #endif
 
@@ -94,6 +94,11 @@ class RecordWriter {
   // are invalid.
   Status Close();
 
+  // Returns the offset at which the next record will be written, which is
+  // where `RecordReader::ReadRecord()` will read it from. For compressed
+  // files, this is an offset in the uncompressed stream of records.
+  uint64 TellOffset() const { return offset_; }
+
   // Utility method to populate TFRecord headers.  Populates record-header in
   // "header[0,kHeaderSize-1]".  The record-header is based on data[0, n-1].
   inline static void PopulateHeader(char* header, const char* data, size_t n);
@@ -110,6 +115,7 @@ class RecordWriter {
  private:
   WritableFile* dest_;
   RecordWriterOptions options_;
+  uint64 offset_ = 0;
 
   inline static uint32 MaskedCrc(const char* data, size_t n) {
     return crc32c::Mask(crc32c::Value(data, n));
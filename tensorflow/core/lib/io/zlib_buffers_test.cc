@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/block_gzip_inputstream.h"
+#include "tensorflow/core/lib/io/block_gzip_outputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -372,5 +374,80 @@ TEST(ZlibInputStream, TestSoftErrorOnDecompressGzip) {
   TestSoftErrorOnDecompress(CompressionOptions::GZIP());
 }
 
+TEST(BlockGzip, RoundTrip) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  CompressionOptions options = CompressionOptions::GZIP();
+  options.num_threads = 4;
+  options.block_size = 1000;
+  ASSERT_TRUE(BlockGzipOutputBuffer::UseBlockGzip(options));
+  string data = GenTestString(500);
+
+  std::unique_ptr<WritableFile> file_writer;
+  TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+  BlockGzipOutputBuffer out(file_writer.get(), options);
+  // Appends in pieces which don't line up with the blocks.
+  for (size_t pos = 0; pos < data.size(); pos += 777) {
+    TF_ASSERT_OK(out.Append(StringPiece(data).substr(pos, 777)));
+  }
+  TF_ASSERT_OK(out.Close());
+  TF_ASSERT_OK(file_writer->Close());
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+  EXPECT_TRUE(BlockGzipInputStream::IsBlockGzipFile(file_reader.get()));
+
+  // Reads in parallel.
+  RandomAccessInputStream block_input(file_reader.get());
+  BlockGzipInputStream block_in(&block_input, options, false);
+  tstring result;
+  TF_ASSERT_OK(block_in.ReadNBytes(1234, &result));
+  EXPECT_EQ(result, data.substr(0, 1234));
+  EXPECT_EQ(1234, block_in.Tell());
+  tstring rest;
+  EXPECT_TRUE(errors::IsOutOfRange(block_in.ReadNBytes(data.size(), &rest)));
+  EXPECT_EQ(result + rest, data);
+
+  TF_ASSERT_OK(block_in.Reset());
+  TF_ASSERT_OK(block_in.ReadNBytes(data.size(), &result));
+  EXPECT_EQ(result, data);
+
+  // The blocks are members of one gzip file to other readers.
+  RandomAccessInputStream zlib_input(file_reader.get());
+  ZlibInputStream zlib_in(&zlib_input, 1000, 1000, CompressionOptions::GZIP());
+  TF_ASSERT_OK(zlib_in.ReadNBytes(data.size(), &result));
+  EXPECT_EQ(result, data);
+  EXPECT_TRUE(errors::IsOutOfRange(zlib_in.ReadNBytes(1, &result)));
+}
+
+TEST(BlockGzip, DetectsOtherFiles) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  WriteCompressedFile(env, fname, 100, 100, CompressionOptions::GZIP(),
+                      GenTestString(10));
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+  EXPECT_FALSE(BlockGzipInputStream::IsBlockGzipFile(file_reader.get()));
+}
+
+TEST(BlockGzip, DetectsCorruption) {
+  CompressionOptions options = CompressionOptions::GZIP();
+  string data = GenTestString(10);
+  std::string block;
+  TF_ASSERT_OK(BlockGzipOutputBuffer::CompressBlock(data, options, &block));
+  std::string output;
+  TF_ASSERT_OK(BlockGzipInputStream::DecompressBlock(block, &output));
+  EXPECT_EQ(output, data);
+
+  // Flips a bit of the checksum.
+  block[block.size() - BlockGzipOutputBuffer::kTrailerSize] ^= 1;
+  EXPECT_TRUE(errors::IsDataLoss(
+      BlockGzipInputStream::DecompressBlock(block, &output)));
+  EXPECT_TRUE(errors::IsDataLoss(BlockGzipInputStream::DecompressBlock(
+      StringPiece(block).substr(0, block.size() - 1), &output)));
+}
+
 }  // namespace io
 }  // namespace tensorflow
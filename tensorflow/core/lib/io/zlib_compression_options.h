@@ -117,6 +117,18 @@ class ZlibCompressionOptions {
   //
   // This option is ignored for `ZlibOutputBuffer`.
   bool soft_fail_on_error = false;  // NOLINT
+
+  // The number of threads which compress or decompress blocks of a gzip file
+  // in parallel. If greater than 1, and `window_bits` selects gzip encoding,
+  // `RecordWriter` writes the file as a series of independent gzip members
+  // (see `BlockGzipOutputBuffer`), and `RecordReader` decompresses such files
+  // in parallel. Other gzip readers read these files as they read any gzip
+  // file. Defaults to 1, i.e. serial compression.
+  int num_threads = 1;
+
+  // The number of uncompressed bytes in each block compressed in parallel.
+  // Ignored unless `num_threads` is greater than 1.
+  int64 block_size = 1 << 20;
 };
 
 inline ZlibCompressionOptions ZlibCompressionOptions::DEFAULT() {
@@ -244,6 +244,15 @@ Status ZlibInputStream::Inflate() {
     }
     return errors::DataLoss(error_string);
   }
+  // A gzip file may hold several members, e.g. the blocks written by
+  // `BlockGzipOutputBuffer`, which decompress to the concatenation of their
+  // data. Starts the next member at the end of each one.
+  if (error == Z_STREAM_END && zlib_options_.window_bits > MAX_WBITS) {
+    error = inflateReset(z_stream_def_->stream.get());
+    if (error != Z_OK) {
+      return errors::DataLoss("inflateReset() failed with error ", error);
+    }
+  }
   return Status::OK();
 }
 
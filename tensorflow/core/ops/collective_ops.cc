@@ -32,6 +32,7 @@ REGISTER_OP("CollectiveReduce")
     .Attr("wait_for: list(int) = []")
     .Attr("communication_hint: string = 'auto'")
     .Attr("timeout_seconds: float = 0")
+    .Attr("compression: {'none', 'float16', 'bfloat16'} = 'none'")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
@@ -114,7 +115,35 @@ REGISTER_OP("CollectiveReduceV2")
     .Attr("merge_op: {'Min', 'Max', 'Mul', 'Add'}")
     .Attr("final_op: {'Id', 'Div'}")
     .Attr("communication_hint: string = 'auto'")
+    .Attr("compression: {'none', 'float16', 'bfloat16'} = 'none'")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
+// Used by ring reductions with compression to convert a chunk into its wire
+// format, and back into the accumulator.  The result is written in place of
+// the first input.
+REGISTER_OP("_CollectiveEncode")
+    .Input("wire: Twire")
+    .Input("value: T")
+    .Output("encoded: Twire")
+    .Attr("T: {float}")
+    .Attr("Twire: {half, bfloat16}")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Converts `value` to `Twire`, writing the result into `wire`.
+)doc");
+
+REGISTER_OP("_CollectiveDecode")
+    .Input("value: T")
+    .Input("wire: Twire")
+    .Output("decoded: T")
+    .Attr("T: {float}")
+    .Attr("Twire: {half, bfloat16}")
+    .Attr("accumulate: bool = false")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Converts `wire` back to `T`, adding it to `value` if `accumulate` is set and
+replacing `value` otherwise.  The result is written into `value`.
+)doc");
+
 }  // namespace tensorflow
@@ -466,6 +466,7 @@ REGISTER_OP("DecodeJpeg")
     .Attr("try_recover_truncated: bool = false")
     .Attr("acceptable_fraction: float = 1.0")
     .Attr("dct_method: string = ''")
+    .Attr("target_size: int = 0")
     .Output("image: uint8")
     .SetShapeFn(DecodeImageShapeFn);
 
@@ -479,6 +480,7 @@ REGISTER_OP("DecodeAndCropJpeg")
     .Attr("try_recover_truncated: bool = false")
     .Attr("acceptable_fraction: float = 1.0")
     .Attr("dct_method: string = ''")
+    .Attr("target_size: int = 0")
     .Output("image: uint8")
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle unused;
@@ -501,8 +503,11 @@ REGISTER_OP("DecodeAndCropJpeg")
       TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
       TF_RETURN_IF_ERROR(c->WithValue(c->Dim(unused, 0), 4, &unused_dim));
 
+      // With a target size, the crop window is scaled along with the image.
+      int32 target_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("target_size", &target_size));
       const Tensor* crop_window = c->input_tensor(1);
-      if (crop_window != nullptr) {
+      if (crop_window != nullptr && target_size <= 0) {
         auto crop_window_vec = crop_window->vec<int32>();
         h = c->MakeDim(crop_window_vec(2));
         w = c->MakeDim(crop_window_vec(3));
@@ -313,6 +313,52 @@ REGISTER_OP("LookupTableImportV2")
       return Status::OK();
     });
 
+REGISTER_OP("LookupTableExportDelta")
+    .Input("table_handle: resource")
+    .Output("keys: Tkeys")
+    .Output("values: Tvalues")
+    .Output("removed_keys: Tkeys")
+    .Attr("Tkeys: type")
+    .Attr("Tvalues: type")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+      ShapeHandle keys = c->UnknownShapeOfRank(1);
+      ShapeAndType value_shape_and_type;
+      TF_RETURN_IF_ERROR(ValidateTableResourceHandle(
+          c,
+          /*keys=*/keys,
+          /*key_dtype_attr=*/"Tkeys",
+          /*value_dtype_attr=*/"Tvalues",
+          /*is_lookup=*/false, &value_shape_and_type));
+      c->set_output(0, keys);
+      c->set_output(1, value_shape_and_type.shape);
+      c->set_output(2, c->UnknownShapeOfRank(1));
+      return Status::OK();
+    });
+
+REGISTER_OP("LookupTableImportDelta")
+    .Input("table_handle: resource")
+    .Input("keys: Tin")
+    .Input("values: Tout")
+    .Input("removed_keys: Tin")
+    .Attr("Tin: type")
+    .Attr("Tout: type")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+
+      ShapeHandle keys;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &keys));
+      ShapeHandle values;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(2), 1, &values));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(keys, 0), c->Dim(values, 0), &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &handle));
+      return Status::OK();
+    });
+
 Status MutableHashTableShape(InferenceContext* c, const ShapeHandle& key,
                              const ShapeHandle& value) {
   c->set_output(0, c->Scalar());
@@ -404,6 +450,26 @@ REGISTER_OP("MutableHashTableOfTensorsV2")
       return MutableHashTableShape(c, /*key=*/c->Scalar(), /*value=*/value_s);
     });
 
+REGISTER_OP("MutableBoundedHashTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .Attr("value_shape: shape = {}")
+    .Attr("capacity: int >= 1")
+    .Attr("min_frequency: int >= 1 = 1")
+    .Attr("eviction_policy: {'lru', 'lfu', 'timestamp'} = 'lru'")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      PartialTensorShape value_p;
+      TF_RETURN_IF_ERROR(c->GetAttr("value_shape", &value_p));
+      ShapeHandle value_s;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromPartialTensorShape(value_p, &value_s));
+      return MutableHashTableShape(c, /*key=*/c->Scalar(), /*value=*/value_s);
+    });
+
 REGISTER_OP("MutableDenseHashTable")
     .Input("empty_key: key_dtype")
     .Output("table_handle: Ref(string)")
@@ -981,6 +981,68 @@ _FusedConv2D output.
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_DynamicQuantizedMatMul")
+    .Input("a: float")
+    .Input("b: qint8")
+    .Input("b_scales: float")
+    .Output("product: float")
+    .Attr("transpose_a: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      ShapeHandle b_scales;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &b_scales));
+
+      bool transpose_a;
+      TF_RETURN_IF_ERROR(c->GetAttr("transpose_a", &transpose_a));
+      DimensionHandle output_rows = c->Dim(a, transpose_a ? 1 : 0);
+      DimensionHandle output_cols;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(b, 0), c->Dim(b_scales, 0), &output_cols));
+      DimensionHandle inner;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(a, transpose_a ? 0 : 1), c->Dim(b, 1), &inner));
+
+      c->set_output(0, c->Matrix(output_rows, output_cols));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Multiplies `a` by int8 weights, quantizing `a` on the fly.
+
+Computes `a * transpose(dequantize(b))`, where row `j` of the weights `b` is
+the int8 quantization of output channel `j` with scale `b_scales[j]`. Each row
+of `a` is quantized symmetrically to int8 with its own scale before an int8
+GEMM with int32 accumulation; the result is rescaled to float.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedElementwise")
+    .Input("x: T")
+    .Input("args: num_args * T")
+    .Output("y: T")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string) >= 1")
+    .Attr("arg_is_lhs: list(bool) = []")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Performs a chain of elementwise operations in a single pass over `x`.
+
+The chain is specified by `fused_ops`, a list of TF op names (e.g. "Mul",
+"Relu"). They are performed in order, where the input to each unary op, and
+one of the inputs to each binary op, is the output of the preceding op; the
+first op is applied to `x`. The other input of the i-th binary op is `args[i]`,
+which must be a scalar or have the shape of `x`. It is the left-hand side of
+the op if `arg_is_lhs[i]` is true, and the right-hand side otherwise.
+
+*NOTE*: Do not invoke this operator directly in Python. The elementwise fusion
+pass is expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
@@ -1316,6 +1378,31 @@ REGISTER_OP("UnsortedSegmentProd")
     .Attr("Tnumsegments: {int32,int64} = DT_INT32")
     .SetShapeFn(shape_inference::UnsortedSegmentReductionShapeFn);
 
+REGISTER_OP("UniqueSegmentSum")
+    .Input("data: T")
+    .Input("indices: Tindices")
+    .Output("output: T")
+    .Output("unique_indices: Tindices")
+    .Attr("T: numbertype")
+    .Attr("Tindices: {int32,int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle data;
+      ShapeHandle indices;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &indices));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(data, 0), c->Dim(indices, 0), &unused));
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(data, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(
+          c->Concatenate(c->Vector(InferenceContext::kUnknownDim), subshape,
+                         &out));
+      c->set_output(0, out);
+      c->set_output(1, c->Vector(InferenceContext::kUnknownDim));
+      return Status::OK();
+    });
+
 REGISTER_OP("SparseSegmentSum")
     .Input("data: T")
     .Input("indices: Tidx")
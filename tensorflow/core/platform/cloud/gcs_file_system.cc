@@ -779,12 +779,18 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  read_ahead_blocks_ = kDefaultReadAheadBlocks;
+  if (GetEnvVar(kReadAheadBlocks, strings::safe_strtou64, &value)) {
+    read_ahead_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "read-ahead blocks = " << read_ahead_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -934,6 +940,13 @@ GcsFileSystem::GcsFileSystem(
       compose_append_(compose_append),
       additional_header_(additional_header) {}
 
+GcsFileSystem::~GcsFileSystem() {
+  // The file block cache may still be reading blocks ahead with the other
+  // members, so destroy it first.
+  mutex_lock l(block_cache_lock_);
+  file_block_cache_.reset();
+}
+
 Status GcsFileSystem::NewRandomAccessFile(
     const string& fname, TransactionToken* token,
     std::unique_ptr<RandomAccessFile>* result) {
@@ -1017,7 +1030,8 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      Env::Default(), read_ahead_blocks_));
   return file_block_cache;
 }
 
@@ -1895,9 +1909,28 @@ Status GcsFileSystem::RenameFile(const string& src, const string& target,
   return Status::OK();
 }
 
+Status GcsFileSystem::CopyFile(const string& src, const string& target,
+                               TransactionToken* token) {
+  // When `target` points to a directory, copy into a file within it.
+  if (IsDirectory(target, token).ok()) {
+    return RewriteObject(src, JoinGcsPath(target, io::Basename(src)));
+  }
+  return RewriteObject(src, target);
+}
+
 // Uses a GCS API command to copy the object and then deletes the old one.
 Status GcsFileSystem::RenameObject(const string& src, const string& target) {
   VLOG(3) << "RenameObject: started gs://" << src << " to " << target;
+  TF_RETURN_IF_ERROR(RewriteObject(src, target));
+  VLOG(3) << "RenameObject: finished from: gs://" << src << " to " << target;
+  // In case the delete API call failed, but the deletion actually happened
+  // on the server side, we can't just retry the whole RenameFile operation
+  // because the source object is already gone.
+  return RetryingUtils::DeleteWithRetries(
+      [this, &src]() { return DeleteFile(src, nullptr); }, retry_config_);
+}
+
+Status GcsFileSystem::RewriteObject(const string& src, const string& target) {
   string src_bucket, src_object, target_bucket, target_object;
   TF_RETURN_IF_ERROR(ParseGcsPath(src, false, &src_bucket, &src_object));
   TF_RETURN_IF_ERROR(
@@ -1913,10 +1946,9 @@ Status GcsFileSystem::RenameObject(const string& src, const string& target) {
   request->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.metadata);
   std::vector<char> output_buffer;
   request->SetResultBuffer(&output_buffer);
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when renaming ", src,
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when copying ", src,
                                   " to ", target);
-  // Flush the target from the caches.  The source will be flushed in the
-  // DeleteFile call below.
+  // Flush the target from the caches.
   ClearFileCaches(target);
   Json::Value root;
   TF_RETURN_IF_ERROR(ParseJson(output_buffer, &root));
@@ -1928,17 +1960,11 @@ Status GcsFileSystem::RenameObject(const string& src, const string& target) {
     // which requires multiple rewrite calls.
     // TODO(surkov): implement multi-step rewrites.
     return errors::Unimplemented(
-        "Couldn't rename ", src, " to ", target,
+        "Couldn't copy ", src, " to ", target,
         ": moving large files between buckets with different "
         "locations or storage classes is not supported.");
   }
-
-  VLOG(3) << "RenameObject: finished from: gs://" << src << " to " << target;
-  // In case the delete API call failed, but the deletion actually happened
-  // on the server side, we can't just retry the whole RenameFile operation
-  // because the source object is already gone.
-  return RetryingUtils::DeleteWithRetries(
-      [this, &src]() { return DeleteFile(src, nullptr); }, retry_config_);
+  return Status::OK();
 }
 
 Status GcsFileSystem::IsDirectory(const string& fname,
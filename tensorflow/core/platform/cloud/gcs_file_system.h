@@ -50,6 +50,10 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that overrides the maximum number of blocks fetched
+// in parallel ahead of a sequential reader. A value of 0 disables read-ahead.
+constexpr char kReadAheadBlocks[] = "GCS_READ_CACHE_READ_AHEAD_BLOCKS";
+constexpr size_t kDefaultReadAheadBlocks = 4;
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -130,6 +134,8 @@ class GcsFileSystem : public FileSystem {
                 std::pair<const string, const string>* additional_header,
                 bool compose_append);
 
+  ~GcsFileSystem() override;
+
   TF_USE_FILESYSTEM_METHODS_WITH_NO_TRANSACTION_SUPPORT;
 
   Status NewRandomAccessFile(
@@ -169,6 +175,10 @@ class GcsFileSystem : public FileSystem {
   Status RenameFile(const string& src, const string& target,
                     TransactionToken* token) override;
 
+  /// Copies the object with a GCS rewrite, without transferring its data.
+  Status CopyFile(const string& src, const string& target,
+                  TransactionToken* token) override;
+
   Status IsDirectory(const string& fname, TransactionToken* token) override;
 
   Status DeleteRecursively(const string& dirname, TransactionToken* token,
@@ -392,6 +402,9 @@ class GcsFileSystem : public FileSystem {
 
   Status RenameObject(const string& src, const string& target);
 
+  // Copies the object src to target on the server.
+  Status RewriteObject(const string& src, const string& target);
+
   // Clear all the caches related to the file with name `filename`.
   void ClearFileCaches(const string& fname);
 
@@ -403,6 +416,10 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The maximum number of blocks the file block cache reads ahead of a
+  // sequential reader.
+  size_t read_ahead_blocks_ = 0;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -21,6 +22,14 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The maximum number of files whose access patterns are tracked for
+// read-ahead. The patterns are forgotten once more files are read.
+constexpr size_t kMaxReadAheadFiles = 1024;
+
+}  // namespace
+
 bool RamFileBlockCache::BlockNotStale(const std::shared_ptr<Block>& block) {
   mutex_lock l(block->mu);
   if (block->state != FetchState::FINISHED) {
@@ -46,6 +55,11 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
     }
   }
 
+  return Insert(key);
+}
+
+std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Insert(
+    const Key& key) {
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
@@ -79,15 +93,19 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
     block->lru_iterator = lru_list_.begin();
   }
 
-  // Check for inconsistent state. If there is a block later in the same file
-  // in the cache, and our current block is not block size, this likely means
-  // we have inconsistent state within the cache. Note: it's possible some
-  // incomplete reads may still go undetected.
+  // Check for inconsistent state. If there is a block with data later in the
+  // same file in the cache, and our current block is not block size, this
+  // likely means we have inconsistent state within the cache. Blocks read
+  // ahead past the end of the file are empty or still being fetched. Note:
+  // it's possible some incomplete reads may still go undetected.
   if (block->data.size() < block_size_) {
-    Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
-    auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    for (auto it = block_map_.upper_bound(key);
+         it != block_map_.end() && it->first.first == key.first; ++it) {
+      mutex_lock l(it->second->mu);
+      if (it->second->state == FetchState::FINISHED &&
+          !it->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -165,6 +183,70 @@ Status RamFileBlockCache::MaybeFetch(const Key& key,
       "Control flow should never reach the end of RamFileBlockCache::Fetch.");
 }
 
+void RamFileBlockCache::MaybeReadAhead(const string& filename, size_t offset,
+                                       size_t n, size_t finish) {
+  if (read_ahead_pool_ == nullptr) {
+    return;
+  }
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> read_ahead_blocks;
+  {
+    mutex_lock lock(mu_);
+    if (read_ahead_states_.size() >= kMaxReadAheadFiles &&
+        read_ahead_states_.find(filename) == read_ahead_states_.end()) {
+      read_ahead_states_.clear();
+    }
+    ReadAheadState& state = read_ahead_states_[filename];
+    if (offset == state.next_offset) {
+      state.window = std::min(std::max<size_t>(1, 2 * state.window),
+                              max_read_ahead_blocks_);
+    } else {
+      state = ReadAheadState();
+    }
+    state.next_offset = offset + n;
+    if (state.eof) {
+      return;
+    }
+    const size_t end = finish + state.window * block_size_;
+    for (size_t pos = std::max(finish, state.read_ahead_end); pos < end;
+         pos += block_size_) {
+      if (read_ahead_bytes_ + block_size_ > max_bytes_ / 2) {
+        break;
+      }
+      state.read_ahead_end = pos + block_size_;
+      Key key = std::make_pair(filename, pos);
+      if (block_map_.find(key) != block_map_.end()) {
+        continue;
+      }
+      read_ahead_bytes_ += block_size_;
+      read_ahead_blocks.emplace_back(key, Insert(key));
+    }
+  }
+  for (const auto& key_block : read_ahead_blocks) {
+    read_ahead_pool_->Schedule(
+        [this, key_block] { ReadAhead(key_block.first, key_block.second); });
+  }
+}
+
+void RamFileBlockCache::ReadAhead(const Key& key,
+                                  const std::shared_ptr<Block>& block) {
+  // On errors the block is fetched again by the reader that requests it.
+  Status status = MaybeFetch(key, block);
+  mutex_lock lock(mu_);
+  read_ahead_bytes_ -= block_size_;
+  if (!status.ok()) {
+    VLOG(1) << "Failed to read ahead " << key.first << "@" << key.second
+            << ": " << status;
+    return;
+  }
+  if (block->data.size() < block_size_) {
+    auto it = read_ahead_states_.find(key.first);
+    if (it != read_ahead_states_.end()) {
+      it->second.eof = true;
+    }
+  }
+  Trim();
+}
+
 Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
                                char* buffer, size_t* bytes_transferred) {
   *bytes_transferred = 0;
@@ -182,6 +264,7 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  MaybeReadAhead(filename, offset, n, finish);
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -268,10 +351,16 @@ void RamFileBlockCache::Prune() {
 
 void RamFileBlockCache::Flush() {
   mutex_lock lock(mu_);
+  // Signal blocks that are still being fetched, e.g. read ahead, that they
+  // were removed.
+  for (auto& entry : block_map_) {
+    entry.second->timestamp = 0;
+  }
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
   cache_size_ = 0;
+  read_ahead_states_.clear();
 }
 
 void RamFileBlockCache::RemoveFile(const string& filename) {
@@ -280,6 +369,7 @@ void RamFileBlockCache::RemoveFile(const string& filename) {
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+  read_ahead_states_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
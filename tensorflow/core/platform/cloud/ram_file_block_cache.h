@@ -21,6 +21,7 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -38,6 +40,13 @@ namespace tensorflow {
 ///
 /// This class should be shared by read-only random access files on a remote
 /// filesystem (e.g. GCS).
+///
+/// If `max_read_ahead_blocks` is positive, the cache detects files that are
+/// read sequentially and fetches the blocks after the read in parallel before
+/// they are requested. The read-ahead window of a file doubles with every
+/// sequential read up to `max_read_ahead_blocks`, and is reset by a read at
+/// any other offset. The blocks being read ahead across all files are limited
+/// to half of `max_bytes`.
 class RamFileBlockCache : public FileBlockCache {
  public:
   /// The callback executed when a block is not found in the cache, and needs to
@@ -51,21 +60,30 @@ class RamFileBlockCache : public FileBlockCache {
       BlockFetcher;
 
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t max_read_ahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        max_read_ahead_blocks_(max_read_ahead_blocks) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (IsCacheEnabled() && max_read_ahead_blocks_ > 0) {
+      read_ahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_read_ahead_FBC", static_cast<int>(max_read_ahead_blocks_)));
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying read_ahead_pool_ will block until the pending read-aheads
+    // return.
+    read_ahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -131,6 +149,8 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The maximum number of blocks read ahead of a sequential reader.
+  const size_t max_read_ahead_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -188,6 +208,19 @@ class RamFileBlockCache : public FileBlockCache {
   /// The block map is an ordered map from Key to Block.
   typedef std::map<Key, std::shared_ptr<Block>> BlockMap;
 
+  /// \brief The access pattern of a file, used to decide how far to read
+  /// ahead.
+  struct ReadAheadState {
+    /// The offset a sequential read would start at.
+    size_t next_offset = 0;
+    /// The number of blocks to read ahead of the current read.
+    size_t window = 0;
+    /// The end of the blocks that have already been read ahead.
+    size_t read_ahead_end = 0;
+    /// Set once a block read ahead reached the end of the file.
+    bool eof = false;
+  };
+
   /// Prune the cache by removing files with expired blocks.
   void Prune() TF_LOCKS_EXCLUDED(mu_);
 
@@ -197,9 +230,23 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) TF_LOCKS_EXCLUDED(mu_);
 
+  /// Insert a new empty block for `key` in the block cache.
+  std::shared_ptr<Block> Insert(const Key& key)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       TF_LOCKS_EXCLUDED(mu_);
 
+  /// Update the access pattern of `filename` with a read of [offset, offset +
+  /// n) whose blocks end at `finish`, and start fetching the blocks to read
+  /// ahead of it.
+  void MaybeReadAhead(const string& filename, size_t offset, size_t n,
+                      size_t finish) TF_LOCKS_EXCLUDED(mu_);
+
+  /// Fetch a block that was inserted by MaybeReadAhead.
+  void ReadAhead(const Key& key, const std::shared_ptr<Block>& block)
+      TF_LOCKS_EXCLUDED(mu_);
+
   /// Trim the block cache to make room for another entry.
   void Trim() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -243,6 +290,17 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ TF_GUARDED_BY(mu_);
+
+  /// The access patterns of the files being read.
+  std::unordered_map<string, ReadAheadState> read_ahead_states_
+      TF_GUARDED_BY(mu_);
+
+  /// The combined size of the blocks being read ahead.
+  size_t read_ahead_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  /// The threads fetching the blocks read ahead, or null if read-ahead is
+  /// disabled.
+  std::unique_ptr<thread::ThreadPool> read_ahead_pool_;
 };
 
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 
 #include <cstring>
+#include <set>
 
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
@@ -566,5 +567,71 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+TEST(RamFileBlockCacheTest, ReadAhead) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::set<size_t> fetched;
+  auto fetcher = [&mu, &fetched](const string& filename, size_t offset,
+                                 size_t n, char* buffer,
+                                 size_t* bytes_transferred) {
+    mutex_lock l(mu);
+    fetched.insert(offset);
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  std::vector<char> out;
+  {
+    RamFileBlockCache cache(block_size, 64 * block_size, 0, fetcher,
+                            Env::Default(), /*max_read_ahead_blocks=*/4);
+    // Sequential reads of the first three blocks read ahead 1, then 2, then 4
+    // blocks.
+    for (size_t offset = 0; offset < 3 * block_size; offset += block_size) {
+      TF_EXPECT_OK(ReadCache(&cache, "", offset, block_size, &out));
+    }
+    // Destroying the cache waits for the pending read-aheads.
+  }
+  std::set<size_t> want;
+  for (size_t offset = 0; offset < 7 * block_size; offset += block_size) {
+    want.insert(offset);
+  }
+  EXPECT_EQ(fetched, want);
+
+  fetched.clear();
+  {
+    RamFileBlockCache cache(block_size, 64 * block_size, 0, fetcher,
+                            Env::Default(), /*max_read_ahead_blocks=*/4);
+    // Random reads do not read ahead.
+    TF_EXPECT_OK(ReadCache(&cache, "", 8 * block_size, block_size, &out));
+    TF_EXPECT_OK(ReadCache(&cache, "", 2 * block_size, block_size, &out));
+  }
+  EXPECT_EQ(fetched, std::set<size_t>({2 * block_size, 8 * block_size}));
+}
+
+TEST(RamFileBlockCacheTest, ReadAheadPastEndOfFile) {
+  const size_t block_size = 16;
+  const size_t file_size = 40;
+  auto fetcher = [file_size](const string& filename, size_t offset, size_t n,
+                             char* buffer, size_t* bytes_transferred) {
+    *bytes_transferred = offset < file_size ? std::min(n, file_size - offset)
+                                            : 0;
+    memset(buffer, 'x', *bytes_transferred);
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 64 * block_size, 0, fetcher,
+                          Env::Default(), /*max_read_ahead_blocks=*/4);
+  std::vector<char> out;
+  // The empty blocks read ahead past the end of the file must not make the
+  // last, partial block look inconsistent.
+  size_t offset = 0;
+  Status status;
+  while ((status = ReadCache(&cache, "", offset, block_size, &out)).ok()) {
+    if (out.empty()) break;
+    offset += out.size();
+  }
+  EXPECT_TRUE(status.ok() || errors::IsOutOfRange(status)) << status;
+  EXPECT_EQ(offset, file_size);
+}
+
 }  // namespace
 }  // namespace tensorflow
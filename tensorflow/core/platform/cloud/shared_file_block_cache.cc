@@ -0,0 +1,191 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/shared_file_block_cache.h"
+
+#include <cstdlib>
+
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/numbers.h"
+#include "tensorflow/core/platform/path.h"
+
+namespace tensorflow {
+
+namespace {
+
+constexpr char kSchemes[] = "TF_SHARED_BLOCK_CACHE_SCHEMES";
+constexpr char kMaxSizeMb[] = "TF_SHARED_BLOCK_CACHE_MAX_SIZE_MB";
+constexpr uint64 kDefaultMaxSizeMb = 1024;
+constexpr char kBlockSizeMb[] = "TF_SHARED_BLOCK_CACHE_BLOCK_SIZE_MB";
+constexpr uint64 kDefaultBlockSizeMb = 16;
+constexpr char kReadAheadBlocks[] = "TF_SHARED_BLOCK_CACHE_READ_AHEAD_BLOCKS";
+constexpr uint64 kDefaultReadAheadBlocks = 4;
+
+uint64 GetEnvUint64(const char* name, uint64 default_value) {
+  const char* value = std::getenv(name);
+  uint64 result;
+  if (value == nullptr || !strings::safe_strtou64(value, &result)) {
+    return default_value;
+  }
+  return result;
+}
+
+}  // namespace
+
+/// A file that reads through the shared cache. The underlying file is
+/// registered with the cache while this file is open, to fetch blocks from.
+class SharedFileBlockCache::CachedRandomAccessFile : public RandomAccessFile {
+ public:
+  CachedRandomAccessFile(SharedFileBlockCache* cache, const string& filename)
+      : cache_(cache), filename_(filename) {}
+
+  ~CachedRandomAccessFile() override { cache_->ReleaseFile(filename_); }
+
+  Status Name(StringPiece* result) const override {
+    *result = filename_;
+    return Status::OK();
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    size_t bytes_transferred;
+    TF_RETURN_IF_ERROR(cache_->cache_.Read(filename_, offset, n, scratch,
+                                           &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      return errors::OutOfRange("EOF reached, ", result->size(),
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
+ private:
+  SharedFileBlockCache* const cache_;  // Not owned.
+  const string filename_;
+};
+
+SharedFileBlockCache::SharedFileBlockCache(const std::set<string>& schemes,
+                                           size_t block_size, size_t max_bytes,
+                                           size_t max_read_ahead_blocks)
+    : schemes_(schemes),
+      cache_(
+          block_size, max_bytes, /*max_staleness=*/0,
+          [this](const string& filename, size_t offset, size_t n, char* buffer,
+                 size_t* bytes_transferred) {
+            return Fetch(filename, offset, n, buffer, bytes_transferred);
+          },
+          Env::Default(), max_read_ahead_blocks) {}
+
+SharedFileBlockCache* SharedFileBlockCache::Get() {
+  static SharedFileBlockCache* cache = [] {
+    std::set<string> schemes;
+    const char* schemes_env = std::getenv(kSchemes);
+    if (schemes_env != nullptr) {
+      for (absl::string_view scheme :
+           absl::StrSplit(schemes_env, ',', absl::SkipWhitespace())) {
+        schemes.emplace(scheme);
+      }
+    }
+    const uint64 max_bytes =
+        GetEnvUint64(kMaxSizeMb, kDefaultMaxSizeMb) * 1024 * 1024;
+    const uint64 block_size =
+        GetEnvUint64(kBlockSizeMb, kDefaultBlockSizeMb) * 1024 * 1024;
+    VLOG(1) << "Shared file block cache for schemes {"
+            << absl::StrJoin(schemes, ",") << "}, max size = " << max_bytes
+            << " ; block size = " << block_size;
+    return new SharedFileBlockCache(
+        schemes, block_size, max_bytes,
+        GetEnvUint64(kReadAheadBlocks, kDefaultReadAheadBlocks));
+  }();
+  return cache;
+}
+
+bool SharedFileBlockCache::IsCached(StringPiece fname) const {
+  if (schemes_.empty() || !cache_.IsCacheEnabled()) {
+    return false;
+  }
+  StringPiece scheme, host, path;
+  io::ParseURI(fname, &scheme, &host, &path);
+  return schemes_.count(string(scheme)) > 0;
+}
+
+Status SharedFileBlockCache::MaybeWrap(
+    FileSystem* fs, const string& fname,
+    std::unique_ptr<RandomAccessFile>* file) {
+  if (!IsCached(fname)) {
+    return Status::OK();
+  }
+  FileStatistics stat;
+  TF_RETURN_IF_ERROR(fs->Stat(fname, /*token=*/nullptr, &stat));
+  cache_.ValidateAndUpdateFileSignature(
+      fname, Hash64Combine(stat.length, stat.mtime_nsec));
+  AddFile(fname, std::shared_ptr<RandomAccessFile>(file->release()));
+  file->reset(new CachedRandomAccessFile(this, fname));
+  return Status::OK();
+}
+
+void SharedFileBlockCache::RemoveFile(const string& fname) {
+  cache_.RemoveFile(fname);
+}
+
+Status SharedFileBlockCache::Fetch(const string& fname, size_t offset,
+                                   size_t n, char* buffer,
+                                   size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  std::shared_ptr<RandomAccessFile> file;
+  {
+    mutex_lock l(mu_);
+    auto it = files_.find(fname);
+    if (it == files_.end()) {
+      // Only happens for blocks read ahead after the file was closed.
+      return errors::FailedPrecondition("File ", fname, " is not open.");
+    }
+    file = it->second.first;
+  }
+  StringPiece result;
+  Status status = file->Read(offset, n, &result, buffer);
+  if (!status.ok() && !errors::IsOutOfRange(status)) {
+    return status;
+  }
+  if (result.data() != buffer) {
+    memmove(buffer, result.data(), result.size());
+  }
+  *bytes_transferred = result.size();
+  return Status::OK();
+}
+
+void SharedFileBlockCache::AddFile(const string& fname,
+                                   std::shared_ptr<RandomAccessFile> file) {
+  mutex_lock l(mu_);
+  auto& entry = files_[fname];
+  if (entry.first == nullptr) {
+    entry.first = std::move(file);
+  }
+  ++entry.second;
+}
+
+void SharedFileBlockCache::ReleaseFile(const string& fname) {
+  mutex_lock l(mu_);
+  auto it = files_.find(fname);
+  if (it != files_.end() && --it->second.second == 0) {
+    files_.erase(it);
+  }
+}
+
+}  // namespace tensorflow
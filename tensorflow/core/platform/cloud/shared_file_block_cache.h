@@ -0,0 +1,103 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_SHARED_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_SHARED_FILE_BLOCK_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief A process-wide block cache for the files of remote filesystems that
+/// have no cache of their own (e.g. S3 and HDFS).
+///
+/// All cached files share one memory budget and LRU list, so that repeated
+/// reads of the same remote data, e.g. over several epochs, are served from
+/// memory whichever filesystem they come from. Sequential readers are read
+/// ahead as in RamFileBlockCache. The cache is configured from the
+/// environment:
+///
+///   TF_SHARED_BLOCK_CACHE_SCHEMES: the comma separated schemes whose files
+///     are cached, e.g. "s3,hdfs". Empty (the default) disables the cache.
+///   TF_SHARED_BLOCK_CACHE_MAX_SIZE_MB: the memory budget (default 1024).
+///   TF_SHARED_BLOCK_CACHE_BLOCK_SIZE_MB: the block size (default 16).
+///   TF_SHARED_BLOCK_CACHE_READ_AHEAD_BLOCKS: the maximum number of blocks
+///     read ahead of a sequential reader (default 4).
+class SharedFileBlockCache {
+ public:
+  SharedFileBlockCache(const std::set<string>& schemes, size_t block_size,
+                       size_t max_bytes, size_t max_read_ahead_blocks);
+
+  /// Returns the cache configured from the environment.
+  static SharedFileBlockCache* Get();
+
+  /// Returns true if the files of the scheme of `fname` are cached.
+  bool IsCached(StringPiece fname) const;
+
+  /// If the files of the scheme of `fname` are cached, replaces `*file`, which
+  /// was opened from `fname` on `fs`, with a file that reads through the
+  /// cache. The cached blocks of `fname` are dropped if its size or
+  /// modification time changed since they were read.
+  Status MaybeWrap(FileSystem* fs, const string& fname,
+                   std::unique_ptr<RandomAccessFile>* file);
+
+  /// Drops the cached blocks of `fname`, e.g. when it is overwritten.
+  void RemoveFile(const string& fname);
+
+  RamFileBlockCache* cache() { return &cache_; }
+
+ private:
+  class CachedRandomAccessFile;
+
+  /// Reads a block of `fname` through one of its open files.
+  Status Fetch(const string& fname, size_t offset, size_t n, char* buffer,
+               size_t* bytes_transferred);
+
+  /// Registers an open file to fetch the blocks of `fname` from.
+  void AddFile(const string& fname, std::shared_ptr<RandomAccessFile> file);
+
+  /// Unregisters an open file of `fname`.
+  void ReleaseFile(const string& fname);
+
+  const std::set<string> schemes_;
+
+  mutable mutex mu_;
+  /// The open files of each cached filename, and the number of times each
+  /// filename is open.
+  std::map<string, std::pair<std::shared_ptr<RandomAccessFile>, int>> files_
+      TF_GUARDED_BY(mu_);
+
+  /// Declared last, so that the blocks being read ahead are waited for before
+  /// the open files are destroyed.
+  RamFileBlockCache cache_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedFileBlockCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_SHARED_FILE_BLOCK_CACHE_H_
@@ -0,0 +1,96 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/shared_file_block_cache.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class SharedFileBlockCacheTest : public ::testing::Test {
+ protected:
+  SharedFileBlockCacheTest()
+      : cache_({"file"}, /*block_size=*/8, /*max_bytes=*/64,
+               /*max_read_ahead_blocks=*/0),
+        fname_(strings::StrCat(
+            "file://", io::JoinPath(testing::TmpDir(), "shared_cache_file"))) {
+  }
+
+  Status OpenCached(std::unique_ptr<RandomAccessFile>* file) {
+    FileSystem* fs;
+    TF_RETURN_IF_ERROR(Env::Default()->GetFileSystemForFile(fname_, &fs));
+    TF_RETURN_IF_ERROR(fs->NewRandomAccessFile(fname_, nullptr, file));
+    return cache_.MaybeWrap(fs, fname_, file);
+  }
+
+  SharedFileBlockCache cache_;
+  const string fname_;
+};
+
+TEST_F(SharedFileBlockCacheTest, IsCached) {
+  EXPECT_TRUE(cache_.IsCached("file:///tmp/a"));
+  EXPECT_FALSE(cache_.IsCached("s3://bucket/a"));
+  EXPECT_FALSE(cache_.IsCached("/tmp/a"));
+
+  SharedFileBlockCache disabled({"file"}, 8, /*max_bytes=*/0, 0);
+  EXPECT_FALSE(disabled.IsCached("file:///tmp/a"));
+}
+
+TEST_F(SharedFileBlockCacheTest, ReadsThroughCache) {
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname_, "0123456789abc"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(OpenCached(&file));
+
+  char scratch[16];
+  StringPiece result;
+  TF_EXPECT_OK(file->Read(2, 8, &result, scratch));
+  EXPECT_EQ("23456789", result);
+  EXPECT_EQ(13, cache_.cache()->CacheSize());
+  EXPECT_TRUE(errors::IsOutOfRange(file->Read(10, 8, &result, scratch)));
+  EXPECT_EQ("abc", result);
+
+  // Blocks already cached are served without reading the file again.
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname_, "ABCDEFGHIJKLM"));
+  TF_EXPECT_OK(file->Read(0, 4, &result, scratch));
+  EXPECT_EQ("0123", result);
+
+  // Once the file is removed from the cache, its new contents are read.
+  cache_.RemoveFile(fname_);
+  TF_EXPECT_OK(file->Read(0, 4, &result, scratch));
+  EXPECT_EQ("ABCD", result);
+}
+
+TEST_F(SharedFileBlockCacheTest, SharedBetweenOpenFiles) {
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname_, "0123456789abc"));
+  std::unique_ptr<RandomAccessFile> file1, file2;
+  TF_ASSERT_OK(OpenCached(&file1));
+  TF_ASSERT_OK(OpenCached(&file2));
+
+  char scratch[16];
+  StringPiece result;
+  TF_EXPECT_OK(file1->Read(0, 8, &result, scratch));
+  file1.reset();
+  TF_EXPECT_OK(file2->Read(0, 8, &result, scratch));
+  EXPECT_EQ("01234567", result);
+  EXPECT_EQ(8, cache_.cache()->CacheSize());
+}
+
+}  // namespace
+}  // namespace tensorflow
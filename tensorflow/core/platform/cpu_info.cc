@@ -87,6 +87,8 @@ class CPUIDInfo {
         have_avx512ifma_(0),
         have_avx512_4vnniw_(0),
         have_avx512_4fmaps_(0),
+        have_avx512_bf16_(0),
+        have_amx_bf16_(0),
         have_bmi1_(0),
         have_bmi2_(0),
         have_cmov_(0),
@@ -153,10 +155,13 @@ class CPUIDInfo {
     const uint64 xcr0_maskreg_mask = 0x20;
     const uint64 xcr0_zmm0_15_mask = 0x40;
     const uint64 xcr0_zmm16_31_mask = 0x80;
+    const uint64 xcr0_tilecfg_mask = 0x20000;
+    const uint64 xcr0_tiledata_mask = 0x40000;
 
     const uint64 xcr0_avx_mask = xcr0_xmm_mask | xcr0_ymm_mask;
     const uint64 xcr0_avx512_mask = xcr0_avx_mask | xcr0_maskreg_mask |
                                     xcr0_zmm0_15_mask | xcr0_zmm16_31_mask;
+    const uint64 xcr0_amx_mask = xcr0_tilecfg_mask | xcr0_tiledata_mask;
 
     const bool have_avx =
         // Does the OS support XGETBV instruction use by applications?
@@ -172,6 +177,12 @@ class CPUIDInfo {
         // Does the OS save/restore ZMM state?
         ((GetXCR0EAX() & xcr0_avx512_mask) == xcr0_avx512_mask);
 
+    const bool have_amx =
+        // Does the OS support XGETBV instruction use by applications?
+        ((ecx >> 27) & 0x1) &&
+        // Does the OS save/restore the tile state?
+        ((GetXCR0EAX() & xcr0_amx_mask) == xcr0_amx_mask);
+
     cpuid->have_avx_ = have_avx;
     cpuid->have_fma_ = have_avx && ((ecx >> 12) & 0x1);
     cpuid->have_f16c_ = have_avx && ((ecx >> 29) & 0x1);
@@ -202,6 +213,14 @@ class CPUIDInfo {
     cpuid->have_avx512ifma_ = have_avx512 && ((ebx >> 21) & 0x1);
     cpuid->have_avx512_4vnniw_ = have_avx512 && ((edx >> 2) & 0x1);
     cpuid->have_avx512_4fmaps_ = have_avx512 && ((edx >> 3) & 0x1);
+    cpuid->have_amx_bf16_ = have_amx && ((edx >> 22) & 0x1);
+
+    // The level 7 sub-leaf 1 features exist if the maximum sub-leaf, returned
+    // in eax by sub-leaf 0, is at least 1.
+    if (eax >= 1) {
+      GETCPUID(eax, ebx, ecx, edx, 7, 1);
+      cpuid->have_avx512_bf16_ = have_avx512 && ((eax >> 5) & 0x1);
+    }
   }
 
   static bool TestFeature(CPUFeature feature) {
@@ -223,6 +242,8 @@ class CPUIDInfo {
       case AVX512IFMA:    return cpuid->have_avx512ifma_;
       case AVX512_4VNNIW: return cpuid->have_avx512_4vnniw_;
       case AVX512_4FMAPS: return cpuid->have_avx512_4fmaps_;
+      case AVX512_BF16:   return cpuid->have_avx512_bf16_;
+      case AMX_BF16:      return cpuid->have_amx_bf16_;
       case BMI1:          return cpuid->have_bmi1_;
       case BMI2:          return cpuid->have_bmi2_;
       case CMOV:          return cpuid->have_cmov_;
@@ -272,6 +293,8 @@ class CPUIDInfo {
   int have_avx512ifma_ : 1;
   int have_avx512_4vnniw_ : 1;
   int have_avx512_4fmaps_ : 1;
+  int have_avx512_bf16_ : 1;
+  int have_amx_bf16_ : 1;
   int have_bmi1_ : 1;
   int have_bmi2_ : 1;
   int have_cmov_ : 1;
@@ -64,6 +64,10 @@ int NumTotalCPUs();
 // identified.  If successful, the return value will be in [0, NumTotalCPUs()).
 int GetCurrentCPU();
 
+// Pins the current thread to the CPU with id `cpu`, in [0, NumTotalCPUs()).
+// Returns false if the platform does not support it or the call failed.
+bool SetCurrentThreadCPUAffinity(int cpu);
+
 // Returns an estimate of the number of hyperthreads per physical core
 // on the CPU
 int NumHyperthreadsPerCore();
@@ -122,6 +126,12 @@ enum CPUFeature {
   AVX512IFMA = 35,     // Integer multiply-add
   AVX512_4VNNIW = 36,  // Integer neural network
   AVX512_4FMAPS = 37,  // Floating point neural network
+
+  // bfloat16 dot products, in Cooper Lake, Sapphire Rapids, etc.
+  AVX512_BF16 = 38,
+  // Advanced Matrix Extensions tile operations on bfloat16, in Sapphire
+  // Rapids, etc.
+  AMX_BF16 = 39,
 };
 
 // Checks whether the current processor supports one of the features above.
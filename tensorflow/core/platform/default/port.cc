@@ -24,6 +24,7 @@ limitations under the License.
 
 #if defined(__linux__) && !defined(__ANDROID__)
 #include <sched.h>
+#include <sys/mman.h>
 #include <sys/sysinfo.h>
 #else
 #include <sys/syscall.h>
@@ -134,6 +135,19 @@ int GetCurrentCPU() {
   return kUnknownCPU;
 }
 
+bool SetCurrentThreadCPUAffinity(int cpu) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  // A pid of 0 is the calling thread.
+  return sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) == 0;
+#else
+  return false;
+#endif
+}
+
 int NumHyperthreadsPerCore() {
   static const int ht_per_core = tensorflow::port::CPUIDNumSMT();
   return (ht_per_core > 0) ? ht_per_core : 1;
@@ -249,6 +263,65 @@ void* AlignedMalloc(size_t size, int minimum_alignment) {
 
 void AlignedFree(void* aligned_memory) { Free(aligned_memory); }
 
+void* HugePageMalloc(size_t size, size_t page_size) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const size_t length = (size + page_size - 1) / page_size * page_size;
+#ifdef MAP_HUGETLB
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+  // Selects the huge page size, instead of the system default.
+  flags |= __builtin_ctzll(page_size) << MAP_HUGE_SHIFT;
+#endif
+  void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (ptr != MAP_FAILED) return ptr;
+#endif
+  // No reserved huge pages are available: map normal pages aligned to the
+  // huge page size, by mapping one more page and unmapping the ends, and ask
+  // for transparent huge pages.
+  const size_t mapped_length = length + page_size;
+  char* mapped = static_cast<char*>(mmap(nullptr, mapped_length,
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (mapped == MAP_FAILED) return nullptr;
+  char* begin = reinterpret_cast<char*>(
+      (reinterpret_cast<uintptr_t>(mapped) + page_size - 1) / page_size *
+      page_size);
+  char* end = begin + length;
+  if (begin > mapped) munmap(mapped, begin - mapped);
+  if (mapped + mapped_length > end) {
+    munmap(end, mapped + mapped_length - end);
+  }
+  AdviseHugePages(begin, length);
+  return begin;
+#else
+  return AlignedMalloc(size, static_cast<int>(page_size));
+#endif
+}
+
+void HugePageFree(void* ptr, size_t size, size_t page_size) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  munmap(ptr, (size + page_size - 1) / page_size * page_size);
+#else
+  AlignedFree(ptr);
+#endif
+}
+
+bool AdviseHugePages(void* ptr, size_t size) {
+#if defined(__linux__) && !defined(__ANDROID__) && defined(MADV_HUGEPAGE)
+  constexpr uintptr_t kHugePageSize = 2 << 20;
+  const uintptr_t begin =
+      (reinterpret_cast<uintptr_t>(ptr) + kHugePageSize - 1) / kHugePageSize *
+      kHugePageSize;
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(ptr) + size) / kHugePageSize * kHugePageSize;
+  if (begin >= end) return false;
+  return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) ==
+         0;
+#else
+  return false;
+#endif
+}
+
 void* Malloc(size_t size) { return malloc(size); }
 
 void* Realloc(void* ptr, size_t size) { return realloc(ptr, size); }
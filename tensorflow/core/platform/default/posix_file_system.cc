@@ -28,11 +28,18 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
 #include "tensorflow/core/platform/default/posix_file_system.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/error.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -42,6 +49,101 @@ namespace tensorflow {
 // 128KB of copy buffer
 constexpr size_t kPosixCopyFileBufferSize = 128 * 1024;
 
+namespace {
+
+// The number of threads which serve the reads of `ReadMany` calls.
+constexpr int kNumReadThreads = 16;
+
+// A pool of threads which serve the ranges of `ReadMany` calls concurrently,
+// so that one caller keeps several reads in flight on the device. The threads
+// are started on first use and shared by all files.
+class ReadThreadPool {
+ public:
+  static ReadThreadPool* Get() {
+    static ReadThreadPool* pool = new ReadThreadPool();
+    return pool;
+  }
+
+  // Runs `fn(0)`, ..., `fn(n - 1)` on the pool and the calling thread, and
+  // returns once all of them have finished. The calling thread keeps taking
+  // work, so this finishes even if all threads of the pool are busy.
+  void ParallelFor(int n, const std::function<void(int)>& fn) {
+    auto state = std::make_shared<ParallelForState>(n, &fn);
+    const int num_helpers = std::min(n - 1, kNumReadThreads);
+    {
+      mutex_lock l(mu_);
+      MaybeStartThreads();
+      for (int i = 0; i < num_helpers; ++i) {
+        work_.push_back([state]() { state->Run(); });
+      }
+      cv_.notify_all();
+    }
+    state->Run();
+    mutex_lock l(state->mu);
+    while (state->num_done < n) {
+      state->cv.wait(l);
+    }
+  }
+
+ private:
+  struct ParallelForState {
+    ParallelForState(int n, const std::function<void(int)>* fn)
+        : n(n), fn(fn) {}
+
+    // Runs the remaining iterations until there are none left.
+    void Run() {
+      for (int i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+        (*fn)(i);
+        mutex_lock l(mu);
+        if (++num_done == n) {
+          cv.notify_all();
+        }
+      }
+    }
+
+    const int n;
+    // Only called for iterations below `n`, which the caller of
+    // `ParallelFor` waits for, so `fn` outlives its uses.
+    const std::function<void(int)>* const fn;
+    std::atomic<int> next{0};
+    mutex mu;
+    condition_variable cv;
+    int num_done TF_GUARDED_BY(mu) = 0;
+  };
+
+  void MaybeStartThreads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (!threads_.empty()) {
+      return;
+    }
+    for (int i = 0; i < kNumReadThreads; ++i) {
+      threads_.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), "tf_posix_read", [this]() { WorkerLoop(); }));
+    }
+  }
+
+  void WorkerLoop() {
+    while (true) {
+      std::function<void()> work;
+      {
+        mutex_lock l(mu_);
+        while (work_.empty()) {
+          cv_.wait(l);
+        }
+        work = std::move(work_.front());
+        work_.pop_front();
+      }
+      work();
+    }
+  }
+
+  mutex mu_;
+  condition_variable cv_;
+  std::deque<std::function<void()>> work_ TF_GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<Thread>> threads_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
 // pread() based random-access
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
@@ -92,6 +194,19 @@ class PosixRandomAccessFile : public RandomAccessFile {
     *result = StringPiece(scratch, dst - scratch);
     return s;
   }
+
+  void ReadMany(std::vector<ReadRequest>* requests) const override {
+    if (requests->size() < 2) {
+      RandomAccessFile::ReadMany(requests);
+      return;
+    }
+    ReadThreadPool::Get()->ParallelFor(
+        requests->size(), [this, requests](int i) {
+          ReadRequest& request = (*requests)[i];
+          request.status = Read(request.offset, request.n, &request.result,
+                                request.scratch);
+        });
+  }
 };
 
 class PosixWritableFile : public WritableFile {
@@ -579,6 +579,10 @@ struct ThreadOptions {
   /// Guard area size to use near thread stacks to use (in bytes)
   size_t guard_size = 0;  // 0: use system default value
   int numa_node = port::kNUMANoAffinity;
+  /// If not empty, the threads of a thread::ThreadPool are each pinned to one
+  /// of these CPUs, in a round robin over the list. Takes precedence over
+  /// `numa_node`.
+  std::vector<int> cpu_list;
 };
 
 /// A utility routine: copy contents of `src` in file system `src_fs`
@@ -90,6 +90,32 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadMany) {
+  const string filename = io::JoinPath(BaseDir(), "read_many");
+  const string input = CreateTestFile(env_, filename, 10000);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  std::vector<std::vector<char>> scratch;
+  std::vector<RandomAccessFile::ReadRequest> requests;
+  for (int i = 0; i < 50; ++i) {
+    RandomAccessFile::ReadRequest request;
+    request.offset = i * 200;
+    request.n = i == 49 ? 300 : 100;
+    scratch.emplace_back(request.n);
+    request.scratch = scratch.back().data();
+    requests.push_back(request);
+  }
+  f->ReadMany(&requests);
+  for (int i = 0; i < 49; ++i) {
+    TF_EXPECT_OK(requests[i].status);
+    EXPECT_EQ(input.substr(i * 200, 100), requests[i].result);
+  }
+  // The last request goes past EOF.
+  EXPECT_EQ(error::OUT_OF_RANGE, requests[49].status.code());
+  EXPECT_EQ(input.substr(9800), requests[49].result);
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
@@ -217,6 +243,19 @@ TEST_F(DefaultEnvTest, DeleteRecursivelyFail) {
   EXPECT_EQ(1, undeleted_dirs);
 }
 
+TEST_F(DefaultEnvTest, FileSystemCopyFileInChunks) {
+  // Large enough to be read in two batches of parallel chunks.
+  const string src = io::JoinPath(BaseDir(), "src");
+  const string target = io::JoinPath(BaseDir(), "target");
+  const string input = CreateTestFile(env_, src, (33 << 20) + 123);
+  FileSystem* fs;
+  TF_ASSERT_OK(env_->GetFileSystemForFile(src, &fs));
+  TF_EXPECT_OK(FileSystemCopyFile(fs, src, fs, target));
+  string output;
+  TF_EXPECT_OK(ReadFileToString(env_, target, &output));
+  EXPECT_TRUE(input == output);
+}
+
 TEST_F(DefaultEnvTest, RecursivelyCreateDir) {
   const string create_path = io::JoinPath(BaseDir(), "a", "b", "c", "d");
   TF_CHECK_OK(env_->RecursivelyCreateDir(create_path));
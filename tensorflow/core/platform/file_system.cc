@@ -31,6 +31,8 @@ limitations under the License.
 
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system_helper.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/platform/scanner.h"
 #include "tensorflow/core/platform/str_util.h"
@@ -148,21 +150,26 @@ Status FileSystem::DeleteRecursively(const string& dirname,
       (*undeleted_dirs)++;
       continue;
     }
-    for (const string& child : children) {
-      const string child_path = this->JoinPath(dir, child);
+    // The children are checked and deleted in parallel, since each call may
+    // be a round trip to a remote file system.
+    mutex mu;
+    internal::ForEach(0, children.size(), [&](int i) {
+      const string child_path = this->JoinPath(dir, children[i]);
       // If the child is a directory add it to the queue, otherwise delete it.
       if (IsDirectory(child_path).ok()) {
+        mutex_lock l(mu);
         dir_q.push_back(child_path);
       } else {
         // Delete file might fail because of permissions issues or might be
         // unimplemented.
         Status del_status = DeleteFile(child_path);
+        mutex_lock l(mu);
         ret.Update(del_status);
         if (!del_status.ok()) {
           (*undeleted_files)++;
         }
       }
-    }
+    });
   }
   // Now reverse the list of directories and delete them. The BFS ensures that
   // we can delete the directories in this order.
@@ -751,6 +751,33 @@ class RandomAccessFile {
   virtual tensorflow::Status Read(uint64 offset, size_t n, StringPiece* result,
                                   char* scratch) const = 0;
 
+  /// \brief A range of the file to read with `ReadMany`.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    /// Space for `n` bytes, used as by `Read`.
+    char* scratch = nullptr;
+    /// Set by `ReadMany`, as `Read` sets its result and returns its status.
+    StringPiece result;
+    Status status;
+  };
+
+  /// \brief Reads several ranges of the file.
+  ///
+  /// Sets the `result` and `status` of every request as `Read` would. File
+  /// systems may serve the requests concurrently, to keep several reads in
+  /// flight on the device from a single caller, so the requests must not
+  /// share scratch space. The default implementation calls `Read` for each
+  /// request in turn.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadMany(std::vector<ReadRequest>* requests) const {
+    for (ReadRequest& request : *requests) {
+      request.status =
+          Read(request.offset, request.n, &request.result, request.scratch);
+    }
+  }
+
   // TODO(ebrevdo): Remove this ifdef when absl is updated.
 #if defined(PLATFORM_GOOGLE)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
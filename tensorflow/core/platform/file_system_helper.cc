@@ -34,14 +34,15 @@ namespace {
 
 constexpr int kNumThreads = 8;
 
-// Run a function in parallel using a ThreadPool, but skip the ThreadPool
-// on the iOS platform due to its problems with more than a few threads.
+}  // namespace
+
 void ForEach(int first, int last, const std::function<void(int)>& f) {
 #if TARGET_OS_IPHONE
   for (int i = first; i < last; i++) {
     f(i);
   }
 #else
+  if (first >= last) return;
   int num_threads = std::min(kNumThreads, last - first);
   thread::ThreadPool threads(Env::Default(), "ForEach", num_threads);
   for (int i = first; i < last; i++) {
@@ -50,8 +51,6 @@ void ForEach(int first, int last, const std::function<void(int)>& f) {
 #endif
 }
 
-}  // namespace
-
 Status GetMatchingPaths(FileSystem* fs, Env* env, const string& pattern,
                         std::vector<string>* results) {
   results->clear();
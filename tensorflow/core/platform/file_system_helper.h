@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_FILE_SYSTEM_HELPER_H_
 #define TENSORFLOW_CORE_PLATFORM_FILE_SYSTEM_HELPER_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,11 @@ class Env;
 
 namespace internal {
 
+// Runs f(i) for i in [first, last) on up to 8 threads and returns when all the
+// calls are done. The calls run sequentially on iOS, due to its problems with
+// more than a few threads.
+void ForEach(int first, int last, const std::function<void(int)>& f);
+
 // Given a pattern, stores in 'results' the set of paths (in the given file
 // system) that match that pattern.
 //
@@ -17,12 +17,17 @@ limitations under the License.
 
 #include <errno.h>
 
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/cloud/shared_file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/error.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
@@ -50,6 +55,8 @@ class LibHDFS {
   std::function<hdfsFS(hdfsBuilder*)> hdfsBuilderConnect;
   std::function<hdfsBuilder*()> hdfsNewBuilder;
   std::function<void(hdfsBuilder*, const char*)> hdfsBuilderSetNameNode;
+  std::function<int(hdfsBuilder*, const char*, const char*)>
+      hdfsBuilderConfSetStr;
   std::function<int(const char*, char**)> hdfsConfGetStr;
   std::function<int(hdfsFS, hdfsFile)> hdfsCloseFile;
   std::function<tSize(hdfsFS, hdfsFile, tOffset, void*, tSize)> hdfsPread;
@@ -77,6 +84,7 @@ class LibHDFS {
       BIND_HDFS_FUNC(hdfsBuilderConnect);
       BIND_HDFS_FUNC(hdfsNewBuilder);
       BIND_HDFS_FUNC(hdfsBuilderSetNameNode);
+      BIND_HDFS_FUNC(hdfsBuilderConfSetStr);
       BIND_HDFS_FUNC(hdfsConfGetStr);
       BIND_HDFS_FUNC(hdfsCloseFile);
       BIND_HDFS_FUNC(hdfsPread);
@@ -154,6 +162,56 @@ Status SplitArchiveNameAndPath(StringPiece& path, string& nn) {
   return Status::OK();
 }
 
+namespace {
+
+// Options of the HDFS client for reads, set from the environment:
+//  * HDFS_SHORT_CIRCUIT_SOCKET_PATH: the UNIX domain socket of the local
+//    datanode. If set, blocks stored on the local datanode are read directly
+//    from its disks instead of over the network.
+//  * HDFS_HEDGED_READ_THREADS, HDFS_HEDGED_READ_THRESHOLD_MS: if the number of
+//    threads is not 0, a read that is not done after the threshold (500 ms by
+//    default) is also sent to another replica, and the first result is used.
+//  * HDFS_READ_BUFFER_SIZE: the buffer size of files opened for reading, or 0
+//    for the default of the client.
+struct HdfsReadOptions {
+  HdfsReadOptions() {
+    const char* socket_path = getenv("HDFS_SHORT_CIRCUIT_SOCKET_PATH");
+    if (socket_path != nullptr && socket_path[0] != '\0') {
+      conf.emplace_back("dfs.client.read.shortcircuit", "true");
+      conf.emplace_back("dfs.domain.socket.path", socket_path);
+    }
+    const char* hedged_read_threads = getenv("HDFS_HEDGED_READ_THREADS");
+    int32 num_threads = 0;
+    if (hedged_read_threads != nullptr &&
+        strings::safe_strto32(hedged_read_threads, &num_threads) &&
+        num_threads > 0) {
+      conf.emplace_back("dfs.client.hedged.read.threadpool.size",
+                        strings::StrCat(num_threads));
+      const char* threshold_ms = getenv("HDFS_HEDGED_READ_THRESHOLD_MS");
+      conf.emplace_back("dfs.client.hedged.read.threshold.millis",
+                        threshold_ms != nullptr ? threshold_ms : "500");
+    }
+    const char* buffer_size = getenv("HDFS_READ_BUFFER_SIZE");
+    if (buffer_size != nullptr &&
+        !strings::safe_strto32(buffer_size, &read_buffer_size)) {
+      LOG(ERROR) << "Invalid HDFS_READ_BUFFER_SIZE: " << buffer_size;
+      read_buffer_size = 0;
+    }
+  }
+
+  // Configuration keys and values of the client. They must outlive the
+  // builders they are set on.
+  std::vector<std::pair<string, string>> conf;
+  int32 read_buffer_size = 0;
+};
+
+const HdfsReadOptions& ReadOptions() {
+  static const HdfsReadOptions* options = new HdfsReadOptions();
+  return *options;
+}
+
+}  // namespace
+
 // We rely on HDFS connection caching here. The HDFS client calls
 // org.apache.hadoop.fs.FileSystem.get(), which caches the connection
 // internally.
@@ -189,6 +247,10 @@ Status HadoopFileSystem::Connect(StringPiece fname, hdfsFS* fs) {
     libhdfs()->hdfsBuilderSetNameNode(builder,
                                       nn.empty() ? "default" : nn.c_str());
   }
+  for (const auto& key_value : ReadOptions().conf) {
+    libhdfs()->hdfsBuilderConfSetStr(builder, key_value.first.c_str(),
+                                     key_value.second.c_str());
+  }
   *fs = libhdfs()->hdfsBuilderConnect(builder);
   if (*fs == nullptr) {
     return errors::NotFound(strerror(errno));
@@ -264,7 +326,7 @@ class HDFSRandomAccessFile : public RandomAccessFile {
           return IOError(filename_, errno);
         }
         file_ = libhdfs()->hdfsOpenFile(fs_, hdfs_filename_.c_str(), O_RDONLY,
-                                        0, 0, 0);
+                                        ReadOptions().read_buffer_size, 0, 0);
         if (file_ == nullptr) {
           return IOError(filename_, errno);
         }
@@ -297,14 +359,15 @@ Status HadoopFileSystem::NewRandomAccessFile(
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
 
-  hdfsFile file = libhdfs()->hdfsOpenFile(fs, TranslateName(fname).c_str(),
-                                          O_RDONLY, 0, 0, 0);
+  hdfsFile file =
+      libhdfs()->hdfsOpenFile(fs, TranslateName(fname).c_str(), O_RDONLY,
+                              ReadOptions().read_buffer_size, 0, 0);
   if (file == nullptr) {
     return IOError(fname, errno);
   }
   result->reset(
       new HDFSRandomAccessFile(fname, TranslateName(fname), fs, file));
-  return Status::OK();
+  return SharedFileBlockCache::Get()->MaybeWrap(this, fname, result);
 }
 
 class HDFSWritableFile : public WritableFile {
@@ -389,6 +452,7 @@ Status HadoopFileSystem::NewWritableFile(
     std::unique_ptr<WritableFile>* result) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
+  SharedFileBlockCache::Get()->RemoveFile(fname);
 
   hdfsFile file = libhdfs()->hdfsOpenFile(fs, TranslateName(fname).c_str(),
                                           O_WRONLY, 0, 0, 0);
@@ -474,6 +538,7 @@ Status HadoopFileSystem::DeleteFile(const string& fname,
                                     TransactionToken* token) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
+  SharedFileBlockCache::Get()->RemoveFile(fname);
 
   if (libhdfs()->hdfsDelete(fs, TranslateName(fname).c_str(),
                             /*recursive=*/0) != 0) {
@@ -543,6 +608,8 @@ Status HadoopFileSystem::RenameFile(const string& src, const string& target,
                                     TransactionToken* token) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(src, &fs));
+  SharedFileBlockCache::Get()->RemoveFile(src);
+  SharedFileBlockCache::Get()->RemoveFile(target);
 
   if (libhdfs()->hdfsExists(fs, TranslateName(target).c_str()) == 0 &&
       libhdfs()->hdfsDelete(fs, TranslateName(target).c_str(),
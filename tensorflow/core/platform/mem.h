@@ -29,6 +29,20 @@ namespace port {
 void* AlignedMalloc(size_t size, int minimum_alignment);
 void AlignedFree(void* aligned_memory);
 
+// Allocates `size` bytes aligned to `page_size`, a power of 2, backed by huge
+// pages of `page_size` bytes (e.g. 2 MB or 1 GB) where the platform supports
+// them. Huge pages reserved by the system are used if any are available;
+// otherwise transparent huge pages are requested, which the system grants on
+// a best effort basis. Returns nullptr on failure. The memory must be released
+// with HugePageFree, with the same `size` and `page_size`.
+void* HugePageMalloc(size_t size, size_t page_size);
+void HugePageFree(void* ptr, size_t size, size_t page_size);
+
+// Asks the system to back the whole 2 MB pages in [ptr, ptr + size), e.g. of a
+// memory mapped file, with transparent huge pages. Returns false if the
+// platform does not support it or the request failed.
+bool AdviseHugePages(void* ptr, size_t size);
+
 void* Malloc(size_t size);
 void* Realloc(void* ptr, size_t size);
 void Free(void* ptr);
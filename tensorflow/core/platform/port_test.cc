@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <string.h>
+
 #include <condition_variable>
 
 #include "tensorflow/core/platform/cpu_info.h"
@@ -35,6 +37,18 @@ TEST(Port, AlignedMalloc) {
   }
 }
 
+TEST(Port, HugePageMalloc) {
+  const size_t kPageSize = 2 << 20;
+  for (size_t size : {size_t{1}, kPageSize, 3 * kPageSize + 1}) {
+    char* p = static_cast<char*>(HugePageMalloc(size, kPageSize));
+    ASSERT_TRUE(p != nullptr) << "HugePageMalloc(" << size << ")";
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % kPageSize, 0);
+    memset(p, 1, size);
+    EXPECT_EQ(p[size - 1], 1);
+    HugePageFree(p, size, kPageSize);
+  }
+}
+
 TEST(Port, GetCurrentCPU) {
   const int cpu = GetCurrentCPU();
 #if !defined(__APPLE__)
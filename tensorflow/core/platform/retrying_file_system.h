@@ -131,6 +131,15 @@ class RetryingFileSystem : public FileSystem {
         retry_config_);
   }
 
+  Status CopyFile(const string& src, const string& target,
+                  TransactionToken* token) override {
+    return RetryingUtils::CallWithRetries(
+        [this, &src, &target, token]() {
+          return base_file_system_->CopyFile(src, target, token);
+        },
+        retry_config_);
+  }
+
   Status IsDirectory(const string& dirname, TransactionToken* token) override {
     return RetryingUtils::CallWithRetries(
         [this, &dirname, token]() {
@@ -28,6 +28,7 @@ limitations under the License.
 #include <aws/s3/model/CompletedMultipartUpload.h>
 #include <aws/s3/model/CompletedPart.h>
 #include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/DeleteObjectRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/HeadBucketRequest.h>
@@ -35,16 +36,23 @@ limitations under the License.
 #include <aws/s3/model/ListObjectsRequest.h>
 #include <aws/s3/model/PutObjectRequest.h>
 #include <aws/s3/model/UploadPartCopyRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <map>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/platform/cloud/shared_file_block_cache.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/s3/aws_crypto.h"
 #include "tensorflow/core/platform/s3/aws_logging.h"
 #include "tensorflow/core/platform/str_util.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -61,7 +69,29 @@ static const size_t kS3ReadAppendableFileBufferSize = 1024 * 1024;
 static const int64 kS3TimeoutMsec = 300000;                           // 5 min
 static const uint64 kS3MultiPartUploadChunkSize = 50 * 1024 * 1024;   // 50 MB
 static const uint64 kS3MultiPartDownloadChunkSize = 2 * 1024 * 1024;  // 50 MB
+// S3 rejects multipart uploads with parts other than the last below 5 MB.
+static const uint64 kS3MinMultiPartUploadChunkSize = 5 * 1024 * 1024;
+// The number of parts of one file uploaded in parallel while it is written.
+static const int kS3StreamingUploadPartsInFlight = 4;
 static const int kS3GetChildrenMaxKeys = 100;
+// The maximum number of keys S3 returns for one list request.
+static const int kS3GlobMaxKeys = 1000;
+// The maximum number of prefixes GetMatchingPaths lists in parallel.
+static const int kS3GlobThreads = 16;
+// The maximum age, in seconds, of the cached object statistics. A value of 0
+// (the default) means nothing is cached.
+static const char* kS3StatCacheMaxAge = "S3_STAT_CACHE_MAX_AGE";
+static const uint64 kS3StatCacheDefaultMaxAge = 0;
+static const char* kS3StatCacheMaxEntries = "S3_STAT_CACHE_MAX_ENTRIES";
+static const uint64 kS3StatCacheDefaultMaxEntries = 100000;
+// The maximum age, in seconds, of the cached GetMatchingPaths results. A value
+// of 0 (the default) means nothing is cached.
+static const char* kS3MatchingPathsCacheMaxAge =
+    "S3_MATCHING_PATHS_CACHE_MAX_AGE";
+static const uint64 kS3MatchingPathsCacheDefaultMaxAge = 0;
+static const char* kS3MatchingPathsCacheMaxEntries =
+    "S3_MATCHING_PATHS_CACHE_MAX_ENTRIES";
+static const uint64 kS3MatchingPathsCacheDefaultMaxEntries = 1024;
 
 // With this change multiple threads are used in one single download.
 // Increasing the thread pool size since multiple downloads
@@ -211,6 +241,15 @@ Status ParseS3Path(const string& fname, bool empty_object_ok, string* bucket,
   return Status::OK();
 }
 
+static uint64 GetEnvUint64(const char* name, uint64 default_value) {
+  const char* value_str = getenv(name);
+  uint64 value;
+  if (value_str == nullptr || !strings::safe_strtou64(value_str, &value)) {
+    return default_value;
+  }
+  return value;
+}
+
 static Status CheckForbiddenError(
     const Aws::Client::AWSError<Aws::S3::S3Errors>& error) {
   if (error.GetResponseCode() == Aws::Http::HttpResponseCode::FORBIDDEN) {
@@ -436,6 +475,297 @@ class S3WritableFile : public WritableFile {
   std::shared_ptr<Aws::Utils::TempFile> outfile_;
 };
 
+// A writable file that uploads its contents as the parts of a multipart upload
+// while they are written, instead of buffering the whole file in a temporary
+// file until Sync() or Close(). Up to kS3StreamingUploadPartsInFlight parts are
+// uploaded in parallel on the executor, which bounds the memory used for
+// buffering to that many parts plus the one being written. A file smaller than
+// one part is uploaded with a single PutObject request.
+//
+// The object becomes visible when the file is closed. Once the first part has
+// been uploaded, Flush() and Sync() cannot publish the data written so far
+// without ending the multipart upload, and only report failed parts.
+class S3StreamingWritableFile : public WritableFile {
+ public:
+  S3StreamingWritableFile(
+      const string& bucket, const string& object, uint64 part_size,
+      std::shared_ptr<Aws::S3::S3Client> s3_client,
+      std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> executor)
+      : bucket_(bucket),
+        object_(object),
+        part_size_(std::max(part_size, kS3MinMultiPartUploadChunkSize)),
+        s3_client_(s3_client),
+        executor_(executor),
+        part_(NewPart()) {}
+
+  ~S3StreamingWritableFile() override {
+    if (!closed_ && !upload_id_.empty()) {
+      // Do not leave the parts of a file that was never closed behind.
+      WaitForParts();
+      AbortUpload().IgnoreError();
+    }
+  }
+
+  Status Append(StringPiece data) override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    sync_needed_ = true;
+    position_ += data.size();
+    while (!data.empty()) {
+      const size_t n = std::min<uint64>(data.size(), part_size_ - part_bytes_);
+      part_->write(data.data(), n);
+      if (!part_->good()) {
+        return errors::Internal("Could not append to the part buffer.");
+      }
+      part_bytes_ += n;
+      data.remove_prefix(n);
+      if (part_bytes_ == part_size_) {
+        TF_RETURN_IF_ERROR(StartPartUpload());
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Close() override {
+    if (closed_) {
+      return Status::OK();
+    }
+    if (upload_id_.empty()) {
+      TF_RETURN_IF_ERROR(Sync());
+      closed_ = true;
+      part_.reset();
+      return Status::OK();
+    }
+    Status status;
+    if (part_bytes_ > 0) {
+      status = StartPartUpload();
+    }
+    if (status.ok()) {
+      status = CompleteUpload();
+    }
+    if (!status.ok()) {
+      WaitForParts();
+      AbortUpload().IgnoreError();
+    }
+    closed_ = true;
+    part_.reset();
+    return status;
+  }
+
+  Status Flush() override { return Sync(); }
+
+  Status Name(StringPiece* result) const override {
+    return errors::Unimplemented(
+        "S3StreamingWritableFile does not support Name()");
+  }
+
+  Status Sync() override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    if (!upload_id_.empty()) {
+      mutex_lock l(mu_);
+      return status_;
+    }
+    if (!sync_needed_) {
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(PutObject());
+    sync_needed_ = false;
+    return Status::OK();
+  }
+
+  Status Tell(int64* position) override {
+    *position = position_;
+    return Status::OK();
+  }
+
+ private:
+  static std::shared_ptr<Aws::StringStream> NewPart() {
+    return Aws::MakeShared<Aws::StringStream>(kS3FileSystemAllocationTag);
+  }
+
+  Status CheckWritable() const {
+    if (closed_) {
+      return errors::FailedPrecondition("The file has been closed.");
+    }
+    return Status::OK();
+  }
+
+  // Uploads the whole file, which is smaller than a part, as one object.
+  Status PutObject() {
+    VLOG(1) << "PutObject: s3://" << bucket_ << "/" << object_;
+    Aws::S3::Model::PutObjectRequest request;
+    request.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
+    request.SetContentType("application/octet-stream");
+    request.SetContentLength(part_bytes_);
+    request.SetBody(part_);
+    Aws::S3::Model::PutObjectOutcome outcome;
+    for (int retries = 0;; ++retries) {
+      part_->clear();
+      part_->seekg(0);
+      outcome = s3_client_->PutObject(request);
+      if (outcome.IsSuccess() || retries >= kUploadRetries) {
+        break;
+      }
+      VLOG(1) << "Retrying upload of s3://" << bucket_ << "/" << object_
+              << " after failure. Current retry count:" << retries + 1;
+    }
+    part_->clear();
+    if (!outcome.IsSuccess()) {
+      return CreateStatusFromAwsError(outcome.GetError());
+    }
+    return Status::OK();
+  }
+
+  Status CreateUpload() {
+    VLOG(1) << "CreateMultipartUpload: s3://" << bucket_ << "/" << object_;
+    Aws::S3::Model::CreateMultipartUploadRequest request;
+    request.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
+    request.SetContentType("application/octet-stream");
+    auto outcome = s3_client_->CreateMultipartUpload(request);
+    if (!outcome.IsSuccess()) {
+      return CreateStatusFromAwsError(outcome.GetError());
+    }
+    upload_id_ = outcome.GetResult().GetUploadId();
+    return Status::OK();
+  }
+
+  // Starts uploading the buffered part on the executor, creating the multipart
+  // upload first if needed. Blocks while kS3StreamingUploadPartsInFlight parts
+  // are being uploaded.
+  Status StartPartUpload() {
+    if (upload_id_.empty()) {
+      TF_RETURN_IF_ERROR(CreateUpload());
+    }
+    {
+      mutex_lock l(mu_);
+      while (parts_in_flight_ >= kS3StreamingUploadPartsInFlight) {
+        cond_var_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(status_);
+      ++parts_in_flight_;
+    }
+    std::shared_ptr<Aws::StringStream> body = std::move(part_);
+    const int64 part_size = part_bytes_;
+    part_ = NewPart();
+    part_bytes_ = 0;
+    const int part_number = ++num_parts_;
+    const bool submitted =
+        executor_->Submit([this, body, part_number, part_size] {
+          UploadPart(body, part_number, part_size);
+        });
+    if (!submitted) {
+      mutex_lock l(mu_);
+      --parts_in_flight_;
+      status_.Update(errors::Unavailable(
+          "Could not schedule the upload of part ", part_number, " of s3://",
+          bucket_, "/", object_));
+      return status_;
+    }
+    return Status::OK();
+  }
+
+  // Uploads a part with retries, and records its ETag or error.
+  void UploadPart(std::shared_ptr<Aws::StringStream> body, int part_number,
+                  int64 part_size) {
+    Aws::S3::Model::UploadPartRequest request;
+    request.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_)
+        .WithPartNumber(part_number);
+    request.SetContentLength(part_size);
+    request.SetBody(body);
+    Aws::S3::Model::UploadPartOutcome outcome;
+    for (int retries = 0;; ++retries) {
+      body->clear();
+      body->seekg(0);
+      outcome = s3_client_->UploadPart(request);
+      if (outcome.IsSuccess() || retries >= kUploadRetries) {
+        break;
+      }
+      VLOG(1) << "Retrying upload of part " << part_number << " of s3://"
+              << bucket_ << "/" << object_
+              << " after failure. Current retry count:" << retries + 1;
+    }
+    mutex_lock l(mu_);
+    if (outcome.IsSuccess()) {
+      etags_[part_number] = outcome.GetResult().GetETag();
+    } else {
+      status_.Update(CreateStatusFromAwsError(outcome.GetError()));
+    }
+    --parts_in_flight_;
+    cond_var_.notify_all();
+  }
+
+  void WaitForParts() {
+    mutex_lock l(mu_);
+    while (parts_in_flight_ > 0) {
+      cond_var_.wait(l);
+    }
+  }
+
+  Status CompleteUpload() {
+    WaitForParts();
+    Aws::S3::Model::CompletedMultipartUpload completed_upload;
+    {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(status_);
+      // Parts have to be added in order.
+      for (const auto& part : etags_) {
+        Aws::S3::Model::CompletedPart completed_part;
+        completed_part.SetPartNumber(part.first);
+        completed_part.SetETag(part.second);
+        completed_upload.AddParts(completed_part);
+      }
+    }
+    VLOG(1) << "CompleteMultipartUpload: s3://" << bucket_ << "/" << object_
+            << " with " << num_parts_ << " parts";
+    Aws::S3::Model::CompleteMultipartUploadRequest request;
+    request.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_);
+    request.SetMultipartUpload(completed_upload);
+    auto outcome = s3_client_->CompleteMultipartUpload(request);
+    if (!outcome.IsSuccess()) {
+      return CreateStatusFromAwsError(outcome.GetError());
+    }
+    return Status::OK();
+  }
+
+  Status AbortUpload() {
+    Aws::S3::Model::AbortMultipartUploadRequest request;
+    request.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_);
+    auto outcome = s3_client_->AbortMultipartUpload(request);
+    if (!outcome.IsSuccess()) {
+      return CreateStatusFromAwsError(outcome.GetError());
+    }
+    return Status::OK();
+  }
+
+  const string bucket_;
+  const string object_;
+  const uint64 part_size_;
+  std::shared_ptr<Aws::S3::S3Client> s3_client_;
+  std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> executor_;
+  // The part being written, and its size.
+  std::shared_ptr<Aws::StringStream> part_;
+  uint64 part_bytes_ = 0;
+  int64 position_ = 0;
+  bool sync_needed_ = true;
+  bool closed_ = false;
+  // Set once the first part is uploaded.
+  Aws::String upload_id_;
+  int num_parts_ = 0;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int parts_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  // The ETags of the uploaded parts, keyed by part number.
+  std::map<int, Aws::String> etags_ TF_GUARDED_BY(mu_);
+  // The first error of a part upload.
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
 class S3ReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  public:
   S3ReadOnlyMemoryRegion(std::unique_ptr<char[]> data, uint64 length)
@@ -486,6 +816,23 @@ S3FileSystem::S3FileSystem()
     }
   }
 
+  use_streaming_upload_ = true;
+  const char* disable_streaming_upload = getenv("S3_DISABLE_STREAMING_UPLOAD");
+  if (disable_streaming_upload) {
+    if (disable_streaming_upload[0] == '1') {
+      use_streaming_upload_ = false;
+    }
+  }
+
+  stat_cache_.reset(new ExpiringLRUCache<FileStatistics>(
+      GetEnvUint64(kS3StatCacheMaxAge, kS3StatCacheDefaultMaxAge),
+      GetEnvUint64(kS3StatCacheMaxEntries, kS3StatCacheDefaultMaxEntries)));
+  matching_paths_cache_.reset(new ExpiringLRUCache<std::vector<string>>(
+      GetEnvUint64(kS3MatchingPathsCacheMaxAge,
+                   kS3MatchingPathsCacheDefaultMaxAge),
+      GetEnvUint64(kS3MatchingPathsCacheMaxEntries,
+                   kS3MatchingPathsCacheDefaultMaxEntries)));
+
   auto upload_pair = std::pair<Aws::Transfer::TransferDirection,
                                std::shared_ptr<Aws::Transfer::TransferManager>>(
       Aws::Transfer::TransferDirection::UPLOAD,
@@ -585,7 +932,12 @@ Status S3FileSystem::NewRandomAccessFile(
       bucket, object, use_mpd,
       this->GetTransferManager(Aws::Transfer::TransferDirection::DOWNLOAD),
       this->GetS3Client()));
-  return Status::OK();
+  return SharedFileBlockCache::Get()->MaybeWrap(this, fname, result);
+}
+
+void S3FileSystem::ClearFileCaches(const string& fname) {
+  SharedFileBlockCache::Get()->RemoveFile(fname);
+  stat_cache_->Delete(fname);
 }
 
 Status S3FileSystem::NewWritableFile(const string& fname,
@@ -593,6 +945,20 @@ Status S3FileSystem::NewWritableFile(const string& fname,
                                      std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
+  ClearFileCaches(fname);
+  if (this->use_streaming_upload_) {
+    std::shared_ptr<Aws::S3::S3Client> s3_client = this->GetS3Client();
+    std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> executor;
+    {
+      std::lock_guard<mutex> lock(this->initialization_lock_);
+      executor = this->GetExecutor();
+    }
+    result->reset(new S3StreamingWritableFile(
+        bucket, object,
+        this->multi_part_chunk_size_[Aws::Transfer::TransferDirection::UPLOAD],
+        s3_client, executor));
+    return Status::OK();
+  }
   result->reset(new S3WritableFile(
       bucket, object,
       this->GetTransferManager(Aws::Transfer::TransferDirection::UPLOAD),
@@ -604,6 +970,7 @@ Status S3FileSystem::NewWritableFile(const string& fname,
 Status S3FileSystem::NewAppendableFile(const string& fname,
                                        TransactionToken* token,
                                        std::unique_ptr<WritableFile>* result) {
+  ClearFileCaches(fname);
   std::unique_ptr<RandomAccessFile> reader;
   TF_RETURN_IF_ERROR(NewRandomAccessFile(fname, token, &reader));
   std::unique_ptr<char[]> buffer(new char[kS3ReadAppendableFileBufferSize]);
@@ -712,6 +1079,9 @@ Status S3FileSystem::Stat(const string& fname, TransactionToken* token,
   VLOG(1) << "Stat on path: " << fname;
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, true, &bucket, &object));
+  if (stat_cache_->Lookup(fname, stats)) {
+    return Status::OK();
+  }
 
   if (object.empty()) {
     Aws::S3::Model::HeadBucketRequest headBucketRequest;
@@ -767,19 +1137,156 @@ Status S3FileSystem::Stat(const string& fname, TransactionToken* token,
   if (!found) {
     return errors::NotFound("Object ", fname, " does not exist");
   }
+  stat_cache_->Insert(fname, *stats);
   return Status::OK();
 }
 
 Status S3FileSystem::GetMatchingPaths(const string& pattern,
                                       TransactionToken* token,
                                       std::vector<string>* results) {
-  return internal::GetMatchingPaths(this, Env::Default(), pattern, results);
+  return matching_paths_cache_->LookupOrCompute(
+      pattern, results,
+      [this](const string& pattern, std::vector<string>* results) {
+        return MatchPaths(pattern, results);
+      });
+}
+
+Status S3FileSystem::MatchPaths(const string& pattern,
+                                std::vector<string>* results) {
+  results->clear();
+  string bucket, object_pattern;
+  TF_RETURN_IF_ERROR(ParseS3Path(pattern, true, &bucket, &object_pattern));
+  // Wildcards in the bucket name, escaped characters and patterns that only
+  // match directories are left to the generic implementation.
+  if (bucket.find_first_of("*?[\\") != string::npos ||
+      object_pattern.empty() || object_pattern.back() == '/' ||
+      object_pattern.find('\\') != string::npos) {
+    return internal::GetMatchingPaths(this, Env::Default(), pattern, results);
+  }
+  const std::vector<string> components =
+      absl::StrSplit(object_pattern, '/', absl::SkipEmpty());
+
+  // The key prefixes, ending in "/", of the directories matched so far.
+  std::vector<string> dirs = {""};
+  std::vector<string> keys;
+  for (size_t i = 0; i < components.size() && !dirs.empty(); ++i) {
+    const string& component = components[i];
+    const bool is_last = i + 1 == components.size();
+    const size_t wildcard = component.find_first_of("*?[");
+    if (wildcard == string::npos && !is_last) {
+      // The listing of the next component finds whether the directory exists.
+      for (string& dir : dirs) {
+        absl::StrAppend(&dir, component, "/");
+      }
+      continue;
+    }
+    // Only the keys starting with the fixed part of the component are listed.
+    const string fixed_prefix = component.substr(0, wildcard);
+    std::vector<std::vector<string>> child_dirs(dirs.size());
+    std::vector<std::vector<string>> child_files(dirs.size());
+    std::vector<Status> statuses(dirs.size());
+    auto list = [&](size_t j) {
+      statuses[j] =
+          ListPrefix(bucket, dirs[j], strings::StrCat(dirs[j], fixed_prefix),
+                     &child_dirs[j], &child_files[j]);
+    };
+    if (dirs.size() == 1) {
+      list(0);
+    } else {
+      thread::ThreadPool pool(
+          Env::Default(), "s3_get_matching_paths",
+          std::min(kS3GlobThreads, static_cast<int>(dirs.size())));
+      for (size_t j = 0; j < dirs.size(); ++j) {
+        pool.Schedule([&list, j] { list(j); });
+      }
+    }
+
+    std::vector<string> next_dirs;
+    for (size_t j = 0; j < dirs.size(); ++j) {
+      TF_RETURN_IF_ERROR(statuses[j]);
+      for (const string& name : child_dirs[j]) {
+        if (Match(name, component)) {
+          if (is_last) {
+            keys.push_back(strings::StrCat(dirs[j], name));
+          } else {
+            next_dirs.push_back(strings::StrCat(dirs[j], name, "/"));
+          }
+        }
+      }
+      if (!is_last) continue;
+      for (const string& name : child_files[j]) {
+        if (Match(name, component)) {
+          keys.push_back(strings::StrCat(dirs[j], name));
+        }
+      }
+    }
+    dirs = std::move(next_dirs);
+  }
+
+  // A key can be both an object and a common prefix.
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  results->reserve(keys.size());
+  for (const string& key : keys) {
+    results->push_back(strings::StrCat("s3://", bucket, "/", key));
+  }
+  return Status::OK();
+}
+
+Status S3FileSystem::ListPrefix(const string& bucket, const string& dir_prefix,
+                                const string& prefix,
+                                std::vector<string>* dirs,
+                                std::vector<string>* files) {
+  Aws::S3::Model::ListObjectsRequest listObjectsRequest;
+  listObjectsRequest.WithBucket(bucket.c_str())
+      .WithPrefix(prefix.c_str())
+      .WithMaxKeys(kS3GlobMaxKeys)
+      .WithDelimiter("/");
+  listObjectsRequest.SetResponseStreamFactory(
+      []() { return Aws::New<Aws::StringStream>(kS3FileSystemAllocationTag); });
+
+  Aws::S3::Model::ListObjectsResult listObjectsResult;
+  do {
+    auto listObjectsOutcome =
+        this->GetS3Client()->ListObjects(listObjectsRequest);
+    if (!listObjectsOutcome.IsSuccess()) {
+      return CreateStatusFromAwsError(listObjectsOutcome.GetError());
+    }
+
+    listObjectsResult = listObjectsOutcome.GetResult();
+    for (const auto& object : listObjectsResult.GetCommonPrefixes()) {
+      // Common prefixes end with the "/" delimiter.
+      const Aws::String& key = object.GetPrefix();
+      if (key.length() <= dir_prefix.length() + 1) continue;
+      dirs->emplace_back(key.c_str() + dir_prefix.length(),
+                         key.length() - dir_prefix.length() - 1);
+      stat_cache_->Insert(
+          strings::StrCat("s3://", bucket, "/",
+                          key.substr(0, key.length() - 1).c_str()),
+          FileStatistics(0, 0, true));
+    }
+    for (const auto& object : listObjectsResult.GetContents()) {
+      const Aws::String& key = object.GetKey();
+      // Skips the marker object of the directory itself.
+      if (key.length() <= dir_prefix.length()) continue;
+      files->emplace_back(key.c_str() + dir_prefix.length(),
+                          key.length() - dir_prefix.length());
+      stat_cache_->Insert(
+          strings::StrCat("s3://", bucket, "/", key.c_str()),
+          FileStatistics(object.GetSize(),
+                         object.GetLastModified().Millis() * 1e6, false));
+    }
+    listObjectsRequest.SetMarker(listObjectsResult.GetNextMarker());
+  } while (listObjectsResult.GetIsTruncated());
+
+  return Status::OK();
 }
 
 Status S3FileSystem::DeleteFile(const string& fname, TransactionToken* token) {
   VLOG(1) << "DeleteFile: " << fname;
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
+  ClearFileCaches(fname);
 
   Aws::S3::Model::DeleteObjectRequest deleteObjectRequest;
   deleteObjectRequest.WithBucket(bucket.c_str()).WithKey(object.c_str());
@@ -796,6 +1303,7 @@ Status S3FileSystem::CreateDir(const string& dirname, TransactionToken* token) {
   VLOG(1) << "CreateDir: " << dirname;
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(dirname, true, &bucket, &object));
+  ClearFileCaches(dirname);
 
   if (object.empty()) {
     Aws::S3::Model::HeadBucketRequest headBucketRequest;
@@ -823,6 +1331,7 @@ Status S3FileSystem::DeleteDir(const string& dirname, TransactionToken* token) {
   VLOG(1) << "DeleteDir: " << dirname;
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(dirname, false, &bucket, &object));
+  ClearFileCaches(dirname);
 
   string prefix = object;
   if (prefix.back() != '/') {
@@ -1137,6 +1646,8 @@ Status S3FileSystem::RenameFile(const string& src, const string& target,
   TF_RETURN_IF_ERROR(ParseS3Path(src, false, &src_bucket, &src_object));
   TF_RETURN_IF_ERROR(
       ParseS3Path(target, false, &target_bucket, &target_object));
+  ClearFileCaches(src);
+  ClearFileCaches(target);
   if (src_object.back() == '/') {
     if (target_object.back() != '/') {
       target_object.push_back('/');
@@ -1190,6 +1701,27 @@ Status S3FileSystem::RenameFile(const string& src, const string& target,
   return Status::OK();
 }
 
+Status S3FileSystem::CopyFile(const string& src, const string& target,
+                              TransactionToken* token) {
+  VLOG(1) << "CopyFile from: " << src << " to: " << target;
+  string src_bucket, src_object, target_bucket, target_object;
+  TF_RETURN_IF_ERROR(ParseS3Path(src, false, &src_bucket, &src_object));
+  TF_RETURN_IF_ERROR(
+      ParseS3Path(target, false, &target_bucket, &target_object));
+  // When `target` points to a directory, copy into a file within it.
+  string target_name = target;
+  if (IsDirectory(target, token).ok()) {
+    target_name = io::JoinPath(target, io::Basename(src));
+    TF_RETURN_IF_ERROR(
+        ParseS3Path(target_name, false, &target_bucket, &target_object));
+  }
+  ClearFileCaches(target_name);
+  return CopyFile(Aws::String(src_bucket.c_str()),
+                  Aws::String(src_object.c_str()),
+                  Aws::String(target_bucket.c_str()),
+                  Aws::String(target_object.c_str()));
+}
+
 Status S3FileSystem::HasAtomicMove(const string& path, bool* has_atomic_move) {
   *has_atomic_move = false;
   return Status::OK();
@@ -22,6 +22,7 @@ limitations under the License.
 #include <aws/s3/model/CompletedMultipartUpload.h>
 #include <aws/transfer/TransferManager.h>
 
+#include "tensorflow/core/platform/cloud/expiring_lru_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/retrying_file_system.h"
@@ -94,6 +95,10 @@ class S3FileSystem : public FileSystem {
 
   Status HasAtomicMove(const string& path, bool* has_atomic_move) override;
 
+  // Copies the object on the server, without transferring its data.
+  Status CopyFile(const string& src, const string& target,
+                  TransactionToken* token) override;
+
  private:
   // Returns the member S3 client, initializing as-needed.
   // When the client tries to access the object in S3, e.g.,
@@ -133,6 +138,22 @@ class S3FileSystem : public FileSystem {
                        const Aws::String& target_bucket,
                        const Aws::String& target_key, const int num_parts,
                        const uint64 file_length);
+  // Drops the cached blocks and statistics of `fname`, e.g. when it is
+  // overwritten.
+  void ClearFileCaches(const string& fname);
+
+  // Expands `pattern` one path component at a time, listing all the prefixes
+  // matched so far in parallel, with "/" as the delimiter.
+  Status MatchPaths(const string& pattern, std::vector<string>* results);
+
+  // Lists the objects and common prefixes of `bucket` whose keys start with
+  // `prefix`, up to the next "/". The names are returned relative to
+  // `dir_prefix`, which `prefix` starts with, and the statistics of the
+  // objects are added to the stat cache.
+  Status ListPrefix(const string& bucket, const string& dir_prefix,
+                    const string& prefix, std::vector<string>* dirs,
+                    std::vector<string>* files);
+
   Status AbortMultiPartCopy(Aws::String target_bucket, Aws::String target_key,
                             Aws::String uploadID);
   Status CompleteMultiPartCopy(
@@ -151,6 +172,17 @@ class S3FileSystem : public FileSystem {
   std::map<Aws::Transfer::TransferDirection, uint64> multi_part_chunk_size_;
 
   bool use_multi_part_download_;
+
+  // Whether writable files upload their parts while they are written.
+  bool use_streaming_upload_;
+
+  // The statistics of the objects seen by Stat and GetMatchingPaths. Nothing
+  // is cached by default, see S3_STAT_CACHE_MAX_AGE.
+  std::unique_ptr<ExpiringLRUCache<FileStatistics>> stat_cache_;
+
+  // The results of GetMatchingPaths. Nothing is cached by default, see
+  // S3_MATCHING_PATHS_CACHE_MAX_AGE.
+  std::unique_ptr<ExpiringLRUCache<std::vector<string>>> matching_paths_cache_;
 };
 
 /// S3 implementation of a file system with retry on failures.
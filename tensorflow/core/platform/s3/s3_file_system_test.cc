@@ -195,6 +195,32 @@ TEST_F(S3FileSystemTest, NewWritableFile) {
   EXPECT_EQ("content1,content2", content);
 }
 
+TEST_F(S3FileSystemTest, NewWritableFile_MultiPart) {
+  // Parts of the minimum size, so that the file is uploaded in three parts
+  // while it is written.
+  setenv("S3_MULTI_PART_UPLOAD_CHUNK_SIZE", "5242880", 1);
+  S3FileSystem s3fs_small_parts;
+  unsetenv("S3_MULTI_PART_UPLOAD_CHUNK_SIZE");
+
+  const string fname = TmpDir("WritableFile_MultiPart");
+  string want;
+  std::unique_ptr<WritableFile> writer;
+  TF_ASSERT_OK(s3fs_small_parts.NewWritableFile(fname, &writer));
+  for (int i = 0; i < 12; ++i) {
+    const string chunk(1024 * 1024, 'a' + i);
+    TF_ASSERT_OK(writer->Append(chunk));
+    want += chunk;
+  }
+  int64 position;
+  TF_EXPECT_OK(writer->Tell(&position));
+  EXPECT_EQ(want.size(), position);
+  TF_ASSERT_OK(writer->Close());
+
+  string content;
+  TF_EXPECT_OK(ReadAll(fname, &content));
+  EXPECT_EQ(want, content);
+}
+
 TEST_F(S3FileSystemTest, NewAppendableFile) {
   std::unique_ptr<WritableFile> writer;
 
@@ -246,6 +272,38 @@ TEST_F(S3FileSystemTest, GetChildren) {
   EXPECT_EQ(std::vector<string>({"SubDir", "TestFile.csv"}), children);
 }
 
+TEST_F(S3FileSystemTest, GetMatchingPaths) {
+  const string base = TmpDir("GetMatchingPaths");
+  TF_ASSERT_OK(WriteString(io::JoinPath(base, "a/part-0.csv"), "test"));
+  TF_ASSERT_OK(WriteString(io::JoinPath(base, "a/part-1.csv"), "test"));
+  TF_ASSERT_OK(WriteString(io::JoinPath(base, "a/other.csv"), "test"));
+  TF_ASSERT_OK(WriteString(io::JoinPath(base, "b/part-0.csv"), "test"));
+  TF_ASSERT_OK(WriteString(io::JoinPath(base, "b/c/part-0.csv"), "test"));
+
+  std::vector<string> results;
+  TF_EXPECT_OK(
+      s3fs.GetMatchingPaths(io::JoinPath(base, "*/part-*"), nullptr, &results));
+  EXPECT_EQ(std::vector<string>({io::JoinPath(base, "a/part-0.csv"),
+                                 io::JoinPath(base, "a/part-1.csv"),
+                                 io::JoinPath(base, "b/part-0.csv")}),
+            results);
+
+  TF_EXPECT_OK(
+      s3fs.GetMatchingPaths(io::JoinPath(base, "b/*"), nullptr, &results));
+  EXPECT_EQ(std::vector<string>({io::JoinPath(base, "b/c"),
+                                 io::JoinPath(base, "b/part-0.csv")}),
+            results);
+
+  TF_EXPECT_OK(s3fs.GetMatchingPaths(io::JoinPath(base, "a/part-1.csv"),
+                                     nullptr, &results));
+  EXPECT_EQ(std::vector<string>({io::JoinPath(base, "a/part-1.csv")}),
+            results);
+
+  TF_EXPECT_OK(
+      s3fs.GetMatchingPaths(io::JoinPath(base, "d/*"), nullptr, &results));
+  EXPECT_TRUE(results.empty());
+}
+
 TEST_F(S3FileSystemTest, DeleteFile) {
   const string fname = TmpDir("DeleteFile");
   TF_ASSERT_OK(WriteString(fname, "test"));
@@ -17,10 +17,13 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <atomic>
+
 #include "absl/types/optional.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -31,6 +34,11 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+struct ThreadPoolStatsCounters {
+  std::atomic<int64> num_tasks{0};
+  std::atomic<int64> busy_micros{0};
+};
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
@@ -45,18 +53,37 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  const std::shared_ptr<ThreadPoolStatsCounters> stats_;
+  // The number of threads created so far. The pool creates its threads one
+  // after the other when it is constructed.
+  int num_threads_created_ = 0;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name,
+                   std::shared_ptr<ThreadPoolStatsCounters> stats)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        stats_(std::move(stats)) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
+    int cpu = -1;
+    if (!thread_options_.cpu_list.empty()) {
+      cpu = thread_options_.cpu_list[num_threads_created_ %
+                                     thread_options_.cpu_list.size()];
+    }
+    ++num_threads_created_;
     return env_->StartThread(thread_options_, name_, [=]() {
       // Set the processor flag to flush denormals to zero.
       port::ScopedFlushDenormal flush;
       // Set the processor rounding mode to ROUND TO NEAREST.
       port::ScopedSetRound round(FE_TONEAREST);
-      if (thread_options_.numa_node != port::kNUMANoAffinity) {
+      if (cpu >= 0) {
+        if (!port::SetCurrentThreadCPUAffinity(cpu)) {
+          LOG(WARNING) << "Could not pin a thread of " << name_ << " to CPU "
+                       << cpu;
+        }
+      } else if (thread_options_.numa_node != port::kNUMANoAffinity) {
         port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
       }
       f();
@@ -82,7 +109,11 @@ struct EigenEnvironment {
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
                                  t.f->trace_id);
+    const uint64 start_micros = env_->NowMicros();
     t.f->f();
+    stats_->busy_micros.fetch_add(env_->NowMicros() - start_micros,
+                                  std::memory_order_relaxed);
+    stats_->num_tasks.fetch_add(1, std::memory_order_relaxed);
   }
 };
 
@@ -95,17 +126,19 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
 
 ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
                        const string& name, int num_threads,
-                       bool low_latency_hint, Eigen::Allocator* allocator) {
+                       bool low_latency_hint, Eigen::Allocator* allocator)
+    : name_(name), stats_(std::make_shared<ThreadPoolStatsCounters>()) {
   CHECK_GE(num_threads, 1);
   eigen_threadpool_.reset(new Eigen::ThreadPoolTempl<EigenEnvironment>(
       num_threads, low_latency_hint,
-      EigenEnvironment(env, thread_options, "tf_" + name)));
+      EigenEnvironment(env, thread_options, "tf_" + name, stats_)));
   underlying_threadpool_ = eigen_threadpool_.get();
   threadpool_device_.reset(new Eigen::ThreadPoolDevice(underlying_threadpool_,
                                                        num_threads, allocator));
 }
 
-ThreadPool::ThreadPool(thread::ThreadPoolInterface* user_threadpool) {
+ThreadPool::ThreadPool(thread::ThreadPoolInterface* user_threadpool)
+    : stats_(std::make_shared<ThreadPoolStatsCounters>()) {
   underlying_threadpool_ = user_threadpool;
   threadpool_device_.reset(new Eigen::ThreadPoolDevice(
       underlying_threadpool_, underlying_threadpool_->NumThreads(), nullptr));
@@ -248,6 +281,13 @@ int ThreadPool::CurrentThreadId() const {
   return underlying_threadpool_->CurrentThreadId();
 }
 
+ThreadPool::Stats ThreadPool::GetStats() const {
+  Stats stats;
+  stats.num_tasks = stats_->num_tasks.load(std::memory_order_relaxed);
+  stats.busy_micros = stats_->busy_micros.load(std::memory_order_relaxed);
+  return stats;
+}
+
 void ThreadPool::ScheduleWithHint(std::function<void()> fn, int start,
                                   int limit) {
   underlying_threadpool_->ScheduleWithHint(std::move(fn), start, limit);
@@ -38,6 +38,7 @@ namespace tensorflow {
 namespace thread {
 
 struct EigenEnvironment;
+struct ThreadPoolStatsCounters;
 
 class ThreadPool {
  public:
@@ -210,6 +211,22 @@ class ThreadPool {
   // thread in the pool. Returns -1 otherwise.
   int CurrentThreadId() const;
 
+  // The utilization of the pool since it was created.
+  struct Stats {
+    // The number of closures run by the threads of the pool.
+    int64 num_tasks = 0;
+    // The time the threads of the pool spent running closures.
+    int64 busy_micros = 0;
+  };
+
+  // Returns the utilization of the pool. Only tracked for pools that create
+  // their own threads; pools wrapping a user_threadpool return zeros.
+  Stats GetStats() const;
+
+  // Returns the name the pool was constructed with, or an empty string for
+  // pools wrapping a user_threadpool.
+  const std::string& name() const { return name_; }
+
   // If ThreadPool implementation is compatible with Eigen::ThreadPoolInterface,
   // returns a non-null pointer. The caller does not own the object the returned
   // pointer points to, and should not attempt to delete.
@@ -227,6 +244,10 @@ class ThreadPool {
       const int64 total, const int64 block_size,
       const std::function<void(int64, int64)>& fn);
 
+  std::string name_;
+  // Shared with the threads of eigen_threadpool_, which update it.
+  std::shared_ptr<ThreadPoolStatsCounters> stats_;
+
   // underlying_threadpool_ is the user_threadpool if user_threadpool is
   // provided in the constructor. Otherwise it is the eigen_threadpool_.
   Eigen::ThreadPoolInterface* underlying_threadpool_;
@@ -99,6 +99,12 @@ int GetCurrentCPU() {
   return GetCurrentProcessorNumber();
 }
 
+bool SetCurrentThreadCPUAffinity(int cpu) {
+  // Like GetCurrentCPU, only handles the current processor group.
+  if (cpu < 0 || cpu >= 64) return false;
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu) != 0;
+}
+
 bool NUMAEnabled() {
   // Not yet implemented: coming soon.
   return false;
@@ -116,6 +122,17 @@ void* AlignedMalloc(size_t size, int minimum_alignment) {
 
 void AlignedFree(void* aligned_memory) { _aligned_free(aligned_memory); }
 
+void* HugePageMalloc(size_t size, size_t page_size) {
+  // Large pages need the SeLockMemoryPrivilege, so normal pages are used.
+  return AlignedMalloc(size, static_cast<int>(page_size));
+}
+
+void HugePageFree(void* ptr, size_t size, size_t page_size) {
+  AlignedFree(ptr);
+}
+
+bool AdviseHugePages(void* ptr, size_t size) { return false; }
+
 void* Malloc(size_t size) { return malloc(size); }
 
 void* Realloc(void* ptr, size_t size) { return realloc(ptr, size); }
@@ -69,6 +69,9 @@ void CombineOpMetrics(const OpMetrics& src, OpMetrics* dst) {
   dst->set_self_time_ps(src.self_time_ps() + dst->self_time_ps());
   dst->set_flops(src.flops() + dst->flops());
   dst->set_bytes_accessed(src.bytes_accessed() + dst->bytes_accessed());
+  dst->set_cpu_cycles(src.cpu_cycles() + dst->cpu_cycles());
+  dst->set_instructions(src.instructions() + dst->instructions());
+  dst->set_llc_misses(src.llc_misses() + dst->llc_misses());
   CombineMemoryAccessedBreakdown(src.memory_accessed_breakdown(),
                                  dst->mutable_memory_accessed_breakdown());
   dst->set_dma_stall_ps(src.dma_stall_ps() + dst->dma_stall_ps());
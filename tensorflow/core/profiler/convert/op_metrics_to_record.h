@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PROFILER_CONVERT_OP_METRICS_TO_RECORD_H_
 #define TENSORFLOW_CORE_PROFILER_CONVERT_OP_METRICS_TO_RECORD_H_
 
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
@@ -99,6 +100,30 @@ inline void SetRooflineMetrics(const OpMetrics& metrics,
                            : ((metrics.flops() != 0) ? "Compute" : "Unknown"));
 }
 
+// Must be called after SetRooflineMetrics.
+template <typename Record>
+inline void SetRooflineEfficiency(const OpMetrics& metrics,
+                                  double peak_gigaflops_per_second,
+                                  double peak_gigabytes_per_second,
+                                  Record* record) {
+  double efficiency = 0.0;
+  if (metrics.flops() != 0) {
+    double attainable_gigaflops_per_second = peak_gigaflops_per_second;
+    if (metrics.bytes_accessed() != 0) {
+      attainable_gigaflops_per_second =
+          std::min(attainable_gigaflops_per_second,
+                   peak_gigabytes_per_second * record->operational_intensity());
+    }
+    efficiency = SafeDivide(record->measured_flop_rate(),
+                            attainable_gigaflops_per_second);
+  } else if (metrics.bytes_accessed() != 0) {
+    efficiency =
+        SafeDivide(record->measured_memory_bw(), peak_gigabytes_per_second);
+  }
+  // The costs are estimates, so the efficiency may exceed the roofline.
+  record->set_roofline_efficiency(std::min(efficiency, 1.0));
+}
+
 }  // namespace profiler
 }  // namespace tensorflow
 
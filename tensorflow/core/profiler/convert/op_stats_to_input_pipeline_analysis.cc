@@ -565,6 +565,15 @@ InputPipelineAnalysisResult ConvertOpStatsToInputPipelineAnalysis(
   GenerateHostResult(op_stats.host_op_metrics_db(), &result);
 
   InputPipelineAnalysisRecommendation recommendation = GenerateRecommendation();
+  if (op_stats.tf_data_stats().has_bottleneck()) {
+    // The concrete suggestion for the bottleneck transformation comes first.
+    InputPipelineAnalysisRecommendation tf_data_recommendation;
+    *tf_data_recommendation.add_details() = absl::StrCat(
+        "tf.data bottleneck: ",
+        op_stats.tf_data_stats().bottleneck().suggestion());
+    tf_data_recommendation.MergeFrom(recommendation);
+    recommendation.Swap(&tf_data_recommendation);
+  }
   BottleneckAnalysis bottleneck_analysis = ComputeBottleneckAnalysis(
       result.input_time_breakdown(), result.step_details());
   result.set_input_percent(bottleneck_analysis.input_percent());
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/convert/op_stats_to_tf_stats.h"
 
+#include <vector>
+
+#include "absl/algorithm/container.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/convert/op_metrics_to_record.h"
 #include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
@@ -33,23 +36,29 @@ namespace {
 // 500 device side ops and 500 host side ops.
 const int kMaxNumOfOps = 500;
 
-TfStatsRecord ConvertOpMetricsToTfStatsRecord(
-    bool on_device, const OpMetrics& metrics,
-    double ridge_point_operational_intensity) {
+TfStatsRecord ConvertOpMetricsToTfStatsRecord(bool on_device,
+                                              const OpMetrics& metrics,
+                                              const PerfEnv& perf_env) {
   TfStatsRecord record;
   record.set_host_or_device(on_device ? "Device" : "Host");
   record.set_is_eager(metrics.is_eager());
   record.set_op_type(metrics.category());
   record.set_op_name(metrics.name());
   SetExecutionTimes(metrics, &record);
-  SetRooflineMetrics(metrics, ridge_point_operational_intensity, &record);
+  SetRooflineMetrics(metrics, perf_env.ridge_point(), &record);
+  // The peaks are those of the device.
+  if (on_device) {
+    SetRooflineEfficiency(metrics, perf_env.peak_tera_flops_per_second() * 1000,
+                          perf_env.peak_hbm_bw_giga_bytes_per_second(),
+                          &record);
+  }
   return record;
 }
 
 TfStatsTable GenerateTfStatsTable(
     const OpMetricsDb& host_tf_metrics_db,
     const OpMetricsDb& device_tf_metrics_db,
-    const KernelStatsByOpName& kernel_stats_by_op_name, double ridge_point,
+    const KernelStatsByOpName& kernel_stats_by_op_name, const PerfEnv& perf_env,
     bool exclude_idle) {
   TfStatsTable tf_stats_table;
   TfStatsRecord sentinel;
@@ -69,7 +78,7 @@ TfStatsTable GenerateTfStatsTable(
     if (exclude_idle && IsIdleOp(*metrics)) continue;
     TfStatsRecord* record = tf_stats_table.add_tf_stats_record();
     *record = ConvertOpMetricsToTfStatsRecord(
-        /*on_device=*/true, *metrics, ridge_point);
+        /*on_device=*/true, *metrics, perf_env);
     // Compute TensorCore utilization only on device side.
     auto iter = kernel_stats_by_op_name.find(record->op_name());
     if (iter != kernel_stats_by_op_name.end()) {
@@ -94,7 +103,7 @@ TfStatsTable GenerateTfStatsTable(
     if (exclude_idle && IsIdleOp(*metrics)) continue;
     TfStatsRecord* record = tf_stats_table.add_tf_stats_record();
     *record = ConvertOpMetricsToTfStatsRecord(
-        /*on_device=*/false, *metrics, ridge_point);
+        /*on_device=*/false, *metrics, perf_env);
     // Host side TensorCore utilization is always 0.0
     record->set_gpu_tensorcore_utilization(0.0);
     SetRankAndHostTimeFractions(total_host_time_us, *prev_record, record);
@@ -109,19 +118,37 @@ TfStatsDatabase ConvertOpStatsToTfStats(const OpStats& op_stats) {
   const OpMetricsDb& host_tf_metrics_db = op_stats.host_op_metrics_db();
   OpMetricsDb device_tf_metrics_db =
       CreateTfMetricsDbFromDeviceOpMetricsDb(op_stats.device_op_metrics_db());
-  double ridge_point = op_stats.perf_env().ridge_point();
   KernelStatsByOpName kernel_stats_by_op_name =
       GroupKernelReportsByOpName(op_stats.kernel_stats_db());
   TfStatsDatabase tf_stats_db;
   *tf_stats_db.mutable_with_idle() = GenerateTfStatsTable(
       host_tf_metrics_db, device_tf_metrics_db, kernel_stats_by_op_name,
-      ridge_point, /*exclude_idle=*/false);
+      op_stats.perf_env(), /*exclude_idle=*/false);
   *tf_stats_db.mutable_without_idle() = GenerateTfStatsTable(
       host_tf_metrics_db, device_tf_metrics_db, kernel_stats_by_op_name,
-      ridge_point, /*exclude_idle=*/true);
+      op_stats.perf_env(), /*exclude_idle=*/true);
   tf_stats_db.set_device_type(op_stats.run_environment().device_type());
   return tf_stats_db;
 }
 
+std::vector<const TfStatsRecord*> RankDeviceOpsByRooflineGap(
+    const TfStatsTable& tf_stats_table) {
+  std::vector<const TfStatsRecord*> result;
+  for (const TfStatsRecord& record : tf_stats_table.tf_stats_record()) {
+    if (record.host_or_device() != "Device") continue;
+    if (record.roofline_efficiency() <= 0) continue;
+    result.push_back(&record);
+  }
+  auto gap_us = [](const TfStatsRecord* record) {
+    return record->total_self_time_in_us() *
+           (1.0 - record->roofline_efficiency());
+  };
+  absl::c_stable_sort(result, [&gap_us](const TfStatsRecord* a,
+                                        const TfStatsRecord* b) {
+    return gap_us(a) > gap_us(b);
+  });
+  return result;
+}
+
 }  // namespace profiler
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PROFILER_CONVERT_OP_STATS_TO_TF_STATS_H_
 #define TENSORFLOW_CORE_PROFILER_CONVERT_OP_STATS_TO_TF_STATS_H_
 
+#include <vector>
+
 #include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/tf_stats.pb.h"
 
@@ -24,6 +26,12 @@ namespace profiler {
 
 TfStatsDatabase ConvertOpStatsToTfStats(const OpStats& op_stats);
 
+// Returns the device TF-ops of the table ranked by the time they would save if
+// they reached their roofline, i.e. their self time times one minus their
+// roofline efficiency. Ops whose efficiency is unknown are left out.
+std::vector<const TfStatsRecord*> RankDeviceOpsByRooflineGap(
+    const TfStatsTable& tf_stats_table);
+
 }  // namespace profiler
 }  // namespace tensorflow
 
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/convert/op_stats_to_tf_stats.h"
 
+#include <string>
+#include <vector>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/test.h"
@@ -161,6 +164,31 @@ block_z:1)MULTI";
             record_2.total_self_time_in_us());
 }
 
+TEST(OpStatsToTfStats, RankDeviceOpsByRooflineGap) {
+  TfStatsTable table;
+  auto add_record = [&table](absl::string_view op_name,
+                             absl::string_view host_or_device,
+                             double self_time_in_us, double efficiency) {
+    TfStatsRecord* record = table.add_tf_stats_record();
+    record->set_op_name(std::string(op_name));
+    record->set_host_or_device(std::string(host_or_device));
+    record->set_total_self_time_in_us(self_time_in_us);
+    record->set_roofline_efficiency(efficiency);
+  };
+  // Gaps of 10us, 40us and 30us.
+  add_record("Fast", "Device", 100, 0.9);
+  add_record("Slow", "Device", 50, 0.2);
+  add_record("Medium", "Device", 60, 0.5);
+  add_record("Unknown", "Device", 1000, 0.0);
+  add_record("Host", "Host", 1000, 0.1);
+
+  std::vector<const TfStatsRecord*> ranked = RankDeviceOpsByRooflineGap(table);
+  ASSERT_EQ(3, ranked.size());
+  EXPECT_EQ("Slow", ranked[0]->op_name());
+  EXPECT_EQ("Medium", ranked[1]->op_name());
+  EXPECT_EQ("Fast", ranked[2]->op_name());
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/protobuf/kernel_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/cost_utils.h"
 #include "tensorflow/core/profiler/utils/kernel_stats_utils.h"
 #include "tensorflow/core/profiler/utils/tf_op_utils.h"
 #include "tensorflow/core/profiler/utils/tf_xplane_visitor.h"
@@ -39,6 +40,7 @@ void ConvertDeviceTraceXPlaneToKernelReports(
     const std::function<void(const XEventVisitor&, KernelReport*)>&
         on_kernel_fn,
     KernelReportMap* reports) {
+  TfOpRoofLineCostEstimator op_level_cost_estimator;
   XPlaneVisitor plane = CreateTfXPlaneVisitor(&device_trace);
   plane.ForEachLine([&](const XLineVisitor& line) {
     if (IsDerivedThreadId(line.Id())) {
@@ -47,6 +49,7 @@ void ConvertDeviceTraceXPlaneToKernelReports(
     line.ForEachEvent([&](const XEventVisitor& event) {
       absl::string_view tf_op_fullname;
       KernelReport kernel;
+      TfOpRoofLineCostEstimator::OpRoofLineStats costs;
 
       absl::string_view equation;
       event.ForEachStat([&](const tensorflow::profiler::XStatVisitor& stat) {
@@ -85,6 +88,9 @@ void ConvertDeviceTraceXPlaneToKernelReports(
           }
 
           kernel.set_is_op_tensor_core_eligible(tensor_core_eligible);
+          if (tf_op.category != Category::kUnknown) {
+            costs = op_level_cost_estimator.Predict(event);
+          }
         }
       }
 
@@ -98,6 +104,8 @@ void ConvertDeviceTraceXPlaneToKernelReports(
         value.min_duration_ns = event.DurationNs();
         value.max_duration_ns = event.DurationNs();
         value.occurrences = 1;
+        value.flops = costs.flops;
+        value.bytes_accessed = costs.bytes_accessed;
         InsertOrUpdateKernelReport(kernel, value, reports);
       }
     });
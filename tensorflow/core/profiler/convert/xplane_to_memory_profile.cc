@@ -47,6 +47,9 @@ namespace {
 
 constexpr int64 kInvalidStepId = -1;
 
+// Number of TF Ops listed in top_producers_at_peak.
+constexpr int kMaxNumTopProducers = 20;
+
 // Index of the time-sorted memory_profile_snapshots list, and the
 // MemoryActivityMetadata proto it contains.
 using IndexMetaPair = std::pair<int64 /*index*/, const MemoryActivityMetadata*>;
@@ -59,6 +62,7 @@ struct AggregationStats {
   int64 bytes_available = 0;
   double fragmentation = 0;
   int64 peak_bytes_in_use = 0;
+  int64 largest_free_block_bytes = 0;
 };
 
 // Metadata associated with each memory allocation/deallocation activity.
@@ -89,6 +93,7 @@ void FillAggregationStats(const AggregationStats& src,
   dst->set_free_memory_bytes(src.bytes_available);
   dst->set_fragmentation(src.fragmentation);
   dst->set_peak_bytes_in_use(src.peak_bytes_in_use);
+  dst->set_largest_free_block_bytes(src.largest_free_block_bytes);
 }
 
 void FillActivityMetadata(int64 event_type, const ActivityMetadata& src,
@@ -124,6 +129,7 @@ void UpdateProfileSummary(const AggregationStats& stats, int64 time_offset_ps,
     peak_stats->set_heap_allocated_bytes(stats.bytes_allocated);
     peak_stats->set_free_memory_bytes(stats.bytes_available);
     peak_stats->set_fragmentation(stats.fragmentation);
+    peak_stats->set_largest_free_block_bytes(stats.largest_free_block_bytes);
     summary->set_peak_stats_time_ps(time_offset_ps);
     summary->set_memory_capacity(stats.bytes_reserved + stats.bytes_allocated +
                                  stats.bytes_available);
@@ -173,6 +179,9 @@ MemoryProfile GenerateMemoryProfile(const XPlane* host_trace) {
           case StatType::kPeakBytesInUse:
             stats.peak_bytes_in_use = stat.IntValue();
             break;
+          case StatType::kLargestFreeBlockBytes:
+            stats.largest_free_block_bytes = stat.IntValue();
+            break;
           case StatType::kRequestedBytes:
             metadata.requested_bytes = stat.IntValue();
             break;
@@ -351,6 +360,36 @@ bool operator==(const IndexMetaPair& a, const IndexMetaPair& b) {
          a_meta->tensor_shape() == b_meta->tensor_shape();
 }
 
+// Fill top_producers_at_peak with the TF Ops holding the most memory among the
+// active allocations at peak.
+void ProcessTopProducers(const std::vector<IndexMetaPair>& active_allocs,
+                         PerAllocatorMemoryProfile* memory_profile) {
+  absl::flat_hash_map<absl::string_view, AllocationProducer> producers;
+  for (const auto& index_and_meta : active_allocs) {
+    const MemoryActivityMetadata* metadata = index_and_meta.second;
+    AllocationProducer& producer = producers[metadata->tf_op_name()];
+    producer.set_live_bytes(producer.live_bytes() +
+                            metadata->allocation_bytes());
+    producer.set_num_allocations(producer.num_allocations() + 1);
+  }
+  std::vector<std::pair<absl::string_view, AllocationProducer>> sorted(
+      producers.begin(), producers.end());
+  const int num_top_producers =
+      std::min<int>(kMaxNumTopProducers, sorted.size());
+  absl::c_partial_sort(
+      sorted, sorted.begin() + num_top_producers,
+      [](const std::pair<absl::string_view, AllocationProducer>& a,
+         const std::pair<absl::string_view, AllocationProducer>& b) {
+        return std::make_tuple(-a.second.live_bytes(), a.first) <
+               std::make_tuple(-b.second.live_bytes(), b.first);
+      });
+  for (int i = 0; i < num_top_producers; ++i) {
+    AllocationProducer* producer = memory_profile->add_top_producers_at_peak();
+    *producer = std::move(sorted[i].second);
+    producer->set_tf_op_name(std::string(sorted[i].first));
+  }
+}
+
 // Generate the memory breakdown table of active allocations at the peak usage
 // (within profiling window) and fill each ActiveAllocation proto (i.e. a row).
 void ProcessActiveAllocations(int64 peak_bytes_profile_step_id,
@@ -401,6 +440,7 @@ void ProcessActiveAllocations(int64 peak_bytes_profile_step_id,
   InsertSpecialAllocations(unmapped_allocation_bytes,
                            peak_bytes_profile_step_id, memory_profile,
                            &active_allocs);
+  ProcessTopProducers(active_allocs, memory_profile);
 
   std::sort(active_allocs.begin(), active_allocs.end(), MetadataComparator());
 
@@ -75,6 +75,7 @@ TEST(ConvertXPlaneToMemoryProfile, OneAllocatorMultiActivitiesTest) {
                 {StatType::kBytesAllocated, int64{5000}},
                 {StatType::kBytesAvailable, int64{3000}},
                 {StatType::kPeakBytesInUse, int64{9500}},
+                {StatType::kLargestFreeBlockBytes, int64{1000}},
                 {StatType::kRequestedBytes, int64{300}},
                 {StatType::kAllocationBytes, int64{300}},
                 {StatType::kAddress, int64{345678}},
@@ -103,6 +104,10 @@ TEST(ConvertXPlaneToMemoryProfile, OneAllocatorMultiActivitiesTest) {
             7000);
   EXPECT_EQ(allocator_memory_profile.profile_summary().peak_stats_time_ps(),
             70000);
+  EXPECT_EQ(allocator_memory_profile.profile_summary()
+                .peak_stats()
+                .largest_free_block_bytes(),
+            1000);
   EXPECT_EQ(allocator_memory_profile.memory_profile_snapshots_size(), 3);
   EXPECT_EQ(allocator_memory_profile.active_allocations_size(), 3);
   EXPECT_EQ(
@@ -113,6 +118,19 @@ TEST(ConvertXPlaneToMemoryProfile, OneAllocatorMultiActivitiesTest) {
   EXPECT_EQ(
       allocator_memory_profile.special_allocations().at(1).allocation_bytes(),
       2000);
+  ASSERT_EQ(allocator_memory_profile.top_producers_at_peak_size(), 3);
+  EXPECT_EQ(allocator_memory_profile.top_producers_at_peak(0).tf_op_name(),
+            "preallocated/unknown");
+  EXPECT_EQ(allocator_memory_profile.top_producers_at_peak(0).live_bytes(),
+            4700);
+  EXPECT_EQ(allocator_memory_profile.top_producers_at_peak(1).tf_op_name(),
+            "stack");
+  EXPECT_EQ(allocator_memory_profile.top_producers_at_peak(2).tf_op_name(),
+            "mul_grad/Sum");
+  EXPECT_EQ(allocator_memory_profile.top_producers_at_peak(2).live_bytes(),
+            300);
+  EXPECT_EQ(
+      allocator_memory_profile.top_producers_at_peak(2).num_allocations(), 1);
 }
 
 }  // namespace
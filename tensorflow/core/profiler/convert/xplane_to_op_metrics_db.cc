@@ -60,6 +60,10 @@ struct TfActivity {
   TfOp tf_op;
   // Whether it is eagerly executed.
   bool is_eager;
+  // Hardware counters of the Op, only set on kTfOpEnd.
+  uint64 cpu_cycles = 0;
+  uint64 instructions = 0;
+  uint64 llc_misses = 0;
 };
 
 // TF Op metrics stored as element in OpStack.
@@ -97,6 +101,11 @@ void ProcessOneTfActivity(const TfActivity& activity,
       tf_metrics_data->tf_metrics_db_builder.EnterOp(
           activity.tf_op.name, activity.tf_op.type, activity.is_eager,
           tf_op_span.duration_ps(), info->children_duration_ps);
+      if (activity.cpu_cycles > 0) {
+        tf_metrics_data->tf_metrics_db_builder.AddHardwareCounters(
+            activity.tf_op.name, activity.cpu_cycles, activity.instructions,
+            activity.llc_misses);
+      }
       TfOpInfo* parent_info = tf_op_stack->Top();
       if (parent_info != nullptr) {
         parent_info->children_duration_ps += tf_op_span.duration_ps();
@@ -155,8 +164,20 @@ void CollectTfActivities(const XLineVisitor& line,
       Timespan span(event.TimestampPs(), event.DurationPs());
       tf_activities->push_back(
           {span.begin_ps(), tf_op_id, kTfOpBegin, *tf_op, is_eager});
-      tf_activities->push_back(
-          {span.end_ps(), tf_op_id, kTfOpEnd, *tf_op, is_eager});
+      TfActivity end = {span.end_ps(), tf_op_id, kTfOpEnd, *tf_op, is_eager};
+      if (absl::optional<XStatVisitor> stat =
+              event.GetStat(StatType::kCpuCycles)) {
+        end.cpu_cycles = stat->IntOrUintValue();
+      }
+      if (absl::optional<XStatVisitor> stat =
+              event.GetStat(StatType::kInstructions)) {
+        end.instructions = stat->IntOrUintValue();
+      }
+      if (absl::optional<XStatVisitor> stat =
+              event.GetStat(StatType::kLlcMisses)) {
+        end.llc_misses = stat->IntOrUintValue();
+      }
+      tf_activities->push_back(end);
     }
   });
 }
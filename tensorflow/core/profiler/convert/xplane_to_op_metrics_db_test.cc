@@ -96,6 +96,38 @@ TEST(ConvertXPlaneToOpMetricsDb, HostOpMetricsDb) {
   EXPECT_EQ(NanosToPicos(kTfOp2DurationNs), op_2.time_ps());
 }
 
+TEST(ConvertXPlaneToOpMetricsDb, HostOpHardwareCounters) {
+  static constexpr char kTfOp[] = "TfOp";
+  XSpace xspace;
+  XPlane* xplane = GetOrCreateHostXPlane(&xspace);
+  XPlaneBuilder host_plane(xplane);
+  XLineBuilder thread = host_plane.GetOrCreateLine(/*line_id=*/10);
+  for (int64 start_ns : {100000, 110000}) {
+    XEventBuilder event = thread.AddEvent(
+        *host_plane.GetOrCreateEventMetadata(absl::StrCat(kTfOp, ":", kTfOp)));
+    event.SetTimestampNs(start_ns);
+    event.SetDurationNs(8000);
+    event.AddStatValue(*host_plane.GetOrCreateStatMetadata(
+                           GetStatTypeStr(StatType::kCpuCycles)),
+                       1000);
+    event.AddStatValue(*host_plane.GetOrCreateStatMetadata(
+                           GetStatTypeStr(StatType::kInstructions)),
+                       2000);
+    event.AddStatValue(*host_plane.GetOrCreateStatMetadata(
+                           GetStatTypeStr(StatType::kLlcMisses)),
+                       10);
+  }
+
+  OpMetricsDb op_metrics = ConvertHostThreadsXPlaneToOpMetricsDb(*xplane);
+  const OpMetrics& op = op_metrics.metrics_db().at(0);
+  EXPECT_EQ(kTfOp, op.name());
+  EXPECT_EQ(2000, op.cpu_cycles());
+  EXPECT_EQ(4000, op.instructions());
+  EXPECT_EQ(20, op.llc_misses());
+  EXPECT_DOUBLE_EQ(2.0, InstructionsPerCycle(op));
+  EXPECT_DOUBLE_EQ(5.0, LlcMissesPerKiloInstructions(op));
+}
+
 TEST(ConvertXPlaneToOpMetricsDb, DeviceOpMetricsDb) {
   // TfOp1 has kernel1 and kernel2; TfOp2 has kernel3.
   static constexpr char kTfOp1[] = "TfOp1";
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/convert/xplane_to_kernel_stats_db.h"
 #include "tensorflow/core/profiler/convert/xplane_to_op_metrics_db.h"
 #include "tensorflow/core/profiler/convert/xplane_to_step_events.h"
+#include "tensorflow/core/profiler/convert/xplane_to_tf_data_stats.h"
 #include "tensorflow/core/profiler/convert/xplane_to_tf_functions.h"
 #include "tensorflow/core/profiler/protobuf/diagnostics.pb.h"
 #include "tensorflow/core/profiler/protobuf/hardware_types.pb.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
 #include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/steps_db.pb.h"
+#include "tensorflow/core/profiler/protobuf/tf_data_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/tf_function.pb.h"
 #include "tensorflow/core/profiler/protobuf/xplane.pb.h"
 #include "tensorflow/core/profiler/utils/event_span.h"
@@ -108,7 +110,7 @@ void SetRunEnvironment(int32 accelerator_count, RunEnvironment* env) {
 
 void ProcessHostPlane(const XPlane* host_plane, bool use_device_step_events,
                       const OpStatsOptions& options, OpMetricsDb* op_metrics_db,
-                      StepEvents* step_events) {
+                      TfDataStats* tf_data_stats, StepEvents* step_events) {
   absl::flat_hash_map<int64, TfOp> tf_ops =
       CollectTfOpsFromHostThreadsXPlane(*host_plane);
   OpMetricsDbCombiner combiner(op_metrics_db);
@@ -116,12 +118,15 @@ void ProcessHostPlane(const XPlane* host_plane, bool use_device_step_events,
   plane.ForEachLine([&](const XLineVisitor& line) {
     ConsumeTfMetricsDbData(
         ConvertHostThreadsXLineToTfMetricsDbData(line, tf_ops), &combiner);
+    CombineTfDataStats(ConvertHostThreadsXLineToTfDataStats(line),
+                       tf_data_stats);
     if (options.generate_step_db) {
       CombineStepEvents(ConvertHostThreadsXLineToStepEvents(
                             line, use_device_step_events, *step_events),
                         step_events);
     }
   });
+  AnalyzeTfDataBottleneck(tf_data_stats);
 }
 
 }  // namespace
@@ -173,8 +178,17 @@ OpStats ConvertXSpaceToOpStats(const XSpace& space,
                         &step_events);
     }
     if (options.generate_kernel_stats_db) {
-      ConvertDeviceTraceXPlaneToKernelReports(*device_trace,
-                                              /*on_kernel_fn=*/{}, &reports);
+      CudaComputeCapability compute_capability =
+          GetDeviceCapFromXPlane(*device_trace).compute_capability();
+      ConvertDeviceTraceXPlaneToKernelReports(
+          *device_trace,
+          /*on_kernel_fn=*/
+          [&compute_capability](const XEventVisitor& event,
+                                KernelReport* kernel) {
+            kernel->set_occupancy(
+                TheoreticalOccupancy(*kernel, compute_capability));
+          },
+          &reports);
     }
   }
 
@@ -188,7 +202,8 @@ OpStats ConvertXSpaceToOpStats(const XSpace& space,
   // Convert a host plane.
   if (host_plane && options.generate_op_metrics_db) {
     ProcessHostPlane(host_plane, has_device, options,
-                     op_stats.mutable_host_op_metrics_db(), &step_events);
+                     op_stats.mutable_host_op_metrics_db(),
+                     op_stats.mutable_tf_data_stats(), &step_events);
   }
   if (options.generate_step_db) {
     StepEvents nonoverlapped_step_events =
@@ -0,0 +1,248 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/convert/xplane_to_tf_data_stats.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/tf_data_stats.pb.h"
+#include "tensorflow/core/profiler/utils/math_utils.h"
+#include "tensorflow/core/profiler/utils/tf_op_utils.h"
+#include "tensorflow/core/profiler/utils/timespan.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_visitor.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// Removes the indices of interleaved inputs from an iterator name, e.g.
+// "Iterator::ParallelInterleaveV4[3]::TFRecord" becomes
+// "Iterator::ParallelInterleaveV4::TFRecord".
+std::string NormalizeIteratorName(absl::string_view name) {
+  std::string result;
+  result.reserve(name.size());
+  int depth = 0;
+  for (char c : name) {
+    if (c == '[') {
+      ++depth;
+    } else if (c == ']') {
+      if (depth > 0) --depth;
+    } else if (depth == 0) {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+// Returns the type of an iterator without its op version, e.g. "ParallelMap"
+// for "Iterator::ParallelMapV2".
+std::string IteratorType(absl::string_view name) {
+  absl::string_view type = name.substr(name.rfind(':') + 1);
+  size_t pos = type.find_last_not_of("0123456789");
+  if (pos != absl::string_view::npos && pos > 0 && pos + 1 < type.size() &&
+      type[pos] == 'V') {
+    type = type.substr(0, pos);
+  }
+  return std::string(type);
+}
+
+double AverageBufferSize(const IteratorStat& stat) {
+  return SafeDivide(stat.buffer_size_sum(), stat.num_buffer_samples());
+}
+
+// Returns the iterator, among those whose names start with `prefix`, with the
+// largest self time, or nullptr if none spent any time.
+const std::pair<const std::string, IteratorStat>* FindSlowestIterator(
+    const TfDataStats& tf_data_stats, absl::string_view prefix) {
+  const std::pair<const std::string, IteratorStat>* slowest = nullptr;
+  for (const auto& name_stat : tf_data_stats.iterator_stats()) {
+    if (!absl::StartsWith(name_stat.first, prefix)) continue;
+    if (name_stat.second.self_time_ps() == 0) continue;
+    if (slowest == nullptr ||
+        name_stat.second.self_time_ps() > slowest->second.self_time_ps()) {
+      slowest = &name_stat;
+    }
+  }
+  return slowest;
+}
+
+std::string Suggestion(absl::string_view name, const IteratorStat& stat) {
+  absl::string_view type = stat.type();
+  if (type == "ParallelMap" || type == "MapAndBatch" ||
+      type == "ParallelBatch") {
+    return absl::StrCat("Increase num_parallel_calls of \"", name,
+                        "\" (parallelism ", stat.max_parallelism(),
+                        ") or set it to tf.data.experimental.AUTOTUNE.");
+  }
+  if (type == "ParallelInterleave" || type == "LegacyParallelInterleave") {
+    return absl::StrCat("Increase num_parallel_calls or cycle_length of \"",
+                        name, "\" (parallelism ", stat.max_parallelism(),
+                        ").");
+  }
+  if (type == "Map") {
+    return absl::StrCat("Set num_parallel_calls in the map of \"", name,
+                        "\" to run its function in parallel.");
+  }
+  if (type == "Interleave") {
+    return absl::StrCat("Set num_parallel_calls in the interleave of \"", name,
+                        "\" to read its inputs in parallel, and add a prefetch "
+                        "after it.");
+  }
+  if (type == "Batch" || type == "PaddedBatch") {
+    return absl::StrCat("Set num_parallel_calls in the batch of \"", name,
+                        "\" to copy the elements in parallel.");
+  }
+  if (type == "Prefetch") {
+    return absl::StrCat(
+        "The buffer of \"", name, "\" is mostly empty (",
+        AverageBufferSize(stat), " elements on average, limit ",
+        stat.max_buffer_limit(),
+        "); increase its buffer_size or set it to "
+        "tf.data.experimental.AUTOTUNE.");
+  }
+  if (type == "TFRecord" || type == "TextLine" ||
+      type == "FixedLengthRecord") {
+    return absl::StrCat("Reading files in \"", name,
+                        "\" is the bottleneck; read several files in parallel "
+                        "with interleave(num_parallel_calls=tf.data."
+                        "experimental.AUTOTUNE) and add a prefetch after it.");
+  }
+  return absl::StrCat("\"", name,
+                      "\" takes the most time in the input pipeline; cache "
+                      "its output with cache() or preprocess the data "
+                      "offline.");
+}
+
+}  // namespace
+
+TfDataStats ConvertHostThreadsXLineToTfDataStats(const XLineVisitor& line) {
+  struct IteratorEvent {
+    Timespan span;
+    std::string name;
+    int64 parallelism = 0;
+    int64 buffer_limit = 0;
+    int64 buffer_size = -1;
+  };
+  std::vector<IteratorEvent> events;
+  line.ForEachEvent([&](const XEventVisitor& event) {
+    if (!IsDatasetOp(ParseTfOpFullname(event.Name()))) return;
+    IteratorEvent iterator_event;
+    iterator_event.span = event.GetTimespan();
+    iterator_event.name = NormalizeIteratorName(event.Name());
+    event.ForEachStat([&](const XStatVisitor& stat) {
+      if (!stat.Type().has_value()) return;
+      switch (stat.Type().value()) {
+        case StatType::kParallelism:
+          iterator_event.parallelism = stat.IntValue();
+          break;
+        case StatType::kBufferLimit:
+          iterator_event.buffer_limit = stat.IntValue();
+          break;
+        case StatType::kBufferSize:
+          iterator_event.buffer_size = stat.IntValue();
+          break;
+        default:
+          break;
+      }
+    });
+    events.push_back(std::move(iterator_event));
+  });
+  absl::c_stable_sort(events,
+                      [](const IteratorEvent& a, const IteratorEvent& b) {
+                        return a.span < b.span;
+                      });
+
+  TfDataStats result;
+  auto* iterator_stats = result.mutable_iterator_stats();
+  // Iterators whose GetNext calls enclose the current one. An iterator calls
+  // its synchronous inputs on the same thread, so their time is removed from
+  // its self time.
+  std::vector<std::pair<Timespan, IteratorStat*>> stack;
+  for (const IteratorEvent& event : events) {
+    while (!stack.empty() && !stack.back().first.Includes(event.span)) {
+      stack.pop_back();
+    }
+    IteratorStat* stat = &(*iterator_stats)[event.name];
+    if (stat->type().empty()) stat->set_type(IteratorType(event.name));
+    stat->set_num_calls(stat->num_calls() + 1);
+    stat->set_self_time_ps(stat->self_time_ps() + event.span.duration_ps());
+    stat->set_max_parallelism(
+        std::max(stat->max_parallelism(), event.parallelism));
+    stat->set_max_buffer_limit(
+        std::max(stat->max_buffer_limit(), event.buffer_limit));
+    if (event.buffer_size >= 0) {
+      stat->set_buffer_size_sum(stat->buffer_size_sum() + event.buffer_size);
+      stat->set_num_buffer_samples(stat->num_buffer_samples() + 1);
+    }
+    if (!stack.empty()) {
+      IteratorStat* parent = stack.back().second;
+      parent->set_self_time_ps(parent->self_time_ps() -
+                               event.span.duration_ps());
+    }
+    stack.emplace_back(event.span, stat);
+  }
+  return result;
+}
+
+void CombineTfDataStats(const TfDataStats& src, TfDataStats* dst) {
+  for (const auto& name_stat : src.iterator_stats()) {
+    const IteratorStat& src_stat = name_stat.second;
+    IteratorStat* dst_stat = &(*dst->mutable_iterator_stats())[name_stat.first];
+    if (dst_stat->type().empty()) dst_stat->set_type(src_stat.type());
+    dst_stat->set_num_calls(src_stat.num_calls() + dst_stat->num_calls());
+    dst_stat->set_self_time_ps(src_stat.self_time_ps() +
+                               dst_stat->self_time_ps());
+    dst_stat->set_max_parallelism(
+        std::max(src_stat.max_parallelism(), dst_stat->max_parallelism()));
+    dst_stat->set_max_buffer_limit(
+        std::max(src_stat.max_buffer_limit(), dst_stat->max_buffer_limit()));
+    dst_stat->set_buffer_size_sum(src_stat.buffer_size_sum() +
+                                  dst_stat->buffer_size_sum());
+    dst_stat->set_num_buffer_samples(src_stat.num_buffer_samples() +
+                                     dst_stat->num_buffer_samples());
+  }
+}
+
+void AnalyzeTfDataBottleneck(TfDataStats* tf_data_stats) {
+  tf_data_stats->clear_bottleneck();
+  const std::pair<const std::string, IteratorStat>* bottleneck =
+      FindSlowestIterator(*tf_data_stats, /*prefix=*/"");
+  if (bottleneck == nullptr) return;
+  while (bottleneck->second.type() == "Prefetch") {
+    const std::pair<const std::string, IteratorStat>* input =
+        FindSlowestIterator(*tf_data_stats,
+                            absl::StrCat(bottleneck->first, "::"));
+    if (input == nullptr) break;
+    bottleneck = input;
+  }
+  TfDataBottleneck* result = tf_data_stats->mutable_bottleneck();
+  result->set_iterator_name(bottleneck->first);
+  result->set_iterator_type(bottleneck->second.type());
+  result->set_self_time_ps(bottleneck->second.self_time_ps());
+  result->set_suggestion(Suggestion(bottleneck->first, bottleneck->second));
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
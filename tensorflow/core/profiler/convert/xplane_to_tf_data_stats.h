@@ -0,0 +1,42 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PROFILER_CONVERT_XPLANE_TO_TF_DATA_STATS_H_
+#define TENSORFLOW_CORE_PROFILER_CONVERT_XPLANE_TO_TF_DATA_STATS_H_
+
+#include "tensorflow/core/profiler/protobuf/tf_data_stats.pb.h"
+#include "tensorflow/core/profiler/utils/xplane_visitor.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// Converts the tf.data iterator events on the given XLine to TfDataStats. The
+// bottleneck is not set.
+TfDataStats ConvertHostThreadsXLineToTfDataStats(const XLineVisitor& line);
+
+// Combines the iterator statistics from src and dst into dst. The bottleneck is
+// not combined.
+void CombineTfDataStats(const TfDataStats& src, TfDataStats* dst);
+
+// Finds the iterator that limits the throughput of the input pipelines, i.e.
+// the one its consumers spend the most time in, and sets the bottleneck of
+// tf_data_stats with a suggestion to remove it. A prefetch only waits for its
+// input, so the bottleneck is then searched among the iterators before it.
+void AnalyzeTfDataBottleneck(TfDataStats* tf_data_stats);
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_CONVERT_XPLANE_TO_TF_DATA_STATS_H_
@@ -0,0 +1,94 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/convert/xplane_to_tf_data_stats.h"
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/tf_data_stats.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/tf_xplane_visitor.h"
+#include "tensorflow/core/profiler/utils/xplane_builder.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_test_utils.h"
+#include "tensorflow/core/profiler/utils/xplane_visitor.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+TfDataStats ConvertXSpaceToTfDataStats(const XSpace& space) {
+  TfDataStats result;
+  XPlaneVisitor plane = CreateTfXPlaneVisitor(&space.planes(0));
+  plane.ForEachLine([&result](const XLineVisitor& line) {
+    CombineTfDataStats(ConvertHostThreadsXLineToTfDataStats(line), &result);
+  });
+  AnalyzeTfDataBottleneck(&result);
+  return result;
+}
+
+TEST(ConvertXPlaneToTfDataStats, BottleneckBeforePrefetch) {
+  XSpace space;
+  XPlaneBuilder host_plane(GetOrCreateHostXPlane(&space));
+  // The consumer waits in the prefetch, whose input runs on another thread.
+  XLineBuilder consumer = host_plane.GetOrCreateLine(0);
+  CreateXEvent(&host_plane, &consumer, "Iterator::Prefetch", 0, 1000,
+               {{StatType::kBufferLimit, int64{2}},
+                {StatType::kBufferSize, int64{0}}});
+  XLineBuilder producer = host_plane.GetOrCreateLine(1);
+  CreateXEvent(&host_plane, &producer, "Iterator::Prefetch::Map", 0, 900);
+  CreateXEvent(&host_plane, &producer, "Iterator::Prefetch::Map::TFRecord", 0,
+               100);
+
+  TfDataStats tf_data_stats = ConvertXSpaceToTfDataStats(space);
+  const auto& iterator_stats = tf_data_stats.iterator_stats();
+  ASSERT_EQ(3, iterator_stats.size());
+  EXPECT_EQ(1000, iterator_stats.at("Iterator::Prefetch").self_time_ps());
+  EXPECT_EQ(2, iterator_stats.at("Iterator::Prefetch").max_buffer_limit());
+  EXPECT_EQ(1, iterator_stats.at("Iterator::Prefetch").num_buffer_samples());
+  EXPECT_EQ(800, iterator_stats.at("Iterator::Prefetch::Map").self_time_ps());
+  EXPECT_EQ(
+      100,
+      iterator_stats.at("Iterator::Prefetch::Map::TFRecord").self_time_ps());
+
+  const TfDataBottleneck& bottleneck = tf_data_stats.bottleneck();
+  EXPECT_EQ("Iterator::Prefetch::Map", bottleneck.iterator_name());
+  EXPECT_EQ("Map", bottleneck.iterator_type());
+  EXPECT_TRUE(absl::StrContains(bottleneck.suggestion(), "num_parallel_calls"));
+}
+
+TEST(ConvertXPlaneToTfDataStats, MergesInterleavedInputs) {
+  XSpace space;
+  XPlaneBuilder host_plane(GetOrCreateHostXPlane(&space));
+  XLineBuilder thread = host_plane.GetOrCreateLine(0);
+  CreateXEvent(&host_plane, &thread,
+               "Iterator::ParallelInterleaveV4[0]::TFRecord", 0, 100);
+  CreateXEvent(&host_plane, &thread,
+               "Iterator::ParallelInterleaveV4[1]::TFRecord", 200, 300);
+
+  TfDataStats tf_data_stats = ConvertXSpaceToTfDataStats(space);
+  ASSERT_EQ(1, tf_data_stats.iterator_stats().size());
+  const IteratorStat& stat = tf_data_stats.iterator_stats().at(
+      "Iterator::ParallelInterleaveV4::TFRecord");
+  EXPECT_EQ("TFRecord", stat.type());
+  EXPECT_EQ(2, stat.num_calls());
+  EXPECT_EQ(400, stat.self_time_ps());
+  EXPECT_EQ("TFRecord", tf_data_stats.bottleneck().iterator_type());
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/hardware_counters.h"
+
+#include <atomic>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+
+std::atomic<bool> HardwareCounters::enabled_(false);
+
+#if defined(__linux__)
+namespace {
+
+// Order of the counters in the group, the first one being the group leader.
+constexpr uint64 kCounterConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+constexpr int kNumCounters = sizeof(kCounterConfigs) / sizeof(uint64);
+
+// The counters of one thread, opened on first use and closed at thread exit.
+class ThreadCounters {
+ public:
+  ThreadCounters() {
+    for (int i = 0; i < kNumCounters; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kCounterConfigs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // Count the calling thread on any CPU.
+      fds_[i] = syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                        /*group_fd=*/i == 0 ? -1 : fds_[0], /*flags=*/0);
+      if (fds_[i] < 0) {
+        VLOG(1) << "Hardware counters are unavailable on this thread.";
+        Close();
+        return;
+      }
+    }
+  }
+
+  ~ThreadCounters() { Close(); }
+
+  bool Read(HardwareCounterValues* values) const {
+    if (fds_[0] < 0) return false;
+    // With PERF_FORMAT_GROUP the leader reads {nr, values[nr]}.
+    uint64 buffer[1 + kNumCounters];
+    if (read(fds_[0], buffer, sizeof(buffer)) != sizeof(buffer) ||
+        buffer[0] != kNumCounters) {
+      return false;
+    }
+    values->cpu_cycles = buffer[1];
+    values->instructions = buffer[2];
+    values->llc_misses = buffer[3];
+    return true;
+  }
+
+ private:
+  void Close() {
+    for (int i = kNumCounters - 1; i >= 0; --i) {
+      if (fds_[i] >= 0) close(fds_[i]);
+      fds_[i] = -1;
+    }
+  }
+
+  int fds_[kNumCounters] = {-1, -1, -1};
+};
+
+}  // namespace
+
+bool HardwareCounters::Read(HardwareCounterValues* values) {
+  static thread_local ThreadCounters counters;
+  return counters.Read(values);
+}
+
+#else
+
+bool HardwareCounters::Read(HardwareCounterValues* values) { return false; }
+
+#endif
+
+}  // namespace profiler
+}  // namespace tensorflow
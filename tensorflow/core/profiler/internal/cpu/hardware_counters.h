@@ -0,0 +1,58 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_HARDWARE_COUNTERS_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_HARDWARE_COUNTERS_H_
+
+#include <atomic>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// Hardware events counted on the calling thread since it first read them.
+struct HardwareCounterValues {
+  uint64 cpu_cycles = 0;
+  uint64 instructions = 0;
+  uint64 llc_misses = 0;
+};
+
+// Per-thread hardware performance counters, read with perf_event_open(2) on
+// Linux. Only user-space events are counted, so no extra privileges are needed
+// beyond the default perf_event_paranoid setting.
+//
+// Counting is off by default. The host tracer enables it for the duration of
+// a trace with ProfileOptions.enable_hardware_counters, and op-level TraceMes
+// then record the counter deltas of the op as metadata.
+class HardwareCounters {
+ public:
+  static void SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_release);
+  }
+
+  static bool IsEnabled() { return enabled_.load(std::memory_order_acquire); }
+
+  // Reads the counters of the calling thread, opening them on first use.
+  // Returns false if they are unavailable on this platform or thread.
+  static bool Read(HardwareCounterValues* values);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_HARDWARE_COUNTERS_H_
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/cpu/hardware_counters.h"
 #include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
 #include "tensorflow/core/profiler/internal/profiler_factory.h"
 #include "tensorflow/core/profiler/internal/profiler_interface.h"
@@ -44,7 +45,7 @@ namespace {
 // Thread-safety: This class is go/thread-compatible.
 class HostTracer : public ProfilerInterface {
  public:
-  explicit HostTracer(int host_trace_level);
+  HostTracer(int host_trace_level, bool enable_hardware_counters);
   ~HostTracer() override;
 
   // Starts recording TraceMes.
@@ -63,6 +64,9 @@ class HostTracer : public ProfilerInterface {
   // Level of host tracing.
   const int host_trace_level_;
 
+  // Whether op TraceMes also record hardware counters.
+  const bool enable_hardware_counters_;
+
   // True if currently recording.
   bool recording_ = false;
 
@@ -73,8 +77,9 @@ class HostTracer : public ProfilerInterface {
   TraceMeRecorder::Events events_;
 };
 
-HostTracer::HostTracer(int host_trace_level)
-    : host_trace_level_(host_trace_level) {}
+HostTracer::HostTracer(int host_trace_level, bool enable_hardware_counters)
+    : host_trace_level_(host_trace_level),
+      enable_hardware_counters_(enable_hardware_counters) {}
 
 HostTracer::~HostTracer() { Stop().IgnoreError(); }
 
@@ -87,6 +92,7 @@ Status HostTracer::Start() {
     return errors::Internal("Failed to start TraceMeRecorder");
   }
   start_timestamp_ns_ = EnvTime::NowNanos();
+  if (enable_hardware_counters_) HardwareCounters::SetEnabled(true);
   return Status::OK();
 }
 
@@ -94,6 +100,7 @@ Status HostTracer::Stop() {
   if (!recording_) {
     return errors::Internal("TraceMeRecorder not started");
   }
+  if (enable_hardware_counters_) HardwareCounters::SetEnabled(false);
   events_ = TraceMeRecorder::Stop();
   recording_ = false;
   return Status::OK();
@@ -158,7 +165,8 @@ Status HostTracer::CollectData(XSpace* space) {
 std::unique_ptr<ProfilerInterface> CreateHostTracer(
     const ProfileOptions& options) {
   if (options.host_tracer_level() == 0) return nullptr;
-  return absl::make_unique<HostTracer>(options.host_tracer_level());
+  return absl::make_unique<HostTracer>(options.host_tracer_level(),
+                                       options.enable_hardware_counters());
 }
 
 auto register_host_tracer_factory = [] {
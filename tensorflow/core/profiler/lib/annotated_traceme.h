@@ -22,14 +22,18 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/cpu/hardware_counters.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 
 namespace tensorflow {
 namespace profiler {
 
 // Combination of TraceMe and ScopedAnnotation which share the same label.
 // Optimization are done to ensure the label generation are done once.
+// When hardware counters are enabled, the TraceMe also records the cycles,
+// instructions and last-level cache misses of the calling thread in its scope.
 class AnnotatedTraceMe {
  public:
   template <typename NameGeneratorT>
@@ -44,11 +48,31 @@ class AnnotatedTraceMe {
       }
       if (TF_PREDICT_TRUE(traceme_enabled)) {
         trace_me_.emplace([&name] { return std::move(name); }, level);
+        if (TF_PREDICT_FALSE(HardwareCounters::IsEnabled())) {
+          counting_ = HardwareCounters::Read(&start_counters_);
+        }
       }
     }
   }
 
+  ~AnnotatedTraceMe() {
+    HardwareCounterValues end_counters;
+    if (TF_PREDICT_FALSE(counting_) && HardwareCounters::Read(&end_counters)) {
+      trace_me_->AppendMetadata([&] {
+        return TraceMeEncode(
+            {{"cpu_cycles",
+              end_counters.cpu_cycles - start_counters_.cpu_cycles},
+             {"instructions",
+              end_counters.instructions - start_counters_.instructions},
+             {"llc_misses",
+              end_counters.llc_misses - start_counters_.llc_misses}});
+      });
+    }
+  }
+
  private:
+  bool counting_ = false;
+  HardwareCounterValues start_counters_;
   absl::optional<TraceMe> trace_me_;
   absl::optional<ScopedAnnotation> scoped_annotation_;
 };
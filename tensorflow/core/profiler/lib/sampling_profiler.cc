@@ -0,0 +1,135 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/convert/op_metrics_db_combiner.h"
+#include "tensorflow/core/profiler/convert/xplane_to_op_stats.h"
+#include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+SamplingProfiler::SamplingProfiler(Options options)
+    : options_(std::move(options)), last_push_ns_(EnvTime::NowNanos()) {}
+
+bool SamplingProfiler::BeginStep() {
+  if (options_.sample_rate <= 0) return false;
+  if (options_.sample_rate < 1 &&
+      static_cast<double>(random::New64()) /
+              std::numeric_limits<uint64>::max() >=
+          options_.sample_rate) {
+    return false;
+  }
+  mutex_lock l(mutex_);
+  if (session_ != nullptr) return false;
+  std::unique_ptr<ProfilerSession> session =
+      ProfilerSession::Create(options_.profile_options);
+  // Skip the step when another session is tracing.
+  if (!session->Status().ok()) return false;
+  session_ = std::move(session);
+  return true;
+}
+
+void SamplingProfiler::EndStep() {
+  std::unique_ptr<ProfilerSession> session;
+  {
+    mutex_lock l(mutex_);
+    session = std::move(session_);
+  }
+  if (session == nullptr) return;
+  XSpace space;
+  Status status = session->CollectData(&space);
+  session.reset();
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to collect a sampled profile: " << status;
+    return;
+  }
+  AddSample(space);
+
+  if (!options_.push_fn) return;
+  OpStats recent;
+  {
+    mutex_lock l(mutex_);
+    const uint64 now_ns = EnvTime::NowNanos();
+    if (now_ns - last_push_ns_ <
+        static_cast<uint64>(options_.push_interval_secs) *
+            EnvTime::kSecondsToNanos) {
+      return;
+    }
+    last_push_ns_ = now_ns;
+    recent = ExportLocked();
+  }
+  options_.push_fn(recent);
+}
+
+void SamplingProfiler::AddSample(const XSpace& space) {
+  OpStatsOptions op_stats_options;
+  op_stats_options.generate_op_metrics_db = true;
+  OpStats op_stats = ConvertXSpaceToOpStats(space, op_stats_options);
+  // Only the op metrics are kept, to bound the size of the window.
+  OpStats sample;
+  sample.mutable_host_op_metrics_db()->Swap(
+      op_stats.mutable_host_op_metrics_db());
+  sample.mutable_device_op_metrics_db()->Swap(
+      op_stats.mutable_device_op_metrics_db());
+  if (op_stats.has_perf_env()) {
+    sample.mutable_perf_env()->Swap(op_stats.mutable_perf_env());
+  }
+  mutex_lock l(mutex_);
+  samples_.push_back(std::move(sample));
+  while (samples_.size() >
+         static_cast<size_t>(std::max(options_.window_size, 1))) {
+    samples_.pop_front();
+  }
+}
+
+OpStats SamplingProfiler::Export() const {
+  mutex_lock l(mutex_);
+  return ExportLocked();
+}
+
+OpStats SamplingProfiler::ExportLocked() const {
+  OpStats result;
+  OpMetricsDbCombiner host_combiner(result.mutable_host_op_metrics_db());
+  OpMetricsDbCombiner device_combiner(result.mutable_device_op_metrics_db());
+  for (const OpStats& sample : samples_) {
+    host_combiner.Combine(sample.host_op_metrics_db());
+    device_combiner.Combine(sample.device_op_metrics_db());
+    if (sample.has_perf_env()) *result.mutable_perf_env() = sample.perf_env();
+  }
+  return result;
+}
+
+int SamplingProfiler::num_samples() const {
+  mutex_lock l(mutex_);
+  return samples_.size();
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
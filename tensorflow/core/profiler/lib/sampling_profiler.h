@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/profiler_options.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// Continuously profiles a random fraction of the steps (or requests) of a
+// long-running job, and keeps the op metrics of the most recent samples in
+// memory. Unsampled steps only cost a random draw, so the profiler can stay
+// enabled in production and the data is there to look at after an incident.
+//
+// Usage:
+//   SamplingProfiler profiler(options);
+//   ...
+//   {
+//     SamplingProfiler::Step step(&profiler);
+//     // Run a step.
+//   }
+//   ...
+//   OpStats recent = profiler.Export();
+//
+// Only one ProfilerSession can be active in the process, so a step is not
+// sampled while another step or an explicit profiling session is traced.
+// Thread-safety: SamplingProfiler is thread-safe.
+class SamplingProfiler {
+ public:
+  struct Options {
+    // Options of the sessions tracing the sampled steps.
+    ProfileOptions profile_options = ProfilerSession::DefaultOptions();
+    // Fraction of the steps that are traced.
+    double sample_rate = 0.01;
+    // Number of most recent samples kept and aggregated by Export.
+    int window_size = 100;
+    // If set, called with Export() at the end of a sampled step once at least
+    // `push_interval_secs` have passed since the previous call.
+    std::function<void(const OpStats&)> push_fn;
+    int64 push_interval_secs = 60;
+  };
+
+  // Traces the current scope if the step is sampled.
+  class Step {
+   public:
+    explicit Step(SamplingProfiler* profiler)
+        : profiler_(profiler), sampled_(profiler->BeginStep()) {}
+    ~Step() {
+      if (sampled_) profiler_->EndStep();
+    }
+
+    bool sampled() const { return sampled_; }
+
+   private:
+    SamplingProfiler* const profiler_;
+    const bool sampled_;
+  };
+
+  explicit SamplingProfiler(Options options);
+
+  // Adds the op metrics of a trace to the window, dropping the oldest sample
+  // when the window is full.
+  void AddSample(const XSpace& space) TF_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the host and device op metrics aggregated over the window.
+  OpStats Export() const TF_LOCKS_EXCLUDED(mutex_);
+
+  // Number of samples in the window.
+  int num_samples() const TF_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  SamplingProfiler(const SamplingProfiler&) = delete;
+  SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+  // Starts tracing if the step is sampled and returns whether it is.
+  bool BeginStep() TF_LOCKS_EXCLUDED(mutex_);
+  // Stops the trace started by BeginStep and adds it to the window.
+  void EndStep() TF_LOCKS_EXCLUDED(mutex_);
+
+  OpStats ExportLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const Options options_;
+  mutable mutex mutex_;
+  // The session tracing the current sampled step, if any.
+  std::unique_ptr<ProfilerSession> session_ TF_GUARDED_BY(mutex_);
+  std::deque<OpStats> samples_ TF_GUARDED_BY(mutex_);
+  uint64 last_push_ns_ TF_GUARDED_BY(mutex_);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
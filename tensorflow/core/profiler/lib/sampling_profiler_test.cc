@@ -0,0 +1,78 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+#include "tensorflow/core/profiler/utils/xplane_builder.h"
+#include "tensorflow/core/profiler/utils/xplane_test_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+constexpr int64 kOpDurationNs = 8000;
+
+// Returns a trace with a single TF op on one host thread.
+XSpace HostTrace() {
+  XSpace space;
+  XPlaneBuilder host_plane(GetOrCreateHostXPlane(&space));
+  XLineBuilder thread = host_plane.GetOrCreateLine(/*line_id=*/10);
+  XEventBuilder event =
+      thread.AddEvent(*host_plane.GetOrCreateEventMetadata("TfOp:TfOp"));
+  event.SetTimestampNs(100000);
+  event.SetDurationNs(kOpDurationNs);
+  return space;
+}
+
+TEST(SamplingProfilerTest, KeepsRollingWindow) {
+  SamplingProfiler::Options options;
+  options.window_size = 2;
+  SamplingProfiler profiler(options);
+  EXPECT_EQ(0, profiler.num_samples());
+
+  for (int i = 0; i < 3; ++i) {
+    profiler.AddSample(HostTrace());
+  }
+  EXPECT_EQ(2, profiler.num_samples());
+
+  OpStats recent = profiler.Export();
+  const OpMetricsDb& db = recent.host_op_metrics_db();
+  EXPECT_EQ(NanosToPicos(kOpDurationNs) * 2, db.total_op_time_ps());
+  int64 occurrences = 0;
+  for (const OpMetrics& metrics : db.metrics_db()) {
+    if (metrics.name() == "TfOp") occurrences += metrics.occurrences();
+  }
+  EXPECT_EQ(2, occurrences);
+}
+
+TEST(SamplingProfilerTest, UnsampledStepsAreNotTraced) {
+  SamplingProfiler::Options options;
+  options.sample_rate = 0;
+  SamplingProfiler profiler(options);
+  for (int i = 0; i < 10; ++i) {
+    SamplingProfiler::Step step(&profiler);
+    EXPECT_FALSE(step.sampled());
+  }
+  EXPECT_EQ(0, profiler.num_samples());
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
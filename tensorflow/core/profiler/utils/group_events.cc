@@ -710,6 +710,22 @@ void EventForest::ProcessModelIds() {
   }
 }
 
+void EventForest::ProcessRequestIds() {
+  for (HostEventType event_type :
+       {HostEventType::kSessionRun, HostEventType::kRunGraph}) {
+    auto run_event_list = gtl::FindOrNull(event_node_map_, event_type);
+    if (!run_event_list) continue;
+    for (const auto& run_event : *run_event_list) {
+      auto group_id = run_event->GetGroupId();
+      if (!group_id.has_value()) continue;
+      absl::optional<XStatVisitor> request_id =
+          run_event->GetEventVisitor().GetStat(StatType::kRequestId);
+      if (!request_id.has_value()) continue;
+      group_metadata_map_[*group_id].request_id = request_id->IntValue();
+    }
+  }
+}
+
 void EventForest::ProcessTfDataEvents() {
   absl::flat_hash_map<std::pair<int64 /*iterator_id*/, int64 /*element_id*/>,
                       std::vector<EventNode*>>
@@ -804,6 +820,7 @@ EventForest::EventForest(
   MarkEagerlyExecutedGpuKernels();
   MarkEagerlyExecutedCpuTfOps();
   ProcessModelIds();
+  ProcessRequestIds();
 }
 
 EventForest::EventForest(
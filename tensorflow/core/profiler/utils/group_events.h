@@ -129,6 +129,9 @@ using EventNodeMap =
 struct GroupMetadata {
   std::string name;
   std::string model_id;  // inference only.
+  // RunOptions.Experimental.request_id of the run, or 0. Joins the groups of
+  // the runs of a request across sessions and hosts.
+  int64 request_id = 0;
 };
 
 using GroupMetadataMap = absl::flat_hash_map<int64 /*group_id*/, GroupMetadata>;
@@ -204,6 +207,9 @@ class EventForest {
   // Adds model ids to group_metadata_map_ for inference profiles.
   void ProcessModelIds();
 
+  // Adds request ids to group_metadata_map_ for the runs of traced requests.
+  void ProcessRequestIds();
+
   EventNodeMap event_node_map_;
   std::vector<XPlaneVisitor> visitors_;
   GroupMetadataMap group_metadata_map_;
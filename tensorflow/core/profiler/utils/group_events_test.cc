@@ -597,6 +597,28 @@ TEST(GroupEventsTest, BatchingSessionTest) {
   EXPECT_EQ(group_metadata_map.size(), 3);
 }
 
+TEST(GroupEventsTest, RequestIdTest) {
+  constexpr int64 kStepId = 0;
+  constexpr int64 kRequestId = 42;
+
+  XSpace space;
+  XPlane* host_plane = GetOrCreateHostXPlane(&space);
+  XPlaneBuilder host_plane_builder(host_plane);
+  host_plane_builder.ReserveLines(1);
+
+  auto main_thread = host_plane_builder.GetOrCreateLine(0);
+  CreateXEvent(&host_plane_builder, &main_thread, HostEventType::kSessionRun, 0,
+               100,
+               {{StatType::kStepId, kStepId},
+                {StatType::kIsRoot, int64{1}},
+                {StatType::kRequestId, kRequestId}});
+
+  GroupMetadataMap group_metadata_map;
+  GroupTfEvents(&space, &group_metadata_map);
+  EXPECT_EQ(group_metadata_map.size(), 1);
+  EXPECT_EQ(group_metadata_map[0].request_id, kRequestId);
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
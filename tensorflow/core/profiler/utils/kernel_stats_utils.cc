@@ -27,6 +27,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/hardware_types.pb.h"
 #include "tensorflow/core/profiler/protobuf/kernel_stats.pb.h"
 
 namespace tensorflow {
@@ -37,8 +38,59 @@ namespace {
 // The maximum number of Kernels displayed on Kernel Stats page.
 const int kMaxNumOfKernels = 1000;
 
+constexpr int kWarpSize = 32;
+
+// Resources of a streaming multiprocessor.
+struct SmLimits {
+  int max_warps;
+  int max_blocks;
+  int registers;
+  int shared_memory_bytes;
+};
+
+SmLimits GetSmLimits(const CudaComputeCapability& compute_capability) {
+  const int major = compute_capability.major();
+  const int minor = compute_capability.minor();
+  if (major >= 9) return {64, 32, 65536, 228 * 1024};
+  if (major == 8 && minor == 0) return {64, 32, 65536, 164 * 1024};
+  if (major == 8 && minor == 9) return {48, 24, 65536, 100 * 1024};
+  if (major == 8) return {48, 16, 65536, 100 * 1024};
+  if (major == 7 && minor == 5) return {32, 16, 65536, 64 * 1024};
+  if (major == 7) return {64, 32, 65536, 96 * 1024};
+  if (major == 6) return {64, 32, 65536, 64 * 1024};
+  return {64, 16, 65536, 48 * 1024};
+}
+
 }  // namespace
 
+double TheoreticalOccupancy(const KernelReport& kernel,
+                            const CudaComputeCapability& compute_capability) {
+  if (compute_capability.major() == 0 || kernel.block_dim_size() != 3) {
+    return 0.0;
+  }
+  const int64 threads_per_block = static_cast<int64>(kernel.block_dim(0)) *
+                                  kernel.block_dim(1) * kernel.block_dim(2);
+  if (threads_per_block == 0) return 0.0;
+  const SmLimits limits = GetSmLimits(compute_capability);
+  const int64 warps_per_block = (threads_per_block + kWarpSize - 1) / kWarpSize;
+  int64 blocks = std::min<int64>(limits.max_blocks,
+                                 limits.max_warps / warps_per_block);
+  const int64 registers_per_block =
+      static_cast<int64>(kernel.registers_per_thread()) * kWarpSize *
+      warps_per_block;
+  if (registers_per_block > 0) {
+    blocks = std::min(blocks, limits.registers / registers_per_block);
+  }
+  const int64 shared_memory_per_block =
+      static_cast<int64>(kernel.static_shmem_bytes()) +
+      kernel.dynamic_shmem_bytes();
+  if (shared_memory_per_block > 0) {
+    blocks = std::min(blocks,
+                      limits.shared_memory_bytes / shared_memory_per_block);
+  }
+  return static_cast<double>(blocks * warps_per_block) / limits.max_warps;
+}
+
 void ParseKernelLaunchParams(absl::string_view xstat_kernel_details,
                              KernelReport* kernel) {
   const std::vector<absl::string_view> params =
@@ -270,6 +322,8 @@ void CopyTopKDurationKernelReportsToDb(const KernelReportMap& reports,
     report->set_min_duration_ns(kernel_value.min_duration_ns);
     report->set_max_duration_ns(kernel_value.max_duration_ns);
     report->set_total_duration_ns(kernel_value.total_duration_ns);
+    report->set_flops(kernel_value.flops);
+    report->set_bytes_accessed(kernel_value.bytes_accessed);
   }
 }
 
@@ -286,6 +340,8 @@ void InsertOrUpdateKernelReport(const KernelReport& kernel,
     element.max_duration_ns =
         std::max(element.max_duration_ns, value.max_duration_ns);
     element.occurrences += 1;
+    element.flops += value.flops;
+    element.bytes_accessed += value.bytes_accessed;
   }
 }
 
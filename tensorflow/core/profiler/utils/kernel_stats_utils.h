@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/hardware_types.pb.h"
 #include "tensorflow/core/profiler/protobuf/kernel_stats.pb.h"
 
 namespace tensorflow {
@@ -39,6 +40,13 @@ bool IsOpTensorCoreEligible(absl::string_view tf_op_name);
 // Returns true if Einsum equation is eligible to use TensorCores.
 bool IsEinsumTensorCoreEligible(absl::string_view equation);
 
+// Returns the theoretical occupancy of a kernel, i.e. the ratio of warps that
+// can be active on a streaming multiprocessor to its maximum, as limited by
+// the block size, registers and shared memory of the kernel. Returns 0 if the
+// launch parameters or the compute capability are unknown.
+double TheoreticalOccupancy(const KernelReport& kernel,
+                            const CudaComputeCapability& compute_capability);
+
 // Less than comparator for Kernel Reports.
 struct KernelReportLessThanComparator {
   bool operator()(const KernelReport& lhs, const KernelReport& rhs) const;
@@ -59,6 +67,8 @@ struct KernelReportValue {
   uint64 min_duration_ns = 0;
   uint64 max_duration_ns = 0;
   uint64 occurrences = 0;
+  uint64 flops = 0;
+  uint64 bytes_accessed = 0;
 };
 
 struct KernelKeyWrap {
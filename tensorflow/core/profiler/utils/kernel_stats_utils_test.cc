@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/utils/kernel_stats_utils.h"
 
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/protobuf/hardware_types.pb.h"
 #include "tensorflow/core/profiler/protobuf/kernel_stats.pb.h"
 
 namespace tensorflow {
@@ -66,6 +67,26 @@ TEST(KernelStatsUtilsTest, TestGroupKernelReportsByOpName) {
   EXPECT_EQ(op2_stats.tensor_core_duration_ns, 0);
 }
 
+TEST(KernelStatsUtilsTest, TestTheoreticalOccupancy) {
+  KernelReport kernel;
+  kernel.add_block_dim(256);
+  kernel.add_block_dim(1);
+  kernel.add_block_dim(1);
+  kernel.set_registers_per_thread(64);
+  CudaComputeCapability compute_capability;
+  // Unknown device.
+  EXPECT_EQ(TheoreticalOccupancy(kernel, compute_capability), 0.0);
+
+  compute_capability.set_major(7);
+  compute_capability.set_minor(0);
+  // 8 warps per block, registers limit an SM to 4 blocks of the 64 warps.
+  EXPECT_DOUBLE_EQ(TheoreticalOccupancy(kernel, compute_capability), 0.5);
+
+  // Shared memory limits an SM to 2 blocks.
+  kernel.set_static_shmem_bytes(48 * 1024);
+  EXPECT_DOUBLE_EQ(TheoreticalOccupancy(kernel, compute_capability), 0.25);
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
@@ -76,6 +76,20 @@ inline bool IsIdleOp(const OpMetrics& metrics) {
   return metrics.name() == kIdle;
 }
 
+// Returns the instructions per cycle of an op, or 0 if its hardware counters
+// were not collected.
+inline double InstructionsPerCycle(const OpMetrics& metrics) {
+  if (metrics.cpu_cycles() == 0) return 0.0;
+  return static_cast<double>(metrics.instructions()) / metrics.cpu_cycles();
+}
+
+// Returns the last-level cache misses per thousand instructions of an op, or 0
+// if its hardware counters were not collected.
+inline double LlcMissesPerKiloInstructions(const OpMetrics& metrics) {
+  if (metrics.instructions() == 0) return 0.0;
+  return 1000.0 * metrics.llc_misses() / metrics.instructions();
+}
+
 // Converts from the device op metrics to Tf-op metrics.
 OpMetricsDb CreateTfMetricsDbFromDeviceOpMetricsDb(
     const OpMetricsDb& device_op_metrics_db, bool with_idle = true);
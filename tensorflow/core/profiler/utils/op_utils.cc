@@ -55,6 +55,16 @@ void HostOpMetricsDbBuilder::EnterOp(absl::string_view name,
   db()->set_total_op_time_ps(db()->total_op_time_ps() + self_time_ps);
 }
 
+void HostOpMetricsDbBuilder::AddHardwareCounters(absl::string_view name,
+                                                 uint64 cpu_cycles,
+                                                 uint64 instructions,
+                                                 uint64 llc_misses) {
+  OpMetrics* op_metrics = LookupOrInsertNewOpMetrics(/*hlo_module_id=*/0, name);
+  op_metrics->set_cpu_cycles(op_metrics->cpu_cycles() + cpu_cycles);
+  op_metrics->set_instructions(op_metrics->instructions() + instructions);
+  op_metrics->set_llc_misses(op_metrics->llc_misses() + llc_misses);
+}
+
 void HostOpMetricsDbBuilder::UpdateHostInfeedEnqInfo(
     uint64 duration_ps, uint64 start_timestamp_ps_diff) {
   db()->set_total_host_infeed_enq_duration_ps(
@@ -41,6 +41,11 @@ class HostOpMetricsDbBuilder : public OpMetricsDbBuilder {
   void EnterOp(absl::string_view name, absl::string_view category,
                bool is_eager, uint64 time_ps, uint64 children_time_ps);
 
+  // Adds the hardware counters measured over one execution of the OP `name`,
+  // which must have been entered with EnterOp.
+  void AddHardwareCounters(absl::string_view name, uint64 cpu_cycles,
+                           uint64 instructions, uint64 llc_misses);
+
   // Updates total_host_infeed_enq_duration_ps_ and
   // total_host_infeed_enq_duration_ps_.
   void UpdateHostInfeedEnqInfo(uint64 duration_ps,
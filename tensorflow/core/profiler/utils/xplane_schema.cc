@@ -144,6 +144,7 @@ const StatTypeMap& GetStatTypeMap() {
       {"bytes_allocated", kBytesAllocated},
       {"bytes_available", kBytesAvailable},
       {"fragmentation", kFragmentation},
+      {"largest_free_block_bytes", kLargestFreeBlockBytes},
       {"peak_bytes_in_use", kPeakBytesInUse},
       {"requested_bytes", kRequestedBytes},
       {"allocation_bytes", kAllocationBytes},
@@ -155,6 +156,12 @@ const StatTypeMap& GetStatTypeMap() {
       {"kpi_value", kKpiValue},
       {"element_id", kElementId},
       {"parent_id", kParentId},
+      {"parallelism", kParallelism},
+      {"buffer_limit", kBufferLimit},
+      {"buffer_size", kBufferSize},
+      {"cpu_cycles", kCpuCycles},
+      {"instructions", kInstructions},
+      {"llc_misses", kLlcMisses},
       // XPlane semantics related.
       {"_pt", kProducerType},
       {"_ct", kConsumerType},
@@ -133,6 +133,7 @@ enum StatType {
   kBytesAllocated,
   kBytesAvailable,
   kFragmentation,
+  kLargestFreeBlockBytes,
   kPeakBytesInUse,
   kRequestedBytes,
   kAllocationBytes,
@@ -144,6 +145,12 @@ enum StatType {
   kKpiValue,
   kElementId,
   kParentId,
+  kParallelism,
+  kBufferLimit,
+  kBufferSize,
+  kCpuCycles,
+  kInstructions,
+  kLlcMisses,
   // XPlane semantics related.
   kProducerType,
   kConsumerType,
@@ -92,6 +92,24 @@ Status HandleElementToSlice<Eigen::half>(const Tensor& /* element */,
   return Status::OK();
 }
 
+template <typename T>
+Status HandleElementsToSlices(absl::Span<Tensor* const> elements, T* dest,
+                              int64 num_values) {
+  if (is_simple_type<T>::value && num_values == 1) {
+    // Avoids a call to memcpy per element for batches of scalars.
+    for (const Tensor* element : elements) {
+      *dest++ = *static_cast<const T*>(element->data());
+    }
+    return Status::OK();
+  }
+  for (Tensor* element : elements) {
+    TF_RETURN_IF_ERROR(HandleElementToSlice<T>(
+        *element, static_cast<T*>(element->data()), dest, num_values));
+    dest += num_values;
+  }
+  return Status::OK();
+}
+
 template <typename T>
 void HandleSliceToElement(const T* src, T* dest, int64 num_values) {
   static_assert(is_simple_type<T>::value, "Memcpy requires a simple type.");
@@ -189,6 +207,44 @@ Status CopyElementToSlice(Tensor element, Tensor* parent, int64 index) {
   }
 }
 
+// Copies each of `elements` into consecutive slices of parent, starting at
+// the offset^th slice.
+Status CopyElementsToSlices(absl::Span<Tensor* const> elements, Tensor* parent,
+                            int64 offset) {
+  if (elements.empty()) return Status::OK();
+  DCHECK_GE(offset, 0);
+  if (offset + static_cast<int64>(elements.size()) > parent->dim_size(0)) {
+    return errors::Internal(
+        "CopyElementsToSlices Cannot perform copy: ", elements.size(),
+        " elements at offset ", offset, " do not fit in a parent of shape ",
+        parent->shape().DebugString());
+  }
+  const int64 num_values = parent->NumElements() / parent->dim_size(0);
+  for (const Tensor* element : elements) {
+    if (element->dtype() != parent->dtype()) {
+      return errors::Internal(
+          "CopyElementsToSlices Cannot perform copy: element type ",
+          DataTypeString(element->dtype()), " does not match parent type ",
+          DataTypeString(parent->dtype()));
+    }
+    TF_RETURN_IF_ERROR(ValidateInput(*parent, *element, offset));
+  }
+#define HANDLE_TYPE(T)                                                       \
+  case DataTypeToEnum<T>::value: {                                           \
+    T* dest = static_cast<T*>(parent->data()) + (num_values * offset);       \
+    return HandleElementsToSlices<T>(elements, dest, num_values);            \
+  }
+
+  switch (parent->dtype()) {
+    TF_CALL_ALL_TYPES(HANDLE_TYPE);
+    TF_CALL_QUANTIZED_TYPES(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      return errors::Unimplemented("CopyElementsToSlices Unhandled data type: ",
+                                   parent->dtype());
+  }
+}
+
 // Copies the index^th slice of parent (in the 0th dimension) into element.
 Status CopySliceToElement(const Tensor& parent, Tensor* element, int64 index) {
   TF_RETURN_IF_ERROR(ValidateInput(parent, *element, index));
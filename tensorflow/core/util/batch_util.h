@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_BATCH_UTIL_H_
 #define TENSORFLOW_CORE_UTIL_BATCH_UTIL_H_
 
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -29,6 +30,17 @@ namespace batch_util {
 // for DT_STRING tensors.
 Status CopyElementToSlice(Tensor element, Tensor* parent, int64 index);
 
+// Copies `*elements[i]` into the (offset + i)^th slice of parent (in the 0th
+// dimension), for each element of `elements`.
+//
+// This is equivalent to calling `CopyElementToSlice()` on each element, but
+// dispatches on the type and validates the parent once for the whole range,
+// which matters when the elements are small. The elements that are the only
+// owner of their buffer are moved from, which is particularly important for
+// DT_STRING tensors.
+Status CopyElementsToSlices(absl::Span<Tensor* const> elements, Tensor* parent,
+                            int64 offset);
+
 // Copies the index^th slice of parent (in the 0th dimension) into element.
 Status CopySliceToElement(const Tensor& parent, Tensor* element, int64 index);
 
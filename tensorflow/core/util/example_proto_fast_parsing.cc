@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstring>
+#include <limits>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -113,6 +115,60 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+// Returns the number of varints in the packed buffer [begin, end), which is
+// the number of bytes without the continuation bit.  This loop is simple
+// enough to be vectorized by the compiler.
+inline int64 CountPackedVarints(const uint8* begin, const uint8* end) {
+  int64 count = 0;
+  for (const uint8* p = begin; p < end; ++p) {
+    count += *p < 0x80;
+  }
+  return count;
+}
+
+// Decodes the packed varints in [begin, end) into out[0, max_out) and returns
+// their number, which may be larger than max_out.  Returns -1 if a varint is
+// truncated or longer than the 10 bytes of a 64 bit value.  Most values fit
+// in a single byte, which is decoded without entering the inner loop.
+inline int64 DecodePackedVarint64s(const uint8* begin, const uint8* end,
+                                   int64* out, int64 max_out) {
+  int64 count = 0;
+  const uint8* p = begin;
+  while (p < end) {
+    uint64 byte = *p++;
+    uint64 n = byte;
+    if (byte >= 0x80) {
+      n &= 0x7f;
+      int shift = 7;
+      do {
+        if (p == end || shift >= 64) return -1;
+        byte = *p++;
+        n |= (byte & 0x7f) << shift;
+        shift += 7;
+      } while (byte >= 0x80);
+    }
+    if (count < max_out) out[count] = static_cast<int64>(n);
+    ++count;
+  }
+  return count;
+}
+
+// Returns the next `length` bytes of `stream` in `*data` and skips them, or
+// returns false if the stream holds fewer bytes.
+inline bool ReadDirectBytes(protobuf::io::CodedInputStream* stream,
+                            uint32 length, const uint8** data) {
+  const void* ptr;
+  int size;
+  if (length == 0) {
+    *data = nullptr;
+    return true;
+  }
+  if (!stream->GetDirectBufferPointer(&ptr, &size)) return false;
+  if (static_cast<uint32>(size) < length) return false;
+  *data = static_cast<const uint8*>(ptr);
+  return stream->Skip(length);
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -299,15 +355,21 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        const uint8* packed;
+        if (!ReadDirectBytes(&stream, packed_length, &packed)) return false;
+        const uint8* packed_end = packed + packed_length;
+
+        // Size the output once and decode straight from the serialized
+        // bytes.  As for floats, the available buffer may be shorter than
+        // requested in case of a LimitedArraySlice.
+        const size_t initial_size = int64_list->size();
+        int64_list->resize(initial_size +
+                           CountPackedVarints(packed, packed_end));
+        if (DecodePackedVarint64s(packed, packed_end,
+                                  int64_list->data() + initial_size,
+                                  int64_list->size() - initial_size) < 0) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -1236,12 +1298,14 @@ Status FastParseExample(const Config& config,
     TF_RETURN_IF_ERROR(status);
   }
 
-  result->sparse_indices.reserve(config.sparse.size());
-  result->sparse_values.reserve(config.sparse.size());
-  result->sparse_shapes.reserve(config.sparse.size());
+  // Every feature is merged into its own output tensors, so the outputs are
+  // sized up front and the features can be merged in parallel.
+  result->sparse_indices.resize(config.sparse.size());
+  result->sparse_values.resize(config.sparse.size());
+  result->sparse_shapes.resize(config.sparse.size());
   result->dense_values.reserve(config.dense.size());
-  result->ragged_values.reserve(config.ragged.size());
-  result->ragged_splits.reserve(config.ragged.size());
+  result->ragged_values.resize(config.ragged.size());
+  result->ragged_splits.resize(config.ragged.size());
 
   for (size_t d = 0; d < config.dense.size(); ++d) {
     result->dense_values.push_back(std::move(fixed_dense_values[d]));
@@ -1258,16 +1322,16 @@ Status FastParseExample(const Config& config,
     TensorShape indices_shape;
     indices_shape.AddDim(total_num_features);
     indices_shape.AddDim(2);
-    result->sparse_indices.emplace_back(DT_INT64, indices_shape);
-    Tensor* indices = &result->sparse_indices.back();
+    result->sparse_indices[d] = Tensor(DT_INT64, indices_shape);
+    Tensor* indices = &result->sparse_indices[d];
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
-    result->sparse_values.emplace_back(config.sparse[d].dtype, values_shape);
-    Tensor* values = &result->sparse_values.back();
+    result->sparse_values[d] = Tensor(config.sparse[d].dtype, values_shape);
+    Tensor* values = &result->sparse_values[d];
 
-    result->sparse_shapes.emplace_back(DT_INT64, TensorShape({2}));
-    auto shapes_shape_t = result->sparse_shapes.back().vec<int64>();
+    result->sparse_shapes[d] = Tensor(DT_INT64, TensorShape({2}));
+    auto shapes_shape_t = result->sparse_shapes[d].vec<int64>();
     shapes_shape_t(0) = serialized.size();
     shapes_shape_t(1) = max_num_features;
 
@@ -1310,9 +1374,9 @@ Status FastParseExample(const Config& config,
 
     TensorShape row_splits_shape;
     row_splits_shape.AddDim(serialized.size() + 1);
-    result->ragged_splits.emplace_back(config.ragged[d].splits_dtype,
-                                       row_splits_shape);
-    Tensor* row_splits = &result->ragged_splits.back();
+    result->ragged_splits[d] =
+        Tensor(config.ragged[d].splits_dtype, row_splits_shape);
+    Tensor* row_splits = &result->ragged_splits[d];
     if (config.ragged[d].splits_dtype == DT_INT64) {
       row_splits->flat<int64>()(0) = 0;
     } else {
@@ -1321,8 +1385,8 @@ Status FastParseExample(const Config& config,
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
-    result->ragged_values.emplace_back(config.ragged[d].dtype, values_shape);
-    Tensor* values = &result->ragged_values.back();
+    result->ragged_values[d] = Tensor(config.ragged[d].dtype, values_shape);
+    Tensor* values = &result->ragged_values[d];
 
     size_t values_offset = 0;
     size_t splits_offset = 0;
@@ -1410,17 +1474,21 @@ Status FastParseExample(const Config& config,
     }
   };
 
-  for (size_t d = 0; d < config.dense.size(); ++d) {
-    MergeDenseVarLenMinibatches(d);
-  }
-
-  for (size_t d = 0; d < config.sparse.size(); ++d) {
-    MergeSparseMinibatches(d);
-  }
-
-  for (size_t d = 0; d < config.ragged.size(); ++d) {
-    MergeRaggedMinibatches(d);
-  }
+  // Merge the features in parallel, unless the whole batch was parsed in a
+  // single minibatch.
+  const size_t num_dense = config.dense.size();
+  const size_t num_sparse = config.sparse.size();
+  auto MergeFeature = [&](size_t f) {
+    if (f < num_dense) {
+      MergeDenseVarLenMinibatches(f);
+    } else if (f < num_dense + num_sparse) {
+      MergeSparseMinibatches(f - num_dense);
+    } else {
+      MergeRaggedMinibatches(f - num_dense - num_sparse);
+    }
+  };
+  ParallelFor(MergeFeature, num_dense + num_sparse + config.ragged.size(),
+              num_minibatches > 1 ? thread_pool : nullptr);
 
   return Status::OK();
 }
@@ -1904,18 +1972,25 @@ inline int ParseFloatFeature(protobuf::io::CodedInputStream* stream,
           !stream->ReadVarint32(&packed_length)) {
         return -1;
       }
-      auto packed_limit = stream->PushLimit(packed_length);
-      while (!stream->ExpectAtEnd()) {
-        uint32 buffer32;
-        if (!stream->ReadLittleEndian32(&buffer32)) {
-          return -1;
-        }
-        if (out != nullptr) {
-          *out++ = absl::bit_cast<float>(buffer32);
+      constexpr uint32 kNumFloatBytes = 4;
+      const uint8* packed;
+      if (packed_length % kNumFloatBytes != 0 ||
+          !ReadDirectBytes(stream, packed_length, &packed)) {
+        return -1;
+      }
+      num_elements = packed_length / kNumFloatBytes;
+      if (out != nullptr && num_elements > 0) {
+        if (port::kLittleEndian) {
+          std::memcpy(out, packed, packed_length);
+        } else {
+          for (int i = 0; i < num_elements; ++i) {
+            uint32 buffer32;
+            protobuf::io::CodedInputStream::ReadLittleEndian32FromArray(
+                packed + i * kNumFloatBytes, &buffer32);
+            out[i] = absl::bit_cast<float>(buffer32);
+          }
         }
-        num_elements++;
       }
-      stream->PopLimit(packed_limit);
     } else if (peek_tag == kFixed32Tag(1)) {
       while (!stream->ExpectAtEnd()) {
         uint32 buffer32;
@@ -1955,18 +2030,17 @@ inline int ParseInt64Feature(protobuf::io::CodedInputStream* stream,
           !stream->ReadVarint32(&packed_length)) {
         return -1;
       }
-      auto packed_limit = stream->PushLimit(packed_length);
-      while (!stream->ExpectAtEnd()) {
-        protobuf_uint64 n;  // There is no API for int64
-        if (!stream->ReadVarint64(&n)) {
-          return -1;
-        }
-        if (out != nullptr) {
-          *out++ = n;
-        }
-        num_elements++;
+      const uint8* packed;
+      if (!ReadDirectBytes(stream, packed_length, &packed)) {
+        return -1;
+      }
+      const int64 count = DecodePackedVarint64s(
+          packed, packed + packed_length, out,
+          out != nullptr ? std::numeric_limits<int64>::max() : 0);
+      if (count < 0) {
+        return -1;
       }
-      stream->PopLimit(packed_limit);
+      num_elements = count;
     } else if (peek_tag == kVarintTag(1)) {
       while (!stream->ExpectAtEnd()) {
         protobuf_uint64 n;  // There is no API for int64
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -170,6 +171,25 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, PackedMultiByteVarints) {
+  Example example;
+  auto* int64_list = (*example.mutable_features()->mutable_feature())["age"]
+                         .mutable_int64_list();
+  for (int64 value : {int64{0}, int64{1}, int64{127}, int64{128},
+                      int64{300}, int64{-1}, kint64max, kint64min}) {
+    int64_list->add_value(value);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, PackedTruncatedVarint) {
+  Example fast_example;
+  // Same as NonPacked, but the continuation bit of the packed value is set.
+  EXPECT_FALSE(TestFastParse(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01\x8d",
+      &fast_example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
@@ -423,6 +443,51 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, MergesFeaturesInParallel) {
+  constexpr int kBatchSize = 1000;
+  std::vector<tstring> serialized;
+  for (int i = 0; i < kBatchSize; ++i) {
+    Example example;
+    auto& features = *example.mutable_features()->mutable_feature();
+    for (int j = 0; j <= i % 3; ++j) {
+      features[kSparseInt64Key].mutable_int64_list()->add_value(i * 1000 + j);
+    }
+    features["ragged"].mutable_float_list()->add_value(i);
+    serialized.push_back(Serialize(example));
+  }
+
+  FastParseExampleConfig config;
+  config.sparse.push_back({kSparseInt64Key, DT_INT64});
+  config.ragged.push_back({"ragged", DT_FLOAT, DT_INT64});
+  thread::ThreadPool thread_pool(Env::Default(), "test", 4);
+  Result result;
+  TF_ASSERT_OK(FastParseExample(config, serialized, gtl::ArraySlice<tstring>(),
+                                &thread_pool, &result));
+
+  ASSERT_EQ(result.sparse_values.size(), 1);
+  auto values = result.sparse_values[0].vec<int64>();
+  auto indices = result.sparse_indices[0].matrix<int64>();
+  int64 k = 0;
+  for (int i = 0; i < kBatchSize; ++i) {
+    for (int j = 0; j <= i % 3; ++j, ++k) {
+      EXPECT_EQ(values(k), i * 1000 + j);
+      EXPECT_EQ(indices(k, 0), i);
+      EXPECT_EQ(indices(k, 1), j);
+    }
+  }
+  EXPECT_EQ(k, values.size());
+  EXPECT_EQ(result.sparse_shapes[0].vec<int64>()(1), 3);
+
+  ASSERT_EQ(result.ragged_values.size(), 1);
+  auto ragged_values = result.ragged_values[0].vec<float>();
+  auto ragged_splits = result.ragged_splits[0].vec<int64>();
+  ASSERT_EQ(ragged_splits.size(), kBatchSize + 1);
+  for (int i = 0; i < kBatchSize; ++i) {
+    EXPECT_EQ(ragged_values(i), i);
+    EXPECT_EQ(ragged_splits(i + 1), i + 1);
+  }
+}
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
@@ -16,7 +16,10 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/memmapped_file_system.pb.h"
 
 namespace tensorflow {
@@ -251,6 +254,18 @@ Status MemmappedFileSystem::InitializeFromFile(Env* env,
     }
     prev_element_offset = element_iter->offset();
   }
+  // Optionally ask for the weights to be mapped with huge pages, which cuts
+  // the TLB misses of random accesses to large tensors. The system may only
+  // collapse read-only file pages into huge pages in the background, if at
+  // all, so this is best effort.
+  bool use_huge_pages = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_MEMMAPPED_USE_HUGE_PAGES",
+                                        false, &use_huge_pages));
+  if (use_huge_pages &&
+      !port::AdviseHugePages(const_cast<void*>(mapped_memory_->data()),
+                             mapped_memory_->length())) {
+    VLOG(1) << "Huge pages are not available for " << filename;
+  }
   return Status::OK();
 }
 
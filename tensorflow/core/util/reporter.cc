@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/human_readable_json.h"
 #include "tensorflow/core/platform/str_util.h"
 
 namespace tensorflow {
@@ -53,8 +54,9 @@ Status TestReportFile::Initialize() {
   return Status::OK();
 }
 
-TestReporter::TestReporter(const string& fname, const string& test_name)
-    : report_file_(fname, test_name) {
+TestReporter::TestReporter(const string& fname, const string& test_name,
+                           const string& format)
+    : report_file_(fname, test_name), format_(format) {
   benchmark_entry_.set_name(test_name);
 }
 
@@ -63,7 +65,14 @@ Status TestReporter::Close() {
 
   BenchmarkEntries entries;
   *entries.add_entry() = benchmark_entry_;
-  TF_RETURN_IF_ERROR(report_file_.Append(entries.SerializeAsString()));
+  string content;
+  if (format_ == "json") {
+    TF_RETURN_IF_ERROR(ProtoToHumanReadableJson(
+        entries, &content, /*ignore_accuracy_loss=*/true));
+  } else {
+    content = entries.SerializeAsString();
+  }
+  TF_RETURN_IF_ERROR(report_file_.Append(content));
   benchmark_entry_.Clear();
 
   return report_file_.Close();
@@ -99,6 +108,12 @@ Status TestReporter::AddMetric(const string& name, double value) {
   return Status::OK();
 }
 
-Status TestReporter::Initialize() { return report_file_.Initialize(); }
+Status TestReporter::Initialize() {
+  if (!format_.empty() && format_ != "proto" && format_ != "json") {
+    return errors::InvalidArgument("Unknown test report format: ", format_,
+                                   ", expected \"proto\" or \"json\"");
+  }
+  return report_file_.Initialize();
+}
 
 }  // namespace tensorflow
@@ -58,7 +58,10 @@ class TestReportFile {
 };
 
 // The TestReporter writes test / benchmark output to binary Protobuf files when
-// the environment variable "TEST_REPORT_FILE_PREFIX" is defined.
+// the environment variable "TEST_REPORT_FILE_PREFIX" is defined. If the
+// environment variable "TEST_REPORT_FILE_FORMAT" is set to "json", the
+// BenchmarkEntries are written in their JSON representation instead, which
+// is easier to consume by tools outside of TensorFlow.
 //
 // If this environment variable is not defined, no logging is performed.
 //
@@ -80,13 +83,21 @@ class TestReportFile {
 class TestReporter {
  public:
   static constexpr const char* kTestReporterEnv = "TEST_REPORT_FILE_PREFIX";
+  static constexpr const char* kTestReporterFormatEnv =
+      "TEST_REPORT_FILE_FORMAT";
 
   // Create a TestReporter with the test name 'test_name'.
   explicit TestReporter(const string& test_name)
       : TestReporter(GetLogEnv(), test_name) {}
 
   // Provide a prefix filename, mostly used for testing this class.
-  TestReporter(const string& fname, const string& test_name);
+  TestReporter(const string& fname, const string& test_name)
+      : TestReporter(fname, test_name, GetFormatEnv()) {}
+
+  // Provide a prefix filename and the output format, either "proto" (the
+  // default if empty) or "json".
+  TestReporter(const string& fname, const string& test_name,
+               const string& format);
 
   // Initialize the TestReporter.  If the reporting env flag is set,
   // try to create the reporting file.  Fails if the file already exists.
@@ -122,7 +133,12 @@ class TestReporter {
     const char* fname_ptr = getenv(kTestReporterEnv);
     return (fname_ptr != nullptr) ? fname_ptr : "";
   }
+  static string GetFormatEnv() {
+    const char* format_ptr = getenv(kTestReporterFormatEnv);
+    return (format_ptr != nullptr) ? format_ptr : "";
+  }
   TestReportFile report_file_;
+  string format_;
   BenchmarkEntry benchmark_entry_;
   TF_DISALLOW_COPY_AND_ASSIGN(TestReporter);
 };
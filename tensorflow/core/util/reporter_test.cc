@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/human_readable_json.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -163,5 +164,37 @@ TEST(TestReporter, AddMetrics) {
   EXPECT_EQ(3.0, metrics.at(1).value());
 }
 
+TEST(TestReporter, BenchmarkAsJson) {
+  string fname =
+      strings::StrCat(testing::TmpDir(), "/test_reporter_json_benchmarks_");
+  TestReporter test_reporter(fname, "b4/5/6", "json");
+  TF_EXPECT_OK(test_reporter.Initialize());
+  TF_EXPECT_OK(test_reporter.Benchmark(2, 1.0, 2.0, 3.0));
+  TF_EXPECT_OK(test_reporter.SetProperty("string_prop", "abc"));
+  TF_EXPECT_OK(test_reporter.Close());
+
+  string expected_fname = strings::StrCat(fname, "b4__5__6");
+  string read;
+  TF_EXPECT_OK(ReadFileToString(Env::Default(), expected_fname, &read));
+  ExpectHasSubstr(read, "\"wall_time\"");
+
+  BenchmarkEntries benchmark_entries;
+  TF_ASSERT_OK(HumanReadableJsonToProto(read, &benchmark_entries));
+  ASSERT_EQ(1, benchmark_entries.entry_size());
+  const BenchmarkEntry& benchmark_entry = benchmark_entries.entry(0);
+  EXPECT_EQ(benchmark_entry.name(), "b4/5/6");
+  EXPECT_EQ(benchmark_entry.iters(), 2);
+  EXPECT_EQ(benchmark_entry.wall_time(), 1.0);
+  EXPECT_EQ("abc", benchmark_entry.extras().at("string_prop").string_value());
+}
+
+TEST(TestReporter, UnknownFormatFails) {
+  TestReporter test_reporter(
+      strings::StrCat(testing::TmpDir(), "/test_reporter_bad_format"), "t1",
+      "xml");
+  Status s = test_reporter.Initialize();
+  ExpectHasSubstr(s.ToString(), "Unknown test report format: xml");
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -52,7 +53,8 @@ namespace tensorflow {
 // Versioning of the tensor bundle format.
 const int kTensorBundleMinProducer = 0;
 const int kTensorBundleMinConsumer = 0;
-const int kTensorBundleVersion = 1;
+const int kTensorBundleVersion = 2;
+const int kTensorBundleDeltaMinConsumer = 2;
 
 // Size of our input buffer for streaming reads
 static const int kBufferSize = 1024 * 1024;
@@ -64,6 +66,32 @@ const char* const kHeaderEntryKey = "";
 
 namespace {
 
+// A tensor buffer pointing into a memory-mapped data file.  Keeps the mapping
+// alive for as long as any tensor refers to it.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const void* data, size_t size)
+      : TensorBuffer(const_cast<void*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("MappedTensorBuffer");
+  }
+
+  // The mapped pages are read-only, so the buffer must never be forwarded to
+  // an op that writes its output in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 // Reads "num_elements" string elements from file[offset, offset+size) into the
 // length-N "destination".  Discards the original content of "destination".
 //
@@ -414,6 +442,18 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
   status_ = env_->HasAtomicMove(prefix_, &use_temp_file_);
   if (!status_.ok()) return;
 
+  if (!options_.base_prefix.empty()) {
+    base_reader_.reset(new BundleReader(env_, options_.base_prefix));
+    status_ = base_reader_->status();
+    if (!status_.ok()) return;
+    if (base_reader_->need_to_swap_bytes_) {
+      status_ = errors::Unimplemented(
+          "The base bundle ", options_.base_prefix,
+          " is of a different endianness than this machine's hardware");
+      return;
+    }
+  }
+
   data_path_ = DataFilename(prefix_, 0, 1);
   metadata_path_ = MetaFilename(prefix_);
   if (use_temp_file_) {
@@ -448,6 +488,11 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
+  if (base_reader_ != nullptr) {
+    bool referenced = false;
+    status_ = ReferenceBaseEntry(key_string, val, entry, &referenced);
+    if (!status_.ok() || referenced) return status_;
+  }
   entry->set_shard_id(0);
   entry->set_offset(size_);
 
@@ -473,6 +518,57 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   return status_;
 }
 
+Status BundleWriter::ReferenceBaseEntry(const string& key, const Tensor& val,
+                                        BundleEntryProto* entry,
+                                        bool* referenced) {
+  *referenced = false;
+  if (!DataTypeCanUseMemcpy(val.dtype()) || val.NumElements() == 0) {
+    return Status::OK();
+  }
+  BundleEntryProto base_entry;
+  if (!base_reader_->GetBundleEntryProto(key, &base_entry).ok()) {
+    return Status::OK();
+  }
+  if (!base_entry.slices().empty() || base_entry.dtype() != val.dtype() ||
+      TensorShape(base_entry.shape()) != val.shape() ||
+      base_entry.size() != val.TotalBytes()) {
+    return Status::OK();
+  }
+  // The checksum rules out most changed tensors without reading the base
+  // bundle, but only comparing the bytes proves that a tensor is unchanged.
+  const StringPiece bytes = val.tensor_data();
+  if (crc32c::Unmask(base_entry.crc32c()) !=
+      crc32c::Value(bytes.data(), bytes.size())) {
+    return Status::OK();
+  }
+  Tensor base_val(val.dtype(), val.shape());
+  TF_RETURN_IF_ERROR(base_reader_->GetValue(base_entry, &base_val));
+  if (base_val.tensor_data() != bytes) return Status::OK();
+
+  // Refer to the bundle holding the bytes, even if it is not the base bundle
+  // itself, so that reading never follows a chain of bundles.
+  BundleHeaderProto::BaseBundle base;
+  if (base_entry.base_id() > 0) {
+    base = base_reader_->base_bundles_[base_entry.base_id() - 1];
+  } else {
+    base.set_prefix(options_.base_prefix);
+    base.set_num_shards(base_reader_->num_shards_);
+  }
+  size_t base_id = 0;
+  while (base_id < base_bundles_.size() &&
+         base_bundles_[base_id].prefix() != base.prefix()) {
+    ++base_id;
+  }
+  if (base_id == base_bundles_.size()) base_bundles_.push_back(base);
+  entry->set_base_id(base_id + 1);
+  entry->set_shard_id(base_entry.shard_id());
+  entry->set_offset(base_entry.offset());
+  entry->set_size(base_entry.size());
+  entry->set_crc32c(base_entry.crc32c());
+  *referenced = true;
+  return Status::OK();
+}
+
 Status BundleWriter::AddSlice(StringPiece full_tensor_key,
                               const TensorShape& full_tensor_shape,
                               const TensorSlice& slice_spec,
@@ -547,7 +643,14 @@ Status BundleWriter::Finish() {
     if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
     VersionDef* version = header.mutable_version();
     version->set_producer(kTensorBundleVersion);
-    version->set_min_consumer(kTensorBundleMinConsumer);
+    // All the bundles written with a base have the same version, so that
+    // sharded saves can be merged.
+    version->set_min_consumer(options_.base_prefix.empty()
+                                  ? kTensorBundleMinConsumer
+                                  : kTensorBundleDeltaMinConsumer);
+    for (const auto& base : base_bundles_) {
+      *header.add_base_bundles() = base;
+    }
 
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
@@ -573,9 +676,6 @@ Status BundleWriter::Finish() {
 
 // Accumulator of metadata states during a merge.
 struct MergeState {
-  // Accumulated from the header entries.
-  int num_shards = 0;
-
   // Derives "endianness" and "version" from the first bundle merged (hence the
   // "seen_first_bundle" guard).  The two fields must be the same for all
   // bundles in a merge.
@@ -587,6 +687,12 @@ struct MergeState {
   std::map<string, BundleEntryProto> entries;
   // Data file path -> new shard id in the final merged bundle.
   std::unordered_map<string, int32> shard_ids;
+  // The bundles referred to by the merged entries, in the order of their
+  // base_id.
+  std::vector<BundleHeaderProto::BaseBundle> base_bundles;
+  // Data file paths of the merged bundles.  Those without any entry, e.g. of
+  // a delta bundle holding no changed tensor, are deleted.
+  std::vector<string> data_files;
 };
 
 // Merges entries of "prefix" into the accumulator state "merge".
@@ -607,6 +713,8 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
   std::unique_ptr<table::Iterator> iter(table->NewIterator());
 
   int num_shards;
+  // The merged base_id of each base bundle of this bundle.
+  std::vector<int32> base_ids;
   // Process header.
   {
     iter->Seek(kHeaderEntryKey);
@@ -618,7 +726,6 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
     Status s = ParseEntryProto(iter->key(), iter->value(), &header);
     if (!s.ok()) return CorruptFileError(s, filename, "unable to parse header");
 
-    merge_state->num_shards += header.num_shards();
     if (!merge_state->seen_first_bundle) {
       merge_state->seen_first_bundle = true;
       merge_state->endianness = header.endianness();
@@ -640,6 +747,16 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
       }
     }
     num_shards = header.num_shards();
+    for (int i = 0; i < num_shards; ++i) {
+      merge_state->data_files.push_back(DataFilename(prefix, i, num_shards));
+    }
+    for (const auto& base : header.base_bundles()) {
+      auto& merged = merge_state->base_bundles;
+      size_t i = 0;
+      while (i < merged.size() && merged[i].prefix() != base.prefix()) ++i;
+      if (i == merged.size()) merged.push_back(base);
+      base_ids.push_back(i + 1);
+    }
     iter->Next();
   }
 
@@ -681,6 +798,18 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
     }
 
     // Key doesn't duplicate: a fresh tensor/slice entry.
+    if (to_merge_entry.base_id() != 0) {
+      // The bytes lie in a base bundle, whose data files are not renamed.
+      if (to_merge_entry.base_id() < 0 ||
+          static_cast<size_t>(to_merge_entry.base_id()) > base_ids.size()) {
+        return errors::DataLoss("Invalid base bundle ",
+                                to_merge_entry.base_id(), " of tensor ", key,
+                                " in ", prefix);
+      }
+      to_merge_entry.set_base_id(base_ids[to_merge_entry.base_id() - 1]);
+      merge_state->entries[key] = to_merge_entry;
+      continue;
+    }
     auto result = merge_state->shard_ids.insert(
         {DataFilename(prefix, to_merge_entry.shard_id(), num_shards),
          merge_state->shard_ids.size()});
@@ -718,9 +847,12 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
     table::TableBuilder builder(TableBuilderOptions(), merged_metadata.get());
     // Header entry.
     BundleHeaderProto header;
-    header.set_num_shards(merge.num_shards);
+    header.set_num_shards(merge.shard_ids.size());
     header.set_endianness(merge.endianness);
     *header.mutable_version() = merge.version;
+    for (const auto& base : merge.base_bundles) {
+      *header.add_base_bundles() = base;
+    }
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
     // All others.
     for (const auto& p : merge.entries) {
@@ -736,6 +868,11 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
   for (const tstring& prefix : prefixes) {
     env->DeleteFile(MetaFilename(prefix)).IgnoreError();
   }
+  for (const string& data_file : merge.data_files) {
+    if (merge.shard_ids.count(data_file) == 0) {
+      env->DeleteFile(data_file).IgnoreError();
+    }
+  }
   return status;
 }
 
@@ -787,6 +924,8 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
     return;
   }
   num_shards_ = header.num_shards();
+  base_bundles_.assign(header.base_bundles().begin(),
+                       header.base_bundles().end());
   if ((header.endianness() == BundleHeaderProto::BIG && port::kLittleEndian) ||
       (header.endianness() == BundleHeaderProto::LITTLE &&
        !port::kLittleEndian)) {
@@ -870,14 +1009,14 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   }
 
   // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
+  string data_filename;
+  TF_RETURN_IF_ERROR(GetDataFilename(entry, &data_filename));
+  io::InputBuffer*& buffered_file = data_[data_filename];
   if (buffered_file == nullptr) {
     std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(data_filename, &file));
     // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
+    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
   }
   CHECK(buffered_file != nullptr);
 
@@ -936,6 +1075,24 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::GetDataFilename(const BundleEntryProto& entry,
+                                     string* filename) {
+  if (entry.base_id() == 0) {
+    *filename = DataFilename(prefix_, entry.shard_id(), num_shards_);
+    return Status::OK();
+  }
+  if (entry.base_id() < 0 ||
+      static_cast<size_t>(entry.base_id()) > base_bundles_.size()) {
+    return errors::DataLoss("Invalid base bundle ", entry.base_id(),
+                            " in bundle entry of ", prefix_, ", which has ",
+                            base_bundles_.size(), " base bundles");
+  }
+  const BundleHeaderProto::BaseBundle& base =
+      base_bundles_[entry.base_id() - 1];
+  *filename = DataFilename(base.prefix(), entry.shard_id(), base.num_shards());
+  return Status::OK();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -950,6 +1107,64 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMapped(StringPiece key, Tensor* val,
+                                  bool* mapped) {
+  CHECK(val != nullptr);
+  *mapped = false;
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  if (!entry.slices().empty() || !DataTypeCanUseMemcpy(entry.dtype()) ||
+      need_to_swap_bytes_) {
+    return Status::OK();
+  }
+  const TensorShape stored_shape(entry.shape());
+  const uint64 expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                            "; stored size ", entry.size(), "; expected size ",
+                            expected_size);
+  }
+
+  // Map the data file if it has not been mapped.  A file system without
+  // memory-mapping support is remembered, so that it is not retried.
+  string data_filename;
+  TF_RETURN_IF_ERROR(GetDataFilename(entry, &data_filename));
+  auto it = mapped_data_.find(data_filename);
+  if (it == mapped_data_.end()) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    if (!env_->NewReadOnlyMemoryRegionFromFile(data_filename, &region).ok()) {
+      region.reset();
+    }
+    it = mapped_data_.emplace(data_filename, std::move(region)).first;
+  }
+  const std::shared_ptr<ReadOnlyMemoryRegion>& region = it->second;
+  if (region == nullptr) return Status::OK();
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss("Bundle entry out of range: key ", key,
+                            "; offset ", entry.offset(), "; size ",
+                            entry.size(), "; file size ", region->length());
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return Status::OK();
+  }
+
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  MappedTensorBuffer* buf = new MappedTensorBuffer(region, data, entry.size());
+  *val = Tensor(entry.dtype(), stored_shape, buf);
+  buf->Unref();
+  *mapped = true;
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1138,7 +1353,11 @@ string BundleReader::DebugString() {
   return shape_str;
 }
 
-FileOutputBuffer::~FileOutputBuffer() { delete file_; }
+FileOutputBuffer::~FileOutputBuffer() {
+  // The background append must be done before the file is deleted.
+  WaitForFlush().IgnoreError();
+  delete file_;
+}
 
 Status FileOutputBuffer::Append(StringPiece data) {
   // In the below, it is critical to calculate the checksum on the actually
@@ -1172,15 +1391,41 @@ Status FileOutputBuffer::Append(StringPiece data) {
 
 Status FileOutputBuffer::Close() {
   TF_RETURN_IF_ERROR(FlushBuffer());
+  TF_RETURN_IF_ERROR(WaitForFlush());
   return file_->Close();
 }
 
 Status FileOutputBuffer::FlushBuffer() {
-  if (position_ > 0) {
-    TF_RETURN_IF_ERROR(file_->Append(StringPiece(&buffer_[0], position_)));
-    position_ = 0;
+  if (position_ == 0) return Status::OK();
+  TF_RETURN_IF_ERROR(WaitForFlush());
+  if (flush_thread_ == nullptr) {
+    flush_thread_.reset(
+        new thread::ThreadPool(Env::Default(), "file_output_buffer", 1));
+    flushing_buffer_.resize(buffer_size_);
+  }
+  buffer_.swap(flushing_buffer_);
+  const size_t size = position_;
+  position_ = 0;
+  {
+    mutex_lock l(mu_);
+    flush_pending_ = true;
   }
+  flush_thread_->Schedule([this, size]() {
+    const Status s = file_->Append(StringPiece(flushing_buffer_.data(), size));
+    mutex_lock l(mu_);
+    flush_status_.Update(s);
+    flush_pending_ = false;
+    flush_done_.notify_all();
+  });
   return Status::OK();
 }
 
+Status FileOutputBuffer::WaitForFlush() {
+  mutex_lock l(mu_);
+  while (flush_pending_) {
+    flush_done_.wait(l);
+  }
+  return flush_status_;
+}
+
 }  // namespace tensorflow
@@ -57,18 +57,26 @@ limitations under the License.
 //        "/fs/model/train/ckpt-step/tmp/worker1-step"},
 //       "/fs/model/train/ckpt-step/ckpt" /* merged prefix */);
 //
+// A BundleWriter given the prefix of an earlier bundle in
+// "BundleWriter::Options::base_prefix" builds a delta bundle: the tensors that
+// did not change since the earlier bundle are not written again, and their
+// entries refer to the data files of the bundle that holds their bytes.
+//
 
 #ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 #define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
@@ -76,6 +84,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
@@ -83,6 +92,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class BundleReader;
 class FileOutputBuffer;
 
 // Versioning of the tensor bundle format.
@@ -91,9 +101,12 @@ class FileOutputBuffer;
 // History:
 // 0. Any tensor bundles produced before this field was added.
 // 1. Added this field (2016-09-14).
+// 2. Added delta bundles, which older consumers cannot read (2026-10-15).
 extern const int kTensorBundleMinProducer;
 extern const int kTensorBundleMinConsumer;
 extern const int kTensorBundleVersion;
+// The min consumer version of delta bundles.
+extern const int kTensorBundleDeltaMinConsumer;
 
 // The empty string, hence always the first key in the metadata table.  Its
 // corresponding value is a BundleHeaderProto.
@@ -112,6 +125,18 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // If non-empty, the prefix of an earlier bundle.  A tensor whose key,
+    // dtype, shape and bytes are the same in that bundle is not written
+    // again; its entry refers to the data file holding its bytes, which may
+    // belong to a bundle "base_prefix" itself refers to.  Entries never refer
+    // to a bundle that refers to another one for them, so a chain of delta
+    // bundles does not slow down restoring.
+    //
+    // The referred bundles must be kept, under the same prefixes, for as
+    // long as the delta bundle is used.  A bundle written without
+    // "base_prefix" refers to no other bundle, e.g. to let older ones be
+    // deleted.  Only numeric tensors are compared.
+    string base_prefix;
   };
   BundleWriter(Env* env, StringPiece prefix,
                const Options& options = Options());
@@ -146,6 +171,11 @@ class BundleWriter {
   Status status() const { return status_; }
 
  private:
+  // If the tensor "val" keyed by "key" has the same contents in the base
+  // bundle, points "entry" to its bytes there and sets "*referenced".
+  Status ReferenceBaseEntry(const string& key, const Tensor& val,
+                            BundleEntryProto* entry, bool* referenced);
+
   Env* const env_;  // Not owned.
   const Options options_;
   const string prefix_;
@@ -157,6 +187,11 @@ class BundleWriter {
   std::map<string, BundleEntryProto> entries_;
   Status status_;
 
+  // Reads the bundle "options_.base_prefix", if any.
+  std::unique_ptr<BundleReader> base_reader_;
+  // The bundles referred to by the entries, in the order of their base_id.
+  std::vector<BundleHeaderProto::BaseBundle> base_bundles_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
 };
 
@@ -165,13 +200,16 @@ class BundleWriter {
 //
 // If there are N bundles in "prefixes", during the merge the data files will be
 // renamed to contain a proper sharded file spec, with num_shards set to the sum
-// of num_shards across the N input bundles.
+// of num_shards across the N input bundles, not counting the data files that
+// hold no tensor, e.g. of delta bundles without changed tensors.  The entries
+// of delta bundles keep referring to the data files of their base bundles.
 //
 // The caller should only rely on the metadata file of the merged bundle to
 // query information about a tensor.  In particular, this function does not
 // guarantee not to re-order the input data files.
 //
-// Once merged, makes a best effort to delete the old metadata files.
+// Once merged, makes a best effort to delete the old metadata files and the
+// data files holding no tensor.
 // Returns OK iff all bundles are successfully merged.
 Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
                     StringPiece merged_prefix);
@@ -219,6 +257,20 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like "Lookup()", but if the entry is stored unsliced, in the host byte
+  // order and suitably aligned, points "val" into a read-only memory mapping
+  // of the data file instead of copying the contents.  Sets "*mapped" to
+  // whether that happened; when it is false, "val" is untouched and the caller
+  // should fall back to "Lookup()".
+  //
+  // The returned tensor does not own its memory, so it is never forwarded to
+  // ops that write in place.  Entries are only aligned if the bundle was
+  // written with "BundleWriter::Options::data_alignment" set to a multiple of
+  // EIGEN_MAX_ALIGN_BYTES.
+  // REQUIRES: status().ok()
+  Status LookupMapped(StringPiece key, Tensor* val,
+                      bool* mapped) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -283,6 +335,11 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Returns in "filename" the name of the data file holding the bytes of
+  // "entry", which may belong to a base bundle.
+  Status GetDataFilename(const BundleEntryProto& entry,
+                         string* filename) TF_MUST_USE_RESULT;
+
   Env* env_;  // Not owned.
   const string prefix_;
 
@@ -291,8 +348,15 @@ class BundleReader {
   table::Table* table_;
   table::Cache* index_cache_;
   table::Iterator* iter_;
-  // Owned the InputBuffer objects and their underlying RandomAccessFile's.
-  std::unordered_map<int32, io::InputBuffer*> data_;
+  // Owned the InputBuffer objects and their underlying RandomAccessFile's,
+  // keyed by data file name.
+  std::unordered_map<string, io::InputBuffer*> data_;
+
+  // Memory mappings of the data files used by "LookupMapped()", keyed by data
+  // file name, or nullptr for the files that could not be mapped.  Shared with
+  // the tensors pointing into them.
+  std::unordered_map<string, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -306,6 +370,10 @@ class BundleReader {
   // differs from that of the current system's processor architecture.
   bool need_to_swap_bytes_;
 
+  // The bundles holding the bytes of the entries with a nonzero base_id.
+  std::vector<BundleHeaderProto::BaseBundle> base_bundles_;
+
+  friend class BundleWriter;  // For reading the base bundle of a delta.
   friend class TensorBundleAlignmentTest;  // For testing data alignment.
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleReader);
@@ -314,6 +382,11 @@ class BundleReader {
 // A buffering wrapper for a WritableFile.  Useful if the caller wishes to issue
 // small writes to a file (e.g. writing out a list of small varints).
 // External synchronization must be used in the presence of concurrent callers.
+//
+// Full buffers are appended to the file on a background thread, while the
+// caller copies and checksums the next bytes into a second buffer, so that
+// writing a large checkpoint is bound by the slower of the two instead of
+// their sum.
 class FileOutputBuffer {
  public:
   FileOutputBuffer(WritableFile* file, size_t buffer_size)
@@ -335,9 +408,15 @@ class FileOutputBuffer {
   Status Close();
 
  private:
-  // Appends the buffered data to the underlying file. Does NOT flush the file.
+  // Starts appending the buffered data to the underlying file in the
+  // background, after the previous such append is done. Does NOT flush the
+  // file.
   Status FlushBuffer();
 
+  // Waits for the background append started by FlushBuffer(), if any, and
+  // returns the status of all the appends so far.
+  Status WaitForFlush();
+
   WritableFile* file_;  // Owned.
 
   // buffer_[0, position_) holds the buffered data not yet appended to the
@@ -346,6 +425,16 @@ class FileOutputBuffer {
   const size_t buffer_size_;
   std::vector<char> buffer_;
 
+  // Holds the data being appended to the underlying file by flush_thread_.
+  // Allocated on the first flush.
+  std::vector<char> flushing_buffer_;
+  std::unique_ptr<thread::ThreadPool> flush_thread_;
+
+  mutex mu_;
+  condition_variable flush_done_;
+  bool flush_pending_ TF_GUARDED_BY(mu_) = false;
+  Status flush_status_ TF_GUARDED_BY(mu_);
+
   // Checksum of all appended bytes since construction or last clear_crc32c().
   uint32 crc32c_ = 0;
 };
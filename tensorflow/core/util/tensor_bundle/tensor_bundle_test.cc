@@ -541,6 +541,25 @@ TEST(TensorBundleTest, Basic) {
   TestBasic<bfloat16>();
 }
 
+TEST(TensorBundleTest, TensorsLargerThanWriteBuffer) {
+  // The 8MB write buffer is flushed in the background several times while
+  // the writer fills the next one.
+  const Tensor big = Constant(1.5f, TensorShape({5 << 20}));
+  const Tensor small = Constant_2x3<int32>(7);
+  {
+    BundleWriter writer(Env::Default(), Prefix("foo"));
+    TF_EXPECT_OK(writer.Add("big_0", big));
+    TF_EXPECT_OK(writer.Add("small", small));
+    TF_EXPECT_OK(writer.Add("big_1", big));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("foo"));
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "big_0", big);
+  Expect<int32>(&reader, "small", small);
+  Expect<float>(&reader, "big_1", big);
+}
+
 TEST(TensorBundleTest, Endianness) {
   TestEndianness<float>();
   TestEndianness<double>();
@@ -685,6 +704,64 @@ TEST(TensorBundleTest, EquivalentSliceTest) {
   }
 }
 
+TEST(TensorBundleTest, DeltaBundles) {
+  auto data_file_size = [](const string& prefix) {
+    uint64 size = 0;
+    TF_EXPECT_OK(
+        Env::Default()->GetFileSize(DataFilename(Prefix(prefix), 0, 1), &size));
+    return size;
+  };
+  {
+    BundleWriter writer(Env::Default(), Prefix("base"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2)));
+    TF_EXPECT_OK(writer.Add("s", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Only "b" changed, and strings are always written.
+  BundleWriter::Options opts;
+  opts.base_prefix = Prefix("base");
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta"), opts);
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(3)));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3<int32>(4)));
+    TF_EXPECT_OK(writer.Add("s", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  EXPECT_EQ(data_file_size("delta"),
+            data_file_size("base") - 6 * sizeof(float) + 6 * sizeof(int32));
+  // Nothing changed: "a" refers to the base bundle directly.
+  opts.base_prefix = Prefix("delta");
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta_2"), opts);
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(3)));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3<int32>(4)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  EXPECT_EQ(data_file_size("delta_2"), uint64{0});
+
+  for (const string& prefix : {"delta", "delta_2"}) {
+    BundleReader reader(Env::Default(), Prefix(prefix));
+    TF_ASSERT_OK(reader.status());
+    Expect<float>(&reader, "a", Constant_2x3<float>(1));
+    Expect<float>(&reader, "b", Constant_2x3<float>(3));
+    Expect<int32>(&reader, "c", Constant_2x3<int32>(4));
+  }
+
+  // Merging keeps the references, and drops the empty data file.
+  TF_ASSERT_OK(MergeBundles(Env::Default(), {Prefix("delta_2")},
+                            Prefix("merged")));
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(
+      DataFilename(Prefix("delta_2"), 0, 1))));
+  BundleReader reader(Env::Default(), Prefix("merged"));
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "a", Constant_2x3<float>(1));
+  Expect<float>(&reader, "b", Constant_2x3<float>(3));
+  Expect<int32>(&reader, "c", Constant_2x3<int32>(4));
+}
+
 TEST(TensorBundleTest, NonStandardShapes) {
   TestNonStandardShapes<float>();
   TestNonStandardShapes<double>();
@@ -1109,6 +1186,41 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, LookupMapped) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("foo"), opts);
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("ints", Constant(7, TensorShape({5}))));
+    TF_EXPECT_OK(writer.Add("strings", Constant_2x3<tstring>("hello")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("foo"));
+  TF_ASSERT_OK(reader.status());
+
+  Tensor floats;
+  bool mapped = false;
+  TF_ASSERT_OK(reader.LookupMapped("floats", &floats, &mapped));
+  EXPECT_TRUE(mapped);
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(1.5));
+  // A mapped tensor must never be updated in place.
+  EXPECT_FALSE(floats.RefCountIsOne());
+
+  Tensor ints;
+  TF_ASSERT_OK(reader.LookupMapped("ints", &ints, &mapped));
+  EXPECT_TRUE(mapped);
+  test::ExpectTensorEqual<int>(ints, Constant(7, TensorShape({5})));
+
+  // Strings are not stored in their in-memory layout and are never mapped.
+  Tensor strings;
+  TF_ASSERT_OK(reader.LookupMapped("strings", &strings, &mapped));
+  EXPECT_FALSE(mapped);
+
+  EXPECT_TRUE(
+      errors::IsNotFound(reader.LookupMapped("missing", &strings, &mapped)));
+}
+
 static void BM_BundleAlignmentByteOff(int iters, int alignment,
                                       int tensor_size) {
   testing::StopTiming();
@@ -78,6 +78,7 @@ TfLiteStatus ArenaPlanner::ResetAllocationsAfter(int node) {
 TfLiteStatus ArenaPlanner::PlanAllocations() {
   // Invalidate any existing data.
   TF_LITE_ENSURE_STATUS(ResetAllocations());
+  cached_plans_.clear();
   // Maybe other verb instead of 'Assigned'
   alloc_node_.assign(graph_info_->num_tensors(), kNodeNotAssigned);
   dealloc_node_.assign(graph_info_->num_tensors(), kNodeNotAssigned);
@@ -139,14 +140,22 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
     }
   }
 
-  // Count references to node input tensors.
+  // Count references to node input tensors. Also find the last node that
+  // may run while each tensor is still read: when nodes run concurrently, the
+  // memory of a tensor can't be reused until all nodes that may run along
+  // with its readers have been allocated.
+  std::vector<int32_t> last_use(graph_info_->num_tensors(), 0);
   for (size_t i = 0; i < graph_info_->num_execution_nodes(); ++i) {
     const TfLiteNode& node = graph_info_->node(i);
+    const int32_t last_concurrent_node =
+        std::max(i, graph_info_->last_concurrent_node(i));
     TfLiteIntArray* node_inputs = node.inputs;
     for (int j = 0; j < node_inputs->size; ++j) {
       int tensor_index = node_inputs->data[j];
       if (tensor_index != kTfLiteOptionalTensor) {
         refcounts[tensor_index]++;
+        last_use[tensor_index] =
+            std::max(last_use[tensor_index], last_concurrent_node);
       }
     }
   }
@@ -177,7 +186,8 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
         if (tensor_index != kTfLiteOptionalTensor) {
           refcounts[tensor_index]--;
           if (refcounts[tensor_index] == 0) {
-            TF_LITE_ENSURE_STATUS(deallocate(i, tensor_index));
+            TF_LITE_ENSURE_STATUS(
+                deallocate(last_use[tensor_index], tensor_index));
           }
         }
       }
@@ -205,11 +215,25 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
     for (int j = 0; j < node_temporaries->size; ++j) {
       int tensor_index = node_temporaries->data[j];
       alloc_node_[tensor_index] = i;
-      dealloc_node_[tensor_index] = i;
+      dealloc_node_[tensor_index] =
+          std::max(i, graph_info_->last_concurrent_node(i));
     }
   }
 
-  TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+  if (first_node == 0 &&
+      last_node + 1 >= static_cast<int>(graph_info_->num_execution_nodes())) {
+    // All tensors are allocated anew, e.g. after resizing the inputs, so the
+    // plan only depends on their sizes and may have been calculated before.
+    std::vector<size_t> signature = CreatePlanSignature();
+    if (!RestoreCachedPlan(signature)) {
+      TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
+      TF_LITE_ENSURE_STATUS(persistent_arena_.ClearPlan());
+      TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+      CachePlan(std::move(signature));
+    }
+  } else {
+    TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+  }
   TF_LITE_ENSURE_STATUS(Commit());
 
   for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
@@ -334,6 +358,64 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   return kTfLiteOk;
 }
 
+std::vector<size_t> ArenaPlanner::CreatePlanSignature() {
+  std::vector<size_t> signature;
+  signature.reserve(4 * graph_info_->num_tensors());
+  for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    signature.push_back(tensor.allocation_type);
+    if (tensor.allocation_type == kTfLiteArenaRw ||
+        tensor.allocation_type == kTfLiteArenaRwPersistent) {
+      signature.push_back(tensor.bytes);
+      signature.push_back(alloc_node_[i]);
+      signature.push_back(dealloc_node_[i]);
+    }
+  }
+  return signature;
+}
+
+bool ArenaPlanner::RestoreCachedPlan(const std::vector<size_t>& signature) {
+  auto it = std::find_if(
+      cached_plans_.begin(), cached_plans_.end(),
+      [&signature](const CachedPlan& plan) {
+        return plan.signature == signature;
+      });
+  if (it == cached_plans_.end()) {
+    return false;
+  }
+  // Keep the most recently used plans first.
+  std::rotate(cached_plans_.begin(), it, it + 1);
+  const CachedPlan& plan = cached_plans_.front();
+
+  std::vector<ArenaAllocWithUsageInterval> arena_allocs;
+  std::vector<ArenaAllocWithUsageInterval> persistent_arena_allocs;
+  for (int i = 0; i < static_cast<int>(plan.allocs.size()); ++i) {
+    TfLiteAllocationType type = graph_info_->tensor(i)->allocation_type;
+    if (type == kTfLiteArenaRw) {
+      arena_allocs.push_back(plan.allocs[i]);
+    } else if (type == kTfLiteArenaRwPersistent) {
+      persistent_arena_allocs.push_back(plan.allocs[i]);
+    }
+  }
+  if (arena_.RestorePlan(context_, arena_allocs) != kTfLiteOk ||
+      persistent_arena_.RestorePlan(context_, persistent_arena_allocs) !=
+          kTfLiteOk) {
+    return false;
+  }
+  allocs_ = plan.allocs;
+  return true;
+}
+
+void ArenaPlanner::CachePlan(std::vector<size_t> signature) {
+  if (cached_plans_.size() >= kMaxCachedPlans) {
+    cached_plans_.pop_back();
+  }
+  CachedPlan plan;
+  plan.signature = std::move(signature);
+  plan.allocs = allocs_;
+  cached_plans_.insert(cached_plans_.begin(), std::move(plan));
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
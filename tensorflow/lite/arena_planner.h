@@ -43,6 +43,11 @@ struct AllocationInfo;
 // execution. Since dynamic tensors don't have sizes until after the
 // corresponding operation is executed, this class supports incremental
 // planning.
+//
+// When all tensors are allocated at once, the resulting assignment is cached
+// under the sizes of the tensors, so that going back to previously seen input
+// shapes, e.g. with variable length sequences, doesn't calculate it again.
+// The arenas only grow, so they also keep the memory of the largest plan.
 class ArenaPlanner : public MemoryPlanner {
  public:
   // Ownership of 'context' is not taken and it must remain util the
@@ -98,6 +103,26 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Returns the values that determine the assignment of all tensors: their
+  // allocation types, sizes and usage intervals.
+  std::vector<size_t> CreatePlanSignature();
+
+  // If an assignment of all tensors with the given signature was cached,
+  // restores it and returns true.
+  bool RestoreCachedPlan(const std::vector<size_t>& signature);
+
+  // Caches the current assignment of all tensors under `signature`, evicting
+  // the least recently used one if there are kMaxCachedPlans already.
+  void CachePlan(std::vector<size_t> signature);
+
+  // The maximum number of assignments kept by CachePlan().
+  static constexpr int kMaxCachedPlans = 8;
+
+  struct CachedPlan {
+    std::vector<size_t> signature;
+    std::vector<ArenaAllocWithUsageInterval> allocs;
+  };
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -131,6 +156,10 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // Assignments of all tensors, most recently used first. Cleared when the
+  // graph is planned again.
+  std::vector<CachedPlan> cached_plans_;
 };
 
 }  // namespace tflite
@@ -109,6 +109,14 @@ class TestGraph {
     variables_ = variables;
   }
 
+  const std::vector<int>& last_concurrent_nodes() {
+    return last_concurrent_nodes_;
+  }
+
+  void SetLastConcurrentNodes(const std::vector<int>& last_concurrent_nodes) {
+    last_concurrent_nodes_ = last_concurrent_nodes;
+  }
+
   void Swap(TestGraph* other) {
     std::swap(nodes_, other->nodes_);
     std::swap(tensors_, other->tensors_);
@@ -123,6 +131,7 @@ class TestGraph {
   std::vector<int> inputs_;
   std::vector<int> outputs_;
   std::vector<int> variables_;
+  std::vector<int> last_concurrent_nodes_;
 };
 
 // The GraphInfo for a TestGraph.
@@ -145,6 +154,11 @@ class TestGraphInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return graph_->variables();
   }
+  size_t last_concurrent_node(size_t index) const override {
+    return graph_->last_concurrent_nodes().empty()
+               ? index
+               : graph_->last_concurrent_nodes()[index];
+  }
 
  private:
   TestGraph* graph_;
@@ -325,6 +339,61 @@ TEST_F(ArenaPlannerTest, SimpleGraphWithTemporary) {
   EXPECT_EQ(GetOffset(1), 0);
 }
 
+TEST_F(ArenaPlannerTest, ConcurrentNodesDontShareMemory) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},     // First branch
+                      {{1}, {2}, {6}},    // First branch
+                      {{0}, {3}, {}},     // Second branch
+                      {{3}, {4}, {7}},    // Second branch
+                      {{2, 4}, {5}, {}},  // Join
+                  },
+                  {5});
+  // The ops of the first branch may run along with those of the second.
+  graph.SetLastConcurrentNodes({3, 3, 2, 3, 4});
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  for (int first : {1, 2, 6}) {
+    for (int second : {3, 4, 7}) {
+      EXPECT_TRUE(GetOffsetAfter(first) <= GetOffset(second) ||
+                  GetOffsetAfter(second) <= GetOffset(first))
+          << "tensors " << first << " and " << second << " overlap";
+    }
+  }
+}
+
+TEST_F(ArenaPlannerTest, SimpleGraphResizedAndBack) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, 10);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i <= 5; ++i) {
+    offsets.push_back(GetOffset(i));
+  }
+
+  // Growing a tensor moves the ones that shared its memory.
+  (*graph.tensors())[1].bytes = 1000;
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(1), 0);
+  EXPECT_GE(GetOffset(0), GetOffsetAfter(1));
+
+  // The original sizes get the original plan back.
+  (*graph.tensors())[1].bytes = 6;
+  Execute(0, 10);
+  for (int i = 0; i <= 5; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]) << "tensor " << i;
+  }
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphWithResetAllocationsAfter) {
   TestGraph graph({0, 1},
                   {
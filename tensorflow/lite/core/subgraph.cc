@@ -16,13 +16,21 @@ limitations under the License.
 #include "tensorflow/lite/core/subgraph.h"
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
 
 #include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/context_util.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -65,6 +73,11 @@ TfLiteStatus ReportOpError(TfLiteContext* context, const TfLiteNode& node,
   return kTfLiteError;
 }
 
+// The CPU backend context of the inter-op thread running on this thread, if
+// any. Kernels run by inter-op threads use it instead of the interpreter's,
+// which can't be used by several threads at once.
+thread_local ExternalCpuBackendContext* inter_op_cpu_backend_context = nullptr;
+
 // Stub method which returns kTfLiteError when the function is forbidden.
 // We're registering this function to several different function to save
 // compiled binary size. Please note the restrictions:
@@ -154,6 +167,68 @@ TfLiteStatus ValidateCustomAllocationForTensor(
 
 }  // namespace
 
+// A fixed set of threads running the tasks scheduled on it in FIFO order.
+// Kernels size the CPU backend context of every thread with the recommended
+// number of threads at the time they first use it.
+class InterOpThreadPool {
+ public:
+  InterOpThreadPool(int num_threads, int recommended_num_threads)
+      : recommended_num_threads_(recommended_num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  ~InterOpThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int recommended_num_threads() const { return recommended_num_threads_; }
+
+  void Schedule(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  void WorkerLoop() {
+    ExternalCpuBackendContext cpu_backend_context;
+    inter_op_cpu_backend_context = &cpu_backend_context;
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) break;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+    inter_op_cpu_backend_context = nullptr;
+  }
+
+  const int recommended_num_threads_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
 // A trivial implementation of GraphInfo around the Interpreter.
 // NOTE: this interpreter info represents the subset of the
 // graph that is executed according to execution plan. Thus,
@@ -187,6 +262,9 @@ class InterpreterInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return subgraph_->variables();
   }
+  size_t last_concurrent_node(size_t index) const override {
+    return subgraph_->last_concurrent_node(index);
+  }
 
  public:
   Subgraph* subgraph_;
@@ -426,6 +504,10 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
+    if (type == kTfLiteCpuBackendContext &&
+        inter_op_cpu_backend_context != nullptr) {
+      return inter_op_cpu_backend_context;
+    }
     return external_contexts_[type];
   }
   return nullptr;
@@ -554,6 +636,27 @@ bool Subgraph::IsCancelled() {
          (*check_cancelled_func_)(cancellation_data_);
 }
 
+TfLiteStatus Subgraph::SetNumInterOpThreads(int num_threads) {
+  if (num_threads < 1) {
+    ReportError("num_threads should be >= 1.");
+    return kTfLiteError;
+  }
+  if (state_ == kStateInvokableAndImmutable) {
+    ReportError("SetNumInterOpThreads is disallowed when graph is immutable.");
+    return kTfLiteError;
+  }
+  if (num_threads == num_inter_op_threads_) {
+    return kTfLiteOk;
+  }
+  num_inter_op_threads_ = num_threads;
+  inter_op_thread_pool_.reset();
+  // The memory plan depends on which nodes may run concurrently, so it is
+  // redone by the next AllocateTensors().
+  memory_planner_.reset();
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
 void Subgraph::ReserveNodes(int count) {
   nodes_and_registration_.reserve(count);
 }
@@ -690,6 +793,104 @@ TfLiteStatus Subgraph::ResetVariableTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::SnapshotVariableTensors(
+    VariableTensorsSnapshot* snapshot) {
+  snapshot->tensors.clear();
+  snapshot->resource_variables.clear();
+  for (int i = 0; i < tensors_.size(); ++i) {
+    if (!tensors_[i].is_variable) {
+      continue;
+    }
+    TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(i));
+    const TfLiteTensor& tensor = tensors_[i];
+    TF_LITE_ENSURE(&context_, tensor.data.raw != nullptr);
+    snapshot->tensors.emplace_back(tensor.data.raw,
+                                   tensor.data.raw + tensor.bytes);
+  }
+  for (auto& resource : *resources_) {
+    if (!resource.second->IsVariable()) {
+      continue;
+    }
+    const TfLiteTensor* tensor =
+        static_cast<resource::ResourceVariable*>(resource.second.get())
+            ->GetTensor();
+    if (tensor == nullptr) {
+      continue;
+    }
+    ResourceVariableSnapshot& variable =
+        snapshot->resource_variables[resource.first];
+    variable.type = tensor->type;
+    variable.dims.assign(tensor->dims->data,
+                         tensor->dims->data + tensor->dims->size);
+    variable.data.assign(tensor->data.raw, tensor->data.raw + tensor->bytes);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::RestoreVariableTensors(
+    const VariableTensorsSnapshot& snapshot) {
+  // Validate the whole snapshot first, so that a mismatching one leaves the
+  // variables untouched.
+  size_t num_variable_tensors = 0;
+  for (const auto& tensor : tensors_) {
+    if (!tensor.is_variable) {
+      continue;
+    }
+    TF_LITE_ENSURE(&context_,
+                   num_variable_tensors < snapshot.tensors.size());
+    TF_LITE_ENSURE(&context_, snapshot.tensors[num_variable_tensors].size() ==
+                                  tensor.bytes);
+    TF_LITE_ENSURE(&context_, tensor.data.raw != nullptr);
+    TF_LITE_ENSURE(&context_,
+                   tensor.buffer_handle == kTfLiteNullBufferHandle ||
+                       tensor.delegate->CopyToBufferHandle != nullptr);
+    ++num_variable_tensors;
+  }
+  TF_LITE_ENSURE(&context_, num_variable_tensors == snapshot.tensors.size());
+  for (const auto& resource : *resources_) {
+    TF_LITE_ENSURE(&context_,
+                   resource.second->IsVariable() ||
+                       snapshot.resource_variables.count(resource.first) == 0);
+  }
+
+  auto next = snapshot.tensors.begin();
+  for (auto& tensor : tensors_) {
+    if (!tensor.is_variable) {
+      continue;
+    }
+    memcpy(tensor.data.raw, next->data(), tensor.bytes);
+    ++next;
+    if (tensor.buffer_handle != kTfLiteNullBufferHandle) {
+      TfLiteDelegate* delegate = tensor.delegate;
+      TF_LITE_ENSURE_STATUS(delegate->CopyToBufferHandle(
+          &context_, delegate, tensor.buffer_handle, &tensor));
+      tensor.data_is_stale = false;
+    }
+  }
+
+  for (auto& resource : *resources_) {
+    if (resource.second->IsVariable() &&
+        snapshot.resource_variables.count(resource.first) == 0) {
+      resource.second.reset(new resource::ResourceVariable());
+    }
+  }
+  for (const auto& entry : snapshot.resource_variables) {
+    const ResourceVariableSnapshot& variable = entry.second;
+    TfLiteTensor tensor = {};
+    tensor.type = variable.type;
+    tensor.dims = ConvertVectorToTfLiteIntArray(variable.dims);
+    tensor.data.raw = const_cast<char*>(variable.data.data());
+    tensor.bytes = variable.data.size();
+    resource::CreateResourceVariableIfNotAvailable(resources_, entry.first);
+    const TfLiteStatus status =
+        resource::GetResourceVariable(resources_, entry.first)
+            ->AssignFrom(&tensor);
+    TfLiteIntArrayFree(tensor.dims);
+    TF_LITE_ENSURE_STATUS(status);
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::AddNodeWithParameters(
     const std::vector<int>& inputs, const std::vector<int>& outputs,
     const std::vector<int>& intermediates, const char* init_data,
@@ -883,6 +1084,7 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
         /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
         kDefaultTensorAlignment));
+    PlanInterOpSchedule();
     memory_planner_->PlanAllocations();
   }
 
@@ -961,6 +1163,10 @@ TfLiteStatus Subgraph::Invoke() {
     applied_nnapi_delegate_ = true;
   }
 
+  if (CanInvokeInterOp()) {
+    return InvokeInterOp();
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1034,6 +1240,193 @@ TfLiteStatus Subgraph::Invoke() {
   return status;
 }
 
+void Subgraph::PlanInterOpSchedule() {
+  inter_op_execution_plan_.clear();
+  node_successors_.clear();
+  node_num_predecessors_.clear();
+  last_concurrent_node_.clear();
+  if (num_inter_op_threads_ <= 1 || HasDelegates()) {
+    return;
+  }
+
+  const int num_nodes = execution_plan_.size();
+  node_successors_.resize(num_nodes);
+  node_num_predecessors_.assign(num_nodes, 0);
+
+  // The accesses to every tensor are ordered: a node reading a tensor depends
+  // on the node that last wrote it, and a node writing a tensor also depends
+  // on the nodes that read it since. Variable tensors are updated in place by
+  // the nodes reading them.
+  std::vector<int> last_writer(tensors_.size(), -1);
+  std::vector<std::vector<int>> readers(tensors_.size());
+  // Custom ops and control flow ops may share state outside of their tensors,
+  // so they are ordered with respect to all other nodes.
+  int last_barrier = -1;
+  std::vector<int> nodes_since_barrier;
+  std::vector<int> predecessors;
+  for (int i = 0; i < num_nodes; ++i) {
+    const auto& node_and_registration =
+        nodes_and_registration_[execution_plan_[i]];
+    const TfLiteNode& node = node_and_registration.first;
+    const int builtin_code = node_and_registration.second.builtin_code;
+    const bool is_barrier = builtin_code == kTfLiteBuiltinCustom ||
+                            builtin_code == kTfLiteBuiltinIf ||
+                            builtin_code == kTfLiteBuiltinWhile;
+
+    predecessors.clear();
+    if (last_barrier >= 0) {
+      predecessors.push_back(last_barrier);
+    }
+    if (is_barrier) {
+      predecessors.insert(predecessors.end(), nodes_since_barrier.begin(),
+                          nodes_since_barrier.end());
+    }
+    auto write = [&](int tensor_index) {
+      if (last_writer[tensor_index] >= 0) {
+        predecessors.push_back(last_writer[tensor_index]);
+      }
+      predecessors.insert(predecessors.end(), readers[tensor_index].begin(),
+                          readers[tensor_index].end());
+      readers[tensor_index].clear();
+      last_writer[tensor_index] = i;
+    };
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      if (tensors_[tensor_index].is_variable) {
+        write(tensor_index);
+        continue;
+      }
+      if (last_writer[tensor_index] >= 0) {
+        predecessors.push_back(last_writer[tensor_index]);
+      }
+      readers[tensor_index].push_back(i);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      write(tensor_index);
+    }
+
+    std::sort(predecessors.begin(), predecessors.end());
+    predecessors.erase(std::unique(predecessors.begin(), predecessors.end()),
+                       predecessors.end());
+    for (int predecessor : predecessors) {
+      if (predecessor == i) continue;
+      node_successors_[predecessor].push_back(i);
+      ++node_num_predecessors_[i];
+    }
+    if (is_barrier) {
+      last_barrier = i;
+      nodes_since_barrier.clear();
+    } else {
+      nodes_since_barrier.push_back(i);
+    }
+  }
+
+  // Walks the plan backwards, collecting the set of nodes that transitively
+  // depend on every node as a bit set over execution plan indices. The last
+  // node that is not in the set may run concurrently with it.
+  const int num_words = (num_nodes + 63) / 64;
+  std::vector<std::vector<uint64_t>> dependents(
+      num_nodes, std::vector<uint64_t>(num_words, 0));
+  last_concurrent_node_.resize(num_nodes);
+  for (int i = num_nodes - 1; i >= 0; --i) {
+    std::vector<uint64_t>& node_dependents = dependents[i];
+    for (int successor : node_successors_[i]) {
+      node_dependents[successor / 64] |= uint64_t{1} << (successor % 64);
+      for (int word = successor / 64; word < num_words; ++word) {
+        node_dependents[word] |= dependents[successor][word];
+      }
+    }
+    int last = num_nodes - 1;
+    while (last > i && ((node_dependents[last / 64] >> (last % 64)) & 1)) {
+      --last;
+    }
+    last_concurrent_node_[i] = last;
+  }
+  inter_op_execution_plan_ = execution_plan_;
+}
+
+bool Subgraph::CanInvokeInterOp() const {
+  return !last_concurrent_node_.empty() &&
+         inter_op_execution_plan_ == execution_plan_ &&
+         delegates_applied_.empty() && profiler_ == nullptr &&
+         !has_dynamic_tensors_ &&
+         next_execution_plan_index_to_prepare_ == execution_plan_.size();
+}
+
+TfLiteStatus Subgraph::InvokeInterOp() {
+  if (inter_op_thread_pool_ == nullptr ||
+      inter_op_thread_pool_->recommended_num_threads() !=
+          context_.recommended_num_threads) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(
+        num_inter_op_threads_, context_.recommended_num_threads));
+  }
+  EnsureTensorsVectorCapacity();
+
+  std::mutex mu;
+  std::condition_variable all_done;
+  std::vector<int> num_pending_predecessors = node_num_predecessors_;
+  int num_running = 0;
+  int failed_execution_plan_index = -1;
+  bool cancelled = false;
+
+  std::function<void(int)> run_node;
+  // Must be called with `mu` held.
+  auto schedule = [&](int execution_plan_index) {
+    ++num_running;
+    inter_op_thread_pool_->Schedule(
+        [&run_node, execution_plan_index] { run_node(execution_plan_index); });
+  };
+  run_node = [&](int execution_plan_index) {
+    int node_index = execution_plan_[execution_plan_index];
+    TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    const bool is_cancelled = IsCancelled();
+    const bool ok =
+        !is_cancelled && OpInvoke(registration, &node) == kTfLiteOk;
+
+    std::lock_guard<std::mutex> lock(mu);
+    if (!ok && failed_execution_plan_index < 0) {
+      failed_execution_plan_index = execution_plan_index;
+      cancelled = is_cancelled;
+    }
+    // Nodes that haven't started yet are dropped after a failure.
+    if (failed_execution_plan_index < 0) {
+      for (int successor : node_successors_[execution_plan_index]) {
+        if (--num_pending_predecessors[successor] == 0) {
+          schedule(successor);
+        }
+      }
+    }
+    if (--num_running == 0) {
+      all_done.notify_one();
+    }
+  };
+
+  {
+    std::unique_lock<std::mutex> lock(mu);
+    for (int i = 0; i < execution_plan_.size(); ++i) {
+      if (num_pending_predecessors[i] == 0) {
+        schedule(i);
+      }
+    }
+    all_done.wait(lock, [&] { return num_running == 0; });
+  }
+
+  if (failed_execution_plan_index >= 0) {
+    if (cancelled) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+    int node_index = execution_plan_[failed_execution_plan_index];
+    return ReportOpError(&context_, nodes_and_registration_[node_index].first,
+                         nodes_and_registration_[node_index].second,
+                         node_index, "failed to invoke");
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -1402,6 +1795,7 @@ void Subgraph::EnsureTensorsVectorCapacity() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    PlanInterOpSchedule();
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
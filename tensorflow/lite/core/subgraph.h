@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 #include <cstdlib>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -41,6 +42,9 @@ namespace impl {
 // Forward declare since NNAPIDelegate uses Interpreter.
 class NNAPIDelegate;
 
+// Runs the nodes of a subgraph with inter-op parallelism enabled.
+class InterOpThreadPool;
+
 class Subgraph {
  public:
   friend class Interpreter;
@@ -137,6 +141,14 @@ class Subgraph {
   // Overrides execution plan. This bounds checks indices sent in.
   TfLiteStatus SetExecutionPlan(const std::vector<int>& new_plan);
 
+  // WARNING: Experimental interface, subject to change
+  // Allocates a buffer of `bytes` bytes that lives as long as the subgraph,
+  // e.g. to back read-only tensors computed when the graph is loaded.
+  char* AllocateOwnedBuffer(size_t bytes) {
+    owned_buffers_.emplace_back(new char[bytes]);
+    return owned_buffers_.back().get();
+  }
+
   // Get a mutable tensor data structure.
   // TODO(aselle): Create a safe ArrayHandle interface to avoid exposing this
   // read/write access to structure
@@ -276,6 +288,32 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  // Sets the number of threads that run independent nodes of the execution
+  // plan concurrently. With 1, the default, nodes run one at a time on the
+  // thread calling Invoke().
+  //
+  // Nodes that use no common tensors may then run in any order. Custom, If
+  // and While ops, which may share state outside their tensors, still run
+  // alone. Invocations fall back to sequential execution when delegates are
+  // applied, when a profiler is set, or when tensors are dynamic. Each thread
+  // uses its own CPU backend context, so SetNumThreads() bounds the threads
+  // every node may use in addition.
+  //
+  // The memory plan is redone so that concurrently running nodes never share
+  // memory; AllocateTensors() must be called before the next Invoke().
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  // Returns the largest execution plan index of a node that may run
+  // concurrently with the node at `execution_plan_index`. All nodes after it
+  // depend on that node.
+  // WARNING: This is an experimental API and subject to change.
+  int last_concurrent_node(int execution_plan_index) const {
+    return execution_plan_index < last_concurrent_node_.size()
+               ? last_concurrent_node_[execution_plan_index]
+               : execution_plan_index;
+  }
+
   // Ensure the data in `tensor.data` is readable. In case delegate is used,
   // it might require to copy the data from delegate buffer to raw memory.
   // WARNING: This is an experimental API and subject to change.
@@ -310,6 +348,35 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   TfLiteStatus ResetVariableTensors();
 
+  // The contents of an initialized resource variable.
+  struct ResourceVariableSnapshot {
+    TfLiteType type;
+    std::vector<int> dims;
+    std::vector<char> data;
+  };
+
+  // The contents of the variable tensors of a subgraph and of the resource
+  // variables it shares with the other subgraphs.
+  struct VariableTensorsSnapshot {
+    // In tensor index order.
+    std::vector<std::vector<char>> tensors;
+    // By resource id. Uninitialized resource variables are left out.
+    std::map<int, ResourceVariableSnapshot> resource_variables;
+  };
+
+  // Copies the contents of all variable tensors and resource variables to
+  // `snapshot`. Variable tensors held by a delegate are read back from it.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SnapshotVariableTensors(VariableTensorsSnapshot* snapshot);
+
+  // Sets the contents of all variable tensors and resource variables from a
+  // `snapshot` taken by SnapshotVariableTensors with the same variable tensor
+  // sizes. Resource variables missing from `snapshot` are reset to their
+  // uninitialized state. Variable tensors held by a delegate are copied to
+  // it. Nothing is changed if `snapshot` does not match the variable tensors.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus RestoreVariableTensors(const VariableTensorsSnapshot& snapshot);
+
   void SetProfiler(Profiler* profiler, int associated_subgraph_idx) {
     if (!profiler) {
       profiler_.reset(nullptr);
@@ -437,6 +504,18 @@ class Subgraph {
   // to wait until Invoke() to resolve the sizes of dynamic tensors.
   TfLiteStatus PrepareOpsAndTensors();
 
+  // Computes the dependencies between the nodes of the execution plan that
+  // are used to run them concurrently, or clears them if inter-op parallelism
+  // is disabled. Must be called before the memory planner plans allocations.
+  void PlanInterOpSchedule();
+
+  // Returns true if the next Invoke() may run nodes concurrently.
+  bool CanInvokeInterOp() const;
+
+  // Runs the execution plan on the inter-op thread pool, starting every node
+  // as soon as the nodes it depends on have finished.
+  TfLiteStatus InvokeInterOp();
+
   // Call OpPrepare() for all ops starting at 'first_node'. Stop when a
   // dynamic tensors is found or all ops have been prepared. Fill
   // 'last_node_prepared' with the id of the op containing dynamic tensors, or
@@ -649,6 +728,9 @@ class Subgraph {
   // Array of indices representing the tensors that are variable tensors.
   std::vector<int> variables_;
 
+  // Buffers allocated by AllocateOwnedBuffer().
+  std::vector<std::unique_ptr<char[]>> owned_buffers_;
+
   // The error reporter delegate that tflite will forward queries errors to.
   ErrorReporter* error_reporter_;
 
@@ -737,6 +819,24 @@ class Subgraph {
 
   // A map of resources. Owned by interpreter and shared by multiple subgraphs.
   resource::ResourceMap* resources_ = nullptr;
+
+  // Number of threads that run independent nodes concurrently.
+  int num_inter_op_threads_ = 1;
+
+  // The execution plan the inter-op schedule below was computed for.
+  std::vector<int> inter_op_execution_plan_;
+
+  // For every node of the execution plan, the execution plan indices of the
+  // nodes that directly depend on it, and the number of nodes it directly
+  // depends on.
+  std::vector<std::vector<int>> node_successors_;
+  std::vector<int> node_num_predecessors_;
+
+  // See last_concurrent_node(). Empty if inter-op parallelism is disabled.
+  std::vector<int> last_concurrent_node_;
+
+  // Created on the first Invoke() that runs nodes concurrently.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
 };
 
 }  // namespace impl
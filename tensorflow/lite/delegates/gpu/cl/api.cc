@@ -852,7 +852,8 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
       // Ignore returned error. Cache is discarded.
       environment_.program_cache()
           ->AddSerializedCache(environment_.context(), environment_.device(),
-                               options_.serialized_binary_cache)
+                               options_.serialized_binary_cache,
+                               options_.model_token)
           .IgnoreError();
     }
 
@@ -868,7 +869,8 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
     std::vector<uint8_t> data;
     // Is there was a problem, data would be empty.
     environment_.program_cache()
-        ->GetSerializedCache(environment_.device(), &data)
+        ->GetSerializedCache(environment_.device(), &data,
+                             options_.model_token)
         .IgnoreError();
     return data;
   }
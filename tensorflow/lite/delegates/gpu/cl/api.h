@@ -24,6 +24,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/types/span.h"
 #include "tensorflow/lite/delegates/gpu/api.h"
@@ -110,6 +111,11 @@ struct InferenceEnvironmentOptions {
   // incompatible when GPU driver is updated.
   absl::Span<const uint8_t> serialized_binary_cache;
 
+  // Optional application-provided identifier of the model, e.g. a hash of the
+  // model file. It is stored in the serialized binary cache, and a cache
+  // created with a different token is discarded.
+  std::string model_token;
+
   bool IsGlAware() const {
     return egl_context != EGL_NO_CONTEXT && egl_display != EGL_NO_DISPLAY;
   }
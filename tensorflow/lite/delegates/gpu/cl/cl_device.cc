@@ -325,6 +325,14 @@ std::string CLDevice::GetPlatformVersion() const {
   return GetPlatformInfo(platform_id_, CL_PLATFORM_VERSION);
 }
 
+std::string CLDevice::GetDeviceName() const {
+  return GetDeviceInfo<std::string>(id_, CL_DEVICE_NAME);
+}
+
+std::string CLDevice::GetDriverVersion() const {
+  return GetDeviceInfo<std::string>(id_, CL_DRIVER_VERSION);
+}
+
 bool CLDevice::IsCL20OrHigher() const { return info_.IsCL20OrHigher(); }
 
 bool CLDevice::SupportsSubGroupWithSize(int sub_group_size) const {
@@ -45,6 +45,8 @@ class CLDevice {
   cl_device_id id() const { return id_; }
   cl_platform_id platform() const { return platform_id_; }
   std::string GetPlatformVersion() const;
+  std::string GetDeviceName() const;
+  std::string GetDriverVersion() const;
 
   Vendor vendor() const { return info_.vendor; }
   OpenCLVersion cl_version() const { return info_.cl_version; }
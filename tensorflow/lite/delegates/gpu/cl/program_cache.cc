@@ -84,7 +84,8 @@ absl::Status ProgramCache::GetOrCreateCLKernel(const std::string& code,
 
 absl::Status ProgramCache::AddSerializedCache(
     const CLContext& context, const CLDevice& device,
-    absl::Span<const uint8_t> serialized_cache) {
+    absl::Span<const uint8_t> serialized_cache,
+    const std::string& model_token) {
   flatbuffers::Verifier verifier(serialized_cache.data(),
                                  serialized_cache.size());
   if (!data::VerifyCompiledCacheBuffer(verifier)) {
@@ -92,13 +93,20 @@ absl::Status ProgramCache::AddSerializedCache(
   }
 
   auto model = data::GetCompiledCache(serialized_cache.data());
-  std::string platform_version(model->driver_version()->c_str(),
-                               model->driver_version()->size());
-
-  if (device.GetPlatformVersion() != platform_version) {
+  auto to_string = [](const flatbuffers::String* s) {
+    return s ? std::string(s->c_str(), s->size()) : std::string();
+  };
+  if (device.GetPlatformVersion() != to_string(model->driver_version()) ||
+      device.GetDeviceName() != to_string(model->device_name()) ||
+      device.GetDriverVersion() !=
+          to_string(model->device_driver_version())) {
     return absl::InvalidArgumentError(
         "OpenCL driver changed, cache invalid, should be regenerated");
   }
+  if (model_token != to_string(model->model_token())) {
+    return absl::InvalidArgumentError(
+        "Cache was created for a different model, should be regenerated");
+  }
 
   use_fingerprints_ = true;
 
@@ -119,7 +127,8 @@ absl::Status ProgramCache::AddSerializedCache(
 }
 
 absl::Status ProgramCache::GetSerializedCache(
-    const CLDevice& device, std::vector<uint8_t>* serialized_cache) const {
+    const CLDevice& device, std::vector<uint8_t>* serialized_cache,
+    const std::string& model_token) const {
   ::flatbuffers::FlatBufferBuilder builder;
   std::vector<flatbuffers::Offset<data::Program>> serialized_programs;
   for (auto& program : programs_) {
@@ -132,10 +141,16 @@ absl::Status ProgramCache::GetSerializedCache(
     serialized_programs.push_back(program_builder.Finish());
   }
   auto driver_version = builder.CreateString(device.GetPlatformVersion());
+  auto device_name = builder.CreateString(device.GetDeviceName());
+  auto device_driver_version = builder.CreateString(device.GetDriverVersion());
+  auto model_token_s = builder.CreateString(model_token);
   auto programs_s = builder.CreateVector(serialized_programs);
   data::CompiledCacheBuilder cache_builder(builder);
   cache_builder.add_driver_version(driver_version);
   cache_builder.add_programs(programs_s);
+  cache_builder.add_device_name(device_name);
+  cache_builder.add_device_driver_version(device_driver_version);
+  cache_builder.add_model_token(model_token_s);
   data::FinishCompiledCacheBuffer(builder, cache_builder.Finish());
   size_t next_element = serialized_cache->size();
   serialized_cache->resize(serialized_cache->size() + builder.GetSize());
@@ -51,11 +51,19 @@ class ProgramCache {
                                    const CLContext& context,
                                    const CLDevice& device, CLKernel* result);
 
+  // Adds programs from a cache serialized with GetSerializedCache. The cache is
+  // rejected unless it was created for the same device, driver and
+  // 'model_token'.
   absl::Status AddSerializedCache(const CLContext& context,
                                   const CLDevice& device,
-                                  absl::Span<const uint8_t> serialized_cache);
+                                  absl::Span<const uint8_t> serialized_cache,
+                                  const std::string& model_token = "");
+  // Appends binaries of all programs in the cache to 'serialized_cache'.
+  // 'model_token' is an optional application-provided identifier of the
+  // model, e.g. a hash of the model file.
   absl::Status GetSerializedCache(const CLDevice& device,
-                                  std::vector<uint8_t>* serialized_cache) const;
+                                  std::vector<uint8_t>* serialized_cache,
+                                  const std::string& model_token = "") const;
 
  private:
   struct ProgramDescriptor {
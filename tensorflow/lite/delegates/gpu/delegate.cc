@@ -17,7 +17,9 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -80,6 +82,20 @@ class Delegate {
     if (options_.max_delegated_partitions <= 0) {
       options_.max_delegated_partitions = 1;
     }
+    // Copy the optional cache and token, so that the caller's buffers do not
+    // need to outlive the delegate.
+    if (options_.serialized_binary_cache_data) {
+      serialized_binary_cache_.assign(
+          options_.serialized_binary_cache_data,
+          options_.serialized_binary_cache_data +
+              options_.serialized_binary_cache_size);
+    }
+    if (options_.model_token) {
+      model_token_ = options_.model_token;
+    }
+    options_.serialized_binary_cache_data = nullptr;
+    options_.serialized_binary_cache_size = 0;
+    options_.model_token = nullptr;
   }
 
   TfLiteDelegate* tflite_delegate() { return &delegate_; }
@@ -94,6 +110,17 @@ class Delegate {
   }
   int num_delegate_kernels() const { return num_delegate_kernels_; }
 
+  // Serialized OpenCL binary cache. Each OpenCL delegate kernel loads it and
+  // replaces it with its own cache, so that it accumulates the programs of
+  // all kernels.
+  const std::vector<uint8_t>& serialized_binary_cache() const {
+    return serialized_binary_cache_;
+  }
+  void set_serialized_binary_cache(std::vector<uint8_t> cache) {
+    serialized_binary_cache_ = std::move(cache);
+  }
+  const std::string& model_token() const { return model_token_; }
+
  private:
   TfLiteDelegate delegate_ = {
       .data_ = reinterpret_cast<void*>(this),
@@ -106,6 +133,8 @@ class Delegate {
 
   TfLiteGpuDelegateOptionsV2 options_;
   int num_delegate_kernels_ = 0;
+  std::vector<uint8_t> serialized_binary_cache_;
+  std::string model_token_;
 
   friend class DelegateKernel;
 };
@@ -288,6 +317,8 @@ class DelegateKernel {
                                    bool* graph_is_destroyed) {
     *graph_is_destroyed = false;
     cl::InferenceEnvironmentOptions env_options;
+    env_options.serialized_binary_cache = delegate_->serialized_binary_cache();
+    env_options.model_token = delegate_->model_token();
     cl::InferenceEnvironmentProperties properties;
     RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
                                                 &properties));
@@ -311,6 +342,14 @@ class DelegateKernel {
     *graph_is_destroyed = true;
     RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
         options, std::move(*graph), builder));
+    // Programs are compiled by now. An empty cache means serialization failed,
+    // in which case the previous one is kept.
+    std::vector<uint8_t> serialized_binary_cache =
+        cl_environment_->GetSerializedBinaryCache();
+    if (!serialized_binary_cache.empty()) {
+      delegate_->set_serialized_binary_cache(
+          std::move(serialized_binary_cache));
+    }
     TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                          "Initialized OpenCL-based API.");
     return absl::OkStatus();
@@ -450,6 +489,9 @@ TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default() {
       .inference_priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO,
       .experimental_flags = TFLITE_GPU_EXPERIMENTAL_FLAGS_NONE,
       .max_delegated_partitions = 1,
+      .serialized_binary_cache_data = nullptr,
+      .serialized_binary_cache_size = 0,
+      .model_token = nullptr,
   };
   return options;
 }
@@ -465,3 +507,20 @@ TfLiteDelegate* TfLiteGpuDelegateV2Create(
 void TfLiteGpuDelegateV2Delete(TfLiteDelegate* delegate) {
   delete tflite::gpu::GetDelegate(delegate);
 }
+
+bool TfLiteGpuDelegateV2GetSerializedBinaryCache(TfLiteDelegate* delegate,
+                                                 size_t* size,
+                                                 const uint8_t** data) {
+  *size = 0;
+  auto* gpu_delegate = tflite::gpu::GetDelegate(delegate);
+  if (!gpu_delegate) {
+    return false;
+  }
+  const std::vector<uint8_t>& cache = gpu_delegate->serialized_binary_cache();
+  if (cache.empty()) {
+    return false;
+  }
+  *size = cache.size();
+  *data = cache.data();
+  return true;
+}
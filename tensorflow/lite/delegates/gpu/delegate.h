@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_DELEGATES_GPU_DELEGATE_H_
 #define TENSORFLOW_LITE_DELEGATES_GPU_DELEGATE_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "tensorflow/lite/c/common.h"
@@ -100,6 +101,21 @@ typedef struct {
   // This limits the maximum number of partitions to be delegated. By default,
   // it's set to 1 in TfLiteGpuDelegateOptionsV2Default().
   int32_t max_delegated_partitions;
+
+  // [Optional] OpenCL only.
+  // Contains data returned from TfLiteGpuDelegateV2GetSerializedBinaryCache
+  // call, which is copied when the delegate is created. Programs found in the
+  // cache are loaded instead of being compiled from source, which reduces
+  // initialization time. Invalid or incompatible data will be discarded.
+  // Compiled binary may become incompatible when GPU driver is updated.
+  const uint8_t* serialized_binary_cache_data;
+  size_t serialized_binary_cache_size;
+
+  // [Optional] OpenCL only.
+  // Application-provided identifier of the model, e.g. a hash of the model
+  // file. It is stored in the serialized binary cache, and a cache created for
+  // a different token is discarded.
+  const char* model_token;
 } TfLiteGpuDelegateOptionsV2;
 
 // Populates TfLiteGpuDelegateOptionsV2 as follows:
@@ -123,6 +139,17 @@ TFL_CAPI_EXPORT TfLiteDelegate* TfLiteGpuDelegateV2Create(
 // Destroys a delegate created with `TfLiteGpuDelegateV2Create` call.
 TFL_CAPI_EXPORT void TfLiteGpuDelegateV2Delete(TfLiteDelegate* delegate);
 
+// Returns opaque binary blob that contains a collection of OpenCL binaries
+// compiled so far by the delegate, including those loaded from
+// `serialized_binary_cache_data`. Returned data could be re-used later to speed
+// up initialization time when new delegate is created for the same model.
+// Returned data is valid only if used on the same device and driver, otherwise
+// it will not be compatible and will be discarded. Returns false if the
+// OpenCL backend is not in use. The data is owned by the delegate and remains
+// valid until the delegate is destroyed or applied to another graph.
+TFL_CAPI_EXPORT bool TfLiteGpuDelegateV2GetSerializedBinaryCache(
+    TfLiteDelegate* delegate, size_t* size, const uint8_t** data);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
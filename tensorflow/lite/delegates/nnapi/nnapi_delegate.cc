@@ -26,8 +26,10 @@ limitations under the License.
 #include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -660,6 +662,90 @@ NNMemory::~NNMemory() {
 #endif
 }
 
+NNAsyncExecution::~NNAsyncExecution() {
+  Wait();
+  nnapi_->ANeuralNetworksEvent_free(event_);
+}
+
+int NNAsyncExecution::Wait() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (execution_ != nullptr) {
+    result_ = nnapi_->ANeuralNetworksEvent_wait(event_);
+    nnapi_->ANeuralNetworksExecution_free(execution_);
+    execution_ = nullptr;
+  }
+  return result_;
+}
+
+namespace {
+
+// Tracks the last asynchronous execution accessing each NNAPI memory, across
+// all NNAPI delegate instances in the process, so that later executions
+// accessing the same memory can be ordered after it.
+class MemoryAccessTracker {
+ public:
+  static MemoryAccessTracker& GetInstance() {
+    static MemoryAccessTracker* instance = new MemoryAccessTracker;
+    return *instance;
+  }
+
+  // Returns the executions that last accessed any of 'memories' and may still
+  // be running.
+  std::vector<std::shared_ptr<NNAsyncExecution>> GetExecutions(
+      const std::vector<const ANeuralNetworksMemory*>& memories) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<NNAsyncExecution>> executions;
+    for (const ANeuralNetworksMemory* memory : memories) {
+      const auto it = last_executions_.find(memory);
+      if (it == last_executions_.end()) continue;
+      std::shared_ptr<NNAsyncExecution> execution = it->second.lock();
+      if (execution &&
+          std::find(executions.begin(), executions.end(), execution) ==
+              executions.end()) {
+        executions.push_back(std::move(execution));
+      }
+    }
+    return executions;
+  }
+
+  // Records 'execution' as the last one accessing 'memories'. The tracker does
+  // not extend the lifetime of the execution, which is owned by the kernel
+  // that scheduled it.
+  void SetExecution(const std::vector<const ANeuralNetworksMemory*>& memories,
+                    const std::shared_ptr<NNAsyncExecution>& execution) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = last_executions_.begin(); it != last_executions_.end();) {
+      if (it->second.expired()) {
+        it = last_executions_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (const ANeuralNetworksMemory* memory : memories) {
+      last_executions_[memory] = execution;
+    }
+  }
+
+  // Waits for the executions that last accessed any of 'memories'. Returns the
+  // first error code, if any of them failed.
+  int Wait(const std::vector<const ANeuralNetworksMemory*>& memories) {
+    int result = ANEURALNETWORKS_NO_ERROR;
+    for (const auto& execution : GetExecutions(memories)) {
+      const int execution_result = execution->Wait();
+      if (result == ANEURALNETWORKS_NO_ERROR) result = execution_result;
+    }
+    return result;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<const ANeuralNetworksMemory*,
+                     std::weak_ptr<NNAsyncExecution>>
+      last_executions_;
+};
+
+}  // namespace
+
 class DequantizeMapping {
  public:
   int DequantizedAnnIndex(int ann_index, TfLiteType type) const {
@@ -3622,6 +3708,17 @@ TfLiteStatus NNAPIDelegateKernel::Prepare(TfLiteContext* context,
                                   "completing NNAPI compilation", nnapi_errno);
   nn_compilation_.reset(compilation);
 
+  if (delegate_options.use_burst_computation &&
+      nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 &&
+      nnapi_->ANeuralNetworksBurst_create) {
+    ANeuralNetworksBurst* burst = nullptr;
+    RETURN_TFLITE_ERROR_IF_NN_ERROR(
+        context,
+        nnapi_->ANeuralNetworksBurst_create(nn_compilation_.get(), &burst),
+        "creating NNAPI burst", nnapi_errno);
+    nn_burst_.reset(burst);
+  }
+
   return kTfLiteOk;
 }
 
@@ -3670,6 +3767,15 @@ TfLiteStatus NNAPIDelegateKernel::GetOperationsSupportedByTargetNnApiDevices(
 
 TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
                                          TfLiteNode* node, int* nnapi_errno) {
+  // Report the result of the previous asynchronous execution, if any.
+  if (async_execution_) {
+    const int previous_result = async_execution_->Wait();
+    async_execution_.reset();
+    RETURN_TFLITE_ERROR_IF_NN_ERROR(context, previous_result,
+                                    "waiting for async computation completion",
+                                    nnapi_errno);
+  }
+
   ANeuralNetworksExecution* execution = nullptr;
   RETURN_TFLITE_ERROR_IF_NN_ERROR(context,
                                   nnapi_->ANeuralNetworksExecution_create(
@@ -3698,6 +3804,40 @@ TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
           "setting execution loop timeout", nnapi_errno);
     }
   }
+
+  // Collect the NNAPI memories bound to inputs and outputs. The execution is
+  // only scheduled asynchronously if no data has to be copied between the CPU
+  // and NNAPI.
+  std::vector<const ANeuralNetworksMemory*> execution_memories;
+  bool all_io_in_nnapi_memory =
+      model_state_tfl_inputs_.empty() && feedback_loops_.empty();
+  auto collect_memory = [&](int tensor_index) {
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    if (tensor.buffer_handle != kTfLiteNullBufferHandle &&
+        tensor.buffer_handle < tensor_memory_map_->size()) {
+      execution_memories.push_back(
+          tensor_memory_map_->at(tensor.buffer_handle).memory);
+    } else {
+      all_io_in_nnapi_memory = false;
+    }
+  };
+  for (int i : TfLiteIntArrayView(node->inputs)) {
+    if (i != kTfLiteOptionalTensor &&
+        context->tensors[i].allocation_type != kTfLiteMmapRo &&
+        operand_mapping_.lite_index_to_ann(i) != -1) {
+      collect_memory(i);
+    }
+  }
+  for (int i : TfLiteIntArrayView(node->outputs)) {
+    if (operand_mapping_.lite_index_to_ann(i) != -1) {
+      collect_memory(i);
+    }
+  }
+  const bool use_async_execution =
+      delegate_options.use_async_execution && all_io_in_nnapi_memory &&
+      nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI13 &&
+      nnapi_->ANeuralNetworksExecution_startComputeWithDependencies;
+
   // Check if the size of input and output memory pool needs to be resized.
   if (delegate_options.allow_dynamic_dimensions) {
     size_t total_input_byte_size = 0;
@@ -3913,6 +4053,39 @@ TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
         "associating NNAPI execution output to a buffer", nnapi_errno);
     relative_output_index++;
   }
+  if (use_async_execution) {
+    // Order the execution after the ones still accessing the same memories,
+    // without waiting for them on the CPU.
+    const auto dependencies =
+        MemoryAccessTracker::GetInstance().GetExecutions(execution_memories);
+    std::vector<const ANeuralNetworksEvent*> dependency_events;
+    dependency_events.reserve(dependencies.size());
+    for (const auto& dependency : dependencies) {
+      dependency_events.push_back(dependency->event());
+    }
+    ANeuralNetworksEvent* event = nullptr;
+    RETURN_TFLITE_ERROR_IF_NN_ERROR(
+        context,
+        nnapi_->ANeuralNetworksExecution_startComputeWithDependencies(
+            execution, dependency_events.data(), dependency_events.size(),
+            /*duration=*/0, &event),
+        "starting async computation with dependencies", nnapi_errno);
+    async_execution_ = std::make_shared<NNAsyncExecution>(
+        nnapi_, execution_unique_ptr.release(), event);
+    MemoryAccessTracker::GetInstance().SetExecution(execution_memories,
+                                                    async_execution_);
+    // All outputs are in NNAPI memory, so there is nothing to copy back.
+    return kTfLiteOk;
+  }
+
+  // Synchronous executions wait on the CPU for asynchronous ones accessing the
+  // same memories.
+  if (!execution_memories.empty()) {
+    RETURN_TFLITE_ERROR_IF_NN_ERROR(
+        context, MemoryAccessTracker::GetInstance().Wait(execution_memories),
+        "waiting for async computations accessing NNAPI memory", nnapi_errno);
+  }
+
   // Invoke ANN in blocking fashion.
   if (nnapi_->android_sdk_version < kMinSdkVersionForNNAPI12) {
     ANeuralNetworksEvent* event = nullptr;
@@ -3925,6 +4098,12 @@ TfLiteStatus NNAPIDelegateKernel::Invoke(TfLiteContext* context,
     RETURN_TFLITE_ERROR_IF_NN_ERROR(context, wait_result,
                                     "waiting for async computation completion",
                                     nnapi_errno);
+  } else if (nn_burst_) {
+    RETURN_TFLITE_ERROR_IF_NN_ERROR(
+        context,
+        nnapi_->ANeuralNetworksExecution_burstCompute(execution,
+                                                      nn_burst_.get()),
+        "running burst computation", nnapi_errno);
   } else {
     // Use synchronous execution for NNAPI 1.2+.
     RETURN_TFLITE_ERROR_IF_NN_ERROR(
@@ -4586,6 +4765,8 @@ StatefulNnApiDelegate::StatefulNnApiDelegate(const NnApi* nnapi,
   if (nnapi->android_sdk_version >= kMinSdkVersionForNNAPI11) {
     delegate_data_.allow_dynamic_dimensions = options.allow_dynamic_dimensions;
   }
+  delegate_data_.use_burst_computation = options.use_burst_computation;
+  delegate_data_.use_async_execution = options.use_async_execution;
   TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                        "Created TensorFlow Lite delegate for NNAPI.");
   Prepare = DoPrepare;
@@ -4628,6 +4809,8 @@ const StatefulNnApiDelegate::Options StatefulNnApiDelegate::GetOptions(
   options.max_execution_loop_timeout_duration_ns =
       delegate_data->max_execution_loop_timeout_duration_ns;
   options.allow_dynamic_dimensions = delegate_data->allow_dynamic_dimensions;
+  options.use_burst_computation = delegate_data->use_burst_computation;
+  options.use_async_execution = delegate_data->use_async_execution;
   return options;
 }
 
@@ -4668,6 +4851,10 @@ TfLiteStatus StatefulNnApiDelegate::DoCopyFromBufferHandle(
   if (!memory || !callback) {
     return kTfLiteError;
   }
+  if (delegate::nnapi::MemoryAccessTracker::GetInstance().Wait({memory}) !=
+      ANEURALNETWORKS_NO_ERROR) {
+    return kTfLiteError;
+  }
   return callback(tensor, memory, 0, tensor->bytes, callback_context);
 }
 
@@ -4682,6 +4869,9 @@ void StatefulNnApiDelegate::DoFreeBufferHandle(TfLiteContext* context,
                                                TfLiteBufferHandle* handle) {
   auto delegate_data = reinterpret_cast<Data*>(delegate->data_);
   if (*handle >= 0 && *handle < delegate_data->tensor_memory_map.size()) {
+    // The memory must not be released while executions still access it.
+    delegate::nnapi::MemoryAccessTracker::GetInstance().Wait(
+        {delegate_data->tensor_memory_map[*handle].memory});
     delegate_data->tensor_memory_map[*handle] = {nullptr, nullptr, nullptr};
     *handle = kTfLiteNullBufferHandle;
   }
@@ -4691,6 +4881,22 @@ int StatefulNnApiDelegate::GetNnApiErrno() const {
   return delegate_data_.nnapi_errno;
 }
 
+TfLiteStatus StatefulNnApiDelegate::WaitForBufferHandle(
+    TfLiteBufferHandle buffer_handle) {
+  if (buffer_handle < 0 ||
+      buffer_handle >= delegate_data_.tensor_memory_map.size() ||
+      !delegate_data_.tensor_memory_map[buffer_handle].memory) {
+    return kTfLiteError;
+  }
+  const int result = delegate::nnapi::MemoryAccessTracker::GetInstance().Wait(
+      {delegate_data_.tensor_memory_map[buffer_handle].memory});
+  if (result != ANEURALNETWORKS_NO_ERROR) {
+    delegate_data_.nnapi_errno = result;
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
 // static
 TfLiteStatus StatefulNnApiDelegate::GetNodesSupportedByAccelerator(
     TfLiteContext* context, TfLiteDelegate* delegate, const NnApi* nnapi,
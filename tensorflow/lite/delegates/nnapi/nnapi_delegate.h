@@ -125,6 +125,27 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     // accelerator. This should only be enabled if the target device supports
     // dynamic dimensions of the model.
     bool allow_dynamic_dimensions = false;
+
+    // Whether to execute the model through an ANeuralNetworksBurst, which lets
+    // the driver reuse resources across invocations to reduce their latency.
+    // Only supported in NNAPI 1.2 and newer versions.
+    bool use_burst_computation = false;
+
+    // Whether to schedule executions asynchronously when all their inputs and
+    // outputs are bound to NNAPI memory with RegisterNnapiMemory. Invoke then
+    // returns as soon as the execution is scheduled, and later executions
+    // accessing the same memories, in this or any other NNAPI delegate
+    // instance, wait for it on the accelerator through fence dependencies
+    // instead of on the CPU. This lets chained models, e.g. a detector feeding
+    // a classifier, run back to back without CPU round trips.
+    // Before reading or writing such memory on the CPU, call
+    // WaitForBufferHandle. Errors of an asynchronous execution are reported by
+    // the next Invoke or WaitForBufferHandle call. Outputs are only left on
+    // the accelerator if the interpreter allows buffer handle outputs (see
+    // Interpreter::SetAllowBufferHandleOutput).
+    // Only supported in NNAPI 1.3 and newer versions; otherwise executions are
+    // synchronous.
+    bool use_async_execution = false;
   };
 
   // Uses default options.
@@ -186,6 +207,13 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
   // (i.e. when calling interpreter.ModifyGraphWithDelegate(delegate)).
   int GetNnApiErrno() const;
 
+  // Waits for asynchronous executions (see Options::use_async_execution)
+  // accessing the NNAPI memory registered as 'buffer_handle' to complete.
+  // Returns kTfLiteError if the handle is unknown or any of the executions
+  // failed.
+  // WARNING: This is an experimental interface that is subject to change.
+  TfLiteStatus WaitForBufferHandle(TfLiteBufferHandle buffer_handle);
+
  private:
   // Encapsulates all delegate data.
   struct Data {
@@ -235,6 +263,10 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     uint64_t max_execution_loop_timeout_duration_ns = 0;
     // Whether to allow dynamic dimension sizes without re-compilation.
     bool allow_dynamic_dimensions = false;
+    // Whether to execute the model through an ANeuralNetworksBurst.
+    bool use_burst_computation = false;
+    // Whether to schedule executions on NNAPI memory asynchronously.
+    bool use_async_execution = false;
 
     explicit Data(const NnApi* nnapi);
     ~Data();
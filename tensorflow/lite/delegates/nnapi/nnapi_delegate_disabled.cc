@@ -52,6 +52,11 @@ TfLiteBufferHandle StatefulNnApiDelegate::RegisterNnapiMemory(
 
 int StatefulNnApiDelegate::GetNnApiErrno() const { return 0; }
 
+TfLiteStatus StatefulNnApiDelegate::WaitForBufferHandle(
+    TfLiteBufferHandle buffer_handle) {
+  return kTfLiteError;
+}
+
 using ::tflite::delegate::nnapi::NNAPIDelegateKernel;
 
 StatefulNnApiDelegate::Data::Data(const NnApi* nnapi) : nnapi(nnapi) {}
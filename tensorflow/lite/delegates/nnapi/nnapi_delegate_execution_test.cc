@@ -0,0 +1,221 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cstdint>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "absl/memory/memory.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
+#include "tensorflow/lite/delegates/nnapi/nnapi_delegate_mock_test.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/nnapi/NeuralNetworksTypes.h"
+#include "tensorflow/lite/nnapi/nnapi_implementation.h"
+
+namespace tflite {
+namespace {
+
+using ::tflite::delegate::nnapi::NnApiMock;
+
+int num_computes = 0;
+int num_burst_computes = 0;
+int num_async_computes = 0;
+int num_event_waits = 0;
+uint32_t last_num_dependencies = 0;
+
+class FloatAddOpModel : public SingleOpModel {
+ public:
+  FloatAddOpModel(const NnApi* nnapi, StatefulNnApiDelegate::Options options) {
+    stateful_delegate_ =
+        absl::make_unique<StatefulNnApiDelegate>(nnapi, options);
+    SetDelegate(stateful_delegate_.get());
+    input1_ = AddInput({TensorType_FLOAT32, {1, 2, 2, 1}});
+    input2_ = AddInput({TensorType_FLOAT32, {1, 2, 2, 1}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(
+        BuiltinOperator_ADD, BuiltinOptions_AddOptions,
+        CreateAddOptions(builder_, ActivationFunctionType_NONE).Union());
+    BuildInterpreter({GetShape(input1_), GetShape(input2_)});
+  }
+
+  StatefulNnApiDelegate* GetDelegate() { return stateful_delegate_.get(); }
+
+  // Binds all inputs and the output to the given NNAPI memories, returning
+  // the buffer handle of the output.
+  TfLiteBufferHandle BindToMemory(ANeuralNetworksMemory* input1,
+                                  ANeuralNetworksMemory* input2,
+                                  ANeuralNetworksMemory* output) {
+    const TfLiteBufferHandle output_handle = Register(output);
+    interpreter_->SetBufferHandle(input1_, Register(input1),
+                                  stateful_delegate_.get());
+    interpreter_->SetBufferHandle(input2_, Register(input2),
+                                  stateful_delegate_.get());
+    interpreter_->SetBufferHandle(output_, output_handle,
+                                  stateful_delegate_.get());
+    interpreter_->SetAllowBufferHandleOutput(true);
+    return output_handle;
+  }
+
+  int input1() { return input1_; }
+  int input2() { return input2_; }
+
+ private:
+  TfLiteBufferHandle Register(ANeuralNetworksMemory* memory) {
+    return stateful_delegate_->RegisterNnapiMemory(
+        memory,
+        [](TfLiteTensor* tensor, ANeuralNetworksMemory* nn_memory,
+           size_t memory_offset, size_t byte_size,
+           void* callback_context) -> TfLiteStatus { return kTfLiteOk; },
+        nullptr);
+  }
+
+  std::unique_ptr<StatefulNnApiDelegate> stateful_delegate_;
+  int input1_;
+  int input2_;
+  int output_;
+};
+
+ANeuralNetworksMemory* FakeMemory(intptr_t id) {
+  return reinterpret_cast<ANeuralNetworksMemory*>(id);
+}
+
+class NnApiExecutionTest : public ::testing::Test {
+ protected:
+  void SetUpWithSdkVersion(int android_sdk_version) {
+    nnapi_ = *NnApiImplementation();
+    nnapi_mock_ = absl::make_unique<NnApiMock>(&nnapi_, android_sdk_version);
+    num_computes = 0;
+    num_burst_computes = 0;
+    num_async_computes = 0;
+    num_event_waits = 0;
+    last_num_dependencies = 0;
+    nnapi_mock_->StubExecutionComputeWith(
+        [](ANeuralNetworksExecution* execution) -> int {
+          ++num_computes;
+          return ANEURALNETWORKS_NO_ERROR;
+        });
+    nnapi_mock_->StubExecutionBurstComputeWith(
+        [](ANeuralNetworksExecution* execution,
+           ANeuralNetworksBurst* burst) -> int {
+          ++num_burst_computes;
+          return ANEURALNETWORKS_NO_ERROR;
+        });
+    nnapi_mock_->StubExecutionStartComputeWithDependenciesWith(
+        [](ANeuralNetworksExecution* execution,
+           const ANeuralNetworksEvent* const* dependencies,
+           uint32_t num_dependencies, uint64_t duration,
+           ANeuralNetworksEvent** event) -> int {
+          ++num_async_computes;
+          last_num_dependencies = num_dependencies;
+          *event = reinterpret_cast<ANeuralNetworksEvent*>(num_async_computes);
+          return ANEURALNETWORKS_NO_ERROR;
+        });
+    nnapi_mock_->StubEventWaitWith([](ANeuralNetworksEvent* event) -> int {
+      ++num_event_waits;
+      return ANEURALNETWORKS_NO_ERROR;
+    });
+  }
+
+  std::unique_ptr<NnApiMock> nnapi_mock_;
+
+ private:
+  NnApi nnapi_;
+};
+
+TEST_F(NnApiExecutionTest, UsesBurstWhenEnabled) {
+  SetUpWithSdkVersion(29);
+  StatefulNnApiDelegate::Options options;
+  options.use_burst_computation = true;
+  FloatAddOpModel m(nnapi_mock_->GetNnApi(), options);
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+
+  EXPECT_EQ(num_burst_computes, 2);
+  EXPECT_EQ(num_computes, 0);
+}
+
+TEST_F(NnApiExecutionTest, DoesNotUseBurstByDefault) {
+  SetUpWithSdkVersion(29);
+  FloatAddOpModel m(nnapi_mock_->GetNnApi(), StatefulNnApiDelegate::Options());
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+
+  EXPECT_EQ(num_burst_computes, 0);
+  EXPECT_EQ(num_computes, 1);
+}
+
+TEST_F(NnApiExecutionTest, ChainsAsyncExecutionsOnNnapiMemory) {
+  SetUpWithSdkVersion(30);
+  StatefulNnApiDelegate::Options options;
+  options.use_async_execution = true;
+  // The output of the first model is the first input of the second one.
+  FloatAddOpModel first(nnapi_mock_->GetNnApi(), options);
+  first.BindToMemory(FakeMemory(0x10), FakeMemory(0x20), FakeMemory(0x30));
+  FloatAddOpModel second(nnapi_mock_->GetNnApi(), options);
+  const TfLiteBufferHandle output = second.BindToMemory(
+      FakeMemory(0x30), FakeMemory(0x40), FakeMemory(0x50));
+
+  ASSERT_EQ(first.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_EQ(num_async_computes, 1);
+  EXPECT_EQ(last_num_dependencies, 0);
+
+  ASSERT_EQ(second.InvokeUnchecked(), kTfLiteOk);
+  EXPECT_EQ(num_async_computes, 2);
+  EXPECT_EQ(last_num_dependencies, 1);
+  EXPECT_EQ(num_event_waits, 0);
+  EXPECT_EQ(num_computes, 0);
+
+  EXPECT_EQ(second.GetDelegate()->WaitForBufferHandle(output), kTfLiteOk);
+  EXPECT_EQ(num_event_waits, 1);
+}
+
+TEST_F(NnApiExecutionTest, ReportsAsyncExecutionErrors) {
+  SetUpWithSdkVersion(30);
+  nnapi_mock_->EventWaitReturns<ANEURALNETWORKS_OP_FAILED>();
+  StatefulNnApiDelegate::Options options;
+  options.use_async_execution = true;
+  FloatAddOpModel m(nnapi_mock_->GetNnApi(), options);
+  const TfLiteBufferHandle output =
+      m.BindToMemory(FakeMemory(0x10), FakeMemory(0x20), FakeMemory(0x30));
+
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+
+  EXPECT_EQ(m.GetDelegate()->WaitForBufferHandle(output), kTfLiteError);
+  EXPECT_EQ(m.GetDelegate()->GetNnApiErrno(), ANEURALNETWORKS_OP_FAILED);
+}
+
+TEST_F(NnApiExecutionTest, RunsSynchronouslyWithCpuBuffers) {
+  SetUpWithSdkVersion(30);
+  StatefulNnApiDelegate::Options options;
+  options.use_async_execution = true;
+  FloatAddOpModel m(nnapi_mock_->GetNnApi(), options);
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+
+  ASSERT_EQ(m.InvokeUnchecked(), kTfLiteOk);
+
+  EXPECT_EQ(num_async_computes, 0);
+  EXPECT_EQ(num_computes, 1);
+}
+
+}  // namespace
+}  // namespace tflite
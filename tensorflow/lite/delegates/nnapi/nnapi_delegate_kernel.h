@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/c/common.h"
@@ -155,6 +156,46 @@ class NNFreeExecution {
   const NnApi* nnapi_;
 };
 
+// RAII NN API Burst Destructor for use with std::unique_ptr
+class NNFreeBurst {
+ public:
+  explicit NNFreeBurst(const NnApi* nnapi) : nnapi_(nnapi) {}
+  void operator()(ANeuralNetworksBurst* burst) {
+    nnapi_->ANeuralNetworksBurst_free(burst);
+  }
+
+ private:
+  // NnApi instance to use. Not owned by this object.
+  const NnApi* nnapi_;
+};
+
+// An execution scheduled with
+// ANeuralNetworksExecution_startComputeWithDependencies. Owns the execution
+// and its completion event, and waits for the execution to complete when
+// destroyed.
+class NNAsyncExecution {
+ public:
+  NNAsyncExecution(const NnApi* nnapi, ANeuralNetworksExecution* execution,
+                   ANeuralNetworksEvent* event)
+      : nnapi_(nnapi), execution_(execution), event_(event) {}
+  ~NNAsyncExecution();
+
+  const ANeuralNetworksEvent* event() const { return event_; }
+
+  // Waits for the execution to complete and returns its result code. Can be
+  // called any number of times, from any thread.
+  int Wait();
+
+ private:
+  // NnApi instance to use. Not owned by this object.
+  const NnApi* nnapi_;
+  std::mutex mutex_;
+  // Freed once the execution completed.
+  ANeuralNetworksExecution* execution_;
+  ANeuralNetworksEvent* event_;
+  int result_ = ANEURALNETWORKS_NO_ERROR;
+};
+
 // Manage NNAPI shared memory handle
 class NNMemory {
  public:
@@ -249,9 +290,12 @@ class NNAPIDelegateKernel {
       : initialised_(false),
         nnapi_(nnapi),
         nn_model_(nullptr, NNFreeModel(nnapi_)),
-        nn_compilation_(nullptr, NNFreeCompilation(nnapi_)) {}
+        nn_compilation_(nullptr, NNFreeCompilation(nnapi_)),
+        nn_burst_(nullptr, NNFreeBurst(nnapi_)) {}
   NNAPIDelegateKernel() : NNAPIDelegateKernel(NnApiImplementation()) {}
   ~NNAPIDelegateKernel() {
+    // The execution may still be reading from the memory freed below.
+    async_execution_.reset();
     for (auto content : allocation_memory_mapping_) {
       nnapi_->ANeuralNetworksMemory_free(content.second);
     }
@@ -323,6 +367,12 @@ class NNAPIDelegateKernel {
   std::unique_ptr<ANeuralNetworksModel, NNFreeModel> nn_model_;
   std::unique_ptr<ANeuralNetworksCompilation, NNFreeCompilation>
       nn_compilation_;
+  // Burst object used to execute the compilation if
+  // StatefulNnApiDelegate::Options::use_burst_computation is set.
+  std::unique_ptr<ANeuralNetworksBurst, NNFreeBurst> nn_burst_;
+  // The last execution scheduled asynchronously, if
+  // StatefulNnApiDelegate::Options::use_async_execution is set.
+  std::shared_ptr<NNAsyncExecution> async_execution_;
   // Node indices that this delegate is responsible for. Indices here
   // indexes into the nodes array in the TfLiteContext.
   std::vector<int> nodes_;
@@ -53,6 +53,7 @@ class NnApiMock : public ::tflite::nnapi::NnApiHandler {
       return open("/dev/zero", O_RDWR);
     };
     nnapi_->ANeuralNetworksEvent_free = [](ANeuralNetworksEvent* event) {};
+    nnapi_->ANeuralNetworksBurst_free = [](ANeuralNetworksBurst* burst) {};
 
     ModelCreateReturns<ANEURALNETWORKS_NO_ERROR>();
     AddOperandReturns<ANEURALNETWORKS_NO_ERROR>();
@@ -71,6 +72,7 @@ class NnApiMock : public ::tflite::nnapi::NnApiHandler {
     ExecutionComputeReturns<ANEURALNETWORKS_NO_ERROR>();
     ExecutionStartComputeReturns<ANEURALNETWORKS_NO_ERROR>();
     EventWaitReturns<ANEURALNETWORKS_NO_ERROR>();
+    BurstCreateReturns<ANEURALNETWORKS_NO_ERROR>();
     SetPriorityReturns<ANEURALNETWORKS_NO_ERROR>();
     SetOperandSymmPerChannelQuantParamsReturns<ANEURALNETWORKS_NO_ERROR>();
     SetNnapiSupportedDevice("test-device", android_sdk_version);
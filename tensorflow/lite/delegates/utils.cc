@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/utils.h"
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/builtin_ops.h"
@@ -46,6 +47,36 @@ TfLiteStatus CreateNewTensorWithDifferentType(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+float PartitionCostModel::GetCpuCost(
+    TfLiteContext* context, int node_index, const TfLiteNode& node,
+    const TfLiteRegistration& registration) const {
+  float cost = 0.0f;
+  if (node.outputs != nullptr) {
+    for (int tensor_id : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_id < 0) continue;
+      const TfLiteIntArray* dims = context->tensors[tensor_id].dims;
+      if (dims == nullptr) continue;
+      float num_elements = 1.0f;
+      for (int d : TfLiteIntArrayView(dims)) num_elements *= d;
+      cost += num_elements;
+    }
+  }
+  // Every node costs at least one unit, e.g. for scalar or dynamic outputs.
+  return std::max(cost, 1.0f);
+}
+
+float PartitionCostModel::GetDelegateCost(
+    TfLiteContext* context, int node_index, const TfLiteNode& node,
+    const TfLiteRegistration& registration) const {
+  return GetCpuCost(context, node_index, node, registration) /
+         delegate_speedup_;
+}
+
+float PartitionCostModel::GetTransferCost(TfLiteContext* context,
+                                          int tensor_index) const {
+  return context->tensors[tensor_index].bytes * transfer_cost_per_byte_;
+}
+
 TfLiteStatus GraphPartitionHelper::Partition(
     std::set<std::string>* unsupported_nodes_info) {
   const auto prepare_status = PrepareSupportedNodes(unsupported_nodes_info);
@@ -97,10 +128,14 @@ GraphPartitionHelper::GetFirstNLargestPartitions(
 
 std::vector<int> GraphPartitionHelper::GetNodesOfFirstNLargestPartitionsImpl(
     int n, int min_nodes_per_partition) {
-  auto first_n_partitions =
-      GetFirstNLargestPartitions(n, min_nodes_per_partition);
+  return GetNodesOfPartitions(
+      GetFirstNLargestPartitions(n, min_nodes_per_partition));
+}
+
+std::vector<int> GraphPartitionHelper::GetNodesOfPartitions(
+    const std::vector<TfLiteDelegateParams*>& partitions) {
   std::vector<int> ops_to_replace;
-  for (const auto p : first_n_partitions) {
+  for (const auto p : partitions) {
     auto nodes = p->nodes_to_replace;
     ops_to_replace.insert(ops_to_replace.end(), nodes->data,
                           nodes->data + nodes->size);
@@ -108,6 +143,83 @@ std::vector<int> GraphPartitionHelper::GetNodesOfFirstNLargestPartitionsImpl(
   return ops_to_replace;
 }
 
+TfLiteStatus GraphPartitionHelper::GetPartitionsByCost(
+    const PartitionSelectionOptions& options,
+    std::vector<TfLiteDelegateParams*>* partitions) const {
+  const PartitionCostModel default_cost_model;
+  const PartitionCostModel& cost_model =
+      options.cost_model ? *options.cost_model : default_cost_model;
+
+  std::vector<std::pair<float, TfLiteDelegateParams*>> candidates;
+  for (TfLiteDelegateParams* p : partitions_) {
+    if (p->nodes_to_replace->size < options.min_nodes_per_partition) {
+      continue;
+    }
+    float cpu_cost = 0.0f;
+    float delegate_cost = 0.0f;
+    if (options.benchmark_fn) {
+      TF_LITE_ENSURE_STATUS(
+          options.benchmark_fn(context_, *p, &cpu_cost, &delegate_cost));
+    } else {
+      TF_LITE_ENSURE_STATUS(
+          EstimatePartitionCost(cost_model, *p, &cpu_cost, &delegate_cost));
+    }
+    if (cpu_cost < options.min_speedup * delegate_cost) {
+      continue;
+    }
+    candidates.emplace_back(cpu_cost - delegate_cost, p);
+  }
+
+  // Stable sort keeps partitions with equal benefit in execution order.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const std::pair<float, TfLiteDelegateParams*>& left,
+                      const std::pair<float, TfLiteDelegateParams*>& right) {
+                     return left.first > right.first;
+                   });
+
+  partitions->clear();
+  for (const auto& candidate : candidates) {
+    if (partitions->size() >= options.max_partitions) break;
+    partitions->push_back(candidate.second);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus GraphPartitionHelper::EstimatePartitionCost(
+    const PartitionCostModel& cost_model, const TfLiteDelegateParams& partition,
+    float* cpu_cost, float* delegate_cost) const {
+  *cpu_cost = 0.0f;
+  *delegate_cost = cost_model.GetPartitionOverhead();
+  for (int node_id : TfLiteIntArrayView(partition.nodes_to_replace)) {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    if (context_->GetNodeAndRegistration(context_, node_id, &node,
+                                         &registration) != kTfLiteOk) {
+      TF_LITE_KERNEL_LOG(context_,
+                         "Couldn't get node and registration info for op: %d\n",
+                         node_id);
+      return kTfLiteError;
+    }
+    *cpu_cost += cost_model.GetCpuCost(context_, node_id, *node, *registration);
+    *delegate_cost +=
+        cost_model.GetDelegateCost(context_, node_id, *node, *registration);
+  }
+  // Constant tensors are copied into the delegate once, when it is prepared,
+  // so only the other inputs and outputs are copied on every invocation.
+  for (const TfLiteIntArray* tensors :
+       {partition.input_tensors, partition.output_tensors}) {
+    if (tensors == nullptr) continue;
+    for (int tensor_id : TfLiteIntArrayView(tensors)) {
+      if (tensor_id < 0 ||
+          context_->tensors[tensor_id].allocation_type == kTfLiteMmapRo) {
+        continue;
+      }
+      *delegate_cost += cost_model.GetTransferCost(context_, tensor_id);
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus GraphPartitionHelper::PrepareSupportedNodes(
     std::set<std::string>* unsupported_nodes_info) {
   if (!is_node_supported_fn_) return kTfLiteOk;
@@ -150,11 +262,8 @@ TfLiteStatus GraphPartitionHelper::PrepareSupportedNodes(
   return kTfLiteOk;
 }
 
-std::vector<int>
-FP16GraphPartitionHelper::GetNodesOfFirstNLargestPartitionsImpl(
-    int n, int min_nodes_per_partition) {
-  auto first_n_partitions =
-      GetFirstNLargestPartitions(n, min_nodes_per_partition);
+std::vector<int> FP16GraphPartitionHelper::GetNodesOfPartitions(
+    const std::vector<TfLiteDelegateParams*>& first_n_partitions) {
   std::vector<int> ops_to_replace;
   if (first_n_partitions.empty()) return ops_to_replace;
 
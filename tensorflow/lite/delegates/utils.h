@@ -45,6 +45,74 @@ using IsNodeSupportedFn =
     std::function<bool(TfLiteContext*, TfLiteNode*, TfLiteRegistration*,
                        std::string* unsupported_details)>;
 
+// Estimates the cost of running nodes on the CPU or in a delegate, and the
+// cost of copying tensors between the CPU and the delegate, in arbitrary but
+// consistent units (e.g. microseconds).
+//
+// The default implementation estimates the CPU cost of a node by the number of
+// elements it outputs, assumes the delegate runs every node
+// 'delegate_speedup' times faster, and estimates copies by the number of
+// bytes copied. Delegates should override it with estimates for their
+// backend.
+class PartitionCostModel {
+ public:
+  explicit PartitionCostModel(float delegate_speedup = 2.0f,
+                              float transfer_cost_per_byte = 0.25f,
+                              float partition_overhead = 0.0f)
+      : delegate_speedup_(delegate_speedup),
+        transfer_cost_per_byte_(transfer_cost_per_byte),
+        partition_overhead_(partition_overhead) {}
+  virtual ~PartitionCostModel() = default;
+
+  // Cost of running the node with index 'node_index' with the CPU kernels.
+  virtual float GetCpuCost(TfLiteContext* context, int node_index,
+                           const TfLiteNode& node,
+                           const TfLiteRegistration& registration) const;
+
+  // Cost of running the node with index 'node_index' in the delegate.
+  virtual float GetDelegateCost(TfLiteContext* context, int node_index,
+                                const TfLiteNode& node,
+                                const TfLiteRegistration& registration) const;
+
+  // Cost of copying the tensor with index 'tensor_index' between the CPU and
+  // the delegate, paid for every non-constant input and output of a delegated
+  // partition.
+  virtual float GetTransferCost(TfLiteContext* context,
+                                int tensor_index) const;
+
+  // Fixed cost of invoking a delegated partition.
+  virtual float GetPartitionOverhead() const { return partition_overhead_; }
+
+ private:
+  const float delegate_speedup_;
+  const float transfer_cost_per_byte_;
+  const float partition_overhead_;
+};
+
+// Measures the cost of running 'partition' on the CPU and in the delegate,
+// including copies, in the units of the PartitionCostModel in use.
+using PartitionBenchmarkFn = std::function<TfLiteStatus(
+    TfLiteContext* context, const TfLiteDelegateParams& partition,
+    float* cpu_cost, float* delegate_cost)>;
+
+// Options for GraphPartitionHelper::GetPartitionsByCost.
+struct PartitionSelectionOptions {
+  // Maximum number of partitions to delegate.
+  int max_partitions = std::numeric_limits<int>::max();
+  // Partitions with fewer nodes are never delegated.
+  int min_nodes_per_partition = 0;
+  // Partitions are only delegated if their CPU cost is at least 'min_speedup'
+  // times their delegate cost, including copies and partition overhead.
+  float min_speedup = 1.0f;
+  // Cost model to estimate partition costs. If null, a default-constructed
+  // PartitionCostModel is used.
+  const PartitionCostModel* cost_model = nullptr;
+  // If set, the costs of each partition with at least
+  // 'min_nodes_per_partition' nodes are measured with this function instead of
+  // being estimated with the cost model.
+  PartitionBenchmarkFn benchmark_fn = nullptr;
+};
+
 // A utility class to help model graph parition.
 // Note the class *needs* to be used in TfLiteDelegate::Prepare.
 class GraphPartitionHelper {
@@ -88,6 +156,26 @@ class GraphPartitionHelper {
     return GetNodesOfFirstNLargestPartitionsImpl(n, min_nodes_per_partition);
   }
 
+  // Returns in 'partitions' the partitions that are worth delegating according
+  // to 'options', ranked by their estimated benefit (CPU cost minus delegate
+  // cost). Unlike GetFirstNLargestPartitions, this accounts for the cost of
+  // copying tensors in and out of each partition, so that a graph fragmented
+  // into many small partitions is not delegated at a loss. The returned
+  // TfLiteDelegateParams objects are *owned* by the TfLite runtime.
+  TfLiteStatus GetPartitionsByCost(
+      const PartitionSelectionOptions& options,
+      std::vector<TfLiteDelegateParams*>* partitions) const;
+
+  // Returns in 'nodes' the node indices of all nodes from the partitions
+  // returned by GetPartitionsByCost.
+  TfLiteStatus GetNodesOfPartitionsByCost(
+      const PartitionSelectionOptions& options, std::vector<int>* nodes) {
+    std::vector<TfLiteDelegateParams*> partitions;
+    TF_LITE_ENSURE_STATUS(GetPartitionsByCost(options, &partitions));
+    *nodes = GetNodesOfPartitions(partitions);
+    return kTfLiteOk;
+  }
+
   int num_total_nodes() const { return num_total_nodes_; }
   int num_partitions() const { return partitions_.size(); }
 
@@ -100,6 +188,10 @@ class GraphPartitionHelper {
   }
   virtual std::vector<int> GetNodesOfFirstNLargestPartitionsImpl(
       int n, int min_nodes_per_partition);
+  // Returns a list of node indices of all nodes from 'partitions', which are
+  // ranked in decreasing order of preference.
+  virtual std::vector<int> GetNodesOfPartitions(
+      const std::vector<TfLiteDelegateParams*>& partitions);
 
   TfLiteContext* const context_ = nullptr;
 
@@ -117,6 +209,12 @@ class GraphPartitionHelper {
   TfLiteStatus PrepareSupportedNodes(
       std::set<std::string>* unsupported_nodes_info = nullptr);
 
+  // Estimates the costs of running 'partition' on the CPU and in the delegate.
+  TfLiteStatus EstimatePartitionCost(const PartitionCostModel& cost_model,
+                                     const TfLiteDelegateParams& partition,
+                                     float* cpu_cost,
+                                     float* delegate_cost) const;
+
   // The number of total nodes passed in for partitioning (i.e. the
   // execution_plan size associated w/ 'context_')
   int num_total_nodes_ = 0;
@@ -150,8 +248,8 @@ class FP16GraphPartitionHelper : public GraphPartitionHelper {
                        std::string* unsupported_details) override;
 
   // This will remap input tensors by removing FP16 to FP32 dequantized tensors.
-  std::vector<int> GetNodesOfFirstNLargestPartitionsImpl(
-      int n, int min_nodes_per_partition) override;
+  std::vector<int> GetNodesOfPartitions(
+      const std::vector<TfLiteDelegateParams*>& partitions) override;
 
  private:
   // This remaps fp32 inputs of the given node to their corresponding fp16
@@ -94,9 +94,22 @@ TfLiteStatus DelegatePrepare(TfLiteContext* context,
   delegates::GraphPartitionHelper helper(context, node_supported_fn);
   TF_LITE_ENSURE_STATUS(helper.Partition(nullptr));
 
-  std::vector<int> supported_nodes = helper.GetNodesOfFirstNLargestPartitions(
-      delegate_options.max_delegated_partitions,
-      delegate_options.min_nodes_per_partition);
+  std::vector<int> supported_nodes;
+  if (delegate_options.partition_cost_model != nullptr) {
+    delegates::PartitionSelectionOptions selection_options;
+    selection_options.max_partitions =
+        delegate_options.max_delegated_partitions;
+    selection_options.min_nodes_per_partition =
+        delegate_options.min_nodes_per_partition;
+    selection_options.min_speedup = delegate_options.min_partition_speedup;
+    selection_options.cost_model = delegate_options.partition_cost_model;
+    TF_LITE_ENSURE_STATUS(
+        helper.GetNodesOfPartitionsByCost(selection_options, &supported_nodes));
+  } else {
+    supported_nodes = helper.GetNodesOfFirstNLargestPartitions(
+        delegate_options.max_delegated_partitions,
+        delegate_options.min_nodes_per_partition);
+  }
 
   TFLITE_LOG_PROD(tflite::TFLITE_LOG_INFO,
                   "%s delegate: %d nodes delegated out of %d nodes with "
@@ -34,6 +34,9 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 
 namespace tflite {
+namespace delegates {
+class PartitionCostModel;
+}  // namespace delegates
 
 using TfLiteDelegateUniquePtr =
     std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)>;
@@ -78,6 +81,13 @@ class SimpleDelegateInterface {
     // The minimum number of nodes allowed in a delegated graph, values <=0
     // means unlimited.
     int min_nodes_per_partition = 0;
+
+    // If set, partitions are selected with this cost model, and only those
+    // estimated to run at least 'min_partition_speedup' times faster in the
+    // delegate, copies included, are delegated. Otherwise the largest
+    // partitions are delegated. Not owned, and must outlive the delegate.
+    const delegates::PartitionCostModel* partition_cost_model = nullptr;
+    float min_partition_speedup = 1.0f;
   };
 
   virtual ~SimpleDelegateInterface() {}
@@ -18,6 +18,8 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/utils.h"
+#include "tensorflow/lite/delegates/utils/simple_delegate.h"
 #include "tensorflow/lite/delegates/utils/dummy_delegate/dummy_delegate.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/builtin_op_kernels.h"
@@ -124,5 +126,67 @@ TEST_F(TestDelegate, DelegateFailedInit) {
   ASSERT_EQ(kTfLiteDelegateError,
             interpreter_->ModifyGraphWithDelegate(std::move(delegate)));
 }
+
+class NoOpDelegateKernel : public SimpleDelegateKernelInterface {
+ public:
+  TfLiteStatus Init(TfLiteContext* context,
+                    const TfLiteDelegateParams* params) override {
+    return kTfLiteOk;
+  }
+  TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) override {
+    return kTfLiteOk;
+  }
+  TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) override {
+    return kTfLiteOk;
+  }
+};
+
+// Delegates ADD nodes, selecting partitions with 'cost_model'.
+class CostModelDelegate : public SimpleDelegateInterface {
+ public:
+  explicit CostModelDelegate(const delegates::PartitionCostModel* cost_model)
+      : cost_model_(cost_model) {}
+
+  bool IsNodeSupportedByDelegate(const TfLiteRegistration* registration,
+                                 const TfLiteNode* node,
+                                 TfLiteContext* context) const override {
+    return registration->builtin_code == kTfLiteBuiltinAdd;
+  }
+  TfLiteStatus Initialize(TfLiteContext* context) override {
+    return kTfLiteOk;
+  }
+  const char* Name() const override { return "CostModelDelegate"; }
+  std::unique_ptr<SimpleDelegateKernelInterface> CreateDelegateKernelInterface()
+      override {
+    return std::make_unique<NoOpDelegateKernel>();
+  }
+  SimpleDelegateInterface::Options DelegateOptions() const override {
+    SimpleDelegateInterface::Options options;
+    options.partition_cost_model = cost_model_;
+    return options;
+  }
+
+ private:
+  const delegates::PartitionCostModel* cost_model_;
+};
+
+TEST_F(TestDelegate, CostModelDelegatesProfitablePartition) {
+  const delegates::PartitionCostModel cost_model(
+      /*delegate_speedup=*/10.0f, /*transfer_cost_per_byte=*/0.0f);
+  interpreter_->ModifyGraphWithDelegate(TfLiteDelegateFactory::Create(
+      std::make_unique<CostModelDelegate>(&cost_model)));
+
+  ASSERT_EQ(interpreter_->execution_plan().size(), 1);
+}
+
+TEST_F(TestDelegate, CostModelSkipsUnprofitablePartition) {
+  // The copies in and out of the partition cost more than delegating saves.
+  const delegates::PartitionCostModel cost_model(
+      /*delegate_speedup=*/10.0f, /*transfer_cost_per_byte=*/1.0f);
+  interpreter_->ModifyGraphWithDelegate(TfLiteDelegateFactory::Create(
+      std::make_unique<CostModelDelegate>(&cost_model)));
+
+  ASSERT_EQ(interpreter_->execution_plan().size(), 3);
+}
 }  // namespace
 }  // namespace tflite
@@ -250,6 +250,150 @@ TEST(GraphPartitionHelper, CheckPartitionsWithSupportedNodeList) {
   EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8, 2, 4, 9}));
 }
 
+// Cost model where each node costs 4 on the CPU and 1 in the delegate, and
+// copies cost as many units as bytes copied.
+class FixedCostModel : public PartitionCostModel {
+ public:
+  explicit FixedCostModel(float partition_overhead)
+      : partition_overhead_(partition_overhead) {}
+
+  float GetCpuCost(TfLiteContext* context, int node_index,
+                   const TfLiteNode& node,
+                   const TfLiteRegistration& registration) const override {
+    return 4.0f;
+  }
+  float GetDelegateCost(TfLiteContext* context, int node_index,
+                        const TfLiteNode& node,
+                        const TfLiteRegistration& registration) const override {
+    return 1.0f;
+  }
+  float GetTransferCost(TfLiteContext* context,
+                        int tensor_index) const override {
+    return context->tensors[tensor_index].bytes;
+  }
+  float GetPartitionOverhead() const override { return partition_overhead_; }
+
+ private:
+  const float partition_overhead_;
+};
+
+TEST(GraphPartitionHelper, CheckPartitionsByCost) {
+  // The mocked TfLiteContext has 4 partitions: {1}, {0,3,7,8}, {2,4,9}, {5,6}.
+  // With an overhead of 7 per partition, their CPU vs. delegate costs are
+  // 4 vs. 8, 16 vs. 11, 12 vs. 10 and 8 vs. 9.
+  MockTfLiteContext mocked_context;
+  GraphPartitionHelper helper(&mocked_context, IsNodeSupported);
+  EXPECT_EQ(kTfLiteOk, helper.Partition(nullptr));
+  FixedCostModel cost_model(/*partition_overhead=*/7.0f);
+  PartitionSelectionOptions options;
+  options.cost_model = &cost_model;
+
+  std::vector<TfLiteDelegateParams*> partitions;
+  EXPECT_EQ(kTfLiteOk, helper.GetPartitionsByCost(options, &partitions));
+  EXPECT_EQ(2, partitions.size());
+  auto nodes = GetNodesToReplaceFromPartitions(partitions);
+  EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8, 2, 4, 9}));
+
+  options.max_partitions = 1;
+  EXPECT_EQ(kTfLiteOk, helper.GetNodesOfPartitionsByCost(options, &nodes));
+  EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8}));
+
+  // Only {0,3,7,8} is at least 1.4 times faster in the delegate.
+  options.max_partitions = 10;
+  options.min_speedup = 1.4f;
+  EXPECT_EQ(kTfLiteOk, helper.GetNodesOfPartitionsByCost(options, &nodes));
+  EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8}));
+
+  options.min_speedup = 1.0f;
+  options.min_nodes_per_partition = 4;
+  EXPECT_EQ(kTfLiteOk, helper.GetNodesOfPartitionsByCost(options, &nodes));
+  EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8}));
+}
+
+TEST(GraphPartitionHelper, CheckPartitionsByCostWithTransfers) {
+  MockTfLiteContext mocked_context;
+  std::vector<TfLiteTensor> tensors(2);
+  tensors[0].allocation_type = kTfLiteArenaRw;
+  tensors[0].bytes = 20;
+  tensors[1].allocation_type = kTfLiteMmapRo;
+  tensors[1].bytes = 100;
+  mocked_context.tensors = tensors.data();
+  GraphPartitionHelper helper(&mocked_context, IsNodeSupported);
+  EXPECT_EQ(kTfLiteOk, helper.Partition(nullptr));
+
+  // Without transfers, {0,3,7,8} costs 16 on the CPU and 4 in the delegate.
+  auto partitions = helper.GetFirstNLargestPartitions(1);
+  ASSERT_EQ(1, partitions.size());
+  partitions[0]->input_tensors = TfLiteIntArrayCreate(1);
+  partitions[0]->input_tensors->data[0] = 1;
+  partitions[0]->output_tensors = TfLiteIntArrayCreate(0);
+  FixedCostModel cost_model(/*partition_overhead=*/0.0f);
+  PartitionSelectionOptions options;
+  options.cost_model = &cost_model;
+  options.min_nodes_per_partition = 4;
+
+  // Constant inputs are not copied on every invocation.
+  std::vector<int> nodes;
+  EXPECT_EQ(kTfLiteOk, helper.GetNodesOfPartitionsByCost(options, &nodes));
+  EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8}));
+
+  // Copying the output costs more than delegating saves.
+  TfLiteIntArrayFree(partitions[0]->output_tensors);
+  partitions[0]->output_tensors = TfLiteIntArrayCreate(1);
+  partitions[0]->output_tensors->data[0] = 0;
+  EXPECT_EQ(kTfLiteOk, helper.GetNodesOfPartitionsByCost(options, &nodes));
+  EXPECT_TRUE(nodes.empty());
+}
+
+TEST(GraphPartitionHelper, CheckPartitionsByBenchmark) {
+  MockTfLiteContext mocked_context;
+  GraphPartitionHelper helper(&mocked_context, IsNodeSupported);
+  EXPECT_EQ(kTfLiteOk, helper.Partition(nullptr));
+
+  // Only {5,6} is measured to be faster in the delegate.
+  int num_benchmarks = 0;
+  PartitionSelectionOptions options;
+  options.min_nodes_per_partition = 2;
+  options.benchmark_fn = [&num_benchmarks](
+                             TfLiteContext* context,
+                             const TfLiteDelegateParams& partition,
+                             float* cpu_cost, float* delegate_cost) {
+    num_benchmarks++;
+    *cpu_cost = partition.nodes_to_replace->size == 2 ? 10.0f : 1.0f;
+    *delegate_cost = 2.0f;
+    return kTfLiteOk;
+  };
+
+  std::vector<int> nodes;
+  EXPECT_EQ(kTfLiteOk, helper.GetNodesOfPartitionsByCost(options, &nodes));
+  EXPECT_THAT(nodes, testing::ElementsAreArray({5, 6}));
+  EXPECT_EQ(3, num_benchmarks);
+}
+
+TEST(PartitionCostModel, DefaultCosts) {
+  std::vector<TfLiteTensor> tensors(1);
+  tensors[0].dims = TfLiteIntArrayCreate(2);
+  tensors[0].dims->data[0] = 2;
+  tensors[0].dims->data[1] = 3;
+  tensors[0].bytes = 24;
+  TfLiteContext context;
+  context.tensors = tensors.data();
+  TfLiteNode node;
+  node.outputs = TfLiteIntArrayCreate(1);
+  node.outputs->data[0] = 0;
+  TfLiteRegistration registration;
+
+  PartitionCostModel cost_model(/*delegate_speedup=*/2.0f,
+                                /*transfer_cost_per_byte=*/0.5f);
+  EXPECT_EQ(6.0f, cost_model.GetCpuCost(&context, 0, node, registration));
+  EXPECT_EQ(3.0f, cost_model.GetDelegateCost(&context, 0, node, registration));
+  EXPECT_EQ(12.0f, cost_model.GetTransferCost(&context, 0));
+  EXPECT_EQ(0.0f, cost_model.GetPartitionOverhead());
+
+  TfLiteIntArrayFree(node.outputs);
+  TfLiteIntArrayFree(tensors[0].dims);
+}
+
 }  // namespace
 }  // namespace delegates
 }  // namespace tflite
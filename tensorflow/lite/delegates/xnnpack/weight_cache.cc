@@ -0,0 +1,349 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/delegates/xnnpack/weight_cache.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+namespace xnnpack {
+
+namespace {
+
+// Alignment of unpacked data, both in memory and in cache files.
+constexpr size_t kAlignment = 64;
+
+constexpr char kMagic[8] = {'X', 'N', 'N', 'W', 'C', '0', '0', '1'};
+
+constexpr uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+// Header of a cache file: kMagic, followed by the number of entries.
+struct FileHeader {
+  char magic[8];
+  uint64_t num_entries;
+};
+
+// Describes one entry of a cache file. Entry headers follow the file header,
+// and the unpacked data of each entry is stored at `offset` from the start of
+// the file, aligned to kAlignment bytes.
+struct FileEntry {
+  uint64_t fingerprint;
+  uint64_t source_size;
+  int32_t kind;
+  int32_t reserved;
+  uint64_t params_hash;
+  uint64_t unpacked_size;
+  uint64_t offset;
+};
+
+// FNV-1a over 64-bit words followed by the remaining bytes.
+uint64_t Hash(const void* data, size_t size, uint64_t hash) {
+  constexpr uint64_t kPrime = 0x100000001b3ull;
+  const char* bytes = static_cast<const char*>(data);
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+    bytes += sizeof(word);
+  }
+  for (; size != 0; size--) {
+    hash = (hash ^ static_cast<unsigned char>(*bytes++)) * kPrime;
+  }
+  return hash;
+}
+
+size_t AlignUp(size_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Errors opening a cache file are reported through the return value of Load().
+class SilentErrorReporter : public ErrorReporter {
+ public:
+  int Report(const char* format, va_list args) override { return 0; }
+};
+
+}  // namespace
+
+struct WeightCache::Entry {
+  const char* data = nullptr;
+  size_t size = 0;
+  bool has_fingerprint = false;
+  FingerprintKey fingerprint_key;
+  // Backing storage of entries unpacked in this process.
+  std::unique_ptr<char[]> owned_data;
+  // Backing storage of entries loaded from a cache file.
+  std::shared_ptr<const Allocation> allocation;
+};
+
+WeightCache& WeightCache::Global() {
+  static WeightCache* cache = new WeightCache();
+  return *cache;
+}
+
+WeightCache::FingerprintKey WeightCache::GetFingerprintKey(
+    const WeightCacheKey& key, uint64_t params_hash) {
+  return FingerprintKey(Hash(key.source, key.source_size, kHashSeed),
+                        key.source_size, key.kind, params_hash,
+                        key.unpacked_size);
+}
+
+std::shared_ptr<const char> WeightCache::GetOrUnpack(
+    const WeightCacheKey& key, const UnpackFunction& unpack) {
+  const uint64_t params_hash =
+      Hash(key.params.data(), key.params.size() * sizeof(int32_t), kHashSeed);
+  const AddressKey address_key(key.source, key.source_size, key.kind,
+                               params_hash, key.unpacked_size);
+  bool use_fingerprints;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_by_address_.find(address_key);
+    if (it != entries_by_address_.end()) {
+      if (std::shared_ptr<const Entry> entry = it->second.lock()) {
+        return std::shared_ptr<const char>(entry, entry->data);
+      }
+    }
+    use_fingerprints = use_fingerprints_;
+  }
+
+  // Hashing the source is a pass over the weights; do it without holding the
+  // lock.
+  FingerprintKey fingerprint_key;
+  if (use_fingerprints) {
+    fingerprint_key = GetFingerprintKey(key, params_hash);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const Entry> entry;
+    const auto loaded_it = loaded_entries_.find(fingerprint_key);
+    if (loaded_it != loaded_entries_.end()) {
+      entry = loaded_it->second;
+    } else {
+      const auto it = entries_by_fingerprint_.find(fingerprint_key);
+      if (it != entries_by_fingerprint_.end()) {
+        entry = it->second.lock();
+      }
+    }
+    if (entry != nullptr) {
+      entries_by_address_[address_key] = entry;
+      return std::shared_ptr<const char>(entry, entry->data);
+    }
+  }
+
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->owned_data.reset(new char[key.unpacked_size + kAlignment]);
+  entry->data = reinterpret_cast<const char*>(
+      AlignUp(reinterpret_cast<uintptr_t>(entry->owned_data.get())));
+  entry->size = key.unpacked_size;
+  entry->has_fingerprint = use_fingerprints;
+  entry->fingerprint_key = fingerprint_key;
+  unpack(const_cast<char*>(entry->data));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  num_unpacks_++;
+  // Another thread may have unpacked the same weights concurrently; keep the
+  // entry that was inserted first.
+  std::weak_ptr<const Entry>& slot = entries_by_address_[address_key];
+  if (std::shared_ptr<const Entry> existing = slot.lock()) {
+    return std::shared_ptr<const char>(existing, existing->data);
+  }
+  slot = entry;
+  if (entry->has_fingerprint) {
+    entries_by_fingerprint_[fingerprint_key] = entry;
+  }
+  PruneExpiredEntries();
+  return std::shared_ptr<const char>(entry, entry->data);
+}
+
+void WeightCache::PruneExpiredEntries() {
+  if (entries_by_address_.size() < prune_threshold_) {
+    return;
+  }
+  for (auto it = entries_by_address_.begin();
+       it != entries_by_address_.end();) {
+    it = it->second.expired() ? entries_by_address_.erase(it) : std::next(it);
+  }
+  for (auto it = entries_by_fingerprint_.begin();
+       it != entries_by_fingerprint_.end();) {
+    it = it->second.expired() ? entries_by_fingerprint_.erase(it)
+                              : std::next(it);
+  }
+  prune_threshold_ = std::max<size_t>(64, 2 * entries_by_address_.size());
+}
+
+bool WeightCache::Load(const std::string& path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    use_fingerprints_ = true;
+    if (std::find(loaded_paths_.begin(), loaded_paths_.end(), path) !=
+        loaded_paths_.end()) {
+      return true;
+    }
+  }
+
+  // A missing file is expected before the first Save().
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fclose(file);
+
+  SilentErrorReporter error_reporter;
+  std::shared_ptr<Allocation> allocation;
+  if (MMAPAllocation::IsSupported()) {
+    allocation.reset(new MMAPAllocation(path.c_str(), &error_reporter));
+  } else {
+    allocation.reset(new FileCopyAllocation(path.c_str(), &error_reporter));
+  }
+  if (!allocation->valid()) {
+    TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+               "Failed to read XNNPACK weight cache file %s", path.c_str());
+    return false;
+  }
+
+  const char* base = static_cast<const char*>(allocation->base());
+  const size_t file_size = allocation->bytes();
+  FileHeader header;
+  if (file_size < sizeof(header)) {
+    TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+               "Invalid XNNPACK weight cache file %s", path.c_str());
+    return false;
+  }
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.num_entries >
+          (file_size - sizeof(header)) / sizeof(FileEntry)) {
+    TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+               "Invalid XNNPACK weight cache file %s", path.c_str());
+    return false;
+  }
+
+  std::vector<std::pair<FingerprintKey, std::shared_ptr<const Entry>>> entries;
+  for (uint64_t i = 0; i < header.num_entries; i++) {
+    FileEntry file_entry;
+    std::memcpy(&file_entry, base + sizeof(header) + i * sizeof(FileEntry),
+                sizeof(file_entry));
+    if (file_entry.offset % kAlignment != 0 || file_entry.offset > file_size ||
+        file_entry.unpacked_size > file_size - file_entry.offset) {
+      TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+                 "Invalid XNNPACK weight cache file %s", path.c_str());
+      return false;
+    }
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->data = base + file_entry.offset;
+    entry->size = file_entry.unpacked_size;
+    entry->has_fingerprint = true;
+    entry->fingerprint_key =
+        FingerprintKey(file_entry.fingerprint, file_entry.source_size,
+                       file_entry.kind, file_entry.params_hash,
+                       file_entry.unpacked_size);
+    entry->allocation = allocation;
+    entries.emplace_back(entry->fingerprint_key, std::move(entry));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& entry : entries) {
+    loaded_entries_.insert(std::move(entry));
+  }
+  loaded_paths_.push_back(path);
+  return true;
+}
+
+bool WeightCache::Save(const std::string& path) {
+  std::vector<std::shared_ptr<const Entry>> entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    use_fingerprints_ = true;
+    for (const auto& loaded_entry : loaded_entries_) {
+      entries.push_back(loaded_entry.second);
+    }
+    for (const auto& weak_entry : entries_by_fingerprint_) {
+      std::shared_ptr<const Entry> entry = weak_entry.second.lock();
+      if (entry != nullptr &&
+          loaded_entries_.count(entry->fingerprint_key) == 0) {
+        entries.push_back(std::move(entry));
+      }
+    }
+  }
+
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.num_entries = entries.size();
+  std::vector<FileEntry> file_entries(entries.size());
+  size_t offset = AlignUp(sizeof(header) + entries.size() * sizeof(FileEntry));
+  for (size_t i = 0; i < entries.size(); i++) {
+    FileEntry& file_entry = file_entries[i];
+    file_entry.fingerprint = std::get<0>(entries[i]->fingerprint_key);
+    file_entry.source_size = std::get<1>(entries[i]->fingerprint_key);
+    file_entry.kind = std::get<2>(entries[i]->fingerprint_key);
+    file_entry.reserved = 0;
+    file_entry.params_hash = std::get<3>(entries[i]->fingerprint_key);
+    file_entry.unpacked_size = entries[i]->size;
+    file_entry.offset = offset;
+    offset = AlignUp(offset + entries[i]->size);
+  }
+
+  const std::string temp_path =
+      path + ".tmp" +
+      std::to_string(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == nullptr) {
+    TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+               "Failed to create XNNPACK weight cache file %s",
+               temp_path.c_str());
+    return false;
+  }
+  bool success =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(file_entries.data(), sizeof(FileEntry), file_entries.size(),
+             file) == file_entries.size();
+  const char padding[kAlignment] = {0};
+  size_t position = sizeof(header) + file_entries.size() * sizeof(FileEntry);
+  for (size_t i = 0; success && i < entries.size(); i++) {
+    const size_t padding_size = file_entries[i].offset - position;
+    success = fwrite(padding, 1, padding_size, file) == padding_size &&
+              fwrite(entries[i]->data, 1, entries[i]->size, file) ==
+                  entries[i]->size;
+    position = file_entries[i].offset + entries[i]->size;
+  }
+  success = fclose(file) == 0 && success;
+  if (success) {
+    // rename() does not replace existing files on all platforms.
+    success = rename(temp_path.c_str(), path.c_str()) == 0 ||
+              (remove(path.c_str()) == 0 &&
+               rename(temp_path.c_str(), path.c_str()) == 0);
+  }
+  if (!success) {
+    remove(temp_path.c_str());
+    TFLITE_LOG(tflite::TFLITE_LOG_WARNING,
+               "Failed to write XNNPACK weight cache file %s", path.c_str());
+  }
+  return success;
+}
+
+int64_t WeightCache::num_unpacks() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_unpacks_;
+}
+
+}  // namespace xnnpack
+}  // namespace tflite
@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_XNNPACK_WEIGHT_CACHE_H_
+#define TENSORFLOW_LITE_DELEGATES_XNNPACK_WEIGHT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace tflite {
+namespace xnnpack {
+
+// Identifies weights unpacked from a static buffer of a model.
+struct WeightCacheKey {
+  // Static (kTfLiteMmapRo) buffer the weights are unpacked from.
+  const void* source = nullptr;
+  size_t source_size = 0;
+  // Kind of unpacking, e.g. the builtin code of the operator unpacking it.
+  int32_t kind = 0;
+  // Any other parameters the unpacked data depends on, such as the shape
+  // and sparsity metadata of the tensor.
+  std::vector<int32_t> params;
+  // Size of the unpacked data in bytes.
+  size_t unpacked_size = 0;
+};
+
+// Process-wide, thread-safe cache of weights that the XNNPACK delegate unpacks
+// from static model buffers. Delegate instances applied to interpreters
+// sharing a model (and thus the static buffers) share a single copy of the
+// unpacked weights, instead of unpacking them again for each interpreter.
+//
+// Entries live as long as any delegate uses them. In addition, the cache can
+// be persisted to a file with Save() and memory-mapped in a later process
+// with Load(); once a file was loaded or saved, entries are matched by a
+// fingerprint of the source contents, rather than by the source address.
+class WeightCache {
+ public:
+  // Fills `unpacked_data` (key.unpacked_size bytes) from key.source.
+  using UnpackFunction = std::function<void(char* unpacked_data)>;
+
+  WeightCache() = default;
+  WeightCache(const WeightCache&) = delete;
+  WeightCache& operator=(const WeightCache&) = delete;
+
+  // Returns the cache shared by all delegate instances in the process.
+  static WeightCache& Global();
+
+  // Returns the unpacked data for `key`, calling `unpack` to produce it if it
+  // is not cached. The data remains valid while any copy of the returned
+  // pointer is alive.
+  std::shared_ptr<const char> GetOrUnpack(const WeightCacheKey& key,
+                                          const UnpackFunction& unpack);
+
+  // Memory-maps entries serialized with Save(). Returns false if the file
+  // does not exist or is not a valid cache file. Loading the same path again
+  // is a no-op.
+  bool Load(const std::string& path);
+
+  // Serializes all live entries to `path`. The file is written to a temporary
+  // path and renamed, so that concurrent readers never see a partial file.
+  bool Save(const std::string& path);
+
+  // Number of times GetOrUnpack() had to unpack weights.
+  int64_t num_unpacks() const;
+
+ private:
+  struct Entry;
+  // Source address, source size, kind, params hash, and unpacked size.
+  using AddressKey =
+      std::tuple<const void*, size_t, int32_t, uint64_t, size_t>;
+  // Source fingerprint, source size, kind, params hash, and unpacked size.
+  using FingerprintKey =
+      std::tuple<uint64_t, size_t, int32_t, uint64_t, size_t>;
+
+  void PruneExpiredEntries();
+
+  static FingerprintKey GetFingerprintKey(const WeightCacheKey& key,
+                                          uint64_t params_hash);
+
+  mutable std::mutex mutex_;
+  std::map<AddressKey, std::weak_ptr<const Entry>> entries_by_address_;
+  std::map<FingerprintKey, std::weak_ptr<const Entry>>
+      entries_by_fingerprint_;
+  // Entries backed by loaded files, which stay alive for the lifetime of the
+  // cache.
+  std::map<FingerprintKey, std::shared_ptr<const Entry>> loaded_entries_;
+  std::vector<std::string> loaded_paths_;
+  // Whether entries are also matched by fingerprint.
+  bool use_fingerprints_ = false;
+  int64_t num_unpacks_ = 0;
+  // Number of entries in entries_by_address_ above which expired entries are
+  // pruned.
+  size_t prune_threshold_ = 64;
+};
+
+}  // namespace xnnpack
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_XNNPACK_WEIGHT_CACHE_H_
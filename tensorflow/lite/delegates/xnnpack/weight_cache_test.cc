@@ -0,0 +1,178 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/delegates/xnnpack/weight_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+// Key for "unpacking" that doubles every element of `source`.
+WeightCacheKey DoubleKey(const std::vector<float>& source) {
+  WeightCacheKey key;
+  key.source = source.data();
+  key.source_size = source.size() * sizeof(float);
+  key.kind = 1;
+  key.params = {static_cast<int32_t>(source.size())};
+  key.unpacked_size = source.size() * sizeof(float);
+  return key;
+}
+
+WeightCache::UnpackFunction Double(const std::vector<float>& source) {
+  return [&source](char* unpacked_data) {
+    float* output = reinterpret_cast<float*>(unpacked_data);
+    for (size_t i = 0; i < source.size(); i++) {
+      output[i] = 2.0f * source[i];
+    }
+  };
+}
+
+std::string TempPath(const std::string& name) {
+  return ::testing::TempDir() + "/" + name;
+}
+
+TEST(WeightCache, SharesUnpackedWeights) {
+  WeightCache cache;
+  const std::vector<float> source = {1.0f, 2.0f, 3.0f};
+
+  std::shared_ptr<const char> first =
+      cache.GetOrUnpack(DoubleKey(source), Double(source));
+  std::shared_ptr<const char> second =
+      cache.GetOrUnpack(DoubleKey(source), Double(source));
+
+  EXPECT_EQ(cache.num_unpacks(), 1);
+  EXPECT_EQ(first.get(), second.get());
+  const float* data = reinterpret_cast<const float*>(first.get());
+  EXPECT_EQ(data[0], 2.0f);
+  EXPECT_EQ(data[1], 4.0f);
+  EXPECT_EQ(data[2], 6.0f);
+}
+
+TEST(WeightCache, AlignsUnpackedWeights) {
+  WeightCache cache;
+  const std::vector<float> source = {1.0f};
+
+  std::shared_ptr<const char> data =
+      cache.GetOrUnpack(DoubleKey(source), Double(source));
+
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data.get()) % 64, 0);
+}
+
+TEST(WeightCache, DistinguishesParams) {
+  WeightCache cache;
+  const std::vector<float> source = {1.0f, 2.0f};
+  WeightCacheKey other_key = DoubleKey(source);
+  other_key.params.push_back(7);
+
+  cache.GetOrUnpack(DoubleKey(source), Double(source));
+  cache.GetOrUnpack(other_key, Double(source));
+
+  EXPECT_EQ(cache.num_unpacks(), 2);
+}
+
+TEST(WeightCache, ReleasesUnusedWeights) {
+  WeightCache cache;
+  const std::vector<float> source = {1.0f, 2.0f};
+
+  cache.GetOrUnpack(DoubleKey(source), Double(source));
+  cache.GetOrUnpack(DoubleKey(source), Double(source));
+
+  EXPECT_EQ(cache.num_unpacks(), 2);
+}
+
+TEST(WeightCache, IsThreadSafe) {
+  WeightCache cache;
+  const std::vector<float> source(1024, 1.0f);
+
+  std::vector<std::shared_ptr<const char>> results(8);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < results.size(); i++) {
+    threads.emplace_back([&, i] {
+      results[i] = cache.GetOrUnpack(DoubleKey(source), Double(source));
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (const std::shared_ptr<const char>& result : results) {
+    EXPECT_EQ(result.get(), results[0].get());
+  }
+  EXPECT_GE(cache.num_unpacks(), 1);
+  EXPECT_LE(cache.num_unpacks(), results.size());
+}
+
+TEST(WeightCache, SavesAndLoadsWeights) {
+  const std::string path = TempPath("weight_cache_test_save_and_load.bin");
+  std::remove(path.c_str());
+  const std::vector<float> source = {1.0f, 2.0f, 3.0f};
+  const std::vector<float> other_source = {5.0f};
+
+  WeightCache cache;
+  EXPECT_FALSE(cache.Load(path));
+  std::shared_ptr<const char> data =
+      cache.GetOrUnpack(DoubleKey(source), Double(source));
+  std::shared_ptr<const char> other_data =
+      cache.GetOrUnpack(DoubleKey(other_source), Double(other_source));
+  ASSERT_TRUE(cache.Save(path));
+
+  // A copy of the weights at a different address, as in another process.
+  const std::vector<float> source_copy = source;
+  WeightCache loaded_cache;
+  ASSERT_TRUE(loaded_cache.Load(path));
+  std::shared_ptr<const char> loaded_data =
+      loaded_cache.GetOrUnpack(DoubleKey(source_copy), Double(source_copy));
+
+  EXPECT_EQ(loaded_cache.num_unpacks(), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(loaded_data.get()) % 64, 0);
+  EXPECT_EQ(std::memcmp(loaded_data.get(), data.get(),
+                        source.size() * sizeof(float)),
+            0);
+
+  // Different contents do not match the loaded weights.
+  const std::vector<float> modified_source = {1.0f, 2.0f, 4.0f};
+  loaded_cache.GetOrUnpack(DoubleKey(modified_source),
+                           Double(modified_source));
+  EXPECT_EQ(loaded_cache.num_unpacks(), 1);
+
+  std::remove(path.c_str());
+}
+
+TEST(WeightCache, RejectsInvalidFile) {
+  const std::string path = TempPath("weight_cache_test_invalid.bin");
+  FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fputs("not a weight cache", file);
+  std::fclose(file);
+
+  WeightCache cache;
+  EXPECT_FALSE(cache.Load(path));
+
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace xnnpack
+}  // namespace tflite
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/xnnpack/weight_cache.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
 
@@ -42,6 +43,16 @@ namespace {
 // Forward declaration.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
 
+// Appends the size and elements of `array` (or -1 for nullptr) to `params`.
+void AppendIntArray(const TfLiteIntArray* array, std::vector<int32_t>* params) {
+  if (array == nullptr) {
+    params->push_back(-1);
+    return;
+  }
+  params->push_back(array->size);
+  params->insert(params->end(), &array->data[0], &array->data[array->size]);
+}
+
 class Delegate {
   friend class Subgraph;
 
@@ -53,6 +64,9 @@ class Delegate {
           pthreadpool_create(static_cast<size_t>(options->num_threads)));
     }
 #endif
+    if (options != nullptr && options->weight_cache_path != nullptr) {
+      weight_cache_path_ = options->weight_cache_path;
+    }
     TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                          "Created TensorFlow Lite XNNPACK delegate for CPU.");
   }
@@ -79,16 +93,19 @@ class Delegate {
   };
 
   // Unpacked data for quasi-static tensors, i.e. tensors produced by
-  // dequantizing or unpacking static buffers.
-  std::vector<char> static_unpacked_data_;
-  // Mapping from a tensor index for a quasi-static tensor to the offset to
-  // its unpacked data within static_unpacked_data_.
-  std::unordered_map<int, size_t> static_unpacked_data_map_;
+  // dequantizing or unpacking static buffers. The data is owned by the
+  // process-wide WeightCache and shared with other delegate instances.
+  std::vector<std::shared_ptr<const char>> static_unpacked_data_;
+  // Mapping from a tensor index for a quasi-static tensor to its unpacked data
+  // within static_unpacked_data_.
+  std::unordered_map<int, const char*> static_unpacked_data_map_;
   // Set of indices of nodes which unpack static data, e.g. Dequantize
   // operators which convert FP16 static weights to FP32. These nodes are simply
   // ignored in the delegate implementation, because their outputs are
   // pre-unpacked in DelegatePrepare.
   std::unordered_set<int> static_unpack_nodes_;
+  // File to persist the weight cache to, or empty.
+  std::string weight_cache_path_;
 #if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
   // Thread pool with smart-pointer for lifetime management.
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)> threadpool_{
@@ -203,7 +220,7 @@ class Subgraph {
         // Check for quasi-static data.
         const auto it = delegate->static_unpacked_data_map_.find(t);
         if (it != delegate->static_unpacked_data_map_.end()) {
-          data = delegate->static_unpacked_data_.data() + it->second;
+          data = it->second;
         }
       }
       if (inputs.count(t) != 0) {
@@ -232,7 +249,7 @@ class Subgraph {
 
     // Create a set of quasi-static tensors for VisitNode function
     std::unordered_set<int> quasi_static_tensors;
-    for (const std::pair<const int, size_t>& entry :
+    for (const std::pair<const int, const char*>& entry :
          delegate->static_unpacked_data_map_) {
       quasi_static_tensors.insert(entry.first);
     }
@@ -2898,7 +2915,12 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     nodes_to_delegate->data[nodes_to_delegate->size++] = node_index;
   }
 
-  // Unpack static data of all tensors
+  // Unpack static data of all tensors, or reuse data unpacked by other
+  // delegate instances or loaded from the cache file.
+  if (!weight_cache_path_.empty()) {
+    WeightCache::Global().Load(weight_cache_path_);
+  }
+  const int64_t num_unpacks = WeightCache::Global().num_unpacks();
   for (int t : quasi_static_tensors_to_unpack) {
     const int producer_index = quasi_static_tensors_producers[t];
     // Check if TFLite nodes can be delegated to XNNPACK
@@ -2948,15 +2970,13 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     }
     const size_t tensor_elements = output_tensor.bytes / sizeof(float);
 
-    // Align to XNN_EXTRA_BYTES bytes
-    while (static_unpacked_data_.size() % XNN_EXTRA_BYTES != 0) {
-      static_unpacked_data_.push_back(0);
-    }
-    const size_t tensor_offset = static_unpacked_data_.size();
-    static_unpacked_data_.resize(tensor_offset + context->tensors[t].bytes);
-
-    float* unpacked_data =
-        reinterpret_cast<float*>(static_unpacked_data_.data() + tensor_offset);
+    WeightCacheKey cache_key;
+    cache_key.source = input_tensor.data.raw_const;
+    cache_key.source_size = input_tensor.bytes;
+    cache_key.kind = registration->builtin_code;
+    AppendIntArray(output_tensor.dims, &cache_key.params);
+    cache_key.unpacked_size = output_tensor.bytes;
+    WeightCache::UnpackFunction unpack;
     switch (registration->builtin_code) {
       case kTfLiteBuiltinDequantize: {
         if (input_tensor.type != kTfLiteFloat16) {
@@ -2978,9 +2998,12 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
 
         const uint16_t* packed_data =
             static_cast<const uint16_t*>(input_tensor.data.data);
-        for (size_t i = 0; i < tensor_elements; i++) {
-          unpacked_data[i] = fp16_ieee_to_fp32_value(packed_data[i]);
-        }
+        unpack = [packed_data, tensor_elements](char* data) {
+          float* unpacked_data = reinterpret_cast<float*>(data);
+          for (size_t i = 0; i < tensor_elements; i++) {
+            unpacked_data[i] = fp16_ieee_to_fp32_value(packed_data[i]);
+          }
+        };
         break;
       }
       case kTfLiteBuiltinDensify: {
@@ -3000,19 +3023,29 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
           return nullptr;  // Hard error.
         }
 
-        const int dims_count = output_tensor.dims->size;
-        std::vector<int> vector_shape(dims_count);
-        for (int i = 0; i < dims_count; i++) {
-          vector_shape[i] = output_tensor.dims->data[i];
+        const TfLiteSparsity& sparsity = *input_tensor.sparsity;
+        AppendIntArray(sparsity.traversal_order, &cache_key.params);
+        AppendIntArray(sparsity.block_map, &cache_key.params);
+        for (int i = 0; i < sparsity.dim_metadata_size; i++) {
+          const TfLiteDimensionMetadata& dim_metadata =
+              sparsity.dim_metadata[i];
+          cache_key.params.push_back(dim_metadata.format);
+          cache_key.params.push_back(dim_metadata.dense_size);
+          AppendIntArray(dim_metadata.array_segments, &cache_key.params);
+          AppendIntArray(dim_metadata.array_indices, &cache_key.params);
         }
 
-        tflite::optimize::sparsity::FormatConverter<float> converter(
-            vector_shape, *input_tensor.sparsity);
-        converter.SparseToDense(input_tensor.data.f);
-        const std::vector<float> out = converter.GetData();
-        for (int i = 0; i < out.size(); i++) {
-          unpacked_data[i] = out[i];
-        }
+        const std::vector<int> vector_shape(
+            &output_tensor.dims->data[0],
+            &output_tensor.dims->data[output_tensor.dims->size]);
+        const float* sparse_data = input_tensor.data.f;
+        unpack = [vector_shape, &sparsity, sparse_data](char* data) {
+          tflite::optimize::sparsity::FormatConverter<float> converter(
+              vector_shape, sparsity);
+          converter.SparseToDense(sparse_data);
+          const std::vector<float>& out = converter.GetData();
+          std::copy(out.begin(), out.end(), reinterpret_cast<float*>(data));
+        };
 
         break;
       }
@@ -3023,7 +3056,16 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
         return nullptr;  // Hard error.
     }
 
-    static_unpacked_data_map_[t] = tensor_offset;
+    static_unpacked_data_.push_back(
+        WeightCache::Global().GetOrUnpack(cache_key, unpack));
+    static_unpacked_data_map_[t] = static_unpacked_data_.back().get();
+  }
+
+  if (!weight_cache_path_.empty() &&
+      WeightCache::Global().num_unpacks() != num_unpacks) {
+    // Persist the newly unpacked weights for later processes. Failing to write
+    // the cache file only affects load time, and is not an error.
+    WeightCache::Global().Save(weight_cache_path_);
   }
 
   // Add nodes that unpack static data consumed by delegated nodes.
@@ -26,6 +26,13 @@ typedef struct {
   // Number of threads to use in the thread pool.
   // 0 or negative value means no thread pool used.
   int32_t num_threads;
+  // Path of a file to persist weights which the delegate unpacks from static
+  // model buffers (FP16 and sparse weights) across processes. When set, the
+  // file is memory-mapped and its weights are reused if it exists, and it is
+  // (re)written whenever the delegate unpacks weights missing in the file.
+  // Unpacked weights are shared between all delegate instances in a process
+  // regardless of this option. nullptr disables the file.
+  const char* weight_cache_path;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns a structure with the default XNNPack delegate options.
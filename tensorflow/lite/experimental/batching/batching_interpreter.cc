@@ -0,0 +1,188 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/batching/batching_interpreter.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+
+#include "tensorflow/lite/core/api/error_reporter.h"
+
+namespace tflite {
+namespace batching {
+
+struct BatchingInterpreter::Request {
+  const std::vector<const void*>* inputs;
+  const std::vector<void*>* outputs;
+  TfLiteStatus status = kTfLiteOk;
+  bool done = false;
+};
+
+TfLiteStatus BatchingInterpreter::Create(
+    Interpreter* interpreter, const Options& options,
+    std::unique_ptr<BatchingInterpreter>* batching_interpreter) {
+  if (options.max_batch_size < 1) {
+    TF_LITE_REPORT_ERROR(interpreter->error_reporter(),
+                         "max_batch_size must be positive, got %d.",
+                         options.max_batch_size);
+    return kTfLiteError;
+  }
+  for (int input : interpreter->inputs()) {
+    const TfLiteTensor* tensor = interpreter->tensor(input);
+    if (tensor->type == kTfLiteString || tensor->dims->size < 1 ||
+        tensor->dims->data[0] != 1) {
+      TF_LITE_REPORT_ERROR(interpreter->error_reporter(),
+                           "Input '%s' does not have a batch dimension of 1.",
+                           tensor->name);
+      return kTfLiteError;
+    }
+  }
+  batching_interpreter->reset(new BatchingInterpreter(interpreter, options));
+  return kTfLiteOk;
+}
+
+BatchingInterpreter::BatchingInterpreter(Interpreter* interpreter,
+                                         const Options& options)
+    : interpreter_(interpreter), options_(options) {
+  for (int input : interpreter_->inputs()) {
+    const TfLiteTensor* tensor = interpreter_->tensor(input);
+    input_row_dims_.emplace_back(tensor->dims->data,
+                                 tensor->dims->data + tensor->dims->size);
+    input_row_bytes_.push_back(tensor->bytes);
+  }
+  thread_ = std::thread(&BatchingInterpreter::RunBatches, this);
+}
+
+BatchingInterpreter::~BatchingInterpreter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queued_.notify_all();
+  thread_.join();
+}
+
+TfLiteStatus BatchingInterpreter::Invoke(const std::vector<const void*>& inputs,
+                                         const std::vector<void*>& outputs) {
+  if (inputs.size() != interpreter_->inputs().size() ||
+      outputs.size() != interpreter_->outputs().size()) {
+    TF_LITE_REPORT_ERROR(
+        interpreter_->error_reporter(),
+        "Expected %d inputs and %d outputs, got %d and %d.",
+        static_cast<int>(interpreter_->inputs().size()),
+        static_cast<int>(interpreter_->outputs().size()),
+        static_cast<int>(inputs.size()), static_cast<int>(outputs.size()));
+    return kTfLiteError;
+  }
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = &outputs;
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.push_back(&request);
+  queued_.notify_all();
+  done_.wait(lock, [&request] { return request.done; });
+  return request.status;
+}
+
+int64_t BatchingInterpreter::num_batches() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_batches_;
+}
+
+void BatchingInterpreter::RunBatches() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    if (options_.batch_timeout_micros > 0) {
+      queued_.wait_for(
+          lock, std::chrono::microseconds(options_.batch_timeout_micros),
+          [this] {
+            return stopping_ || queue_.size() >= static_cast<size_t>(
+                                                 options_.max_batch_size);
+          });
+    }
+    const size_t batch_size =
+        std::min(queue_.size(), static_cast<size_t>(options_.max_batch_size));
+    std::vector<Request*> batch(queue_.begin(), queue_.begin() + batch_size);
+    queue_.erase(queue_.begin(), queue_.begin() + batch_size);
+
+    lock.unlock();
+    const TfLiteStatus status = RunBatch(batch);
+    lock.lock();
+
+    for (Request* request : batch) {
+      request->status = status;
+      request->done = true;
+    }
+    ++num_batches_;
+    done_.notify_all();
+  }
+}
+
+TfLiteStatus BatchingInterpreter::RunBatch(const std::vector<Request*>& batch) {
+  const int batch_size = batch.size();
+  const std::vector<int>& inputs = interpreter_->inputs();
+  if (batch_size != batch_size_) {
+    batch_size_ = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      std::vector<int> dims = input_row_dims_[i];
+      dims[0] = batch_size;
+      if (interpreter_->ResizeInputTensor(inputs[i], dims) != kTfLiteOk) {
+        return kTfLiteError;
+      }
+    }
+    if (interpreter_->AllocateTensors() != kTfLiteOk) {
+      return kTfLiteError;
+    }
+    batch_size_ = batch_size;
+  }
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    char* data = interpreter_->tensor(inputs[i])->data.raw;
+    for (const Request* request : batch) {
+      std::memcpy(data, (*request->inputs)[i], input_row_bytes_[i]);
+      data += input_row_bytes_[i];
+    }
+  }
+
+  if (interpreter_->Invoke() != kTfLiteOk) {
+    return kTfLiteError;
+  }
+
+  const std::vector<int>& outputs = interpreter_->outputs();
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    const TfLiteTensor* tensor = interpreter_->tensor(outputs[i]);
+    if (tensor->type == kTfLiteString || tensor->dims->size < 1 ||
+        tensor->dims->data[0] != batch_size) {
+      TF_LITE_REPORT_ERROR(interpreter_->error_reporter(),
+                           "Output '%s' does not have a batch dimension of %d.",
+                           tensor->name, batch_size);
+      return kTfLiteError;
+    }
+    const size_t row_bytes = tensor->bytes / batch_size;
+    const char* data = tensor->data.raw;
+    for (const Request* request : batch) {
+      std::memcpy((*request->outputs)[i], data, row_bytes);
+      data += row_bytes;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace batching
+}  // namespace tflite
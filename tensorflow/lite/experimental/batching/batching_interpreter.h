@@ -0,0 +1,116 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_BATCHING_INTERPRETER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_BATCHING_INTERPRETER_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace tflite {
+namespace batching {
+
+// WARNING: Experimental interface, subject to change.
+//
+// Runs the concurrent requests made to a model exported with batch 1 in
+// batches, for throughput serving.
+//
+// Every input of the model must have a leading batch dimension of size 1.
+// Each call to Invoke() queues a request holding one row of every input, and
+// blocks until the batch it was put in has run. A batch is formed by a
+// dedicated thread from up to `max_batch_size` queued requests: the batch
+// dimension of the inputs is resized to the number of requests, their rows are
+// copied into the input tensors, the interpreter runs once and the rows of
+// the outputs are copied back to the requests.
+//
+// Resizing reallocates the tensors, but the arena planner caches the plans of
+// the most recently used tensor sizes, so going back and forth between a few
+// batch sizes does not replan the arena every time.
+//
+// The interpreter must not be used by anything else while the
+// BatchingInterpreter exists. Invoke() is thread-safe.
+class BatchingInterpreter {
+ public:
+  struct Options {
+    // The largest number of requests run in one batch.
+    int max_batch_size = 8;
+    // How long a batch waits for more requests once its first request is
+    // queued. By default, a batch runs the requests already queued.
+    int64_t batch_timeout_micros = 0;
+  };
+
+  // Creates a BatchingInterpreter running `interpreter`, which must outlive
+  // it. Returns an error if the inputs of `interpreter` do not have a batch
+  // dimension of size 1.
+  static TfLiteStatus Create(
+      Interpreter* interpreter, const Options& options,
+      std::unique_ptr<BatchingInterpreter>* batching_interpreter);
+
+  // Runs the requests still queued before returning.
+  ~BatchingInterpreter();
+
+  BatchingInterpreter(const BatchingInterpreter&) = delete;
+  BatchingInterpreter& operator=(const BatchingInterpreter&) = delete;
+
+  // Runs the model on one request. `inputs` holds the row of every input of
+  // the model, in the order of Interpreter::inputs(), and `outputs` the
+  // buffers the rows of the outputs are copied to, in the order of
+  // Interpreter::outputs(). Returns an error if the batch failed to run.
+  TfLiteStatus Invoke(const std::vector<const void*>& inputs,
+                      const std::vector<void*>& outputs);
+
+  // Returns the number of batches run so far.
+  int64_t num_batches() const;
+
+ private:
+  struct Request;
+
+  BatchingInterpreter(Interpreter* interpreter, const Options& options);
+
+  // Forms and runs batches until destruction.
+  void RunBatches();
+  TfLiteStatus RunBatch(const std::vector<Request*>& batch);
+
+  Interpreter* const interpreter_;
+  const Options options_;
+  // The shape and size of one row of every input.
+  std::vector<std::vector<int>> input_row_dims_;
+  std::vector<size_t> input_row_bytes_;
+  // The batch size the tensors are allocated for, or 0.
+  int batch_size_ = 0;
+
+  mutable std::mutex mutex_;
+  // Signaled when a request is queued or on destruction.
+  std::condition_variable queued_;
+  // Signaled when a batch has run.
+  std::condition_variable done_;
+  std::deque<Request*> queue_;
+  int64_t num_batches_ = 0;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace batching
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_BATCHING_INTERPRETER_H_
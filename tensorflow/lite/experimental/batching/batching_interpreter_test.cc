@@ -0,0 +1,149 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/batching/batching_interpreter.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace batching {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Returns an op computing out = 2 * in for float tensors.
+TfLiteRegistration* GetDoubleRegistration() {
+  static TfLiteRegistration reg = {
+      nullptr, nullptr,
+      [](TfLiteContext* context, TfLiteNode* node) {
+        const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+        TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+        return context->ResizeTensor(context, output,
+                                     TfLiteIntArrayCopy(input->dims));
+      },
+      [](TfLiteContext* context, TfLiteNode* node) {
+        const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+        TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+        for (size_t i = 0; i < input->bytes / sizeof(float); ++i) {
+          output->data.f[i] = 2 * input->data.f[i];
+        }
+        return kTfLiteOk;
+      }};
+  return &reg;
+}
+
+// Builds a graph doubling a [1, 2] float input.
+void BuildDoubleGraph(Interpreter* interpreter) {
+  ASSERT_EQ(interpreter->AddTensors(2), kTfLiteOk);
+  ASSERT_EQ(interpreter->SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter->SetOutputs({1}), kTfLiteOk);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(interpreter->SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {1, 2}, TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter->AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                               GetDoubleRegistration()),
+            kTfLiteOk);
+}
+
+TEST(BatchingInterpreterTest, SingleRequest) {
+  Interpreter interpreter;
+  BuildDoubleGraph(&interpreter);
+  std::unique_ptr<BatchingInterpreter> batching_interpreter;
+  ASSERT_EQ(BatchingInterpreter::Create(&interpreter, {},
+                                        &batching_interpreter),
+            kTfLiteOk);
+
+  const float input[2] = {1, 2};
+  float output[2] = {0, 0};
+  ASSERT_EQ(batching_interpreter->Invoke({input}, {output}), kTfLiteOk);
+  EXPECT_THAT(output, ElementsAre(2, 4));
+  EXPECT_EQ(batching_interpreter->num_batches(), 1);
+}
+
+TEST(BatchingInterpreterTest, ConcurrentRequestsAreBatched) {
+  Interpreter interpreter;
+  BuildDoubleGraph(&interpreter);
+  BatchingInterpreter::Options options;
+  options.max_batch_size = 4;
+  options.batch_timeout_micros = 100000;
+  std::unique_ptr<BatchingInterpreter> batching_interpreter;
+  ASSERT_EQ(BatchingInterpreter::Create(&interpreter, options,
+                                        &batching_interpreter),
+            kTfLiteOk);
+
+  constexpr int kNumRequests = 8;
+  float inputs[kNumRequests][2];
+  float outputs[kNumRequests][2];
+  TfLiteStatus statuses[kNumRequests];
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumRequests; ++i) {
+    inputs[i][0] = i;
+    inputs[i][1] = -i;
+    threads.emplace_back([&, i] {
+      statuses[i] = batching_interpreter->Invoke({inputs[i]}, {outputs[i]});
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < kNumRequests; ++i) {
+    EXPECT_EQ(statuses[i], kTfLiteOk);
+    EXPECT_THAT(outputs[i], ElementsAre(2 * i, -2 * i));
+  }
+  EXPECT_GE(batching_interpreter->num_batches(), 2);
+  EXPECT_LT(batching_interpreter->num_batches(), kNumRequests);
+}
+
+TEST(BatchingInterpreterTest, RejectsInputsWithoutBatchOfOne) {
+  Interpreter interpreter;
+  BuildDoubleGraph(&interpreter);
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {2, 2}), kTfLiteOk);
+  std::unique_ptr<BatchingInterpreter> batching_interpreter;
+  EXPECT_EQ(BatchingInterpreter::Create(&interpreter, {},
+                                        &batching_interpreter),
+            kTfLiteError);
+  EXPECT_EQ(batching_interpreter, nullptr);
+}
+
+TEST(BatchingInterpreterTest, RejectsWrongNumberOfInputs) {
+  Interpreter interpreter;
+  BuildDoubleGraph(&interpreter);
+  std::unique_ptr<BatchingInterpreter> batching_interpreter;
+  ASSERT_EQ(BatchingInterpreter::Create(&interpreter, {},
+                                        &batching_interpreter),
+            kTfLiteOk);
+  float output[2];
+  EXPECT_EQ(batching_interpreter->Invoke({}, {output}), kTfLiteError);
+}
+
+}  // namespace
+}  // namespace batching
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,395 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/delegates/xla/hlo_builder.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/client/lib/arithmetic.h"
+#include "tensorflow/compiler/xla/client/lib/constants.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace xla_delegate {
+namespace {
+
+bool IsFloatTensor(const TfLiteContext* context, int tensor_index) {
+  return tensor_index >= 0 &&
+         context->tensors[tensor_index].type == kTfLiteFloat32;
+}
+
+// Returns true if all the inputs, except for missing optional ones, and all the
+// outputs of 'node' are float32 tensors.
+bool HasOnlyFloatTensors(const TfLiteContext* context, const TfLiteNode* node) {
+  for (int i = 0; i < node->inputs->size; ++i) {
+    const int tensor_index = node->inputs->data[i];
+    if (tensor_index != kTfLiteOptionalTensor &&
+        !IsFloatTensor(context, tensor_index)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < node->outputs->size; ++i) {
+    if (!IsFloatTensor(context, node->outputs->data[i])) return false;
+  }
+  return true;
+}
+
+bool IsSupportedActivation(TfLiteFusedActivation activation) {
+  switch (activation) {
+    case kTfLiteActNone:
+    case kTfLiteActRelu:
+    case kTfLiteActReluN1To1:
+    case kTfLiteActRelu6:
+    case kTfLiteActTanh:
+    case kTfLiteActSigmoid:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if the shapes of 'lhs' and 'rhs' can be broadcast together
+// following the NumPy rules.
+bool AreBroadcastable(const TfLiteTensor& lhs, const TfLiteTensor& rhs) {
+  for (int i = 1; i <= std::min(lhs.dims->size, rhs.dims->size); ++i) {
+    const int lhs_dim = lhs.dims->data[lhs.dims->size - i];
+    const int rhs_dim = rhs.dims->data[rhs.dims->size - i];
+    if (lhs_dim != rhs_dim && lhs_dim != 1 && rhs_dim != 1) return false;
+  }
+  return true;
+}
+
+xla::XlaOp ApplyActivation(xla::XlaOp x, TfLiteFusedActivation activation) {
+  xla::XlaBuilder* builder = x.builder();
+  switch (activation) {
+    case kTfLiteActRelu:
+      return xla::Max(x, xla::ConstantR0<float>(builder, 0.0f));
+    case kTfLiteActReluN1To1:
+      return xla::Clamp(xla::ConstantR0<float>(builder, -1.0f), x,
+                        xla::ConstantR0<float>(builder, 1.0f));
+    case kTfLiteActRelu6:
+      return xla::Clamp(xla::ConstantR0<float>(builder, 0.0f), x,
+                        xla::ConstantR0<float>(builder, 6.0f));
+    case kTfLiteActTanh:
+      return xla::Tanh(x);
+    case kTfLiteActSigmoid:
+      return xla::Logistic(x);
+    default:
+      return x;
+  }
+}
+
+// Expands the rank of 'x' to 'rank' by adding leading dimensions of size 1,
+// which XLA then broadcasts implicitly like NumPy does.
+xla::StatusOr<xla::XlaOp> ExpandToRank(xla::XlaOp x, int64_t rank) {
+  TF_ASSIGN_OR_RETURN(xla::Shape shape, x.builder()->GetShape(x));
+  if (shape.rank() >= rank) return x;
+  std::vector<xla::int64> dims(rank - shape.rank(), 1);
+  dims.insert(dims.end(), shape.dimensions().begin(),
+              shape.dimensions().end());
+  return xla::Reshape(x, dims);
+}
+
+xla::StatusOr<xla::XlaOp> BuildBinary(int builtin_code, xla::XlaOp lhs,
+                                      xla::XlaOp rhs) {
+  TF_ASSIGN_OR_RETURN(xla::Shape lhs_shape, lhs.builder()->GetShape(lhs));
+  TF_ASSIGN_OR_RETURN(xla::Shape rhs_shape, rhs.builder()->GetShape(rhs));
+  const int64_t rank = std::max(lhs_shape.rank(), rhs_shape.rank());
+  TF_ASSIGN_OR_RETURN(lhs, ExpandToRank(lhs, rank));
+  TF_ASSIGN_OR_RETURN(rhs, ExpandToRank(rhs, rank));
+  switch (builtin_code) {
+    case kTfLiteBuiltinAdd:
+      return xla::Add(lhs, rhs);
+    case kTfLiteBuiltinSub:
+      return xla::Sub(lhs, rhs);
+    case kTfLiteBuiltinMul:
+      return xla::Mul(lhs, rhs);
+    case kTfLiteBuiltinDiv:
+      return xla::Div(lhs, rhs);
+    case kTfLiteBuiltinMaximum:
+      return xla::Max(lhs, rhs);
+    case kTfLiteBuiltinMinimum:
+      return xla::Min(lhs, rhs);
+    default:
+      return xla::Unimplemented("Unsupported binary op %d", builtin_code);
+  }
+}
+
+xla::StatusOr<xla::XlaOp> BuildFullyConnected(const NodeInfo& node,
+                                              xla::XlaOp input,
+                                              xla::XlaOp filter,
+                                              const xla::XlaOp* bias) {
+  xla::XlaBuilder* builder = input.builder();
+  TF_ASSIGN_OR_RETURN(xla::Shape input_shape, builder->GetShape(input));
+  TF_ASSIGN_OR_RETURN(xla::Shape filter_shape, builder->GetShape(filter));
+  const xla::int64 num_units = filter_shape.dimensions(0);
+  const xla::int64 input_size = filter_shape.dimensions(1);
+  const xla::int64 num_elements = xla::ShapeUtil::ElementsIn(input_shape);
+  if (input_size == 0 || num_elements % input_size != 0) {
+    return xla::InvalidArgument(
+        "FULLY_CONNECTED input of %d elements is not a multiple of the input "
+        "size %d",
+        num_elements, input_size);
+  }
+
+  // Like the builtin kernel, treats the input as a [batch, input_size] matrix.
+  xla::XlaOp x = xla::Reshape(input, {num_elements / input_size, input_size});
+  xla::DotDimensionNumbers dnums;
+  dnums.add_lhs_contracting_dimensions(1);
+  dnums.add_rhs_contracting_dimensions(1);
+  xla::XlaOp y = xla::DotGeneral(x, filter, dnums);
+  if (bias != nullptr) {
+    y = xla::Add(y, *bias, /*broadcast_dimensions=*/{1});
+  }
+  y = ApplyActivation(y, node.activation);
+  if (node.keep_num_dims) {
+    std::vector<xla::int64> dims(input_shape.dimensions().begin(),
+                                 input_shape.dimensions().end());
+    dims.back() = num_units;
+    y = xla::Reshape(y, dims);
+  }
+  return y;
+}
+
+xla::StatusOr<xla::XlaOp> BuildSoftmax(const NodeInfo& node, xla::XlaOp x) {
+  xla::XlaBuilder* builder = x.builder();
+  TF_ASSIGN_OR_RETURN(xla::Shape shape, builder->GetShape(x));
+  const xla::int64 last_dim = shape.rank() - 1;
+  std::vector<xla::int64> batch_dims(last_dim);
+  std::iota(batch_dims.begin(), batch_dims.end(), 0);
+
+  // Subtracts the maximum of each row for numerical stability, as the builtin
+  // kernel does.
+  xla::XlaOp max = xla::Reduce(
+      x, xla::MinValue(builder, xla::F32),
+      xla::CreateScalarMaxComputation(xla::F32, builder), {last_dim});
+  xla::XlaOp beta = xla::ConstantR0<float>(builder, node.beta);
+  xla::XlaOp exp = xla::Exp(xla::Mul(xla::Sub(x, max, batch_dims), beta));
+  xla::XlaOp sum = xla::Reduce(
+      exp, xla::ConstantR0<float>(builder, 0.0f),
+      xla::CreateScalarAddComputation(xla::F32, builder), {last_dim});
+  return xla::Div(exp, sum, batch_dims);
+}
+
+xla::StatusOr<xla::XlaOp> BuildConcatenation(const NodeInfo& node,
+                                             absl::Span<const xla::XlaOp> xs) {
+  xla::XlaBuilder* builder = xs[0].builder();
+  TF_ASSIGN_OR_RETURN(xla::Shape shape, builder->GetShape(xs[0]));
+  const xla::int64 axis = node.axis < 0 ? node.axis + shape.rank() : node.axis;
+  return ApplyActivation(xla::ConcatInDim(builder, xs, axis), node.activation);
+}
+
+xla::StatusOr<xla::XlaOp> BuildNode(const NodeInfo& node,
+                                    const std::vector<xla::XlaOp>& inputs) {
+  switch (node.builtin_code) {
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinSub:
+    case kTfLiteBuiltinMul:
+    case kTfLiteBuiltinDiv: {
+      TF_ASSIGN_OR_RETURN(xla::XlaOp y,
+                          BuildBinary(node.builtin_code, inputs[0], inputs[1]));
+      return ApplyActivation(y, node.activation);
+    }
+    case kTfLiteBuiltinMaximum:
+    case kTfLiteBuiltinMinimum:
+      return BuildBinary(node.builtin_code, inputs[0], inputs[1]);
+    case kTfLiteBuiltinRelu:
+      return ApplyActivation(inputs[0], kTfLiteActRelu);
+    case kTfLiteBuiltinRelu6:
+      return ApplyActivation(inputs[0], kTfLiteActRelu6);
+    case kTfLiteBuiltinTanh:
+      return ApplyActivation(inputs[0], kTfLiteActTanh);
+    case kTfLiteBuiltinLogistic:
+      return ApplyActivation(inputs[0], kTfLiteActSigmoid);
+    case kTfLiteBuiltinSoftmax:
+      return BuildSoftmax(node, inputs[0]);
+    case kTfLiteBuiltinConcatenation:
+      return BuildConcatenation(node, inputs);
+    case kTfLiteBuiltinFullyConnected:
+      return BuildFullyConnected(node, inputs[0], inputs[1],
+                                 inputs.size() > 2 ? &inputs[2] : nullptr);
+    default:
+      return xla::Unimplemented("Unsupported builtin op %d",
+                                node.builtin_code);
+  }
+}
+
+}  // namespace
+
+bool IsNodeSupported(const TfLiteContext* context, const TfLiteNode* node,
+                     const TfLiteRegistration* registration) {
+  if (!HasOnlyFloatTensors(context, node)) return false;
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinSub:
+    case kTfLiteBuiltinMul:
+    case kTfLiteBuiltinDiv:
+    case kTfLiteBuiltinMaximum:
+    case kTfLiteBuiltinMinimum: {
+      if (node->inputs->size != 2) return false;
+      if (registration->builtin_code != kTfLiteBuiltinMaximum &&
+          registration->builtin_code != kTfLiteBuiltinMinimum) {
+        // All these params start with the fused activation.
+        const auto* params =
+            reinterpret_cast<const TfLiteAddParams*>(node->builtin_data);
+        if (!params || !IsSupportedActivation(params->activation)) {
+          return false;
+        }
+      }
+      return AreBroadcastable(context->tensors[node->inputs->data[0]],
+                              context->tensors[node->inputs->data[1]]);
+    }
+    case kTfLiteBuiltinRelu:
+    case kTfLiteBuiltinRelu6:
+    case kTfLiteBuiltinTanh:
+    case kTfLiteBuiltinLogistic:
+      return node->inputs->size == 1;
+    case kTfLiteBuiltinSoftmax:
+      return node->inputs->size == 1 &&
+             context->tensors[node->inputs->data[0]].dims->size >= 1;
+    case kTfLiteBuiltinConcatenation: {
+      const auto* params =
+          reinterpret_cast<const TfLiteConcatenationParams*>(
+              node->builtin_data);
+      return params && node->inputs->size >= 1 &&
+             IsSupportedActivation(params->activation);
+    }
+    case kTfLiteBuiltinFullyConnected: {
+      const auto* params =
+          reinterpret_cast<const TfLiteFullyConnectedParams*>(
+              node->builtin_data);
+      if (!params || !IsSupportedActivation(params->activation) ||
+          params->weights_format !=
+              kTfLiteFullyConnectedWeightsFormatDefault) {
+        return false;
+      }
+      if (node->inputs->size < 2 || node->outputs->size != 1) return false;
+      const TfLiteTensor& filter = context->tensors[node->inputs->data[1]];
+      return filter.dims->size == 2 && filter.sparsity == nullptr;
+    }
+    default:
+      return false;
+  }
+}
+
+NodeInfo GetNodeInfo(const TfLiteNode* node,
+                     const TfLiteRegistration* registration) {
+  NodeInfo info;
+  info.builtin_code = registration->builtin_code;
+  info.inputs.assign(node->inputs->data,
+                     node->inputs->data + node->inputs->size);
+  info.outputs.assign(node->outputs->data,
+                      node->outputs->data + node->outputs->size);
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinSub:
+    case kTfLiteBuiltinMul:
+    case kTfLiteBuiltinDiv:
+      info.activation =
+          reinterpret_cast<const TfLiteAddParams*>(node->builtin_data)
+              ->activation;
+      break;
+    case kTfLiteBuiltinSoftmax:
+      info.beta = reinterpret_cast<const TfLiteSoftmaxParams*>(
+                      node->builtin_data)
+                      ->beta;
+      break;
+    case kTfLiteBuiltinConcatenation: {
+      const auto* params = reinterpret_cast<const TfLiteConcatenationParams*>(
+          node->builtin_data);
+      info.activation = params->activation;
+      info.axis = params->axis;
+      break;
+    }
+    case kTfLiteBuiltinFullyConnected: {
+      const auto* params = reinterpret_cast<const TfLiteFullyConnectedParams*>(
+          node->builtin_data);
+      info.activation = params->activation;
+      info.keep_num_dims = params->keep_num_dims;
+      break;
+    }
+    default:
+      break;
+  }
+  // Drops a missing optional bias.
+  while (!info.inputs.empty() && info.inputs.back() == kTfLiteOptionalTensor) {
+    info.inputs.pop_back();
+  }
+  return info;
+}
+
+xla::Shape GetXlaShape(const TfLiteTensor& tensor) {
+  std::vector<xla::int64> dims(tensor.dims->data,
+                               tensor.dims->data + tensor.dims->size);
+  return xla::ShapeUtil::MakeShape(xla::F32, dims);
+}
+
+xla::StatusOr<xla::XlaComputation> BuildComputation(
+    const TfLiteContext* context, const std::vector<NodeInfo>& nodes,
+    const std::vector<int>& parameter_tensors,
+    const std::vector<int>& output_tensors) {
+  xla::XlaBuilder builder("tflite_partition");
+  std::unordered_map<int, xla::XlaOp> values;
+  for (int i = 0; i < parameter_tensors.size(); ++i) {
+    const int tensor_index = parameter_tensors[i];
+    values[tensor_index] =
+        xla::Parameter(&builder, i, GetXlaShape(context->tensors[tensor_index]),
+                       absl::StrCat("tensor_", tensor_index));
+  }
+
+  auto get_value = [&](int tensor_index) -> xla::StatusOr<xla::XlaOp> {
+    auto it = values.find(tensor_index);
+    if (it != values.end()) return it->second;
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    if (!IsConstantTensor(&tensor)) {
+      return xla::InvalidArgument("Tensor %d is not produced in the partition",
+                                  tensor_index);
+    }
+    xla::XlaOp constant = xla::ConstantLiteral(
+        &builder,
+        xla::BorrowingLiteral(tensor.data.raw_const, GetXlaShape(tensor)));
+    values[tensor_index] = constant;
+    return constant;
+  };
+
+  for (const NodeInfo& node : nodes) {
+    std::vector<xla::XlaOp> inputs;
+    for (int tensor_index : node.inputs) {
+      TF_ASSIGN_OR_RETURN(xla::XlaOp input, get_value(tensor_index));
+      inputs.push_back(input);
+    }
+    TF_ASSIGN_OR_RETURN(values[node.outputs[0]], BuildNode(node, inputs));
+  }
+
+  std::vector<xla::XlaOp> outputs;
+  for (int tensor_index : output_tensors) {
+    TF_ASSIGN_OR_RETURN(xla::XlaOp output, get_value(tensor_index));
+    outputs.push_back(output);
+  }
+  xla::Tuple(&builder, outputs);
+  return builder.Build();
+}
+
+}  // namespace xla_delegate
+}  // namespace tflite
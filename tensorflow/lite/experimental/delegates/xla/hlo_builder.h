@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_DELEGATES_XLA_HLO_BUILDER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_DELEGATES_XLA_HLO_BUILDER_H_
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace xla_delegate {
+
+// The parts of a TFLite node needed to translate it to HLO, captured when the
+// partition is delegated.
+struct NodeInfo {
+  int builtin_code = 0;
+  std::vector<int> inputs;
+  std::vector<int> outputs;
+  TfLiteFusedActivation activation = kTfLiteActNone;
+  // SOFTMAX.
+  float beta = 1.0f;
+  // FULLY_CONNECTED.
+  bool keep_num_dims = false;
+  // CONCATENATION.
+  int axis = 0;
+};
+
+// Returns true if 'node' can be translated to HLO by BuildComputation().
+// Only float32 tensors are supported.
+bool IsNodeSupported(const TfLiteContext* context, const TfLiteNode* node,
+                     const TfLiteRegistration* registration);
+
+// Captures the parts of 'node' needed by BuildComputation().
+NodeInfo GetNodeInfo(const TfLiteNode* node,
+                     const TfLiteRegistration* registration);
+
+// Returns the XLA shape of the float32 'tensor'.
+xla::Shape GetXlaShape(const TfLiteTensor& tensor);
+
+// Translates the nodes of a delegated partition to an XLA computation for the
+// current shapes of 'parameter_tensors'. The computation takes the values of
+// 'parameter_tensors' as parameters, in order, and returns a tuple of the
+// values of 'output_tensors'. Constant tensors read by the nodes are embedded
+// in the computation, so that XLA can fold and lay them out at compile time.
+xla::StatusOr<xla::XlaComputation> BuildComputation(
+    const TfLiteContext* context, const std::vector<NodeInfo>& nodes,
+    const std::vector<int>& parameter_tensors,
+    const std::vector<int>& output_tensors);
+
+}  // namespace xla_delegate
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_DELEGATES_XLA_HLO_BUILDER_H_
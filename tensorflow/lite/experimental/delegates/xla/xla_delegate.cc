@@ -0,0 +1,285 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/delegates/xla/xla_delegate.h"
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/client/executable_build_options.h"
+#include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/service/shaped_buffer.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/lite/delegates/utils/simple_delegate.h"
+#include "tensorflow/lite/experimental/delegates/xla/hlo_builder.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/stream_executor/device_memory.h"
+
+namespace tflite {
+namespace xla_delegate {
+namespace {
+
+// The alignment the XLA CPU backend assumes for buffers of 16 bytes or more,
+// see xla::cpu_function_runtime::kMinAlign. TFLite arenas align tensors to 64
+// bytes, but tensors with custom allocations may be less aligned.
+constexpr uintptr_t kXlaCpuBufferAlignment = 16;
+
+// Returns the process-wide XLA client for the host CPU, or nullptr if it can't
+// be created.
+xla::LocalClient* GetCpuClient(TfLiteContext* context) {
+  auto platform = xla::PlatformUtil::GetPlatform("cpu");
+  if (!platform.ok()) {
+    TF_LITE_KERNEL_LOG(context, "XLA CPU platform not available: %s",
+                       platform.status().ToString().c_str());
+    return nullptr;
+  }
+  auto client =
+      xla::ClientLibrary::GetOrCreateLocalClient(platform.ValueOrDie());
+  if (!client.ok()) {
+    TF_LITE_KERNEL_LOG(context, "Failed to create the XLA client: %s",
+                       client.status().ToString().c_str());
+    return nullptr;
+  }
+  return client.ValueOrDie();
+}
+
+// Compiles a delegated partition with XLA and runs it. The partition is
+// compiled lazily in Prepare for the current input shapes, and the
+// executables are cached so that switching between a few input shapes
+// doesn't recompile.
+class XlaDelegateKernel : public SimpleDelegateKernelInterface {
+ public:
+  explicit XlaDelegateKernel(const TfLiteXlaDelegateOptions& options)
+      : options_(options) {}
+
+  TfLiteStatus Init(TfLiteContext* context,
+                    const TfLiteDelegateParams* params) override {
+    client_ = GetCpuClient(context);
+    if (client_ == nullptr) return kTfLiteError;
+
+    for (int i = 0; i < params->nodes_to_replace->size; ++i) {
+      TfLiteNode* node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, params->nodes_to_replace->data[i], &node, &registration));
+      nodes_.push_back(GetNodeInfo(node, registration));
+    }
+    // Constant inputs are embedded in the computation rather than passed as
+    // parameters.
+    for (int i = 0; i < params->input_tensors->size; ++i) {
+      const int tensor_index = params->input_tensors->data[i];
+      if (!IsConstantTensor(&context->tensors[tensor_index])) {
+        parameter_tensors_.push_back(tensor_index);
+      }
+    }
+    output_tensors_.assign(
+        params->output_tensors->data,
+        params->output_tensors->data + params->output_tensors->size);
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) override {
+    std::vector<std::vector<int>> key;
+    for (int tensor_index : parameter_tensors_) {
+      const TfLiteIntArray* dims = context->tensors[tensor_index].dims;
+      key.emplace_back(dims->data, dims->data + dims->size);
+    }
+    auto it = executables_.find(key);
+    if (it == executables_.end()) {
+      CompiledPartition compiled;
+      TF_LITE_ENSURE_STATUS(Compile(context, &compiled));
+      if (executables_.size() >= options_.max_cached_executables &&
+          !insertion_order_.empty()) {
+        executables_.erase(insertion_order_.front());
+        insertion_order_.pop_front();
+      }
+      it = executables_.emplace(key, std::move(compiled)).first;
+      insertion_order_.push_back(key);
+    }
+    executable_ = it->second.executable.get();
+
+    // The outputs take the shapes inferred by XLA.
+    const xla::Shape& result_shape = it->second.result_shape;
+    for (int i = 0; i < output_tensors_.size(); ++i) {
+      const xla::Shape& shape = result_shape.tuple_shapes(i);
+      TfLiteIntArray* dims = TfLiteIntArrayCreate(shape.rank());
+      for (int d = 0; d < shape.rank(); ++d) {
+        dims->data[d] = shape.dimensions(d);
+      }
+      TF_LITE_ENSURE_STATUS(context->ResizeTensor(
+          context, &context->tensors[output_tensors_[i]], dims));
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) override {
+    // Device memory is host memory on the CPU, so the arguments are buffers
+    // aliasing the input tensors. Only inputs that are not aligned as XLA
+    // expects are copied.
+    std::vector<xla::ShapedBuffer> aliased_arguments;
+    std::vector<xla::ScopedShapedBuffer> copied_arguments;
+    aliased_arguments.reserve(parameter_tensors_.size());
+    copied_arguments.reserve(parameter_tensors_.size());
+    std::vector<const xla::ShapedBuffer*> argument_ptrs;
+    for (int tensor_index : parameter_tensors_) {
+      const TfLiteTensor& tensor = context->tensors[tensor_index];
+      const xla::Shape shape = GetXlaShape(tensor);
+      if (reinterpret_cast<uintptr_t>(tensor.data.raw_const) %
+              kXlaCpuBufferAlignment ==
+          0) {
+        aliased_arguments.emplace_back(shape, shape, client_->platform(),
+                                       /*device_ordinal=*/0);
+        aliased_arguments.back().set_buffer(
+            stream_executor::DeviceMemoryBase(tensor.data.raw, tensor.bytes),
+            /*index=*/{});
+        argument_ptrs.push_back(&aliased_arguments.back());
+      } else {
+        auto buffer = client_->LiteralToShapedBuffer(
+            xla::BorrowingLiteral(tensor.data.raw_const, shape),
+            /*device_ordinal=*/0);
+        if (!buffer.ok()) return ReportError(context, buffer.status());
+        copied_arguments.push_back(std::move(buffer).ValueOrDie());
+        argument_ptrs.push_back(&copied_arguments.back());
+      }
+    }
+
+    auto result = executable_->Run(argument_ptrs, xla::ExecutableRunOptions());
+    if (!result.ok()) return ReportError(context, result.status());
+
+    // XLA allocates the result buffers itself, so they are copied into the
+    // output tensors, directly rather than through a literal.
+    for (int i = 0; i < output_tensors_.size(); ++i) {
+      TfLiteTensor& tensor = context->tensors[output_tensors_[i]];
+      const stream_executor::DeviceMemoryBase& buffer =
+          result.ValueOrDie().buffer({i});
+      TF_LITE_ENSURE_EQ(context, buffer.size(), tensor.bytes);
+      std::memcpy(tensor.data.raw, buffer.opaque(), tensor.bytes);
+    }
+    return kTfLiteOk;
+  }
+
+ private:
+  struct CompiledPartition {
+    std::unique_ptr<xla::LocalExecutable> executable;
+    // The tuple of the output shapes.
+    xla::Shape result_shape;
+  };
+
+  TfLiteStatus Compile(TfLiteContext* context, CompiledPartition* compiled) {
+    auto computation = BuildComputation(context, nodes_, parameter_tensors_,
+                                        output_tensors_);
+    if (!computation.ok()) return ReportError(context, computation.status());
+    auto program_shape = computation.ValueOrDie().GetProgramShape();
+    if (!program_shape.ok()) {
+      return ReportError(context, program_shape.status());
+    }
+    compiled->result_shape = program_shape.ValueOrDie().result();
+
+    std::vector<xla::Shape> shapes;
+    for (int tensor_index : parameter_tensors_) {
+      shapes.push_back(GetXlaShape(context->tensors[tensor_index]));
+    }
+    std::vector<const xla::Shape*> shape_ptrs;
+    for (const auto& shape : shapes) shape_ptrs.push_back(&shape);
+
+    auto executables = client_->Compile(computation.ValueOrDie(), shape_ptrs,
+                                        xla::ExecutableBuildOptions());
+    if (!executables.ok()) return ReportError(context, executables.status());
+    compiled->executable = std::move(executables.ValueOrDie().front());
+    return kTfLiteOk;
+  }
+
+  static TfLiteStatus ReportError(TfLiteContext* context,
+                                  const xla::Status& status) {
+    TF_LITE_KERNEL_LOG(context, "XLA delegate: %s", status.ToString().c_str());
+    return kTfLiteError;
+  }
+
+  const TfLiteXlaDelegateOptions options_;
+  xla::LocalClient* client_ = nullptr;
+  std::vector<NodeInfo> nodes_;
+  std::vector<int> parameter_tensors_;
+  std::vector<int> output_tensors_;
+
+  // Compiled executables keyed by the shapes of 'parameter_tensors_', and
+  // their keys in insertion order for eviction.
+  std::map<std::vector<std::vector<int>>, CompiledPartition> executables_;
+  std::deque<std::vector<std::vector<int>>> insertion_order_;
+  // The executable for the current input shapes, set in Prepare.
+  xla::LocalExecutable* executable_ = nullptr;
+};
+
+class XlaDelegate : public SimpleDelegateInterface {
+ public:
+  explicit XlaDelegate(const TfLiteXlaDelegateOptions& options)
+      : options_(options) {}
+
+  bool IsNodeSupportedByDelegate(const TfLiteRegistration* registration,
+                                 const TfLiteNode* node,
+                                 TfLiteContext* context) const override {
+    return IsNodeSupported(context, node, registration);
+  }
+
+  TfLiteStatus Initialize(TfLiteContext* context) override {
+    return GetCpuClient(context) != nullptr ? kTfLiteOk : kTfLiteError;
+  }
+
+  const char* Name() const override {
+    static constexpr char kName[] = "XlaDelegate";
+    return kName;
+  }
+
+  std::unique_ptr<SimpleDelegateKernelInterface> CreateDelegateKernelInterface()
+      override {
+    return std::make_unique<XlaDelegateKernel>(options_);
+  }
+
+  SimpleDelegateInterface::Options DelegateOptions() const override {
+    return SimpleDelegateInterface::Options();
+  }
+
+ private:
+  const TfLiteXlaDelegateOptions options_;
+};
+
+}  // namespace
+}  // namespace xla_delegate
+}  // namespace tflite
+
+TfLiteXlaDelegateOptions TfLiteXlaDelegateOptionsDefault() {
+  TfLiteXlaDelegateOptions options = {0};
+  options.max_cached_executables = 8;
+  return options;
+}
+
+TfLiteDelegate* TfLiteXlaDelegateCreate(
+    const TfLiteXlaDelegateOptions* options) {
+  std::unique_ptr<tflite::xla_delegate::XlaDelegate> xla_delegate(
+      new tflite::xla_delegate::XlaDelegate(
+          options ? *options : TfLiteXlaDelegateOptionsDefault()));
+  return tflite::TfLiteDelegateFactory::CreateSimpleDelegate(
+      std::move(xla_delegate));
+}
+
+void TfLiteXlaDelegateDelete(TfLiteDelegate* delegate) {
+  tflite::TfLiteDelegateFactory::DeleteSimpleDelegate(delegate);
+}
@@ -0,0 +1,56 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_DELEGATES_XLA_XLA_DELEGATE_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_DELEGATES_XLA_XLA_DELEGATE_H_
+
+#include <memory>
+
+#include "tensorflow/lite/c/common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct {
+  // The maximum number of compiled executables kept per delegated partition.
+  // A partition is compiled once for each distinct set of input shapes; when
+  // the limit is reached the oldest executable is evicted.
+  int max_cached_executables;
+} TfLiteXlaDelegateOptions;
+
+// Returns a structure with the default delegate options.
+TfLiteXlaDelegateOptions TfLiteXlaDelegateOptionsDefault();
+
+// Creates a new delegate instance that needs to be destroyed with
+// `TfLiteXlaDelegateDelete` when delegate is no longer used by TFLite.
+// When `options` is set to `nullptr`, the default values are used.
+TfLiteDelegate* TfLiteXlaDelegateCreate(
+    const TfLiteXlaDelegateOptions* options);
+
+// Destroys a delegate created with `TfLiteXlaDelegateCreate` call.
+void TfLiteXlaDelegateDelete(TfLiteDelegate* delegate);
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+// A convenient wrapper that returns C++ std::unique_ptr for automatic memory
+// management.
+inline std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)>
+TfLiteXlaDelegateCreateUnique(const TfLiteXlaDelegateOptions* options) {
+  return std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)>(
+      TfLiteXlaDelegateCreate(options), TfLiteXlaDelegateDelete);
+}
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_DELEGATES_XLA_XLA_DELEGATE_H_
@@ -0,0 +1,179 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/delegates/xla/xla_delegate.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+class XlaDelegateTest : public ::testing::Test {
+ protected:
+  XlaDelegateTest() : delegate_(TfLiteXlaDelegateCreateUnique(nullptr)) {}
+
+  std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)> delegate_;
+};
+
+class AddOpModel : public SingleOpModel {
+ public:
+  AddOpModel(TfLiteDelegate* delegate, const TensorData& input1,
+             const TensorData& input2, ActivationFunctionType activation) {
+    input1_ = AddInput(input1);
+    input2_ = AddInput(input2);
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_ADD, BuiltinOptions_AddOptions,
+                 CreateAddOptions(builder_, activation).Union());
+    SetDelegate(delegate);
+    BuildInterpreter({GetShape(input1_), GetShape(input2_)});
+  }
+
+  // Resizes the inputs and re-applies the shapes to the delegated partition.
+  void Resize(const std::vector<int>& input1_shape,
+              const std::vector<int>& input2_shape) {
+    ASSERT_EQ(interpreter_->ResizeInputTensor(input1_, input1_shape),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter_->ResizeInputTensor(input2_, input2_shape),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  }
+
+  int input1() { return input1_; }
+  int input2() { return input2_; }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int input1_;
+  int input2_;
+  int output_;
+};
+
+class FullyConnectedOpModel : public SingleOpModel {
+ public:
+  FullyConnectedOpModel(TfLiteDelegate* delegate,
+                        std::initializer_list<float> weights,
+                        std::initializer_list<float> bias, int units,
+                        int input_size, ActivationFunctionType activation) {
+    input_ = AddInput({TensorType_FLOAT32, {2, input_size}});
+    AddConstInput<float>({TensorType_FLOAT32, {units, input_size}}, weights);
+    AddConstInput<float>({TensorType_FLOAT32, {units}}, bias);
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_FULLY_CONNECTED,
+                 BuiltinOptions_FullyConnectedOptions,
+                 CreateFullyConnectedOptions(builder_, activation).Union());
+    SetDelegate(delegate);
+    BuildInterpreter({GetShape(input_)});
+  }
+
+  int input() { return input_; }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int input_;
+  int output_;
+};
+
+class SoftmaxOpModel : public SingleOpModel {
+ public:
+  SoftmaxOpModel(TfLiteDelegate* delegate, const std::vector<int>& shape,
+                 float beta) {
+    input_ = AddInput({TensorType_FLOAT32, shape});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_SOFTMAX, BuiltinOptions_SoftmaxOptions,
+                 CreateSoftmaxOptions(builder_, beta).Union());
+    SetDelegate(delegate);
+    BuildInterpreter({GetShape(input_)});
+  }
+
+  int input() { return input_; }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int output_;
+};
+
+TEST_F(XlaDelegateTest, AddWithActivation) {
+  AddOpModel m(delegate_.get(), {TensorType_FLOAT32, {1, 2, 2}},
+               {TensorType_FLOAT32, {1, 2, 2}}, ActivationFunctionType_RELU6);
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 8.0});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(1, 2, 2));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({0, 0.4, 1, 6})));
+}
+
+TEST_F(XlaDelegateTest, AddBroadcastsLowerRankInput) {
+  AddOpModel m(delegate_.get(), {TensorType_FLOAT32, {2, 3}},
+               {TensorType_FLOAT32, {3}}, ActivationFunctionType_NONE);
+  m.PopulateTensor<float>(m.input1(), {1, 2, 3, 4, 5, 6});
+  m.PopulateTensor<float>(m.input2(), {10, 20, 30});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({11, 22, 33, 14, 25, 36})));
+}
+
+TEST_F(XlaDelegateTest, AddRecompilesForNewInputShapes) {
+  AddOpModel m(delegate_.get(), {TensorType_FLOAT32, {2}},
+               {TensorType_FLOAT32, {2}}, ActivationFunctionType_NONE);
+  m.PopulateTensor<float>(m.input1(), {1, 2});
+  m.PopulateTensor<float>(m.input2(), {3, 4});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({4, 6})));
+
+  m.Resize({3}, {3});
+  m.PopulateTensor<float>(m.input1(), {1, 2, 3});
+  m.PopulateTensor<float>(m.input2(), {4, 5, 6});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(3));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({5, 7, 9})));
+
+  // Switching back to the first shape uses the cached executable.
+  m.Resize({2}, {2});
+  m.PopulateTensor<float>(m.input1(), {1, 1});
+  m.PopulateTensor<float>(m.input2(), {2, 2});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({3, 3})));
+}
+
+TEST_F(XlaDelegateTest, FullyConnected) {
+  FullyConnectedOpModel m(delegate_.get(),
+                          /*weights=*/{1, 2, 3, -1, -2, -3},
+                          /*bias=*/{1, 2}, /*units=*/2, /*input_size=*/3,
+                          ActivationFunctionType_RELU);
+  m.PopulateTensor<float>(m.input(), {1, 1, 1, 1, 2, 3});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 2));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({7, 0, 15, 0})));
+}
+
+TEST_F(XlaDelegateTest, Softmax) {
+  SoftmaxOpModel m(delegate_.get(), {2, 2}, /*beta=*/1.0f);
+  m.PopulateTensor<float>(m.input(), {0, 0, 1, 3});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear(
+                                 {0.5, 0.5, 0.1192029, 0.8807971})));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -31,6 +31,9 @@ class ResourceBase {
 
   // Returns true if it is initialized.
   virtual bool IsInitialized() = 0;
+
+  // Returns true if it is a ResourceVariable.
+  virtual bool IsVariable() const { return false; }
 };
 
 /// WARNING: Experimental interface, subject to change.
@@ -88,7 +88,7 @@ void CreateResourceVariableIfNotAvailable(ResourceMap* resources,
 
 ResourceVariable* GetResourceVariable(ResourceMap* resources, int resource_id) {
   auto it = resources->find(resource_id);
-  if (it != resources->end()) {
+  if (it != resources->end() && it->second->IsVariable()) {
     return static_cast<ResourceVariable*>(it->second.get());
   }
   return nullptr;
@@ -49,6 +49,8 @@ class ResourceVariable : public ResourceBase {
   // Returns true if this resource variable is initialized.
   bool IsInitialized() override { return is_initialized_; }
 
+  bool IsVariable() const override { return true; }
+
  private:
   // The tensor (and its buffer stored in `tensor_.data` is fully owned by
   // the `ResourceVariable` object.
@@ -59,6 +59,12 @@ class GraphInfo {
 
   // Returns the indices of the variable tensors.
   virtual const std::vector<int>& variables() const = 0;
+
+  // Returns the largest execution plan index of a node that may run
+  // concurrently with the node at execution plan index `index`. All nodes
+  // after it depend on that node. Nodes that run in execution plan order
+  // return `index`.
+  virtual size_t last_concurrent_node(size_t index) const { return index; }
 };
 
 // Represents a subset of nodes in a TensorFlow Lite graph.
@@ -0,0 +1,525 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/graph_rewriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/context_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+int64_t NumElements(const TfLiteTensor* tensor) {
+  int64_t count = 1;
+  for (int dim : TfLiteIntArrayView(tensor->dims)) count *= dim;
+  return count;
+}
+
+bool IsConstant(const TfLiteTensor* tensor) {
+  return tensor->allocation_type == kTfLiteMmapRo && tensor->data.raw;
+}
+
+// Returns whether the values of `a` and `b` have the same type and, for
+// quantized types, the same per-tensor quantization parameters.
+bool HaveSameTypeAndQuantization(const TfLiteTensor* a, const TfLiteTensor* b) {
+  auto is_per_tensor = [](const TfLiteTensor* tensor) {
+    if (tensor->quantization.type != kTfLiteAffineQuantization) return true;
+    const auto* params = static_cast<const TfLiteAffineQuantization*>(
+        tensor->quantization.params);
+    return params == nullptr || params->scale == nullptr ||
+           params->scale->size <= 1;
+  };
+  return a->type == b->type && a->params.scale == b->params.scale &&
+         a->params.zero_point == b->params.zero_point && is_per_tensor(a) &&
+         is_per_tensor(b);
+}
+
+// Tracks the producer and number of consumers of every tensor while the
+// execution plan of a subgraph is rewritten.
+class Graph {
+ public:
+  explicit Graph(Subgraph* subgraph)
+      : subgraph_(subgraph),
+        plan_(subgraph->execution_plan()),
+        producers_(subgraph->tensors_size(), -1),
+        num_consumers_(subgraph->tensors_size(), 0),
+        pinned_(subgraph->tensors_size(), false),
+        removed_(subgraph->nodes_size(), false) {
+    for (int tensor_index : subgraph->outputs()) {
+      if (tensor_index >= 0) pinned_[tensor_index] = true;
+    }
+    for (int tensor_index : subgraph->variables()) {
+      pinned_[tensor_index] = true;
+    }
+    for (int node_index : plan_) {
+      const TfLiteNode& node = this->node(node_index);
+      for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+        if (tensor_index >= 0) ++num_consumers_[tensor_index];
+      }
+      for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+        if (tensor_index >= 0) producers_[tensor_index] = node_index;
+      }
+    }
+  }
+
+  const std::vector<int>& plan() const { return plan_; }
+
+  TfLiteNode& node(int node_index) {
+    return subgraph_->nodes_and_registration()[node_index].first;
+  }
+
+  bool IsOp(int node_index, BuiltinOperator op) const {
+    return subgraph_->node_and_registration(node_index)->second.builtin_code ==
+           op;
+  }
+
+  TfLiteTensor* tensor(int tensor_index) {
+    return subgraph_->tensor(tensor_index);
+  }
+
+  bool IsRemoved(int node_index) const { return removed_[node_index]; }
+
+  // Returns the node producing `tensor_index` if it is the only output of
+  // that node and is used once, by the node being rewritten. Returns -1
+  // otherwise.
+  int GetSoleProducer(int tensor_index) {
+    if (tensor_index < 0 || pinned_[tensor_index] ||
+        num_consumers_[tensor_index] != 1) {
+      return -1;
+    }
+    const int producer = producers_[tensor_index];
+    if (producer < 0 || node(producer).outputs->size != 1) return -1;
+    return producer;
+  }
+
+  bool IsPinned(int tensor_index) const { return pinned_[tensor_index]; }
+
+  void SetInput(int node_index, int input, int tensor_index) {
+    TfLiteNode& node = this->node(node_index);
+    if (input >= node.inputs->size) {
+      TfLiteIntArray* inputs = TfLiteIntArrayCreate(input + 1);
+      std::fill(inputs->data, inputs->data + inputs->size, -1);
+      std::copy(node.inputs->data, node.inputs->data + node.inputs->size,
+                inputs->data);
+      TfLiteIntArrayFree(node.inputs);
+      node.inputs = inputs;
+    }
+    if (node.inputs->data[input] >= 0) {
+      --num_consumers_[node.inputs->data[input]];
+    }
+    node.inputs->data[input] = tensor_index;
+    if (tensor_index >= 0) ++num_consumers_[tensor_index];
+  }
+
+  void SetOutput(int node_index, int output, int tensor_index) {
+    TfLiteNode& node = this->node(node_index);
+    producers_[node.outputs->data[output]] = -1;
+    node.outputs->data[output] = tensor_index;
+    producers_[tensor_index] = node_index;
+  }
+
+  // Makes the nodes of the plan use `new_tensor` instead of `old_tensor`.
+  void ReplaceUses(int old_tensor, int new_tensor) {
+    for (int node_index : plan_) {
+      const TfLiteIntArray* inputs = node(node_index).inputs;
+      for (int i = 0; i < inputs->size; ++i) {
+        if (inputs->data[i] == old_tensor) SetInput(node_index, i, new_tensor);
+      }
+    }
+  }
+
+  void RemoveNode(int node_index) {
+    const TfLiteNode& node = this->node(node_index);
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index >= 0) --num_consumers_[tensor_index];
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index >= 0) producers_[tensor_index] = -1;
+    }
+    plan_.erase(std::find(plan_.begin(), plan_.end(), node_index));
+    removed_[node_index] = true;
+  }
+
+  // Adds a float constant backed by a buffer owned by the subgraph. Returns
+  // its index and its data in `data`, or -1.
+  int AddFloatConstant(const char* name, const std::vector<int>& dims,
+                       float** data) {
+    size_t bytes = sizeof(float);
+    for (int dim : dims) bytes *= dim;
+    int tensor_index;
+    if (subgraph_->AddTensors(1, &tensor_index) != kTfLiteOk) return -1;
+    char* buffer = subgraph_->AllocateOwnedBuffer(bytes);
+    if (subgraph_->SetTensorParametersReadOnly(
+            tensor_index, kTfLiteFloat32, name, dims, TfLiteQuantization(),
+            buffer, bytes) != kTfLiteOk) {
+      return -1;
+    }
+    producers_.push_back(-1);
+    num_consumers_.push_back(0);
+    pinned_.push_back(false);
+    *data = reinterpret_cast<float*>(buffer);
+    return tensor_index;
+  }
+
+ private:
+  Subgraph* const subgraph_;
+  std::vector<int> plan_;
+  std::vector<int> producers_;
+  std::vector<int> num_consumers_;
+  // Whether tensors are outputs or variables of the subgraph, and thus used
+  // outside of the execution plan.
+  std::vector<bool> pinned_;
+  std::vector<bool> removed_;
+};
+
+// Returns the fused activation function of an op that has one, or null.
+TfLiteFusedActivation* GetFusedActivation(Graph* graph, int node_index) {
+  void* params = graph->node(node_index).builtin_data;
+  if (params == nullptr) return nullptr;
+  if (graph->IsOp(node_index, BuiltinOperator_CONV_2D)) {
+    return &static_cast<TfLiteConvParams*>(params)->activation;
+  }
+  if (graph->IsOp(node_index, BuiltinOperator_DEPTHWISE_CONV_2D)) {
+    return &static_cast<TfLiteDepthwiseConvParams*>(params)->activation;
+  }
+  if (graph->IsOp(node_index, BuiltinOperator_FULLY_CONNECTED)) {
+    return &static_cast<TfLiteFullyConnectedParams*>(params)->activation;
+  }
+  if (graph->IsOp(node_index, BuiltinOperator_ADD)) {
+    return &static_cast<TfLiteAddParams*>(params)->activation;
+  }
+  if (graph->IsOp(node_index, BuiltinOperator_SUB)) {
+    return &static_cast<TfLiteSubParams*>(params)->activation;
+  }
+  if (graph->IsOp(node_index, BuiltinOperator_MUL)) {
+    return &static_cast<TfLiteMulParams*>(params)->activation;
+  }
+  return nullptr;
+}
+
+// A rewrite of the pattern ending at a node of the execution plan. Returns
+// true if the graph was changed.
+using Rewrite = bool (*)(Graph* graph, int node_index);
+
+// RESHAPE(RESHAPE(x)) -> RESHAPE(x). The shape of a RESHAPE does not depend
+// on the shape of its input.
+bool RemoveReshapeOfReshape(Graph* graph, int node_index) {
+  if (!graph->IsOp(node_index, BuiltinOperator_RESHAPE)) return false;
+  const int producer =
+      graph->GetSoleProducer(graph->node(node_index).inputs->data[0]);
+  if (producer < 0 || !graph->IsOp(producer, BuiltinOperator_RESHAPE)) {
+    return false;
+  }
+  graph->SetInput(node_index, 0, graph->node(producer).inputs->data[0]);
+  graph->RemoveNode(producer);
+  return true;
+}
+
+// QUANTIZE(DEQUANTIZE(x)) -> x when quantizing back to the parameters of x,
+// which is exact.
+bool RemoveDequantizeQuantize(Graph* graph, int node_index) {
+  if (!graph->IsOp(node_index, BuiltinOperator_QUANTIZE)) return false;
+  const TfLiteNode& node = graph->node(node_index);
+  const int producer = graph->GetSoleProducer(node.inputs->data[0]);
+  if (producer < 0 || !graph->IsOp(producer, BuiltinOperator_DEQUANTIZE)) {
+    return false;
+  }
+  const int input = graph->node(producer).inputs->data[0];
+  const int output = node.outputs->data[0];
+  const TfLiteType type = graph->tensor(input)->type;
+  if (graph->IsPinned(output) ||
+      (type != kTfLiteUInt8 && type != kTfLiteInt8 && type != kTfLiteInt16) ||
+      !HaveSameTypeAndQuantization(graph->tensor(input),
+                                   graph->tensor(output))) {
+    return false;
+  }
+  graph->RemoveNode(node_index);
+  graph->RemoveNode(producer);
+  graph->ReplaceUses(output, input);
+  return true;
+}
+
+// Returns whether `before` and `after` are the padding SAME adds to a
+// dimension of size `input_size`.
+bool IsSamePadding(int input_size, int filter_size, int stride, int dilation,
+                   int64_t before, int64_t after) {
+  const int effective_filter_size = (filter_size - 1) * dilation + 1;
+  const int output_size = (input_size + stride - 1) / stride;
+  const int total_padding = std::max(
+      (output_size - 1) * stride + effective_filter_size - input_size, 0);
+  return before == total_padding / 2 &&
+         after == total_padding - total_padding / 2;
+}
+
+// CONV(PAD(x), padding=VALID) -> CONV(x, padding=SAME) when the PAD adds the
+// zeros SAME would.
+bool FoldPadIntoConvolution(Graph* graph, int node_index) {
+  const bool is_conv = graph->IsOp(node_index, BuiltinOperator_CONV_2D);
+  if (!is_conv &&
+      !graph->IsOp(node_index, BuiltinOperator_DEPTHWISE_CONV_2D)) {
+    return false;
+  }
+  TfLiteNode& node = graph->node(node_index);
+  if (node.builtin_data == nullptr) return false;
+  TfLitePadding* padding;
+  int stride_height, stride_width, dilation_height, dilation_width;
+  if (is_conv) {
+    auto* params = static_cast<TfLiteConvParams*>(node.builtin_data);
+    padding = &params->padding;
+    stride_height = params->stride_height;
+    stride_width = params->stride_width;
+    dilation_height = params->dilation_height_factor;
+    dilation_width = params->dilation_width_factor;
+  } else {
+    auto* params = static_cast<TfLiteDepthwiseConvParams*>(node.builtin_data);
+    padding = &params->padding;
+    stride_height = params->stride_height;
+    stride_width = params->stride_width;
+    dilation_height = params->dilation_height_factor;
+    dilation_width = params->dilation_width_factor;
+  }
+  if (*padding != kTfLitePaddingValid || stride_height < 1 ||
+      stride_width < 1) {
+    return false;
+  }
+
+  const int producer = graph->GetSoleProducer(node.inputs->data[0]);
+  if (producer < 0 || !graph->IsOp(producer, BuiltinOperator_PAD) ||
+      graph->node(producer).inputs->size != 2) {
+    return false;
+  }
+  const int input = graph->node(producer).inputs->data[0];
+  const TfLiteTensor* input_tensor = graph->tensor(input);
+  const TfLiteTensor* paddings =
+      graph->tensor(graph->node(producer).inputs->data[1]);
+  const TfLiteTensor* filter = graph->tensor(node.inputs->data[1]);
+  if (!HaveSameTypeAndQuantization(input_tensor,
+                                   graph->tensor(node.inputs->data[0])) ||
+      input_tensor->dims->size != 4 || filter->dims->size != 4 ||
+      !IsConstant(paddings) || NumElements(paddings) != 8 ||
+      (paddings->type != kTfLiteInt32 && paddings->type != kTfLiteInt64)) {
+    return false;
+  }
+  // The input sizes must be known when the graph is loaded.
+  const TfLiteIntArray* signature = input_tensor->dims_signature;
+  if (signature != nullptr && signature->size == 4 &&
+      (signature->data[1] < 0 || signature->data[2] < 0)) {
+    return false;
+  }
+  int64_t pads[8];
+  for (int i = 0; i < 8; ++i) {
+    pads[i] = paddings->type == kTfLiteInt32 ? paddings->data.i32[i]
+                                             : paddings->data.i64[i];
+  }
+  if (pads[0] != 0 || pads[1] != 0 || pads[6] != 0 || pads[7] != 0 ||
+      !IsSamePadding(input_tensor->dims->data[1], filter->dims->data[1],
+                     stride_height, dilation_height, pads[2], pads[3]) ||
+      !IsSamePadding(input_tensor->dims->data[2], filter->dims->data[2],
+                     stride_width, dilation_width, pads[4], pads[5])) {
+    return false;
+  }
+  *padding = kTfLitePaddingSame;
+  graph->SetInput(node_index, 0, input);
+  graph->RemoveNode(producer);
+  return true;
+}
+
+// MUL(CONV(x, w, b), m) -> CONV(x, w * m, b * m) and
+// ADD(CONV(x, w, b), a) -> CONV(x, w, b + a), for float convolutions and
+// fully-connected ops without activation, and per-channel or scalar m and a.
+bool FoldMulOrAddIntoConvolution(Graph* graph, int node_index) {
+  const bool is_mul = graph->IsOp(node_index, BuiltinOperator_MUL);
+  if (!is_mul && !graph->IsOp(node_index, BuiltinOperator_ADD)) return false;
+  const TfLiteNode& node = graph->node(node_index);
+  if (node.inputs->size != 2 || node.builtin_data == nullptr) return false;
+  const int constant_input =
+      IsConstant(graph->tensor(node.inputs->data[1])) ? 1 : 0;
+  const TfLiteTensor* constant =
+      graph->tensor(node.inputs->data[constant_input]);
+  const int intermediate = node.inputs->data[1 - constant_input];
+  const int producer = graph->GetSoleProducer(intermediate);
+  if (!IsConstant(constant) || constant->type != kTfLiteFloat32 ||
+      constant->sparsity != nullptr || producer < 0) {
+    return false;
+  }
+
+  // The axis of the output channels in the weights.
+  int channel_axis;
+  if (graph->IsOp(producer, BuiltinOperator_CONV_2D)) {
+    channel_axis = 0;
+  } else if (graph->IsOp(producer, BuiltinOperator_DEPTHWISE_CONV_2D)) {
+    channel_axis = 3;
+  } else if (graph->IsOp(producer, BuiltinOperator_FULLY_CONNECTED)) {
+    auto* params = static_cast<TfLiteFullyConnectedParams*>(
+        graph->node(producer).builtin_data);
+    if (params == nullptr ||
+        params->weights_format != kTfLiteFullyConnectedWeightsFormatDefault) {
+      return false;
+    }
+    channel_axis = 0;
+  } else {
+    return false;
+  }
+  TfLiteFusedActivation* activation = GetFusedActivation(graph, producer);
+  const TfLiteNode& producer_node = graph->node(producer);
+  const int filter = producer_node.inputs->data[1];
+  const int bias =
+      producer_node.inputs->size > 2 ? producer_node.inputs->data[2] : -1;
+  const TfLiteTensor* filter_tensor = graph->tensor(filter);
+  const TfLiteTensor* bias_tensor = bias >= 0 ? graph->tensor(bias) : nullptr;
+  const TfLiteTensor* intermediate_tensor = graph->tensor(intermediate);
+  // Sparse weights only hold their non-zero values, so they cannot be
+  // rescaled element by element.
+  if (activation == nullptr || *activation != kTfLiteActNone ||
+      intermediate_tensor->type != kTfLiteFloat32 ||
+      filter_tensor->type != kTfLiteFloat32 || !IsConstant(filter_tensor) ||
+      filter_tensor->sparsity != nullptr ||
+      channel_axis >= filter_tensor->dims->size ||
+      (bias_tensor != nullptr &&
+       (bias_tensor->type != kTfLiteFloat32 || !IsConstant(bias_tensor) ||
+        bias_tensor->sparsity != nullptr))) {
+    return false;
+  }
+  const int num_channels = filter_tensor->dims->data[channel_axis];
+  if (num_channels < 1 ||
+      (bias_tensor != nullptr && NumElements(bias_tensor) != num_channels)) {
+    return false;
+  }
+
+  // The constant must have one value per output channel, along the last
+  // axis, or a single value, so that the output shape does not change.
+  const int64_t num_constants = NumElements(constant);
+  if ((num_constants != 1 && num_constants != num_channels) ||
+      constant->dims->size > intermediate_tensor->dims->size ||
+      (constant->dims->size > 0 &&
+       constant->dims->data[constant->dims->size - 1] != num_constants)) {
+    return false;
+  }
+  const float* values = constant->data.f;
+  auto value = [values, num_constants](int channel) {
+    return values[num_constants == 1 ? 0 : channel];
+  };
+
+  // Compute the new weights and bias before adding tensors, which may move
+  // the existing ones.
+  std::vector<float> new_filter;
+  if (is_mul) {
+    const int64_t num_weights = NumElements(filter_tensor);
+    const int64_t inner_size = num_weights / num_channels;
+    new_filter.resize(num_weights);
+    for (int64_t i = 0; i < num_weights; ++i) {
+      const int channel = channel_axis == 0 ? i / inner_size : i % num_channels;
+      new_filter[i] = filter_tensor->data.f[i] * value(channel);
+    }
+  }
+  std::vector<float> new_bias;
+  if (bias_tensor != nullptr || !is_mul) {
+    new_bias.resize(num_channels);
+    for (int c = 0; c < num_channels; ++c) {
+      const float b = bias_tensor != nullptr ? bias_tensor->data.f[c] : 0.0f;
+      new_bias[c] = is_mul ? b * value(c) : b + value(c);
+    }
+  }
+
+  // The names of the new tensors are those of the ones they replace.
+  const char* filter_name = filter_tensor->name;
+  const std::vector<int> filter_dims(
+      filter_tensor->dims->data,
+      filter_tensor->dims->data + filter_tensor->dims->size);
+  const char* bias_name =
+      bias_tensor != nullptr ? bias_tensor->name : filter_tensor->name;
+  float* data;
+  int new_filter_index = filter;
+  if (is_mul) {
+    new_filter_index = graph->AddFloatConstant(filter_name, filter_dims, &data);
+    if (new_filter_index < 0) return false;
+    std::copy(new_filter.begin(), new_filter.end(), data);
+  }
+  int new_bias_index = bias;
+  if (!new_bias.empty()) {
+    new_bias_index = graph->AddFloatConstant(bias_name, {num_channels}, &data);
+    if (new_bias_index < 0) return false;
+    std::copy(new_bias.begin(), new_bias.end(), data);
+  }
+
+  graph->SetInput(producer, 1, new_filter_index);
+  if (new_bias_index >= 0) graph->SetInput(producer, 2, new_bias_index);
+
+  *activation = *GetFusedActivation(graph, node_index);
+  const int output = node.outputs->data[0];
+  graph->RemoveNode(node_index);
+  graph->SetOutput(producer, 0, output);
+  return true;
+}
+
+// RELU(OP(x)) -> OP(x, activation=RELU), and likewise for RELU6 and
+// RELU_N1_TO_1, on float tensors.
+bool FuseActivation(Graph* graph, int node_index) {
+  TfLiteFusedActivation fused_activation;
+  if (graph->IsOp(node_index, BuiltinOperator_RELU)) {
+    fused_activation = kTfLiteActRelu;
+  } else if (graph->IsOp(node_index, BuiltinOperator_RELU6)) {
+    fused_activation = kTfLiteActRelu6;
+  } else if (graph->IsOp(node_index, BuiltinOperator_RELU_N1_TO_1)) {
+    fused_activation = kTfLiteActReluN1To1;
+  } else {
+    return false;
+  }
+  const TfLiteNode& node = graph->node(node_index);
+  const int input = node.inputs->data[0];
+  const int output = node.outputs->data[0];
+  const int producer = graph->GetSoleProducer(input);
+  if (producer < 0 || graph->tensor(input)->type != kTfLiteFloat32 ||
+      graph->tensor(output)->type != kTfLiteFloat32) {
+    return false;
+  }
+  TfLiteFusedActivation* activation = GetFusedActivation(graph, producer);
+  if (activation == nullptr || *activation != kTfLiteActNone) return false;
+  *activation = fused_activation;
+  graph->RemoveNode(node_index);
+  graph->SetOutput(producer, 0, output);
+  return true;
+}
+
+// The rewrites, tried in this order on every node.
+const Rewrite kRewrites[] = {
+    RemoveReshapeOfReshape,
+    RemoveDequantizeQuantize,
+    FoldPadIntoConvolution,
+    FoldMulOrAddIntoConvolution,
+    FuseActivation,
+};
+
+}  // namespace
+
+TfLiteStatus RewriteGraph(Subgraph* subgraph) {
+  Graph graph(subgraph);
+  // Rewrites end at the node they are tried on, so trying them in execution
+  // order also rewrites chains, such as a MUL and an ADD following a CONV_2D.
+  for (int node_index : subgraph->execution_plan()) {
+    if (graph.IsRemoved(node_index)) continue;
+    for (Rewrite rewrite : kRewrites) {
+      if (rewrite(&graph, node_index)) break;
+    }
+  }
+  return subgraph->SetExecutionPlan(graph.plan());
+}
+
+}  // namespace tflite
@@ -0,0 +1,51 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_GRAPH_REWRITER_H_
+#define TENSORFLOW_LITE_GRAPH_REWRITER_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+
+namespace tflite {
+
+// Applies fusions and no-op eliminations to the execution plan of a subgraph
+// whose nodes and tensors have been set up but not yet allocated, so that
+// models whose converter did not fuse these patterns still run the fused
+// kernels. Every rewrite is exact: it does not change the outputs of the
+// subgraph. The rewrites, tried on the nodes in execution order, are:
+//
+//  * RESHAPE of a RESHAPE: the first RESHAPE is removed.
+//  * DEQUANTIZE followed by a QUANTIZE back to the same type and quantization
+//    parameters: both are removed.
+//  * PAD followed by a CONV_2D or DEPTHWISE_CONV_2D with VALID padding, when
+//    the PAD adds exactly the padding of SAME: the PAD is removed and the
+//    convolution uses SAME padding.
+//  * Float CONV_2D, DEPTHWISE_CONV_2D or FULLY_CONNECTED followed by a MUL or
+//    ADD with a per-channel or scalar constant: the constant is folded into
+//    the weights and bias of the convolution, which becomes the producer of
+//    the MUL or ADD output. Chains such as an unfused batch normalization
+//    fold entirely.
+//  * RELU, RELU6 or RELU_N1_TO_1 following an op with a fused activation
+//    function and no activation: the activation is fused.
+//
+// A pattern is only rewritten when its intermediate tensors are not used by
+// any other node and are not outputs or variables of the subgraph. Removed
+// nodes stay in the subgraph but are no longer in its execution plan.
+// Constants are never modified in place: folded weights are new tensors.
+TfLiteStatus RewriteGraph(Subgraph* subgraph);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_GRAPH_REWRITER_H_
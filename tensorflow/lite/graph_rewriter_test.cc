@@ -0,0 +1,341 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/graph_rewriter.h"
+
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+
+template <typename T>
+T* NewParams() {
+  return static_cast<T*>(calloc(1, sizeof(T)));
+}
+
+// Builds graphs of nodes that only have the builtin code of the ops they
+// stand for, which is all the rewrites look at.
+class GraphRewriterTest : public ::testing::Test {
+ protected:
+  int AddTensor(const std::vector<int>& dims,
+                TfLiteType type = kTfLiteFloat32,
+                TfLiteQuantizationParams params = {}) {
+    int tensor_index;
+    interpreter_.AddTensors(1, &tensor_index);
+    interpreter_.SetTensorParametersReadWrite(tensor_index, type, "", dims,
+                                              params);
+    return tensor_index;
+  }
+
+  template <typename T>
+  int AddConstant(TfLiteType type, const std::vector<int>& dims,
+                  const std::vector<T>& values) {
+    buffers_.emplace_back(reinterpret_cast<const char*>(values.data()),
+                          reinterpret_cast<const char*>(values.data()) +
+                              values.size() * sizeof(T));
+    int tensor_index;
+    interpreter_.AddTensors(1, &tensor_index);
+    interpreter_.SetTensorParametersReadOnly(
+        tensor_index, type, "", dims, TfLiteQuantizationParams(),
+        buffers_.back().data(), buffers_.back().size());
+    return tensor_index;
+  }
+
+  int AddConstant(const std::vector<int>& dims,
+                  const std::vector<float>& values) {
+    return AddConstant(kTfLiteFloat32, dims, values);
+  }
+
+  int AddNode(BuiltinOperator op, const std::vector<int>& inputs,
+              const std::vector<int>& outputs, void* params = nullptr) {
+    TfLiteRegistration registration = {};
+    registration.builtin_code = op;
+    int node_index;
+    interpreter_.AddNodeWithParameters(inputs, outputs, nullptr, 0, params,
+                                       &registration, &node_index);
+    return node_index;
+  }
+
+  void SetInputsAndOutputs(const std::vector<int>& inputs,
+                           const std::vector<int>& outputs) {
+    interpreter_.SetInputs(inputs);
+    interpreter_.SetOutputs(outputs);
+  }
+
+  TfLiteStatus Rewrite() {
+    return RewriteGraph(&interpreter_.primary_subgraph());
+  }
+
+  const std::vector<int>& plan() { return interpreter_.execution_plan(); }
+
+  std::vector<int> node_inputs(int node_index) {
+    const TfLiteIntArray* inputs =
+        interpreter_.node_and_registration(node_index)->first.inputs;
+    return std::vector<int>(inputs->data, inputs->data + inputs->size);
+  }
+
+  int node_output(int node_index) {
+    return interpreter_.node_and_registration(node_index)
+        ->first.outputs->data[0];
+  }
+
+  template <typename T>
+  T* params(int node_index) {
+    return static_cast<T*>(
+        interpreter_.node_and_registration(node_index)->first.builtin_data);
+  }
+
+  std::vector<float> values(int tensor_index) {
+    const TfLiteTensor* tensor = interpreter_.tensor(tensor_index);
+    return std::vector<float>(
+        tensor->data.f, tensor->data.f + tensor->bytes / sizeof(float));
+  }
+
+  Interpreter interpreter_;
+  std::deque<std::vector<char>> buffers_;
+};
+
+TEST_F(GraphRewriterTest, RemovesReshapeOfReshape) {
+  const int input = AddTensor({1, 6});
+  const int reshaped = AddTensor({2, 3});
+  const int output = AddTensor({3, 2});
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_RESHAPE, {input}, {reshaped},
+          NewParams<TfLiteReshapeParams>());
+  const int second = AddNode(BuiltinOperator_RESHAPE, {reshaped}, {output},
+                             NewParams<TfLiteReshapeParams>());
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(second));
+  EXPECT_THAT(node_inputs(second), ElementsAre(input));
+}
+
+TEST_F(GraphRewriterTest, KeepsIntermediateOutputs) {
+  const int input = AddTensor({1, 6});
+  const int reshaped = AddTensor({2, 3});
+  const int output = AddTensor({3, 2});
+  SetInputsAndOutputs({input}, {reshaped, output});
+  AddNode(BuiltinOperator_RESHAPE, {input}, {reshaped},
+          NewParams<TfLiteReshapeParams>());
+  AddNode(BuiltinOperator_RESHAPE, {reshaped}, {output},
+          NewParams<TfLiteReshapeParams>());
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(0, 1));
+}
+
+TEST_F(GraphRewriterTest, RemovesDequantizeQuantize) {
+  const TfLiteQuantizationParams params = {0.5f, 3};
+  const int input = AddTensor({4}, kTfLiteInt8, params);
+  const int dequantized = AddTensor({4});
+  const int quantized = AddTensor({4}, kTfLiteInt8, params);
+  const int output = AddTensor({4}, kTfLiteInt8, params);
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_DEQUANTIZE, {input}, {dequantized});
+  AddNode(BuiltinOperator_QUANTIZE, {dequantized}, {quantized});
+  const int add = AddNode(BuiltinOperator_ADD, {quantized, quantized},
+                          {output}, NewParams<TfLiteAddParams>());
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(add));
+  EXPECT_THAT(node_inputs(add), ElementsAre(input, input));
+}
+
+TEST_F(GraphRewriterTest, KeepsRequantization) {
+  const int input = AddTensor({4}, kTfLiteInt8, {0.5f, 3});
+  const int dequantized = AddTensor({4});
+  const int output = AddTensor({4}, kTfLiteInt8, {0.25f, 3});
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_DEQUANTIZE, {input}, {dequantized});
+  AddNode(BuiltinOperator_QUANTIZE, {dequantized}, {output});
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(0, 1));
+}
+
+TEST_F(GraphRewriterTest, FoldsPadIntoConvolution) {
+  const int input = AddTensor({1, 5, 5, 1});
+  const int paddings = AddConstant<int32_t>(kTfLiteInt32, {4, 2},
+                                            {0, 0, 1, 1, 1, 1, 0, 0});
+  const int padded = AddTensor({1, 7, 7, 1});
+  const int filter = AddConstant({1, 3, 3, 1}, std::vector<float>(9, 1));
+  const int bias = AddConstant({1}, {0});
+  const int output = AddTensor({1, 5, 5, 1});
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_PAD, {input, paddings}, {padded});
+  auto* conv_params = NewParams<TfLiteConvParams>();
+  conv_params->padding = kTfLitePaddingValid;
+  conv_params->stride_width = conv_params->stride_height = 1;
+  conv_params->dilation_width_factor = conv_params->dilation_height_factor = 1;
+  const int conv = AddNode(BuiltinOperator_CONV_2D, {padded, filter, bias},
+                           {output}, conv_params);
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(conv));
+  EXPECT_THAT(node_inputs(conv), ElementsAre(input, filter, bias));
+  EXPECT_EQ(params<TfLiteConvParams>(conv)->padding, kTfLitePaddingSame);
+}
+
+TEST_F(GraphRewriterTest, KeepsPadOtherThanSame) {
+  const int input = AddTensor({1, 5, 5, 1});
+  const int paddings = AddConstant<int32_t>(kTfLiteInt32, {4, 2},
+                                            {0, 0, 0, 2, 1, 1, 0, 0});
+  const int padded = AddTensor({1, 7, 7, 1});
+  const int filter = AddConstant({1, 3, 3, 1}, std::vector<float>(9, 1));
+  const int output = AddTensor({1, 5, 5, 1});
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_PAD, {input, paddings}, {padded});
+  auto* conv_params = NewParams<TfLiteDepthwiseConvParams>();
+  conv_params->padding = kTfLitePaddingValid;
+  conv_params->stride_width = conv_params->stride_height = 1;
+  conv_params->dilation_width_factor = conv_params->dilation_height_factor = 1;
+  AddNode(BuiltinOperator_DEPTHWISE_CONV_2D, {padded, filter}, {output},
+          conv_params);
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(0, 1));
+}
+
+TEST_F(GraphRewriterTest, FoldsMulAndAddIntoConvolution) {
+  const int input = AddTensor({1, 2, 2, 1});
+  const int filter = AddConstant({2, 1, 1, 1}, {1, 2});
+  const int bias = AddConstant({2}, {10, 20});
+  const int conv_output = AddTensor({1, 2, 2, 2});
+  const int scale = AddConstant({2}, {3, 4});
+  const int scaled = AddTensor({1, 2, 2, 2});
+  const int offset = AddConstant({1, 1, 1, 2}, {5, 6});
+  const int output = AddTensor({1, 2, 2, 2});
+  SetInputsAndOutputs({input}, {output});
+  auto* conv_params = NewParams<TfLiteConvParams>();
+  conv_params->padding = kTfLitePaddingSame;
+  const int conv = AddNode(BuiltinOperator_CONV_2D, {input, filter, bias},
+                           {conv_output}, conv_params);
+  AddNode(BuiltinOperator_MUL, {conv_output, scale}, {scaled},
+          NewParams<TfLiteMulParams>());
+  auto* add_params = NewParams<TfLiteAddParams>();
+  add_params->activation = kTfLiteActRelu;
+  AddNode(BuiltinOperator_ADD, {offset, scaled}, {output}, add_params);
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+
+  EXPECT_THAT(plan(), ElementsAre(conv));
+  EXPECT_EQ(node_output(conv), output);
+  EXPECT_EQ(params<TfLiteConvParams>(conv)->activation, kTfLiteActRelu);
+  const std::vector<int> conv_inputs = node_inputs(conv);
+  ASSERT_EQ(conv_inputs.size(), 3);
+  EXPECT_EQ(conv_inputs[0], input);
+  EXPECT_THAT(values(conv_inputs[1]), ElementsAre(3, 8));
+  EXPECT_THAT(values(conv_inputs[2]), ElementsAre(35, 86));
+  // The original constants are left untouched.
+  EXPECT_THAT(values(filter), ElementsAre(1, 2));
+  EXPECT_THAT(values(bias), ElementsAre(10, 20));
+}
+
+TEST_F(GraphRewriterTest, FoldsAddIntoFullyConnectedWithoutBias) {
+  const int input = AddTensor({1, 3});
+  const int weights = AddConstant({2, 3}, {1, 2, 3, 4, 5, 6});
+  const int fc_output = AddTensor({1, 2});
+  const int offset = AddConstant({2}, {7, 8});
+  const int output = AddTensor({1, 2});
+  SetInputsAndOutputs({input}, {output});
+  const int fc = AddNode(BuiltinOperator_FULLY_CONNECTED, {input, weights, -1},
+                         {fc_output}, NewParams<TfLiteFullyConnectedParams>());
+  AddNode(BuiltinOperator_ADD, {fc_output, offset}, {output},
+          NewParams<TfLiteAddParams>());
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+
+  EXPECT_THAT(plan(), ElementsAre(fc));
+  const std::vector<int> fc_inputs = node_inputs(fc);
+  ASSERT_EQ(fc_inputs.size(), 3);
+  EXPECT_EQ(fc_inputs[1], weights);
+  EXPECT_THAT(values(fc_inputs[2]), ElementsAre(7, 8));
+}
+
+TEST_F(GraphRewriterTest, KeepsNonChannelwiseMul) {
+  const int input = AddTensor({1, 2, 2, 1});
+  const int filter = AddConstant({2, 1, 1, 1}, {1, 2});
+  const int conv_output = AddTensor({1, 2, 2, 2});
+  const int scale = AddConstant({2, 1}, {3, 4});
+  const int output = AddTensor({1, 2, 2, 2});
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_CONV_2D, {input, filter}, {conv_output},
+          NewParams<TfLiteConvParams>());
+  AddNode(BuiltinOperator_MUL, {conv_output, scale}, {output},
+          NewParams<TfLiteMulParams>());
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(0, 1));
+}
+
+TEST_F(GraphRewriterTest, KeepsMulAfterConvolutionWithSparseFilter) {
+  const int input = AddTensor({1, 2, 2, 1});
+  const int filter = AddConstant({2, 1, 1, 1}, {1, 2});
+  // The sparsity parameters are never read by the rewrites, and are freed
+  // with the tensor.
+  auto* sparsity = NewParams<TfLiteSparsity>();
+  sparsity->traversal_order = TfLiteIntArrayCreate(4);
+  for (int i = 0; i < 4; ++i) sparsity->traversal_order->data[i] = i;
+  interpreter_.tensor(filter)->sparsity = sparsity;
+  const int conv_output = AddTensor({1, 2, 2, 2});
+  const int scale = AddConstant({2}, {3, 4});
+  const int output = AddTensor({1, 2, 2, 2});
+  SetInputsAndOutputs({input}, {output});
+  AddNode(BuiltinOperator_CONV_2D, {input, filter}, {conv_output},
+          NewParams<TfLiteConvParams>());
+  AddNode(BuiltinOperator_MUL, {conv_output, scale}, {output},
+          NewParams<TfLiteMulParams>());
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(0, 1));
+  EXPECT_THAT(values(filter), ElementsAre(1, 2));
+}
+
+TEST_F(GraphRewriterTest, FusesActivation) {
+  const int input = AddTensor({4});
+  const int sum = AddTensor({4});
+  const int output = AddTensor({4});
+  SetInputsAndOutputs({input}, {output});
+  const int add = AddNode(BuiltinOperator_ADD, {input, input}, {sum},
+                          NewParams<TfLiteAddParams>());
+  AddNode(BuiltinOperator_RELU6, {sum}, {output});
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(add));
+  EXPECT_EQ(node_output(add), output);
+  EXPECT_EQ(params<TfLiteAddParams>(add)->activation, kTfLiteActRelu6);
+}
+
+TEST_F(GraphRewriterTest, KeepsActivationAfterActivation) {
+  const int input = AddTensor({4});
+  const int sum = AddTensor({4});
+  const int output = AddTensor({4});
+  SetInputsAndOutputs({input}, {output});
+  auto* add_params = NewParams<TfLiteAddParams>();
+  add_params->activation = kTfLiteActRelu;
+  AddNode(BuiltinOperator_ADD, {input, input}, {sum}, add_params);
+  AddNode(BuiltinOperator_RELU6, {sum}, {output});
+  ASSERT_EQ(Rewrite(), kTfLiteOk);
+  EXPECT_THAT(plan(), ElementsAre(0, 1));
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
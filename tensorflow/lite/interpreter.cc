@@ -304,6 +304,16 @@ TfLiteStatus Interpreter::ResetVariableTensors() {
   return primary_subgraph().ResetVariableTensors();
 }
 
+TfLiteStatus Interpreter::SnapshotVariableTensors(
+    VariableTensorsSnapshot* snapshot) {
+  return primary_subgraph().SnapshotVariableTensors(snapshot);
+}
+
+TfLiteStatus Interpreter::RestoreVariableTensors(
+    const VariableTensorsSnapshot& snapshot) {
+  return primary_subgraph().RestoreVariableTensors(snapshot);
+}
+
 TfLiteStatus Interpreter::SetTensorParametersReadOnly(
     int tensor_index, TfLiteType type, const char* name,
     const std::vector<int>& dims, TfLiteQuantization quantization,
@@ -374,6 +384,10 @@ TfLiteStatus Interpreter::SetNumThreads(int num_threads) {
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::SetNumInterOpThreads(int num_threads) {
+  return primary_subgraph().SetNumInterOpThreads(num_threads);
+}
+
 void Interpreter::SetAllowFp16PrecisionForFp32(bool allow) {
   for (auto& subgraph : subgraphs_) {
     subgraph->context()->allow_fp32_relax_to_fp16 = allow;
@@ -385,6 +385,16 @@ class Interpreter {
   /// available to itself.
   TfLiteStatus SetNumThreads(int num_threads);
 
+  /// Set the number of threads that run independent ops of the primary
+  /// subgraph concurrently. With 1, the default, ops run one at a time on the
+  /// thread calling `Invoke`. Each of these threads additionally uses up to
+  /// the number of threads set with `SetNumThreads` within ops.
+  ///
+  /// NOTE: num_threads should be >= 1. `AllocateTensors` must be called
+  /// before the next `Invoke`.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
   /// Allow float16 precision for FP32 calculation when possible.
   /// default: not allow.
   /// WARNING: This is an experimental API and subject to change.
@@ -515,6 +525,29 @@ class Interpreter {
   /// WARNING: This is an experimental API and subject to change.
   TfLiteStatus ResetVariableTensors();
 
+  /// Contents of the variable tensors of the primary subgraph and of the
+  /// resource variables.
+  using VariableTensorsSnapshot = Subgraph::VariableTensorsSnapshot;
+
+  /// Variable tensors (e.g. the states of LSTM ops) keep their contents across
+  /// invocations, so a stream of small inputs, such as audio frames, can be
+  /// run with one Invoke() per input without passing the state through input
+  /// and output tensors. ResetVariableTensors() starts a new stream, and the
+  /// following functions suspend a stream and resume it later, possibly after
+  /// running other streams with the same interpreter.
+  ///
+  /// Copies the contents of all variable tensors and resource variables to
+  /// `snapshot`. Variable tensors held by a delegate are read back from it.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SnapshotVariableTensors(VariableTensorsSnapshot* snapshot);
+
+  /// Sets the contents of all variable tensors and resource variables from a
+  /// `snapshot`, which must have been taken with the same variable tensor
+  /// sizes. Resource variables created after the snapshot are reset. Variable
+  /// tensors held by a delegate are copied to it.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus RestoreVariableTensors(const VariableTensorsSnapshot& snapshot);
+
   /// Retrieve an operator's description of its work, for profiling purposes.
   const char* OpProfilingString(const TfLiteRegistration& op_reg,
                                 const TfLiteNode* node) const {
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/graph_rewriter.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/profiling/platform_profiler.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -666,6 +667,11 @@ TfLiteStatus InterpreterBuilder::operator()(
       }
     }
     modified_subgraph->SetVariables(std::move(variables));
+
+    // Fuse the patterns the converter left unfused before anything depends on
+    // the execution plan.
+    if (RewriteGraph(modified_subgraph) != kTfLiteOk)
+      return cleanup_and_error();
   }
 
   if (num_fp32_tensors_ > 0) {
@@ -36,7 +36,11 @@ namespace impl {
 ///
 /// `model`: A model whose lifetime must be at least as long as any
 ///   interpreter(s) created by the builder. In principle multiple interpreters
-///   can be made from a single model.
+///   can be made from a single model. Such interpreters share the model's
+///   constant tensors and the constant weights that kernels transform from
+///   them (e.g. transposed or densified weights), while each keeps its own
+///   arena of activations; running one interpreter per thread thus costs a
+///   single copy of the weights.
 /// `op_resolver`: An instance that implements the `OpResolver` interface, which
 ///   maps custom op names and builtin op codes to op registrations. The
 ///   lifetime of the provided `op_resolver` object must be at least as long as
@@ -18,12 +18,15 @@ limitations under the License.
 #include <stdint.h>
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/lite/builtin_op_data.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/experimental/resource/resource_variable.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/kernels/builtin_op_kernels.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
@@ -33,6 +36,7 @@ limitations under the License.
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/testing/util.h"
+#include "tensorflow/lite/util.h"
 #include "tensorflow/lite/version.h"
 
 namespace tflite {
@@ -133,6 +137,84 @@ TEST(BasicInterpreter, TestAllocateTensorsResetVariableTensorsInt8) {
   }
 }
 
+TEST(BasicInterpreter, SnapshotAndRestoreVariableTensors) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
+  constexpr int kTensorSize = 4;
+  TfLiteQuantizationParams quant;
+  interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "",
+                                           {kTensorSize}, quant,
+                                           /*is_variable=*/true);
+  interpreter.SetTensorParametersReadWrite(1, kTfLiteInt8, "", {kTensorSize},
+                                           quant, /*is_variable=*/true);
+  interpreter.SetVariables({0, 1});
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  for (int i = 0; i < kTensorSize; ++i) {
+    interpreter.tensor(0)->data.f[i] = i + 0.5f;
+    interpreter.tensor(1)->data.int8[i] = -i;
+  }
+
+  Interpreter::VariableTensorsSnapshot snapshot;
+  ASSERT_EQ(interpreter.SnapshotVariableTensors(&snapshot), kTfLiteOk);
+  ASSERT_EQ(snapshot.tensors.size(), 2);
+  ASSERT_EQ(interpreter.ResetVariableTensors(), kTfLiteOk);
+  EXPECT_EQ(interpreter.tensor(0)->data.f[1], 0.0f);
+
+  ASSERT_EQ(interpreter.RestoreVariableTensors(snapshot), kTfLiteOk);
+  for (int i = 0; i < kTensorSize; ++i) {
+    EXPECT_EQ(interpreter.tensor(0)->data.f[i], i + 0.5f);
+    EXPECT_EQ(interpreter.tensor(1)->data.int8[i], -i);
+  }
+
+  // Snapshots of other tensor sizes are rejected before anything is copied.
+  snapshot.tensors[0][0] ^= 1;
+  snapshot.tensors[1].pop_back();
+  EXPECT_EQ(interpreter.RestoreVariableTensors(snapshot), kTfLiteError);
+  EXPECT_EQ(interpreter.tensor(0)->data.f[0], 0.5f);
+  snapshot.tensors.pop_back();
+  EXPECT_EQ(interpreter.RestoreVariableTensors(snapshot), kTfLiteError);
+  EXPECT_EQ(interpreter.tensor(0)->data.f[0], 0.5f);
+}
+
+TEST(BasicInterpreter, SnapshotAndRestoreResourceVariables) {
+  Interpreter interpreter;
+  auto& resources = interpreter.primary_subgraph().resources();
+  auto assign = [&resources](int resource_id, std::vector<float> values) {
+    TfLiteTensor tensor = {};
+    tensor.type = kTfLiteFloat32;
+    tensor.dims = ConvertVectorToTfLiteIntArray(
+        {static_cast<int>(values.size())});
+    tensor.data.f = values.data();
+    tensor.bytes = values.size() * sizeof(float);
+    resource::CreateResourceVariableIfNotAvailable(&resources, resource_id);
+    ASSERT_EQ(resource::GetResourceVariable(&resources, resource_id)
+                  ->AssignFrom(&tensor),
+              kTfLiteOk);
+    TfLiteIntArrayFree(tensor.dims);
+  };
+  auto values = [&resources](int resource_id) {
+    const TfLiteTensor* tensor =
+        resource::GetResourceVariable(&resources, resource_id)->GetTensor();
+    return std::vector<float>(tensor->data.f,
+                              tensor->data.f + tensor->bytes / sizeof(float));
+  };
+  assign(1, {1, 2});
+  resource::CreateResourceVariableIfNotAvailable(&resources, 2);
+
+  Interpreter::VariableTensorsSnapshot snapshot;
+  ASSERT_EQ(interpreter.SnapshotVariableTensors(&snapshot), kTfLiteOk);
+  // The uninitialized variable is left out.
+  ASSERT_EQ(snapshot.resource_variables.size(), 1);
+
+  assign(1, {3, 4, 5});
+  assign(2, {6});
+  assign(3, {7});
+  ASSERT_EQ(interpreter.RestoreVariableTensors(snapshot), kTfLiteOk);
+  EXPECT_EQ(values(1), std::vector<float>({1, 2}));
+  EXPECT_FALSE(resources[2]->IsInitialized());
+  EXPECT_FALSE(resources[3]->IsInitialized());
+}
+
 // Test size accessor functions.
 TEST(BasicInterpreter, TestSizeFunctions) {
   Interpreter interpreter;
@@ -693,6 +775,47 @@ TEST(BasicInterpreter, OneOpInterpreter) {
   ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
 }
 
+TEST(BasicInterpreter, InterOpParallelism) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2, 4}), kTfLiteOk);
+
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+
+  // Two independent chains of two ops reading the same input.
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  for (const auto& edge : std::vector<std::pair<int, int>>{
+           {0, 1}, {1, 2}, {0, 3}, {3, 4}}) {
+    ASSERT_EQ(interpreter.AddNodeWithParameters({edge.first}, {edge.second},
+                                                nullptr, 0, nullptr, &reg),
+              kTfLiteOk);
+  }
+
+  ASSERT_NE(interpreter.SetNumInterOpThreads(0), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  for (int run = 0; run < 10; ++run) {
+    float* input = interpreter.typed_tensor<float>(0);
+    for (int i = 0; i < 3; ++i) {
+      input[i] = run * 3 + i;
+    }
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int output : {2, 4}) {
+      const float* data = interpreter.typed_tensor<float>(output);
+      for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(data[i], run * 3 + i);
+      }
+    }
+  }
+}
+
 TEST(BasicInterpreter, ReleaseNonPersistentMemory) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
@@ -17,6 +17,7 @@ limitations under the License.
 #include <stddef.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 // Only use multi-threaded Eigen if ruy is disabled.
@@ -45,6 +46,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/kernels/shared_weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -105,6 +107,10 @@ struct OpData {
 
   bool need_hwcn_weights = false;
   bool have_weights_been_transposed = false;
+  // If the filter is constant, its transpose is shared by all interpreters of
+  // the model instead of being stored in the `hwcn_weights` temporary.
+  bool share_hwcn_weights = false;
+  std::shared_ptr<const void> shared_hwcn_weights;
   bool need_im2col = false;
 
   bool supports_multithreaded_kernel = false;
@@ -145,11 +151,8 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatMatrix(const float* input_data, int rows, int cols,
+                          float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -158,6 +161,11 @@ void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(const TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatMatrix(GetTensorData<float>(input), output->dims->data[1],
+                       output->dims->data[0], GetTensorData<float>(output));
+}
+
 // Check if im2col needs to be allocated, as some version of optimized Conv dont
 // use it. If any change is supporting im2col in any of the Conv versions, then
 // it should be updated here as well
@@ -236,6 +244,8 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
   // we're running with that data type.
   data->need_hwcn_weights =
       input->type == kTfLiteFloat32 && data->supports_multithreaded_kernel;
+  data->share_hwcn_weights =
+      data->need_hwcn_weights && IsConstantTensor(filter);
 
   // We don't always need to allocate im2col. It is only used in some versions
   // of the optimized Conv. This test just mimics something that happens inside
@@ -251,7 +261,7 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !data->share_hwcn_weights) {
     data->hwcn_weights_index = temporaries_count;
     if (data->hwcn_weights_id == kTensorNotAllocated) {
       context->AddTensors(context, 1, &data->hwcn_weights_id);
@@ -464,7 +474,7 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !data->share_hwcn_weights) {
     node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
     TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
 
@@ -734,7 +744,7 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
                TfLiteConvParams* params, OpData* data,
                const TfLiteTensor* input, const TfLiteTensor* filter,
                const TfLiteTensor* bias, TfLiteTensor* im2col,
-               TfLiteTensor* hwcn_weights, TfLiteTensor* output) {
+               const float* hwcn_weights, TfLiteTensor* output) {
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
@@ -779,7 +789,7 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
 #if defined(TFLITE_WITH_MULTITHREADED_EIGEN)
       const float* filter_data;
       if (data->need_hwcn_weights) {
-        filter_data = GetTensorData<float>(hwcn_weights);
+        filter_data = hwcn_weights;
       } else {
         filter_data = GetTensorData<float>(filter);
       }
@@ -955,14 +965,27 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
       data->need_im2col
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
-  TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
-          ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
-          : nullptr;
-
-  if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
-    TransposeFloatTensor(filter, hwcn_weights);
-    data->have_weights_been_transposed = true;
+  const float* hwcn_weights = nullptr;
+  if (data->share_hwcn_weights) {
+    if (data->shared_hwcn_weights == nullptr) {
+      const int rows = filter->dims->data[0];
+      const int cols = NumElements(filter) / rows;
+      data->shared_hwcn_weights = shared_weights_cache::GetOrCreate(
+          filter, "conv_hwcn_weights", filter->bytes,
+          [filter, rows, cols](void* hwcn_weights) {
+            TransposeFloatMatrix(GetTensorData<float>(filter), rows, cols,
+                                 static_cast<float*>(hwcn_weights));
+          });
+    }
+    hwcn_weights = static_cast<const float*>(data->shared_hwcn_weights.get());
+  } else if (data->need_hwcn_weights) {
+    TfLiteTensor* hwcn_weights_tensor =
+        &context->tensors[node->temporaries->data[data->hwcn_weights_index]];
+    if (!data->have_weights_been_transposed) {
+      TransposeFloatTensor(filter, hwcn_weights_tensor);
+      data->have_weights_been_transposed = true;
+    }
+    hwcn_weights = GetTensorData<float>(hwcn_weights_tensor);
   }
 
   TFLITE_DCHECK_EQ(input_type, input->type);
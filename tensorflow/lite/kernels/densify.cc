@@ -17,10 +17,12 @@ limitations under the License.
 #include <stddef.h>
 
 #include <cstdint>
+#include <memory>
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/shared_weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -37,13 +39,20 @@ struct OpContext {
 };
 
 struct OpData {
-  bool dense_weights_initialized;
+  // The dense weights, shared with the densify nodes of other interpreters
+  // built from the same model.
+  std::shared_ptr<const void> dense_weights;
 };
 
+template <typename T>
+void DensifyTo(const TfLiteTensor* input, void* output) {
+  reference_ops::Densify(input->sparsity, GetTensorShape(input),
+                         GetTensorData<T>(input), GetTensorShape(input),
+                         static_cast<T*>(output));
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
-  auto* op_data = new OpData();
-  op_data->dense_weights_initialized = false;
-  return op_data;
+  return new OpData();
 }
 
 void Free(TfLiteContext* context, void* buffer) {
@@ -51,6 +60,12 @@ void Free(TfLiteContext* context, void* buffer) {
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
+  if (op_data->dense_weights != nullptr) {
+    // The input is constant, so the output computed earlier is still valid.
+    return kTfLiteOk;
+  }
+
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
 
@@ -60,50 +75,44 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, IsConstantTensor(op_context.input));
   TF_LITE_ENSURE(context, op_context.input->sparsity != nullptr);
 
-  op_context.output->type = op_context.input->type;
-  op_context.output->allocation_type = kTfLiteArenaRwPersistent;
-
-  return context->ResizeTensor(context, op_context.output,
-                               TfLiteIntArrayCopy(op_context.input->dims));
-}
-
-TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
-  OpContext op_context(context, node);
-  if (op_data->dense_weights_initialized) {
-    return kTfLiteOk;
-  }
-
+  void (*densify)(const TfLiteTensor*, void*);
   switch (op_context.input->type) {
     case kTfLiteFloat32:
-      reference_ops::Densify(op_context.input->sparsity,
-                             GetTensorShape(op_context.input),
-                             GetTensorData<float>(op_context.input),
-                             GetTensorShape(op_context.output),
-                             GetTensorData<float>(op_context.output));
+      densify = DensifyTo<float>;
       break;
     case kTfLiteFloat16:
-      reference_ops::Densify(op_context.input->sparsity,
-                             GetTensorShape(op_context.input),
-                             GetTensorData<Eigen::half>(op_context.input),
-                             GetTensorShape(op_context.output),
-                             GetTensorData<Eigen::half>(op_context.output));
+      densify = DensifyTo<Eigen::half>;
       break;
     case kTfLiteInt8:
-      reference_ops::Densify(op_context.input->sparsity,
-                             GetTensorShape(op_context.input),
-                             GetTensorData<int8_t>(op_context.input),
-                             GetTensorShape(op_context.output),
-                             GetTensorData<int8_t>(op_context.output));
+      densify = DensifyTo<int8_t>;
       break;
-
     default:
       context->ReportError(context, "Type %d not supported.",
                            op_context.input->type);
       return kTfLiteError;
   }
 
-  op_data->dense_weights_initialized = true;
+  // The output is densified here rather than in Eval, and is made a constant
+  // tensor pointing to the shared dense weights: it is neither planned in the
+  // arena nor copied per interpreter, and downstream ops see constant
+  // weights.
+  op_context.output->type = op_context.input->type;
+  op_context.output->allocation_type = kTfLiteCustom;
+  TF_LITE_ENSURE_OK(context,
+                    context->ResizeTensor(
+                        context, op_context.output,
+                        TfLiteIntArrayCopy(op_context.input->dims)));
+  const TfLiteTensor* input = op_context.input;
+  op_data->dense_weights = shared_weights_cache::GetOrCreate(
+      input, "densify", op_context.output->bytes,
+      [input, densify](void* dense_weights) { densify(input, dense_weights); });
+  op_context.output->data.raw = const_cast<char*>(
+      static_cast<const char*>(op_data->dense_weights.get()));
+  op_context.output->allocation_type = kTfLiteMmapRo;
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
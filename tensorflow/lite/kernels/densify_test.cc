@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/shared_weights_cache.h"
 #include "tensorflow/lite/kernels/test_util.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -57,6 +58,9 @@ class DensifyOpModel : public SingleOpModel {
 
   std::vector<T> GetInput() { return ExtractVector<T>(input_); }
   std::vector<T> GetOutput() { return ExtractVector<T>(output_); }
+  bool IsOutputConstant() {
+    return interpreter_->tensor(output_)->allocation_type == kTfLiteMmapRo;
+  }
 
  private:
   int input_;
@@ -105,5 +109,24 @@ TEST(DensifyOpTest, Int8) {
   EXPECT_THAT(m.GetOutput(), ElementsAreArray(dense_values));
 }
 
+TEST(DensifyOpTest, OutputIsSharedConstant) {
+  std::vector<float> dense_values = {6, 0, 9, 8, 0, 0, 0, 0, 5, 0, 0, 7};
+  TensorData input = {};
+  input.type = TensorType_FLOAT32;
+  input.shape = {3, 4};
+  input.traversal_order = {0, 1};
+  input.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  const int num_cached_buffers = shared_weights_cache::NumCachedBuffers();
+  {
+    DensifyOpModel<float> m(input, dense_values);
+    EXPECT_TRUE(m.IsOutputConstant());
+    EXPECT_EQ(shared_weights_cache::NumCachedBuffers(),
+              num_cached_buffers + 1);
+    m.Invoke();
+    EXPECT_THAT(m.GetOutput(), ElementsAreArray(dense_values));
+  }
+  EXPECT_EQ(shared_weights_cache::NumCachedBuffers(), num_cached_buffers);
+}
+
 }  // namespace
 }  // namespace tflite
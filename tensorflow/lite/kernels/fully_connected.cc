@@ -118,6 +118,11 @@ inline TfLiteStatus CheckTypes(TfLiteContext* context,
                                   output->type == kTfLiteInt16);
       TF_LITE_ENSURE_EQ(context, is_optional_bias_int, true);
     }
+  } else if (filter->type == kTfLiteFloat16) {
+    // Half-precision weights are only supported with float32 activations.
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteFloat32);
+    TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+    TF_LITE_ENSURE_EQ(context, is_optional_bias_float, true);
   } else {
     // Only float32 is supported currently
     TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteFloat32);
@@ -295,6 +300,51 @@ TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+// Allocates the scratch tensors of the optimized kernel for half-precision
+// weights: a block of weights widened to float, and the outputs of the block,
+// which are only needed when the weights take more than one block.
+TfLiteStatus PrepareHalfWeightsScratch(TfLiteContext* context,
+                                       TfLiteNode* node) {
+  OpData* data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* filter = GetInput(context, node, kWeightsTensor);
+  const int num_units = SizeOfDimension(filter, 0);
+  const int accum_depth = SizeOfDimension(filter, 1);
+  const int batch_size = NumElements(input) / accum_depth;
+  const int block_rows =
+      optimized_ops::HalfWeightsBlockRows(num_units, accum_depth);
+
+  TfLiteIntArrayFree(node->temporaries);
+  node->temporaries = TfLiteIntArrayCreate(2);
+  node->temporaries->data[0] = data->scratch_tensor_index;
+  TfLiteTensor* block_weights = GetTemporary(context, node, /*index=*/0);
+  block_weights->type = kTfLiteFloat32;
+  block_weights->allocation_type = kTfLiteArenaRw;
+  int block_weights_dims[2] = {block_rows, accum_depth};
+  if (!TfLiteIntArrayEqualsArray(block_weights->dims, 2, block_weights_dims)) {
+    TfLiteIntArray* block_weights_size = TfLiteIntArrayCreate(2);
+    block_weights_size->data[0] = block_rows;
+    block_weights_size->data[1] = accum_depth;
+    TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, block_weights,
+                                                     block_weights_size));
+  }
+
+  node->temporaries->data[1] = data->scratch_tensor_index + 1;
+  TfLiteTensor* block_output = GetTemporary(context, node, /*index=*/1);
+  block_output->type = kTfLiteFloat32;
+  block_output->allocation_type = kTfLiteArenaRw;
+  int block_output_dims[2] = {batch_size,
+                              block_rows < num_units ? block_rows : 0};
+  if (!TfLiteIntArrayEqualsArray(block_output->dims, 2, block_output_dims)) {
+    TfLiteIntArray* block_output_size = TfLiteIntArrayCreate(2);
+    block_output_size->data[0] = block_output_dims[0];
+    block_output_size->data[1] = block_output_dims[1];
+    TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, block_output,
+                                                     block_output_size));
+  }
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type>
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   // Check for supported activation types.
@@ -315,7 +365,12 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                                 params->activation == kTfLiteActReluN1To1 ||
                                 params->activation == kTfLiteActRelu6);
   }
-  return PrepareImpl(context, node);
+  TF_LITE_ENSURE_STATUS(PrepareImpl(context, node));
+  // Only the optimized kernel widens the weights into scratch buffers.
+  if (filter->type == kTfLiteFloat16 && kernel_type != kReference) {
+    TF_LITE_ENSURE_STATUS(PrepareHalfWeightsScratch(context, node));
+  }
+  return kTfLiteOk;
 }
 
 TfLiteStatus EvalPie(TfLiteContext* context, TfLiteNode* node,
@@ -473,6 +528,39 @@ void FullyConnectedInt16(const OpData* data, const TfLiteTensor* input,
 }
 }  // namespace
 
+template <KernelType kernel_type>
+TfLiteStatus EvalSparseInt8(TfLiteContext* context,
+                            const FullyConnectedParams& op_params,
+                            const TfLiteTensor* input,
+                            const TfLiteTensor* filter,
+                            const TfLiteTensor* bias, TfLiteTensor* output) {
+  const auto& sparsity = *filter->sparsity;
+  if (kernel_type == kReference) {
+    reference_ops::FullyConnectedSparseWeight(
+        sparsity, op_params, GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter),
+        GetTensorData<int8_t>(filter), GetTensorShape(bias),
+        GetTensorData<int32_t>(bias), GetTensorShape(output),
+        GetTensorData<int8_t>(output));
+    return kTfLiteOk;
+  }
+  if (!SupportedSparsityFormat(sparsity) ||
+      sparsity.dim_metadata_size != kDimMetadataSizeBlockSparse ||
+      sparsity.dim_metadata[2].dense_size != 4) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Unsupported sparse fully-connected weight format.");
+    return kTfLiteError;
+  }
+  // Block sparse with block size of 1x4, with symmetric weights.
+  TF_LITE_ENSURE_EQ(context, op_params.weights_offset, 0);
+  optimized_ops::FullyConnectedSparseWeight1x4(
+      sparsity, op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
+      GetTensorShape(filter), GetTensorData<int8_t>(filter),
+      GetTensorShape(bias), GetTensorData<int32_t>(bias),
+      GetTensorShape(output), GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type>
 TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                            TfLiteFullyConnectedParams* params, OpData* data,
@@ -521,6 +609,10 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
         }
         break;
       case kTfLiteInt8:
+        if (filter->sparsity != nullptr) {
+          return EvalSparseInt8<kernel_type>(context, op_params, input,
+                                             filter, bias, output);
+        }
         FullyConnectedInt8<kernel_type>(
             data, input, filter, bias, output,
             CpuBackendContext::GetFromContext(context));
@@ -687,6 +779,44 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+template <KernelType kernel_type>
+TfLiteStatus EvalHalfWeights(TfLiteContext* context, TfLiteNode* node,
+                             TfLiteFullyConnectedParams* params,
+                             const TfLiteTensor* input,
+                             const TfLiteTensor* filter,
+                             const TfLiteTensor* bias, TfLiteTensor* output) {
+  if (filter->sparsity != nullptr) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Sparse half-precision weights are not supported.");
+    return kTfLiteError;
+  }
+  FullyConnectedParams op_params;
+  CalculateActivationRange(params->activation,
+                           &op_params.float_activation_min,
+                           &op_params.float_activation_max);
+  const Eigen::half* weights_data = reinterpret_cast<const Eigen::half*>(
+      GetTensorData<TfLiteFloat16>(filter));
+  if (kernel_type == kReference) {
+    reference_ops::FullyConnected(
+        op_params, GetTensorShape(input), GetTensorData<float>(input),
+        GetTensorShape(filter), weights_data, GetTensorShape(bias),
+        GetTensorData<float>(bias), GetTensorShape(output),
+        GetTensorData<float>(output));
+  } else {
+    op_params.rhs_cacheable = IsConstantTensor(input);
+    TfLiteTensor* block_weights = GetTemporary(context, node, /*index=*/0);
+    TfLiteTensor* block_output = GetTemporary(context, node, /*index=*/1);
+    optimized_ops::FullyConnected(
+        op_params, GetTensorShape(input), GetTensorData<float>(input),
+        GetTensorShape(filter), weights_data, GetTensorShape(bias),
+        GetTensorData<float>(bias), GetTensorShape(output),
+        GetTensorData<float>(output), GetTensorData<float>(block_weights),
+        GetTensorData<float>(block_output),
+        CpuBackendContext::GetFromContext(context));
+  }
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type>
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
@@ -705,6 +835,9 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteFloat32:
       return EvalFloat<kernel_type>(context, node, params, data, input, filter,
                                     bias, output);
+    case kTfLiteFloat16:
+      return EvalHalfWeights<kernel_type>(context, node, params, input, filter,
+                                          bias, output);
     case kTfLiteUInt8:
       if (params->weights_format ==
           kTfLiteFullyConnectedWeightsFormatShuffled4x16Int8) {
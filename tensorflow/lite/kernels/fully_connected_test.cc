@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/test_util.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/string_type.h"
+#include "third_party/eigen3/Eigen/Core"
 
 namespace tflite {
 namespace {
@@ -377,6 +378,45 @@ class QuantizedFullyConnectedOpTest : public SingleOpTest {
   }
 };
 
+// Float activations with half-precision weights.
+class HalfWeightsFullyConnectedOpModel : public SingleOpModel {
+ public:
+  HalfWeightsFullyConnectedOpModel(TfLiteRegistration* registration, int units,
+                                   int batches, int input_size) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, input_size}});
+    weights_ = AddInput({TensorType_FLOAT16, {units, input_size}});
+    bias_ = AddInput({TensorType_FLOAT32, {units}});
+    output_ = AddOutput({TensorType_FLOAT32});
+
+    SetBuiltinOp(BuiltinOperator_FULLY_CONNECTED,
+                 BuiltinOptions_FullyConnectedOptions,
+                 CreateFullyConnectedOptions(builder_,
+                                             ActivationFunctionType_RELU)
+                     .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)});
+  }
+
+  void SetWeights(std::vector<Eigen::half> weights) {
+    PopulateTensor(weights_, /*offset=*/0,
+                   reinterpret_cast<TfLiteFloat16*>(weights.data()),
+                   reinterpret_cast<TfLiteFloat16*>(weights.data()) +
+                       weights.size());
+  }
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
 const auto kKernelMapHybrid = new std::map<string, TfLiteRegistration*>({
     {"Pie", ops::builtin::Register_FULLY_CONNECTED_PIE()},
     // Only Pie supports the hybrid path, so the optimized kernel should fall
@@ -457,6 +497,70 @@ TEST(FloatFullyConnectedOpTest, SimpleTestNoBias) {
   EXPECT_THAT(m.GetOutput(), ElementsAre(10, 8));
 }
 
+TEST_P(FloatFullyConnectedOpTest, SimpleTestHalfWeights) {
+  HalfWeightsFullyConnectedOpModel m(GetRegistration(), /*units=*/3,
+                                     /*batches=*/2, /*input_size=*/10);
+  std::vector<Eigen::half> weights;
+  for (int u = 0; u < 3; ++u) {
+    for (int i = 1; i <= 10; ++i) {
+      weights.push_back(Eigen::half(static_cast<float>(i)));
+    }
+  }
+  m.SetWeights(weights);
+  m.SetBias({1, 2, 3});
+
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,  -9, -10,  // b = 0
+      1, 2, 3, 4, 5, 6, 7, -8, 9,  -10,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+  EXPECT_THAT(m.GetOutput(), ElementsAre(24, 25, 26, 58, 59, 60));
+}
+
+TEST_P(FloatFullyConnectedOpTest, HalfWeightsSpanningSeveralBlocks) {
+  // Large enough for the optimized kernel to widen the weights in several
+  // blocks of rows, the last of them partial.
+  const int units = 40;
+  const int batches = 2;
+  const int input_size = 1000;
+  HalfWeightsFullyConnectedOpModel m(GetRegistration(), units, batches,
+                                     input_size);
+  std::vector<Eigen::half> weights;
+  for (int i = 0; i < units * input_size; ++i) {
+    weights.push_back(Eigen::half(((i % 7) - 3) * 0.25f));
+  }
+  m.SetWeights(weights);
+  std::vector<float> bias;
+  for (int u = 0; u < units; ++u) {
+    bias.push_back(u - 20);
+  }
+  m.SetBias(bias);
+  std::vector<float> input;
+  for (int i = 0; i < batches * input_size; ++i) {
+    input.push_back((i % 5) - 2);
+  }
+  m.SetInput(input);
+
+  m.Invoke();
+
+  std::vector<float> expected;
+  for (int b = 0; b < batches; ++b) {
+    for (int u = 0; u < units; ++u) {
+      float total = bias[u];
+      for (int i = 0; i < input_size; ++i) {
+        total += input[b * input_size + i] *
+                 static_cast<float>(weights[u * input_size + i]);
+      }
+      expected.push_back(std::max(total, 0.0f));
+    }
+  }
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(batches, units));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear(expected)));
+}
+
 TEST_P(QuantizedFullyConnectedOpTest, SimpleTestQuantizedUint8) {
   QuantizedFullyConnectedOpModel m(
       GetRegistration(), /*units=*/3, /*batches*/ 2,
@@ -1355,6 +1459,83 @@ TEST_P(SparseFullyConnectedOpTest, Simple1x4TestMultiThreadedMoreBatches) {
                                            ));
   }
 }
+class SparseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseQuantizedFullyConnectedOpModel(TfLiteRegistration* registration,
+                                       const TensorData& input,
+                                       const TensorData& weights,
+                                       const std::vector<int8_t>& weights_data,
+                                       const TensorData& output) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data);
+    const int units = weights.shape[0];
+    bias_ = AddInput({TensorType_INT32,
+                      {units},
+                      0,
+                      0,
+                      GetScale(input_) * weights.scale,
+                      0});
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_RELU)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     /*num_threads=*/1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+  void SetBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(SparseFullyConnectedOpTest, Simple1x4TestQuantizedInt8) {
+  std::vector<int8_t> weight_data = {
+      1, 2, 3, 4, 0, 0, 0, 0, 9, 10, 11, 12,  // u = 0
+      0, 0, 0, 0, 5, 6, 7, 8, 0, 0,  0,  0,  // u = 1
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,  // u = 2
+  };
+  TensorData weight = {};
+  weight.type = TensorType_INT8;
+  weight.shape = {3, 12};
+  weight.scale = 1.0;
+  weight.traversal_order = {0, 1, 2};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {1};
+  weight.block_size = {4};
+  SparseQuantizedFullyConnectedOpModel m(
+      GetRegistration(), /*input=*/{TensorType_INT8, {2, 12}, -63.5, 64},
+      weight, weight_data, /*output=*/{TensorType_INT8, {}, -508, 512});
+  m.SetBias({1, 2, 3});
+
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,  -9, -10, 11,  12,  // b = 0
+      1, 2, 3, 4, 5, 6, 7, -8, 9,  -10, -11, 12,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear({115, 176, 291, 35, 48, 83},
+                                              /*max_abs_error=*/2)));
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
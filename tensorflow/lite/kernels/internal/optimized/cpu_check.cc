@@ -47,4 +47,22 @@ bool DetectArmNeonDotprod() {
   return false;
 }
 
+bool DetectX86Avx2() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_cpu_supports("avx2");
+#endif
+
+  return false;
+}
+
+bool DetectX86Avx512Vnni() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_cpu_supports("avx2") &&
+         __builtin_cpu_supports("avx512vl") &&
+         __builtin_cpu_supports("avx512vnni");
+#endif
+
+  return false;
+}
+
 }  // namespace tflite
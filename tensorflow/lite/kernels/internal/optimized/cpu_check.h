@@ -27,12 +27,24 @@ namespace tflite {
 // On other architectures, returns false unconditionally.
 bool DetectArmNeonDotprod();
 
+// On x86 with GCC or Clang, returns true if AVX2 is supported by the CPU and
+// enabled by the OS. On other platforms, returns false unconditionally.
+bool DetectX86Avx2();
+
+// Same as DetectX86Avx2, for AVX-512 VNNI on 256-bit vectors (which also
+// requires AVX-512 VL).
+bool DetectX86Avx512Vnni();
+
 struct CpuFlags {
   bool neon_dotprod = false;
+  bool avx2 = false;
+  bool avx512_vnni = false;
 };
 
 inline void GetCpuFlags(CpuFlags* cpu_flags) {
   cpu_flags->neon_dotprod = DetectArmNeonDotprod();
+  cpu_flags->avx2 = DetectX86Avx2();
+  cpu_flags->avx512_vnni = DetectX86Avx512Vnni();
 }
 
 }  // namespace tflite
@@ -1989,6 +1989,44 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, int32_t vector_offset, int n_batch,
+    int32_t* __restrict__ result) {
+  const int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  const int16x4_t vector_offset_16x4 =
+      vdup_n_s16(static_cast<int16_t>(vector_offset));
+
+  for (int batch = 0; batch < n_batch; batch++) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vector + batch * m_cols;
+    for (int row = 0; row < m_rows; row++) {
+      int32x4_t acc_32x4 = vmovq_n_s32(0);
+      for (int i = segments[row]; i < segments[row + 1]; i++) {
+        const int block_start_index = indices[i] * kBlockSize;
+        // Load the 4 int8 values of the block and of the vector, widened to
+        // int16. The offset vector values fit in int16.
+        int32_t matrix_block, vector_block;
+        memcpy(&matrix_block, matrix_ptr, sizeof(matrix_block));
+        memcpy(&vector_block, vector_in_batch + block_start_index,
+               sizeof(vector_block));
+        const int16x4_t matrix_16x4 = vget_low_s16(
+            vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(matrix_block))));
+        const int16x4_t vector_16x4 = vadd_s16(
+            vget_low_s16(
+                vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(vector_block)))),
+            vector_offset_16x4);
+        // Multiply the vector and matrix block and add to accumulator.
+        acc_32x4 = vmlal_s16(acc_32x4, matrix_16x4, vector_16x4);
+        matrix_ptr += kBlockSize;
+      }
+      result[batch * m_rows + row] += AccumulateNeonLane(acc_32x4);
+    }
+  }
+}
+
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
@@ -402,6 +402,97 @@ inline void FullyConnected(
                          cpu_backend_context);
 }
 
+// Widens 'size' half-precision floats to float.
+inline void HalfToFloat(const Eigen::half* input_data, int size,
+                        float* output_data) {
+  int i = 0;
+#if defined(USE_NEON) && defined(__aarch64__)
+  // The conversion instructions are part of the base A64 instruction set.
+  const uint16_t* input_bits = reinterpret_cast<const uint16_t*>(input_data);
+  for (; i <= size - 8; i += 8) {
+    const float16x8_t input = vreinterpretq_f16_u16(vld1q_u16(input_bits + i));
+    vst1q_f32(output_data + i, vcvt_f32_f16(vget_low_f16(input)));
+    vst1q_f32(output_data + i + 4, vcvt_high_f32_f16(input));
+  }
+#endif
+  for (; i < size; ++i) {
+    output_data[i] = Eigen::half_impl::half_to_float(input_data[i]);
+  }
+}
+
+// Returns the number of rows of half-precision weights that FullyConnected
+// widens to float at a time.
+inline int HalfWeightsBlockRows(int output_depth, int accum_depth) {
+  // Number of widened weights per block.
+  constexpr int kBlockSize = 16 * 1024;
+  return std::min(output_depth, std::max(1, kBlockSize / accum_depth));
+}
+
+// Fully connected with float activations and half-precision weights. The
+// weights are widened to float one block of rows at a time, small enough to
+// stay in cache while the block is multiplied, so that only the half-precision
+// weights are read from memory.
+//
+// 'block_weights_data' holds a block of HalfWeightsBlockRows() x accum_depth
+// widened weights. 'block_output_data' holds the batches x
+// HalfWeightsBlockRows() outputs of a block, and is only used when the weights
+// take more than one block.
+inline void FullyConnected(
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const float* input_data, const RuntimeShape& weights_shape,
+    const Eigen::half* weights_data, const RuntimeShape& bias_shape,
+    const float* optional_bias_data, const RuntimeShape& output_shape,
+    float* output_data, float* block_weights_data, float* block_output_data,
+    CpuBackendContext* cpu_backend_context) {
+  ruy::profiler::ScopeLabel label("FullyConnected/HalfWeights");
+  const int dims_count = weights_shape.DimensionsCount();
+  const int accum_depth = weights_shape.Dims(dims_count - 1);
+  const int output_depth = FlatSizeSkipDim(weights_shape, dims_count - 1);
+  const int batches = input_shape.FlatSize() / accum_depth;
+  TFLITE_DCHECK_EQ(input_shape.FlatSize(), accum_depth * batches);
+  TFLITE_DCHECK_EQ(output_shape.FlatSize(), output_depth * batches);
+  const int block_rows = HalfWeightsBlockRows(output_depth, accum_depth);
+
+  cpu_backend_gemm::MatrixParams<float> rhs_params;
+  rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = accum_depth;
+  rhs_params.cols = batches;
+  rhs_params.cache_policy =
+      cpu_backend_gemm::DefaultCachePolicy(params.rhs_cacheable);
+  for (int row = 0; row < output_depth; row += block_rows) {
+    const int rows = std::min(block_rows, output_depth - row);
+    HalfToFloat(weights_data + row * accum_depth, rows * accum_depth,
+                block_weights_data);
+
+    cpu_backend_gemm::MatrixParams<float> lhs_params;
+    lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+    lhs_params.rows = rows;
+    lhs_params.cols = accum_depth;
+    cpu_backend_gemm::MatrixParams<float> dst_params;
+    dst_params.order = cpu_backend_gemm::Order::kColMajor;
+    dst_params.rows = rows;
+    dst_params.cols = batches;
+    cpu_backend_gemm::GemmParams<float, float> gemm_params;
+    gemm_params.bias = optional_bias_data ? optional_bias_data + row : nullptr;
+    gemm_params.clamp_min = params.float_activation_min;
+    gemm_params.clamp_max = params.float_activation_max;
+    // A single block is written to the output directly.
+    if (block_rows == output_depth) {
+      cpu_backend_gemm::Gemm(lhs_params, block_weights_data, rhs_params,
+                             input_data, dst_params, output_data, gemm_params,
+                             cpu_backend_context);
+      break;
+    }
+    cpu_backend_gemm::Gemm(lhs_params, block_weights_data, rhs_params,
+                           input_data, dst_params, block_output_data,
+                           gemm_params, cpu_backend_context);
+    for (int b = 0; b < batches; ++b) {
+      memcpy(output_data + b * output_depth + row,
+             block_output_data + b * rows, rows * sizeof(float));
+    }
+  }
+}
+
 inline void FullyConnected(
     const FullyConnectedParams& params, const RuntimeShape& input_shape,
     const uint8* input_data, const RuntimeShape& filter_shape,
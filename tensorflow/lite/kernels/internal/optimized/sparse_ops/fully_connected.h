@@ -201,6 +201,51 @@ inline void FullyConnectedSparseWeight1x4(
                                   cpu_backend_context);
 }
 
+// Int8 version of the above, for symmetrically quantized weights. The int32
+// accumulators of one batch at a time are requantized to the output.
+inline void FullyConnectedSparseWeight1x4(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data) {
+  ruy::profiler::ScopeLabel label("FullyConnectedInt8");
+  ruy::profiler::ScopeLabel inner_label("1x4 Block Sparse");
+  TFLITE_DCHECK_EQ(params.weights_offset, 0);
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  const int input_dims_count = input_shape.DimensionsCount();
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int input_depth = MatchingDim(weights_shape, weights_dims_count - 1,
+                                      input_shape, input_dims_count - 1);
+  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
+                                       output_shape, output_dims_count - 1);
+  const int* w1_segments = sparsity.dim_metadata[1].array_segments->data;
+  const int* w1_indices = sparsity.dim_metadata[1].array_indices->data;
+
+  std::vector<int32_t> accum(output_depth);
+  for (int b = 0; b < batches; ++b) {
+    for (int i = 0; i < output_depth; ++i) {
+      accum[i] = bias_data ? bias_data[i] : 0;
+    }
+    tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x4(
+        weights_data, w1_segments, w1_indices, output_depth, input_depth,
+        input_data + b * input_depth, params.input_offset, /*n_batch=*/1,
+        accum.data());
+    for (int i = 0; i < output_depth; ++i) {
+      int32_t acc = MultiplyByQuantizedMultiplier(
+          accum[i], params.output_multiplier, params.output_shift);
+      acc += params.output_offset;
+      acc = std::max(acc, output_activation_min);
+      acc = std::min(acc, output_activation_max);
+      output_data[b * output_depth + i] = static_cast<int8_t>(acc);
+    }
+  }
+}
+
 }  // namespace optimized_ops
 }  // namespace tflite
 #endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
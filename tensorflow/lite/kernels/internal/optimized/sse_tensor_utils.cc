@@ -21,6 +21,12 @@ limitations under the License.
 #ifdef __SSE4_1__
 #include <smmintrin.h>  // SSE4.1
 #endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// AVX2 and AVX-512 VNNI code is compiled with target attributes and selected
+// at runtime.
+#define TFLITE_X86_RUNTIME_DISPATCH
+#include <immintrin.h>
+#endif
 
 #include <cstdint>
 
@@ -29,6 +35,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/cpu_backend_gemm.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 
 namespace tflite {
 namespace tensor_utils {
@@ -91,6 +98,138 @@ float GetFloatVectorElement(__m128 v) {
   return _mm_cvtss_f32(v);
 }
 
+// Returns the dot product of the `m_cols` int8 values of `row_ptr` and
+// `vectors`.
+int32_t SseDotProdInt8(const int8_t* __restrict__ row_ptr,
+                       const int8_t* __restrict__ vectors, int m_cols) {
+  // Initialize the dot product sum for the row to 0.
+  __m128i dotprod_32x4 = _mm_setzero_si128();
+  std::intptr_t col = 0;
+  // For every block of 16x 8-bit inputs.
+  while (col < (m_cols & ~15)) {
+    const __m128i vec_8x16 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(vectors + col));
+    const __m128i row_8x16 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_ptr + col));
+    // dotprod += vec · row
+    dotprod_32x4 =
+        _mm_add_epi32(dotprod_32x4, DotProdInt8x4x4(vec_8x16, row_8x16));
+    col += 16;
+  }
+#ifdef __SSE4_1__
+  // Postamble for 8x 8-bit inputs.
+  if (col < (m_cols & ~7)) {
+    const __m128i vec_16x8 = _mm_cvtepi8_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vectors + col)));
+    const __m128i row_16x8 = _mm_cvtepi8_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row_ptr + col)));
+    // dotprod += vec · row
+    dotprod_32x4 =
+        _mm_add_epi32(dotprod_32x4, _mm_madd_epi16(vec_16x8, row_16x8));
+    col += 8;
+  }
+  // Postamble for 4x 8-bit inputs.
+  if (col < (m_cols & ~3)) {
+    const __m128i vec_32x4 = _mm_cvtepi8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vectors + col)));
+    const __m128i row_32x4 = _mm_cvtepi8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row_ptr + col)));
+    // dotprod += vec · row
+    dotprod_32x4 =
+        _mm_add_epi32(dotprod_32x4, _mm_mullo_epi32(vec_32x4, row_32x4));
+    col += 4;
+  }
+#endif
+
+  // Horizontally add the 4 intermediate sum values to get the final
+  // dot-prod value for this row.
+  int32_t sum = ReduceInt32x4(dotprod_32x4);
+
+#if defined(__SSE4_1__) && defined(__clang__)
+  // SSE 4.1: Don't try to unroll and vectorize this, already done above.
+#pragma clang loop unroll(disable) vectorize(disable)
+#endif
+  // Postamble loop for <4x (<16x without SSE 4.1) remaining 8-bit inputs.
+  for (; col < m_cols; ++col) {
+    sum += row_ptr[col] * vectors[col];
+  }  // for col
+  return sum;
+}
+
+#ifdef TFLITE_X86_RUNTIME_DISPATCH
+
+// AVX2 version of SseDotProdInt8, for blocks of 32x 8-bit inputs. The
+// function is compiled for AVX2 regardless of the compiler flags, and is only
+// called if the CPU supports it.
+__attribute__((target("avx2"))) int32_t Avx2DotProdInt8(
+    const int8_t* __restrict__ row_ptr, const int8_t* __restrict__ vectors,
+    int m_cols) {
+  __m256i dotprod_32x8 = _mm256_setzero_si256();
+  std::intptr_t col = 0;
+  for (; col < (m_cols & ~31); col += 32) {
+    const __m256i vec_8x32 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vectors + col));
+    const __m256i row_8x32 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_ptr + col));
+    // Transfer sign from 'vec' to 'row', as _mm256_maddubs_epi16 treats its
+    // first operand unsigned.
+    const __m256i sumprod_16x16 = _mm256_maddubs_epi16(
+        _mm256_abs_epi8(vec_8x32), _mm256_sign_epi8(row_8x32, vec_8x32));
+    dotprod_32x8 = _mm256_add_epi32(
+        dotprod_32x8, _mm256_madd_epi16(sumprod_16x16, _mm256_set1_epi16(1)));
+  }
+  const __m128i dotprod_32x4 =
+      _mm_add_epi32(_mm256_castsi256_si128(dotprod_32x8),
+                    _mm256_extracti128_si256(dotprod_32x8, 1));
+  return ReduceInt32x4(dotprod_32x4) +
+         SseDotProdInt8(row_ptr + col, vectors + col, m_cols - col);
+}
+
+// Same as Avx2DotProdInt8, but with the AVX-512 VNNI vpdpbusd instruction,
+// which fuses the multiplies and the accumulation, and does not saturate the
+// intermediate int16 sums.
+__attribute__((target("avx2,avx512f,avx512vl,avx512vnni"))) int32_t
+Avx512VnniDotProdInt8(const int8_t* __restrict__ row_ptr,
+                      const int8_t* __restrict__ vectors, int m_cols) {
+  __m256i dotprod_32x8 = _mm256_setzero_si256();
+  std::intptr_t col = 0;
+  for (; col < (m_cols & ~31); col += 32) {
+    const __m256i vec_8x32 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vectors + col));
+    const __m256i row_8x32 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_ptr + col));
+    dotprod_32x8 = _mm256_dpbusd_epi32(dotprod_32x8, _mm256_abs_epi8(vec_8x32),
+                                       _mm256_sign_epi8(row_8x32, vec_8x32));
+  }
+  const __m128i dotprod_32x4 =
+      _mm_add_epi32(_mm256_castsi256_si128(dotprod_32x8),
+                    _mm256_extracti128_si256(dotprod_32x8, 1));
+  return ReduceInt32x4(dotprod_32x4) +
+         SseDotProdInt8(row_ptr + col, vectors + col, m_cols - col);
+}
+
+#endif  // TFLITE_X86_RUNTIME_DISPATCH
+
+using DotProdInt8Fn = int32_t (*)(const int8_t*, const int8_t*, int);
+
+// Returns the fastest dot product supported by the CPU.
+DotProdInt8Fn GetDotProdInt8() {
+  static const DotProdInt8Fn dot_prod = []() -> DotProdInt8Fn {
+#ifdef TFLITE_X86_RUNTIME_DISPATCH
+    CpuFlags cpu_flags;
+    GetCpuFlags(&cpu_flags);
+    if (cpu_flags.avx512_vnni) {
+      return Avx512VnniDotProdInt8;
+    }
+    if (cpu_flags.avx2) {
+      return Avx2DotProdInt8;
+    }
+#endif
+    return SseDotProdInt8;
+  }();
+  return dot_prod;
+}
+
 }  // namespace
 
 void SseMatrixBatchVectorMultiplyAccumulateImpl(
@@ -99,6 +238,7 @@ void SseMatrixBatchVectorMultiplyAccumulateImpl(
     const float* __restrict__ scaling_factors, int n_batch,
     float* __restrict__ result, const float* per_channel_scale,
     const int32_t* input_offset, const int32_t* row_sums) {
+  const DotProdInt8Fn dot_prod = GetDotProdInt8();
   for (std::intptr_t batch = 0; batch < n_batch; ++batch) {
     const float batch_scaling_factor = scaling_factors[batch];
     const int32_t batch_offset = input_offset ? input_offset[batch] : 0;
@@ -111,57 +251,7 @@ void SseMatrixBatchVectorMultiplyAccumulateImpl(
                             : batch_scaling_factor;
       const int32_t row_offset =
           row_sums && batch_offset ? batch_offset * row_sums[row] : 0;
-      // Initialize the dot product sum for the row to 0.
-      __m128i dotprod_32x4 = _mm_setzero_si128();
-      std::intptr_t col = 0;
-      // For every block of 16x 8-bit inputs.
-      while (col < (m_cols & ~15)) {
-        const __m128i vec_8x16 =
-            _mm_loadu_si128(reinterpret_cast<const __m128i*>(vectors + col));
-        const __m128i row_8x16 =
-            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_ptr + col));
-        // dotprod += vec · row
-        dotprod_32x4 =
-            _mm_add_epi32(dotprod_32x4, DotProdInt8x4x4(vec_8x16, row_8x16));
-        col += 16;
-      }
-#ifdef __SSE4_1__
-      // Postamble for 8x 8-bit inputs.
-      if (col < (m_cols & ~7)) {
-        const __m128i vec_16x8 = _mm_cvtepi8_epi16(
-            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vectors + col)));
-        const __m128i row_16x8 = _mm_cvtepi8_epi16(
-            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row_ptr + col)));
-        // dotprod += vec · row
-        dotprod_32x4 =
-            _mm_add_epi32(dotprod_32x4, _mm_madd_epi16(vec_16x8, row_16x8));
-        col += 8;
-      }
-      // Postamble for 4x 8-bit inputs.
-      if (col < (m_cols & ~3)) {
-        const __m128i vec_32x4 = _mm_cvtepi8_epi32(
-            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vectors + col)));
-        const __m128i row_32x4 = _mm_cvtepi8_epi32(
-            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row_ptr + col)));
-        // dotprod += vec · row
-        dotprod_32x4 =
-            _mm_add_epi32(dotprod_32x4, _mm_mullo_epi32(vec_32x4, row_32x4));
-        col += 4;
-      }
-#endif
-
-      // Horizontally add the 4 intermediate sum values to get the final
-      // dot-prod value for this row.
-      int32_t sum = ReduceInt32x4(dotprod_32x4);
-
-#if defined(__SSE4_1__) && defined(__clang__)
-      // SSE 4.1: Don't try to unroll and vectorize this, already done above.
-#pragma clang loop unroll(disable) vectorize(disable)
-#endif
-      // Postamble loop for <4x (<16x without SSE 4.1) remaining 8-bit inputs.
-      for (; col < m_cols; ++col) {
-        sum += row_ptr[col] * vectors[col];
-      }  // for col
+      int32_t sum = dot_prod(row_ptr, vectors, m_cols);
       if (row_offset) {
         sum -= row_offset;
       }
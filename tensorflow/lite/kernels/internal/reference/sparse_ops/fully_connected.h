@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_SPARSE_OPS_FULLY_CONNECTED_H_
 
 #include "tensorflow/lite/kernels/internal/reference/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
 
 namespace tflite {
@@ -41,6 +42,27 @@ inline void FullyConnectedSparseWeight(
                  output_data);
 }
 
+// Int8 version of the above.
+inline void FullyConnectedSparseWeight(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data) {
+  std::vector<int> weights_shape_vector(weights_shape.DimensionsCount());
+  for (int i = 0; i < weights_shape.DimensionsCount(); i++) {
+    weights_shape_vector[i] = weights_shape.Dims(i);
+  }
+  tflite::optimize::sparsity::FormatConverter<int8_t> converter(
+      weights_shape_vector, sparsity);
+  converter.SparseToDense(weights_data);
+  const std::vector<int8_t> dense_weights_data = converter.GetData();
+  reference_integer_ops::FullyConnected(
+      params, input_shape, input_data, weights_shape,
+      dense_weights_data.data(), bias_shape, bias_data, output_shape,
+      output_data);
+}
+
 }  // namespace reference_ops
 }  // namespace tflite
 #endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_SPARSE_OPS_FULLY_CONNECTED_H_
@@ -1454,6 +1454,38 @@ TEST(uKernels, MatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
 }
 #endif  // __ANDROID__
 
+TEST(uKernels, MatrixBatchVectorMultiplyAccumulateSymmetricQuantizedLongRows) {
+  // 77 columns exercise the 32-block AVX2 code on x86 as well as the shorter
+  // SIMD blocks and the leftover postamble.
+  const int m_rows = 3, m_cols = 77, n_batch = 2;
+  std::vector<int8_t> matrix(m_rows * m_cols);
+  for (int i = 0; i < matrix.size(); ++i) {
+    matrix[i] = (i * 37) % 255 - 127;
+  }
+  std::vector<int8_t> vectors(n_batch * m_cols);
+  for (int i = 0; i < vectors.size(); ++i) {
+    vectors[i] = 127 - (i * 53) % 255;
+  }
+  const float scaling_factors[] = {1.0f, 0.5f};
+
+  std::vector<float> expected(n_batch * m_rows, 1.0f);
+  for (int b = 0; b < n_batch; ++b) {
+    for (int r = 0; r < m_rows; ++r) {
+      int32_t dot_prod = 0;
+      for (int c = 0; c < m_cols; ++c) {
+        dot_prod += matrix[r * m_cols + c] * vectors[b * m_cols + c];
+      }
+      expected[b * m_rows + r] += dot_prod * scaling_factors[b];
+    }
+  }
+
+  std::vector<float> result(n_batch * m_rows, 1.0f);
+  MatrixBatchVectorMultiplyAccumulate(matrix.data(), m_rows, m_cols,
+                                      vectors.data(), scaling_factors, n_batch,
+                                      result.data());
+  EXPECT_THAT(result, ElementsAreArray(ArrayFloatNear(expected)));
+}
+
 TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
   const int kRow = 4;
   const int kCol = 48;
@@ -0,0 +1,91 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/shared_weights_cache.h"
+
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <tuple>
+
+namespace tflite {
+namespace shared_weights_cache {
+namespace {
+
+struct Key {
+  const void* data;
+  size_t bytes;
+  std::string transformation;
+
+  bool operator<(const Key& other) const {
+    return std::tie(data, bytes, transformation) <
+           std::tie(other.data, other.bytes, other.transformation);
+  }
+};
+
+struct Cache {
+  std::mutex mu;
+  // Only holds weak references, so that buffers are freed along with the
+  // kernels using them.
+  std::map<Key, std::weak_ptr<const void>> buffers;
+};
+
+Cache* GetCache() {
+  static Cache* cache = new Cache;
+  return cache;
+}
+
+}  // namespace
+
+std::shared_ptr<const void> GetOrCreate(
+    const TfLiteTensor* weights, const char* transformation, size_t size,
+    const std::function<void(void*)>& transform) {
+  Key key{weights->data.raw_const, weights->bytes, transformation};
+  Cache* cache = GetCache();
+  // The transformation runs under the lock, so that interpreters preparing
+  // the same model concurrently don't compute it more than once.
+  std::lock_guard<std::mutex> lock(cache->mu);
+  auto it = cache->buffers.find(key);
+  if (it != cache->buffers.end()) {
+    if (std::shared_ptr<const void> buffer = it->second.lock()) {
+      return buffer;
+    }
+  }
+
+  // Drop the entries of the buffers that were freed since the last miss.
+  for (auto entry = cache->buffers.begin(); entry != cache->buffers.end();) {
+    entry = entry->second.expired() ? cache->buffers.erase(entry) : ++entry;
+  }
+
+  char* data = new char[size];
+  transform(data);
+  std::shared_ptr<const void> buffer(data, [](const void* data) {
+    delete[] static_cast<const char*>(data);
+  });
+  cache->buffers[std::move(key)] = buffer;
+  return buffer;
+}
+
+int NumCachedBuffers() {
+  Cache* cache = GetCache();
+  std::lock_guard<std::mutex> lock(cache->mu);
+  int num_buffers = 0;
+  for (const auto& entry : cache->buffers) {
+    if (!entry.second.expired()) ++num_buffers;
+  }
+  return num_buffers;
+}
+
+}  // namespace shared_weights_cache
+}  // namespace tflite
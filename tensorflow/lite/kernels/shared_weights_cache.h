@@ -0,0 +1,49 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_SHARED_WEIGHTS_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_SHARED_WEIGHTS_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace shared_weights_cache {
+
+// Returns `size` bytes computed by `transform` from the constant tensor
+// `weights`, e.g. the weights in the layout a kernel wants. All kernels of
+// the process asking for the same `transformation` of the same constant data
+// get the same buffer, which is freed when the last of them releases it.
+// `transform` is only called if no kernel holds the buffer.
+//
+// Interpreters built from the same FlatBufferModel share the memory of its
+// constant tensors, so they also share the transformed weights instead of
+// keeping a copy each.
+//
+// `weights` must be a kTfLiteMmapRo tensor, and its data must outlive the
+// returned buffer.
+std::shared_ptr<const void> GetOrCreate(
+    const TfLiteTensor* weights, const char* transformation, size_t size,
+    const std::function<void(void*)>& transform);
+
+// Returns the number of buffers currently held by kernels.
+int NumCachedBuffers();
+
+}  // namespace shared_weights_cache
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_SHARED_WEIGHTS_CACHE_H_
@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/shared_weights_cache.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace shared_weights_cache {
+namespace {
+
+TfLiteTensor ConstantTensor(const float* data, size_t num_elements) {
+  TfLiteTensor tensor = {};
+  tensor.type = kTfLiteFloat32;
+  tensor.allocation_type = kTfLiteMmapRo;
+  tensor.data.raw_const = reinterpret_cast<const char*>(data);
+  tensor.bytes = num_elements * sizeof(float);
+  return tensor;
+}
+
+std::shared_ptr<const void> Negate(const TfLiteTensor* tensor,
+                                   int* num_calls) {
+  return GetOrCreate(tensor, "negate", tensor->bytes,
+                     [tensor, num_calls](void* buffer) {
+                       ++*num_calls;
+                       const float* input = tensor->data.f;
+                       float* output = static_cast<float*>(buffer);
+                       for (size_t i = 0; i < tensor->bytes / sizeof(float);
+                            ++i) {
+                         output[i] = -input[i];
+                       }
+                     });
+}
+
+TEST(SharedWeightsCacheTest, SharesBuffersWhileHeld) {
+  const float weights[] = {1.0f, 2.0f, 3.0f};
+  // Two interpreters of the same model see the same constant data.
+  TfLiteTensor tensor1 = ConstantTensor(weights, 3);
+  TfLiteTensor tensor2 = ConstantTensor(weights, 3);
+  const int num_buffers = NumCachedBuffers();
+
+  int num_calls = 0;
+  std::shared_ptr<const void> buffer1 = Negate(&tensor1, &num_calls);
+  std::shared_ptr<const void> buffer2 = Negate(&tensor2, &num_calls);
+  EXPECT_EQ(num_calls, 1);
+  EXPECT_EQ(buffer1.get(), buffer2.get());
+  EXPECT_EQ(static_cast<const float*>(buffer1.get())[2], -3.0f);
+  EXPECT_EQ(NumCachedBuffers(), num_buffers + 1);
+
+  buffer1.reset();
+  buffer2.reset();
+  EXPECT_EQ(NumCachedBuffers(), num_buffers);
+  buffer1 = Negate(&tensor1, &num_calls);
+  EXPECT_EQ(num_calls, 2);
+}
+
+TEST(SharedWeightsCacheTest, SeparatesDataAndTransformations) {
+  const float weights[] = {1.0f, 2.0f, 3.0f, 4.0f};
+  TfLiteTensor tensor = ConstantTensor(weights, 4);
+  TfLiteTensor prefix = ConstantTensor(weights, 2);
+
+  int num_calls = 0;
+  std::shared_ptr<const void> negated = Negate(&tensor, &num_calls);
+  std::shared_ptr<const void> negated_prefix = Negate(&prefix, &num_calls);
+  std::shared_ptr<const void> copy =
+      GetOrCreate(&tensor, "copy", tensor.bytes, [&](void* buffer) {
+        ++num_calls;
+        std::copy(weights, weights + 4, static_cast<float*>(buffer));
+      });
+  EXPECT_EQ(num_calls, 3);
+  EXPECT_NE(negated.get(), negated_prefix.get());
+  EXPECT_NE(negated.get(), copy.get());
+  EXPECT_EQ(static_cast<const float*>(copy.get())[3], 4.0f);
+}
+
+}  // namespace
+}  // namespace shared_weights_cache
+}  // namespace tflite
@@ -400,6 +400,73 @@ TfLiteStatus CommitPlan(ErrorReporter* error_reporter, MemoryPlanner* planner,
   }
   return kTfLiteOk;
 }
+
+// Returns true if the offline memory plan of the model has an offset for every
+// buffer that needs allocating, in which case no online planning is needed.
+bool IsFullyOfflinePlanned(const AllocationInfo* allocation_info,
+                           size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating &&
+        current->offline_offset == kOnlinePlannedBuffer) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Verifies the offline memory plan of a fully offline planned model and sets
+// the buffer pointers from it, without running the GreedyMemoryPlanner and
+// allocating its scratch memory. Offline planned buffers may deliberately
+// share memory, so only the bounds of each buffer are checked. Like the
+// GreedyMemoryPlanner, offsets that are not multiples of kBufferAlignment are
+// accepted as given. The size of the head section needed by the plan is
+// stored in head_usage.
+TfLiteStatus CommitOfflinePlan(ErrorReporter* error_reporter,
+                               uint8_t* starting_point,
+                               size_t available_arena_size,
+                               const AllocationInfo* allocation_info,
+                               size_t allocation_info_size,
+                               size_t* head_usage) {
+  size_t plan_size = 0;
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (!current->needs_allocating) {
+      continue;
+    }
+    if (current->offline_offset < 0) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Offline planned offset %d of buffer %d is "
+                           "negative.",
+                           current->offline_offset, i);
+      return kTfLiteError;
+    }
+    const size_t end = current->offline_offset +
+                       AlignSizeUp(current->bytes, kBufferAlignment);
+    if (end > plan_size) {
+      plan_size = end;
+    }
+  }
+
+  if (plan_size > available_arena_size) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter,
+        "Arena size is too small for the offline planned buffers. Needed %u "
+        "but only %u was available.",
+        plan_size, available_arena_size);
+    return kTfLiteError;
+  }
+
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->needs_allocating) {
+      *current->output_ptr =
+          reinterpret_cast<void*>(starting_point + current->offline_offset);
+    }
+  }
+  *head_usage = plan_size;
+  return kTfLiteOk;
+}
 }  // namespace
 
 namespace internal {
@@ -1028,6 +1095,8 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   // 2. Add them into the planner (such as the GreedyMemoryPlanner).
   // 3. Static memory planning using the planner.
   // 4. Set tensor/buffer pointers based on the offsets from the previous step.
+  // Models whose offline memory plan covers every buffer skip steps 2 and 3:
+  // their offsets are only verified before being committed.
   // Note that AllocationInfo is only needed for creating the plan. It will be
   // thrown away when the child allocator (tmp_allocator) goes out of scope.
   {
@@ -1049,33 +1118,42 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
     TF_LITE_ENSURE_STATUS(builder.AddScratchBuffers(scratch_buffer_handles_));
     const AllocationInfo* allocation_info = builder.Finish();
 
-    // Remaining arena size that memory planner can use for calculating offsets.
-    size_t remaining_arena_size =
-        tmp_allocator.GetAvailableMemory(kBufferAlignment);
-    uint8_t* planner_arena =
-        tmp_allocator.AllocateTemp(remaining_arena_size, kBufferAlignment);
-    TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
-    GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
-    TF_LITE_ENSURE_STATUS(
-        CreatePlan(error_reporter_, &planner, allocation_info, builder.Size()));
-
     size_t actual_available_arena_size =
         memory_allocator_->GetAvailableMemory(kBufferAlignment);
 
-    // Make sure we have enough arena size.
-    if (planner.GetMaximumMemorySize() > actual_available_arena_size) {
-      TF_LITE_REPORT_ERROR(
-          error_reporter_,
-          "Arena size is too small for all buffers. Needed %u but only "
-          "%u was available.",
-          planner.GetMaximumMemorySize(), actual_available_arena_size);
-      return kTfLiteError;
+    if (IsFullyOfflinePlanned(allocation_info, builder.Size())) {
+      // A complete offline plan only needs to be verified.
+      TF_LITE_ENSURE_STATUS(CommitOfflinePlan(
+          error_reporter_, memory_allocator_->GetBufferHead(),
+          actual_available_arena_size, allocation_info, builder.Size(),
+          &head_usage));
+    } else {
+      // Remaining arena size that memory planner can use for calculating
+      // offsets.
+      size_t remaining_arena_size =
+          tmp_allocator.GetAvailableMemory(kBufferAlignment);
+      uint8_t* planner_arena =
+          tmp_allocator.AllocateTemp(remaining_arena_size, kBufferAlignment);
+      TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
+      GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
+      TF_LITE_ENSURE_STATUS(CreatePlan(error_reporter_, &planner,
+                                       allocation_info, builder.Size()));
+
+      // Make sure we have enough arena size.
+      if (planner.GetMaximumMemorySize() > actual_available_arena_size) {
+        TF_LITE_REPORT_ERROR(
+            error_reporter_,
+            "Arena size is too small for all buffers. Needed %u but only "
+            "%u was available.",
+            planner.GetMaximumMemorySize(), actual_available_arena_size);
+        return kTfLiteError;
+      }
+      // Commit the plan.
+      TF_LITE_ENSURE_STATUS(CommitPlan(error_reporter_, &planner,
+                                       memory_allocator_->GetBufferHead(),
+                                       allocation_info, builder.Size()));
+      head_usage = planner.GetMaximumMemorySize();
     }
-    // Commit the plan.
-    TF_LITE_ENSURE_STATUS(CommitPlan(error_reporter_, &planner,
-                                     memory_allocator_->GetBufferHead(),
-                                     allocation_info, builder.Size()));
-    head_usage = planner.GetMaximumMemorySize();
   }
 
   TF_LITE_ENSURE_STATUS(
@@ -242,6 +242,38 @@ class NnApiHandler {
         [](ANeuralNetworksExecution* execution) { return Value; };
   }
 
+  template <int Value>
+  void BurstCreateReturns() {
+    nnapi_->ANeuralNetworksBurst_create =
+        [](ANeuralNetworksCompilation* compilation,
+           ANeuralNetworksBurst** burst) {
+          *burst = reinterpret_cast<ANeuralNetworksBurst*>(5);
+          return Value;
+        };
+  }
+
+  void StubExecutionBurstComputeWith(
+      int(stub)(ANeuralNetworksExecution* execution,
+                ANeuralNetworksBurst* burst)) {
+    nnapi_->ANeuralNetworksExecution_burstCompute = stub;
+  }
+
+  void StubExecutionComputeWith(int(stub)(ANeuralNetworksExecution*)) {
+    nnapi_->ANeuralNetworksExecution_compute = stub;
+  }
+
+  void StubExecutionStartComputeWithDependenciesWith(
+      int(stub)(ANeuralNetworksExecution* execution,
+                const ANeuralNetworksEvent* const* dependencies,
+                uint32_t num_dependencies, uint64_t duration,
+                ANeuralNetworksEvent** event)) {
+    nnapi_->ANeuralNetworksExecution_startComputeWithDependencies = stub;
+  }
+
+  void StubEventWaitWith(int(stub)(ANeuralNetworksEvent* event)) {
+    nnapi_->ANeuralNetworksEvent_wait = stub;
+  }
+
   template <int Value>
   void GetSupportedOperationsForDevicesReturns() {
     nnapi_->ANeuralNetworksModel_getSupportedOperationsForDevices =
@@ -0,0 +1,132 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/latency_histogram_profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+// Handle returned for the events that are not timed.
+constexpr uint32_t kUntimedEventHandle = 0;
+
+int BucketIndex(uint64_t latency_us) {
+  int index = 0;
+  while (latency_us != 0 && index < OpLatencyStats::kNumBuckets - 1) {
+    latency_us >>= 1;
+    ++index;
+  }
+  return index;
+}
+
+}  // namespace
+
+uint64_t OpLatencyStats::PercentileUpperBoundUs(double percentile) const {
+  if (num_samples == 0) return 0;
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100 * num_samples)));
+  uint64_t count = 0;
+  for (int i = 0; i < kNumBuckets - 1; ++i) {
+    count += buckets[i];
+    if (count >= rank) {
+      return std::min(max_us, i == 0 ? 0 : (uint64_t{1} << i) - 1);
+    }
+  }
+  return max_us;
+}
+
+LatencyHistogramProfiler::LatencyHistogramProfiler(int num_nodes,
+                                                   int sampling_period)
+    : num_nodes_(std::max(num_nodes, 0)),
+      sampling_period_(std::max(sampling_period, 1)),
+      nodes_(new NodeStats[num_nodes_]) {
+  Reset();
+}
+
+uint32_t LatencyHistogramProfiler::BeginEvent(const char* tag,
+                                              EventType event_type,
+                                              int64_t event_metadata1,
+                                              int64_t event_metadata2) {
+  // Only the operators of the primary subgraph run by the interpreter are
+  // tracked, as identified by their node index in event_metadata1 and their
+  // subgraph index in event_metadata2.
+  if (event_type != EventType::OPERATOR_INVOKE_EVENT || event_metadata2 != 0 ||
+      event_metadata1 < 0 || event_metadata1 >= num_nodes_) {
+    return kUntimedEventHandle;
+  }
+  NodeStats& node = nodes_[event_metadata1];
+  const uint64_t run = node.num_runs.fetch_add(1, std::memory_order_relaxed);
+  if (run % sampling_period_ != 0) return kUntimedEventHandle;
+  node.tag.store(tag, std::memory_order_relaxed);
+  node.begin_us = time::NowMicros();
+  return static_cast<uint32_t>(event_metadata1) + 1;
+}
+
+void LatencyHistogramProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == kUntimedEventHandle ||
+      event_handle > static_cast<uint32_t>(num_nodes_)) {
+    return;
+  }
+  NodeStats& node = nodes_[event_handle - 1];
+  const uint64_t end_us = time::NowMicros();
+  const uint64_t latency_us =
+      end_us > node.begin_us ? end_us - node.begin_us : 0;
+  node.buckets[BucketIndex(latency_us)].fetch_add(1, std::memory_order_relaxed);
+  node.total_us.fetch_add(latency_us, std::memory_order_relaxed);
+  uint64_t max_us = node.max_us.load(std::memory_order_relaxed);
+  while (latency_us > max_us &&
+         !node.max_us.compare_exchange_weak(max_us, latency_us,
+                                            std::memory_order_relaxed)) {
+  }
+  node.num_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+OpLatencyStats LatencyHistogramProfiler::GetStats(int node_index,
+                                                  const char** tag) const {
+  OpLatencyStats stats;
+  if (node_index < 0 || node_index >= num_nodes_) return stats;
+  const NodeStats& node = nodes_[node_index];
+  // The counters are read one at a time while samples may be recorded, so the
+  // statistics of a sample being recorded may be partially included.
+  stats.num_runs = node.num_runs.load(std::memory_order_relaxed);
+  stats.num_samples = node.num_samples.load(std::memory_order_relaxed);
+  stats.total_us = node.total_us.load(std::memory_order_relaxed);
+  stats.max_us = node.max_us.load(std::memory_order_relaxed);
+  for (int i = 0; i < OpLatencyStats::kNumBuckets; ++i) {
+    stats.buckets[i] = node.buckets[i].load(std::memory_order_relaxed);
+  }
+  if (tag != nullptr) *tag = node.tag.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void LatencyHistogramProfiler::Reset() {
+  for (int n = 0; n < num_nodes_; ++n) {
+    NodeStats& node = nodes_[n];
+    node.num_runs.store(0, std::memory_order_relaxed);
+    node.num_samples.store(0, std::memory_order_relaxed);
+    node.total_us.store(0, std::memory_order_relaxed);
+    node.max_us.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < OpLatencyStats::kNumBuckets; ++i) {
+      node.buckets[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,104 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_LATENCY_HISTOGRAM_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_LATENCY_HISTOGRAM_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// The latency statistics of one operator, as aggregated by a
+// LatencyHistogramProfiler.
+struct OpLatencyStats {
+  // Latencies are bucketed by powers of two: bucket 0 counts latencies of 0us
+  // and bucket i > 0 those in [2^(i-1), 2^i) us. The last bucket also counts
+  // everything above.
+  static constexpr int kNumBuckets = 32;
+
+  // The number of times the operator ran, and the number of these runs that
+  // were timed.
+  uint64_t num_runs = 0;
+  uint64_t num_samples = 0;
+  uint64_t total_us = 0;
+  uint64_t max_us = 0;
+  uint64_t buckets[kNumBuckets] = {};
+
+  double mean_us() const {
+    return num_samples == 0 ? 0 : static_cast<double>(total_us) / num_samples;
+  }
+
+  // Returns an upper bound of the given percentile (in [0, 100]) of the
+  // sampled latencies, at the resolution of the buckets.
+  uint64_t PercentileUpperBoundUs(double percentile) const;
+};
+
+// A profiler meant to stay enabled in production: rather than recording every
+// event like BufferedProfiler, it aggregates the latency of every operator of
+// the primary subgraph into a fixed-size histogram, timing one out of every
+// `sampling_period` runs of each operator. Memory use does not grow with the
+// number of invocations, and recording a sample is a handful of relaxed
+// atomic operations, without locks or allocations.
+//
+// The statistics can be read with GetStats() from any thread while the
+// interpreter runs. A profiler must be attached to a single interpreter, as
+// set by Interpreter::SetProfiler().
+class LatencyHistogramProfiler : public tflite::Profiler {
+ public:
+  // `num_nodes` is the number of nodes in the execution plan of the primary
+  // subgraph; operators with a larger index are ignored.
+  explicit LatencyHistogramProfiler(int num_nodes, int sampling_period = 1);
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+
+  void EndEvent(uint32_t event_handle) override;
+
+  int num_nodes() const { return num_nodes_; }
+
+  // Returns the statistics of the operator at `node_index` so far, and its
+  // name in `tag` if not null and the operator was sampled at least once.
+  OpLatencyStats GetStats(int node_index, const char** tag = nullptr) const;
+
+  // Clears the statistics of all operators.
+  void Reset();
+
+ private:
+  struct NodeStats {
+    std::atomic<const char*> tag{nullptr};
+    std::atomic<uint64_t> num_runs{0};
+    std::atomic<uint64_t> num_samples{0};
+    std::atomic<uint64_t> total_us{0};
+    std::atomic<uint64_t> max_us{0};
+    std::atomic<uint64_t> buckets[OpLatencyStats::kNumBuckets];
+    // The start time of the run being timed, only accessed by the thread
+    // running the operator.
+    uint64_t begin_us = 0;
+  };
+
+  const int num_nodes_;
+  const uint64_t sampling_period_;
+  std::unique_ptr<NodeStats[]> nodes_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_LATENCY_HISTOGRAM_PROFILER_H_
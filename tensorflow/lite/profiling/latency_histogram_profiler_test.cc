@@ -0,0 +1,123 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/latency_histogram_profiler.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+void RunOp(tflite::Profiler* profiler, const char* tag, int node_index,
+           int sleep_ms) {
+  ScopedOperatorProfile profile(profiler, tag, node_index);
+  std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+}
+
+TEST(LatencyHistogramProfilerTest, AggregatesLatenciesPerOp) {
+  LatencyHistogramProfiler profiler(2);
+  for (int i = 0; i < 3; ++i) {
+    RunOp(&profiler, "CONV_2D", 0, 0);
+    RunOp(&profiler, "ADD", 1, 10);
+  }
+
+  const char* tag = nullptr;
+  OpLatencyStats stats = profiler.GetStats(1, &tag);
+  EXPECT_STREQ(tag, "ADD");
+  EXPECT_EQ(stats.num_runs, 3);
+  EXPECT_EQ(stats.num_samples, 3);
+  EXPECT_GE(stats.total_us, 30000);
+  EXPECT_GE(stats.max_us, 10000);
+  EXPECT_GE(stats.mean_us(), 10000);
+  EXPECT_GE(stats.PercentileUpperBoundUs(50), 10000);
+  EXPECT_LE(stats.PercentileUpperBoundUs(50), stats.max_us);
+  uint64_t num_bucketed = 0;
+  for (uint64_t count : stats.buckets) num_bucketed += count;
+  EXPECT_EQ(num_bucketed, 3);
+
+  EXPECT_EQ(profiler.GetStats(0).num_samples, 3);
+  EXPECT_LT(profiler.GetStats(0).max_us, stats.max_us);
+}
+
+TEST(LatencyHistogramProfilerTest, SamplesOneRunInPeriod) {
+  LatencyHistogramProfiler profiler(1, /*sampling_period=*/4);
+  for (int i = 0; i < 10; ++i) {
+    RunOp(&profiler, "ADD", 0, 0);
+  }
+  OpLatencyStats stats = profiler.GetStats(0);
+  EXPECT_EQ(stats.num_runs, 10);
+  EXPECT_EQ(stats.num_samples, 3);
+}
+
+TEST(LatencyHistogramProfilerTest, IgnoresOtherEvents) {
+  LatencyHistogramProfiler profiler(1);
+  {
+    ScopedProfile profile(&profiler, "Invoke");
+  }
+  {
+    ScopedDelegateOperatorProfile profile(&profiler, "Delegate", 0);
+  }
+  // An operator of another subgraph.
+  profiler.EndEvent(profiler.BeginEvent(
+      "ADD", Profiler::EventType::OPERATOR_INVOKE_EVENT, 0, 1));
+  // An operator beyond the number of nodes.
+  RunOp(&profiler, "ADD", 1, 0);
+  EXPECT_EQ(profiler.GetStats(0).num_runs, 0);
+  EXPECT_EQ(profiler.GetStats(1).num_runs, 0);
+}
+
+TEST(LatencyHistogramProfilerTest, Reset) {
+  LatencyHistogramProfiler profiler(1);
+  RunOp(&profiler, "ADD", 0, 1);
+  profiler.Reset();
+  OpLatencyStats stats = profiler.GetStats(0);
+  EXPECT_EQ(stats.num_runs, 0);
+  EXPECT_EQ(stats.num_samples, 0);
+  EXPECT_EQ(stats.max_us, 0);
+  EXPECT_EQ(stats.PercentileUpperBoundUs(99), 0);
+}
+
+TEST(LatencyHistogramProfilerTest, PercentileUpperBound) {
+  OpLatencyStats stats;
+  stats.num_samples = 4;
+  stats.max_us = 100;
+  stats.buckets[2] = 3;  // [2, 4) us.
+  stats.buckets[7] = 1;  // [64, 128) us.
+  EXPECT_EQ(stats.PercentileUpperBoundUs(50), 3);
+  EXPECT_EQ(stats.PercentileUpperBoundUs(75), 3);
+  EXPECT_EQ(stats.PercentileUpperBoundUs(100), 100);
+}
+
+TEST(LatencyHistogramProfilerTest, StatsCanBeReadWhileRecording) {
+  LatencyHistogramProfiler profiler(1);
+  std::thread runner([&profiler] {
+    for (int i = 0; i < 1000; ++i) RunOp(&profiler, "ADD", 0, 0);
+  });
+  uint64_t num_samples = 0;
+  while (num_samples < 1000) {
+    OpLatencyStats stats = profiler.GetStats(0);
+    EXPECT_GE(stats.num_samples, num_samples);
+    num_samples = stats.num_samples;
+  }
+  runner.join();
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
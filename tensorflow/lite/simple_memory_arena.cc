@@ -104,6 +104,23 @@ TfLiteStatus SimpleMemoryArena::Deallocate(
   return kTfLiteOk;
 }
 
+TfLiteStatus SimpleMemoryArena::RestorePlan(
+    TfLiteContext* context,
+    const std::vector<ArenaAllocWithUsageInterval>& allocs) {
+  committed_ = false;
+  high_water_mark_ = 0;
+  ordered_allocs_.clear();
+  for (const auto& alloc : allocs) {
+    if (alloc.size == 0) {
+      continue;
+    }
+    high_water_mark_ = std::max(high_water_mark_, alloc.offset + alloc.size);
+    ordered_allocs_.push_back(alloc);
+  }
+  std::stable_sort(ordered_allocs_.begin(), ordered_allocs_.end());
+  return kTfLiteOk;
+}
+
 TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
   size_t required_size = RequiredBufferSize();
   if (required_size > underlying_buffer_size_) {
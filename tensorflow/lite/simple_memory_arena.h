@@ -76,6 +76,14 @@ class SimpleMemoryArena {
   TfLiteStatus Deallocate(TfLiteContext* context,
                           const ArenaAllocWithUsageInterval& alloc);
 
+  // Replaces the allocation plan with `allocs`, which were all scheduled by
+  // Allocate() after a ClearPlan() on an arena with the same alignment. The
+  // arena is then in the same state as after scheduling them again, but
+  // without searching for their offsets.
+  TfLiteStatus RestorePlan(
+      TfLiteContext* context,
+      const std::vector<ArenaAllocWithUsageInterval>& allocs);
+
   inline size_t RequiredBufferSize() {
     // Add in a small amount of padding to reduce the chance of resize events
     // for small allocations.
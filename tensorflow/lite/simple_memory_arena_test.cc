@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/simple_memory_arena.h"
 
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "tensorflow/core/platform/logging.h"
@@ -44,6 +46,28 @@ TEST(SimpleMemoryArenaTest, BasicArenaOperations) {
   EXPECT_EQ(allocs[5].offset, 2048);
 }
 
+TEST(SimpleMemoryArenaTest, RestorePlan) {
+  TfLiteContext context;
+  SimpleMemoryArena arena(64);
+  std::vector<ArenaAllocWithUsageInterval> allocs(3);
+
+  arena.Allocate(&context, 32, 2047, 0, 1, 3, &allocs[0]);
+  arena.Allocate(&context, 32, 2047, 1, 2, 5, &allocs[1]);
+  arena.Allocate(&context, 32, 0, 2, 2, 5, &allocs[2]);
+  const size_t required_size = arena.RequiredBufferSize();
+
+  // Restoring the plan after clearing it leaves the same gaps to fill.
+  ASSERT_EQ(arena.ClearPlan(), kTfLiteOk);
+  ASSERT_EQ(arena.RestorePlan(&context, allocs), kTfLiteOk);
+  EXPECT_EQ(arena.RequiredBufferSize(), required_size);
+
+  ArenaAllocWithUsageInterval alloc;
+  arena.Allocate(&context, 32, 2047, 3, 4, 6, &alloc);
+  EXPECT_EQ(alloc.offset, 0);
+  arena.Allocate(&context, 32, 2047, 4, 3, 6, &alloc);
+  EXPECT_EQ(alloc.offset, 4096);
+}
+
 TEST(SimpleMemoryArenaTest, BasicZeroAlloc) {
   TfLiteContext context;
   SimpleMemoryArena arena(64);
@@ -40,6 +40,10 @@ BenchmarkParams BenchmarkModel::DefaultParams() {
   params.AddParam("warmup_runs", BenchmarkParam::Create<int32_t>(1));
   params.AddParam("warmup_min_secs", BenchmarkParam::Create<float>(0.5f));
   params.AddParam("verbose", BenchmarkParam::Create<bool>(false));
+  params.AddParam("load_num_workers", BenchmarkParam::Create<int32_t>(0));
+  params.AddParam("load_target_qps", BenchmarkParam::Create<float>(0.0f));
+  params.AddParam("load_poisson_arrivals", BenchmarkParam::Create<bool>(true));
+  params.AddParam("load_duration_secs", BenchmarkParam::Create<float>(10.0f));
   return params;
 }
 
@@ -67,6 +71,43 @@ void BenchmarkLoggingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                    << " overall=" << overall_mem_usage.max_rss_kb / 1024.0;
 }
 
+void BenchmarkLoggingListener::OnLoadTestEnd(const LoadTestResults& results) {
+  const LoadGeneratorOptions& options = results.options;
+  std::stringstream mode;
+  if (options.target_qps > 0) {
+    mode << "open loop at " << options.target_qps << " QPS ("
+         << (options.poisson_arrivals ? "Poisson" : "constant-rate")
+         << " arrivals)";
+  } else {
+    mode << "closed loop";
+  }
+  TFLITE_LOG(INFO) << "Load test with " << options.num_workers << " workers, "
+                   << mode.str() << ": " << results.num_completed
+                   << " requests completed, " << results.num_failed
+                   << " failed and " << results.num_backlogged
+                   << " backlogged in " << results.elapsed_secs << "s.";
+  TFLITE_LOG(INFO) << "Throughput (QPS): " << results.throughput_qps();
+  TFLITE_LOG(INFO) << "Latency in us: "
+                   << "avg=" << results.avg_latency_us << ", "
+                   << "p50=" << results.p50_latency_us << ", "
+                   << "p90=" << results.p90_latency_us << ", "
+                   << "p99=" << results.p99_latency_us << ", "
+                   << "p99.9=" << results.p999_latency_us << ", "
+                   << "max=" << results.max_latency_us;
+  if (results.cpu_utilization >= 0) {
+    std::stringstream cpus;
+    if (results.num_cpus > 0) {
+      cpus << " (" << 100.0 * results.cpu_utilization / results.num_cpus
+           << "% of " << results.num_cpus << " CPUs)";
+    }
+    TFLITE_LOG(INFO) << "CPU utilization (busy cores): "
+                     << results.cpu_utilization << cpus.str();
+  }
+  if (!results.mem_usage.IsSupported()) return;
+  TFLITE_LOG(INFO) << "Peak memory footprint of the process (MB): "
+                   << results.mem_usage.max_rss_kb / 1024.0;
+}
+
 std::vector<Flag> BenchmarkModel::GetFlags() {
   return {
       CreateFlag<int32_t>(
@@ -105,6 +146,23 @@ std::vector<Flag> BenchmarkModel::GetFlags() {
                        "Whether to log parameters whose values are not set. "
                        "By default, only log those parameters that are set by "
                        "parsing their values from the commandline flags."),
+      CreateFlag<int32_t>(
+          "load_num_workers", &params_,
+          "If positive, run a load test after the regular benchmark runs, "
+          "with this number of workers serving requests concurrently. Each "
+          "worker has its own instance of the model, e.g. a TFLite "
+          "interpreter, and its own delegates."),
+      CreateFlag<float>(
+          "load_target_qps", &params_,
+          "Rate of requests per second issued in the load test independently "
+          "of their completion (open loop). If not positive, each worker "
+          "issues its next request as soon as the previous one completes "
+          "(closed loop)."),
+      CreateFlag<bool>("load_poisson_arrivals", &params_,
+                       "Whether open-loop requests of the load test arrive as "
+                       "a Poisson process rather than at a constant rate."),
+      CreateFlag<float>("load_duration_secs", &params_,
+                        "duration of the load test in seconds"),
   };
 }
 
@@ -125,12 +183,51 @@ void BenchmarkModel::LogParams() {
   LOG_BENCHMARK_PARAM(int32_t, "warmup_runs", "Min warmup runs", verbose);
   LOG_BENCHMARK_PARAM(float, "warmup_min_secs",
                       "Min warmup runs duration (seconds)", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "load_num_workers", "Load test workers",
+                      verbose);
+  LOG_BENCHMARK_PARAM(float, "load_target_qps", "Load test target QPS",
+                      verbose);
+  LOG_BENCHMARK_PARAM(bool, "load_poisson_arrivals",
+                      "Load test Poisson arrivals", verbose);
+  LOG_BENCHMARK_PARAM(float, "load_duration_secs",
+                      "Load test duration (seconds)", verbose);
 }
 
 TfLiteStatus BenchmarkModel::PrepareInputData() { return kTfLiteOk; }
 
 TfLiteStatus BenchmarkModel::ResetInputsAndOutputs() { return kTfLiteOk; }
 
+TfLiteStatus BenchmarkModel::PrepareLoadWorkers(int num_workers) {
+  TFLITE_LOG(ERROR) << "Load tests are not supported by this benchmark.";
+  return kTfLiteError;
+}
+
+TfLiteStatus BenchmarkModel::RunLoadRequest(int worker_index) {
+  return kTfLiteError;
+}
+
+TfLiteStatus BenchmarkModel::RunLoadTest() {
+  LoadGeneratorOptions options;
+  options.num_workers = params_.Get<int32_t>("load_num_workers");
+  options.target_qps = params_.Get<float>("load_target_qps");
+  options.poisson_arrivals = params_.Get<bool>("load_poisson_arrivals");
+  options.duration_secs = params_.Get<float>("load_duration_secs");
+
+  TFLITE_LOG(INFO) << "Preparing " << options.num_workers
+                   << " workers for the load test.";
+  TfLiteStatus status = PrepareLoadWorkers(options.num_workers);
+  if (status == kTfLiteOk) {
+    TFLITE_LOG(INFO) << "Running load test for " << options.duration_secs
+                     << " seconds.";
+    const LoadTestResults results = LoadGenerator(options).Run(
+        [this](int worker_index) { return RunLoadRequest(worker_index); });
+    listeners_.OnLoadTestEnd(results);
+    if (results.num_failed > 0) status = kTfLiteError;
+  }
+  CleanUpLoadWorkers();
+  return status;
+}
+
 Stat<int64_t> BenchmarkModel::Run(int min_num_times, float min_secs,
                                   float max_secs, RunType run_type,
                                   TfLiteStatus* invoke_status) {
@@ -218,6 +315,9 @@ TfLiteStatus BenchmarkModel::Run() {
   listeners_.OnBenchmarkEnd({model_size_mb, startup_latency_us, input_bytes,
                              warmup_time_us, inference_time_us, init_mem_usage,
                              overall_mem_usage});
+  if (status == kTfLiteOk && params_.Get<int32_t>("load_num_workers") > 0) {
+    status = RunLoadTest();
+  }
   return status;
 }
 
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/profiling/memory_info.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_params.h"
+#include "tensorflow/lite/tools/benchmark/load_generator.h"
 #include "tensorflow/lite/tools/command_line_flags.h"
 
 namespace tflite {
@@ -97,6 +98,8 @@ class BenchmarkListener {
   virtual void OnSingleRunEnd() {}
   // Called after the (outer) inference loop begins.
   virtual void OnBenchmarkEnd(const BenchmarkResults& results) {}
+  // Called after the load test, if any, is done.
+  virtual void OnLoadTestEnd(const LoadTestResults& results) {}
   virtual ~BenchmarkListener() {}
 };
 
@@ -143,6 +146,12 @@ class BenchmarkListeners : public BenchmarkListener {
     }
   }
 
+  void OnLoadTestEnd(const LoadTestResults& results) override {
+    for (auto listener : listeners_) {
+      listener->OnLoadTestEnd(results);
+    }
+  }
+
   ~BenchmarkListeners() override {}
 
  private:
@@ -154,6 +163,7 @@ class BenchmarkListeners : public BenchmarkListener {
 class BenchmarkLoggingListener : public BenchmarkListener {
  public:
   void OnBenchmarkEnd(const BenchmarkResults& results) override;
+  void OnLoadTestEnd(const LoadTestResults& results) override;
 };
 
 template <typename T>
@@ -212,6 +222,20 @@ class BenchmarkModel {
 
   virtual TfLiteStatus ResetInputsAndOutputs();
   virtual TfLiteStatus RunImpl() = 0;
+
+  // Runs the load test enabled by --load_num_workers, after the regular
+  // benchmark runs.
+  TfLiteStatus RunLoadTest();
+  // Sets up 'num_workers' independent instances of the model, which serve
+  // load test requests concurrently. Subclasses supporting load tests need to
+  // override this and RunLoadRequest().
+  virtual TfLiteStatus PrepareLoadWorkers(int num_workers);
+  // Runs a single inference on the given worker. Called concurrently for
+  // different workers.
+  virtual TfLiteStatus RunLoadRequest(int worker_index);
+  // Releases the resources set up by PrepareLoadWorkers().
+  virtual void CleanUpLoadWorkers() {}
+
   BenchmarkParams params_;
   BenchmarkListeners listeners_;
 };
@@ -546,11 +546,16 @@ TfLiteStatus BenchmarkTfLiteModel::PrepareInputData() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
-  auto interpreter_inputs = interpreter_->inputs();
+  SetInputs(interpreter_.get());
+  return kTfLiteOk;
+}
+
+void BenchmarkTfLiteModel::SetInputs(Interpreter* interpreter) {
+  auto interpreter_inputs = interpreter->inputs();
   // Set the values of the input tensors from inputs_data_.
   for (int j = 0; j < interpreter_inputs.size(); ++j) {
     int i = interpreter_inputs[j];
-    TfLiteTensor* t = interpreter_->tensor(i);
+    TfLiteTensor* t = interpreter->tensor(i);
     if (t->type == kTfLiteString) {
       if (inputs_data_[j].data) {
         static_cast<DynamicBuffer*>(inputs_data_[j].data.get())
@@ -568,8 +573,6 @@ TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
                   inputs_data_[j].bytes);
     }
   }
-
-  return kTfLiteOk;
 }
 
 TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
@@ -681,27 +684,79 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
     }
   }
 
+  TF_LITE_ENSURE_STATUS(ResizeAndAllocateTensors(interpreter_.get()));
+
+  ruy_profiling_listener_.reset(new RuyProfileListener());
+  AddListener(ruy_profiling_listener_.get());
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkTfLiteModel::ResizeAndAllocateTensors(
+    Interpreter* interpreter) {
+  auto interpreter_inputs = interpreter->inputs();
   // Resize all non-string tensors.
   for (int j = 0; j < inputs_.size(); ++j) {
     const InputLayerInfo& input = inputs_[j];
     int i = interpreter_inputs[j];
-    TfLiteTensor* t = interpreter_->tensor(i);
+    TfLiteTensor* t = interpreter->tensor(i);
     if (t->type != kTfLiteString) {
-      interpreter_->ResizeInputTensor(i, input.shape);
+      interpreter->ResizeInputTensor(i, input.shape);
     }
   }
 
-  if (interpreter_->AllocateTensors() != kTfLiteOk) {
+  if (interpreter->AllocateTensors() != kTfLiteOk) {
     TFLITE_LOG(ERROR) << "Failed to allocate tensors!";
     return kTfLiteError;
   }
+  return kTfLiteOk;
+}
 
-  ruy_profiling_listener_.reset(new RuyProfileListener());
-  AddListener(ruy_profiling_listener_.get());
+TfLiteStatus BenchmarkTfLiteModel::PrepareLoadWorkers(int num_workers) {
+  auto resolver = GetOpResolver();
+  const int32_t num_threads = params_.Get<int32_t>("num_threads");
+  load_workers_.clear();
+  for (int w = 0; w < num_workers; ++w) {
+    std::unique_ptr<LoadWorker> worker(new LoadWorker);
+    tflite::InterpreterBuilder(*model_, *resolver)(&worker->interpreter,
+                                                   num_threads);
+    if (!worker->interpreter) {
+      TFLITE_LOG(ERROR) << "Failed to initialize the interpreter of load test "
+                        << "worker " << w;
+      return kTfLiteError;
+    }
+    worker->interpreter->SetAllowFp16PrecisionForFp32(
+        params_.Get<bool>("allow_fp16"));
+
+    // Delegate instances are generally not shareable between interpreters,
+    // so each worker gets its own.
+    for (const auto& delegate_provider :
+         tools::GetRegisteredDelegateProviders()) {
+      auto delegate = delegate_provider->CreateTfLiteDelegate(params_);
+      if (delegate == nullptr) continue;
+      if (worker->interpreter->ModifyGraphWithDelegate(delegate.get()) !=
+          kTfLiteOk) {
+        TFLITE_LOG(ERROR) << "Failed to apply " << delegate_provider->GetName()
+                          << " delegate to load test worker " << w;
+        return kTfLiteError;
+      }
+      worker->delegates.emplace_back(std::move(delegate));
+    }
 
+    TF_LITE_ENSURE_STATUS(ResizeAndAllocateTensors(worker->interpreter.get()));
+    // Inputs are set once, as the load test only measures inference.
+    SetInputs(worker->interpreter.get());
+    load_workers_.emplace_back(std::move(worker));
+  }
   return kTfLiteOk;
 }
 
+TfLiteStatus BenchmarkTfLiteModel::RunLoadRequest(int worker_index) {
+  return load_workers_[worker_index]->interpreter->Invoke();
+}
+
+void BenchmarkTfLiteModel::CleanUpLoadWorkers() { load_workers_.clear(); }
+
 TfLiteStatus BenchmarkTfLiteModel::LoadModel() {
   std::string graph = params_.Get<std::string>("graph");
   model_ = tflite::FlatBufferModel::BuildFromFile(graph.c_str());
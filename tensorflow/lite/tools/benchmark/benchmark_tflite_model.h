@@ -67,6 +67,10 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   TfLiteStatus PrepareInputData() override;
   TfLiteStatus ResetInputsAndOutputs() override;
 
+  TfLiteStatus PrepareLoadWorkers(int num_workers) override;
+  TfLiteStatus RunLoadRequest(int worker_index) override;
+  void CleanUpLoadWorkers() override;
+
   int64_t MayGetModelFileSize() override;
 
   virtual TfLiteStatus LoadModel();
@@ -118,12 +122,28 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   InputTensorData LoadInputTensorData(const TfLiteTensor& t,
                                       const std::string& input_file_path);
 
+  // Resizes the inputs of 'interpreter' to the shapes given by --input_layer
+  // and --input_layer_shape, and allocates its tensors.
+  TfLiteStatus ResizeAndAllocateTensors(Interpreter* interpreter);
+
+  // Sets the values of the input tensors of 'interpreter' from inputs_data_.
+  void SetInputs(Interpreter* interpreter);
+
+  // An independent interpreter of the model for the load test, with its own
+  // delegates.
+  struct LoadWorker {
+    // Declared first so that the delegates outlive the interpreter.
+    std::vector<Interpreter::TfLiteDelegatePtr> delegates;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+  };
+
   std::vector<InputLayerInfo> inputs_;
   std::vector<InputTensorData> inputs_data_;
   std::unique_ptr<BenchmarkListener> profiling_listener_ = nullptr;
   std::unique_ptr<BenchmarkListener> ruy_profiling_listener_ = nullptr;
   std::mt19937 random_engine_;
   std::vector<Interpreter::TfLiteDelegatePtr> owned_delegates_;
+  std::vector<std::unique_ptr<LoadWorker>> load_workers_;
   // Always TFLITE_LOG the benchmark result.
   BenchmarkLoggingListener log_output_;
 };
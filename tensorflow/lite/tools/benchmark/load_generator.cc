@@ -0,0 +1,214 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/load_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <mutex>  // NOLINT(build/c++11)
+#include <random>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "tensorflow/lite/profiling/time.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/time.h>
+#define TFLITE_HAS_GETRUSAGE 1
+#endif
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// Outcome of the requests served by a single worker.
+struct WorkerStats {
+  std::vector<int64_t> latencies_us;
+  int64_t num_failed = 0;
+};
+
+void ServeRequest(const LoadGenerator::RequestFn& request_fn, int worker_index,
+                  int64_t arrival_us, WorkerStats* stats) {
+  const TfLiteStatus status = request_fn(worker_index);
+  const int64_t end_us = profiling::time::NowMicros();
+  if (status == kTfLiteOk) {
+    stats->latencies_us.push_back(end_us - arrival_us);
+  } else {
+    stats->num_failed++;
+  }
+}
+
+// Each worker issues its next request as soon as the previous one completes,
+// until 'deadline_us'.
+void RunClosedLoop(const LoadGenerator::RequestFn& request_fn,
+                   int64_t deadline_us, std::vector<WorkerStats>* stats) {
+  std::vector<std::thread> workers;
+  for (int i = 0; i < stats->size(); ++i) {
+    workers.emplace_back([&request_fn, deadline_us, i, stats] {
+      WorkerStats* worker_stats = &(*stats)[i];
+      for (int64_t now_us = profiling::time::NowMicros(); now_us < deadline_us;
+           now_us = profiling::time::NowMicros()) {
+        ServeRequest(request_fn, i, now_us, worker_stats);
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+// Requests arrive at 'target_qps' until 'deadline_us' and are served by the
+// first free worker. Returns the number of requests that were still waiting
+// for a worker at the deadline.
+int64_t RunOpenLoop(const LoadGenerator::RequestFn& request_fn,
+                    const LoadGeneratorOptions& options, int64_t start_us,
+                    int64_t deadline_us, std::vector<WorkerStats>* stats) {
+  std::mutex mutex;
+  std::condition_variable arrival_cv;
+  // Arrival times of the requests that are waiting for a worker.
+  std::deque<int64_t> arrivals_us;
+  bool done = false;
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < stats->size(); ++i) {
+    workers.emplace_back([&, i] {
+      WorkerStats* worker_stats = &(*stats)[i];
+      while (true) {
+        int64_t arrival_us;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          arrival_cv.wait(lock, [&] { return done || !arrivals_us.empty(); });
+          if (done) return;
+          arrival_us = arrivals_us.front();
+          arrivals_us.pop_front();
+        }
+        ServeRequest(request_fn, i, arrival_us, worker_stats);
+      }
+    });
+  }
+
+  // Requests are timestamped with their scheduled arrival time, so that a
+  // late wake-up of this thread does not hide queueing delays.
+  std::mt19937 random_engine(std::random_device{}());
+  std::exponential_distribution<double> poisson_interval_us(options.target_qps /
+                                                            1e6);
+  const double constant_interval_us = 1e6 / options.target_qps;
+  double next_arrival_us = start_us;
+  while (next_arrival_us < deadline_us) {
+    const int64_t now_us = profiling::time::NowMicros();
+    if (next_arrival_us > now_us) {
+      profiling::time::SleepForMicros(
+          static_cast<uint64_t>(next_arrival_us - now_us));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      arrivals_us.push_back(static_cast<int64_t>(next_arrival_us));
+    }
+    arrival_cv.notify_one();
+    next_arrival_us += options.poisson_arrivals
+                           ? poisson_interval_us(random_engine)
+                           : constant_interval_us;
+  }
+
+  // Requests in flight complete, but no new ones are started.
+  int64_t num_backlogged;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    num_backlogged = arrivals_us.size();
+  }
+  arrival_cv.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  return num_backlogged;
+}
+
+}  // namespace
+
+int64_t GetPercentile(const std::vector<int64_t>& sorted_values,
+                      double percentile) {
+  if (sorted_values.empty()) return 0;
+  // The epsilon keeps rounding errors, e.g. of 99.9 / 100 * 1000, from
+  // bumping the rank.
+  const size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * sorted_values.size() - 1e-9));
+  return sorted_values[std::min(std::max<size_t>(rank, 1),
+                                sorted_values.size()) -
+                       1];
+}
+
+int64_t GetProcessCpuTimeMicros() {
+#ifdef TFLITE_HAS_GETRUSAGE
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#else
+  return -1;
+#endif
+}
+
+LoadTestResults LoadGenerator::Run(const RequestFn& request_fn) {
+  LoadTestResults results;
+  results.options = options_;
+  results.num_cpus = std::thread::hardware_concurrency();
+
+  std::vector<WorkerStats> stats(std::max(options_.num_workers, 1));
+  const int64_t start_cpu_us = GetProcessCpuTimeMicros();
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t deadline_us =
+      start_us + static_cast<int64_t>(options_.duration_secs * 1e6);
+  if (options_.target_qps > 0) {
+    results.num_backlogged =
+        RunOpenLoop(request_fn, options_, start_us, deadline_us, &stats);
+  } else {
+    RunClosedLoop(request_fn, deadline_us, &stats);
+  }
+  const int64_t end_us = profiling::time::NowMicros();
+  const int64_t end_cpu_us = GetProcessCpuTimeMicros();
+
+  results.elapsed_secs = (end_us - start_us) / 1e6;
+  if (start_cpu_us >= 0 && end_cpu_us >= 0 && end_us > start_us) {
+    results.cpu_utilization =
+        static_cast<double>(end_cpu_us - start_cpu_us) / (end_us - start_us);
+  }
+  results.mem_usage = profiling::memory::GetMemoryUsage();
+
+  std::vector<int64_t> latencies_us;
+  for (const WorkerStats& worker_stats : stats) {
+    latencies_us.insert(latencies_us.end(), worker_stats.latencies_us.begin(),
+                        worker_stats.latencies_us.end());
+    results.num_failed += worker_stats.num_failed;
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  results.num_completed = latencies_us.size();
+  if (!latencies_us.empty()) {
+    double sum_us = 0;
+    for (int64_t latency_us : latencies_us) sum_us += latency_us;
+    results.avg_latency_us = sum_us / latencies_us.size();
+    results.max_latency_us = latencies_us.back();
+  }
+  results.p50_latency_us = GetPercentile(latencies_us, 50);
+  results.p90_latency_us = GetPercentile(latencies_us, 90);
+  results.p99_latency_us = GetPercentile(latencies_us, 99);
+  results.p999_latency_us = GetPercentile(latencies_us, 99.9);
+  return results;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_LOAD_GENERATOR_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_LOAD_GENERATOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/profiling/memory_info.h"
+
+namespace tflite {
+namespace benchmark {
+
+struct LoadGeneratorOptions {
+  // Number of workers issuing requests concurrently, each on its own thread.
+  int num_workers = 1;
+  // Requests per second offered to the workers. Requests arrive independently
+  // of the completion of earlier ones (open loop), so their latencies include
+  // the time spent waiting for a free worker. If not positive, each worker
+  // issues its next request as soon as its previous one completes (closed
+  // loop), which measures the maximum throughput.
+  double target_qps = 0.0;
+  // Whether the times between open-loop arrivals are exponentially
+  // distributed (Poisson arrivals) rather than constant.
+  bool poisson_arrivals = true;
+  // How long requests are issued for.
+  double duration_secs = 10.0;
+};
+
+struct LoadTestResults {
+  LoadGeneratorOptions options;
+
+  // Number of requests that completed successfully.
+  int64_t num_completed = 0;
+  // Number of requests that returned an error.
+  int64_t num_failed = 0;
+  // Number of open-loop requests that arrived but were still waiting for a
+  // worker when the test ended.
+  int64_t num_backlogged = 0;
+  // Wall time from the start of the test until the last request completed.
+  double elapsed_secs = 0.0;
+
+  // Latencies of successful requests in microseconds, from their arrival
+  // until their completion.
+  double avg_latency_us = 0.0;
+  int64_t p50_latency_us = 0;
+  int64_t p90_latency_us = 0;
+  int64_t p99_latency_us = 0;
+  int64_t p999_latency_us = 0;
+  int64_t max_latency_us = 0;
+
+  // CPU time (user and system) the process spent during the test divided by
+  // its wall time, i.e. the average number of busy cores. Negative if not
+  // supported on the platform.
+  double cpu_utilization = -1.0;
+  // Number of CPUs available to the process, or 0 if unknown.
+  int num_cpus = 0;
+
+  // Memory usage of the process at the end of the test.
+  profiling::memory::MemoryUsage mem_usage;
+
+  double throughput_qps() const {
+    return elapsed_secs > 0 ? num_completed / elapsed_secs : 0.0;
+  }
+};
+
+// Returns the value at 'percentile' (in [0, 100]) of the ascending
+// 'sorted_values' using the nearest-rank method, or 0 if there are no values.
+int64_t GetPercentile(const std::vector<int64_t>& sorted_values,
+                      double percentile);
+
+// Returns the CPU time in microseconds the process has consumed so far, or -1
+// if not supported on the platform.
+int64_t GetProcessCpuTimeMicros();
+
+// Issues requests from concurrent workers, either open loop at a target rate
+// or closed loop, and reports throughput, latency percentiles and resource
+// usage.
+class LoadGenerator {
+ public:
+  // Serves a single request on the worker with the given index. Calls for the
+  // same worker are always made from the same thread, one at a time.
+  using RequestFn = std::function<TfLiteStatus(int worker_index)>;
+
+  explicit LoadGenerator(const LoadGeneratorOptions& options)
+      : options_(options) {}
+
+  LoadTestResults Run(const RequestFn& request_fn);
+
+ private:
+  const LoadGeneratorOptions options_;
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_LOAD_GENERATOR_H_
@@ -0,0 +1,128 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/load_generator.h"
+
+#include <atomic>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+TEST(LoadGeneratorTest, GetPercentile) {
+  std::vector<int64_t> values;
+  for (int i = 1; i <= 1000; ++i) values.push_back(i);
+
+  EXPECT_EQ(GetPercentile(values, 50), 500);
+  EXPECT_EQ(GetPercentile(values, 90), 900);
+  EXPECT_EQ(GetPercentile(values, 99.9), 999);
+  EXPECT_EQ(GetPercentile(values, 100), 1000);
+  EXPECT_EQ(GetPercentile(values, 0), 1);
+  EXPECT_EQ(GetPercentile({}, 50), 0);
+}
+
+TEST(LoadGeneratorTest, ClosedLoopUsesAllWorkers) {
+  LoadGeneratorOptions options;
+  options.num_workers = 3;
+  options.duration_secs = 0.2;
+  std::mutex mutex;
+  std::set<int> worker_indices;
+  std::set<std::thread::id> thread_ids;
+
+  LoadTestResults results =
+      LoadGenerator(options).Run([&](int worker_index) -> TfLiteStatus {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          worker_indices.insert(worker_index);
+          thread_ids.insert(std::this_thread::get_id());
+        }
+        profiling::time::SleepForMicros(1000);
+        return kTfLiteOk;
+      });
+
+  EXPECT_EQ(worker_indices, std::set<int>({0, 1, 2}));
+  EXPECT_EQ(thread_ids.size(), 3);
+  EXPECT_GT(results.num_completed, 3);
+  EXPECT_EQ(results.num_failed, 0);
+  EXPECT_EQ(results.num_backlogged, 0);
+  EXPECT_GE(results.elapsed_secs, 0.2);
+  EXPECT_GT(results.throughput_qps(), 0);
+  EXPECT_GE(results.p50_latency_us, 1000);
+  EXPECT_LE(results.p50_latency_us, results.p99_latency_us);
+  EXPECT_LE(results.p99_latency_us, results.max_latency_us);
+}
+
+TEST(LoadGeneratorTest, OpenLoopIssuesRequestsAtTargetRate) {
+  LoadGeneratorOptions options;
+  options.num_workers = 2;
+  options.target_qps = 200;
+  options.poisson_arrivals = false;
+  options.duration_secs = 0.5;
+  std::atomic<int> num_requests(0);
+
+  LoadTestResults results = LoadGenerator(options).Run([&](int) {
+    ++num_requests;
+    return kTfLiteOk;
+  });
+
+  // 100 requests are expected, with some slack for slow test machines.
+  EXPECT_GE(num_requests, 90);
+  EXPECT_LE(num_requests, 101);
+  EXPECT_EQ(results.num_completed + results.num_backlogged, 100);
+}
+
+TEST(LoadGeneratorTest, OpenLoopLatencyIncludesQueueing) {
+  LoadGeneratorOptions options;
+  options.num_workers = 1;
+  options.target_qps = 1000;
+  options.poisson_arrivals = false;
+  options.duration_secs = 0.1;
+
+  // Requests take 10 times longer than the time between their arrivals, so
+  // they queue up behind the single worker.
+  LoadTestResults results = LoadGenerator(options).Run([](int) {
+    profiling::time::SleepForMicros(10000);
+    return kTfLiteOk;
+  });
+
+  EXPECT_GT(results.num_backlogged, 0);
+  EXPECT_GT(results.max_latency_us, 2 * 10000);
+}
+
+TEST(LoadGeneratorTest, CountsFailedRequests) {
+  LoadGeneratorOptions options;
+  options.num_workers = 2;
+  options.duration_secs = 0.1;
+  std::atomic<int> num_requests(0);
+
+  LoadTestResults results = LoadGenerator(options).Run([&](int) {
+    profiling::time::SleepForMicros(100);
+    return (num_requests++ % 2) ? kTfLiteError : kTfLiteOk;
+  });
+
+  EXPECT_GT(results.num_failed, 0);
+  EXPECT_EQ(results.num_completed + results.num_failed, num_requests);
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
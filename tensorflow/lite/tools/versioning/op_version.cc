@@ -128,6 +128,12 @@ int GetBuiltinOperatorVersion(const OpSignature& op_sig) {
       // | Quantized Int8  |                  4 |                        4 |
       // +-----------------+--------------------+--------------------------+
 
+      // Float16 weights with float32 activations are supported at version 10.
+      if (op_sig.input_types.at(0) == TensorType_FLOAT32 &&
+          op_sig.input_types.at(1) == TensorType_FLOAT16) {
+        return 10;
+      }
+
       // FullyConnected with sparse weight is supported at version 8.
       if (op_sig.options.fully_connected.sparse_weight) {
         return 8;
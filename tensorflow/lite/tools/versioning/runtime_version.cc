@@ -109,6 +109,7 @@ std::string FindMinimumRuntimeVersionForOp(tflite::BuiltinOperator op_code,
               {{BuiltinOperator_FULLY_CONNECTED, 7}, "2.3.0"},
               {{BuiltinOperator_FULLY_CONNECTED, 8}, "2.3.0"},
               {{BuiltinOperator_FULLY_CONNECTED, 9}, "2.3.0"},
+              {{BuiltinOperator_FULLY_CONNECTED, 10}, kPendingReleaseVersion},
               {{BuiltinOperator_GATHER, 1}, "1.6.0"},
               {{BuiltinOperator_GATHER, 2}, "1.14.0"},
               {{BuiltinOperator_GATHER, 3}, "1.15.0"},
@@ -450,5 +450,16 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     self.assertEqual(cpu_budget, 1000)
     self.assertEqual(ram_budget, 999999999)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testAutotuningMemoryBounded(self):
+    options = dataset_ops.Options()
+    options.experimental_optimization.autotune_ram_budget = 1 << 30
+    options.experimental_optimization.autotune_memory_bounded = True
+    autotune, algorithm, _, ram_budget = options._autotune_settings()
+    self.assertTrue(autotune)
+    self.assertEqual(algorithm,
+                     optimization_options._AutotuneAlgorithm.MEMORY_BOUNDED)
+    self.assertEqual(ram_budget, 1 << 30)
+
 if __name__ == "__main__":
   test.main()
@@ -144,6 +144,52 @@ class TFRecordWriterTest(test_base.DatasetTestBase, parameterized.TestCase):
       for j, r in enumerate(tf_record.tf_record_iterator(shard_filename)):
         self.assertAllEqual(self._record(i + 2*j), r)
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(compression_type=["", "GZIP"])))
+  def testWriteShards(self, compression_type):
+    prefix = self._outputFilename()
+    dataset = dataset_ops.Dataset.range(self._num_records).map(
+        lambda i: string_ops.as_string(i))
+    self.evaluate(
+        writers.TFRecordWriter(
+            prefix, compression_type, num_shards=3).write(dataset))
+    options = tf_record.TFRecordOptions(compression_type)
+    for i in range(3):
+      shard_filename = "%s-%05d-of-00003" % (prefix, i)
+      records = list(
+          tf_record.tf_record_iterator(shard_filename, options=options))
+      self.assertAllEqual(
+          [compat.as_bytes(str(j)) for j in range(i, self._num_records, 3)],
+          records)
+      self.assertTrue(
+          os.path.exists(shard_filename + ".tfrecord_index"))
+    with open(prefix + ".COMMITTED") as f:
+      self.assertEqual(
+          ["%s-%05d-of-00003" % (prefix, i) for i in range(3)],
+          f.read().splitlines())
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testWriteShardsByKey(self):
+    prefix = self._outputFilename()
+    dataset = dataset_ops.Dataset.range(self._num_records).map(
+        lambda i: (i // 4, string_ops.as_string(i)))
+    self.evaluate(
+        writers.TFRecordWriter(prefix, num_shards=2).write(dataset))
+    for i in range(2):
+      shard_filename = "%s-%05d-of-00002" % (prefix, i)
+      self.assertAllEqual(
+          [compat.as_bytes(str(j)) for j in range(4 * i, 4 * i + 4)],
+          list(tf_record.tf_record_iterator(shard_filename)))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testWriteShardsFailsWithBadStructure(self):
+    dataset = dataset_ops.Dataset.range(3)
+    with self.assertRaises(TypeError):
+      writers.TFRecordWriter(
+          self._outputFilename(), num_shards=2).write(dataset)
+
 
 if __name__ == "__main__":
   test.main()
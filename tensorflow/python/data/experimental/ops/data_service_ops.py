@@ -55,6 +55,8 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
                address,
                protocol,
                job_name=None,
+               consumer_index=None,
+               num_consumers=None,
                max_outstanding_requests=None,
                task_refresh_interval_hint_ms=None):
     """Constructs a _DataServiceDatasetV2.
@@ -70,6 +72,12 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
       job_name: (Optional.) The name of the job. This argument makes it possible
         for multiple datasets to share the same job. The default behavior is
         that the dataset creates anonymous, exclusively owned jobs.
+      consumer_index: (Optional.) The index of the consumer in the range from
+        `0` to `num_consumers`. Must be specified alongside `num_consumers`.
+      num_consumers: (Optional.) The number of consumers which will consume
+        from the job. If set, the consumers read the job in coordinated rounds,
+        where every round gives each consumer one element from the same
+        worker. Requires `job_name`.
       max_outstanding_requests: (Optional.) A limit on how many elements may be
         requested at the same time. You can use this option to control the
         amount of memory used, since `distribute` won't use more than
@@ -80,6 +88,10 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
 
     if job_name is None:
       job_name = ""
+    if consumer_index is None:
+      consumer_index = -1
+    if num_consumers is None:
+      num_consumers = -1
     if max_outstanding_requests is None:
       max_outstanding_requests = dataset_ops.AUTOTUNE
     if task_refresh_interval_hint_ms is None:
@@ -111,6 +123,8 @@ class _DataServiceDatasetV2(dataset_ops.DatasetSource):
         job_name=self._job_name,
         max_outstanding_requests=self._max_outstanding_requests,
         task_refresh_interval_hint_ms=task_refresh_interval_hint_ms,
+        consumer_index=consumer_index,
+        num_consumers=num_consumers,
         iteration_counter=gen_experimental_dataset_ops.dummy_iteration_counter(
         ),
         **self._flat_structure)
@@ -126,7 +140,8 @@ class _DataServiceDatasetV1(dataset_ops.DatasetV1Adapter):
 
   @functools.wraps(_DataServiceDatasetV2.__init__)
   def __init__(self, dataset_id, processing_mode, address, protocol, job_name,
-               max_outstanding_requests, task_refresh_interval_hint_ms):
+               consumer_index, num_consumers, max_outstanding_requests,
+               task_refresh_interval_hint_ms):
 
     self._wrapped = _DataServiceDatasetV2(
         dataset_id=dataset_id,
@@ -134,6 +149,8 @@ class _DataServiceDatasetV1(dataset_ops.DatasetV1Adapter):
         address=address,
         protocol=protocol,
         job_name=job_name,
+        consumer_index=consumer_index,
+        num_consumers=num_consumers,
         max_outstanding_requests=max_outstanding_requests,
         task_refresh_interval_hint_ms=task_refresh_interval_hint_ms)
     super(_DataServiceDatasetV1, self).__init__(self._wrapped)
@@ -177,6 +194,8 @@ def _from_dataset_id(processing_mode,
                      dataset_id,
                      element_spec,
                      job_name=None,
+                     consumer_index=None,
+                     num_consumers=None,
                      max_outstanding_requests=None,
                      task_refresh_interval_hint_ms=None):
   """Creates a dataset which reads data from the tf.data service.
@@ -200,6 +219,16 @@ def _from_dataset_id(processing_mode,
     job_name: (Optional.) The name of the job. This argument makes it possible
       for multiple datasets to share the same job. The default behavior is that
       the dataset creates anonymous, exclusively owned jobs.
+    consumer_index: (Optional.) The index of the consumer in the range from `0`
+      to `num_consumers`. Must be specified alongside `num_consumers`.
+    num_consumers: (Optional.) The number of consumers which will consume from
+      the job. If set, the consumers read the job in coordinated rounds: each
+      round takes `num_consumers` consecutive elements from one worker and
+      gives one of them to every consumer, and consecutive rounds visit the
+      workers in a fixed order. This is useful when the consumers must see
+      elements of matching size at each step, e.g. for bucketized batches.
+      Requires `job_name`, and requires the set of workers to stay fixed while
+      the job is read.
     max_outstanding_requests: (Optional.) A limit on how many elements may be
       requested at the same time. You can use this option to control the amount
       of memory used, since `distribute` won't use more than `element_size` *
@@ -217,6 +246,13 @@ def _from_dataset_id(processing_mode,
                        "{0}. job_name={1}".format(type(job_name), job_name))
     if not job_name:
       raise ValueError("job_name must not be empty")
+  if (consumer_index is None) != (num_consumers is None):
+    raise ValueError(
+        "Must either set both consumer_index and num_consumers, or neither. "
+        "consumer_index: {}, num_consumers: {}".format(consumer_index,
+                                                       num_consumers))
+  if num_consumers is not None and job_name is None:
+    raise ValueError("job_name must be set when setting num_consumers")
   if element_spec is None:
     raise ValueError("element_spec must not be None")
   protocol, address = _parse_service(service)
@@ -227,6 +263,8 @@ def _from_dataset_id(processing_mode,
       address=address,
       protocol=protocol,
       job_name=job_name,
+      consumer_index=consumer_index,
+      num_consumers=num_consumers,
       max_outstanding_requests=max_outstanding_requests,
       task_refresh_interval_hint_ms=task_refresh_interval_hint_ms)
   # TODO(b/157105111): Make this an autotuned parallel map when we have a way
@@ -248,8 +286,11 @@ def _from_dataset_id(processing_mode,
 def _distribute(processing_mode,
                 service,
                 job_name=None,
+                consumer_index=None,
+                num_consumers=None,
                 max_outstanding_requests=None,
-                task_refresh_interval_hint_ms=None):
+                task_refresh_interval_hint_ms=None,
+                compression="snappy"):
   """A transformation that moves dataset processing to the tf.data service.
 
   This transformation is similar to `distribute`, but supports additional
@@ -265,12 +306,27 @@ def _distribute(processing_mode,
     job_name: (Optional.) The name of the job. This argument makes it possible
       for multiple datasets to share the same job. The default behavior is that
       the dataset creates anonymous, exclusively owned jobs.
+    consumer_index: (Optional.) The index of the consumer in the range from `0`
+      to `num_consumers`. Must be specified alongside `num_consumers`.
+    num_consumers: (Optional.) The number of consumers which will consume from
+      the job. If set, the consumers read the job in coordinated rounds: each
+      round takes `num_consumers` consecutive elements from one worker and
+      gives one of them to every consumer, and consecutive rounds visit the
+      workers in a fixed order. This is useful when the consumers must see
+      elements of matching size at each step, e.g. for bucketized batches.
+      Requires `job_name`, and requires the set of workers to stay fixed while
+      the job is read.
     max_outstanding_requests: (Optional.) A limit on how many elements may be
       requested at the same time. You can use this option to control the amount
       of memory used, since `distribute` won't use more than `element_size` *
       `max_outstanding_requests` of memory.
     task_refresh_interval_hint_ms: (Optional.) A hint for how often to query the
       dispatcher for task changes.
+    compression: (Optional.) How the tf.data workers compress elements before
+      sending them to the client, either "snappy", "gzip" or None. Use None
+      for elements that don't compress well, e.g. already-encoded images, or
+      when the network is faster than compression. "gzip" compresses better
+      than "snappy" but costs more CPU on the workers and clients.
 
   Returns:
     Dataset: A `Dataset` of the elements produced by the data service.
@@ -278,13 +334,15 @@ def _distribute(processing_mode,
   ProcessingMode.validate(processing_mode)
 
   def _apply_fn(dataset):  # pylint: disable=missing-docstring
-    dataset_id = register_dataset(service, dataset)
+    dataset_id = register_dataset(service, dataset, compression=compression)
     return _from_dataset_id(
         processing_mode,
         service,
         dataset_id,
         dataset.element_spec,
         job_name=job_name,
+        consumer_index=consumer_index,
+        num_consumers=num_consumers,
         max_outstanding_requests=max_outstanding_requests,
         task_refresh_interval_hint_ms=task_refresh_interval_hint_ms)
 
@@ -295,7 +353,8 @@ def _distribute(processing_mode,
 def distribute(processing_mode,
                service,
                job_name=None,
-               max_outstanding_requests=None):
+               max_outstanding_requests=None,
+               compression="snappy"):
   """A transformation that moves dataset processing to the tf.data service.
 
   When you iterate over a dataset containing the `distribute` transformation,
@@ -409,6 +468,11 @@ def distribute(processing_mode,
       requested at the same time. You can use this option to control the amount
       of memory used, since `distribute` won't use more than `element_size` *
       `max_outstanding_requests` of memory.
+    compression: (Optional.) How the tf.data workers compress elements before
+      sending them to the client, either "snappy", "gzip" or None. Use None
+      for elements that don't compress well, e.g. already-encoded images, or
+      when the network is faster than compression. "gzip" compresses better
+      than "snappy" but costs more CPU on the workers and clients.
 
   Returns:
     Dataset: A `Dataset` of the elements produced by the data service.
@@ -417,11 +481,12 @@ def distribute(processing_mode,
       processing_mode=processing_mode,
       service=service,
       job_name=job_name,
-      max_outstanding_requests=max_outstanding_requests)
+      max_outstanding_requests=max_outstanding_requests,
+      compression=compression)
 
 
 @tf_export("data.experimental.service.register_dataset")
-def register_dataset(service, dataset):
+def register_dataset(service, dataset, compression="snappy"):
   """Registers a dataset with the tf.data service.
 
   `register_dataset` registers a dataset with the tf.data service so that
@@ -456,20 +521,32 @@ def register_dataset(service, dataset):
       string should be in the format "protocol://address", e.g.
       "grpc://localhost:5000".
     dataset: A `tf.data.Dataset` to register with the tf.data service.
+    compression: (Optional.) How the tf.data workers compress elements before
+      sending them to the client, either "snappy", "gzip" or None.
 
   Returns:
     A scalar int64 tensor of the registered dataset's id.
+
+  Raises:
+    ValueError: If `compression` is not "snappy", "gzip" or None.
   """
+  if compression not in ("snappy", "gzip", None):
+    raise ValueError(
+        "Invalid compression {}. Supported values are \"snappy\", \"gzip\" "
+        "and None.".format(compression))
   protocol, address = _parse_service(service)
   external_state_policy = dataset.options().experimental_external_state_policy
   if external_state_policy is None:
     external_state_policy = ExternalStatePolicy.WARN
 
   # Compress the dataset elements to reduce the amount of data that needs to
-  # be sent over the network.
+  # be sent over the network. Uncompressed elements still go through
+  # `compress`, which packs them into the variant sent to the client.
   # TODO(b/157105111): Make this an autotuned parallel map when we have a way
   # to limit memory usage.
-  dataset = dataset.map(lambda *x: compression_ops.compress(x))
+  compression = compression or "none"
+  dataset = dataset.map(
+      lambda *x: compression_ops.compress(x, compression=compression))
   # Prefetch one compressed element to reduce latency when requesting data
   # from tf.data workers.
   # TODO(b/157105111): Set this to autotune when we have a way to limit
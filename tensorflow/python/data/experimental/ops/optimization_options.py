@@ -30,6 +30,7 @@ class _AutotuneAlgorithm(enum.Enum):
   """Controls what algorithm is used in the autotune implementation."""
   HILL_CLIMB = 0
   GRADIENT_DESCENT = 1
+  MEMORY_BOUNDED = 2
 
 
 @tf_export("data.experimental.MapVectorizationOptions")
@@ -117,6 +118,16 @@ class OptimizationOptions(options.OptionsBase):
       "are allowed but may result in CPU contention. If None, defaults to the "
       "number of schedulable CPU cores.")
 
+  autotune_memory_bounded = options.create_option(
+      name="autotune_memory_bounded",
+      ty=bool,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines whether to "
+      "treat the RAM budget as a hard limit on the memory buffered by the "
+      "input pipeline, including the elements being produced by parallel "
+      "transformations. Buffers are also shrunk when the memory available on "
+      "the host runs low. If None, defaults to False.")
+
   autotune_ram_budget = options.create_option(
       name="autotune_ram_budget",
       ty=int,
@@ -238,6 +249,8 @@ class OptimizationOptions(options.OptionsBase):
       autotune = False
     if self.autotune_cpu_budget is not None:
       cpu_budget = self.autotune_cpu_budget
+    if self.autotune_memory_bounded:
+      algorithm = _AutotuneAlgorithm.MEMORY_BOUNDED
     if self.autotune_ram_budget is not None:
       ram_budget = self.autotune_ram_budget
 
@@ -63,16 +63,34 @@ class TFRecordWriter(object):
     lambda i, _: i % NUM_SHARDS, reduce_func, tf.int64.max
   ))
   ```
+
+  With `num_shards`, the writer instead writes `num_shards` files in parallel,
+  named `"<filename>-<index>-of-<num_shards>"`. The records go to the shards
+  in round robin order, or, if the dataset produces `(key, record)` pairs
+  with scalar `tf.int64` or `tf.string` keys, to the shard of their key. Each
+  shard gets a record index next to it, and once all shards are written, the
+  file `"<filename>.COMMITTED"` lists them.
+
+  ```python
+  dataset = tf.data.Dataset.range(100).map(tf.io.serialize_tensor)
+  writer = tf.data.experimental.TFRecordWriter("/path/to/file", num_shards=4)
+  writer.write(dataset)
+  dataset = tf.data.TFRecordDataset(
+      tf.data.Dataset.list_files("/path/to/file-*-of-00004"))
+  ```
   """
 
-  def __init__(self, filename, compression_type=None):
+  def __init__(self, filename, compression_type=None, num_shards=None):
     """Initializes a `TFRecordWriter`.
 
     Args:
-      filename: a string path indicating where to write the TFRecord data.
+      filename: a string path indicating where to write the TFRecord data. With
+        `num_shards`, the prefix of the shard files.
       compression_type: (Optional.) a string indicating what type of compression
         to use when writing the file. See `tf.io.TFRecordCompressionType` for
         what types of compression are available. Defaults to `None`.
+      num_shards: (Optional.) The number of shards to write in parallel. If
+        `None`, writes a single file.
     """
     self._filename = ops.convert_to_tensor(
         filename, dtypes.string, name="filename")
@@ -81,6 +99,11 @@ class TFRecordWriter(object):
         compression_type,
         argument_default="",
         argument_dtype=dtypes.string)
+    if num_shards is None:
+      self._num_shards = None
+    else:
+      self._num_shards = ops.convert_to_tensor(
+          num_shards, dtypes.int64, name="num_shards")
 
   def write(self, dataset):
     """Writes a dataset to a TFRecord file.
@@ -100,10 +123,13 @@ class TFRecordWriter(object):
 
     Raises
       TypeError: if `dataset` is not a `tf.data.Dataset`.
-      TypeError: if the elements produced by the dataset are not scalar strings.
+      TypeError: if the elements produced by the dataset are not scalar strings,
+        or, with `num_shards`, pairs of scalar keys and scalar strings.
     """
     if not isinstance(dataset, dataset_ops.DatasetV2):
       raise TypeError("`dataset` must be a `tf.data.Dataset` object.")
+    if self._num_shards is not None:
+      return self._write_shards(dataset)
     if not dataset_ops.get_structure(dataset).is_compatible_with(
         tensor_spec.TensorSpec([], dtypes.string)):
       raise TypeError(
@@ -113,3 +139,24 @@ class TFRecordWriter(object):
               dataset_ops.get_legacy_output_types(dataset)))
     return gen_experimental_dataset_ops.dataset_to_tf_record(
         dataset._variant_tensor, self._filename, self._compression_type)  # pylint: disable=protected-access
+
+  def _write_shards(self, dataset):
+    """Writes `dataset` to `self._num_shards` shards."""
+    structure = dataset_ops.get_structure(dataset)
+    record_spec = tensor_spec.TensorSpec([], dtypes.string)
+    keyed = (
+        isinstance(structure, tuple) and len(structure) == 2 and
+        any(structure[0].is_compatible_with(tensor_spec.TensorSpec([], dtype))
+            for dtype in (dtypes.int64, dtypes.string)) and
+        structure[1].is_compatible_with(record_spec))
+    if not keyed and not (isinstance(structure, tensor_spec.TensorSpec) and
+                          structure.is_compatible_with(record_spec)):
+      raise TypeError(
+          "`dataset` must produce scalar `DT_STRING` tensors or pairs of "
+          "scalar `DT_INT64` or `DT_STRING` keys and scalar `DT_STRING` "
+          "tensors whereas it produces shape {0} and types {1}".format(
+              dataset_ops.get_legacy_output_shapes(dataset),
+              dataset_ops.get_legacy_output_types(dataset)))
+    return gen_experimental_dataset_ops.dataset_to_sharded_tf_record(
+        dataset._variant_tensor, self._filename, self._compression_type,  # pylint: disable=protected-access
+        self._num_shards)
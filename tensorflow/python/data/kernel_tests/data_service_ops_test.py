@@ -517,6 +517,48 @@ class DataServiceOpsTest(test_base.DatasetTestBase, parameterized.TestCase):
     self.assertDatasetProduces(ds2, list(range(num_elements)))
     self.assertDatasetProduces(ds1, [])
 
+  @combinations.generate(test_base.eager_only_combinations())
+  def testCoordinatedRead(self):
+    dispatcher, workers = self.start_cluster(1)  # to avoid gcing workers, pylint: disable=unused-variable
+    num_consumers = 3
+    num_rounds = 4
+    ds = dataset_ops.Dataset.range(num_consumers * num_rounds)
+    iterators = []
+    for consumer_index in range(num_consumers):
+      iterators.append(
+          iter(
+              ds.apply(
+                  data_service_ops._distribute(
+                      "parallel_epochs",
+                      dispatcher.target,
+                      job_name="job_name",
+                      consumer_index=consumer_index,
+                      num_consumers=num_consumers))))
+    # Each round hands one element of the same worker to every consumer, in
+    # consumer order.
+    results = []
+    for _ in range(num_rounds):
+      results.append([next(it).numpy() for it in iterators])
+    expected = [[r * num_consumers + c
+                 for c in range(num_consumers)]
+                for r in range(num_rounds)]
+    self.assertEqual(expected, results)
+    for it in iterators:
+      with self.assertRaises(StopIteration):
+        next(it)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testCoordinatedReadRequiresJobName(self):
+    ds = dataset_ops.Dataset.range(10)
+    with self.assertRaisesRegex(ValueError, "job_name must be set"):
+      data_service_ops._from_dataset_id(
+          "parallel_epochs",
+          "grpc://localhost:5000",
+          dataset_id=0,
+          element_spec=ds.element_spec,
+          consumer_index=0,
+          num_consumers=2)
+
   @combinations.generate(test_base.eager_only_combinations())
   def testSharedJobNameRepeat(self):
     dispatcher, workers = self.start_cluster(1)  # to avoid gcing workers, pylint: disable=unused-variable
@@ -4107,6 +4107,15 @@ def _should_unpack_args(args):
   return type(args) is tuple  # pylint: disable=unidiomatic-typecheck
 
 
+def _jit_compile_attr(jit_compile):
+  """Returns the `jit_compile` attr for a map op, omitted when not set.
+
+  Leaving out the default keeps graphs loadable by runtimes that predate the
+  attr.
+  """
+  return {"jit_compile": True} if jit_compile else {}
+
+
 class MapDataset(UnaryDataset):
   """A `Dataset` that maps a function over elements in its input."""
 
@@ -4115,7 +4124,8 @@ class MapDataset(UnaryDataset):
                map_func,
                use_inter_op_parallelism=True,
                preserve_cardinality=False,
-               use_legacy_function=False):
+               use_legacy_function=False,
+               jit_compile=False):
     """See `Dataset.map()` for details."""
     self._input_dataset = input_dataset
     self._use_inter_op_parallelism = use_inter_op_parallelism
@@ -4131,6 +4141,7 @@ class MapDataset(UnaryDataset):
         f=self._map_func.function,
         use_inter_op_parallelism=self._use_inter_op_parallelism,
         preserve_cardinality=self._preserve_cardinality,
+        **_jit_compile_attr(jit_compile),
         **self._flat_structure)
     super(MapDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -4155,7 +4166,8 @@ class ParallelMapDataset(UnaryDataset):
                deterministic,
                use_inter_op_parallelism=True,
                preserve_cardinality=False,
-               use_legacy_function=False):
+               use_legacy_function=False,
+               jit_compile=False):
     """See `Dataset.map()` for details."""
     self._input_dataset = input_dataset
     self._use_inter_op_parallelism = use_inter_op_parallelism
@@ -4181,6 +4193,7 @@ class ParallelMapDataset(UnaryDataset):
         deterministic=self._deterministic,
         use_inter_op_parallelism=self._use_inter_op_parallelism,
         preserve_cardinality=self._preserve_cardinality,
+        **_jit_compile_attr(jit_compile),
         **self._flat_structure)
     super(ParallelMapDataset, self).__init__(input_dataset, variant_tensor)
 
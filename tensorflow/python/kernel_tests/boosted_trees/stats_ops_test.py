@@ -1634,6 +1634,43 @@ class StatsOpsTest(test_util.TensorFlowTestCase):
                                               summary_values)
     self.assertAllClose(expected_dense_summary, dense_result)
 
+  def testStatsSummaryManyFeatures(self):
+    """Tests stats summaries of enough features to be built in parallel."""
+    np.random.seed(0)
+    max_splits = 4
+    num_buckets = 8
+    batch_size = 5000
+    num_features = 64
+    node_ids = np.random.randint(0, max_splits, size=batch_size)
+    gradients = np.random.randn(batch_size, 2).astype(np.float32)
+    hessians = np.random.rand(batch_size, 2).astype(np.float32)
+    # -1 is the missing value, aggregated into the last bucket.
+    features = np.random.randint(
+        -1, num_buckets, size=(batch_size, num_features)).astype(np.int32)
+    bucketized_features = np.maximum(features, 0)
+
+    expected_aggregate = np.zeros(
+        (max_splits, num_features, num_buckets + 1, 4), dtype=np.float64)
+    expected_summary = np.zeros(
+        (num_features, max_splits, num_buckets, 2), dtype=np.float64)
+    for i in range(batch_size):
+      node = node_ids[i]
+      for f in range(num_features):
+        expected_aggregate[node, f, features[i, f], :2] += gradients[i]
+        expected_aggregate[node, f, features[i, f], 2:] += hessians[i]
+        bucket = bucketized_features[i, f]
+        expected_summary[f, node, bucket, 0] += gradients[i, 0]
+        expected_summary[f, node, bucket, 1] += hessians[i, 0]
+
+    with self.cached_session():
+      aggregate = boosted_trees_ops.boosted_trees_aggregate_stats(
+          node_ids, gradients, hessians, features, max_splits, num_buckets)
+      summary = boosted_trees_ops.make_stats_summary(
+          node_ids, gradients[:, :1], hessians[:, :1],
+          list(bucketized_features.T), max_splits, num_buckets)
+      self.assertAllClose(expected_aggregate, self.evaluate(aggregate))
+      self.assertAllClose(expected_summary, self.evaluate(summary))
+
   def _verify_precision(self, length):
     with self.cached_session():
       max_splits = 1
@@ -265,6 +265,42 @@ class EmbeddingLookupTest(test.TestCase):
     self.assertAllEqual(np_result, tf_result)
     self.assertShapeEqual(np_result, embedding)
 
+  @test_util.run_deprecated_v1
+  def testShardedRepeatedIds(self):
+    with self.cached_session() as sess:
+      num_shards = 3
+      vocab_size = 7
+      p, params, feed_dict = _EmbeddingParams(num_shards, vocab_size)
+
+      id_vals = np.array([4, 1, 4, 0, 4, 1])
+      ids = constant_op.constant(list(id_vals), dtype=dtypes.int32)
+      embedding = embedding_ops.embedding_lookup(p, ids, deduplicate_ids=True)
+
+      tf_result = embedding.eval(feed_dict=feed_dict)
+      # Every distinct id is gathered from its shard only once.
+      self.assertIn("Unique", [op.type for op in sess.graph.get_operations()])
+    np_result, _, _ = _EmbeddingResult(params, id_vals, num_shards, vocab_size)
+    self.assertAllEqual(np_result, tf_result)
+    self.assertShapeEqual(np_result, embedding)
+
+  @test_util.run_deprecated_v1
+  def testShardedRepeatedIdsNotDeduplicatedByDefault(self):
+    with self.cached_session() as sess:
+      num_shards = 3
+      vocab_size = 7
+      p, params, feed_dict = _EmbeddingParams(num_shards, vocab_size)
+
+      id_vals = np.array([4, 1, 4, 0, 4, 1])
+      ids = constant_op.constant(list(id_vals), dtype=dtypes.int32)
+      embedding = embedding_ops.embedding_lookup(p, ids)
+
+      tf_result = embedding.eval(feed_dict=feed_dict)
+      self.assertNotIn("Unique",
+                       [op.type for op in sess.graph.get_operations()])
+    np_result, _, _ = _EmbeddingResult(params, id_vals, num_shards, vocab_size)
+    self.assertAllEqual(np_result, tf_result)
+    self.assertShapeEqual(np_result, embedding)
+
   @test_util.run_deprecated_v1
   def testMaxNorm(self):
     with self.cached_session():
@@ -41,6 +41,7 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import gen_lookup_ops
 from tensorflow.python.ops import lookup_ops
 from tensorflow.python.ops import map_fn
 from tensorflow.python.ops import string_ops
@@ -3535,6 +3536,210 @@ class MutableHashTableOpTest(test.TestCase):
       result = self.evaluate(output)
       self.assertAllEqual((b"brain", b"salad", b"n/a"), result)
 
+  def testMutableHashTableDuplicateInsertAcrossShards(self):
+    with self.cached_session():
+      # Every key appears four times, and the keys spread over all shards.
+      keys = np.arange(200, dtype=np.int64) % 50
+      values = np.arange(200, dtype=np.int64)
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      self.evaluate(table.insert(keys, values))
+      self.assertAllEqual(50, self.evaluate(table.size()))
+
+      # The last write of each key wins.
+      output = table.lookup(np.arange(50, dtype=np.int64))
+      self.assertAllEqual(np.arange(150, 200), self.evaluate(output))
+
+  def testMutableHashTableOfTensorsDuplicateInsertAcrossShards(self):
+    with self.cached_session():
+      keys = np.arange(200, dtype=np.int64) % 50
+      values = np.arange(200, dtype=np.int64)
+      values = np.stack([values, -values], axis=1)
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, [-1, -1])
+      self.evaluate(table.insert(keys, values))
+      self.assertAllEqual(50, self.evaluate(table.size()))
+
+      output = table.lookup(np.arange(50, dtype=np.int64))
+      self.assertAllEqual(values[150:], self.evaluate(output))
+
+  def testMutableHashTableImportClears(self):
+    with self.cached_session():
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      self.evaluate(
+          table.insert(
+              np.arange(100, dtype=np.int64), np.arange(100, dtype=np.int64)))
+      self.assertAllEqual(100, self.evaluate(table.size()))
+
+      # Importing replaces the contents of every shard.
+      self.evaluate(
+          gen_lookup_ops.lookup_table_import_v2(
+              table.resource_handle, np.arange(90, 120, dtype=np.int64),
+              np.arange(190, 220, dtype=np.int64)))
+      self.assertAllEqual(30, self.evaluate(table.size()))
+      output = table.lookup(
+          constant_op.constant([0, 89, 90, 119], dtypes.int64))
+      self.assertAllEqual([-1, -1, 190, 219], self.evaluate(output))
+
+  def testMutableHashTableExportManyKeys(self):
+    with self.cached_session():
+      # Enough keys to fill every shard, inserted in several batches.
+      keys = np.arange(1000, dtype=np.int64) * 7919
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      for batch in np.split(keys, 4):
+        self.evaluate(table.insert(batch, batch * 2))
+      self.assertAllEqual(1000, self.evaluate(table.size()))
+
+      exported_keys, exported_values = self.evaluate(table.export())
+      order = np.argsort(exported_keys)
+      self.assertAllEqual(keys, exported_keys[order])
+      self.assertAllEqual(keys * 2, exported_values[order])
+
+  @test_util.run_v1_only("Sessions not available in TF2.0")
+  def testMutableHashTableConcurrentInsertAndFind(self):
+    num_threads = 8
+    keys_per_thread = 500
+    with self.cached_session() as sess:
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      inserts = []
+      lookups = []
+      for t in range(num_threads):
+        keys = np.arange(
+            t * keys_per_thread, (t + 1) * keys_per_thread, dtype=np.int64)
+        inserts.append(table.insert(keys, keys * 2))
+        lookups.append(table.lookup(keys))
+
+      def InsertAndFind(t):
+        keys = np.arange(
+            t * keys_per_thread, (t + 1) * keys_per_thread, dtype=np.int64)
+        for _ in range(10):
+          sess.run(inserts[t])
+          self.assertAllEqual(keys * 2, sess.run(lookups[t]))
+          # Reads of the other threads' keys see either nothing or the
+          # inserted values.
+          other = sess.run(lookups[(t + 1) % num_threads])
+          self.assertTrue(np.all((other == -1) | (other % 2 == 0)))
+
+      threads = [
+          self.checkedThread(target=InsertAndFind, args=(t,))
+          for t in range(num_threads)
+      ]
+      for thread in threads:
+        thread.start()
+      for thread in threads:
+        thread.join()
+      self.assertAllEqual(num_threads * keys_per_thread,
+                          self.evaluate(table.size()))
+
+
+class MutableBoundedHashTableOpTest(test.TestCase):
+
+  def _create_table(self, capacity, **kwargs):
+    return gen_lookup_ops.mutable_bounded_hash_table(
+        key_dtype=dtypes.int64,
+        value_dtype=dtypes.float32,
+        capacity=capacity,
+        **kwargs)
+
+  def _lookup(self, table, keys):
+    return self.evaluate(
+        gen_lookup_ops.lookup_table_find_v2(
+            table, constant_op.constant(keys, dtypes.int64),
+            constant_op.constant(-1.0)))
+
+  def _insert(self, table, keys, values):
+    self.evaluate(
+        gen_lookup_ops.lookup_table_insert_v2(
+            table, constant_op.constant(keys, dtypes.int64),
+            constant_op.constant(values, dtypes.float32)))
+
+  def _size(self, table):
+    return self.evaluate(gen_lookup_ops.lookup_table_size_v2(table))
+
+  def testLruEviction(self):
+    with self.cached_session():
+      table = self._create_table(capacity=2, eviction_policy="lru")
+      self._insert(table, [1, 2], [1.0, 2.0])
+      # Using key 1 makes key 2 the least recently used one.
+      self.assertAllEqual([1.0], self._lookup(table, [1]))
+      self._insert(table, [3], [3.0])
+      self.assertAllEqual(2, self._size(table))
+      self.assertAllEqual([1.0, -1.0, 3.0], self._lookup(table, [1, 2, 3]))
+
+  def testLfuEviction(self):
+    with self.cached_session():
+      table = self._create_table(capacity=2, eviction_policy="lfu")
+      self._insert(table, [1, 2], [1.0, 2.0])
+      self._lookup(table, [2, 2, 1])
+      self._lookup(table, [1, 1])
+      self._insert(table, [3], [3.0])
+      self.assertAllEqual([1.0, -1.0, 3.0], self._lookup(table, [1, 2, 3]))
+
+  def testTimestampEviction(self):
+    with self.cached_session():
+      table = self._create_table(capacity=2, eviction_policy="timestamp")
+      self._insert(table, [1, 2], [1.0, 2.0])
+      # Lookups do not keep key 1 alive.
+      self._lookup(table, [1])
+      self._insert(table, [3], [3.0])
+      self.assertAllEqual([-1.0, 2.0, 3.0], self._lookup(table, [1, 2, 3]))
+
+  def testMinFrequency(self):
+    with self.cached_session():
+      table = self._create_table(capacity=10, min_frequency=2)
+      self._insert(table, [1], [1.0])
+      self.assertAllEqual(0, self._size(table))
+      self.assertAllEqual([-1.0], self._lookup(table, [1]))
+      self._insert(table, [1], [1.5])
+      self.assertAllEqual(1, self._size(table))
+      self.assertAllEqual([1.5], self._lookup(table, [1]))
+
+  def testExportImportDelta(self):
+    with self.cached_session():
+      table = self._create_table(capacity=3)
+      self._insert(table, [1, 2, 3], [1.0, 2.0, 3.0])
+      keys, values = self.evaluate(
+          gen_lookup_ops.lookup_table_export_v2(table, dtypes.int64,
+                                                dtypes.float32))
+      restored = self._create_table(capacity=3)
+      self.evaluate(
+          gen_lookup_ops.lookup_table_import_v2(restored, keys, values))
+
+      # Updates key 2, removes key 1 and evicts key 3.
+      self._insert(table, [2], [20.0])
+      self.evaluate(
+          gen_lookup_ops.lookup_table_remove_v2(
+              table, constant_op.constant([1], dtypes.int64)))
+      self._insert(table, [4, 5], [4.0, 5.0])
+
+      keys, values, removed_keys = self.evaluate(
+          gen_lookup_ops.lookup_table_export_delta(table, dtypes.int64,
+                                                   dtypes.float32))
+      order = np.argsort(keys)
+      self.assertAllEqual([2, 4, 5], keys[order])
+      self.assertAllEqual([20.0, 4.0, 5.0], values[order])
+      self.assertAllEqual([1, 3], np.sort(removed_keys))
+
+      self.evaluate(
+          gen_lookup_ops.lookup_table_import_delta(restored, keys, values,
+                                                   removed_keys))
+      self.assertAllEqual(3, self._size(restored))
+      self.assertAllEqual([-1.0, 20.0, -1.0, 4.0, 5.0],
+                          self._lookup(restored, [1, 2, 3, 4, 5]))
+
+      # Nothing changed since the last export.
+      keys, _, removed_keys = self.evaluate(
+          gen_lookup_ops.lookup_table_export_delta(table, dtypes.int64,
+                                                   dtypes.float32))
+      self.assertAllEqual(0, keys.size)
+      self.assertAllEqual(0, removed_keys.size)
+
+  def testExportDeltaUnsupported(self):
+    with self.cached_session():
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.float32, -1.0)
+      with self.assertRaisesOpError("does not track its changes"):
+        self.evaluate(
+            gen_lookup_ops.lookup_table_export_delta(
+                table.resource_handle, dtypes.int64, dtypes.float32))
+
 
 class MutableHashTableBenchmark(test.Benchmark):
 
@@ -19,6 +19,8 @@ from __future__ import print_function
 
 import os
 
+import numpy as np
+
 from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.client import session
 from tensorflow.python.framework import constant_op
@@ -41,6 +43,31 @@ class SaveTest(test.TestCase):
                         self.evaluate(io_ops.restore_v2(
                             "ckpt", ["x"], [""], [dtypes.float32])))
 
+  @test_util.run_in_graph_and_eager_modes
+  def testRestoreManyTensors(self):
+    # Enough data for the restore to be split over several threads.
+    prefix = os.path.join(self.get_temp_dir(), "ckpt")
+    names = ["x%03d" % i for i in range(96)]
+    values = [
+        np.arange(i, i + (1 << 16), dtype=np.float32).reshape([256, 256])
+        for i in range(len(names))
+    ]
+    names.append("s")
+    values.append(np.array([b"a", b"bc"]))
+    self.evaluate(io_ops.save_v2(prefix, names, [""] * len(names), values))
+
+    # Restore in a different order than the names are stored, with a slice.
+    order = list(reversed(range(len(names))))
+    slices = [""] * len(names)
+    slices[0] = "256 256 0,4:-"
+    restored = self.evaluate(
+        io_ops.restore_v2(prefix, [names[i] for i in order],
+                          [slices[i] for i in order],
+                          [dtypes.as_dtype(values[i].dtype) for i in order]))
+    for i, value in zip(order, restored):
+      expected = values[i][:4] if slices[i] else values[i]
+      self.assertAllEqual(expected, value)
+
 
 class ShardedFileOpsTest(test.TestCase):
 
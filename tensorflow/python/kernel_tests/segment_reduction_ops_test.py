@@ -29,6 +29,7 @@ from tensorflow.python.framework import errors_impl
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import gradient_checker
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import gradient_checker_v2
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import variables
@@ -500,6 +501,92 @@ class UnsortedSegmentTest(SegmentReductionHelper):
         self.assertAllClose(np_ans, tf_ans)
         self.assertShapeEqual(np_ans, s)
 
+  def testLargeSkewedValues(self):
+    # Large enough to be reduced in parallel on CPU, with one segment holding
+    # most of the rows so that the columns are split as well.
+    np.random.seed(0)
+    num_segments = 100
+    segment_ids = np.where(
+        np.random.rand(4096) < 0.8, 7,
+        np.random.randint(-1, num_segments, size=4096))
+    np_x = np.random.rand(4096, 256).astype(np.float32)
+    np_sum = np.zeros((num_segments, 256), dtype=np.float32)
+    np_max = np.full((num_segments, 256), np.finfo(np.float32).min,
+                     dtype=np.float32)
+    for i, j in enumerate(segment_ids):
+      if j >= 0:
+        np_sum[j] += np_x[i]
+        np_max[j] = np.maximum(np_max[j], np_x[i])
+    with self.session(use_gpu=False):
+      self.assertAllClose(
+          np_sum,
+          self.evaluate(
+              math_ops.unsorted_segment_sum(np_x, segment_ids, num_segments)),
+          rtol=1e-5)
+      self.assertAllEqual(
+          np_max,
+          self.evaluate(
+              math_ops.unsorted_segment_max(np_x, segment_ids, num_segments)))
+
+  @test_util.run_deprecated_v1
+  def testLargeBadIndices(self):
+    segment_ids = np.zeros([4096], dtype=np.int32)
+    segment_ids[100] = 9
+    with self.session(use_gpu=False):
+      unsorted = math_ops.unsorted_segment_sum(
+          np.ones([4096, 64], dtype=np.float32), segment_ids, num_segments=2)
+      with self.assertRaisesOpError(
+          r"segment_ids\[100\] = 9 is out of range \[0, 2\)"):
+        self.evaluate(unsorted)
+
+
+class UniqueSegmentSumTest(test.TestCase):
+
+  def testValues(self):
+    data = np.array([[1, 2], [3, 4], [5, 6], [7, 8]], dtype=np.float32)
+    for itype in (np.int32, np.int64):
+      indices = np.array([7, 2, 7, 7], dtype=itype)
+      with self.session(use_gpu=False):
+        output, unique_indices = self.evaluate(
+            gen_math_ops.unique_segment_sum(data, indices))
+      self.assertAllEqual([[13, 16], [3, 4]], output)
+      self.assertAllEqual([7, 2], unique_indices)
+      self.assertEqual(itype, unique_indices.dtype)
+
+  def testMatchesUniqueAndUnsortedSegmentSum(self):
+    np.random.seed(0)
+    # A power law distribution of indices, large enough to be summed in
+    # parallel.
+    indices = np.random.zipf(1.5, size=4096) % 1000
+    data = np.random.rand(4096, 3, 16).astype(np.float32)
+    with self.session(use_gpu=False):
+      output, unique_indices = self.evaluate(
+          gen_math_ops.unique_segment_sum(data, indices))
+    _, first = np.unique(indices, return_index=True)
+    self.assertAllEqual(indices[np.sort(first)], unique_indices)
+    expected = np.zeros((len(unique_indices), 3, 16), dtype=np.float32)
+    for i, index in enumerate(indices):
+      expected[list(unique_indices).index(index)] += data[i]
+    self.assertAllClose(expected, output, rtol=1e-5)
+
+  def testEmpty(self):
+    with self.session(use_gpu=False):
+      output, unique_indices = self.evaluate(
+          gen_math_ops.unique_segment_sum(
+              np.zeros((0, 3), dtype=np.float32), np.zeros([0], np.int32)))
+    self.assertAllEqual(np.zeros((0, 3)), output)
+    self.assertAllEqual([], unique_indices)
+
+  @test_util.run_deprecated_v1
+  def testIndicesSizeMismatch(self):
+    with self.session(use_gpu=False):
+      with self.assertRaisesRegexp(
+          (ValueError, errors_impl.InvalidArgumentError),
+          "Dimensions must be equal|does not start with"):
+        self.evaluate(
+            gen_math_ops.unique_segment_sum(
+                np.zeros((3, 2), dtype=np.float32), [0, 1]))
+
 
 class SparseSegmentReductionHelper(SegmentReductionHelper):
 
@@ -653,6 +740,36 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
         s = tf_op(data=tf_x, indices=tf_indices, segment_ids=segment_indices)
         self.evaluate(s)
 
+  def testLargeSkewedValues(self):
+    # Large enough to be reduced in parallel on CPU.
+    np.random.seed(0)
+    np_x = np.random.rand(1000, 128).astype(np.float32)
+    indices = np.random.randint(0, 1000, size=8192)
+    # A few small segments, a gap and one segment with most of the indices.
+    segment_ids = np.sort(
+        np.concatenate([np.arange(50), np.full([8192 - 50], 60)]))
+    with self.session(use_gpu=False):
+      for tf_op, np_op in [(math_ops.sparse_segment_sum, np.sum),
+                           (math_ops.sparse_segment_mean, np.mean)]:
+        np_ans = np.zeros((61, 128), dtype=np.float32)
+        for j in np.unique(segment_ids):
+          np_ans[j] = np_op(np_x[indices[segment_ids == j]], axis=0)
+        s = tf_op(data=np_x, indices=indices, segment_ids=segment_ids)
+        self.assertAllClose(np_ans, self.evaluate(s), rtol=1e-4)
+
+  @test_util.run_deprecated_v1
+  def testLargeIndicesInvalid(self):
+    tf_x, _ = self._input([10, 64], dtype=dtypes_lib.float32)
+    segment_indices = np.arange(4096) // 4
+    tf_indices = np.zeros([4096], dtype=np.int32)
+    tf_indices[[3000, 1000]] = [11, 12]
+    with self.session(use_gpu=False):
+      s = math_ops.sparse_segment_sum(
+          data=tf_x, indices=tf_indices, segment_ids=segment_indices)
+      with self.assertRaisesOpError(
+          r"indices\[1000\] == 12 out of range \[0, 10\)"):
+        self.evaluate(s)
+
   @test_util.run_deprecated_v1
   def testIndicesInvalid1(self):
     tf_x, _ = self._input([10, 4], dtype=dtypes_lib.float32)
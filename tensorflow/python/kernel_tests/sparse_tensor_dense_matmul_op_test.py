@@ -234,6 +234,24 @@ class SparseTensorDenseMatMulTest(test.TestCase):
     self._testLarge(np.complex64)
     self._testLarge(np.complex128)
 
+  # Tests products large enough to be computed on several threads, with a few
+  # output rows holding most of the entries.
+  @test_util.run_deprecated_v1
+  def testLargeSkewedRows(self):
+    np.random.seed(127)  # Repeatable results
+    for np_dtype in [np.float32, np.complex64]:
+      for n in [8, 64]:
+        x = _maybe_complex(np.random.rand(2000, 300).astype(np_dtype))
+        x[np.abs(x) < 0.9] = 0
+        x[:3] = _maybe_complex(np.random.rand(3, 300).astype(np_dtype))
+        y = _maybe_complex(np.random.randn(300, n).astype(np_dtype))
+
+        self._testMatmul(x, y, adjoint_a=False, adjoint_b=False)
+        self._testMatmul(x.transpose(), y, adjoint_a=True, adjoint_b=False)
+        self._testMatmul(x, y.transpose(), adjoint_a=False, adjoint_b=True)
+        self._testMatmul(
+            x.transpose(), y.transpose(), adjoint_a=True, adjoint_b=True)
+
   # Tests random sized matrices.
   @test_util.run_deprecated_v1
   def testFloatRandom(self):
@@ -43,6 +43,18 @@ class StringLowerOpTest(test.TestCase):
       self.assertAllEqual(output, [[b"pigs on the wing", b"animals"],
                                    [b" hello ", b"\n\tworld! \r \n"]])
 
+  def test_string_lower_ascii_only(self):
+    # Only the bytes 'A' to 'Z' change without an encoding, including in
+    # strings too long to be stored inline.
+    strings = [b"@AZ[`az{", b"\xc3\x93 LONG ENOUGH NOT TO FIT INLINE " * 3]
+
+    with self.cached_session():
+      output = string_ops.string_lower(strings)
+      output = self.evaluate(output)
+      self.assertAllEqual(
+          output,
+          [b"@az[`az{", b"\xc3\x93 long enough not to fit inline " * 3])
+
   def test_string_upper_unicode(self):
     strings = [["ÓÓSSCHLOË"]]
     with self.cached_session():
@@ -89,6 +89,16 @@ class StringSplitOpTest(test.TestCase, parameterized.TestCase):
       self.assertAllEqual(values, [b"a", b"b", b"c", b"d", b"e", b"f", b"g"])
       self.assertAllEqual(shape, [10, 1])
 
+  def testStringSplitOnSetNonAsciiDelimiter(self):
+    strings = [b"a\xffb c", b"\xff\xfed"]
+
+    with self.cached_session():
+      tokens = string_ops.string_split(strings, delimiter=b" \xff")
+      indices, values, shape = self.evaluate(tokens)
+      self.assertAllEqual(indices, [[0, 0], [0, 1], [0, 2], [1, 0]])
+      self.assertAllEqual(values, [b"a", b"b", b"c", b"\xfed"])
+      self.assertAllEqual(shape, [2, 3])
+
   @test_util.run_deprecated_v1
   def testStringSplitWithDelimiter(self):
     strings = ["hello|world", "hello world"]
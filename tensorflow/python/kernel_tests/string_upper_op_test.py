@@ -43,6 +43,18 @@ class StringUpperOpTest(test.TestCase):
       self.assertAllEqual(output, [[b"PIGS ON THE WING", b"ANIMALS"],
                                    [b" HELLO ", b"\n\tWORLD! \r \n"]])
 
+  def test_string_upper_ascii_only(self):
+    # Only the bytes 'a' to 'z' change without an encoding, including in
+    # strings too long to be stored inline.
+    strings = [b"`az{@AZ[", b"\xc3\xb3 long enough not to fit inline " * 3]
+
+    with self.cached_session():
+      output = string_ops.string_upper(strings)
+      output = self.evaluate(output)
+      self.assertAllEqual(
+          output,
+          [b"`AZ{@AZ[", b"\xc3\xb3 LONG ENOUGH NOT TO FIT INLINE " * 3])
+
   def test_string_upper_unicode(self):
     strings = [["óósschloë"]]
     with self.cached_session():
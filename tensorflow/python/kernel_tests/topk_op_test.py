@@ -153,6 +153,26 @@ class TopKTest(test.TestCase):
     self._testMediumTopK(np.float32)
     self._testMediumTopK(np.float16)
 
+  def testSingleLongRow(self):
+    # Enough columns to be selected in parallel blocks.
+    n = 1 << 18
+    inputs = np.random.permutation(
+        np.linspace(0, 100, n, dtype=np.float32)).reshape(1, n)
+    for k in [2, 100, 2000]:
+      indices = np.argsort(-inputs, axis=1)[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+
+  def testSingleLongRowStable(self):
+    n = 1 << 18
+    # Lots of repeated integers taking values in [0, 3]
+    inputs = np.random.randint(0, 4, size=(1, n)).astype(np.int32)
+    for k in [5, 1000]:
+      # Use mergesort, a stable sort, to get the indices.
+      indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+
   def testStableSort(self):
     b = 5
     n = 500
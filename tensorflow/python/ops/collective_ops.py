@@ -28,7 +28,8 @@ def all_reduce(t,
                final_op,
                subdiv_offsets=(0,),
                communication_hint='auto',
-               timeout=0):
+               timeout=0,
+               compression='none'):
   """Reduces tensors collectively, across devices.
 
   Args:
@@ -45,11 +46,16 @@ def all_reduce(t,
       independent subdivision should begin.  Use [0] if no subdivision should
       be done.
     communication_hint: preferred collective communication.  The implementation
-      may fall back to another mechanism.  Options include `auto`, `ring`, and
-      `nccl`.
+      may fall back to another mechanism.  Options include `auto`, `ring`,
+      `nccl` and `hierarchical`, which reduces within each task before
+      reducing across tasks.
     timeout: If set to a non zero, set a completion timeout to detect staleness.
       If the timer goes off, a DeadlineExceededError is raised.
       The timeout value in seconds. This feature is experimental.
+    compression: wire format used to exchange float32 partial reductions.
+      Options are `none`, `float16` and `bfloat16`.  Compression requires an
+      `Add` merge_op and always uses the ring implementation.  This feature is
+      experimental.
 
   Returns:
     An Op implementing the distributed reduction.
@@ -68,7 +74,8 @@ def all_reduce(t,
       final_op=final_op,
       subdiv_offsets=subdiv_offsets,
       communication_hint=communication_hint.lower(),
-      timeout_seconds=timeout)
+      timeout_seconds=timeout,
+      compression=compression.lower())
 
 
 def all_gather(t,
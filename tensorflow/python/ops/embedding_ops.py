@@ -88,7 +88,8 @@ def _embedding_lookup_and_transform(params,
                                     partition_strategy="mod",
                                     name=None,
                                     max_norm=None,
-                                    transform_fn=None):
+                                    transform_fn=None,
+                                    deduplicate_ids=False):
   """Helper function for embedding_lookup and _compute_sampled_logits.
 
   This function is a generalization of embedding_lookup that optionally
@@ -110,6 +111,7 @@ def _embedding_lookup_and_transform(params,
     transform_fn: An optional function to apply to each retrieved embedding. If
       max_norm is provided, transform_fn is applied to the norm-limited
       embeddings.
+    deduplicate_ids: See embedding_lookup.
 
   Returns:
     See embedding_lookup for details.
@@ -149,6 +151,12 @@ def _embedding_lookup_and_transform(params,
       #   We must flatten in this case because transform_fn expects a flat
       #   tensor of embeddings.
       flat_ids = array_ops.reshape(ids, [-1])
+      deduplicate_ids = deduplicate_ids and np > 1
+      if deduplicate_ids:
+        # Look up each distinct id once.  Sharded params usually live on
+        # parameter servers, so duplicate ids would cost network traffic for
+        # both the lookup and its gradient.
+        flat_ids, unique_idx = array_ops.unique(flat_ids)
       original_indices = math_ops.range(array_ops.size(flat_ids))
 
       # Create p_assignments and set new_ids depending on the strategy.
@@ -213,8 +221,13 @@ def _embedding_lookup_and_transform(params,
             result = transform_fn(_clip(result, pids, max_norm))
         partitioned_result.append(result)
       # Stitch these back together
-      ret = data_flow_ops.parallel_dynamic_stitch(
-          pindices, partitioned_result, name=name)
+      if deduplicate_ids:
+        ret = data_flow_ops.parallel_dynamic_stitch(pindices,
+                                                    partitioned_result)
+        ret = array_ops.gather(ret, unique_idx, name=name)
+      else:
+        ret = data_flow_ops.parallel_dynamic_stitch(
+            pindices, partitioned_result, name=name)
 
       # Determine the static element shape.
       if transform_fn is None:
@@ -258,7 +271,8 @@ def embedding_lookup(
     partition_strategy="mod",
     name=None,
     validate_indices=True,  # pylint: disable=unused-argument
-    max_norm=None):
+    max_norm=None,
+    deduplicate_ids=False):
   """Looks up embeddings for the given `ids` from a list of tensors.
 
   This function is used to perform parallel lookups on the list of tensors in
@@ -282,6 +296,12 @@ def embedding_lookup(
   contiguous manner. In this case, 13 ids are split across 5 partitions as:
   `[[0, 1, 2], [3, 4, 5], [6, 7, 8], [9, 10], [11, 12]]`
 
+  If `len(params) > 1` and `deduplicate_ids` is `True`, repeated ids are looked
+  up once: each partition receives every distinct id at most once, and the
+  gradients for repeated ids are summed before they are sent to their
+  partition. Deduplication adds a `Unique` op, whose output has a dynamic
+  shape, so it is off by default.
+
   If the input ids are ragged tensors, partition variables are not supported and
   the partition strategy and the max_norm are ignored.
   The results of the lookup are concatenated into a dense
@@ -305,6 +325,10 @@ def embedding_lookup(
       include raising an error.
     max_norm: If not `None`, each embedding is clipped if its l2-norm is larger
       than this value.
+    deduplicate_ids: If `True` and `len(params) > 1`, look up each distinct id
+      once. Worthwhile when `ids` has many repeats and `params` live on remote
+      parameter servers; avoid it where static shapes are required, e.g. under
+      XLA compilation.
 
   Returns:
     A `Tensor` or a 'RaggedTensor', depending on the input, with the same type
@@ -325,12 +349,14 @@ def embedding_lookup(
       partition_strategy=partition_strategy,
       name=name,
       max_norm=max_norm,
-      transform_fn=None)
+      transform_fn=None,
+      deduplicate_ids=deduplicate_ids)
 
 
 @tf_export("nn.embedding_lookup", v1=[])
 @dispatch.add_dispatch_support
-def embedding_lookup_v2(params, ids, max_norm=None, name=None):
+def embedding_lookup_v2(params, ids, max_norm=None, name=None,
+                        deduplicate_ids=False):
   """Looks up embeddings for the given `ids` from a list of tensors.
 
   This function is used to perform parallel lookups on the list of tensors in
@@ -346,6 +372,10 @@ def embedding_lookup_v2(params, ids, max_norm=None, name=None):
   If the id space does not evenly divide the number of partitions, each of the
   first `(max_id + 1) % len(params)` partitions will be assigned one more id.
 
+  If `len(params) > 1` and `deduplicate_ids` is `True`, repeated ids are looked
+  up once, and their gradients are summed before they are sent to their
+  partition.
+
   The results of the lookup are concatenated into a dense
   tensor. The returned tensor has shape `shape(ids) + shape(params)[1:]`.
 
@@ -358,6 +388,8 @@ def embedding_lookup_v2(params, ids, max_norm=None, name=None):
     max_norm: If not `None`, each embedding is clipped if its l2-norm is larger
       than this value.
     name: A name for the operation (optional).
+    deduplicate_ids: If `True` and `len(params) > 1`, look up each distinct id
+      once. See `tf.compat.v1.nn.embedding_lookup`.
 
   Returns:
     A `Tensor` with the same type as the tensors in `params`.
@@ -391,7 +423,8 @@ def embedding_lookup_v2(params, ids, max_norm=None, name=None):
   Raises:
     ValueError: If `params` is empty.
   """
-  return embedding_lookup(params, ids, "div", name, max_norm=max_norm)
+  return embedding_lookup(params, ids, "div", name, max_norm=max_norm,
+                          deduplicate_ids=deduplicate_ids)
 
 
 @tf_export(v1=["nn.embedding_lookup_sparse"])
@@ -4162,6 +4162,40 @@ class JpegTest(test_util.TensorFlowTestCase):
             lambda e: "Invalid JPEG data or crop window" in str(e)):
           self.evaluate(result)
 
+  def testDecodeJpegTargetSize(self):
+    with self.cached_session() as sess:
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+
+      # The image is 256x128, so the shorter side picks the scale.
+      for target_size, ratio in [(200, 1), (128, 1), (64, 2), (60, 2),
+                                 (20, 4), (16, 8), (1, 8)]:
+        image1 = image_ops.decode_jpeg(jpeg0, ratio=ratio)
+        image2 = image_ops.decode_jpeg(jpeg0, target_size=target_size)
+        image1, image2 = self.evaluate([image1, image2])
+        self.assertAllEqual(image1, image2)
+
+  def testCropAndDecodeJpegTargetSize(self):
+    with self.cached_session() as sess:
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+
+      # The crop window is given at full resolution and is scaled to the
+      # smallest window of the decoded image covering it.
+      for crop_window, target_size, scaled_window, ratio in [
+          ([6, 5, 100, 60], 20, [3, 2, 50, 31], 2),
+          ([6, 5, 100, 60], 100, [6, 5, 100, 60], 1),
+          ([250, 120, 6, 8], 1, [62, 30, 2, 2], 4),
+          ([0, 0, 256, 128], 32, [0, 0, 64, 32], 4)]:
+        image1 = image_ops.decode_jpeg(jpeg0, ratio=ratio)
+        y, x, h, w = scaled_window
+        image1_crop = image_ops.crop_to_bounding_box(image1, y, x, h, w)
+        image2 = image_ops.decode_and_crop_jpeg(
+            jpeg0, crop_window, target_size=target_size)
+        image1_crop, image2 = self.evaluate([image1_crop, image2])
+        self.assertEqual(image1_crop.shape, image2.shape)
+        self.assertLess(self.averageError(image1_crop, image2), 1)
+
   def testSynthetic(self):
     with self.cached_session(use_gpu=True) as sess:
       # Encode it, then decode it, then encode it
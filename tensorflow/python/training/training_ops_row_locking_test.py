@@ -0,0 +1,131 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for sparse apply ops with TF_SPARSE_APPLY_ROW_LOCKING set.
+
+The environment variable is read once per process, so these tests live apart
+from training_ops_test.py.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import resource_variable_ops
+from tensorflow.python.ops import variables
+from tensorflow.python.platform import googletest
+from tensorflow.python.training import training_ops
+
+_NUM_ROWS = 2048
+_NUM_COLS = 4
+_NUM_THREADS = 8
+_NUM_STEPS = 50
+
+
+def _thread_indices(thread):
+  """Returns the rows that `thread` updates.
+
+  All threads update rows 0-3, pairs of threads share a row, and every thread
+  has rows of its own. Rows 100 + t and 1124 + t fall in the same lock stripe.
+  """
+  return np.array([0, 1, 2, 3, 500 + thread // 2, 100 + thread,
+                   100 + thread + 1024], dtype=np.int64)
+
+
+class TrainingOpsRowLockingTest(test_util.TensorFlowTestCase):
+
+  def _runConcurrently(self, sess, update_ops):
+    def run(op):
+      for _ in range(_NUM_STEPS):
+        sess.run(op)
+
+    threads = [self.checkedThread(target=run, args=(op,)) for op in update_ops]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+
+  def testProximalGradientDescentMatchesSerializedUpdates(self):
+    with ops.Graph().as_default(), self.session() as sess:
+      var = resource_variable_ops.ResourceVariable(
+          np.zeros([_NUM_ROWS, _NUM_COLS], dtype=np.float32))
+      update_ops = []
+      expected = np.zeros([_NUM_ROWS, _NUM_COLS], dtype=np.float32)
+      for t in range(_NUM_THREADS):
+        indices = _thread_indices(t)
+        # Integral gradients keep the sums exact in any order.
+        grad = np.full([len(indices), _NUM_COLS], t + 1, dtype=np.float32)
+        update_ops.append(
+            training_ops.resource_sparse_apply_proximal_gradient_descent(
+                var.handle,
+                constant_op.constant(1.0),
+                constant_op.constant(0.0),
+                constant_op.constant(0.0),
+                constant_op.constant(grad),
+                constant_op.constant(indices, dtypes.int64),
+                use_locking=True))
+        for _ in range(_NUM_STEPS):
+          np.subtract.at(expected, indices, grad)
+      self.evaluate(variables.global_variables_initializer())
+      self._runConcurrently(sess, update_ops)
+      self.assertAllEqual(expected, self.evaluate(var))
+
+  def testAdagradKeepsSlotConsistent(self):
+    with ops.Graph().as_default(), self.session() as sess:
+      var = resource_variable_ops.ResourceVariable(
+          np.zeros([_NUM_ROWS, _NUM_COLS], dtype=np.float32))
+      accum = resource_variable_ops.ResourceVariable(
+          np.ones([_NUM_ROWS, _NUM_COLS], dtype=np.float32))
+      update_ops = []
+      num_updates = np.zeros([_NUM_ROWS], dtype=np.int64)
+      for t in range(_NUM_THREADS):
+        indices = _thread_indices(t)
+        # With the same gradient everywhere, every serialization of the
+        # updates gives the same result, while a torn update loses an
+        # increment of `accum`.
+        grad = np.ones([len(indices), _NUM_COLS], dtype=np.float32)
+        update_ops.append(
+            training_ops.resource_sparse_apply_adagrad(
+                var.handle,
+                accum.handle,
+                constant_op.constant(1.0),
+                constant_op.constant(grad),
+                constant_op.constant(indices, dtypes.int64),
+                use_locking=True))
+        num_updates[indices] += _NUM_STEPS
+      self.evaluate(variables.global_variables_initializer())
+      self._runConcurrently(sess, update_ops)
+
+      # After n updates, accum is 1 + n and var is -sum(1 / sqrt(1 + k)) for
+      # k in 1..n.
+      expected_accum = np.zeros([_NUM_ROWS, _NUM_COLS], dtype=np.float32)
+      expected_var = np.zeros([_NUM_ROWS, _NUM_COLS], dtype=np.float32)
+      for row, n in enumerate(num_updates):
+        expected_accum[row, :] = 1 + n
+        expected_var[row, :] = -np.sum(1 / np.sqrt(1 + np.arange(1, n + 1)))
+      self.assertAllEqual(expected_accum, self.evaluate(accum))
+      self.assertAllClose(expected_var, self.evaluate(var), rtol=1e-5)
+
+
+if __name__ == '__main__':
+  os.environ['TF_SPARSE_APPLY_ROW_LOCKING'] = '1'
+  googletest.main()
@@ -994,6 +994,95 @@ GpuDriver::ContextGetSharedMemConfig(GpuContext* context) {
   return false;
 }
 
+/* static */ port::Status GpuDriver::StreamBeginCapture(GpuContext* context,
+                                                        CUstream stream) {
+#if CUDA_VERSION >= 10010
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+      "Could not begin capturing CUDA stream");
+  return port::Status::OK();
+#else
+  return port::Status(port::error::UNIMPLEMENTED,
+                      "stream capture requires CUDA 10.1 or later");
+#endif
+}
+
+/* static */ port::Status GpuDriver::StreamEndCapture(GpuContext* context,
+                                                      CUstream stream,
+                                                      CUgraph* graph) {
+#if CUDA_VERSION >= 10010
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(cuStreamEndCapture(stream, graph),
+                           "Could not end capturing CUDA stream");
+  return port::Status::OK();
+#else
+  return port::Status(port::error::UNIMPLEMENTED,
+                      "stream capture requires CUDA 10.1 or later");
+#endif
+}
+
+/* static */ port::Status GpuDriver::GraphInstantiate(GpuContext* context,
+                                                      CUgraph graph,
+                                                      CUgraphExec* graph_exec) {
+#if CUDA_VERSION >= 10010
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(cuGraphInstantiate(graph_exec, graph,
+                                              /*phErrorNode=*/nullptr,
+                                              /*logBuffer=*/nullptr,
+                                              /*bufferSize=*/0),
+                           "Could not instantiate CUDA graph");
+  return port::Status::OK();
+#else
+  return port::Status(port::error::UNIMPLEMENTED,
+                      "CUDA graphs require CUDA 10.1 or later");
+#endif
+}
+
+/* static */ port::Status GpuDriver::GraphLaunch(GpuContext* context,
+                                                 CUgraphExec graph_exec,
+                                                 CUstream stream) {
+#if CUDA_VERSION >= 10010
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(cuGraphLaunch(graph_exec, stream),
+                           "Could not launch CUDA graph");
+  return port::Status::OK();
+#else
+  return port::Status(port::error::UNIMPLEMENTED,
+                      "CUDA graphs require CUDA 10.1 or later");
+#endif
+}
+
+/* static */ void GpuDriver::DestroyGraph(GpuContext* context, CUgraph graph) {
+#if CUDA_VERSION >= 10010
+  if (graph == nullptr) {
+    return;
+  }
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+#endif
+}
+
+/* static */ void GpuDriver::DestroyGraphExec(GpuContext* context,
+                                              CUgraphExec graph_exec) {
+#if CUDA_VERSION >= 10010
+  if (graph_exec == nullptr) {
+    return;
+  }
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphExecDestroy(graph_exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy executable CUDA graph: " << ToString(res);
+  }
+#endif
+}
+
 /* static */ port::Status GpuDriver::SynchronousMemcpyD2H(GpuContext* context,
                                                           void* host_dst,
                                                           CUdeviceptr gpu_src,
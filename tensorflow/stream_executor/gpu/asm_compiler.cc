@@ -29,6 +29,10 @@ limitations under the License.
 #include "tensorflow/stream_executor/gpu/gpu_driver.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 
+#if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#endif  // GOOGLE_CUDA
+
 namespace stream_executor {
 
 // Prints a warning if the ptxas at ptxas_path has known bugs.
@@ -105,6 +109,60 @@ static void WarnIfBadPtxasVersion(const std::string& ptxas_path) {
   }
 }
 
+// Returns the path of the ptxas binary to use with `options`.
+static std::string FindPtxasPath(const GpuAsmOpts& options) {
+  auto env = tensorflow::Env::Default();
+  std::string ptxas_binary_name = "ptxas";
+#if defined(PLATFORM_WINDOWS)
+  ptxas_binary_name += ".exe";
+#endif
+
+  std::string ptxas_path;
+  for (const std::string& cuda_root :
+       tensorflow::CandidateCudaRoots(options.preferred_cuda_dir)) {
+    ptxas_path = tensorflow::io::JoinPath(cuda_root, "bin", ptxas_binary_name);
+    VLOG(2) << "Looking for ptxas at " << ptxas_path;
+    if (env->FileExists(ptxas_path).ok()) {
+      break;
+    }
+  }
+  if (!env->FileExists(ptxas_path).ok()) {
+    // Rely on subprocess invocation to find the correct binary.
+    ptxas_path = ptxas_binary_name;
+  }
+  VLOG(2) << "Using ptxas at " << ptxas_path;
+  return ptxas_path;
+}
+
+port::StatusOr<std::string> GetPtxasVersion(const GpuAsmOpts& options) {
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto* versions TF_GUARDED_BY(mu) =
+      new absl::flat_hash_map<std::string, std::string>();
+
+  const std::string ptxas_path = FindPtxasPath(options);
+  tensorflow::mutex_lock lock(mu);
+  auto it = versions->find(ptxas_path);
+  if (it != versions->end()) {
+    return it->second;
+  }
+
+  tensorflow::SubProcess ptxas;
+  ptxas.SetProgram(ptxas_path, {ptxas_path, "--version"});
+  ptxas.SetChannelAction(tensorflow::CHAN_STDOUT, tensorflow::ACTION_PIPE);
+  if (!ptxas.Start()) {
+    return port::InternalError(
+        absl::StrCat("Couldn't invoke ", ptxas_path, " --version"));
+  }
+  std::string out;
+  int exit_code = ptxas.Communicate(/*stdin_input=*/nullptr, &out,
+                                    /*stderr_output=*/nullptr);
+  if (exit_code != 0) {
+    return port::InternalError(absl::StrCat(
+        "Running ", ptxas_path, " --version returned ", exit_code));
+  }
+  return versions->emplace(ptxas_path, std::move(out)).first->second;
+}
+
 port::StatusOr<absl::Span<const uint8>> CompileGpuAsmOrGetCached(
     int device_ordinal, const char* ptx, GpuAsmOpts compilation_options) {
   using PtxCacheKey = std::tuple<int, std::string, GpuAsmOpts::PtxOptionsTuple>;
@@ -143,27 +201,8 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int device_ordinal,
 port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
                                                  const char* ptx_contents,
                                                  GpuAsmOpts options) {
-  std::string ptxas_path;
   auto env = tensorflow::Env::Default();
-  std::string ptxas_binary_name = "ptxas";
-#if defined(PLATFORM_WINDOWS)
-  ptxas_binary_name += ".exe";
-#endif
-
-  for (const std::string& cuda_root :
-       tensorflow::CandidateCudaRoots(options.preferred_cuda_dir)) {
-    ptxas_path = tensorflow::io::JoinPath(cuda_root, "bin", ptxas_binary_name);
-    VLOG(2) << "Looking for ptxas at " << ptxas_path;
-    if (env->FileExists(ptxas_path).ok()) {
-      break;
-    }
-  }
-  if (!env->FileExists(ptxas_path).ok()) {
-    // Rely on subprocess invocation to find the correct binary.
-    ptxas_path = ptxas_binary_name;
-  }
-  VLOG(2) << "Using ptxas at " << ptxas_path;
-
+  const std::string ptxas_path = FindPtxasPath(options);
   WarnIfBadPtxasVersion(ptxas_path);
 
   // Write ptx into a temporary file.
@@ -232,4 +271,55 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
   return cubin_vector;
 }
 
+#if GOOGLE_CUDA
+// Returns an error naming the failed CUDA linker call if `result` is not
+// CUDA_SUCCESS.
+static port::Status CudaLinkerStatus(CUresult result, const char* call) {
+  if (result == CUDA_SUCCESS) {
+    return port::Status::OK();
+  }
+  const char* error_name = nullptr;
+  if (cuGetErrorName(result, &error_name) != CUDA_SUCCESS) {
+    error_name = "unknown error";
+  }
+  return port::InternalError(absl::StrCat(call, " failed: ", error_name));
+}
+#endif  // GOOGLE_CUDA
+
+port::StatusOr<std::vector<uint8>> LinkGpuAsm(
+    gpu::GpuContext* context, const std::vector<std::vector<uint8>>& cubins) {
+#if GOOGLE_CUDA
+  gpu::ScopedActivateContext activation(context);
+
+  CUlinkState link_state;
+  TF_RETURN_IF_ERROR(CudaLinkerStatus(
+      cuLinkCreate(/*numOptions=*/0, /*options=*/nullptr,
+                   /*optionValues=*/nullptr, &link_state),
+      "cuLinkCreate"));
+  auto link_state_cleaner = tensorflow::gtl::MakeCleanup(
+      [&link_state] { cuLinkDestroy(link_state); });
+  for (const std::vector<uint8>& cubin : cubins) {
+    TF_RETURN_IF_ERROR(CudaLinkerStatus(
+        cuLinkAddData(link_state, CU_JIT_INPUT_CUBIN,
+                      static_cast<void*>(const_cast<uint8*>(cubin.data())),
+                      cubin.size(), /*name=*/"", /*numOptions=*/0,
+                      /*options=*/nullptr, /*optionValues=*/nullptr),
+        "cuLinkAddData"));
+  }
+  void* linked_cubin;
+  size_t linked_cubin_size;
+  TF_RETURN_IF_ERROR(CudaLinkerStatus(
+      cuLinkComplete(link_state, &linked_cubin, &linked_cubin_size),
+      "cuLinkComplete"));
+  // The linked cubin is owned by the link state, so copy it before destroying
+  // the latter.
+  const uint8* linked_cubin_bytes = static_cast<const uint8*>(linked_cubin);
+  return std::vector<uint8>(linked_cubin_bytes,
+                            linked_cubin_bytes + linked_cubin_size);
+#else
+  return port::Status(port::error::UNIMPLEMENTED,
+                      "linking GPU binaries is only supported with CUDA");
+#endif  // GOOGLE_CUDA
+}
+
 }  // namespace stream_executor
@@ -45,6 +45,10 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
                                                  const char* ptx_contents,
                                                  GpuAsmOpts options);
 
+// Returns the output of `ptxas --version` for the ptxas that CompileGpuAsm
+// runs with 'options'. The output is cached for each ptxas binary.
+port::StatusOr<std::string> GetPtxasVersion(const GpuAsmOpts& options);
+
 // Same as CompileGpuAsm, but caches the result, and returns unowned view of
 // the compiled binary.
 //
@@ -52,6 +56,15 @@ port::StatusOr<std::vector<uint8>> CompileGpuAsm(int cc_major, int cc_minor,
 port::StatusOr<absl::Span<const uint8>> CompileGpuAsmOrGetCached(
     int device_ordinal, const char* ptx, GpuAsmOpts compilation_options);
 
+namespace gpu {
+class GpuContext;
+}  // namespace gpu
+
+// Links the given relocatable cubins, i.e. compiled by ptxas with -c, into a
+// single cubin using the linker of the CUDA driver, in `context`.
+port::StatusOr<std::vector<uint8>> LinkGpuAsm(
+    gpu::GpuContext* context, const std::vector<std::vector<uint8>>& cubins);
+
 }  // namespace stream_executor
 
 #endif  // TENSORFLOW_STREAM_EXECUTOR_GPU_ASM_COMPILER_H_
@@ -346,6 +346,40 @@ class GpuDriver {
   // the stream immediately after this returns).
   static bool IsStreamIdle(GpuContext* context, GpuStreamHandle stream);
 
+  // Starts capturing the work enqueued onto stream into a graph instead of
+  // executing it, via cuStreamBeginCapture. Only the calling thread is
+  // restricted from making unsafe API calls while the capture is in progress.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html#group__CUDA__STREAM_1g767167da0bbf07157dc20b6c258a2143
+  static port::Status StreamBeginCapture(GpuContext* context,
+                                         GpuStreamHandle stream);
+
+  // Ends the capture started by StreamBeginCapture and returns the captured
+  // graph, via cuStreamEndCapture. The capture is ended even if it was
+  // invalidated, in which case an error is returned.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html#group__CUDA__STREAM_1g03dab8b2ba76b00718955177a929970c
+  static port::Status StreamEndCapture(GpuContext* context,
+                                       GpuStreamHandle stream,
+                                       GpuGraphHandle* graph);
+
+  // Creates an executable graph from graph, via cuGraphInstantiate.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html#group__CUDA__GRAPH_1g433ae118a751c9f2087f53d7add7bc2c
+  static port::Status GraphInstantiate(GpuContext* context,
+                                       GpuGraphHandle graph,
+                                       GpuGraphExecHandle* graph_exec);
+
+  // Enqueues the executable graph onto stream, via cuGraphLaunch.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html#group__CUDA__GRAPH_1g6b2dceb3901e71a390d2bd8b0491e471
+  static port::Status GraphLaunch(GpuContext* context,
+                                  GpuGraphExecHandle graph_exec,
+                                  GpuStreamHandle stream);
+
+  // Destroys graph, via cuGraphDestroy.
+  static void DestroyGraph(GpuContext* context, GpuGraphHandle graph);
+
+  // Destroys the executable graph, via cuGraphExecDestroy.
+  static void DestroyGraphExec(GpuContext* context,
+                               GpuGraphExecHandle graph_exec);
+
   // Returns whether code in the from context can access memory in the to
   // context via cuDeviceCanAccessPeer.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__PEER__ACCESS.html#group__CUDA__PEER__ACCESS_1g496bdaae1f632ebfb695b99d2c40f19e
@@ -831,6 +831,38 @@ GpuDriver::ContextGetSharedMemConfig(GpuContext* context) {
   return false;
 }
 
+/* static */ port::Status GpuDriver::StreamBeginCapture(
+    GpuContext* context, GpuStreamHandle stream) {
+  return port::Status{port::error::UNIMPLEMENTED,
+                      "stream capture is not supported on ROCm"};
+}
+
+/* static */ port::Status GpuDriver::StreamEndCapture(GpuContext* context,
+                                                      GpuStreamHandle stream,
+                                                      GpuGraphHandle* graph) {
+  return port::Status{port::error::UNIMPLEMENTED,
+                      "stream capture is not supported on ROCm"};
+}
+
+/* static */ port::Status GpuDriver::GraphInstantiate(
+    GpuContext* context, GpuGraphHandle graph, GpuGraphExecHandle* graph_exec) {
+  return port::Status{port::error::UNIMPLEMENTED,
+                      "graphs are not supported on ROCm"};
+}
+
+/* static */ port::Status GpuDriver::GraphLaunch(GpuContext* context,
+                                                 GpuGraphExecHandle graph_exec,
+                                                 GpuStreamHandle stream) {
+  return port::Status{port::error::UNIMPLEMENTED,
+                      "graphs are not supported on ROCm"};
+}
+
+/* static */ void GpuDriver::DestroyGraph(GpuContext* context,
+                                          GpuGraphHandle graph) {}
+
+/* static */ void GpuDriver::DestroyGraphExec(GpuContext* context,
+                                              GpuGraphExecHandle graph_exec) {}
+
 /* static */ port::Status GpuDriver::SynchronousMemcpyD2H(
     GpuContext* context, void* host_dst, hipDeviceptr_t gpu_src, uint64 size) {
   ScopedActivateContext activation{context};
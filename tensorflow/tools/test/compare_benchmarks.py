@@ -0,0 +1,70 @@
+# Lint as: python2, python3
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Compares the benchmark reports of two runs and flags regressions.
+
+Example, comparing two builds of //tensorflow/core/kernels:
+core_kernels_benchmark_test run with TEST_REPORT_FILE_PREFIX set to
+/tmp/base/ and /tmp/new/ respectively:
+
+  bazel run //tensorflow/tools/test:compare_benchmarks -- \\
+    --baseline=/tmp/base/ --candidate=/tmp/new/ --threshold=0.05
+
+Exits with a non-zero status if any benchmark slowed down by more than the
+threshold.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import sys
+
+from tensorflow.python.platform import app
+from tensorflow.tools.test import compare_benchmarks_lib
+
+FLAGS = None
+
+
+def main(unused_args):
+  baseline = compare_benchmarks_lib.load_wall_times(FLAGS.baseline)
+  candidate = compare_benchmarks_lib.load_wall_times(FLAGS.candidate)
+  comparisons = compare_benchmarks_lib.compare(baseline, candidate)
+  print(compare_benchmarks_lib.format_table(comparisons, FLAGS.threshold))
+  for name in sorted(set(baseline) ^ set(candidate)):
+    print("Skipped %s: only present in one of the runs." % name)
+  regressed = compare_benchmarks_lib.regressions(comparisons, FLAGS.threshold)
+  if regressed:
+    print("%d of %d benchmarks regressed by more than %.1f%%." %
+          (len(regressed), len(comparisons), FLAGS.threshold * 100))
+    return 1
+  return 0
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "--baseline", type=str, required=True,
+      help="TEST_REPORT_FILE_PREFIX, or directory, of the reference run.")
+  parser.add_argument(
+      "--candidate", type=str, required=True,
+      help="TEST_REPORT_FILE_PREFIX, or directory, of the run to evaluate.")
+  parser.add_argument(
+      "--threshold", type=float, default=0.05,
+      help="Relative slowdown of the wall time above which a benchmark is "
+      "reported as a regression.")
+  FLAGS, unparsed = parser.parse_known_args()
+  app.run(main=main, argv=[sys.argv[0]] + unparsed)
@@ -0,0 +1,116 @@
+# Lint as: python2, python3
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Library for comparing the benchmark reports of two runs.
+
+The reports are the files written by TestReporter when TEST_REPORT_FILE_PREFIX
+is set, each holding a BenchmarkEntries proto in binary or JSON form (see
+TEST_REPORT_FILE_FORMAT).
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+from google.protobuf import json_format
+from google.protobuf import message
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+
+# Change in the wall time of a benchmark between two runs. 'ratio' is
+# candidate / baseline, so values above one are slowdowns.
+Comparison = collections.namedtuple(
+    "Comparison", ["name", "baseline", "candidate", "ratio"])
+
+
+def parse_benchmark_entries(content):
+  """Parses a BenchmarkEntries proto from its binary or JSON serialization."""
+  entries = test_log_pb2.BenchmarkEntries()
+  stripped = content.lstrip()
+  if stripped.startswith(b"{"):
+    json_format.Parse(stripped.decode("utf-8"), entries)
+    return entries
+  try:
+    entries.ParseFromString(content)
+  except message.DecodeError as e:
+    raise ValueError("Not a BenchmarkEntries proto: {}".format(e))
+  return entries
+
+
+def load_wall_times(prefix):
+  """Returns {benchmark name: wall time} over all reports matching prefix.
+
+  Args:
+    prefix: The TEST_REPORT_FILE_PREFIX of a run. A directory matches all the
+      files in it.
+
+  Raises:
+    ValueError: If no report matches prefix or a report can't be parsed.
+  """
+  if gfile.IsDirectory(prefix):
+    prefix = prefix.rstrip("/") + "/"
+  paths = sorted(gfile.Glob(prefix + "*"))
+  wall_times = {}
+  for path in paths:
+    if gfile.IsDirectory(path):
+      continue
+    with gfile.GFile(path, "rb") as f:
+      content = f.read()
+    try:
+      entries = parse_benchmark_entries(content)
+    except (ValueError, json_format.ParseError) as e:
+      raise ValueError("Unable to parse report {}: {}".format(path, e))
+    for entry in entries.entry:
+      wall_times[entry.name] = entry.wall_time
+  if not wall_times:
+    raise ValueError("No benchmark reports found for prefix: %s" % prefix)
+  return wall_times
+
+
+def compare(baseline, candidate):
+  """Compares the benchmarks present in both baseline and candidate.
+
+  Args:
+    baseline: {benchmark name: wall time} of the reference run.
+    candidate: {benchmark name: wall time} of the run under evaluation.
+
+  Returns:
+    A list of Comparison, sorted by name.
+  """
+  comparisons = []
+  for name in sorted(set(baseline) & set(candidate)):
+    base, cand = baseline[name], candidate[name]
+    ratio = cand / base if base > 0 else float("inf") if cand > 0 else 1.0
+    comparisons.append(Comparison(name, base, cand, ratio))
+  return comparisons
+
+
+def regressions(comparisons, threshold):
+  """Returns the comparisons slower than baseline by more than threshold."""
+  return [c for c in comparisons if c.ratio > 1.0 + threshold]
+
+
+def format_table(comparisons, threshold):
+  """Returns comparisons as a human readable table."""
+  width = max([len("Benchmark")] + [len(c.name) for c in comparisons])
+  lines = ["{:<{w}}  {:>14}  {:>14}  {:>8}".format(
+      "Benchmark", "Baseline (s)", "Candidate (s)", "Change", w=width)]
+  for c in comparisons:
+    mark = "  REGRESSION" if c.ratio > 1.0 + threshold else ""
+    lines.append("{:<{w}}  {:>14.6g}  {:>14.6g}  {:>+7.1f}%{}".format(
+        c.name, c.baseline, c.candidate, (c.ratio - 1.0) * 100, mark, w=width))
+  return "\n".join(lines)
@@ -0,0 +1,72 @@
+# Lint as: python2, python3
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_benchmarks_lib."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from google.protobuf import json_format
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import googletest
+from tensorflow.tools.test import compare_benchmarks_lib
+
+
+def _write_report(path, wall_times, as_json):
+  entries = test_log_pb2.BenchmarkEntries()
+  for name, wall_time in wall_times.items():
+    entry = entries.entry.add()
+    entry.name = name
+    entry.iters = 1
+    entry.wall_time = wall_time
+  content = (json_format.MessageToJson(entries).encode("utf-8")
+             if as_json else entries.SerializeToString())
+  with gfile.GFile(path, "wb") as f:
+    f.write(content)
+
+
+class CompareBenchmarksTest(googletest.TestCase):
+
+  def testLoadsBinaryAndJsonReports(self):
+    run_dir = os.path.join(googletest.GetTempDir(), "load")
+    gfile.MakeDirs(run_dir)
+    _write_report(os.path.join(run_dir, "a"), {"BM_A": 1.5}, as_json=False)
+    _write_report(os.path.join(run_dir, "b"), {"BM_B": 2.5}, as_json=True)
+    self.assertEqual({"BM_A": 1.5, "BM_B": 2.5},
+                     compare_benchmarks_lib.load_wall_times(run_dir))
+
+  def testMissingReportsFail(self):
+    with self.assertRaises(ValueError):
+      compare_benchmarks_lib.load_wall_times(
+          os.path.join(googletest.GetTempDir(), "does_not_exist_"))
+
+  def testFlagsRegressionsAboveThreshold(self):
+    comparisons = compare_benchmarks_lib.compare(
+        {"BM_A": 1.0, "BM_B": 1.0, "BM_C": 1.0, "BM_Old": 1.0},
+        {"BM_A": 1.02, "BM_B": 1.2, "BM_C": 0.5, "BM_New": 1.0})
+    self.assertEqual(["BM_A", "BM_B", "BM_C"], [c.name for c in comparisons])
+    regressed = compare_benchmarks_lib.regressions(comparisons, 0.05)
+    self.assertEqual(["BM_B"], [c.name for c in regressed])
+    table = compare_benchmarks_lib.format_table(comparisons, 0.05)
+    self.assertIn("REGRESSION", table.splitlines()[2])
+    self.assertNotIn("REGRESSION", table.splitlines()[1])
+
+
+if __name__ == "__main__":
+  googletest.main()